@@ -63,6 +63,7 @@ else()
     absl::btree
     absl::cleanup
     absl::cord
+    absl::crc32c
     absl::core_headers
     absl::debugging
     absl::die_if_null
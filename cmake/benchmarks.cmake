@@ -0,0 +1,69 @@
+# C++ runtime benchmarks, see upb/benchmarks/cpp_benchmark.cc, and protoc
+# benchmarks, see src/google/protobuf/compiler/protoc_benchmark.cc.  Requires
+# an installed Google Benchmark package.
+find_package(benchmark REQUIRED)
+
+set(_benchmark_dir ${protobuf_SOURCE_DIR}/upb/benchmarks)
+set(_benchmark_out ${CMAKE_CURRENT_BINARY_DIR}/benchmarks)
+
+# The lite variant is the same proto with optimize_for = LITE_RUNTIME, as
+# generated by cc_optimizefor_proto_library in Bazel.
+file(MAKE_DIRECTORY ${_benchmark_out}/lite_src/benchmarks)
+file(READ ${_benchmark_dir}/cpp_benchmark.proto _benchmark_proto)
+file(WRITE ${_benchmark_out}/lite_src/benchmarks/cpp_benchmark_lite.proto
+  "${_benchmark_proto}option optimize_for = LITE_RUNTIME;\n")
+
+add_custom_command(
+  OUTPUT
+    ${_benchmark_out}/benchmarks/cpp_benchmark.pb.h
+    ${_benchmark_out}/benchmarks/cpp_benchmark.pb.cc
+  DEPENDS ${protobuf_PROTOC_EXE} ${_benchmark_dir}/cpp_benchmark.proto
+  COMMAND ${protobuf_PROTOC_EXE} ${_benchmark_dir}/cpp_benchmark.proto
+      --proto_path=${protobuf_SOURCE_DIR}/upb
+      --cpp_out=${_benchmark_out}
+)
+
+add_custom_command(
+  OUTPUT
+    ${_benchmark_out}/benchmarks/cpp_benchmark_lite.pb.h
+    ${_benchmark_out}/benchmarks/cpp_benchmark_lite.pb.cc
+  DEPENDS ${protobuf_PROTOC_EXE}
+          ${_benchmark_out}/lite_src/benchmarks/cpp_benchmark_lite.proto
+  COMMAND ${protobuf_PROTOC_EXE}
+      ${_benchmark_out}/lite_src/benchmarks/cpp_benchmark_lite.proto
+      --proto_path=${_benchmark_out}/lite_src
+      --cpp_out=${_benchmark_out}
+)
+
+add_executable(cpp_benchmark
+  ${_benchmark_dir}/cpp_benchmark.cc
+  ${_benchmark_out}/benchmarks/cpp_benchmark.pb.h
+  ${_benchmark_out}/benchmarks/cpp_benchmark.pb.cc
+)
+
+add_executable(cpp_benchmark_lite
+  ${_benchmark_dir}/cpp_benchmark.cc
+  ${_benchmark_out}/benchmarks/cpp_benchmark_lite.pb.h
+  ${_benchmark_out}/benchmarks/cpp_benchmark_lite.pb.cc
+)
+target_compile_definitions(cpp_benchmark_lite PRIVATE CPP_BENCHMARK_LITE)
+
+foreach(_target cpp_benchmark cpp_benchmark_lite)
+  target_include_directories(${_target} PRIVATE ${_benchmark_out})
+  target_include_directories(${_target} PRIVATE ${ABSL_ROOT_DIR})
+  target_link_libraries(${_target} benchmark::benchmark)
+  target_link_libraries(${_target} ${protobuf_ABSL_USED_TARGETS})
+endforeach()
+target_link_libraries(cpp_benchmark ${protobuf_LIB_PROTOBUF})
+target_link_libraries(cpp_benchmark_lite ${protobuf_LIB_PROTOBUF_LITE})
+
+if (protobuf_LIB_PROTOC)
+  add_executable(protoc_benchmark
+    ${protobuf_SOURCE_DIR}/src/google/protobuf/compiler/protoc_benchmark.cc
+  )
+  target_include_directories(protoc_benchmark PRIVATE ${ABSL_ROOT_DIR})
+  target_link_libraries(protoc_benchmark benchmark::benchmark)
+  target_link_libraries(protoc_benchmark ${protobuf_LIB_PROTOC})
+  target_link_libraries(protoc_benchmark ${protobuf_LIB_PROTOBUF})
+  target_link_libraries(protoc_benchmark ${protobuf_ABSL_USED_TARGETS})
+endif()
@@ -152,9 +152,216 @@ add_test(NAME lite-test
   COMMAND lite-test ${protobuf_GTEST_ARGS}
   WORKING_DIRECTORY ${protobuf_SOURCE_DIR})
 
+# Generated with a C++ generator option, which writes one .cc file per
+# message next to the usual outputs.
+set(lazy_implicit_weak_out ${CMAKE_CURRENT_BINARY_DIR}/lazy_implicit_weak)
+set(lazy_implicit_weak_base
+  ${lazy_implicit_weak_out}/google/protobuf/unittest_lazy_implicit_weak)
+set(lazy_implicit_weak_proto_files
+  ${lazy_implicit_weak_base}.pb.h
+  ${lazy_implicit_weak_base}.pb.cc
+  ${lazy_implicit_weak_base}.out/0.cc
+  ${lazy_implicit_weak_base}.out/1.cc
+  ${lazy_implicit_weak_base}.out/2.cc
+)
+add_custom_command(
+  OUTPUT ${lazy_implicit_weak_proto_files}
+  DEPENDS ${protobuf_PROTOC_EXE}
+      ${protobuf_SOURCE_DIR}/src/google/protobuf/unittest_lazy_implicit_weak.proto
+  COMMAND ${CMAKE_COMMAND} -E make_directory ${lazy_implicit_weak_out}
+  COMMAND ${protobuf_PROTOC_EXE}
+      ${protobuf_SOURCE_DIR}/src/google/protobuf/unittest_lazy_implicit_weak.proto
+      --proto_path=${protobuf_SOURCE_DIR}/src
+      --cpp_out=lite_lazy_implicit_weak_fields:${lazy_implicit_weak_out}
+)
+
+add_executable(lazy-implicit-weak-test
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/lazy_implicit_weak_test.cc
+  ${lazy_implicit_weak_proto_files}
+)
+target_include_directories(lazy-implicit-weak-test PRIVATE
+  ${lazy_implicit_weak_out})
+target_link_libraries(lazy-implicit-weak-test
+  ${protobuf_LIB_PROTOBUF_LITE}
+  ${protobuf_ABSL_USED_TARGETS}
+  ${protobuf_ABSL_USED_TEST_TARGETS}
+  GTest::gmock_main
+)
+
+add_test(NAME lazy-implicit-weak-test
+  COMMAND lazy-implicit-weak-test ${protobuf_GTEST_ARGS}
+  WORKING_DIRECTORY ${protobuf_SOURCE_DIR})
+
+set(lite_lazy_out ${CMAKE_CURRENT_BINARY_DIR}/lite_lazy)
+set(lite_lazy_proto_files
+  ${lite_lazy_out}/google/protobuf/unittest_lite_lazy.pb.h
+  ${lite_lazy_out}/google/protobuf/unittest_lite_lazy.pb.cc
+)
+add_custom_command(
+  OUTPUT ${lite_lazy_proto_files}
+  DEPENDS ${protobuf_PROTOC_EXE}
+      ${protobuf_SOURCE_DIR}/src/google/protobuf/unittest_lite_lazy.proto
+  COMMAND ${CMAKE_COMMAND} -E make_directory ${lite_lazy_out}
+  COMMAND ${protobuf_PROTOC_EXE}
+      ${protobuf_SOURCE_DIR}/src/google/protobuf/unittest_lite_lazy.proto
+      --proto_path=${protobuf_SOURCE_DIR}/src
+      --cpp_out=lite_lazy_fields,retain_lazy_encoding=protobuf_unittest.LiteLazyRetainHolder:${lite_lazy_out}
+)
+
+add_executable(lite-lazy-field-test
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/lite_lazy_field_test.cc
+  ${lite_lazy_proto_files}
+)
+target_include_directories(lite-lazy-field-test PRIVATE ${lite_lazy_out})
+target_link_libraries(lite-lazy-field-test
+  ${protobuf_LIB_PROTOBUF_LITE}
+  ${protobuf_ABSL_USED_TARGETS}
+  ${protobuf_ABSL_USED_TEST_TARGETS}
+  GTest::gmock_main
+)
+
+add_test(NAME lite-lazy-field-test
+  COMMAND lite-lazy-field-test ${protobuf_GTEST_ARGS}
+  WORKING_DIRECTORY ${protobuf_SOURCE_DIR})
+
+set(descriptor_table_section_out
+  ${CMAKE_CURRENT_BINARY_DIR}/descriptor_table_section)
+set(descriptor_table_section_proto_files
+  ${descriptor_table_section_out}/google/protobuf/unittest_descriptor_table_section.pb.h
+  ${descriptor_table_section_out}/google/protobuf/unittest_descriptor_table_section.pb.cc
+)
+add_custom_command(
+  OUTPUT ${descriptor_table_section_proto_files}
+  DEPENDS ${protobuf_PROTOC_EXE}
+      ${protobuf_SOURCE_DIR}/src/google/protobuf/unittest_descriptor_table_section.proto
+  COMMAND ${CMAKE_COMMAND} -E make_directory ${descriptor_table_section_out}
+  COMMAND ${protobuf_PROTOC_EXE}
+      ${protobuf_SOURCE_DIR}/src/google/protobuf/unittest_descriptor_table_section.proto
+      --proto_path=${protobuf_SOURCE_DIR}/src
+      --cpp_out=lazy_descriptor_registration:${descriptor_table_section_out}
+)
+
+add_executable(descriptor-table-section-test
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/descriptor_table_section_test.cc
+  ${descriptor_table_section_proto_files}
+)
+target_include_directories(descriptor-table-section-test PRIVATE
+  ${descriptor_table_section_out})
+target_link_libraries(descriptor-table-section-test
+  ${protobuf_LIB_PROTOBUF}
+  ${protobuf_ABSL_USED_TARGETS}
+  ${protobuf_ABSL_USED_TEST_TARGETS}
+  GTest::gmock_main
+)
+
+add_test(NAME descriptor-table-section-test
+  COMMAND descriptor-table-section-test ${protobuf_GTEST_ARGS}
+  WORKING_DIRECTORY ${protobuf_SOURCE_DIR})
+
+set(specialized_parse_out ${CMAKE_CURRENT_BINARY_DIR}/specialized_parse)
+set(specialized_parse_proto_files
+  ${specialized_parse_out}/google/protobuf/unittest_specialized_parse.pb.h
+  ${specialized_parse_out}/google/protobuf/unittest_specialized_parse.pb.cc
+)
+add_custom_command(
+  OUTPUT ${specialized_parse_proto_files}
+  DEPENDS ${protobuf_PROTOC_EXE}
+      ${protobuf_SOURCE_DIR}/src/google/protobuf/unittest_specialized_parse.proto
+  COMMAND ${CMAKE_COMMAND} -E make_directory ${specialized_parse_out}
+  COMMAND ${protobuf_PROTOC_EXE}
+      ${protobuf_SOURCE_DIR}/src/google/protobuf/unittest_specialized_parse.proto
+      --proto_path=${protobuf_SOURCE_DIR}/src
+      --cpp_out=specialized_parse=protobuf_unittest.SpecializedParseMessage+protobuf_unittest.SpecializedParseChild:${specialized_parse_out}
+)
+
+add_executable(specialized-parse-test
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/specialized_parse_test.cc
+  ${specialized_parse_proto_files}
+)
+target_include_directories(specialized-parse-test PRIVATE
+  ${specialized_parse_out})
+target_link_libraries(specialized-parse-test
+  ${protobuf_LIB_PROTOBUF}
+  ${protobuf_ABSL_USED_TARGETS}
+  ${protobuf_ABSL_USED_TEST_TARGETS}
+  GTest::gmock_main
+)
+
+add_test(NAME specialized-parse-test
+  COMMAND specialized-parse-test ${protobuf_GTEST_ARGS}
+  WORKING_DIRECTORY ${protobuf_SOURCE_DIR})
+
+set(repeated_string_buffer_out ${CMAKE_CURRENT_BINARY_DIR}/repeated_string_buffer)
+set(repeated_string_buffer_proto_files
+  ${repeated_string_buffer_out}/google/protobuf/unittest_repeated_string_buffer.pb.h
+  ${repeated_string_buffer_out}/google/protobuf/unittest_repeated_string_buffer.pb.cc
+)
+add_custom_command(
+  OUTPUT ${repeated_string_buffer_proto_files}
+  DEPENDS ${protobuf_PROTOC_EXE}
+      ${protobuf_SOURCE_DIR}/src/google/protobuf/unittest_repeated_string_buffer.proto
+  COMMAND ${CMAKE_COMMAND} -E make_directory ${repeated_string_buffer_out}
+  COMMAND ${protobuf_PROTOC_EXE}
+      ${protobuf_SOURCE_DIR}/src/google/protobuf/unittest_repeated_string_buffer.proto
+      --proto_path=${protobuf_SOURCE_DIR}/src
+      --cpp_out=repeated_string_buffer=protobuf_unittest.RepeatedStringBufferMessage.names+protobuf_unittest.RepeatedStringBufferMessage.blobs:${repeated_string_buffer_out}
+)
+
+add_executable(repeated-string-buffer-test
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/repeated_string_buffer_test.cc
+  ${repeated_string_buffer_proto_files}
+)
+target_include_directories(repeated-string-buffer-test PRIVATE
+  ${repeated_string_buffer_out})
+target_link_libraries(repeated-string-buffer-test
+  ${protobuf_LIB_PROTOBUF}
+  ${protobuf_ABSL_USED_TARGETS}
+  ${protobuf_ABSL_USED_TEST_TARGETS}
+  GTest::gmock_main
+)
+
+add_test(NAME repeated-string-buffer-test
+  COMMAND repeated-string-buffer-test ${protobuf_GTEST_ARGS}
+  WORKING_DIRECTORY ${protobuf_SOURCE_DIR})
+
+set(recycle_oneof_messages_out ${CMAKE_CURRENT_BINARY_DIR}/recycle_oneof_messages)
+set(recycle_oneof_messages_proto_files
+  ${recycle_oneof_messages_out}/google/protobuf/unittest_recycle_oneof_messages.pb.h
+  ${recycle_oneof_messages_out}/google/protobuf/unittest_recycle_oneof_messages.pb.cc
+)
+add_custom_command(
+  OUTPUT ${recycle_oneof_messages_proto_files}
+  DEPENDS ${protobuf_PROTOC_EXE}
+      ${protobuf_SOURCE_DIR}/src/google/protobuf/unittest_recycle_oneof_messages.proto
+  COMMAND ${CMAKE_COMMAND} -E make_directory ${recycle_oneof_messages_out}
+  COMMAND ${protobuf_PROTOC_EXE}
+      ${protobuf_SOURCE_DIR}/src/google/protobuf/unittest_recycle_oneof_messages.proto
+      --proto_path=${protobuf_SOURCE_DIR}/src
+      --cpp_out=recycle_oneof_messages:${recycle_oneof_messages_out}
+)
+
+add_executable(recycle-oneof-messages-test
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/recycle_oneof_messages_test.cc
+  ${recycle_oneof_messages_proto_files}
+)
+target_include_directories(recycle-oneof-messages-test PRIVATE
+  ${recycle_oneof_messages_out})
+target_link_libraries(recycle-oneof-messages-test
+  ${protobuf_LIB_PROTOBUF}
+  ${protobuf_ABSL_USED_TARGETS}
+  ${protobuf_ABSL_USED_TEST_TARGETS}
+  GTest::gmock_main
+)
+
+add_test(NAME recycle-oneof-messages-test
+  COMMAND recycle-oneof-messages-test ${protobuf_GTEST_ARGS}
+  WORKING_DIRECTORY ${protobuf_SOURCE_DIR})
+
 add_custom_target(full-test
   COMMAND tests
-  DEPENDS tests lite-test fake_plugin test_plugin
+  DEPENDS tests lite-test lazy-implicit-weak-test lite-lazy-field-test
+      descriptor-table-section-test specialized-parse-test
+      recycle-oneof-messages-test fake_plugin test_plugin
   WORKING_DIRECTORY ${protobuf_SOURCE_DIR})
 
 add_test(NAME full-test
@@ -0,0 +1,360 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "conformance_benchmark.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "absl/log/absl_log.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "conformance/conformance.pb.h"
+#include "conformance_test.h"
+#include "google/protobuf/test_messages_proto3.pb.h"
+
+using conformance::ConformanceRequest;
+using conformance::ConformanceResponse;
+using protobuf_test_messages::proto3::TestAllTypesProto3;
+
+namespace google {
+namespace protobuf {
+namespace {
+
+constexpr absl::string_view kDefaultMessageType =
+    "protobuf_test_messages.proto3.TestAllTypesProto3";
+
+void BenchmarkUsageError() {
+  fprintf(stderr,
+          "Usage: conformance-test-runner --benchmark [options] "
+          "<test-program>\n");
+  fprintf(stderr, "\n");
+  fprintf(stderr, "Options:\n");
+  fprintf(stderr,
+          "  --benchmark_corpus <filename>        Binary payload to measure.\n"
+          "                                       May be repeated.  Defaults\n"
+          "                                       to a built-in corpus.\n");
+  fprintf(stderr,
+          "  --benchmark_message_type <name>      Message type of the corpus\n"
+          "                                       files.  Defaults to\n"
+          "                                       %s.\n",
+          std::string(kDefaultMessageType).c_str());
+  fprintf(stderr,
+          "  --benchmark_iterations <n>           Requests timed per payload\n"
+          "                                       and mode.  Defaults to "
+          "1000.\n");
+  fprintf(stderr,
+          "  --benchmark_report <filename>        Also write the results as\n"
+          "                                       CSV, one row per payload\n"
+          "                                       and mode.\n");
+  exit(1);
+}
+
+std::string ReadFileOrDie(const char* filename) {
+  std::ifstream in(filename, std::ios::in | std::ios::binary);
+  if (!in.is_open()) {
+    fprintf(stderr, "Couldn't open benchmark corpus file: %s\n", filename);
+    exit(1);
+  }
+  std::stringstream contents;
+  contents << in.rdbuf();
+  return contents.str();
+}
+
+std::string Basename(const std::string& path) {
+  size_t slash = path.find_last_of('/');
+  return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+}  // namespace
+
+bool ConformanceBenchmark::Requested(int argc, char* argv[]) {
+  return argc > 1 && strcmp(argv[1], "--benchmark") == 0;
+}
+
+int ConformanceBenchmark::Run(int argc, char* argv[]) {
+  std::string program;
+  std::vector<std::string> program_args;
+  std::vector<std::string> corpus_files;
+  std::string message_type(kDefaultMessageType);
+  std::string report_filename;
+  int iterations = 1000;
+
+  for (int arg = 2; arg < argc; ++arg) {
+    if (strcmp(argv[arg], "--benchmark_corpus") == 0) {
+      if (++arg == argc) BenchmarkUsageError();
+      corpus_files.push_back(argv[arg]);
+    } else if (strcmp(argv[arg], "--benchmark_message_type") == 0) {
+      if (++arg == argc) BenchmarkUsageError();
+      message_type = argv[arg];
+    } else if (strcmp(argv[arg], "--benchmark_iterations") == 0) {
+      if (++arg == argc) BenchmarkUsageError();
+      if (!absl::SimpleAtoi(argv[arg], &iterations) || iterations <= 0) {
+        BenchmarkUsageError();
+      }
+    } else if (strcmp(argv[arg], "--benchmark_report") == 0) {
+      if (++arg == argc) BenchmarkUsageError();
+      report_filename = argv[arg];
+    } else if (argv[arg][0] == '-') {
+      fprintf(stderr, "Unknown option: %s\n", argv[arg]);
+      BenchmarkUsageError();
+    } else {
+      program = argv[arg++];
+      while (arg < argc) program_args.push_back(argv[arg++]);
+    }
+  }
+  if (program.empty()) BenchmarkUsageError();
+
+  ForkPipeRunner runner(program, program_args, /*performance=*/false);
+  ConformanceBenchmark benchmark(&runner, Basename(program));
+  benchmark.SetIterations(iterations);
+  if (corpus_files.empty()) {
+    benchmark.AddDefaultCorpus();
+  }
+  for (const std::string& file : corpus_files) {
+    benchmark.AddPayload(Basename(file), message_type,
+                         ReadFileOrDie(file.c_str()));
+  }
+
+  std::string report;
+  std::string csv = "testee,payload,mode,bytes,iterations,ns_per_op,mb_per_s\n";
+  bool ok = benchmark.RunBenchmark(&report, &csv);
+  fwrite(report.c_str(), 1, report.size(), stderr);
+
+  if (!report_filename.empty()) {
+    std::ofstream out(report_filename, std::ios::out | std::ios::binary);
+    out << csv;
+    if (!out) {
+      fprintf(stderr, "Couldn't write benchmark report: %s\n",
+              report_filename.c_str());
+      return EXIT_FAILURE;
+    }
+  }
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void ConformanceBenchmark::AddPayload(const std::string& name,
+                                      const std::string& message_type,
+                                      const std::string& protobuf_payload) {
+  corpus_.push_back({name, message_type, protobuf_payload});
+}
+
+void ConformanceBenchmark::AddDefaultCorpus() {
+  const std::string message_type(kDefaultMessageType);
+
+  TestAllTypesProto3 scalars;
+  scalars.set_optional_int32(-12345);
+  scalars.set_optional_int64(1234567890123LL);
+  scalars.set_optional_uint32(4000000000U);
+  scalars.set_optional_uint64(12345678901234567890ULL);
+  scalars.set_optional_sint32(-54321);
+  scalars.set_optional_sint64(-9876543210LL);
+  scalars.set_optional_fixed32(0xdeadbeef);
+  scalars.set_optional_fixed64(0xfeedfacecafebeefULL);
+  scalars.set_optional_sfixed32(-1);
+  scalars.set_optional_sfixed64(-2);
+  scalars.set_optional_float(1.5f);
+  scalars.set_optional_double(2.25);
+  scalars.set_optional_bool(true);
+  scalars.set_optional_string("conformance benchmark");
+  scalars.set_optional_bytes("\x01\x02\x03\x04");
+  scalars.set_optional_nested_enum(TestAllTypesProto3::BAR);
+  scalars.mutable_optional_nested_message()->set_a(42);
+  AddPayload("scalars", message_type, scalars.SerializeAsString());
+
+  TestAllTypesProto3 packed;
+  for (int i = 0; i < 1000; i++) {
+    packed.add_repeated_int32(i * 7919);
+    packed.add_repeated_sint64(-int64_t{i} * 104729);
+    packed.add_repeated_fixed32(i);
+    packed.add_repeated_double(i * 0.5);
+  }
+  AddPayload("packed_repeated", message_type, packed.SerializeAsString());
+
+  TestAllTypesProto3 strings;
+  for (int i = 0; i < 200; i++) {
+    strings.add_repeated_string(
+        absl::StrCat("string value number ", i, " ", std::string(i % 48, 'x')));
+    strings.add_repeated_bytes(std::string(16 + i % 64, static_cast<char>(i)));
+  }
+  AddPayload("strings", message_type, strings.SerializeAsString());
+
+  TestAllTypesProto3 nested;
+  for (int i = 0; i < 200; i++) {
+    TestAllTypesProto3::NestedMessage* child =
+        nested.add_repeated_nested_message();
+    child->set_a(i);
+    child->mutable_corecursive()->set_optional_int32(i);
+    child->mutable_corecursive()->set_optional_string(
+        absl::StrCat("child ", i));
+  }
+  AddPayload("nested_messages", message_type, nested.SerializeAsString());
+
+  TestAllTypesProto3 maps;
+  for (int i = 0; i < 200; i++) {
+    (*maps.mutable_map_int32_int32())[i] = i * 31;
+    (*maps.mutable_map_string_string())[absl::StrCat("key", i)] =
+        absl::StrCat("value", i);
+  }
+  AddPayload("maps", message_type, maps.SerializeAsString());
+}
+
+const char* ConformanceBenchmark::ModeName(Mode mode) {
+  switch (mode) {
+    case kBinaryRoundTrip:
+      return "binary_to_binary";
+    case kBinaryToJson:
+      return "binary_to_json";
+    case kJsonToBinary:
+      return "json_to_binary";
+  }
+  return "unknown";
+}
+
+bool ConformanceBenchmark::Probe(const std::string& test_name, Mode mode,
+                                 const ConformanceRequest& request,
+                                 ConformanceResponse* response) {
+  std::string serialized_response;
+  runner_->RunTest(test_name, request.SerializeAsString(),
+                   &serialized_response);
+  if (!response->ParseFromString(serialized_response)) {
+    ABSL_LOG(ERROR) << test_name << ": unparseable response from testee";
+    return false;
+  }
+  ConformanceResponse::ResultCase expected =
+      mode == kBinaryToJson ? ConformanceResponse::kJsonPayload
+                            : ConformanceResponse::kProtobufPayload;
+  return response->result_case() == expected ||
+         response->result_case() == ConformanceResponse::kSkipped;
+}
+
+double ConformanceBenchmark::TimeRequest(const std::string& test_name,
+                                         const std::string& request) {
+  std::string response;
+  int warmup = std::max(1, iterations_ / 10);
+  for (int i = 0; i < warmup; i++) {
+    runner_->RunTest(test_name, request, &response);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations_; i++) {
+    runner_->RunTest(test_name, request, &response);
+  }
+  std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / iterations_;
+}
+
+bool ConformanceBenchmark::RunBenchmark(std::string* report, std::string* csv) {
+  bool ok = true;
+
+  // Every round trip pays for the pipe and the testee's request dispatch.
+  // Measure that with an empty message and report only what is left.
+  ConformanceRequest empty;
+  empty.set_message_type(std::string(kDefaultMessageType));
+  empty.set_protobuf_payload("");
+  empty.set_requested_output_format(conformance::PROTOBUF);
+  empty.set_test_category(conformance::BINARY_TEST);
+  const double overhead_ns =
+      TimeRequest("Benchmark.Overhead", empty.SerializeAsString());
+
+  absl::StrAppendFormat(report,
+                        "\nBenchmark results for %s (%d iterations, %.0f ns "
+                        "round trip overhead subtracted):\n\n",
+                        testee_name_, iterations_, overhead_ns);
+  absl::StrAppendFormat(report, "%-24s %-18s %10s %12s %10s\n", "payload",
+                        "mode", "bytes", "ns/op", "MB/s");
+
+  for (const Payload& payload : corpus_) {
+    std::string json_payload;
+    for (Mode mode : {kBinaryRoundTrip, kBinaryToJson, kJsonToBinary}) {
+      std::string test_name =
+          absl::StrCat("Benchmark.", payload.name, ".", ModeName(mode));
+
+      ConformanceRequest request;
+      request.set_message_type(payload.message_type);
+      if (mode == kJsonToBinary) {
+        // The JSON input is whatever this testee printed for the binary
+        // payload, so it needs no JSON printer in the tester.
+        if (json_payload.empty()) continue;
+        request.set_json_payload(json_payload);
+        request.set_test_category(conformance::JSON_TEST);
+      } else {
+        request.set_protobuf_payload(payload.protobuf_payload);
+        request.set_test_category(conformance::BINARY_TEST);
+      }
+      request.set_requested_output_format(
+          mode == kBinaryToJson ? conformance::JSON : conformance::PROTOBUF);
+
+      ConformanceResponse response;
+      if (!Probe(test_name, mode, request, &response)) {
+        absl::StrAppendFormat(report, "%-24s %-18s failed: %s\n", payload.name,
+                              ModeName(mode), response.ShortDebugString());
+        ok = false;
+        continue;
+      }
+      if (response.result_case() == ConformanceResponse::kSkipped) {
+        absl::StrAppendFormat(report, "%-24s %-18s skipped\n", payload.name,
+                              ModeName(mode));
+        continue;
+      }
+      if (mode == kBinaryToJson) json_payload = response.json_payload();
+
+      size_t bytes = mode == kJsonToBinary ? json_payload.size()
+                                           : payload.protobuf_payload.size();
+      double ns_per_op = std::max(
+          0.0,
+          TimeRequest(test_name, request.SerializeAsString()) - overhead_ns);
+      double mb_per_s = ns_per_op > 0 ? bytes * 1e3 / ns_per_op : 0;
+
+      absl::StrAppendFormat(report, "%-24s %-18s %10d %12.0f %10.1f\n",
+                            payload.name, ModeName(mode), bytes, ns_per_op,
+                            mb_per_s);
+      absl::StrAppendFormat(csv, "%s,%s,%s,%d,%d,%.0f,%.1f\n", testee_name_,
+                            payload.name, ModeName(mode), bytes, iterations_,
+                            ns_per_op, mb_per_s);
+    }
+  }
+
+  return ok;
+}
+
+}  // namespace protobuf
+}  // namespace google
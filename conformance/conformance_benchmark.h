@@ -0,0 +1,120 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// This file defines a benchmark mode for the conformance test runner.  It
+// reuses the conformance pipe protocol, so any existing testee can be measured
+// without changes: the same payloads are sent to each runtime and the time for
+// every request/response round trip is recorded.
+//
+// The protocol only exposes whole requests, so each measurement covers a parse
+// plus a serialize in the testee.  A request with an empty payload is timed
+// first and its cost is subtracted from every other measurement, so what
+// remains is the work that scales with the payload rather than the pipe.
+
+#ifndef CONFORMANCE_CONFORMANCE_BENCHMARK_H
+#define CONFORMANCE_CONFORMANCE_BENCHMARK_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "conformance/conformance.pb.h"
+#include "conformance_test.h"
+
+namespace google {
+namespace protobuf {
+
+class ConformanceBenchmark {
+ public:
+  // Returns true if the command line asks for benchmark mode, i.e. its first
+  // argument is --benchmark.
+  static bool Requested(int argc, char* argv[]);
+
+  // Parses the benchmark flags, spawns the testee and prints the report.
+  // Returns an exit code for main().
+  static int Run(int argc, char* argv[]);
+
+  ConformanceBenchmark(ConformanceTestRunner* runner, std::string testee_name)
+      : runner_(runner), testee_name_(std::move(testee_name)) {}
+
+  void SetIterations(int iterations) { iterations_ = iterations; }
+
+  // Adds a binary payload of the given message type to the corpus.
+  void AddPayload(const std::string& name, const std::string& message_type,
+                  const std::string& protobuf_payload);
+
+  // Adds the built-in corpus of TestAllTypesProto3 payloads: scalars, packed
+  // repeated fields, strings, nested messages and maps.
+  void AddDefaultCorpus();
+
+  // Measures every payload of the corpus in every mode.  Appends a table to
+  // "report" and, one line per measurement, CSV rows to "csv" that can be
+  // concatenated across testees.  Returns false if a testee failed a request
+  // it was expected to handle.
+  bool RunBenchmark(std::string* report, std::string* csv);
+
+ private:
+  enum Mode {
+    // Parse a binary payload and serialize it back to binary.
+    kBinaryRoundTrip,
+    // Parse a binary payload and serialize it to JSON.
+    kBinaryToJson,
+    // Parse a JSON payload and serialize it to binary.
+    kJsonToBinary,
+  };
+
+  struct Payload {
+    std::string name;
+    std::string message_type;
+    std::string protobuf_payload;
+  };
+
+  static const char* ModeName(Mode mode);
+
+  // Sends "request" once and checks that the testee answered in "mode"'s
+  // output format.  Stores the answer in "response".
+  bool Probe(const std::string& test_name, Mode mode,
+             const conformance::ConformanceRequest& request,
+             conformance::ConformanceResponse* response);
+
+  // Returns the average wall time of one round trip, in nanoseconds.
+  double TimeRequest(const std::string& test_name, const std::string& request);
+
+  ConformanceTestRunner* runner_;
+  std::string testee_name_;
+  int iterations_ = 1000;
+  std::vector<Payload> corpus_;
+};
+
+}  // namespace protobuf
+}  // namespace google
+
+#endif  // CONFORMANCE_CONFORMANCE_BENCHMARK_H
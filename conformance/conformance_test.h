@@ -98,7 +98,7 @@ class ForkPipeRunner : public ConformanceTestRunner {
         performance_(performance) {}
 
   explicit ForkPipeRunner(const std::string& executable)
-      : child_pid_(-1), executable_(executable) {}
+      : child_pid_(-1), executable_(executable), performance_(false) {}
 
   virtual ~ForkPipeRunner() {}
 
@@ -29,10 +29,14 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "binary_json_conformance_suite.h"
+#include "conformance_benchmark.h"
 #include "conformance_test.h"
 #include "text_format_conformance_suite.h"
 
 int main(int argc, char *argv[]) {
+  if (google::protobuf::ConformanceBenchmark::Requested(argc, argv)) {
+    return google::protobuf::ConformanceBenchmark::Run(argc, argv);
+  }
   google::protobuf::BinaryAndJsonConformanceSuite binary_and_json_suite;
   google::protobuf::TextFormatConformanceTestSuite text_format_suite;
   return google::protobuf::ForkPipeRunner::Run(
@@ -145,6 +145,12 @@ void UsageError() {
   fprintf(stderr,
           "  --output_dir                <dirname> Directory to write\n"
           "                              output files.\n");
+  fprintf(stderr,
+          "  --benchmark                 Must come first.  Measures the\n"
+          "                              throughput of the test program\n"
+          "                              instead of running the suites.\n"
+          "                              Pass it without a test program to\n"
+          "                              list the benchmark options.\n");
   exit(1);
 }
 
@@ -336,15 +342,15 @@ void ForkPipeRunner::CheckedWrite(int fd, const void *buf, size_t len) {
 bool ForkPipeRunner::TryRead(int fd, void *buf, size_t len) {
   size_t ofs = 0;
   while (len > 0) {
-    std::future<ssize_t> future = std::async(
-        std::launch::async,
-        [](int fd, void *buf, size_t ofs, size_t len) {
-          return read(fd, (char *)buf + ofs, len);
-        },
-        fd, buf, ofs, len);
-    std::future_status status;
+    ssize_t bytes_read;
     if (performance_) {
-      status = future.wait_for(std::chrono::seconds(5));
+      std::future<ssize_t> future = std::async(
+          std::launch::async,
+          [](int fd, void *buf, size_t ofs, size_t len) {
+            return read(fd, (char *)buf + ofs, len);
+          },
+          fd, buf, ofs, len);
+      std::future_status status = future.wait_for(std::chrono::seconds(5));
       if (status == std::future_status::timeout) {
         ABSL_LOG(ERROR) << current_test_name_ << ": timeout from test program";
         kill(child_pid_, SIGQUIT);
@@ -363,10 +369,12 @@ bool ForkPipeRunner::TryRead(int fd, void *buf, size_t len) {
                         << &err[0];
         return false;
       }
+      bytes_read = future.get();
     } else {
-      future.wait();
+      // Without a timeout there is no need to read on another thread, which
+      // would otherwise cost a thread start per read.
+      bytes_read = read(fd, (char *)buf + ofs, len);
     }
-    ssize_t bytes_read = future.get();
     if (bytes_read == 0) {
       ABSL_LOG(ERROR) << current_test_name_
                       << ": unexpected EOF from test program";
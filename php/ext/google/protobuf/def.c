@@ -1020,9 +1020,13 @@ PHP_METHOD(DescriptorPool, internalAddGeneratedFile) {
     return;
   }
 
+  // Every file in a set that was added before is already in the pool.
+  if (DescriptorSets_Contains(data, data_len)) return;
+
   arena = upb_Arena_New();
   add_descriptor_set(intern->symtab, data, data_len, arena);
   upb_Arena_Free(arena);
+  DescriptorSets_Add(data, data_len);
 }
 
 // clang-format off
@@ -210,8 +210,13 @@ Error, UINTPTR_MAX is undefined
  *   2. add some fallback code for when musttail isn't available (ie. return
  *      instead of tail calling). This is safe and portable, but this comes at
  *      a CPU cost.
+ *
+ * On Windows this covers clang-cl, which supports musttail.  MSVC proper has
+ * no way to guarantee tail calls, so it keeps using the generic decoder.
  */
-#if (defined(__x86_64__) || defined(__aarch64__)) && defined(__GNUC__)
+#if (defined(__x86_64__) || defined(__aarch64__) || defined(_M_X64) || \
+     defined(_M_ARM64)) &&                                               \
+    (defined(__GNUC__) || defined(__clang__))
 #define UPB_FASTTABLE_SUPPORTED 1
 #else
 #define UPB_FASTTABLE_SUPPORTED 0
@@ -2626,61 +2631,223 @@ typedef bool eqlfunc_t(upb_tabkey k1, lookupkey_t k2);
 
 /* Base table (shared code) ***************************************************/
 
-static uint32_t upb_inthash(uintptr_t key) { return (uint32_t)key; }
+/* The hash part is an open-addressing table in the style of Abseil's
+ * SwissTable. Alongside the entries there is one control byte per entry:
+ *
+ *   kUpb_Ctrl_Empty     the entry has never been used since the last rehash
+ *   kUpb_Ctrl_Deleted   the entry held a key that was removed (a tombstone)
+ *   kUpb_Ctrl_Sentinel  padding past the end of a table smaller than a group
+ *   0b0xxxxxxx          the entry is full; xxxxxxx are the low 7 bits (H2) of
+ *                       the key's hash
+ *
+ * Entries are probed a group (16 or 8 control bytes) at a time: the remaining
+ * bits of the hash (H1) pick the first group and later groups are visited in
+ * triangular order. Within a group, the control bytes whose H2 matches are
+ * found with one SIMD comparison, so keys are only compared on a likely hit.
+ * Groups are aligned, which lets a removal tell from its own group whether a
+ * probe could ever have passed through it: if the group still has an empty
+ * entry no probe did, and the entry can become empty instead of a tombstone.
+ */
+
+enum {
+  kUpb_Ctrl_Empty = 0x80,
+  kUpb_Ctrl_Deleted = 0xfe,
+  kUpb_Ctrl_Sentinel = 0xff,
+};
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+static int upb_ctz64(uint64_t v) {
+  UPB_ASSERT(v != 0);
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(v);
+#elif defined(_MSC_VER) && defined(_M_X64)
+  unsigned long idx;
+  _BitScanForward64(&idx, v);
+  return (int)idx;
+#else
+  int ret = 0;
+  while (!(v & 1)) {
+    v >>= 1;
+    ret++;
+  }
+  return ret;
+#endif
+}
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+
+#include <emmintrin.h>
+
+#define UPB_TABLE_GROUP_WIDTH 16
+
+/* One bit per control byte. */
+typedef uint32_t upb_groupmask;
+
+static upb_groupmask upb_group_match(const uint8_t* ctrl, uint8_t h2) {
+  __m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), group));
+}
+
+static upb_groupmask upb_group_matchempty(const uint8_t* ctrl) {
+  return upb_group_match(ctrl, kUpb_Ctrl_Empty);
+}
+
+static upb_groupmask upb_group_matchfree(const uint8_t* ctrl) {
+  // Empty and deleted are the only bytes less than sentinel as signed chars.
+  __m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+  return _mm_movemask_epi8(
+      _mm_cmpgt_epi8(_mm_set1_epi8((char)kUpb_Ctrl_Sentinel), group));
+}
+
+static int upb_groupmask_first(upb_groupmask mask) {
+  return upb_ctz64(mask);
+}
+
+#else
+
+#define UPB_TABLE_GROUP_WIDTH 8
+
+/* The high bit of each byte corresponds to one control byte. */
+typedef uint64_t upb_groupmask;
 
-static const upb_tabent* upb_getentry(const upb_table* t, uint32_t hash) {
-  return t->entries + (hash & t->mask);
+#define kUpb_Group_Lsbs 0x0101010101010101ULL
+#define kUpb_Group_Msbs 0x8080808080808080ULL
+
+static uint64_t upb_group_load(const uint8_t* ctrl) {
+  uint64_t ret = 0;
+  for (int i = 0; i < 8; i++) ret |= (uint64_t)ctrl[i] << (i * 8);
+  return ret;
+}
+
+static upb_groupmask upb_group_match(const uint8_t* ctrl, uint8_t h2) {
+  // May report a false positive for a byte above a real match; callers
+  // compare keys anyway.
+  uint64_t x = upb_group_load(ctrl) ^ (kUpb_Group_Lsbs * h2);
+  return (x - kUpb_Group_Lsbs) & ~x & kUpb_Group_Msbs;
+}
+
+static upb_groupmask upb_group_matchempty(const uint8_t* ctrl) {
+  // High bit set and bit 1 clear: only kUpb_Ctrl_Empty.
+  uint64_t g = upb_group_load(ctrl);
+  return g & ~(g << 6) & kUpb_Group_Msbs;
+}
+
+static upb_groupmask upb_group_matchfree(const uint8_t* ctrl) {
+  // High bit set and bit 0 clear: kUpb_Ctrl_Empty or kUpb_Ctrl_Deleted.
+  uint64_t g = upb_group_load(ctrl);
+  return g & ~(g << 7) & kUpb_Group_Msbs;
+}
+
+static int upb_groupmask_first(upb_groupmask mask) {
+  return upb_ctz64(mask) >> 3;
+}
+
+#endif
+
+static uint8_t upb_h2(uint32_t hash) { return hash & 0x7f; }
+
+static size_t upb_groupcount(const upb_table* t) {
+  size_t size = upb_table_size(t);
+  return size > UPB_TABLE_GROUP_WIDTH ? size / UPB_TABLE_GROUP_WIDTH : 1;
+}
+
+/* Probe sequence over aligned groups. With a power-of-two group count,
+ * triangular steps visit every group exactly once. */
+typedef struct {
+  size_t group;
+  size_t mask;
+  size_t step;
+} upb_probeseq;
+
+static upb_probeseq upb_probeseq_start(const upb_table* t, uint32_t hash) {
+  upb_probeseq seq;
+  seq.mask = t->mask / UPB_TABLE_GROUP_WIDTH;  // Zero for a single group.
+  seq.group = (hash >> 7) & seq.mask;
+  seq.step = 0;
+  return seq;
+}
+
+static void upb_probeseq_next(upb_probeseq* seq) {
+  seq->step++;
+  seq->group = (seq->group + seq->step) & seq->mask;
+}
+
+static const uint8_t* upb_groupctrl(const upb_table* t, size_t group) {
+  return t->ctrl + group * UPB_TABLE_GROUP_WIDTH;
+}
+
+static uint32_t upb_inthash(uintptr_t key) {
+  // Keys are often small integers or aligned pointers, which would cluster
+  // badly if used directly; take the high half of a multiplicative hash.
+  return (uint32_t)(((uint64_t)key * 0x9E3779B97F4A7C15ULL) >> 32);
 }
 
 static bool upb_arrhas(upb_tabval key) { return key.val != (uint64_t)-1; }
 
-static bool isfull(upb_table* t) { return t->count == t->max_count; }
+static bool isfull(upb_table* t) {
+  return t->count + t->deleted >= t->max_count;
+}
+
+/* The size to rehash to once `t` is full: if half or more of the used entries
+ * are tombstones, rehashing in place reclaims enough room. */
+static uint8_t growsize_lg2(const upb_table* t) {
+  return t->size_lg2 && t->deleted >= t->count ? t->size_lg2
+                                               : t->size_lg2 + 1;
+}
+
+static void init_ctrl(upb_table* t) {
+  size_t size = upb_table_size(t);
+  size_t ctrl_size = upb_groupcount(t) * UPB_TABLE_GROUP_WIDTH;
+  memset(t->ctrl, kUpb_Ctrl_Empty, size);
+  memset(t->ctrl + size, kUpb_Ctrl_Sentinel, ctrl_size - size);
+}
 
 static bool init(upb_table* t, uint8_t size_lg2, upb_Arena* a) {
   size_t bytes;
 
   t->count = 0;
+  t->deleted = 0;
   t->size_lg2 = size_lg2;
   t->mask = upb_table_size(t) ? upb_table_size(t) - 1 : 0;
   t->max_count = upb_table_size(t) * MAX_LOAD;
   bytes = upb_table_size(t) * sizeof(upb_tabent);
   if (bytes > 0) {
-    t->entries = upb_Arena_Malloc(a, bytes);
+    size_t ctrl_size = upb_groupcount(t) * UPB_TABLE_GROUP_WIDTH;
+    t->entries = upb_Arena_Malloc(a, bytes + ctrl_size);
     if (!t->entries) return false;
     memset(t->entries, 0, bytes);
+    t->ctrl = (uint8_t*)(t->entries + upb_table_size(t));
+    init_ctrl(t);
   } else {
     t->entries = NULL;
+    t->ctrl = NULL;
   }
   return true;
 }
 
-static upb_tabent* emptyent(upb_table* t, upb_tabent* e) {
-  upb_tabent* begin = t->entries;
-  upb_tabent* end = begin + upb_table_size(t);
-  for (e = e + 1; e < end; e++) {
-    if (upb_tabent_isempty(e)) return e;
-  }
-  for (e = begin; e < end; e++) {
-    if (upb_tabent_isempty(e)) return e;
-  }
-  UPB_ASSERT(false);
-  return NULL;
-}
-
-static upb_tabent* getentry_mutable(upb_table* t, uint32_t hash) {
-  return (upb_tabent*)upb_getentry(t, hash);
-}
-
 static const upb_tabent* findentry(const upb_table* t, lookupkey_t key,
                                    uint32_t hash, eqlfunc_t* eql) {
-  const upb_tabent* e;
+  upb_probeseq seq;
+  uint8_t h2 = upb_h2(hash);
 
   if (t->size_lg2 == 0) return NULL;
-  e = upb_getentry(t, hash);
-  if (upb_tabent_isempty(e)) return NULL;
+  seq = upb_probeseq_start(t, hash);
   while (1) {
-    if (eql(e->key, key)) return e;
-    if ((e = e->next) == NULL) return NULL;
+    const uint8_t* ctrl = upb_groupctrl(t, seq.group);
+    upb_groupmask match = upb_group_match(ctrl, h2);
+    while (match) {
+      const upb_tabent* e =
+          &t->entries[seq.group * UPB_TABLE_GROUP_WIDTH +
+                      upb_groupmask_first(match)];
+      if (eql(e->key, key)) return e;
+      match &= match - 1;
+    }
+    if (upb_group_matchempty(ctrl)) return NULL;
+    upb_probeseq_next(&seq);
   }
 }
 
@@ -2702,90 +2869,76 @@ static bool lookup(const upb_table* t, lookupkey_t key, upb_value* v,
   }
 }
 
+/* Inserts without checking for duplicates or load; the table must have a free
+ * entry. */
+static void insert_unique(upb_table* t, upb_tabkey tabkey, upb_value val,
+                          uint32_t hash) {
+  upb_probeseq seq = upb_probeseq_start(t, hash);
+  while (1) {
+    upb_groupmask free = upb_group_matchfree(upb_groupctrl(t, seq.group));
+    if (free) {
+      size_t i = seq.group * UPB_TABLE_GROUP_WIDTH + upb_groupmask_first(free);
+      if (t->ctrl[i] == kUpb_Ctrl_Deleted) t->deleted--;
+      t->ctrl[i] = upb_h2(hash);
+      t->entries[i].key = tabkey;
+      t->entries[i].val.val = val.val;
+      t->count++;
+      return;
+    }
+    upb_probeseq_next(&seq);
+  }
+}
+
 /* The given key must not already exist in the table. */
 static void insert(upb_table* t, lookupkey_t key, upb_tabkey tabkey,
-                   upb_value val, uint32_t hash, hashfunc_t* hashfunc,
-                   eqlfunc_t* eql) {
-  upb_tabent* mainpos_e;
-  upb_tabent* our_e;
-
+                   upb_value val, uint32_t hash, eqlfunc_t* eql) {
   UPB_ASSERT(findentry(t, key, hash, eql) == NULL);
+  UPB_ASSERT(!isfull(t));
+  insert_unique(t, tabkey, val, hash);
+  UPB_ASSERT(findentry(t, key, hash, eql)->key == tabkey);
+}
 
-  t->count++;
-  mainpos_e = getentry_mutable(t, hash);
-  our_e = mainpos_e;
+/* Rebuilds `t` with 2^size_lg2 entries, moving the existing keys over without
+ * copying them. */
+static bool rehash(upb_table* t, uint8_t size_lg2, hashfunc_t* hashfunc,
+                   upb_Arena* a) {
+  upb_table new_table;
+  size_t i;
 
-  if (upb_tabent_isempty(mainpos_e)) {
-    /* Our main position is empty; use it. */
-    our_e->next = NULL;
+  if (!init(&new_table, size_lg2, a)) return false;
+  for (i = 0; i < upb_table_size(t); i++) {
+    const upb_tabent* e = &t->entries[i];
+    upb_value v;
+    if (upb_tabent_isempty(e)) continue;
+    _upb_value_setval(&v, e->val.val);
+    insert_unique(&new_table, e->key, v, hashfunc(e->key));
+  }
+  UPB_ASSERT(t->count == new_table.count);
+  *t = new_table;
+  return true;
+}
+
+/* Empties the entry at index i, which must be full. */
+static void rm_entry(upb_table* t, size_t i) {
+  const uint8_t* ctrl = upb_groupctrl(t, i / UPB_TABLE_GROUP_WIDTH);
+  t->count--;
+  t->entries[i].key = 0;
+  if (upb_group_matchempty(ctrl)) {
+    t->ctrl[i] = kUpb_Ctrl_Empty;
   } else {
-    /* Collision. */
-    upb_tabent* new_e = emptyent(t, mainpos_e);
-    /* Head of collider's chain. */
-    upb_tabent* chain = getentry_mutable(t, hashfunc(mainpos_e->key));
-    if (chain == mainpos_e) {
-      /* Existing ent is in its main position (it has the same hash as us, and
-       * is the head of our chain).  Insert to new ent and append to this chain.
-       */
-      new_e->next = mainpos_e->next;
-      mainpos_e->next = new_e;
-      our_e = new_e;
-    } else {
-      /* Existing ent is not in its main position (it is a node in some other
-       * chain).  This implies that no existing ent in the table has our hash.
-       * Evict it (updating its chain) and use its ent for head of our chain. */
-      *new_e = *mainpos_e; /* copies next. */
-      while (chain->next != mainpos_e) {
-        chain = (upb_tabent*)chain->next;
-        UPB_ASSERT(chain);
-      }
-      chain->next = new_e;
-      our_e = mainpos_e;
-      our_e->next = NULL;
-    }
+    t->ctrl[i] = kUpb_Ctrl_Deleted;
+    t->deleted++;
   }
-  our_e->key = tabkey;
-  our_e->val.val = val.val;
-  UPB_ASSERT(findentry(t, key, hash, eql) == our_e);
 }
 
 static bool rm(upb_table* t, lookupkey_t key, upb_value* val,
                upb_tabkey* removed, uint32_t hash, eqlfunc_t* eql) {
-  upb_tabent* chain = getentry_mutable(t, hash);
-  if (upb_tabent_isempty(chain)) return false;
-  if (eql(chain->key, key)) {
-    /* Element to remove is at the head of its chain. */
-    t->count--;
-    if (val) _upb_value_setval(val, chain->val.val);
-    if (removed) *removed = chain->key;
-    if (chain->next) {
-      upb_tabent* move = (upb_tabent*)chain->next;
-      *chain = *move;
-      move->key = 0; /* Make the slot empty. */
-    } else {
-      chain->key = 0; /* Make the slot empty. */
-    }
-    return true;
-  } else {
-    /* Element to remove is either in a non-head position or not in the
-     * table. */
-    while (chain->next && !eql(chain->next->key, key)) {
-      chain = (upb_tabent*)chain->next;
-    }
-    if (chain->next) {
-      /* Found element to remove. */
-      upb_tabent* rm = (upb_tabent*)chain->next;
-      t->count--;
-      if (val) _upb_value_setval(val, chain->next->val.val);
-      if (removed) *removed = rm->key;
-      rm->key = 0; /* Make the slot empty. */
-      chain->next = rm->next;
-      return true;
-    } else {
-      /* Element to remove is not in the table. */
-      return false;
-    }
-  }
+  upb_tabent* e = findentry_mutable(t, key, hash, eql);
+  if (!e) return false;
+  if (val) _upb_value_setval(val, e->val.val);
+  if (removed) *removed = e->key;
+  rm_entry(t, e - t->entries);
+  return true;
 }
 
 static size_t next(const upb_table* t, size_t i) {
@@ -2980,21 +3133,13 @@ bool upb_strtable_init(upb_strtable* t, size_t expected_size, upb_Arena* a) {
 void upb_strtable_clear(upb_strtable* t) {
   size_t bytes = upb_table_size(&t->t) * sizeof(upb_tabent);
   t->t.count = 0;
+  t->t.deleted = 0;
   memset((char*)t->t.entries, 0, bytes);
+  if (t->t.ctrl) init_ctrl(&t->t);
 }
 
 bool upb_strtable_resize(upb_strtable* t, size_t size_lg2, upb_Arena* a) {
-  upb_strtable new_table;
-  if (!init(&new_table.t, size_lg2, a)) return false;
-
-  intptr_t iter = UPB_STRTABLE_BEGIN;
-  upb_StringView key;
-  upb_value val;
-  while (upb_strtable_next2(t, &key, &val, &iter)) {
-    upb_strtable_insert(&new_table, key.data, key.size, val, a);
-  }
-  *t = new_table;
-  return true;
+  return rehash(&t->t, size_lg2, &strhash, a);
 }
 
 bool upb_strtable_insert(upb_strtable* t, const char* k, size_t len,
@@ -3004,8 +3149,9 @@ bool upb_strtable_insert(upb_strtable* t, const char* k, size_t len,
   uint32_t hash;
 
   if (isfull(&t->t)) {
-    /* Need to resize.  New table of double the size, add old elements to it. */
-    if (!upb_strtable_resize(t, t->t.size_lg2 + 1, a)) {
+    /* Need to resize.  Rehash the existing keys into a larger table (or one of
+     * the same size, if that clears enough tombstones). */
+    if (!upb_strtable_resize(t, growsize_lg2(&t->t), a)) {
       return false;
     }
   }
@@ -3015,7 +3161,7 @@ bool upb_strtable_insert(upb_strtable* t, const char* k, size_t len,
   if (tabkey == 0) return false;
 
   hash = _upb_Hash_NoSeed(key.str.str, key.str.len);
-  insert(&t->t, key, tabkey, v, hash, &strhash, &streql);
+  insert(&t->t, key, tabkey, v, hash, &streql);
   return true;
 }
 
@@ -3160,28 +3306,11 @@ bool upb_inttable_insert(upb_inttable* t, uintptr_t key, upb_value val,
   } else {
     if (isfull(&t->t)) {
       /* Need to resize the hash part, but we re-use the array part. */
-      size_t i;
-      upb_table new_table;
-
-      if (!init(&new_table, t->t.size_lg2 + 1, a)) {
+      if (!rehash(&t->t, growsize_lg2(&t->t), &inthash, a)) {
         return false;
       }
-
-      for (i = begin(&t->t); i < upb_table_size(&t->t); i = next(&t->t, i)) {
-        const upb_tabent* e = &t->t.entries[i];
-        uint32_t hash;
-        upb_value v;
-
-        _upb_value_setval(&v, e->val.val);
-        hash = upb_inthash(e->key);
-        insert(&new_table, intkey(e->key), e->key, v, hash, &inthash, &inteql);
-      }
-
-      UPB_ASSERT(t->t.count == new_table.count);
-
-      t->t = new_table;
     }
-    insert(&t->t, intkey(key), key, val, upb_inthash(key), &inthash, &inteql);
+    insert(&t->t, intkey(key), key, val, upb_inthash(key), &inteql);
   }
   check(t);
   return true;
@@ -3319,25 +3448,7 @@ void upb_inttable_removeiter(upb_inttable* t, intptr_t* iter) {
     t->array_count--;
     mutable_array(t)[i].val = -1;
   } else {
-    upb_tabent* ent = &t->t.entries[i - t->array_size];
-    upb_tabent* prev = NULL;
-
-    // Linear search, not great.
-    upb_tabent* end = &t->t.entries[upb_table_size(&t->t)];
-    for (upb_tabent* e = t->t.entries; e != end; e++) {
-      if (e->next == ent) {
-        prev = e;
-        break;
-      }
-    }
-
-    if (prev) {
-      prev->next = ent->next;
-    }
-
-    t->t.count--;
-    ent->key = 0;
-    ent->next = NULL;
+    rm_entry(&t->t, i - t->array_size);
   }
 }
 
@@ -3358,26 +3469,7 @@ bool upb_strtable_next2(const upb_strtable* t, upb_StringView* key,
 }
 
 void upb_strtable_removeiter(upb_strtable* t, intptr_t* iter) {
-  intptr_t i = *iter;
-  upb_tabent* ent = &t->t.entries[i];
-  upb_tabent* prev = NULL;
-
-  // Linear search, not great.
-  upb_tabent* end = &t->t.entries[upb_table_size(&t->t)];
-  for (upb_tabent* e = t->t.entries; e != end; e++) {
-    if (e->next == ent) {
-      prev = e;
-      break;
-    }
-  }
-
-  if (prev) {
-    prev->next = ent->next;
-  }
-
-  t->t.count--;
-  ent->key = 0;
-  ent->next = NULL;
+  rm_entry(&t->t, *iter);
 }
 
 void upb_strtable_setentryvalue(upb_strtable* t, intptr_t iter, upb_value v) {
@@ -3760,6 +3852,37 @@ static void jsondec_resize(jsondec* d, char** buf, char** end, char** buf_end) {
   *buf_end = *buf + size;
 }
 
+// Returns a pointer to the first byte in [ptr, end) that ends a plain run of
+// JSON string data (a quote, a backslash or a control character), or `end`.
+// Scans a word at a time, since most strings contain no escapes.
+static const char* jsondec_skipplain(const char* ptr, const char* end) {
+  const uint64_t ones = 0x0101010101010101ULL;
+  const uint64_t highs = 0x8080808080808080ULL;
+
+  while (end - ptr >= 8) {
+    uint64_t w;
+    memcpy(&w, ptr, 8);
+    // `(x - ones * n) & ~x & highs` is nonzero iff some byte of `x` is less
+    // than `n` (for n <= 0x80); with n == 1 that finds zero bytes, which the
+    // XORs turn into matches for '"' and '\\'.
+    uint64_t quote = w ^ (ones * '"');
+    uint64_t backslash = w ^ (ones * '\\');
+    uint64_t special = ((quote - ones) & ~quote) |
+                       ((backslash - ones) & ~backslash) |
+                       ((w - ones * 0x20) & ~w);
+    if (special & highs) break;
+    ptr += 8;
+  }
+
+  while (ptr < end) {
+    uint8_t ch = *ptr;
+    if (ch == '"' || ch == '\\' || ch < 0x20) break;
+    ptr++;
+  }
+
+  return ptr;
+}
+
 static upb_StringView jsondec_string(jsondec* d) {
   char* buf = NULL;
   char* end = NULL;
@@ -3772,11 +3895,19 @@ static upb_StringView jsondec_string(jsondec* d) {
   }
 
   while (d->ptr < d->end) {
-    char ch = *d->ptr++;
+    const char* plain = jsondec_skipplain(d->ptr, d->end);
+    size_t n = plain - d->ptr;
 
-    if (end == buf_end) {
+    // Always leaves room for at least one more byte.
+    while (end == buf_end || (size_t)(buf_end - end) <= n) {
       jsondec_resize(d, &buf, &end, &buf_end);
     }
+    if (n) memcpy(end, d->ptr, n);
+    end += n;
+    d->ptr = plain;
+    if (d->ptr == d->end) break;
+
+    char ch = *d->ptr++;
 
     switch (ch) {
       case '"': {
@@ -3800,11 +3931,7 @@ static upb_StringView jsondec_string(jsondec* d) {
         }
         break;
       default:
-        if ((unsigned char)*d->ptr < 0x20) {
-          jsondec_err(d, "Invalid char in JSON string");
-        }
-        *end++ = ch;
-        break;
+        jsondec_err(d, "Invalid char in JSON string");
     }
   }
 
@@ -5068,11 +5195,47 @@ static void jsonenc_bytes(jsonenc* e, upb_StringView str) {
   jsonenc_putstr(e, "\"");
 }
 
+// Returns a pointer to the first byte in [ptr, end) that must be escaped in a
+// JSON string (a quote, a backslash or a control character), or `end`.
+// Scans a word at a time, since most strings need no escaping at all.
+static const char* jsonenc_skipplain(const char* ptr, const char* end) {
+  const uint64_t ones = 0x0101010101010101ULL;
+  const uint64_t highs = 0x8080808080808080ULL;
+
+  while (end - ptr >= 8) {
+    uint64_t w;
+    memcpy(&w, ptr, 8);
+    // `(x - ones * n) & ~x & highs` is nonzero iff some byte of `x` is less
+    // than `n` (for n <= 0x80); with n == 1 that finds zero bytes, which the
+    // XORs turn into matches for '"' and '\\'.
+    uint64_t quote = w ^ (ones * '"');
+    uint64_t backslash = w ^ (ones * '\\');
+    uint64_t special = ((quote - ones) & ~quote) |
+                       ((backslash - ones) & ~backslash) |
+                       ((w - ones * 0x20) & ~w);
+    if (special & highs) break;
+    ptr += 8;
+  }
+
+  while (ptr < end) {
+    uint8_t ch = *ptr;
+    if (ch == '"' || ch == '\\' || ch < 0x20) break;
+    ptr++;
+  }
+
+  return ptr;
+}
+
 static void jsonenc_stringbody(jsonenc* e, upb_StringView str) {
   const char* ptr = str.data;
   const char* end = UPB_PTRADD(ptr, str.size);
 
   while (ptr < end) {
+    const char* plain = jsonenc_skipplain(ptr, end);
+    if (plain != ptr) jsonenc_putbytes(e, ptr, plain - ptr);
+    ptr = plain;
+    if (ptr == end) break;
+
     switch (*ptr) {
       case '\n':
         jsonenc_putstr(e, "\\n");
@@ -5096,13 +5259,7 @@ static void jsonenc_stringbody(jsonenc* e, upb_StringView str) {
         jsonenc_putstr(e, "\\\\");
         break;
       default:
-        if ((uint8_t)*ptr < 0x20) {
-          jsonenc_printf(e, "\\u%04x", (int)(uint8_t)*ptr);
-        } else {
-          /* This could be a non-ASCII byte.  We rely on the string being valid
-           * UTF-8. */
-          jsonenc_putbytes(e, ptr, 1);
-        }
+        jsonenc_printf(e, "\\u%04x", (int)(uint8_t)*ptr);
         break;
     }
     ptr++;
@@ -5518,7 +5675,9 @@ static void jsonenc_fieldval(jsonenc* e, const upb_FieldDef* f,
     } else {
       name = upb_FieldDef_JsonName(f);
     }
-    jsonenc_printf(e, "\"%s\":", name);
+    jsonenc_putstr(e, "\"");
+    jsonenc_stringbody(e, upb_StringView_FromString(name));
+    jsonenc_putstr(e, "\":");
   }
 
   if (upb_FieldDef_IsMap(f)) {
@@ -5810,6 +5969,44 @@ struct _upb_MemBlock {
 static const size_t memblock_reserve =
     UPB_ALIGN_UP(sizeof(_upb_MemBlock), UPB_MALLOC_ALIGN);
 
+#define kUpb_Arena_DefaultInitialBlockSize 256
+#define kUpb_Arena_DefaultGrowthFactor 2
+
+static upb_ArenaOptions _upb_Arena_DefaultOptions = {
+    kUpb_Arena_DefaultInitialBlockSize,
+    0,
+    kUpb_Arena_DefaultGrowthFactor,
+};
+
+// Fills in the zero fields of |options| (which may be NULL) from the
+// process-wide defaults.
+static upb_ArenaOptions _upb_Arena_ResolveOptions(
+    const upb_ArenaOptions* options) {
+  upb_ArenaOptions ret = _upb_Arena_DefaultOptions;
+  if (options) {
+    if (options->initial_block_size) {
+      ret.initial_block_size = options->initial_block_size;
+    }
+    if (options->max_block_size) ret.max_block_size = options->max_block_size;
+    if (options->growth_factor) ret.growth_factor = options->growth_factor;
+  }
+  return ret;
+}
+
+void upb_Arena_SetDefaultOptions(const upb_ArenaOptions* options) {
+  _upb_Arena_DefaultOptions.initial_block_size =
+      options->initial_block_size ? options->initial_block_size
+                                  : kUpb_Arena_DefaultInitialBlockSize;
+  _upb_Arena_DefaultOptions.max_block_size = options->max_block_size;
+  _upb_Arena_DefaultOptions.growth_factor =
+      options->growth_factor ? options->growth_factor
+                             : kUpb_Arena_DefaultGrowthFactor;
+}
+
+void upb_Arena_GetDefaultOptions(upb_ArenaOptions* options) {
+  *options = _upb_Arena_DefaultOptions;
+}
+
 typedef struct _upb_ArenaRoot {
   upb_Arena* root;
   uintptr_t tagged_count;
@@ -5852,21 +6049,27 @@ static _upb_ArenaRoot _upb_Arena_FindRoot(upb_Arena* a) {
   return (_upb_ArenaRoot){.root = a, .tagged_count = poc};
 }
 
-size_t upb_Arena_SpaceAllocated(upb_Arena* arena) {
+void upb_Arena_GetStats(upb_Arena* arena, upb_ArenaStats* stats) {
   arena = _upb_Arena_FindRoot(arena).root;
-  size_t memsize = 0;
+  memset(stats, 0, sizeof(*stats));
 
   while (arena != NULL) {
     _upb_MemBlock* block =
         upb_Atomic_Load(&arena->blocks, memory_order_relaxed);
     while (block != NULL) {
-      memsize += sizeof(_upb_MemBlock) + block->size;
+      stats->space_allocated += sizeof(_upb_MemBlock) + block->size;
+      stats->block_count++;
+      stats->largest_block = UPB_MAX(stats->largest_block, block->size);
       block = upb_Atomic_Load(&block->next, memory_order_relaxed);
     }
     arena = upb_Atomic_Load(&arena->next, memory_order_relaxed);
   }
+}
 
-  return memsize;
+size_t upb_Arena_SpaceAllocated(upb_Arena* arena) {
+  upb_ArenaStats stats;
+  upb_Arena_GetStats(arena, &stats);
+  return stats.space_allocated;
 }
 
 uint32_t upb_Arena_DebugRefCount(upb_Arena* a) {
@@ -5895,10 +6098,13 @@ static void upb_Arena_AddBlock(upb_Arena* a, void* ptr, size_t size) {
 }
 
 static bool upb_Arena_AllocBlock(upb_Arena* a, size_t size) {
-  if (!a->block_alloc) return false;
+  if (!upb_Arena_BlockAlloc(a)) return false;
   _upb_MemBlock* last_block = upb_Atomic_Load(&a->blocks, memory_order_acquire);
   size_t last_size = last_block != NULL ? last_block->size : 128;
-  size_t block_size = UPB_MAX(size, last_size * 2) + memblock_reserve;
+  uint64_t next_size = (uint64_t)last_size * a->growth_factor;
+  size_t block_size =
+      UPB_MAX(size, (size_t)UPB_MIN(next_size, a->max_block_size)) +
+      memblock_reserve;
   _upb_MemBlock* block = upb_malloc(upb_Arena_BlockAlloc(a), block_size);
 
   if (!block) return false;
@@ -5907,20 +6113,33 @@ static bool upb_Arena_AllocBlock(upb_Arena* a, size_t size) {
 }
 
 void* _upb_Arena_SlowMalloc(upb_Arena* a, size_t size) {
-  if (!upb_Arena_AllocBlock(a, size)) return NULL; /* Out of memory. */
-  UPB_ASSERT(_upb_ArenaHas(a) >= size);
+  // Leave room for the guard upb_Arena_Malloc() checks for, otherwise a
+  // block capped at exactly |size| would send us straight back here.
+  size_t span = size + UPB_ASAN_GUARD_SIZE;
+  if (!upb_Arena_AllocBlock(a, span)) return NULL; /* Out of memory. */
+  UPB_ASSERT(_upb_ArenaHas(a) >= span);
   return upb_Arena_Malloc(a, size);
 }
 
 /* Public Arena API ***********************************************************/
 
-static upb_Arena* upb_Arena_InitSlow(upb_alloc* alloc) {
+static void upb_Arena_SetGrowthPolicy(upb_Arena* a,
+                                      const upb_ArenaOptions* options) {
+  a->max_block_size = options->max_block_size
+                          ? (uint32_t)UPB_MIN(options->max_block_size,
+                                              UINT32_MAX - memblock_reserve)
+                          : UINT32_MAX - memblock_reserve;
+  a->growth_factor = options->growth_factor;
+}
+
+static upb_Arena* upb_Arena_InitSlow(upb_alloc* alloc,
+                                     const upb_ArenaOptions* options) {
   const size_t first_block_overhead = sizeof(upb_Arena) + memblock_reserve;
   upb_Arena* a;
 
   /* We need to malloc the initial block. */
   char* mem;
-  size_t n = first_block_overhead + 256;
+  size_t n = first_block_overhead + options->initial_block_size;
   if (!alloc || !(mem = upb_malloc(alloc, n))) {
     return NULL;
   }
@@ -5933,6 +6152,7 @@ static upb_Arena* upb_Arena_InitSlow(upb_alloc* alloc) {
   upb_Atomic_Init(&a->next, NULL);
   upb_Atomic_Init(&a->tail, a);
   upb_Atomic_Init(&a->blocks, NULL);
+  upb_Arena_SetGrowthPolicy(a, options);
 
   upb_Arena_AddBlock(a, mem, n);
 
@@ -5940,6 +6160,12 @@ static upb_Arena* upb_Arena_InitSlow(upb_alloc* alloc) {
 }
 
 upb_Arena* upb_Arena_Init(void* mem, size_t n, upb_alloc* alloc) {
+  return upb_Arena_InitWithOptions(mem, n, alloc, NULL);
+}
+
+upb_Arena* upb_Arena_InitWithOptions(void* mem, size_t n, upb_alloc* alloc,
+                                     const upb_ArenaOptions* options) {
+  upb_ArenaOptions resolved = _upb_Arena_ResolveOptions(options);
   upb_Arena* a;
 
   if (n) {
@@ -5955,7 +6181,7 @@ upb_Arena* upb_Arena_Init(void* mem, size_t n, upb_alloc* alloc) {
   n = UPB_ALIGN_DOWN(n, UPB_ALIGN_OF(upb_Arena));
 
   if (UPB_UNLIKELY(n < sizeof(upb_Arena))) {
-    return upb_Arena_InitSlow(alloc);
+    return upb_Arena_InitSlow(alloc, &resolved);
   }
 
   a = UPB_PTR_AT(mem, n - sizeof(*a), upb_Arena);
@@ -5965,6 +6191,7 @@ upb_Arena* upb_Arena_Init(void* mem, size_t n, upb_alloc* alloc) {
   upb_Atomic_Init(&a->tail, a);
   upb_Atomic_Init(&a->blocks, NULL);
   a->block_alloc = upb_Arena_MakeBlockAlloc(alloc, 1);
+  upb_Arena_SetGrowthPolicy(a, &resolved);
   a->head.ptr = mem;
   a->head.end = UPB_PTR_AT(mem, n - sizeof(*a), char);
 
@@ -6020,29 +6247,55 @@ retry:
   goto retry;
 }
 
+bool upb_Arena_IncRefFor(upb_Arena* a, const void* owner) {
+  UPB_UNUSED(owner);
+  if (upb_Arena_HasInitialBlock(a)) return false;
+
+  _upb_ArenaRoot r;
+retry:
+  r = _upb_Arena_FindRoot(a);
+  if (upb_Atomic_CompareExchangeWeak(
+          &r.root->parent_or_count, &r.tagged_count,
+          _upb_Arena_TaggedFromRefcount(
+              _upb_Arena_RefCountFromTagged(r.tagged_count) + 1),
+          memory_order_release, memory_order_acquire)) {
+    return true;
+  }
+
+  // Either the count changed or the root was fused away; look again.
+  goto retry;
+}
+
+void upb_Arena_DecRefFor(upb_Arena* a, const void* owner) {
+  UPB_UNUSED(owner);
+  upb_Arena_Free(a);
+}
+
 static void _upb_Arena_DoFuseArenaLists(upb_Arena* const parent,
                                         upb_Arena* child) {
-  upb_Arena* parent_tail = upb_Atomic_Load(&parent->tail, memory_order_relaxed);
+  // The list links are how other threads reach arenas they did not create, so
+  // they are published with release and read with acquire ordering.
+  upb_Arena* parent_tail = upb_Atomic_Load(&parent->tail, memory_order_acquire);
   do {
     // Our tail might be stale, but it will always converge to the true tail.
     upb_Arena* parent_tail_next =
-        upb_Atomic_Load(&parent_tail->next, memory_order_relaxed);
+        upb_Atomic_Load(&parent_tail->next, memory_order_acquire);
     while (parent_tail_next != NULL) {
       parent_tail = parent_tail_next;
       parent_tail_next =
-          upb_Atomic_Load(&parent_tail->next, memory_order_relaxed);
+          upb_Atomic_Load(&parent_tail->next, memory_order_acquire);
     }
 
     upb_Arena* displaced =
-        upb_Atomic_Exchange(&parent_tail->next, child, memory_order_relaxed);
-    parent_tail = upb_Atomic_Load(&child->tail, memory_order_relaxed);
+        upb_Atomic_Exchange(&parent_tail->next, child, memory_order_acq_rel);
+    parent_tail = upb_Atomic_Load(&child->tail, memory_order_acquire);
 
     // If we displaced something that got installed racily, we can simply
     // reinstall it on our new tail.
     child = displaced;
   } while (child != NULL);
 
-  upb_Atomic_Store(&parent->tail, parent_tail, memory_order_relaxed);
+  upb_Atomic_Store(&parent->tail, parent_tail, memory_order_release);
 }
 
 static upb_Arena* _upb_Arena_DoFuse(upb_Arena* a1, upb_Arena* a2,
@@ -6071,32 +6324,49 @@ static upb_Arena* _upb_Arena_DoFuse(upb_Arena* a1, upb_Arena* a2,
   // increments to that refcount and their frees!).  We need to add `r2`'s refs
   // now, so that `r1` can withstand any unrefs that come from r2.
   //
-  // Note that while it is possible for `r2`'s refcount to increase
-  // asynchronously, we will not actually do the reparenting operation below
-  // unless `r2`'s refcount is unchanged from when we read it.
+  // Under contention either CAS below can fail merely because another thread
+  // changed a refcount while the arena stayed a root.  Re-walking both trees
+  // for that is wasteful, so we only start over when `r1` or `r2` stops being
+  // a root; otherwise we retry in place with the freshly loaded value.
   //
-  // Note that we may have done this previously, either to this node or a
-  // different node, during a previous and failed DoFuse() attempt. But we will
-  // not lose track of these refs because we always add them to our overall
-  // delta.
+  // `added` is how many of `r2`'s refs (untagged, so still shifted left by one)
+  // we have moved to `r1` so far.  It can exceed `r2`'s final count if `r2` was
+  // unreffed concurrently; any excess, and any refs added during a failed
+  // attempt, go into the overall `ref_delta` and are removed from the final
+  // root in a single fixup.
+  uintptr_t added = 0;
   uintptr_t r2_untagged_count = r2.tagged_count & ~1;
-  uintptr_t with_r2_refs = r1.tagged_count + r2_untagged_count;
-  if (!upb_Atomic_CompareExchangeStrong(
-          &r1.root->parent_or_count, &r1.tagged_count, with_r2_refs,
-          memory_order_release, memory_order_acquire)) {
-    return NULL;
-  }
+  while (true) {
+    while (added < r2_untagged_count) {
+      uintptr_t with_r2_refs = r1.tagged_count + (r2_untagged_count - added);
+      if (upb_Atomic_CompareExchangeWeak(
+              &r1.root->parent_or_count, &r1.tagged_count, with_r2_refs,
+              memory_order_release, memory_order_acquire)) {
+        r1.tagged_count = with_r2_refs;
+        added = r2_untagged_count;
+      } else if (_upb_Arena_IsTaggedPointer(r1.tagged_count)) {
+        // `r1` was fused under another root, start over from the top.
+        *ref_delta += added;
+        return NULL;
+      }
+    }
 
-  // Perform the actual fuse by removing the refs from `r2` and swapping in the
-  // parent pointer.
-  if (!upb_Atomic_CompareExchangeStrong(
-          &r2.root->parent_or_count, &r2.tagged_count,
-          _upb_Arena_TaggedFromPointer(r1.root), memory_order_release,
-          memory_order_acquire)) {
-    // We'll need to remove the excess refs we added to r1 previously.
-    *ref_delta += r2_untagged_count;
-    return NULL;
+    // Perform the actual fuse by removing the refs from `r2` and swapping in
+    // the parent pointer.
+    if (upb_Atomic_CompareExchangeWeak(
+            &r2.root->parent_or_count, &r2.tagged_count,
+            _upb_Arena_TaggedFromPointer(r1.root), memory_order_release,
+            memory_order_acquire)) {
+      break;
+    }
+    if (_upb_Arena_IsTaggedPointer(r2.tagged_count)) {
+      // We'll need to remove the excess refs we added to r1 previously.
+      *ref_delta += added;
+      return NULL;
+    }
+    r2_untagged_count = r2.tagged_count & ~1;
   }
+  *ref_delta += added - r2_untagged_count;
 
   // Now that the fuse has been performed (and can no longer fail) we need to
   // append `r2` to `r1`'s linked list.
@@ -6108,12 +6378,16 @@ static bool _upb_Arena_FixupRefs(upb_Arena* new_root, uintptr_t ref_delta) {
   if (ref_delta == 0) return true;  // No fixup required.
   uintptr_t poc =
       upb_Atomic_Load(&new_root->parent_or_count, memory_order_relaxed);
-  if (_upb_Arena_IsTaggedPointer(poc)) return false;
-  uintptr_t with_refs = poc - ref_delta;
-  UPB_ASSERT(!_upb_Arena_IsTaggedPointer(with_refs));
-  return upb_Atomic_CompareExchangeStrong(&new_root->parent_or_count, &poc,
-                                          with_refs, memory_order_relaxed,
-                                          memory_order_relaxed);
+  // Racing refcount changes on the root only require another try; we have to
+  // find the new root only if `new_root` itself was fused away.
+  do {
+    if (_upb_Arena_IsTaggedPointer(poc)) return false;
+    UPB_ASSERT(!_upb_Arena_IsTaggedPointer(poc - ref_delta));
+  } while (!upb_Atomic_CompareExchangeWeak(&new_root->parent_or_count, &poc,
+                                           poc - ref_delta,
+                                           memory_order_relaxed,
+                                           memory_order_relaxed));
+  return true;
 }
 
 bool upb_Arena_Fuse(upb_Arena* a1, upb_Arena* a2) {
@@ -8469,7 +8743,7 @@ static const upb_FileDef* upb_DefBuilder_AddFileToPool(
   return builder->file;
 }
 
-static const upb_FileDef* _upb_DefPool_AddFile(
+const upb_FileDef* _upb_DefPool_AddFile(
     upb_DefPool* s, const UPB_DESC(FileDescriptorProto) * file_proto,
     const upb_MiniTableFile* layout, upb_Status* status) {
   const upb_StringView name = UPB_DESC(FileDescriptorProto_name)(file_proto);
@@ -10488,57 +10762,73 @@ void upb_Message_ClearByDef(upb_Message* msg, const upb_MessageDef* m) {
   upb_Message_Clear(msg, upb_MessageDef_MiniTable(m));
 }
 
-bool upb_Message_Next(const upb_Message* msg, const upb_MessageDef* m,
-                      const upb_DefPool* ext_pool, const upb_FieldDef** out_f,
-                      upb_MessageValue* out_val, size_t* iter) {
+// Returns true if a non-extension field is set, deciding from the hasbit, the
+// oneof case or the field's own storage.  An unset field therefore costs a
+// single load and its default value is never materialized.
+static bool _upb_Message_NonExtensionFieldIsSet(
+    const upb_Message* msg, const upb_MiniTableField* field) {
+  if (field->presence > 0) return _upb_hasbit_field(msg, field);
+  if (field->presence < 0) {
+    return _upb_getoneofcase_field(msg, field) == field->number;
+  }
+  const void* ptr = _upb_MiniTableField_GetConstPtr(msg, field);
+  switch (upb_FieldMode_Get(field)) {
+    case kUpb_FieldMode_Map: {
+      const upb_Map* map = *(const upb_Map* const*)ptr;
+      return map && upb_Map_Size(map) != 0;
+    }
+    case kUpb_FieldMode_Array: {
+      const upb_Array* arr = *(const upb_Array* const*)ptr;
+      return arr && upb_Array_Size(arr) != 0;
+    }
+    case kUpb_FieldMode_Scalar:
+      return _upb_MiniTable_ValueIsNonZero(ptr, field);
+  }
+  UPB_UNREACHABLE();
+}
+
+size_t upb_Message_NextBatch(const upb_Message* msg, const upb_MessageDef* m,
+                             const upb_DefPool* ext_pool,
+                             const upb_FieldDef** out_f,
+                             upb_MessageValue* out_val, size_t max,
+                             size_t* iter) {
   size_t i = *iter;
   size_t n = upb_MessageDef_FieldCount(m);
-  UPB_UNUSED(ext_pool);
+  size_t found = 0;
 
-  // Iterate over normal fields, returning the first one that is set.
-  while (++i < n) {
+  // Iterate over normal fields, returning the ones that are set.
+  while (found < max && ++i < n) {
     const upb_FieldDef* f = upb_MessageDef_Field(m, i);
     const upb_MiniTableField* field = upb_FieldDef_MiniTable(f);
-    upb_MessageValue val = upb_Message_GetFieldByDef(msg, f);
-
-    // Skip field if unset or empty.
-    if (upb_MiniTableField_HasPresence(field)) {
-      if (!upb_Message_HasFieldByDef(msg, f)) continue;
-    } else {
-      switch (upb_FieldMode_Get(field)) {
-        case kUpb_FieldMode_Map:
-          if (!val.map_val || upb_Map_Size(val.map_val) == 0) continue;
-          break;
-        case kUpb_FieldMode_Array:
-          if (!val.array_val || upb_Array_Size(val.array_val) == 0) continue;
-          break;
-        case kUpb_FieldMode_Scalar:
-          if (!_upb_MiniTable_ValueIsNonZero(&val, field)) continue;
-          break;
-      }
-    }
+    if (!_upb_Message_NonExtensionFieldIsSet(msg, field)) continue;
 
-    *out_val = val;
-    *out_f = f;
-    *iter = i;
-    return true;
+    // The field is set, so its storage holds the value.
+    memset(&out_val[found], 0, sizeof(out_val[found]));
+    _upb_MiniTable_CopyFieldData(
+        &out_val[found], _upb_MiniTableField_GetConstPtr(msg, field), field);
+    out_f[found++] = f;
   }
 
-  if (ext_pool) {
+  if (ext_pool && i >= n) {
     // Return any extensions that are set.
     size_t count;
     const upb_Message_Extension* ext = _upb_Message_Getexts(msg, &count);
-    if (i - n < count) {
-      ext += count - 1 - (i - n);
-      memcpy(out_val, &ext->data, sizeof(*out_val));
-      *out_f = upb_DefPool_FindExtensionByMiniTable(ext_pool, ext->ext);
-      *iter = i;
-      return true;
+    while (found < max && i - n < count) {
+      const upb_Message_Extension* e = ext + count - 1 - (i - n);
+      memcpy(&out_val[found], &e->data, sizeof(out_val[found]));
+      out_f[found++] = upb_DefPool_FindExtensionByMiniTable(ext_pool, e->ext);
+      if (found < max) i++;
     }
   }
 
   *iter = i;
-  return false;
+  return found;
+}
+
+bool upb_Message_Next(const upb_Message* msg, const upb_MessageDef* m,
+                      const upb_DefPool* ext_pool, const upb_FieldDef** out_f,
+                      upb_MessageValue* out_val, size_t* iter) {
+  return upb_Message_NextBatch(msg, m, ext_pool, out_f, out_val, 1, iter) == 1;
 }
 
 bool _upb_Message_DiscardUnknown(upb_Message* msg, const upb_MessageDef* m,
@@ -11742,6 +12032,11 @@ enum {
   kUpb_DecodeOp_PackedEnum = 13,
 };
 
+// Upper bound on how many elements of a repeated field are counted ahead of
+// the decoder, and so on how many sub-messages are allocated together; see
+// _upb_Decoder_CountRepeated().
+#define kUpb_Decoder_MaxLookahead 32
+
 // For packed fields it is helpful to be able to recover the lg2 of the data
 // size from the op.
 #define OP_FIXPCK_LG2(n) (n + 5) /* n in [2, 3] => op in [7, 8] */
@@ -12109,6 +12404,8 @@ static const char* _upb_Decoder_DecodeVarintPacked(
     const upb_MiniTableField* field, int lg2) {
   int scale = 1 << lg2;
   int saved_limit = upb_EpsCopyInputStream_PushLimit(&d->input, ptr, val->size);
+  _upb_Decoder_Reserve(
+      d, arr, _upb_Decoder_CountVarints(ptr, d->input.limit_ptr));
   char* out = UPB_PTR_AT(_upb_array_ptr(arr), arr->size << lg2, void);
   while (!_upb_Decoder_IsDone(d, &ptr)) {
     wireval elem;
@@ -12132,6 +12429,9 @@ static const char* _upb_Decoder_DecodeEnumPacked(
     wireval* val) {
   const upb_MiniTableEnum* e = subs[field->UPB_PRIVATE(submsg_index)].subenum;
   int saved_limit = upb_EpsCopyInputStream_PushLimit(&d->input, ptr, val->size);
+  // Unknown values are dropped, so this may reserve a few too many.
+  _upb_Decoder_Reserve(
+      d, arr, _upb_Decoder_CountVarints(ptr, d->input.limit_ptr));
   char* out = UPB_PTR_AT(_upb_array_ptr(arr), arr->size * 4, void);
   while (!_upb_Decoder_IsDone(d, &ptr)) {
     wireval elem;
@@ -12152,7 +12452,8 @@ static const char* _upb_Decoder_DecodeEnumPacked(
 }
 
 upb_Array* _upb_Decoder_CreateArray(upb_Decoder* d,
-                                    const upb_MiniTableField* field) {
+                                    const upb_MiniTableField* field,
+                                    size_t capacity) {
   /* Maps descriptor type -> elem_size_lg2.  */
   static const uint8_t kElemSizeLg2[] = {
       [0] = -1,  // invalid descriptor type
@@ -12177,11 +12478,132 @@ upb_Array* _upb_Decoder_CreateArray(upb_Decoder* d,
   };
 
   size_t lg2 = kElemSizeLg2[field->UPB_PRIVATE(descriptortype)];
-  upb_Array* ret = _upb_Array_New(&d->arena, 4, lg2);
+  upb_Array* ret = _upb_Array_New(&d->arena, capacity, lg2);
   if (!ret) _upb_Decoder_ErrorJmp(d, kUpb_DecodeStatus_OutOfMemory);
   return ret;
 }
 
+// Returns the wire type of one unpacked element of |field|.
+static int _upb_Decoder_ElementWireType(const upb_MiniTableField* field) {
+  switch (field->UPB_PRIVATE(descriptortype)) {
+    case kUpb_FieldType_Float:
+    case kUpb_FieldType_Fixed32:
+    case kUpb_FieldType_SFixed32:
+      return kUpb_WireType_32Bit;
+    case kUpb_FieldType_Double:
+    case kUpb_FieldType_Fixed64:
+    case kUpb_FieldType_SFixed64:
+      return kUpb_WireType_64Bit;
+    case kUpb_FieldType_String:
+    case kUpb_FieldType_Bytes:
+    case kUpb_FieldType_Message:
+      return kUpb_WireType_Delimited;
+    default:
+      return kUpb_WireType_Varint;
+  }
+}
+
+// Counts the unpacked elements of |field| that directly follow |ptr|,
+// including the one that ends at |ptr|, without reading past the current
+// buffer or limit.  At most kUpb_Decoder_MaxLookahead are counted.
+static int _upb_Decoder_CountRepeated(upb_Decoder* d, const char* ptr,
+                                      const upb_MiniTableField* field) {
+  const char* limit = d->input.limit_ptr;
+  const int wire_type = _upb_Decoder_ElementWireType(field);
+  char tag[5];
+  uint32_t tag_val = ((uint32_t)field->number << 3) | wire_type;
+  size_t tag_size = upb_Decoder_EncodeVarint32(tag_val, tag) - tag;
+  int count = 1;
+
+  // Everything we read here is within the slop bytes past |limit|.
+  while (count < kUpb_Decoder_MaxLookahead && ptr < limit) {
+    if (memcmp(ptr, tag, tag_size) != 0) break;
+    ptr += tag_size;
+    switch (wire_type) {
+      case kUpb_WireType_Varint:
+        while (ptr < limit && (*ptr & 0x80)) ptr++;
+        ptr++;
+        break;
+      case kUpb_WireType_32Bit:
+        ptr += 4;
+        break;
+      case kUpb_WireType_64Bit:
+        ptr += 8;
+        break;
+      case kUpb_WireType_Delimited: {
+        uint64_t size = (uint8_t)*ptr;
+        if (UPB_LIKELY((size & 0x80) == 0)) {
+          ptr++;
+        } else {
+          _upb_DecodeLongVarintReturn res =
+              _upb_Decoder_DecodeLongVarint(ptr, size);
+          if (!res.ptr) return count;
+          ptr = res.ptr;
+          size = res.val;
+        }
+        if (ptr > limit || size > (uint64_t)(limit - ptr)) return count;
+        ptr += size;
+        break;
+      }
+    }
+    if (ptr > limit) break;
+    count++;
+  }
+
+  return count;
+}
+
+// Appends the next element of a repeated sub-message field and decodes it.
+// Long runs of the same field are common, so rather than allocating each
+// element separately we count the run that is already in the buffer and carve
+// its messages out of a single zeroed allocation.
+static const char* _upb_Decoder_DecodeRepeatedSubMessage(
+    upb_Decoder* d, const char* ptr, upb_Array* arr,
+    const upb_MiniTableSub* subs, const upb_MiniTableField* field, int size) {
+  const upb_MiniTable* subl = subs[field->UPB_PRIVATE(submsg_index)].submsg;
+  UPB_ASSERT(subl);
+  size_t msg_size = UPB_ALIGN_MALLOC(upb_msg_sizeof(subl));
+  upb_Message* submsg = NULL;
+  int count;
+
+  if (d->msg_slab != d->msg_slab_end && d->msg_slab_type == subl) {
+    submsg = UPB_PTR_AT(d->msg_slab, sizeof(upb_Message_Internal), upb_Message);
+    d->msg_slab += msg_size;
+  } else if (subl != &_kUpb_MiniTable_Empty &&
+             (count = _upb_Decoder_CountRepeated(d, ptr + size, field)) > 1) {
+    _upb_Decoder_Reserve(d, arr, count);
+    char* mem = upb_Arena_Malloc(&d->arena, msg_size * count);
+    if (!mem) _upb_Decoder_ErrorJmp(d, kUpb_DecodeStatus_OutOfMemory);
+    memset(mem, 0, msg_size * count);
+    d->msg_slab = mem + msg_size;
+    d->msg_slab_end = mem + msg_size * count;
+    d->msg_slab_type = subl;
+    submsg = UPB_PTR_AT(mem, sizeof(upb_Message_Internal), upb_Message);
+  }
+
+  upb_TaggedMessagePtr* target =
+      (upb_TaggedMessagePtr*)_upb_array_ptr(arr) + arr->size;
+  if (submsg) {
+    upb_TaggedMessagePtr tagged = _upb_TaggedMessagePtr_Pack(submsg, false);
+    memcpy(target, &tagged, sizeof(tagged));
+  } else {
+    submsg = _upb_Decoder_NewSubMessage(d, subs, field, target);
+  }
+  arr->size++;
+
+  // The sub-message may batch its own repeated fields, so give it an empty
+  // slab and restore ours (whose remaining entries follow this one) after.
+  char* slab = d->msg_slab;
+  char* slab_end = d->msg_slab_end;
+  const upb_MiniTable* slab_type = d->msg_slab_type;
+  d->msg_slab = d->msg_slab_end = NULL;
+  ptr = _upb_Decoder_DecodeSubMessage(d, ptr, submsg, subs, field, size);
+  d->msg_slab = slab;
+  d->msg_slab_end = slab_end;
+  d->msg_slab_type = slab_type;
+  return ptr;
+}
+
 static const char* _upb_Decoder_DecodeToArray(upb_Decoder* d, const char* ptr,
                                               upb_Message* msg,
                                               const upb_MiniTableSub* subs,
@@ -12194,7 +12616,26 @@ static const char* _upb_Decoder_DecodeToArray(upb_Decoder* d, const char* ptr,
   if (arr) {
     _upb_Decoder_Reserve(d, arr, 1);
   } else {
-    arr = _upb_Decoder_CreateArray(d, field);
+    // Size a new array for the run of elements already in the buffer.  Packed
+    // payloads reserve their own space once their length is known.
+    size_t capacity = 4;
+    switch (op) {
+      case kUpb_DecodeOp_Scalar1Byte:
+      case kUpb_DecodeOp_Scalar4Byte:
+      case kUpb_DecodeOp_Scalar8Byte:
+      case kUpb_DecodeOp_Enum:
+        capacity = UPB_MAX(capacity, _upb_Decoder_CountRepeated(d, ptr, field));
+        break;
+      case kUpb_DecodeOp_String:
+      case kUpb_DecodeOp_Bytes:
+        if (upb_EpsCopyInputStream_CheckDataSizeAvailable(&d->input, ptr,
+                                                          val->size)) {
+          capacity = UPB_MAX(capacity, _upb_Decoder_CountRepeated(
+                                           d, ptr + val->size, field));
+        }
+        break;
+    }
+    arr = _upb_Decoder_CreateArray(d, field, capacity);
     *arrp = arr;
   }
 
@@ -12217,18 +12658,17 @@ static const char* _upb_Decoder_DecodeToArray(upb_Decoder* d, const char* ptr,
       return _upb_Decoder_ReadString(d, ptr, val->size, str);
     }
     case kUpb_DecodeOp_SubMessage: {
-      /* Append submessage / group. */
+      if (UPB_LIKELY(field->UPB_PRIVATE(descriptortype) !=
+                     kUpb_FieldType_Group)) {
+        return _upb_Decoder_DecodeRepeatedSubMessage(d, ptr, arr, subs, field,
+                                                     val->size);
+      }
+      /* Append group. */
       upb_TaggedMessagePtr* target = UPB_PTR_AT(
           _upb_array_ptr(arr), arr->size * sizeof(void*), upb_TaggedMessagePtr);
       upb_Message* submsg = _upb_Decoder_NewSubMessage(d, subs, field, target);
       arr->size++;
-      if (UPB_UNLIKELY(field->UPB_PRIVATE(descriptortype) ==
-                       kUpb_FieldType_Group)) {
-        return _upb_Decoder_DecodeKnownGroup(d, ptr, submsg, subs, field);
-      } else {
-        return _upb_Decoder_DecodeSubMessage(d, ptr, submsg, subs, field,
-                                             val->size);
-      }
+      return _upb_Decoder_DecodeKnownGroup(d, ptr, submsg, subs, field);
     }
     case OP_FIXPCK_LG2(2):
     case OP_FIXPCK_LG2(3):
@@ -13030,6 +13470,9 @@ upb_DecodeStatus upb_Decode(const char* buf, size_t size, void* msg,
   decoder.options = (uint16_t)options;
   decoder.missing_required = false;
   decoder.status = kUpb_DecodeStatus_Ok;
+  decoder.msg_slab = NULL;
+  decoder.msg_slab_end = NULL;
+  decoder.msg_slab_type = NULL;
 
   // Violating the encapsulation of the arena for performance reasons.
   // This is a temporary arena that we swap into and swap out of when we are
@@ -13039,6 +13482,8 @@ upb_DecodeStatus upb_Decode(const char* buf, size_t size, void* msg,
   _upb_MemBlock* blocks = upb_Atomic_Load(&arena->blocks, memory_order_relaxed);
   decoder.arena.head = arena->head;
   decoder.arena.block_alloc = arena->block_alloc;
+  decoder.arena.max_block_size = arena->max_block_size;
+  decoder.arena.growth_factor = arena->growth_factor;
   upb_Atomic_Init(&decoder.arena.blocks, blocks);
 
   return upb_Decoder_Decode(&decoder, buf, msg, l, arena);
@@ -13197,21 +13642,29 @@ typedef struct {
   uint32_t tag;
 } fastdecode_nextret;
 
+// Grows the array so that at least |count| more elements fit after |dst|.
+UPB_NOINLINE
+static void* fastdecode_growarr(upb_Decoder* d, void* dst, fastdecode_arr* farr,
+                                int valbytes, size_t count) {
+  char* old_ptr = _upb_array_ptr(farr->arr);
+  size_t old_size = farr->arr->capacity;
+  size_t used = ((char*)dst - old_ptr) / valbytes;
+  size_t new_size = UPB_MAX(old_size * 2, used + count);
+  char* new_ptr = upb_Arena_Realloc(&d->arena, old_ptr, old_size * valbytes,
+                                    new_size * valbytes);
+  if (!new_ptr) _upb_FastDecoder_ErrorJmp(d, kUpb_DecodeStatus_OutOfMemory);
+  uint8_t elem_size_lg2 = __builtin_ctz(valbytes);
+  farr->arr->capacity = new_size;
+  farr->arr->data = _upb_array_tagptr(new_ptr, elem_size_lg2);
+  farr->end = (void*)(new_ptr + (new_size * valbytes));
+  return (void*)(new_ptr + (used * valbytes));
+}
+
 UPB_FORCEINLINE
 static void* fastdecode_resizearr(upb_Decoder* d, void* dst,
                                   fastdecode_arr* farr, int valbytes) {
   if (UPB_UNLIKELY(dst == farr->end)) {
-    size_t old_size = farr->arr->capacity;
-    size_t old_bytes = old_size * valbytes;
-    size_t new_size = old_size * 2;
-    size_t new_bytes = new_size * valbytes;
-    char* old_ptr = _upb_array_ptr(farr->arr);
-    char* new_ptr = upb_Arena_Realloc(&d->arena, old_ptr, old_bytes, new_bytes);
-    uint8_t elem_size_lg2 = __builtin_ctz(valbytes);
-    farr->arr->capacity = new_size;
-    farr->arr->data = _upb_array_tagptr(new_ptr, elem_size_lg2);
-    dst = (void*)(new_ptr + (old_size * valbytes));
-    farr->end = (void*)(new_ptr + (new_size * valbytes));
+    dst = fastdecode_growarr(d, dst, farr, valbytes, 1);
   }
   return dst;
 }
@@ -13421,6 +13874,13 @@ static const char* fastdecode_topackedvarint(upb_EpsCopyInputStream* e,
   void* dst = data->dst;
   uint64_t val;
 
+  // Make room for every varint that is already in the buffer at once.
+  size_t count = _upb_Decoder_CountVarints(ptr, e->limit_ptr);
+  size_t avail = ((char*)data->farr.end - (char*)dst) / data->valbytes;
+  if (count > avail) {
+    dst = fastdecode_growarr(d, dst, &data->farr, data->valbytes, count);
+  }
+
   while (!_upb_Decoder_IsDone(d, &ptr)) {
     dst = fastdecode_resizearr(d, dst, &data->farr, data->valbytes);
     ptr = fastdecode_varint64(ptr, &val);
@@ -13575,18 +14035,23 @@ TAGBYTES(p)
   uint8_t elem_size_lg2 = __builtin_ctz(valbytes);                          \
   int elems = size / valbytes;                                              \
                                                                             \
+  size_t old_elems = 0;                                                      \
   if (UPB_LIKELY(!arr)) {                                                   \
     *arr_p = arr = _upb_Array_New(&d->arena, elems, elem_size_lg2);         \
     if (!arr) {                                                             \
-      _upb_FastDecoder_ErrorJmp(d, kUpb_DecodeStatus_Malformed);            \
+      _upb_FastDecoder_ErrorJmp(d, kUpb_DecodeStatus_OutOfMemory);          \
     }                                                                       \
   } else {                                                                  \
-    _upb_Array_ResizeUninitialized(arr, elems, &d->arena);                  \
+    old_elems = arr->size;                                                  \
+    if (!_upb_Array_ResizeUninitialized(arr, old_elems + elems,             \
+                                        &d->arena)) {                       \
+      _upb_FastDecoder_ErrorJmp(d, kUpb_DecodeStatus_OutOfMemory);          \
+    }                                                                       \
   }                                                                         \
                                                                             \
-  char* dst = _upb_array_ptr(arr);                                          \
+  char* dst = (char*)_upb_array_ptr(arr) + old_elems * valbytes;            \
   memcpy(dst, ptr, size);                                                   \
-  arr->size = elems;                                                        \
+  arr->size = old_elems + elems;                                            \
                                                                             \
   ptr += size;                                                              \
   UPB_MUSTTAIL return fastdecode_dispatch(UPB_PARSE_ARGS);
@@ -66,6 +66,13 @@ ZEND_BEGIN_MODULE_GLOBALS(protobuf)
   // destroying it.
   upb_DefPool* global_symtab;
 
+  // The serialized descriptor sets that have been added to global_symtab. When
+  // the symtab is kept after a request, generated code loaded again by a later
+  // request finds its descriptor here and skips parsing it. Like the name caches
+  // below, this lives exactly as long as global_symtab, so it is allocated from
+  // persistent memory.
+  HashTable descriptor_sets;
+
   // Object cache (see interface in protobuf.h).
   HashTable object_cache;
 
@@ -84,6 +91,7 @@ ZEND_END_MODULE_GLOBALS(protobuf)
 void free_protobuf_globals(zend_protobuf_globals* globals) {
   zend_hash_destroy(&globals->name_msg_cache);
   zend_hash_destroy(&globals->name_enum_cache);
+  zend_hash_destroy(&globals->descriptor_sets);
   upb_DefPool_Free(globals->global_symtab);
   globals->global_symtab = NULL;
 }
@@ -169,8 +177,9 @@ static PHP_RINIT_FUNCTION(protobuf) {
   upb_DefPool* symtab = PROTOBUF_G(global_symtab);
   if (!symtab) {
     PROTOBUF_G(global_symtab) = symtab = upb_DefPool_New();
-    zend_hash_init(&PROTOBUF_G(name_msg_cache), 64, NULL, NULL, 0);
-    zend_hash_init(&PROTOBUF_G(name_enum_cache), 64, NULL, NULL, 0);
+    zend_hash_init(&PROTOBUF_G(name_msg_cache), 64, NULL, NULL, 1);
+    zend_hash_init(&PROTOBUF_G(name_enum_cache), 64, NULL, NULL, 1);
+    zend_hash_init(&PROTOBUF_G(descriptor_sets), 64, NULL, NULL, 1);
   }
 
   zend_hash_init(&PROTOBUF_G(object_cache), 64, NULL, NULL, 0);
@@ -236,6 +245,18 @@ bool ObjCache_Get(const void* upb_obj, zval* val) {
   }
 }
 
+// -----------------------------------------------------------------------------
+// Descriptor Set Cache.
+// -----------------------------------------------------------------------------
+
+bool DescriptorSets_Contains(const char* data, size_t size) {
+  return zend_hash_str_exists(&PROTOBUF_G(descriptor_sets), data, size);
+}
+
+void DescriptorSets_Add(const char* data, size_t size) {
+  zend_hash_str_add_empty_element(&PROTOBUF_G(descriptor_sets), data, size);
+}
+
 // -----------------------------------------------------------------------------
 // Name Cache.
 // -----------------------------------------------------------------------------
@@ -86,6 +86,13 @@ const upb_EnumDef* NameMap_GetEnum(zend_class_entry* ce);
 void NameMap_EnterConstructor(zend_class_entry* ce);
 void NameMap_ExitConstructor(zend_class_entry* ce);
 
+// Cache of the serialized descriptor sets already added to the global symtab,
+// keyed by their contents. This persists along with the symtab, so that when
+// protobuf.keep_descriptor_pool_after_request is set, a generated file that is
+// loaded again by a later request does not need to parse its descriptors.
+bool DescriptorSets_Contains(const char* data, size_t size);
+void DescriptorSets_Add(const char* data, size_t size);
+
 // Add this descriptor object to the global list of descriptors that will be
 // kept alive for the duration of the request but destroyed when the request
 // is ending.
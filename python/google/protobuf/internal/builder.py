@@ -37,6 +37,9 @@ in generated code.
 
 __author__ = 'jieluo@google.com (Jie Luo)'
 
+import os
+
+from google.protobuf.internal import api_implementation
 from google.protobuf.internal import enum_type_wrapper
 from google.protobuf.internal import python_message
 from google.protobuf import message as _message
@@ -45,6 +48,114 @@ from google.protobuf import symbol_database as _symbol_database
 
 _sym_db = _symbol_database.Default()
 
+# With the upb backend, the message classes of a _pb2 module and the module
+# level aliases of their descriptors are built the first time they are read
+# rather than at import, so importing a large module only pays for the
+# messages it uses. upb creates the class of any message it hands out through
+# _BuildLazyMessage() below, and returns the existing class when one is
+# created twice, so every path sees the same class. Setting
+# PROTOCOL_BUFFERS_PYTHON_LAZY_BUILD=0 builds everything at import instead.
+_LAZY_BUILD = (
+    api_implementation.Type() == 'upb'
+    and os.getenv('PROTOCOL_BUFFERS_PYTHON_LAZY_BUILD', '1') != '0'
+)
+
+# The _LazyModule of each lazily built _pb2 module, by .proto file name.
+_lazy_modules = {}
+
+
+class _LazyModule(object):
+  """Builds the contents of a _pb2 module when they are first read.
+
+  Installed as the module's __getattr__ (PEP 562), which Python only calls for
+  names that are not in the module dict yet.
+  """
+
+  def __init__(self, file_des, module):
+    self._file_des = file_des
+    self._module = module
+    self._module_name = None
+    self._descriptors_built = False
+
+  def SetModuleName(self, module_name):
+    self._module_name = module_name
+
+  def __call__(self, name):
+    if self._module_name is not None:
+      msg_des = self._file_des.message_types_by_name.get(name)
+      if msg_des is not None:
+        return self._BuildTopMessage(name, msg_des)
+    if name.startswith('_') and not name.startswith('__'):
+      self._BuildDescriptors()
+      if name in self._module:
+        return self._module[name]
+    elif name == '__all__':
+      # "from module import *" falls back to the module dict when __all__ is
+      # missing, so make sure the dict holds everything first.
+      self._BuildDescriptors()
+      for msg_name, msg_des in self._file_des.message_types_by_name.items():
+        self._BuildTopMessage(msg_name, msg_des)
+    raise AttributeError(
+        'module %r has no attribute %r' % (self._module['__name__'], name))
+
+  def Dir(self):
+    names = set(self._module)
+    names.update(self._file_des.message_types_by_name.keys())
+    return sorted(names)
+
+  def BuildMessage(self, msg_des):
+    """Builds the class of a message of this file and its nested messages."""
+    while msg_des.containing_type is not None:
+      msg_des = msg_des.containing_type
+    self._BuildTopMessage(msg_des.name, msg_des)
+
+  def _BuildTopMessage(self, name, msg_des):
+    message_class = self._module.get(name)
+    if message_class is None:
+      message_class = _BuildMessage(msg_des, self._module_name)
+      self._module[name] = message_class
+    return message_class
+
+  def _BuildDescriptors(self):
+    if not self._descriptors_built:
+      self._descriptors_built = True
+      _BuildMessageAndEnumDescriptors(self._file_des, self._module)
+
+
+def _GetLazyModule(file_des, module):
+  lazy_module = module.get('__getattr__')
+  if not isinstance(lazy_module, _LazyModule):
+    lazy_module = _LazyModule(file_des, module)
+    module['__getattr__'] = lazy_module
+    module['__dir__'] = lazy_module.Dir
+    _lazy_modules[file_des.name] = lazy_module
+  return lazy_module
+
+
+def _BuildLazyMessage(msg_des):
+  """Builds the class of msg_des if its _pb2 module has not built it yet.
+
+  Called by the upb backend when it needs the class of a message.
+
+  Args:
+    msg_des: Descriptor of the message.
+  """
+  lazy_module = _lazy_modules.get(msg_des.file.name)
+  if lazy_module is not None:
+    lazy_module.BuildMessage(msg_des)
+
+
+def _BuildMessage(msg_des, module_name):
+  create_dict = {}
+  for (name, nested_msg) in msg_des.nested_types_by_name.items():
+    create_dict[name] = _BuildMessage(nested_msg, module_name)
+  create_dict['DESCRIPTOR'] = msg_des
+  create_dict['__module__'] = module_name
+  message_class = _reflection.GeneratedProtocolMessageType(
+      msg_des.name, (_message.Message,), create_dict)
+  _sym_db.RegisterMessage(message_class)
+  return message_class
+
 
 def BuildMessageAndEnumDescriptors(file_des, module):
   """Builds message and enum descriptors.
@@ -53,6 +164,13 @@ def BuildMessageAndEnumDescriptors(file_des, module):
     file_des: FileDescriptor of the .proto file
     module: Generated _pb2 module
   """
+  if _LAZY_BUILD:
+    _GetLazyModule(file_des, module)
+  else:
+    _BuildMessageAndEnumDescriptors(file_des, module)
+
+
+def _BuildMessageAndEnumDescriptors(file_des, module):
 
   def BuildNestedDescriptors(msg_des, prefix):
     for (name, nested_msg) in msg_des.nested_types_by_name.items():
@@ -77,17 +195,6 @@ def BuildTopDescriptorsAndMessages(file_des, module_name, module):
     module: Generated _pb2 module
   """
 
-  def BuildMessage(msg_des):
-    create_dict = {}
-    for (name, nested_msg) in msg_des.nested_types_by_name.items():
-      create_dict[name] = BuildMessage(nested_msg)
-    create_dict['DESCRIPTOR'] = msg_des
-    create_dict['__module__'] = module_name
-    message_class = _reflection.GeneratedProtocolMessageType(
-        msg_des.name, (_message.Message,), create_dict)
-    _sym_db.RegisterMessage(message_class)
-    return message_class
-
   # top level enums
   for (name, enum_des) in file_des.enum_types_by_name.items():
     module['_' + name.upper()] = enum_des
@@ -105,8 +212,11 @@ def BuildTopDescriptorsAndMessages(file_des, module_name, module):
     module['_' + name.upper()] = service
 
   # Build messages.
+  if _LAZY_BUILD:
+    _GetLazyModule(file_des, module).SetModuleName(module_name)
+    return
   for (name, msg_des) in file_des.message_types_by_name.items():
-    module[name] = BuildMessage(msg_des)
+    module[name] = _BuildMessage(msg_des, module_name)
 
 
 def AddHelpersToExtensions(file_des):
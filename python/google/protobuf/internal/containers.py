@@ -45,6 +45,7 @@ import copy
 import pickle
 from typing import (
     Any,
+    Dict,
     Iterable,
     Iterator,
     List,
@@ -322,6 +323,28 @@ class RepeatedCompositeFieldContainer(BaseContainer[_T], MutableSequence[_T]):
     """
     self.extend(other)
 
+  def extract_columns(self, field_names: Iterable[str]) -> Dict[str, List[Any]]:
+    """Returns the values of the given fields across all elements.
+
+    The result maps each field name to a list holding that field's value in
+    every element, in order. Unset fields contribute their default value. Only
+    singular, non-message fields may be extracted. Implementations may build
+    the columns without creating a Python object for each element.
+    """
+    fields_by_name = self._message_descriptor.fields_by_name
+    columns = {}
+    for name in field_names:
+      field = fields_by_name.get(name)
+      if field is None:
+        raise ValueError('Protocol message %s has no "%s" field.' %
+                         (self._message_descriptor.name, name))
+      if (field.label == field.LABEL_REPEATED or
+          field.cpp_type == field.CPPTYPE_MESSAGE):
+        raise TypeError('Cannot extract a column for field "%s"; only '
+                        'singular, non-message fields are supported.' % name)
+      columns[name] = [getattr(value, name) for value in self._values]
+    return columns
+
   def remove(self, elem: _T) -> None:
     """Removes an item from the list. Similar to list.remove()."""
     self._values.remove(elem)
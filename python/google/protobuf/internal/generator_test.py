@@ -348,6 +348,25 @@ class GeneratorTest(unittest.TestCase):
     self.assertTrue(unittest_import_public_pb2.PublicImportMessage is
                     unittest_import_pb2.PublicImportMessage)
 
+  def testModuleAttributes(self):
+    # Message classes may be built when they are first used, which must not be
+    # visible through the module.
+    self.assertIn('TestAllTypes', dir(unittest_pb2))
+    self.assertEqual(unittest_pb2.__name__,
+                     unittest_pb2.TestRequired.__module__)
+    self.assertIs(unittest_pb2.TestAllTypes.DESCRIPTOR,
+                  unittest_pb2._TESTALLTYPES)
+    self.assertIs(type(unittest_pb2.TestRequiredForeign().optional_message),
+                  unittest_pb2.TestRequired)
+    self.assertIs(
+        symbol_database.Default().GetSymbol(
+            'protobuf_unittest.TestEmptyMessage'),
+        unittest_pb2.TestEmptyMessage)
+    namespace = {}
+    exec('from google.protobuf.unittest_pb2 import *', namespace)
+    self.assertIs(namespace['TestPackedTypes'], unittest_pb2.TestPackedTypes)
+    self.assertFalse(hasattr(unittest_pb2, 'NoSuchMessage'))
+
   def testBadIdentifiers(self):
     # We're just testing that the code was imported without problems.
     message = test_bad_identifiers_pb2.TestBadIdentifiers()
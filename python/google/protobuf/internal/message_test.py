@@ -45,6 +45,7 @@ import operator
 import pickle
 import pydoc
 import sys
+import threading
 import unittest
 import warnings
 
@@ -1219,6 +1220,26 @@ class MessageTest(unittest.TestCase):
     self.assertEqual(2, m.repeated_nested_message.pop(1).bb)
     self.assertEqual([1, 3], [n.bb for n in m.repeated_nested_message])
 
+  @unittest.skipIf(api_implementation.Type() == 'cpp',
+                   'extract_columns is not implemented in the C++ backend')
+  def testRepeatedCompositeFieldExtractColumns(self, message_module):
+    m = message_module.TestAllTypes()
+    self.assertEqual({'bb': []},
+                     m.repeated_nested_message.extract_columns(['bb']))
+    for i in range(3):
+      m.repeated_nested_message.add(bb=i)
+    m.repeated_nested_message.add()
+    self.assertEqual({'bb': [0, 1, 2, 0]},
+                     m.repeated_nested_message.extract_columns(('bb',)))
+    with self.assertRaises(ValueError):
+      m.repeated_nested_message.extract_columns(['no_such_field'])
+    m = message_module.NestedTestAllTypes()
+    m.repeated_child.add()
+    with self.assertRaises(TypeError):
+      m.repeated_child.extract_columns(['payload'])
+    with self.assertRaises(TypeError):
+      m.repeated_child.extract_columns(['repeated_child'])
+
   def testRepeatedCompareWithSelf(self, message_module):
     m = message_module.TestAllTypes()
     for i in range(5):
@@ -2646,5 +2667,72 @@ class OversizeProtosTest(unittest.TestCase):
     msg.ParseFromString(self.GenerateNestedProto(101))
 
 
+@testing_refleaks.TestCase
+class ThreadedParseSerializeTest(unittest.TestCase):
+  """Large messages may be parsed and serialized without holding the GIL."""
+
+  def LargeMessage(self):
+    msg = unittest_pb2.TestAllTypes()
+    msg.repeated_int64.extend(range(20000))
+    msg.repeated_bytes.extend([b'x' * 1000] * 100)
+    msg.optional_nested_message.bb = 7
+    return msg
+
+  def RunThreads(self, target, n=4):
+    threads = [threading.Thread(target=target) for _ in range(n)]
+    for t in threads:
+      t.start()
+    for t in threads:
+      t.join()
+
+  def testConcurrentParse(self):
+    golden = self.LargeMessage()
+    data = golden.SerializeToString()
+    results = []
+
+    def Parse():
+      for _ in range(5):
+        results.append(unittest_pb2.TestAllTypes.FromString(data))
+
+    self.RunThreads(Parse)
+    self.assertEqual(20, len(results))
+    for msg in results:
+      self.assertEqual(golden, msg)
+
+  def testParseMergesIntoNonEmpty(self):
+    data = self.LargeMessage().SerializeToString()
+    msg = unittest_pb2.TestAllTypes(repeated_int64=[-1])
+    msg.MergeFromString(data)
+    self.assertEqual(20001, len(msg.repeated_int64))
+    self.assertEqual(-1, msg.repeated_int64[0])
+
+  def testSerializeWhileMutating(self):
+    msg = self.LargeMessage()
+    outputs = []
+
+    def Serialize():
+      for _ in range(5):
+        outputs.append(msg.SerializeToString())
+
+    def Mutate():
+      for i in range(200):
+        msg.optional_int32 = i
+        msg.repeated_int64.append(i)
+
+    threads = [threading.Thread(target=Serialize) for _ in range(3)]
+    threads.append(threading.Thread(target=Mutate))
+    for t in threads:
+      t.start()
+    for t in threads:
+      t.join()
+
+    # Every output must be a consistent snapshot of the message.
+    self.assertEqual(15, len(outputs))
+    for data in outputs:
+      parsed = unittest_pb2.TestAllTypes.FromString(data)
+      appended = len(parsed.repeated_int64) - 20000
+      self.assertIn(appended - parsed.optional_int32, (0, 1))
+
+
 if __name__ == '__main__':
   unittest.main()
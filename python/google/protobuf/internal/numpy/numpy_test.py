@@ -34,6 +34,7 @@ import unittest
 
 import numpy as np
 
+from google.protobuf.internal import api_implementation
 from google.protobuf.internal import testing_refleaks
 from google.protobuf import unittest_pb2
 
@@ -211,5 +212,72 @@ class NumpyProtoIndexingTest(unittest.TestCase):
                                          buffer=np.array([0]),
                                          dtype=int)]
 
+
+@unittest.skipIf(api_implementation.Type() != 'upb',
+                 'Only the upb backend exports repeated field storage.')
+@testing_refleaks.TestCase
+class NumpyRepeatedViewTest(unittest.TestCase):
+
+  def testAsArrayAliasesStorage(self):
+    data = unittest_pb2.TestAllTypes(repeated_int32=[1, 2, 3])
+    view = np.asarray(data.repeated_int32)
+    self.assertEqual(np.int32, view.dtype)
+    self.assertEqual([1, 2, 3], view.tolist())
+    view[1] = 20
+    self.assertEqual(20, data.repeated_int32[1])
+
+  def testAsArrayDtypes(self):
+    data = unittest_pb2.TestAllTypes(
+        repeated_uint64=[1], repeated_double=[1.5], repeated_bool=[True])
+    self.assertEqual(np.uint64, np.asarray(data.repeated_uint64).dtype)
+    self.assertEqual(np.float64, np.asarray(data.repeated_double).dtype)
+    bools = np.asarray(data.repeated_bool)
+    self.assertEqual(np.bool_, bools.dtype)
+    self.assertFalse(bools.flags.writeable)
+
+  def testAsArrayEmpty(self):
+    data = unittest_pb2.TestAllTypes()
+    self.assertEqual(0, np.asarray(data.repeated_float).size)
+
+  def testExtendFromArray(self):
+    data = unittest_pb2.TestAllTypes(repeated_int64=[1])
+    data.repeated_int64.extend(np.array([2, 3], dtype=np.int64))
+    self.assertEqual([1, 2, 3], data.repeated_int64)
+    # Mismatched dtypes still go through the element-by-element path.
+    data.repeated_int64.extend(np.array([4], dtype=np.int32))
+    self.assertEqual([1, 2, 3, 4], data.repeated_int64)
+
+  def testResizeWhileExportedRaises(self):
+    data = unittest_pb2.TestAllTypes(repeated_int32=[1, 2, 3])
+    view = memoryview(data.repeated_int32)
+    self.assertRaises(BufferError, data.repeated_int32.append, 4)
+    self.assertRaises(BufferError, data.repeated_int32.extend, [4])
+    self.assertRaises(BufferError, data.repeated_int32.pop)
+    with self.assertRaises(BufferError):
+      del data.repeated_int32[0]
+    with self.assertRaises(BufferError):
+      data.repeated_int32[1:] = [5]
+    # Writes that keep the size go straight to the exported storage.
+    data.repeated_int32[0] = 10
+    data.repeated_int32.sort(reverse=True)
+    self.assertEqual([10, 3, 2], view.tolist())
+    view.release()
+    data.repeated_int32.append(4)
+    self.assertEqual([10, 3, 2, 4], data.repeated_int32)
+
+  def testMessageChangesWhileExportedRaise(self):
+    data = unittest_pb2.TestAllTypes(repeated_int32=[1])
+    serialized = data.SerializeToString()
+    view = np.asarray(data.repeated_int32)
+    self.assertRaises(BufferError, data.Clear)
+    self.assertRaises(BufferError, data.ClearField, 'repeated_int32')
+    self.assertRaises(BufferError, data.MergeFromString, serialized)
+    self.assertRaises(BufferError, data.MergeFrom, data)
+    self.assertRaises(BufferError, data.CopyFrom, unittest_pb2.TestAllTypes())
+    self.assertEqual([1], data.repeated_int32)
+    del view
+    data.MergeFromString(serialized)
+    self.assertEqual([1, 1], data.repeated_int32)
+
 if __name__ == '__main__':
   unittest.main()
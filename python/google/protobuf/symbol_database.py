@@ -171,7 +171,13 @@ class SymbolDatabase():
       KeyError: if the symbol could not be found.
     """
 
-    return self._classes[self.pool.FindMessageTypeByName(symbol)]
+    desc = self.pool.FindMessageTypeByName(symbol)
+    if desc not in self._classes:
+      # Generated modules may build their message classes on first use.
+      # pylint: disable=g-import-not-at-top,protected-access
+      from google.protobuf.internal import builder
+      builder._BuildLazyMessage(desc)
+    return self._classes[desc]
 
   def GetMessages(self, files):
     # TODO(amauryfa): Fix the differences with MessageFactory.
@@ -102,6 +102,7 @@ VALUE Map_GetRubyWrapper(upb_Map* map, upb_CType key_type, TypeInfo value_type,
       const upb_MessageDef* val_m = self->value_type_info.def.msgdef;
       self->value_type_class = Descriptor_DefToClass(val_m);
     }
+    if (Arena_IsReadOnly(arena)) RB_OBJ_FREEZE(val);
     return ObjectCache_TryAdd(map, val);
   }
 
@@ -136,6 +136,7 @@ VALUE Message_GetRubyWrapper(upb_Message* msg, const upb_MessageDef* m,
     VALUE klass = Descriptor_DefToClass(m);
     val = Message_alloc(klass);
     Message_InitPtr(val, msg, arena);
+    if (Arena_IsReadOnly(arena)) RB_OBJ_FREEZE(val);
   }
 
   return val;
@@ -929,18 +930,9 @@ static VALUE Message_index_set(VALUE _self, VALUE field_name, VALUE value) {
   return Qnil;
 }
 
-/*
- * call-seq:
- *     MessageClass.decode(data, options) => message
- *
- * Decodes the given data (as a string containing bytes in protocol buffers wire
- * format) under the interpretration given by this message class's definition
- * and returns a message object with the corresponding field values.
- * @param options [Hash] options for the decoder
- *  recursion_limit: set to maximum decoding depth for message (default is 64)
- */
-static VALUE Message_decode(int argc, VALUE* argv, VALUE klass) {
-  VALUE data = argv[0];
+// Returns the upb decode options described by the optional options hash in
+// argv[1], checking that decode was given one or two arguments.
+static int Message_GetDecodeOptions(int argc, VALUE* argv) {
   int options = 0;
 
   if (argc < 1 || argc > 2) {
@@ -961,12 +953,63 @@ static VALUE Message_decode(int argc, VALUE* argv, VALUE klass) {
     }
   }
 
-  if (TYPE(data) != T_STRING) {
+  if (TYPE(argv[0]) != T_STRING) {
     rb_raise(rb_eArgError, "Expected string for binary protobuf data.");
   }
 
+  return options;
+}
+
+/*
+ * call-seq:
+ *     MessageClass.decode(data, options) => message
+ *
+ * Decodes the given data (as a string containing bytes in protocol buffers wire
+ * format) under the interpretration given by this message class's definition
+ * and returns a message object with the corresponding field values.
+ * @param options [Hash] options for the decoder
+ *  recursion_limit: set to maximum decoding depth for message (default is 64)
+ */
+static VALUE Message_decode(int argc, VALUE* argv, VALUE klass) {
+  int options = Message_GetDecodeOptions(argc, argv);
+  VALUE data = argv[0];
+
+  VALUE msg_rb = initialize_rb_class_with_no_args(klass);
+  Message* msg = ruby_to_Message(msg_rb);
+
+  upb_DecodeStatus status =
+      upb_Decode(RSTRING_PTR(data), RSTRING_LEN(data), (upb_Message*)msg->msg,
+                 upb_MessageDef_MiniTable(msg->msgdef), NULL, options,
+                 Arena_get(msg->arena));
+
+  if (status != kUpb_DecodeStatus_Ok) {
+    rb_raise(cParseError, "Error occurred during parsing");
+  }
+
+  return msg_rb;
+}
+
+/*
+ * call-seq:
+ *     MessageClass.decode_frozen(data, options) => message
+ *
+ * Like decode, but returns a deeply frozen message. String and bytes fields
+ * alias the (frozen) input data instead of copying it, so this is cheaper than
+ * decode followed by freezing for read-only payloads that are kept in memory.
+ * The data is kept alive for as long as the message is.
+ * @param options [Hash] options for the decoder
+ *  recursion_limit: set to maximum decoding depth for message (default is 64)
+ */
+static VALUE Message_decode_frozen(int argc, VALUE* argv, VALUE klass) {
+  int options =
+      Message_GetDecodeOptions(argc, argv) | kUpb_DecodeOption_AliasString;
+  // Strings that are already frozen are used as-is; others are shared
+  // copy-on-write, so later writes to argv[0] cannot reach the message.
+  VALUE data = rb_str_new_frozen(argv[0]);
+
   VALUE msg_rb = initialize_rb_class_with_no_args(klass);
   Message* msg = ruby_to_Message(msg_rb);
+  Arena_Pin(msg->arena, data);
 
   upb_DecodeStatus status =
       upb_Decode(RSTRING_PTR(data), RSTRING_LEN(data), (upb_Message*)msg->msg,
@@ -977,6 +1020,8 @@ static VALUE Message_decode(int argc, VALUE* argv, VALUE klass) {
     rb_raise(cParseError, "Error occurred during parsing");
   }
 
+  Arena_SetReadOnly(msg->arena);
+  RB_OBJ_FREEZE(msg_rb);
   return msg_rb;
 }
 
@@ -1391,6 +1436,7 @@ static void Message_define_class(VALUE klass) {
   rb_define_method(klass, "[]", Message_index, 1);
   rb_define_method(klass, "[]=", Message_index_set, 2);
   rb_define_singleton_method(klass, "decode", Message_decode, -1);
+  rb_define_singleton_method(klass, "decode_frozen", Message_decode_frozen, -1);
   rb_define_singleton_method(klass, "encode", Message_encode, -1);
   rb_define_singleton_method(klass, "decode_json", Message_decode_json, -1);
   rb_define_singleton_method(klass, "encode_json", Message_encode_json, -1);
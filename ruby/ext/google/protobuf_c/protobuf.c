@@ -174,11 +174,20 @@ typedef struct {
   // IMPORTANT: WB_PROTECTED objects must only use the RB_OBJ_WRITE()
   // macro to update VALUE references, as to trigger write barriers.
   VALUE pinned_objs;
+  bool read_only;
 } Arena;
 
 static void Arena_mark(void *data) {
   Arena *arena = data;
   rb_gc_mark(arena->pinned_objs);
+  if (arena->pinned_objs != Qnil) {
+    // Pinned strings may back string fields decoded with aliasing, so they
+    // must not be moved by GC compaction either.
+    long n = RARRAY_LEN(arena->pinned_objs);
+    for (long i = 0; i < n; i++) {
+      rb_gc_mark(RARRAY_AREF(arena->pinned_objs, i));
+    }
+  }
 }
 
 static void Arena_free(void *data) {
@@ -211,6 +220,7 @@ static VALUE Arena_alloc(VALUE klass) {
   Arena *arena = ALLOC(Arena);
   arena->arena = upb_Arena_Init(NULL, 0, &ruby_upb_alloc);
   arena->pinned_objs = Qnil;
+  arena->read_only = false;
   return TypedData_Wrap_Struct(klass, &Arena_type, arena);
 }
 
@@ -241,6 +251,18 @@ void Arena_Pin(VALUE _arena, VALUE obj) {
   rb_ary_push(arena->pinned_objs, obj);
 }
 
+void Arena_SetReadOnly(VALUE _arena) {
+  Arena *arena;
+  TypedData_Get_Struct(_arena, Arena, &Arena_type, arena);
+  arena->read_only = true;
+}
+
+bool Arena_IsReadOnly(VALUE _arena) {
+  Arena *arena;
+  TypedData_Get_Struct(_arena, Arena, &Arena_type, arena);
+  return arena->read_only;
+}
+
 void Arena_register(VALUE module) {
   VALUE internal = rb_define_module_under(module, "Internal");
   VALUE klass = rb_define_class_under(internal, "Arena", rb_cObject);
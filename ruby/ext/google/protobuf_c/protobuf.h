@@ -80,6 +80,12 @@ void Arena_fuse(VALUE arena, upb_Arena* other);
 // remembered, even if the user drops their reference to this precise object.
 void Arena_Pin(VALUE arena, VALUE obj);
 
+// Marks this arena as read-only. Every message, repeated field and map wrapper
+// subsequently created over this arena's memory is frozen on creation, so a
+// frozen message stays deeply frozen without wrapping its children eagerly.
+void Arena_SetReadOnly(VALUE arena);
+bool Arena_IsReadOnly(VALUE arena);
+
 // -----------------------------------------------------------------------------
 // ObjectCache
 // -----------------------------------------------------------------------------
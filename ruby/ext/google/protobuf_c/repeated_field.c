@@ -94,6 +94,7 @@ VALUE RepeatedField_GetRubyWrapper(upb_Array* array, TypeInfo type_info,
     if (self->type_info.type == kUpb_CType_Message) {
       self->type_class = Descriptor_DefToClass(type_info.def.msgdef);
     }
+    if (Arena_IsReadOnly(arena)) RB_OBJ_FREEZE(val);
     val = ObjectCache_TryAdd(array, val);
   }
 
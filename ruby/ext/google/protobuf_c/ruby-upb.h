@@ -211,8 +211,13 @@ Error, UINTPTR_MAX is undefined
  *   2. add some fallback code for when musttail isn't available (ie. return
  *      instead of tail calling). This is safe and portable, but this comes at
  *      a CPU cost.
+ *
+ * On Windows this covers clang-cl, which supports musttail.  MSVC proper has
+ * no way to guarantee tail calls, so it keeps using the generic decoder.
  */
-#if (defined(__x86_64__) || defined(__aarch64__)) && defined(__GNUC__)
+#if (defined(__x86_64__) || defined(__aarch64__) || defined(_M_X64) || \
+     defined(_M_ARM64)) &&                                               \
+    (defined(__GNUC__) || defined(__clang__))
 #define UPB_FASTTABLE_SUPPORTED 1
 #else
 #define UPB_FASTTABLE_SUPPORTED 0
@@ -1132,6 +1137,28 @@ typedef struct {
   char *ptr, *end;
 } _upb_ArenaHead;
 
+// Controls how an arena sizes the blocks it allocates. Zero fields select the
+// built-in defaults.
+typedef struct {
+  // Usable size of the first block allocated by an arena that was not given an
+  // initial block. Default: 256.
+  size_t initial_block_size;
+
+  // Blocks stop growing once they reach this size. An allocation that is larger
+  // still gets a block of its own. Default: unlimited.
+  size_t max_block_size;
+
+  // Each block is this many times larger than the previous one. Default: 2.
+  uint32_t growth_factor;
+} upb_ArenaOptions;
+
+// Statistics for an arena and every arena fused with it.
+typedef struct {
+  size_t space_allocated;  // Same as upb_Arena_SpaceAllocated().
+  size_t block_count;
+  size_t largest_block;
+} upb_ArenaStats;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -1141,11 +1168,33 @@ extern "C" {
 // is a fixed-size arena and cannot grow.
 UPB_API upb_Arena* upb_Arena_Init(void* mem, size_t n, upb_alloc* alloc);
 
+// Like upb_Arena_Init(), but blocks are sized according to |options| instead
+// of the process-wide defaults. |options| may be NULL.
+UPB_API upb_Arena* upb_Arena_InitWithOptions(void* mem, size_t n,
+                                             upb_alloc* alloc,
+                                             const upb_ArenaOptions* options);
+
+// Replaces the process-wide defaults used by upb_Arena_Init() and
+// upb_Arena_New(). Zero fields restore the built-in default for that field.
+// This is not synchronized with arena creation, so it should be called during
+// startup before other threads create arenas.
+UPB_API void upb_Arena_SetDefaultOptions(const upb_ArenaOptions* options);
+UPB_API void upb_Arena_GetDefaultOptions(upb_ArenaOptions* options);
+
 UPB_API void upb_Arena_Free(upb_Arena* a);
 UPB_API bool upb_Arena_Fuse(upb_Arena* a, upb_Arena* b);
 
+// Adds a reference to `a` on behalf of `owner`, who must later drop it with
+// upb_Arena_DecRefFor(). The arena (and everything fused with it) is freed
+// once every reference is gone, including the one upb_Arena_Free() drops.
+// Returns false, without adding a reference, for arenas with an initial
+// block, whose lifetime cannot be extended.
+UPB_API bool upb_Arena_IncRefFor(upb_Arena* a, const void* owner);
+UPB_API void upb_Arena_DecRefFor(upb_Arena* a, const void* owner);
+
 void* _upb_Arena_SlowMalloc(upb_Arena* a, size_t size);
 size_t upb_Arena_SpaceAllocated(upb_Arena* arena);
+UPB_API void upb_Arena_GetStats(upb_Arena* arena, upb_ArenaStats* stats);
 uint32_t upb_Arena_DebugRefCount(upb_Arena* arena);
 
 UPB_INLINE size_t _upb_ArenaHas(upb_Arena* a) {
@@ -1217,6 +1266,11 @@ UPB_API_INLINE upb_Arena* upb_Arena_New(void) {
   return upb_Arena_Init(NULL, 0, &upb_alloc_global);
 }
 
+UPB_API_INLINE upb_Arena* upb_Arena_NewWithOptions(
+    const upb_ArenaOptions* options) {
+  return upb_Arena_InitWithOptions(NULL, 0, &upb_alloc_global, options);
+}
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -1506,9 +1560,9 @@ UPB_API upb_MessageValue upb_MapIterator_Value(const upb_Map* map, size_t iter);
  * This file defines very fast int->upb_value (inttable) and string->upb_value
  * (strtable) hash tables.
  *
- * The table uses chained scatter with Brent's variation (inspired by the Lua
- * implementation of hash tables).  The hash function for strings is Austin
- * Appleby's "MurmurHash."
+ * The table uses open addressing with one metadata byte per entry that is
+ * probed a group at a time with SIMD (in the style of Abseil's SwissTable).
+ * The hash function for strings is wyhash.
  *
  * The inttable uses uintptr_t as its key, which guarantees it can be used to
  * store pointers or integers of at least 32 bits (upb isn't really useful on
@@ -1636,19 +1690,15 @@ typedef struct upb_tabval {
 typedef struct _upb_tabent {
   upb_tabkey key;
   upb_tabval val;
-
-  /* Internal chaining.  This is const so we can create static initializers for
-   * tables.  We cast away const sometimes, but *only* when the containing
-   * upb_table is known to be non-const.  This requires a bit of care, but
-   * the subtlety is confined to table.c. */
-  const struct _upb_tabent* next;
 } upb_tabent;
 
 typedef struct {
   size_t count;       /* Number of entries in the hash part. */
   uint32_t mask;      /* Mask to turn hash value -> bucket. */
-  uint32_t max_count; /* Max count before we hit our load limit. */
+  uint32_t max_count; /* Max count + deleted before we hit our load limit. */
+  uint32_t deleted;   /* Number of tombstones in the hash part. */
   uint8_t size_lg2;   /* Size of the hashtable part is 2^size_lg2 entries. */
+  uint8_t* ctrl;      /* Per-entry metadata bytes, see common.c. */
   upb_tabent* entries;
 } upb_table;
 
@@ -3696,6 +3746,9 @@ typedef enum {
 
   // kUpb_EncodeOption_CheckRequired failed but the parse otherwise succeeded.
   kUpb_EncodeStatus_MissingRequired = 3,
+
+  // The output stream passed to upb_EncodeToStream() failed or hit EOF.
+  kUpb_EncodeStatus_OutputError = 4,
 } upb_EncodeStatus;
 
 UPB_INLINE uint32_t upb_EncodeOptions_MaxDepth(uint16_t depth) {
@@ -11397,6 +11450,23 @@ bool upb_Message_Next(const upb_Message* msg, const upb_MessageDef* m,
                       const upb_DefPool* ext_pool, const upb_FieldDef** f,
                       upb_MessageValue* val, size_t* iter);
 
+// Like upb_Message_Next(), but fills up to |max| present fields into |f| and
+// |val| per call and returns how many it wrote.  A return value less than
+// |max| means the iteration is complete.
+//
+// size_t iter = kUpb_Message_Begin;
+// const upb_FieldDef *f[16];
+// upb_MessageValue val[16];
+// size_t n;
+// do {
+//   n = upb_Message_NextBatch(msg, m, ext_pool, f, val, 16, &iter);
+//   for (size_t i = 0; i < n; i++) process_field(f[i], val[i]);
+// } while (n == 16);
+size_t upb_Message_NextBatch(const upb_Message* msg, const upb_MessageDef* m,
+                             const upb_DefPool* ext_pool,
+                             const upb_FieldDef** f, upb_MessageValue* val,
+                             size_t max, size_t* iter);
+
 // Clears all unknown field data from this message and all submessages.
 UPB_API bool upb_Message_DiscardUnknown(upb_Message* msg,
                                         const upb_MessageDef* m, int maxdepth);
@@ -11551,6 +11621,10 @@ struct upb_Arena {
   // Linked list of blocks to free/cleanup.  Atomic only for the benefit of
   // upb_Arena_SpaceAllocated().
   UPB_ATOMIC(_upb_MemBlock*) blocks;
+
+  // Block growth policy, resolved from upb_ArenaOptions at creation.
+  uint32_t max_block_size;
+  uint32_t growth_factor;
 };
 
 UPB_INLINE bool _upb_Arena_IsTaggedRefcount(uintptr_t parent_or_count) {
@@ -12200,6 +12274,13 @@ void** _upb_DefPool_ScratchData(const upb_DefPool* s);
 size_t* _upb_DefPool_ScratchSize(const upb_DefPool* s);
 void _upb_DefPool_SetPlatform(upb_DefPool* s, upb_MiniTablePlatform platform);
 
+// Like upb_DefPool_AddFile(), but uses the precomputed MiniTables in `layout`
+// (which must outlive `s`) instead of building them. If `layout` is NULL the
+// MiniTables are built from the descriptor as usual.
+const upb_FileDef* _upb_DefPool_AddFile(
+    upb_DefPool* s, const UPB_DESC(FileDescriptorProto) * file_proto,
+    const upb_MiniTableFile* layout, upb_Status* status);
+
 // For generated code only: loads a generated descriptor.
 typedef struct _upb_DefPool_Init {
   struct _upb_DefPool_Init** deps;  // Dependencies of this file.
@@ -12786,6 +12867,13 @@ typedef struct upb_Decoder {
   bool missing_required;
   upb_Arena arena;
   upb_DecodeStatus status;
+
+  // Pre-zeroed messages for the run of repeated sub-messages being decoded at
+  // the current depth. Each message occupies msg_slab_type's aligned size.
+  char* msg_slab;
+  char* msg_slab_end;
+  const upb_MiniTable* msg_slab_type;
+
   jmp_buf err;
 
 #ifndef NDEBUG
@@ -12829,6 +12917,16 @@ non_ascii:
   return utf8_range2((const unsigned char*)ptr, end - ptr) == 0;
 }
 
+// Returns how many varints end in [ptr, end): every byte without a
+// continuation bit ends one.  This sizes arrays for packed varint fields before
+// they are decoded; it is not a bound, since a malformed payload can still
+// decode one more element.
+UPB_INLINE size_t _upb_Decoder_CountVarints(const char* ptr, const char* end) {
+  size_t count = 0;
+  for (; ptr < end; ptr++) count += (uint8_t)*ptr < 0x80;
+  return count;
+}
+
 const char* _upb_Decoder_CheckRequired(upb_Decoder* d, const char* ptr,
                                        const upb_Message* msg,
                                        const upb_MiniTable* l);
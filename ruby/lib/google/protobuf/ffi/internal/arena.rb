@@ -61,6 +61,7 @@ module Google
         def initialize(pointer)
           @arena = ::FFI::AutoPointer.new(pointer, Google::Protobuf::FFI.method(:free_arena))
           @pinned_messages = []
+          @read_only = false
         end
 
         def fuse(other_arena)
@@ -73,6 +74,17 @@ module Google
         def pin(message)
           pinned_messages.push message
         end
+
+        ##
+        # Marks this arena as read-only, so that every wrapper subsequently
+        # created over its memory is frozen.
+        def read_only!
+          @read_only = true
+        end
+
+        def read_only?
+          @read_only
+        end
       end
     end
 
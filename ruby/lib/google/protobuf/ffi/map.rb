@@ -376,6 +376,7 @@ module Google
 
         internal_merge_into_self(initial_values) unless initial_values.nil?
 
+        freeze if @arena.read_only?
         # Should always be the last expression of the initializer to avoid
         # leaking references to this object before construction is complete.
         OBJECT_CACHE.try_add(@map_ptr.address, self)
@@ -198,6 +198,21 @@ module Google
             message
           end
 
+          ##
+          # call-seq:
+          #    MessageClass.decode_frozen(data, options) => message
+          #
+          # Like decode, but returns a deeply frozen message: every message,
+          # repeated field and map reachable from it is frozen as well.
+          # @param data [String] Binary string in Protobuf wire format to decode
+          # @param options [Hash] options for the decoder
+          # @option options [Integer] :recursion_limit Set to maximum decoding depth for message (default is 64)
+          def self.decode_frozen(data, options = {})
+            message = decode(data, options)
+            message.instance_variable_get(:@arena).read_only!
+            message.freeze
+          end
+
           ##
           # call-seq:
           #    MessageClass.encode(msg, options) => bytes
@@ -588,6 +603,7 @@ module Google
               end
             end
 
+            freeze if @arena.read_only?
             # Should always be the last expression of the initializer to avoid
             # leaking references to this object before construction is complete.
             Google::Protobuf::OBJECT_CACHE.try_add @msg.address, self
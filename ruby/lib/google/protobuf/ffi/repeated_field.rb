@@ -486,6 +486,7 @@ module Google
           internal_push(*initial_values)
         end
 
+        freeze if @arena.read_only?
         # Should always be the last expression of the initializer to avoid
         # leaking references to this object before construction is complete.
         OBJECT_CACHE.try_add(@array.address, self)
@@ -1755,6 +1755,26 @@ module CommonTests
     assert_nil h[m2]
   end
 
+  def test_eq_signed_zero_agrees_with_hash
+    m1 = proto_module::TestMessage.new(:optional_double => 0.0)
+    m2 = proto_module::TestMessage.new(:optional_double => -0.0)
+
+    # Messages are compared by their bytes, so eql? must imply equal hashes.
+    refute_equal m1, m2
+    refute m1.eql?(m2)
+    refute_equal m1.hash, m2.hash
+  end
+
+  def test_eq_nan
+    m1 = proto_module::TestMessage.new(:optional_double => Float::NAN)
+    m2 = m1.dup
+
+    assert_equal m1, m2
+    assert m1.eql?(m2)
+    assert_equal m1.hash, m2.hash
+    assert_equal m1, m1
+  end
+
   def cruby_or_jruby_9_3_or_higher?
     # https://github.com/jruby/jruby/issues/6818 was fixed in JRuby 9.3.0.0
     match = RUBY_PLATFORM == "java" &&
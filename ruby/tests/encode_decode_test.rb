@@ -175,4 +175,37 @@ class EncodeDecodeTest < Test::Unit::TestCase
     assert_match msg.to_json, msg_out.to_json
   end
 
+  def test_decode_frozen
+    return if RUBY_PLATFORM == "java"
+    msg = A::B::C::TestMessage.new(
+      optional_string: "x" * 100,
+      optional_msg: A::B::C::TestMessage.new(optional_int32: 1),
+      repeated_msg: [A::B::C::TestMessage.new(optional_int32: 2)],
+      map_string_msg: {"a" => A::B::C::TestMessage.new(optional_int32: 3)}
+    )
+    data = A::B::C::TestMessage.encode(msg).dup
+    msg_out = A::B::C::TestMessage.decode_frozen(data)
+
+    # Writes to the input must not be visible through the message.
+    data.replace("\0" * data.bytesize)
+    assert_equal msg, msg_out
+
+    assert_predicate msg_out, :frozen?
+    assert_predicate msg_out.optional_msg, :frozen?
+    assert_predicate msg_out.repeated_msg, :frozen?
+    assert_predicate msg_out.repeated_msg[0], :frozen?
+    assert_predicate msg_out.map_string_msg, :frozen?
+    assert_predicate msg_out.map_string_msg["a"], :frozen?
+    assert_raises(FrozenError) { msg_out.optional_msg.optional_int32 = 5 }
+    assert_raises(FrozenError) { msg_out.repeated_msg << A::B::C::TestMessage.new }
+
+    copy = msg_out.dup
+    copy.optional_int32 = 5
+    assert_equal 5, copy.optional_int32
+
+    assert_raises Google::Protobuf::ParseError do
+      A::B::C::TestMessage.decode_frozen("\xff")
+    end
+  end
+
 end
@@ -33,7 +33,9 @@
 #ifndef GOOGLE_PROTOBUF_RUST_CPP_KERNEL_CPP_H__
 #define GOOGLE_PROTOBUF_RUST_CPP_KERNEL_CPP_H__
 
+#include <climits>
 #include <cstddef>
+#include <cstdint>
 
 #include "google/protobuf/message.h"
 
@@ -63,16 +65,22 @@ extern "C" struct SerializedData {
 extern "C" void* __pb_rust_alloc(size_t size, size_t align);
 
 inline SerializedData SerializeMsg(const google::protobuf::Message* msg) {
+  // ByteSizeLong() caches the size of every sub-message, so we serialize with
+  // the cached sizes instead of letting SerializeToArray() compute them again.
   size_t len = msg->ByteSizeLong();
-  void* bytes = __pb_rust_alloc(len, alignof(char));
-  if (!msg->SerializeToArray(bytes, static_cast<int>(len))) {
+  if (len > INT_MAX) {
     ABSL_LOG(FATAL) << "Couldn't serialize the message.";
   }
-  return SerializedData(static_cast<char*>(bytes), len);
+  auto* bytes = static_cast<uint8_t*>(__pb_rust_alloc(len, alignof(char)));
+  uint8_t* end = msg->SerializeWithCachedSizesToArray(bytes);
+  ABSL_DCHECK_EQ(static_cast<size_t>(end - bytes), len);
+  (void)end;
+  return SerializedData(reinterpret_cast<char*>(bytes), len);
 }
 
 // Represents an ABI-stable version of &[u8]/string_view (borrowed slice of
-// bytes) for FFI use only.
+// bytes) for FFI use only. String getters return one that points straight at
+// the field's storage, so reading a string from Rust never copies it.
 struct PtrAndLen {
   /// Borrows the memory.
   const char* ptr;
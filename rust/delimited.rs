@@ -0,0 +1,131 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google LLC.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//! Splitting of length-delimited record streams.
+
+use crate::ParseError;
+
+/// The longest a varint can be: 64 bits at 7 bits per byte.
+const MAX_VARINT_LEN: usize = 10;
+
+/// An iterator over the records in a buffer of length-delimited messages.
+///
+/// Each record is a varint byte length followed by that many bytes of
+/// serialized message, the format other languages produce with
+/// `writeDelimitedTo()`. The records are yielded as slices of the input, so
+/// nothing is copied. A malformed or truncated length yields one `Err` and ends
+/// the iteration.
+#[derive(Debug, Clone)]
+pub struct DelimitedRecords<'a> {
+    data: &'a [u8],
+}
+
+impl<'a> DelimitedRecords<'a> {
+    pub fn new(data: &'a [u8]) -> Self {
+        Self { data }
+    }
+
+    fn fail(&mut self) -> Option<Result<&'a [u8], ParseError>> {
+        self.data = &[];
+        Some(Err(ParseError))
+    }
+}
+
+impl<'a> Iterator for DelimitedRecords<'a> {
+    type Item = Result<&'a [u8], ParseError>;
+
+    fn next(&mut self) -> Option<Self::Item> {
+        if self.data.is_empty() {
+            return None;
+        }
+
+        let mut len: u64 = 0;
+        let mut pos = 0;
+        loop {
+            let Some(&byte) = self.data.get(pos) else { return self.fail() };
+            if pos == MAX_VARINT_LEN {
+                return self.fail();
+            }
+            len |= u64::from(byte & 0x7f) << (7 * pos);
+            pos += 1;
+            if byte & 0x80 == 0 {
+                break;
+            }
+        }
+
+        let end = usize::try_from(len).ok().and_then(|len| pos.checked_add(len));
+        match end {
+            Some(end) if end <= self.data.len() => {
+                let (record, rest) = self.data[pos..].split_at(end - pos);
+                self.data = rest;
+                Some(Ok(record))
+            }
+            _ => self.fail(),
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn collect(data: &[u8]) -> Vec<Result<&[u8], ParseError>> {
+        DelimitedRecords::new(data).collect()
+    }
+
+    #[test]
+    fn test_records() {
+        let records: Vec<_> =
+            collect(b"\x03abc\x00\x01d").into_iter().map(Result::unwrap).collect();
+        assert_eq!(records, [&b"abc"[..], b"", b"d"]);
+        assert!(collect(b"").is_empty());
+    }
+
+    #[test]
+    fn test_multibyte_length() {
+        let mut data = vec![0x80, 0x01];
+        data.extend_from_slice(&[7; 128]);
+        let records = collect(&data);
+        assert_eq!(records.len(), 1);
+        assert_eq!(records[0].as_ref().unwrap().len(), 128);
+    }
+
+    #[test]
+    fn test_malformed() {
+        // Truncated record.
+        let records = collect(b"\x01a\x05abc");
+        assert_eq!(records.len(), 2);
+        assert!(records[1].is_err());
+        // Truncated length.
+        assert!(collect(b"\x80")[0].is_err());
+        // Overlong length.
+        assert!(collect(&[0xff; 11])[0].is_err());
+    }
+}
@@ -40,6 +40,7 @@ use std::fmt;
 /// These are the items protobuf users can access directly.
 #[doc(hidden)]
 pub mod __public {
+    pub use crate::delimited::DelimitedRecords;
     pub use crate::optional::{AbsentField, FieldEntry, Optional, PresentField};
     pub use crate::proxied::{
         Mut, MutProxy, Proxied, ProxiedWithPresence, SettableValue, View, ViewProxy,
@@ -64,6 +65,7 @@ pub mod __runtime;
 #[path = "upb.rs"]
 pub mod __runtime;
 
+mod delimited;
 mod macros;
 mod optional;
 mod proxied;
@@ -59,3 +59,27 @@ fn deserialize_error() {
     let data = b"not a serialized proto";
     assert!(msg.deserialize(&*data).is_err());
 }
+
+#[test]
+fn parse_delimited_in_shared_arena() {
+    let mut data = Vec::new();
+    for i in 1..=3 {
+        let mut msg = TestAllTypes::new();
+        msg.optional_int64_set(Some(i));
+        let serialized = msg.serialize();
+        data.push(serialized.len() as u8);
+        data.extend_from_slice(&serialized);
+    }
+
+    let arena = protobuf::__runtime::Arena::new();
+    let msgs: Vec<_> = TestAllTypes::parse_delimited_in(&data, &arena)
+        .collect::<Result<_, _>>()
+        .expect("parse should succeed");
+    drop(arena);
+
+    let values: Vec<_> = msgs.iter().map(|m| m.optional_int64()).collect();
+    assert_eq!(values, [1, 2, 3]);
+
+    let arena = protobuf::__runtime::Arena::new();
+    assert!(TestAllTypes::parse_in(b"not a serialized proto", &arena).is_err());
+}
@@ -64,6 +64,7 @@ extern "C" {
     // `Option<NonNull<T: Sized>>` is ABI-compatible with `*mut T`
     fn upb_Arena_New() -> Option<RawArena>;
     fn upb_Arena_Free(arena: RawArena);
+    fn upb_Arena_IncRefFor(arena: RawArena, owner: *const u8) -> bool;
     fn upb_Arena_Malloc(arena: RawArena, size: usize) -> *mut u8;
     fn upb_Arena_Realloc(arena: RawArena, ptr: *mut u8, old: usize, new: usize) -> *mut u8;
 }
@@ -87,6 +88,23 @@ impl Arena {
         }
     }
 
+    /// Returns another owning handle to the same arena.
+    ///
+    /// Memory allocated through any handle stays valid until every handle has
+    /// been dropped. This lets many messages share one arena, which is much
+    /// cheaper than giving each its own.
+    #[inline]
+    pub fn share(&self) -> Self {
+        // SAFETY:
+        // - `self.raw` is a valid UPB arena.
+        // - Arenas created by `upb_Arena_New` have no initial block, so taking a
+        //   reference cannot fail. The reference is dropped by `upb_Arena_Free`
+        //   in `drop`, the same as for the original handle.
+        let ok = unsafe { upb_Arena_IncRefFor(self.raw, ptr::null()) };
+        assert!(ok, "Could not share a UPB arena");
+        Self { raw: self.raw, _not_sync: PhantomData }
+    }
+
     /// Returns the raw, UPB-managed pointer to the arena.
     #[inline]
     pub fn raw(&self) -> RawArena {
@@ -283,6 +301,16 @@ mod tests {
         drop(arena);
     }
 
+    #[test]
+    fn test_arena_share() {
+        let arena = Arena::new();
+        let shared = arena.share();
+        let mem = unsafe { shared.alloc(Layout::new::<u64>()) };
+        drop(arena);
+        mem.fill(MaybeUninit::new(0));
+        drop(shared);
+    }
+
     #[test]
     fn test_serialized_data_roundtrip() {
         let arena = Arena::new();
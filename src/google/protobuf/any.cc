@@ -48,8 +48,7 @@ bool AnyMetadata::PackFrom(Arena* arena, const Message& message) {
 
 bool AnyMetadata::PackFrom(Arena* arena, const Message& message,
                            absl::string_view type_url_prefix) {
-  type_url_->Set(
-      GetTypeUrl(message.GetDescriptor()->full_name(), type_url_prefix), arena);
+  SetTypeUrl(arena, type_url_prefix, message.GetDescriptor()->full_name());
   return message.SerializeToString(value_->Mutable(arena));
 }
 
@@ -123,6 +123,10 @@ class PROTOBUF_EXPORT AnyMetadata {
   bool InternalUnpackTo(absl::string_view type_name,
                         MessageLite* message) const;
   bool InternalIs(absl::string_view type_name) const;
+  // Writes the type URL for "type_name" into type_url_ in place, reusing its
+  // existing buffer rather than building a temporary string.
+  void SetTypeUrl(Arena* arena, absl::string_view type_url_prefix,
+                  absl::string_view type_name);
 
   UrlType* type_url_;
   ValueType* value_;
@@ -145,6 +149,11 @@ bool ParseAnyTypeUrl(absl::string_view type_url, std::string* full_type_name);
 bool ParseAnyTypeUrl(absl::string_view type_url, std::string* url_prefix,
                      std::string* full_type_name);
 
+// Like ParseAnyTypeUrl(), but returns views into "type_url" instead of
+// copying. Either output pointer may be null.
+bool SplitAnyTypeUrl(absl::string_view type_url, absl::string_view* url_prefix,
+                     absl::string_view* full_type_name);
+
 // See if message is of type google.protobuf.Any, if so, return the descriptors
 // for "type_url" and "value" fields.
 bool GetAnyFieldDescriptors(const Message& message,
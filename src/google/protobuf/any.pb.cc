@@ -121,9 +121,19 @@ const ::_pbi::DescriptorTable descriptor_table_google_2fprotobuf_2fany_2eproto =
 PROTOBUF_ATTRIBUTE_WEAK const ::_pbi::DescriptorTable* descriptor_table_google_2fprotobuf_2fany_2eproto_getter() {
   return &descriptor_table_google_2fprotobuf_2fany_2eproto;
 }
+#if defined(PROTOBUF_DESCRIPTOR_TABLE_SECTION)
+// Registered on first access to the generated pool.
+PROTOBUF_DESCRIPTOR_TABLE_SECTION
+static const ::_pbi::DescriptorTable* const dynamic_init_dummy_google_2fprotobuf_2fany_2eproto =
+    &descriptor_table_google_2fprotobuf_2fany_2eproto;
+// Makes this binary or shared object report its section.
+__attribute__((used)) static const bool* const descriptor_table_section_dummy_google_2fprotobuf_2fany_2eproto =
+    &::_pbi::DescriptorTableSection<>::registered;
+#else
 // Force running AddDescriptors() at dynamic initialization time.
 PROTOBUF_ATTRIBUTE_INIT_PRIORITY2
 static ::_pbi::AddDescriptorsRunner dynamic_init_dummy_google_2fprotobuf_2fany_2eproto(&descriptor_table_google_2fprotobuf_2fany_2eproto);
+#endif  // defined(PROTOBUF_DESCRIPTOR_TABLE_SECTION)
 namespace google {
 namespace protobuf {
 // ===================================================================
@@ -244,6 +254,7 @@ const ::_pbi::TcParseTable<1, 2, 0, 36, 2> Any::_table_ = {
     offsetof(decltype(_table_), field_names),  // no aux_entries
     &_Any_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     // bytes value = 2;
     {::_pbi::TcParser::FastBS1,
@@ -279,8 +290,10 @@ const ::_pbi::TcParseTable<1, 2, 0, 36, 2> Any::_table_ = {
   // string type_url = 1;
   if (!this->_internal_type_url().empty()) {
     const std::string& _s = this->_internal_type_url();
-    ::google::protobuf::internal::WireFormatLite::VerifyUtf8String(
-        _s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormatLite::SERIALIZE, "google.protobuf.Any.type_url");
+    if (!_impl_.type_url_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormatLite::VerifyUtf8String(
+          _s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormatLite::SERIALIZE, "google.protobuf.Any.type_url");
+    }
     target = stream->WriteStringMaybeAliased(1, _s, target);
   }
 
@@ -322,6 +335,24 @@ const ::_pbi::TcParseTable<1, 2, 0, 36, 2> Any::_table_ = {
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t Any::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(Any);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  if (!_impl_.type_url_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.type_url_.Get());
+  }
+  if (!_impl_.value_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.value_.Get());
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData Any::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     Any::MergeImpl
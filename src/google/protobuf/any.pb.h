@@ -208,6 +208,7 @@ class PROTOBUF_EXPORT Any final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -301,6 +302,7 @@ class PROTOBUF_EXPORT Any final :
 
 
 
+
 // ===================================================================
 
 
@@ -56,10 +56,20 @@ const char kTypeGoogleProdComPrefix[] = "type.googleprod.com/";
 bool AnyMetadata::InternalPackFrom(Arena* arena, const MessageLite& message,
                                    absl::string_view type_url_prefix,
                                    absl::string_view type_name) {
-  type_url_->Set(GetTypeUrl(type_name, type_url_prefix), arena);
+  SetTypeUrl(arena, type_url_prefix, type_name);
   return message.SerializeToString(value_->Mutable(arena));
 }
 
+void AnyMetadata::SetTypeUrl(Arena* arena, absl::string_view type_url_prefix,
+                             absl::string_view type_name) {
+  std::string* type_url = type_url_->Mutable(arena);
+  type_url->assign(type_url_prefix.data(), type_url_prefix.size());
+  if (type_url_prefix.empty() || type_url_prefix.back() != '/') {
+    type_url->push_back('/');
+  }
+  type_url->append(type_name.data(), type_name.size());
+}
+
 bool AnyMetadata::InternalUnpackTo(absl::string_view type_name,
                                    MessageLite* message) const {
   if (!InternalIs(type_name)) {
@@ -75,16 +85,32 @@ bool AnyMetadata::InternalIs(absl::string_view type_name) const {
          absl::EndsWith(type_url, type_name);
 }
 
+bool SplitAnyTypeUrl(absl::string_view type_url, absl::string_view* url_prefix,
+                     absl::string_view* full_type_name) {
+  size_t pos = type_url.find_last_of('/');
+  if (pos == absl::string_view::npos || pos + 1 == type_url.size()) {
+    return false;
+  }
+  if (url_prefix) {
+    *url_prefix = type_url.substr(0, pos + 1);
+  }
+  if (full_type_name) {
+    *full_type_name = type_url.substr(pos + 1);
+  }
+  return true;
+}
+
 bool ParseAnyTypeUrl(absl::string_view type_url, std::string* url_prefix,
                      std::string* full_type_name) {
-  size_t pos = type_url.find_last_of('/');
-  if (pos == std::string::npos || pos + 1 == type_url.size()) {
+  absl::string_view prefix;
+  absl::string_view name;
+  if (!SplitAnyTypeUrl(type_url, &prefix, &name)) {
     return false;
   }
   if (url_prefix) {
-    *url_prefix = std::string(type_url.substr(0, pos + 1));
+    *url_prefix = std::string(prefix);
   }
-  *full_type_name = std::string(type_url.substr(pos + 1));
+  *full_type_name = std::string(name);
   return true;
 }
 
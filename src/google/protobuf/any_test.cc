@@ -31,7 +31,9 @@
 #include "google/protobuf/any.pb.h"
 #include <gtest/gtest.h>
 #include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "google/protobuf/any_test.pb.h"
+#include "google/protobuf/arena.h"
 #include "google/protobuf/unittest.pb.h"
 
 
@@ -123,6 +125,33 @@ TEST(AnyTest, TestPackWithCustomTypeUrl) {
   EXPECT_EQ(12345, submessage.int32_value());
 }
 
+TEST(AnyTest, RepackReusesTypeUrl) {
+  Arena arena;
+  auto* any = Arena::CreateMessage<google::protobuf::Any>(&arena);
+  protobuf_unittest::TestAny submessage;
+  submessage.set_int32_value(1);
+  ASSERT_TRUE(any->PackFrom(submessage, "type.myservice.com"));
+  ASSERT_TRUE(any->PackFrom(submessage));
+  EXPECT_EQ("type.googleapis.com/protobuf_unittest.TestAny", any->type_url());
+  submessage.Clear();
+  ASSERT_TRUE(any->UnpackTo(&submessage));
+  EXPECT_EQ(1, submessage.int32_value());
+}
+
+TEST(AnyTest, SplitAnyTypeUrl) {
+  absl::string_view prefix;
+  absl::string_view name;
+  ASSERT_TRUE(internal::SplitAnyTypeUrl("type.googleapis.com/a.B", &prefix,
+                                        &name));
+  EXPECT_EQ("type.googleapis.com/", prefix);
+  EXPECT_EQ("a.B", name);
+  EXPECT_TRUE(internal::SplitAnyTypeUrl("a/b/c.D", nullptr, &name));
+  EXPECT_EQ("c.D", name);
+  EXPECT_FALSE(internal::SplitAnyTypeUrl("a.B", &prefix, &name));
+  EXPECT_FALSE(internal::SplitAnyTypeUrl("type.googleapis.com/", &prefix,
+                                         &name));
+}
+
 TEST(AnyTest, TestIs) {
   protobuf_unittest::TestAny submessage;
   submessage.set_int32_value(12345);
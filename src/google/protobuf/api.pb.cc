@@ -234,9 +234,19 @@ const ::_pbi::DescriptorTable descriptor_table_google_2fprotobuf_2fapi_2eproto =
 PROTOBUF_ATTRIBUTE_WEAK const ::_pbi::DescriptorTable* descriptor_table_google_2fprotobuf_2fapi_2eproto_getter() {
   return &descriptor_table_google_2fprotobuf_2fapi_2eproto;
 }
+#if defined(PROTOBUF_DESCRIPTOR_TABLE_SECTION)
+// Registered on first access to the generated pool.
+PROTOBUF_DESCRIPTOR_TABLE_SECTION
+static const ::_pbi::DescriptorTable* const dynamic_init_dummy_google_2fprotobuf_2fapi_2eproto =
+    &descriptor_table_google_2fprotobuf_2fapi_2eproto;
+// Makes this binary or shared object report its section.
+__attribute__((used)) static const bool* const descriptor_table_section_dummy_google_2fprotobuf_2fapi_2eproto =
+    &::_pbi::DescriptorTableSection<>::registered;
+#else
 // Force running AddDescriptors() at dynamic initialization time.
 PROTOBUF_ATTRIBUTE_INIT_PRIORITY2
 static ::_pbi::AddDescriptorsRunner dynamic_init_dummy_google_2fprotobuf_2fapi_2eproto(&descriptor_table_google_2fprotobuf_2fapi_2eproto);
+#endif  // defined(PROTOBUF_DESCRIPTOR_TABLE_SECTION)
 namespace google {
 namespace protobuf {
 // ===================================================================
@@ -386,6 +396,7 @@ const ::_pbi::TcParseTable<3, 7, 4, 39, 2> Api::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_Api_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // string name = 1;
@@ -456,8 +467,10 @@ const ::_pbi::TcParseTable<3, 7, 4, 39, 2> Api::_table_ = {
   // string name = 1;
   if (!this->_internal_name().empty()) {
     const std::string& _s = this->_internal_name();
-    ::google::protobuf::internal::WireFormatLite::VerifyUtf8String(
-        _s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormatLite::SERIALIZE, "google.protobuf.Api.name");
+    if (!_impl_.name_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormatLite::VerifyUtf8String(
+          _s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormatLite::SERIALIZE, "google.protobuf.Api.name");
+    }
     target = stream->WriteStringMaybeAliased(1, _s, target);
   }
 
@@ -480,8 +493,10 @@ const ::_pbi::TcParseTable<3, 7, 4, 39, 2> Api::_table_ = {
   // string version = 4;
   if (!this->_internal_version().empty()) {
     const std::string& _s = this->_internal_version();
-    ::google::protobuf::internal::WireFormatLite::VerifyUtf8String(
-        _s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormatLite::SERIALIZE, "google.protobuf.Api.version");
+    if (!_impl_.version_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormatLite::VerifyUtf8String(
+          _s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormatLite::SERIALIZE, "google.protobuf.Api.version");
+    }
     target = stream->WriteStringMaybeAliased(4, _s, target);
   }
 
@@ -572,6 +587,30 @@ const ::_pbi::TcParseTable<3, 7, 4, 39, 2> Api::_table_ = {
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t Api::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(Api);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  total_size += _impl_.methods_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.options_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.mixins_.SpaceUsedExcludingSelfLong();
+  if (!_impl_.name_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.name_.Get());
+  }
+  if (!_impl_.version_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.version_.Get());
+  }
+  if (_impl_.source_context_ != nullptr) {
+    total_size += _impl_.source_context_->SpaceUsedLong();
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData Api::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     Api::MergeImpl
@@ -782,6 +821,7 @@ const ::_pbi::TcParseTable<3, 7, 1, 68, 2> Method::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_Method_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // string name = 1;
@@ -850,16 +890,20 @@ const ::_pbi::TcParseTable<3, 7, 1, 68, 2> Method::_table_ = {
   // string name = 1;
   if (!this->_internal_name().empty()) {
     const std::string& _s = this->_internal_name();
-    ::google::protobuf::internal::WireFormatLite::VerifyUtf8String(
-        _s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormatLite::SERIALIZE, "google.protobuf.Method.name");
+    if (!_impl_.name_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormatLite::VerifyUtf8String(
+          _s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormatLite::SERIALIZE, "google.protobuf.Method.name");
+    }
     target = stream->WriteStringMaybeAliased(1, _s, target);
   }
 
   // string request_type_url = 2;
   if (!this->_internal_request_type_url().empty()) {
     const std::string& _s = this->_internal_request_type_url();
-    ::google::protobuf::internal::WireFormatLite::VerifyUtf8String(
-        _s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormatLite::SERIALIZE, "google.protobuf.Method.request_type_url");
+    if (!_impl_.request_type_url_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormatLite::VerifyUtf8String(
+          _s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormatLite::SERIALIZE, "google.protobuf.Method.request_type_url");
+    }
     target = stream->WriteStringMaybeAliased(2, _s, target);
   }
 
@@ -873,8 +917,10 @@ const ::_pbi::TcParseTable<3, 7, 1, 68, 2> Method::_table_ = {
   // string response_type_url = 4;
   if (!this->_internal_response_type_url().empty()) {
     const std::string& _s = this->_internal_response_type_url();
-    ::google::protobuf::internal::WireFormatLite::VerifyUtf8String(
-        _s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormatLite::SERIALIZE, "google.protobuf.Method.response_type_url");
+    if (!_impl_.response_type_url_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormatLite::VerifyUtf8String(
+          _s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormatLite::SERIALIZE, "google.protobuf.Method.response_type_url");
+    }
     target = stream->WriteStringMaybeAliased(4, _s, target);
   }
 
@@ -960,6 +1006,29 @@ const ::_pbi::TcParseTable<3, 7, 1, 68, 2> Method::_table_ = {
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t Method::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(Method);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  total_size += _impl_.options_.SpaceUsedExcludingSelfLong();
+  if (!_impl_.name_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.name_.Get());
+  }
+  if (!_impl_.request_type_url_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.request_type_url_.Get());
+  }
+  if (!_impl_.response_type_url_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.response_type_url_.Get());
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData Method::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     Method::MergeImpl
@@ -1135,6 +1204,7 @@ const ::_pbi::TcParseTable<1, 2, 0, 38, 2> Mixin::_table_ = {
     offsetof(decltype(_table_), field_names),  // no aux_entries
     &_Mixin_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     // string root = 2;
     {::_pbi::TcParser::FastUS1,
@@ -1171,16 +1241,20 @@ const ::_pbi::TcParseTable<1, 2, 0, 38, 2> Mixin::_table_ = {
   // string name = 1;
   if (!this->_internal_name().empty()) {
     const std::string& _s = this->_internal_name();
-    ::google::protobuf::internal::WireFormatLite::VerifyUtf8String(
-        _s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormatLite::SERIALIZE, "google.protobuf.Mixin.name");
+    if (!_impl_.name_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormatLite::VerifyUtf8String(
+          _s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormatLite::SERIALIZE, "google.protobuf.Mixin.name");
+    }
     target = stream->WriteStringMaybeAliased(1, _s, target);
   }
 
   // string root = 2;
   if (!this->_internal_root().empty()) {
     const std::string& _s = this->_internal_root();
-    ::google::protobuf::internal::WireFormatLite::VerifyUtf8String(
-        _s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormatLite::SERIALIZE, "google.protobuf.Mixin.root");
+    if (!_impl_.root_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormatLite::VerifyUtf8String(
+          _s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormatLite::SERIALIZE, "google.protobuf.Mixin.root");
+    }
     target = stream->WriteStringMaybeAliased(2, _s, target);
   }
 
@@ -1216,6 +1290,24 @@ const ::_pbi::TcParseTable<1, 2, 0, 38, 2> Mixin::_table_ = {
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t Mixin::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(Mixin);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  if (!_impl_.name_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.name_.Get());
+  }
+  if (!_impl_.root_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.root_.Get());
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData Mixin::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     Mixin::MergeImpl
@@ -31,6 +31,7 @@
 #include "google/protobuf/message.h"
 #include "google/protobuf/repeated_field.h"  // IWYU pragma: export
 #include "google/protobuf/extension_set.h"  // IWYU pragma: export
+#include "absl/types/span.h"
 #include "google/protobuf/unknown_field_set.h"
 #include "google/protobuf/source_context.pb.h"
 #include "google/protobuf/type.pb.h"
@@ -181,6 +182,7 @@ class PROTOBUF_EXPORT Mixin final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -372,6 +374,7 @@ class PROTOBUF_EXPORT Method final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -637,6 +640,7 @@ class PROTOBUF_EXPORT Api final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -819,6 +823,7 @@ class PROTOBUF_EXPORT Api final :
 
 
 
+
 // ===================================================================
 
 
@@ -37,6 +37,7 @@
 #include <limits>
 #include <string>
 #include <typeinfo>
+#include <utility>
 #include <vector>
 
 #include "absl/base/attributes.h"
@@ -45,6 +46,7 @@
 #include "google/protobuf/arenaz_sampler.h"
 #include "google/protobuf/port.h"
 #include "google/protobuf/serial_arena.h"
+#include "google/protobuf/thread_local_cache.h"
 #include "google/protobuf/thread_safe_arena.h"
 
 
@@ -52,6 +54,10 @@
 #include <sanitizer/asan_interface.h>
 #endif  // ADDRESS_SANITIZER
 
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif  // defined(__linux__)
+
 // Must be included last.
 #include "google/protobuf/port_def.inc"
 
@@ -81,10 +87,130 @@ ArenaBlock* SentryArenaBlock() {
 }
 #endif
 
+// Records the number and size of the cleanup nodes in `[pos, end)` of a block
+// for a sampled arena.
+void RecordCleanupNodes(ThreadSafeArenaStats* stats, const char* pos,
+                        const char* end) {
+  if (PROTOBUF_PREDICT_TRUE(stats == nullptr)) return;
+  size_t nodes = 0;
+  for (const char* it = pos; it < end; it += cleanup::PrefetchNode(it)) {
+    ++nodes;
+  }
+  ThreadSafeArenaStats::RecordCleanupStats(stats, nodes,
+                                           static_cast<size_t>(end - pos));
+}
+
+}  // namespace
+
+namespace {
+
+// A bounded, per-thread LIFO cache of freed arena blocks. Arenas whose
+// AllocationPolicy enables `max_thread_cached_blocks` return their blocks here
+// on destruction instead of releasing them, and new arenas on the same thread
+// reuse them, which keeps short-lived arenas off the system allocator. The
+// blocks are released on thread exit.
+class ThreadBlockCache {
+ public:
+  // Returns the most recently cached block that is at least `size` bytes, or
+  // {nullptr, 0} if there is none.
+  static SizedPtr Get(size_t size) {
+    Blocks& blocks = internal::ThreadLocalCache<Blocks>::Get();
+    for (CachedBlock** it = &blocks.head; *it != nullptr; it = &(*it)->next) {
+      CachedBlock* b = *it;
+      if (b->size < size) continue;
+      *it = b->next;
+      --blocks.count;
+      return {b, b->size};
+    }
+    return {nullptr, 0};
+  }
+
+  // Takes ownership of `mem` if the cache has room for it. Returns false
+  // otherwise, in which case the caller must release the memory.
+  static bool Put(SizedPtr mem, size_t max_blocks) {
+    Blocks* blocks = internal::ThreadLocalCache<Blocks>::GetForInsert();
+    if (blocks == nullptr || blocks->count >= max_blocks) return false;
+    blocks->head = new (mem.p) CachedBlock{blocks->head, mem.n};
+    ++blocks->count;
+    return true;
+  }
+
+ private:
+  struct CachedBlock {
+    CachedBlock* next;
+    size_t size;
+  };
+
+  struct Blocks {
+    CachedBlock* head;
+    size_t count;
+
+    static void Clear(Blocks& blocks) {
+      while (blocks.head != nullptr) {
+        CachedBlock* b = blocks.head;
+        blocks.head = b->next;
+        internal::SizedDelete(b, b->size);
+      }
+      blocks.count = 0;
+    }
+  };
+};
+
 }  // namespace
 
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+// Huge page blocks are exactly a multiple of kHugePageSize. Blocks from the
+// fallback path are never, so they can be told apart on deallocation.
+static bool IsHugePageBlock(SizedPtr mem) {
+  return mem.n >= AllocationPolicy::kHugePageSize &&
+         mem.n % AllocationPolicy::kHugePageSize == 0;
+}
+#endif  // defined(__linux__) && defined(MADV_HUGEPAGE)
+
+static SizedPtr AllocateHugePageBlock(size_t size) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  constexpr size_t kHugePageSize = AllocationPolicy::kHugePageSize;
+  ABSL_DCHECK_GE(size, kHugePageSize);
+  // Also verify that rounding up to kHugePageSize won't overflow.
+  ABSL_CHECK_LE(size, std::numeric_limits<size_t>::max() - 2 * kHugePageSize);
+  size_t n = (size + kHugePageSize - 1) & ~(kHugePageSize - 1);
+  // Over-allocate so that the block can be aligned to a huge page boundary,
+  // then give back the unaligned head and tail.
+  void* p = mmap(nullptr, n + kHugePageSize, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p != MAP_FAILED) {
+    uintptr_t start = reinterpret_cast<uintptr_t>(p);
+    uintptr_t aligned = (start + kHugePageSize - 1) & ~(kHugePageSize - 1);
+    if (aligned != start) munmap(p, aligned - start);
+    size_t tail = kHugePageSize - (aligned - start);
+    if (tail != 0) munmap(reinterpret_cast<void*>(aligned + n), tail);
+    void* block = reinterpret_cast<void*>(aligned);
+    // Advisory only; the block is usable with regular pages as well.
+    madvise(block, n, MADV_HUGEPAGE);
+    return {block, n};
+  }
+  // Keep the size off a kHugePageSize multiple so that IsHugePageBlock()
+  // does not mistake this block for a mapped one.
+  n += 8;
+  return {::operator new(n), n};
+#else
+  return AllocateAtLeast(size);
+#endif  // defined(__linux__) && defined(MADV_HUGEPAGE)
+}
+
+static void DeallocateHugePageBlock(SizedPtr mem) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  if (IsHugePageBlock(mem)) {
+    munmap(mem.p, mem.n);
+    return;
+  }
+#endif  // defined(__linux__) && defined(MADV_HUGEPAGE)
+  internal::SizedDelete(mem.p, mem.n);
+}
+
 static SizedPtr AllocateMemory(const AllocationPolicy* policy_ptr,
-                               size_t last_size, size_t min_bytes) {
+                               size_t last_size, size_t min_bytes,
+                               ThreadSafeArenaStats* stats = nullptr) {
   AllocationPolicy policy;  // default policy
   if (policy_ptr) policy = *policy_ptr;
   size_t size;
@@ -100,7 +226,15 @@ static SizedPtr AllocateMemory(const AllocationPolicy* policy_ptr,
                                SerialArena::kBlockHeaderSize);
   size = std::max(size, SerialArena::kBlockHeaderSize + min_bytes);
 
+  if (policy.UsesThreadBlockCache()) {
+    SizedPtr mem = ThreadBlockCache::Get(size);
+    ThreadSafeArenaStats::RecordBlockCacheStats(stats, mem.p != nullptr);
+    if (mem.p != nullptr) return mem;
+  }
   if (policy.block_alloc == nullptr) {
+    if (policy.UsesHugePages() && size >= AllocationPolicy::kHugePageSize) {
+      return AllocateHugePageBlock(size);
+    }
     return AllocateAtLeast(size);
   }
   return {policy.block_alloc(size), size};
@@ -110,6 +244,10 @@ class GetDeallocator {
  public:
   GetDeallocator(const AllocationPolicy* policy, size_t* space_allocated)
       : dealloc_(policy ? policy->block_dealloc : nullptr),
+        max_cached_blocks_(policy && policy->UsesThreadBlockCache()
+                               ? policy->max_thread_cached_blocks
+                               : 0),
+        huge_pages_(policy && policy->UsesHugePages()),
         space_allocated_(space_allocated) {}
 
   void operator()(SizedPtr mem) const {
@@ -120,7 +258,10 @@ class GetDeallocator {
 #endif  // ADDRESS_SANITIZER
     if (dealloc_) {
       dealloc_(mem.p, mem.n);
-    } else {
+    } else if (huge_pages_) {
+      DeallocateHugePageBlock(mem);
+    } else if (max_cached_blocks_ == 0 ||
+               !ThreadBlockCache::Put(mem, max_cached_blocks_)) {
       internal::SizedDelete(mem.p, mem.n);
     }
     *space_allocated_ += mem.n;
@@ -128,6 +269,8 @@ class GetDeallocator {
 
  private:
   void (*dealloc_)(void*, size_t);
+  size_t max_cached_blocks_;
+  bool huge_pages_;
   size_t* space_allocated_;
 };
 
@@ -155,6 +298,7 @@ SerialArena::SerialArena(FirstSerialArena, ArenaBlock* b,
 
   set_ptr(b->Pointer(kBlockHeaderSize));
   limit_ = b->Limit();
+  prefetch_ptr_ = ptr();
 }
 
 std::vector<void*> SerialArena::PeekCleanupListForTesting() {
@@ -183,6 +327,7 @@ std::vector<void*> ThreadSafeArena::PeekCleanupListForTesting() {
 void SerialArena::Init(ArenaBlock* b, size_t offset) {
   set_ptr(b->Pointer(offset));
   limit_ = b->Limit();
+  prefetch_ptr_ = ptr();
   head_.store(b, std::memory_order_relaxed);
   space_used_.store(0, std::memory_order_relaxed);
   space_allocated_.store(b->size, std::memory_order_relaxed);
@@ -203,7 +348,11 @@ SerialArena* SerialArena::New(SizedPtr mem, ThreadSafeArena& parent) {
 
 template <typename Deallocator>
 SizedPtr SerialArena::Free(Deallocator deallocator) {
-  ArenaBlock* b = head();
+  return FreeBlocks(head(), deallocator);
+}
+
+template <typename Deallocator>
+SizedPtr SerialArena::FreeBlocks(ArenaBlock* b, Deallocator deallocator) {
   SizedPtr mem = {b, b->size};
   while (b->next) {
     b = b->next;  // We must first advance before deleting this block
@@ -229,15 +378,19 @@ void* SerialArena::AllocateFromStringBlockFallback() {
 
   void* ptr;
   StringBlock* new_sb;
-  size_t size = StringBlock::NextSize(sb);
+  const size_t initial_size = parent_.StringBlockInitialSize(this);
+  size_t size = StringBlock::NextSize(sb, initial_size);
   if (MaybeAllocateAligned(size, &ptr)) {
     // Correct space_used_ to avoid double counting
     AddSpaceUsed(-size);
     new_sb = StringBlock::Emplace(ptr, size, sb);
   } else {
-    new_sb = StringBlock::New(sb);
+    new_sb = StringBlock::New(sb, initial_size);
     AddSpaceAllocated(new_sb->allocated_size());
   }
+  ThreadSafeArenaStats::RecordStringBlockStats(
+      parent_.arena_stats_.MutableStats(),
+      /*allocated=*/new_sb->effective_size(), /*unused=*/0);
   string_block_.store(new_sb, std::memory_order_release);
   size_t unused = new_sb->effective_size() - sizeof(std::string);
   string_block_unused_.store(unused, std::memory_order_relaxed);
@@ -267,10 +420,14 @@ void SerialArena::AllocateNewBlock(size_t n) {
     // Sync limit to block
     old_head->cleanup_nodes = limit_;
 
-    // Record how much used in this block.
+    // Record how much used in this block.  The cleanup nodes at the tail of
+    // the block are not counted as wasted.
     used = static_cast<size_t>(ptr() - old_head->Pointer(kBlockHeaderSize));
-    wasted = old_head->size - used - kBlockHeaderSize;
+    size_t cleanup_bytes = static_cast<size_t>(old_head->Limit() - limit_);
+    wasted = old_head->size - used - kBlockHeaderSize - cleanup_bytes;
     AddSpaceUsed(used);
+    RecordCleanupNodes(parent_.arena_stats_.MutableStats(), limit_,
+                       old_head->Limit());
   }
 
   // TODO(sbenza): Evaluate if pushing unused space into the cached blocks is a
@@ -278,7 +435,8 @@ void SerialArena::AllocateNewBlock(size_t n) {
   // but with a CPU regression. The regression might have been an artifact of
   // the microbenchmark.
 
-  auto mem = AllocateMemory(parent_.AllocPolicy(), old_head->size, n);
+  auto mem = AllocateMemory(parent_.AllocPolicy(), old_head->size, n,
+                            parent_.arena_stats_.MutableStats());
   // We don't want to emit an expensive RMW instruction that requires
   // exclusive access to a cacheline. Hence we write it in terms of a
   // regular add.
@@ -289,6 +447,7 @@ void SerialArena::AllocateNewBlock(size_t n) {
   auto* new_head = new (mem.p) ArenaBlock{old_head, mem.n};
   set_ptr(new_head->Pointer(kBlockHeaderSize));
   limit_ = new_head->Limit();
+  prefetch_ptr_ = ptr();
   // Previous writes must take effect before writing new head.
   head_.store(new_head, std::memory_order_release);
 
@@ -323,6 +482,17 @@ uint64_t SerialArena::SpaceUsed() const {
   return space_used + space_used_.load(std::memory_order_relaxed);
 }
 
+size_t SerialArena::StringBlockBytesUsed() const {
+  const StringBlock* sb = string_block_.load(std::memory_order_relaxed);
+  if (sb == nullptr) return 0;
+  size_t used = sb->effective_size() -
+                string_block_unused_.load(std::memory_order_relaxed);
+  for (sb = sb->next(); sb != nullptr; sb = sb->next()) {
+    used += sb->effective_size();
+  }
+  return used;
+}
+
 size_t SerialArena::FreeStringBlocks(StringBlock* string_block,
                                      size_t unused_bytes) {
   ABSL_DCHECK(string_block != nullptr);
@@ -348,6 +518,17 @@ void SerialArena::CleanupList() {
   if (b->IsSentry()) return;
 
   b->cleanup_nodes = limit_;
+  // Blocks before the head were recorded in `AllocateNewBlock`.
+  ThreadSafeArenaStats* stats = parent_.arena_stats_.MutableStats();
+  RecordCleanupNodes(stats, limit_, b->Limit());
+  ThreadSafeArenaStats::RecordStringBlockStats(
+      stats, /*allocated=*/0,
+      /*unused=*/string_block_unused_.load(std::memory_order_relaxed));
+  CleanupBlocks(b);
+}
+
+void SerialArena::CleanupBlocks(ArenaBlock* b) {
+  if (b->IsSentry()) return;
   do {
     char* limit = b->Limit();
     char* it = reinterpret_cast<char*>(b->cleanup_nodes);
@@ -599,6 +780,7 @@ void ThreadSafeArena::InitializeWithPolicy(const AllocationPolicy& policy) {
   // Low bits store flags, so they mustn't be overwritten.
   ABSL_DCHECK_EQ(0u, reinterpret_cast<uintptr_t>(p) & 3);
   alloc_policy_.set_policy(reinterpret_cast<AllocationPolicy*>(p));
+  alloc_policy_.set_is_single_threaded(policy.single_threaded);
   ABSL_DCHECK_POLICY_FLAGS_();
 
 #undef ABSL_DCHECK_POLICY_FLAGS_
@@ -650,11 +832,11 @@ ThreadSafeArena::SerialArenaChunk* ThreadSafeArena::NewSerialArenaChunk(
 
 // Tries to reserve an entry by atomic fetch_add. If the head chunk is already
 // full (size >= capacity), acquires the mutex and adds a new head.
-void ThreadSafeArena::AddSerialArena(void* id, SerialArena* serial) {
+bool ThreadSafeArena::AddSerialArena(void* id, SerialArena* serial) {
   SerialArenaChunk* head = head_.load(std::memory_order_acquire);
   // Fast path without acquiring mutex.
   if (!head->IsSentry() && head->insert(id, serial)) {
-    return;
+    return false;
   }
 
   // Slow path with acquiring mutex.
@@ -663,7 +845,7 @@ void ThreadSafeArena::AddSerialArena(void* id, SerialArena* serial) {
   // Refetch and if someone else installed a new head, try allocating on that!
   SerialArenaChunk* new_head = head_.load(std::memory_order_acquire);
   if (new_head != head) {
-    if (new_head->insert(id, serial)) return;
+    if (new_head->insert(id, serial)) return false;
     // Update head to link to the latest one.
     head = new_head;
   }
@@ -674,6 +856,7 @@ void ThreadSafeArena::AddSerialArena(void* id, SerialArena* serial) {
   // Use "std::memory_order_release" to make sure prior stores are visible after
   // this one.
   head_.store(new_head, std::memory_order_release);
+  return true;
 }
 
 void ThreadSafeArena::Init() {
@@ -693,7 +876,150 @@ void ThreadSafeArena::Init() {
   CacheSerialArena(&first_arena_);
 }
 
+// State needed to run the destructors and release the blocks of an arena after
+// the ThreadSafeArena itself is gone.
+struct ThreadSafeArena::DeferredCleanup {
+  SerialArenaChunk* chunks;
+  // Head block of the first SerialArena, with its cleanup nodes synced.
+  ArenaBlock* first_head;
+  StringBlock* first_string_block;
+  size_t first_string_block_unused;
+  const AllocationPolicy* policy;
+};
+
+ThreadSafeArena::DeferredCleanup* ThreadSafeArena::NewDeferredCleanup() {
+  ABSL_DCHECK(!alloc_policy_.is_user_owned_initial_block());
+  // The first arena is embedded in this object, so capture what is needed to
+  // clean it up.
+  ArenaBlock* first_head = first_arena_.head();
+  if (!first_head->IsSentry()) first_head->cleanup_nodes = first_arena_.limit_;
+  return new DeferredCleanup{
+      head_.load(std::memory_order_relaxed), first_head,
+      first_arena_.string_block_.load(std::memory_order_relaxed),
+      first_arena_.string_block_unused_.load(std::memory_order_relaxed),
+      alloc_policy_.get()};
+}
+
+void ThreadSafeArena::RunDeferredDestructors(DeferredCleanup* cleanup) {
+  // Same order as the destructor: the first arena is cleaned up last.
+  // (b/247560530)
+  CleanupSerialArenas(cleanup->chunks);
+  SerialArena::CleanupBlocks(cleanup->first_head);
+}
+
+void ThreadSafeArena::FreeDeferred(DeferredCleanup* cleanup) {
+  size_t space_allocated = 0;
+  // The policy lives in the first block, so copy it out before freeing.
+  auto deallocator = GetDeallocator(cleanup->policy, &space_allocated);
+  FreeSerialArenas(cleanup->chunks, deallocator, &space_allocated);
+  if (cleanup->first_string_block != nullptr) {
+    SerialArena::FreeStringBlocks(cleanup->first_string_block,
+                                  cleanup->first_string_block_unused);
+  }
+  SizedPtr mem = SerialArena::FreeBlocks(cleanup->first_head, deallocator);
+  if (mem.n > 0) deallocator(mem);
+  delete cleanup;
+}
+
+void ThreadSafeArena::RunDeferredCleanup(void* arg) {
+  DeferredCleanup* cleanup = static_cast<DeferredCleanup*>(arg);
+  // All destructors run before any memory is released.
+  RunDeferredDestructors(cleanup);
+  FreeDeferred(cleanup);
+}
+
+// Arenas whose lifetimes have been joined by Fuse(). Destroying a member that
+// is not the last one only moves its contents into `retired`.
+struct ThreadSafeArena::FuseGroup {
+  uint64_t id;
+  std::vector<ThreadSafeArena*> members;
+  std::vector<DeferredCleanup*> retired;
+};
+
+namespace {
+// Guards every FuseGroup and ThreadSafeArena::fuse_group_. Fusing is rare, so
+// a single mutex is enough.
+ABSL_CONST_INIT absl::Mutex fuse_mutex(absl::kConstInit);
+uint64_t next_fuse_id ABSL_GUARDED_BY(fuse_mutex) = 1;
+}  // namespace
+
+bool ThreadSafeArena::Fuse(ThreadSafeArena* a, ThreadSafeArena* b) {
+  if (a == b) return true;
+  // A user-owned initial block is released by its owner when the arena is
+  // destroyed, which a fused arena can't defer.
+  if (a->alloc_policy_.is_user_owned_initial_block() ||
+      b->alloc_policy_.is_user_owned_initial_block()) {
+    return false;
+  }
+
+  absl::MutexLock lock(&fuse_mutex);
+  FuseGroup* group = a->fuse_group_;
+  FuseGroup* other = b->fuse_group_;
+  if (group != nullptr && group == other) return true;
+  // Merge the smaller group into the larger one.
+  if (group == nullptr ||
+      (other != nullptr && other->members.size() > group->members.size())) {
+    std::swap(a, b);
+    std::swap(group, other);
+  }
+  if (group == nullptr) {
+    group = new FuseGroup{next_fuse_id++, {a}, {}};
+    a->fuse_group_ = group;
+    a->fuse_id_.store(group->id, std::memory_order_release);
+  }
+  auto join = [group](ThreadSafeArena* arena) {
+    group->members.push_back(arena);
+    arena->fuse_group_ = group;
+    arena->fuse_id_.store(group->id, std::memory_order_release);
+  };
+  if (other == nullptr) {
+    join(b);
+  } else {
+    for (ThreadSafeArena* arena : other->members) join(arena);
+    group->retired.insert(group->retired.end(), other->retired.begin(),
+                          other->retired.end());
+    delete other;
+  }
+  return true;
+}
+
+bool ThreadSafeArena::LeaveFuseGroup(std::vector<DeferredCleanup*>* retired) {
+  absl::MutexLock lock(&fuse_mutex);
+  FuseGroup* group = fuse_group_;
+  group->members.erase(
+      std::find(group->members.begin(), group->members.end(), this));
+  if (!group->members.empty()) {
+    group->retired.push_back(NewDeferredCleanup());
+    return true;
+  }
+  *retired = std::move(group->retired);
+  delete group;
+  return false;
+}
+
 ThreadSafeArena::~ThreadSafeArena() {
+  if (fuse_id_.load(std::memory_order_acquire) != 0) {
+    std::vector<DeferredCleanup*> retired;
+    if (LeaveFuseGroup(&retired)) return;
+    // This is the last arena of its group. Objects may refer to memory of any
+    // arena in the group, so run every destructor before freeing anything.
+    CleanupList();
+    for (DeferredCleanup* cleanup : retired) RunDeferredDestructors(cleanup);
+    for (DeferredCleanup* cleanup : retired) FreeDeferred(cleanup);
+    size_t space_allocated = 0;
+    auto mem = Free(&space_allocated);
+    if (mem.n > 0) GetDeallocator(alloc_policy_.get(), &space_allocated)(mem);
+    return;
+  }
+
+  const AllocationPolicy* policy = alloc_policy_.get();
+  if (policy != nullptr && policy->cleanup_executor != nullptr &&
+      !alloc_policy_.is_user_owned_initial_block()) {
+    // Hand everything over to the executor.
+    policy->cleanup_executor(&RunDeferredCleanup, NewDeferredCleanup());
+    return;
+  }
+
   // Have to do this in a first pass, because some of the destructors might
   // refer to memory in other blocks.
   CleanupList();
@@ -711,10 +1037,11 @@ ThreadSafeArena::~ThreadSafeArena() {
   }
 }
 
-SizedPtr ThreadSafeArena::Free(size_t* space_allocated) {
-  auto deallocator = GetDeallocator(alloc_policy_.get(), space_allocated);
-
-  WalkSerialArenaChunk([&](SerialArenaChunk* chunk) {
+template <typename Deallocator>
+void ThreadSafeArena::FreeSerialArenas(SerialArenaChunk* chunk,
+                                       Deallocator deallocator,
+                                       size_t* space_allocated) {
+  WalkSerialArenaChunk(chunk, [&](SerialArenaChunk* chunk) {
     absl::Span<std::atomic<SerialArena*>> span = chunk->arenas();
     // Walks arenas backward to handle the first serial arena the last. Freeing
     // in reverse-order to the order in which objects were created may not be
@@ -734,34 +1061,104 @@ SizedPtr ThreadSafeArena::Free(size_t* space_allocated) {
     internal::SizedDelete(chunk,
                           SerialArenaChunk::AllocSize(chunk->capacity()));
   });
+}
+
+SizedPtr ThreadSafeArena::Free(size_t* space_allocated,
+                               const ArenaBlock* retained) {
+  auto deallocator = GetDeallocator(alloc_policy_.get(), space_allocated);
+
+  // By omitting an Acquire barrier we help the sanitizer that any user code
+  // that doesn't properly synchronize Reset() or the destructor will throw a
+  // TSAN warning.
+  FreeSerialArenas(head_.load(std::memory_order_relaxed), deallocator,
+                   space_allocated);
 
   // The first block of the first arena is special and let the caller handle it.
   *space_allocated += first_arena_.FreeStringBlocks();
-  return first_arena_.Free(deallocator);
+  if (retained == nullptr) return first_arena_.Free(deallocator);
+  return first_arena_.Free([&](SizedPtr mem) {
+    if (mem.p == retained) {
+      *space_allocated += mem.n;
+    } else {
+      deallocator(mem);
+    }
+  });
+}
+
+ArenaBlock* ThreadSafeArena::FindRetainableBlock(size_t max_bytes) {
+  ArenaBlock* best = nullptr;
+  // The last block in the list is either the sentry or the first block, which
+  // Reset() keeps anyway. Retaining a block no bigger than that is pointless.
+  ArenaBlock* b = first_arena_.head();
+  for (; b->next != nullptr; b = b->next) {
+    if (b->size <= max_bytes && (best == nullptr || b->size > best->size)) {
+      best = b;
+    }
+  }
+  if (best != nullptr && best->size <= b->size) return nullptr;
+  return best;
 }
 
-uint64_t ThreadSafeArena::Reset() {
+uint64_t ThreadSafeArena::Reset() { return ResetRetainingBlock(0); }
+
+uint64_t ThreadSafeArena::ResetRetainingBlock(size_t max_retained_bytes) {
+  ABSL_DCHECK_EQ(fuse_id_.load(std::memory_order_relaxed), 0u)
+      << "Fused arenas can't be reset.";
   // Have to do this in a first pass, because some of the destructors might
   // refer to memory in other blocks.
   CleanupList();
 
+  // Size the first string block of the next lifecycle for the strings of
+  // this one, so that string-heavy arenas don't regrow from the smallest
+  // block on every reuse and string-light ones shrink back.
+  string_block_size_hint_ = static_cast<uint32_t>(StringBlock::SizeForStrings(
+      first_arena_.StringBlockBytesUsed() / sizeof(std::string)));
+
+  ArenaBlock* retained = max_retained_bytes > 0
+                             ? FindRetainableBlock(max_retained_bytes)
+                             : nullptr;
+  size_t retained_size = retained != nullptr ? retained->size : 0;
+
   // Discard all blocks except the first one. Whether it is user-provided or
   // allocated, always reuse the first block for the first arena.
   size_t space_allocated = 0;
-  auto mem = Free(&space_allocated);
+  auto mem = Free(&space_allocated, retained);
   space_allocated += mem.n;
 
   // Reset the first arena with the first block. This avoids redundant
   // free / allocation and re-allocating for AllocationPolicy. Adjust offset if
   // we need to preserve alloc_policy_.
+  ArenaBlock* first;
+  size_t offset;
   if (alloc_policy_.is_user_owned_initial_block() ||
       alloc_policy_.get() != nullptr) {
-    size_t offset = alloc_policy_.get() == nullptr
-                        ? kBlockHeaderSize
-                        : kBlockHeaderSize + kAllocPolicySize;
-    first_arena_.Init(new (mem.p) ArenaBlock{nullptr, mem.n}, offset);
+    offset = alloc_policy_.get() == nullptr
+                 ? kBlockHeaderSize
+                 : kBlockHeaderSize + kAllocPolicySize;
+    first = new (mem.p) ArenaBlock{nullptr, mem.n};
+  } else {
+    offset = 0;
+    first = SentryArenaBlock();
+  }
+
+  if (retained != nullptr) {
+    // Allocate from the retained block and keep the first block behind it so
+    // that it is still released (or returned to the user) on destruction.
+    // Whatever the first block holds (e.g. alloc_policy_) counts as used.
+    if (!first->IsSentry()) first->cleanup_nodes = first->Limit();
+    first_arena_.Init(new (retained) ArenaBlock{first, retained_size},
+                      kBlockHeaderSize);
+    first_arena_.AddSpaceAllocated(first->size);
+    if (offset > kBlockHeaderSize) {
+      first_arena_.AddSpaceUsed(offset - kBlockHeaderSize);
+    }
+#ifdef ADDRESS_SANITIZER
+    ASAN_POISON_MEMORY_REGION(retained->Pointer(kBlockHeaderSize),
+                              retained->Limit() -
+                                  retained->Pointer(kBlockHeaderSize));
+#endif  // ADDRESS_SANITIZER
   } else {
-    first_arena_.Init(SentryArenaBlock(), 0);
+    first_arena_.Init(first, offset);
   }
 
   // Since the first block and potential alloc_policy on the first block is
@@ -805,6 +1202,16 @@ void* ThreadSafeArena::AllocateFromStringBlock() {
   return GetSerialArena()->AllocateFromStringBlock();
 }
 
+size_t ThreadSafeArena::StringBlockInitialSize(
+    const SerialArena* serial) const {
+  size_t size = serial == &first_arena_ ? string_block_size_hint_ : 0;
+  if (const AllocationPolicy* policy = AllocPolicy()) {
+    size = std::max(size,
+                    StringBlock::SizeForStrings(policy->expected_string_count));
+  }
+  return StringBlock::NextSize(nullptr, size);
+}
+
 template <typename Functor>
 void ThreadSafeArena::WalkConstSerialArenaChunk(Functor fn) const {
   const SerialArenaChunk* chunk = head_.load(std::memory_order_acquire);
@@ -815,12 +1222,8 @@ void ThreadSafeArena::WalkConstSerialArenaChunk(Functor fn) const {
 }
 
 template <typename Functor>
-void ThreadSafeArena::WalkSerialArenaChunk(Functor fn) {
-  // By omitting an Acquire barrier we help the sanitizer that any user code
-  // that doesn't properly synchronize Reset() or the destructor will throw a
-  // TSAN warning.
-  SerialArenaChunk* chunk = head_.load(std::memory_order_relaxed);
-
+void ThreadSafeArena::WalkSerialArenaChunk(SerialArenaChunk* chunk,
+                                           Functor fn) {
   while (!chunk->IsSentry()) {
     // Cache next chunk in case this chunk is destroyed.
     SerialArenaChunk* next_chunk = chunk->next_chunk();
@@ -873,7 +1276,16 @@ template void*
     ThreadSafeArena::AllocateAlignedFallback<AllocationClient::kArray>(size_t);
 
 void ThreadSafeArena::CleanupList() {
-  WalkSerialArenaChunk([](SerialArenaChunk* chunk) {
+  // By omitting an Acquire barrier we help the sanitizer that any user code
+  // that doesn't properly synchronize Reset() or the destructor will throw a
+  // TSAN warning.
+  CleanupSerialArenas(head_.load(std::memory_order_relaxed));
+  // First arena must be cleaned up last. (b/247560530)
+  first_arena_.CleanupList();
+}
+
+void ThreadSafeArena::CleanupSerialArenas(SerialArenaChunk* chunk) {
+  WalkSerialArenaChunk(chunk, [](SerialArenaChunk* chunk) {
     absl::Span<std::atomic<SerialArena*>> span = chunk->arenas();
     // Walks arenas backward to handle the first serial arena the last.
     // Destroying in reverse-order to the construction is often assumed by users
@@ -884,14 +1296,14 @@ void ThreadSafeArena::CleanupList() {
       serial->CleanupList();
     }
   });
-  // First arena must be cleaned up last. (b/247560530)
-  first_arena_.CleanupList();
 }
 
 PROTOBUF_NOINLINE
 SerialArena* ThreadSafeArena::GetSerialArenaFallback(size_t n) {
   void* const id = &thread_cache();
   if (id == first_owner_) {
+    ThreadSafeArenaStats::RecordSerialArenaLookupStats(
+        arena_stats_.MutableStats(), /*created=*/false, /*grew_chunks=*/false);
     CacheSerialArena(&first_arena_);
     return &first_arena_;
   }
@@ -909,15 +1321,21 @@ SerialArena* ThreadSafeArena::GetSerialArenaFallback(size_t n) {
     }
   });
 
-  if (!serial) {
+  const bool created = serial == nullptr;
+  bool grew_chunks = false;
+  if (created) {
     // This thread doesn't have any SerialArena, which also means it doesn't
     // have any blocks yet.  So we'll allocate its first block now. It must be
     // big enough to host SerialArena and the pending request.
     serial = SerialArena::New(
-        AllocateMemory(alloc_policy_.get(), 0, n + kSerialArenaSize), *this);
+        AllocateMemory(alloc_policy_.get(), 0, n + kSerialArenaSize,
+                       arena_stats_.MutableStats()),
+        *this);
 
-    AddSerialArena(id, serial);
+    grew_chunks = AddSerialArena(id, serial);
   }
+  ThreadSafeArenaStats::RecordSerialArenaLookupStats(
+      arena_stats_.MutableStats(), created, grew_chunks);
 
   CacheSerialArena(serial);
   return serial;
@@ -34,6 +34,7 @@
 #define GOOGLE_PROTOBUF_ARENA_H__
 
 #include <limits>
+#include <memory>
 #include <string>
 #include <type_traits>
 #include <utility>
@@ -50,6 +51,7 @@ using type_info = ::type_info;
 #endif
 
 #include "absl/meta/type_traits.h"
+#include "absl/strings/string_view.h"
 #include "google/protobuf/arena_align.h"
 #include "google/protobuf/port.h"
 #include "google/protobuf/serial_arena.h"
@@ -69,8 +71,11 @@ struct ArenaOptions;  // defined below
 class Arena;    // defined below
 class Message;  // defined in message.h
 class MessageLite;
+class StringInterner;  // defined in string_interner.h
 template <typename Key, typename T>
 class Map;
+template <typename T>
+class ArenaAllocator;  // defined below
 
 namespace arena_metrics {
 
@@ -144,6 +149,59 @@ struct ArenaOptions {
   // calls free.
   void (*block_dealloc)(void*, size_t) = nullptr;
 
+  // The maximum number of freed blocks that each thread keeps for reuse by
+  // subsequent arenas created with this option on that thread. This avoids
+  // returning blocks to the system allocator when arenas are short-lived, at
+  // the cost of retaining up to this many blocks per thread. Ignored when
+  // custom block_alloc or block_dealloc functions are provided. Zero (the
+  // default) disables caching.
+  size_t max_thread_cached_blocks = 0;
+
+  // A function that runs `task(arg)`, possibly later and on another thread.
+  // If provided, destroying the arena only hands the work of running the
+  // destructors of its objects and releasing its blocks to this function, so
+  // that it can be done off the critical path, e.g. by a background thread.
+  // `task` must be run exactly once. The arena's objects must not be accessed
+  // after the arena is destroyed, and `block_dealloc` must remain usable until
+  // `task` completes. Not used when `initial_block` is provided, since the
+  // user may reuse that block as soon as the arena is destroyed. Reset() is
+  // always performed inline.
+  internal::Executor cleanup_executor = nullptr;
+
+  // If true, blocks of at least 2MiB (which requires raising max_block_size,
+  // or large individual allocations) are backed by transparent huge pages on
+  // platforms that support them, reducing TLB misses for large messages.
+  // Blocks are first touched by the thread that owns them, so on NUMA systems
+  // the kernel places them on that thread's node under the default memory
+  // policy. Ignored when custom block_alloc or block_dealloc functions are
+  // provided.
+  bool use_huge_pages = false;
+
+  // A dictionary of strings, such as host names or country codes, that recur
+  // across messages.  When a singular string field of a message on this arena
+  // is parsed and its value is in the dictionary, the field refers to the
+  // dictionary's copy instead of allocating its own.  Such a field is copied
+  // on its first mutation.  The dictionary is not owned, and must outlive the
+  // arena and every message on it.  It may be shared by any number of arenas.
+  const StringInterner* string_interner = nullptr;
+
+  // If true, the arena is only ever used by one thread at a time, so every
+  // allocation goes straight to its first block list instead of looking up
+  // the calling thread's SerialArena in thread-local storage. The arena may
+  // still be handed from one thread to another, as long as each hand-off
+  // synchronizes like a mutex would. Using it from two threads concurrently
+  // is undefined behavior.
+  bool single_threaded = false;
+
+  // A hint for the number of strings (e.g. string fields of messages) that
+  // will be allocated on the arena. Strings are carved out of dedicated
+  // blocks that start small and double in size; with a hint the first block
+  // is sized to hold that many strings (up to 8KB), saving several small
+  // block allocations for string-heavy arenas. Independently of this hint, an
+  // arena that is Reset() sizes its first string block from the number of
+  // strings allocated before the reset. Zero (the default) gives no hint.
+  size_t expected_string_count = 0;
+
  private:
   internal::AllocationPolicy AllocationPolicy() const {
     internal::AllocationPolicy res;
@@ -151,6 +209,12 @@ struct ArenaOptions {
     res.max_block_size = max_block_size;
     res.block_alloc = block_alloc;
     res.block_dealloc = block_dealloc;
+    res.max_thread_cached_blocks = max_thread_cached_blocks;
+    res.cleanup_executor = cleanup_executor;
+    res.use_huge_pages = use_huge_pages;
+    res.string_interner = string_interner;
+    res.single_threaded = single_threaded;
+    res.expected_string_count = expected_string_count;
     return res;
   }
 
@@ -350,6 +414,40 @@ class PROTOBUF_EXPORT PROTOBUF_ALIGNAS(8) Arena final {
   // of the allocated blocks. This method is not thread-safe.
   uint64_t Reset() { return impl_.Reset(); }
 
+  // Like Reset(), but keeps one already-allocated block of at most
+  // |max_retained_bytes| (the largest one that fits) and reuses it after the
+  // reset. An arena that is reset in a loop with a steady workload then stops
+  // requesting memory from the system once its blocks have grown large enough.
+  // Returns the same value as Reset(). This method is not thread-safe.
+  uint64_t ResetRetainingBlock(size_t max_retained_bytes) {
+    return impl_.ResetRetainingBlock(max_retained_bytes);
+  }
+
+  // Fuses the lifetimes of |a| and |b|, together with any arenas either of
+  // them was already fused with: from then on, the memory and registered
+  // destructors of every arena in the group are only released once all of
+  // them have been destroyed. This lets sub-messages move between messages on
+  // fused arenas without a deep copy: set_allocated_*(), AddAllocated() and
+  // the corresponding Reflection methods adopt a message from a fused arena
+  // as they would one from the same arena. Swap() between messages on
+  // different arenas still copies.
+  //
+  // Returns false, and fuses nothing, if either arena was constructed with a
+  // user-provided initial block, since that block is returned to its owner
+  // when the arena is destroyed. The destructor of the last arena of a group
+  // cleans up the whole group on the calling thread, without using
+  // ArenaOptions::cleanup_executor. Fused arenas must not be Reset(). This
+  // method is thread-safe.
+  static bool Fuse(Arena* a, Arena* b) {
+    return internal::ThreadSafeArena::Fuse(&a->impl_, &b->impl_);
+  }
+
+  // Returns true if |a| and |b| are the same arena or have been fused. Fusing
+  // that happens concurrently with this call may not be observed.
+  static bool IsFused(const Arena* a, const Arena* b) {
+    return a != nullptr && b != nullptr && a->impl_.IsFusedWith(b->impl_);
+  }
+
   // Adds |object| to a list of heap-allocated objects to be freed with |delete|
   // when the arena is destroyed or reset.
   template <typename T>
@@ -433,6 +531,20 @@ class PROTOBUF_EXPORT PROTOBUF_ALIGNAS(8) Arena final {
 
     static void InternalSwap(T* a, T* b) { a->InternalSwap(b); }
 
+    // Returns the full name of generated message types, and an empty string
+    // for any other arena constructable type.
+    static absl::string_view TypeName() { return TypeName<T>(Rank0{}); }
+
+    template <typename U>
+    static auto TypeName(Rank0) -> decltype(U::FullMessageName()) {
+      return U::FullMessageName();
+    }
+
+    template <typename U>
+    static absl::string_view TypeName(Rank1) {
+      return absl::string_view();
+    }
+
     static Arena* GetArenaForAllocation(T* p) {
       return GetArenaForAllocation(Rank0{}, p);
     }
@@ -536,6 +648,16 @@ class PROTOBUF_EXPORT PROTOBUF_ALIGNAS(8) Arena final {
     impl_.ReturnArrayMemory(p, size);
   }
 
+  // Grows an array of `old_size` bytes previously returned by CreateArray()
+  // to `new_size` bytes without moving it, if it is still the most recent
+  // allocation on the calling thread and the current block has room. Returns
+  // false, leaving the array untouched, otherwise.
+  bool TryExtendArrayInPlace(void* p, size_t old_size, size_t new_size) {
+    return impl_.TryExtendArrayInPlace(
+        p, internal::ArenaAlignDefault::Ceil(old_size),
+        internal::ArenaAlignDefault::Ceil(new_size));
+  }
+
   template <typename T, typename... Args>
   PROTOBUF_NDEBUG_INLINE static T* CreateMessageInternal(Arena* arena,
                                                          Args&&... args) {
@@ -606,6 +728,9 @@ class PROTOBUF_EXPORT PROTOBUF_ALIGNAS(8) Arena final {
 
   template <typename T, typename... Args>
   PROTOBUF_NDEBUG_INLINE T* DoCreateMessage(Args&&... args) {
+#if defined(PROTOBUF_ARENAZ_SAMPLE)
+    impl_.RecordMessageAllocation(InternalHelper<T>::TypeName(), sizeof(T));
+#endif  // defined(PROTOBUF_ARENAZ_SAMPLE)
     return InternalHelper<T>::Construct(
         AllocateInternal<T, is_destructor_skippable<T>::value>(), this,
         std::forward<Args>(args)...);
@@ -651,6 +776,10 @@ class PROTOBUF_EXPORT PROTOBUF_ALIGNAS(8) Arena final {
     return InternalHelper<T>::GetArena(value);
   }
 
+  const StringInterner* string_interner() const {
+    return impl_.string_interner();
+  }
+
   void* AllocateAlignedForArray(size_t n, size_t align) {
     if (align <= internal::ArenaAlignDefault::align) {
       return AllocateForArray(internal::ArenaAlignDefault::Ceil(n));
@@ -689,6 +818,8 @@ class PROTOBUF_EXPORT PROTOBUF_ALIGNAS(8) Arena final {
   friend class Map;
   template <typename>
   friend class RepeatedField;                   // For ReturnArrayMemory
+  template <typename>
+  friend class ArenaAllocator;  // For ReturnArrayMemory
   friend class internal::RepeatedPtrFieldBase;  // For ReturnArrayMemory
   friend struct internal::ArenaTestPeer;
 };
@@ -698,6 +829,65 @@ inline void* Arena::AllocateInternal<std::string, false>() {
   return impl_.AllocateFromStringBlock();
 }
 
+// An allocator for standard containers, such as std::vector or
+// absl::flat_hash_map, that places their storage on an arena, so that data
+// kept next to arena-allocated messages is freed in bulk with them:
+//
+//   std::vector<int, ArenaAllocator<int>> ids{ArenaAllocator<int>(&arena)};
+//
+// Deallocated storage is kept by the arena and reused by later allocations of
+// a similar size on the same thread, as the storage of repeated fields is.
+// Containers must not outlive their arena, and containers on different arenas
+// must not be swapped. Like the arena, the allocator is thread-safe. A
+// default-constructed allocator, or one with a null arena, uses the heap.
+template <typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+
+  constexpr ArenaAllocator() noexcept = default;
+  explicit constexpr ArenaAllocator(Arena* arena) noexcept : arena_(arena) {}
+  template <typename U>
+  constexpr ArenaAllocator(  // NOLINT(google-explicit-constructor)
+      const ArenaAllocator<U>& other) noexcept
+      : arena_(other.arena()) {}
+
+  T* allocate(size_t n) {
+    if (arena_ == nullptr) return std::allocator<T>().allocate(n);
+    ABSL_CHECK_LE(n, std::numeric_limits<size_t>::max() / sizeof(T))
+        << "Requested size is too large to fit into size_t.";
+    return static_cast<T*>(
+        arena_->AllocateAlignedForArray(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T* p, size_t n) {
+    if (arena_ == nullptr) {
+      std::allocator<T>().deallocate(p, n);
+      return;
+    }
+    // Over-aligned allocations do not start at the memory the arena handed
+    // out, and the arena does not keep blocks under 16 bytes.
+    const size_t size = internal::ArenaAlignDefault::Ceil(n * sizeof(T));
+    if (alignof(T) <= internal::ArenaAlignDefault::align && size >= 16) {
+      arena_->ReturnArrayMemory(p, size);
+    }
+  }
+
+  Arena* arena() const { return arena_; }
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U>& other) const {
+    return arena_ == other.arena();
+  }
+  template <typename U>
+  bool operator!=(const ArenaAllocator<U>& other) const {
+    return arena_ != other.arena();
+  }
+
+ private:
+  Arena* arena_ = nullptr;
+};
+
 }  // namespace protobuf
 }  // namespace google
 
@@ -34,8 +34,13 @@
 #include <cstddef>
 #include <cstdint>
 
+#include "google/protobuf/port.h"
+
 namespace google {
 namespace protobuf {
+
+class StringInterner;  // string_interner.h
+
 namespace internal {
 
 // `AllocationPolicy` defines `Arena` allocation policies. Applications can
@@ -53,10 +58,51 @@ struct AllocationPolicy {
   void* (*block_alloc)(size_t) = nullptr;
   void (*block_dealloc)(void*, size_t) = nullptr;
 
+  // Maximum number of freed blocks kept in a per-thread cache for reuse by
+  // later arenas on the same thread. Zero disables the cache. Only applies to
+  // blocks obtained from the default allocator.
+  size_t max_thread_cached_blocks = 0;
+
+  // If set, the arena destructor hands the destruction of the arena's objects
+  // and the release of its memory to this function as `task(arg)`, instead of
+  // doing the work inline.
+  Executor cleanup_executor = nullptr;
+
+  // If true, blocks of at least kHugePageSize bytes are rounded up to a
+  // multiple of kHugePageSize and mapped with transparent huge pages where the
+  // platform supports it. Only applies to the default allocator.
+  bool use_huge_pages = false;
+
+  // If set, string fields parsed into messages on the arena share the
+  // matching strings of this dictionary instead of copying them.
+  const StringInterner* string_interner = nullptr;
+
+  // If true, all allocations use the first SerialArena without consulting the
+  // thread cache. The arena must not be used concurrently.
+  bool single_threaded = false;
+
+  // Expected number of arena strings, used to size the first string block.
+  // Zero uses the default size.
+  size_t expected_string_count = 0;
+
+  static constexpr size_t kHugePageSize = 2 << 20;
+
   bool IsDefault() const {
     return start_block_size == kDefaultStartBlockSize &&
            max_block_size == kDefaultMaxBlockSize && block_alloc == nullptr &&
-           block_dealloc == nullptr;
+           block_dealloc == nullptr && max_thread_cached_blocks == 0 &&
+           cleanup_executor == nullptr && !use_huge_pages &&
+           string_interner == nullptr && !single_threaded &&
+           expected_string_count == 0;
+  }
+
+  bool UsesThreadBlockCache() const {
+    return max_thread_cached_blocks != 0 && block_alloc == nullptr &&
+           block_dealloc == nullptr && !use_huge_pages;
+  }
+
+  bool UsesHugePages() const {
+    return use_huge_pages && block_alloc == nullptr && block_dealloc == nullptr;
   }
 };
 
@@ -93,11 +139,17 @@ class TaggedAllocationPolicyPtr {
     set_mask<kUserOwnedInitialBlock>(v);
   }
 
+  bool is_single_threaded() const {
+    return static_cast<bool>(get_mask<kSingleThreaded>());
+  }
+  void set_is_single_threaded(bool v) { set_mask<kSingleThreaded>(v); }
+
   uintptr_t get_raw() const { return policy_; }
 
  private:
   enum : uintptr_t {
     kUserOwnedInitialBlock = 1,
+    kSingleThreaded = 2,
   };
 
   static constexpr uintptr_t kTagsMask = 7;
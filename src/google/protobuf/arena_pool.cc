@@ -0,0 +1,155 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/arena_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/log/absl_check.h"
+#include "absl/synchronization/mutex.h"
+#include "google/protobuf/arena.h"
+#include "google/protobuf/port.h"
+#include "google/protobuf/serial_arena.h"
+#include "google/protobuf/thread_local_cache.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+
+// The arenas a thread released to one pool, the last one it released to.
+struct ArenaPool::ThreadArenas {
+  uint64_t pool_id;
+  size_t count;
+  Arena* arenas[kMaxArenasPerThread];
+
+  static void Clear(ThreadArenas& cache) {
+    while (cache.count > 0) delete cache.arenas[--cache.count];
+    cache.pool_id = 0;
+  }
+};
+
+namespace {
+std::atomic<uint64_t> next_pool_id{1};
+}  // namespace
+
+ArenaPool::ArenaPool(const ArenaPoolOptions& options)
+    : options_(options),
+      id_(next_pool_id.fetch_add(1, std::memory_order_relaxed)) {
+  ABSL_CHECK(options_.arena_options.initial_block == nullptr)
+      << "ArenaPool arenas cannot share an initial block.";
+  ABSL_CHECK_LE(options_.max_arenas_per_thread, kMaxArenasPerThread);
+  constexpr size_t kHeader = internal::SerialArena::kBlockHeaderSize;
+  absl::MutexLock lock(&mutex_);
+  shared_.reserve(options_.prewarmed_arenas);
+  for (size_t i = 0; i < options_.prewarmed_arenas; ++i) {
+    Arena* arena = NewArena();
+    if (options_.max_retained_bytes > kHeader) {
+      // Allocating all of a block's payload at once makes the arena allocate
+      // exactly that block, which the reset then retains.
+      Arena::CreateArray<char>(
+          arena, (options_.max_retained_bytes - kHeader) & ~size_t{7});
+      arena->ResetRetainingBlock(options_.max_retained_bytes);
+    }
+    shared_.push_back(arena);
+  }
+}
+
+ArenaPool::~ArenaPool() {
+  ThreadArenas& cache = internal::ThreadLocalCache<ThreadArenas>::Get();
+  if (cache.pool_id == id_) ThreadArenas::Clear(cache);
+  absl::MutexLock lock(&mutex_);
+  for (Arena* arena : shared_) delete arena;
+}
+
+Arena* ArenaPool::NewArena() const {
+  return new Arena(options_.arena_options);
+}
+
+Arena* ArenaPool::AcquireArena() {
+  ThreadArenas& cache = internal::ThreadLocalCache<ThreadArenas>::Get();
+  if (cache.pool_id == id_ && cache.count > 0) {
+    return cache.arenas[--cache.count];
+  }
+  {
+    absl::MutexLock lock(&mutex_);
+    if (!shared_.empty()) {
+      Arena* arena = shared_.back();
+      shared_.pop_back();
+      return arena;
+    }
+  }
+  return NewArena();
+}
+
+void ArenaPool::Release(Arena* arena) {
+  ABSL_DCHECK(arena != nullptr);
+  arena->ResetRetainingBlock(options_.max_retained_bytes);
+
+  ThreadArenas* cache =
+      options_.max_arenas_per_thread > 0
+          ? internal::ThreadLocalCache<ThreadArenas>::GetForInsert()
+          : nullptr;
+  if (cache != nullptr) {
+    if (cache->pool_id != id_) {
+      // Switching pools frees the arenas kept for the previous one, which
+      // may have been destroyed since.
+      ThreadArenas::Clear(*cache);
+      cache->pool_id = id_;
+    }
+    if (cache->count < options_.max_arenas_per_thread) {
+      cache->arenas[cache->count++] = arena;
+      return;
+    }
+  }
+
+  {
+    absl::MutexLock lock(&mutex_);
+    if (shared_.size() < options_.max_shared_arenas) {
+      shared_.push_back(arena);
+      return;
+    }
+  }
+  delete arena;
+}
+
+size_t ArenaPool::SharedArenaCount() const {
+  absl::MutexLock lock(&mutex_);
+  return shared_.size();
+}
+
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
@@ -0,0 +1,164 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file defines ArenaPool, which recycles whole Arenas.
+
+#ifndef GOOGLE_PROTOBUF_ARENA_POOL_H__
+#define GOOGLE_PROTOBUF_ARENA_POOL_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "google/protobuf/arena.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+
+struct ArenaPoolOptions {
+  // The options each arena of the pool is constructed with. `initial_block`
+  // must not be set, since a block cannot be shared by several arenas.
+  ArenaOptions arena_options;
+
+  // Each released arena keeps one block of at most this many bytes, see
+  // Arena::ResetRetainingBlock(), so that it is acquired again with its
+  // memory already allocated.
+  size_t max_retained_bytes = 64 << 10;
+
+  // The number of released arenas each thread keeps for itself, at most
+  // ArenaPool::kMaxArenasPerThread. An arena reused by the thread that
+  // released it finds its blocks still in that thread's CPU caches.
+  size_t max_arenas_per_thread = 4;
+
+  // The number of released arenas kept for all threads together, beyond
+  // those kept per thread. Arenas released when this is reached are deleted.
+  size_t max_shared_arenas = 64;
+
+  // The number of arenas created, each with a block of max_retained_bytes,
+  // when the pool is constructed.
+  size_t prewarmed_arenas = 0;
+};
+
+// A pool of Arenas for request-scoped allocation, e.g. one arena per RPC.
+// Acquire() returns an arena that was released before whenever there is one,
+// which saves constructing the Arena and allocating its first block:
+//
+//   ArenaPool pool;
+//   ...
+//   ArenaPool::Lease arena = pool.Acquire();
+//   auto* request = Arena::CreateMessage<MyRequest>(arena.get());
+//   ...  // `arena` is reset and returned to the pool when it goes away.
+//
+// Released arenas are kept by the releasing thread first, then in a list
+// shared by all threads. ArenaPool is thread-safe, and a lease may be released
+// on another thread than the one that acquired it. Arenas kept by other
+// threads than the one destroying the pool are deleted when those threads
+// exit or use another pool.
+class PROTOBUF_EXPORT ArenaPool {
+ public:
+  static constexpr size_t kMaxArenasPerThread = 8;
+
+  // Owns an arena of the pool, and returns it to the pool on destruction.
+  class Lease {
+   public:
+    Lease() = default;
+    Lease(Lease&& other) noexcept : pool_(other.pool_), arena_(other.arena_) {
+      other.arena_ = nullptr;
+    }
+    Lease& operator=(Lease&& other) noexcept {
+      if (this != &other) {
+        Reset();
+        pool_ = other.pool_;
+        arena_ = other.arena_;
+        other.arena_ = nullptr;
+      }
+      return *this;
+    }
+    ~Lease() { Reset(); }
+
+    Arena* get() const { return arena_; }
+    Arena* operator->() const { return arena_; }
+    Arena& operator*() const { return *arena_; }
+
+    // Returns the arena to the pool early.
+    void Reset() {
+      if (arena_ != nullptr) pool_->Release(arena_);
+      arena_ = nullptr;
+    }
+
+   private:
+    friend class ArenaPool;
+    Lease(ArenaPool* pool, Arena* arena) : pool_(pool), arena_(arena) {}
+
+    ArenaPool* pool_ = nullptr;
+    Arena* arena_ = nullptr;
+  };
+
+  ArenaPool() : ArenaPool(ArenaPoolOptions()) {}
+  explicit ArenaPool(const ArenaPoolOptions& options);
+  ArenaPool(const ArenaPool&) = delete;
+  ArenaPool& operator=(const ArenaPool&) = delete;
+  // All leases must have been released.
+  ~ArenaPool();
+
+  Lease Acquire() { return Lease(this, AcquireArena()); }
+
+  // Like Acquire(), for callers that manage the arena's lifetime themselves:
+  // the arena must be passed to Release() exactly once. It must not be
+  // deleted, nor fused with another arena.
+  Arena* AcquireArena();
+  void Release(Arena* arena);
+
+  // The number of released arenas in the shared list.
+  size_t SharedArenaCount() const;
+
+ private:
+  struct ThreadArenas;
+
+  Arena* NewArena() const;
+
+  const ArenaPoolOptions options_;
+  // Identifies the pool in per-thread caches, which may outlive it.
+  const uint64_t id_;
+  mutable absl::Mutex mutex_;
+  std::vector<Arena*> shared_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_ARENA_POOL_H__
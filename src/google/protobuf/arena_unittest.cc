@@ -44,9 +44,11 @@
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include "absl/container/flat_hash_map.h"
 #include "absl/log/absl_check.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/barrier.h"
+#include "google/protobuf/arena_pool.h"
 #include "google/protobuf/arena_test_util.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/extension_set.h"
@@ -56,6 +58,7 @@
 #include "google/protobuf/message_lite.h"
 #include "google/protobuf/port.h"
 #include "google/protobuf/repeated_field.h"
+#include "google/protobuf/string_interner.h"
 #include "google/protobuf/test_util.h"
 #include "google/protobuf/unittest.pb.h"
 #include "google/protobuf/unittest_arena.pb.h"
@@ -317,6 +320,485 @@ TEST(ArenaTest, InitialBlockTooSmall) {
   }
 }
 
+TEST(ArenaTest, ThreadBlockCacheReusesBlocks) {
+  ArenaOptions options;
+  options.max_thread_cached_blocks = 4;
+
+  char* first;
+  {
+    Arena arena(options);
+    first = Arena::CreateArray<char>(&arena, 64);
+  }
+  // The block released by the previous arena is reused by the next one.
+  {
+    Arena arena(options);
+    EXPECT_EQ(first, Arena::CreateArray<char>(&arena, 64));
+  }
+
+  // Arenas that need larger blocks than the cached ones still work.
+  {
+    Arena arena(options);
+    char* p = Arena::CreateArray<char>(&arena, 64 << 10);
+    memset(p, 0, 64 << 10);
+  }
+}
+
+namespace {
+
+std::atomic<int> counted_block_allocs{0};
+std::atomic<int> counted_block_deallocs{0};
+
+void* CountingBlockAlloc(size_t size) {
+  counted_block_allocs.fetch_add(1, std::memory_order_relaxed);
+  return ::operator new(size);
+}
+
+void CountingBlockDealloc(void* p, size_t size) {
+  counted_block_deallocs.fetch_add(1, std::memory_order_relaxed);
+  internal::SizedDelete(p, size);
+}
+
+}  // namespace
+
+TEST(ArenaTest, ThreadBlockCacheIgnoresCustomAllocator) {
+  ArenaOptions options;
+  options.max_thread_cached_blocks = 4;
+  options.block_alloc = &CountingBlockAlloc;
+  options.block_dealloc = &CountingBlockDealloc;
+
+  counted_block_allocs = 0;
+  counted_block_deallocs = 0;
+  for (int i = 0; i < 3; i++) {
+    Arena arena(options);
+    Arena::CreateArray<char>(&arena, 64);
+  }
+  // Every block goes through the user-provided functions.
+  EXPECT_EQ(counted_block_allocs, 3);
+  EXPECT_EQ(counted_block_deallocs, 3);
+}
+
+TEST(ArenaTest, ResetRetainingBlock) {
+  ArenaOptions options;
+  options.block_alloc = &CountingBlockAlloc;
+  options.block_dealloc = &CountingBlockDealloc;
+
+  counted_block_allocs = 0;
+  counted_block_deallocs = 0;
+  {
+    Arena arena(options);
+    int allocs = 0;
+    for (int i = 0; i < 4; i++) {
+      const int allocs_before = counted_block_allocs;
+      for (int j = 0; j < 20; j++) {
+        memset(Arena::CreateArray<char>(&arena, 512), 0, 512);
+      }
+      allocs = counted_block_allocs - allocs_before;
+      const uint64_t space_allocated = arena.SpaceAllocated();
+      EXPECT_EQ(space_allocated, arena.ResetRetainingBlock(1 << 20));
+      EXPECT_EQ(0, arena.SpaceUsed());
+    }
+    // Once the retained block holds a whole iteration, no more blocks are
+    // requested.
+    EXPECT_EQ(allocs, 0);
+    EXPECT_GT(counted_block_allocs, counted_block_deallocs);
+
+    // A limit smaller than any block behaves like Reset().
+    for (int j = 0; j < 20; j++) Arena::CreateArray<char>(&arena, 512);
+    arena.ResetRetainingBlock(1);
+    const int allocs_before = counted_block_allocs;
+    for (int j = 0; j < 20; j++) Arena::CreateArray<char>(&arena, 512);
+    EXPECT_GT(counted_block_allocs, allocs_before);
+  }
+  EXPECT_EQ(counted_block_allocs, counted_block_deallocs);
+}
+
+TEST(ArenaAllocatorTest, ContainersOnArena) {
+  Arena arena;
+  const uint64_t space_used = arena.SpaceUsed();
+  {
+    std::vector<int, ArenaAllocator<int>> v{ArenaAllocator<int>(&arena)};
+    for (int i = 0; i < 100; ++i) v.push_back(i);
+    absl::flat_hash_map<int, std::string, absl::Hash<int>, std::equal_to<int>,
+                        ArenaAllocator<std::pair<const int, std::string>>>
+        m{0, absl::Hash<int>(), std::equal_to<int>(),
+          ArenaAllocator<std::pair<const int, std::string>>(&arena)};
+    for (int i = 0; i < 100; ++i) m[i] = "value";
+    EXPECT_EQ(v[99], 99);
+    EXPECT_EQ(m[42], "value");
+  }
+  EXPECT_GT(arena.SpaceUsed(), space_used);
+}
+
+TEST(ArenaAllocatorTest, ReusesDeallocatedMemory) {
+  Arena arena;
+  ArenaAllocator<int64_t> alloc(&arena);
+  // The first returned block may be taken over as the arena's freelist, so
+  // return two blocks and expect the second to be handed out again.
+  int64_t* first = alloc.allocate(8);
+  int64_t* second = alloc.allocate(8);
+  alloc.deallocate(first, 8);
+  alloc.deallocate(second, 8);
+  EXPECT_EQ(alloc.allocate(8), second);
+
+  // Allocators of other types compare equal on the same arena.
+  EXPECT_TRUE(alloc == ArenaAllocator<char>(&arena));
+  EXPECT_TRUE(alloc != ArenaAllocator<int64_t>());
+}
+
+TEST(ArenaAllocatorTest, NullArenaUsesHeap) {
+  std::vector<std::string, ArenaAllocator<std::string>> v;
+  v.push_back("heap");
+  EXPECT_EQ(v.get_allocator().arena(), nullptr);
+  EXPECT_EQ(v[0], "heap");
+}
+
+TEST(ArenaPoolTest, ReusesReleasedArenas) {
+  ArenaPoolOptions options;
+  options.arena_options.block_alloc = &CountingBlockAlloc;
+  options.arena_options.block_dealloc = &CountingBlockDealloc;
+
+  counted_block_allocs = 0;
+  counted_block_deallocs = 0;
+  {
+    ArenaPool pool(options);
+    Arena* first;
+    {
+      ArenaPool::Lease arena = pool.Acquire();
+      first = arena.get();
+      Arena::CreateArray<char>(arena.get(), 4096);
+    }
+    ArenaPool::Lease arena = pool.Acquire();
+    // The thread gets its own arena back, reset but with its block.
+    EXPECT_EQ(arena.get(), first);
+    EXPECT_EQ(arena->SpaceUsed(), 0);
+    const int allocs_before = counted_block_allocs;
+    Arena::CreateArray<char>(arena.get(), 4096);
+    EXPECT_EQ(counted_block_allocs, allocs_before);
+  }
+  EXPECT_EQ(counted_block_allocs, counted_block_deallocs);
+}
+
+TEST(ArenaPoolTest, PrewarmedArenas) {
+  ArenaPoolOptions options;
+  options.arena_options.block_alloc = &CountingBlockAlloc;
+  options.arena_options.block_dealloc = &CountingBlockDealloc;
+  options.max_retained_bytes = 16 << 10;
+  options.prewarmed_arenas = 2;
+
+  counted_block_allocs = 0;
+  counted_block_deallocs = 0;
+  {
+    ArenaPool pool(options);
+    EXPECT_EQ(pool.SharedArenaCount(), 2);
+    ArenaPool::Lease arena = pool.Acquire();
+    EXPECT_EQ(pool.SharedArenaCount(), 1);
+    const int allocs_before = counted_block_allocs;
+    Arena::CreateArray<char>(arena.get(), 8 << 10);
+    EXPECT_EQ(counted_block_allocs, allocs_before);
+  }
+  EXPECT_EQ(counted_block_allocs, counted_block_deallocs);
+}
+
+TEST(ArenaPoolTest, SharesArenasAcrossThreads) {
+  ArenaPoolOptions options;
+  options.max_arenas_per_thread = 0;
+  ArenaPool pool(options);
+  Arena* released = nullptr;
+  std::thread([&] {
+    ArenaPool::Lease arena = pool.Acquire();
+    released = arena.get();
+  }).join();
+  EXPECT_EQ(pool.SharedArenaCount(), 1);
+  ArenaPool::Lease arena = pool.Acquire();
+  EXPECT_EQ(arena.get(), released);
+  EXPECT_EQ(pool.SharedArenaCount(), 0);
+}
+
+namespace {
+
+struct DeferredTask {
+  void (*task)(void*);
+  void* arg;
+};
+std::vector<DeferredTask>* deferred_tasks = nullptr;
+
+void DeferCleanup(void (*task)(void*), void* arg) {
+  deferred_tasks->push_back({task, arg});
+}
+
+}  // namespace
+
+TEST(ArenaTest, CleanupExecutor) {
+  std::vector<DeferredTask> tasks;
+  deferred_tasks = &tasks;
+  ArenaOptions options;
+  options.cleanup_executor = &DeferCleanup;
+
+  Notifier notifier;
+  {
+    Arena arena(options);
+    Arena::Create<SimpleDataType>(&arena)->SetNotifier(&notifier);
+    std::thread t([&] {
+      Arena::Create<SimpleDataType>(&arena)->SetNotifier(&notifier);
+    });
+    t.join();
+    Arena::CreateMessage<TestAllTypes>(&arena)->set_optional_string(
+        std::string(100, 'x'));
+    for (int i = 0; i < 100; i++) Arena::CreateArray<char>(&arena, 1000);
+  }
+  // Nothing was destroyed by the arena's destructor itself.
+  EXPECT_EQ(0, notifier.GetCount());
+  ASSERT_EQ(tasks.size(), 1);
+
+  std::thread reclaimer([&] { tasks[0].task(tasks[0].arg); });
+  reclaimer.join();
+  EXPECT_EQ(2, notifier.GetCount());
+  deferred_tasks = nullptr;
+}
+
+TEST(ArenaTest, CleanupExecutorNotUsedWithInitialBlock) {
+  std::vector<DeferredTask> tasks;
+  deferred_tasks = &tasks;
+  std::vector<char> arena_block(1024);
+  ArenaOptions options;
+  options.cleanup_executor = &DeferCleanup;
+  options.initial_block = arena_block.data();
+  options.initial_block_size = arena_block.size();
+
+  Notifier notifier;
+  {
+    Arena arena(options);
+    Arena::Create<SimpleDataType>(&arena)->SetNotifier(&notifier);
+  }
+  EXPECT_EQ(1, notifier.GetCount());
+  EXPECT_TRUE(tasks.empty());
+  deferred_tasks = nullptr;
+}
+
+TEST(ArenaTest, SingleThreaded) {
+  ArenaOptions options;
+  options.single_threaded = true;
+  Arena arena(options);
+
+  Notifier notifier;
+  TestAllTypes* message = Arena::CreateMessage<TestAllTypes>(&arena);
+  TestUtil::SetAllFields(message);
+  Arena::Create<SimpleDataType>(&arena)->SetNotifier(&notifier);
+
+  // The arena may be handed to another thread, which keeps allocating from
+  // the same blocks.
+  std::thread t([&] {
+    for (int i = 0; i < 100; i++) Arena::CreateArray<char>(&arena, 1000);
+    Arena::Create<SimpleDataType>(&arena)->SetNotifier(&notifier);
+  });
+  t.join();
+  TestUtil::ExpectAllFieldsSet(*message);
+  EXPECT_GE(arena.SpaceAllocated(), 100 * 1000);
+
+  arena.Reset();
+  EXPECT_EQ(2, notifier.GetCount());
+
+  // Still single-threaded after Reset().
+  message = Arena::CreateMessage<TestAllTypes>(&arena);
+  TestUtil::SetAllFields(message);
+  TestUtil::ExpectAllFieldsSet(*message);
+  EXPECT_EQ(message->GetArena(), &arena);
+}
+
+// Returns true if `n` strings created on `arena` come from one string block,
+// which hands out strings from its end towards its start.
+bool CreatesStringsFromOneBlock(Arena* arena, int n) {
+  std::string* last = Arena::Create<std::string>(arena);
+  bool contiguous = true;
+  for (int i = 1; i < n; ++i) {
+    std::string* s = Arena::Create<std::string>(arena);
+    contiguous &= s == last - 1;
+    last = s;
+  }
+  return contiguous;
+}
+
+TEST(ArenaTest, ExpectedStringCount) {
+  Arena default_arena;
+  EXPECT_FALSE(CreatesStringsFromOneBlock(&default_arena, 100));
+
+  ArenaOptions options;
+  options.expected_string_count = 100;
+  Arena arena(options);
+  EXPECT_TRUE(CreatesStringsFromOneBlock(&arena, 100));
+}
+
+TEST(ArenaTest, ResetSizesStringBlocksFromPreviousUse) {
+  Arena arena;
+  EXPECT_FALSE(CreatesStringsFromOneBlock(&arena, 100));
+  arena.Reset();
+  EXPECT_TRUE(CreatesStringsFromOneBlock(&arena, 100));
+}
+
+TEST(ArenaTest, FuseMovesSubMessagesWithoutCopy) {
+  Notifier notifier;
+  Arena arena1;
+  auto* arena2 = new Arena;
+  ASSERT_TRUE(Arena::Fuse(&arena1, arena2));
+  EXPECT_TRUE(Arena::IsFused(&arena1, arena2));
+  EXPECT_TRUE(Arena::IsFused(arena2, &arena1));
+
+  auto* message = Arena::CreateMessage<TestAllTypes>(&arena1);
+  auto* nested = Arena::CreateMessage<TestAllTypes::NestedMessage>(arena2);
+  nested->set_bb(42);
+  message->set_allocated_optional_nested_message(nested);
+  EXPECT_EQ(&message->optional_nested_message(), nested);
+
+  auto* element = Arena::CreateMessage<TestAllTypes::NestedMessage>(arena2);
+  element->set_bb(7);
+  message->mutable_repeated_nested_message()->AddAllocated(element);
+  EXPECT_EQ(&message->repeated_nested_message(0), element);
+
+  auto* foreign = Arena::CreateMessage<ForeignMessage>(arena2);
+  message->GetReflection()->SetAllocatedMessage(
+      message, foreign,
+      message->GetDescriptor()->FindFieldByName("optional_foreign_message"));
+  EXPECT_EQ(&message->optional_foreign_message(), foreign);
+
+  auto* string = Arena::Create<std::string>(arena2, 100, 'x');
+  Arena::Create<SimpleDataType>(arena2)->SetNotifier(&notifier);
+
+  // The moved objects outlive their arena until the whole group is gone.
+  delete arena2;
+  EXPECT_EQ(0, notifier.GetCount());
+  EXPECT_EQ(message->optional_nested_message().bb(), 42);
+  EXPECT_EQ(message->repeated_nested_message(0).bb(), 7);
+  EXPECT_EQ(*string, std::string(100, 'x'));
+}
+
+TEST(ArenaTest, FuseRunsDestructorsWithLastArena) {
+  Notifier notifier;
+  {
+    Arena arena1;
+    {
+      Arena arena2;
+      Arena arena3;
+      ASSERT_TRUE(Arena::Fuse(&arena1, &arena2));
+      ASSERT_TRUE(Arena::Fuse(&arena2, &arena3));
+      Arena::Create<SimpleDataType>(&arena2)->SetNotifier(&notifier);
+      Arena::Create<SimpleDataType>(&arena3)->SetNotifier(&notifier);
+      for (int i = 0; i < 100; i++) Arena::CreateArray<char>(&arena3, 1000);
+    }
+    EXPECT_EQ(0, notifier.GetCount());
+    Arena::Create<SimpleDataType>(&arena1)->SetNotifier(&notifier);
+  }
+  EXPECT_EQ(3, notifier.GetCount());
+}
+
+TEST(ArenaTest, FuseMergesGroups) {
+  Arena a, b, c, d, e;
+  EXPECT_TRUE(Arena::Fuse(&a, &a));
+  EXPECT_TRUE(Arena::IsFused(&a, &a));
+  EXPECT_FALSE(Arena::IsFused(&a, &b));
+  EXPECT_FALSE(Arena::IsFused(&a, nullptr));
+
+  ASSERT_TRUE(Arena::Fuse(&a, &b));
+  ASSERT_TRUE(Arena::Fuse(&c, &d));
+  EXPECT_FALSE(Arena::IsFused(&a, &c));
+  ASSERT_TRUE(Arena::Fuse(&b, &c));
+  EXPECT_TRUE(Arena::Fuse(&d, &a));
+  for (Arena* x : {&a, &b, &c, &d}) {
+    for (Arena* y : {&a, &b, &c, &d}) EXPECT_TRUE(Arena::IsFused(x, y));
+    EXPECT_FALSE(Arena::IsFused(x, &e));
+  }
+}
+
+TEST(ArenaTest, FuseRefusesInitialBlock) {
+  std::vector<char> arena_block(1024);
+  Arena with_block(arena_block.data(), arena_block.size());
+  Arena arena;
+  EXPECT_FALSE(Arena::Fuse(&arena, &with_block));
+  EXPECT_FALSE(Arena::Fuse(&with_block, &arena));
+  EXPECT_FALSE(Arena::IsFused(&arena, &with_block));
+
+  // Unfused arenas still copy.
+  auto* message = Arena::CreateMessage<TestAllTypes>(&arena);
+  auto* nested =
+      Arena::CreateMessage<TestAllTypes::NestedMessage>(&with_block);
+  nested->set_bb(42);
+  message->mutable_repeated_nested_message()->AddAllocated(nested);
+  EXPECT_NE(&message->repeated_nested_message(0), nested);
+  EXPECT_EQ(message->repeated_nested_message(0).bb(), 42);
+}
+
+TEST(ArenaTest, HugePageBlocks) {
+  constexpr size_t kHugePageSize = internal::AllocationPolicy::kHugePageSize;
+  ArenaOptions options;
+  options.use_huge_pages = true;
+  options.max_block_size = 4 * kHugePageSize;
+  Arena arena(options);
+
+  // Small blocks are unaffected.
+  Arena::CreateArray<char>(&arena, 64);
+  EXPECT_LT(arena.SpaceAllocated(), kHugePageSize);
+
+  // Large blocks are rounded up to whole huge pages where supported.
+  char* p = Arena::CreateArray<char>(&arena, kHugePageSize + 1);
+  memset(p, 0xab, kHugePageSize + 1);
+  EXPECT_GE(arena.SpaceAllocated(), 2 * kHugePageSize);
+#if defined(__linux__)
+  // The new block is aligned to a huge page boundary.
+  EXPECT_EQ(internal::SerialArena::kBlockHeaderSize,
+            reinterpret_cast<uintptr_t>(p) % kHugePageSize);
+#endif  // defined(__linux__)
+  arena.Reset();
+  p = Arena::CreateArray<char>(&arena, 3 * kHugePageSize);
+  memset(p, 0xcd, 3 * kHugePageSize);
+}
+
+TEST(ArenaTest, StringInterner) {
+  const absl::string_view kValues[] = {"example.com", "US"};
+  StringInterner interner(kValues);
+  EXPECT_EQ(2, interner.size());
+  EXPECT_EQ(nullptr, interner.Find("example.org"));
+
+  TestAllTypes source;
+  source.set_optional_string("example.com");
+  source.set_optional_bytes("not interned");
+  source.set_default_string("US");
+  source.add_repeated_string("US");
+  const std::string data = source.SerializeAsString();
+
+  ArenaOptions options;
+  options.string_interner = &interner;
+  Arena arena(options);
+  auto* message = Arena::CreateMessage<TestAllTypes>(&arena);
+  ASSERT_TRUE(message->ParseFromString(data));
+  EXPECT_EQ(interner.Find("example.com"), &message->optional_string());
+  EXPECT_EQ(interner.Find("US"), &message->default_string());
+  EXPECT_EQ("not interned", message->optional_bytes());
+  EXPECT_EQ(data, message->SerializeAsString());
+
+  // Mutations copy the shared value and leave the dictionary intact.
+  message->mutable_optional_string()->append("/path");
+  EXPECT_EQ("example.com/path", message->optional_string());
+  EXPECT_NE(interner.Find("example.com"), &message->optional_string());
+  message->clear_default_string();
+  EXPECT_EQ("hello", message->default_string());
+  EXPECT_EQ("US", *interner.Find("US"));
+
+  ASSERT_TRUE(message->ParseFromString(data));
+  message->set_optional_string("other");
+  EXPECT_EQ("other", message->optional_string());
+  std::unique_ptr<std::string> released(message->release_default_string());
+  EXPECT_EQ("US", *released);
+  EXPECT_EQ("example.com", *interner.Find("example.com"));
+
+  // A heap copy does not share the dictionary's strings.
+  ASSERT_TRUE(message->ParseFromString(data));
+  TestAllTypes copy(*message);
+  EXPECT_NE(interner.Find("example.com"), &copy.optional_string());
+  EXPECT_EQ("example.com", copy.optional_string());
+  message->Clear();
+  EXPECT_EQ("", message->optional_string());
+  EXPECT_EQ("example.com", copy.optional_string());
+}
+
 TEST(ArenaTest, CreateDestroy) {
   TestAllTypes original;
   TestUtil::SetAllFields(&original);
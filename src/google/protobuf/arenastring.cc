@@ -38,6 +38,7 @@
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/message_lite.h"
 #include "google/protobuf/parse_context.h"
+#include "google/protobuf/string_interner.h"
 
 // clang-format off
 #include "google/protobuf/port_def.inc"
@@ -66,6 +67,11 @@ constexpr size_t kStringAlign = alignof(std::string);
 
 static_assert((kStringAlign > kNewAlign ? kStringAlign : kNewAlign) >= 4, "");
 static_assert(alignof(ExplicitlyConstructedArenaString) >= 4, "");
+// TaggedStringPtr::kUtf8ValidatedBit uses a third bit where strings allow it.
+static_assert(TaggedStringPtr::kUtf8ValidatedBit == 0 ||
+                  ((kStringAlign > kNewAlign ? kStringAlign : kNewAlign) >= 8 &&
+                   alignof(ExplicitlyConstructedArenaString) >= 8),
+              "");
 
 }  // namespace
 
@@ -116,13 +122,15 @@ TaggedStringPtr CreateArenaString(Arena& arena, absl::string_view s) {
 }  // namespace
 
 TaggedStringPtr TaggedStringPtr::ForceCopy(Arena* arena) const {
-  return arena != nullptr ? CreateArenaString(*arena, *Get())
-                          : CreateString(*Get());
+  TaggedStringPtr res = arena != nullptr ? CreateArenaString(*arena, *Get())
+                                         : CreateString(*Get());
+  if (IsUtf8Validated()) res.SetUtf8Validated();
+  return res;
 }
 
 void ArenaStringPtr::Set(absl::string_view value, Arena* arena) {
   ScopedCheckPtrInvariants check(&tagged_ptr_);
-  if (IsDefault()) {
+  if (!tagged_ptr_.IsMutable()) {
     // If we're not on an arena, skip straight to a true string to avoid
     // possible copy cost later.
     tagged_ptr_ = arena != nullptr ? CreateArenaString(*arena, value)
@@ -147,7 +155,7 @@ void ArenaStringPtr::Set(absl::string_view value, Arena* arena) {
 template <>
 void ArenaStringPtr::Set(const std::string& value, Arena* arena) {
   ScopedCheckPtrInvariants check(&tagged_ptr_);
-  if (IsDefault()) {
+  if (!tagged_ptr_.IsMutable()) {
     // If we're not on an arena, skip straight to a true string to avoid
     // possible copy cost later.
     tagged_ptr_ = arena != nullptr ? CreateArenaString(*arena, value)
@@ -171,14 +179,9 @@ void ArenaStringPtr::Set(const std::string& value, Arena* arena) {
 
 void ArenaStringPtr::Set(std::string&& value, Arena* arena) {
   ScopedCheckPtrInvariants check(&tagged_ptr_);
-  if (IsDefault()) {
+  if (!tagged_ptr_.IsMutable()) {
     NewString(arena, std::move(value));
-  } else if (IsFixedSizeArena()) {
-    std::string* current = tagged_ptr_.Get();
-    auto* s = new (current) std::string(std::move(value));
-    arena->OwnDestructor(s);
-    tagged_ptr_.SetMutableArena(s);
-  } else /* !IsFixedSizeArena() */ {
+  } else {
     *UnsafeMutablePointer() = std::move(value);
   }
 }
@@ -186,6 +189,7 @@ void ArenaStringPtr::Set(std::string&& value, Arena* arena) {
 std::string* ArenaStringPtr::Mutable(Arena* arena) {
   ScopedCheckPtrInvariants check(&tagged_ptr_);
   if (tagged_ptr_.IsMutable()) {
+    tagged_ptr_.ClearUtf8Validated();
     return tagged_ptr_.Get();
   } else {
     return MutableSlow(arena);
@@ -196,6 +200,7 @@ std::string* ArenaStringPtr::Mutable(const LazyString& default_value,
                                      Arena* arena) {
   ScopedCheckPtrInvariants check(&tagged_ptr_);
   if (tagged_ptr_.IsMutable()) {
+    tagged_ptr_.ClearUtf8Validated();
     return tagged_ptr_.Get();
   } else {
     return MutableSlow(arena, default_value);
@@ -205,9 +210,9 @@ std::string* ArenaStringPtr::Mutable(const LazyString& default_value,
 std::string* ArenaStringPtr::MutableNoCopy(Arena* arena) {
   ScopedCheckPtrInvariants check(&tagged_ptr_);
   if (tagged_ptr_.IsMutable()) {
+    tagged_ptr_.ClearUtf8Validated();
     return tagged_ptr_.Get();
   } else {
-    ABSL_DCHECK(IsDefault());
     // Allocate empty. The contents are not relevant.
     return NewString(arena);
   }
@@ -216,7 +221,11 @@ std::string* ArenaStringPtr::MutableNoCopy(Arena* arena) {
 template <typename... Lazy>
 std::string* ArenaStringPtr::MutableSlow(::google::protobuf::Arena* arena,
                                          const Lazy&... lazy_default) {
-  ABSL_DCHECK(IsDefault());
+  if (!IsDefault()) {
+    // Copy a shared interned string before it is mutated.
+    ABSL_DCHECK(tagged_ptr_.IsFixedSizeArena());
+    return NewString(arena, *tagged_ptr_.Get());
+  }
 
   // For empty defaults, this ends up calling the default constructor which is
   // more efficient than a copy construction from
@@ -265,6 +274,9 @@ void ArenaStringPtr::ClearToEmpty() {
   ScopedCheckPtrInvariants check(&tagged_ptr_);
   if (IsDefault()) {
     // Already set to default -- do nothing.
+  } else if (!tagged_ptr_.IsMutable()) {
+    // A shared interned string: point back at the empty default.
+    InitDefault();
   } else {
     // Unconditionally mask away the tag.
     //
@@ -281,6 +293,10 @@ void ArenaStringPtr::ClearToDefault(const LazyString& default_value,
   (void)arena;
   if (IsDefault()) {
     // Already set to default -- do nothing.
+  } else if (!tagged_ptr_.IsMutable()) {
+    // A shared interned string. While the field is in its default state its
+    // value is read from `default_value`.
+    InitDefault();
   } else {
     UnsafeMutablePointer()->assign(default_value.get());
   }
@@ -295,6 +311,16 @@ const char* EpsCopyInputStream::ReadArenaString(const char* ptr,
   int size = ReadSize(&ptr);
   if (!ptr) return nullptr;
 
+  const StringInterner* interner = arena->string_interner();
+  if (interner != nullptr && size <= buffer_end_ + kSlopBytes - ptr) {
+    if (const std::string* interned =
+            interner->Find(absl::string_view(ptr, size))) {
+      // Interned strings are immutable; the first mutation copies them.
+      s->tagged_ptr_.SetFixedSizeArena(const_cast<std::string*>(interned));
+      return ptr + size;
+    }
+  }
+
   auto* str = s->NewString(arena);
   ptr = ReadString(ptr, size, str);
   GOOGLE_PROTOBUF_PARSER_ASSERT(ptr);
@@ -105,6 +105,13 @@ class PROTOBUF_EXPORT TaggedStringPtr {
     kMask = 0x3         // Bit mask
   };
 
+  // Set on strings whose contents the parser found to be valid UTF-8, and
+  // dropped by every operation that may change the contents.  The bit is
+  // independent of the type bits above and only available where strings are
+  // at least 8 byte aligned; it is zero, and the state never set, otherwise.
+  static constexpr uintptr_t kUtf8ValidatedBit =
+      alignof(std::string) >= 8 ? 0x4 : 0;
+
   // Composed logical types
   enum Type {
     // Default strings are immutable and never owned.
@@ -126,6 +133,10 @@ class PROTOBUF_EXPORT TaggedStringPtr {
     // size arena strings are immutable, with the exception of custom internal
     // updates to the content that fit inside the existing capacity.
     // Fixed size arena strings must never be deleted or destroyed.
+    //
+    // Strings shared from an arena's StringInterner also use this type: they
+    // are immutable and owned by the interner, so they are never deleted and
+    // are copied on their first mutation.
     kFixedSizeArena = kArenaBit,
   };
 
@@ -166,10 +177,25 @@ class PROTOBUF_EXPORT TaggedStringPtr {
   // Returns true if the current string is an immutable default value.
   inline bool IsDefault() const { return (as_int() & kMask) == kDefault; }
 
+  // Returns true if the contents of the current string are known to be valid
+  // UTF-8, see kUtf8ValidatedBit.
+  inline bool IsUtf8Validated() const { return as_int() & kUtf8ValidatedBit; }
+
+  // Marks the contents of the current string as valid UTF-8.
+  inline void SetUtf8Validated() {
+    ptr_ = reinterpret_cast<void*>(as_int() | kUtf8ValidatedBit);
+  }
+
+  // Forgets whether the contents of the current string are valid UTF-8. Called
+  // before handing out mutable access to the contents.
+  inline void ClearUtf8Validated() {
+    ptr_ = reinterpret_cast<void*>(as_int() & ~kUtf8ValidatedBit);
+  }
+
   // If the current string is a heap-allocated mutable value, returns a pointer
   // to it.  Returns nullptr otherwise.
   inline std::string* GetIfAllocated() const {
-    auto allocated = as_int() ^ kAllocated;
+    auto allocated = (as_int() & ~kUtf8ValidatedBit) ^ kAllocated;
     if (allocated & kMask) return nullptr;
 
     auto ptr = reinterpret_cast<std::string*>(allocated);
@@ -188,7 +214,8 @@ class PROTOBUF_EXPORT TaggedStringPtr {
 
   // Returns the contained string pointer.
   inline std::string* Get() const {
-    return reinterpret_cast<std::string*>(as_int() & ~kMask);
+    return reinterpret_cast<std::string*>(as_int() &
+                                          ~(kMask | kUtf8ValidatedBit));
   }
 
   // Returns true if the contained pointer is null, indicating some error.
@@ -412,6 +439,14 @@ struct PROTOBUF_EXPORT ArenaStringPtr {
   // Returns true if this instances holds an immutable default value.
   inline bool IsDefault() const { return tagged_ptr_.IsDefault(); }
 
+  // Returns true if the parser found the current value to be valid UTF-8 and
+  // it has not been mutably accessed since.  Serialization uses this to skip
+  // validating strings again that are written back unchanged.
+  inline bool IsUtf8Validated() const { return tagged_ptr_.IsUtf8Validated(); }
+
+  // Called from parsing code only, after checking the current value.
+  inline void SetUtf8Validated() { tagged_ptr_.SetUtf8Validated(); }
+
  private:
   template <typename... Args>
   inline std::string* NewString(Arena* arena, Args&&... args) {
@@ -426,7 +461,7 @@ struct PROTOBUF_EXPORT ArenaStringPtr {
 
   TaggedStringPtr tagged_ptr_;
 
-  bool IsFixedSizeArena() const { return false; }
+  bool IsFixedSizeArena() const { return tagged_ptr_.IsFixedSizeArena(); }
 
   // Swaps tagged pointer without debug hardening. This is to allow python
   // protobuf to maintain pointer stability even in DEBUG builds.
@@ -550,13 +585,18 @@ inline PROTOBUF_NDEBUG_INLINE void ArenaStringPtr::InternalSwap(  //
 }
 
 inline void ArenaStringPtr::ClearNonDefaultToEmpty() {
-  // Unconditionally mask away the tag.
+  if (PROTOBUF_PREDICT_FALSE(!tagged_ptr_.IsMutable())) {
+    // A shared interned string: point back at the empty default.
+    InitDefault();
+    return;
+  }
   tagged_ptr_.Get()->clear();
 }
 
 inline std::string* ArenaStringPtr::UnsafeMutablePointer() {
   ABSL_DCHECK(tagged_ptr_.IsMutable());
   ABSL_DCHECK(tagged_ptr_.Get() != nullptr);
+  tagged_ptr_.ClearUtf8Validated();
   return tagged_ptr_.Get();
 }
 
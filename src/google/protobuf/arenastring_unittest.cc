@@ -265,6 +265,38 @@ TEST_P(SingleArena, CopyConstructLong) {
   field.Destroy();
 }
 
+TEST_P(SingleArena, Utf8ValidatedUntilMutated) {
+  if (internal::TaggedStringPtr::kUtf8ValidatedBit == 0) {
+    GTEST_SKIP() << "Strings are not 8 byte aligned";
+  }
+  auto arena = GetArena();
+  ArenaStringPtr field;
+  field.InitDefault();
+  EXPECT_FALSE(field.IsUtf8Validated());
+  field.Set("A string long enough to not be inlined", arena.get());
+  field.SetUtf8Validated();
+  EXPECT_TRUE(field.IsUtf8Validated());
+  EXPECT_EQ(field.Get(), "A string long enough to not be inlined");
+
+  // Copies carry the state, mutable access drops it.
+  ArenaStringPtr copy(arena.get(), field);
+  EXPECT_TRUE(copy.IsUtf8Validated());
+  field.Mutable(arena.get())->append("\xff");
+  EXPECT_FALSE(field.IsUtf8Validated());
+  copy.Set("value", arena.get());
+  EXPECT_FALSE(copy.IsUtf8Validated());
+  copy.SetUtf8Validated();
+  *copy.MutableNoCopy(arena.get()) = "other";
+  EXPECT_FALSE(copy.IsUtf8Validated());
+
+  // Owned strings are still found, and freed, while the state is set.
+  field.SetUtf8Validated();
+  if (arena == nullptr) {
+    field.Destroy();
+    copy.Destroy();
+  }
+}
+
 
 }  // namespace protobuf
 }  // namespace google
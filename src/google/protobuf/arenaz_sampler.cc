@@ -86,6 +86,20 @@ void ThreadSafeArenaStats::PrepareForSampling(int64_t stride) {
   for (auto& blockstats : block_histogram) blockstats.PrepareForSampling();
   max_block_size.store(0, std::memory_order_relaxed);
   thread_ids.store(0, std::memory_order_relaxed);
+  block_cache_hits.store(0, std::memory_order_relaxed);
+  block_cache_misses.store(0, std::memory_order_relaxed);
+  cleanup_nodes.store(0, std::memory_order_relaxed);
+  cleanup_bytes.store(0, std::memory_order_relaxed);
+  string_blocks.store(0, std::memory_order_relaxed);
+  string_block_bytes.store(0, std::memory_order_relaxed);
+  string_block_unused_bytes.store(0, std::memory_order_relaxed);
+  serial_arena_lookups.store(0, std::memory_order_relaxed);
+  serial_arenas_created.store(0, std::memory_order_relaxed);
+  serial_arena_chunks_grown.store(0, std::memory_order_relaxed);
+  {
+    absl::MutexLock lock(&message_mu);
+    message_stats.clear();
+  }
   weight = stride;
   // The inliner makes hardcoded skip_count difficult (especially when combined
   // with LTO).  We use the ability to exclude stacks by regex when encoding
@@ -135,6 +149,47 @@ void RecordAllocateSlow(ThreadSafeArenaStats* info, size_t used,
   info->thread_ids.fetch_or(tid, std::memory_order_relaxed);
 }
 
+void RecordBlockCacheSlow(ThreadSafeArenaStats* info, bool hit) {
+  if (hit) {
+    info->block_cache_hits.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    info->block_cache_misses.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void RecordCleanupSlow(ThreadSafeArenaStats* info, size_t nodes, size_t bytes) {
+  info->cleanup_nodes.fetch_add(nodes, std::memory_order_relaxed);
+  info->cleanup_bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void RecordStringBlockSlow(ThreadSafeArenaStats* info, size_t allocated,
+                           size_t unused) {
+  if (allocated != 0) {
+    info->string_blocks.fetch_add(1, std::memory_order_relaxed);
+    info->string_block_bytes.fetch_add(allocated, std::memory_order_relaxed);
+  }
+  info->string_block_unused_bytes.fetch_add(unused, std::memory_order_relaxed);
+}
+
+void RecordSerialArenaLookupSlow(ThreadSafeArenaStats* info, bool created,
+                                 bool grew_chunks) {
+  info->serial_arena_lookups.fetch_add(1, std::memory_order_relaxed);
+  if (created) {
+    info->serial_arenas_created.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (grew_chunks) {
+    info->serial_arena_chunks_grown.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void RecordMessageSlow(ThreadSafeArenaStats* info, absl::string_view type_name,
+                       size_t bytes) {
+  absl::MutexLock lock(&info->message_mu);
+  auto& stats = info->message_stats[type_name];
+  ++stats.count;
+  stats.bytes += bytes;
+}
+
 ThreadSafeArenaStats* SampleSlow(SamplingState& sampling_state) {
   bool first = sampling_state.next_sample < 0;
   const int64_t next_stride = g_exponential_biased_generator.GetStride(
@@ -37,6 +37,9 @@
 #include <cstdint>
 #include <utility>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 
 // Must be included last.
 #include "google/protobuf/port_def.inc"
@@ -49,6 +52,14 @@ namespace internal {
 struct ThreadSafeArenaStats;
 void RecordAllocateSlow(ThreadSafeArenaStats* info, size_t used,
                         size_t allocated, size_t wasted);
+void RecordBlockCacheSlow(ThreadSafeArenaStats* info, bool hit);
+void RecordCleanupSlow(ThreadSafeArenaStats* info, size_t nodes, size_t bytes);
+void RecordStringBlockSlow(ThreadSafeArenaStats* info, size_t allocated,
+                           size_t unused);
+void RecordMessageSlow(ThreadSafeArenaStats* info, absl::string_view type_name,
+                       size_t bytes);
+void RecordSerialArenaLookupSlow(ThreadSafeArenaStats* info, bool created,
+                                 bool grew_chunks);
 // Stores information about a sampled thread safe arena.  All mutations to this
 // *must* be made through `Record*` functions below.  All reads from this *must*
 // only occur in the callback to `ThreadSafeArenazSampler::Iterate`.
@@ -96,6 +107,41 @@ struct ThreadSafeArenaStats
   // bit mixing for thread-ids; `% 64` would only grab the low bits and might
   // create sampling artifacts.
   std::atomic<uint64_t> thread_ids;
+  // Number of block allocations served from, or missed in, the per-thread
+  // block cache (see `AllocationPolicy::max_thread_cached_blocks`).
+  std::atomic<size_t> block_cache_hits;
+  std::atomic<size_t> block_cache_misses;
+  // Number of cleanup nodes and the bytes they occupy at the tail of blocks.
+  // A block is counted when the arena moves on to a new block, and the current
+  // block of each SerialArena when the arena is reset or destroyed.
+  std::atomic<size_t> cleanup_nodes;
+  std::atomic<size_t> cleanup_bytes;
+  // Number and total size of the blocks backing arena-allocated strings, and
+  // the unused space in the active string blocks when the arena is reset or
+  // destroyed.
+  std::atomic<size_t> string_blocks;
+  std::atomic<size_t> string_block_bytes;
+  std::atomic<size_t> string_block_unused_bytes;
+  // Number of allocations that missed the thread's cached SerialArena and
+  // looked it up in the arena's list of SerialArenas, how many of those found
+  // none and added a new SerialArena for the thread, and how many of those
+  // found no room in the list and took the arena's mutex to add a new chunk
+  // to it.  Lookups that keep recurring show threads taking turns on the
+  // same arena.
+  std::atomic<size_t> serial_arena_lookups;
+  std::atomic<size_t> serial_arenas_created;
+  std::atomic<size_t> serial_arena_chunks_grown;
+
+  // Messages created on the arena, keyed by their full type name.  `bytes` is
+  // the sum of `sizeof` of the created objects; it does not include the
+  // repeated fields, strings or submessages they allocate later.
+  struct MessageStats {
+    size_t count = 0;
+    size_t bytes = 0;
+  };
+  mutable absl::Mutex message_mu;
+  absl::flat_hash_map<absl::string_view, MessageStats> message_stats
+      ABSL_GUARDED_BY(message_mu);
 
   // All of the fields below are set by `PrepareForSampling`, they must not
   // be mutated in `Record*` functions.  They are logically `const` in that
@@ -110,6 +156,30 @@ struct ThreadSafeArenaStats
     if (PROTOBUF_PREDICT_TRUE(info == nullptr)) return;
     RecordAllocateSlow(info, used, allocated, wasted);
   }
+  static void RecordBlockCacheStats(ThreadSafeArenaStats* info, bool hit) {
+    if (PROTOBUF_PREDICT_TRUE(info == nullptr)) return;
+    RecordBlockCacheSlow(info, hit);
+  }
+  static void RecordCleanupStats(ThreadSafeArenaStats* info, size_t nodes,
+                                 size_t bytes) {
+    if (PROTOBUF_PREDICT_TRUE(info == nullptr)) return;
+    RecordCleanupSlow(info, nodes, bytes);
+  }
+  static void RecordStringBlockStats(ThreadSafeArenaStats* info,
+                                     size_t allocated, size_t unused) {
+    if (PROTOBUF_PREDICT_TRUE(info == nullptr)) return;
+    RecordStringBlockSlow(info, allocated, unused);
+  }
+  static void RecordMessageStats(ThreadSafeArenaStats* info,
+                                 absl::string_view type_name, size_t bytes) {
+    if (PROTOBUF_PREDICT_TRUE(info == nullptr)) return;
+    RecordMessageSlow(info, type_name, bytes);
+  }
+  static void RecordSerialArenaLookupStats(ThreadSafeArenaStats* info,
+                                           bool created, bool grew_chunks) {
+    if (PROTOBUF_PREDICT_TRUE(info == nullptr)) return;
+    RecordSerialArenaLookupSlow(info, created, grew_chunks);
+  }
 
   // Returns the bin for the provided size.
   static size_t FindBin(size_t bytes);
@@ -190,6 +260,18 @@ using SamplingState = int64_t;
 struct ThreadSafeArenaStats {
   static void RecordAllocateStats(ThreadSafeArenaStats*, size_t /*requested*/,
                                   size_t /*allocated*/, size_t /*wasted*/) {}
+  static void RecordBlockCacheStats(ThreadSafeArenaStats*, bool /*hit*/) {}
+  static void RecordCleanupStats(ThreadSafeArenaStats*, size_t /*nodes*/,
+                                 size_t /*bytes*/) {}
+  static void RecordStringBlockStats(ThreadSafeArenaStats*,
+                                     size_t /*allocated*/,
+                                     size_t /*unused*/) {}
+  static void RecordMessageStats(ThreadSafeArenaStats*,
+                                 absl::string_view /*type_name*/,
+                                 size_t /*bytes*/) {}
+  static void RecordSerialArenaLookupStats(ThreadSafeArenaStats*,
+                                           bool /*created*/,
+                                           bool /*grew_chunks*/) {}
 };
 
 ThreadSafeArenaStats* SampleSlow(SamplingState& next_sample);
@@ -205,6 +205,86 @@ TEST(ThreadSafeArenaStatsTest, RecordAllocateSlowMaxBlockSizeTest) {
   EXPECT_EQ(info.max_block_size.load(std::memory_order_relaxed), 256);
 }
 
+TEST(ThreadSafeArenaStatsTest, RecordBlockCacheSlow) {
+  ThreadSafeArenaStats info;
+  constexpr int64_t kTestStride = 458;
+  absl::MutexLock l(&info.init_mu);
+  info.PrepareForSampling(kTestStride);
+  RecordBlockCacheSlow(&info, /*hit=*/true);
+  RecordBlockCacheSlow(&info, /*hit=*/false);
+  RecordBlockCacheSlow(&info, /*hit=*/true);
+  EXPECT_EQ(info.block_cache_hits.load(std::memory_order_relaxed), 2);
+  EXPECT_EQ(info.block_cache_misses.load(std::memory_order_relaxed), 1);
+
+  info.PrepareForSampling(kTestStride);
+  EXPECT_EQ(info.block_cache_hits.load(std::memory_order_relaxed), 0);
+  EXPECT_EQ(info.block_cache_misses.load(std::memory_order_relaxed), 0);
+}
+
+TEST(ThreadSafeArenaStatsTest, RecordCleanupAndStringBlockSlow) {
+  ThreadSafeArenaStats info;
+  constexpr int64_t kTestStride = 458;
+  absl::MutexLock l(&info.init_mu);
+  info.PrepareForSampling(kTestStride);
+  RecordCleanupSlow(&info, /*nodes=*/3, /*bytes=*/40);
+  RecordCleanupSlow(&info, /*nodes=*/1, /*bytes=*/16);
+  RecordStringBlockSlow(&info, /*allocated=*/256, /*unused=*/0);
+  RecordStringBlockSlow(&info, /*allocated=*/0, /*unused=*/96);
+  EXPECT_EQ(info.cleanup_nodes.load(std::memory_order_relaxed), 4);
+  EXPECT_EQ(info.cleanup_bytes.load(std::memory_order_relaxed), 56);
+  EXPECT_EQ(info.string_blocks.load(std::memory_order_relaxed), 1);
+  EXPECT_EQ(info.string_block_bytes.load(std::memory_order_relaxed), 256);
+  EXPECT_EQ(info.string_block_unused_bytes.load(std::memory_order_relaxed),
+            96);
+
+  info.PrepareForSampling(kTestStride);
+  EXPECT_EQ(info.cleanup_nodes.load(std::memory_order_relaxed), 0);
+  EXPECT_EQ(info.cleanup_bytes.load(std::memory_order_relaxed), 0);
+  EXPECT_EQ(info.string_blocks.load(std::memory_order_relaxed), 0);
+  EXPECT_EQ(info.string_block_bytes.load(std::memory_order_relaxed), 0);
+  EXPECT_EQ(info.string_block_unused_bytes.load(std::memory_order_relaxed), 0);
+}
+
+TEST(ThreadSafeArenaStatsTest, RecordSerialArenaLookupSlow) {
+  ThreadSafeArenaStats info;
+  constexpr int64_t kTestStride = 458;
+  absl::MutexLock l(&info.init_mu);
+  info.PrepareForSampling(kTestStride);
+  RecordSerialArenaLookupSlow(&info, /*created=*/true, /*grew_chunks=*/true);
+  RecordSerialArenaLookupSlow(&info, /*created=*/true, /*grew_chunks=*/false);
+  RecordSerialArenaLookupSlow(&info, /*created=*/false, /*grew_chunks=*/false);
+  EXPECT_EQ(info.serial_arena_lookups.load(std::memory_order_relaxed), 3);
+  EXPECT_EQ(info.serial_arenas_created.load(std::memory_order_relaxed), 2);
+  EXPECT_EQ(info.serial_arena_chunks_grown.load(std::memory_order_relaxed), 1);
+
+  info.PrepareForSampling(kTestStride);
+  EXPECT_EQ(info.serial_arena_lookups.load(std::memory_order_relaxed), 0);
+  EXPECT_EQ(info.serial_arenas_created.load(std::memory_order_relaxed), 0);
+  EXPECT_EQ(info.serial_arena_chunks_grown.load(std::memory_order_relaxed), 0);
+}
+
+TEST(ThreadSafeArenaStatsTest, RecordMessageSlow) {
+  ThreadSafeArenaStats info;
+  constexpr int64_t kTestStride = 458;
+  absl::MutexLock l(&info.init_mu);
+  info.PrepareForSampling(kTestStride);
+  RecordMessageSlow(&info, "pkg.Foo", 48);
+  RecordMessageSlow(&info, "pkg.Bar", 24);
+  RecordMessageSlow(&info, "pkg.Foo", 48);
+  {
+    absl::MutexLock lock(&info.message_mu);
+    ASSERT_EQ(info.message_stats.size(), 2);
+    EXPECT_EQ(info.message_stats["pkg.Foo"].count, 2);
+    EXPECT_EQ(info.message_stats["pkg.Foo"].bytes, 96);
+    EXPECT_EQ(info.message_stats["pkg.Bar"].count, 1);
+    EXPECT_EQ(info.message_stats["pkg.Bar"].bytes, 24);
+  }
+
+  info.PrepareForSampling(kTestStride);
+  absl::MutexLock lock(&info.message_mu);
+  EXPECT_TRUE(info.message_stats.empty());
+}
+
 TEST(ThreadSafeArenazSamplerTest, SamplingCorrectness) {
   SetThreadSafeArenazEnabled(true);
   for (int p = 0; p <= 15; ++p) {
@@ -438,6 +518,33 @@ TEST(ThreadSafeArenazSamplerTest, InitialBlockReportsZeroUsedAndWasted) {
   SetThreadSafeArenazSampleParameter(oldparam);
 }
 
+TEST(ThreadSafeArenazSamplerTest, AttributesMessagesToType) {
+  SetThreadSafeArenazEnabled(true);
+  int32_t oldparam = ThreadSafeArenazSampleParameter();
+  SetThreadSafeArenazSampleParameter(1);
+  SetThreadSafeArenazGlobalNextSample(0);
+  using Message = protobuf_test_messages::proto2::TestAllTypesProto2;
+  const absl::string_view type_name = Message::descriptor()->full_name();
+  int count_found = 0;
+  auto& sampler = GlobalThreadSafeArenazSampler();
+  for (int i = 0; i < 10; ++i) {
+    google::protobuf::Arena arena;
+    for (int j = 0; j < 3; ++j) {
+      google::protobuf::Arena::CreateMessage<Message>(&arena);
+    }
+    sampler.Iterate([&](const ThreadSafeArenaStats& h) {
+      absl::MutexLock lock(&h.message_mu);
+      auto it = h.message_stats.find(type_name);
+      if (it == h.message_stats.end()) return;
+      count_found++;
+      EXPECT_EQ(it->second.count, 3);
+      EXPECT_EQ(it->second.bytes, 3 * sizeof(Message));
+    });
+  }
+  EXPECT_GT(count_found, 0);
+  SetThreadSafeArenazSampleParameter(oldparam);
+}
+
 class ThreadSafeArenazSamplerTestThread : public Thread {
  protected:
   void Run() override {
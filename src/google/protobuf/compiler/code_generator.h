@@ -132,6 +132,14 @@ class PROTOC_EXPORT CodeGenerator {
   // method can be removed.
   virtual bool HasGenerateAll() const { return true; }
 
+  // Implement this to return true if generating one file never depends on
+  // the output for another: each call only creates that file's own outputs
+  // with GeneratorContext::Open() and no state is kept between calls.  When
+  // protoc is run with --jobs, such generators may have GenerateAll() called
+  // concurrently, one file at a time, with independent GeneratorContexts
+  // whose contents are merged afterwards in input file order.
+  virtual bool SupportsConcurrentFileGeneration() const { return false; }
+
   // Returns all the feature extensions used by this generator.  This must be in
   // the generated pool, meaning that the extensions should be linked into this
   // binary.  Any generator features not included here will not get properly
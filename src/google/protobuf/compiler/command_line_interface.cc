@@ -34,6 +34,8 @@
 
 #include "google/protobuf/compiler/command_line_interface.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdlib>
 
 #include "absl/algorithm/container.h"
@@ -72,6 +74,7 @@
 
 #include <memory>
 #include <string>
+#include <thread>  // NOLINT
 #include <utility>
 #include <vector>
 
@@ -86,6 +89,7 @@
 #include "absl/log/absl_log.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_replace.h"
 #include "absl/strings/str_split.h"
@@ -478,6 +482,10 @@ class CommandLineInterface::GeneratorContextImpl : public GeneratorContext {
 
   // Get name of all output files.
   void GetOutputFilenames(std::vector<std::string>* output_filenames);
+
+  // Moves all files out of `other` into this directory.  As with Open(), it is
+  // an error for a file to be present in both.
+  void MergeFrom(GeneratorContextImpl& other);
   // implements GeneratorContext --------------------------------------
   io::ZeroCopyOutputStream* Open(const std::string& filename) override;
   io::ZeroCopyOutputStream* OpenForAppend(const std::string& filename) override;
@@ -698,6 +706,22 @@ void CommandLineInterface::GeneratorContextImpl::GetOutputFilenames(
   }
 }
 
+void CommandLineInterface::GeneratorContextImpl::MergeFrom(
+    GeneratorContextImpl& other) {
+  had_error_ |= other.had_error_;
+  for (auto& pair : other.files_) {
+    auto it = files_.insert({pair.first, ""});
+    if (!it.second) {
+      std::cerr << pair.first << ": Tried to write the same file twice."
+                << std::endl;
+      had_error_ = true;
+      continue;
+    }
+    it.first->second.swap(pair.second);
+  }
+  other.files_.clear();
+}
+
 io::ZeroCopyOutputStream* CommandLineInterface::GeneratorContextImpl::Open(
     const std::string& filename) {
   return new MemoryOutputStream(this, filename, false);
@@ -1266,6 +1290,9 @@ int CommandLineInterface::Run(int argc, const char* const argv[]) {
     source_tree_database.reset(new SourceTreeDescriptorDatabase(
         disk_source_tree.get(), descriptor_set_in_database.get()));
     source_tree_database->RecordErrorsTo(error_collector.get());
+    if (!parse_cache_dir_.empty()) {
+      source_tree_database->SetParseCacheDirectory(parse_cache_dir_);
+    }
 
     descriptor_pool.reset(new DescriptorPool(
         source_tree_database.get(),
@@ -1349,6 +1376,8 @@ int CommandLineInterface::Run(int argc, const char* const argv[]) {
 
   // Generate output.
   if (mode_ == MODE_COMPILE) {
+    std::vector<std::pair<const OutputDirective*, GeneratorContextImpl*>>
+        directives;
     for (int i = 0; i < output_directives_.size(); i++) {
       std::string output_location = output_directives_[i].output_location;
       if (!absl::EndsWith(output_location, ".zip") &&
@@ -1363,11 +1392,20 @@ int CommandLineInterface::Run(int argc, const char* const argv[]) {
         // First time we've seen this output location.
         generator = std::make_unique<GeneratorContextImpl>(parsed_files);
       }
+      directives.emplace_back(&output_directives_[i], generator.get());
+    }
 
-      if (!GenerateOutput(parsed_files, output_directives_[i],
-                          generator.get())) {
+    if (jobs_ > 1) {
+      if (!GenerateOutputInParallel(parsed_files, directives)) {
         return 1;
       }
+    } else {
+      for (const auto& directive : directives) {
+        if (!GenerateOutput(parsed_files, *directive.first, directive.second,
+                            /*jobs=*/1)) {
+          return 1;
+        }
+      }
     }
   }
 
@@ -1682,6 +1720,7 @@ void CommandLineInterface::Clear() {
   descriptor_set_in_names_.clear();
   descriptor_set_out_name_.clear();
   dependency_out_name_.clear();
+  parse_cache_dir_.clear();
 
   experimental_editions_ = false;
 
@@ -1693,6 +1732,7 @@ void CommandLineInterface::Clear() {
   disallow_services_ = false;
   direct_dependencies_explicitly_set_ = false;
   deterministic_output_ = false;
+  jobs_ = 1;
 }
 
 bool CommandLineInterface::MakeProtoProtoPathRelative(
@@ -2183,6 +2223,13 @@ CommandLineInterface::InterpretArgument(const std::string& name,
     }
     dependency_out_name_ = value;
 
+  } else if (name == "--parse_cache_dir") {
+    if (value.empty()) {
+      std::cerr << name << " requires a non-empty value." << std::endl;
+      return PARSE_ARGUMENT_FAIL;
+    }
+    parse_cache_dir_ = value;
+
   } else if (name == "--include_imports") {
     if (imports_in_descriptor_set_) {
       std::cerr << name << " may only be passed once." << std::endl;
@@ -2265,6 +2312,13 @@ CommandLineInterface::InterpretArgument(const std::string& name,
       return PARSE_ARGUMENT_FAIL;
     }
 
+  } else if (name == "--jobs") {
+    if (!absl::SimpleAtoi(value, &jobs_) || jobs_ < 1) {
+      std::cerr << name << " requires a positive number of jobs, got: "
+                << value << std::endl;
+      return PARSE_ARGUMENT_FAIL;
+    }
+
   } else if (name == "--fatal_warnings") {
     if (fatal_warnings_) {
       std::cerr << name << " may only be passed once." << std::endl;
@@ -2454,6 +2508,9 @@ Parse PROTO_FILES and generate output based on the options given:
   --dependency_out=FILE       Write a dependency output file in the format
                               expected by make. This writes the transitive
                               set of input file paths to FILE
+  --parse_cache_dir=DIR       Cache parsed .proto files in DIR, which must
+                              exist.  Later runs using the same DIR skip
+                              parsing files whose contents are unchanged.
   --error_format=FORMAT       Set the format in which to print errors.
                               FORMAT may be 'gcc' (the default) or 'msvs'
                               (Microsoft Visual Studio format).
@@ -2461,6 +2518,11 @@ Parse PROTO_FILES and generate output based on the options given:
                               gcc). This flag will make protoc return
                               with a non-zero exit code if any warnings
                               are generated.
+  --jobs=N                    Run up to N code generators concurrently.
+                              Output locations are generated independently,
+                              and generators that support it also process
+                              input files in parallel.  Output is identical
+                              to that of a sequential run.
   --print_free_field_numbers  Print the free field numbers of the messages
                               defined in the given proto files. Extension ranges
                               are counted as occupied fields numbers.
@@ -2528,10 +2590,96 @@ bool CommandLineInterface::EnforceProto3OptionalSupport(
   return true;
 }
 
+namespace {
+
+// Calls `fn(i)` for each i in [0, count) on up to `jobs` threads, including
+// the calling one.
+void RunInParallel(int jobs, size_t count,
+                   const std::function<void(size_t)>& fn) {
+  std::atomic<size_t> next{0};
+  auto worker = [&] {
+    for (size_t i = next++; i < count; i = next++) {
+      fn(i);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < std::min(static_cast<size_t>(jobs), count); ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+}  // namespace
+
+bool CommandLineInterface::GenerateOutputInParallel(
+    const std::vector<const FileDescriptor*>& parsed_files,
+    const std::vector<std::pair<const OutputDirective*, GeneratorContextImpl*>>&
+        directives) {
+  // Directives sharing an output location may insert into each other's files,
+  // so they stay sequential.
+  std::vector<std::vector<const OutputDirective*>> groups;
+  std::vector<GeneratorContextImpl*> group_contexts;
+  absl::flat_hash_map<GeneratorContextImpl*, size_t> group_index;
+  for (const auto& directive : directives) {
+    auto it = group_index.insert({directive.second, groups.size()});
+    if (it.second) {
+      groups.emplace_back();
+      group_contexts.push_back(directive.second);
+    }
+    groups[it.first->second].push_back(directive.first);
+  }
+
+  // Split the remaining threads among the groups for per-file parallelism.
+  const int jobs_per_group =
+      std::max(1, jobs_ / static_cast<int>(std::max<size_t>(groups.size(), 1)));
+  std::atomic<bool> failed{false};
+  RunInParallel(jobs_, groups.size(), [&](size_t i) {
+    for (const OutputDirective* directive : groups[i]) {
+      if (failed) return;
+      if (!GenerateOutput(parsed_files, *directive, group_contexts[i],
+                          jobs_per_group)) {
+        failed = true;
+        return;
+      }
+    }
+  });
+  return !failed;
+}
+
+bool CommandLineInterface::GenerateFilesInParallel(
+    const std::vector<const FileDescriptor*>& parsed_files,
+    const CodeGenerator& generator, const std::string& parameter, int jobs,
+    GeneratorContextImpl* generator_context, std::string* error) {
+  std::vector<std::unique_ptr<GeneratorContextImpl>> contexts(
+      parsed_files.size());
+  std::vector<std::string> errors(parsed_files.size());
+  std::unique_ptr<bool[]> succeeded(new bool[parsed_files.size()]());
+  RunInParallel(jobs, parsed_files.size(), [&](size_t i) {
+    contexts[i] = std::make_unique<GeneratorContextImpl>(parsed_files);
+    succeeded[i] = generator.GenerateAll({parsed_files[i]}, parameter,
+                                         contexts[i].get(), &errors[i]);
+  });
+
+  // Report the first failure in file order, as a sequential run would.
+  for (size_t i = 0; i < parsed_files.size(); i++) {
+    if (!succeeded[i]) {
+      *error = std::move(errors[i]);
+      return false;
+    }
+  }
+  for (const auto& context : contexts) {
+    generator_context->MergeFrom(*context);
+  }
+  return true;
+}
+
 bool CommandLineInterface::GenerateOutput(
     const std::vector<const FileDescriptor*>& parsed_files,
     const OutputDirective& output_directive,
-    GeneratorContext* generator_context) {
+    GeneratorContextImpl* generator_context, int jobs) {
   // Call the generator.
   std::string error;
   if (output_directive.generator == nullptr) {
@@ -2542,11 +2690,15 @@ bool CommandLineInterface::GenerateOutput(
 
     std::string plugin_name = PluginName(plugin_prefix_, output_directive.name);
     std::string parameters = output_directive.parameter;
-    if (!plugin_parameters_[plugin_name].empty()) {
+    // Use find() rather than operator[]: with --jobs several directives are
+    // generated concurrently.
+    auto plugin_parameter = plugin_parameters_.find(plugin_name);
+    if (plugin_parameter != plugin_parameters_.end() &&
+        !plugin_parameter->second.empty()) {
       if (!parameters.empty()) {
         parameters.append(",");
       }
-      parameters.append(plugin_parameters_[plugin_name]);
+      parameters.append(plugin_parameter->second);
     }
     if (!GeneratePluginOutput(parsed_files, plugin_name, parameters,
                               generator_context, &error)) {
@@ -2556,11 +2708,14 @@ bool CommandLineInterface::GenerateOutput(
   } else {
     // Regular generator.
     std::string parameters = output_directive.parameter;
-    if (!generator_parameters_[output_directive.name].empty()) {
+    auto generator_parameter =
+        generator_parameters_.find(output_directive.name);
+    if (generator_parameter != generator_parameters_.end() &&
+        !generator_parameter->second.empty()) {
       if (!parameters.empty()) {
         parameters.append(",");
       }
-      parameters.append(generator_parameters_[output_directive.name]);
+      parameters.append(generator_parameter->second);
     }
     if (!EnforceProto3OptionalSupport(
             output_directive.name,
@@ -2574,8 +2729,17 @@ bool CommandLineInterface::GenerateOutput(
       return false;
     }
 
-    if (!output_directive.generator->GenerateAll(parsed_files, parameters,
-                                                 generator_context, &error)) {
+    bool succeeded;
+    if (jobs > 1 && parsed_files.size() > 1 &&
+        output_directive.generator->SupportsConcurrentFileGeneration()) {
+      succeeded =
+          GenerateFilesInParallel(parsed_files, *output_directive.generator,
+                                  parameters, jobs, generator_context, &error);
+    } else {
+      succeeded = output_directive.generator->GenerateAll(
+          parsed_files, parameters, generator_context, &error);
+    }
+    if (!succeeded) {
       // Generator returned an error.
       std::cerr << output_directive.name << ": " << error << std::endl;
       return false;
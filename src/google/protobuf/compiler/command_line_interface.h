@@ -296,9 +296,25 @@ class PROTOC_EXPORT CommandLineInterface {
 
   // Generate the given output file from the given input.
   struct OutputDirective;  // see below
+  // At most `jobs` threads are used to generate files concurrently when the
+  // generator supports it.
   bool GenerateOutput(const std::vector<const FileDescriptor*>& parsed_files,
                       const OutputDirective& output_directive,
-                      GeneratorContext* generator_context);
+                      GeneratorContextImpl* generator_context, int jobs);
+  // Implements --jobs: runs the directives for each output location on their
+  // own thread, in command-line order within a location so that insertion
+  // points keep working.
+  bool GenerateOutputInParallel(
+      const std::vector<const FileDescriptor*>& parsed_files,
+      const std::vector<std::pair<const OutputDirective*,
+                                  GeneratorContextImpl*>>& directives);
+  // Runs `generator` over each of `files` on up to `jobs` threads, each file
+  // into its own context, then merges the results into `generator_context`
+  // in file order.
+  bool GenerateFilesInParallel(
+      const std::vector<const FileDescriptor*>& parsed_files,
+      const CodeGenerator& generator, const std::string& parameter, int jobs,
+      GeneratorContextImpl* generator_context, std::string* error);
   bool GeneratePluginOutput(
       const std::vector<const FileDescriptor*>& parsed_files,
       const std::string& plugin_name, const std::string& parameter,
@@ -413,6 +429,9 @@ class PROTOC_EXPORT CommandLineInterface {
   // True if we should treat warnings as errors that fail the compilation.
   bool fatal_warnings_ = false;
 
+  // Maximum number of threads used for code generation (--jobs).
+  int jobs_ = 1;
+
   std::vector<std::pair<std::string, std::string>>
       proto_path_;                        // Search path for proto files.
   std::vector<std::string> input_files_;  // Names of the input proto files.
@@ -452,6 +471,10 @@ class PROTOC_EXPORT CommandLineInterface {
   // dependency file will be written. Otherwise, empty.
   std::string dependency_out_name_;
 
+  // If --parse_cache_dir was given, parsed .proto files are cached there
+  // across runs.  Otherwise, empty.
+  std::string parse_cache_dir_;
+
   bool experimental_editions_ = false;
 
   // True if --include_imports was given, meaning that we should
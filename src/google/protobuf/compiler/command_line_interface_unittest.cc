@@ -37,6 +37,7 @@
 #include <sys/types.h>
 
 #include <cstdint>
+#include <cstdlib>
 
 #include <gmock/gmock.h>
 #include "absl/log/absl_check.h"
@@ -48,6 +49,9 @@
 #ifndef _MSC_VER
 #include <unistd.h>
 #endif
+#ifndef _WIN32
+#include <sys/wait.h>
+#endif
 #include <memory>
 #include <string>
 #include <utility>
@@ -68,8 +72,10 @@
 #include "google/protobuf/compiler/plugin.pb.h"
 #include "google/protobuf/compiler/subprocess.h"
 #include "google/protobuf/io/io_win32.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include "google/protobuf/test_textproto.h"
 #include "google/protobuf/test_util2.h"
+#include "google/protobuf/util/delimited_message_util.h"
 #include "google/protobuf/unittest.pb.h"
 #include "google/protobuf/unittest_custom_options.pb.h"
 
@@ -103,7 +109,9 @@ using google::protobuf::io::win32::write;
 
 namespace {
 
-std::string CreatePluginArg() {
+// Returns the path of the test_plugin binary, or an empty string if it cannot
+// be found.
+std::string FindTestPluginPath() {
   std::string plugin_path;
 #ifdef GOOGLE_PROTOBUF_TEST_PLUGIN_PATH
   plugin_path = GOOGLE_PROTOBUF_TEST_PLUGIN_PATH;
@@ -142,6 +150,12 @@ std::string CreatePluginArg() {
         << plugin_path;
     return "";
   }
+  return plugin_path;
+}
+
+std::string CreatePluginArg() {
+  std::string plugin_path = FindTestPluginPath();
+  if (plugin_path.empty()) return "";
   return absl::StrCat("--plugin=prefix-gen-plug=", plugin_path);
 }
 
@@ -614,6 +628,30 @@ TEST_F(CommandLineInterfaceTest, MultipleInputs) {
                                     "bar.proto", "Bar");
 }
 
+TEST_F(CommandLineInterfaceTest, MultipleInputsWithJobs) {
+  // Test that --jobs produces the same output as a sequential run.
+
+  CreateTempFile("foo.proto",
+                 "syntax = \"proto2\";\n"
+                 "message Foo {}\n");
+  CreateTempFile("bar.proto",
+                 "syntax = \"proto2\";\n"
+                 "message Bar {}\n");
+
+  Run("protocol_compiler --jobs=4 --test_out=$tmpdir --plug_out=$tmpdir "
+      "--proto_path=$tmpdir foo.proto bar.proto");
+
+  ExpectNoErrors();
+  ExpectGeneratedWithMultipleInputs("test_generator", "foo.proto,bar.proto",
+                                    "foo.proto", "Foo");
+  ExpectGeneratedWithMultipleInputs("test_generator", "foo.proto,bar.proto",
+                                    "bar.proto", "Bar");
+  ExpectGeneratedWithMultipleInputs("test_plugin", "foo.proto,bar.proto",
+                                    "foo.proto", "Foo");
+  ExpectGeneratedWithMultipleInputs("test_plugin", "foo.proto,bar.proto",
+                                    "bar.proto", "Bar");
+}
+
 TEST_F(CommandLineInterfaceTest, MultipleInputs_DescriptorSetIn) {
   // Test parsing multiple input files.
   FileDescriptorSet file_descriptor_set;
@@ -2718,6 +2756,154 @@ TEST_F(CommandLineInterfaceTest, GeneratorPluginNotAllowed) {
   ExpectErrorSubstring("Unknown flag: --plug_out");
 }
 
+#ifndef _WIN32
+// Runs test_plugin as a persistent worker, feeding it `input` on stdin.
+// Returns its exit status and stores what it wrote to stdout in `output`.
+int RunPersistentPlugin(absl::string_view temp_directory,
+                        absl::string_view input, std::string* output) {
+  std::string plugin_path = FindTestPluginPath();
+  std::string input_path = absl::StrCat(temp_directory, "/requests");
+  std::string output_path = absl::StrCat(temp_directory, "/responses");
+  ABSL_CHECK_OK(File::SetContents(input_path, input, true));
+  int status =
+      std::system(absl::StrCat("'", plugin_path, "' --persistent < '",
+                               input_path, "' > '", output_path, "'")
+                      .c_str());
+  ABSL_CHECK_OK(File::GetContents(output_path, output, true));
+  return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+std::string FrameRequests(const std::vector<CodeGeneratorRequest>& requests) {
+  std::string framed;
+  io::StringOutputStream output(&framed);
+  for (const CodeGeneratorRequest& request : requests) {
+    ABSL_CHECK(util::SerializeDelimitedToZeroCopyStream(request, &output));
+  }
+  return framed;
+}
+
+// Parses the length-delimited responses in `framed`, failing the test if
+// anything follows the last complete one.
+std::vector<CodeGeneratorResponse> ParseResponses(absl::string_view framed) {
+  std::vector<CodeGeneratorResponse> responses;
+  io::ArrayInputStream input(framed.data(), static_cast<int>(framed.size()));
+  while (true) {
+    CodeGeneratorResponse response;
+    bool clean_eof = false;
+    if (!util::ParseDelimitedFromZeroCopyStream(&response, &input,
+                                                &clean_eof)) {
+      EXPECT_TRUE(clean_eof) << "Malformed response framing";
+      return responses;
+    }
+    responses.push_back(std::move(response));
+  }
+}
+
+CodeGeneratorRequest MakeRequest(absl::string_view file_to_generate) {
+  CodeGeneratorRequest request;
+  request.add_file_to_generate(std::string(file_to_generate));
+  return request;
+}
+
+void AddFile(CodeGeneratorRequest* request, absl::string_view name,
+             absl::string_view message_name,
+             absl::string_view dependency = "") {
+  FileDescriptorProto* file = request->add_proto_file();
+  file->set_name(std::string(name));
+  file->set_syntax("proto2");
+  file->add_message_type()->set_name(std::string(message_name));
+  if (!dependency.empty()) file->add_dependency(std::string(dependency));
+}
+
+TEST_F(CommandLineInterfaceTest, PersistentPluginServesEveryRequest) {
+  std::vector<CodeGeneratorRequest> requests;
+  // A plain request.
+  requests.push_back(MakeRequest("foo.proto"));
+  AddFile(&requests.back(), "foo.proto", "Foo");
+  // foo.proto was sent before, so bar.proto may leave it out.
+  requests.push_back(MakeRequest("bar.proto"));
+  AddFile(&requests.back(), "bar.proto", "Bar", "foo.proto");
+  // foo.proto changes, which discards bar.proto.
+  requests.push_back(MakeRequest("foo.proto"));
+  AddFile(&requests.back(), "foo.proto", "Foo2");
+  requests.push_back(MakeRequest("bar.proto"));
+
+  std::string output;
+  ASSERT_EQ(
+      RunPersistentPlugin(temp_directory(), FrameRequests(requests), &output),
+      0);
+  std::vector<CodeGeneratorResponse> responses = ParseResponses(output);
+  ASSERT_EQ(responses.size(), 4);
+
+  EXPECT_FALSE(responses[0].has_error()) << responses[0].error();
+  ASSERT_EQ(responses[0].file_size(), 1);
+  EXPECT_EQ(responses[0].file(0).name(),
+            "foo.proto.MockCodeGenerator.test_plugin");
+  EXPECT_THAT(responses[0].file(0).content(), testing::HasSubstr("Foo"));
+
+  EXPECT_FALSE(responses[1].has_error()) << responses[1].error();
+  ASSERT_EQ(responses[1].file_size(), 1);
+  EXPECT_EQ(responses[1].file(0).name(),
+            "bar.proto.MockCodeGenerator.test_plugin");
+
+  EXPECT_FALSE(responses[2].has_error()) << responses[2].error();
+  ASSERT_EQ(responses[2].file_size(), 1);
+  EXPECT_THAT(responses[2].file(0).content(), testing::HasSubstr("Foo2"));
+
+  EXPECT_THAT(responses[3].error(),
+              testing::HasSubstr(
+                  "did not provide a descriptor for the file: bar.proto"));
+  EXPECT_EQ(responses[3].file_size(), 0);
+}
+
+TEST_F(CommandLineInterfaceTest, PersistentPluginKeepsServingAfterErrors) {
+  std::vector<CodeGeneratorRequest> requests;
+  // The generator fails.
+  requests.push_back(MakeRequest("error.proto"));
+  AddFile(&requests.back(), "error.proto", "MockCodeGenerator_Error");
+  // The descriptor does not build.
+  requests.push_back(MakeRequest("bad.proto"));
+  AddFile(&requests.back(), "bad.proto", "Bad", "missing.proto");
+  requests.push_back(MakeRequest("foo.proto"));
+  AddFile(&requests.back(), "foo.proto", "Foo");
+
+  std::string output;
+  ASSERT_EQ(
+      RunPersistentPlugin(temp_directory(), FrameRequests(requests), &output),
+      0);
+  std::vector<CodeGeneratorResponse> responses = ParseResponses(output);
+  ASSERT_EQ(responses.size(), 3);
+  EXPECT_EQ(responses[0].error(),
+            "error.proto: Saw message type MockCodeGenerator_Error.");
+  EXPECT_EQ(responses[1].error(),
+            "failed to build descriptor for file: bad.proto");
+  EXPECT_FALSE(responses[2].has_error()) << responses[2].error();
+  EXPECT_EQ(responses[2].file_size(), 1);
+}
+
+TEST_F(CommandLineInterfaceTest, PersistentPluginRejectsTruncatedRequest) {
+  std::vector<CodeGeneratorRequest> requests;
+  requests.push_back(MakeRequest("foo.proto"));
+  AddFile(&requests.back(), "foo.proto", "Foo");
+  std::string input = FrameRequests(requests);
+  // A second request whose length prefix promises more bytes than follow.
+  input += FrameRequests(requests).substr(0, 5);
+
+  std::string output;
+  EXPECT_EQ(RunPersistentPlugin(temp_directory(), input, &output), 1);
+  // The complete request before it was still answered.
+  std::vector<CodeGeneratorResponse> responses = ParseResponses(output);
+  ASSERT_EQ(responses.size(), 1);
+  EXPECT_FALSE(responses[0].has_error()) << responses[0].error();
+}
+
+TEST_F(CommandLineInterfaceTest, PersistentPluginExitsOnEmptyInput) {
+  std::string output;
+  EXPECT_EQ(RunPersistentPlugin(temp_directory(), "", &output), 0);
+  EXPECT_EQ(output, "");
+}
+#endif  // !_WIN32
+
 TEST_F(CommandLineInterfaceTest, HelpText) {
   Run("test_exec_name --help");
 
@@ -2771,6 +2957,17 @@ TEST_F(CommandLineInterfaceTest, InvalidErrorFormat) {
   ExpectErrorText("Unknown error format: invalid\n");
 }
 
+TEST_F(CommandLineInterfaceTest, InvalidJobs) {
+  CreateTempFile("foo.proto",
+                 "syntax = \"proto2\";\n"
+                 "message Foo {}\n");
+
+  Run("protocol_compiler --test_out=$tmpdir "
+      "--proto_path=$tmpdir --jobs=0 foo.proto");
+
+  ExpectErrorText("--jobs requires a positive number of jobs, got: 0\n");
+}
+
 TEST_F(CommandLineInterfaceTest, Warnings) {
   // Test --fatal_warnings.
 
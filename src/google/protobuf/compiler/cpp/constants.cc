@@ -0,0 +1,209 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "google/protobuf/compiler/cpp/constants.h"
+
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/log/absl_log.h"
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+#include "google/protobuf/compiler/cpp/helpers.h"
+#include "google/protobuf/compiler/cpp/options.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+#include "google/protobuf/text_format.h"
+
+namespace google {
+namespace protobuf {
+namespace compiler {
+namespace cpp {
+namespace {
+
+absl::StatusOr<std::string> ReadFile(absl::string_view path) {
+  std::ifstream stream{std::string(path)};
+  if (!stream) {
+    return absl::InvalidArgumentError(absl::StrCat("Unable to read ", path));
+  }
+  std::stringstream content;
+  content << stream.rdbuf();
+  return content.str();
+}
+
+bool IsIdentifier(absl::string_view name) {
+  if (name.empty() || absl::ascii_isdigit(name[0])) return false;
+  for (char c : name) {
+    if (!absl::ascii_isalnum(c) && c != '_') return false;
+  }
+  return true;
+}
+
+absl::Status CheckValue(const Message& value, const Options& options) {
+  const Descriptor* descriptor = value.GetDescriptor();
+  if (!MessageConstants::CanBeConstant(descriptor, options)) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Messages of type ", descriptor->full_name(), " cannot be constants"));
+  }
+  const Reflection* reflection = value.GetReflection();
+  std::vector<const FieldDescriptor*> fields;
+  reflection->ListFields(value, &fields);
+  for (const FieldDescriptor* field : fields) {
+    if (!MessageConstants::IsConstantField(field)) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Field ", field->full_name(), " cannot be set in a constant"));
+    }
+    if (field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) continue;
+    if (field->message_type()->file() != descriptor->file()) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Field ", field->full_name(),
+                       " of a constant must have a type defined in ",
+                       descriptor->file()->name()));
+    }
+    absl::Status status =
+        CheckValue(reflection->GetMessage(value, field), options);
+    if (!status.ok()) return status;
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<MessageConstants>> MessageConstants::Load(
+    absl::string_view manifest_path, const FileDescriptor* file,
+    const Options& options) {
+  absl::StatusOr<std::string> manifest = ReadFile(manifest_path);
+  if (!manifest.ok()) return manifest.status();
+
+  auto constants = absl::WrapUnique(new MessageConstants(file->pool()));
+  absl::flat_hash_set<std::string> names;
+  int line_number = 0;
+  for (absl::string_view line : absl::StrSplit(*manifest, '\n')) {
+    ++line_number;
+    line = absl::StripAsciiWhitespace(line);
+    if (line.empty() || line[0] == '#') continue;
+
+    std::vector<absl::string_view> parts =
+        absl::StrSplit(line, ' ', absl::SkipEmpty());
+    if (parts.size() != 3 || !IsIdentifier(parts[0])) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Invalid constants entry on line ", line_number, ": \"",
+                       line, "\""));
+    }
+    const Descriptor* descriptor =
+        file->pool()->FindMessageTypeByName(parts[1]);
+    if (descriptor == nullptr || descriptor->file() != file) continue;
+    if (!names.insert(std::string(parts[0])).second) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Duplicate constant ", parts[0], " on line ",
+                       line_number));
+    }
+
+    absl::StatusOr<std::string> text = ReadFile(parts[2]);
+    if (!text.ok()) return text.status();
+    std::unique_ptr<Message> value(
+        constants->factory_.GetPrototype(descriptor)->New());
+    if (!TextFormat::ParseFromString(*text, value.get())) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Unable to parse ", parts[2], " as ", descriptor->full_name()));
+    }
+    absl::Status status = CheckValue(*value, options);
+    if (!status.ok()) {
+      return absl::InvalidArgumentError(
+          absl::StrCat(parts[2], ": ", status.message()));
+    }
+
+    constants->constants_.push_back(
+        {std::string(parts[0]), std::string(parts[2]), value.get()});
+    constants->values_.push_back(std::move(value));
+  }
+  return constants;
+}
+
+bool MessageConstants::CanBeConstant(const Descriptor* descriptor,
+                                     const Options& options) {
+  return ShouldGenerateClass(descriptor, options) &&
+         !IsMapEntryMessage(descriptor) && HasImplData(descriptor, options) &&
+         !HasSimpleBaseClass(descriptor, options) &&
+         !ShouldSplit(descriptor, options) &&
+         !IsAnyMessage(descriptor, options);
+}
+
+bool MessageConstants::IsConstantField(const FieldDescriptor* field) {
+  return !field->is_repeated() && !field->is_extension() &&
+         field->real_containing_oneof() == nullptr &&
+         field->cpp_type() != FieldDescriptor::CPPTYPE_STRING &&
+         !field->options().weak();
+}
+
+std::string MessageConstants::ValueLiteral(const Message& message,
+                                           const FieldDescriptor* field) {
+  const Reflection* reflection = message.GetReflection();
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      return Int32ToString(reflection->GetInt32(message, field));
+    case FieldDescriptor::CPPTYPE_UINT32:
+      return absl::StrCat(reflection->GetUInt32(message, field), "u");
+    case FieldDescriptor::CPPTYPE_INT64:
+      return Int64ToString(reflection->GetInt64(message, field));
+    case FieldDescriptor::CPPTYPE_UINT64:
+      return UInt64ToString(reflection->GetUInt64(message, field));
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      return DoubleToString(reflection->GetDouble(message, field));
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      return FloatToString(reflection->GetFloat(message, field));
+    case FieldDescriptor::CPPTYPE_BOOL:
+      return reflection->GetBool(message, field) ? "true" : "false";
+    case FieldDescriptor::CPPTYPE_ENUM:
+      return Int32ToString(reflection->GetEnumValue(message, field));
+    case FieldDescriptor::CPPTYPE_STRING:
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      break;
+  }
+  ABSL_LOG(FATAL) << "Not a scalar field: " << field->full_name();
+  return "";
+}
+
+}  // namespace cpp
+}  // namespace compiler
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,108 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef GOOGLE_PROTOBUF_COMPILER_CPP_CONSTANTS_H__
+#define GOOGLE_PROTOBUF_COMPILER_CPP_CONSTANTS_H__
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/compiler/cpp/options.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/dynamic_message.h"
+#include "google/protobuf/message.h"
+
+namespace google {
+namespace protobuf {
+namespace compiler {
+namespace cpp {
+
+// Message values that the generated code defines as constant-initialized
+// objects, so that a program can refer to them without parsing anything or
+// running a dynamic initializer.  They are listed in a manifest passed to the
+// generator with the `constants=<file>` option.
+//
+// The manifest has one `<C++ name> <message full name> <text format file>`
+// entry per line.  Blank lines and lines starting with '#' are ignored, as are
+// entries for messages that are not defined in the file being generated, so
+// one manifest can be shared by all the files of a target.
+//
+// Only values that C++ can constant-initialize are accepted: singular scalar
+// and enum fields, and singular sub-messages of types defined in the same
+// file that are themselves constants.  Values that set strings, repeated
+// fields, oneof members or extensions are rejected.
+class MessageConstants {
+ public:
+  struct Constant {
+    // Name of the constant in the namespace of the generated file.
+    std::string name;
+    // Text format file the value was parsed from.
+    std::string source;
+    const Message* value;
+  };
+
+  static absl::StatusOr<std::unique_ptr<MessageConstants>> Load(
+      absl::string_view manifest_path, const FileDescriptor* file,
+      const Options& options);
+
+  const std::vector<Constant>& constants() const { return constants_; }
+
+  // Returns true if messages of type `descriptor` can be constants, in which
+  // case they get a constexpr constructor taking a value for each of their
+  // constant fields.
+  static bool CanBeConstant(const Descriptor* descriptor,
+                            const Options& options);
+
+  // Returns true if `field` is a parameter of the constexpr constructor.
+  static bool IsConstantField(const FieldDescriptor* field);
+
+  // Returns code that evaluates to the value of the scalar or enum `field` of
+  // `message`.
+  static std::string ValueLiteral(const Message& message,
+                                  const FieldDescriptor* field);
+
+ private:
+  explicit MessageConstants(const DescriptorPool* pool) : factory_(pool) {}
+
+  DynamicMessageFactory factory_;
+  std::vector<std::unique_ptr<Message>> values_;
+  std::vector<Constant> constants_;
+};
+
+}  // namespace cpp
+}  // namespace compiler
+}  // namespace protobuf
+}  // namespace google
+
+#endif  // GOOGLE_PROTOBUF_COMPILER_CPP_CONSTANTS_H__
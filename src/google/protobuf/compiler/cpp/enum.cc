@@ -360,8 +360,10 @@ void EnumGenerator::GenerateMethods(int idx, io::Printer* p) {
   auto v = p->WithVars(EnumVars(enum_, options_, limits_.min, limits_.max));
 
   if (has_reflection_) {
-    p->Emit({{"idx", idx}}, R"cc(
-      const ::$proto_ns$::EnumDescriptor* $Msg_Enum$_descriptor() {
+    p->Emit({{"idx", idx},
+             {"cold", options_.cold_sections ? "PROTOBUF_COLD " : ""}},
+            R"cc(
+      $cold$const ::$proto_ns$::EnumDescriptor* $Msg_Enum$_descriptor() {
         ::$proto_ns$::internal::AssignDescriptors(&$desc_table$);
         return $file_level_enum_descriptors$[$idx$];
       }
@@ -235,6 +235,112 @@ void FieldGeneratorBase::GenerateCopyConstructorCode(io::Printer* p) const {
   }
 }
 
+void FieldGeneratorBase::GenerateSpaceUsedLong(io::Printer* p) const {
+  // Oneof members are only asked for their size while they are the active
+  // member; see MessageGenerator::GenerateSpaceUsedLong().
+  if (descriptor_->is_repeated()) {
+    p->Emit(R"cc(
+      total_size += $field_$.SpaceUsedExcludingSelfLong();
+    )cc");
+  } else if (is_message()) {
+    ABSL_CHECK(!is_lazy() && !is_weak());
+    if (is_oneof()) {
+      p->Emit(R"cc(
+        total_size += $field_$->SpaceUsedLong();
+      )cc");
+    } else {
+      p->Emit(R"cc(
+        if ($field_$ != nullptr) {
+          total_size += $field_$->SpaceUsedLong();
+        }
+      )cc");
+    }
+  } else if (IsCord(descriptor_)) {
+    if (is_oneof()) {
+      p->Emit(R"cc(
+        total_size += $field_$->EstimatedMemoryUsage();
+      )cc");
+    } else {
+      // sizeof(::absl::Cord) is already included in sizeof(*this).
+      p->Emit(R"cc(
+        total_size += $field_$.EstimatedMemoryUsage() - sizeof(::absl::Cord);
+      )cc");
+    }
+  } else if (is_string()) {
+    ABSL_CHECK(!IsStringPiece(descriptor_));
+    if (is_inlined()) {
+      p->Emit(R"cc(
+        total_size += ::_pbi::StringSpaceUsedExcludingSelfLong($field_$.Get());
+      )cc");
+    } else if (is_oneof()) {
+      // An active oneof member never points to the shared default.
+      p->Emit(R"cc(
+        total_size += sizeof(std::string) +
+                      ::_pbi::StringSpaceUsedExcludingSelfLong($field_$.Get());
+      )cc");
+    } else {
+      // Only count the string if it was changed from the default, which is
+      // shared.
+      p->Emit(R"cc(
+        if (!$field_$.IsDefault()) {
+          total_size += sizeof(std::string) +
+                        ::_pbi::StringSpaceUsedExcludingSelfLong($field_$.Get());
+        }
+      )cc");
+    }
+  }
+}
+
+void FieldGeneratorBase::GenerateEquals(io::Printer* p) const {
+  if (descriptor_->is_map()) {
+    p->Emit(R"cc(
+      if (!::_pbi::MapEquals(_internal_$name$(), other._internal_$name$())) {
+        return false;
+      }
+    )cc");
+  } else if (descriptor_->is_repeated()) {
+    p->Emit(R"cc(
+      if (!::_pbi::RepeatedEquals(_internal_$name$(),
+                                  other._internal_$name$())) {
+        return false;
+      }
+    )cc");
+  } else if (is_message()) {
+    ABSL_CHECK(!is_lazy() && !is_weak());
+    if (is_oneof()) {
+      p->Emit(R"cc(
+        if (!::_pbi::MessageEquals(_internal_$name$(),
+                                   other._internal_$name$())) {
+          return false;
+        }
+      )cc");
+    } else if (internal::cpp::HasHasbit(descriptor_)) {
+      // The has-bits were already compared, and a message may stay allocated
+      // after it is cleared.
+      p->Emit(R"cc(
+        if (($has_hasbit$) &&
+            !::_pbi::MessageEquals(*$field_$, *other.$field_$)) {
+          return false;
+        }
+      )cc");
+    } else {
+      p->Emit(R"cc(
+        if (($field_$ == nullptr) != (other.$field_$ == nullptr)) return false;
+        if ($field_$ != nullptr &&
+            !::_pbi::MessageEquals(*$field_$, *other.$field_$)) {
+          return false;
+        }
+      )cc");
+    }
+  } else {
+    // Fields that are not set hold their default value, so they can be
+    // compared without looking at the has-bits.
+    p->Emit(R"cc(
+      if (_internal_$name$() != other._internal_$name$()) return false;
+    )cc");
+  }
+}
+
 namespace {
 std::unique_ptr<FieldGeneratorBase> MakeGenerator(const FieldDescriptor* field,
                                                   const Options& options,
@@ -248,6 +354,9 @@ std::unique_ptr<FieldGeneratorBase> MakeGenerator(const FieldDescriptor* field,
       case FieldDescriptor::CPPTYPE_MESSAGE:
         return MakeRepeatedMessageGenerator(field, options, scc);
       case FieldDescriptor::CPPTYPE_STRING:
+        if (IsRepeatedStringBuffer(field, options)) {
+          return MakeRepeatedStringBufferGenerator(field, options, scc);
+        }
         return MakeRepeatedStringGenerator(field, options, scc);
       case FieldDescriptor::CPPTYPE_ENUM:
         return MakeRepeatedEnumGenerator(field, options, scc);
@@ -197,6 +197,10 @@ class FieldGeneratorBase {
 
   virtual void GenerateByteSize(io::Printer* p) const = 0;
 
+  virtual void GenerateSpaceUsedLong(io::Printer* p) const;
+
+  virtual void GenerateEquals(io::Printer* p) const;
+
   virtual void GenerateIsInitialized(io::Printer* p) const {}
 
   virtual bool IsInlined() const { return false; }
@@ -487,6 +491,22 @@ class FieldGenerator {
     impl_->GenerateByteSize(p);
   }
 
+  // Generates statements adding the memory used by this field outside of the
+  // message object to `total_size`, which are placed in the message's
+  // SpaceUsedLong() method.
+  void GenerateSpaceUsedLong(io::Printer* p) const {
+    auto vars = PushVarsForCall(p);
+    impl_->GenerateSpaceUsedLong(p);
+  }
+
+  // Generates statements returning false if this field differs between `this`
+  // and `other`, which are placed in the message's _InternalEquals() method.
+  // Oneof fields are only compared when both messages have them set.
+  void GenerateEquals(io::Printer* p) const {
+    auto vars = PushVarsForCall(p);
+    impl_->GenerateEquals(p);
+  }
+
   // Generates lines to call IsInitialized() for eligible message fields. Non
   // message fields won't need to override this function.
   void GenerateIsInitialized(io::Printer* p) const {
@@ -110,7 +110,8 @@ class SingularMessage : public FieldGeneratorBase {
         field_(field),
         opts_(&opts),
         has_required_(scc->HasRequiredFields(field->message_type())),
-        has_hasbit_(HasHasbit(field)) {}
+        has_hasbit_(HasHasbit(field)),
+        is_eager_(IsEagerMessage(field, opts, scc)) {}
 
   ~SingularMessage() override = default;
 
@@ -149,7 +150,11 @@ class SingularMessage : public FieldGeneratorBase {
   }
 
   void GenerateMemberConstructor(io::Printer* p) const override {
-    p->Emit("$name$_{nullptr}");
+    if (is_eager_) {
+      p->Emit("$name$_{CreateMaybeMessage<$Submsg$>(arena)}");
+    } else {
+      p->Emit("$name$_{nullptr}");
+    }
   }
 
   void GenerateMemberCopyConstructor(io::Printer* p) const override {
@@ -164,11 +169,17 @@ class SingularMessage : public FieldGeneratorBase {
 
  private:
   friend class OneofMessage;
+  friend class OneofMessage;
+  friend class SingularLazyMessage;
 
   const FieldDescriptor* field_;
   const Options* opts_;
   bool has_required_;
   bool has_hasbit_;
+  // The constructor allocates the sub-message, see IsEagerMessage().  The
+  // hasbit still tracks presence, so the pointer is only known to be non-null
+  // while the has bit is set.
+  bool is_eager_;
 };
 
 void SingularMessage::GenerateAccessorDeclarations(io::Printer* p) const {
@@ -567,6 +578,10 @@ void SingularMessage::GenerateAggregateInitializer(io::Printer* p) const {
     p->Emit(R"cc(
       decltype(Impl_::Split::$name$_){nullptr},
     )cc");
+  } else if (is_eager_) {
+    p->Emit(R"cc(
+      decltype($field_$){CreateMaybeMessage<$Submsg$>(arena)},
+    )cc");
   } else {
     p->Emit(R"cc(
       decltype($field_$){nullptr},
@@ -574,6 +589,267 @@ void SingularMessage::GenerateAggregateInitializer(io::Printer* p) const {
   }
 }
 
+// A field stored as a LazyField, see IsLazyImplicitWeakField() and
+// IsLazilyVerifiedLazy().  The parser only copies the bytes, and the
+// sub-message is parsed through its default instance on first access.
+class SingularLazyMessage : public SingularMessage {
+ public:
+  SingularLazyMessage(const FieldDescriptor* field, const Options& opts,
+                      MessageSCCAnalyzer* scc)
+      : SingularMessage(field, opts, scc) {
+    ABSL_CHECK(has_hasbit_ && !should_split());
+  }
+
+  ~SingularLazyMessage() override = default;
+
+  std::vector<Sub> MakeVars() const override {
+    std::vector<Sub> vars = SingularMessage::MakeVars();
+    // The inline accessors are in the header, which only declares the default
+    // instance itself; they hold a strong reference to the type anyway.
+    std::string default_ref = absl::Substitute(
+        "reinterpret_cast<const ::google::protobuf::MessageLite&>($0)",
+        QualifiedDefaultInstanceName(field_->message_type(), *opts_));
+    // The out-of-line code of a weak field must not reference the type, so it
+    // goes through the default instance pointer, which only weak types have.
+    std::string prototype = default_ref;
+    if (is_weak()) {
+      prototype = absl::Substitute(
+          "*reinterpret_cast<const ::google::protobuf::MessageLite*>($0)",
+          QualifiedDefaultInstancePtr(field_->message_type(), *opts_));
+    }
+    vars.push_back({"kDefaultRef", std::move(default_ref)});
+    vars.push_back({"kPrototype", std::move(prototype)});
+    // The default instance is never serialized, so its constexpr constructor
+    // does not need the mode.
+    vars.push_back(
+        {"retain_encoding",
+         opts_->retain_lazy_encoding_messages.contains(
+             field_->containing_type()->full_name())
+             ? "true"
+             : ""});
+    return vars;
+  }
+
+  void GeneratePrivateMembers(io::Printer* p) const override {
+    p->Emit(R"cc(
+      $pbi$::LazyField $name$_;
+    )cc");
+  }
+
+  void GenerateInlineAccessorDefinitions(io::Printer* p) const override;
+  // The LazyField already hides the type, so the weak _Internal accessors
+  // are not needed.
+  void GenerateInternalAccessorDeclarations(io::Printer* p) const override {}
+  void GenerateInternalAccessorDefinitions(io::Printer* p) const override {}
+  void GenerateClearingCode(io::Printer* p) const override;
+  void GenerateMessageClearingCode(io::Printer* p) const override {
+    GenerateClearingCode(p);
+  }
+  void GenerateMergingCode(io::Printer* p) const override;
+  void GenerateSwappingCode(io::Printer* p) const override;
+  void GenerateDestructorCode(io::Printer* p) const override;
+  void GenerateCopyConstructorCode(io::Printer* p) const override;
+  void GenerateSerializeWithCachedSizesToArray(io::Printer* p) const override;
+  void GenerateByteSize(io::Printer* p) const override;
+  void GenerateIsInitialized(io::Printer* p) const override;
+
+  void GenerateConstexprAggregateInitializer(io::Printer* p) const override {
+    p->Emit(R"cc(
+      /*decltype($field_$)*/ {},
+    )cc");
+  }
+  void GenerateAggregateInitializer(io::Printer* p) const override {
+    p->Emit(R"cc(
+      decltype($field_$){$retain_encoding$},
+    )cc");
+  }
+  void GenerateCopyAggregateInitializer(io::Printer* p) const override {
+    p->Emit(R"cc(
+      decltype($field_$){$retain_encoding$},
+    )cc");
+  }
+
+  void GenerateMemberConstexprConstructor(io::Printer* p) const override {
+    p->Emit("$name$_{}");
+  }
+  void GenerateMemberConstructor(io::Printer* p) const override {
+    p->Emit("$name$_{$retain_encoding$}");
+  }
+  void GenerateMemberCopyConstructor(io::Printer* p) const override {
+    p->Emit("$name$_{arena, from.$name$_, $kPrototype$}");
+  }
+};
+
+void SingularLazyMessage::GenerateInlineAccessorDefinitions(
+    io::Printer* p) const {
+  auto v =
+      p->WithVars({{"release_name", SafeFunctionName(field_->containing_type(),
+                                                     field_, "release_")}});
+  p->Emit(R"cc(
+    inline const $Submsg$& $Msg$::_internal_$name$() const {
+      $TsanDetectConcurrentRead$;
+      $StrongRef$;
+      return reinterpret_cast<const $Submsg$&>(
+          $field_$.Get($kDefaultRef$, GetArenaForAllocation()));
+    }
+    inline const $Submsg$& $Msg$::$name$() const ABSL_ATTRIBUTE_LIFETIME_BOUND {
+      $annotate_get$;
+      // @@protoc_insertion_point(field_get:$pkg.Msg.field$)
+      return _internal_$name$();
+    }
+    inline void $Msg$::unsafe_arena_set_allocated_$name$($Submsg$* value) {
+      $TsanDetectConcurrentMutation$;
+      $field_$.UnsafeArenaSetAllocated(
+          reinterpret_cast<$pb$::MessageLite*>(value), GetArenaForAllocation());
+      if (value != nullptr) {
+        $set_hasbit$
+      } else {
+        $clear_hasbit$
+      }
+      $annotate_set$;
+      // @@protoc_insertion_point(field_unsafe_arena_set_allocated:$pkg.Msg.field$)
+    }
+    inline $Submsg$* $Msg$::$release_name$() {
+      $TsanDetectConcurrentMutation$;
+      $StrongRef$;
+      $annotate_release$;
+
+      $clear_hasbit$;
+      $Submsg$* released = reinterpret_cast<$Submsg$*>(
+          $field_$.UnsafeArenaRelease($kDefaultRef$, GetArenaForAllocation()));
+#ifdef PROTOBUF_FORCE_COPY_IN_RELEASE
+      auto* old = reinterpret_cast<$pb$::MessageLite*>(released);
+      released = $pbi$::DuplicateIfNonNull(released);
+      if (GetArenaForAllocation() == nullptr) {
+        delete old;
+      }
+#else   // PROTOBUF_FORCE_COPY_IN_RELEASE
+      if (GetArenaForAllocation() != nullptr) {
+        released = $pbi$::DuplicateIfNonNull(released);
+      }
+#endif  // !PROTOBUF_FORCE_COPY_IN_RELEASE
+      return released;
+    }
+    inline $Submsg$* $Msg$::unsafe_arena_release_$name$() {
+      $TsanDetectConcurrentMutation$;
+      $annotate_release$;
+      // @@protoc_insertion_point(field_release:$pkg.Msg.field$)
+      $StrongRef$;
+
+      $clear_hasbit$;
+      return reinterpret_cast<$Submsg$*>(
+          $field_$.UnsafeArenaRelease($kDefaultRef$, GetArenaForAllocation()));
+    }
+    inline $Submsg$* $Msg$::_internal_mutable_$name$() {
+      $TsanDetectConcurrentMutation$;
+      $StrongRef$;
+      $set_hasbit$;
+      return reinterpret_cast<$Submsg$*>(
+          $field_$.Mutable($kDefaultRef$, GetArenaForAllocation()));
+    }
+    inline $Submsg$* $Msg$::mutable_$name$() ABSL_ATTRIBUTE_LIFETIME_BOUND {
+      $Submsg$* _msg = _internal_mutable_$name$();
+      $annotate_mutable$;
+      // @@protoc_insertion_point(field_mutable:$pkg.Msg.field$)
+      return _msg;
+    }
+    inline void $Msg$::set_allocated_$name$($Submsg$* value) {
+      $pb$::Arena* message_arena = GetArenaForAllocation();
+      $TsanDetectConcurrentMutation$;
+      if (value != nullptr) {
+        $pb$::Arena* submessage_arena =
+            $pb$::Arena::InternalGetOwningArena($base_cast$(value));
+        if (message_arena != submessage_arena) {
+          value = $pbi$::GetOwnedMessage(message_arena, value, submessage_arena);
+        }
+        $set_hasbit$;
+      } else {
+        $clear_hasbit$;
+      }
+
+      $field_$.UnsafeArenaSetAllocated(
+          reinterpret_cast<$pb$::MessageLite*>(value), message_arena);
+      $annotate_set$;
+      // @@protoc_insertion_point(field_set_allocated:$pkg.Msg.field$)
+    }
+  )cc");
+}
+
+void SingularLazyMessage::GenerateClearingCode(io::Printer* p) const {
+  p->Emit(R"cc(
+    $field_$.Clear();
+  )cc");
+}
+
+void SingularLazyMessage::GenerateMergingCode(io::Printer* p) const {
+  // Unparsed bytes are appended rather than parsed.
+  p->Emit(R"cc(
+    _this->$field_$.MergeFrom(from.$field_$, $kPrototype$,
+                              _this->GetArenaForAllocation());
+    _this->$set_hasbit$;
+  )cc");
+}
+
+void SingularLazyMessage::GenerateSwappingCode(io::Printer* p) const {
+  p->Emit(R"cc(
+    $field_$.Swap(&other->$field_$);
+  )cc");
+}
+
+void SingularLazyMessage::GenerateDestructorCode(io::Printer* p) const {
+  p->Emit(R"cc(
+    $field_$.Destroy();
+  )cc");
+}
+
+#ifndef PROTOBUF_EXPLICIT_CONSTRUCTORS
+
+void SingularLazyMessage::GenerateCopyConstructorCode(io::Printer* p) const {
+  p->Emit(R"cc(
+    if ((from.$has_hasbit$) != 0) {
+      _this->$field_$.MergeFrom(from.$field_$, $kPrototype$, nullptr);
+    }
+  )cc");
+}
+
+#else  // !PROTOBUF_EXPLICIT_CONSTRUCTORS
+
+void SingularLazyMessage::GenerateCopyConstructorCode(io::Printer* p) const {
+  p->Emit(R"cc(
+    if ((from.$has_hasbit$) != 0) {
+      _this->$field_$.MergeFrom(from.$field_$, $kPrototype$, arena);
+    }
+  )cc");
+}
+
+#endif  // !PROTOBUF_EXPLICIT_CONSTRUCTORS
+
+void SingularLazyMessage::GenerateSerializeWithCachedSizesToArray(
+    io::Printer* p) const {
+  p->Emit(R"cc(
+    target = $field_$.InternalWrite($number$, target, stream);
+  )cc");
+}
+
+void SingularLazyMessage::GenerateByteSize(io::Printer* p) const {
+  p->Emit(R"cc(
+    total_size += $tag_size$ + $pbi$::WireFormatLite::LengthDelimitedSize(
+                                   $field_$.ByteSizeLong());
+  )cc");
+}
+
+void SingularLazyMessage::GenerateIsInitialized(io::Printer* p) const {
+  if (!has_required_ || ShouldIgnoreRequiredFieldCheck(field_, *opts_)) return;
+
+  p->Emit(R"cc(
+    if (($has_hasbit$) != 0) {
+      if (!$field_$.IsInitialized($kPrototype$, GetArenaForAllocation())) {
+        return false;
+      }
+    }
+  )cc");
+}
+
 class OneofMessage : public SingularMessage {
  public:
   OneofMessage(const FieldDescriptor* descriptor, const Options& options,
@@ -616,6 +892,35 @@ void OneofMessage::GenerateInlineAccessorDefinitions(io::Printer* p) const {
   auto v =
       p->WithVars({{"release_name", SafeFunctionName(field_->containing_type(),
                                                      field_, "release_")}});
+  auto create = [&] {
+    if (!RecyclesOneofMessage(field_, *opts_, scc_)) {
+      p->Emit(R"cc(
+        $field_$ =
+            $weak_cast$(CreateMaybeMessage<$Submsg$>(GetArenaForAllocation()));
+      )cc");
+      return;
+    }
+    p->Emit(R"cc(
+      if (_impl_._recycled_$name$_ != nullptr) {
+        $field_$ = _impl_._recycled_$name$_;
+        _impl_._recycled_$name$_ = nullptr;
+        $field_$->Clear();
+      } else {
+        $field_$ = CreateMaybeMessage<$Submsg$>(GetArenaForAllocation());
+      }
+      _impl_._allocated_$oneof_name$_ = $field_$;
+    )cc");
+  };
+  // A sub-message handed out by unsafe_arena_release_<field>() may come back
+  // through unsafe_arena_set_allocated_<field>(), still owned by the caller.
+  auto forget_allocated = [&] {
+    if (!RecyclesOneofMessage(field_, *opts_, scc_)) return;
+    p->Emit(R"cc(
+      if (temp == _impl_._allocated_$oneof_name$_) {
+        _impl_._allocated_$oneof_name$_ = nullptr;
+      }
+    )cc");
+  };
 
   p->Emit(R"cc(
     inline $Submsg$* $Msg$::$release_name$() {
@@ -648,7 +953,7 @@ void OneofMessage::GenerateInlineAccessorDefinitions(io::Printer* p) const {
       return _internal_$name$();
     }
   )cc");
-  p->Emit(R"cc(
+  p->Emit({{"forget_allocated", forget_allocated}}, R"cc(
     inline $Submsg$* $Msg$::unsafe_arena_release_$name$() {
       $annotate_release$;
       // @@protoc_insertion_point(field_unsafe_arena_release:$pkg.Msg.field$)
@@ -657,6 +962,7 @@ void OneofMessage::GenerateInlineAccessorDefinitions(io::Printer* p) const {
         clear_has_$oneof_name$();
         $Submsg$* temp = $cast_field_$;
         $field_$ = nullptr;
+        $forget_allocated$;
         return temp;
       } else {
         return nullptr;
@@ -677,14 +983,13 @@ void OneofMessage::GenerateInlineAccessorDefinitions(io::Printer* p) const {
       // @@protoc_insertion_point(field_unsafe_arena_set_allocated:$pkg.Msg.field$)
     }
   )cc");
-  p->Emit(R"cc(
+  p->Emit({{"create", create}}, R"cc(
     inline $Submsg$* $Msg$::_internal_mutable_$name$() {
       $StrongRef$;
       if ($not_has_field$) {
         clear_$oneof_name$();
         set_has_$name$();
-        $field_$ =
-            $weak_cast$(CreateMaybeMessage<$Submsg$>(GetArenaForAllocation()));
+        $create$;
       }
       return $cast_field_$;
     }
@@ -700,6 +1005,18 @@ void OneofMessage::GenerateInlineAccessorDefinitions(io::Printer* p) const {
 }
 
 void OneofMessage::GenerateClearingCode(io::Printer* p) const {
+  if (RecyclesOneofMessage(field_, *opts_, scc_)) {
+    // Kept for _internal_mutable_<field>(), which clears it when reused.
+    // Sub-messages installed by other means, e.g. by
+    // unsafe_arena_set_allocated_<field>(), may be owned by the caller.
+    p->Emit(R"cc(
+      if (GetArenaForAllocation() == nullptr) {
+        delete $field_$;
+      } else if ($field_$ == _impl_._allocated_$oneof_name$_) {
+        _impl_._recycled_$name$_ = $field_$;
+      })cc");
+    return;
+  }
   p->Emit(R"cc(
     if (GetArenaForAllocation() == nullptr) {
       delete $field_$;
@@ -1045,6 +1362,10 @@ void RepeatedMessage::GenerateIsInitialized(io::Printer* p) const {
 std::unique_ptr<FieldGeneratorBase> MakeSinguarMessageGenerator(
     const FieldDescriptor* desc, const Options& options,
     MessageSCCAnalyzer* scc) {
+  if (IsLazyImplicitWeakField(desc, options, scc) ||
+      IsLazilyVerifiedLazy(desc, options)) {
+    return absl::make_unique<SingularLazyMessage>(desc, options, scc);
+  }
   return absl::make_unique<SingularMessage>(desc, options, scc);
 }
 
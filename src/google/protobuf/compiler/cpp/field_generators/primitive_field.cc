@@ -474,23 +474,52 @@ void RepeatedPrimitive::GenerateAccessorDeclarations(io::Printer* p) const {
       p->WithVars(AnnotatedAccessors(field_, {"set_", "add_"}, Semantic::kSet));
   auto va =
       p->WithVars(AnnotatedAccessors(field_, {"mutable_"}, Semantic::kAlias));
-  p->Emit(R"cc(
-    $DEPRECATED$ $Type$ $name$(int index) const;
-    $DEPRECATED$ void $set_name$(int index, $Type$ value);
-    $DEPRECATED$ void $add_name$($Type$ value);
-    $DEPRECATED$ const $pb$::RepeatedField<$Type$>& $name$() const;
-    $DEPRECATED$ $pb$::RepeatedField<$Type$>* $mutable_name$();
-
-    private:
-    const $pb$::RepeatedField<$Type$>& $_internal_name$() const;
-    $pb$::RepeatedField<$Type$>* $_internal_mutable_name$();
-
-    public:
-  )cc");
+  // Besides the RepeatedField accessors, repeated scalars get views of their
+  // storage for bulk and vectorized access: `foo_span()` and
+  // `mutable_foo_span()` (invalidated by any change in size), `assign_foo()`,
+  // and `add_n_foo(n)`, which appends `n` uninitialized elements to be filled
+  // in through the returned span.
+  const Descriptor* msg = field_->containing_type();
+  p->Emit(
+      {
+          Sub("name_span", SafeFunctionName(msg, field_, "", "_span"))
+              .AnnotatedAs(field_),
+          Sub("mutable_name_span",
+              SafeFunctionName(msg, field_, "mutable_", "_span"))
+              .AnnotatedAs({field_, Semantic::kAlias}),
+          Sub("assign_name", SafeFunctionName(msg, field_, "assign_", ""))
+              .AnnotatedAs({field_, Semantic::kSet}),
+          Sub("add_n_name", SafeFunctionName(msg, field_, "add_n_", ""))
+              .AnnotatedAs({field_, Semantic::kAlias}),
+      },
+      R"cc(
+        $DEPRECATED$ $Type$ $name$(int index) const;
+        $DEPRECATED$ void $set_name$(int index, $Type$ value);
+        $DEPRECATED$ void $add_name$($Type$ value);
+        $DEPRECATED$ const $pb$::RepeatedField<$Type$>& $name$() const;
+        $DEPRECATED$ $pb$::RepeatedField<$Type$>* $mutable_name$();
+        $DEPRECATED$ absl::Span<const $Type$> $name_span$() const;
+        $DEPRECATED$ absl::Span<$Type$> $mutable_name_span$();
+        $DEPRECATED$ void $assign_name$(absl::Span<const $Type$> values);
+        $DEPRECATED$ absl::Span<$Type$> $add_n_name$(int n);
+
+        private:
+        const $pb$::RepeatedField<$Type$>& $_internal_name$() const;
+        $pb$::RepeatedField<$Type$>* $_internal_mutable_name$();
+
+        public:
+      )cc");
 }
 
 void RepeatedPrimitive::GenerateInlineAccessorDefinitions(
     io::Printer* p) const {
+  const Descriptor* msg = field_->containing_type();
+  auto vs = p->WithVars({
+      {"name_span", SafeFunctionName(msg, field_, "", "_span")},
+      {"mutable_name_span", SafeFunctionName(msg, field_, "mutable_", "_span")},
+      {"assign_name", SafeFunctionName(msg, field_, "assign_", "")},
+      {"add_n_name", SafeFunctionName(msg, field_, "add_n_", "")},
+  });
   p->Emit(R"cc(
     inline $Type$ $Msg$::$name$(int index) const {
       $annotate_get$;
@@ -519,6 +548,29 @@ void RepeatedPrimitive::GenerateInlineAccessorDefinitions(
       $TsanDetectConcurrentMutation$;
       return _internal_mutable_$name$();
     }
+    inline absl::Span<const $Type$> $Msg$::$name_span$() const {
+      $annotate_list$;
+      const auto& field = _internal_$name$();
+      return absl::MakeConstSpan(field.data(), field.size());
+    }
+    inline absl::Span<$Type$> $Msg$::$mutable_name_span$() {
+      $annotate_mutable_list$;
+      $TsanDetectConcurrentMutation$;
+      auto* field = _internal_mutable_$name$();
+      return absl::MakeSpan(field->mutable_data(), field->size());
+    }
+    inline void $Msg$::$assign_name$(absl::Span<const $Type$> values) {
+      $annotate_mutable_list$;
+      $TsanDetectConcurrentMutation$;
+      _internal_mutable_$name$()->Assign(values.begin(), values.end());
+    }
+    inline absl::Span<$Type$> $Msg$::$add_n_name$(int n) {
+      $annotate_mutable_list$;
+      $TsanDetectConcurrentMutation$;
+      auto* field = _internal_mutable_$name$();
+      field->Reserve(field->size() + n);
+      return absl::MakeSpan(field->AddNAlreadyReserved(n), n);
+    }
 
   )cc");
   if (should_split()) {
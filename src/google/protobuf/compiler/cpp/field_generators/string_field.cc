@@ -692,11 +692,29 @@ void SingularString::GenerateDestructorCode(io::Printer* p) const {
 
 void SingularString::GenerateSerializeWithCachedSizesToArray(
     io::Printer* p) const {
+  auto utf8_check = [&] {
+    GenerateUtf8CheckCodeForString(p, field_, options_, false,
+                                   "_s.data(), "
+                                   "static_cast<int>(_s.length()),");
+  };
+  bool is_lite =
+      GetOptimizeFor(field_->file(), options_) == FileOptions::LITE_RUNTIME;
+  bool skip_if_validated =
+      !is_inlined() && field_->type() == FieldDescriptor::TYPE_STRING &&
+      internal::cpp::GetUtf8CheckMode(field_, is_lite) !=
+          internal::cpp::Utf8CheckMode::kNone;
   p->Emit({{"utf8_check",
             [&] {
-              GenerateUtf8CheckCodeForString(p, field_, options_, false,
-                                             "_s.data(), "
-                                             "static_cast<int>(_s.length()),");
+              if (!skip_if_validated) {
+                utf8_check();
+                return;
+              }
+              // Strings the parser already validated are written back as is.
+              p->Emit({{"check", utf8_check}}, R"cc(
+                if (!$field_$.IsUtf8Validated()) {
+                  $check$;
+                }
+              )cc");
             }}},
           R"cc(
             const std::string& _s = this->_internal_$name$();
@@ -1033,6 +1051,163 @@ void RepeatedString::GenerateSerializeWithCachedSizesToArray(
             }
           )cc");
 }
+
+// A repeated string or bytes field listed in the repeated_string_buffer option,
+// stored in a RepeatedStringBuffer.  Elements are read as absl::string_view and
+// cannot be mutated in place.
+class RepeatedStringBuffer : public FieldGeneratorBase {
+ public:
+  RepeatedStringBuffer(const FieldDescriptor* field, const Options& opts,
+                       MessageSCCAnalyzer* scc)
+      : FieldGeneratorBase(field, opts, scc), field_(field), opts_(&opts) {
+    // Repeated fields are never split.
+    ABSL_CHECK(!ShouldSplit(field, opts));
+  }
+  ~RepeatedStringBuffer() override = default;
+
+  std::vector<Sub> MakeVars() const override { return Vars(field_, *opts_); }
+
+  void GeneratePrivateMembers(io::Printer* p) const override {
+    p->Emit(R"cc(
+      $pb$::RepeatedStringBuffer $name$_;
+    )cc");
+  }
+
+  void GenerateClearingCode(io::Printer* p) const override {
+    p->Emit("$field_$.Clear();\n");
+  }
+
+  void GenerateMergingCode(io::Printer* p) const override {
+    p->Emit(R"cc(
+      _this->_internal_mutable_$name$()->MergeFrom(from._internal_$name$());
+    )cc");
+  }
+
+  void GenerateSwappingCode(io::Printer* p) const override {
+    p->Emit(R"cc(
+      $field_$.InternalSwap(&other->$field_$);
+    )cc");
+  }
+
+  void GenerateDestructorCode(io::Printer* p) const override {
+#ifndef PROTOBUF_EXPLICIT_CONSTRUCTORS
+    p->Emit(R"cc(
+      _internal_mutable_$name$()->~RepeatedStringBuffer();
+    )cc");
+#endif  // !PROTOBUF_EXPLICIT_CONSTRUCTORS
+  }
+
+  void GenerateConstructorCode(io::Printer* p) const override {}
+
+  void GenerateCopyConstructorCode(io::Printer* p) const override {}
+
+  void GenerateByteSize(io::Printer* p) const override {
+    p->Emit(R"cc(
+      total_size += $kTagBytes$ * $pbi$::FromIntSize(_internal_$name$().size());
+      for (absl::string_view s : _internal_$name$()) {
+        total_size += $pbi$::WireFormatLite::LengthDelimitedSize(s.size());
+      }
+    )cc");
+  }
+
+  void GenerateEquals(io::Printer* p) const override {
+    p->Emit(R"cc(
+      if (_internal_$name$() != other._internal_$name$()) {
+        return false;
+      }
+    )cc");
+  }
+
+  void GenerateAccessorDeclarations(io::Printer* p) const override;
+  void GenerateInlineAccessorDefinitions(io::Printer* p) const override;
+  void GenerateSerializeWithCachedSizesToArray(io::Printer* p) const override;
+
+ private:
+  const FieldDescriptor* field_;
+  const Options* opts_;
+};
+
+void RepeatedStringBuffer::GenerateAccessorDeclarations(io::Printer* p) const {
+  auto v1 = p->WithVars(AnnotatedAccessors(field_, {"", "_internal_"}));
+  auto v2 = p->WithVars(
+      AnnotatedAccessors(field_, {"set_", "add_"}, AnnotationCollector::kSet));
+  auto v3 = p->WithVars(
+      AnnotatedAccessors(field_, {"mutable_"}, AnnotationCollector::kAlias));
+
+  p->Emit(R"cc(
+    $DEPRECATED$ absl::string_view $name$(int index) const;
+    $DEPRECATED$ void $set_name$(int index, absl::string_view value);
+    $DEPRECATED$ void $add_name$(absl::string_view value);
+    $DEPRECATED$ const $pb$::RepeatedStringBuffer& $name$() const;
+    $DEPRECATED$ $pb$::RepeatedStringBuffer* $mutable_name$();
+
+    private:
+    const $pb$::RepeatedStringBuffer& _internal_$name$() const;
+    $pb$::RepeatedStringBuffer* _internal_mutable_$name$();
+
+    public:
+  )cc");
+}
+
+void RepeatedStringBuffer::GenerateInlineAccessorDefinitions(
+    io::Printer* p) const {
+  p->Emit(R"cc(
+    inline absl::string_view $Msg$::$name$(int index) const
+        ABSL_ATTRIBUTE_LIFETIME_BOUND {
+      $annotate_get$;
+      // @@protoc_insertion_point(field_get:$pkg.Msg.field$)
+      return _internal_$name$().Get(index);
+    }
+    inline void $Msg$::set_$name$(int index, absl::string_view value) {
+      _internal_mutable_$name$()->Set(index, value);
+      $annotate_set$;
+      // @@protoc_insertion_point(field_set_string_piece:$pkg.Msg.field$)
+    }
+    inline void $Msg$::add_$name$(absl::string_view value) {
+      $TsanDetectConcurrentMutation$;
+      _internal_mutable_$name$()->Add(value);
+      $annotate_add$;
+      // @@protoc_insertion_point(field_add_string_piece:$pkg.Msg.field$)
+    }
+    inline const $pb$::RepeatedStringBuffer& $Msg$::$name$() const
+        ABSL_ATTRIBUTE_LIFETIME_BOUND {
+      $annotate_list$;
+      // @@protoc_insertion_point(field_list:$pkg.Msg.field$)
+      return _internal_$name$();
+    }
+    inline $pb$::RepeatedStringBuffer* $Msg$::mutable_$name$()
+        ABSL_ATTRIBUTE_LIFETIME_BOUND {
+      $annotate_mutable_list$;
+      // @@protoc_insertion_point(field_mutable_list:$pkg.Msg.field$)
+      $TsanDetectConcurrentMutation$;
+      return _internal_mutable_$name$();
+    }
+    inline const $pb$::RepeatedStringBuffer& $Msg$::_internal_$name$() const {
+      $TsanDetectConcurrentRead$;
+      return $field_$;
+    }
+    inline $pb$::RepeatedStringBuffer* $Msg$::_internal_mutable_$name$() {
+      $TsanDetectConcurrentRead$;
+      return &$field_$;
+    }
+  )cc");
+}
+
+void RepeatedStringBuffer::GenerateSerializeWithCachedSizesToArray(
+    io::Printer* p) const {
+  p->Emit({{"utf8_check",
+            [&] {
+              GenerateUtf8CheckCodeForString(
+                  p, field_, options_, false,
+                  "s.data(), static_cast<int>(s.length()),");
+            }}},
+          R"cc(
+            for (absl::string_view s : this->_internal_$name$()) {
+              $utf8_check$;
+              target = stream->Write$DeclaredType$($number$, s, target);
+            }
+          )cc");
+}
 }  // namespace
 
 std::unique_ptr<FieldGeneratorBase> MakeSinguarStringGenerator(
@@ -1047,6 +1222,12 @@ std::unique_ptr<FieldGeneratorBase> MakeRepeatedStringGenerator(
   return absl::make_unique<RepeatedString>(desc, options, scc);
 }
 
+std::unique_ptr<FieldGeneratorBase> MakeRepeatedStringBufferGenerator(
+    const FieldDescriptor* desc, const Options& options,
+    MessageSCCAnalyzer* scc) {
+  return absl::make_unique<RepeatedStringBuffer>(desc, options, scc);
+}
+
 }  // namespace cpp
 }  // namespace compiler
 }  // namespace protobuf
@@ -52,6 +52,7 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/strip.h"
+#include "google/protobuf/compiler/cpp/constants.h"
 #include "google/protobuf/compiler/cpp/enum.h"
 #include "google/protobuf/compiler/cpp/extension.h"
 #include "google/protobuf/compiler/cpp/helpers.h"
@@ -411,6 +412,8 @@ void FileGenerator::GenerateSharedHeaderCode(io::Printer* p) {
                      {"messages", [&] { GenerateMessageDefinitions(p); }},
                      {"services", [&] { GenerateServiceDefinitions(p); }},
                      {"extensions", [&] { GenerateExtensionIdentifiers(p); }},
+                     {"constants",
+                      [&] { GenerateMessageConstantDeclarations(p); }},
                      {"inline_fns",
                       [&] { GenerateInlineFunctionDefinitions(p); }},
                  },
@@ -427,6 +430,8 @@ void FileGenerator::GenerateSharedHeaderCode(io::Printer* p) {
 
                    $extensions$
 
+                   $constants$
+
                    $hrule_thick$
 
                    $inline_fns$
@@ -653,7 +658,8 @@ void FileGenerator::GenerateSourceIncludes(io::Printer* p) {
     IncludeFile("third_party/protobuf/wire_format.h", p);
   }
 
-  if (HasGeneratedMethods(file_, options_)) {
+  if (HasGeneratedMethods(file_, options_) ||
+      HasTableDrivenMethods(file_, options_)) {
     IncludeFile("third_party/protobuf/generated_message_tctable_impl.h", p);
   }
 
@@ -699,7 +705,8 @@ void FileGenerator::GenerateSourcePrelude(io::Printer* p) {
     namespace _pbi = ::$proto_ns$::internal;
   )cc");
 
-  if (HasGeneratedMethods(file_, options_)) {
+  if (HasGeneratedMethods(file_, options_) ||
+      HasTableDrivenMethods(file_, options_)) {
     p->Emit(R"cc(
       namespace _fl = ::$proto_ns$::internal::field_layout;
     )cc");
@@ -992,6 +999,129 @@ void FileGenerator::GenerateGlobalSource(io::Printer* p) {
   }
 }
 
+namespace {
+
+// A rough measure of the code generated for the methods of `descriptor`'s
+// class, not counting nested types, used to balance messages across shards.
+size_t EstimatedSourceWeight(const Descriptor* descriptor) {
+  // Constructors, Clear(), _InternalSerialize(), ByteSizeLong(), MergeImpl(),
+  // the parse table, etc. exist for every message.
+  size_t weight = 16;
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    const FieldDescriptor* field = descriptor->field(i);
+    weight += field->is_repeated() ||
+                      field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE ||
+                      field->cpp_type() == FieldDescriptor::CPPTYPE_STRING
+                  ? 3
+                  : 2;
+  }
+  weight += 4 * descriptor->real_oneof_decl_count();
+  weight += 4 * descriptor->extension_range_count();
+  return weight;
+}
+
+}  // namespace
+
+std::vector<std::vector<int>> FileGenerator::ShardMessages(
+    int num_shards) const {
+  ABSL_CHECK_GT(num_shards, 0);
+  // Place the heaviest messages first, each in the lightest shard so far.
+  std::vector<int> order(message_generators_.size());
+  std::vector<size_t> weights(message_generators_.size());
+  for (int i = 0; i < message_generators_.size(); ++i) {
+    order[i] = i;
+    weights[i] = EstimatedSourceWeight(message_generators_[i]->descriptor());
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&](int a, int b) { return weights[a] > weights[b]; });
+
+  std::vector<std::vector<int>> shards(num_shards);
+  std::vector<size_t> shard_weights(num_shards);
+  for (int idx : order) {
+    size_t lightest =
+        std::min_element(shard_weights.begin(), shard_weights.end()) -
+        shard_weights.begin();
+    shards[lightest].push_back(idx);
+    shard_weights[lightest] += weights[idx];
+  }
+  for (auto& shard : shards) {
+    std::sort(shard.begin(), shard.end());
+  }
+  return shards;
+}
+
+void FileGenerator::GenerateSourceForShard(
+    const std::vector<int>& message_indices, io::Printer* p) {
+  auto v = p->WithVars(FileVars(file_, options_));
+
+  GenerateSourceIncludes(p);
+  GenerateSourcePrelude(p);
+
+  if (IsAnyMessage(file_, options_)) {
+    MuteWuninitialized(p);
+  }
+
+  CrossFileReferences refs;
+  for (int idx : message_indices) {
+    ForEachField(message_generators_[idx]->descriptor(),
+                 [this, &refs](const FieldDescriptor* field) {
+                   GetCrossFileReferencesForField(field, &refs);
+                 });
+  }
+  GenerateInternalForwardDeclarations(refs, p);
+
+  if (HasDescriptorMethods(file_, options_)) {
+    // Defined by GenerateReflectionInitializationCode() in the main pb.cc.
+    p->Emit({{"len", message_generators_.size()}}, R"cc(
+      extern ::_pb::Metadata $file_level_metadata$[$len$];
+      extern ::absl::once_flag $desc_table$_once;
+      const ::_pbi::DescriptorTable* $desc_table$_getter();
+    )cc");
+  }
+
+  std::vector<bool> in_shard(message_generators_.size());
+  for (int idx : message_indices) {
+    in_shard[idx] = true;
+  }
+
+  {
+    NamespaceOpener ns(Namespace(file_, options_), p);
+    for (int idx : message_generators_topologically_ordered_) {
+      if (in_shard[idx]) {
+        GenerateSourceDefaultInstance(idx, p);
+      }
+    }
+
+    for (int idx : message_indices) {
+      p->Emit(R"(
+        $hrule_thick$
+      )");
+      message_generators_[idx]->GenerateClassMethods(p);
+    }
+
+    p->Emit(R"cc(
+      // @@protoc_insertion_point(namespace_scope)
+    )cc");
+  }
+
+  {
+    NamespaceOpener proto_ns(ProtobufNamespace(options_), p);
+    for (int idx : message_indices) {
+      message_generators_[idx]->GenerateSourceInProto2Namespace(p);
+    }
+  }
+
+  p->Emit(R"cc(
+    // @@protoc_insertion_point(global_scope)
+  )cc");
+
+  if (IsAnyMessage(file_, options_)) {
+    UnmuteWuninitialized(p);
+  }
+
+  IncludeFile("third_party/protobuf/port_undef.inc", p);
+}
+
 void FileGenerator::GenerateSource(io::Printer* p) {
   auto v = p->WithVars(FileVars(file_, options_));
 
@@ -1005,7 +1135,7 @@ void FileGenerator::GenerateSource(io::Printer* p) {
     MuteWuninitialized(p);
   }
 
-  {
+  if (!ShardsMessages()) {
     NamespaceOpener ns(Namespace(file_, options_), p);
     for (int i = 0; i < message_generators_.size(); ++i) {
       GenerateSourceDefaultInstance(
@@ -1032,7 +1162,7 @@ void FileGenerator::GenerateSource(io::Printer* p) {
     }
 
     // Generate classes.
-    for (int i = 0; i < message_generators_.size(); ++i) {
+    for (int i = 0; i < message_generators_.size() && !ShardsMessages(); ++i) {
       p->Emit(R"(
         $hrule_thick$
       )");
@@ -1054,6 +1184,8 @@ void FileGenerator::GenerateSource(io::Printer* p) {
       extension_generators_[i]->GenerateDefinition(p);
     }
 
+    GenerateMessageConstants(p);
+
     p->Emit(R"cc(
       // @@protoc_insertion_point(namespace_scope)
     )cc");
@@ -1061,7 +1193,7 @@ void FileGenerator::GenerateSource(io::Printer* p) {
 
   {
     NamespaceOpener proto_ns(ProtobufNamespace(options_), p);
-    for (int i = 0; i < message_generators_.size(); ++i) {
+    for (int i = 0; i < message_generators_.size() && !ShardsMessages(); ++i) {
       message_generators_[i]->GenerateSourceInProto2Namespace(p);
     }
   }
@@ -1078,9 +1210,11 @@ void FileGenerator::GenerateSource(io::Printer* p) {
 }
 
 void FileGenerator::GenerateReflectionInitializationCode(io::Printer* p) {
+  // GetMetadata() in the numbered .cc files refers to these when sharding.
+  auto v = p->WithVars({{"static", ShardsMessages() ? "" : "static "}});
   if (!message_generators_.empty()) {
     p->Emit({{"len", message_generators_.size()}}, R"cc(
-      static ::_pb::Metadata $file_level_metadata$[$len$];
+      $static$::_pb::Metadata $file_level_metadata$[$len$];
     )cc");
   }
 
@@ -1131,14 +1265,22 @@ void FileGenerator::GenerateReflectionInitializationCode(io::Printer* p) {
             {"defaults",
              [&] {
                for (auto& gen : message_generators_) {
-                 p->Emit(
-                     {
-                         {"ns", Namespace(gen->descriptor(), options_)},
-                         {"class", ClassName(gen->descriptor())},
-                     },
-                     R"cc(
-                       &$ns$::_$class$_default_instance_._instance,
-                     )cc");
+                 auto v = p->WithVars({
+                     {"ns", Namespace(gen->descriptor(), options_)},
+                     {"class", ClassName(gen->descriptor())},
+                 });
+                 if (ShardsMessages()) {
+                   // The default instance types are only complete in the
+                   // numbered .cc files.
+                   p->Emit(R"cc(
+                     &reinterpret_cast<const $ns$::$class$&>(
+                         $ns$::_$class$_default_instance_),
+                   )cc");
+                 } else {
+                   p->Emit(R"cc(
+                     &$ns$::_$class$_default_instance_._instance,
+                   )cc");
+                 }
                }
              }},
         },
@@ -1282,7 +1424,7 @@ void FileGenerator::GenerateReflectionInitializationCode(io::Printer* p) {
                            : std::string(p->LookupVar("file_level_metadata"))},
       },
       R"cc(
-        static ::absl::once_flag $desc_table$_once;
+        $static$::absl::once_flag $desc_table$_once;
         const ::_pbi::DescriptorTable $desc_table$ = {
             false,
             $eager$,
@@ -1322,11 +1464,30 @@ void FileGenerator::GenerateReflectionInitializationCode(io::Printer* p) {
   // pull in a lot of unnecessary code that can't be stripped by --gc-sections.
   // Descriptor initialization will still be performed lazily when it's needed.
   if (!IsLazilyInitializedFile(file_->name())) {
-    p->Emit({{"dummy", UniqueName("dynamic_init_dummy", file_, options_)}},
+    // With lazy_descriptor_registration the section is used whenever the
+    // target supports it, not only when the build opts in with
+    // PROTOBUF_LAZY_GENERATED_FILE_REGISTRATION.
+    p->Emit({{"dummy", UniqueName("dynamic_init_dummy", file_, options_)},
+             {"section_dummy",
+              UniqueName("descriptor_table_section_dummy", file_, options_)},
+             {"section", options_.lazy_descriptor_registration
+                             ? "PROTOBUF_DESCRIPTOR_TABLE_SECTION_ATTRIBUTE"
+                             : "PROTOBUF_DESCRIPTOR_TABLE_SECTION"}},
             R"cc(
+              //~ Emit wants an indented line, so give it a comment to strip.
+#if defined($section$)
+              // Registered on first access to the generated pool.
+              $section$
+              static const ::_pbi::DescriptorTable* const $dummy$ =
+                  &$desc_table$;
+              // Makes this binary or shared object report its section.
+              __attribute__((used)) static const bool* const $section_dummy$ =
+                  &::_pbi::DescriptorTableSection<>::registered;
+#else
               // Force running AddDescriptors() at dynamic initialization time.
               PROTOBUF_ATTRIBUTE_INIT_PRIORITY2
               static ::_pbi::AddDescriptorsRunner $dummy$(&$desc_table$);
+#endif  // defined($section$)
             )cc");
   }
 
@@ -1519,7 +1680,6 @@ void FileGenerator::GenerateLibraryIncludes(io::Printer* p) {
     IncludeFile("third_party/protobuf/weak_field_map.h", p);
   }
   if (HasLazyFields(file_, options_, &scc_analyzer_)) {
-    ABSL_CHECK(!options_.opensource_runtime);
     IncludeFile("third_party/protobuf/lazy_field.h", p);
   }
   if (ShouldVerify(file_, options_, &scc_analyzer_)) {
@@ -1556,13 +1716,17 @@ void FileGenerator::GenerateLibraryIncludes(io::Printer* p) {
   IncludeFile("third_party/protobuf/arena.h", p);
   IncludeFile("third_party/protobuf/arenastring.h", p);
   if ((options_.force_inline_string || options_.profile_driven_inline_string) &&
-      !options_.opensource_runtime) {
+      (!options_.opensource_runtime || options_.parse_profile != nullptr)) {
     IncludeFile("third_party/protobuf/inlined_string_field.h", p);
   }
+  if (HasRepeatedStringBufferFields(file_, options_)) {
+    IncludeFile("third_party/protobuf/repeated_string_buffer.h", p);
+  }
   if (HasSimpleBaseClasses(file_, options_)) {
     IncludeFile("third_party/protobuf/generated_message_bases.h", p);
   }
-  if (HasGeneratedMethods(file_, options_)) {
+  if (HasGeneratedMethods(file_, options_) ||
+      HasTableDrivenMethods(file_, options_)) {
     IncludeFile("third_party/protobuf/generated_message_tctable_decl.h", p);
   }
   IncludeFile("third_party/protobuf/generated_message_util.h", p);
@@ -1579,6 +1743,10 @@ void FileGenerator::GenerateLibraryIncludes(io::Printer* p) {
       IncludeFile("third_party/protobuf/message_lite.h", p);
     }
   }
+  if (options_.field_listener_options.inject_field_listener_events &&
+      HasDescriptorMethods(file_, options_)) {
+    IncludeFile("third_party/protobuf/field_access_listener.h", p);
+  }
   if (options_.opensource_runtime) {
     // Open-source relies on unconditional includes of these.
     IncludeFileAndExport("third_party/protobuf/repeated_field.h", p);
@@ -1600,6 +1768,11 @@ void FileGenerator::GenerateLibraryIncludes(io::Printer* p) {
       #include "absl/strings/cord.h"
       )");
   }
+  if (HasRepeatedFields(file_)) {
+    p->Emit(R"(
+      #include "absl/types/span.h"
+      )");
+  }
   if (HasMapFields(file_)) {
     IncludeFileAndExport("third_party/protobuf/map.h", p);
     if (HasDescriptorMethods(file_, options_)) {
@@ -1735,6 +1908,74 @@ void FileGenerator::GenerateExtensionIdentifiers(io::Printer* p) {
   }
 }
 
+void FileGenerator::GenerateMessageConstantDeclarations(io::Printer* p) {
+  if (options_.message_constants == nullptr) return;
+  for (const auto& constant : options_.message_constants->constants()) {
+    p->Emit({{"type", QualifiedClassName(constant.value->GetDescriptor(),
+                                         options_)},
+             {"name", constant.name},
+             {"source", constant.source}},
+            R"cc(
+              // Parsed from $source$ when this file was generated.
+              $dllexport_decl $extern const $type$& $name$;
+            )cc");
+  }
+}
+
+void FileGenerator::GenerateMessageConstants(io::Printer* p) {
+  if (options_.message_constants == nullptr) return;
+  for (const auto& generator : message_generators_) {
+    generator->GenerateConstantConstructor(p);
+  }
+  for (const auto& constant : options_.message_constants->constants()) {
+    int count = 0;
+    std::string storage =
+        GenerateConstantStorage(p, *constant.value, constant.name, &count);
+    p->Emit({{"type", QualifiedClassName(constant.value->GetDescriptor(),
+                                         options_)},
+             {"name", constant.name},
+             {"storage", storage}},
+            R"cc(
+              PROTOBUF_CONSTINIT const $type$& $name$ = $storage$.value;
+            )cc");
+  }
+}
+
+std::string FileGenerator::GenerateConstantStorage(io::Printer* p,
+                                                   const Message& value,
+                                                   absl::string_view name,
+                                                   int* count) {
+  const MessageGenerator* generator = nullptr;
+  for (const auto& g : message_generators_) {
+    if (g->descriptor() == value.GetDescriptor()) generator = g.get();
+  }
+  ABSL_CHECK(generator != nullptr) << value.GetDescriptor()->full_name();
+  std::string args =
+      generator->ConstantConstructorArgs(value, [&](const Message& sub) {
+        return absl::StrCat("&", GenerateConstantStorage(p, sub, name, count),
+                            ".value");
+      });
+  std::string storage = absl::StrCat(name, "_storage_", (*count)++);
+  p->Emit({{"type", QualifiedClassName(value.GetDescriptor(), options_)},
+           {"storage", storage},
+           {"args", args}},
+          R"cc(
+            namespace {
+            struct $storage$_t {
+              PROTOBUF_CONSTEXPR $storage$_t()
+                  : value(::_pbi::ConstantInitialized{}, $args$) {}
+              ~$storage$_t() {}
+              union {
+                $type$ value;
+              };
+            };
+            PROTOBUF_ATTRIBUTE_NO_DESTROY PROTOBUF_CONSTINIT const $storage$_t
+                $storage$;
+            }  // namespace
+          )cc");
+  return storage;
+}
+
 void FileGenerator::GenerateInlineFunctionDefinitions(io::Printer* p) {
   // TODO(gerbens) remove pragmas when gcc is no longer used. Current version
   // of gcc fires a bogus error when compiled with strict-aliasing.
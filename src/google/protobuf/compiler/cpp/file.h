@@ -93,6 +93,18 @@ class PROTOC_EXPORT FileGenerator {
   // extensions.
   void GenerateGlobalSource(io::Printer* p);
 
+  // The following member functions are used when the num_cc_files option is
+  // set without lite_implicit_weak_fields. The messages are spread over that
+  // many numbered .cc files, balanced by an estimate of the code generated for
+  // each, so that they can be compiled in parallel; GenerateSource() then
+  // produces the main pb.cc file with everything else.
+
+  // Returns the indices of the messages in each of `num_shards` .cc files.
+  std::vector<std::vector<int>> ShardMessages(int num_shards) const;
+  // Generates the source file for the given messages.
+  void GenerateSourceForShard(const std::vector<int>& message_indices,
+                              io::Printer* p);
+
  private:
   // Generates a file, setting up the necessary accoutrements that start and
   // end the file, calling `cb` in between.
@@ -129,6 +141,13 @@ class PROTOC_EXPORT FileGenerator {
   void GenerateSourcePrelude(io::Printer* p);
   void GenerateSourceDefaultInstance(int idx, io::Printer* p);
 
+  // True if messages are generated by GenerateSourceForShard() rather than
+  // GenerateSource().
+  bool ShardsMessages() const {
+    return options_.num_cc_files > 0 &&
+           !UsingImplicitWeakFields(file_, options_);
+  }
+
   void GenerateInitForSCC(const SCC* scc, const CrossFileReferences& refs,
                           io::Printer* p);
   void GenerateReflectionInitializationCode(io::Printer* p);
@@ -165,6 +184,15 @@ class PROTOC_EXPORT FileGenerator {
   // Generates inline function definitions.
   void GenerateInlineFunctionDefinitions(io::Printer* p);
 
+  // Generates the declarations and definitions of the message constants
+  // listed with the `constants` option.
+  void GenerateMessageConstantDeclarations(io::Printer* p);
+  void GenerateMessageConstants(io::Printer* p);
+  // Emits constant-initialized storage for `value` after that of each of its
+  // sub-messages, and returns its name.
+  std::string GenerateConstantStorage(io::Printer* p, const Message& value,
+                                      absl::string_view name, int* count);
+
   void GenerateProto2NamespaceEnumSpecializations(io::Printer* p);
 
   // Sometimes the names we use in a .proto file happen to be defined as
@@ -35,17 +35,23 @@
 #include "google/protobuf/compiler/cpp/generator.h"
 
 #include <cstdlib>
+#include <fstream>
 #include <memory>
+#include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "absl/status/status.h"
 #include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "google/protobuf/compiler/cpp/constants.h"
 #include "google/protobuf/compiler/cpp/file.h"
 #include "google/protobuf/compiler/cpp/helpers.h"
+#include "google/protobuf/compiler/cpp/parse_profile.h"
 #include "google/protobuf/cpp_features.pb.h"
 #include "google/protobuf/descriptor.pb.h"
 #include "google/protobuf/descriptor_visitor.h"
@@ -142,7 +148,124 @@ bool CppGenerator::Generate(const FileDescriptor* file,
   //
   // If the lite option is passed to the compiler, we will generate the
   // current files and all transitive dependencies using the LITE runtime.
+  //
+  // If the num_cc_files=N option is passed to the compiler, messages are
+  // implemented in N files named <basename>.out/<i>.cc rather than in the
+  // .pb.cc file, balanced by estimated code size, so that large protos can be
+  // compiled in parallel.
+  //
+  // If the lite_lazy_implicit_weak_fields option is passed to the compiler, it
+  // implies lite_implicit_weak_fields, and in addition singular non-oneof
+  // implicit weak fields are stored as internal::LazyField: parsing only
+  // copies their bytes, and they are parsed into the real message type the
+  // first time they are accessed, which also requires the type to be linked.
+  // Fields that are never accessed cost neither code size nor parse time and
+  // are serialized by copying the bytes.
+  //
+  // If the lite_lazy_fields option is passed to the compiler, singular
+  // non-oneof message fields marked [lazy = true] in LITE_RUNTIME files are
+  // stored the same way.  Their bytes are not checked for required fields.
+  // Const accessors parse an unparsed field in place, so reading one message
+  // from several threads needs external synchronization until each lazy field
+  // has been read once.
+  //
+  // If the table_serializer_min_fields=N option is passed to the compiler,
+  // messages with at least N fields are serialized and sized by walking their
+  // parse table (TcParser::SerializeWithTable) instead of with per-field
+  // generated code, which keeps the generated code for large messages small.
+  //
+  // If the sparse_clear_min_fields=N option is passed to the compiler,
+  // messages with at least N fields with has-bits implement Clear() by
+  // visiting only the fields whose has-bit is set, which is cheaper for
+  // large messages that are reused and sparsely populated.
+  //
+  // If the sparse_serialize_min_fields=N option is passed to the compiler,
+  // messages with at least N fields with has-bits assign has-bits in field
+  // number order and serialize and size those fields by walking the set bits
+  // of each has-bit word, so that sparsely populated messages pay only for the
+  // fields they set.
+  //
+  // If the lazy_descriptor_registration option is passed to the compiler, the
+  // generated file does not register its descriptor from a dynamic
+  // initializer; registration happens on first use of reflection or of the
+  // generated pool, as with PROTOBUF_LAZY_GENERATED_FILE_REGISTRATION, but
+  // without having to build every .pb.cc with that macro. Only ELF targets
+  // support this; elsewhere the option has no effect.
+  //
+  // If the parse_profile=<file> option is passed to the compiler, the field
+  // frequencies in <file> (see ParseProfile for the format, and
+  // internal::TcParseProfile for how to collect them) steer the generated code
+  // of the messages they cover: the most frequent fields get the fast parse
+  // table slots and are laid out first, hot singular string fields are
+  // inlined into the message (InlinedStringField) instead of being allocated
+  // separately, rarely seen fields move to a separately allocated split
+  // struct and nearly always present sub-messages are allocated with their
+  // parent. Passing profile_driven_inline_string=false keeps strings out of
+  // line.
+  //
+  // If the cold_sections option is passed to the compiler, functions that
+  // only reflection reaches, such as GetMetadata() and enum descriptor
+  // getters, are marked cold so that the compiler places them away from the
+  // hot text. Combined with parse_profile, every out-of-line method of a
+  // message the profile never saw is marked cold as well (Clang only).
+  //
+  // If the constants=<file> option is passed to the compiler, the message
+  // values listed in that manifest (see MessageConstants) are parsed from
+  // text format at generation time and defined in the generated code as
+  // constant-initialized `const Foo&` objects, which need neither parsing nor
+  // a dynamic initializer at startup.
+  //
+  // If the equality option is passed to the compiler, messages get a
+  // field-by-field `bool Equals(const Foo&, const Foo&)`, found by ADL, which
+  // compares has-bits words first, compares runs of integer fields with
+  // memcmp and returns at the first difference. With equality=operator,
+  // operator== and operator!= are generated as well. Messages with extensions
+  // or weak or lazy fields get no Equals(); as fields of other messages, they
+  // and messages generated without the option are compared by their
+  // deterministic serialization.
+  //
+  // If the specialized_parse=<message>[+<message>...] option is passed to the
+  // compiler, the listed messages (by full name) get an _InternalParse() that
+  // expects their fields in field number order, the order they are
+  // serialized in, and parses each of them inline without going through the
+  // parse table. The first tag out of that order hands the rest of the
+  // message to the table-driven parser. This only pays off for a handful of
+  // very hot messages, at the cost of code size.
+  //
+  // If the retain_lazy_encoding=<message>[+<message>...] option is passed to
+  // the compiler, the LazyField-backed fields of the listed messages (by full
+  // name, see lite_lazy_fields) keep the bytes they write for a mutated
+  // sub-message. Until the next mutable_<field>(), re-serializing the owner
+  // copies those bytes instead of encoding the sub-message again, so after a
+  // small change only the path to it is re-encoded. Sub-message pointers
+  // must not be used for modification after the owner is serialized.
+  //
+  // If the repeated_string_buffer=<field>[+<field>...] option is passed to the
+  // compiler, the listed repeated string and bytes fields (by full name) are
+  // stored in a RepeatedStringBuffer: all elements back to back in one byte
+  // buffer, plus a 32-bit end offset per element, instead of one std::string
+  // per element. Parsing appends each element with a memcpy. The accessors
+  // return absl::string_view, and elements can be set and added but not
+  // mutated in place. Reflection copies elements out, and
+  // GetRepeatedPtrField() on such a field fails.
+  //
+  // If the recycle_oneof_messages option is passed to the compiler, clearing
+  // a message alternative of a oneof on an arena keeps the sub-message aside
+  // instead of abandoning it, one slot per alternative, and the next
+  // mutable_<field>() of that alternative clears and reuses it. A message
+  // whose oneofs keep switching between the same alternatives then stops
+  // growing its arena. Pointers to a cleared sub-message must not be used
+  // afterwards, as it may come back as a different value. The parser still
+  // allocates a new sub-message when it switches a oneof.
+  //
+  // If the heap_free_list=N option is passed to the compiler, message classes
+  // get their own operator new and delete, which keep the storage of up to N
+  // deleted messages of each type per thread and reuse it for the next
+  // messages of that type allocated on the heap by that thread, including
+  // sub-messages. Arena allocation is unaffected.
   Options file_options;
+  absl::optional<ParseProfile> parse_profile;
+  std::string constants_manifest;
 
   file_options.opensource_runtime = opensource_runtime_;
   file_options.runtime_include_base = runtime_include_base_;
@@ -165,6 +288,8 @@ bool CppGenerator::Generate(const FileDescriptor* file,
       file_options.enforce_mode = EnforceOptimizeMode::kSpeed;
     } else if (key == "code_size") {
       file_options.enforce_mode = EnforceOptimizeMode::kCodeSize;
+    } else if (key == "table_driven") {
+      file_options.enforce_mode = EnforceOptimizeMode::kTableDriven;
     } else if (key == "lite") {
       file_options.enforce_mode = EnforceOptimizeMode::kLiteRuntime;
     } else if (key == "lite_implicit_weak_fields") {
@@ -173,6 +298,43 @@ bool CppGenerator::Generate(const FileDescriptor* file,
       if (!value.empty()) {
         file_options.num_cc_files = std::strtol(value.c_str(), nullptr, 10);
       }
+    } else if (key == "lite_lazy_implicit_weak_fields") {
+      file_options.enforce_mode = EnforceOptimizeMode::kLiteRuntime;
+      file_options.lite_implicit_weak_fields = true;
+      file_options.lite_lazy_implicit_weak_fields = true;
+    } else if (key == "lite_lazy_fields") {
+      file_options.lite_lazy_fields = true;
+    } else if (key == "num_cc_files") {
+      if (!absl::SimpleAtoi(value, &file_options.num_cc_files) ||
+          file_options.num_cc_files <= 0) {
+        *error = absl::StrCat("Invalid num_cc_files: ", value);
+        return false;
+      }
+    } else if (key == "table_serializer_min_fields") {
+      if (!absl::SimpleAtoi(value, &file_options.table_serializer_min_fields) ||
+          file_options.table_serializer_min_fields <= 0) {
+        *error = absl::StrCat("Invalid table_serializer_min_fields: ", value);
+        return false;
+      }
+    } else if (key == "sparse_clear_min_fields") {
+      if (!absl::SimpleAtoi(value, &file_options.sparse_clear_min_fields) ||
+          file_options.sparse_clear_min_fields <= 0) {
+        *error = absl::StrCat("Invalid sparse_clear_min_fields: ", value);
+        return false;
+      }
+    } else if (key == "sparse_serialize_min_fields") {
+      if (!absl::SimpleAtoi(value,
+                            &file_options.sparse_serialize_min_fields) ||
+          file_options.sparse_serialize_min_fields <= 0) {
+        *error = absl::StrCat("Invalid sparse_serialize_min_fields: ", value);
+        return false;
+      }
+    } else if (key == "heap_free_list") {
+      if (!absl::SimpleAtoi(value, &file_options.heap_free_list_size) ||
+          file_options.heap_free_list_size <= 0) {
+        *error = absl::StrCat("Invalid heap_free_list: ", value);
+        return false;
+      }
     } else if (key == "proto_h") {
       file_options.proto_h = true;
     } else if (key == "proto_static_reflection_h") {
@@ -186,6 +348,18 @@ bool CppGenerator::Generate(const FileDescriptor* file,
           break;
         }
       }
+    } else if (key == "specialized_parse") {
+      for (absl::string_view message : absl::StrSplit(value, '+')) {
+        file_options.specialized_parse_messages.emplace(message);
+      }
+    } else if (key == "retain_lazy_encoding") {
+      for (absl::string_view message : absl::StrSplit(value, '+')) {
+        file_options.retain_lazy_encoding_messages.emplace(message);
+      }
+    } else if (key == "repeated_string_buffer") {
+      for (absl::string_view field : absl::StrSplit(value, '+')) {
+        file_options.repeated_string_buffer_fields.emplace(field);
+      }
     } else if (key == "inject_field_listener_events") {
       file_options.field_listener_options.inject_field_listener_events = true;
     } else if (key == "forbidden_field_listener_events") {
@@ -204,6 +378,42 @@ bool CppGenerator::Generate(const FileDescriptor* file,
       file_options.force_eagerly_verified_lazy = true;
     } else if (key == "experimental_strip_nonfunctional_codegen") {
       file_options.strip_nonfunctional_codegen = true;
+    } else if (key == "lazy_descriptor_registration") {
+      file_options.lazy_descriptor_registration = true;
+    } else if (key == "recycle_oneof_messages") {
+      file_options.recycle_oneof_messages = true;
+    } else if (key == "cold_sections") {
+      file_options.cold_sections = true;
+    } else if (key == "profile_driven_inline_string") {
+      if (!absl::SimpleAtob(value,
+                            &file_options.profile_driven_inline_string)) {
+        *error = absl::StrCat("Invalid profile_driven_inline_string: ", value);
+        return false;
+      }
+    } else if (key == "parse_profile") {
+      std::ifstream profile_stream(value);
+      if (!profile_stream) {
+        *error = absl::StrCat("Unable to read parse profile: ", value);
+        return false;
+      }
+      std::stringstream profile_content;
+      profile_content << profile_stream.rdbuf();
+      auto profile = ParseProfile::Parse(profile_content.str());
+      if (!profile.ok()) {
+        *error = std::string(profile.status().message());
+        return false;
+      }
+      parse_profile = *std::move(profile);
+      file_options.parse_profile = &*parse_profile;
+    } else if (key == "constants") {
+      constants_manifest = value;
+    } else if (key == "equality") {
+      if (!value.empty() && value != "operator") {
+        *error = absl::StrCat("Invalid equality value: ", value);
+        return false;
+      }
+      file_options.equality = true;
+      file_options.equality_operator = value == "operator";
     } else {
       *error = absl::StrCat("Unknown generator option: ", key);
       return false;
@@ -218,6 +428,51 @@ bool CppGenerator::Generate(const FileDescriptor* file,
     return false;
   }
 
+  for (const std::string& name : file_options.retain_lazy_encoding_messages) {
+    if (file->pool()->FindMessageTypeByName(name) == nullptr) {
+      *error = absl::StrCat("Unknown message in retain_lazy_encoding: ", name);
+      return false;
+    }
+  }
+  for (const std::string& name : file_options.specialized_parse_messages) {
+    if (file->pool()->FindMessageTypeByName(name) == nullptr) {
+      *error = absl::StrCat("Unknown message in specialized_parse: ", name);
+      return false;
+    }
+  }
+  for (const std::string& name : file_options.repeated_string_buffer_fields) {
+    const FieldDescriptor* field = file->pool()->FindFieldByName(name);
+    if (field == nullptr) {
+      *error = absl::StrCat("Unknown field in repeated_string_buffer: ", name);
+      return false;
+    }
+    if (!field->is_repeated() ||
+        field->cpp_type() != FieldDescriptor::CPPTYPE_STRING ||
+        field->options().ctype() != FieldOptions::STRING) {
+      *error = absl::StrCat(
+          "Field in repeated_string_buffer is not a repeated string or bytes "
+          "field: ",
+          name);
+      return false;
+    }
+  }
+
+  std::unique_ptr<MessageConstants> message_constants;
+  if (!constants_manifest.empty()) {
+#ifdef PROTOBUF_EXPLICIT_CONSTRUCTORS
+    *error = "The constants option requires aggregate initialized messages.";
+    return false;
+#endif  // PROTOBUF_EXPLICIT_CONSTRUCTORS
+    auto constants =
+        MessageConstants::Load(constants_manifest, file, file_options);
+    if (!constants.ok()) {
+      *error = std::string(constants.status().message());
+      return false;
+    }
+    message_constants = *std::move(constants);
+    file_options.message_constants = message_constants.get();
+  }
+
   // -----------------------------------------------------------------
 
 
@@ -351,12 +606,31 @@ bool CppGenerator::Generate(const FileDescriptor* file,
           NumberedCcFileName(basename, cc_file_number++)));
     }
   } else {
-    auto output = absl::WrapUnique(
-        generator_context->Open(absl::StrCat(basename, ".pb.cc")));
-    io::Printer p(output.get());
-    auto v = p.WithVars(CommonVars(file_options));
+    {
+      auto output = absl::WrapUnique(
+          generator_context->Open(absl::StrCat(basename, ".pb.cc")));
+      io::Printer p(output.get());
+      auto v = p.WithVars(CommonVars(file_options));
+
+      file_generator.GenerateSource(&p);
+    }
 
-    file_generator.GenerateSource(&p);
+    // With num_cc_files, the messages are in numbered .cc files instead. Each
+    // file is always written, possibly empty, so that build rules can list
+    // them up front.
+    if (file_options.num_cc_files > 0) {
+      std::vector<std::vector<int>> shards =
+          file_generator.ShardMessages(file_options.num_cc_files);
+      for (int i = 0; i < shards.size(); ++i) {
+        auto output = absl::WrapUnique(
+            generator_context->Open(NumberedCcFileName(basename, i)));
+        if (shards[i].empty()) continue;
+        io::Printer p(output.get());
+        auto v = p.WithVars(CommonVars(file_options));
+
+        file_generator.GenerateSourceForShard(shards[i], &p);
+      }
+    }
   }
 
   return true;
@@ -95,6 +95,8 @@ class PROTOC_EXPORT CppGenerator : public CodeGenerator {
     return FEATURE_PROTO3_OPTIONAL | FEATURE_SUPPORTS_EDITIONS;
   }
 
+  bool SupportsConcurrentFileGeneration() const override { return true; }
+
   std::vector<const FieldDescriptor*> GetFeatureExtensions() const override {
     return {GetExtensionReflection(pb::cpp)};
   }
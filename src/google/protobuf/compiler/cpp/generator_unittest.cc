@@ -31,11 +31,17 @@
 #include "google/protobuf/compiler/cpp/generator.h"
 
 #include <memory>
+#include <string>
 
 #include "google/protobuf/descriptor.pb.h"
 #include <gtest/gtest.h>
+#include "absl/log/absl_check.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "google/protobuf/compiler/command_line_interface_tester.h"
 #include "google/protobuf/cpp_features.pb.h"
+#include "google/protobuf/testing/file.h"
 
 namespace google {
 namespace protobuf {
@@ -287,6 +293,929 @@ TEST_F(CppGeneratorTest, CtypeOnExtensionTest) {
       "not supported for extensions.");
 }
 #endif  // !PROTOBUF_FUTURE_REMOVE_WRONG_CTYPE
+
+// `cold` and `hot` map to the same fast table slot, which by default goes to
+// the lower field number.
+constexpr absl::string_view kParseProfileSchema = R"schema(
+    syntax = "proto2";
+    message Foo {
+      optional int32 cold = 1;
+      optional int32 hot = 33;
+    })schema";
+constexpr absl::string_view kHotFastEntry =
+    "// optional int32 hot = 33;\n    {::_pbi::TcParser::";
+
+TEST_F(CppGeneratorTest, ParseProfileDefaultsToFieldOrder) {
+  CreateTempFile("foo.proto", kParseProfileSchema);
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir --cpp_out=$tmpdir foo.proto");
+
+  ExpectNoErrors();
+  std::string generated;
+  ABSL_CHECK_OK(File::GetContents(
+      absl::StrCat(temp_directory(), "/foo.pb.cc"), &generated, true));
+  EXPECT_FALSE(absl::StrContains(generated, kHotFastEntry));
+}
+
+TEST_F(CppGeneratorTest, ParseProfileAssignsFastSlots) {
+  CreateTempFile("foo.proto", kParseProfileSchema);
+  CreateTempFile("profile.txt",
+                 "# message field count\n"
+                 "Foo 1 3\n"
+                 "Foo 33 200\n");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=parse_profile=$tmpdir/profile.txt:$tmpdir foo.proto");
+
+  ExpectNoErrors();
+  std::string generated;
+  ABSL_CHECK_OK(File::GetContents(
+      absl::StrCat(temp_directory(), "/foo.pb.cc"), &generated, true));
+  EXPECT_TRUE(absl::StrContains(generated, kHotFastEntry));
+}
+
+TEST_F(CppGeneratorTest, ParseProfileLaysOutHotFieldsFirstAndSplitsCold) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Foo {
+      optional int64 warm = 1;
+      optional string rare = 2;
+      optional int32 hot = 3;
+      optional int32 hottest = 4;
+      repeated int32 rare_list = 5;
+    })schema");
+  CreateTempFile("profile.txt",
+                 "Foo 1 50\n"
+                 "Foo 3 300\n"
+                 "Foo 4 1000\n"
+                 "Foo 5 1\n");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=parse_profile=$tmpdir/profile.txt:$tmpdir foo.proto");
+
+  ExpectNoErrors();
+  std::string header;
+  ABSL_CHECK_OK(File::GetContents(absl::StrCat(temp_directory(), "/foo.pb.h"),
+                                  &header, true));
+  // `rare` was never seen and moves to the split struct; repeated fields are
+  // never split.
+  const size_t split = header.find("struct Split {");
+  ASSERT_NE(split, std::string::npos);
+  EXPECT_GT(header.find("ArenaStringPtr rare_;"), split);
+  EXPECT_LT(header.find("RepeatedField<::int32_t> rare_list_;"), split);
+  // Hot fields come first, most frequent first.
+  EXPECT_LT(header.find("::int32_t hottest_;"), header.find("::int32_t hot_;"));
+  EXPECT_LT(header.find("::int32_t hot_;"),
+            header.find("RepeatedField<::int32_t> rare_list_;"));
+  EXPECT_LT(header.find("::int32_t hot_;"), header.find("::int64_t warm_;"));
+}
+
+TEST_F(CppGeneratorTest, ParseProfileAllocatesAlwaysPresentMessages) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Bar {
+      optional int32 x = 1;
+    }
+    message Foo {
+      optional Bar always = 1;
+      optional Bar sometimes = 2;
+      optional Foo recursive = 3;
+      oneof kind {
+        Bar in_oneof = 4;
+      }
+    })schema");
+  CreateTempFile("profile.txt",
+                 "Foo 1 100\n"
+                 "Foo 2 50\n"
+                 "Foo 3 100\n"
+                 "Foo 4 100\n");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=parse_profile=$tmpdir/profile.txt:$tmpdir foo.proto");
+
+  ExpectNoErrors();
+  std::string generated;
+  ABSL_CHECK_OK(File::GetContents(
+      absl::StrCat(temp_directory(), "/foo.pb.cc"), &generated, true));
+  // Only `always` is allocated by the constructor: `sometimes` is not frequent
+  // enough, `recursive` would recurse and oneof members share their storage.
+  const std::string eager = "{CreateMaybeMessage<::Bar>(arena)}";
+  const size_t pos = generated.find(eager);
+  ASSERT_NE(pos, std::string::npos);
+  EXPECT_TRUE(absl::StrContains(generated.substr(pos - 16, 16), "always_"));
+  EXPECT_EQ(generated.find(eager, pos + 1), std::string::npos);
+  EXPECT_FALSE(
+      absl::StrContains(generated, "CreateMaybeMessage<::Foo>(arena)}"));
+}
+
+TEST_F(CppGeneratorTest, ParseProfileInlinesHotStrings) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Foo {
+      optional string hot = 1;
+      optional bytes hot_bytes = 2;
+      optional string warm = 3;
+      repeated string hot_list = 4;
+      oneof kind {
+        string hot_choice = 5;
+      }
+    })schema");
+  CreateTempFile("profile.txt",
+                 "Foo 1 1000\n"
+                 "Foo 2 1000\n"
+                 "Foo 3 50\n"
+                 "Foo 4 1000\n"
+                 "Foo 5 1000\n");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=parse_profile=$tmpdir/profile.txt:$tmpdir foo.proto");
+
+  ExpectNoErrors();
+  std::string header;
+  ABSL_CHECK_OK(File::GetContents(absl::StrCat(temp_directory(), "/foo.pb.h"),
+                                  &header, true));
+  EXPECT_TRUE(absl::StrContains(header, "InlinedStringField hot_;"));
+  EXPECT_TRUE(absl::StrContains(header, "InlinedStringField hot_bytes_;"));
+  EXPECT_TRUE(absl::StrContains(header, "ArenaStringPtr warm_;"));
+  EXPECT_TRUE(absl::StrContains(header, "ArenaStringPtr hot_choice_;"));
+  EXPECT_TRUE(absl::StrContains(header, "_inlined_string_donated_;"));
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=parse_profile=$tmpdir/profile.txt,"
+      "profile_driven_inline_string=false:$tmpdir foo.proto");
+
+  ExpectNoErrors();
+  ABSL_CHECK_OK(File::GetContents(absl::StrCat(temp_directory(), "/foo.pb.h"),
+                                  &header, true));
+  EXPECT_FALSE(absl::StrContains(header, "InlinedStringField hot_;"));
+  EXPECT_TRUE(absl::StrContains(header, "ArenaStringPtr hot_;"));
+}
+
+TEST_F(CppGeneratorTest, ColdSectionsForUnprofiledMessages) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Hot {
+      optional int32 a = 1;
+    }
+    message Unused {
+      optional int32 a = 1;
+    })schema");
+  CreateTempFile("profile.txt", "Hot 1 10\n");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=cold_sections,parse_profile=$tmpdir/profile.txt:$tmpdir "
+      "foo.proto");
+
+  ExpectNoErrors();
+  std::string generated;
+  ABSL_CHECK_OK(File::GetContents(
+      absl::StrCat(temp_directory(), "/foo.pb.cc"), &generated, true));
+  EXPECT_TRUE(absl::StrContains(
+      generated,
+      "PROTOBUF_COLD ::google::protobuf::Metadata Hot::GetMetadata()"));
+
+  // Only the methods of the message missing from the profile are bracketed.
+  size_t begin = generated.find("PROTOBUF_COLD_FUNCTIONS_BEGIN");
+  ASSERT_NE(begin, std::string::npos);
+  size_t end = generated.find("PROTOBUF_COLD_FUNCTIONS_END", begin);
+  ASSERT_NE(end, std::string::npos);
+  absl::string_view cold_region =
+      absl::string_view(generated).substr(begin, end - begin);
+  EXPECT_TRUE(absl::StrContains(cold_region, "Unused::Clear()"));
+  EXPECT_FALSE(absl::StrContains(cold_region, "Hot::Clear()"));
+  EXPECT_EQ(generated.find("PROTOBUF_COLD_FUNCTIONS_BEGIN", end),
+            std::string::npos);
+}
+
+TEST_F(CppGeneratorTest, ConstantsAreConstantInitialized) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    package pkg;
+    message Limits {
+      optional int64 max_bytes = 1;
+      optional float ratio = 2;
+    }
+    message Config {
+      optional int32 retries = 1;
+      optional bool verbose = 2;
+      optional Limits limits = 3;
+      optional string name = 4;
+    })schema");
+  CreateTempFile("config.txtpb",
+                 "retries: 3 limits { max_bytes: 4096 ratio: 0.5 }");
+  CreateTempFile("constants.txt",
+                 absl::StrCat("# Shared by every file of the target.\n"
+                              "kDefaultConfig pkg.Config ",
+                              temp_directory(), "/config.txtpb\n",
+                              "kOther other.Message unused.txtpb\n"));
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=constants=$tmpdir/constants.txt:$tmpdir foo.proto");
+
+  ExpectNoErrors();
+  std::string header;
+  ABSL_CHECK_OK(File::GetContents(absl::StrCat(temp_directory(), "/foo.pb.h"),
+                                  &header, true));
+  EXPECT_TRUE(
+      absl::StrContains(header, "extern const ::pkg::Config& kDefaultConfig;"));
+  std::string generated;
+  ABSL_CHECK_OK(File::GetContents(
+      absl::StrCat(temp_directory(), "/foo.pb.cc"), &generated, true));
+  // The sub-message is defined first and referenced by address.
+  EXPECT_TRUE(absl::StrContains(generated, "::int64_t{4096}, 0.5f)"));
+  EXPECT_LT(generated.find("::int64_t{4096}, 0.5f)"),
+            generated.find("&kDefaultConfig_storage_0.value, 3, false)"));
+  EXPECT_TRUE(absl::StrContains(
+      generated,
+      "PROTOBUF_CONSTINIT const ::pkg::Config& kDefaultConfig = "
+      "kDefaultConfig_storage_1.value;"));
+}
+
+TEST_F(CppGeneratorTest, ConstantsRejectStrings) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Config {
+      optional string name = 1;
+    })schema");
+  CreateTempFile("config.txtpb", "name: \"x\"");
+  CreateTempFile("constants.txt", absl::StrCat("kConfig Config ",
+                                               temp_directory(),
+                                               "/config.txtpb\n"));
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=constants=$tmpdir/constants.txt:$tmpdir foo.proto");
+
+  ExpectErrorSubstring("Field Config.name cannot be set in a constant");
+}
+
+TEST_F(CppGeneratorTest, NumCcFilesBalancesMessages) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Big {
+      optional int32 a = 1; optional int32 b = 2; optional int32 c = 3;
+      optional int32 d = 4; optional int32 e = 5; optional int32 f = 6;
+    }
+    message Small1 {}
+    message Small2 {}
+    message Small3 {}
+  )schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=num_cc_files=3:$tmpdir foo.proto");
+
+  ExpectNoErrors();
+  std::string main, shards[3];
+  ABSL_CHECK_OK(File::GetContents(absl::StrCat(temp_directory(), "/foo.pb.cc"),
+                                  &main, true));
+  for (int i = 0; i < 3; ++i) {
+    ABSL_CHECK_OK(File::GetContents(
+        absl::StrCat(temp_directory(), "/foo.out/", i, ".cc"), &shards[i],
+        true));
+  }
+  // The main file keeps the reflection data but no message methods.
+  EXPECT_TRUE(absl::StrContains(main, "descriptor_table_foo_2eproto"));
+  EXPECT_FALSE(absl::StrContains(main, "Big::Big("));
+  // The heaviest message gets a file of its own.
+  EXPECT_TRUE(absl::StrContains(shards[0], "Big::Big("));
+  EXPECT_FALSE(absl::StrContains(shards[0], "Small"));
+  EXPECT_TRUE(absl::StrContains(shards[1], "Small1::Small1("));
+  EXPECT_TRUE(absl::StrContains(shards[1], "Small3::Small3("));
+  EXPECT_TRUE(absl::StrContains(shards[2], "Small2::Small2("));
+}
+
+TEST_F(CppGeneratorTest, NumCcFilesInvalid) {
+  CreateTempFile("foo.proto", "syntax = \"proto2\";\n");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=num_cc_files=0:$tmpdir foo.proto");
+
+  ExpectErrorSubstring("Invalid num_cc_files: 0");
+}
+
+TEST_F(CppGeneratorTest, TableDrivenKeepsOnlyParseTables) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Foo {
+      optional int32 a = 1;
+      repeated string b = 2;
+      extensions 100 to max;
+    }
+    message Set {
+      option message_set_wire_format = true;
+      extensions 4 to max;
+    })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=table_driven:$tmpdir foo.proto");
+
+  ExpectNoErrors();
+  std::string source;
+  ABSL_CHECK_OK(File::GetContents(absl::StrCat(temp_directory(), "/foo.pb.cc"),
+                                  &source, true));
+  EXPECT_TRUE(absl::StrContains(source, "Foo::_table_"));
+  EXPECT_TRUE(absl::StrContains(source, "Foo::_InternalParse("));
+  EXPECT_TRUE(absl::StrContains(
+      source, "TcParser::SerializeWithTable(*this, &_table_.header"));
+  EXPECT_TRUE(absl::StrContains(source, "TcParser::ByteSizeWithTable("));
+  // Merging, clearing and initialization checks stay reflective.
+  EXPECT_FALSE(absl::StrContains(source, "Foo::MergeImpl("));
+  EXPECT_FALSE(absl::StrContains(source, "Foo::Clear()"));
+  EXPECT_FALSE(absl::StrContains(source, "Foo::IsInitialized()"));
+  // MessageSets have no table-driven serializer.
+  EXPECT_FALSE(absl::StrContains(source, "Set::_InternalSerialize("));
+}
+
+TEST_F(CppGeneratorTest, TableSerializerForLargeMessages) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Small {
+      optional int32 a = 1;
+    }
+    message Large {
+      optional int32 a = 1;
+      repeated string b = 2;
+      optional Small c = 3;
+    }
+    message WithMap {
+      optional int32 a = 1;
+      optional int32 b = 2;
+      map<int32, int32> c = 3;
+    })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=table_serializer_min_fields=3:$tmpdir foo.proto");
+
+  ExpectNoErrors();
+  std::string source;
+  ABSL_CHECK_OK(File::GetContents(absl::StrCat(temp_directory(), "/foo.pb.cc"),
+                                  &source, true));
+  // Only Large qualifies: Small is below the threshold and WithMap has a
+  // field the parse table cannot serialize on its own.
+  EXPECT_TRUE(absl::StrContains(
+      source, "TcParser::SerializeWithTable(*this, &_table_.header"));
+  EXPECT_TRUE(absl::StrContains(source, "TcParser::ByteSizeWithTable("));
+  EXPECT_FALSE(absl::StrContains(source, "serialize_to_array_start:Large"));
+  EXPECT_FALSE(absl::StrContains(source, "message_byte_size_start:Large"));
+  EXPECT_TRUE(absl::StrContains(source, "serialize_to_array_start:Small"));
+  EXPECT_TRUE(absl::StrContains(source, "serialize_to_array_start:WithMap"));
+}
+
+TEST_F(CppGeneratorTest, LazyDescriptorRegistration) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Foo { optional int32 bar = 1; })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=lazy_descriptor_registration:$tmpdir foo.proto");
+
+  ExpectNoErrors();
+  std::string source;
+  ABSL_CHECK_OK(File::GetContents(absl::StrCat(temp_directory(), "/foo.pb.cc"),
+                                  &source, true));
+  EXPECT_TRUE(absl::StrContains(
+      source, "#if defined(PROTOBUF_DESCRIPTOR_TABLE_SECTION_ATTRIBUTE)"));
+  EXPECT_TRUE(absl::StrContains(
+      source, "&::_pbi::DescriptorTableSection<>::registered"));
+}
+
+TEST_F(CppGeneratorTest, LiteLazyImplicitWeakFields) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    option optimize_for = LITE_RUNTIME;
+    message Leaf { optional int32 a = 1; }
+    message Foo {
+      optional Leaf leaf = 1;
+      repeated Leaf leaves = 2;
+      oneof o { Leaf choice = 3; }
+    })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=lite_lazy_implicit_weak_fields:$tmpdir foo.proto");
+
+  ExpectNoErrors();
+  std::string header, source;
+  ABSL_CHECK_OK(File::GetContents(absl::StrCat(temp_directory(), "/foo.pb.h"),
+                                  &header, true));
+  ABSL_CHECK_OK(File::GetContents(
+      absl::StrCat(temp_directory(), "/foo.out/1.cc"), &source, true));
+  EXPECT_TRUE(absl::StrContains(header, "internal::LazyField leaf_;"));
+  // Repeated and oneof fields stay eager.
+  EXPECT_FALSE(absl::StrContains(header, "LazyField leaves_;"));
+  EXPECT_FALSE(absl::StrContains(header, "LazyField choice_;"));
+  EXPECT_TRUE(
+      absl::StrContains(source, "::_fl::kRepLazy | ::_fl::kTvWeakPtr"));
+  EXPECT_TRUE(absl::StrContains(source, "_impl_.leaf_.InternalWrite(1,"));
+}
+
+TEST_F(CppGeneratorTest, LiteLazyFields) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    option optimize_for = LITE_RUNTIME;
+    message Leaf { optional int32 a = 1; }
+    message Foo {
+      optional Leaf leaf = 1 [lazy = true];
+      optional Leaf eager = 2;
+      oneof o { Leaf choice = 3 [lazy = true]; }
+    })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=lite_lazy_fields:$tmpdir foo.proto");
+
+  ExpectNoErrors();
+  std::string header, source;
+  ABSL_CHECK_OK(File::GetContents(absl::StrCat(temp_directory(), "/foo.pb.h"),
+                                  &header, true));
+  ABSL_CHECK_OK(File::GetContents(absl::StrCat(temp_directory(), "/foo.pb.cc"),
+                                  &source, true));
+  EXPECT_TRUE(absl::StrContains(header, "internal::LazyField leaf_;"));
+  // Unannotated and oneof fields stay eager.
+  EXPECT_FALSE(absl::StrContains(header, "LazyField eager_;"));
+  EXPECT_FALSE(absl::StrContains(header, "LazyField choice_;"));
+  EXPECT_TRUE(absl::StrContains(source, "::_fl::kRepLazy | ::_fl::kTvLazy"));
+}
+
+TEST_F(CppGeneratorTest, LazyFieldsAreEagerWithoutOption) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    option optimize_for = LITE_RUNTIME;
+    message Leaf { optional int32 a = 1; }
+    message Foo { optional Leaf leaf = 1 [lazy = true]; })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir --cpp_out=$tmpdir foo.proto");
+
+  ExpectNoErrors();
+  std::string header;
+  ABSL_CHECK_OK(File::GetContents(absl::StrCat(temp_directory(), "/foo.pb.h"),
+                                  &header, true));
+  EXPECT_FALSE(absl::StrContains(header, "LazyField"));
+}
+
+TEST_F(CppGeneratorTest, RetainLazyEncodingRejectsUnknownMessage) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    package pkg;
+    message Foo { optional int32 bar = 1; })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=retain_lazy_encoding=pkg.Foo+pkg.Baz:$tmpdir foo.proto");
+
+  ExpectErrorSubstring("Unknown message in retain_lazy_encoding: pkg.Baz");
+}
+
+TEST_F(CppGeneratorTest, InvalidTableSerializerMinFields) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Foo { optional int32 bar = 1; })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=table_serializer_min_fields=0:$tmpdir foo.proto");
+
+  ExpectErrorSubstring("Invalid table_serializer_min_fields: 0");
+}
+
+TEST_F(CppGeneratorTest, SparseClearForLargeMessages) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Small {
+      optional int32 a = 1;
+    }
+    message Large {
+      optional int32 a = 1;
+      optional string b = 2;
+      optional Small c = 3;
+      repeated int32 d = 4;
+    })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=sparse_clear_min_fields=3:$tmpdir foo.proto");
+
+  ExpectNoErrors();
+  std::string source;
+  ABSL_CHECK_OK(File::GetContents(absl::StrCat(temp_directory(), "/foo.pb.cc"),
+                                  &source, true));
+  // Only Large has enough fields with has-bits; its repeated field is still
+  // cleared unconditionally.
+  constexpr absl::string_view kSparseClear =
+      "::absl::countr_zero(cached_has_bits)";
+  size_t pos = source.find(kSparseClear);
+  ASSERT_NE(pos, std::string::npos);
+  EXPECT_EQ(source.find(kSparseClear, pos + 1), std::string::npos);
+  EXPECT_TRUE(absl::StrContains(source, "_impl_.d_.Clear();"));
+}
+
+TEST_F(CppGeneratorTest, InvalidSparseClearMinFields) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Foo { optional int32 bar = 1; })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=sparse_clear_min_fields=0:$tmpdir foo.proto");
+
+  ExpectErrorSubstring("Invalid sparse_clear_min_fields: 0");
+}
+
+TEST_F(CppGeneratorTest, SparseSerializeForLargeMessages) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Small {
+      optional int32 a = 1;
+    }
+    message Large {
+      optional Small c = 3;
+      optional int32 a = 1;
+      optional string b = 2;
+      repeated int32 d = 4;
+      optional int32 e = 5;
+    })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=sparse_serialize_min_fields=3:$tmpdir foo.proto");
+
+  ExpectNoErrors();
+  std::string source;
+  ABSL_CHECK_OK(File::GetContents(absl::StrCat(temp_directory(), "/foo.pb.cc"),
+                                  &source, true));
+  // Only Large has enough fields with has-bits. Fields 1 to 3 form a run that
+  // is serialized by walking its has-bits, then the repeated field and field 5
+  // are serialized as usual. ByteSizeLong() walks all four has-bits.
+  EXPECT_TRUE(absl::StrContains(
+      source, "cached_has_bits = _impl_._has_bits_[0] & 0x00000007u;"));
+  EXPECT_TRUE(
+      absl::StrContains(source, "cached_has_bits = _impl_._has_bits_[0];"));
+  EXPECT_TRUE(absl::StrContains(source, "cached_has_bits & 0x00000008u"));
+}
+
+TEST_F(CppGeneratorTest, InvalidSparseSerializeMinFields) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Foo { optional int32 bar = 1; })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=sparse_serialize_min_fields=0:$tmpdir foo.proto");
+
+  ExpectErrorSubstring("Invalid sparse_serialize_min_fields: 0");
+}
+
+TEST_F(CppGeneratorTest, EqualityComparesFieldByField) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Foo {
+      optional int32 a = 1;
+      optional int32 b = 2;
+      optional string s = 3;
+      optional Foo child = 4;
+      oneof o {
+        int32 x = 5;
+        string y = 6;
+      }
+    }
+    message Extendable {
+      extensions 100 to 200;
+    })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=equality=operator:$tmpdir foo.proto");
+
+  ExpectNoErrors();
+  std::string header, source;
+  ABSL_CHECK_OK(File::GetContents(absl::StrCat(temp_directory(), "/foo.pb.h"),
+                                  &header, true));
+  ABSL_CHECK_OK(File::GetContents(absl::StrCat(temp_directory(), "/foo.pb.cc"),
+                                  &source, true));
+  EXPECT_TRUE(absl::StrContains(
+      header, "friend bool Equals(const Foo& a, const Foo& b)"));
+  EXPECT_TRUE(
+      absl::StrContains(header, "friend bool operator==(const Foo& a,"));
+  // Extensions have no field-by-field comparison.
+  EXPECT_FALSE(absl::StrContains(header, "const Extendable& b)"));
+  EXPECT_TRUE(absl::StrContains(
+      source,
+      "if (_impl_._has_bits_[0] != other._impl_._has_bits_[0]) return false;"));
+  // a and b are adjacent int32 fields.
+  EXPECT_TRUE(absl::StrContains(source, "::memcmp("));
+  EXPECT_TRUE(absl::StrContains(source, "&_impl_.a_, &other._impl_.a_,"));
+  EXPECT_TRUE(absl::StrContains(source, "if (o_case() != other.o_case())"));
+}
+
+TEST_F(CppGeneratorTest, InvalidEquality) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Foo { optional int32 bar = 1; })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=equality=hash:$tmpdir foo.proto");
+
+  ExpectErrorSubstring("Invalid equality value: hash");
+}
+
+TEST_F(CppGeneratorTest, HeapFreeList) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Foo {
+      optional int32 a = 1;
+      map<int32, int32> m = 2;
+    })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=heap_free_list=4:$tmpdir foo.proto");
+
+  ExpectNoErrors();
+  std::string header;
+  ABSL_CHECK_OK(File::GetContents(absl::StrCat(temp_directory(), "/foo.pb.h"),
+                                  &header, true));
+  EXPECT_TRUE(absl::StrContains(
+      header, "MessageFreeList<Foo>::Deallocate(ptr, size, 4);"));
+  EXPECT_TRUE(absl::StrContains(
+      header, "MessageFreeList<Foo>::Allocate(size, tag);"));
+  // Map entries are not allocated on their own.
+  EXPECT_FALSE(absl::StrContains(header, "MessageFreeList<Foo_MEntry"));
+}
+
+TEST_F(CppGeneratorTest, SpanAccessorNameCollisions) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Foo {
+      repeated int32 foo = 1;
+      repeated int32 foo_span = 2;
+      repeated int32 n_foo = 3;
+    })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir --cpp_out=$tmpdir foo.proto");
+
+  ExpectNoErrors();
+  std::string header;
+  ABSL_CHECK_OK(File::GetContents(absl::StrCat(temp_directory(), "/foo.pb.h"),
+                                  &header, true));
+  // `foo_span()` and `mutable_foo_span()` are accessors of `foo_span`, and
+  // `add_n_foo()` is `add_()` of `n_foo`.
+  EXPECT_TRUE(absl::StrContains(header, "Foo::foo_span__() const {"));
+  EXPECT_TRUE(absl::StrContains(header, "Foo::mutable_foo_span__() {"));
+  EXPECT_TRUE(absl::StrContains(header, "Foo::add_n_foo__(int n) {"));
+  EXPECT_TRUE(absl::StrContains(header, "Foo::assign_foo(absl::Span"));
+  EXPECT_TRUE(absl::StrContains(header, "Foo::foo_span_span() const {"));
+}
+
+TEST_F(CppGeneratorTest, InvalidHeapFreeList) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Foo { optional int32 bar = 1; })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=heap_free_list=0:$tmpdir foo.proto");
+
+  ExpectErrorSubstring("Invalid heap_free_list: 0");
+}
+
+TEST_F(CppGeneratorTest, RecycleOneofMessages) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Bar {}
+    message Foo {
+      oneof x {
+        Bar bar = 1;
+        int32 n = 2;
+        string s = 3;
+      }
+      optional Bar other = 4;
+    })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=recycle_oneof_messages:$tmpdir foo.proto");
+
+  ExpectNoErrors();
+  std::string header;
+  ABSL_CHECK_OK(File::GetContents(absl::StrCat(temp_directory(), "/foo.pb.h"),
+                                  &header, true));
+  EXPECT_TRUE(absl::StrContains(header, "::Bar* _recycled_bar_ = nullptr;"));
+  EXPECT_TRUE(absl::StrContains(
+      header, "_impl_._recycled_bar_ = _impl_.x_.bar_;"));
+  EXPECT_TRUE(absl::StrContains(header, "_impl_.x_.bar_->Clear();"));
+  // Only the sub-message _internal_mutable_bar() allocated is kept.
+  EXPECT_TRUE(
+      absl::StrContains(header, "const void* _allocated_x_ = nullptr;"));
+  EXPECT_TRUE(absl::StrContains(
+      header, "} else if (_impl_.x_.bar_ == _impl_._allocated_x_) {"));
+  // Only message alternatives of a oneof keep a slot.
+  EXPECT_FALSE(absl::StrContains(header, "_recycled_n_"));
+  EXPECT_FALSE(absl::StrContains(header, "_recycled_s_"));
+  EXPECT_FALSE(absl::StrContains(header, "_recycled_other_"));
+}
+
+TEST_F(CppGeneratorTest, SpecializedParse) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    package pkg;
+    enum E { E_ZERO = 0; }
+    message Foo {
+      optional int32 a = 1;
+      repeated string s = 2;
+      optional Foo child = 3;
+      optional E e = 4;
+      oneof o { int32 x = 5; }
+      repeated int32 p = 300 [packed = true];
+    }
+    message Bar { optional int32 a = 1; })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=specialized_parse=pkg.Foo:$tmpdir foo.proto");
+
+  ExpectNoErrors();
+  std::string source;
+  ABSL_CHECK_OK(File::GetContents(absl::StrCat(temp_directory(), "/foo.pb.cc"),
+                                  &source, true));
+  EXPECT_TRUE(absl::StrContains(source, "_internal_set_a("));
+  EXPECT_TRUE(absl::StrContains(
+      source, "} while (static_cast<::uint8_t>(ptr[0]) == 18);"));
+  EXPECT_TRUE(absl::StrContains(
+      source, "ctx->ParseMessage(_internal_mutable_child(), ptr);"));
+  EXPECT_TRUE(absl::StrContains(
+      source, "ptr = ::_pbi::PackedInt32Parser(_internal_mutable_p(), ptr, "));
+  // Closed enums and oneofs are left to the table.
+  EXPECT_FALSE(
+      absl::StrContains(source, "if (static_cast<::uint8_t>(ptr[0]) == 32)"));
+  EXPECT_FALSE(
+      absl::StrContains(source, "if (static_cast<::uint8_t>(ptr[0]) == 40)"));
+  // Only Foo is specialized.
+  EXPECT_TRUE(absl::StrContains(source,
+                                "const char* Foo::_InternalParse(\n"
+                                "    const char* ptr, ::_pbi::ParseContext* "
+                                "ctx) {\n"
+                                "  if (ctx->Done(&ptr)) goto done;\n"));
+  EXPECT_TRUE(absl::StrContains(source,
+                                "const char* Bar::_InternalParse(\n"
+                                "    const char* ptr, ::_pbi::ParseContext* "
+                                "ctx) {\n"
+                                "  ptr = ::_pbi::TcParser::ParseLoop("));
+}
+
+TEST_F(CppGeneratorTest, SpecializedParseRejectsUnknownMessage) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    package pkg;
+    message Foo { optional int32 a = 1; })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=specialized_parse=pkg.Foo+pkg.Baz:$tmpdir foo.proto");
+
+  ExpectErrorSubstring("Unknown message in specialized_parse: pkg.Baz");
+}
+
+TEST_F(CppGeneratorTest, RepeatedStringBufferStoresFieldInBuffer) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    package pkg;
+    message Foo {
+      repeated string a = 1;
+      repeated string b = 2;
+    })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=repeated_string_buffer=pkg.Foo.a:$tmpdir foo.proto");
+
+  ExpectNoErrors();
+  std::string header;
+  ABSL_CHECK_OK(File::GetContents(absl::StrCat(temp_directory(), "/foo.pb.h"),
+                                  &header, true));
+  EXPECT_TRUE(absl::StrContains(header, "RepeatedStringBuffer a_;"));
+  EXPECT_TRUE(absl::StrContains(header, "RepeatedPtrField<std::string> b_;"));
+}
+
+TEST_F(CppGeneratorTest, RepeatedStringBufferRejectsNonRepeatedString) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    package pkg;
+    message Foo {
+      optional string a = 1;
+    })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=repeated_string_buffer=pkg.Foo.a:$tmpdir foo.proto");
+  ExpectErrorSubstring(
+      "Field in repeated_string_buffer is not a repeated string or bytes "
+      "field: pkg.Foo.a");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=repeated_string_buffer=pkg.Foo.b:$tmpdir foo.proto");
+  ExpectErrorSubstring("Unknown field in repeated_string_buffer: pkg.Foo.b");
+}
+
+TEST_F(CppGeneratorTest, ParallelJobsProduceSequentialOutput) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Foo { optional int32 bar = 1; })schema");
+  CreateTempFile("bar.proto",
+                 R"schema(
+    syntax = "proto2";
+    import "foo.proto";
+    message Bar { optional Foo foo = 1; })schema");
+  CreateTempDir("serial");
+  CreateTempDir("parallel");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir --cpp_out=$tmpdir/serial "
+      "foo.proto bar.proto");
+  ExpectNoErrors();
+  RunProtoc(
+      "protocol_compiler --jobs=4 --proto_path=$tmpdir "
+      "--cpp_out=$tmpdir/parallel foo.proto bar.proto");
+  ExpectNoErrors();
+
+  for (absl::string_view file :
+       {"foo.pb.h", "foo.pb.cc", "bar.pb.h", "bar.pb.cc"}) {
+    std::string serial, parallel;
+    ABSL_CHECK_OK(File::GetContents(
+        absl::StrCat(temp_directory(), "/serial/", file), &serial, true));
+    ABSL_CHECK_OK(File::GetContents(
+        absl::StrCat(temp_directory(), "/parallel/", file), &parallel, true));
+    EXPECT_EQ(serial, parallel) << file;
+  }
+}
+
+TEST_F(CppGeneratorTest, ParseProfileInvalid) {
+  CreateTempFile("foo.proto", kParseProfileSchema);
+  CreateTempFile("profile.txt", "Foo 33\n");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=parse_profile=$tmpdir/profile.txt:$tmpdir foo.proto");
+
+  ExpectErrorSubstring("Invalid parse profile entry on line 1");
+}
+
+TEST_F(CppGeneratorTest, ParseProfileMissing) {
+  CreateTempFile("foo.proto", kParseProfileSchema);
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_out=parse_profile=$tmpdir/missing.txt:$tmpdir foo.proto");
+
+  ExpectErrorSubstring("Unable to read parse profile");
+}
+
 }  // namespace
 }  // namespace cpp
 }  // namespace compiler
@@ -53,8 +53,10 @@
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/types/optional.h"
 #include "google/protobuf/compiler/cpp/names.h"
 #include "google/protobuf/compiler/cpp/options.h"
+#include "google/protobuf/compiler/cpp/parse_profile.h"
 #include "google/protobuf/compiler/scc.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/descriptor.pb.h"
@@ -202,7 +204,36 @@ std::string IntTypeName(const Options& options, absl::string_view type) {
 bool IsLazy(const FieldDescriptor* field, const Options& options,
             MessageSCCAnalyzer* scc_analyzer) {
   return IsLazilyVerifiedLazy(field, options) ||
-         IsEagerlyVerifiedLazy(field, options, scc_analyzer);
+         IsEagerlyVerifiedLazy(field, options, scc_analyzer) ||
+         IsLazyImplicitWeakField(field, options, scc_analyzer);
+}
+
+bool IsEagerMessage(const FieldDescriptor* field, const Options& options,
+                    MessageSCCAnalyzer* scc_analyzer) {
+  // Without a hasbit, presence is the pointer being non-null.  Eagerly
+  // allocating a type from the same SCC would never terminate.
+  if (options.parse_profile == nullptr || options.bootstrap ||
+      scc_analyzer == nullptr || field->is_extension() ||
+      field->is_repeated() ||
+      field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE ||
+      field->real_containing_oneof() || !internal::cpp::HasHasbit(field) ||
+      IsWeak(field, options) ||
+      IsImplicitWeakField(field, options, scc_analyzer) ||
+      IsLazy(field, options, scc_analyzer) || ShouldSplit(field, options) ||
+      scc_analyzer->GetSCC(field->message_type()) ==
+          scc_analyzer->GetSCC(field->containing_type())) {
+    return false;
+  }
+  return options.parse_profile->IsAlwaysPresent(field);
+}
+
+bool RecyclesOneofMessage(const FieldDescriptor* field, const Options& options,
+                          MessageSCCAnalyzer* scc_analyzer) {
+  return options.recycle_oneof_messages && field->real_containing_oneof() &&
+         field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE &&
+         !IsWeak(field, options) &&
+         !IsImplicitWeakField(field, options, scc_analyzer) &&
+         !IsLazy(field, options, scc_analyzer);
 }
 
 // Returns true if "field" is a message field that is backed by LazyField per
@@ -220,7 +251,13 @@ bool IsEagerlyVerifiedLazy(const FieldDescriptor* field, const Options& options,
 
 bool IsLazilyVerifiedLazy(const FieldDescriptor* field,
                           const Options& options) {
-  return false;
+  // Reflection cannot read a LazyField, so only lite messages use one.
+  return options.lite_lazy_fields && IsExplicitLazy(field) &&
+         field->type() == FieldDescriptor::TYPE_MESSAGE &&
+         !field->is_repeated() && field->real_containing_oneof() == nullptr &&
+         internal::cpp::HasHasbit(field) && !IsWeak(field, options) &&
+         !ShouldSplit(field, options) &&
+         !HasDescriptorMethods(field->file(), options);
 }
 
 absl::flat_hash_map<absl::string_view, std::string> MessageVars(
@@ -343,8 +380,9 @@ bool CanInitializeByZeroing(const FieldDescriptor* field,
       return field->default_value_bool() == false;
     case FieldDescriptor::CPPTYPE_MESSAGE:
       // Non-repeated, non-lazy message fields are raw pointers initialized to
-      // null.
-      return !IsLazy(field, options, scc_analyzer);
+      // null, unless the constructor allocates the sub-message.
+      return !IsLazy(field, options, scc_analyzer) &&
+             !IsEagerMessage(field, options, scc_analyzer);
     default:
       return false;
   }
@@ -785,7 +823,7 @@ std::string Int32ToString(int number) {
   }
 }
 
-static std::string Int64ToString(int64_t number) {
+std::string Int64ToString(int64_t number) {
   if (number == std::numeric_limits<int64_t>::min()) {
     // This needs to be special-cased, see explanation here:
     // https://gcc.gnu.org/bugzilla/show_bug.cgi?id=52661
@@ -794,7 +832,7 @@ static std::string Int64ToString(int64_t number) {
   return absl::StrCat("::int64_t{", number, "}");
 }
 
-static std::string UInt64ToString(uint64_t number) {
+std::string UInt64ToString(uint64_t number) {
   return absl::StrCat("::uint64_t{", number, "u}");
 }
 
@@ -802,6 +840,37 @@ std::string DefaultValue(const FieldDescriptor* field) {
   return DefaultValue(Options(), field);
 }
 
+std::string DoubleToString(double value) {
+  if (value == std::numeric_limits<double>::infinity()) {
+    return "std::numeric_limits<double>::infinity()";
+  } else if (value == -std::numeric_limits<double>::infinity()) {
+    return "-std::numeric_limits<double>::infinity()";
+  } else if (value != value) {
+    return "std::numeric_limits<double>::quiet_NaN()";
+  } else {
+    return io::SimpleDtoa(value);
+  }
+}
+
+std::string FloatToString(float value) {
+  if (value == std::numeric_limits<float>::infinity()) {
+    return "std::numeric_limits<float>::infinity()";
+  } else if (value == -std::numeric_limits<float>::infinity()) {
+    return "-std::numeric_limits<float>::infinity()";
+  } else if (value != value) {
+    return "std::numeric_limits<float>::quiet_NaN()";
+  } else {
+    std::string float_value = io::SimpleFtoa(value);
+    // If floating point value contains a period (.) or an exponent
+    // (either E or e), then append suffix 'f' to make it a float
+    // literal.
+    if (float_value.find_first_of(".eE") != std::string::npos) {
+      float_value.push_back('f');
+    }
+    return float_value;
+  }
+}
+
 std::string DefaultValue(const Options& options, const FieldDescriptor* field) {
   switch (field->cpp_type()) {
     case FieldDescriptor::CPPTYPE_INT32:
@@ -812,37 +881,10 @@ std::string DefaultValue(const Options& options, const FieldDescriptor* field) {
       return Int64ToString(field->default_value_int64());
     case FieldDescriptor::CPPTYPE_UINT64:
       return UInt64ToString(field->default_value_uint64());
-    case FieldDescriptor::CPPTYPE_DOUBLE: {
-      double value = field->default_value_double();
-      if (value == std::numeric_limits<double>::infinity()) {
-        return "std::numeric_limits<double>::infinity()";
-      } else if (value == -std::numeric_limits<double>::infinity()) {
-        return "-std::numeric_limits<double>::infinity()";
-      } else if (value != value) {
-        return "std::numeric_limits<double>::quiet_NaN()";
-      } else {
-        return io::SimpleDtoa(value);
-      }
-    }
-    case FieldDescriptor::CPPTYPE_FLOAT: {
-      float value = field->default_value_float();
-      if (value == std::numeric_limits<float>::infinity()) {
-        return "std::numeric_limits<float>::infinity()";
-      } else if (value == -std::numeric_limits<float>::infinity()) {
-        return "-std::numeric_limits<float>::infinity()";
-      } else if (value != value) {
-        return "std::numeric_limits<float>::quiet_NaN()";
-      } else {
-        std::string float_value = io::SimpleFtoa(value);
-        // If floating point value contains a period (.) or an exponent
-        // (either E or e), then append suffix 'f' to make it a float
-        // literal.
-        if (float_value.find_first_of(".eE") != std::string::npos) {
-          float_value.push_back('f');
-        }
-        return float_value;
-      }
-    }
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      return DoubleToString(field->default_value_double());
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      return FloatToString(field->default_value_float());
     case FieldDescriptor::CPPTYPE_BOOL:
       return field->default_value_bool() ? "true" : "false";
     case FieldDescriptor::CPPTYPE_ENUM:
@@ -922,6 +964,47 @@ std::string SafeFunctionName(const Descriptor* descriptor,
   return function_name;
 }
 
+std::string SafeFunctionName(const Descriptor* descriptor,
+                             const FieldDescriptor* field,
+                             absl::string_view prefix,
+                             absl::string_view suffix) {
+  // The affixes that the accessors of a field are made of.
+  static constexpr absl::string_view kPrefixes[] = {
+      "",         "has_",     "clear_",   "set_",
+      "add_",     "add_n_",   "assign_",  "mutable_",
+      "release_", "set_allocated_",       "unsafe_arena_release_",
+      "unsafe_arena_set_allocated_",
+  };
+  static constexpr absl::string_view kSuffixes[] = {"", "_size", "_span"};
+
+  // Do not use FieldName() since it will escape keywords.
+  std::string name = field->name();
+  absl::AsciiStrToLower(&name);
+  std::string function_name = absl::StrCat(prefix, name, suffix);
+  bool collides = false;
+  for (int i = 0; i < descriptor->field_count() && !collides; ++i) {
+    const FieldDescriptor* other = descriptor->field(i);
+    if (other == field) continue;
+    std::string other_name = other->name();
+    absl::AsciiStrToLower(&other_name);
+    for (absl::string_view other_prefix : kPrefixes) {
+      for (absl::string_view other_suffix : kSuffixes) {
+        if (function_name ==
+            absl::StrCat(other_prefix, other_name, other_suffix)) {
+          collides = true;
+        }
+      }
+    }
+  }
+  if (collides) {
+    // Double underscore, as in SafeFunctionName() above.
+    function_name.append("__");
+  } else if (Keywords().count(name) > 0) {
+    function_name.append("_");
+  }
+  return function_name;
+}
+
 bool IsProfileDriven(const Options& options) {
   return !options.bootstrap && !options.opensource_runtime &&
          options.access_info_map != nullptr;
@@ -937,12 +1020,44 @@ bool IsLikelyPresent(const FieldDescriptor* field, const Options& options) {
 
 float GetPresenceProbability(const FieldDescriptor* field,
                              const Options& options) {
+  if (options.parse_profile != nullptr) {
+    absl::optional<float> frequency =
+        options.parse_profile->GetFrequency(field);
+    if (frequency.has_value()) return *frequency;
+  }
   return 1.f;
 }
 
 bool IsStringInlined(const FieldDescriptor* field, const Options& options) {
-  (void)field;
-  (void)options;
+  // InlinedStringField relies on a hasbit to tell a set field from its
+  // default, and tracks arena donation per message, so extensions, oneof
+  // members, repeated fields and map entries are never inlined.
+  if (options.parse_profile == nullptr ||
+      !options.profile_driven_inline_string || options.bootstrap ||
+      field->cpp_type() != FieldDescriptor::CPPTYPE_STRING ||
+      field->options().ctype() != FieldOptions::STRING ||
+      field->is_extension() || field->is_repeated() ||
+      field->real_containing_oneof() || !internal::cpp::HasHasbit(field) ||
+      IsMapEntryMessage(field->containing_type()) ||
+      IsAnyMessage(field->containing_type(), options)) {
+    return false;
+  }
+  return options.parse_profile->IsHot(field);
+}
+
+bool IsRepeatedStringBuffer(const FieldDescriptor* field,
+                            const Options& options) {
+  // The generator only accepts repeated string and bytes fields in the option.
+  return !options.repeated_string_buffer_fields.empty() &&
+         options.repeated_string_buffer_fields.contains(field->full_name());
+}
+
+bool HasRepeatedStringBufferFields(const FileDescriptor* file,
+                                   const Options& options) {
+  for (const std::string& name : options.repeated_string_buffer_fields) {
+    const FieldDescriptor* field = file->pool()->FindFieldByName(name);
+    if (field != nullptr && field->file() == file) return true;
+  }
   return false;
 }
 
@@ -1009,8 +1124,32 @@ VerifySimpleType ShouldVerifySimple(const Descriptor* descriptor) {
   return VerifySimpleType::kCustom;
 }
 
-bool ShouldSplit(const Descriptor*, const Options&) { return false; }
-bool ShouldSplit(const FieldDescriptor*, const Options&) { return false; }
+bool ShouldSplit(const Descriptor* desc, const Options& options) {
+  if (options.parse_profile == nullptr) return false;
+  for (const auto* field : FieldRange(desc)) {
+    if (ShouldSplit(field, options)) return true;
+  }
+  return false;
+}
+
+bool IsColdMessage(const Descriptor* desc, const Options& options) {
+  // Map entries are parsed as part of their map field and never show up in
+  // the profile on their own.
+  return options.cold_sections && options.parse_profile != nullptr &&
+         !IsMapEntryMessage(desc) && !options.parse_profile->IsSampled(desc);
+}
+
+bool ShouldSplit(const FieldDescriptor* field, const Options& options) {
+  // The split struct is allocated by the full runtime.
+  if (options.parse_profile == nullptr || options.bootstrap ||
+      !HasDescriptorMethods(field->file(), options) ||
+      field->is_extension() || field->is_repeated() ||
+      field->real_containing_oneof() || IsWeak(field, options) ||
+      IsStringInlined(field, options)) {
+    return false;
+  }
+  return options.parse_profile->IsCold(field);
+}
 
 bool ShouldForceAllocationOnConstruction(const Descriptor* desc,
                                          const Options& options) {
@@ -1346,6 +1485,17 @@ bool IsImplicitWeakField(const FieldDescriptor* field, const Options& options,
              scc_analyzer->GetSCC(field->message_type());
 }
 
+bool IsLazyImplicitWeakField(const FieldDescriptor* field,
+                             const Options& options,
+                             MessageSCCAnalyzer* scc_analyzer) {
+  // Groups, repeated fields and oneof members keep the eager representation.
+  return options.lite_lazy_implicit_weak_fields && scc_analyzer != nullptr &&
+         field->type() == FieldDescriptor::TYPE_MESSAGE &&
+         !field->is_repeated() && field->real_containing_oneof() == nullptr &&
+         internal::cpp::HasHasbit(field) && !ShouldSplit(field, options) &&
+         IsImplicitWeakField(field, options, scc_analyzer);
+}
+
 MessageAnalysis MessageSCCAnalyzer::GetSCCAnalysis(const SCC* scc) {
   auto it = analysis_cache_.find(scc);
   if (it != analysis_cache_.end()) return it->second;
@@ -1665,6 +1815,7 @@ FileOptions_OptimizeMode GetOptimizeFor(const FileDescriptor* file,
     case EnforceOptimizeMode::kLiteRuntime:
       return FileOptions::LITE_RUNTIME;
     case EnforceOptimizeMode::kCodeSize:
+    case EnforceOptimizeMode::kTableDriven:
       if (file->options().optimize_for() == FileOptions::LITE_RUNTIME) {
         return FileOptions::LITE_RUNTIME;
       }
@@ -260,6 +260,10 @@ const char* DeclaredTypeMethodName(FieldDescriptor::Type type);
 
 // Return the code that evaluates to the number when compiled.
 std::string Int32ToString(int number);
+std::string Int64ToString(int64_t number);
+std::string UInt64ToString(uint64_t number);
+std::string DoubleToString(double value);
+std::string FloatToString(float value);
 
 // Get code that evaluates to the field's default value.
 std::string DefaultValue(const Options& options, const FieldDescriptor* field);
@@ -330,6 +334,15 @@ std::string SafeFunctionName(const Descriptor* descriptor,
                              const FieldDescriptor* field,
                              absl::string_view prefix);
 
+// Like the above, for function names that also append a suffix to the field
+// name.  Such names can collide with the accessors of another field too (e.g.
+// `foo_span()` with those of a field `foo_span`, or `add_n_foo()` with
+// `add_n_foo()` of a field `n_foo`), so those are checked as well.
+std::string SafeFunctionName(const Descriptor* descriptor,
+                             const FieldDescriptor* field,
+                             absl::string_view prefix,
+                             absl::string_view suffix);
+
 // Returns the optimize mode for <file>, respecting <options.enforce_lite>.
 FileOptions_OptimizeMode GetOptimizeFor(const FileDescriptor* file,
                                         const Options& options);
@@ -376,9 +389,20 @@ bool IsLikelyPresent(const FieldDescriptor* field, const Options& options);
 float GetPresenceProbability(const FieldDescriptor* field,
                              const Options& options);
 
-// Returns true if `field` should be inlined based on PDProto profile.
+// Returns true if `field` should be an InlinedStringField, stored in its
+// message instead of behind a pointer, because the parse profile shows it is
+// hot.
 bool IsStringInlined(const FieldDescriptor* field, const Options& options);
 
+// Returns true if `field` is stored in a RepeatedStringBuffer, as requested by
+// the repeated_string_buffer option.
+bool IsRepeatedStringBuffer(const FieldDescriptor* field,
+                            const Options& options);
+
+// Does the file have any fields stored in a RepeatedStringBuffer?
+bool HasRepeatedStringBufferFields(const FileDescriptor* file,
+                                   const Options& options);
+
 // Does the given FileDescriptor use lazy fields?
 bool HasLazyFields(const FileDescriptor* file, const Options& options,
                    MessageSCCAnalyzer* scc_analyzer);
@@ -398,6 +422,18 @@ bool IsEagerlyVerifiedLazy(const FieldDescriptor* field, const Options& options,
 
 bool IsLazilyVerifiedLazy(const FieldDescriptor* field, const Options& options);
 
+// Is the sub-message of the given field allocated by the constructor of its
+// containing message?  Singular message fields that the parse profile finds
+// always present are, unless their type can contain the containing message.
+bool IsEagerMessage(const FieldDescriptor* field, const Options& options,
+                    MessageSCCAnalyzer* scc_analyzer);
+
+// Does the given oneof message field keep the last sub-message it held on an
+// arena, to reuse the next time the oneof switches to it?  See the
+// recycle_oneof_messages option.
+bool RecyclesOneofMessage(const FieldDescriptor* field, const Options& options,
+                          MessageSCCAnalyzer* scc_analyzer);
+
 bool ShouldVerify(const Descriptor* descriptor, const Options& options,
                   MessageSCCAnalyzer* scc_analyzer);
 bool ShouldVerify(const FileDescriptor* file, const Options& options,
@@ -427,7 +463,12 @@ VerifySimpleType ShouldVerifySimple(const Descriptor* descriptor);
 // Is the given message being split (go/pdsplit)?
 bool ShouldSplit(const Descriptor* desc, const Options& options);
 
-// Is the given field being split out?
+// Returns true if all out-of-line methods of the message should be placed in
+// the cold text section, because the parse profile never saw it.
+bool IsColdMessage(const Descriptor* desc, const Options& options);
+
+// Is the given field being split out?  Singular fields that the parse profile
+// finds cold are.
 bool ShouldSplit(const FieldDescriptor* field, const Options& options);
 
 // Should we generate code that force creating an allocation in the constructor
@@ -468,6 +509,15 @@ inline bool HasGeneratedMethods(const FileDescriptor* file,
   return GetOptimizeFor(file, options) != FileOptions::CODE_SIZE;
 }
 
+// Are messages in this file optimized for code size, but still parsed,
+// serialized and sized through their generated parse tables instead of
+// reflection?
+inline bool HasTableDrivenMethods(const FileDescriptor* file,
+                                  const Options& options) {
+  return options.enforce_mode == EnforceOptimizeMode::kTableDriven &&
+         GetOptimizeFor(file, options) == FileOptions::CODE_SIZE;
+}
+
 // Do message classes in this file have descriptor and reflection methods?
 inline bool HasDescriptorMethods(const FileDescriptor* file,
                                  const Options& options) {
@@ -743,6 +793,13 @@ bool UsingImplicitWeakFields(const FileDescriptor* file,
 bool IsImplicitWeakField(const FieldDescriptor* field, const Options& options,
                          MessageSCCAnalyzer* scc_analyzer);
 
+// Indicates whether this implicitly weak field is stored as a LazyField, which
+// keeps the serialized bytes until the field is accessed.  IsLazy() is true
+// for such fields.
+bool IsLazyImplicitWeakField(const FieldDescriptor* field,
+                             const Options& options,
+                             MessageSCCAnalyzer* scc_analyzer);
+
 inline std::string SimpleBaseClass(const Descriptor* desc,
                                    const Options& options) {
   if (!HasDescriptorMethods(desc->file(), options)) return "";
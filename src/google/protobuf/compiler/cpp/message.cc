@@ -49,6 +49,7 @@
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/log/absl_check.h"
+#include "absl/functional/function_ref.h"
 #include "absl/log/absl_log.h"
 #include "absl/strings/ascii.h"
 #include "absl/strings/escaping.h"
@@ -56,6 +57,7 @@
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
+#include "google/protobuf/compiler/cpp/constants.h"
 #include "google/protobuf/compiler/cpp/enum.h"
 #include "google/protobuf/compiler/cpp/extension.h"
 #include "google/protobuf/compiler/cpp/field.h"
@@ -322,6 +324,135 @@ bool IsCrossFileMaybeMap(const FieldDescriptor* field) {
   return IsCrossFileMessage(field);
 }
 
+// Returns true if `desc` gets a generated parse table that also drives its
+// serialization and ByteSize, with everything else left to reflection.
+// MessageSets and messages with weak fields keep the reflective fallbacks.
+bool HasTableDrivenMethods(const Descriptor* desc, const Options& options) {
+  if (!HasTableDrivenMethods(desc->file(), options) ||
+      HasSimpleBaseClass(desc, options) ||
+      desc->options().message_set_wire_format()) {
+    return false;
+  }
+  for (const auto* field : FieldRange(desc)) {
+    if (field->options().weak()) return false;
+  }
+  return true;
+}
+
+// Returns true if `desc` is generated for speed but is big enough that its
+// _InternalSerialize and ByteSizeLong should walk the parse table instead of
+// being expanded field by field. Only messages whose fields the table fully
+// describes qualify, so the table serializer never needs reflection for them.
+bool UseTableSerializer(const Descriptor* desc, const Options& options,
+                        MessageSCCAnalyzer* scc_analyzer) {
+  if (options.table_serializer_min_fields <= 0 ||
+      desc->field_count() < options.table_serializer_min_fields ||
+      !HasGeneratedMethods(desc->file(), options) ||
+      !HasDescriptorMethods(desc->file(), options) ||
+      HasSimpleBaseClass(desc, options) ||
+      desc->options().message_set_wire_format() ||
+      options.field_listener_options.inject_field_listener_events) {
+    return false;
+  }
+  for (const auto* field : FieldRange(desc)) {
+    if (field->is_map() || field->options().weak() || IsCord(field) ||
+        IsStringPiece(field) || IsLazy(field, options, scc_analyzer)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns true if `desc` has enough fields with has-bits that Clear() should
+// visit only the fields whose has-bit is set rather than every chunk of
+// fields, so that reused, sparsely populated messages pay only for the fields
+// they set.
+bool ClearOnlySetFields(const Descriptor* desc, const Options& options) {
+  if (options.sparse_clear_min_fields <= 0 || ShouldSplit(desc, options)) {
+    return false;
+  }
+  int fields_with_hasbits = 0;
+  for (const auto* field : FieldRange(desc)) {
+    if (field->options().weak()) return false;
+    if (HasHasbit(field)) ++fields_with_hasbits;
+  }
+  return fields_with_hasbits >= options.sparse_clear_min_fields;
+}
+
+// Returns true if `desc` has enough fields with has-bits that serialization
+// and ByteSizeLong() should visit only the fields whose has-bit is set. Such
+// messages assign has-bits in field number order, so walking the set bits in
+// increasing order still serializes fields in field number order.
+bool SerializeOnlySetFields(const Descriptor* desc, const Options& options) {
+  if (options.sparse_serialize_min_fields <= 0 || ShouldSplit(desc, options)) {
+    return false;
+  }
+  int fields_with_hasbits = 0;
+  for (const auto* field : FieldRange(desc)) {
+    if (field->options().weak()) return false;
+    if (HasHasbit(field)) ++fields_with_hasbits;
+  }
+  return fields_with_hasbits >= options.sparse_serialize_min_fields;
+}
+
+// Returns true if SpaceUsedLong() should be generated for `desc` rather than
+// inherited from Message, which walks every field through reflection.  Split,
+// weak and lazy fields are left to reflection, which knows their layout.
+bool HasGeneratedSpaceUsedLong(const Descriptor* desc, const Options& options,
+                               MessageSCCAnalyzer* scc_analyzer) {
+  if (!HasGeneratedMethods(desc->file(), options) ||
+      !HasDescriptorMethods(desc->file(), options) ||
+      HasSimpleBaseClass(desc, options) || ShouldSplit(desc, options)) {
+    return false;
+  }
+  for (const auto* field : FieldRange(desc)) {
+    if (field->options().weak() || IsStringPiece(field) ||
+        IsLazy(field, options, scc_analyzer)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns true if Equals() should be generated for `desc`.  Extensions have
+// no field-by-field comparison, and weak and lazy fields are only reachable
+// through reflection; such messages are compared by their serialization when
+// they appear as fields of other messages.
+bool HasGeneratedEquals(const Descriptor* desc, const Options& options,
+                        MessageSCCAnalyzer* scc_analyzer) {
+  if (!options.equality || HasSimpleBaseClass(desc, options) ||
+      IsMapEntryMessage(desc) || desc->extension_range_count() > 0 ||
+      UsingImplicitWeakFields(desc->file(), options)) {
+    return false;
+  }
+  for (const auto* field : FieldRange(desc)) {
+    if (field->options().weak() || IsLazy(field, options, scc_analyzer)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns the size of a field that Equals() may compare with memcmp together
+// with the adjacent fields of the same size, or 0.  Equal sizes rule out
+// padding between the fields.
+size_t EqualsMemcmpSize(const FieldDescriptor* field, const Options& options) {
+  if (field->is_repeated() || ShouldSplit(field, options)) return 0;
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_BOOL:
+      return 1;
+    case FieldDescriptor::CPPTYPE_INT32:
+    case FieldDescriptor::CPPTYPE_UINT32:
+    case FieldDescriptor::CPPTYPE_ENUM:
+      return 4;
+    case FieldDescriptor::CPPTYPE_INT64:
+    case FieldDescriptor::CPPTYPE_UINT64:
+      return 8;
+    default:
+      return 0;
+  }
+}
+
 bool HasNonSplitOptionalString(const Descriptor* desc, const Options& options) {
   for (const auto* field : FieldRange(desc)) {
     if (IsString(field, options) && !field->is_repeated() &&
@@ -421,6 +552,63 @@ uint32_t GenChunkMask(ChunkIterator it, ChunkIterator end,
   return chunk_mask;
 }
 
+// Emits loops that walk the set has-bits of `fields`, one has-bit word at a
+// time and in increasing bit order, dispatching to `emit_field` through a
+// switch on the bit. Bits of fields not in `fields` are masked off.
+void EmitSetFieldsLoops(
+    const std::vector<const FieldDescriptor*>& fields,
+    const std::vector<int>& has_bit_indices,
+    const std::function<void(const FieldDescriptor*)>& emit_field,
+    io::Printer* p) {
+  std::vector<std::vector<const FieldDescriptor*>> fields_by_word;
+  for (const auto* field : fields) {
+    size_t word = static_cast<size_t>(has_bit_indices[field->index()] / 32);
+    if (fields_by_word.size() <= word) fields_by_word.resize(word + 1);
+    fields_by_word[word].push_back(field);
+  }
+  for (size_t word = 0; word < fields_by_word.size(); ++word) {
+    if (fields_by_word[word].empty()) continue;
+    uint32_t word_mask = 0;
+    for (int index : has_bit_indices) {
+      if (index >= 0 && static_cast<size_t>(index / 32) == word) {
+        word_mask |= static_cast<uint32_t>(1) << (index % 32);
+      }
+    }
+    uint32_t mask = GenChunkMask(fields_by_word[word], has_bit_indices);
+    p->Emit(
+        {{"word", word},
+         {"mask", mask == word_mask
+                      ? ""
+                      : absl::StrCat(" & 0x", absl::Hex(mask, absl::kZeroPad8),
+                                     "u")},
+         {"cases",
+          [&] {
+            for (const auto* field : fields_by_word[word]) {
+              p->Emit({{"bit", has_bit_indices[field->index()] % 32},
+                       {"body", [&] { emit_field(field); }}},
+                      R"cc(
+                        case $bit$: {
+                          $body$;
+                          break;
+                        }
+                      )cc");
+            }
+          }}},
+        R"cc(
+          cached_has_bits = _impl_._has_bits_[$word$]$mask$;
+          while (cached_has_bits != 0) {
+            const int bit = ::absl::countr_zero(cached_has_bits);
+            cached_has_bits &= cached_has_bits - 1;
+            switch (bit) {
+              $cases$;
+              default:
+                break;
+            }
+          }
+        )cc");
+  }
+}
+
 // Return the number of bits set in n, a non-negative integer.
 static int popcnt(uint32_t n) {
   int result = 0;
@@ -553,14 +741,25 @@ MessageGenerator::MessageGenerator(
                                          scc_analyzer_);
   ABSL_CHECK_EQ(initial_size, optimized_order_.size());
 
-  // This message has hasbits iff one or more fields need one.
-  for (auto field : optimized_order_) {
+  // This message has hasbits iff one or more fields need one. They follow the
+  // layout, unless serialization walks the set has-bits and needs them in
+  // field number order.
+  std::vector<const FieldDescriptor*> has_bit_order = optimized_order_;
+  if (SerializeOnlySetFields(descriptor_, options_)) {
+    std::stable_sort(has_bit_order.begin(), has_bit_order.end(),
+                     [](const FieldDescriptor* a, const FieldDescriptor* b) {
+                       return a->number() < b->number();
+                     });
+  }
+  for (auto field : has_bit_order) {
     if (HasHasbit(field)) {
       if (has_bit_indices_.empty()) {
         has_bit_indices_.resize(descriptor_->field_count(), kNoHasbit);
       }
       has_bit_indices_[field->index()] = max_has_bit_index_++;
     }
+  }
+  for (auto field : optimized_order_) {
     if (IsStringInlined(field, options_)) {
       if (inlined_string_indices_.empty()) {
         inlined_string_indices_.resize(descriptor_->field_count(), kNoHasbit);
@@ -1276,7 +1475,18 @@ void MessageGenerator::GenerateClassDefinition(io::Printer* p) {
       // (warning in gcc 13).
       "template<typename = void>\n"
       "explicit PROTOBUF_CONSTEXPR "
-      "$classname$(::$proto_ns$::internal::ConstantInitialized);\n"
+      "$classname$(::$proto_ns$::internal::ConstantInitialized);\n");
+  if (HasConstantConstructor()) {
+    // Constructs a constant from the value of each constant field; see
+    // MessageConstants.
+    p->Emit({{"params", ConstantConstructorParams()}}, R"cc(
+      template <typename = void>
+      explicit PROTOBUF_CONSTEXPR $classname$(
+          ::$proto_ns$::internal::ConstantInitialized,
+          std::initializer_list<::uint32_t> has_bits$params$);
+    )cc");
+  }
+  format(
       "\n"
 #ifdef PROTOBUF_EXPLICIT_CONSTRUCTORS
       "$classname$(::$proto_ns$::Arena* arena, const $classname$& from);\n"
@@ -1481,6 +1691,52 @@ void MessageGenerator::GenerateClassDefinition(io::Printer* p) {
       "  InternalSwap(other);\n"
       "}\n");
 
+  if (options_.heap_free_list_size > 0 && !IsMapEntryMessage(descriptor_)) {
+    // A class operator new hides every global form, so we redeclare the ones
+    // callers rely on: placement, as used by Arena, and nothrow, whose null
+    // result on failure we pass through.
+    p->Emit({{"max_cached", options_.heap_free_list_size}}, R"cc(
+      static void* operator new(::size_t size) {
+        return $pbi$::MessageFreeList<$classname$>::Allocate(size);
+      }
+      static void* operator new(::size_t size,
+                                const std::nothrow_t& tag) noexcept {
+        return $pbi$::MessageFreeList<$classname$>::Allocate(size, tag);
+      }
+      static void* operator new(::size_t, void* ptr) noexcept { return ptr; }
+      static void operator delete(void* ptr, ::size_t size) {
+        $pbi$::MessageFreeList<$classname$>::Deallocate(ptr, size, $max_cached$);
+      }
+      static void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+        ::operator delete(ptr);
+      }
+      static void operator delete(void*, void*) noexcept {}
+    )cc");
+  }
+
+  if (HasGeneratedEquals(descriptor_, options_, scc_analyzer_)) {
+    p->Emit({{"operators",
+              [&] {
+                if (!options_.equality_operator) return;
+                p->Emit(R"cc(
+                  friend bool operator==(const $classname$& a,
+                                         const $classname$& b) {
+                    return a._InternalEquals(b);
+                  }
+                  friend bool operator!=(const $classname$& a,
+                                         const $classname$& b) {
+                    return !a._InternalEquals(b);
+                  }
+                )cc");
+              }}},
+            R"cc(
+              friend bool Equals(const $classname$& a, const $classname$& b) {
+                return a._InternalEquals(b);
+              }
+              $operators$;
+            )cc");
+  }
+
   format(
       "\n"
       "// implements Message ----------------------------------------------\n"
@@ -1542,6 +1798,9 @@ void MessageGenerator::GenerateClassDefinition(io::Printer* p) {
           "bool IsInitialized() const final;\n"
           "\n"
           "::size_t ByteSizeLong() const final;\n");
+      if (HasGeneratedSpaceUsedLong(descriptor_, options_, scc_analyzer_)) {
+        format("::size_t SpaceUsedLong() const final;\n");
+      }
 
       parse_function_generator_->GenerateMethodDecls(p);
 
@@ -1550,6 +1809,15 @@ void MessageGenerator::GenerateClassDefinition(io::Printer* p) {
           "    $uint8$* target, ::$proto_ns$::io::EpsCopyOutputStream* stream) "
           "const final;\n");
     }
+  } else if (HasTableDrivenMethods(descriptor_, options_)) {
+    format("::size_t ByteSizeLong() const final;\n");
+
+    parse_function_generator_->GenerateMethodDecls(p);
+
+    format(
+        "$uint8$* _InternalSerialize(\n"
+        "    $uint8$* target, ::$proto_ns$::io::EpsCopyOutputStream* stream) "
+        "const final;\n");
   }
 
   if (options_.field_listener_options.inject_field_listener_events) {
@@ -1568,6 +1836,11 @@ void MessageGenerator::GenerateClassDefinition(io::Printer* p) {
           void SharedDtor();
           void InternalSwap($classname$* other);
         )cc");
+    if (HasGeneratedEquals(descriptor_, options_, scc_analyzer_)) {
+      p->Emit(R"cc(
+        bool _InternalEquals(const $classname$& other) const;
+      )cc");
+    }
   }
 
   format(
@@ -1709,7 +1982,8 @@ void MessageGenerator::GenerateClassDefinition(io::Printer* p) {
         oneof->name());
   }
 
-  if (HasGeneratedMethods(descriptor_->file(), options_)) {
+  if (HasGeneratedMethods(descriptor_->file(), options_) ||
+      HasTableDrivenMethods(descriptor_, options_)) {
     parse_function_generator_->GenerateDataDecls(p);
   }
 
@@ -1864,6 +2138,24 @@ void MessageGenerator::GenerateClassDefinition(io::Printer* p) {
     format("::$proto_ns$::internal::AnyMetadata _any_metadata_;\n");
   }
 
+  // The sub-messages kept by recycle_oneof_messages, and per oneof the last
+  // sub-message that _internal_mutable_<field>() allocated, the only one that
+  // may be kept. They come after every member that the aggregate
+  // initializations of Impl_ list, which therefore leave them null.
+  for (auto oneof : OneOfRange(descriptor_)) {
+    bool recycles = false;
+    for (auto field : FieldRange(oneof)) {
+      if (!RecyclesOneofMessage(field, options_, scc_analyzer_)) continue;
+      recycles = true;
+      format("$1$* _recycled_$2$_ = nullptr;\n",
+             QualifiedClassName(field->message_type(), options_),
+             FieldName(field));
+    }
+    if (recycles) {
+      format("const void* _allocated_$1$_ = nullptr;\n", oneof->name());
+    }
+  }
+
   // For detecting when concurrent accessor calls cause races.
   format("PROTOBUF_TSAN_DECLARE_MEMBER\n");
 
@@ -1944,6 +2236,8 @@ void MessageGenerator::GenerateClassMethods(io::Printer* p) {
 
   auto v = p->WithVars(ClassVars(descriptor_, options_));
   auto t = p->WithVars(MakeTrackerCalls(descriptor_, options_));
+  auto c = p->WithVars(
+      {{"reflection_cold", options_.cold_sections ? "PROTOBUF_COLD " : ""}});
   Formatter format(p);
   if (IsMapEntryMessage(descriptor_)) {
     format(
@@ -1956,7 +2250,8 @@ void MessageGenerator::GenerateClassMethods(io::Printer* p) {
     if (HasDescriptorMethods(descriptor_->file(), options_)) {
       if (!descriptor_->options().map_entry()) {
         format(
-            "::$proto_ns$::Metadata $classname$::GetMetadata() const {\n"
+            "$reflection_cold$::$proto_ns$::Metadata "
+            "$classname$::GetMetadata() const {\n"
             "$annotate_reflection$"
             "  return ::_pbi::AssignDescriptors(\n"
             "      &$desc_table$_getter, &$desc_table$_once,\n"
@@ -1965,7 +2260,8 @@ void MessageGenerator::GenerateClassMethods(io::Printer* p) {
             index_in_file_messages_);
       } else {
         format(
-            "::$proto_ns$::Metadata $classname$::GetMetadata() const {\n"
+            "$reflection_cold$::$proto_ns$::Metadata "
+            "$classname$::GetMetadata() const {\n"
             "  return ::_pbi::AssignDescriptors(\n"
             "      &$desc_table$_getter, &$desc_table$_once,\n"
             "      $file_level_metadata$[$1$]);\n"
@@ -1976,6 +2272,12 @@ void MessageGenerator::GenerateClassMethods(io::Printer* p) {
     return;
   }
 
+  // Map entries never reach this point; see IsColdMessage().
+  const bool cold = IsColdMessage(descriptor_, options_);
+  if (cold) {
+    p->Emit("PROTOBUF_COLD_FUNCTIONS_BEGIN\n");
+  }
+
   if (IsAnyMessage(descriptor_, options_)) {
     if (HasDescriptorMethods(descriptor_->file(), options_)) {
       format(
@@ -2076,6 +2378,11 @@ void MessageGenerator::GenerateClassMethods(io::Printer* p) {
     GenerateByteSize(p);
     format("\n");
 
+    if (HasGeneratedSpaceUsedLong(descriptor_, options_, scc_analyzer_)) {
+      GenerateSpaceUsedLong(p);
+      format("\n");
+    }
+
     GenerateMergeFrom(p);
     format("\n");
 
@@ -2087,6 +2394,25 @@ void MessageGenerator::GenerateClassMethods(io::Printer* p) {
 
     GenerateIsInitialized(p);
     format("\n");
+  } else if (HasTableDrivenMethods(descriptor_, options_)) {
+    parse_function_generator_->GenerateMethodImpls(p);
+    format("\n");
+
+    parse_function_generator_->GenerateDataDefinitions(p);
+
+    p->Emit(R"cc(
+      ::size_t $classname$::ByteSizeLong() const {
+        return $pbi$::TcParser::ByteSizeWithTable(*this, &_table_.header);
+      }
+
+      $uint8$* $classname$::_InternalSerialize(
+          $uint8$* target,
+          ::$proto_ns$::io::EpsCopyOutputStream* stream) const {
+        return $pbi$::TcParser::SerializeWithTable(*this, &_table_.header,
+                                                  target, stream);
+      }
+    )cc");
+    format("\n");
   }
 
   if (ShouldSplit(descriptor_, options_)) {
@@ -2115,10 +2441,16 @@ void MessageGenerator::GenerateClassMethods(io::Printer* p) {
   GenerateSwap(p);
   format("\n");
 
+  if (HasGeneratedEquals(descriptor_, options_, scc_analyzer_)) {
+    GenerateEquals(p);
+    format("\n");
+  }
+
   if (HasDescriptorMethods(descriptor_->file(), options_)) {
     if (!descriptor_->options().map_entry()) {
       format(
-          "::$proto_ns$::Metadata $classname$::GetMetadata() const {\n"
+          "$reflection_cold$::$proto_ns$::Metadata "
+          "$classname$::GetMetadata() const {\n"
           "$annotate_reflection$"
           "  return ::_pbi::AssignDescriptors(\n"
           "      &$desc_table$_getter, &$desc_table$_once,\n"
@@ -2127,7 +2459,8 @@ void MessageGenerator::GenerateClassMethods(io::Printer* p) {
           index_in_file_messages_);
     } else {
       format(
-          "::$proto_ns$::Metadata $classname$::GetMetadata() const {\n"
+          "$reflection_cold$::$proto_ns$::Metadata "
+          "$classname$::GetMetadata() const {\n"
           "  return ::_pbi::AssignDescriptors(\n"
           "      &$desc_table$_getter, &$desc_table$_once,\n"
           "      $file_level_metadata$[$1$]);\n"
@@ -2148,6 +2481,10 @@ void MessageGenerator::GenerateClassMethods(io::Printer* p) {
         "$1$::$tracker$(&FullMessageName);\n",
         ClassName(descriptor_));
   }
+
+  if (cold) {
+    p->Emit("PROTOBUF_COLD_FUNCTIONS_END\n");
+  }
 }
 
 std::pair<size_t, size_t> MessageGenerator::GenerateOffsets(io::Printer* p) {
@@ -2217,8 +2554,8 @@ std::pair<size_t, size_t> MessageGenerator::GenerateOffsets(io::Printer* p) {
     // reflectively accessing the field at run time.
     //
     // We embed whether the field is cold to the MSB of the offset, and whether
-    // the field is eagerly verified lazy or inlined string to the LSB of the
-    // offset.
+    // the field is eagerly verified lazy, an inlined string or a string buffer
+    // to the LSB of the offset.
 
     if (ShouldSplit(field, options_)) {
       format(" | ::_pbi::kSplitFieldOffsetMask /*split*/");
@@ -2227,6 +2564,8 @@ std::pair<size_t, size_t> MessageGenerator::GenerateOffsets(io::Printer* p) {
       format(" | 0x1u /*eagerly verified lazy*/");
     } else if (IsStringInlined(field, options_)) {
       format(" | 0x1u /*inlined*/");
+    } else if (IsRepeatedStringBuffer(field, options_)) {
+      format(" | 0x1u /*string buffer*/");
     }
     format(",\n");
   }
@@ -2816,6 +3155,175 @@ void MessageGenerator::GenerateArenaDestructorCode(io::Printer* p) {
       )cc");
 }
 
+void MessageGenerator::GenerateConstexprImplInitializers(io::Printer* p,
+                                                         bool from_params) {
+  bool need_to_emit_cached_size = !HasSimpleBaseClass(descriptor_, options_);
+  p->Emit("\n");
+  auto indent = p->WithIndent();
+
+  if (descriptor_->extension_range_count() > 0) {
+    p->Emit(R"cc(
+      /*decltype($extensions$)*/ {},
+    )cc");
+  }
+  if (!inlined_string_indices_.empty()) {
+    p->Emit(R"cc(
+      /*decltype($inlined_string_donated_array$)*/ {},
+    )cc");
+  }
+  if (!has_bit_indices_.empty()) {
+    if (from_params) {
+      p->Emit(R"cc(
+        /*decltype($has_bits$)*/ has_bits,
+      )cc");
+    } else {
+      p->Emit(R"cc(
+        /*decltype($has_bits$)*/ {},
+      )cc");
+    }
+    if (need_to_emit_cached_size) {
+      p->Emit(R"cc(
+        /*decltype($cached_size$)*/ {},
+      )cc");
+      need_to_emit_cached_size = false;
+    }
+  }
+  for (auto* field : optimized_order_) {
+    if (ShouldSplit(field, options_)) {
+      continue;
+    }
+    if (from_params && MessageConstants::IsConstantField(field)) {
+      if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+        p->Emit({{"name", FieldName(field)},
+                 {"Submsg", FieldMessageTypeName(field, options_)}},
+                R"cc(
+                  /*decltype(_impl_.$name$_)*/ const_cast<$Submsg$*>(
+                      $name$_value),
+                )cc");
+      } else {
+        p->Emit({{"name", FieldName(field)}}, R"cc(
+          /*decltype(_impl_.$name$_)*/ $name$_value,
+        )cc");
+      }
+      continue;
+    }
+    field_generators_.get(field).GenerateConstexprAggregateInitializer(p);
+  }
+  if (ShouldSplit(descriptor_, options_)) {
+    p->Emit({{"name", DefaultInstanceName(descriptor_, options_,
+                                          /*split=*/true)}},
+            R"cc(
+              /*decltype($split$)*/ const_cast<Impl_::Split*>(
+                  &$name$._instance),
+            )cc");
+  }
+  for (auto* oneof : OneOfRange(descriptor_)) {
+    p->Emit({{"name", oneof->name()}},
+            R"cc(
+              /*decltype(_impl_.$name$_)*/ {},
+            )cc");
+  }
+  if (need_to_emit_cached_size) {
+    p->Emit(R"cc(
+      /*decltype($cached_size$)*/ {},
+    )cc");
+  }
+  if (descriptor_->real_oneof_decl_count() != 0) {
+    p->Emit(R"cc(
+      /*decltype($oneof_case$)*/ {},
+    )cc");
+  }
+  if (num_weak_fields_) {
+    p->Emit(R"cc(
+      /*decltype($weak_field_map$)*/ {},
+    )cc");
+  }
+  if (IsAnyMessage(descriptor_, options_)) {
+    p->Emit(R"cc(
+      /*decltype($any_metadata$)*/ {&_impl_.type_url_,
+                                    &_impl_.value_},
+    )cc");
+  }
+}
+
+bool MessageGenerator::HasConstantConstructor() const {
+  return options_.message_constants != nullptr &&
+         !options_.message_constants->constants().empty() &&
+         MessageConstants::CanBeConstant(descriptor_, options_);
+}
+
+std::string MessageGenerator::ConstantConstructorParams() const {
+  std::string params;
+  for (const auto* field : optimized_order_) {
+    if (!MessageConstants::IsConstantField(field)) continue;
+    std::string type;
+    switch (field->cpp_type()) {
+      case FieldDescriptor::CPPTYPE_MESSAGE:
+        type = absl::StrCat("const ", FieldMessageTypeName(field, options_),
+                            "*");
+        break;
+      case FieldDescriptor::CPPTYPE_ENUM:
+        type = "int";
+        break;
+      default:
+        type = PrimitiveTypeName(options_, field->cpp_type());
+        break;
+    }
+    absl::StrAppend(&params, ", ", type, " ", FieldName(field), "_value");
+  }
+  return params;
+}
+
+std::string MessageGenerator::ConstantConstructorArgs(
+    const Message& value,
+    absl::FunctionRef<std::string(const Message&)> storage) const {
+  const Reflection* reflection = value.GetReflection();
+  std::vector<uint32_t> has_words((max_has_bit_index_ + 31) / 32);
+  std::vector<std::string> args;
+  for (const auto* field : optimized_order_) {
+    if (!MessageConstants::IsConstantField(field)) continue;
+    bool has = reflection->HasField(value, field);
+    int has_bit_index = HasBitIndex(field);
+    if (has && has_bit_index != kNoHasbit) {
+      has_words[has_bit_index / 32] |= uint32_t{1} << (has_bit_index % 32);
+    }
+    if (field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) {
+      args.push_back(MessageConstants::ValueLiteral(value, field));
+    } else if (has) {
+      args.push_back(storage(reflection->GetMessage(value, field)));
+    } else {
+      args.push_back("nullptr");
+    }
+  }
+  std::vector<std::string> words;
+  for (uint32_t word : has_words) {
+    words.push_back(absl::StrCat("0x", absl::Hex(word, absl::kZeroPad8), "u"));
+  }
+  args.insert(args.begin(), absl::StrCat("{", absl::StrJoin(words, ", "), "}"));
+  return absl::StrJoin(args, ", ");
+}
+
+void MessageGenerator::GenerateConstantConstructor(io::Printer* p) {
+  if (!HasConstantConstructor()) return;
+  auto v = p->WithVars(ClassVars(descriptor_, options_));
+  p->Emit(
+      {
+          {"has_bits", has_bit_indices_.empty() ? "" : " has_bits"},
+          {"params", ConstantConstructorParams()},
+          {"init_body",
+           [&] {
+             GenerateConstexprImplInitializers(p, /*from_params=*/true);
+           }},
+      },
+      R"cc(
+        template <typename>
+        PROTOBUF_CONSTEXPR $classname$::$classname$(
+            ::_pbi::ConstantInitialized,
+            std::initializer_list<::uint32_t>$has_bits$$params$)
+            : _impl_{$init_body$} {}
+      )cc");
+}
+
 void MessageGenerator::GenerateConstexprConstructor(io::Printer* p) {
   if (!ShouldGenerateClass(descriptor_, options_)) return;
 
@@ -2836,77 +3344,11 @@ void MessageGenerator::GenerateConstexprConstructor(io::Printer* p) {
 
 #ifndef PROTOBUF_EXPLICIT_CONSTRUCTORS
 
-  bool need_to_emit_cached_size = !HasSimpleBaseClass(descriptor_, options_);
   p->Emit(
       {
           {"init_body",
            [&] {
-             p->Emit("\n");
-             auto indent = p->WithIndent();
-
-             if (descriptor_->extension_range_count() > 0) {
-               p->Emit(R"cc(
-                 /*decltype($extensions$)*/ {},
-               )cc");
-             }
-             if (!inlined_string_indices_.empty()) {
-               p->Emit(R"cc(
-                 /*decltype($inlined_string_donated_array$)*/ {},
-               )cc");
-             }
-             if (!has_bit_indices_.empty()) {
-               p->Emit(R"cc(
-                 /*decltype($has_bits$)*/ {},
-               )cc");
-               if (need_to_emit_cached_size) {
-                 p->Emit(R"cc(
-                   /*decltype($cached_size$)*/ {},
-                 )cc");
-                 need_to_emit_cached_size = false;
-               }
-             }
-             for (auto* field : optimized_order_) {
-               if (ShouldSplit(field, options_)) {
-                 continue;
-               }
-               field_generators_.get(field)
-                   .GenerateConstexprAggregateInitializer(p);
-             }
-             if (ShouldSplit(descriptor_, options_)) {
-               p->Emit({{"name", DefaultInstanceName(descriptor_, options_,
-                                                     /*split=*/true)}},
-                       R"cc(
-                         /*decltype($split$)*/ const_cast<Impl_::Split*>(
-                             &$name$._instance),
-                       )cc");
-             }
-             for (auto* oneof : OneOfRange(descriptor_)) {
-               p->Emit({{"name", oneof->name()}},
-                       R"cc(
-                         /*decltype(_impl_.$name$_)*/ {},
-                       )cc");
-             }
-             if (need_to_emit_cached_size) {
-               p->Emit(R"cc(
-                 /*decltype($cached_size$)*/ {},
-               )cc");
-             }
-             if (descriptor_->real_oneof_decl_count() != 0) {
-               p->Emit(R"cc(
-                 /*decltype($oneof_case$)*/ {},
-               )cc");
-             }
-             if (num_weak_fields_) {
-               p->Emit(R"cc(
-                 /*decltype($weak_field_map$)*/ {},
-               )cc");
-             }
-             if (IsAnyMessage(descriptor_, options_)) {
-               p->Emit(R"cc(
-                 /*decltype($any_metadata$)*/ {&_impl_.type_url_,
-                                               &_impl_.value_},
-               )cc");
-             }
+             GenerateConstexprImplInitializers(p, /*from_params=*/false);
            }},
       },
       R"cc(
@@ -3593,10 +4035,31 @@ void MessageGenerator::GenerateClear(io::Printer* p) {
     format("$extensions$.Clear();\n");
   }
 
+  // Fields left for the chunked clearing below.
+  std::vector<const FieldDescriptor*> chunked_fields = optimized_order_;
+  if (ClearOnlySetFields(descriptor_, options_)) {
+    // Visit the set bits of each has-bit word and clear only those fields.
+    std::vector<const FieldDescriptor*> hasbit_fields;
+    chunked_fields.clear();
+    for (const auto* field : optimized_order_) {
+      if (HasBitIndex(field) == kNoHasbit) {
+        chunked_fields.push_back(field);
+      } else {
+        hasbit_fields.push_back(field);
+      }
+    }
+    EmitSetFieldsLoops(
+        hasbit_fields, has_bit_indices_,
+        [&](const FieldDescriptor* field) {
+          field_generators_.get(field).GenerateMessageClearingCode(p);
+        },
+        p);
+  }
+
   // Collect fields into chunks. Each chunk may have an if() condition that
   // checks all hasbits in the chunk and skips it if none are set.
   int zero_init_bytes = 0;
-  for (const auto& field : optimized_order_) {
+  for (const auto& field : chunked_fields) {
     if (CanClearByZeroing(field)) {
       zero_init_bytes += EstimateAlignmentSize(field);
     }
@@ -3605,7 +4068,7 @@ void MessageGenerator::GenerateClear(io::Printer* p) {
   int chunk_count = 0;
 
   std::vector<FieldChunk> chunks = CollectFields(
-      optimized_order_, options_,
+      chunked_fields, options_,
       [&](const FieldDescriptor* a, const FieldDescriptor* b) -> bool {
         chunk_count++;
         // This predicate guarantees that there is only a single zero-init
@@ -4055,6 +4518,36 @@ void MessageGenerator::GenerateClassSpecificMergeImpl(io::Printer* p) {
         format.Indent();
       }
 
+      // A chunk of POD fields with has-bits is laid out contiguously, so when
+      // all of them are set in `from` they are copied with a single memcpy.
+      const bool copy_whole_chunk =
+          check_has_byte &&
+          std::all_of(fields.begin(), fields.end(),
+                      [&](const FieldDescriptor* field) {
+                        return IsPOD(field) && HasHasbit(field) &&
+                               !field->options().weak() &&
+                               !ShouldSplit(field, options_) &&
+                               HasWordIndex(field) == cached_has_word_index;
+                      });
+      if (copy_whole_chunk) {
+        uint32_t chunk_mask = GenChunkMask(fields, has_bit_indices_);
+        auto v = p->WithVars({
+            {"mask", absl::StrCat(absl::Hex(chunk_mask, absl::kZeroPad8))},
+            {"first", FieldMemberName(fields.front(), /*split=*/false)},
+            {"last", FieldMemberName(fields.back(), /*split=*/false)},
+        });
+        p->Emit(R"cc(
+          if ((cached_has_bits & 0x$mask$u) == 0x$mask$u) {
+            ::memcpy(&_this->$first$, &from.$first$,
+                     static_cast<::size_t>(
+                         reinterpret_cast<const char*>(&from.$last$) -
+                         reinterpret_cast<const char*>(&from.$first$)) +
+                         sizeof(from.$last$));
+          } else {
+        )cc");
+        p->Indent();
+      }
+
       // Go back and emit merging code for each of the fields we processed.
       bool deferred_has_bit_changes = false;
       for (const auto* field : fields) {
@@ -4108,6 +4601,13 @@ void MessageGenerator::GenerateClassSpecificMergeImpl(io::Printer* p) {
         }
       }
 
+      if (copy_whole_chunk) {
+        p->Outdent();
+        p->Emit(R"cc(
+          }
+        )cc");
+      }
+
       if (check_has_byte) {
         if (deferred_has_bit_changes) {
           // Flush the has bits for the primitives we deferred.
@@ -4331,6 +4831,17 @@ void MessageGenerator::GenerateSerializeOneField(io::Printer* p,
   p->Emit("\n");
 }
 
+void MessageGenerator::GenerateSerializeSetFields(
+    io::Printer* p, const std::vector<const FieldDescriptor*>& fields) {
+  EmitSetFieldsLoops(
+      fields, has_bit_indices_,
+      [&](const FieldDescriptor* field) {
+        auto v = p->WithVars(FieldVars(field, options_));
+        field_generators_.get(field).GenerateSerializeWithCachedSizesToArray(p);
+      },
+      p);
+}
+
 void MessageGenerator::GenerateSerializeOneExtensionRange(io::Printer* p,
                                                           int start, int end) {
   auto v = p->WithVars(variables_);
@@ -4360,6 +4871,18 @@ void MessageGenerator::GenerateSerializeWithCachedSizesToArray(io::Printer* p) {
     )cc");
     return;
   }
+  if (UseTableSerializer(descriptor_, options_, scc_analyzer_)) {
+    p->Emit(R"cc(
+      $uint8$* $classname$::_InternalSerialize(
+          $uint8$* target,
+          ::$proto_ns$::io::EpsCopyOutputStream* stream) const {
+        $annotate_serialize$;
+        return $pbi$::TcParser::SerializeWithTable(*this, &_table_.header,
+                                                  target, stream);
+      }
+    )cc");
+    return;
+  }
 
   p->Emit(
       {
@@ -4449,6 +4972,15 @@ void MessageGenerator::GenerateSerializeWithCachedSizesBody(io::Printer* p) {
       }
     }
 
+    // Emits a loop over the set has-bits of `fields`, a run of fields that
+    // are consecutive in field number order and have increasing has-bits.
+    void EmitSetFields(const std::vector<const FieldDescriptor*>& fields) {
+      Flush();
+      mg_->GenerateSerializeSetFields(p_, fields);
+      // The loop consumes cached_has_bits.
+      cached_has_bit_index_ = kNoHasbit;
+    }
+
     void Flush() {
       if (!v_.empty()) {
         mg_->GenerateSerializeOneofFields(p_, v_);
@@ -4553,6 +5085,19 @@ void MessageGenerator::GenerateSerializeWithCachedSizesBody(io::Printer* p) {
              LazySerializerEmitter e(this, p);
              LazyExtensionRangeEmitter re(this, p);
              LargestWeakFieldHolder largest_weak_field;
+             // Runs of fields with has-bits are collected here when only set
+             // fields are serialized.
+             const bool only_set_fields =
+                 SerializeOnlySetFields(descriptor_, options_);
+             std::vector<const FieldDescriptor*> set_fields_run;
+             auto flush_run = [&] {
+               if (set_fields_run.size() > 1) {
+                 e.EmitSetFields(set_fields_run);
+               } else if (!set_fields_run.empty()) {
+                 e.Emit(set_fields_run.front());
+               }
+               set_fields_run.clear();
+             };
              int i, j;
              for (i = 0, j = 0;
                   i < ordered_fields.size() || j < sorted_extensions.size();) {
@@ -4562,6 +5107,11 @@ void MessageGenerator::GenerateSerializeWithCachedSizesBody(io::Printer* p) {
                         sorted_extensions[j]->start_number())) {
                  const FieldDescriptor* field = ordered_fields[i++];
                  re.Flush();
+                 if (only_set_fields && HasHasbit(field)) {
+                   set_fields_run.push_back(field);
+                   continue;
+                 }
+                 flush_run();
                  if (field->options().weak()) {
                    largest_weak_field.ReplaceIfLarger(field);
                    PrintFieldComment(Formatter{p}, field, options_);
@@ -4570,11 +5120,13 @@ void MessageGenerator::GenerateSerializeWithCachedSizesBody(io::Printer* p) {
                    e.Emit(field);
                  }
                } else {
+                 flush_run();
                  e.EmitIfNotNull(largest_weak_field.Release());
                  e.Flush();
                  re.AddToRange(sorted_extensions[j++]);
                }
              }
+             flush_run();
              re.Flush();
              e.EmitIfNotNull(largest_weak_field.Release());
            }},
@@ -4718,6 +5270,196 @@ std::vector<uint32_t> MessageGenerator::RequiredFieldsBitMask() const {
   return masks;
 }
 
+void MessageGenerator::GenerateSpaceUsedLong(io::Printer* p) {
+  p->Emit(
+      {
+          {"extension_set",
+           [&] {
+             if (descriptor_->extension_range_count() == 0) return;
+             p->Emit(R"cc(
+               total_size += $extensions$.SpaceUsedExcludingSelfLong();
+             )cc");
+           }},
+          {"field_sizes",
+           [&] {
+             for (const auto* field : optimized_order_) {
+               field_generators_.get(field).GenerateSpaceUsedLong(p);
+             }
+           }},
+          {"oneof_sizes",
+           [&] {
+             // Only the active member of a oneof may be read from its union.
+             for (const auto* oneof : OneOfRange(descriptor_)) {
+               bool owns_memory = false;
+               for (const auto* field : FieldRange(oneof)) {
+                 owns_memory |= IsStringOrMessage(field);
+               }
+               if (!owns_memory) continue;
+               p->Emit(
+                   {{"oneof_name", oneof->name()},
+                    {"cases",
+                     [&] {
+                       for (const auto* field : FieldRange(oneof)) {
+                         if (!IsStringOrMessage(field)) continue;
+                         p->Emit(
+                             {{"Member",
+                               UnderscoresToCamelCase(field->name(), true)},
+                              {"size",
+                               [&] {
+                                 field_generators_.get(field)
+                                     .GenerateSpaceUsedLong(p);
+                               }}},
+                             R"cc(
+                               case k$Member$: {
+                                 $size$;
+                                 break;
+                               }
+                             )cc");
+                       }
+                     }}},
+                   R"cc(
+                     switch ($oneof_name$_case()) {
+                       $cases$;
+                       default:
+                         break;
+                     }
+                   )cc");
+             }
+           }},
+      },
+      R"cc(
+        ::size_t $classname$::SpaceUsedLong() const {
+          // sizeof(*this) already includes every field stored inline, so only
+          // memory owned through pointers is added.
+          ::size_t total_size = sizeof($classname$);
+          if ($have_unknown_fields$) {
+            total_size += $unknown_fields$.SpaceUsedExcludingSelfLong();
+          }
+          $extension_set$;
+          $field_sizes$;
+          $oneof_sizes$;
+          return ::_pbi::SpaceUsedLongResult(total_size, this);
+        }
+      )cc");
+}
+
+void MessageGenerator::GenerateEquals(io::Printer* p) {
+  // Fields stored inline are compared first, as they are the cheapest.
+  auto is_inline = [](const FieldDescriptor* field) {
+    return !field->is_repeated() &&
+           field->cpp_type() != FieldDescriptor::CPPTYPE_STRING &&
+           field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE;
+  };
+
+  p->Emit(
+      {
+          {"compare_has_bits",
+           [&] {
+             for (size_t i = 0; i < HasBitsSize(); ++i) {
+               p->Emit({{"i", i}}, R"cc(
+                 if ($has_bits$[$i$] != other.$has_bits$[$i$]) return false;
+               )cc");
+             }
+           }},
+          {"compare_inline_fields",
+           [&] {
+             for (size_t i = 0; i < optimized_order_.size(); ++i) {
+               const FieldDescriptor* field = optimized_order_[i];
+               if (!is_inline(field)) continue;
+               const size_t size = EqualsMemcmpSize(field, options_);
+               size_t end = i + 1;
+               while (size != 0 && end < optimized_order_.size() &&
+                      EqualsMemcmpSize(optimized_order_[end], options_) ==
+                          size) {
+                 ++end;
+               }
+               // As in Clear(), a single field is compared by itself for
+               // clarity.
+               if (end - i == 1) {
+                 field_generators_.get(field).GenerateEquals(p);
+                 continue;
+               }
+               p->Emit({{"first", FieldMemberName(field, /*split=*/false)},
+                        {"last", FieldMemberName(optimized_order_[end - 1],
+                                                 /*split=*/false)}},
+                       R"cc(
+                         if (::memcmp(
+                                 &$first$, &other.$first$,
+                                 static_cast<::size_t>(
+                                     reinterpret_cast<const char*>(&$last$) -
+                                     reinterpret_cast<const char*>(&$first$)) +
+                                     sizeof($last$)) != 0) {
+                           return false;
+                         }
+                       )cc");
+               i = end - 1;
+             }
+           }},
+          {"compare_other_fields",
+           [&] {
+             for (const auto* field : optimized_order_) {
+               if (is_inline(field)) continue;
+               field_generators_.get(field).GenerateEquals(p);
+             }
+           }},
+          {"compare_oneofs",
+           [&] {
+             for (const auto* oneof : OneOfRange(descriptor_)) {
+               p->Emit(
+                   {
+                       {"name", oneof->name()},
+                       {"NAME", absl::AsciiStrToUpper(oneof->name())},
+                       {"cases",
+                        [&] {
+                          for (const auto* field : FieldRange(oneof)) {
+                            p->Emit(
+                                {{"Name",
+                                  UnderscoresToCamelCase(field->name(), true)},
+                                 {"body",
+                                  [&] {
+                                    field_generators_.get(field)
+                                        .GenerateEquals(p);
+                                  }}},
+                                R"cc(
+                                  case k$Name$: {
+                                    $body$;
+                                    break;
+                                  }
+                                )cc");
+                          }
+                        }},
+                   },
+                   R"cc(
+                     if ($name$_case() != other.$name$_case()) return false;
+                     switch ($name$_case()) {
+                       $cases$;
+                       case $NAME$_NOT_SET: {
+                         break;
+                       }
+                     }
+                   )cc");
+             }
+           }},
+      },
+      R"cc(
+        bool $classname$::_InternalEquals(const $classname$& other) const {
+          if (this == &other) return true;
+          // Messages that differ in which fields are set usually differ in
+          // the first has-bits word.
+          $compare_has_bits$;
+          $compare_inline_fields$;
+          $compare_other_fields$;
+          $compare_oneofs$;
+          if (($have_unknown_fields$ || other.$have_unknown_fields$) &&
+              !::_pbi::UnknownFieldsEquals($unknown_fields$,
+                                           other.$unknown_fields$)) {
+            return false;
+          }
+          return true;
+        }
+      )cc");
+}
+
 void MessageGenerator::GenerateByteSize(io::Printer* p) {
   if (HasSimpleBaseClass(descriptor_, options_)) return;
 
@@ -4738,6 +5480,15 @@ void MessageGenerator::GenerateByteSize(io::Printer* p) {
         )cc");
     return;
   }
+  if (UseTableSerializer(descriptor_, options_, scc_analyzer_)) {
+    p->Emit(R"cc(
+      ::size_t $classname$::ByteSizeLong() const {
+        $annotate_bytesize$;
+        return $pbi$::TcParser::ByteSizeWithTable(*this, &_table_.header);
+      }
+    )cc");
+    return;
+  }
 
   Formatter format(p);
   format(
@@ -4755,8 +5506,34 @@ void MessageGenerator::GenerateByteSize(io::Printer* p) {
         "\n");
   }
 
+  format(
+      "$uint32$ cached_has_bits = 0;\n"
+      "// Prevent compiler warnings about cached_has_bits being unused\n"
+      "(void) cached_has_bits;\n\n");
+
+  // Fields left for the chunked sizing below.
+  std::vector<const FieldDescriptor*> chunked_fields = optimized_order_;
+  if (SerializeOnlySetFields(descriptor_, options_)) {
+    // Visit the set bits of each has-bit word and size only those fields.
+    std::vector<const FieldDescriptor*> hasbit_fields;
+    chunked_fields.clear();
+    for (const auto* field : optimized_order_) {
+      if (HasBitIndex(field) == kNoHasbit) {
+        chunked_fields.push_back(field);
+      } else {
+        hasbit_fields.push_back(field);
+      }
+    }
+    EmitSetFieldsLoops(
+        hasbit_fields, has_bit_indices_,
+        [&](const FieldDescriptor* field) {
+          field_generators_.get(field).GenerateByteSize(p);
+        },
+        p);
+  }
+
   std::vector<FieldChunk> chunks = CollectFields(
-      optimized_order_, options_,
+      chunked_fields, options_,
       [&](const FieldDescriptor* a, const FieldDescriptor* b) -> bool {
         return a->label() == b->label() && HasByteIndex(a) == HasByteIndex(b) &&
                IsLikelyPresent(a, options_) == IsLikelyPresent(b, options_) &&
@@ -4767,11 +5544,6 @@ void MessageGenerator::GenerateByteSize(io::Printer* p) {
   auto end = chunks.end();
   int cached_has_word_index = -1;
 
-  format(
-      "$uint32$ cached_has_bits = 0;\n"
-      "// Prevent compiler warnings about cached_has_bits being unused\n"
-      "(void) cached_has_bits;\n\n");
-
   while (it != end) {
     auto next = FindNextUnequalChunk(it, end, MayGroupChunksForHaswordsCheck);
     bool has_haswords_check = MaybeEmitHaswordsCheck(
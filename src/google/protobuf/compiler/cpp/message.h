@@ -43,6 +43,7 @@
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
 #include "google/protobuf/compiler/cpp/enum.h"
 #include "google/protobuf/compiler/cpp/extension.h"
 #include "google/protobuf/compiler/cpp/field.h"
@@ -51,6 +52,7 @@
 #include "google/protobuf/compiler/cpp/options.h"
 #include "google/protobuf/compiler/cpp/parse_function_generator.h"
 #include "google/protobuf/io/printer.h"
+#include "google/protobuf/message.h"
 
 namespace google {
 namespace protobuf {
@@ -94,6 +96,17 @@ class MessageGenerator {
   // default instance.
   void GenerateConstexprConstructor(io::Printer* p);
 
+  // Generate the constexpr constructor that builds a message constant from the
+  // value of each of its constant fields (see MessageConstants).
+  void GenerateConstantConstructor(io::Printer* p);
+  bool HasConstantConstructor() const;
+
+  // Returns the arguments of the constant constructor for `value`.  `storage`
+  // emits each set sub-message and returns an expression for its address.
+  std::string ConstantConstructorArgs(
+      const Message& value,
+      absl::FunctionRef<std::string(const Message&)> storage) const;
+
   void GenerateSchema(io::Printer* p, int offset, int has_offset);
 
   // Generate the field offsets array.  Returns the a pair of the total number
@@ -108,6 +121,8 @@ class MessageGenerator {
   // Generate declarations and definitions of accessors for fields.
   void GenerateFieldAccessorDeclarations(io::Printer* p);
   void GenerateFieldAccessorDefinitions(io::Printer* p);
+  void GenerateConstexprImplInitializers(io::Printer* p, bool from_params);
+  std::string ConstantConstructorParams() const;
 
   // Generate constructors and destructor.
   void GenerateStructors(io::Printer* p);
@@ -142,6 +157,8 @@ class MessageGenerator {
   void GenerateSerializeWithCachedSizesBody(io::Printer* p);
   void GenerateSerializeWithCachedSizesBodyShuffled(io::Printer* p);
   void GenerateByteSize(io::Printer* p);
+  void GenerateSpaceUsedLong(io::Printer* p);
+  void GenerateEquals(io::Printer* p);
   void GenerateMergeFrom(io::Printer* p);
   void GenerateClassSpecificMergeImpl(io::Printer* p);
   void GenerateCopyFrom(io::Printer* p);
@@ -160,6 +177,10 @@ class MessageGenerator {
   void GenerateSerializeOneofFields(
       io::Printer* p, const std::vector<const FieldDescriptor*>& fields);
   void GenerateSerializeOneExtensionRange(io::Printer* p, int start, int end);
+  // Generate loops over the set has-bits of `fields`, which are consecutive
+  // in field number order, that serialize just the fields that are present.
+  void GenerateSerializeSetFields(
+      io::Printer* p, const std::vector<const FieldDescriptor*>& fields);
 
   // Generates has_foo() functions and variables for singular field has-bits.
   void GenerateSingularFieldHasBits(const FieldDescriptor* field,
@@ -44,11 +44,15 @@ class AccessInfoMap;
 class SplitMap;
 
 namespace cpp {
+class MessageConstants;
+class ParseProfile;
 
 enum class EnforceOptimizeMode {
   kNoEnforcement,  // Use the runtime specified by the file specific options.
   kSpeed,          // Full runtime with a generated code implementation.
   kCodeSize,       // Full runtime with a reflective implementation.
+  kTableDriven,    // Full runtime; parse, serialize and ByteSize driven by the
+                   // parse table, everything else reflective.
   kLiteRuntime,
 };
 
@@ -61,18 +65,32 @@ struct FieldListenerOptions {
 struct Options {
   const AccessInfoMap* access_info_map = nullptr;
   const SplitMap* split_map = nullptr;
+  const ParseProfile* parse_profile = nullptr;
+  const MessageConstants* message_constants = nullptr;
   std::string dllexport_decl;
   std::string runtime_include_base;
   std::string annotation_pragma_name;
   std::string annotation_guard_name;
   FieldListenerOptions field_listener_options;
+  absl::flat_hash_set<std::string> specialized_parse_messages;
+  absl::flat_hash_set<std::string> retain_lazy_encoding_messages;
+  absl::flat_hash_set<std::string> repeated_string_buffer_fields;
   EnforceOptimizeMode enforce_mode = EnforceOptimizeMode::kNoEnforcement;
   int num_cc_files = 0;
+  int table_serializer_min_fields = 0;
+  int sparse_clear_min_fields = 0;
+  int sparse_serialize_min_fields = 0;
+  int heap_free_list_size = 0;
   bool safe_boundary_check = false;
   bool proto_h = false;
   bool transitive_pb_h = true;
   bool annotate_headers = false;
   bool lite_implicit_weak_fields = false;
+  // Singular implicit weak fields keep their serialized bytes until accessed.
+  bool lite_lazy_implicit_weak_fields = false;
+  // Singular [lazy = true] fields of lite messages keep their serialized bytes
+  // until accessed.
+  bool lite_lazy_fields = false;
   bool bootstrap = false;
   bool opensource_runtime = false;
   bool annotate_accessor = false;
@@ -86,6 +104,11 @@ struct Options {
   bool force_inline_string = false;
 #endif  // !PROTOBUF_STABLE_EXPERIMENTS
   bool strip_nonfunctional_codegen = false;
+  bool lazy_descriptor_registration = false;
+  bool cold_sections = false;
+  bool equality = false;
+  bool equality_operator = false;
+  bool recycle_oneof_messages = false;
 };
 
 }  // namespace cpp
@@ -30,8 +30,12 @@
 
 #include "google/protobuf/compiler/cpp/padding_optimizer.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "absl/log/absl_log.h"
 #include "google/protobuf/compiler/cpp/helpers.h"
+#include "google/protobuf/compiler/cpp/parse_profile.h"
 
 namespace google {
 namespace protobuf {
@@ -86,9 +90,12 @@ class FieldGroup {
 
 }  // namespace
 
+// If `keep_order` is true, fields are kept close to their position in `fields`
+// rather than to their field number order.
 static void OptimizeLayoutHelper(std::vector<const FieldDescriptor*>* fields,
                                  const Options& options,
-                                 MessageSCCAnalyzer* scc_analyzer) {
+                                 MessageSCCAnalyzer* scc_analyzer,
+                                 bool keep_order = false) {
   if (fields->empty()) return;
 
   // The sorted numeric order of Family determines the declaration order in the
@@ -126,7 +133,7 @@ static void OptimizeLayoutHelper(std::vector<const FieldDescriptor*>* fields,
       f = ZERO_INITIALIZABLE;
     }
 
-    const int j = field->number();
+    const int j = keep_order ? i : field->number();
     switch (EstimateAlignmentSize(field)) {
       case 1:
         aligned_to_1[f].push_back(FieldGroup(j, field));
@@ -227,24 +234,39 @@ static void OptimizeLayoutHelper(std::vector<const FieldDescriptor*>* fields,
 //
 // OTHER these fields are initialized one-by-one.
 //
+// If the parse profile marks some fields as hot, they are placed first so that
+// they share the leading cache lines, ordered by decreasing frequency within
+// each family.
+//
 // If there are split fields in `fields`, they will be placed at the end. The
 // order within split fields follows the same rule, aka classify and order by
 // "family".
 void PaddingOptimizer::OptimizeLayout(
     std::vector<const FieldDescriptor*>* fields, const Options& options,
     MessageSCCAnalyzer* scc_analyzer) {
+  std::vector<const FieldDescriptor*> hot;
   std::vector<const FieldDescriptor*> normal;
   std::vector<const FieldDescriptor*> split;
   for (const auto* field : *fields) {
     if (ShouldSplit(field, options)) {
       split.push_back(field);
+    } else if (options.parse_profile != nullptr &&
+               options.parse_profile->IsHot(field)) {
+      hot.push_back(field);
     } else {
       normal.push_back(field);
     }
   }
+  std::stable_sort(hot.begin(), hot.end(),
+                   [&](const FieldDescriptor* a, const FieldDescriptor* b) {
+                     return *options.parse_profile->GetFrequency(a) >
+                            *options.parse_profile->GetFrequency(b);
+                   });
+  OptimizeLayoutHelper(&hot, options, scc_analyzer, /*keep_order=*/true);
   OptimizeLayoutHelper(&normal, options, scc_analyzer);
   OptimizeLayoutHelper(&split, options, scc_analyzer);
   fields->clear();
+  fields->insert(fields->end(), hot.begin(), hot.end());
   fields->insert(fields->end(), normal.begin(), normal.end());
   fields->insert(fields->end(), split.begin(), split.end());
 }
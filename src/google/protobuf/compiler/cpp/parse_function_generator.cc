@@ -41,6 +41,7 @@
 #include "absl/log/absl_log.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
 #include "google/protobuf/compiler/cpp/helpers.h"
 #include "google/protobuf/compiler/cpp/options.h"
@@ -94,6 +95,49 @@ std::vector<const FieldDescriptor*> GetOrderedFields(
   return ordered_fields;
 }
 
+// Returns whether the specialized parse function parses `field` itself
+// instead of leaving it to the table-driven parser.
+bool IsSpecializedParseField(const FieldDescriptor* field,
+                             const Options& options,
+                             MessageSCCAnalyzer* scc_analyzer) {
+  if (field->real_containing_oneof() != nullptr || field->is_map() ||
+      IsWeak(field, options) || IsLazy(field, options, scc_analyzer) ||
+      IsImplicitWeakField(field, options, scc_analyzer) ||
+      // Only tags of one or two bytes are predicted.
+      field->number() >= (1 << 11)) {
+    return false;
+  }
+  switch (field->type()) {
+    case FieldDescriptor::TYPE_GROUP:
+      return false;
+    case FieldDescriptor::TYPE_ENUM:
+      // Closed enums need their values validated.
+      return !field->legacy_enum_field_treated_as_closed();
+    case FieldDescriptor::TYPE_STRING:
+    case FieldDescriptor::TYPE_BYTES:
+      return !IsCord(field) && !IsStringPiece(field) &&
+             !IsStringInlined(field, options) &&
+             !IsRepeatedStringBuffer(field, options);
+    default:
+      return true;
+  }
+}
+
+// Returns the condition that `ptr` points at the encoding of `tag`, and sets
+// `size` to its length.
+std::string ExpectedTagCondition(uint32_t tag, int* size) {
+  std::vector<std::string> bytes;
+  do {
+    uint32_t byte = tag & 0x7F;
+    tag >>= 7;
+    if (tag != 0) byte |= 0x80;
+    bytes.push_back(absl::StrCat("static_cast<::uint8_t>(ptr[", bytes.size(),
+                                 "]) == ", byte));
+  } while (tag != 0);
+  *size = static_cast<int>(bytes.size());
+  return absl::StrJoin(bytes, " && ");
+}
+
 }  // namespace
 
 class ParseFunctionGenerator::GeneratedOptionProvider final
@@ -105,7 +149,8 @@ class ParseFunctionGenerator::GeneratedOptionProvider final
     const auto verify_flag = [&] {
       if (IsEagerlyVerifiedLazy(field, gen_->options_, gen_->scc_analyzer_))
         return internal::field_layout::kTvEager;
-      if (IsLazilyVerifiedLazy(field, gen_->options_))
+      if (IsLazilyVerifiedLazy(field, gen_->options_) ||
+          IsLazyImplicitWeakField(field, gen_->options_, gen_->scc_analyzer_))
         return internal::field_layout::kTvLazy;
       return internal::field_layout::TransformValidation{};
     };
@@ -116,6 +161,7 @@ class ParseFunctionGenerator::GeneratedOptionProvider final
         IsImplicitWeakField(field, gen_->options_, gen_->scc_analyzer_),
         UseDirectTcParserTable(field, gen_->options_),
         ShouldSplit(field, gen_->options_),
+        IsRepeatedStringBuffer(field, gen_->options_),
     };
   }
 
@@ -200,6 +246,10 @@ bool ParseFunctionGenerator::should_generate_tctable() const {
 
 void ParseFunctionGenerator::GenerateTailcallParseFunction(Formatter& format) {
   ABSL_CHECK(should_generate_tctable());
+  if (options_.specialized_parse_messages.contains(descriptor_->full_name())) {
+    GenerateSpecializedParseFunction(format);
+    return;
+  }
 
   // Generate an `_InternalParse` that starts the tail-calling loop.
   format(
@@ -213,6 +263,171 @@ void ParseFunctionGenerator::GenerateTailcallParseFunction(Formatter& format) {
       "}\n\n");
 }
 
+void ParseFunctionGenerator::GenerateSpecializedParseFunction(
+    Formatter& format) {
+  // Each field is tried in turn and skipped if absent, so a message that is
+  // serialized in field number order is parsed in a single pass without any
+  // table lookups. The first tag out of that order, or of a field that is
+  // left to the table, hands the rest of the message over to the table-driven
+  // parser, which also runs the end of message checks.
+  format(
+      "const char* $classname$::_InternalParse(\n"
+      "    const char* ptr, ::_pbi::ParseContext* ctx) {\n"
+      "$annotate_deserialize$");
+  format.Indent();
+  format("if (ctx->Done(&ptr)) goto done;\n");
+  for (const FieldDescriptor* field : ordered_fields_) {
+    if (IsSpecializedParseField(field, options_, scc_analyzer_)) {
+      GenerateSpecializedFieldParse(format, field);
+    }
+  }
+  format.Outdent();
+  format(
+      "done:\n"
+      "  if (ptr == nullptr) return nullptr;\n"
+      "  return ::_pbi::TcParser::ParseLoop(this, ptr, ctx, "
+      "&_table_.header);\n"
+      "}\n\n");
+}
+
+void ParseFunctionGenerator::GenerateSpecializedFieldParse(
+    Formatter& format, const FieldDescriptor* field) {
+  int tag_size;
+  const std::string expected_tag =
+      ExpectedTagCondition(WireFormat::MakeTag(field), &tag_size);
+  const std::string name = FieldName(field);
+  const bool repeated = field->is_repeated();
+  const bool packed = field->is_packed();
+  const WireFormatLite::WireType wire_type =
+      WireFormat::WireTypeForFieldType(field->type());
+  const bool fixed = wire_type == WireFormatLite::WIRETYPE_FIXED32 ||
+                     wire_type == WireFormatLite::WIRETYPE_FIXED64;
+
+  PrintFieldComment(format, field, options_);
+  format("if ($1$) {\n", expected_tag);
+  format.Indent();
+  if (repeated && !packed) {
+    format("do {\n");
+    format.Indent();
+  }
+  format("ptr += $1$;\n", tag_size);
+  // Stores `value`, an expression that reads from `ptr`.
+  auto store = [&](const std::string& value) {
+    if (repeated) {
+      format("_internal_mutable_$1$()->Add($2$);\n", name, value);
+    } else {
+      format("_internal_set_$1$($2$);\n", name, value);
+    }
+  };
+  auto check_utf8 = [&](const std::string& value) {
+    if (field->type() != FieldDescriptor::TYPE_STRING) return;
+    bool is_lite =
+        GetOptimizeFor(field->file(), options_) == FileOptions::LITE_RUNTIME;
+    switch (internal::cpp::GetUtf8CheckMode(field, is_lite)) {
+      case Utf8CheckMode::kStrict:
+        format(
+            "if (!::_pbi::WireFormatLite::VerifyUtf8String(\n"
+            "        $1$.data(), static_cast<int>($1$.size()),\n"
+            "        ::_pbi::WireFormatLite::PARSE, \"$2$\")) {\n"
+            "  return nullptr;\n"
+            "}\n",
+            value, field->full_name());
+        break;
+      case Utf8CheckMode::kVerify:
+        format(
+            "::_pbi::WireFormat::VerifyUTF8StringNamedField(\n"
+            "    $1$.data(), static_cast<int>($1$.size()),\n"
+            "    ::_pbi::WireFormat::PARSE, \"$2$\");\n",
+            value, field->full_name());
+        break;
+      case Utf8CheckMode::kNone:
+        break;
+    }
+  };
+
+  if (packed) {
+    format("ptr = ::_pbi::Packed$1$Parser(_internal_mutable_$2$(), ptr, ctx);\n",
+           DeclaredTypeMethodName(field->type()), name);
+  } else {
+    switch (field->type()) {
+      case FieldDescriptor::TYPE_FIXED32:
+      case FieldDescriptor::TYPE_SFIXED32:
+      case FieldDescriptor::TYPE_FLOAT:
+      case FieldDescriptor::TYPE_FIXED64:
+      case FieldDescriptor::TYPE_SFIXED64:
+      case FieldDescriptor::TYPE_DOUBLE: {
+        const std::string type =
+            PrimitiveTypeName(options_, field->cpp_type());
+        store(absl::StrCat("::_pbi::UnalignedLoad<", type, ">(ptr)"));
+        format("ptr += sizeof($1$);\n", type);
+        break;
+      }
+      case FieldDescriptor::TYPE_INT32:
+      case FieldDescriptor::TYPE_INT64:
+      case FieldDescriptor::TYPE_UINT32:
+        store(absl::StrCat("static_cast<",
+                           PrimitiveTypeName(options_, field->cpp_type()),
+                           ">(::_pbi::ReadVarint64(&ptr))"));
+        break;
+      case FieldDescriptor::TYPE_UINT64:
+        store("::_pbi::ReadVarint64(&ptr)");
+        break;
+      case FieldDescriptor::TYPE_SINT32:
+        store("::_pbi::ReadVarintZigZag32(&ptr)");
+        break;
+      case FieldDescriptor::TYPE_SINT64:
+        store("::_pbi::ReadVarintZigZag64(&ptr)");
+        break;
+      case FieldDescriptor::TYPE_BOOL:
+        store("::_pbi::ReadVarint64(&ptr) != 0");
+        break;
+      case FieldDescriptor::TYPE_ENUM:
+        store(absl::StrCat(
+            "static_cast<",
+            repeated ? "int" : QualifiedClassName(field->enum_type(), options_),
+            ">(static_cast<::int32_t>(::_pbi::ReadVarint64(&ptr)))"));
+        break;
+      case FieldDescriptor::TYPE_STRING:
+      case FieldDescriptor::TYPE_BYTES:
+        if (repeated) {
+          format(
+              "std::string* str = _internal_mutable_$1$()->Add();\n"
+              "ptr = ::_pbi::InlineGreedyStringParser(str, ptr, ctx);\n"
+              "if (ptr == nullptr) return nullptr;\n",
+              name);
+          check_utf8("(*str)");
+        } else {
+          format(
+              "ptr = ::_pbi::InlineGreedyStringParser(\n"
+              "    _internal_mutable_$1$(), ptr, ctx);\n"
+              "if (ptr == nullptr) return nullptr;\n",
+              name);
+          check_utf8(absl::StrCat("_internal_", name, "()"));
+        }
+        break;
+      case FieldDescriptor::TYPE_MESSAGE:
+        format("ptr = ctx->ParseMessage(_internal_mutable_$1$()$2$, ptr);\n",
+               name, repeated ? "->Add()" : "");
+        break;
+      default:
+        ABSL_LOG(FATAL) << "Unexpected type: " << field->type_name();
+    }
+  }
+  // Fixed width values can't fail, and strings were checked above.
+  if (packed || (field->type() != FieldDescriptor::TYPE_STRING &&
+                 field->type() != FieldDescriptor::TYPE_BYTES &&
+                 !fixed)) {
+    format("if (ptr == nullptr) return nullptr;\n");
+  }
+  format("if (ctx->Done(&ptr)) goto done;\n");
+  if (repeated && !packed) {
+    format.Outdent();
+    format("} while ($1$);\n", expected_tag);
+  }
+  format.Outdent();
+  format("}\n");
+}
+
 struct SkipEntry16 {
   uint16_t skipmap;
   uint16_t field_entry_offset;
@@ -424,8 +639,11 @@ void ParseFunctionGenerator::GenerateTailCallTable(io::Printer* printer) {
       format(
           "&$1$._instance,\n"
           "$2$,  // fallback\n"
+          "$3$, $4$,  // required_has_bits_word, required_has_bits\n"
           "",
-          DefaultInstanceName(descriptor_, options_), fallback);
+          DefaultInstanceName(descriptor_, options_), fallback,
+          static_cast<int>(tc_table_info_->required_has_bits_word),
+          tc_table_info_->required_has_bits);
     }
     format("}, {{\n");
     {
@@ -669,13 +887,14 @@ static void FormatFieldKind(Formatter& format,
           ABSL_LOG(FATAL) << "Unknown type_card: 0x" << type_card;
       }
 
-      static constexpr const char* kRepNames[] = {"AString", "IString", "Cord",
-                                                  "SPiece", "SString"};
+      static constexpr const char* kRepNames[] = {
+          "AString", "IString", "Cord", "SPiece", "SString", "SBuffer"};
       static_assert((fl::kRepAString >> fl::kRepShift) == 0, "");
       static_assert((fl::kRepIString >> fl::kRepShift) == 1, "");
       static_assert((fl::kRepCord >> fl::kRepShift) == 2, "");
       static_assert((fl::kRepSPiece >> fl::kRepShift) == 3, "");
       static_assert((fl::kRepSString >> fl::kRepShift) == 4, "");
+      static_assert((fl::kRepSBuffer >> fl::kRepShift) == 5, "");
 
       format(" | ::_fl::kRep$1$", kRepNames[rep_index]);
       break;
@@ -693,7 +912,8 @@ static void FormatFieldKind(Formatter& format,
       }
 
       static constexpr const char* kXFormNames[2][4] = {
-          {nullptr, "Default", "Table", "WeakPtr"}, {nullptr, "Eager", "Lazy"}};
+          {nullptr, "Default", "Table", "WeakPtr"},
+          {nullptr, "Eager", "Lazy", "WeakPtr"}};
 
       static_assert((fl::kTvDefault >> fl::kTvShift) == 1, "");
       static_assert((fl::kTvTable >> fl::kTvShift) == 2, "");
@@ -79,6 +79,12 @@ class ParseFunctionGenerator {
   // Generates a tail-calling `_InternalParse` function.
   void GenerateTailcallParseFunction(Formatter& format);
 
+  // Generates an `_InternalParse` function that parses the fields expected
+  // in field number order inline, see the specialized_parse option.
+  void GenerateSpecializedParseFunction(Formatter& format);
+  void GenerateSpecializedFieldParse(Formatter& format,
+                                     const FieldDescriptor* field);
+
   // Generates the tail-call table definition.
   void GenerateTailCallTable(io::Printer* printer);
   void GenerateFastFieldEntries(Formatter& format);
@@ -0,0 +1,115 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef GOOGLE_PROTOBUF_COMPILER_CPP_PARSE_PROFILE_H__
+#define GOOGLE_PROTOBUF_COMPILER_CPP_PARSE_PROFILE_H__
+
+#include <cstdint>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "google/protobuf/descriptor.h"
+
+namespace google {
+namespace protobuf {
+namespace compiler {
+namespace cpp {
+
+// Per field frequencies, as collected at runtime by internal::TcParseProfile
+// and passed to the generator with the `parse_profile=<file>` option.  The
+// fast parse table, the field layout, the split of cold fields and the
+// inlining of hot string fields of every message in the profile are derived
+// from them.
+//
+// The profile has one `<message full name> <field number> <count>` entry per
+// line. Blank lines and lines starting with '#' are ignored, and repeated
+// entries are summed so that profiles from several processes can simply be
+// concatenated.  Accessor frequencies sampled on live traffic by
+// SampledAccessListener are exported in the same format by
+// FieldAccessProfileToString(), and counts from other sources, e.g. periodic
+// sampling of live messages through Reflection::ListFields(), can be written
+// in it too.
+class ParseProfile {
+ public:
+  // Fields at least this frequent are laid out first in their message, most
+  // frequent first. Hot singular string fields with a hasbit are stored
+  // inline as an InlinedStringField, which saves the allocation and the
+  // indirection of the string.
+  static constexpr float kHotFrequency = 0.1f;
+  // Singular fields less frequent than this are moved out of the message into
+  // its separately allocated split struct.
+  static constexpr float kColdFrequency = 0.01f;
+  // Singular message fields at least this frequent are allocated by the
+  // constructor of their message, next to it, instead of on first use.
+  static constexpr float kAlwaysPresentFrequency = 0.99f;
+
+  static absl::StatusOr<ParseProfile> Parse(absl::string_view content);
+
+  // Returns how often `field` was seen relative to the most frequent field of
+  // its message, in [0, 1], or nullopt if the message was never sampled.
+  absl::optional<float> GetFrequency(const FieldDescriptor* field) const;
+
+  bool IsHot(const FieldDescriptor* field) const {
+    absl::optional<float> frequency = GetFrequency(field);
+    return frequency.has_value() && *frequency >= kHotFrequency;
+  }
+  bool IsCold(const FieldDescriptor* field) const {
+    absl::optional<float> frequency = GetFrequency(field);
+    return frequency.has_value() && *frequency < kColdFrequency;
+  }
+  bool IsAlwaysPresent(const FieldDescriptor* field) const {
+    absl::optional<float> frequency = GetFrequency(field);
+    return frequency.has_value() && *frequency >= kAlwaysPresentFrequency;
+  }
+
+  // Returns whether any field of `message` was seen in the profile.
+  bool IsSampled(const Descriptor* message) const {
+    auto it = messages_.find(message->full_name());
+    return it != messages_.end() && it->second.max_count != 0;
+  }
+
+ private:
+  struct MessageCounts {
+    absl::flat_hash_map<int, uint64_t> fields;
+    uint64_t max_count = 0;
+  };
+  absl::flat_hash_map<std::string, MessageCounts> messages_;
+};
+
+}  // namespace cpp
+}  // namespace compiler
+}  // namespace protobuf
+}  // namespace google
+
+#endif  // GOOGLE_PROTOBUF_COMPILER_CPP_PARSE_PROFILE_H__
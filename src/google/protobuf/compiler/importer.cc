@@ -45,19 +45,23 @@
 #include <sys/types.h>
 
 #include <algorithm>
+#include <cstdio>
 #include <memory>
 #include <vector>
 
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_replace.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "google/protobuf/compiler/parser.h"
+#include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/io_win32.h"
 #include "google/protobuf/io/tokenizer.h"
 #include "google/protobuf/io/zero_copy_stream_impl.h"
+#include "google/protobuf/stubs/common.h"
 
 #ifdef _WIN32
 #include <ctype.h>
@@ -74,6 +78,14 @@ using google::protobuf::io::win32::access;
 using google::protobuf::io::win32::open;
 #endif
 
+#ifndef O_BINARY
+#ifdef _O_BINARY
+#define O_BINARY _O_BINARY
+#else
+#define O_BINARY 0  // If this isn't defined, the platform doesn't need it.
+#endif
+#endif
+
 // Returns true if the text looks like a Windows-style absolute path, starting
 // with a drive letter.  Example:  "C:\foo".  TODO(kenton):  Share this with
 // copy in command_line_interface.cc?
@@ -154,9 +166,38 @@ bool SourceTreeDescriptorDatabase::FindFileByName(const std::string& filename,
     return false;
   }
 
+  if (parse_cache_directory_.empty()) {
+    return Parse(filename, input.get(), output);
+  }
+  cached_files_.erase(filename);
+
+  // The whole file is needed to look it up in the cache.
+  std::string source;
+  const void* data;
+  int size;
+  while (input->Next(&data, &size)) {
+    source.append(static_cast<const char*>(data), size);
+  }
+  if (ReadParseCache(filename, source, output)) {
+    if (using_validation_error_collector_) {
+      cached_files_[filename] = {std::move(source), output};
+    }
+    return true;
+  }
+  io::ArrayInputStream source_input(source.data(), source.size());
+  if (!Parse(filename, &source_input, output)) {
+    return false;
+  }
+  WriteParseCache(filename, source, *output);
+  return true;
+}
+
+bool SourceTreeDescriptorDatabase::Parse(const std::string& filename,
+                                         io::ZeroCopyInputStream* input,
+                                         FileDescriptorProto* output) {
   // Set up the tokenizer and parser.
   SingleFileErrorCollector file_error_collector(filename, error_collector_);
-  io::Tokenizer tokenizer(input.get(), &file_error_collector);
+  io::Tokenizer tokenizer(input, &file_error_collector);
 
   Parser parser;
   if (error_collector_ != nullptr) {
@@ -171,6 +212,169 @@ bool SourceTreeDescriptorDatabase::FindFileByName(const std::string& filename,
   return parser.Parse(&tokenizer, output) && !file_error_collector.had_errors();
 }
 
+namespace {
+
+// Bumped whenever the parser may produce different output for the same input.
+constexpr uint32_t kParseCacheVersion = GOOGLE_PROTOBUF_VERSION;
+
+// 64-bit FNV-1a.  This only needs to spread entries over file names; entries
+// store the full key and are verified on lookup.
+uint64_t ParseCacheHash(absl::string_view filename, absl::string_view source) {
+  uint64_t hash = 0xcbf29ce484222325;
+  for (absl::string_view part :
+       {filename, absl::string_view("\0", 1), source}) {
+    for (char c : part) {
+      hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3;
+    }
+  }
+  return hash;
+}
+
+std::string ParseCachePath(absl::string_view directory,
+                           absl::string_view filename,
+                           absl::string_view source) {
+  return absl::StrFormat("%s/%016x.protoparse", directory,
+                         ParseCacheHash(filename, source));
+}
+
+}  // namespace
+
+bool SourceTreeDescriptorDatabase::ReadParseCache(
+    const std::string& filename, absl::string_view source,
+    FileDescriptorProto* output) {
+  std::string path = ParseCachePath(parse_cache_directory_, filename, source);
+  int file_descriptor;
+  do {
+    file_descriptor = open(path.c_str(), O_RDONLY | O_BINARY);
+  } while (file_descriptor < 0 && errno == EINTR);
+  if (file_descriptor < 0) return false;
+
+  // An entry is the cache version, the file name and contents it was parsed
+  // from, and then the serialized FileDescriptorProto.
+  io::FileInputStream stream(file_descriptor);
+  stream.SetCloseOnDelete(true);
+  io::CodedInputStream input(&stream);
+  uint32_t version, length;
+  std::string entry_filename, entry_source;
+  if (!input.ReadVarint32(&version) || version != kParseCacheVersion ||
+      !input.ReadVarint32(&length) ||
+      !input.ReadString(&entry_filename, length) ||
+      entry_filename != filename || !input.ReadVarint32(&length) ||
+      length != source.size() || !input.ReadString(&entry_source, length) ||
+      entry_source != source) {
+    return false;
+  }
+  output->Clear();
+  return output->ParseFromCodedStream(&input);
+}
+
+void SourceTreeDescriptorDatabase::WriteParseCache(
+    const std::string& filename, absl::string_view source,
+    const FileDescriptorProto& file) {
+  // Write to a temporary file and rename it into place so that concurrent
+  // readers never see a partial entry.  O_EXCL keeps concurrent writers of
+  // the same entry apart; the loser simply doesn't cache.
+  std::string path = ParseCachePath(parse_cache_directory_, filename, source);
+  std::string temp_path = absl::StrCat(path, ".tmp");
+  int file_descriptor;
+  do {
+    file_descriptor = open(temp_path.c_str(),
+                           O_WRONLY | O_CREAT | O_EXCL | O_BINARY, 0666);
+  } while (file_descriptor < 0 && errno == EINTR);
+  if (file_descriptor < 0) return;
+
+  bool ok;
+  {
+    io::FileOutputStream stream(file_descriptor);
+    {
+      io::CodedOutputStream output(&stream);
+      output.WriteVarint32(kParseCacheVersion);
+      output.WriteVarint32(filename.size());
+      output.WriteString(filename);
+      output.WriteVarint32(source.size());
+      output.WriteRaw(source.data(), source.size());
+      ok = file.SerializeToCodedStream(&output) && !output.HadError();
+    }
+    ok &= stream.Close();
+  }
+  if (!ok || std::rename(temp_path.c_str(), path.c_str()) != 0) {
+    std::remove(temp_path.c_str());
+  }
+}
+
+namespace {
+
+// Finds the path of submessages from `root` to `target`.
+bool FindMessagePath(
+    const Message& root, const Message* target,
+    std::vector<std::pair<const FieldDescriptor*, int>>* path) {
+  if (&root == target) return true;
+  const Reflection* reflection = root.GetReflection();
+  std::vector<const FieldDescriptor*> fields;
+  reflection->ListFields(root, &fields);
+  for (const FieldDescriptor* field : fields) {
+    if (field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) continue;
+    if (!field->is_repeated()) {
+      path->emplace_back(field, -1);
+      if (FindMessagePath(reflection->GetMessage(root, field), target, path)) {
+        return true;
+      }
+      path->pop_back();
+      continue;
+    }
+    for (int i = 0; i < reflection->FieldSize(root, field); ++i) {
+      path->emplace_back(field, i);
+      if (FindMessagePath(reflection->GetRepeatedMessage(root, field, i),
+                          target, path)) {
+        return true;
+      }
+      path->pop_back();
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+const Message* SourceTreeDescriptorDatabase::FindParsedDescriptor(
+    absl::string_view filename, const Message* descriptor) {
+  auto cached = cached_files_.find(filename);
+  if (cached == cached_files_.end()) return descriptor;
+
+  std::vector<std::pair<const FieldDescriptor*, int>> path;
+  if (descriptor == nullptr ||
+      !FindMessagePath(*cached->second.file, descriptor, &path)) {
+    return descriptor;
+  }
+
+  auto& reparsed = reparsed_files_[filename];
+  if (reparsed == nullptr) {
+    // The file parsed without errors before, so this records its locations
+    // without reporting anything.
+    reparsed = std::make_unique<FileDescriptorProto>();
+    MultiFileErrorCollector* error_collector = error_collector_;
+    error_collector_ = nullptr;
+    const std::string& source = cached->second.source;
+    io::ArrayInputStream input(source.data(), source.size());
+    Parse(std::string(filename), &input, reparsed.get());
+    error_collector_ = error_collector;
+  }
+
+  const Message* message = reparsed.get();
+  for (const auto& step : path) {
+    const Reflection* reflection = message->GetReflection();
+    if (step.second < 0) {
+      message = &reflection->GetMessage(*message, step.first);
+    } else if (step.second < reflection->FieldSize(*message, step.first)) {
+      message = &reflection->GetRepeatedMessage(*message, step.first,
+                                                step.second);
+    } else {
+      return descriptor;
+    }
+  }
+  return message;
+}
+
 bool SourceTreeDescriptorDatabase::FindFileContainingSymbol(
     const std::string& symbol_name, FileDescriptorProto* output) {
   return false;
@@ -196,6 +400,7 @@ void SourceTreeDescriptorDatabase::ValidationErrorCollector::RecordError(
     const Message* descriptor, ErrorLocation location,
     absl::string_view message) {
   if (owner_->error_collector_ == nullptr) return;
+  descriptor = owner_->FindParsedDescriptor(filename, descriptor);
 
   int line, column;
   if (location == DescriptorPool::ErrorCollector::IMPORT) {
@@ -212,6 +417,7 @@ void SourceTreeDescriptorDatabase::ValidationErrorCollector::RecordWarning(
     const Message* descriptor, ErrorLocation location,
     absl::string_view message) {
   if (owner_->error_collector_ == nullptr) return;
+  descriptor = owner_->FindParsedDescriptor(filename, descriptor);
 
   int line, column;
   if (location == DescriptorPool::ErrorCollector::IMPORT) {
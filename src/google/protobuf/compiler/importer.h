@@ -37,10 +37,12 @@
 #ifndef GOOGLE_PROTOBUF_COMPILER_IMPORTER_H__
 #define GOOGLE_PROTOBUF_COMPILER_IMPORTER_H__
 
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
 #include "google/protobuf/compiler/parser.h"
 #include "google/protobuf/descriptor.h"
@@ -106,6 +108,16 @@ class PROTOBUF_EXPORT SourceTreeDescriptorDatabase : public DescriptorDatabase {
     return &validation_error_collector_;
   }
 
+  // Caches parsed files on disk in the given directory, keyed by file name and
+  // contents.  Files which are unchanged since any earlier use of the same
+  // directory (e.g. by a previous protoc run) are then not tokenized and
+  // parsed again.  Only files which parsed without errors are cached.  If the
+  // DescriptorPool reports an error in a cached file, that file is parsed
+  // again on demand to find the line and column of the error.
+  void SetParseCacheDirectory(absl::string_view directory) {
+    parse_cache_directory_ = std::string(directory);
+  }
+
   // implements DescriptorDatabase -----------------------------------
   bool FindFileByName(const std::string& filename,
                       FileDescriptorProto* output) override;
@@ -118,6 +130,23 @@ class PROTOBUF_EXPORT SourceTreeDescriptorDatabase : public DescriptorDatabase {
  private:
   class SingleFileErrorCollector;
 
+  // Parses `input` into `output`, reporting errors to error_collector_.
+  bool Parse(const std::string& filename, io::ZeroCopyInputStream* input,
+             FileDescriptorProto* output);
+
+  // Looks up or stores the parse of `filename` with the given contents in
+  // parse_cache_directory_.
+  bool ReadParseCache(const std::string& filename, absl::string_view source,
+                      FileDescriptorProto* output);
+  void WriteParseCache(const std::string& filename, absl::string_view source,
+                       const FileDescriptorProto& file);
+
+  // If `filename` was loaded from the parse cache, parses it again to record
+  // its source locations and returns the element of the fresh parse which
+  // corresponds to `descriptor`.  Otherwise returns `descriptor`.
+  const Message* FindParsedDescriptor(absl::string_view filename,
+                                      const Message* descriptor);
+
   SourceTree* source_tree_;
   DescriptorDatabase* fallback_database_;
   MultiFileErrorCollector* error_collector_;
@@ -146,6 +175,19 @@ class PROTOBUF_EXPORT SourceTreeDescriptorDatabase : public DescriptorDatabase {
   bool using_validation_error_collector_;
   SourceLocationTable source_locations_;
   ValidationErrorCollector validation_error_collector_;
+
+  std::string parse_cache_directory_;
+  // Files served from the parse cache, with their contents and the proto the
+  // DescriptorPool is building from.  The proto is only dereferenced while
+  // the pool reports errors for that file, i.e. while it is being built.
+  struct CachedFile {
+    std::string source;
+    const FileDescriptorProto* file;
+  };
+  absl::flat_hash_map<std::string, CachedFile> cached_files_;
+  // Fresh parses of cached files, made when an error needed a location.
+  absl::flat_hash_map<std::string, std::unique_ptr<FileDescriptorProto>>
+      reparsed_files_;
 };
 
 // Simple interface for parsing .proto files.  This wraps the process
@@ -254,6 +254,77 @@ TEST_F(ImporterTest, LiteRuntimeImport) {
       error_collector_.text_);
 }
 
+// ===================================================================
+
+class ParseCacheTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    cache_dir_ = absl::StrCat(TestTempDir(), "/test_parse_cache");
+    if (FileExists(cache_dir_)) {
+      File::DeleteRecursively(cache_dir_, NULL, NULL);
+    }
+    ABSL_CHECK_OK(File::CreateDir(cache_dir_, 0777));
+  }
+
+  void TearDown() override {
+    if (FileExists(cache_dir_)) {
+      File::DeleteRecursively(cache_dir_, NULL, NULL);
+    }
+  }
+
+  // Builds `filename` in a fresh pool backed by the parse cache, returning
+  // the errors reported and the FileDescriptorProto the database produced.
+  std::string Build(const std::string& filename,
+                    FileDescriptorProto* proto = nullptr) {
+    MockErrorCollector error_collector;
+    SourceTreeDescriptorDatabase database(&source_tree_);
+    database.RecordErrorsTo(&error_collector);
+    database.SetParseCacheDirectory(cache_dir_);
+    DescriptorPool pool(&database, database.GetValidationErrorCollector());
+    pool.FindFileByName(filename);
+    if (proto != nullptr) {
+      SourceTreeDescriptorDatabase uncached(&source_tree_);
+      proto->Clear();
+      EXPECT_TRUE(uncached.FindFileByName(filename, proto));
+      FileDescriptorProto cached;
+      EXPECT_TRUE(database.FindFileByName(filename, &cached));
+      EXPECT_EQ(cached.SerializeAsString(), proto->SerializeAsString());
+    }
+    return error_collector.text_;
+  }
+
+  std::string cache_dir_;
+  MockSourceTree source_tree_;
+};
+
+TEST_F(ParseCacheTest, CachedFilesMatchParsedFiles) {
+  source_tree_.AddFile("foo.proto",
+                       "syntax = \"proto2\";\n"
+                       "message Foo { optional int32 a = 1; }\n");
+  FileDescriptorProto first, second;
+  EXPECT_EQ("", Build("foo.proto", &first));
+  EXPECT_EQ("", Build("foo.proto", &second));
+  EXPECT_EQ("Foo", second.message_type(0).name());
+
+  // Changing the file invalidates its entry.
+  source_tree_.AddFile("foo.proto",
+                       "syntax = \"proto2\";\n"
+                       "message Bar { optional int32 a = 1; }\n");
+  EXPECT_EQ("", Build("foo.proto", &second));
+  EXPECT_EQ("Bar", second.message_type(0).name());
+}
+
+TEST_F(ParseCacheTest, CachedFilesReportErrorLocations) {
+  source_tree_.AddFile("foo.proto",
+                       "syntax = \"proto2\";\n"
+                       "message Foo {\n"
+                       "  optional Baz baz = 1;\n"
+                       "}\n");
+  const std::string expected = "foo.proto:2:11: \"Baz\" is not defined.\n";
+  EXPECT_EQ(expected, Build("foo.proto"));
+  // The second build is served from the cache.
+  EXPECT_EQ(expected, Build("foo.proto"));
+}
 
 // ===================================================================
 
@@ -33,6 +33,8 @@
 #include "google/protobuf/compiler/plugin.h"
 
 #include <iostream>
+#include <memory>
+#include <string>
 #include <vector>
 
 #ifdef _WIN32
@@ -41,14 +43,17 @@
 #include <unistd.h>
 #endif
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "google/protobuf/compiler/code_generator.h"
 #include "google/protobuf/compiler/plugin.pb.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/descriptor.pb.h"
 #include "google/protobuf/io/io_win32.h"
 #include "google/protobuf/io/zero_copy_stream_impl.h"
+#include "google/protobuf/util/delimited_message_util.h"
 
 
 namespace google {
@@ -112,29 +117,15 @@ class GeneratorResponseContext : public GeneratorContext {
   const std::vector<const FileDescriptor*>& parsed_files_;
 };
 
-bool GenerateCode(const CodeGeneratorRequest& request,
-                  const CodeGenerator& generator,
-                  CodeGeneratorResponse* response, std::string* error_msg) {
-  DescriptorPool pool;
-
-  // Initialize feature set default mapping.
-  absl::StatusOr<FeatureSetDefaults> defaults =
-      generator.BuildFeatureSetDefaults();
-  if (!defaults.ok()) {
-    *error_msg = absl::StrCat("error generating feature defaults: ",
-                              defaults.status().message());
-    return false;
-  }
-  pool.SetFeatureSetDefaults(*defaults);
-
-  for (int i = 0; i < request.proto_file_size(); i++) {
-    const FileDescriptor* file = pool.BuildFile(request.proto_file(i));
-    if (file == nullptr) {
-      // BuildFile() already wrote an error message.
-      return false;
-    }
-  }
+namespace {
 
+// Runs `generator` over the files named in `request.file_to_generate()`, all
+// of which must already have been built into `pool`.
+bool GenerateCodeFromPool(const CodeGeneratorRequest& request,
+                          const CodeGenerator& generator,
+                          const DescriptorPool& pool,
+                          CodeGeneratorResponse* response,
+                          std::string* error_msg) {
   std::vector<const FileDescriptor*> parsed_files;
   for (int i = 0; i < request.file_to_generate_size(); i++) {
     parsed_files.push_back(pool.FindFileByName(request.file_to_generate(i)));
@@ -169,9 +160,141 @@ bool GenerateCode(const CodeGeneratorRequest& request,
   return true;
 }
 
+// The descriptors held by a persistent plugin worker. Each file is built once
+// and reused by every later request, so a request only needs to carry the
+// files that earlier requests did not.
+class PersistentPool {
+ public:
+  explicit PersistentPool(FeatureSetDefaults defaults)
+      : defaults_(std::move(defaults)) {
+    Reset();
+  }
+
+  const DescriptorPool& pool() const { return *pool_; }
+
+  // Builds the files in `request.proto_file()` that are not already in the
+  // pool. Returns false if one of them fails to build.
+  bool AddFiles(const CodeGeneratorRequest& request, std::string* error_msg) {
+    std::vector<std::string> serialized(request.proto_file_size());
+    for (int i = 0; i < request.proto_file_size(); i++) {
+      request.proto_file(i).SerializeToString(&serialized[i]);
+    }
+
+    // A file that changed since it was built invalidates everything built on
+    // top of it, so start over rather than track dependents.
+    for (int i = 0; i < request.proto_file_size(); i++) {
+      auto it = built_.find(request.proto_file(i).name());
+      if (it != built_.end() && it->second != serialized[i]) {
+        Reset();
+        break;
+      }
+    }
+
+    for (int i = 0; i < request.proto_file_size(); i++) {
+      const FileDescriptorProto& proto = request.proto_file(i);
+      if (built_.contains(proto.name())) continue;
+      if (pool_->BuildFile(proto) == nullptr) {
+        // BuildFile() already logged the details.
+        *error_msg = absl::StrCat("failed to build descriptor for file: ",
+                                  proto.name());
+        return false;
+      }
+      built_.emplace(proto.name(), std::move(serialized[i]));
+    }
+    return true;
+  }
+
+ private:
+  void Reset() {
+    pool_ = std::make_unique<DescriptorPool>();
+    pool_->SetFeatureSetDefaults(defaults_);
+    built_.clear();
+  }
+
+  FeatureSetDefaults defaults_;
+  std::unique_ptr<DescriptorPool> pool_;
+  // Serialized form of every file in `pool_`, keyed by file name.
+  absl::flat_hash_map<std::string, std::string> built_;
+};
+
+// Serves length-delimited requests from stdin until it is closed, writing one
+// length-delimited response to stdout for each.
+int RunPersistentPlugin(const char* argv0, const CodeGenerator& generator) {
+  absl::StatusOr<FeatureSetDefaults> defaults =
+      generator.BuildFeatureSetDefaults();
+  if (!defaults.ok()) {
+    std::cerr << argv0 << ": error generating feature defaults: "
+              << defaults.status().message() << std::endl;
+    return 1;
+  }
+  PersistentPool pool(*std::move(defaults));
+
+  io::FileInputStream input(STDIN_FILENO);
+  io::FileOutputStream output(STDOUT_FILENO);
+  while (true) {
+    CodeGeneratorRequest request;
+    bool clean_eof = false;
+    if (!util::ParseDelimitedFromZeroCopyStream(&request, &input,
+                                                &clean_eof)) {
+      if (clean_eof) return 0;
+      std::cerr << argv0 << ": protoc sent unparseable request to plugin."
+                << std::endl;
+      return 1;
+    }
+
+    CodeGeneratorResponse response;
+    std::string error_msg;
+    if (!pool.AddFiles(request, &error_msg) ||
+        !GenerateCodeFromPool(request, generator, pool.pool(), &response,
+                              &error_msg)) {
+      // A single-shot plugin exits here; a worker reports the failure in the
+      // response instead so that it can keep serving.
+      response.Clear();
+      response.set_error(error_msg);
+    }
+
+    if (!util::SerializeDelimitedToZeroCopyStream(response, &output) ||
+        !output.Flush()) {
+      std::cerr << argv0 << ": Error writing to stdout." << std::endl;
+      return 1;
+    }
+  }
+}
+
+}  // namespace
+
+bool GenerateCode(const CodeGeneratorRequest& request,
+                  const CodeGenerator& generator,
+                  CodeGeneratorResponse* response, std::string* error_msg) {
+  DescriptorPool pool;
+
+  // Initialize feature set default mapping.
+  absl::StatusOr<FeatureSetDefaults> defaults =
+      generator.BuildFeatureSetDefaults();
+  if (!defaults.ok()) {
+    *error_msg = absl::StrCat("error generating feature defaults: ",
+                              defaults.status().message());
+    return false;
+  }
+  pool.SetFeatureSetDefaults(*defaults);
+
+  for (int i = 0; i < request.proto_file_size(); i++) {
+    const FileDescriptor* file = pool.BuildFile(request.proto_file(i));
+    if (file == nullptr) {
+      // BuildFile() already wrote an error message.
+      return false;
+    }
+  }
+
+  return GenerateCodeFromPool(request, generator, pool, response, error_msg);
+}
+
 int PluginMain(int argc, char* argv[], const CodeGenerator* generator) {
 
-  if (argc > 1) {
+  bool persistent = false;
+  if (argc == 2 && absl::string_view(argv[1]) == "--persistent") {
+    persistent = true;
+  } else if (argc > 1) {
     std::cerr << argv[0] << ": Unknown option: " << argv[1] << std::endl;
     return 1;
   }
@@ -181,6 +304,10 @@ int PluginMain(int argc, char* argv[], const CodeGenerator* generator) {
   setmode(STDOUT_FILENO, _O_BINARY);
 #endif
 
+  if (persistent) {
+    return RunPersistentPlugin(argv[0], *generator);
+  }
+
   CodeGeneratorRequest request;
   if (!request.ParseFromFileDescriptor(STDIN_FILENO)) {
     std::cerr << argv[0] << ": protoc sent unparseable request to plugin."
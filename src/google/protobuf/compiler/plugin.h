@@ -58,6 +58,16 @@
 //     protoc --plugin=protoc-gen-NAME=path/to/mybinary --NAME_out=OUT_DIR
 //   On Windows, make sure to include the .exe suffix:
 //     protoc --plugin=protoc-gen-NAME=path/to/mybinary.exe --NAME_out=OUT_DIR
+//
+// A build system that runs many protoc actions can instead keep a plugin alive
+// across them by starting it with the single argument --persistent. The plugin
+// then reads a sequence of CodeGeneratorRequests from stdin, each preceded by
+// its varint-encoded length, and answers each with a CodeGeneratorResponse
+// framed the same way, until stdin is closed. Descriptors sent in one request
+// stay available to later ones, so a request's proto_file only needs to hold
+// the files not sent before. Resending a file with different contents
+// discards everything the worker had built. In this mode, failures that would
+// make a one-shot plugin exit are reported through CodeGeneratorResponse.error.
 
 #ifndef GOOGLE_PROTOBUF_COMPILER_PLUGIN_H__
 #define GOOGLE_PROTOBUF_COMPILER_PLUGIN_H__
@@ -272,9 +272,19 @@ const ::_pbi::DescriptorTable descriptor_table_google_2fprotobuf_2fcompiler_2fpl
 PROTOBUF_ATTRIBUTE_WEAK const ::_pbi::DescriptorTable* descriptor_table_google_2fprotobuf_2fcompiler_2fplugin_2eproto_getter() {
   return &descriptor_table_google_2fprotobuf_2fcompiler_2fplugin_2eproto;
 }
+#if defined(PROTOBUF_DESCRIPTOR_TABLE_SECTION)
+// Registered on first access to the generated pool.
+PROTOBUF_DESCRIPTOR_TABLE_SECTION
+static const ::_pbi::DescriptorTable* const dynamic_init_dummy_google_2fprotobuf_2fcompiler_2fplugin_2eproto =
+    &descriptor_table_google_2fprotobuf_2fcompiler_2fplugin_2eproto;
+// Makes this binary or shared object report its section.
+__attribute__((used)) static const bool* const descriptor_table_section_dummy_google_2fprotobuf_2fcompiler_2fplugin_2eproto =
+    &::_pbi::DescriptorTableSection<>::registered;
+#else
 // Force running AddDescriptors() at dynamic initialization time.
 PROTOBUF_ATTRIBUTE_INIT_PRIORITY2
 static ::_pbi::AddDescriptorsRunner dynamic_init_dummy_google_2fprotobuf_2fcompiler_2fplugin_2eproto(&descriptor_table_google_2fprotobuf_2fcompiler_2fplugin_2eproto);
+#endif  // defined(PROTOBUF_DESCRIPTOR_TABLE_SECTION)
 namespace google {
 namespace protobuf {
 namespace compiler {
@@ -417,6 +427,7 @@ const ::_pbi::TcParseTable<2, 4, 0, 47, 2> Version::_table_ = {
     offsetof(decltype(_table_), field_names),  // no aux_entries
     &_Version_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     // optional string suffix = 4;
     {::_pbi::TcParser::FastSS1,
@@ -486,8 +497,10 @@ const ::_pbi::TcParseTable<2, 4, 0, 47, 2> Version::_table_ = {
   // optional string suffix = 4;
   if (cached_has_bits & 0x00000001u) {
     const std::string& _s = this->_internal_suffix();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.compiler.Version.suffix");
+    if (!_impl_.suffix_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.compiler.Version.suffix");
+    }
     target = stream->WriteStringMaybeAliased(4, _s, target);
   }
 
@@ -538,6 +551,20 @@ const ::_pbi::TcParseTable<2, 4, 0, 47, 2> Version::_table_ = {
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t Version::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(Version);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  if (!_impl_.suffix_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.suffix_.Get());
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData Version::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     Version::MergeImpl
@@ -741,6 +768,7 @@ const ::_pbi::TcParseTable<3, 5, 3, 79, 2> CodeGeneratorRequest::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_CodeGeneratorRequest_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // repeated string file_to_generate = 1;
@@ -807,8 +835,10 @@ const ::_pbi::TcParseTable<3, 5, 3, 79, 2> CodeGeneratorRequest::_table_ = {
   // optional string parameter = 2;
   if (cached_has_bits & 0x00000001u) {
     const std::string& _s = this->_internal_parameter();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.compiler.CodeGeneratorRequest.parameter");
+    if (!_impl_.parameter_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.compiler.CodeGeneratorRequest.parameter");
+    }
     target = stream->WriteStringMaybeAliased(2, _s, target);
   }
 
@@ -889,6 +919,26 @@ const ::_pbi::TcParseTable<3, 5, 3, 79, 2> CodeGeneratorRequest::_table_ = {
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t CodeGeneratorRequest::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(CodeGeneratorRequest);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  total_size += _impl_.file_to_generate_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.proto_file_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.source_file_descriptors_.SpaceUsedExcludingSelfLong();
+  if (!_impl_.parameter_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.parameter_.Get());
+  }
+  if (_impl_.compiler_version_ != nullptr) {
+    total_size += _impl_.compiler_version_->SpaceUsedLong();
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData CodeGeneratorRequest::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     CodeGeneratorRequest::MergeImpl
@@ -1118,6 +1168,7 @@ const ::_pbi::TcParseTable<2, 4, 1, 86, 2> CodeGeneratorResponse_File::_table_ =
     offsetof(decltype(_table_), aux_entries),
     &_CodeGeneratorResponse_File_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     // optional .google.protobuf.GeneratedCodeInfo generated_code_info = 16;
     {::_pbi::TcParser::FastMtS2,
@@ -1168,24 +1219,30 @@ const ::_pbi::TcParseTable<2, 4, 1, 86, 2> CodeGeneratorResponse_File::_table_ =
   // optional string name = 1;
   if (cached_has_bits & 0x00000001u) {
     const std::string& _s = this->_internal_name();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.compiler.CodeGeneratorResponse.File.name");
+    if (!_impl_.name_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.compiler.CodeGeneratorResponse.File.name");
+    }
     target = stream->WriteStringMaybeAliased(1, _s, target);
   }
 
   // optional string insertion_point = 2;
   if (cached_has_bits & 0x00000002u) {
     const std::string& _s = this->_internal_insertion_point();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.compiler.CodeGeneratorResponse.File.insertion_point");
+    if (!_impl_.insertion_point_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.compiler.CodeGeneratorResponse.File.insertion_point");
+    }
     target = stream->WriteStringMaybeAliased(2, _s, target);
   }
 
   // optional string content = 15;
   if (cached_has_bits & 0x00000004u) {
     const std::string& _s = this->_internal_content();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.compiler.CodeGeneratorResponse.File.content");
+    if (!_impl_.content_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.compiler.CodeGeneratorResponse.File.content");
+    }
     target = stream->WriteStringMaybeAliased(15, _s, target);
   }
 
@@ -1244,6 +1301,31 @@ const ::_pbi::TcParseTable<2, 4, 1, 86, 2> CodeGeneratorResponse_File::_table_ =
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t CodeGeneratorResponse_File::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(CodeGeneratorResponse_File);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  if (!_impl_.name_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.name_.Get());
+  }
+  if (!_impl_.insertion_point_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.insertion_point_.Get());
+  }
+  if (!_impl_.content_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.content_.Get());
+  }
+  if (_impl_.generated_code_info_ != nullptr) {
+    total_size += _impl_.generated_code_info_->SpaceUsedLong();
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData CodeGeneratorResponse_File::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     CodeGeneratorResponse_File::MergeImpl
@@ -1418,6 +1500,7 @@ const ::_pbi::TcParseTable<2, 3, 1, 60, 2> CodeGeneratorResponse::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_CodeGeneratorResponse_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // optional string error = 1;
@@ -1461,8 +1544,10 @@ const ::_pbi::TcParseTable<2, 3, 1, 60, 2> CodeGeneratorResponse::_table_ = {
   // optional string error = 1;
   if (cached_has_bits & 0x00000001u) {
     const std::string& _s = this->_internal_error();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.compiler.CodeGeneratorResponse.error");
+    if (!_impl_.error_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.compiler.CodeGeneratorResponse.error");
+    }
     target = stream->WriteStringMaybeAliased(1, _s, target);
   }
 
@@ -1522,6 +1607,21 @@ const ::_pbi::TcParseTable<2, 3, 1, 60, 2> CodeGeneratorResponse::_table_ = {
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t CodeGeneratorResponse::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(CodeGeneratorResponse);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  total_size += _impl_.file_.SpaceUsedExcludingSelfLong();
+  if (!_impl_.error_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.error_.Get());
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData CodeGeneratorResponse::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     CodeGeneratorResponse::MergeImpl
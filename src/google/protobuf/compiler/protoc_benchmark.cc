@@ -0,0 +1,434 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Benchmarks for the phases of protoc over a large synthetic schema:
+// tokenizing, parsing into FileDescriptorProtos, building descriptors, the
+// whole of Importer, and each of the cpp, java, python and rust generators.
+// Benchmarks are named BM_<Phase>/files:<N>, where N is the number of .proto
+// files in the schema; each file has a few dozen messages and imports one
+// other file.  The files are generated in memory, nothing touches the disk.
+//
+// Besides time, every benchmark reports the counter peak_heap, the most heap
+// memory the phase had live at once, in bytes, on top of what was live
+// before it.  Like protoc, the generator benchmarks keep all generated files
+// in memory until the end of the run, so their peak_heap includes them; they
+// also report the bytes of generated code per run as output_bytes.
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <map>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "google/protobuf/descriptor.pb.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/log/absl_check.h"
+#include "absl/log/absl_log.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/substitute.h"
+#include "google/protobuf/compiler/code_generator.h"
+#include "google/protobuf/compiler/cpp/generator.h"
+#include "google/protobuf/compiler/importer.h"
+#include "google/protobuf/compiler/java/generator.h"
+#include "google/protobuf/compiler/parser.h"
+#include "google/protobuf/compiler/python/generator.h"
+#include "google/protobuf/compiler/rust/generator.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/io/tokenizer.h"
+#include "google/protobuf/io/zero_copy_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+
+// Heap tracking.  Every allocation through the global operator new is
+// prefixed with its size, so that the bytes live, and their peak, are known
+// at any time.
+
+namespace {
+
+constexpr size_t kHeader = alignof(std::max_align_t);
+
+std::atomic<size_t> live_bytes{0};
+std::atomic<size_t> peak_bytes{0};
+
+void* TrackedAlloc(size_t size) {
+  void* p = std::malloc(size + kHeader);
+  if (p == nullptr) return nullptr;
+  *static_cast<size_t*>(p) = size;
+  size_t live = live_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+  size_t peak = peak_bytes.load(std::memory_order_relaxed);
+  while (live > peak && !peak_bytes.compare_exchange_weak(
+                            peak, live, std::memory_order_relaxed)) {
+  }
+  return static_cast<char*>(p) + kHeader;
+}
+
+void TrackedFree(void* p) {
+  if (p == nullptr) return;
+  void* base = static_cast<char*>(p) - kHeader;
+  live_bytes.fetch_sub(*static_cast<size_t*>(base), std::memory_order_relaxed);
+  std::free(base);
+}
+
+void* TrackedAllocOrThrow(size_t size) {
+  void* p = TrackedAlloc(size);
+  if (p == nullptr) throw std::bad_alloc();
+  return p;
+}
+
+}  // namespace
+
+void* operator new(size_t size) { return TrackedAllocOrThrow(size); }
+void* operator new[](size_t size) { return TrackedAllocOrThrow(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  return TrackedAlloc(size);
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  return TrackedAlloc(size);
+}
+void operator delete(void* p) noexcept { TrackedFree(p); }
+void operator delete[](void* p) noexcept { TrackedFree(p); }
+void operator delete(void* p, size_t) noexcept { TrackedFree(p); }
+void operator delete[](void* p, size_t) noexcept { TrackedFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+  TrackedFree(p);
+}
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+  TrackedFree(p);
+}
+
+namespace google {
+namespace protobuf {
+namespace compiler {
+namespace {
+
+// Measures the peak heap usage from its construction on.
+class HeapPeak {
+ public:
+  HeapPeak() : base_(live_bytes.load(std::memory_order_relaxed)) {
+    peak_bytes.store(base_, std::memory_order_relaxed);
+  }
+
+  void Report(benchmark::State& state) const {
+    state.counters["peak_heap"] = static_cast<double>(
+        peak_bytes.load(std::memory_order_relaxed) - base_);
+  }
+
+ private:
+  const size_t base_;
+};
+
+// The synthetic schema.
+
+constexpr int kMessagesPerFile = 24;
+constexpr int kFieldsPerMessage = 16;
+
+std::string FileName(int i) { return absl::StrCat("bench/file", i, ".proto"); }
+
+// File `i` imports file (i - 1) / 2, so the files form a balanced tree with
+// file 0 at its root.  Fields cycle through scalars, strings, enums, messages
+// of the same and the imported file, repeated fields, maps and oneofs.
+std::string SyntheticFile(int i) {
+  const int parent = (i - 1) / 2;
+  std::string out = absl::Substitute(
+      "syntax = \"proto3\";\n\npackage bench.f$0;\n\n", i);
+  if (i > 0) {
+    absl::SubstituteAndAppend(&out, "import \"$0\";\n\n", FileName(parent));
+  }
+  absl::SubstituteAndAppend(
+      &out, "option java_package = \"com.bench.f$0\";\n\n", i);
+  absl::SubstituteAndAppend(
+      &out, "// Kinds of things in file $0.\nenum Kind {\n", i);
+  for (int v = 0; v < 8; ++v) {
+    absl::SubstituteAndAppend(&out, "  KIND_$0 = $0;\n", v);
+  }
+  out += "}\n";
+  for (int m = 0; m < kMessagesPerFile; ++m) {
+    absl::SubstituteAndAppend(
+        &out, "\n// Message $0 of file $1.\nmessage M$0 {\n", m, i);
+    for (int f = 1; f <= kFieldsPerMessage; ++f) {
+      // A comment for every other field, to give the tokenizer some.
+      if (f % 2 == 0) {
+        absl::SubstituteAndAppend(&out, "  // Field $0 of M$1.\n", f, m);
+      }
+      switch ((f + m) % 10) {
+        case 0:
+          absl::SubstituteAndAppend(&out, "  int32 i32_$0 = $0;\n", f);
+          break;
+        case 1:
+          absl::SubstituteAndAppend(&out, "  optional int64 i64_$0 = $0;\n", f);
+          break;
+        case 2:
+          absl::SubstituteAndAppend(&out, "  string str_$0 = $0;\n", f);
+          break;
+        case 3:
+          absl::SubstituteAndAppend(&out, "  repeated double dbl_$0 = $0;\n",
+                                    f);
+          break;
+        case 4:
+          absl::SubstituteAndAppend(&out, "  Kind kind_$0 = $0;\n", f);
+          break;
+        case 5:
+          absl::SubstituteAndAppend(&out, "  M$1 msg_$0 = $0;\n", f, m / 2);
+          break;
+        case 6:
+          if (i > 0) {
+            absl::SubstituteAndAppend(&out, "  bench.f$1.M$2 ext_$0 = $0;\n",
+                                      f, parent, m);
+          } else {
+            absl::SubstituteAndAppend(&out, "  bytes ext_$0 = $0;\n", f);
+          }
+          break;
+        case 7:
+          absl::SubstituteAndAppend(&out, "  repeated string strs_$0 = $0;\n",
+                                    f);
+          break;
+        case 8:
+          absl::SubstituteAndAppend(&out, "  map<string, M$1> map_$0 = $0;\n",
+                                    f, m / 2);
+          break;
+        case 9:
+          absl::SubstituteAndAppend(
+              &out, "  oneof choice_$0 {\n    bool flag_$0 = $0;\n  }\n", f);
+          break;
+      }
+    }
+    out += "}\n";
+  }
+  absl::SubstituteAndAppend(&out,
+                            "\nservice Service {\n"
+                            "  rpc Get(M0) returns (M1);\n"
+                            "  rpc List(M2) returns (stream M3);\n"
+                            "}\n");
+  return out;
+}
+
+class SyntheticSourceTree : public SourceTree {
+ public:
+  explicit SyntheticSourceTree(int num_files) {
+    for (int i = 0; i < num_files; ++i) {
+      std::string file = SyntheticFile(i);
+      total_bytes_ += file.size();
+      files_.emplace(FileName(i), std::move(file));
+    }
+  }
+
+  io::ZeroCopyInputStream* Open(absl::string_view filename) override {
+    auto it = files_.find(filename);
+    if (it == files_.end()) return nullptr;
+    return new io::ArrayInputStream(it->second.data(),
+                                    static_cast<int>(it->second.size()));
+  }
+
+  absl::string_view Contents(int i) const { return files_.at(FileName(i)); }
+  size_t total_bytes() const { return total_bytes_; }
+
+ private:
+  absl::flat_hash_map<std::string, std::string> files_;
+  size_t total_bytes_ = 0;
+};
+
+class FailingErrorCollector : public MultiFileErrorCollector,
+                              public io::ErrorCollector {
+ public:
+  void RecordError(absl::string_view filename, int line, int column,
+                   absl::string_view message) override {
+    ABSL_LOG(FATAL) << filename << ":" << line << ":" << column << ": "
+                    << message;
+  }
+  void RecordError(int line, io::ColumnNumber column,
+                   absl::string_view message) override {
+    RecordError("", line, column, message);
+  }
+};
+
+// Keeps the generated files in memory, and counts their size.
+class InMemoryContext : public GeneratorContext {
+ public:
+  explicit InMemoryContext(std::vector<const FileDescriptor*> files)
+      : files_(std::move(files)) {}
+
+  io::ZeroCopyOutputStream* Open(const std::string& filename) override {
+    return new io::StringOutputStream(&outputs_[filename]);
+  }
+
+  void ListParsedFiles(std::vector<const FileDescriptor*>* output) override {
+    *output = files_;
+  }
+
+  size_t output_bytes() const {
+    size_t bytes = 0;
+    for (const auto& output : outputs_) bytes += output.second.size();
+    return bytes;
+  }
+
+ private:
+  std::vector<const FileDescriptor*> files_;
+  // Node-based, so that the streams' strings stay put.
+  std::map<std::string, std::string> outputs_;
+};
+
+void BM_Tokenize(benchmark::State& state) {
+  const int num_files = static_cast<int>(state.range(0));
+  SyntheticSourceTree tree(num_files);
+  FailingErrorCollector errors;
+  HeapPeak heap;
+  size_t tokens = 0;
+  for (auto _ : state) {
+    for (int i = 0; i < num_files; ++i) {
+      absl::string_view contents = tree.Contents(i);
+      io::ArrayInputStream input(contents.data(),
+                                 static_cast<int>(contents.size()));
+      io::Tokenizer tokenizer(&input, &errors);
+      while (tokenizer.Next()) ++tokens;
+    }
+  }
+  heap.Report(state);
+  state.SetBytesProcessed(state.iterations() * tree.total_bytes());
+  state.SetItemsProcessed(tokens);
+}
+BENCHMARK(BM_Tokenize)->ArgName("files")->Arg(16)->Arg(256);
+
+std::vector<FileDescriptorProto> ParseAll(const SyntheticSourceTree& tree,
+                                          int num_files) {
+  FailingErrorCollector errors;
+  std::vector<FileDescriptorProto> protos(num_files);
+  for (int i = 0; i < num_files; ++i) {
+    absl::string_view contents = tree.Contents(i);
+    io::ArrayInputStream input(contents.data(),
+                               static_cast<int>(contents.size()));
+    io::Tokenizer tokenizer(&input, &errors);
+    Parser parser;
+    parser.RecordErrorsTo(&errors);
+    ABSL_CHECK(parser.Parse(&tokenizer, &protos[i]));
+    protos[i].set_name(FileName(i));
+  }
+  return protos;
+}
+
+void BM_Parse(benchmark::State& state) {
+  const int num_files = static_cast<int>(state.range(0));
+  SyntheticSourceTree tree(num_files);
+  HeapPeak heap;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ParseAll(tree, num_files));
+  }
+  heap.Report(state);
+  state.SetBytesProcessed(state.iterations() * tree.total_bytes());
+}
+BENCHMARK(BM_Parse)->ArgName("files")->Arg(16)->Arg(256);
+
+void BM_BuildDescriptors(benchmark::State& state) {
+  const int num_files = static_cast<int>(state.range(0));
+  SyntheticSourceTree tree(num_files);
+  std::vector<FileDescriptorProto> protos = ParseAll(tree, num_files);
+  HeapPeak heap;
+  for (auto _ : state) {
+    DescriptorPool pool;
+    // Parents come first, so every import is built before it is used.
+    for (const FileDescriptorProto& proto : protos) {
+      ABSL_CHECK(pool.BuildFile(proto) != nullptr);
+    }
+  }
+  heap.Report(state);
+  state.SetBytesProcessed(state.iterations() * tree.total_bytes());
+}
+BENCHMARK(BM_BuildDescriptors)->ArgName("files")->Arg(16)->Arg(256);
+
+void BM_Import(benchmark::State& state) {
+  const int num_files = static_cast<int>(state.range(0));
+  SyntheticSourceTree tree(num_files);
+  FailingErrorCollector errors;
+  HeapPeak heap;
+  for (auto _ : state) {
+    Importer importer(&tree, &errors);
+    for (int i = num_files - 1; i >= 0; --i) {
+      ABSL_CHECK(importer.Import(FileName(i)) != nullptr);
+    }
+  }
+  heap.Report(state);
+  state.SetBytesProcessed(state.iterations() * tree.total_bytes());
+}
+BENCHMARK(BM_Import)->ArgName("files")->Arg(16)->Arg(256);
+
+template <typename Generator>
+void BM_Generate(benchmark::State& state, absl::string_view parameter) {
+  const int num_files = static_cast<int>(state.range(0));
+  SyntheticSourceTree tree(num_files);
+  FailingErrorCollector errors;
+  Importer importer(&tree, &errors);
+  std::vector<const FileDescriptor*> files;
+  for (int i = 0; i < num_files; ++i) {
+    files.push_back(importer.Import(FileName(i)));
+    ABSL_CHECK(files.back() != nullptr);
+  }
+  Generator generator;
+  size_t output_bytes = 0;
+  HeapPeak heap;
+  for (auto _ : state) {
+    InMemoryContext context(files);
+    std::string error;
+    ABSL_CHECK(generator.GenerateAll(files, std::string(parameter), &context,
+                                     &error))
+        << error;
+    output_bytes = context.output_bytes();
+  }
+  heap.Report(state);
+  state.SetBytesProcessed(state.iterations() * tree.total_bytes());
+  state.counters["output_bytes"] = static_cast<double>(output_bytes);
+}
+void BM_GenerateCpp(benchmark::State& state) {
+  BM_Generate<cpp::CppGenerator>(state, "");
+}
+void BM_GenerateJava(benchmark::State& state) {
+  BM_Generate<java::JavaGenerator>(state, "");
+}
+void BM_GeneratePython(benchmark::State& state) {
+  BM_Generate<python::Generator>(state, "");
+}
+void BM_GenerateRust(benchmark::State& state) {
+  BM_Generate<rust::RustGenerator>(state,
+                                  "kernel=cpp,experimental-codegen=enabled");
+}
+BENCHMARK(BM_GenerateCpp)->ArgName("files")->Arg(16)->Arg(256);
+BENCHMARK(BM_GenerateJava)->ArgName("files")->Arg(16)->Arg(256);
+BENCHMARK(BM_GeneratePython)->ArgName("files")->Arg(16)->Arg(256);
+BENCHMARK(BM_GenerateRust)->ArgName("files")->Arg(16)->Arg(256);
+
+}  // namespace
+}  // namespace compiler
+}  // namespace protobuf
+}  // namespace google
+
+BENCHMARK_MAIN();
@@ -103,10 +103,8 @@ void MessageDeserialize(Context<Descriptor> msg) {
           },
           R"rs(
           let success = unsafe {
-            let data = $pbr$::SerializedData::from_raw_parts(
-              $NonNull$::new(data.as_ptr() as *mut _).unwrap(),
-              data.len(),
-            );
+            // The C++ side only borrows the input for the duration of the call.
+            let data = $pbi$::PtrAndLen { ptr: data.as_ptr(), len: data.len() };
 
             $deserialize_thunk$(self.inner.msg, data)
           };
@@ -152,7 +150,10 @@ void MessageExterns(Context<Descriptor> msg) {
           fn $new_thunk$() -> $pbi$::RawMessage;
           fn $delete_thunk$(raw_msg: $pbi$::RawMessage);
           fn $serialize_thunk$(raw_msg: $pbi$::RawMessage) -> $pbr$::SerializedData;
-          fn $deserialize_thunk$(raw_msg: $pbi$::RawMessage, data: $pbr$::SerializedData) -> bool;
+          fn $deserialize_thunk$(
+              raw_msg: $pbi$::RawMessage,
+              data: $pbi$::PtrAndLen,
+          ) -> bool;
         )rs");
       return;
 
@@ -174,6 +175,35 @@ void MessageExterns(Context<Descriptor> msg) {
   ABSL_LOG(FATAL) << "unreachable";
 }
 
+void MessageParseIn(Context<Descriptor> msg) {
+  switch (msg.opts().kernel) {
+    case Kernel::kCpp:
+      // The C++ kernel has no user-visible arena, so each message is parsed on
+      // its own.
+      msg.Emit(R"rs(
+        let _ = arena;
+        let mut msg = Self::new();
+        msg.deserialize(data).map(|_| msg)
+      )rs");
+      return;
+
+    case Kernel::kUpb:
+      msg.Emit({{"deserialize_thunk", Thunk(msg, "parse")}}, R"rs(
+        let arena = arena.share();
+        let msg = unsafe {
+          $deserialize_thunk$(data.as_ptr(), data.len(), arena.raw())
+        };
+        // A failed parse may leave some garbage in the shared arena, which is
+        // reclaimed along with it.
+        msg.map(|msg| Self { inner: $pbr$::MessageInner { msg, arena } })
+           .ok_or($pb$::ParseError)
+      )rs");
+      return;
+  }
+
+  ABSL_LOG(FATAL) << "unreachable";
+}
+
 void MessageDrop(Context<Descriptor> msg) {
   if (msg.is_upb()) {
     // Nothing to do here; drop glue (which will run drop(self.arena)
@@ -198,6 +228,7 @@ void GenerateRs(Context<Descriptor> msg) {
           {"Msg::new", [&] { MessageNew(msg); }},
           {"Msg::serialize", [&] { MessageSerialize(msg); }},
           {"Msg::deserialize", [&] { MessageDeserialize(msg); }},
+          {"Msg::parse_in", [&] { MessageParseIn(msg); }},
           {"Msg::drop", [&] { MessageDrop(msg); }},
           {"Msg_externs", [&] { MessageExterns(msg); }},
           {"accessor_fns",
@@ -363,6 +394,26 @@ void GenerateRs(Context<Descriptor> msg) {
             $Msg::deserialize$
           }
 
+          /// Parses `data` into a new message that allocates from `arena`.
+          ///
+          /// Parsing many messages into one arena is cheaper than giving each
+          /// its own; the arena's memory is kept alive by every message that
+          /// uses it.
+          pub fn parse_in(
+              data: &[u8],
+              arena: &$pbr$::Arena,
+          ) -> Result<Self, $pb$::ParseError> {
+            $Msg::parse_in$
+          }
+
+          /// Parses a stream of varint length-prefixed messages, all of which
+          /// allocate from `arena`.
+          pub fn parse_delimited_in<'a>(data: &'a [u8], arena: &'a $pbr$::Arena)
+            -> impl Iterator<Item = Result<Self, $pb$::ParseError>> + 'a {
+            $pb$::DelimitedRecords::new(data)
+                .map(move |r| Self::parse_in(r?, arena))
+          }
+
           $accessor_fns$
 
           $oneof_accessor_fns$
@@ -449,9 +500,10 @@ void GenerateThunksCc(Context<Descriptor> msg) {
         google::protobuf::rust_internal::SerializedData $serialize_thunk$($QualifiedMsg$* msg) {
           return google::protobuf::rust_internal::SerializeMsg(msg);
         }
-        bool $deserialize_thunk$($QualifiedMsg$* msg,
-                                 google::protobuf::rust_internal::SerializedData data) {
-          return msg->ParseFromArray(data.data, data.len);
+        bool $deserialize_thunk$(
+            $QualifiedMsg$* msg,
+            google::protobuf::rust_internal::PtrAndLen data) {
+          return msg->ParseFromArray(data.ptr, data.len);
         }
 
         $accessor_thunks$
@@ -222,6 +222,7 @@ const ::_pbi::TcParseTable<1, 2, 1, 0, 2> CppFeatures::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_CppFeatures_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     // optional .pb.CppFeatures.Utf8Validation utf8_validation = 2 [retention = RETENTION_RUNTIME, targets = TARGET_TYPE_FIELD, targets = TARGET_TYPE_FILE, edition_defaults = {
     {::_pbi::TcParser::FastEr0S1,
@@ -300,6 +301,16 @@ const ::_pbi::TcParseTable<1, 2, 1, 0, 2> CppFeatures::_table_ = {
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t CppFeatures::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(CppFeatures);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData CppFeatures::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     CppFeatures::MergeImpl
@@ -317,11 +328,19 @@ void CppFeatures::MergeImpl(::google::protobuf::Message& to_msg, const ::google:
 
   cached_has_bits = from._impl_._has_bits_[0];
   if (cached_has_bits & 0x00000003u) {
-    if (cached_has_bits & 0x00000001u) {
-      _this->_impl_.legacy_closed_enum_ = from._impl_.legacy_closed_enum_;
-    }
-    if (cached_has_bits & 0x00000002u) {
-      _this->_impl_.utf8_validation_ = from._impl_.utf8_validation_;
+    if ((cached_has_bits & 0x00000003u) == 0x00000003u) {
+      ::memcpy(&_this->_impl_.legacy_closed_enum_, &from._impl_.legacy_closed_enum_,
+               static_cast<::size_t>(
+                   reinterpret_cast<const char*>(&from._impl_.utf8_validation_) -
+                   reinterpret_cast<const char*>(&from._impl_.legacy_closed_enum_)) +
+                   sizeof(from._impl_.utf8_validation_));
+    } else {
+      if (cached_has_bits & 0x00000001u) {
+        _this->_impl_.legacy_closed_enum_ = from._impl_.legacy_closed_enum_;
+      }
+      if (cached_has_bits & 0x00000002u) {
+        _this->_impl_.utf8_validation_ = from._impl_.utf8_validation_;
+      }
     }
     _this->_impl_._has_bits_[0] |= cached_has_bits;
   }
@@ -207,6 +207,7 @@ class PROTOBUF_EXPORT CppFeatures final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -316,6 +317,7 @@ PROTOBUF_EXPORT extern ::google::protobuf::internal::ExtensionIdentifier< ::goog
     ::google::protobuf::internal::MessageTypeTraits< ::pb::CppFeatures >, 11, false >
   cpp;
 
+
 // ===================================================================
 
 
@@ -36,6 +36,8 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <cstdint>
 #include <cstdlib>
 #include <functional>
 #include <iterator>
@@ -43,6 +45,7 @@
 #include <memory>
 #include <sstream>
 #include <string>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -54,6 +57,7 @@
 #include "absl/container/btree_map.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/container/node_hash_set.h"
 #include "absl/functional/function_ref.h"
 #include "absl/hash/hash.h"
 #include "absl/log/absl_check.h"
@@ -73,6 +77,7 @@
 #include "absl/synchronization/mutex.h"
 #include "absl/types/optional.h"
 #include "google/protobuf/any.h"
+#include "google/protobuf/arena.h"
 #include "google/protobuf/cpp_features.pb.h"
 #include "google/protobuf/descriptor.pb.h"
 #include "google/protobuf/descriptor_database.h"
@@ -80,6 +85,7 @@
 #include "google/protobuf/descriptor_visitor.h"
 #include "google/protobuf/dynamic_message.h"
 #include "google/protobuf/feature_resolver.h"
+#include "google/protobuf/generated_message_reflection.h"
 #include "google/protobuf/generated_message_util.h"
 #include "google/protobuf/io/strtod.h"
 #include "google/protobuf/io/tokenizer.h"
@@ -443,8 +449,8 @@ class FlatAllocatorImpl {
           // Case 1: they are all the same.
           return PlanArray<std::string>(2);
         case FieldNameCase::kSnakeCase:
-          // Case 2: name==lower, camel==json
-          return PlanArray<std::string>(3);
+          // Case 2: name==lower, camel==json, which is derived on first use.
+          return PlanArray<std::string>(2);
         default:
           break;
       }
@@ -467,6 +473,9 @@ class FlatAllocatorImpl {
   }
 
   struct FieldNamesResult {
+    // The index of names that are not stored but derived on first use.
+    static constexpr int kDerived = -1;
+
     const std::string* array;
     int lowercase_index;
     int camelcase_index;
@@ -487,10 +496,9 @@ class FlatAllocatorImpl {
           // Case 1: they are all the same.
           return {AllocateStrings(name, std::move(full_name)), 0, 0, 0};
         case FieldNameCase::kSnakeCase:
-          // Case 2: name==lower, camel==json
-          return {AllocateStrings(name, std::move(full_name),
-                                  ToCamelCase(name, /* lower_first = */ true)),
-                  0, 2, 2};
+          // Case 2: name==lower, camel==json, which is derived on first use.
+          return {AllocateStrings(name, std::move(full_name)), 0,
+                  FieldNamesResult::kDerived, FieldNamesResult::kDerived};
         default:
           break;
       }
@@ -1295,6 +1303,9 @@ class FileDescriptorTables {
       const void* parent, absl::string_view lowercase_name) const;
   inline const FieldDescriptor* FindFieldByCamelcaseName(
       const void* parent, absl::string_view camelcase_name) const;
+  // Returns the camelcase name of a field of this file that does not store
+  // it.
+  const std::string& DerivedCamelcaseName(const FieldDescriptor* field) const;
   inline const EnumValueDescriptor* FindEnumValueByNumber(
       const EnumDescriptor* parent, int number) const;
   // This creates a new EnumValueDescriptor if not found, in a thread-safe way.
@@ -1335,6 +1346,7 @@ class FileDescriptorTables {
   static void FieldsByCamelcaseNamesLazyInitStatic(
       const FileDescriptorTables* tables);
   void FieldsByCamelcaseNamesLazyInitInternal() const;
+  void DerivedCamelcaseNamesLazyInitInternal() const;
 
   SymbolsByParentSet symbols_by_parent_;
   mutable absl::once_flag fields_by_lowercase_name_once_;
@@ -1344,6 +1356,13 @@ class FileDescriptorTables {
   // change anymore.
   mutable std::atomic<const FieldsByNameMap*> fields_by_lowercase_name_{};
   mutable std::atomic<const FieldsByNameMap*> fields_by_camelcase_name_{};
+  // Camelcase names of the fields that do not store them, built for the whole
+  // file on first request.  They are interned, since the same names tend to
+  // recur across the messages of a file.
+  mutable absl::once_flag derived_camelcase_names_once_;
+  mutable absl::node_hash_set<std::string> derived_camelcase_names_;
+  mutable absl::flat_hash_map<const FieldDescriptor*, const std::string*>
+      derived_camelcase_name_by_field_;
   FieldsByNumberSet fields_by_number_;  // Not including extensions.
   EnumValuesByNumberSet enum_values_by_number_;
   mutable EnumValuesByNumberSet unknown_enum_values_by_number_
@@ -1439,6 +1458,10 @@ class DescriptorPool::Tables {
   // Not used when fallback_database_ == nullptr.
   absl::flat_hash_set<std::string> known_bad_files_;
 
+  // Identifies these tables in the per-thread symbol caches.  Ids are never
+  // reused, so entries left behind by a destroyed pool can never match.
+  const uint64_t id_ = NextId();
+
   // A set of symbols which we have tried to load from the fallback database
   // and encountered errors. We will not attempt to load them again during
   // execution of the current public API call, but for compatibility with
@@ -1455,9 +1478,30 @@ class DescriptorPool::Tables {
   // so the overhead is small.
   absl::flat_hash_map<std::string, Descriptor::WellKnownType> well_known_types_;
 
+  // Merged feature sets resolved in this pool, interned by their serialized
+  // contents so that all descriptors with the same resolved features share one
+  // FeatureSet.  merged_features_cache_ maps the inputs of a merge (edition,
+  // parent features, serialized local overrides) to its interned result, so
+  // repeated merges skip FeatureResolver::MergeFeatures() altogether.  Parents
+  // are always interned or static feature sets, so entries stay valid even
+  // when the build that created them is rolled back.
+  absl::flat_hash_map<std::string, std::unique_ptr<FeatureSet>>
+      interned_features_;
+  absl::flat_hash_map<std::tuple<std::string, const FeatureSet*, std::string>,
+                      const FeatureSet*>
+      merged_features_cache_;
+
+  // Returns the interned copy of `features`, adding it if needed.
+  const FeatureSet* InternFeatures(FeatureSet&& features);
+
   // -----------------------------------------------------------------
   // Finding items.
 
+  static uint64_t NextId() {
+    static std::atomic<uint64_t> next_id{1};
+    return next_id.fetch_add(1, std::memory_order_relaxed);
+  }
+
   // Find symbols.  This returns a null Symbol (symbol.IsNull() is true)
   // if not found.
   inline Symbol FindSymbol(absl::string_view key) const;
@@ -1578,6 +1622,16 @@ DescriptorPool::Tables::Tables() {
 
 DescriptorPool::Tables::~Tables() { ABSL_DCHECK(checkpoints_.empty()); }
 
+const FeatureSet* DescriptorPool::Tables::InternFeatures(
+    FeatureSet&& features) {
+  std::unique_ptr<FeatureSet>& interned =
+      interned_features_[features.SerializeAsString()];
+  if (interned == nullptr) {
+    interned = absl::make_unique<FeatureSet>(std::move(features));
+  }
+  return interned.get();
+}
+
 FileDescriptorTables::FileDescriptorTables() {}
 
 FileDescriptorTables::~FileDescriptorTables() {
@@ -1648,14 +1702,61 @@ inline Symbol FileDescriptorTables::FindNestedSymbol(
   return it == symbols_by_parent_.end() ? Symbol() : *it;
 }
 
+namespace {
+
+// Pools with a fallback database lock their tables on every lookup.  Symbols
+// that a thread found before are served from its own small direct-mapped
+// cache instead, so repeated lookups of built types never touch the mutex.
+// Once a lookup has returned a symbol it lives as long as its pool, and
+// entries are keyed by the never reused id of the pool's tables, so they can
+// not go stale.
+class ThreadSymbolCache {
+ public:
+  static Symbol Find(uint64_t tables_id, absl::string_view name, size_t hash) {
+    const Entry& entry = entries()[hash % kSize];
+    if (entry.tables_id == tables_id && entry.symbol.full_name() == name) {
+      return entry.symbol;
+    }
+    return Symbol();
+  }
+
+  static void Insert(uint64_t tables_id, size_t hash, Symbol symbol) {
+    entries()[hash % kSize] = {tables_id, symbol};
+  }
+
+ private:
+  struct Entry {
+    uint64_t tables_id = 0;
+    Symbol symbol;
+  };
+  static constexpr size_t kSize = 256;
+
+  static Entry* entries() {
+    static thread_local Entry entries[kSize];
+    return entries;
+  }
+};
+
+}  // namespace
+
 Symbol DescriptorPool::Tables::FindByNameHelper(const DescriptorPool* pool,
                                                 absl::string_view name) {
+  size_t hash = 0;
   if (pool->mutex_ != nullptr) {
+    hash = absl::HashOf(name);
+    Symbol result = ThreadSymbolCache::Find(id_, name, hash);
+    if (!result.IsNull()) return result;
+
     // Fast path: the Symbol is already cached.  This is just a hash lookup.
     absl::ReaderMutexLock lock(pool->mutex_);
     if (known_bad_symbols_.empty() && known_bad_files_.empty()) {
-      Symbol result = FindSymbol(name);
-      if (!result.IsNull()) return result;
+      result = FindSymbol(name);
+      if (!result.IsNull()) {
+        if (checkpoints_.empty()) {
+          ThreadSymbolCache::Insert(id_, hash, result);
+        }
+        return result;
+      }
     }
   }
   absl::MutexLockMaybe lock(pool->mutex_);
@@ -1677,6 +1778,9 @@ Symbol DescriptorPool::Tables::FindByNameHelper(const DescriptorPool* pool,
     }
   }
 
+  if (pool->mutex_ != nullptr && !result.IsNull() && checkpoints_.empty()) {
+    ThreadSymbolCache::Insert(id_, hash, result);
+  }
   return result;
 }
 
@@ -1687,13 +1791,57 @@ inline const FileDescriptor* DescriptorPool::Tables::FindFile(
   return *it;
 }
 
+namespace {
+
+// Size of the name part of Descriptor::field_lookup_.  Each field is entered
+// under its name and, if different, its lowercase name, so keeping the table
+// at four slots per field keeps it at most half full.  Returns 0 when the
+// fields don't fit in 16-bit indices.
+int FieldNameTableSize(int field_count) {
+  if (field_count == 0 ||
+      field_count >= std::numeric_limits<uint16_t>::max() / 4) {
+    return 0;
+  }
+  int size = 4;
+  while (size < 4 * field_count) size *= 2;
+  return size;
+}
+
+// Returns the highest field number in `proto` if its fields should also be
+// looked up through a dense table by number, or 0 if not.  That is the case
+// when the numbers aren't already covered by the sequential range, but are
+// still compact enough that the table is at most twice the number of fields.
+int DenseFieldNumberLimit(const DescriptorProto& proto) {
+  if (FieldNameTableSize(proto.field_size()) == 0) return 0;
+  int max_number = 0;
+  bool sequential = true;
+  for (int i = 0; i < proto.field_size(); ++i) {
+    int number = proto.field(i).number();
+    if (number < 1) return 0;
+    sequential = sequential && number == i + 1;
+    max_number = std::max(max_number, number);
+  }
+  if (sequential || max_number > 2 * proto.field_size()) return 0;
+  return max_number;
+}
+
+size_t FieldLookupSize(const DescriptorProto& proto) {
+  return DenseFieldNumberLimit(proto) + FieldNameTableSize(proto.field_size());
+}
+
+}  // namespace
+
 inline const FieldDescriptor* FileDescriptorTables::FindFieldByNumber(
     const Descriptor* parent, int number) const {
   // If `number` is within the sequential range, just index into the parent
   // without doing a table lookup.
   if (parent != nullptr &&  //
       1 <= number && number <= parent->sequential_field_limit_) {
-    return parent->field(number - 1);
+    if (!parent->has_dense_field_numbers_) return parent->field(number - 1);
+    if (uint16_t index = parent->field_lookup_[number - 1]) {
+      return parent->field(index - 1);
+    }
+    // Numbers missing from the dense table may still belong to extensions.
   }
 
   auto it = fields_by_number_.find(ParentNumberQuery{{parent, number}});
@@ -1741,6 +1889,32 @@ inline const FieldDescriptor* FileDescriptorTables::FindFieldByLowercaseName(
   return it->second;
 }
 
+void FileDescriptorTables::DerivedCamelcaseNamesLazyInitInternal() const {
+  for (Symbol symbol : symbols_by_parent_) {
+    const FieldDescriptor* field = symbol.field_descriptor();
+    if (field == nullptr ||
+        field->camelcase_name_index_ != FieldDescriptor::kDerivedNameIndex) {
+      continue;
+    }
+    const std::string& name =
+        *derived_camelcase_names_
+             .insert(ToCamelCase(field->name(), /* lower_first = */ true))
+             .first;
+    derived_camelcase_name_by_field_[field] = &name;
+  }
+}
+
+const std::string& FileDescriptorTables::DerivedCamelcaseName(
+    const FieldDescriptor* field) const {
+  absl::call_once(derived_camelcase_names_once_, [this] {
+    DerivedCamelcaseNamesLazyInitInternal();
+  });
+  auto it = derived_camelcase_name_by_field_.find(field);
+  ABSL_CHECK(it != derived_camelcase_name_by_field_.end())
+      << "Field " << field->full_name() << " is not in its file's tables.";
+  return *it->second;
+}
+
 void FileDescriptorTables::FieldsByCamelcaseNamesLazyInitStatic(
     const FileDescriptorTables* tables) {
   tables->FieldsByCamelcaseNamesLazyInitInternal();
@@ -1898,15 +2072,24 @@ void FileDescriptorTables::FinalizeTables() {}
 
 bool FileDescriptorTables::AddFieldByNumber(FieldDescriptor* field) {
   // Skip fields that are at the start of the sequence.
-  if (field->containing_type() != nullptr && field->number() >= 1 &&
-      field->number() <= field->containing_type()->sequential_field_limit_) {
-    if (field->is_extension()) {
-      // Conflicts with the field that already exists in the sequential range.
-      return false;
+  const Descriptor* parent = field->containing_type();
+  if (parent != nullptr && field->number() >= 1 &&
+      field->number() <= parent->sequential_field_limit_) {
+    if (!parent->has_dense_field_numbers_) {
+      if (field->is_extension()) {
+        // Conflicts with the field that already exists in the sequential
+        // range.
+        return false;
+      }
+      // Only return true if the field at that index matches. Otherwise it
+      // conflicts with the existing field in the sequential range.
+      return parent->field(field->number() - 1) == field;
+    }
+    // Likewise for the dense table, except that numbers missing from it go
+    // to the map below.
+    if (uint16_t index = parent->field_lookup_[field->number() - 1]) {
+      return !field->is_extension() && parent->field(index - 1) == field;
     }
-    // Only return true if the field at that index matches. Otherwise it
-    // conflicts with the existing field in the sequential range.
-    return field->containing_type()->field(field->number() - 1) == field;
   }
 
   return fields_by_number_.insert(field).second;
@@ -2126,16 +2309,24 @@ DescriptorPool* NewGeneratedPool() {
   return generated_pool;
 }
 
+// The generated pool, without registering the section descriptor tables.
+// Registration adds files through InternalAddGeneratedFile(), which uses this.
+DescriptorPool* GeneratedPool() {
+  static DescriptorPool* generated_pool =
+      internal::OnShutdownDelete(NewGeneratedPool());
+  return generated_pool;
+}
+
 }  // anonymous namespace
 
 DescriptorDatabase* DescriptorPool::internal_generated_database() {
+  internal::RegisterSectionDescriptorTables();
   return GeneratedDatabase();
 }
 
 DescriptorPool* DescriptorPool::internal_generated_pool() {
-  static DescriptorPool* generated_pool =
-      internal::OnShutdownDelete(NewGeneratedPool());
-  return generated_pool;
+  internal::RegisterSectionDescriptorTables();
+  return GeneratedPool();
 }
 
 const DescriptorPool* DescriptorPool::generated_pool() {
@@ -2175,7 +2366,7 @@ void DescriptorPool::InternalAddGeneratedFile(
   // Therefore, when we parse one, we have to be very careful to avoid using
   // any descriptor-based operations, since this might cause infinite recursion
   // or deadlock.
-  absl::MutexLockMaybe lock(internal_generated_pool()->mutex_);
+  absl::MutexLockMaybe lock(GeneratedPool()->mutex_);
   ABSL_CHECK(GeneratedDatabase()->Add(encoded_file_descriptor, size));
 }
 
@@ -2400,8 +2591,25 @@ const FieldDescriptor* Descriptor::FindFieldByNumber(int key) const {
   }
 }
 
+const FieldDescriptor* Descriptor::FindFieldInLookup(absl::string_view key,
+                                                     bool lowercase) const {
+  const uint16_t* table =
+      field_lookup_ + (has_dense_field_numbers_ ? sequential_field_limit_ : 0);
+  const size_t mask = FieldNameTableSize(field_count_) - 1;
+  // The table is at most half full, so probing always reaches an empty slot.
+  for (size_t i = absl::Hash<absl::string_view>{}(key) & mask;;
+       i = (i + 1) & mask) {
+    if (table[i] == 0) return nullptr;
+    const FieldDescriptor* field = this->field(table[i] - 1);
+    if ((lowercase ? field->lowercase_name() : field->name()) == key) {
+      return field;
+    }
+  }
+}
+
 const FieldDescriptor* Descriptor::FindFieldByLowercaseName(
     absl::string_view key) const {
+  if (field_lookup_ != nullptr) return FindFieldInLookup(key, true);
   const FieldDescriptor* result =
       file()->tables_->FindFieldByLowercaseName(this, key);
   if (result == nullptr || result->is_extension()) {
@@ -2424,6 +2632,7 @@ const FieldDescriptor* Descriptor::FindFieldByCamelcaseName(
 
 const FieldDescriptor* Descriptor::FindFieldByName(
     absl::string_view key) const {
+  if (field_lookup_ != nullptr) return FindFieldInLookup(key, false);
   const FieldDescriptor* field =
       file()->tables_->FindNestedSymbol(this, key).field_descriptor();
   return field != nullptr && !field->is_extension() ? field : nullptr;
@@ -2617,7 +2826,9 @@ bool DescriptorPool::TryFindFileInFallbackDatabase(
     return database.FindFileByName(std::string(filename), &output);
   };
 
-  auto file_proto = absl::make_unique<FileDescriptorProto>();
+  // The proto only lives until it is built, so parse it into an arena.
+  Arena arena;
+  auto* file_proto = Arena::Create<FileDescriptorProto>(&arena);
   if (!find_file(*fallback_database_, name, *file_proto) ||
       BuildFileFromDatabase(*file_proto) == nullptr) {
     tables_->known_bad_files_.emplace(name);
@@ -2654,7 +2865,8 @@ bool DescriptorPool::TryFindSymbolInFallbackDatabase(
   if (tables_->known_bad_symbols_.contains(name)) return false;
 
   std::string name_string(name);
-  auto file_proto = absl::make_unique<FileDescriptorProto>();
+  Arena arena;
+  auto* file_proto = Arena::Create<FileDescriptorProto>(&arena);
   if (  // We skip looking in the fallback database if the name is a sub-symbol
         // of any descriptor that already exists in the descriptor pool (except
         // for package descriptors).  This is valid because all symbols except
@@ -2675,7 +2887,7 @@ bool DescriptorPool::TryFindSymbolInFallbackDatabase(
 
       // Look up file containing this symbol in fallback database.
       || !fallback_database_->FindFileContainingSymbol(name_string,
-                                                       file_proto.get())
+                                                       file_proto)
 
       // Check if we've already built this file. If so, it apparently doesn't
       // contain the symbol we're looking for.  Some DescriptorDatabases
@@ -2695,9 +2907,10 @@ bool DescriptorPool::TryFindExtensionInFallbackDatabase(
     const Descriptor* containing_type, int field_number) const {
   if (fallback_database_ == nullptr) return false;
 
-  auto file_proto = absl::make_unique<FileDescriptorProto>();
+  Arena arena;
+  auto* file_proto = Arena::Create<FileDescriptorProto>(&arena);
   if (!fallback_database_->FindFileContainingExtension(
-          containing_type->full_name(), field_number, file_proto.get())) {
+          containing_type->full_name(), field_number, file_proto)) {
     return false;
   }
 
@@ -2717,6 +2930,10 @@ bool DescriptorPool::TryFindExtensionInFallbackDatabase(
 
 // ===================================================================
 
+const std::string& FieldDescriptor::DerivedCamelcaseName() const {
+  return file()->tables_->DerivedCamelcaseName(this);
+}
+
 bool FieldDescriptor::is_map_message_type() const {
   return type_descriptor_.message_type->options().map_entry();
 }
@@ -4287,6 +4504,9 @@ class DescriptorBuilder {
   // macro, below.
   void BuildMessage(const DescriptorProto& proto, const Descriptor* parent,
                     Descriptor* result, internal::FlatAllocator& alloc);
+  // Fills in result->field_lookup_ once result's fields have been built.
+  void BuildFieldLookup(const DescriptorProto& proto, Descriptor* result,
+                        internal::FlatAllocator& alloc);
   void BuildFieldOrExtension(const FieldDescriptorProto& proto,
                              Descriptor* parent, FieldDescriptor* result,
                              bool is_extension, internal::FlatAllocator& alloc);
@@ -4536,6 +4756,13 @@ class DescriptorBuilder {
     }
   }
 
+  // Clears the fields of `options` that have source retention, recursing into
+  // message-typed options.  Used by DescriptorPool::DiscardSourceOnlyData().
+  void StripSourceRetentionOptions(Message& options);
+  // Same, for options of `type` that are still held as unknown fields.
+  void StripSourceRetentionOptions(const Descriptor* type,
+                                   UnknownFieldSet& unknown_fields);
+
   // Must be run only after options have been interpreted.
   //
   // NOTE: Validation code must only reference the options in the mutable
@@ -4608,6 +4835,101 @@ const FileDescriptor* DescriptorPool::BuildFileCollectingErrors(
       ->BuildFile(proto);
 }
 
+const FileDescriptor* DescriptorPool::BuildFileFromSerialized(
+    absl::string_view serialized) {
+  return BuildFileFromSerializedCollectingErrors(serialized, nullptr);
+}
+
+const FileDescriptor* DescriptorPool::BuildFileFromSerializedCollectingErrors(
+    absl::string_view serialized, ErrorCollector* error_collector) {
+  Arena arena;
+  auto* proto = Arena::Create<FileDescriptorProto>(&arena);
+  if (!proto->ParseFromString(serialized)) {
+    if (error_collector != nullptr) {
+      error_collector->RecordError("", "", proto, ErrorCollector::OTHER,
+                                   "Failed to parse FileDescriptorProto.");
+    } else {
+      ABSL_LOG(ERROR) << "Failed to parse FileDescriptorProto.";
+    }
+    return nullptr;
+  }
+  return BuildFileCollectingErrors(*proto, error_collector);
+}
+
+std::vector<const FileDescriptor*> DescriptorPool::BuildFiles(
+    const FileDescriptorSet& files) {
+  return BuildFilesCollectingErrors(files, nullptr);
+}
+
+std::vector<const FileDescriptor*> DescriptorPool::BuildFilesCollectingErrors(
+    const FileDescriptorSet& files, ErrorCollector* error_collector) {
+  ABSL_CHECK(fallback_database_ == nullptr)
+      << "Cannot call BuildFiles on a DescriptorPool that uses a "
+         "DescriptorDatabase.  You must instead find a way to get your files "
+         "into the underlying database.";
+  auto add_error = [&](const FileDescriptorProto& file,
+                       absl::string_view message) {
+    if (error_collector != nullptr) {
+      error_collector->RecordError(file.name(), file.name(), &file,
+                                   ErrorCollector::IMPORT, message);
+    } else {
+      ABSL_LOG(ERROR) << file.name() << ": " << message;
+    }
+  };
+
+  absl::flat_hash_map<absl::string_view, int> index;
+  for (int i = 0; i < files.file_size(); i++) {
+    if (!index.emplace(files.file(i).name(), i).second) {
+      add_error(files.file(i), "File appears more than once in the set.");
+      return {};
+    }
+  }
+
+  // Order the files so that each comes after its imports.  The depth-first
+  // search is iterative, since import chains can be arbitrarily long.
+  enum : uint8_t { kUnvisited, kVisiting, kVisited };
+  std::vector<uint8_t> state(files.file_size(), kUnvisited);
+  std::vector<int> order;
+  order.reserve(files.file_size());
+  std::vector<std::pair<int, int>> stack;  // (file, next import to visit)
+  for (int root = 0; root < files.file_size(); root++) {
+    if (state[root] != kUnvisited) continue;
+    state[root] = kVisiting;
+    stack.emplace_back(root, 0);
+    while (!stack.empty()) {
+      const FileDescriptorProto& file = files.file(stack.back().first);
+      if (stack.back().second == file.dependency_size()) {
+        state[stack.back().first] = kVisited;
+        order.push_back(stack.back().first);
+        stack.pop_back();
+        continue;
+      }
+      auto it = index.find(file.dependency(stack.back().second++));
+      if (it == index.end() || state[it->second] == kVisited) continue;
+      if (state[it->second] == kVisiting) {
+        add_error(file, "File recursively imports itself.");
+        return {};
+      }
+      state[it->second] = kVisiting;
+      stack.emplace_back(it->second, 0);
+    }
+  }
+
+  // Files built by a failing set must not stay behind, so the whole set is
+  // built under one checkpoint.
+  std::vector<const FileDescriptor*> result(files.file_size());
+  tables_->AddCheckpoint();
+  for (int i : order) {
+    result[i] = BuildFileCollectingErrors(files.file(i), error_collector);
+    if (result[i] == nullptr) {
+      tables_->RollbackToLastCheckpoint();
+      return {};
+    }
+  }
+  tables_->ClearLastCheckpoint();
+  return result;
+}
+
 const FileDescriptor* DescriptorPool::BuildFileFromDatabase(
     const FileDescriptorProto& proto) const {
   mutex_->AssertHeld();
@@ -5339,9 +5661,16 @@ void DescriptorBuilder::ResolveFeaturesImpl(
     // Nothing to merge, and we aren't forcing it.
     return;
   }
-  FeatureSet* merged_features = alloc.AllocateArray<FeatureSet>(1);
 
-  // Calculate the merged features for this target.
+  // Calculate the merged features for this target, unless the same merge has
+  // already been done in this pool.
+  auto key = std::make_tuple(std::string(*file_->edition_), &parent_features,
+                             descriptor->proto_features_->SerializeAsString());
+  auto it = tables_->merged_features_cache_.find(key);
+  if (it != tables_->merged_features_cache_.end()) {
+    descriptor->merged_features_ = it->second;
+    return;
+  }
   absl::StatusOr<FeatureSet> merged = feature_resolver_->MergeFeatures(
       parent_features, *descriptor->proto_features_);
   if (!merged.ok()) {
@@ -5350,8 +5679,10 @@ void DescriptorBuilder::ResolveFeaturesImpl(
     return;
   }
 
-  merged_features->Swap(&merged.value());
-  descriptor->merged_features_ = merged_features;
+  descriptor->merged_features_ =
+      tables_->InternFeatures(std::move(merged).value());
+  tables_->merged_features_cache_.emplace(std::move(key),
+                                          descriptor->merged_features_);
 }
 
 template <class DescriptorT>
@@ -5489,7 +5820,7 @@ static void PlanAllocationSize(
   alloc.PlanArray<std::string>(2 * values.size());  // name + full_name
   for (const auto& v : values) {
     if (v.has_options()) alloc.PlanArray<EnumValueOptions>(1);
-    if (HasFeatures(v.options())) alloc.PlanArray<FeatureSet>(2);
+    if (HasFeatures(v.options())) alloc.PlanArray<FeatureSet>(1);
   }
 }
 
@@ -5500,7 +5831,7 @@ static void PlanAllocationSize(
   alloc.PlanArray<std::string>(2 * enums.size());  // name + full_name
   for (const auto& e : enums) {
     if (e.has_options()) alloc.PlanArray<EnumOptions>(1);
-    if (HasFeatures(e.options())) alloc.PlanArray<FeatureSet>(2);
+    if (HasFeatures(e.options())) alloc.PlanArray<FeatureSet>(1);
     PlanAllocationSize(e.value(), alloc);
     alloc.PlanArray<EnumDescriptor::ReservedRange>(e.reserved_range_size());
     alloc.PlanArray<const std::string*>(e.reserved_name_size());
@@ -5515,7 +5846,7 @@ static void PlanAllocationSize(
   alloc.PlanArray<std::string>(2 * oneofs.size());  // name + full_name
   for (const auto& oneof : oneofs) {
     if (oneof.has_options()) alloc.PlanArray<OneofOptions>(1);
-    if (HasFeatures(oneof.options())) alloc.PlanArray<FeatureSet>(2);
+    if (HasFeatures(oneof.options())) alloc.PlanArray<FeatureSet>(1);
   }
 }
 
@@ -5525,7 +5856,7 @@ static void PlanAllocationSize(
   alloc.PlanArray<FieldDescriptor>(fields.size());
   for (const auto& field : fields) {
     if (field.has_options()) alloc.PlanArray<FieldOptions>(1);
-    if (HasFeatures(field.options())) alloc.PlanArray<FeatureSet>(2);
+    if (HasFeatures(field.options())) alloc.PlanArray<FeatureSet>(1);
     alloc.PlanFieldNames(field.name(),
                          field.has_json_name() ? &field.json_name() : nullptr);
     if (field.has_default_value() && field.has_type() &&
@@ -5543,7 +5874,7 @@ static void PlanAllocationSize(
   alloc.PlanArray<Descriptor::ExtensionRange>(ranges.size());
   for (const auto& r : ranges) {
     if (r.has_options()) alloc.PlanArray<ExtensionRangeOptions>(1);
-    if (HasFeatures(r.options())) alloc.PlanArray<FeatureSet>(2);
+    if (HasFeatures(r.options())) alloc.PlanArray<FeatureSet>(1);
   }
 }
 
@@ -5555,9 +5886,10 @@ static void PlanAllocationSize(
 
   for (const auto& message : messages) {
     if (message.has_options()) alloc.PlanArray<MessageOptions>(1);
-    if (HasFeatures(message.options())) alloc.PlanArray<FeatureSet>(2);
+    if (HasFeatures(message.options())) alloc.PlanArray<FeatureSet>(1);
     PlanAllocationSize(message.nested_type(), alloc);
     PlanAllocationSize(message.field(), alloc);
+    alloc.PlanArray<uint16_t>(FieldLookupSize(message));
     PlanAllocationSize(message.extension(), alloc);
     PlanAllocationSize(message.extension_range(), alloc);
     alloc.PlanArray<Descriptor::ReservedRange>(message.reserved_range_size());
@@ -5575,7 +5907,7 @@ static void PlanAllocationSize(
   alloc.PlanArray<std::string>(2 * methods.size());  // name + full_name
   for (const auto& m : methods) {
     if (m.has_options()) alloc.PlanArray<MethodOptions>(1);
-    if (HasFeatures(m.options())) alloc.PlanArray<FeatureSet>(2);
+    if (HasFeatures(m.options())) alloc.PlanArray<FeatureSet>(1);
   }
 }
 
@@ -5586,25 +5918,25 @@ static void PlanAllocationSize(
   alloc.PlanArray<std::string>(2 * services.size());  // name + full_name
   for (const auto& service : services) {
     if (service.has_options()) alloc.PlanArray<ServiceOptions>(1);
-    if (HasFeatures(service.options())) alloc.PlanArray<FeatureSet>(2);
+    if (HasFeatures(service.options())) alloc.PlanArray<FeatureSet>(1);
     PlanAllocationSize(service.method(), alloc);
   }
 }
 
 static void PlanAllocationSize(const FileDescriptorProto& proto,
+                               bool keep_source_code_info,
                                internal::FlatAllocator& alloc) {
   alloc.PlanArray<FileDescriptor>(1);
   alloc.PlanArray<FileDescriptorTables>(1);
   alloc.PlanArray<std::string>(
       2 + (proto.has_edition() ? 1 : 0));  // name + package
   if (proto.has_options()) alloc.PlanArray<FileOptions>(1);
-  if (proto.has_edition()) {
+  if (proto.has_edition() && HasFeatures(proto.options())) {
     alloc.PlanArray<FeatureSet>(1);
-    if (HasFeatures(proto.options())) {
-      alloc.PlanArray<FeatureSet>(1);
-    }
   }
-  if (proto.has_source_code_info()) alloc.PlanArray<SourceCodeInfo>(1);
+  if (proto.has_source_code_info() && keep_source_code_info) {
+    alloc.PlanArray<SourceCodeInfo>(1);
+  }
 
   PlanAllocationSize(proto.service(), alloc);
   PlanAllocationSize(proto.message_type(), alloc);
@@ -5684,7 +6016,7 @@ const FileDescriptor* DescriptorBuilder::BuildFile(
   tables_->AddCheckpoint();
 
   auto alloc = absl::make_unique<internal::FlatAllocator>();
-  PlanAllocationSize(proto, *alloc);
+  PlanAllocationSize(proto, !pool_->discard_source_only_data_, *alloc);
   alloc->FinalizePlanning(tables_);
   FileDescriptor* result = BuildFileImpl(proto, *alloc);
 
@@ -5725,7 +6057,7 @@ FileDescriptor* DescriptorBuilder::BuildFileImpl(
   result->is_placeholder_ = false;
   result->finished_building_ = false;
   SourceCodeInfo* info = nullptr;
-  if (proto.has_source_code_info()) {
+  if (proto.has_source_code_info() && !pool_->discard_source_only_data_) {
     info = alloc.AllocateArray<SourceCodeInfo>(1);
     info->CopyFrom(proto.source_code_info());
     result->source_code_info_ = info;
@@ -6007,6 +6339,25 @@ FileDescriptor* DescriptorBuilder::BuildFileImpl(
                                });
   }
 
+  if (!had_errors_ && pool_->discard_source_only_data_ &&
+      !pool_->enforce_extension_declarations_) {
+    internal::VisitDescriptors(*result, [&](const auto& descriptor) {
+      using OptionsT = typename std::remove_const<typename std::remove_pointer<
+          decltype(descriptor.options_)>::type>::type;
+      if (descriptor.options_ == &OptionsT::default_instance()) return;
+      auto& options = const_cast<OptionsT&>(
+          *descriptor.options_);  // NOLINT(google3-runtime-proto-const-cast)
+      StripSourceRetentionOptions(options);
+      // Options that held nothing else are dropped like in generated code.
+      if (options.ByteSizeLong() == 0) {
+        using DescriptorT = typename std::remove_const<
+            typename std::remove_reference<decltype(descriptor)>::type>::type;
+        const_cast<DescriptorT&>(descriptor).options_ =
+            &OptionsT::default_instance();
+      }
+    });
+  }
+
   // Additional naming conflict check for map entry types. Only need to check
   // this if there are already errors.
   if (had_errors_) {
@@ -6032,6 +6383,63 @@ FileDescriptor* DescriptorBuilder::BuildFileImpl(
 }
 
 
+void DescriptorBuilder::StripSourceRetentionOptions(Message& options) {
+  const Reflection* reflection = options.GetReflection();
+  std::vector<const FieldDescriptor*> fields;
+  reflection->ListFields(options, &fields);
+  for (const FieldDescriptor* field : fields) {
+    if (field->options().retention() == FieldOptions::RETENTION_SOURCE) {
+      reflection->ClearField(&options, field);
+    } else if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+      if (field->is_repeated()) {
+        for (int i = 0; i < reflection->FieldSize(options, field); ++i) {
+          StripSourceRetentionOptions(
+              *reflection->MutableRepeatedMessage(&options, field, i));
+        }
+      } else {
+        StripSourceRetentionOptions(
+            *reflection->MutableMessage(&options, field));
+      }
+    }
+  }
+
+  // Custom options defined in this pool are still unknown fields, since the
+  // options type comes from the generated pool.  This pool's own copy of the
+  // options type, if any, is where their extensions are registered.
+  if (reflection->GetUnknownFields(options).empty()) return;
+  Symbol symbol = tables_->FindSymbol(options.GetDescriptor()->full_name());
+  if (symbol.type() != Symbol::MESSAGE) return;
+  StripSourceRetentionOptions(symbol.descriptor(),
+                              *reflection->MutableUnknownFields(&options));
+}
+
+void DescriptorBuilder::StripSourceRetentionOptions(
+    const Descriptor* type, UnknownFieldSet& unknown_fields) {
+  for (int i = unknown_fields.field_count() - 1; i >= 0; --i) {
+    UnknownField& unknown = *unknown_fields.mutable_field(i);
+    const FieldDescriptor* field = type->FindFieldByNumber(unknown.number());
+    if (field == nullptr) {
+      field =
+          pool_->InternalFindExtensionByNumberNoLock(type, unknown.number());
+    }
+    if (field == nullptr) continue;
+    if (field->options().retention() == FieldOptions::RETENTION_SOURCE) {
+      unknown_fields.DeleteSubrange(i, 1);
+    } else if (field->message_type() == nullptr) {
+      continue;
+    } else if (unknown.type() == UnknownField::TYPE_GROUP) {
+      StripSourceRetentionOptions(field->message_type(),
+                                  *unknown.mutable_group());
+    } else if (unknown.type() == UnknownField::TYPE_LENGTH_DELIMITED) {
+      UnknownFieldSet nested;
+      if (nested.ParseFromString(unknown.length_delimited())) {
+        StripSourceRetentionOptions(field->message_type(), nested);
+        nested.SerializeToString(unknown.mutable_length_delimited());
+      }
+    }
+  }
+}
+
 const std::string* DescriptorBuilder::AllocateNameStrings(
     const std::string& scope, const std::string& proto_name,
     internal::FlatAllocator& alloc) {
@@ -6065,6 +6473,43 @@ bool IsNonMessageType(absl::string_view type) {
 }  // namespace
 
 
+void DescriptorBuilder::BuildFieldLookup(const DescriptorProto& proto,
+                                         Descriptor* result,
+                                         internal::FlatAllocator& alloc) {
+  const size_t size = FieldLookupSize(proto);
+  if (size == 0) {
+    result->field_lookup_ = nullptr;
+    return;
+  }
+  uint16_t* lookup = alloc.AllocateArray<uint16_t>(size);
+  std::fill(lookup, lookup + size, 0);
+  result->field_lookup_ = lookup;
+
+  if (result->has_dense_field_numbers_) {
+    for (int i = 0; i < result->field_count(); ++i) {
+      // Keep the first field with each number; AddFieldByNumber() reports the
+      // others as conflicts.
+      uint16_t& slot = lookup[result->field(i)->number() - 1];
+      if (slot == 0) slot = static_cast<uint16_t>(i + 1);
+    }
+    lookup += result->sequential_field_limit_;
+  }
+
+  const size_t mask = FieldNameTableSize(result->field_count()) - 1;
+  auto insert = [&](absl::string_view name, int index) {
+    size_t i = absl::Hash<absl::string_view>{}(name) & mask;
+    while (lookup[i] != 0) i = (i + 1) & mask;
+    lookup[i] = static_cast<uint16_t>(index + 1);
+  };
+  for (int i = 0; i < result->field_count(); ++i) {
+    const FieldDescriptor* field = result->field(i);
+    insert(field->name(), i);
+    if (field->lowercase_name() != field->name()) {
+      insert(field->lowercase_name(), i);
+    }
+  }
+}
+
 void DescriptorBuilder::BuildMessage(const DescriptorProto& proto,
                                      const Descriptor* parent,
                                      Descriptor* result,
@@ -6098,10 +6543,16 @@ void DescriptorBuilder::BuildMessage(const DescriptorProto& proto,
        ++i) {
     result->sequential_field_limit_ = i + 1;
   }
+  // When the numbers are compact but out of order, extend the fast path with
+  // a dense table from number to field instead.
+  const int dense_limit = DenseFieldNumberLimit(proto);
+  result->has_dense_field_numbers_ = dense_limit != 0;
+  if (dense_limit != 0) result->sequential_field_limit_ = dense_limit;
 
   // Build oneofs first so that fields and extension ranges can refer to them.
   BUILD_ARRAY(proto, result, oneof_decl, BuildOneof, result);
   BUILD_ARRAY(proto, result, field, BuildField, result);
+  BuildFieldLookup(proto, result, alloc);
   BUILD_ARRAY(proto, result, enum_type, BuildEnum, result);
   BUILD_ARRAY(proto, result, extension_range, BuildExtensionRange, result);
   BUILD_ARRAY(proto, result, extension, BuildExtension, result);
@@ -6357,8 +6808,13 @@ void DescriptorBuilder::BuildFieldOrExtension(const FieldDescriptorProto& proto,
       proto.has_json_name() ? &proto.json_name() : nullptr);
   result->all_names_ = all_names.array;
   result->lowercase_name_index_ = all_names.lowercase_index;
-  result->camelcase_name_index_ = all_names.camelcase_index;
-  result->json_name_index_ = all_names.json_index;
+  result->camelcase_name_index_ =
+      all_names.camelcase_index == all_names.kDerived
+          ? FieldDescriptor::kDerivedNameIndex
+          : all_names.camelcase_index;
+  result->json_name_index_ = all_names.json_index == all_names.kDerived
+                                 ? FieldDescriptor::kDerivedNameIndex
+                                 : all_names.json_index;
 
   ValidateSymbolName(proto.name(), result->full_name(), proto);
 
@@ -7862,7 +8318,9 @@ void DescriptorBuilder::ValidateOptions(const FieldDescriptor* field,
              "option json_name is not allowed on extension fields.");
   }
 
-  if (absl::StrContains(field->json_name(), '\0')) {
+  // Derived json names come from valid identifiers, so only a custom
+  // json_name can contain a NUL.
+  if (field->has_json_name() && absl::StrContains(field->json_name(), '\0')) {
     AddError(field->full_name(), proto,
              DescriptorPool::ErrorCollector::OPTION_NAME,
              "json_name cannot have embedded null characters.");
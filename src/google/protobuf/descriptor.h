@@ -111,6 +111,7 @@ class EnumValueDescriptorProto;
 class ServiceDescriptorProto;
 class MethodDescriptorProto;
 class FileDescriptorProto;
+class FileDescriptorSet;
 class MessageOptions;
 class FieldOptions;
 class OneofOptions;
@@ -668,18 +669,27 @@ class PROTOBUF_EXPORT Descriptor : private internal::SymbolBase {
   // to this descriptor from the file root.
   void GetLocationPath(std::vector<int>* output) const;
 
+  // Looks `key` up in the name part of field_lookup_, comparing it against
+  // either the name or the lowercase name of the fields found.
+  const FieldDescriptor* FindFieldInLookup(absl::string_view key,
+                                           bool lowercase) const;
+
   // True if this is a placeholder for an unknown type.
   bool is_placeholder_ : 1;
   // True if this is a placeholder and the type name wasn't fully-qualified.
   bool is_unqualified_placeholder_ : 1;
   // Well known type.  Stored like this to conserve space.
   uint8_t well_known_type_ : 5;
+  // True if field_lookup_ starts with a dense table indexed by field number.
+  bool has_dense_field_numbers_ : 1;
 
   // This points to the last field _number_ that is part of the sequence
   // starting at 1, where
   //     `desc->field(i)->number() == i + 1`
   // A value of `0` means no field matches. That is, there are no fields or the
   // first field is not field `1`.
+  // If has_dense_field_numbers_ is set, this is instead the highest field
+  // number, and numbers up to it are looked up in the dense table.
   // Uses 16-bit to avoid extra padding. Unlikely to have more than 2^16
   // sequentially numbered fields in a message.
   uint16_t sequential_field_limit_;
@@ -696,6 +706,10 @@ class PROTOBUF_EXPORT Descriptor : private internal::SymbolBase {
 
   // These arrays are separated from their sizes to minimize padding on 64-bit.
   FieldDescriptor* fields_;
+  // Per-message lookup tables of 1-based field indices, where 0 is empty:
+  // the dense table by number, if any, followed by an open-addressed hash
+  // table keyed by both name and lowercase name.  Null if there are no fields.
+  const uint16_t* field_lookup_;
   OneofDescriptor* oneof_decls_;
   Descriptor* nested_types_;
   EnumDescriptor* enum_types_;
@@ -729,7 +743,7 @@ class PROTOBUF_EXPORT Descriptor : private internal::SymbolBase {
   friend class FileDescriptor;
 };
 
-PROTOBUF_INTERNAL_CHECK_CLASS_SIZE(Descriptor, 152);
+PROTOBUF_INTERNAL_CHECK_CLASS_SIZE(Descriptor, 160);
 
 // Describes a single field of a message.  To get the descriptor for a given
 // field, first get the Descriptor for the message in which it is defined,
@@ -1078,6 +1092,10 @@ class PROTOBUF_EXPORT FieldDescriptor : private internal::SymbolBase {
   // Returns true if this is a map message type.
   bool is_map_message_type() const;
 
+  // Returns the camelcase name of a field whose derived names are not stored
+  // in all_names_.  See kDerivedNameIndex.
+  const std::string& DerivedCamelcaseName() const;
+
   bool has_default_value_ : 1;
   bool proto3_optional_ : 1;
   // Whether the user has specified the json_name field option in the .proto
@@ -1099,6 +1117,12 @@ class PROTOBUF_EXPORT FieldDescriptor : private internal::SymbolBase {
   //   position.
   // We store the true offset for each name here, and the bit width must be
   // large enough to account for the worst case where all names are present.
+  //
+  // snake_case fields without a custom json_name, which are most fields,
+  // only store [name, full_name]: their camelcase and json names are equal
+  // and are derived on first use instead.  Such fields use kDerivedNameIndex,
+  // the position of full_name, which is never a valid index for those names.
+  static constexpr uint8_t kDerivedNameIndex = 1;
   uint8_t lowercase_name_index_ : 2;
   uint8_t camelcase_name_index_ : 2;
   uint8_t json_name_index_ : 3;
@@ -1155,6 +1179,7 @@ class PROTOBUF_EXPORT FieldDescriptor : private internal::SymbolBase {
   FieldDescriptor();
   friend class DescriptorBuilder;
   friend class FileDescriptor;
+  friend class FileDescriptorTables;
   friend class Descriptor;
   friend class OneofDescriptor;
 };
@@ -2267,6 +2292,29 @@ class PROTOBUF_EXPORT DescriptorPool {
   const FileDescriptor* BuildFileCollectingErrors(
       const FileDescriptorProto& proto, ErrorCollector* error_collector);
 
+  // Same as BuildFile(), but takes a serialized FileDescriptorProto.  The
+  // intermediate proto is parsed into an arena, so it costs a few block
+  // allocations that are released at once rather than one heap allocation per
+  // element.  Returns nullptr if `serialized` does not parse.
+  const FileDescriptor* BuildFileFromSerialized(absl::string_view serialized);
+
+  // Same as BuildFileFromSerialized() except errors are sent to the given
+  // ErrorCollector.
+  const FileDescriptor* BuildFileFromSerializedCollectingErrors(
+      absl::string_view serialized, ErrorCollector* error_collector);
+
+  // Builds every file in `files`, which may be given in any order: each file
+  // is built after the files it imports from the same set.  Imports outside
+  // the set must already be in the pool.  The set is added all-or-nothing:
+  // if any file fails to build, or the imports within the set form a cycle,
+  // none of its files are added and an empty vector is returned.  Otherwise
+  // returns the built files, in the same order as `files`.
+  std::vector<const FileDescriptor*> BuildFiles(const FileDescriptorSet& files);
+
+  // Same as BuildFiles() except errors are sent to the given ErrorCollector.
+  std::vector<const FileDescriptor*> BuildFilesCollectingErrors(
+      const FileDescriptorSet& files, ErrorCollector* error_collector);
+
   // By default, it is an error if a FileDescriptorProto contains references
   // to types or other files that are not found in the DescriptorPool (or its
   // backing DescriptorDatabase, if any).  If you call
@@ -2304,6 +2352,16 @@ class PROTOBUF_EXPORT DescriptorPool {
   void EnforceExtensionDeclarations(bool enforce) {
     enforce_extension_declarations_ = enforce;
   }
+
+  // Discards data that only tools working on .proto sources need, for files
+  // built after the call.  SourceCodeInfo is not kept, so
+  // FileDescriptor::CopySourceCodeInfoTo() and GetSourceLocation() find
+  // nothing, and options with source retention are cleared once each file has
+  // been validated.  Source-retention options are kept when extension
+  // declarations are enforced, since the declarations are among them.
+  void DiscardSourceOnlyData(bool discard) {
+    discard_source_only_data_ = discard;
+  }
   // Internal stuff --------------------------------------------------
   // These methods MUST NOT be called from outside the proto2 library.
   // These methods may contain hidden pitfalls and may be removed in a
@@ -2477,6 +2535,7 @@ class PROTOBUF_EXPORT DescriptorPool {
   bool enforce_extension_declarations_;
   bool disallow_enforce_utf8_;
   bool deprecated_legacy_json_field_conflicts_;
+  bool discard_source_only_data_ = false;
   mutable bool build_started_ = false;
 
   // Set of files to track for unused imports. The bool value when true means
@@ -2683,10 +2742,16 @@ inline const std::string& FieldDescriptor::lowercase_name() const {
 }
 
 inline const std::string& FieldDescriptor::camelcase_name() const {
+  if (PROTOBUF_PREDICT_FALSE(camelcase_name_index_ == kDerivedNameIndex)) {
+    return DerivedCamelcaseName();
+  }
   return all_names_[camelcase_name_index_];
 }
 
 inline const std::string& FieldDescriptor::json_name() const {
+  if (PROTOBUF_PREDICT_FALSE(json_name_index_ == kDerivedNameIndex)) {
+    return DerivedCamelcaseName();
+  }
   return all_names_[json_name_index_];
 }
 
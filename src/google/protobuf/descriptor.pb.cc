@@ -2363,6 +2363,7 @@ constexpr ::_pbi::TcParseTable<0, 1, 1, 0, 2> FileDescriptorSet::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_FileDescriptorSet_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     // repeated .google.protobuf.FileDescriptorProto file = 1;
     {::_pbi::TcParser::FastMtR1,
@@ -2420,6 +2421,17 @@ constexpr ::_pbi::TcParseTable<0, 1, 1, 0, 2> FileDescriptorSet::_table_ = {
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t FileDescriptorSet::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(FileDescriptorSet);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  total_size += _impl_.file_.SpaceUsedExcludingSelfLong();
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData FileDescriptorSet::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     FileDescriptorSet::MergeImpl
@@ -2685,6 +2697,7 @@ constexpr ::_pbi::TcParseTable<4, 13, 6, 86, 2> FileDescriptorProto::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_FileDescriptorProto_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // optional string name = 1;
@@ -2799,16 +2812,20 @@ constexpr ::_pbi::TcParseTable<4, 13, 6, 86, 2> FileDescriptorProto::_table_ = {
   // optional string name = 1;
   if (cached_has_bits & 0x00000001u) {
     const std::string& _s = this->_internal_name();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.FileDescriptorProto.name");
+    if (!_impl_.name_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.FileDescriptorProto.name");
+    }
     target = stream->WriteStringMaybeAliased(1, _s, target);
   }
 
   // optional string package = 2;
   if (cached_has_bits & 0x00000002u) {
     const std::string& _s = this->_internal_package();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.FileDescriptorProto.package");
+    if (!_impl_.package_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.FileDescriptorProto.package");
+    }
     target = stream->WriteStringMaybeAliased(2, _s, target);
   }
 
@@ -2883,16 +2900,20 @@ constexpr ::_pbi::TcParseTable<4, 13, 6, 86, 2> FileDescriptorProto::_table_ = {
   // optional string syntax = 12;
   if (cached_has_bits & 0x00000004u) {
     const std::string& _s = this->_internal_syntax();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.FileDescriptorProto.syntax");
+    if (!_impl_.syntax_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.FileDescriptorProto.syntax");
+    }
     target = stream->WriteStringMaybeAliased(12, _s, target);
   }
 
   // optional string edition = 13;
   if (cached_has_bits & 0x00000008u) {
     const std::string& _s = this->_internal_edition();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.FileDescriptorProto.edition");
+    if (!_impl_.edition_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.FileDescriptorProto.edition");
+    }
     target = stream->WriteStringMaybeAliased(13, _s, target);
   }
 
@@ -3007,6 +3028,45 @@ constexpr ::_pbi::TcParseTable<4, 13, 6, 86, 2> FileDescriptorProto::_table_ = {
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t FileDescriptorProto::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(FileDescriptorProto);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  total_size += _impl_.dependency_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.message_type_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.enum_type_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.service_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.extension_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.public_dependency_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.weak_dependency_.SpaceUsedExcludingSelfLong();
+  if (!_impl_.name_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.name_.Get());
+  }
+  if (!_impl_.package_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.package_.Get());
+  }
+  if (!_impl_.syntax_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.syntax_.Get());
+  }
+  if (!_impl_.edition_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.edition_.Get());
+  }
+  if (_impl_.options_ != nullptr) {
+    total_size += _impl_.options_->SpaceUsedLong();
+  }
+  if (_impl_.source_code_info_ != nullptr) {
+    total_size += _impl_.source_code_info_->SpaceUsedLong();
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData FileDescriptorProto::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     FileDescriptorProto::MergeImpl
@@ -3227,6 +3287,7 @@ constexpr ::_pbi::TcParseTable<2, 3, 1, 0, 2> DescriptorProto_ExtensionRange::_t
     offsetof(decltype(_table_), aux_entries),
     &_DescriptorProto_ExtensionRange_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // optional int32 start = 1;
@@ -3327,6 +3388,19 @@ constexpr ::_pbi::TcParseTable<2, 3, 1, 0, 2> DescriptorProto_ExtensionRange::_t
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t DescriptorProto_ExtensionRange::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(DescriptorProto_ExtensionRange);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  if (_impl_.options_ != nullptr) {
+    total_size += _impl_.options_->SpaceUsedLong();
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData DescriptorProto_ExtensionRange::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     DescriptorProto_ExtensionRange::MergeImpl
@@ -3474,6 +3548,7 @@ constexpr ::_pbi::TcParseTable<1, 2, 0, 0, 2> DescriptorProto_ReservedRange::_ta
     offsetof(decltype(_table_), field_names),  // no aux_entries
     &_DescriptorProto_ReservedRange_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     // optional int32 end = 2;
     {::_pbi::TcParser::SingularVarintNoZag1<::uint32_t, offsetof(DescriptorProto_ReservedRange, _impl_.end_), 1>(),
@@ -3553,6 +3628,16 @@ constexpr ::_pbi::TcParseTable<1, 2, 0, 0, 2> DescriptorProto_ReservedRange::_ta
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t DescriptorProto_ReservedRange::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(DescriptorProto_ReservedRange);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData DescriptorProto_ReservedRange::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     DescriptorProto_ReservedRange::MergeImpl
@@ -3570,11 +3655,19 @@ void DescriptorProto_ReservedRange::MergeImpl(::google::protobuf::Message& to_ms
 
   cached_has_bits = from._impl_._has_bits_[0];
   if (cached_has_bits & 0x00000003u) {
-    if (cached_has_bits & 0x00000001u) {
-      _this->_impl_.start_ = from._impl_.start_;
-    }
-    if (cached_has_bits & 0x00000002u) {
-      _this->_impl_.end_ = from._impl_.end_;
+    if ((cached_has_bits & 0x00000003u) == 0x00000003u) {
+      ::memcpy(&_this->_impl_.start_, &from._impl_.start_,
+               static_cast<::size_t>(
+                   reinterpret_cast<const char*>(&from._impl_.end_) -
+                   reinterpret_cast<const char*>(&from._impl_.start_)) +
+                   sizeof(from._impl_.end_));
+    } else {
+      if (cached_has_bits & 0x00000001u) {
+        _this->_impl_.start_ = from._impl_.start_;
+      }
+      if (cached_has_bits & 0x00000002u) {
+        _this->_impl_.end_ = from._impl_.end_;
+      }
     }
     _this->_impl_._has_bits_[0] |= cached_has_bits;
   }
@@ -3757,6 +3850,7 @@ constexpr ::_pbi::TcParseTable<4, 10, 8, 65, 2> DescriptorProto::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_DescriptorProto_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // optional string name = 1;
@@ -3855,8 +3949,10 @@ constexpr ::_pbi::TcParseTable<4, 10, 8, 65, 2> DescriptorProto::_table_ = {
   // optional string name = 1;
   if (cached_has_bits & 0x00000001u) {
     const std::string& _s = this->_internal_name();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.DescriptorProto.name");
+    if (!_impl_.name_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.DescriptorProto.name");
+    }
     target = stream->WriteStringMaybeAliased(1, _s, target);
   }
 
@@ -4015,6 +4111,31 @@ constexpr ::_pbi::TcParseTable<4, 10, 8, 65, 2> DescriptorProto::_table_ = {
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t DescriptorProto::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(DescriptorProto);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  total_size += _impl_.field_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.nested_type_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.enum_type_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.extension_range_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.extension_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.oneof_decl_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.reserved_range_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.reserved_name_.SpaceUsedExcludingSelfLong();
+  if (!_impl_.name_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.name_.Get());
+  }
+  if (_impl_.options_ != nullptr) {
+    total_size += _impl_.options_->SpaceUsedLong();
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData DescriptorProto::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     DescriptorProto::MergeImpl
@@ -4250,6 +4371,7 @@ constexpr ::_pbi::TcParseTable<3, 5, 0, 71, 2> ExtensionRangeOptions_Declaration
     offsetof(decltype(_table_), field_names),  // no aux_entries
     &_ExtensionRangeOptions_Declaration_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // optional int32 number = 1;
@@ -4315,16 +4437,20 @@ constexpr ::_pbi::TcParseTable<3, 5, 0, 71, 2> ExtensionRangeOptions_Declaration
   // optional string full_name = 2;
   if (cached_has_bits & 0x00000001u) {
     const std::string& _s = this->_internal_full_name();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.ExtensionRangeOptions.Declaration.full_name");
+    if (!_impl_.full_name_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.ExtensionRangeOptions.Declaration.full_name");
+    }
     target = stream->WriteStringMaybeAliased(2, _s, target);
   }
 
   // optional string type = 3;
   if (cached_has_bits & 0x00000002u) {
     const std::string& _s = this->_internal_type();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.ExtensionRangeOptions.Declaration.type");
+    if (!_impl_.type_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.ExtensionRangeOptions.Declaration.type");
+    }
     target = stream->WriteStringMaybeAliased(3, _s, target);
   }
 
@@ -4393,6 +4519,24 @@ constexpr ::_pbi::TcParseTable<3, 5, 0, 71, 2> ExtensionRangeOptions_Declaration
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t ExtensionRangeOptions_Declaration::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(ExtensionRangeOptions_Declaration);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  if (!_impl_.full_name_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.full_name_.Get());
+  }
+  if (!_impl_.type_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.type_.Get());
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData ExtensionRangeOptions_Declaration::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     ExtensionRangeOptions_Declaration::MergeImpl
@@ -4581,6 +4725,7 @@ constexpr ::_pbi::TcParseTable<3, 4, 4, 0, 12> ExtensionRangeOptions::_table_ =
     offsetof(decltype(_table_), aux_entries),
     &_ExtensionRangeOptions_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     {::_pbi::TcParser::MiniParse, {}},
@@ -4714,6 +4859,22 @@ constexpr ::_pbi::TcParseTable<3, 4, 4, 0, 12> ExtensionRangeOptions::_table_ =
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t ExtensionRangeOptions::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(ExtensionRangeOptions);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  total_size += _impl_._extensions_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.declaration_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.uninterpreted_option_.SpaceUsedExcludingSelfLong();
+  if (_impl_.features_ != nullptr) {
+    total_size += _impl_.features_->SpaceUsedLong();
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData ExtensionRangeOptions::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     ExtensionRangeOptions::MergeImpl
@@ -5021,6 +5182,7 @@ constexpr ::_pbi::TcParseTable<4, 11, 3, 96, 2> FieldDescriptorProto::_table_ =
     offsetof(decltype(_table_), aux_entries),
     &_FieldDescriptorProto_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // optional string name = 1;
@@ -5120,16 +5282,20 @@ constexpr ::_pbi::TcParseTable<4, 11, 3, 96, 2> FieldDescriptorProto::_table_ =
   // optional string name = 1;
   if (cached_has_bits & 0x00000001u) {
     const std::string& _s = this->_internal_name();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.FieldDescriptorProto.name");
+    if (!_impl_.name_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.FieldDescriptorProto.name");
+    }
     target = stream->WriteStringMaybeAliased(1, _s, target);
   }
 
   // optional string extendee = 2;
   if (cached_has_bits & 0x00000002u) {
     const std::string& _s = this->_internal_extendee();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.FieldDescriptorProto.extendee");
+    if (!_impl_.extendee_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.FieldDescriptorProto.extendee");
+    }
     target = stream->WriteStringMaybeAliased(2, _s, target);
   }
 
@@ -5157,16 +5323,20 @@ constexpr ::_pbi::TcParseTable<4, 11, 3, 96, 2> FieldDescriptorProto::_table_ =
   // optional string type_name = 6;
   if (cached_has_bits & 0x00000004u) {
     const std::string& _s = this->_internal_type_name();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.FieldDescriptorProto.type_name");
+    if (!_impl_.type_name_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.FieldDescriptorProto.type_name");
+    }
     target = stream->WriteStringMaybeAliased(6, _s, target);
   }
 
   // optional string default_value = 7;
   if (cached_has_bits & 0x00000008u) {
     const std::string& _s = this->_internal_default_value();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.FieldDescriptorProto.default_value");
+    if (!_impl_.default_value_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.FieldDescriptorProto.default_value");
+    }
     target = stream->WriteStringMaybeAliased(7, _s, target);
   }
 
@@ -5187,8 +5357,10 @@ constexpr ::_pbi::TcParseTable<4, 11, 3, 96, 2> FieldDescriptorProto::_table_ =
   // optional string json_name = 10;
   if (cached_has_bits & 0x00000010u) {
     const std::string& _s = this->_internal_json_name();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.FieldDescriptorProto.json_name");
+    if (!_impl_.json_name_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.FieldDescriptorProto.json_name");
+    }
     target = stream->WriteStringMaybeAliased(10, _s, target);
   }
 
@@ -5290,6 +5462,39 @@ constexpr ::_pbi::TcParseTable<4, 11, 3, 96, 2> FieldDescriptorProto::_table_ =
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t FieldDescriptorProto::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(FieldDescriptorProto);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  if (!_impl_.name_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.name_.Get());
+  }
+  if (!_impl_.extendee_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.extendee_.Get());
+  }
+  if (!_impl_.type_name_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.type_name_.Get());
+  }
+  if (!_impl_.default_value_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.default_value_.Get());
+  }
+  if (!_impl_.json_name_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.json_name_.Get());
+  }
+  if (_impl_.options_ != nullptr) {
+    total_size += _impl_.options_->SpaceUsedLong();
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData FieldDescriptorProto::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     FieldDescriptorProto::MergeImpl
@@ -5335,14 +5540,22 @@ void FieldDescriptorProto::MergeImpl(::google::protobuf::Message& to_msg, const
     _this->_impl_._has_bits_[0] |= cached_has_bits;
   }
   if (cached_has_bits & 0x00000700u) {
-    if (cached_has_bits & 0x00000100u) {
-      _this->_impl_.proto3_optional_ = from._impl_.proto3_optional_;
-    }
-    if (cached_has_bits & 0x00000200u) {
-      _this->_impl_.label_ = from._impl_.label_;
-    }
-    if (cached_has_bits & 0x00000400u) {
-      _this->_impl_.type_ = from._impl_.type_;
+    if ((cached_has_bits & 0x00000700u) == 0x00000700u) {
+      ::memcpy(&_this->_impl_.proto3_optional_, &from._impl_.proto3_optional_,
+               static_cast<::size_t>(
+                   reinterpret_cast<const char*>(&from._impl_.type_) -
+                   reinterpret_cast<const char*>(&from._impl_.proto3_optional_)) +
+                   sizeof(from._impl_.type_));
+    } else {
+      if (cached_has_bits & 0x00000100u) {
+        _this->_impl_.proto3_optional_ = from._impl_.proto3_optional_;
+      }
+      if (cached_has_bits & 0x00000200u) {
+        _this->_impl_.label_ = from._impl_.label_;
+      }
+      if (cached_has_bits & 0x00000400u) {
+        _this->_impl_.type_ = from._impl_.type_;
+      }
     }
     _this->_impl_._has_bits_[0] |= cached_has_bits;
   }
@@ -5508,6 +5721,7 @@ constexpr ::_pbi::TcParseTable<1, 2, 1, 49, 2> OneofDescriptorProto::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_OneofDescriptorProto_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     // optional .google.protobuf.OneofOptions options = 2;
     {::_pbi::TcParser::FastMtS1,
@@ -5544,8 +5758,10 @@ constexpr ::_pbi::TcParseTable<1, 2, 1, 49, 2> OneofDescriptorProto::_table_ = {
   // optional string name = 1;
   if (cached_has_bits & 0x00000001u) {
     const std::string& _s = this->_internal_name();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.OneofDescriptorProto.name");
+    if (!_impl_.name_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.OneofDescriptorProto.name");
+    }
     target = stream->WriteStringMaybeAliased(1, _s, target);
   }
 
@@ -5592,6 +5808,23 @@ constexpr ::_pbi::TcParseTable<1, 2, 1, 49, 2> OneofDescriptorProto::_table_ = {
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t OneofDescriptorProto::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(OneofDescriptorProto);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  if (!_impl_.name_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.name_.Get());
+  }
+  if (_impl_.options_ != nullptr) {
+    total_size += _impl_.options_->SpaceUsedLong();
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData OneofDescriptorProto::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     OneofDescriptorProto::MergeImpl
@@ -5734,6 +5967,7 @@ constexpr ::_pbi::TcParseTable<1, 2, 0, 0, 2> EnumDescriptorProto_EnumReservedRa
     offsetof(decltype(_table_), field_names),  // no aux_entries
     &_EnumDescriptorProto_EnumReservedRange_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     // optional int32 end = 2;
     {::_pbi::TcParser::SingularVarintNoZag1<::uint32_t, offsetof(EnumDescriptorProto_EnumReservedRange, _impl_.end_), 1>(),
@@ -5813,6 +6047,16 @@ constexpr ::_pbi::TcParseTable<1, 2, 0, 0, 2> EnumDescriptorProto_EnumReservedRa
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t EnumDescriptorProto_EnumReservedRange::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(EnumDescriptorProto_EnumReservedRange);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData EnumDescriptorProto_EnumReservedRange::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     EnumDescriptorProto_EnumReservedRange::MergeImpl
@@ -5830,11 +6074,19 @@ void EnumDescriptorProto_EnumReservedRange::MergeImpl(::google::protobuf::Messag
 
   cached_has_bits = from._impl_._has_bits_[0];
   if (cached_has_bits & 0x00000003u) {
-    if (cached_has_bits & 0x00000001u) {
-      _this->_impl_.start_ = from._impl_.start_;
-    }
-    if (cached_has_bits & 0x00000002u) {
-      _this->_impl_.end_ = from._impl_.end_;
+    if ((cached_has_bits & 0x00000003u) == 0x00000003u) {
+      ::memcpy(&_this->_impl_.start_, &from._impl_.start_,
+               static_cast<::size_t>(
+                   reinterpret_cast<const char*>(&from._impl_.end_) -
+                   reinterpret_cast<const char*>(&from._impl_.start_)) +
+                   sizeof(from._impl_.end_));
+    } else {
+      if (cached_has_bits & 0x00000001u) {
+        _this->_impl_.start_ = from._impl_.start_;
+      }
+      if (cached_has_bits & 0x00000002u) {
+        _this->_impl_.end_ = from._impl_.end_;
+      }
     }
     _this->_impl_._has_bits_[0] |= cached_has_bits;
   }
@@ -5997,6 +6249,7 @@ constexpr ::_pbi::TcParseTable<3, 5, 3, 61, 2> EnumDescriptorProto::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_EnumDescriptorProto_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // optional string name = 1;
@@ -6057,8 +6310,10 @@ constexpr ::_pbi::TcParseTable<3, 5, 3, 61, 2> EnumDescriptorProto::_table_ = {
   // optional string name = 1;
   if (cached_has_bits & 0x00000001u) {
     const std::string& _s = this->_internal_name();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.EnumDescriptorProto.name");
+    if (!_impl_.name_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.EnumDescriptorProto.name");
+    }
     target = stream->WriteStringMaybeAliased(1, _s, target);
   }
 
@@ -6147,6 +6402,26 @@ constexpr ::_pbi::TcParseTable<3, 5, 3, 61, 2> EnumDescriptorProto::_table_ = {
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t EnumDescriptorProto::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(EnumDescriptorProto);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  total_size += _impl_.value_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.reserved_range_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.reserved_name_.SpaceUsedExcludingSelfLong();
+  if (!_impl_.name_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.name_.Get());
+  }
+  if (_impl_.options_ != nullptr) {
+    total_size += _impl_.options_->SpaceUsedLong();
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData EnumDescriptorProto::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     EnumDescriptorProto::MergeImpl
@@ -6338,6 +6613,7 @@ constexpr ::_pbi::TcParseTable<2, 3, 1, 53, 2> EnumValueDescriptorProto::_table_
     offsetof(decltype(_table_), aux_entries),
     &_EnumValueDescriptorProto_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // optional string name = 1;
@@ -6381,8 +6657,10 @@ constexpr ::_pbi::TcParseTable<2, 3, 1, 53, 2> EnumValueDescriptorProto::_table_
   // optional string name = 1;
   if (cached_has_bits & 0x00000001u) {
     const std::string& _s = this->_internal_name();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.EnumValueDescriptorProto.name");
+    if (!_impl_.name_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.EnumValueDescriptorProto.name");
+    }
     target = stream->WriteStringMaybeAliased(1, _s, target);
   }
 
@@ -6442,6 +6720,23 @@ constexpr ::_pbi::TcParseTable<2, 3, 1, 53, 2> EnumValueDescriptorProto::_table_
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t EnumValueDescriptorProto::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(EnumValueDescriptorProto);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  if (!_impl_.name_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.name_.Get());
+  }
+  if (_impl_.options_ != nullptr) {
+    total_size += _impl_.options_->SpaceUsedLong();
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData EnumValueDescriptorProto::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     EnumValueDescriptorProto::MergeImpl
@@ -6629,6 +6924,7 @@ constexpr ::_pbi::TcParseTable<2, 3, 2, 51, 2> ServiceDescriptorProto::_table_ =
     offsetof(decltype(_table_), aux_entries),
     &_ServiceDescriptorProto_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // optional string name = 1;
@@ -6673,8 +6969,10 @@ constexpr ::_pbi::TcParseTable<2, 3, 2, 51, 2> ServiceDescriptorProto::_table_ =
   // optional string name = 1;
   if (cached_has_bits & 0x00000001u) {
     const std::string& _s = this->_internal_name();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.ServiceDescriptorProto.name");
+    if (!_impl_.name_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.ServiceDescriptorProto.name");
+    }
     target = stream->WriteStringMaybeAliased(1, _s, target);
   }
 
@@ -6735,6 +7033,24 @@ constexpr ::_pbi::TcParseTable<2, 3, 2, 51, 2> ServiceDescriptorProto::_table_ =
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t ServiceDescriptorProto::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(ServiceDescriptorProto);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  total_size += _impl_.method_.SpaceUsedExcludingSelfLong();
+  if (!_impl_.name_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.name_.Get());
+  }
+  if (_impl_.options_ != nullptr) {
+    total_size += _impl_.options_->SpaceUsedLong();
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData ServiceDescriptorProto::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     ServiceDescriptorProto::MergeImpl
@@ -6970,6 +7286,7 @@ constexpr ::_pbi::TcParseTable<3, 6, 1, 71, 2> MethodDescriptorProto::_table_ =
     offsetof(decltype(_table_), aux_entries),
     &_MethodDescriptorProto_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // optional string name = 1;
@@ -7034,24 +7351,30 @@ constexpr ::_pbi::TcParseTable<3, 6, 1, 71, 2> MethodDescriptorProto::_table_ =
   // optional string name = 1;
   if (cached_has_bits & 0x00000001u) {
     const std::string& _s = this->_internal_name();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.MethodDescriptorProto.name");
+    if (!_impl_.name_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.MethodDescriptorProto.name");
+    }
     target = stream->WriteStringMaybeAliased(1, _s, target);
   }
 
   // optional string input_type = 2;
   if (cached_has_bits & 0x00000002u) {
     const std::string& _s = this->_internal_input_type();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.MethodDescriptorProto.input_type");
+    if (!_impl_.input_type_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.MethodDescriptorProto.input_type");
+    }
     target = stream->WriteStringMaybeAliased(2, _s, target);
   }
 
   // optional string output_type = 3;
   if (cached_has_bits & 0x00000004u) {
     const std::string& _s = this->_internal_output_type();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.MethodDescriptorProto.output_type");
+    if (!_impl_.output_type_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.MethodDescriptorProto.output_type");
+    }
     target = stream->WriteStringMaybeAliased(3, _s, target);
   }
 
@@ -7134,6 +7457,31 @@ constexpr ::_pbi::TcParseTable<3, 6, 1, 71, 2> MethodDescriptorProto::_table_ =
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t MethodDescriptorProto::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(MethodDescriptorProto);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  if (!_impl_.name_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.name_.Get());
+  }
+  if (!_impl_.input_type_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.input_type_.Get());
+  }
+  if (!_impl_.output_type_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.output_type_.Get());
+  }
+  if (_impl_.options_ != nullptr) {
+    total_size += _impl_.options_->SpaceUsedLong();
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData MethodDescriptorProto::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     MethodDescriptorProto::MergeImpl
@@ -7587,6 +7935,7 @@ constexpr ::_pbi::TcParseTable<5, 22, 3, 202, 12> FileOptions::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_FileOptions_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // optional string java_package = 1;
@@ -7759,16 +8108,20 @@ constexpr ::_pbi::TcParseTable<5, 22, 3, 202, 12> FileOptions::_table_ = {
   // optional string java_package = 1;
   if (cached_has_bits & 0x00000001u) {
     const std::string& _s = this->_internal_java_package();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.FileOptions.java_package");
+    if (!_impl_.java_package_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.FileOptions.java_package");
+    }
     target = stream->WriteStringMaybeAliased(1, _s, target);
   }
 
   // optional string java_outer_classname = 8;
   if (cached_has_bits & 0x00000002u) {
     const std::string& _s = this->_internal_java_outer_classname();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.FileOptions.java_outer_classname");
+    if (!_impl_.java_outer_classname_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.FileOptions.java_outer_classname");
+    }
     target = stream->WriteStringMaybeAliased(8, _s, target);
   }
 
@@ -7789,8 +8142,10 @@ constexpr ::_pbi::TcParseTable<5, 22, 3, 202, 12> FileOptions::_table_ = {
   // optional string go_package = 11;
   if (cached_has_bits & 0x00000004u) {
     const std::string& _s = this->_internal_go_package();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.FileOptions.go_package");
+    if (!_impl_.go_package_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.FileOptions.go_package");
+    }
     target = stream->WriteStringMaybeAliased(11, _s, target);
   }
 
@@ -7846,40 +8201,50 @@ constexpr ::_pbi::TcParseTable<5, 22, 3, 202, 12> FileOptions::_table_ = {
   // optional string objc_class_prefix = 36;
   if (cached_has_bits & 0x00000008u) {
     const std::string& _s = this->_internal_objc_class_prefix();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.FileOptions.objc_class_prefix");
+    if (!_impl_.objc_class_prefix_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.FileOptions.objc_class_prefix");
+    }
     target = stream->WriteStringMaybeAliased(36, _s, target);
   }
 
   // optional string csharp_namespace = 37;
   if (cached_has_bits & 0x00000010u) {
     const std::string& _s = this->_internal_csharp_namespace();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.FileOptions.csharp_namespace");
+    if (!_impl_.csharp_namespace_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.FileOptions.csharp_namespace");
+    }
     target = stream->WriteStringMaybeAliased(37, _s, target);
   }
 
   // optional string swift_prefix = 39;
   if (cached_has_bits & 0x00000020u) {
     const std::string& _s = this->_internal_swift_prefix();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.FileOptions.swift_prefix");
+    if (!_impl_.swift_prefix_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.FileOptions.swift_prefix");
+    }
     target = stream->WriteStringMaybeAliased(39, _s, target);
   }
 
   // optional string php_class_prefix = 40;
   if (cached_has_bits & 0x00000040u) {
     const std::string& _s = this->_internal_php_class_prefix();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.FileOptions.php_class_prefix");
+    if (!_impl_.php_class_prefix_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.FileOptions.php_class_prefix");
+    }
     target = stream->WriteStringMaybeAliased(40, _s, target);
   }
 
   // optional string php_namespace = 41;
   if (cached_has_bits & 0x00000080u) {
     const std::string& _s = this->_internal_php_namespace();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.FileOptions.php_namespace");
+    if (!_impl_.php_namespace_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.FileOptions.php_namespace");
+    }
     target = stream->WriteStringMaybeAliased(41, _s, target);
   }
 
@@ -7893,16 +8258,20 @@ constexpr ::_pbi::TcParseTable<5, 22, 3, 202, 12> FileOptions::_table_ = {
   // optional string php_metadata_namespace = 44;
   if (cached_has_bits & 0x00000100u) {
     const std::string& _s = this->_internal_php_metadata_namespace();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.FileOptions.php_metadata_namespace");
+    if (!_impl_.php_metadata_namespace_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.FileOptions.php_metadata_namespace");
+    }
     target = stream->WriteStringMaybeAliased(44, _s, target);
   }
 
   // optional string ruby_package = 45;
   if (cached_has_bits & 0x00000200u) {
     const std::string& _s = this->_internal_ruby_package();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.FileOptions.ruby_package");
+    if (!_impl_.ruby_package_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.FileOptions.ruby_package");
+    }
     target = stream->WriteStringMaybeAliased(45, _s, target);
   }
 
@@ -8077,6 +8446,61 @@ constexpr ::_pbi::TcParseTable<5, 22, 3, 202, 12> FileOptions::_table_ = {
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t FileOptions::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(FileOptions);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  total_size += _impl_._extensions_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.uninterpreted_option_.SpaceUsedExcludingSelfLong();
+  if (!_impl_.java_package_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.java_package_.Get());
+  }
+  if (!_impl_.java_outer_classname_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.java_outer_classname_.Get());
+  }
+  if (!_impl_.go_package_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.go_package_.Get());
+  }
+  if (!_impl_.objc_class_prefix_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.objc_class_prefix_.Get());
+  }
+  if (!_impl_.csharp_namespace_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.csharp_namespace_.Get());
+  }
+  if (!_impl_.swift_prefix_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.swift_prefix_.Get());
+  }
+  if (!_impl_.php_class_prefix_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.php_class_prefix_.Get());
+  }
+  if (!_impl_.php_namespace_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.php_namespace_.Get());
+  }
+  if (!_impl_.php_metadata_namespace_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.php_metadata_namespace_.Get());
+  }
+  if (!_impl_.ruby_package_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.ruby_package_.Get());
+  }
+  if (_impl_.features_ != nullptr) {
+    total_size += _impl_.features_->SpaceUsedLong();
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData FileOptions::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     FileOptions::MergeImpl
@@ -8150,20 +8574,28 @@ void FileOptions::MergeImpl(::google::protobuf::Message& to_msg, const ::google:
     _this->_impl_._has_bits_[0] |= cached_has_bits;
   }
   if (cached_has_bits & 0x001f0000u) {
-    if (cached_has_bits & 0x00010000u) {
-      _this->_impl_.py_generic_services_ = from._impl_.py_generic_services_;
-    }
-    if (cached_has_bits & 0x00020000u) {
-      _this->_impl_.php_generic_services_ = from._impl_.php_generic_services_;
-    }
-    if (cached_has_bits & 0x00040000u) {
-      _this->_impl_.deprecated_ = from._impl_.deprecated_;
-    }
-    if (cached_has_bits & 0x00080000u) {
-      _this->_impl_.optimize_for_ = from._impl_.optimize_for_;
-    }
-    if (cached_has_bits & 0x00100000u) {
-      _this->_impl_.cc_enable_arenas_ = from._impl_.cc_enable_arenas_;
+    if ((cached_has_bits & 0x001f0000u) == 0x001f0000u) {
+      ::memcpy(&_this->_impl_.py_generic_services_, &from._impl_.py_generic_services_,
+               static_cast<::size_t>(
+                   reinterpret_cast<const char*>(&from._impl_.cc_enable_arenas_) -
+                   reinterpret_cast<const char*>(&from._impl_.py_generic_services_)) +
+                   sizeof(from._impl_.cc_enable_arenas_));
+    } else {
+      if (cached_has_bits & 0x00010000u) {
+        _this->_impl_.py_generic_services_ = from._impl_.py_generic_services_;
+      }
+      if (cached_has_bits & 0x00020000u) {
+        _this->_impl_.php_generic_services_ = from._impl_.php_generic_services_;
+      }
+      if (cached_has_bits & 0x00040000u) {
+        _this->_impl_.deprecated_ = from._impl_.deprecated_;
+      }
+      if (cached_has_bits & 0x00080000u) {
+        _this->_impl_.optimize_for_ = from._impl_.optimize_for_;
+      }
+      if (cached_has_bits & 0x00100000u) {
+        _this->_impl_.cc_enable_arenas_ = from._impl_.cc_enable_arenas_;
+      }
     }
     _this->_impl_._has_bits_[0] |= cached_has_bits;
   }
@@ -8368,6 +8800,7 @@ constexpr ::_pbi::TcParseTable<3, 7, 2, 0, 7> MessageOptions::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_MessageOptions_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // optional bool message_set_wire_format = 1 [default = false];
@@ -8544,6 +8977,21 @@ constexpr ::_pbi::TcParseTable<3, 7, 2, 0, 7> MessageOptions::_table_ = {
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t MessageOptions::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(MessageOptions);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  total_size += _impl_._extensions_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.uninterpreted_option_.SpaceUsedExcludingSelfLong();
+  if (_impl_.features_ != nullptr) {
+    total_size += _impl_.features_->SpaceUsedLong();
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData MessageOptions::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     MessageOptions::MergeImpl
@@ -8745,6 +9193,7 @@ constexpr ::_pbi::TcParseTable<1, 2, 0, 64, 2> FieldOptions_EditionDefault::_tab
     offsetof(decltype(_table_), field_names),  // no aux_entries
     &_FieldOptions_EditionDefault_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     // optional string value = 2;
     {::_pbi::TcParser::FastSS1,
@@ -8782,16 +9231,20 @@ constexpr ::_pbi::TcParseTable<1, 2, 0, 64, 2> FieldOptions_EditionDefault::_tab
   // optional string edition = 1;
   if (cached_has_bits & 0x00000001u) {
     const std::string& _s = this->_internal_edition();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.FieldOptions.EditionDefault.edition");
+    if (!_impl_.edition_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.FieldOptions.EditionDefault.edition");
+    }
     target = stream->WriteStringMaybeAliased(1, _s, target);
   }
 
   // optional string value = 2;
   if (cached_has_bits & 0x00000002u) {
     const std::string& _s = this->_internal_value();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.FieldOptions.EditionDefault.value");
+    if (!_impl_.value_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.FieldOptions.EditionDefault.value");
+    }
     target = stream->WriteStringMaybeAliased(2, _s, target);
   }
 
@@ -8830,6 +9283,24 @@ constexpr ::_pbi::TcParseTable<1, 2, 0, 64, 2> FieldOptions_EditionDefault::_tab
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t FieldOptions_EditionDefault::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(FieldOptions_EditionDefault);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  if (!_impl_.edition_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.edition_.Get());
+  }
+  if (!_impl_.value_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.value_.Get());
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData FieldOptions_EditionDefault::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     FieldOptions_EditionDefault::MergeImpl
@@ -9055,6 +9526,7 @@ constexpr ::_pbi::TcParseTable<4, 13, 7, 0, 7> FieldOptions::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_FieldOptions_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     // optional bool debug_redact = 16 [default = false];
     {::_pbi::TcParser::FastV8S2,
@@ -9359,6 +9831,23 @@ constexpr ::_pbi::TcParseTable<4, 13, 7, 0, 7> FieldOptions::_table_ = {
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t FieldOptions::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(FieldOptions);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  total_size += _impl_._extensions_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.targets_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.edition_defaults_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.uninterpreted_option_.SpaceUsedExcludingSelfLong();
+  if (_impl_.features_ != nullptr) {
+    total_size += _impl_.features_->SpaceUsedLong();
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData FieldOptions::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     FieldOptions::MergeImpl
@@ -9409,11 +9898,19 @@ void FieldOptions::MergeImpl(::google::protobuf::Message& to_msg, const ::google
     _this->_impl_._has_bits_[0] |= cached_has_bits;
   }
   if (cached_has_bits & 0x00000300u) {
-    if (cached_has_bits & 0x00000100u) {
-      _this->_impl_.debug_redact_ = from._impl_.debug_redact_;
-    }
-    if (cached_has_bits & 0x00000200u) {
-      _this->_impl_.retention_ = from._impl_.retention_;
+    if ((cached_has_bits & 0x00000300u) == 0x00000300u) {
+      ::memcpy(&_this->_impl_.debug_redact_, &from._impl_.debug_redact_,
+               static_cast<::size_t>(
+                   reinterpret_cast<const char*>(&from._impl_.retention_) -
+                   reinterpret_cast<const char*>(&from._impl_.debug_redact_)) +
+                   sizeof(from._impl_.retention_));
+    } else {
+      if (cached_has_bits & 0x00000100u) {
+        _this->_impl_.debug_redact_ = from._impl_.debug_redact_;
+      }
+      if (cached_has_bits & 0x00000200u) {
+        _this->_impl_.retention_ = from._impl_.retention_;
+      }
     }
     _this->_impl_._has_bits_[0] |= cached_has_bits;
   }
@@ -9565,6 +10062,7 @@ constexpr ::_pbi::TcParseTable<2, 2, 2, 0, 7> OneofOptions::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_OneofOptions_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // optional .google.protobuf.FeatureSet features = 1;
@@ -9654,6 +10152,21 @@ constexpr ::_pbi::TcParseTable<2, 2, 2, 0, 7> OneofOptions::_table_ = {
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t OneofOptions::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(OneofOptions);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  total_size += _impl_._extensions_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.uninterpreted_option_.SpaceUsedExcludingSelfLong();
+  if (_impl_.features_ != nullptr) {
+    total_size += _impl_.features_->SpaceUsedLong();
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData OneofOptions::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     OneofOptions::MergeImpl
@@ -9837,6 +10350,7 @@ constexpr ::_pbi::TcParseTable<3, 5, 2, 0, 7> EnumOptions::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_EnumOptions_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     {::_pbi::TcParser::MiniParse, {}},
@@ -9981,6 +10495,21 @@ constexpr ::_pbi::TcParseTable<3, 5, 2, 0, 7> EnumOptions::_table_ = {
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t EnumOptions::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(EnumOptions);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  total_size += _impl_._extensions_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.uninterpreted_option_.SpaceUsedExcludingSelfLong();
+  if (_impl_.features_ != nullptr) {
+    total_size += _impl_.features_->SpaceUsedLong();
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData EnumOptions::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     EnumOptions::MergeImpl
@@ -10177,6 +10706,7 @@ constexpr ::_pbi::TcParseTable<3, 4, 2, 0, 7> EnumValueOptions::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_EnumValueOptions_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // optional bool deprecated = 1 [default = false];
@@ -10306,6 +10836,21 @@ constexpr ::_pbi::TcParseTable<3, 4, 2, 0, 7> EnumValueOptions::_table_ = {
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t EnumValueOptions::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(EnumValueOptions);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  total_size += _impl_._extensions_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.uninterpreted_option_.SpaceUsedExcludingSelfLong();
+  if (_impl_.features_ != nullptr) {
+    total_size += _impl_.features_->SpaceUsedLong();
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData EnumValueOptions::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     EnumValueOptions::MergeImpl
@@ -10490,6 +11035,7 @@ constexpr ::_pbi::TcParseTable<2, 3, 2, 0, 12> ServiceOptions::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_ServiceOptions_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // optional bool deprecated = 33 [default = false];
@@ -10599,6 +11145,21 @@ constexpr ::_pbi::TcParseTable<2, 3, 2, 0, 12> ServiceOptions::_table_ = {
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t ServiceOptions::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(ServiceOptions);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  total_size += _impl_._extensions_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.uninterpreted_option_.SpaceUsedExcludingSelfLong();
+  if (_impl_.features_ != nullptr) {
+    total_size += _impl_.features_->SpaceUsedLong();
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData ServiceOptions::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     ServiceOptions::MergeImpl
@@ -10791,6 +11352,7 @@ constexpr ::_pbi::TcParseTable<3, 4, 3, 0, 12> MethodOptions::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_MethodOptions_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // optional bool deprecated = 33 [default = false];
@@ -10923,6 +11485,21 @@ constexpr ::_pbi::TcParseTable<3, 4, 3, 0, 12> MethodOptions::_table_ = {
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t MethodOptions::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(MethodOptions);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  total_size += _impl_._extensions_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.uninterpreted_option_.SpaceUsedExcludingSelfLong();
+  if (_impl_.features_ != nullptr) {
+    total_size += _impl_.features_->SpaceUsedLong();
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData MethodOptions::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     MethodOptions::MergeImpl
@@ -11103,6 +11680,7 @@ constexpr ::_pbi::TcParseTable<1, 2, 0, 62, 2> UninterpretedOption_NamePart::_ta
     offsetof(decltype(_table_), field_names),  // no aux_entries
     &_UninterpretedOption_NamePart_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 3,  // required_has_bits_word, required_has_bits
   }, {{
     // required bool is_extension = 2;
     {::_pbi::TcParser::SingularVarintNoZag1<bool, offsetof(UninterpretedOption_NamePart, _impl_.is_extension_), 1>(),
@@ -11139,8 +11717,10 @@ constexpr ::_pbi::TcParseTable<1, 2, 0, 62, 2> UninterpretedOption_NamePart::_ta
   // required string name_part = 1;
   if (cached_has_bits & 0x00000001u) {
     const std::string& _s = this->_internal_name_part();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.UninterpretedOption.NamePart.name_part");
+    if (!_impl_.name_part_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.UninterpretedOption.NamePart.name_part");
+    }
     target = stream->WriteStringMaybeAliased(1, _s, target);
   }
 
@@ -11185,6 +11765,20 @@ constexpr ::_pbi::TcParseTable<1, 2, 0, 62, 2> UninterpretedOption_NamePart::_ta
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t UninterpretedOption_NamePart::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(UninterpretedOption_NamePart);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  if (!_impl_.name_part_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.name_part_.Get());
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData UninterpretedOption_NamePart::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     UninterpretedOption_NamePart::MergeImpl
@@ -11409,6 +12003,7 @@ constexpr ::_pbi::TcParseTable<3, 7, 1, 75, 2> UninterpretedOption::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_UninterpretedOption_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     // optional string aggregate_value = 8;
     {::_pbi::TcParser::FastSS1,
@@ -11485,8 +12080,10 @@ constexpr ::_pbi::TcParseTable<3, 7, 1, 75, 2> UninterpretedOption::_table_ = {
   // optional string identifier_value = 3;
   if (cached_has_bits & 0x00000001u) {
     const std::string& _s = this->_internal_identifier_value();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.UninterpretedOption.identifier_value");
+    if (!_impl_.identifier_value_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.UninterpretedOption.identifier_value");
+    }
     target = stream->WriteStringMaybeAliased(3, _s, target);
   }
 
@@ -11520,8 +12117,10 @@ constexpr ::_pbi::TcParseTable<3, 7, 1, 75, 2> UninterpretedOption::_table_ = {
   // optional string aggregate_value = 8;
   if (cached_has_bits & 0x00000004u) {
     const std::string& _s = this->_internal_aggregate_value();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.UninterpretedOption.aggregate_value");
+    if (!_impl_.aggregate_value_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.UninterpretedOption.aggregate_value");
+    }
     target = stream->WriteStringMaybeAliased(8, _s, target);
   }
 
@@ -11589,6 +12188,29 @@ constexpr ::_pbi::TcParseTable<3, 7, 1, 75, 2> UninterpretedOption::_table_ = {
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t UninterpretedOption::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(UninterpretedOption);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  total_size += _impl_.name_.SpaceUsedExcludingSelfLong();
+  if (!_impl_.identifier_value_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.identifier_value_.Get());
+  }
+  if (!_impl_.string_value_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.string_value_.Get());
+  }
+  if (!_impl_.aggregate_value_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.aggregate_value_.Get());
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData UninterpretedOption::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     UninterpretedOption::MergeImpl
@@ -11786,6 +12408,7 @@ constexpr ::_pbi::TcParseTable<3, 5, 5, 0, 2> FeatureSet::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_FeatureSet_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // optional .google.protobuf.FeatureSet.FieldPresence field_presence = 1 [retention = RETENTION_RUNTIME, targets = TARGET_TYPE_FIELD, targets = TARGET_TYPE_FILE, edition_defaults = {
@@ -11934,6 +12557,17 @@ constexpr ::_pbi::TcParseTable<3, 5, 5, 0, 2> FeatureSet::_table_ = {
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t FeatureSet::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(FeatureSet);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  total_size += _impl_._extensions_.SpaceUsedExcludingSelfLong();
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData FeatureSet::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     FeatureSet::MergeImpl
@@ -11951,20 +12585,28 @@ void FeatureSet::MergeImpl(::google::protobuf::Message& to_msg, const ::google::
 
   cached_has_bits = from._impl_._has_bits_[0];
   if (cached_has_bits & 0x0000001fu) {
-    if (cached_has_bits & 0x00000001u) {
-      _this->_impl_.field_presence_ = from._impl_.field_presence_;
-    }
-    if (cached_has_bits & 0x00000002u) {
-      _this->_impl_.enum_type_ = from._impl_.enum_type_;
-    }
-    if (cached_has_bits & 0x00000004u) {
-      _this->_impl_.repeated_field_encoding_ = from._impl_.repeated_field_encoding_;
-    }
-    if (cached_has_bits & 0x00000008u) {
-      _this->_impl_.message_encoding_ = from._impl_.message_encoding_;
-    }
-    if (cached_has_bits & 0x00000010u) {
-      _this->_impl_.json_format_ = from._impl_.json_format_;
+    if ((cached_has_bits & 0x0000001fu) == 0x0000001fu) {
+      ::memcpy(&_this->_impl_.field_presence_, &from._impl_.field_presence_,
+               static_cast<::size_t>(
+                   reinterpret_cast<const char*>(&from._impl_.json_format_) -
+                   reinterpret_cast<const char*>(&from._impl_.field_presence_)) +
+                   sizeof(from._impl_.json_format_));
+    } else {
+      if (cached_has_bits & 0x00000001u) {
+        _this->_impl_.field_presence_ = from._impl_.field_presence_;
+      }
+      if (cached_has_bits & 0x00000002u) {
+        _this->_impl_.enum_type_ = from._impl_.enum_type_;
+      }
+      if (cached_has_bits & 0x00000004u) {
+        _this->_impl_.repeated_field_encoding_ = from._impl_.repeated_field_encoding_;
+      }
+      if (cached_has_bits & 0x00000008u) {
+        _this->_impl_.message_encoding_ = from._impl_.message_encoding_;
+      }
+      if (cached_has_bits & 0x00000010u) {
+        _this->_impl_.json_format_ = from._impl_.json_format_;
+      }
     }
     _this->_impl_._has_bits_[0] |= cached_has_bits;
   }
@@ -12120,6 +12762,7 @@ constexpr ::_pbi::TcParseTable<1, 2, 1, 75, 2> FeatureSetDefaults_FeatureSetEdit
     offsetof(decltype(_table_), aux_entries),
     &_FeatureSetDefaults_FeatureSetEditionDefault_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     // optional .google.protobuf.FeatureSet features = 2;
     {::_pbi::TcParser::FastMtS1,
@@ -12156,8 +12799,10 @@ constexpr ::_pbi::TcParseTable<1, 2, 1, 75, 2> FeatureSetDefaults_FeatureSetEdit
   // optional string edition = 1;
   if (cached_has_bits & 0x00000001u) {
     const std::string& _s = this->_internal_edition();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.FeatureSetDefaults.FeatureSetEditionDefault.edition");
+    if (!_impl_.edition_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.FeatureSetDefaults.FeatureSetEditionDefault.edition");
+    }
     target = stream->WriteStringMaybeAliased(1, _s, target);
   }
 
@@ -12204,6 +12849,23 @@ constexpr ::_pbi::TcParseTable<1, 2, 1, 75, 2> FeatureSetDefaults_FeatureSetEdit
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t FeatureSetDefaults_FeatureSetEditionDefault::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(FeatureSetDefaults_FeatureSetEditionDefault);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  if (!_impl_.edition_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.edition_.Get());
+  }
+  if (_impl_.features_ != nullptr) {
+    total_size += _impl_.features_->SpaceUsedLong();
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData FeatureSetDefaults_FeatureSetEditionDefault::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     FeatureSetDefaults_FeatureSetEditionDefault::MergeImpl
@@ -12385,6 +13047,7 @@ constexpr ::_pbi::TcParseTable<2, 3, 1, 73, 2> FeatureSetDefaults::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_FeatureSetDefaults_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // repeated .google.protobuf.FeatureSetDefaults.FeatureSetEditionDefault defaults = 1;
@@ -12437,16 +13100,20 @@ constexpr ::_pbi::TcParseTable<2, 3, 1, 73, 2> FeatureSetDefaults::_table_ = {
   // optional string minimum_edition = 2;
   if (cached_has_bits & 0x00000001u) {
     const std::string& _s = this->_internal_minimum_edition();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.FeatureSetDefaults.minimum_edition");
+    if (!_impl_.minimum_edition_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.FeatureSetDefaults.minimum_edition");
+    }
     target = stream->WriteStringMaybeAliased(2, _s, target);
   }
 
   // optional string maximum_edition = 3;
   if (cached_has_bits & 0x00000002u) {
     const std::string& _s = this->_internal_maximum_edition();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.FeatureSetDefaults.maximum_edition");
+    if (!_impl_.maximum_edition_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.FeatureSetDefaults.maximum_edition");
+    }
     target = stream->WriteStringMaybeAliased(3, _s, target);
   }
 
@@ -12491,6 +13158,25 @@ constexpr ::_pbi::TcParseTable<2, 3, 1, 73, 2> FeatureSetDefaults::_table_ = {
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t FeatureSetDefaults::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(FeatureSetDefaults);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  total_size += _impl_.defaults_.SpaceUsedExcludingSelfLong();
+  if (!_impl_.minimum_edition_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.minimum_edition_.Get());
+  }
+  if (!_impl_.maximum_edition_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.maximum_edition_.Get());
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData FeatureSetDefaults::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     FeatureSetDefaults::MergeImpl
@@ -12686,6 +13372,7 @@ constexpr ::_pbi::TcParseTable<3, 5, 0, 106, 2> SourceCodeInfo_Location::_table_
     offsetof(decltype(_table_), field_names),  // no aux_entries
     &_SourceCodeInfo_Location_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // repeated int32 path = 1 [packed = true];
@@ -12763,16 +13450,20 @@ constexpr ::_pbi::TcParseTable<3, 5, 0, 106, 2> SourceCodeInfo_Location::_table_
   // optional string leading_comments = 3;
   if (cached_has_bits & 0x00000001u) {
     const std::string& _s = this->_internal_leading_comments();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.SourceCodeInfo.Location.leading_comments");
+    if (!_impl_.leading_comments_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.SourceCodeInfo.Location.leading_comments");
+    }
     target = stream->WriteStringMaybeAliased(3, _s, target);
   }
 
   // optional string trailing_comments = 4;
   if (cached_has_bits & 0x00000002u) {
     const std::string& _s = this->_internal_trailing_comments();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.SourceCodeInfo.Location.trailing_comments");
+    if (!_impl_.trailing_comments_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.SourceCodeInfo.Location.trailing_comments");
+    }
     target = stream->WriteStringMaybeAliased(4, _s, target);
   }
 
@@ -12851,6 +13542,27 @@ constexpr ::_pbi::TcParseTable<3, 5, 0, 106, 2> SourceCodeInfo_Location::_table_
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t SourceCodeInfo_Location::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(SourceCodeInfo_Location);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  total_size += _impl_.path_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.span_.SpaceUsedExcludingSelfLong();
+  total_size += _impl_.leading_detached_comments_.SpaceUsedExcludingSelfLong();
+  if (!_impl_.leading_comments_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.leading_comments_.Get());
+  }
+  if (!_impl_.trailing_comments_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.trailing_comments_.Get());
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData SourceCodeInfo_Location::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     SourceCodeInfo_Location::MergeImpl
@@ -12986,6 +13698,7 @@ constexpr ::_pbi::TcParseTable<0, 1, 1, 0, 2> SourceCodeInfo::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_SourceCodeInfo_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     // repeated .google.protobuf.SourceCodeInfo.Location location = 1;
     {::_pbi::TcParser::FastMtR1,
@@ -13043,6 +13756,17 @@ constexpr ::_pbi::TcParseTable<0, 1, 1, 0, 2> SourceCodeInfo::_table_ = {
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t SourceCodeInfo::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(SourceCodeInfo);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  total_size += _impl_.location_.SpaceUsedExcludingSelfLong();
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData SourceCodeInfo::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     SourceCodeInfo::MergeImpl
@@ -13211,6 +13935,7 @@ constexpr ::_pbi::TcParseTable<3, 5, 1, 64, 2> GeneratedCodeInfo_Annotation::_ta
     offsetof(decltype(_table_), aux_entries),
     &_GeneratedCodeInfo_Annotation_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // repeated int32 path = 1 [packed = true];
@@ -13277,8 +14002,10 @@ constexpr ::_pbi::TcParseTable<3, 5, 1, 64, 2> GeneratedCodeInfo_Annotation::_ta
   // optional string source_file = 2;
   if (cached_has_bits & 0x00000001u) {
     const std::string& _s = this->_internal_source_file();
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
-                                "google.protobuf.GeneratedCodeInfo.Annotation.source_file");
+    if (!_impl_.source_file_.IsUtf8Validated()) {
+      ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(_s.data(), static_cast<int>(_s.length()), ::google::protobuf::internal::WireFormat::SERIALIZE,
+                                  "google.protobuf.GeneratedCodeInfo.Annotation.source_file");
+    }
     target = stream->WriteStringMaybeAliased(2, _s, target);
   }
 
@@ -13363,6 +14090,21 @@ constexpr ::_pbi::TcParseTable<3, 5, 1, 64, 2> GeneratedCodeInfo_Annotation::_ta
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t GeneratedCodeInfo_Annotation::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(GeneratedCodeInfo_Annotation);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  total_size += _impl_.path_.SpaceUsedExcludingSelfLong();
+  if (!_impl_.source_file_.IsDefault()) {
+    total_size += sizeof(std::string) +
+                  ::_pbi::StringSpaceUsedExcludingSelfLong(_impl_.source_file_.Get());
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData GeneratedCodeInfo_Annotation::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     GeneratedCodeInfo_Annotation::MergeImpl
@@ -13505,6 +14247,7 @@ constexpr ::_pbi::TcParseTable<0, 1, 1, 0, 2> GeneratedCodeInfo::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_GeneratedCodeInfo_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     // repeated .google.protobuf.GeneratedCodeInfo.Annotation annotation = 1;
     {::_pbi::TcParser::FastMtR1,
@@ -13562,6 +14305,17 @@ constexpr ::_pbi::TcParseTable<0, 1, 1, 0, 2> GeneratedCodeInfo::_table_ = {
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t GeneratedCodeInfo::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(GeneratedCodeInfo);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  total_size += _impl_.annotation_.SpaceUsedExcludingSelfLong();
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData GeneratedCodeInfo::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     GeneratedCodeInfo::MergeImpl
@@ -31,6 +31,7 @@
 #include "google/protobuf/message.h"
 #include "google/protobuf/repeated_field.h"  // IWYU pragma: export
 #include "google/protobuf/extension_set.h"  // IWYU pragma: export
+#include "absl/types/span.h"
 #include "google/protobuf/generated_enum_reflection.h"
 #include "google/protobuf/unknown_field_set.h"
 // @@protoc_insertion_point(includes)
@@ -744,6 +745,7 @@ class PROTOBUF_EXPORT UninterpretedOption_NamePart final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -932,6 +934,7 @@ class PROTOBUF_EXPORT SourceCodeInfo_Location final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -980,6 +983,10 @@ class PROTOBUF_EXPORT SourceCodeInfo_Location final :
   void add_path(::int32_t value);
   const ::google::protobuf::RepeatedField<::int32_t>& path() const;
   ::google::protobuf::RepeatedField<::int32_t>* mutable_path();
+  absl::Span<const ::int32_t> path_span() const;
+  absl::Span<::int32_t> mutable_path_span();
+  void assign_path(absl::Span<const ::int32_t> values);
+  absl::Span<::int32_t> add_n_path(int n);
 
   private:
   const ::google::protobuf::RepeatedField<::int32_t>& _internal_path() const;
@@ -998,6 +1005,10 @@ class PROTOBUF_EXPORT SourceCodeInfo_Location final :
   void add_span(::int32_t value);
   const ::google::protobuf::RepeatedField<::int32_t>& span() const;
   ::google::protobuf::RepeatedField<::int32_t>* mutable_span();
+  absl::Span<const ::int32_t> span_span() const;
+  absl::Span<::int32_t> mutable_span_span();
+  void assign_span(absl::Span<const ::int32_t> values);
+  absl::Span<::int32_t> add_n_span(int n);
 
   private:
   const ::google::protobuf::RepeatedField<::int32_t>& _internal_span() const;
@@ -1198,6 +1209,7 @@ class PROTOBUF_EXPORT GeneratedCodeInfo_Annotation final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -1267,6 +1279,10 @@ class PROTOBUF_EXPORT GeneratedCodeInfo_Annotation final :
   void add_path(::int32_t value);
   const ::google::protobuf::RepeatedField<::int32_t>& path() const;
   ::google::protobuf::RepeatedField<::int32_t>* mutable_path();
+  absl::Span<const ::int32_t> path_span() const;
+  absl::Span<::int32_t> mutable_path_span();
+  void assign_path(absl::Span<const ::int32_t> values);
+  absl::Span<::int32_t> add_n_path(int n);
 
   private:
   const ::google::protobuf::RepeatedField<::int32_t>& _internal_path() const;
@@ -1454,6 +1470,7 @@ class PROTOBUF_EXPORT FieldOptions_EditionDefault final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -1648,6 +1665,7 @@ class PROTOBUF_EXPORT FeatureSet final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -2128,6 +2146,7 @@ class PROTOBUF_EXPORT ExtensionRangeOptions_Declaration final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -2361,6 +2380,7 @@ class PROTOBUF_EXPORT EnumDescriptorProto_EnumReservedRange final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -2543,6 +2563,7 @@ class PROTOBUF_EXPORT DescriptorProto_ReservedRange final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -2725,6 +2746,7 @@ class PROTOBUF_EXPORT UninterpretedOption final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -2999,6 +3021,7 @@ class PROTOBUF_EXPORT SourceCodeInfo final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -3176,6 +3199,7 @@ class PROTOBUF_EXPORT GeneratedCodeInfo final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -3353,6 +3377,7 @@ class PROTOBUF_EXPORT FeatureSetDefaults_FeatureSetEditionDefault final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -3545,6 +3570,7 @@ class PROTOBUF_EXPORT ServiceOptions final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -3904,6 +3930,7 @@ class PROTOBUF_EXPORT OneofOptions final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -4250,6 +4277,7 @@ class PROTOBUF_EXPORT MethodOptions final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -4643,6 +4671,7 @@ class PROTOBUF_EXPORT MessageOptions final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -5054,6 +5083,7 @@ class PROTOBUF_EXPORT FileOptions final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -5741,6 +5771,7 @@ class PROTOBUF_EXPORT FieldOptions final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -6338,6 +6369,7 @@ class PROTOBUF_EXPORT FeatureSetDefaults final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -6554,6 +6586,7 @@ class PROTOBUF_EXPORT ExtensionRangeOptions final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -6955,6 +6988,7 @@ class PROTOBUF_EXPORT EnumValueOptions final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -7327,6 +7361,7 @@ class PROTOBUF_EXPORT EnumOptions final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -7712,6 +7747,7 @@ class PROTOBUF_EXPORT OneofDescriptorProto final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -7904,6 +7940,7 @@ class PROTOBUF_EXPORT MethodDescriptorProto final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -8160,6 +8197,7 @@ class PROTOBUF_EXPORT FieldDescriptorProto final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -8550,6 +8588,7 @@ class PROTOBUF_EXPORT EnumValueDescriptorProto final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -8755,6 +8794,7 @@ class PROTOBUF_EXPORT DescriptorProto_ExtensionRange final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -8954,6 +8994,7 @@ class PROTOBUF_EXPORT ServiceDescriptorProto final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -9166,6 +9207,7 @@ class PROTOBUF_EXPORT EnumDescriptorProto final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -9430,6 +9472,7 @@ class PROTOBUF_EXPORT DescriptorProto final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -9795,6 +9838,7 @@ class PROTOBUF_EXPORT FileDescriptorProto final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -9951,6 +9995,10 @@ class PROTOBUF_EXPORT FileDescriptorProto final :
   void add_public_dependency(::int32_t value);
   const ::google::protobuf::RepeatedField<::int32_t>& public_dependency() const;
   ::google::protobuf::RepeatedField<::int32_t>* mutable_public_dependency();
+  absl::Span<const ::int32_t> public_dependency_span() const;
+  absl::Span<::int32_t> mutable_public_dependency_span();
+  void assign_public_dependency(absl::Span<const ::int32_t> values);
+  absl::Span<::int32_t> add_n_public_dependency(int n);
 
   private:
   const ::google::protobuf::RepeatedField<::int32_t>& _internal_public_dependency() const;
@@ -9969,6 +10017,10 @@ class PROTOBUF_EXPORT FileDescriptorProto final :
   void add_weak_dependency(::int32_t value);
   const ::google::protobuf::RepeatedField<::int32_t>& weak_dependency() const;
   ::google::protobuf::RepeatedField<::int32_t>* mutable_weak_dependency();
+  absl::Span<const ::int32_t> weak_dependency_span() const;
+  absl::Span<::int32_t> mutable_weak_dependency_span();
+  void assign_weak_dependency(absl::Span<const ::int32_t> values);
+  absl::Span<::int32_t> add_n_weak_dependency(int n);
 
   private:
   const ::google::protobuf::RepeatedField<::int32_t>& _internal_weak_dependency() const;
@@ -10211,6 +10263,7 @@ class PROTOBUF_EXPORT FileDescriptorSet final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -10287,6 +10340,7 @@ class PROTOBUF_EXPORT FileDescriptorSet final :
 
 
 
+
 // ===================================================================
 
 
@@ -10627,6 +10681,25 @@ inline ::google::protobuf::RepeatedField<::int32_t>* FileDescriptorProto::mutabl
   PROTOBUF_TSAN_WRITE(&_impl_._tsan_detect_race);
   return _internal_mutable_public_dependency();
 }
+inline absl::Span<const ::int32_t> FileDescriptorProto::public_dependency_span() const {
+  const auto& field = _internal_public_dependency();
+  return absl::MakeConstSpan(field.data(), field.size());
+}
+inline absl::Span<::int32_t> FileDescriptorProto::mutable_public_dependency_span() {
+  PROTOBUF_TSAN_WRITE(&_impl_._tsan_detect_race);
+  auto* field = _internal_mutable_public_dependency();
+  return absl::MakeSpan(field->mutable_data(), field->size());
+}
+inline void FileDescriptorProto::assign_public_dependency(absl::Span<const ::int32_t> values) {
+  PROTOBUF_TSAN_WRITE(&_impl_._tsan_detect_race);
+  _internal_mutable_public_dependency()->Assign(values.begin(), values.end());
+}
+inline absl::Span<::int32_t> FileDescriptorProto::add_n_public_dependency(int n) {
+  PROTOBUF_TSAN_WRITE(&_impl_._tsan_detect_race);
+  auto* field = _internal_mutable_public_dependency();
+  field->Reserve(field->size() + n);
+  return absl::MakeSpan(field->AddNAlreadyReserved(n), n);
+}
 inline const ::google::protobuf::RepeatedField<::int32_t>& FileDescriptorProto::_internal_public_dependency()
     const {
   PROTOBUF_TSAN_READ(&_impl_._tsan_detect_race);
@@ -10670,6 +10743,25 @@ inline ::google::protobuf::RepeatedField<::int32_t>* FileDescriptorProto::mutabl
   PROTOBUF_TSAN_WRITE(&_impl_._tsan_detect_race);
   return _internal_mutable_weak_dependency();
 }
+inline absl::Span<const ::int32_t> FileDescriptorProto::weak_dependency_span() const {
+  const auto& field = _internal_weak_dependency();
+  return absl::MakeConstSpan(field.data(), field.size());
+}
+inline absl::Span<::int32_t> FileDescriptorProto::mutable_weak_dependency_span() {
+  PROTOBUF_TSAN_WRITE(&_impl_._tsan_detect_race);
+  auto* field = _internal_mutable_weak_dependency();
+  return absl::MakeSpan(field->mutable_data(), field->size());
+}
+inline void FileDescriptorProto::assign_weak_dependency(absl::Span<const ::int32_t> values) {
+  PROTOBUF_TSAN_WRITE(&_impl_._tsan_detect_race);
+  _internal_mutable_weak_dependency()->Assign(values.begin(), values.end());
+}
+inline absl::Span<::int32_t> FileDescriptorProto::add_n_weak_dependency(int n) {
+  PROTOBUF_TSAN_WRITE(&_impl_._tsan_detect_race);
+  auto* field = _internal_mutable_weak_dependency();
+  field->Reserve(field->size() + n);
+  return absl::MakeSpan(field->AddNAlreadyReserved(n), n);
+}
 inline const ::google::protobuf::RepeatedField<::int32_t>& FileDescriptorProto::_internal_weak_dependency()
     const {
   PROTOBUF_TSAN_READ(&_impl_._tsan_detect_race);
@@ -18551,6 +18643,25 @@ inline ::google::protobuf::RepeatedField<::int32_t>* SourceCodeInfo_Location::mu
   PROTOBUF_TSAN_WRITE(&_impl_._tsan_detect_race);
   return _internal_mutable_path();
 }
+inline absl::Span<const ::int32_t> SourceCodeInfo_Location::path_span() const {
+  const auto& field = _internal_path();
+  return absl::MakeConstSpan(field.data(), field.size());
+}
+inline absl::Span<::int32_t> SourceCodeInfo_Location::mutable_path_span() {
+  PROTOBUF_TSAN_WRITE(&_impl_._tsan_detect_race);
+  auto* field = _internal_mutable_path();
+  return absl::MakeSpan(field->mutable_data(), field->size());
+}
+inline void SourceCodeInfo_Location::assign_path(absl::Span<const ::int32_t> values) {
+  PROTOBUF_TSAN_WRITE(&_impl_._tsan_detect_race);
+  _internal_mutable_path()->Assign(values.begin(), values.end());
+}
+inline absl::Span<::int32_t> SourceCodeInfo_Location::add_n_path(int n) {
+  PROTOBUF_TSAN_WRITE(&_impl_._tsan_detect_race);
+  auto* field = _internal_mutable_path();
+  field->Reserve(field->size() + n);
+  return absl::MakeSpan(field->AddNAlreadyReserved(n), n);
+}
 inline const ::google::protobuf::RepeatedField<::int32_t>& SourceCodeInfo_Location::_internal_path()
     const {
   PROTOBUF_TSAN_READ(&_impl_._tsan_detect_race);
@@ -18594,6 +18705,25 @@ inline ::google::protobuf::RepeatedField<::int32_t>* SourceCodeInfo_Location::mu
   PROTOBUF_TSAN_WRITE(&_impl_._tsan_detect_race);
   return _internal_mutable_span();
 }
+inline absl::Span<const ::int32_t> SourceCodeInfo_Location::span_span() const {
+  const auto& field = _internal_span();
+  return absl::MakeConstSpan(field.data(), field.size());
+}
+inline absl::Span<::int32_t> SourceCodeInfo_Location::mutable_span_span() {
+  PROTOBUF_TSAN_WRITE(&_impl_._tsan_detect_race);
+  auto* field = _internal_mutable_span();
+  return absl::MakeSpan(field->mutable_data(), field->size());
+}
+inline void SourceCodeInfo_Location::assign_span(absl::Span<const ::int32_t> values) {
+  PROTOBUF_TSAN_WRITE(&_impl_._tsan_detect_race);
+  _internal_mutable_span()->Assign(values.begin(), values.end());
+}
+inline absl::Span<::int32_t> SourceCodeInfo_Location::add_n_span(int n) {
+  PROTOBUF_TSAN_WRITE(&_impl_._tsan_detect_race);
+  auto* field = _internal_mutable_span();
+  field->Reserve(field->size() + n);
+  return absl::MakeSpan(field->AddNAlreadyReserved(n), n);
+}
 inline const ::google::protobuf::RepeatedField<::int32_t>& SourceCodeInfo_Location::_internal_span()
     const {
   PROTOBUF_TSAN_READ(&_impl_._tsan_detect_race);
@@ -18937,6 +19067,25 @@ inline ::google::protobuf::RepeatedField<::int32_t>* GeneratedCodeInfo_Annotatio
   PROTOBUF_TSAN_WRITE(&_impl_._tsan_detect_race);
   return _internal_mutable_path();
 }
+inline absl::Span<const ::int32_t> GeneratedCodeInfo_Annotation::path_span() const {
+  const auto& field = _internal_path();
+  return absl::MakeConstSpan(field.data(), field.size());
+}
+inline absl::Span<::int32_t> GeneratedCodeInfo_Annotation::mutable_path_span() {
+  PROTOBUF_TSAN_WRITE(&_impl_._tsan_detect_race);
+  auto* field = _internal_mutable_path();
+  return absl::MakeSpan(field->mutable_data(), field->size());
+}
+inline void GeneratedCodeInfo_Annotation::assign_path(absl::Span<const ::int32_t> values) {
+  PROTOBUF_TSAN_WRITE(&_impl_._tsan_detect_race);
+  _internal_mutable_path()->Assign(values.begin(), values.end());
+}
+inline absl::Span<::int32_t> GeneratedCodeInfo_Annotation::add_n_path(int n) {
+  PROTOBUF_TSAN_WRITE(&_impl_._tsan_detect_race);
+  auto* field = _internal_mutable_path();
+  field->Reserve(field->size() + n);
+  return absl::MakeSpan(field->AddNAlreadyReserved(n), n);
+}
 inline const ::google::protobuf::RepeatedField<::int32_t>& GeneratedCodeInfo_Annotation::_internal_path()
     const {
   PROTOBUF_TSAN_READ(&_impl_._tsan_detect_race);
@@ -35,7 +35,11 @@
 #include "google/protobuf/descriptor_database.h"
 
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
 #include <string>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -45,6 +49,8 @@
 #include "absl/strings/str_replace.h"
 #include "absl/strings/string_view.h"
 #include "google/protobuf/descriptor.pb.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/wire_format_lite.h"
 
 
 namespace google {
@@ -564,10 +570,201 @@ class EncodedDescriptorDatabase::DescriptorIndex {
   std::vector<ExtensionEntry> by_extension_flat_;
 };
 
+namespace {
+
+// The parts of an encoded FileDescriptorProto that DescriptorIndex::AddFile
+// reads, scanned straight from the wire format.  Every generated file is
+// added to the generated pool's database at startup, and fully parsing each
+// one just to index a few names was most of that cost.  The strings point
+// into the encoded data.
+struct EncodedSymbolView {
+  absl::string_view name_;
+
+  absl::string_view name() const { return name_; }
+};
+
+struct EncodedExtensionView {
+  absl::string_view name_;
+  absl::string_view extendee_;
+  int32_t number_ = 0;
+
+  absl::string_view name() const { return name_; }
+  absl::string_view extendee() const { return extendee_; }
+  int32_t number() const { return number_; }
+};
+
+struct EncodedMessageView {
+  absl::string_view name_;
+  std::vector<EncodedMessageView> nested_type_;
+  std::vector<EncodedExtensionView> extension_;
+
+  absl::string_view name() const { return name_; }
+  const std::vector<EncodedMessageView>& nested_type() const {
+    return nested_type_;
+  }
+  const std::vector<EncodedExtensionView>& extension() const {
+    return extension_;
+  }
+};
+
+struct EncodedFileView {
+  absl::string_view name_;
+  absl::string_view package_;
+  std::vector<EncodedMessageView> message_type_;
+  std::vector<EncodedSymbolView> enum_type_;
+  std::vector<EncodedExtensionView> extension_;
+  std::vector<EncodedSymbolView> service_;
+
+  absl::string_view name() const { return name_; }
+  absl::string_view package() const { return package_; }
+  const std::vector<EncodedMessageView>& message_type() const {
+    return message_type_;
+  }
+  const std::vector<EncodedSymbolView>& enum_type() const { return enum_type_; }
+  const std::vector<EncodedExtensionView>& extension() const {
+    return extension_;
+  }
+  const std::vector<EncodedSymbolView>& service() const { return service_; }
+};
+
+using WireFormatLite = internal::WireFormatLite;
+
+constexpr uint32_t LengthDelimitedTag(int field_number) {
+  return WireFormatLite::MakeTag(field_number,
+                                 WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+}
+
+bool ScanString(io::CodedInputStream* input, absl::string_view* output) {
+  int length;
+  if (!input->ReadVarintSizeAsInt(&length)) return false;
+  if (length == 0) {
+    *output = absl::string_view();
+    return true;
+  }
+  const void* data;
+  int size;
+  if (!input->GetDirectBufferPointer(&data, &size) || size < length) {
+    return false;
+  }
+  *output = absl::string_view(static_cast<const char*>(data), length);
+  return input->Skip(length);
+}
+
+bool Scan(io::CodedInputStream* input, EncodedSymbolView* symbol);
+bool Scan(io::CodedInputStream* input, EncodedExtensionView* extension);
+bool Scan(io::CodedInputStream* input, EncodedMessageView* message);
+
+template <typename View>
+bool ScanSubMessage(io::CodedInputStream* input, std::vector<View>* output) {
+  int length;
+  if (!input->ReadVarintSizeAsInt(&length)) return false;
+  if (!input->IncrementRecursionDepth()) return false;
+  io::CodedInputStream::Limit limit = input->PushLimit(length);
+  output->emplace_back();
+  const bool ok = Scan(input, &output->back());
+  input->PopLimit(limit);
+  input->DecrementRecursionDepth();
+  return ok;
+}
+
+bool Scan(io::CodedInputStream* input, EncodedSymbolView* symbol) {
+  while (uint32_t tag = input->ReadTag()) {
+    if (tag == LengthDelimitedTag(EnumDescriptorProto::kNameFieldNumber)) {
+      if (!ScanString(input, &symbol->name_)) return false;
+    } else if (!WireFormatLite::SkipField(input, tag)) {
+      return false;
+    }
+  }
+  return input->ConsumedEntireMessage();
+}
+
+bool Scan(io::CodedInputStream* input, EncodedExtensionView* extension) {
+  constexpr uint32_t kNumberTag =
+      WireFormatLite::MakeTag(FieldDescriptorProto::kNumberFieldNumber,
+                              WireFormatLite::WIRETYPE_VARINT);
+  while (uint32_t tag = input->ReadTag()) {
+    bool ok;
+    switch (tag) {
+      case LengthDelimitedTag(FieldDescriptorProto::kNameFieldNumber):
+        ok = ScanString(input, &extension->name_);
+        break;
+      case LengthDelimitedTag(FieldDescriptorProto::kExtendeeFieldNumber):
+        ok = ScanString(input, &extension->extendee_);
+        break;
+      case kNumberTag:
+        ok = WireFormatLite::ReadPrimitive<int32_t, WireFormatLite::TYPE_INT32>(
+            input, &extension->number_);
+        break;
+      default:
+        ok = WireFormatLite::SkipField(input, tag);
+        break;
+    }
+    if (!ok) return false;
+  }
+  return input->ConsumedEntireMessage();
+}
+
+bool Scan(io::CodedInputStream* input, EncodedMessageView* message) {
+  while (uint32_t tag = input->ReadTag()) {
+    bool ok;
+    switch (tag) {
+      case LengthDelimitedTag(DescriptorProto::kNameFieldNumber):
+        ok = ScanString(input, &message->name_);
+        break;
+      case LengthDelimitedTag(DescriptorProto::kNestedTypeFieldNumber):
+        ok = ScanSubMessage(input, &message->nested_type_);
+        break;
+      case LengthDelimitedTag(DescriptorProto::kExtensionFieldNumber):
+        ok = ScanSubMessage(input, &message->extension_);
+        break;
+      default:
+        ok = WireFormatLite::SkipField(input, tag);
+        break;
+    }
+    if (!ok) return false;
+  }
+  return input->ConsumedEntireMessage();
+}
+
+bool Scan(io::CodedInputStream* input, EncodedFileView* file) {
+  while (uint32_t tag = input->ReadTag()) {
+    bool ok;
+    switch (tag) {
+      case LengthDelimitedTag(FileDescriptorProto::kNameFieldNumber):
+        ok = ScanString(input, &file->name_);
+        break;
+      case LengthDelimitedTag(FileDescriptorProto::kPackageFieldNumber):
+        ok = ScanString(input, &file->package_);
+        break;
+      case LengthDelimitedTag(FileDescriptorProto::kMessageTypeFieldNumber):
+        ok = ScanSubMessage(input, &file->message_type_);
+        break;
+      case LengthDelimitedTag(FileDescriptorProto::kEnumTypeFieldNumber):
+        ok = ScanSubMessage(input, &file->enum_type_);
+        break;
+      case LengthDelimitedTag(FileDescriptorProto::kServiceFieldNumber):
+        ok = ScanSubMessage(input, &file->service_);
+        break;
+      case LengthDelimitedTag(FileDescriptorProto::kExtensionFieldNumber):
+        ok = ScanSubMessage(input, &file->extension_);
+        break;
+      default:
+        ok = WireFormatLite::SkipField(input, tag);
+        break;
+    }
+    if (!ok) return false;
+  }
+  return input->ConsumedEntireMessage();
+}
+
+}  // namespace
+
 bool EncodedDescriptorDatabase::Add(const void* encoded_file_descriptor,
                                     int size) {
-  FileDescriptorProto file;
-  if (file.ParseFromArray(encoded_file_descriptor, size)) {
+  EncodedFileView file;
+  io::CodedInputStream input(
+      static_cast<const uint8_t*>(encoded_file_descriptor), size);
+  if (Scan(&input, &file)) {
     return index_->AddFile(file, std::make_pair(encoded_file_descriptor, size));
   } else {
     ABSL_LOG(ERROR) << "Invalid file descriptor data passed to "
@@ -893,6 +1090,149 @@ bool EncodedDescriptorDatabase::MaybeParse(
   return internal::ParseNoReflection(source, *output);
 }
 
+namespace {
+
+// Layout of the images written by EncodedDescriptorDatabase::SerializeImage().
+// Every field is a 32-bit word in host byte order, and every string is stored
+// as an (offset, size) pair of words pointing into the image:
+//
+//   header:     magic, version, file_count, symbol_count, extension_count
+//   files:      name, data                 (sorted by name)
+//   symbols:    file, full name            (sorted by full name)
+//   extensions: file, extendee, number     (sorted by extendee, number)
+//   followed by the bytes of all the strings.
+//
+// Extendees are stored without their leading '.'.
+constexpr uint32_t kImageMagic = 0x49444250;  // "PBDI"
+constexpr uint32_t kImageVersion = 1;
+constexpr size_t kImageHeaderWords = 5;
+constexpr size_t kImageFileWords = 4;
+constexpr size_t kImageSymbolWords = 3;
+constexpr size_t kImageExtensionWords = 4;
+
+void AppendWord(std::string* output, uint32_t word) {
+  output->append(reinterpret_cast<const char*>(&word), sizeof(word));
+}
+
+// Returns the index of the first element in [0, n) for which `less` is false.
+template <typename Less>
+uint32_t LowerBoundIndex(uint32_t n, Less less) {
+  uint32_t first = 0;
+  while (n > 0) {
+    uint32_t half = n / 2;
+    if (less(first + half)) {
+      first += half + 1;
+      n -= half + 1;
+    } else {
+      n = half;
+    }
+  }
+  return first;
+}
+
+}  // namespace
+
+bool EncodedDescriptorDatabase::SerializeImage(std::string* output) {
+  index_->EnsureFlat();
+  const DescriptorIndex& index = *index_;
+
+  // Files that failed to be added can leave entries behind in the index,
+  // including a second entry under an existing file name.  Keep the file that
+  // was added first under each name and drop anything that refers to others.
+  constexpr uint32_t kNoFile = ~uint32_t{0};
+  std::vector<const DescriptorIndex::FileEntry*> files;
+  for (const auto& entry : index.by_name_flat_) {
+    if (files.empty() || files.back()->name(index) != entry.name(index)) {
+      files.push_back(&entry);
+    } else if (entry.data_offset < files.back()->data_offset) {
+      files.back() = &entry;
+    }
+  }
+  std::vector<uint32_t> file_of_value(index.all_values_.size(), kNoFile);
+  for (size_t i = 0; i < files.size(); ++i) {
+    file_of_value[files[i]->data_offset] = static_cast<uint32_t>(i);
+  }
+
+  struct Entry {
+    uint32_t file;
+    std::string name;
+    int number;
+  };
+  std::vector<Entry> symbols;
+  for (const auto& entry : index.by_symbol_flat_) {
+    uint32_t file = file_of_value[entry.data_offset];
+    if (file == kNoFile) continue;
+    symbols.push_back({file, entry.AsString(index), 0});
+  }
+  std::vector<Entry> extensions;
+  for (const auto& entry : index.by_extension_flat_) {
+    uint32_t file = file_of_value[entry.data_offset];
+    if (file == kNoFile) continue;
+    if (!extensions.empty() &&
+        extensions.back().name == entry.extendee(index) &&
+        extensions.back().number == entry.extension_number) {
+      continue;
+    }
+    extensions.push_back(
+        {file, std::string(entry.extendee(index)), entry.extension_number});
+  }
+
+  const size_t file_count = files.size();
+  uint64_t size = sizeof(uint32_t) * (kImageHeaderWords +
+                                      kImageFileWords * file_count +
+                                      kImageSymbolWords * symbols.size() +
+                                      kImageExtensionWords * extensions.size());
+  for (const auto* entry : files) {
+    size += entry->name(index).size() +
+            index.all_values_[entry->data_offset].size;
+  }
+  for (const auto& entry : symbols) size += entry.name.size();
+  for (const auto& entry : extensions) size += entry.name.size();
+  if (size > std::numeric_limits<uint32_t>::max()) {
+    ABSL_LOG(ERROR) << "EncodedDescriptorDatabase is too large to be "
+                       "serialized to an image.";
+    return false;
+  }
+
+  std::string strings;
+  uint32_t strings_start = static_cast<uint32_t>(
+      sizeof(uint32_t) *
+      (kImageHeaderWords + kImageFileWords * file_count +
+       kImageSymbolWords * symbols.size() +
+       kImageExtensionWords * extensions.size()));
+  output->clear();
+  output->reserve(size);
+  auto append_string = [&](absl::string_view str) {
+    AppendWord(output, strings_start + static_cast<uint32_t>(strings.size()));
+    AppendWord(output, static_cast<uint32_t>(str.size()));
+    strings.append(str.data(), str.size());
+  };
+
+  AppendWord(output, kImageMagic);
+  AppendWord(output, kImageVersion);
+  AppendWord(output, static_cast<uint32_t>(file_count));
+  AppendWord(output, static_cast<uint32_t>(symbols.size()));
+  AppendWord(output, static_cast<uint32_t>(extensions.size()));
+  for (const auto* entry : files) {
+    const auto& value = index.all_values_[entry->data_offset];
+    append_string(entry->name(index));
+    append_string(
+        absl::string_view(static_cast<const char*>(value.data), value.size));
+  }
+  for (const auto& entry : symbols) {
+    AppendWord(output, entry.file);
+    append_string(entry.name);
+  }
+  for (const auto& entry : extensions) {
+    AppendWord(output, entry.file);
+    append_string(entry.name);
+    AppendWord(output, static_cast<uint32_t>(entry.number));
+  }
+  ABSL_DCHECK_EQ(output->size(), strings_start);
+  output->append(strings);
+  return true;
+}
+
 EncodedDescriptorDatabase::EncodedDescriptorDatabase()
     : index_(new DescriptorIndex()) {}
 
@@ -904,6 +1244,170 @@ EncodedDescriptorDatabase::~EncodedDescriptorDatabase() {
 
 // ===================================================================
 
+DescriptorImageDatabase::DescriptorImageDatabase() = default;
+DescriptorImageDatabase::~DescriptorImageDatabase() = default;
+
+uint32_t DescriptorImageDatabase::Word(size_t index) const {
+  uint32_t word;
+  memcpy(&word, image_.data() + index * sizeof(word), sizeof(word));
+  return word;
+}
+
+absl::string_view DescriptorImageDatabase::String(size_t index) const {
+  return image_.substr(Word(index), Word(index + 1));
+}
+
+size_t DescriptorImageDatabase::FileRecord(uint32_t i) const {
+  return kImageHeaderWords + kImageFileWords * i;
+}
+
+size_t DescriptorImageDatabase::SymbolRecord(uint32_t i) const {
+  return FileRecord(file_count_) + kImageSymbolWords * i;
+}
+
+size_t DescriptorImageDatabase::ExtensionRecord(uint32_t i) const {
+  return SymbolRecord(symbol_count_) + kImageExtensionWords * i;
+}
+
+bool DescriptorImageDatabase::Init(const void* image, size_t size) {
+  image_ = absl::string_view();
+  file_count_ = symbol_count_ = extension_count_ = 0;
+
+  absl::string_view data(static_cast<const char*>(image), size);
+  auto fail = [](absl::string_view reason) {
+    ABSL_LOG(ERROR) << "Invalid descriptor image passed to "
+                       "DescriptorImageDatabase::Init(): "
+                    << reason;
+    return false;
+  };
+  if (size < sizeof(uint32_t) * kImageHeaderWords) {
+    return fail("truncated header");
+  }
+  image_ = data;
+  if (Word(0) != kImageMagic || Word(1) != kImageVersion) {
+    image_ = absl::string_view();
+    return fail("unknown format");
+  }
+  uint64_t table_words = kImageHeaderWords +
+                         uint64_t{kImageFileWords} * Word(2) +
+                         uint64_t{kImageSymbolWords} * Word(3) +
+                         uint64_t{kImageExtensionWords} * Word(4);
+  if (table_words * sizeof(uint32_t) > size) {
+    image_ = absl::string_view();
+    return fail("truncated tables");
+  }
+  file_count_ = Word(2);
+  symbol_count_ = Word(3);
+  extension_count_ = Word(4);
+
+  // Check every string reference and the table order up front, so that
+  // lookups can trust the image.
+  auto valid_string = [&](size_t index) {
+    return Word(index) <= size && Word(index + 1) <= size - Word(index);
+  };
+  bool ok = true;
+  for (uint32_t i = 0; ok && i < file_count_; ++i) {
+    size_t record = FileRecord(i);
+    ok = valid_string(record) && valid_string(record + 2) &&
+         (i == 0 || String(FileRecord(i - 1)) < String(record));
+  }
+  for (uint32_t i = 0; ok && i < symbol_count_; ++i) {
+    size_t record = SymbolRecord(i);
+    ok = Word(record) < file_count_ && valid_string(record + 1) &&
+         (i == 0 || String(SymbolRecord(i - 1) + 1) < String(record + 1));
+  }
+  for (uint32_t i = 0; ok && i < extension_count_; ++i) {
+    size_t record = ExtensionRecord(i);
+    ok = Word(record) < file_count_ && valid_string(record + 1);
+    if (ok && i > 0) {
+      size_t prev = ExtensionRecord(i - 1);
+      ok = std::make_tuple(String(prev + 1), static_cast<int>(Word(prev + 3))) <
+           std::make_tuple(String(record + 1),
+                           static_cast<int>(Word(record + 3)));
+    }
+  }
+  if (!ok) {
+    image_ = absl::string_view();
+    file_count_ = symbol_count_ = extension_count_ = 0;
+    return fail("corrupt tables");
+  }
+  return true;
+}
+
+bool DescriptorImageDatabase::ParseFile(uint32_t file,
+                                        FileDescriptorProto* output) const {
+  if (file >= file_count_) return false;
+  return internal::ParseNoReflection(String(FileRecord(file) + 2), *output);
+}
+
+bool DescriptorImageDatabase::FindFileByName(const std::string& filename,
+                                             FileDescriptorProto* output) {
+  uint32_t i = LowerBoundIndex(file_count_, [&](uint32_t i) {
+    return String(FileRecord(i)) < filename;
+  });
+  if (i == file_count_ || String(FileRecord(i)) != filename) return false;
+  return ParseFile(i, output);
+}
+
+bool DescriptorImageDatabase::FindFileContainingSymbol(
+    const std::string& symbol_name, FileDescriptorProto* output) {
+  // Find the last symbol that sorts less than or equal to `symbol_name`, as
+  // EncodedDescriptorDatabase does.
+  uint32_t i = LowerBoundIndex(symbol_count_, [&](uint32_t i) {
+    return String(SymbolRecord(i) + 1) <= symbol_name;
+  });
+  if (i == 0) return false;
+  size_t record = SymbolRecord(i - 1);
+  if (!IsSubSymbol(String(record + 1), symbol_name)) return false;
+  return ParseFile(Word(record), output);
+}
+
+uint32_t DescriptorImageDatabase::LowerBoundExtension(
+    absl::string_view containing_type, int field_number) const {
+  return LowerBoundIndex(extension_count_, [&](uint32_t i) {
+    size_t record = ExtensionRecord(i);
+    return std::make_tuple(String(record + 1),
+                           static_cast<int>(Word(record + 3))) <
+           std::make_tuple(containing_type, field_number);
+  });
+}
+
+bool DescriptorImageDatabase::FindFileContainingExtension(
+    const std::string& containing_type, int field_number,
+    FileDescriptorProto* output) {
+  uint32_t i = LowerBoundExtension(containing_type, field_number);
+  if (i == extension_count_) return false;
+  size_t record = ExtensionRecord(i);
+  if (String(record + 1) != containing_type ||
+      static_cast<int>(Word(record + 3)) != field_number) {
+    return false;
+  }
+  return ParseFile(Word(record), output);
+}
+
+bool DescriptorImageDatabase::FindAllExtensionNumbers(
+    const std::string& extendee_type, std::vector<int>* output) {
+  bool success = false;
+  for (uint32_t i = LowerBoundExtension(extendee_type, 0);
+       i < extension_count_ && String(ExtensionRecord(i) + 1) == extendee_type;
+       ++i) {
+    output->push_back(static_cast<int>(Word(ExtensionRecord(i) + 3)));
+    success = true;
+  }
+  return success;
+}
+
+bool DescriptorImageDatabase::FindAllFileNames(
+    std::vector<std::string>* output) {
+  output->reserve(output->size() + file_count_);
+  for (uint32_t i = 0; i < file_count_; ++i) {
+    output->emplace_back(String(FileRecord(i)));
+  }
+  return true;
+}
+
+// ===================================================================
+
 DescriptorPoolDatabase::DescriptorPoolDatabase(const DescriptorPool& pool)
     : pool_(pool) {}
 DescriptorPoolDatabase::~DescriptorPoolDatabase() {}
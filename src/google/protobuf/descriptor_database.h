@@ -37,11 +37,14 @@
 #ifndef GOOGLE_PROTOBUF_DESCRIPTOR_DATABASE_H__
 #define GOOGLE_PROTOBUF_DESCRIPTOR_DATABASE_H__
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "absl/container/btree_map.h"
+#include "absl/strings/string_view.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/port.h"
 
@@ -59,6 +62,7 @@ namespace protobuf {
 class DescriptorDatabase;
 class SimpleDescriptorDatabase;
 class EncodedDescriptorDatabase;
+class DescriptorImageDatabase;
 class DescriptorPoolDatabase;
 class MergedDescriptorDatabase;
 
@@ -309,6 +313,13 @@ class PROTOBUF_EXPORT EncodedDescriptorDatabase : public DescriptorDatabase {
   bool FindNameOfFileContainingSymbol(const std::string& symbol_name,
                                       std::string* output);
 
+  // Writes every file in the database, together with its flattened index, to
+  // a single self-contained image that DescriptorImageDatabase can search in
+  // place.  The image holds no pointers, so it can be written to a file and
+  // mmapped read-only by many processes at once.  Returns false and logs an
+  // error if the database is too large to fit in an image.
+  bool SerializeImage(std::string* output);
+
   // implements DescriptorDatabase -----------------------------------
   bool FindFileByName(const std::string& filename,
                       FileDescriptorProto* output) override;
@@ -334,6 +345,65 @@ class PROTOBUF_EXPORT EncodedDescriptorDatabase : public DescriptorDatabase {
                   FileDescriptorProto* output);
 };
 
+// A read-only DescriptorDatabase over an image written by
+// EncodedDescriptorDatabase::SerializeImage().  Lookups binary-search the
+// image directly and allocate nothing per file, so processes on the same host
+// that mmap one image share all of the database's memory.  Pair it with a
+// DescriptorPool built on top of it so that each process only builds the
+// files it actually uses.
+//
+// The image is in host byte order and is only meant to be shared between
+// processes running the same protobuf version on the same machine.
+class PROTOBUF_EXPORT DescriptorImageDatabase : public DescriptorDatabase {
+ public:
+  DescriptorImageDatabase();
+  DescriptorImageDatabase(const DescriptorImageDatabase&) = delete;
+  DescriptorImageDatabase& operator=(const DescriptorImageDatabase&) = delete;
+  ~DescriptorImageDatabase() override;
+
+  // Points the database at `image`.  The database does not make a copy of the
+  // bytes, nor does it take ownership; it's up to the caller to make sure the
+  // bytes remain valid for the life of the database.  Returns false and logs
+  // an error if the bytes are not a valid image, in which case the database is
+  // left empty.
+  bool Init(const void* image, size_t size);
+
+  // implements DescriptorDatabase -----------------------------------
+  bool FindFileByName(const std::string& filename,
+                      FileDescriptorProto* output) override;
+  bool FindFileContainingSymbol(const std::string& symbol_name,
+                                FileDescriptorProto* output) override;
+  bool FindFileContainingExtension(const std::string& containing_type,
+                                   int field_number,
+                                   FileDescriptorProto* output) override;
+  bool FindAllExtensionNumbers(const std::string& extendee_type,
+                               std::vector<int>* output) override;
+  bool FindAllFileNames(std::vector<std::string>* output) override;
+
+ private:
+  // Reads the 32-bit word at `index` (counted in words from the start of the
+  // image).
+  uint32_t Word(size_t index) const;
+  // Reads the (offset, size) string reference at word `index`.
+  absl::string_view String(size_t index) const;
+
+  // Word offsets of the records for file, symbol and extension `i`.
+  size_t FileRecord(uint32_t i) const;
+  size_t SymbolRecord(uint32_t i) const;
+  size_t ExtensionRecord(uint32_t i) const;
+
+  // Returns the index of the first extension of `containing_type` whose number
+  // is not less than `field_number`.
+  uint32_t LowerBoundExtension(absl::string_view containing_type,
+                               int field_number) const;
+  bool ParseFile(uint32_t file, FileDescriptorProto* output) const;
+
+  absl::string_view image_;
+  uint32_t file_count_ = 0;
+  uint32_t symbol_count_ = 0;
+  uint32_t extension_count_ = 0;
+};
+
 // A DescriptorDatabase that fetches files from a given pool.
 class PROTOBUF_EXPORT DescriptorPoolDatabase : public DescriptorDatabase {
  public:
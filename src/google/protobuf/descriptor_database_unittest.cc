@@ -38,6 +38,8 @@
 
 #include <algorithm>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "google/protobuf/descriptor.pb.h"
 #include <gmock/gmock.h>
@@ -127,6 +129,32 @@ class EncodedDescriptorDatabaseTestCase : public DescriptorDatabaseTestCase {
   EncodedDescriptorDatabase database_;
 };
 
+// Specialization for DescriptorImageDatabase.  Files are added to an
+// EncodedDescriptorDatabase, which is re-serialized after every change.
+class DescriptorImageDatabaseTestCase : public DescriptorDatabaseTestCase {
+ public:
+  static DescriptorDatabaseTestCase* New() {
+    return new DescriptorImageDatabaseTestCase;
+  }
+
+  virtual ~DescriptorImageDatabaseTestCase() {}
+
+  virtual DescriptorDatabase* GetDatabase() { return &database_; }
+  virtual bool AddToDatabase(const FileDescriptorProto& file) {
+    std::string data;
+    file.SerializeToString(&data);
+    bool added = source_.AddCopy(data.data(), data.size());
+    EXPECT_TRUE(source_.SerializeImage(&image_));
+    EXPECT_TRUE(database_.Init(image_.data(), image_.size()));
+    return added;
+  }
+
+ private:
+  EncodedDescriptorDatabase source_;
+  std::string image_;
+  DescriptorImageDatabase database_;
+};
+
 // Specialization for DescriptorPoolDatabase.
 class DescriptorPoolDatabaseTestCase : public DescriptorDatabaseTestCase {
  public:
@@ -476,6 +504,9 @@ INSTANTIATE_TEST_CASE_P(
 INSTANTIATE_TEST_CASE_P(
     MemoryConserving, DescriptorDatabaseTest,
     testing::Values(&EncodedDescriptorDatabaseTestCase::New));
+INSTANTIATE_TEST_CASE_P(
+    Image, DescriptorDatabaseTest,
+    testing::Values(&DescriptorImageDatabaseTestCase::New));
 INSTANTIATE_TEST_CASE_P(Pool, DescriptorDatabaseTest,
                         testing::Values(&DescriptorPoolDatabaseTestCase::New));
 
@@ -515,6 +546,131 @@ TEST(EncodedDescriptorDatabaseExtraTest, FindNameOfFileContainingSymbol) {
   EXPECT_FALSE(db.FindNameOfFileContainingSymbol("baz.Baz", &filename));
 }
 
+TEST(EncodedDescriptorDatabaseExtraTest, IndexesFileWithoutParsingIt) {
+  // Add() scans only the names it indexes; everything else is skipped.
+  FileDescriptorProto file;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      R"pb(
+        name: "foo.proto"
+        package: "foo"
+        dependency: "bar.proto"
+        message_type {
+          name: "Foo"
+          field { name: "a" number: 1 type: TYPE_INT32 label: LABEL_OPTIONAL }
+          nested_type {
+            name: "Nested"
+            extension { name: "ext" extendee: ".bar.Bar" number: 12 }
+          }
+          options { deprecated: true }
+        }
+        enum_type {
+          name: "FooEnum"
+          value { name: "FOO_ENUM_ZERO" number: 0 }
+        }
+        service { name: "FooService" }
+        extension { name: "top_ext" extendee: ".bar.Bar" number: -7 }
+        options { java_package: "com.foo" }
+      )pb",
+      &file));
+  std::string data = file.SerializeAsString();
+
+  EncodedDescriptorDatabase db;
+  ASSERT_TRUE(db.Add(data.data(), data.size()));
+
+  FileDescriptorProto found;
+  for (const char* symbol :
+       {"foo.Foo", "foo.Foo.Nested", "foo.FooEnum", "foo.FooService",
+        "foo.top_ext"}) {
+    SCOPED_TRACE(symbol);
+    found.Clear();
+    ASSERT_TRUE(db.FindFileContainingSymbol(symbol, &found));
+    EXPECT_EQ(file.DebugString(), found.DebugString());
+  }
+  EXPECT_TRUE(db.FindFileContainingExtension("bar.Bar", 12, &found));
+  EXPECT_TRUE(db.FindFileContainingExtension("bar.Bar", -7, &found));
+  EXPECT_FALSE(db.FindFileContainingExtension("bar.Bar", 1, &found));
+  EXPECT_FALSE(db.FindFileContainingSymbol("foo.a", &found));
+
+  // Truncated data is rejected.
+  EncodedDescriptorDatabase truncated_db;
+  EXPECT_FALSE(truncated_db.Add(data.data(), data.size() - 1));
+  EXPECT_FALSE(truncated_db.FindFileByName("foo.proto", &found));
+}
+
+TEST(DescriptorImageDatabaseExtraTest, BuildsPoolFromImage) {
+  FileDescriptorProto foo, bar;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      R"pb(
+        name: "foo.proto" package: "foo" message_type { name: "Foo" }
+      )pb",
+      &foo));
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      R"pb(
+        name: "bar.proto"
+        package: "bar"
+        dependency: "foo.proto"
+        message_type {
+          name: "Bar"
+          field {
+            name: "foo"
+            number: 1
+            label: LABEL_OPTIONAL
+            type: TYPE_MESSAGE
+            type_name: ".foo.Foo"
+          }
+        }
+      )pb",
+      &bar));
+  EncodedDescriptorDatabase source;
+  std::string data1 = foo.SerializeAsString();
+  std::string data2 = bar.SerializeAsString();
+  ASSERT_TRUE(source.Add(data1.data(), data1.size()));
+  ASSERT_TRUE(source.Add(data2.data(), data2.size()));
+
+  std::string image;
+  ASSERT_TRUE(source.SerializeImage(&image));
+  // The image must not point back into the source database.
+  data1.clear();
+  data2.clear();
+
+  DescriptorImageDatabase db;
+  ASSERT_TRUE(db.Init(image.data(), image.size()));
+  std::vector<std::string> names;
+  EXPECT_TRUE(db.FindAllFileNames(&names));
+  EXPECT_THAT(names, testing::ElementsAre("bar.proto", "foo.proto"));
+
+  DescriptorPool pool(&db);
+  const Descriptor* bar_type = pool.FindMessageTypeByName("bar.Bar");
+  ASSERT_NE(bar_type, nullptr);
+  EXPECT_EQ(bar_type->field(0)->message_type()->full_name(), "foo.Foo");
+}
+
+TEST(DescriptorImageDatabaseExtraTest, RejectsCorruptImage) {
+  FileDescriptorProto file;
+  file.set_name("foo.proto");
+  file.add_message_type()->set_name("Foo");
+  std::string data = file.SerializeAsString();
+  EncodedDescriptorDatabase source;
+  ASSERT_TRUE(source.Add(data.data(), data.size()));
+  std::string image;
+  ASSERT_TRUE(source.SerializeImage(&image));
+
+  DescriptorImageDatabase db;
+  // Every strict prefix of the image is missing some of the bytes the tables
+  // refer to.
+  for (size_t size = 0; size < image.size(); ++size) {
+    EXPECT_FALSE(db.Init(image.data(), size)) << size;
+  }
+  std::string bad_magic = image;
+  bad_magic[0] ^= 1;
+  EXPECT_FALSE(db.Init(bad_magic.data(), bad_magic.size()));
+  FileDescriptorProto output;
+  EXPECT_FALSE(db.FindFileByName("foo.proto", &output));
+
+  ASSERT_TRUE(db.Init(image.data(), image.size()));
+  EXPECT_TRUE(db.FindFileByName("foo.proto", &output));
+}
+
 TEST(SimpleDescriptorDatabaseExtraTest, FindAllFileNames) {
   FileDescriptorProto f;
   f.set_name("foo.proto");
@@ -0,0 +1,80 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Tests for files generated with lazy_descriptor_registration, whose
+// descriptor tables are registered from a linker section on first access to
+// the generated pool instead of at dynamic initialization time.
+
+#include <gtest/gtest.h>
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/descriptor.pb.h"
+#include "google/protobuf/descriptor_database.h"
+#include "google/protobuf/generated_message_reflection.h"
+#include "google/protobuf/unittest_descriptor_table_section.pb.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace {
+
+const internal::DescriptorTable& SectionTable() {
+  return descriptor_table_google_2fprotobuf_2funittest_5fdescriptor_5ftable_5fsection_2eproto;
+}
+
+TEST(DescriptorTableSectionTest, RegisteredOnFirstPoolAccess) {
+#if !defined(PROTOBUF_DESCRIPTOR_TABLE_SECTION_ATTRIBUTE)
+  GTEST_SKIP() << "Descriptor table sections are not supported";
+#endif
+  // Nothing has touched the generated pool yet, so the table was found in the
+  // section rather than added by a dynamic initializer.
+  EXPECT_FALSE(SectionTable().is_initialized);
+
+  const FileDescriptor* file = DescriptorPool::generated_pool()->FindFileByName(
+      "google/protobuf/unittest_descriptor_table_section.proto");
+  ASSERT_NE(file, nullptr);
+  EXPECT_TRUE(SectionTable().is_initialized);
+  EXPECT_EQ(file->FindMessageTypeByName("SectionRegisteredMessage"),
+            protobuf_unittest::SectionRegisteredMessage::descriptor());
+}
+
+TEST(DescriptorTableSectionTest, GeneratedDatabaseSeesSectionTables) {
+  FileDescriptorProto proto;
+  ASSERT_TRUE(DescriptorPool::internal_generated_database()->FindFileByName(
+      "google/protobuf/unittest_descriptor_table_section.proto", &proto));
+  EXPECT_EQ(proto.message_type(0).name(), "SectionRegisteredMessage");
+}
+
+}  // namespace
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
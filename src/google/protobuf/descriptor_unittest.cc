@@ -40,6 +40,7 @@
 #include <limits>
 #include <memory>
 #include <string>
+#include <thread>  // NOLINT
 #include <tuple>
 #include <utility>
 #include <vector>
@@ -456,6 +457,82 @@ TEST_F(FileDescriptorTest, BuildAgain) {
   EXPECT_TRUE(pool_.BuildFile(file) == nullptr);
 }
 
+TEST_F(FileDescriptorTest, BuildFromSerialized) {
+  // Files built from serialized bytes match those built from the proto.
+  DescriptorPool pool;
+  for (const FileDescriptor* file :
+       {protobuf_unittest_import::PublicImportMessage::descriptor()->file(),
+        protobuf_unittest_import::ImportMessage::descriptor()->file(),
+        protobuf_unittest::TestAllTypes::descriptor()->file()}) {
+    FileDescriptorProto proto;
+    file->CopyTo(&proto);
+    const FileDescriptor* built =
+        pool.BuildFileFromSerialized(proto.SerializeAsString());
+    ASSERT_TRUE(built != nullptr) << file->name();
+    EXPECT_EQ(file->DebugString(), built->DebugString());
+  }
+
+  // Building the same bytes again returns the same file.
+  FileDescriptorProto file;
+  foo_file_->CopyTo(&file);
+  EXPECT_EQ(foo_file_, pool_.BuildFileFromSerialized(file.SerializeAsString()));
+
+  MockErrorCollector error_collector;
+  EXPECT_TRUE(pool_.BuildFileFromSerializedCollectingErrors(
+                  "\xff", &error_collector) == nullptr);
+  EXPECT_EQ(": : OTHER: Failed to parse FileDescriptorProto.\n",
+            error_collector.text_);
+}
+
+TEST_F(FileDescriptorTest, BuildFilesInDependencyOrder) {
+  // Files are built after their imports, whatever their order in the set.
+  FileDescriptorSet set;
+  protobuf_unittest::TestAllTypes::descriptor()->file()->CopyTo(set.add_file());
+  protobuf_unittest_import::ImportMessage::descriptor()->file()->CopyTo(
+      set.add_file());
+  protobuf_unittest_import::PublicImportMessage::descriptor()->file()->CopyTo(
+      set.add_file());
+
+  DescriptorPool pool;
+  std::vector<const FileDescriptor*> files = pool.BuildFiles(set);
+  ASSERT_EQ(files.size(), 3);
+  for (int i = 0; i < set.file_size(); ++i) {
+    ASSERT_TRUE(files[i] != nullptr);
+    EXPECT_EQ(files[i], pool.FindFileByName(set.file(i).name()));
+  }
+  EXPECT_EQ(files[1], files[0]->dependency(0));
+}
+
+TEST_F(FileDescriptorTest, BuildFilesIsAllOrNothing) {
+  FileDescriptorSet set;
+  FileDescriptorProto* good = set.add_file();
+  good->set_name("good.proto");
+  good->add_message_type()->set_name("Good");
+  FileDescriptorProto* bad = set.add_file();
+  bad->set_name("bad.proto");
+  bad->add_dependency("good.proto");
+  bad->add_dependency("missing.proto");
+
+  MockErrorCollector error_collector;
+  EXPECT_TRUE(pool_.BuildFilesCollectingErrors(set, &error_collector).empty());
+  EXPECT_EQ(
+      "bad.proto: missing.proto: IMPORT: Import \"missing.proto\" has not "
+      "been loaded.\n",
+      error_collector.text_);
+  // The file that did build was rolled back with the rest of the set.
+  EXPECT_TRUE(pool_.FindFileByName("good.proto") == nullptr);
+  EXPECT_TRUE(pool_.FindMessageTypeByName("Good") == nullptr);
+
+  // Cycles within the set are reported before anything is built.
+  bad->clear_dependency();
+  bad->add_dependency("good.proto");
+  good->add_dependency("bad.proto");
+  MockErrorCollector cycle_collector;
+  EXPECT_TRUE(pool_.BuildFilesCollectingErrors(set, &cycle_collector).empty());
+  EXPECT_EQ("bad.proto: bad.proto: IMPORT: File recursively imports itself.\n",
+            cycle_collector.text_);
+}
+
 TEST_F(FileDescriptorTest, BuildAgainWithSyntax) {
   // Test that if we call BuildFile again on the same input we get the same
   // FileDescriptor back even if syntax param is specified.
@@ -907,6 +984,41 @@ TEST_F(DescriptorTest, FieldNameDedupJsonEqFull) {
   EXPECT_EQ(file->message_type(0)->field(0)->json_name(), "Name1.Name2");
 }
 
+TEST_F(DescriptorTest, DerivedFieldNamesAreInternedPerFile) {
+  FileDescriptorProto proto;
+  proto.set_name("derived_names.proto");
+  for (absl::string_view name : {"Foo", "Bar"}) {
+    auto* message = AddMessage(&proto, std::string(name));
+    AddField(message, "create_time", 1, FieldDescriptorProto::LABEL_OPTIONAL,
+             FieldDescriptorProto::TYPE_INT32);
+  }
+  const FileDescriptor* file = pool_.BuildFile(proto);
+  ASSERT_NE(file, nullptr);
+  const FieldDescriptor* foo = file->message_type(0)->field(0);
+  const FieldDescriptor* bar = file->message_type(1)->field(0);
+
+  // Look the names up from several threads at once; the lazy initialization
+  // must hand every caller the same object.
+  std::vector<const std::string*> seen(4);
+  std::vector<std::thread> threads;
+  for (auto& slot : seen) {
+    threads.emplace_back([&slot, foo] { slot = &foo->camelcase_name(); });
+  }
+  for (auto& t : threads) t.join();
+  for (const std::string* name : seen) EXPECT_EQ(name, seen[0]);
+
+  EXPECT_EQ(foo->camelcase_name(), "createTime");
+  EXPECT_EQ(foo->json_name(), "createTime");
+  EXPECT_EQ(&foo->camelcase_name(), &foo->json_name());
+  // Equal derived names within a file share storage.
+  EXPECT_EQ(&foo->camelcase_name(), &bar->camelcase_name());
+
+  FileDescriptorProto copy;
+  file->CopyTo(&copy);
+  file->CopyJsonNameTo(&copy);
+  EXPECT_EQ(copy.message_type(0).field(0).json_name(), "createTime");
+}
+
 TEST_F(DescriptorTest, FieldsByIndex) {
   ASSERT_EQ(4, message_->field_count());
   EXPECT_EQ(foo_, message_->field(0));
@@ -2315,6 +2427,81 @@ TEST_F(ExtensionDescriptorTest, DuplicateFieldNumber) {
 
 // ===================================================================
 
+// Fields with compact but out-of-order numbers.
+TEST(DescriptorFieldLookupTest, CompactOutOfOrderNumbers) {
+  // Numbers 1..5 out of order, with 4 left for an extension, are looked up
+  // through the message's dense number table.
+  FileDescriptorProto file_proto;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      R"pb(
+        name: "foo.proto"
+        message_type {
+          name: "Foo"
+          field { name: "c" number: 3 label: LABEL_OPTIONAL type: TYPE_INT32 }
+          field { name: "a" number: 1 label: LABEL_OPTIONAL type: TYPE_INT32 }
+          field {
+            name: "B_Field"
+            number: 2
+            label: LABEL_OPTIONAL
+            type: TYPE_INT32
+          }
+          field { name: "e" number: 5 label: LABEL_OPTIONAL type: TYPE_INT32 }
+          extension_range { start: 4 end: 5 }
+        }
+        extension {
+          name: "d"
+          number: 4
+          label: LABEL_OPTIONAL
+          type: TYPE_INT32
+          extendee: ".Foo"
+        }
+      )pb",
+      &file_proto));
+  DescriptorPool pool;
+  const FileDescriptor* file = pool.BuildFile(file_proto);
+  ASSERT_NE(file, nullptr);
+  const Descriptor* foo = file->message_type(0);
+
+  for (int i = 0; i < foo->field_count(); ++i) {
+    const FieldDescriptor* field = foo->field(i);
+    EXPECT_EQ(foo->FindFieldByNumber(field->number()), field);
+    EXPECT_EQ(foo->FindFieldByName(field->name()), field);
+    EXPECT_EQ(foo->FindFieldByLowercaseName(field->lowercase_name()), field);
+  }
+  EXPECT_EQ(foo->FindFieldByNumber(4), nullptr);
+  EXPECT_EQ(foo->FindFieldByNumber(0), nullptr);
+  EXPECT_EQ(foo->FindFieldByNumber(6), nullptr);
+  EXPECT_EQ(pool.FindExtensionByNumber(foo, 4), file->extension(0));
+  EXPECT_EQ(foo->FindFieldByName("b_field"), nullptr);
+  EXPECT_EQ(foo->FindFieldByLowercaseName("B_Field"), nullptr);
+  EXPECT_EQ(foo->FindFieldByName("d"), nullptr);
+  EXPECT_EQ(foo->FindFieldByName("x"), nullptr);
+}
+
+TEST(DescriptorFieldLookupTest, CompactNumberConflict) {
+  FileDescriptorProto file_proto;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      R"pb(
+        name: "foo.proto"
+        message_type {
+          name: "Foo"
+          field { name: "b" number: 2 label: LABEL_OPTIONAL type: TYPE_INT32 }
+          field { name: "a" number: 1 label: LABEL_OPTIONAL type: TYPE_INT32 }
+          field { name: "c" number: 2 label: LABEL_OPTIONAL type: TYPE_INT32 }
+        }
+      )pb",
+      &file_proto));
+  DescriptorPool pool;
+  MockErrorCollector error_collector;
+  EXPECT_EQ(pool.BuildFileCollectingErrors(file_proto, &error_collector),
+            nullptr);
+  EXPECT_EQ(error_collector.text_,
+            "foo.proto: Foo.c: NUMBER: Field number 2 has already been used in "
+            "\"Foo\" by field \"b\".\n");
+}
+
+// ===================================================================
+
 // Ensure that overlapping extension ranges are not allowed.
 TEST(OverlappingExtensionRangeTest, ExtensionRangeInternal) {
   // Build descriptors for the following definitions:
@@ -8093,6 +8280,64 @@ TEST_F(FeaturesTest, FieldFeaturesDefault) {
                 })pb"));
 }
 
+TEST_F(FeaturesTest, MergedFeaturesAreShared) {
+  BuildDescriptorMessagesInTestPool();
+  const FileDescriptor* file = BuildFile(R"pb(
+    name: "foo.proto"
+    syntax: "editions"
+    edition: "2023"
+    message_type {
+      name: "Foo"
+      field { name: "a" number: 1 label: LABEL_OPTIONAL type: TYPE_INT64 }
+      field {
+        name: "b"
+        number: 2
+        label: LABEL_OPTIONAL
+        type: TYPE_INT64
+        options { features { field_presence: IMPLICIT } }
+      }
+      field {
+        name: "c"
+        number: 3
+        label: LABEL_OPTIONAL
+        type: TYPE_INT64
+        options { features { field_presence: IMPLICIT } }
+      }
+    }
+    message_type {
+      name: "Bar"
+      field {
+        name: "b"
+        number: 2
+        label: LABEL_OPTIONAL
+        type: TYPE_INT64
+        options { features { field_presence: IMPLICIT } }
+      }
+      field {
+        name: "d"
+        number: 4
+        label: LABEL_OPTIONAL
+        type: TYPE_INT64
+        options { features { field_presence: EXPLICIT } }
+      }
+    }
+  )pb");
+  const Descriptor* foo = file->message_type(0);
+  const Descriptor* bar = file->message_type(1);
+
+  // Fields without overrides inherit their parent's features as-is.
+  EXPECT_EQ(&GetFeatures(foo->field(0)), &GetFeatures(foo));
+  EXPECT_EQ(&GetFeatures(foo), &GetFeatures(file));
+  // Identical overrides on the same parent, and on different parents with
+  // identical features, resolve to a single FeatureSet.
+  EXPECT_EQ(&GetFeatures(foo->field(1)), &GetFeatures(foo->field(2)));
+  EXPECT_EQ(&GetFeatures(foo->field(1)), &GetFeatures(bar->field(0)));
+  EXPECT_EQ(GetFeatures(foo->field(1)).field_presence(), FeatureSet::IMPLICIT);
+  // An override that restates the parent's value merges to the same features.
+  EXPECT_EQ(&GetFeatures(bar->field(1)), &GetFeatures(file));
+  EXPECT_THAT(bar->field(1)->options(), EqualsProto(""));
+}
+
 TEST_F(FeaturesTest, FieldFeaturesInherit) {
   BuildDescriptorMessagesInTestPool();
   BuildFileInTestPool(pb::TestFeatures::descriptor()->file());
@@ -10934,6 +11179,36 @@ TEST_F(DatabaseBackedPoolTest, FindMessageTypeByName) {
   EXPECT_TRUE(pool.FindMessageTypeByName("NoSuchType") == nullptr);
 }
 
+TEST_F(DatabaseBackedPoolTest, RepeatedLookupsFromManyThreads) {
+  auto pool = std::make_unique<DescriptorPool>(&database_);
+  const Descriptor* foo = pool->FindMessageTypeByName("Foo");
+  ASSERT_TRUE(foo != nullptr);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(foo, pool->FindMessageTypeByName("Foo"));
+        ASSERT_TRUE(pool->FindMessageTypeByName("Bar") != nullptr);
+        ASSERT_TRUE(pool->FindEnumValueByName("DUMMY") != nullptr);
+        EXPECT_TRUE(pool->FindMessageTypeByName("NoSuchType") == nullptr);
+        // The symbol has a different kind than the one asked for.
+        EXPECT_TRUE(pool->FindEnumTypeByName("Foo") == nullptr);
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  // A new pool over the same database must not see the old pool's symbols,
+  // even if it is allocated at the same address.
+  pool.reset();
+  pool = std::make_unique<DescriptorPool>(&database_);
+  const Descriptor* new_foo = pool->FindMessageTypeByName("Foo");
+  ASSERT_TRUE(new_foo != nullptr);
+  EXPECT_EQ(new_foo->file(), pool->FindFileByName("foo.proto"));
+  EXPECT_EQ(new_foo, pool->FindMessageTypeByName("Foo"));
+}
+
 TEST_F(DatabaseBackedPoolTest, FindExtensionByNumber) {
   DescriptorPool pool(&database_);
 
@@ -29,9 +29,12 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <memory>
+#include <string>
 
 #include <gtest/gtest.h>
+#include "absl/strings/string_view.h"
 #include "google/protobuf/dynamic_message.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include "google/protobuf/message_lite.h"
 #include "google/protobuf/unittest_drop_unknown_fields.pb.h"
 
@@ -79,5 +82,79 @@ TEST(DropUnknownFieldsTest, DynamicMessage) {
   EXPECT_EQ(2, foo_with_extra_fields.extra_int32_value());
 }
 
+// Every wire type, including nested groups, a run of one repeated field and a
+// field longer than a buffer, around the known fields.
+std::string WithUnknownFields() {
+  std::string data(
+      "\x50\xff\xff\xff\xff\xff\xff\xff\xff\xff\x01"  // 10: varint
+      "\x59\x01\x02\x03\x04\x05\x06\x07\x08"          // 11: fixed64
+      "\x65\x01\x02\x03\x04"                          // 12: fixed32
+      "\x6a\x03"
+      "abc"                           // 13: bytes
+      "\x73\x08\x05\x13\x14\x74"      // 14: group holding a group
+      "\x78\x01\x78\x80\x01\x78\x02"  // 15: three varints
+      "\x08\x07\x10\x03",             // 1: 7, 2: MOO
+      47);
+  data += "\x82\x01\xe8\x07";  // 16: 1000 bytes
+  data.append(1000, 'x');
+  data += "\x08\x09";  // 1: 9
+  return data;
+}
+
+TEST(DropUnknownFieldsTest, DiscardWhileParsing) {
+  Foo foo;
+  ASSERT_TRUE(foo.ParseFrom<MessageLite::kParseDiscardUnknown>(
+      WithUnknownFields()));
+  EXPECT_EQ(9, foo.int32_value());
+  EXPECT_EQ(static_cast<int>(FooWithExtraFields::MOO),
+            static_cast<int>(foo.enum_value()));
+  EXPECT_TRUE(foo.GetReflection()->GetUnknownFields(foo).empty());
+
+  // Without the flag the same bytes are kept.
+  ASSERT_TRUE(foo.ParseFromString(WithUnknownFields()));
+  EXPECT_FALSE(foo.GetReflection()->GetUnknownFields(foo).empty());
+}
+
+TEST(DropUnknownFieldsTest, DiscardWhileParsingAcrossBuffers) {
+  const std::string data = WithUnknownFields();
+  for (int block_size = 1; block_size < 20; ++block_size) {
+    io::ArrayInputStream input(data.data(), static_cast<int>(data.size()),
+                               block_size);
+    Foo foo;
+    ASSERT_TRUE(foo.ParseFrom<MessageLite::kParseDiscardUnknown>(
+        static_cast<io::ZeroCopyInputStream*>(&input)))
+        << block_size;
+    EXPECT_EQ(9, foo.int32_value());
+    EXPECT_TRUE(foo.GetReflection()->GetUnknownFields(foo).empty());
+  }
+}
+
+TEST(DropUnknownFieldsTest, DiscardWhileParsingDynamicMessage) {
+  DynamicMessageFactory factory;
+  std::unique_ptr<Message> foo(factory.GetPrototype(Foo::descriptor())->New());
+  ASSERT_TRUE(foo->ParseFrom<MessageLite::kParseDiscardUnknown>(
+      WithUnknownFields()));
+  EXPECT_TRUE(foo->GetReflection()->GetUnknownFields(*foo).empty());
+
+  FooWithExtraFields foo_with_extra_fields;
+  ASSERT_TRUE(foo_with_extra_fields.ParseFromString(foo->SerializeAsString()));
+  EXPECT_EQ(9, foo_with_extra_fields.int32_value());
+  EXPECT_EQ(FooWithExtraFields::MOO, foo_with_extra_fields.enum_value());
+}
+
+TEST(DropUnknownFieldsTest, DiscardWhileParsingRejectsMalformedFields) {
+  Foo foo;
+  // An eleven byte varint.
+  EXPECT_FALSE(foo.ParseFrom<MessageLite::kParseDiscardUnknown>(
+      absl::string_view("\x50\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\x01",
+                        12)));
+  // A length past the end of the input.
+  EXPECT_FALSE(foo.ParseFrom<MessageLite::kParseDiscardUnknown>(
+      absl::string_view("\x6a\x05" "abc", 5)));
+  // A group closed with another field's end tag.
+  EXPECT_FALSE(foo.ParseFrom<MessageLite::kParseDiscardUnknown>(
+      absl::string_view("\x73\x08\x05\x7c", 4)));
+}
+
 }  // namespace protobuf
 }  // namespace google
@@ -109,9 +109,19 @@ const ::_pbi::DescriptorTable descriptor_table_google_2fprotobuf_2fduration_2epr
 PROTOBUF_ATTRIBUTE_WEAK const ::_pbi::DescriptorTable* descriptor_table_google_2fprotobuf_2fduration_2eproto_getter() {
   return &descriptor_table_google_2fprotobuf_2fduration_2eproto;
 }
+#if defined(PROTOBUF_DESCRIPTOR_TABLE_SECTION)
+// Registered on first access to the generated pool.
+PROTOBUF_DESCRIPTOR_TABLE_SECTION
+static const ::_pbi::DescriptorTable* const dynamic_init_dummy_google_2fprotobuf_2fduration_2eproto =
+    &descriptor_table_google_2fprotobuf_2fduration_2eproto;
+// Makes this binary or shared object report its section.
+__attribute__((used)) static const bool* const descriptor_table_section_dummy_google_2fprotobuf_2fduration_2eproto =
+    &::_pbi::DescriptorTableSection<>::registered;
+#else
 // Force running AddDescriptors() at dynamic initialization time.
 PROTOBUF_ATTRIBUTE_INIT_PRIORITY2
 static ::_pbi::AddDescriptorsRunner dynamic_init_dummy_google_2fprotobuf_2fduration_2eproto(&descriptor_table_google_2fprotobuf_2fduration_2eproto);
+#endif  // defined(PROTOBUF_DESCRIPTOR_TABLE_SECTION)
 namespace google {
 namespace protobuf {
 // ===================================================================
@@ -182,6 +192,7 @@ const ::_pbi::TcParseTable<1, 2, 0, 0, 2> Duration::_table_ = {
     offsetof(decltype(_table_), field_names),  // no aux_entries
     &_Duration_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0, 0,  // required_has_bits_word, required_has_bits
   }, {{
     // int32 nanos = 2;
     {::_pbi::TcParser::SingularVarintNoZag1<::uint32_t, offsetof(Duration, _impl_.nanos_), 63>(),
@@ -257,6 +268,16 @@ const ::_pbi::TcParseTable<1, 2, 0, 0, 2> Duration::_table_ = {
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
+::size_t Duration::SpaceUsedLong() const {
+  // sizeof(*this) already includes every field stored inline, so only
+  // memory owned through pointers is added.
+  ::size_t total_size = sizeof(Duration);
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size += _internal_metadata_.unknown_fields<::google::protobuf::UnknownFieldSet>(::google::protobuf::UnknownFieldSet::default_instance).SpaceUsedExcludingSelfLong();
+  }
+  return ::_pbi::SpaceUsedLongResult(total_size, this);
+}
+
 const ::google::protobuf::Message::ClassData Duration::_class_data_ = {
     ::google::protobuf::Message::CopyWithSourceCheck,
     Duration::MergeImpl
@@ -173,6 +173,7 @@ class PROTOBUF_EXPORT Duration final :
   bool IsInitialized() const final;
 
   ::size_t ByteSizeLong() const final;
+  ::size_t SpaceUsedLong() const final;
   const char* _InternalParse(const char* ptr, ::google::protobuf::internal::ParseContext* ctx) final;
   ::uint8_t* _InternalSerialize(
       ::uint8_t* target, ::google::protobuf::io::EpsCopyOutputStream* stream) const final;
@@ -253,6 +254,7 @@ class PROTOBUF_EXPORT Duration final :
 
 
 
+
 // ===================================================================
 
 
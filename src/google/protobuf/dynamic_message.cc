@@ -68,6 +68,7 @@
 #include <cstddef>
 #include <memory>
 #include <new>
+#include <vector>
 
 #include "google/protobuf/arenastring.h"
 #include "google/protobuf/descriptor.h"
@@ -196,6 +197,25 @@ inline int AlignTo(int offset, int alignment) {
 // type may be stored at it.
 inline int AlignOffset(int offset) { return AlignTo(offset, kSafeAlignment); }
 
+// Returns the fields of `type` that get their own storage, i.e. those not in a
+// real oneof, in the order they are laid out. As in the padding optimizer for
+// generated code, fields are sorted by decreasing alignment so that they pack
+// without padding; fields of equal alignment keep their declaration order.
+// There is no access profile for dynamic types, so there is no hot/cold split.
+std::vector<const FieldDescriptor*> FieldLayoutOrder(const Descriptor* type) {
+  std::vector<const FieldDescriptor*> fields;
+  fields.reserve(type->field_count());
+  for (int i = 0; i < type->field_count(); i++) {
+    if (!InRealOneof(type->field(i))) fields.push_back(type->field(i));
+  }
+  std::stable_sort(fields.begin(), fields.end(),
+                   [](const FieldDescriptor* a, const FieldDescriptor* b) {
+                     return std::min(kSafeAlignment, FieldSpaceUsed(a)) >
+                            std::min(kSafeAlignment, FieldSpaceUsed(b));
+                   });
+  return fields;
+}
+
 #define bitsizeof(T) (sizeof(T) * 8)
 
 }  // namespace
@@ -636,8 +656,16 @@ DynamicMessageFactory::~DynamicMessageFactory() {
 }
 
 const Message* DynamicMessageFactory::GetPrototype(const Descriptor* type) {
+  if (const TypeInfo* type_info = published_.Find(type)) {
+    return type_info->prototype;
+  }
   absl::MutexLock lock(&prototypes_mutex_);
-  return GetPrototypeNoLock(type);
+  const Message* result = GetPrototypeNoLock(type);
+  for (const TypeInfo* type_info : unpublished_) {
+    published_.Insert(type_info->type, type_info);
+  }
+  unpublished_.clear();
+  return result;
 }
 
 const Message* DynamicMessageFactory::GetPrototypeNoLock(
@@ -655,6 +683,7 @@ const Message* DynamicMessageFactory::GetPrototypeNoLock(
 
   TypeInfo* type_info = new TypeInfo;
   *target = type_info;
+  unpublished_.push_back(type_info);
 
   type_info->type = type;
   type_info->pool = (pool_ == nullptr) ? type->file()->pool() : pool_;
@@ -684,11 +713,14 @@ const Message* DynamicMessageFactory::GetPrototypeNoLock(
   int size = sizeof(DynamicMessage);
   size = AlignOffset(size);
 
-  // Next the has_bits, which is an array of uint32s.
+  const std::vector<const FieldDescriptor*> layout = FieldLayoutOrder(type);
+
+  // Next the has_bits, which is an array of uint32s. They are assigned in
+  // layout order, so fields stored next to each other share has_bits words.
   type_info->has_bits_offset = -1;
   int max_hasbit = 0;
-  for (int i = 0; i < type->field_count(); i++) {
-    if (internal::cpp::HasHasbit(type->field(i))) {
+  for (const FieldDescriptor* field : layout) {
+    if (internal::cpp::HasHasbit(field)) {
       if (type_info->has_bits_offset == -1) {
         // At least one field in the message requires a hasbit, so allocate
         // hasbits.
@@ -700,7 +732,7 @@ const Message* DynamicMessageFactory::GetPrototypeNoLock(
         }
         type_info->has_bits_indices.reset(has_bits_indices);
       }
-      type_info->has_bits_indices[i] = max_hasbit++;
+      type_info->has_bits_indices[field->index()] = max_hasbit++;
     }
   }
 
@@ -727,18 +759,13 @@ const Message* DynamicMessageFactory::GetPrototypeNoLock(
     type_info->extensions_offset = -1;
   }
 
-  // All the fields.
-  //
-  // TODO(b/31226269):  Optimize the order of fields to minimize padding.
-  for (int i = 0; i < type->field_count(); i++) {
+  // All the fields, in layout order. Oneof fields do not use any space.
+  for (const FieldDescriptor* field : layout) {
     // Make sure field is aligned to avoid bus errors.
-    // Oneof fields do not use any space.
-    if (!InRealOneof(type->field(i))) {
-      int field_size = FieldSpaceUsed(type->field(i));
-      size = AlignTo(size, std::min(kSafeAlignment, field_size));
-      offsets[i] = size;
-      size += field_size;
-    }
+    int field_size = FieldSpaceUsed(field);
+    size = AlignTo(size, std::min(kSafeAlignment, field_size));
+    offsets[field->index()] = size;
+    size += field_size;
   }
 
   // The oneofs.
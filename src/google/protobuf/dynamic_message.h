@@ -44,6 +44,7 @@
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/synchronization/mutex.h"
+#include "google/protobuf/insert_only_pointer_map.h"
 #include "google/protobuf/message.h"
 #include "google/protobuf/port.h"
 #include "google/protobuf/reflection.h"
@@ -141,6 +142,12 @@ class PROTOBUF_EXPORT DynamicMessageFactory : public MessageFactory {
   struct TypeInfo;
   absl::flat_hash_map<const Descriptor*, const TypeInfo*> prototypes_;
   mutable absl::Mutex prototypes_mutex_;
+  // Prototypes that are fully constructed, readable without the mutex.
+  // Entries are added when the outermost GetPrototype() call that built them
+  // returns, since until then their cross-linked defaults may still be in
+  // progress.
+  internal::InsertOnlyPointerMap<Descriptor, const TypeInfo> published_;
+  std::vector<const TypeInfo*> unpublished_;
 
   friend class DynamicMessage;
   const Message* GetPrototypeNoLock(const Descriptor* type);
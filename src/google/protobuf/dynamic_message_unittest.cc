@@ -43,14 +43,22 @@
 #include "google/protobuf/dynamic_message.h"
 
 #include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
+#include "absl/strings/str_cat.h"
 #include "google/protobuf/descriptor.pb.h"
 #include "google/protobuf/testing/googletest.h"
 #include <gtest/gtest.h>
 #include "google/protobuf/descriptor.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include "google/protobuf/test_util.h"
 #include "google/protobuf/unittest.pb.h"
 #include "google/protobuf/unittest_no_field_presence.pb.h"
+#include "google/protobuf/unknown_field_set.h"
+#include "google/protobuf/wire_format_lite.h"
 
 namespace google {
 namespace protobuf {
@@ -132,6 +140,39 @@ TEST_F(DynamicMessageTest, OnePrototype) {
   EXPECT_EQ(prototype_, factory_.GetPrototype(descriptor_));
 }
 
+TEST_F(DynamicMessageTest, ConcurrentPrototypes) {
+  // Threads racing to create and look up prototypes on a fresh factory must
+  // all agree on a single, fully built prototype per type.
+  DynamicMessageFactory factory(&pool_);
+  const FileDescriptor* file = descriptor_->file();
+  std::vector<std::vector<const Message*>> results(4);
+  std::vector<std::thread> threads;
+  for (auto& result : results) {
+    threads.emplace_back([&] {
+      for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < file->message_type_count(); ++i) {
+          const Message* prototype =
+              factory.GetPrototype(file->message_type(i));
+          if (round == 0) result.push_back(prototype);
+          if (prototype != result[i] ||
+              prototype->GetDescriptor() != file->message_type(i)) {
+            result[i] = nullptr;
+          }
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  for (int i = 0; i < file->message_type_count(); ++i) {
+    EXPECT_EQ(results[0][i], factory.GetPrototype(file->message_type(i)));
+    for (const auto& result : results) EXPECT_EQ(results[0][i], result[i]);
+  }
+  TestUtil::ReflectionTester reflection_tester(descriptor_);
+  reflection_tester.ExpectClearViaReflection(
+      *factory.GetPrototype(descriptor_));
+}
+
 TEST_F(DynamicMessageTest, Defaults) {
   // Check that all default values are set correctly in the initial message.
   TestUtil::ReflectionTester reflection_tester(descriptor_);
@@ -269,6 +310,62 @@ TEST_P(DynamicMessageTest, SpaceUsed) {
   }
 }
 
+TEST_F(DynamicMessageTest, FieldLayoutAvoidsPadding) {
+  // Fields are reordered by alignment, so interleaving small and large fields
+  // costs no space compared to declaring them grouped.
+  FileDescriptorProto file;
+  file.set_name("layout.proto");
+  file.set_package("layout");
+  DescriptorProto* grouped = file.add_message_type();
+  grouped->set_name("Grouped");
+  DescriptorProto* interleaved = file.add_message_type();
+  interleaved->set_name("Interleaved");
+  const FieldDescriptorProto::Type kTypes[] = {
+      FieldDescriptorProto::TYPE_BOOL, FieldDescriptorProto::TYPE_INT64};
+  for (int i = 0; i < 6; ++i) {
+    FieldDescriptorProto* field = grouped->add_field();
+    field->set_name(absl::StrCat("f", i));
+    field->set_number(i + 1);
+    field->set_label(FieldDescriptorProto::LABEL_OPTIONAL);
+    field->set_type(kTypes[i / 3]);
+    *interleaved->add_field() = *field;
+    interleaved->mutable_field(i)->set_type(kTypes[i % 2]);
+  }
+  DescriptorPool pool;
+  ASSERT_TRUE(pool.BuildFile(file) != nullptr);
+  DynamicMessageFactory factory(&pool);
+  const Message* grouped_prototype =
+      factory.GetPrototype(pool.FindMessageTypeByName("layout.Grouped"));
+  const Message* interleaved_prototype =
+      factory.GetPrototype(pool.FindMessageTypeByName("layout.Interleaved"));
+  EXPECT_EQ(grouped_prototype->SpaceUsedLong(),
+            interleaved_prototype->SpaceUsedLong());
+
+  // Every field still gets its own storage and has-bit.
+  std::unique_ptr<Message> message(interleaved_prototype->New());
+  const Descriptor* descriptor = message->GetDescriptor();
+  const Reflection* reflection = message->GetReflection();
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    const FieldDescriptor* field = descriptor->field(i);
+    if (i % 2 == 0) {
+      reflection->SetBool(message.get(), field, true);
+    } else {
+      reflection->SetInt64(message.get(), field, -i);
+    }
+  }
+  std::unique_ptr<Message> parsed(interleaved_prototype->New());
+  ASSERT_TRUE(parsed->ParseFromString(message->SerializeAsString()));
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    const FieldDescriptor* field = descriptor->field(i);
+    EXPECT_TRUE(reflection->HasField(*parsed, field));
+    if (i % 2 == 0) {
+      EXPECT_TRUE(reflection->GetBool(*parsed, field));
+    } else {
+      EXPECT_EQ(-i, reflection->GetInt64(*parsed, field));
+    }
+  }
+}
+
 TEST_F(DynamicMessageTest, Arena) {
   Arena arena;
   Message* message = prototype_->New(&arena);
@@ -285,6 +382,46 @@ TEST_F(DynamicMessageTest, Arena) {
 }
 
 
+TEST_P(DynamicMessageTest, ParsesSparseClosedEnum) {
+  // Enums whose values are not one dense range are validated by the parse
+  // table against the encoded enum values, as in generated code.
+  const Descriptor* desc =
+      pool_.FindMessageTypeByName("protobuf_unittest.SparseEnumMessage");
+  ASSERT_TRUE(desc != nullptr);
+  const FieldDescriptor* field = desc->FindFieldByName("sparse_enum");
+  const Message* prototype = factory_.GetPrototype(desc);
+
+  // The last two are not values of the enum.
+  const int kValues[] = {unittest::SPARSE_A, unittest::SPARSE_B,
+                         unittest::SPARSE_C, unittest::SPARSE_E, 1, 7};
+  Arena arena;
+  for (int value : kValues) {
+    SCOPED_TRACE(value);
+    std::string data;
+    {
+      io::StringOutputStream output(&data);
+      io::CodedOutputStream coded(&output);
+      internal::WireFormatLite::WriteInt32(field->number(), value, &coded);
+    }
+    Message* message = GetParam() ? prototype->New(&arena) : prototype->New();
+    ASSERT_TRUE(message->ParseFromString(data));
+    const Reflection* refl = message->GetReflection();
+    if (unittest::TestSparseEnum_IsValid(value)) {
+      EXPECT_TRUE(refl->HasField(*message, field));
+      EXPECT_EQ(value, refl->GetEnumValue(*message, field));
+      EXPECT_EQ(0, refl->GetUnknownFields(*message).field_count());
+    } else {
+      EXPECT_FALSE(refl->HasField(*message, field));
+      const UnknownFieldSet& unknown = refl->GetUnknownFields(*message);
+      ASSERT_EQ(1, unknown.field_count());
+      EXPECT_EQ(value, unknown.field(0).varint());
+    }
+    EXPECT_EQ(data, message->SerializeAsString());
+    if (!GetParam()) delete message;
+  }
+}
+
+
 TEST_F(DynamicMessageTest, Proto3) {
   Message* message = proto3_prototype_->New();
   const Reflection* refl = message->GetReflection();
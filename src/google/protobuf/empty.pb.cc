@@ -101,9 +101,19 @@ const ::_pbi::DescriptorTable descriptor_table_google_2fprotobuf_2fempty_2eproto
 PROTOBUF_ATTRIBUTE_WEAK const ::_pbi::DescriptorTable* descriptor_table_google_2fprotobuf_2fempty_2eproto_getter() {
   return &descriptor_table_google_2fprotobuf_2fempty_2eproto;
 }
+#if defined(PROTOBUF_DESCRIPTOR_TABLE_SECTION)
+// Registered on first access to the generated pool.
+PROTOBUF_DESCRIPTOR_TABLE_SECTION
+static const ::_pbi::DescriptorTable* const dynamic_init_dummy_google_2fprotobuf_2fempty_2eproto =
+    &descriptor_table_google_2fprotobuf_2fempty_2eproto;
+// Makes this binary or shared object report its section.
+__attribute__((used)) static const bool* const descriptor_table_section_dummy_google_2fprotobuf_2fempty_2eproto =
+    &::_pbi::DescriptorTableSection<>::registered;
+#else
 // Force running AddDescriptors() at dynamic initialization time.
 PROTOBUF_ATTRIBUTE_INIT_PRIORITY2
 static ::_pbi::AddDescriptorsRunner dynamic_init_dummy_google_2fprotobuf_2fempty_2eproto(&descriptor_table_google_2fprotobuf_2fempty_2eproto);
+#endif  // defined(PROTOBUF_DESCRIPTOR_TABLE_SECTION)
 namespace google {
 namespace protobuf {
 // ===================================================================
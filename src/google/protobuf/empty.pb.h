@@ -206,6 +206,7 @@ class PROTOBUF_EXPORT Empty final :
 
 
 
+
 // ===================================================================
 
 
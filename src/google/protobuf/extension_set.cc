@@ -34,14 +34,19 @@
 
 #include "google/protobuf/extension_set.h"
 
+#include <atomic>
+#include <deque>
+#include <memory>
 #include <string>
 #include <tuple>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "google/protobuf/stubs/common.h"
-#include "absl/container/flat_hash_set.h"
+#include "absl/base/thread_annotations.h"
 #include "absl/hash/hash.h"
+#include "absl/synchronization/mutex.h"
 #include "google/protobuf/arena.h"
 #include "google/protobuf/extension_set_inl.h"
 #include "google/protobuf/io/coded_stream.h"
@@ -70,29 +75,93 @@ inline WireFormatLite::CppType cpp_type(FieldType type) {
 
 // Registry stuff.
 
-struct ExtensionEq {
-  bool operator()(const ExtensionInfo& lhs, const ExtensionInfo& rhs) const {
-    return lhs.message == rhs.message && lhs.number == rhs.number;
+// An insert-only open addressing hash table of registered extensions. Lookups
+// never lock, so that parsers on many threads do not contend on it: they load
+// the current table and probe it with acquire loads. Registration takes a
+// mutex and publishes the new entry into a free slot or, once the table gets
+// too full, publishes a copy of twice the size. A replaced table is kept
+// until shutdown, since readers may still be probing it; all of them together
+// are smaller than the current one.
+class ExtensionRegistry {
+ public:
+  ExtensionRegistry() = default;
+  ExtensionRegistry(const ExtensionRegistry&) = delete;
+  ExtensionRegistry& operator=(const ExtensionRegistry&) = delete;
+
+  const ExtensionInfo* Find(const MessageLite* extendee, int number) const {
+    const Table* table = table_.load(std::memory_order_acquire);
+    if (table == nullptr) return nullptr;
+    for (size_t i = Hash(extendee, number);; ++i) {
+      const ExtensionInfo* info =
+          table->slots[i & table->mask].load(std::memory_order_acquire);
+      if (info == nullptr) return nullptr;
+      if (info->message == extendee && info->number == number) return info;
+    }
   }
-};
 
-struct ExtensionHasher {
-  std::size_t operator()(const ExtensionInfo& info) const {
-    return absl::HashOf(info.message, info.number);
+  // Returns false if an extension with the same extendee and number is
+  // already registered.
+  bool Insert(const ExtensionInfo& info) {
+    absl::MutexLock lock(&mutex_);
+    if (Find(info.message, info.number) != nullptr) return false;
+    const Table* table = table_.load(std::memory_order_relaxed);
+    // Keep the load factor at or below 1/2.
+    if (table == nullptr || 2 * (infos_.size() + 1) > table->mask + 1) {
+      table = Grow(table);
+    }
+    infos_.push_back(info);
+    Publish(*table, &infos_.back());
+    return true;
   }
-};
 
-using ExtensionRegistry =
-    absl::flat_hash_set<ExtensionInfo, ExtensionHasher, ExtensionEq>;
+ private:
+  struct Table {
+    explicit Table(size_t capacity)
+        : mask(capacity - 1),
+          slots(new std::atomic<const ExtensionInfo*>[capacity]()) {}
+    size_t mask;
+    std::unique_ptr<std::atomic<const ExtensionInfo*>[]> slots;
+  };
 
-static const ExtensionRegistry* global_registry = nullptr;
+  static size_t Hash(const MessageLite* extendee, int number) {
+    return absl::HashOf(extendee, number);
+  }
 
-// This function is only called at startup, so there is no need for thread-
-// safety.
+  static void Publish(const Table& table, const ExtensionInfo* info) {
+    for (size_t i = Hash(info->message, info->number);; ++i) {
+      auto& slot = table.slots[i & table.mask];
+      if (slot.load(std::memory_order_relaxed) == nullptr) {
+        slot.store(info, std::memory_order_release);
+        return;
+      }
+    }
+  }
+
+  const Table* Grow(const Table* old) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    auto table =
+        std::make_unique<Table>(old == nullptr ? 64 : 2 * (old->mask + 1));
+    for (const ExtensionInfo& info : infos_) Publish(*table, &info);
+    table_.store(table.get(), std::memory_order_release);
+    tables_.push_back(std::move(table));
+    return tables_.back().get();
+  }
+
+  absl::Mutex mutex_;
+  std::atomic<const Table*> table_{nullptr};
+  // The current table is the last one.
+  std::vector<std::unique_ptr<Table>> tables_ ABSL_GUARDED_BY(mutex_);
+  // A deque never moves its elements, so the tables can point into it.
+  std::deque<ExtensionInfo> infos_ ABSL_GUARDED_BY(mutex_);
+};
+
+PROTOBUF_CONSTINIT std::atomic<const ExtensionRegistry*> global_registry{
+    nullptr};
+
+// Registration is safe while other threads look up extensions.
 void Register(const ExtensionInfo& info) {
   static auto local_static_registry = OnShutdownDelete(new ExtensionRegistry);
-  global_registry = local_static_registry;
-  if (!local_static_registry->insert(info).second) {
+  global_registry.store(local_static_registry, std::memory_order_release);
+  if (!local_static_registry->Insert(info)) {
     ABSL_LOG(FATAL) << "Multiple extension registrations for type \""
                     << info.message->GetTypeName() << "\", field number "
                     << info.number << ".";
@@ -101,18 +170,10 @@ void Register(const ExtensionInfo& info) {
 
 const ExtensionInfo* FindRegisteredExtension(const MessageLite* extendee,
                                              int number) {
-  if (!global_registry) return nullptr;
-
-  ExtensionInfo info;
-  info.message = extendee;
-  info.number = number;
-
-  auto it = global_registry->find(info);
-  if (it == global_registry->end()) {
-    return nullptr;
-  } else {
-    return &*it;
-  }
+  const ExtensionRegistry* registry =
+      global_registry.load(std::memory_order_acquire);
+  if (registry == nullptr) return nullptr;
+  return registry->Find(extendee, number);
 }
 
 }  // namespace
@@ -649,9 +710,11 @@ void ExtensionSet::SetAllocatedMessage(int number, FieldType type,
     ClearExtension(number);
     return;
   }
-  ABSL_DCHECK(message->GetOwningArena() == nullptr ||
-              message->GetOwningArena() == arena_);
   Arena* message_arena = message->GetOwningArena();
+  ABSL_DCHECK(message_arena == nullptr ||
+              Arena::IsFused(message_arena, arena_));
+  // A message on a fused arena is adopted as if it were on `arena_`.
+  if (Arena::IsFused(message_arena, arena_)) message_arena = arena_;
   Extension* extension;
   if (MaybeNewExtension(number, descriptor, &extension)) {
     extension->type = type;
@@ -1238,15 +1301,17 @@ const char* ExtensionSet::ParseField(uint64_t tag, const char* ptr,
     return UnknownFieldParse(
         tag, metadata->mutable_unknown_fields<std::string>(), ptr, ctx);
   }
-  return ParseFieldWithExtensionInfo<std::string>(
-      number, was_packed_on_wire, extension, metadata, ptr, ctx);
+  return ParseFieldRunWithExtensionInfo<std::string>(
+      tag, was_packed_on_wire, extension, metadata, ptr, ctx);
 }
 
 const char* ExtensionSet::ParseMessageSetItem(
     const char* ptr, const MessageLite* extendee,
-    internal::InternalMetadata* metadata, internal::ParseContext* ctx) {
+    internal::InternalMetadata* metadata, internal::ParseContext* ctx,
+    MessageSetTypeCache* type_cache) {
   return ParseMessageSetItemTmpl<MessageLite, std::string>(ptr, extendee,
-                                                           metadata, ctx);
+                                                           metadata, ctx,
+                                                           type_cache);
 }
 
 uint8_t* ExtensionSet::_InternalSerializeImpl(
@@ -1592,7 +1657,15 @@ const ExtensionSet::Extension* ExtensionSet::FindOrNull(int key) const {
   if (flat_size_ == 0) {
     return nullptr;
   } else if (PROTOBUF_PREDICT_TRUE(!is_large())) {
-    auto it = std::lower_bound(flat_begin(), flat_end() - 1, key,
+    // Extensions are often numbered consecutively. When the keys up to `key`
+    // are, its index follows from the first key and no search is needed.
+    const KeyValue* begin = flat_begin();
+    const uint32_t index =
+        static_cast<uint32_t>(key) - static_cast<uint32_t>(begin->first);
+    if (index < flat_size_ && begin[index].first == key) {
+      return &begin[index].second;
+    }
+    auto it = std::lower_bound(begin, flat_end() - 1, key,
                                KeyValue::FirstComparator());
     return it->first == key ? &it->second : nullptr;
   } else {
@@ -208,7 +208,8 @@ class PROTOBUF_EXPORT ExtensionSet {
   // register known extensions.  The registrations are used by ParseField()
   // to look up extensions for parsed field numbers.  Note that dynamic parsing
   // does not use ParseField(); only protocol-compiler-generated parsing
-  // methods do.
+  // methods do.  Registration may also happen later, concurrently with
+  // parsing on other threads.
   static void RegisterExtension(const MessageLite* extendee, int number,
                                 FieldType type, bool is_repeated,
                                 bool is_packed,
@@ -417,14 +418,17 @@ class PROTOBUF_EXPORT ExtensionSet {
   const char* ParseMessageSet(const char* ptr, const Msg* extendee,
                               InternalMetadata* metadata,
                               internal::ParseContext* ctx) {
+    MessageSetTypeCache type_cache;
     struct MessageSetItem {
       const char* _InternalParse(const char* ptr, ParseContext* ctx) {
-        return me->ParseMessageSetItem(ptr, extendee, metadata, ctx);
+        return me->ParseMessageSetItem(ptr, extendee, metadata, ctx,
+                                       type_cache);
       }
       ExtensionSet* me;
       const Msg* extendee;
       InternalMetadata* metadata;
-    } item{this, extendee, metadata};
+      MessageSetTypeCache* type_cache;
+    } item{this, extendee, metadata, &type_cache};
     while (!ctx->Done(&ptr)) {
       uint32_t tag;
       ptr = ReadTag(ptr, &tag);
@@ -859,24 +863,45 @@ class PROTOBUF_EXPORT ExtensionSet {
                             const Message* extendee,
                             const internal::ParseContext* ctx,
                             ExtensionInfo* extension, bool* was_packed_on_wire);
-  // Used for MessageSet only
-  const char* ParseFieldMaybeLazily(uint64_t tag, const char* ptr,
-                                    const MessageLite* extendee,
-                                    internal::InternalMetadata* metadata,
-                                    internal::ParseContext* ctx) {
-    // Lite MessageSet doesn't implement lazy.
-    return ParseField(tag, ptr, extendee, metadata, ctx);
-  }
-  const char* ParseFieldMaybeLazily(uint64_t tag, const char* ptr,
-                                    const Message* extendee,
-                                    internal::InternalMetadata* metadata,
-                                    internal::ParseContext* ctx);
+
+  // The extensions that one ParseMessageSet() call resolved, by type_id, so
+  // that the items of a MessageSet look each of their types up once rather
+  // than once per item.  Direct mapped; a collision only costs a lookup.
+  struct MessageSetTypeCache {
+    struct Entry {
+      uint32_t type_id = 0;  // Never a valid type_id.
+      bool found = false;
+      bool was_packed_on_wire = false;
+      ExtensionInfo extension;
+    };
+    static constexpr int kSize = 8;
+    Entry entries[kSize];
+  };
+  template <typename Msg>
+  bool FindMessageSetExtension(uint32_t type_id, const Msg* extendee,
+                               const internal::ParseContext* ctx,
+                               MessageSetTypeCache* type_cache,
+                               ExtensionInfo* extension,
+                               bool* was_packed_on_wire) {
+    auto& entry = type_cache->entries[type_id % MessageSetTypeCache::kSize];
+    if (entry.type_id != type_id) {
+      entry.type_id = type_id;
+      entry.found = FindExtension(WireFormatLite::WIRETYPE_LENGTH_DELIMITED,
+                                  type_id, extendee, ctx, &entry.extension,
+                                  &entry.was_packed_on_wire);
+    }
+    *extension = entry.extension;
+    *was_packed_on_wire = entry.was_packed_on_wire;
+    return entry.found;
+  }
   const char* ParseMessageSetItem(const char* ptr, const MessageLite* extendee,
                                   internal::InternalMetadata* metadata,
-                                  internal::ParseContext* ctx);
+                                  internal::ParseContext* ctx,
+                                  MessageSetTypeCache* type_cache);
   const char* ParseMessageSetItem(const char* ptr, const Message* extendee,
                                   internal::InternalMetadata* metadata,
-                                  internal::ParseContext* ctx);
+                                  internal::ParseContext* ctx,
+                                  MessageSetTypeCache* type_cache);
 
   // Implemented in extension_set_inl.h to keep code out of the header file.
   template <typename T>
@@ -885,10 +910,26 @@ class PROTOBUF_EXPORT ExtensionSet {
                                           internal::InternalMetadata* metadata,
                                           const char* ptr,
                                           internal::ParseContext* ctx);
+  // Parses the field at `ptr` and any values with the same `tag` that directly
+  // follow it, so the extension is looked up once for the whole run. Also in
+  // extension_set_inl.h.
+  template <typename T>
+  const char* ParseFieldRunWithExtensionInfo(
+      uint32_t tag, bool was_packed_on_wire, const ExtensionInfo& info,
+      internal::InternalMetadata* metadata, const char* ptr,
+      internal::ParseContext* ctx);
   template <typename Msg, typename T>
   const char* ParseMessageSetItemTmpl(const char* ptr, const Msg* extendee,
                                       internal::InternalMetadata* metadata,
-                                      internal::ParseContext* ctx);
+                                      internal::ParseContext* ctx,
+                                      MessageSetTypeCache* type_cache);
+  // Parses the message of a MessageSet item whose type_id was already read.
+  template <typename Msg, typename T>
+  const char* ParseMessageSetItemMessage(uint32_t type_id, const char* ptr,
+                                         const Msg* extendee,
+                                         internal::InternalMetadata* metadata,
+                                         internal::ParseContext* ctx,
+                                         MessageSetTypeCache* type_cache);
 
   // Hack:  RepeatedPtrFieldBase declares ExtensionSet as a friend.  This
   //   friendship should automatically extend to ExtensionSet::Extension, but
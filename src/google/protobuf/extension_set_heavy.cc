@@ -339,21 +339,17 @@ const char* ExtensionSet::ParseField(uint64_t tag, const char* ptr,
     return UnknownFieldParse(
         tag, metadata->mutable_unknown_fields<UnknownFieldSet>(), ptr, ctx);
   }
-  return ParseFieldWithExtensionInfo<UnknownFieldSet>(
-      number, was_packed_on_wire, extension, metadata, ptr, ctx);
-}
-
-const char* ExtensionSet::ParseFieldMaybeLazily(
-    uint64_t tag, const char* ptr, const Message* extendee,
-    internal::InternalMetadata* metadata, internal::ParseContext* ctx) {
-  return ParseField(tag, ptr, extendee, metadata, ctx);
+  return ParseFieldRunWithExtensionInfo<UnknownFieldSet>(
+      tag, was_packed_on_wire, extension, metadata, ptr, ctx);
 }
 
 const char* ExtensionSet::ParseMessageSetItem(
     const char* ptr, const Message* extendee,
-    internal::InternalMetadata* metadata, internal::ParseContext* ctx) {
+    internal::InternalMetadata* metadata, internal::ParseContext* ctx,
+    MessageSetTypeCache* type_cache) {
   return ParseMessageSetItemTmpl<Message, UnknownFieldSet>(ptr, extendee,
-                                                           metadata, ctx);
+                                                           metadata, ctx,
+                                                           type_cache);
 }
 
 int ExtensionSet::SpaceUsedExcludingSelf() const {
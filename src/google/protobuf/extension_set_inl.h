@@ -201,15 +201,72 @@ const char* ExtensionSet::ParseFieldWithExtensionInfo(
   return ptr;
 }
 
+template <typename T>
+const char* ExtensionSet::ParseFieldRunWithExtensionInfo(
+    uint32_t tag, bool was_packed_on_wire, const ExtensionInfo& extension,
+    InternalMetadata* metadata, const char* ptr, internal::ParseContext* ctx) {
+  const int number = WireFormatLite::GetTagFieldNumber(tag);
+  while (true) {
+    ptr = ParseFieldWithExtensionInfo<T>(number, was_packed_on_wire, extension,
+                                         metadata, ptr, ctx);
+    if (ptr == nullptr || !ctx->DataAvailable(ptr)) return ptr;
+    uint32_t next_tag;
+    const char* next = ReadTag(ptr, &next_tag);
+    if (next_tag != tag) return ptr;
+    ptr = next;
+  }
+}
+
+template <typename Msg, typename T>
+const char* ExtensionSet::ParseMessageSetItemMessage(
+    uint32_t type_id, const char* ptr, const Msg* extendee,
+    internal::InternalMetadata* metadata, internal::ParseContext* ctx,
+    MessageSetTypeCache* type_cache) {
+  ExtensionInfo extension;
+  bool was_packed_on_wire;
+  if (!FindMessageSetExtension(type_id, extendee, ctx, type_cache, &extension,
+                               &was_packed_on_wire)) {
+    return UnknownFieldParse(static_cast<uint64_t>(type_id) * 8 + 2,
+                             metadata->mutable_unknown_fields<T>(), ptr, ctx);
+  }
+  return ParseFieldWithExtensionInfo<T>(type_id, was_packed_on_wire, extension,
+                                        metadata, ptr, ctx);
+}
+
 template <typename Msg, typename T>
 const char* ExtensionSet::ParseMessageSetItemTmpl(
     const char* ptr, const Msg* extendee, internal::InternalMetadata* metadata,
-    internal::ParseContext* ctx) {
+    internal::ParseContext* ctx, MessageSetTypeCache* type_cache) {
   std::string payload;
   uint32_t type_id = 0;
   enum class State { kNoTag, kHasType, kHasPayload, kDone };
   State state = State::kNoTag;
 
+  // Serializers write the type_id, then the message, then the end of the
+  // item. Take that layout straight through, and leave anything else to the
+  // state machine below from wherever it departs from it.
+  if (ctx->DataAvailable(ptr) &&
+      static_cast<uint8_t>(*ptr) == WireFormatLite::kMessageSetTypeIdTag) {
+    uint64_t tmp;
+    ptr = ParseBigVarint(ptr + 1, &tmp);
+    GOOGLE_PROTOBUF_PARSER_ASSERT(ptr != nullptr &&
+                                   static_cast<uint32_t>(tmp) != 0);
+    type_id = static_cast<uint32_t>(tmp);
+    state = State::kHasType;
+    if (ctx->DataAvailable(ptr) &&
+        static_cast<uint8_t>(*ptr) == WireFormatLite::kMessageSetMessageTag) {
+      ptr = ParseMessageSetItemMessage<Msg, T>(type_id, ptr + 1, extendee,
+                                               metadata, ctx, type_cache);
+      GOOGLE_PROTOBUF_PARSER_ASSERT(ptr != nullptr);
+      state = State::kDone;
+      if (ctx->DataAvailable(ptr) &&
+          static_cast<uint8_t>(*ptr) == WireFormatLite::kMessageSetItemEndTag) {
+        ctx->SetLastTag(WireFormatLite::kMessageSetItemEndTag);
+        return ptr + 1;
+      }
+    }
+  }
+
   while (!ctx->Done(&ptr)) {
     uint32_t tag = static_cast<uint8_t>(*ptr++);
     if (tag == WireFormatLite::kMessageSetTypeIdTag) {
@@ -225,8 +282,8 @@ const char* ExtensionSet::ParseMessageSetItemTmpl(
         type_id = static_cast<uint32_t>(tmp);
         ExtensionInfo extension;
         bool was_packed_on_wire;
-        if (!FindExtension(2, type_id, extendee, ctx, &extension,
-                           &was_packed_on_wire)) {
+        if (!FindMessageSetExtension(type_id, extendee, ctx, type_cache,
+                                     &extension, &was_packed_on_wire)) {
           WriteLengthDelimited(type_id, payload,
                                metadata->mutable_unknown_fields<T>());
         } else {
@@ -246,13 +303,16 @@ const char* ExtensionSet::ParseMessageSetItemTmpl(
           ParseContext tmp_ctx(ParseContext::kSpawn, *ctx, &p, payload);
           GOOGLE_PROTOBUF_PARSER_ASSERT(value->_InternalParse(p, &tmp_ctx) &&
                                          tmp_ctx.EndedAtLimit());
+          if (tmp_ctx.needs_initialization_check()) {
+            ctx->RequireInitializationCheck();
+          }
         }
         state = State::kDone;
       }
     } else if (tag == WireFormatLite::kMessageSetMessageTag) {
       if (state == State::kHasType) {
-        ptr = ParseFieldMaybeLazily(static_cast<uint64_t>(type_id) * 8 + 2, ptr,
-                                    extendee, metadata, ctx);
+        ptr = ParseMessageSetItemMessage<Msg, T>(type_id, ptr, extendee,
+                                                 metadata, ctx, type_cache);
         GOOGLE_PROTOBUF_PARSER_ASSERT(ptr != nullptr);
         state = State::kDone;
       } else {
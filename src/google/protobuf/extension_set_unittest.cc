@@ -34,6 +34,10 @@
 
 #include "google/protobuf/extension_set.h"
 
+#include <atomic>
+#include <thread>  // NOLINT
+#include <vector>
+
 #include "google/protobuf/descriptor.pb.h"
 #include "google/protobuf/testing/googletest.h"
 #include <gtest/gtest.h>
@@ -663,6 +667,111 @@ TEST(ExtensionSetTest, Parsing) {
   TestUtil::ExpectAllExtensionsSet(destination);
 }
 
+TEST(ExtensionSetTest, ParsingRunsOfRepeatedExtensions) {
+  // Consecutive values of a repeated field are parsed as one run.
+  unittest::TestAllTypes source;
+  for (int i = 0; i < 1000; ++i) {
+    source.add_repeated_int32(i);
+    source.add_repeated_string(absl::StrCat("value", i));
+    source.add_repeated_nested_message()->set_bb(i);
+  }
+  source.set_optional_int32(-1);
+  std::string data;
+  source.SerializeToString(&data);
+  // The same field again after another one starts a new run.
+  unittest::TestAllTypes more;
+  more.add_repeated_int32(1000);
+  data += more.SerializeAsString();
+
+  unittest::TestAllExtensions destination;
+  ASSERT_TRUE(destination.ParseFromString(data));
+  ASSERT_EQ(1001,
+            destination.ExtensionSize(unittest::repeated_int32_extension));
+  ASSERT_EQ(1000,
+            destination.ExtensionSize(unittest::repeated_string_extension));
+  ASSERT_EQ(1000, destination.ExtensionSize(
+                      unittest::repeated_nested_message_extension));
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(i,
+              destination.GetExtension(unittest::repeated_int32_extension, i));
+    EXPECT_EQ(absl::StrCat("value", i),
+              destination.GetExtension(unittest::repeated_string_extension, i));
+    EXPECT_EQ(i, destination
+                     .GetExtension(
+                         unittest::repeated_nested_message_extension, i)
+                     .bb());
+  }
+  EXPECT_EQ(1000,
+            destination.GetExtension(unittest::repeated_int32_extension, 1000));
+  EXPECT_EQ(-1, destination.GetExtension(unittest::optional_int32_extension));
+
+  // Runs inside a submessage end with it.
+  unittest::TestChildExtension child;
+  *child.mutable_optional_extension() = destination;
+  child.set_b("after");
+  unittest::TestChildExtension child_destination;
+  ASSERT_TRUE(child_destination.ParseFromString(child.SerializeAsString()));
+  EXPECT_EQ(1001, child_destination.optional_extension().ExtensionSize(
+                      unittest::repeated_int32_extension));
+  EXPECT_EQ("after", child_destination.b());
+}
+
+TEST(ExtensionSetTest, FindsExtensionsWithGapsInNumbers) {
+  // Lookups take a shortcut while the extension numbers are consecutive.
+  unittest::TestAllExtensions message;
+  message.SetExtension(unittest::optional_int32_extension, 1);   // 1
+  message.SetExtension(unittest::optional_int64_extension, 2);   // 2
+  message.SetExtension(unittest::optional_uint64_extension, 4);  // 4
+  message.SetExtension(unittest::optional_sint32_extension, 5);  // 5
+  EXPECT_TRUE(message.HasExtension(unittest::optional_int32_extension));
+  EXPECT_TRUE(message.HasExtension(unittest::optional_int64_extension));
+  EXPECT_FALSE(message.HasExtension(unittest::optional_uint32_extension));
+  EXPECT_EQ(4, message.GetExtension(unittest::optional_uint64_extension));
+  EXPECT_EQ(5, message.GetExtension(unittest::optional_sint32_extension));
+  EXPECT_FALSE(message.HasExtension(unittest::optional_sint64_extension));
+  message.SetExtension(unittest::optional_uint32_extension, 3);  // 3
+  EXPECT_EQ(3, message.GetExtension(unittest::optional_uint32_extension));
+  EXPECT_EQ(4, message.GetExtension(unittest::optional_uint64_extension));
+}
+
+TEST(ExtensionSetTest, RegistrationDoesNotBlockLookups) {
+  // Registering extensions while other threads look up generated ones must
+  // neither lose nor corrupt entries, including across table growth.
+  constexpr int kFirstNumber = 200000;
+  constexpr int kRegistered = 2000;
+  const MessageLite* extendee =
+      &unittest::TestAllExtensions::default_instance();
+  std::atomic<bool> done{false};
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; ++t) {
+    readers.emplace_back([&] {
+      internal::GeneratedExtensionFinder finder(extendee);
+      internal::ExtensionInfo info;
+      do {
+        ASSERT_TRUE(finder.Find(1, &info));
+        EXPECT_EQ(info.type, internal::WireFormatLite::TYPE_INT32);
+        EXPECT_FALSE(finder.Find(kFirstNumber - 1, &info));
+      } while (!done.load(std::memory_order_relaxed));
+    });
+  }
+  for (int i = 0; i < kRegistered; ++i) {
+    internal::ExtensionSet::RegisterExtension(
+        extendee, kFirstNumber + i, internal::WireFormatLite::TYPE_SINT64,
+        /*is_repeated=*/false, /*is_packed=*/false,
+        /*verify_func=*/nullptr);
+  }
+  done.store(true, std::memory_order_relaxed);
+  for (auto& reader : readers) reader.join();
+
+  internal::GeneratedExtensionFinder finder(extendee);
+  internal::ExtensionInfo info;
+  for (int i = 0; i < kRegistered; ++i) {
+    ASSERT_TRUE(finder.Find(kFirstNumber + i, &info));
+    EXPECT_EQ(info.type, internal::WireFormatLite::TYPE_SINT64);
+  }
+  EXPECT_FALSE(finder.Find(kFirstNumber + kRegistered, &info));
+}
+
 TEST(ExtensionSetTest, PackedParsing) {
   // Serialize as TestPackedTypes and parse as TestPackedExtensions.
   unittest::TestPackedTypes source;
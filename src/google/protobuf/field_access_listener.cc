@@ -0,0 +1,148 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "google/protobuf/field_access_listener.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "absl/log/absl_check.h"
+#include "absl/strings/str_cat.h"
+#include "google/protobuf/descriptor.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace {
+
+// How many accessor calls a thread makes between checks of whether sampling
+// got enabled.
+constexpr int kDisabledCountdown = 1 << 16;
+
+std::atomic<int> field_access_sample_period{0};
+std::atomic<internal::FieldAccessCounts*> field_access_counts{nullptr};
+
+}  // namespace
+
+namespace internal {
+
+#if defined(PROTOBUF_USE_DLLS) && defined(_WIN32)
+int& FieldAccessSampling::countdown() {
+  static PROTOBUF_THREAD_LOCAL int countdown = 0;
+  return countdown;
+}
+#else
+PROTOBUF_CONSTINIT PROTOBUF_THREAD_LOCAL int FieldAccessSampling::countdown_ =
+    0;
+#endif
+
+void FieldAccessSampling::Register(FieldAccessCounts* counts) {
+  counts->next = field_access_counts.load(std::memory_order_relaxed);
+  while (!field_access_counts.compare_exchange_weak(
+      counts->next, counts, std::memory_order_release,
+      std::memory_order_relaxed)) {
+  }
+}
+
+void FieldAccessSampling::RecordAccess(FieldAccessCounts* counts, int index,
+                                       bool write) {
+  const int period = field_access_sample_period.load(std::memory_order_relaxed);
+  countdown() = period > 0 ? period : kDisabledCountdown;
+  if (period == 0 || counts->reads == nullptr) return;
+  (write ? counts->writes : counts->reads)[index].fetch_add(
+      period, std::memory_order_relaxed);
+}
+
+}  // namespace internal
+
+void SetFieldAccessSamplingPeriod(int period) {
+  ABSL_CHECK_GE(period, 0);
+  field_access_sample_period.store(period, std::memory_order_relaxed);
+}
+
+std::vector<FieldAccessFrequency> GetFieldAccessProfile() {
+  std::vector<FieldAccessFrequency> profile;
+  for (const internal::FieldAccessCounts* counts =
+           field_access_counts.load(std::memory_order_acquire);
+       counts != nullptr; counts = counts->next) {
+    // The counts are by field index, as the generated accessors know it.
+    const Descriptor* descriptor =
+        DescriptorPool::generated_pool()->FindMessageTypeByName(
+            counts->name_extractor());
+    if (descriptor == nullptr) continue;
+    const int field_count =
+        std::min(counts->field_count, descriptor->field_count());
+    for (int i = 0; i < field_count; ++i) {
+      uint64_t reads = counts->reads[i].load(std::memory_order_relaxed);
+      uint64_t writes = counts->writes[i].load(std::memory_order_relaxed);
+      if (reads == 0 && writes == 0) continue;
+      profile.push_back({descriptor->full_name(),
+                         descriptor->field(i)->number(), reads, writes});
+    }
+  }
+  std::sort(profile.begin(), profile.end(),
+            [](const FieldAccessFrequency& a, const FieldAccessFrequency& b) {
+              return std::tie(a.message_name, a.field_number) <
+                     std::tie(b.message_name, b.field_number);
+            });
+  return profile;
+}
+
+std::string FieldAccessProfileToString() {
+  std::string out;
+  for (const FieldAccessFrequency& field : GetFieldAccessProfile()) {
+    absl::StrAppend(&out, field.message_name, " ", field.field_number, " ",
+                    field.reads + field.writes, "\n");
+  }
+  return out;
+}
+
+void ResetFieldAccessProfile() {
+  for (internal::FieldAccessCounts* counts =
+           field_access_counts.load(std::memory_order_acquire);
+       counts != nullptr; counts = counts->next) {
+    for (int i = 0; i < counts->field_count; ++i) {
+      counts->reads[i].store(0, std::memory_order_relaxed);
+      counts->writes[i].store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
@@ -31,11 +31,18 @@
 #ifndef GOOGLE_PROTOBUF_FIELD_ACCESS_LISTENER_H__
 #define GOOGLE_PROTOBUF_FIELD_ACCESS_LISTENER_H__
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
 
+#include "absl/strings/string_view.h"
 #include "google/protobuf/message_lite.h"
 #include "google/protobuf/port.h"
 
+// Must be included last.
+#include "google/protobuf/port_def.inc"
 
 namespace google {
 namespace protobuf {
@@ -159,14 +166,172 @@ struct NoOpAccessListener {
                                      const void* field) {}
 };
 
+namespace internal {
+
+// The access counts of one message type, indexed by field index.
+struct FieldAccessCounts {
+  absl::string_view (*name_extractor)();
+  int field_count;
+  std::atomic<uint64_t>* reads;
+  std::atomic<uint64_t>* writes;
+  FieldAccessCounts* next;
+};
+
+template <int kFields>
+struct FieldAccessTable {
+  FieldAccessCounts counts;
+  std::atomic<uint64_t> reads[kFields];
+  std::atomic<uint64_t> writes[kFields];
+};
+
+class PROTOBUF_EXPORT FieldAccessSampling {
+ public:
+  // Makes the counts of a message type part of GetFieldAccessProfile().
+  static void Register(FieldAccessCounts* counts);
+
+  // Called when the countdown of the calling thread runs out. Counts the
+  // access if sampling is enabled, and restarts the countdown.
+  static void RecordAccess(FieldAccessCounts* counts, int index, bool write);
+
+#if defined(PROTOBUF_USE_DLLS) && defined(_WIN32)
+  // Thread local variables cannot be exposed through MSVC DLL interface but we
+  // can wrap them in static functions.
+  static int& countdown();
+#else
+  static int& countdown() { return countdown_; }
+
+ private:
+  PROTOBUF_CONSTINIT static PROTOBUF_THREAD_LOCAL int countdown_;
+#endif
+};
+
+}  // namespace internal
+
+// An access listener cheap enough for production: every accessor call only
+// decrements a thread local countdown, and one in every N calls, as set by
+// SetFieldAccessSamplingPeriod(), counts a read or a write of the field in a
+// table of its message type. Extension accesses and whole-message events are
+// not counted.
+//
+// Enabled by building the generated code with the C++ generator's
+// `inject_field_listener_events` option and the runtime with
+// PROTOBUF_SAMPLE_FIELD_ACCESS defined.
+template <typename Proto>
+struct SampledAccessListener : NoOpAccessListener<Proto> {
+  explicit SampledAccessListener(absl::string_view (*name_extractor)())
+      : NoOpAccessListener<Proto>(name_extractor) {
+    table_.counts.name_extractor = name_extractor;
+    table_.counts.field_count = Proto::_kInternalFieldNumber;
+    table_.counts.reads = table_.reads;
+    table_.counts.writes = table_.writes;
+    internal::FieldAccessSampling::Register(&table_.counts);
+  }
+
+  template <int kFieldNum>
+  static void OnAdd(const MessageLite* msg, const void* field) {
+    Sample(kFieldNum, /*write=*/true);
+  }
+  template <int kFieldNum>
+  static void OnAddMutable(const MessageLite* msg, const void* field) {
+    Sample(kFieldNum, /*write=*/true);
+  }
+  template <int kFieldNum>
+  static void OnGet(const MessageLite* msg, const void* field) {
+    Sample(kFieldNum, /*write=*/false);
+  }
+  template <int kFieldNum>
+  static void OnClear(const MessageLite* msg, const void* field) {
+    Sample(kFieldNum, /*write=*/true);
+  }
+  template <int kFieldNum>
+  static void OnHas(const MessageLite* msg, const void* field) {
+    Sample(kFieldNum, /*write=*/false);
+  }
+  template <int kFieldNum>
+  static void OnList(const MessageLite* msg, const void* field) {
+    Sample(kFieldNum, /*write=*/false);
+  }
+  template <int kFieldNum>
+  static void OnMutable(const MessageLite* msg, const void* field) {
+    Sample(kFieldNum, /*write=*/true);
+  }
+  template <int kFieldNum>
+  static void OnMutableList(const MessageLite* msg, const void* field) {
+    Sample(kFieldNum, /*write=*/true);
+  }
+  template <int kFieldNum>
+  static void OnRelease(const MessageLite* msg, const void* field) {
+    Sample(kFieldNum, /*write=*/true);
+  }
+  template <int kFieldNum>
+  static void OnSet(const MessageLite* msg, const void* field) {
+    Sample(kFieldNum, /*write=*/true);
+  }
+  template <int kFieldNum>
+  static void OnSize(const MessageLite* msg, const void* field) {
+    Sample(kFieldNum, /*write=*/false);
+  }
+
+ private:
+  static constexpr int kTableSize =
+      Proto::_kInternalFieldNumber > 0 ? Proto::_kInternalFieldNumber : 1;
+
+  static void Sample(int index, bool write) {
+    if (PROTOBUF_PREDICT_TRUE(--internal::FieldAccessSampling::countdown() >
+                              0)) {
+      return;
+    }
+    internal::FieldAccessSampling::RecordAccess(&table_.counts, index, write);
+  }
+
+  // Zero-initialized, so that accesses during static initialization, before
+  // the constructor has run, are safely ignored.
+  static internal::FieldAccessTable<kTableSize> table_;
+};
+
+template <typename Proto>
+internal::FieldAccessTable<SampledAccessListener<Proto>::kTableSize>
+    SampledAccessListener<Proto>::table_;
+
+// Sets SampledAccessListener to count one in every `period` accessor calls of
+// each thread, or disables counting if `period` is 0, the default. Threads
+// that are not counting pick up a new period within 65536 accessor calls.
+PROTOBUF_EXPORT void SetFieldAccessSamplingPeriod(int period);
+
+struct FieldAccessFrequency {
+  std::string message_name;
+  int field_number;
+  // Estimated totals: every sampled access counts for the sampling period.
+  uint64_t reads;
+  uint64_t writes;
+};
+
+// Returns the fields of the generated messages seen by SampledAccessListener,
+// sorted by message name and field number.
+PROTOBUF_EXPORT std::vector<FieldAccessFrequency> GetFieldAccessProfile();
+
+// Returns one `<message full name> <field number> <reads + writes>` line per
+// accessed field: the format of the C++ code generator's `parse_profile`
+// option, so that accessor frequencies from live traffic can drive the field
+// layout, string inlining and fast table choices like parse frequencies do.
+PROTOBUF_EXPORT std::string FieldAccessProfileToString();
+
+// Zeroes all counts, e.g. to start a new profiling window.
+PROTOBUF_EXPORT void ResetFieldAccessProfile();
+
 }  // namespace protobuf
 }  // namespace google
 
 #ifndef REPLACE_PROTO_LISTENER_IMPL
 namespace google {
 namespace protobuf {
+#ifdef PROTOBUF_SAMPLE_FIELD_ACCESS
+template <class T>
+using AccessListener = SampledAccessListener<T>;
+#else
 template <class T>
 using AccessListener = NoOpAccessListener<T>;
+#endif
 }  // namespace protobuf
 }  // namespace google
 #else
@@ -175,4 +340,6 @@ using AccessListener = NoOpAccessListener<T>;
 
 #endif  // !REPLACE_PROTO_LISTENER_IMPL
 
+#include "google/protobuf/port_undef.inc"
+
 #endif  // GOOGLE_PROTOBUF_FIELD_ACCESS_LISTENER_H__
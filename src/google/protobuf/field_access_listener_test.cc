@@ -0,0 +1,150 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/field_access_listener.h"
+
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/strings/string_view.h"
+#include "google/protobuf/unittest.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+// Stands in for a message generated with inject_field_listener_events.  Its
+// counts are reported under TestAllTypes, whose first three fields are
+// optional_int32 (1), optional_int64 (2) and optional_uint32 (3).
+struct FakeProto {
+  static constexpr int _kInternalFieldNumber = 3;
+};
+
+using Listener = SampledAccessListener<FakeProto>;
+
+absl::string_view FakeProtoName() { return "protobuf_unittest.TestAllTypes"; }
+
+const Listener listener(&FakeProtoName);
+
+// Makes the calling thread pick up the current period.  A thread that is not
+// counting only rereads it every 65536 accessor calls.
+void SyncCountdown() {
+  for (int i = 0; i < (1 << 16); ++i) {
+    Listener::OnGet<0>(nullptr, nullptr);
+  }
+}
+
+class FieldAccessListenerTest : public ::testing::Test {
+ protected:
+  void TearDown() override {
+    SetFieldAccessSamplingPeriod(0);
+    SyncCountdown();
+    ResetFieldAccessProfile();
+  }
+
+  // Enables sampling with `period` and starts from empty counts.
+  void Enable(int period) {
+    SetFieldAccessSamplingPeriod(period);
+    SyncCountdown();
+    ResetFieldAccessProfile();
+  }
+};
+
+MATCHER_P4(Frequency, name, number, reads, writes, "") {
+  return arg.message_name == name && arg.field_number == number &&
+         arg.reads == reads && arg.writes == writes;
+}
+
+TEST_F(FieldAccessListenerTest, DisabledByDefault) {
+  ResetFieldAccessProfile();
+  for (int i = 0; i < 3 * (1 << 16); ++i) {
+    Listener::OnGet<0>(nullptr, nullptr);
+    Listener::OnSet<1>(nullptr, nullptr);
+  }
+  EXPECT_THAT(GetFieldAccessProfile(), IsEmpty());
+  EXPECT_EQ(FieldAccessProfileToString(), "");
+}
+
+TEST_F(FieldAccessListenerTest, SamplesOneInPeriodCalls) {
+  Enable(10);
+  // Whatever the countdown is left at, 1000 calls take exactly 100 samples,
+  // each counting for 10 accesses.
+  for (int i = 0; i < 1000; ++i) Listener::OnGet<0>(nullptr, nullptr);
+  EXPECT_THAT(GetFieldAccessProfile(),
+              ElementsAre(Frequency("protobuf_unittest.TestAllTypes", 1,
+                                    1000u, 0u)));
+}
+
+TEST_F(FieldAccessListenerTest, ForwardsReadsAndWritesToTheirField) {
+  Enable(1);
+  Listener::OnGet<0>(nullptr, nullptr);
+  Listener::OnHas<0>(nullptr, nullptr);
+  Listener::OnSize<0>(nullptr, nullptr);
+  Listener::OnList<0>(nullptr, nullptr);
+  Listener::OnSet<1>(nullptr, nullptr);
+  Listener::OnClear<1>(nullptr, nullptr);
+  Listener::OnMutable<1>(nullptr, nullptr);
+  Listener::OnMutableList<1>(nullptr, nullptr);
+  Listener::OnAdd<2>(nullptr, nullptr);
+  Listener::OnAddMutable<2>(nullptr, nullptr);
+  Listener::OnRelease<2>(nullptr, nullptr);
+  Listener::OnGet<2>(nullptr, nullptr);
+
+  EXPECT_THAT(
+      GetFieldAccessProfile(),
+      ElementsAre(Frequency("protobuf_unittest.TestAllTypes", 1, 4u, 0u),
+                  Frequency("protobuf_unittest.TestAllTypes", 2, 0u, 4u),
+                  Frequency("protobuf_unittest.TestAllTypes", 3, 1u, 3u)));
+  EXPECT_EQ(FieldAccessProfileToString(),
+            "protobuf_unittest.TestAllTypes 1 4\n"
+            "protobuf_unittest.TestAllTypes 2 4\n"
+            "protobuf_unittest.TestAllTypes 3 4\n");
+}
+
+TEST_F(FieldAccessListenerTest, DisablingStopsCounting) {
+  Enable(1);
+  Listener::OnGet<0>(nullptr, nullptr);
+  SetFieldAccessSamplingPeriod(0);
+  for (int i = 0; i < 3 * (1 << 16); ++i) {
+    Listener::OnGet<0>(nullptr, nullptr);
+  }
+  EXPECT_THAT(GetFieldAccessProfile(),
+              ElementsAre(Frequency("protobuf_unittest.TestAllTypes", 1, 1u,
+                                    0u)));
+}
+
+}  // namespace
+}  // namespace protobuf
+}  // namespace google
@@ -39,6 +39,7 @@
 #include <cstdint>
 #include <cstring>
 #include <string>
+#include <vector>
 
 #include "absl/base/call_once.h"
 #include "absl/base/casts.h"
@@ -54,6 +55,7 @@
 #include "google/protobuf/descriptor.pb.h"
 #include "google/protobuf/descriptor_legacy.h"
 #include "google/protobuf/extension_set.h"
+#include "google/protobuf/generated_enum_util.h"
 #include "google/protobuf/generated_message_tctable_gen.h"
 #include "google/protobuf/generated_message_tctable_impl.h"
 #include "google/protobuf/generated_message_util.h"
@@ -62,6 +64,7 @@
 #include "google/protobuf/map_field_inl.h"
 #include "google/protobuf/raw_ptr.h"
 #include "google/protobuf/repeated_field.h"
+#include "google/protobuf/repeated_string_buffer.h"
 #include "google/protobuf/unknown_field_set.h"
 
 
@@ -407,6 +410,11 @@ size_t Reflection::SpaceUsedLong(const Message& message) const {
 #undef HANDLE_TYPE
 
         case FieldDescriptor::CPPTYPE_STRING:
+          if (schema_.IsRepeatedStringBuffer(field)) {
+            total_size += GetRaw<RepeatedStringBuffer>(message, field)
+                              .SpaceUsedExcludingSelfLong();
+            break;
+          }
           switch (field->options().ctype()) {
             default:  // TODO(kenton):  Support other string reps.
             case FieldOptions::STRING:
@@ -500,19 +508,7 @@ size_t Reflection::SpaceUsedLong(const Message& message) const {
       }
     }
   }
-#ifndef PROTOBUF_FUZZ_MESSAGE_SPACE_USED_LONG
-  return total_size;
-#else
-  // Use both `this` and `dummy` to generate the seed so that the scale factor
-  // is both per-object and non-predictable, but consistent across multiple
-  // calls in the same binary.
-  static bool dummy;
-  uintptr_t seed =
-      reinterpret_cast<uintptr_t>(&dummy) ^ reinterpret_cast<uintptr_t>(this);
-  // Fuzz the size by +/- 50%.
-  double scale = (static_cast<double>(seed % 10000) / 10000) + 0.5;
-  return total_size * scale;
-#endif
+  return internal::SpaceUsedLongResult(total_size, &message);
 }
 
 namespace {
@@ -629,6 +625,16 @@ template <bool unsafe_shallow_swap>
 void SwapFieldHelper::SwapRepeatedStringField(const Reflection* r, Message* lhs,
                                               Message* rhs,
                                               const FieldDescriptor* field) {
+  if (r->schema_.IsRepeatedStringBuffer(field)) {
+    auto* lhs_buffer = r->MutableRaw<RepeatedStringBuffer>(lhs, field);
+    auto* rhs_buffer = r->MutableRaw<RepeatedStringBuffer>(rhs, field);
+    if (unsafe_shallow_swap) {
+      lhs_buffer->InternalSwap(rhs_buffer);
+    } else {
+      lhs_buffer->Swap(rhs_buffer);
+    }
+    return;
+  }
   switch (field->options().ctype()) {
     default:
     case FieldOptions::STRING: {
@@ -1334,6 +1340,10 @@ int Reflection::FieldSize(const Message& message,
 #undef HANDLE_TYPE
 
       case FieldDescriptor::CPPTYPE_STRING:
+        if (schema_.IsRepeatedStringBuffer(field)) {
+          return GetRaw<RepeatedStringBuffer>(message, field).size();
+        }
+        return GetRaw<RepeatedPtrFieldBase>(message, field).size();
       case FieldDescriptor::CPPTYPE_MESSAGE:
         if (IsMapFieldInApi(field)) {
           const internal::MapFieldBase& map =
@@ -1449,6 +1459,10 @@ void Reflection::ClearField(Message* message,
 #undef HANDLE_TYPE
 
       case FieldDescriptor::CPPTYPE_STRING: {
+        if (schema_.IsRepeatedStringBuffer(field)) {
+          MutableRaw<RepeatedStringBuffer>(message, field)->Clear();
+          break;
+        }
         switch (field->options().ctype()) {
           default:  // TODO(kenton):  Support other string reps.
           case FieldOptions::STRING:
@@ -1499,6 +1513,10 @@ void Reflection::RemoveLast(Message* message,
 #undef HANDLE_TYPE
 
       case FieldDescriptor::CPPTYPE_STRING:
+        if (schema_.IsRepeatedStringBuffer(field)) {
+          MutableRaw<RepeatedStringBuffer>(message, field)->RemoveLast();
+          break;
+        }
         switch (field->options().ctype()) {
           default:  // TODO(kenton):  Support other string reps.
           case FieldOptions::STRING:
@@ -1593,6 +1611,14 @@ void Reflection::SwapElements(Message* message, const FieldDescriptor* field,
 #undef HANDLE_TYPE
 
       case FieldDescriptor::CPPTYPE_STRING:
+        if (schema_.IsRepeatedStringBuffer(field)) {
+          MutableRaw<RepeatedStringBuffer>(message, field)
+              ->SwapElements(index1, index2);
+        } else {
+          MutableRaw<RepeatedPtrFieldBase>(message, field)
+              ->SwapElements(index1, index2);
+        }
+        break;
       case FieldDescriptor::CPPTYPE_MESSAGE:
         if (IsMapFieldInApi(field)) {
           MutableRaw<MapFieldBase>(message, field)
@@ -1787,6 +1813,30 @@ DEFINE_PRIMITIVE_ACCESSORS(Double, double, double, DOUBLE)
 DEFINE_PRIMITIVE_ACCESSORS(Bool, bool, bool, BOOL)
 #undef DEFINE_PRIMITIVE_ACCESSORS
 
+internal::FieldAccessorLayout Reflection::ResolveFieldAccessor(
+    const FieldDescriptor* field, FieldDescriptor::CppType cpp_type) const {
+  USAGE_CHECK_MESSAGE_TYPE(GetFieldAccessor);
+  USAGE_CHECK_SINGULAR(GetFieldAccessor);
+  if (field->cpp_type() != cpp_type) {
+    ReportReflectionUsageTypeError(descriptor_, field, "GetFieldAccessor",
+                                   cpp_type);
+  }
+  internal::FieldAccessorLayout layout{false, 0, 0, static_cast<uint32_t>(-1)};
+  // Everything but plain fields goes through the Get/Set methods, which know
+  // about extension sets, oneof cases and the split struct.
+  if (field->is_extension() || schema_.InRealOneof(field) ||
+      schema_.IsSplit(field)) {
+    return layout;
+  }
+  layout.direct = true;
+  layout.offset = schema_.GetFieldOffsetNonOneof(field);
+  layout.has_bit_index = schema_.HasBitIndex(field);
+  if (layout.has_bit_index != static_cast<uint32_t>(-1)) {
+    layout.has_bits_offset = schema_.HasBitsOffset();
+  }
+  return layout;
+}
+
 // -------------------------------------------------------------------
 
 std::string Reflection::GetString(const Message& message,
@@ -1994,6 +2044,8 @@ std::string Reflection::GetRepeatedString(const Message& message,
   USAGE_CHECK_ALL(GetRepeatedString, REPEATED, STRING);
   if (field->is_extension()) {
     return GetExtensionSet(message).GetRepeatedString(field->number(), index);
+  } else if (schema_.IsRepeatedStringBuffer(field)) {
+    return std::string(GetRaw<RepeatedStringBuffer>(message, field).Get(index));
   } else {
     switch (field->options().ctype()) {
       default:  // TODO(kenton):  Support other string reps.
@@ -2006,10 +2058,15 @@ std::string Reflection::GetRepeatedString(const Message& message,
 const std::string& Reflection::GetRepeatedStringReference(
     const Message& message, const FieldDescriptor* field, int index,
     std::string* scratch) const {
-  (void)scratch;  // Parameter is used by Google-internal code.
   USAGE_CHECK_ALL(GetRepeatedStringReference, REPEATED, STRING);
   if (field->is_extension()) {
     return GetExtensionSet(message).GetRepeatedString(field->number(), index);
+  } else if (schema_.IsRepeatedStringBuffer(field)) {
+    // The elements are not std::string objects.
+    absl::string_view value =
+        GetRaw<RepeatedStringBuffer>(message, field).Get(index);
+    scratch->assign(value.data(), value.size());
+    return *scratch;
   } else {
     switch (field->options().ctype()) {
       default:  // TODO(kenton):  Support other string reps.
@@ -2027,6 +2084,8 @@ void Reflection::SetRepeatedString(Message* message,
   if (field->is_extension()) {
     MutableExtensionSet(message)->SetRepeatedString(field->number(), index,
                                                     std::move(value));
+  } else if (schema_.IsRepeatedStringBuffer(field)) {
+    MutableRaw<RepeatedStringBuffer>(message, field)->Set(index, value);
   } else {
     switch (field->options().ctype()) {
       default:  // TODO(kenton):  Support other string reps.
@@ -2045,6 +2104,8 @@ void Reflection::AddString(Message* message, const FieldDescriptor* field,
   if (field->is_extension()) {
     MutableExtensionSet(message)->AddString(field->number(), field->type(),
                                             std::move(value), field);
+  } else if (schema_.IsRepeatedStringBuffer(field)) {
+    MutableRaw<RepeatedStringBuffer>(message, field)->Add(value);
   } else {
     switch (field->options().ctype()) {
       default:  // TODO(kenton):  Support other string reps.
@@ -2338,13 +2399,17 @@ void Reflection::SetAllocatedMessage(Message* message, Message* sub_message,
                                      const FieldDescriptor* field) const {
   ABSL_DCHECK(
       sub_message == nullptr || sub_message->GetOwningArena() == nullptr ||
-      sub_message->GetOwningArena() == message->GetArenaForAllocation());
+      sub_message->GetOwningArena() == message->GetArenaForAllocation() ||
+      Arena::IsFused(sub_message->GetOwningArena(),
+                     message->GetArenaForAllocation()));
 
   // If message and sub-message are in different memory ownership domains
-  // (different arenas, or one is on heap and one is not), then we may need to
-  // do a copy.
+  // (different arenas that are not fused, or one is on heap and one is not),
+  // then we may need to do a copy.
   if (sub_message != nullptr &&
-      sub_message->GetOwningArena() != message->GetArenaForAllocation()) {
+      sub_message->GetOwningArena() != message->GetArenaForAllocation() &&
+      !Arena::IsFused(sub_message->GetOwningArena(),
+                      message->GetArenaForAllocation())) {
     if (sub_message->GetOwningArena() == nullptr &&
         message->GetArenaForAllocation() != nullptr) {
       // Case 1: parent is on an arena and child is heap-allocated. We can add
@@ -3066,6 +3131,8 @@ const void* Reflection::GetRawRepeatedString(const Message& message,
                                              const FieldDescriptor* field,
                                              bool is_string) const {
   (void)is_string;  // Parameter is used by Google-internal code.
+  ABSL_CHECK(!schema_.IsRepeatedStringBuffer(field))
+      << field->full_name() << " is not a RepeatedPtrField<std::string>.";
   return GetRawRepeatedField(message, field, FieldDescriptor::CPPTYPE_STRING,
                              FieldOptions::STRING, nullptr);
 }
@@ -3074,6 +3141,8 @@ void* Reflection::MutableRawRepeatedString(Message* message,
                                            const FieldDescriptor* field,
                                            bool is_string) const {
   (void)is_string;  // Parameter is used by Google-internal code.
+  ABSL_CHECK(!schema_.IsRepeatedStringBuffer(field))
+      << field->full_name() << " is not a RepeatedPtrField<std::string>.";
   return MutableRawRepeatedField(message, field,
                                  FieldDescriptor::CPPTYPE_STRING,
                                  FieldOptions::STRING, nullptr);
@@ -3217,6 +3286,18 @@ static uint32_t AlignTo(uint32_t v) {
   return (v + alignof(T) - 1) & ~(alignof(T) - 1);
 }
 
+static std::vector<uint32_t> GenerateEnumData(const EnumDescriptor* enum_type) {
+  // Multiple values may have the same number. Sort and dedup.
+  std::vector<int32_t> numbers;
+  numbers.reserve(static_cast<size_t>(enum_type->value_count()));
+  for (int i = 0; i < enum_type->value_count(); ++i) {
+    numbers.push_back(enum_type->value(i)->number());
+  }
+  std::sort(numbers.begin(), numbers.end());
+  numbers.erase(std::unique(numbers.begin(), numbers.end()), numbers.end());
+  return internal::GenerateEnumData(numbers);
+}
+
 static internal::TailCallParseFunc GetFastParseFunction(
     absl::string_view func_name) {
 #define PROTOBUF_TC_PARSE_FUNCTION_X(value) \
@@ -3295,26 +3376,18 @@ void Reflection::PopulateTcParseEntries(
   for (const auto& entry : table_info.field_entries) {
     const FieldDescriptor* field = entry.field;
     ABSL_CHECK(!field->options().weak());
-    if (field->type() == field->TYPE_ENUM &&
-        table_info.aux_entries[entry.aux_idx].type ==
-            internal::TailCallTableInfo::kEnumValidator) {
-      // Mini parse can't handle it. Fallback to reflection.
-      *entries = {};
-      table_info.aux_entries[entry.aux_idx] = {};
+    const OneofDescriptor* oneof = field->real_containing_oneof();
+    entries->offset = schema_.GetFieldOffset(field);
+    if (oneof != nullptr) {
+      entries->has_idx = schema_.oneof_case_offset_ + 4 * oneof->index();
+    } else if (schema_.HasHasbits()) {
+      entries->has_idx =
+          static_cast<int>(8 * schema_.HasBitsOffset() + entry.hasbit_idx);
     } else {
-      const OneofDescriptor* oneof = field->real_containing_oneof();
-      entries->offset = schema_.GetFieldOffset(field);
-      if (oneof != nullptr) {
-        entries->has_idx = schema_.oneof_case_offset_ + 4 * oneof->index();
-      } else if (schema_.HasHasbits()) {
-        entries->has_idx =
-            static_cast<int>(8 * schema_.HasBitsOffset() + entry.hasbit_idx);
-      } else {
-        entries->has_idx = 0;
-      }
-      entries->aux_idx = entry.aux_idx;
-      entries->type_card = entry.type_card;
+      entries->has_idx = 0;
     }
+    entries->aux_idx = entry.aux_idx;
+    entries->type_card = entry.type_card;
 
     ++entries;
   }
@@ -3322,6 +3395,7 @@ void Reflection::PopulateTcParseEntries(
 
 void Reflection::PopulateTcParseFieldAux(
     const internal::TailCallTableInfo& table_info,
+    const uint32_t* const* enum_data,
     TcParseTableBase::FieldAux* field_aux) const {
   for (const auto& aux_entry : table_info.aux_entries) {
     switch (aux_entry.type) {
@@ -3360,7 +3434,7 @@ void Reflection::PopulateTcParseFieldAux(
                                    aux_entry.enum_range.size};
         break;
       case internal::TailCallTableInfo::kEnumValidator:
-        ABSL_LOG(FATAL) << "Not supported.";
+        field_aux++->enum_data = *enum_data++;
         break;
       case internal::TailCallTableInfo::kNumericOffset:
         field_aux++->offset = aux_entry.offset;
@@ -3428,7 +3502,8 @@ const internal::TcParseTableBase* Reflection::CreateTcParseTable() const {
           // Might be easier to do when all messages support TDP.
           /* use_direct_tcparser_table */ false,
 
-          ref_.schema_.IsSplit(field),  //
+          ref_.schema_.IsSplit(field),                 //
+          ref_.schema_.IsRepeatedStringBuffer(field),  //
       };
     }
 
@@ -3456,10 +3531,24 @@ const internal::TcParseTableBase* Reflection::CreateTcParseTable() const {
       field_entry_offset +
       sizeof(TcParseTableBase::FieldEntry) * fields.size());
 
-  int byte_size =
+  // Closed enums that are not a small dense range are validated like
+  // generated code does, against the encoded values of the enum. The encoding
+  // is stored after the name data so that it is freed along with the table.
+  std::vector<std::vector<uint32_t>> enum_data;
+  for (const auto& aux_entry : table_info.aux_entries) {
+    if (aux_entry.type == internal::TailCallTableInfo::kEnumValidator) {
+      enum_data.push_back(GenerateEnumData(aux_entry.field->enum_type()));
+    }
+  }
+  const uint32_t enum_data_offset = AlignTo<uint32_t>(
       aux_offset +
       sizeof(TcParseTableBase::FieldAux) * table_info.aux_entries.size() +
-      sizeof(char) * table_info.field_name_data.size();
+      sizeof(char) * table_info.field_name_data.size());
+
+  int byte_size = enum_data_offset;
+  for (const auto& data : enum_data) {
+    byte_size += sizeof(uint32_t) * data.size();
+  }
 
   void* p = ::operator new(byte_size);
   auto* res = ::new (p) TcParseTableBase{
@@ -3476,7 +3565,9 @@ const internal::TcParseTableBase* Reflection::CreateTcParseTable() const {
       static_cast<uint16_t>(table_info.aux_entries.size()),
       aux_offset,
       schema_.default_instance_,
-      &internal::TcParser::ReflectionFallback};
+      &internal::TcParser::ReflectionFallback,
+      table_info.required_has_bits_word,
+      table_info.required_has_bits};
 
   // Now copy the rest of the payloads
   PopulateTcParseFastEntries(table_info, res->fast_entry(0));
@@ -3485,7 +3576,16 @@ const internal::TcParseTableBase* Reflection::CreateTcParseTable() const {
 
   PopulateTcParseEntries(table_info, res->field_entries_begin());
 
-  PopulateTcParseFieldAux(table_info, res->field_aux(0u));
+  std::vector<const uint32_t*> enum_data_ptrs;
+  auto* enum_data_dst = reinterpret_cast<uint32_t*>(
+      reinterpret_cast<char*>(res) + enum_data_offset);
+  for (const auto& data : enum_data) {
+    enum_data_ptrs.push_back(enum_data_dst);
+    enum_data_dst = std::copy(data.begin(), data.end(), enum_data_dst);
+  }
+
+  PopulateTcParseFieldAux(table_info, enum_data_ptrs.data(),
+                          res->field_aux(0u));
 
   // Copy the name data.
   if (!table_info.field_name_data.empty()) {
@@ -3493,7 +3593,10 @@ const internal::TcParseTableBase* Reflection::CreateTcParseTable() const {
            table_info.field_name_data.size());
   }
   // Validation to make sure we used all the bytes correctly.
-  ABSL_CHECK_EQ(res->name_data() + table_info.field_name_data.size() -
+  ABSL_CHECK_LE(res->name_data() + table_info.field_name_data.size() -
+                    reinterpret_cast<char*>(res),
+                enum_data_offset);
+  ABSL_CHECK_EQ(reinterpret_cast<char*>(enum_data_dst) -
                     reinterpret_cast<char*>(res),
                 byte_size);
 
@@ -3616,15 +3719,15 @@ struct MetadataOwner {
 
 void AddDescriptors(const DescriptorTable* table);
 
+// Serializes the calls to AddDescriptors() made after dynamic initialization.
+ABSL_CONST_INIT absl::Mutex add_descriptors_mutex(absl::kConstInit);
+
 void AssignDescriptorsImpl(const DescriptorTable* table, bool eager) {
   // Ensure the file descriptor is added to the pool.
   {
-    // This only happens once per proto file. So a global mutex to serialize
-    // calls to AddDescriptors.
-    static absl::Mutex mu{absl::kConstInit};
-    mu.Lock();
+    // This only happens once per proto file.
+    absl::MutexLock lock(&add_descriptors_mutex);
     AddDescriptors(table);
-    mu.Unlock();
   }
   if (eager) {
     // Normally we do not want to eagerly build descriptors of our deps.
@@ -3747,6 +3850,63 @@ AddDescriptorsRunner::AddDescriptorsRunner(const DescriptorTable* table) {
   AddDescriptors(table);
 }
 
+namespace {
+
+using DescriptorTableSectionBounds =
+    std::pair<const DescriptorTable* const*, const DescriptorTable* const*>;
+
+// Sections reported by AddDescriptorTableSection() before the first
+// RegisterSectionDescriptorTables() call.  Guarded by add_descriptors_mutex.
+std::vector<DescriptorTableSectionBounds>* pending_descriptor_table_sections =
+    nullptr;
+
+// Set, under add_descriptors_mutex, by the first
+// RegisterSectionDescriptorTables() call.  Sections reported afterwards (e.g.
+// by a shared library loaded with dlopen()) are registered right away.
+ABSL_CONST_INIT std::atomic<bool> descriptor_table_sections_registered{false};
+
+void AddSectionDescriptorTables(const DescriptorTable* const* begin,
+                                const DescriptorTable* const* end) {
+  for (const DescriptorTable* const* table = begin; table != end; ++table) {
+    AddDescriptors(*table);
+  }
+}
+
+}  // namespace
+
+void AddDescriptorTableSection(const DescriptorTable* const* begin,
+                               const DescriptorTable* const* end) {
+  if (begin == end) return;
+  absl::MutexLock lock(&add_descriptors_mutex);
+  if (descriptor_table_sections_registered.load(std::memory_order_relaxed)) {
+    AddSectionDescriptorTables(begin, end);
+    return;
+  }
+  if (pending_descriptor_table_sections == nullptr) {
+    pending_descriptor_table_sections =
+        new std::vector<DescriptorTableSectionBounds>;
+  }
+  pending_descriptor_table_sections->emplace_back(begin, end);
+}
+
+void RegisterSectionDescriptorTables() {
+  if (descriptor_table_sections_registered.load(std::memory_order_acquire)) {
+    return;
+  }
+  absl::MutexLock lock(&add_descriptors_mutex);
+  if (descriptor_table_sections_registered.load(std::memory_order_relaxed)) {
+    return;
+  }
+  if (pending_descriptor_table_sections != nullptr) {
+    for (const auto& section : *pending_descriptor_table_sections) {
+      AddSectionDescriptorTables(section.first, section.second);
+    }
+    delete pending_descriptor_table_sections;
+    pending_descriptor_table_sections = nullptr;
+  }
+  descriptor_table_sections_registered.store(true, std::memory_order_release);
+}
+
 void RegisterFileLevelMetadata(const DescriptorTable* table) {
   AssignDescriptors(table);
   RegisterAllTypesInternal(table->file_level_metadata, table->num_messages);
@@ -3763,6 +3923,14 @@ void UnknownFieldSetSerializer(const uint8_t* base, uint32_t offset,
   }
 }
 
+bool UnknownFieldsEquals(const UnknownFieldSet& a, const UnknownFieldSet& b) {
+  if (a.field_count() != b.field_count()) return false;
+  std::string a_bytes, b_bytes;
+  a.SerializeToString(&a_bytes);
+  b.SerializeToString(&b_bytes);
+  return a_bytes == b_bytes;
+}
+
 bool IsDescendant(Message& root, const Message& message) {
   const Reflection* reflection = root.GetReflection();
   std::vector<const FieldDescriptor*> fields;
@@ -83,6 +83,8 @@ constexpr uint32_t kInvalidFieldOffsetTag = 0x40000000u;
 constexpr uint32_t kSplitFieldOffsetMask = 0x80000000u;
 constexpr uint32_t kLazyMask = 0x1u;
 constexpr uint32_t kInlinedMask = 0x1u;
+// On a repeated string or bytes field: stored in a RepeatedStringBuffer.
+constexpr uint32_t kStringBufferMask = 0x1u;
 
 // This struct describes the internal layout of the message, hence this is
 // used to act on the message reflectively.
@@ -156,7 +158,14 @@ struct ReflectionSchema {
   }
 
   bool IsFieldInlined(const FieldDescriptor* field) const {
-    return Inlined(offsets_[field->index()], field->type());
+    return !field->is_repeated() &&
+           Inlined(offsets_[field->index()], field->type());
+  }
+
+  bool IsRepeatedStringBuffer(const FieldDescriptor* field) const {
+    return field->is_repeated() &&
+           field->cpp_type() == FieldDescriptor::CPPTYPE_STRING &&
+           (offsets_[field->index()] & kStringBufferMask) != 0;
   }
 
   uint32_t GetOneofCaseOffset(const OneofDescriptor* oneof_descriptor) const {
@@ -354,12 +363,56 @@ PROTOBUF_EXPORT void UnknownFieldSetSerializer(const uint8_t* base,
                                                uint32_t has_offset,
                                                io::CodedOutputStream* output);
 
+// Compares unknown fields in wire format for the generated Equals(), so
+// fields are expected in the same order.
+PROTOBUF_EXPORT bool UnknownFieldsEquals(const UnknownFieldSet& a,
+                                         const UnknownFieldSet& b);
+
 PROTOBUF_EXPORT void InitializeFileDescriptorDefaultInstances();
 
 struct PROTOBUF_EXPORT AddDescriptorsRunner {
   explicit AddDescriptorsRunner(const DescriptorTable* table);
 };
 
+// Registers the files whose generated code was compiled with
+// PROTOBUF_LAZY_GENERATED_FILE_REGISTRATION, which leaves their descriptor
+// tables in a linker section instead of running AddDescriptorsRunner at
+// dynamic initialization time.  Called on every access to the generated pool
+// or database; only the first call does any work.
+PROTOBUF_EXPORT void RegisterSectionDescriptorTables();
+
+// Reports the descriptor table section [begin, end) of one binary or shared
+// object.  The tables are registered by the first
+// RegisterSectionDescriptorTables() call, or right away if it already ran.
+PROTOBUF_EXPORT void AddDescriptorTableSection(
+    const DescriptorTable* const* begin, const DescriptorTable* const* end);
+
+#if defined(PROTOBUF_DESCRIPTOR_TABLE_SECTION_ATTRIBUTE)
+extern "C" {
+// Bounds of the descriptor table section, defined by the linker in every
+// binary or shared object that has one.  Hidden, so each module sees its own.
+extern const DescriptorTable* const __start_protobuf_descriptor_tables[]
+    __attribute__((weak, visibility("hidden")));
+extern const DescriptorTable* const __stop_protobuf_descriptor_tables[]
+    __attribute__((weak, visibility("hidden")));
+}  // extern "C"
+
+// Every generated file that puts its table in the section refers to
+// `registered`.  The copies within a module fold into one and, being hidden,
+// are not shared with other modules, so each binary or shared object reports
+// its own section exactly once from a single dynamic initializer.
+template <typename = void>
+struct __attribute__((visibility("hidden"))) DescriptorTableSection {
+  static const bool registered;
+};
+
+template <typename T>
+const bool DescriptorTableSection<T>::registered =
+    (AddDescriptorTableSection(__start_protobuf_descriptor_tables,
+                               __stop_protobuf_descriptor_tables),
+     true);
+#endif  // PROTOBUF_DESCRIPTOR_TABLE_SECTION_ATTRIBUTE
+
 struct DenseEnumCacheInfo {
   std::atomic<const std::string**> cache;
   int min_val;
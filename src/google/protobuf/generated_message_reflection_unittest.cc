@@ -53,6 +53,8 @@
 #include "absl/strings/cord.h"
 #include "google/protobuf/arena.h"
 #include "google/protobuf/descriptor.h"
+#include "google/protobuf/generated_message_tctable_impl.h"
+#include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/map_test_util.h"
 #include "google/protobuf/map_unittest.pb.h"
 #include "google/protobuf/test_util.h"
@@ -60,6 +62,7 @@
 #include "google/protobuf/unittest.pb.h"
 #include "google/protobuf/unittest_mset.pb.h"
 #include "google/protobuf/unittest_mset_wire_format.pb.h"
+#include "google/protobuf/unittest_proto3.pb.h"
 
 // Must be included last.
 #include "google/protobuf/port_def.inc"
@@ -88,6 +91,10 @@ class GeneratedMessageReflectionTestHelper {
                                         const FieldDescriptor* field) {
     return msg.GetReflection()->IsLazilyVerifiedLazyField(field);
   }
+  static const internal::TcParseTableBase* GetTcParseTable(
+      const Message& msg) {
+    return msg.GetReflection()->GetTcParseTable();
+  }
 };
 
 namespace {
@@ -142,6 +149,57 @@ TEST(GeneratedMessageReflectionTest, Accessors) {
   TestUtil::ExpectRepeatedFieldsModified(message);
 }
 
+TEST(GeneratedMessageReflectionTest, GeneratedSpaceUsedMatchesReflection) {
+  // Generated messages override SpaceUsedLong(); it must agree with the
+  // reflection implementation it replaces.
+  unittest::TestAllTypes message;
+  const Reflection* reflection = message.GetReflection();
+  EXPECT_EQ(message.SpaceUsedLong(), reflection->SpaceUsedLong(message));
+  TestUtil::SetAllFields(&message);
+  message.mutable_unknown_fields()->AddLengthDelimited(1000, "unknown");
+  EXPECT_EQ(message.SpaceUsedLong(), reflection->SpaceUsedLong(message));
+  message.set_oneof_string("a string that does not fit the SSO buffer");
+  EXPECT_EQ(message.SpaceUsedLong(), reflection->SpaceUsedLong(message));
+  message.mutable_oneof_nested_message()->set_bb(1);
+  EXPECT_EQ(message.SpaceUsedLong(), reflection->SpaceUsedLong(message));
+
+  unittest::TestAllExtensions extensions;
+  TestUtil::SetAllExtensions(&extensions);
+  EXPECT_EQ(extensions.SpaceUsedLong(),
+            extensions.GetReflection()->SpaceUsedLong(extensions));
+
+  unittest::TestMap map;
+  MapTestUtil::SetMapFields(&map);
+  EXPECT_EQ(map.SpaceUsedLong(), map.GetReflection()->SpaceUsedLong(map));
+}
+
+TEST(GeneratedMessageReflectionTest, GeneratedSpaceUsedOneof) {
+  for (bool use_arena : {false, true}) {
+    Arena arena;
+    auto* message =
+        Arena::CreateMessage<unittest::TestAllTypes>(use_arena ? &arena
+                                                               : nullptr);
+    const Reflection* reflection = message->GetReflection();
+    const size_t empty_size = message->SpaceUsedLong();
+
+    message->set_oneof_string(std::string(1000, 'x'));
+    const size_t long_string_size = message->SpaceUsedLong();
+    EXPECT_GE(long_string_size, empty_size + 1000);
+    EXPECT_EQ(long_string_size, reflection->SpaceUsedLong(*message));
+
+    // Switching to another string member counts that member only.
+    message->set_oneof_bytes("short");
+    EXPECT_LT(message->SpaceUsedLong(), long_string_size);
+    EXPECT_EQ(message->SpaceUsedLong(), reflection->SpaceUsedLong(*message));
+
+    message->set_oneof_uint32(1);
+    EXPECT_EQ(message->SpaceUsedLong(), empty_size);
+    EXPECT_EQ(message->SpaceUsedLong(), reflection->SpaceUsedLong(*message));
+
+    if (!use_arena) delete message;
+  }
+}
+
 TEST(GeneratedMessageReflectionTest, GetStringReference) {
   // Test that GetStringReference() returns the underlying string when it
   // is a normal string field.
@@ -1295,8 +1353,133 @@ TEST(GeneratedMessageReflectionTest, ArenaReleaseOneofMessageTest) {
   EXPECT_TRUE(released == nullptr);
 }
 
+// Serializes `message` with TcParser::SerializeWithTable, driven by the
+// table reflection builds for it.
+std::string SerializeWithTable(const Message& message) {
+  const internal::TcParseTableBase* table =
+      GeneratedMessageReflectionTestHelper::GetTcParseTable(message);
+  size_t size = internal::TcParser::ByteSizeWithTable(message, table);
+  EXPECT_EQ(size, message.GetCachedSize());
+  std::string result(size, '\0');
+  uint8_t* target = reinterpret_cast<uint8_t*>(&result[0]);
+  io::EpsCopyOutputStream stream(target, static_cast<int>(size),
+                                 /*deterministic=*/false);
+  uint8_t* end =
+      internal::TcParser::SerializeWithTable(message, table, target, &stream);
+  EXPECT_EQ(end - target, size);
+  return result;
+}
+
+TEST(GeneratedMessageReflectionTest, SerializeWithTableMatchesGenerated) {
+  unittest::TestAllTypes all_types;
+  TestUtil::SetAllFields(&all_types);
+  unittest::TestAllExtensions all_extensions;
+  TestUtil::SetAllExtensions(&all_extensions);
+  unittest::TestPackedTypes packed;
+  TestUtil::SetPackedFields(&packed);
+  unittest::TestOneof2 oneof;
+  TestUtil::SetOneof1(&oneof);
+  unittest::TestAllTypes unknown;
+  unknown.mutable_unknown_fields()->AddVarint(123456, 7);
+
+  for (const Message* message : std::vector<const Message*>{
+           &all_types, &all_extensions, &packed, &oneof, &unknown}) {
+    SCOPED_TRACE(message->GetTypeName());
+    EXPECT_EQ(SerializeWithTable(*message), message->SerializeAsString());
+  }
+}
+
+TEST(GeneratedMessageReflectionTest, SerializeWithTableMapFields) {
+  unittest::TestMap message;
+  MapTestUtil::SetMapFields(&message);
+
+  // Map iteration order is unspecified, so compare after a round trip.
+  unittest::TestMap parsed;
+  ASSERT_TRUE(parsed.ParseFromString(SerializeWithTable(message)));
+  MapTestUtil::ExpectMapFieldsSet(parsed);
+}
+
+TEST(GeneratedMessageReflectionTest, FieldAccessor) {
+  unittest::TestAllTypes message;
+  const Reflection* reflection = message.GetReflection();
+  const Descriptor* descriptor = message.GetDescriptor();
+
+  FieldAccessor<int32_t> int32 = reflection->GetFieldAccessor<int32_t>(
+      descriptor->FindFieldByName("optional_int32"));
+  EXPECT_FALSE(int32.Has(message));
+  EXPECT_EQ(int32.Get(message), 0);
+  int32.Set(&message, 101);
+  EXPECT_TRUE(int32.Has(message));
+  EXPECT_TRUE(message.has_optional_int32());
+  EXPECT_EQ(message.optional_int32(), 101);
+  message.clear_optional_int32();
+  EXPECT_FALSE(int32.Has(message));
+
+  // Unset fields read as their default.
+  FieldAccessor<double> default_double = reflection->GetFieldAccessor<double>(
+      descriptor->FindFieldByName("default_double"));
+  EXPECT_EQ(default_double.Get(message), 52e3);
+  default_double.Set(&message, 1.5);
+  EXPECT_EQ(message.default_double(), 1.5);
+
+  FieldAccessor<bool> boolean = reflection->GetFieldAccessor<bool>(
+      descriptor->FindFieldByName("optional_bool"));
+  message.set_optional_bool(true);
+  EXPECT_TRUE(boolean.Has(message));
+  EXPECT_TRUE(boolean.Get(message));
+
+  // Oneof members go through Reflection, which maintains the oneof case.
+  FieldAccessor<uint32_t> oneof = reflection->GetFieldAccessor<uint32_t>(
+      descriptor->FindFieldByName("oneof_uint32"));
+  message.set_oneof_string("foo");
+  EXPECT_FALSE(oneof.Has(message));
+  EXPECT_EQ(oneof.Get(message), 0);
+  oneof.Set(&message, 7);
+  EXPECT_TRUE(message.has_oneof_uint32());
+  EXPECT_FALSE(message.has_oneof_string());
+  EXPECT_EQ(oneof.Get(message), 7);
+
+  // So do extensions.
+  unittest::TestAllExtensions extensions;
+  FieldAccessor<int64_t> extension =
+      extensions.GetReflection()->GetFieldAccessor<int64_t>(
+          descriptor->file()->FindExtensionByName("optional_int64_extension"));
+  EXPECT_FALSE(extension.Has(extensions));
+  extension.Set(&extensions, -5);
+  EXPECT_EQ(extensions.GetExtension(unittest::optional_int64_extension), -5);
+  EXPECT_EQ(extension.Get(extensions), -5);
+}
+
+TEST(GeneratedMessageReflectionTest, FieldAccessorImplicitPresence) {
+  proto3_unittest::TestAllTypes message;
+  FieldAccessor<float> field =
+      message.GetReflection()->GetFieldAccessor<float>(
+          message.GetDescriptor()->FindFieldByName("optional_float"));
+  EXPECT_FALSE(field.Has(message));
+  field.Set(&message, -0.0f);
+  // Like HasField(), -0.0 is present since its bits are not all zero.
+  EXPECT_TRUE(field.Has(message));
+  EXPECT_TRUE(message.GetReflection()->HasField(message, field.field()));
+  field.Set(&message, 0.0f);
+  EXPECT_FALSE(field.Has(message));
+  field.Set(&message, 2.5f);
+  EXPECT_EQ(message.optional_float(), 2.5f);
+}
+
 #if GTEST_HAS_DEATH_TEST
 
+TEST(GeneratedMessageReflectionTest, FieldAccessorUsageErrors) {
+  unittest::TestAllTypes message;
+  const Reflection* reflection = message.GetReflection();
+  const Descriptor* descriptor = message.GetDescriptor();
+  EXPECT_DEATH(reflection->GetFieldAccessor<int32_t>(
+                   descriptor->FindFieldByName("optional_int64")),
+               "Field is not the right type");
+  EXPECT_DEATH(reflection->GetFieldAccessor<int32_t>(
+                   descriptor->FindFieldByName("repeated_int32")),
+               "Field is repeated");
+}
+
 TEST(GeneratedMessageReflectionTest, UsageErrors) {
   unittest::TestAllTypes message;
   unittest::ForeignMessage foreign;
@@ -294,6 +294,12 @@ struct alignas(uint64_t) TcParseTableBase {
   uint16_t extension_offset;
   uint32_t max_field_number;
   uint8_t fast_idx_mask;
+  // The has-bits word holding all the required fields' has-bits, or
+  // kRequiredFieldsUnknown if they are not in a single word or the table does
+  // not say.  Together with `required_has_bits` this lets ParseLoop check
+  // required fields as each message ends, so that a parse which started from
+  // a cleared message does not need a separate IsInitialized() walk.
+  uint8_t required_has_bits_word;
   uint16_t lookup_table_offset;
   uint32_t skipmap32;
   uint32_t field_entries_offset;
@@ -301,6 +307,8 @@ struct alignas(uint64_t) TcParseTableBase {
 
   uint16_t num_aux_entries;
   uint32_t aux_offset;
+  // Mask of the required fields' has-bits in `required_has_bits_word`.
+  uint32_t required_has_bits;
 
   const MessageLite* default_instance;
 
@@ -318,20 +326,39 @@ struct alignas(uint64_t) TcParseTableBase {
       uint16_t lookup_table_offset, uint32_t skipmap32,
       uint32_t field_entries_offset, uint16_t num_field_entries,
       uint16_t num_aux_entries, uint32_t aux_offset,
-      const MessageLite* default_instance, TailCallParseFunc fallback)
+      const MessageLite* default_instance, TailCallParseFunc fallback,
+      uint8_t required_has_bits_word, uint32_t required_has_bits)
       : has_bits_offset(has_bits_offset),
         extension_offset(extension_offset),
         max_field_number(max_field_number),
         fast_idx_mask(fast_idx_mask),
+        required_has_bits_word(required_has_bits_word),
         lookup_table_offset(lookup_table_offset),
         skipmap32(skipmap32),
         field_entries_offset(field_entries_offset),
         num_field_entries(num_field_entries),
         num_aux_entries(num_aux_entries),
         aux_offset(aux_offset),
+        required_has_bits(required_has_bits),
         default_instance(default_instance),
         fallback(fallback) {}
 
+  // Tables generated before the required field masks existed.
+  constexpr TcParseTableBase(
+      uint16_t has_bits_offset, uint16_t extension_offset,
+      uint32_t max_field_number, uint8_t fast_idx_mask,
+      uint16_t lookup_table_offset, uint32_t skipmap32,
+      uint32_t field_entries_offset, uint16_t num_field_entries,
+      uint16_t num_aux_entries, uint32_t aux_offset,
+      const MessageLite* default_instance, TailCallParseFunc fallback)
+      : TcParseTableBase(has_bits_offset, extension_offset, max_field_number,
+                         fast_idx_mask, lookup_table_offset, skipmap32,
+                         field_entries_offset, num_field_entries,
+                         num_aux_entries, aux_offset, default_instance,
+                         fallback, kRequiredFieldsUnknown, 0) {}
+
+  static constexpr uint8_t kRequiredFieldsUnknown = 0xFF;
+
   // Table entry for fast-path tailcall dispatch handling.
   struct FastFieldEntry {
     // Target function for dispatch:
@@ -28,15 +28,32 @@
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#include <cstddef>
 #include <cstdint>
+#include <limits>
+#include <string>
+#include <type_traits>
 
+#include "absl/numeric/bits.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/arenastring.h"
+#include "google/protobuf/descriptor.h"
 #include "google/protobuf/extension_set.h"
+#include "google/protobuf/generated_message_tctable_decl.h"
 #include "google/protobuf/generated_message_tctable_impl.h"
+#include "google/protobuf/inlined_string_field.h"
+#include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/message.h"
+#include "google/protobuf/message_lite.h"
 #include "google/protobuf/parse_context.h"
 #include "google/protobuf/port.h"
+#include "google/protobuf/repeated_field.h"
+#include "google/protobuf/repeated_ptr_field.h"
+#include "google/protobuf/repeated_string_buffer.h"
 #include "google/protobuf/unknown_field_set.h"
 #include "google/protobuf/wire_format.h"
+#include "google/protobuf/wire_format_lite.h"
+#include "utf8_validity.h"
 
 // must be last
 #include "google/protobuf/port_def.inc"
@@ -76,6 +93,9 @@ const char* TcParser::ReflectionFallback(PROTOBUF_TC_PARAM_DECL) {
       field = ctx->data().pool->FindExtensionByNumber(descriptor, field_number);
     }
   }
+  if (field == nullptr && ctx->discard_unknown_fields()) {
+    return SkipUnknownField(tag, ptr, ctx);
+  }
 
   return WireFormat::_InternalParseAndMergeField(full_msg, ptr, ctx, tag,
                                                  reflection, field);
@@ -89,6 +109,516 @@ const char* TcParser::ReflectionParseLoop(PROTOBUF_TC_PARAM_DECL) {
   return WireFormat::_InternalParse(DownCast<Message*>(msg), ptr, ctx);
 }
 
+namespace {
+
+using FieldEntry = TcParseTableBase::FieldEntry;
+namespace fl = field_layout;
+
+// Calls `f(field_number, entry)` for every field entry of `table`, in field
+// number order.  This walks the same lookup data that FindFieldEntry()
+// searches: `skipmap32` covers field numbers 1-32, and the lookup table holds
+// blocks of 16-field skipmaps, terminated by a block starting at 0xFFFFFFFF.
+template <typename F>
+void ForEachFieldEntry(const TcParseTableBase* table, F f) {
+  const FieldEntry* const field_entries = table->field_entries_begin();
+  const FieldEntry* entry = field_entries;
+  for (uint32_t present = ~table->skipmap32; present != 0;
+       present &= present - 1) {
+    f(static_cast<uint32_t>(absl::countr_zero(present)) + 1, *entry++);
+  }
+  const uint16_t* lookup_table = table->field_lookup_begin();
+  for (;;) {
+    uint32_t fstart = lookup_table[0] | (uint32_t{lookup_table[1]} << 16);
+    if (fstart == 0xFFFFFFFF) return;
+    uint32_t num_skip_entries = lookup_table[2];
+    lookup_table += 3;
+    for (uint32_t i = 0; i < num_skip_entries; ++i, lookup_table += 2) {
+      entry = field_entries + lookup_table[1];
+      for (uint32_t present = ~uint32_t{lookup_table[0]} & 0xFFFF;
+           present != 0; present &= present - 1) {
+        f(fstart + 16 * i + static_cast<uint32_t>(absl::countr_zero(present)),
+          *entry++);
+      }
+    }
+  }
+}
+
+template <typename T>
+const T& FieldAt(const void* base, uint32_t offset) {
+  return *reinterpret_cast<const T*>(static_cast<const char*>(base) + offset);
+}
+
+// Split fields are stored behind the split pointer rather than in the message.
+const void* FieldBase(const MessageLite& msg, const TcParseTableBase* table,
+                      const FieldEntry& entry) {
+  if ((entry.type_card & fl::kSplitMask) == 0) return &msg;
+  return FieldAt<const void*>(&msg,
+                              table->field_aux(kSplitOffsetAuxIdx)->offset);
+}
+
+bool IsRepeated(const FieldEntry& entry) {
+  return (entry.type_card & fl::kFcMask) == fl::kFcRepeated;
+}
+
+bool HasImplicitPresence(const FieldEntry& entry) {
+  return (entry.type_card & fl::kFcMask) == fl::kFcSingular;
+}
+
+// Returns false if a non-repeated field is known to be absent.  Fields with
+// implicit presence additionally have to be checked against their default.
+bool MaybePresent(const MessageLite& msg, uint32_t field_number,
+                  const FieldEntry& entry) {
+  switch (entry.type_card & fl::kFcMask) {
+    case fl::kFcOptional: {
+      uint32_t has_idx = static_cast<uint32_t>(entry.has_idx);
+      return (FieldAt<uint32_t>(&msg, has_idx / 32 * 4) >> (has_idx % 32)) & 1;
+    }
+    case fl::kFcOneof:
+      return FieldAt<uint32_t>(&msg, static_cast<uint32_t>(entry.has_idx)) ==
+             field_number;
+    default:
+      return true;
+  }
+}
+
+// The field entries only describe the layout of fields the parser handles
+// through the mini table; anything else is sized and written by reflection.
+bool NeedsReflection(uint16_t type_card) {
+  switch (type_card & fl::kFkMask) {
+    case fl::kFkNone:
+    case fl::kFkMap:
+      return true;
+    case fl::kFkString: {
+      uint16_t rep = type_card & fl::kRepMask;
+      return rep == fl::kRepCord || rep == fl::kRepSPiece;
+    }
+    case fl::kFkMessage:
+      return (type_card & fl::kRepMask) == fl::kRepLazy;
+    default:
+      return false;
+  }
+}
+
+const FieldDescriptor* FindField(const Message& msg, uint32_t field_number) {
+  return msg.GetDescriptor()->FindFieldByNumber(
+      static_cast<int>(field_number));
+}
+
+// Like FindField(), but returns null for an absent singular field: the
+// WireFormat field helpers assume singular fields are present.
+const FieldDescriptor* FindPresentField(const Message& msg,
+                                        uint32_t field_number) {
+  const FieldDescriptor* field = FindField(msg, field_number);
+  if (!field->is_repeated() && !msg.GetReflection()->HasField(msg, field)) {
+    return nullptr;
+  }
+  return field;
+}
+
+bool IsZigZag(uint16_t type_card) {
+  return (type_card & fl::kTvMask) == fl::kTvZigZag;
+}
+
+// Calls `f` with a null pointer to the type a varint field is stored as.
+// Signed and enum fields are visited as signed so that negative values are
+// sign-extended to 64 bits on the wire.
+template <typename F>
+auto VisitVarintType(uint16_t type_card, F f) -> decltype(f(
+    static_cast<bool*>(nullptr))) {
+  uint16_t format = type_card & fl::kFmtMask;
+  bool is_signed = format == fl::kFmtSigned || format == fl::kFmtEnum;
+  switch (type_card & fl::kRepMask) {
+    case fl::kRep8Bits:
+      return f(static_cast<bool*>(nullptr));
+    case fl::kRep32Bits:
+      return is_signed ? f(static_cast<int32_t*>(nullptr))
+                       : f(static_cast<uint32_t*>(nullptr));
+    default:
+      return is_signed ? f(static_cast<int64_t*>(nullptr))
+                       : f(static_cast<uint64_t*>(nullptr));
+  }
+}
+
+uint64_t EncodeVarint(bool value, bool) { return value; }
+uint64_t EncodeVarint(uint32_t value, bool) { return value; }
+uint64_t EncodeVarint(uint64_t value, bool) { return value; }
+uint64_t EncodeVarint(int32_t value, bool zigzag) {
+  return zigzag ? WireFormatLite::ZigZagEncode32(value)
+                : static_cast<uint64_t>(int64_t{value});
+}
+uint64_t EncodeVarint(int64_t value, bool zigzag) {
+  return zigzag ? WireFormatLite::ZigZagEncode64(value)
+                : static_cast<uint64_t>(value);
+}
+
+template <typename T>
+size_t VarintDataSize(const RepeatedField<T>& field, bool zigzag) {
+  size_t size = 0;
+  for (T value : field) {
+    size += io::CodedOutputStream::VarintSize64(EncodeVarint(value, zigzag));
+  }
+  return size;
+}
+
+size_t TagSize(uint32_t field_number) {
+  return io::CodedOutputStream::VarintSize32(field_number << 3);
+}
+
+const std::string& GetString(const void* base, const FieldEntry& entry) {
+  if ((entry.type_card & fl::kRepMask) == fl::kRepIString) {
+    return FieldAt<InlinedStringField>(base, entry.offset).Get();
+  }
+  return FieldAt<ArenaStringPtr>(base, entry.offset).Get();
+}
+
+void VerifyUtf8(const Message& msg, uint32_t field_number, uint16_t type_card,
+                absl::string_view value) {
+  uint16_t validation = type_card & fl::kTvMask;
+  if (validation != fl::kTvUtf8 && validation != fl::kTvUtf8Debug) return;
+  if (PROTOBUF_PREDICT_TRUE(utf8_range::IsStructurallyValid(value))) return;
+  const std::string& name = FindField(msg, field_number)->full_name();
+  if (validation == fl::kTvUtf8) {
+    WireFormatLite::VerifyUtf8String(value.data(),
+                                     static_cast<int>(value.size()),
+                                     WireFormatLite::SERIALIZE, name.c_str());
+  } else {
+    WireFormat::VerifyUTF8StringNamedField(value.data(),
+                                           static_cast<int>(value.size()),
+                                           WireFormat::SERIALIZE, name.c_str());
+  }
+}
+
+uint8_t* WriteMessage(uint32_t field_number, uint16_t type_card,
+                      const MessageLite& value, uint8_t* target,
+                      io::EpsCopyOutputStream* stream) {
+  if ((type_card & fl::kRepMask) == fl::kRepGroup) {
+    return WireFormatLite::InternalWriteGroup(field_number, value, target,
+                                              stream);
+  }
+  return WireFormatLite::InternalWriteMessage(
+      field_number, value, value.GetCachedSize(), target, stream);
+}
+
+size_t MessageByteSize(uint32_t field_number, uint16_t type_card,
+                       const MessageLite& value) {
+  if ((type_card & fl::kRepMask) == fl::kRepGroup) {
+    return 2 * TagSize(field_number) + value.ByteSizeLong();
+  }
+  return TagSize(field_number) +
+         WireFormatLite::LengthDelimitedSize(value.ByteSizeLong());
+}
+
+uint8_t* SerializeField(const Message& msg, const TcParseTableBase* table,
+                        uint32_t field_number, const FieldEntry& entry,
+                        uint8_t* target, io::EpsCopyOutputStream* stream) {
+  const uint16_t type_card = entry.type_card;
+  if (NeedsReflection(type_card)) {
+    const FieldDescriptor* field = FindPresentField(msg, field_number);
+    if (field == nullptr) return target;
+    return WireFormat::InternalSerializeField(field, msg, target, stream);
+  }
+  const bool repeated = IsRepeated(entry);
+  if (!repeated && !MaybePresent(msg, field_number, entry)) return target;
+  const void* base = FieldBase(msg, table, entry);
+
+  switch (type_card & fl::kFkMask) {
+    case fl::kFkVarint:
+      return VisitVarintType(type_card, [&](auto* type) {
+        using T = std::remove_pointer_t<decltype(type)>;
+        const bool zigzag = IsZigZag(type_card);
+        if (repeated) {
+          for (T value : FieldAt<RepeatedField<T>>(base, entry.offset)) {
+            target = stream->EnsureSpace(target);
+            target = WireFormatLite::WriteUInt64ToArray(
+                field_number, EncodeVarint(value, zigzag), target);
+          }
+          return target;
+        }
+        T value = FieldAt<T>(base, entry.offset);
+        if (HasImplicitPresence(entry) && value == 0) return target;
+        target = stream->EnsureSpace(target);
+        return WireFormatLite::WriteUInt64ToArray(
+            field_number, EncodeVarint(value, zigzag), target);
+      });
+
+    case fl::kFkPackedVarint:
+      return VisitVarintType(type_card, [&](auto* type) {
+        using T = std::remove_pointer_t<decltype(type)>;
+        const bool zigzag = IsZigZag(type_card);
+        const auto& field = FieldAt<RepeatedField<T>>(base, entry.offset);
+        if (field.empty()) return target;
+        target = stream->EnsureSpace(target);
+        target = WireFormatLite::WriteTagToArray(
+            field_number, WireFormatLite::WIRETYPE_LENGTH_DELIMITED, target);
+        target = io::CodedOutputStream::WriteVarint32ToArray(
+            static_cast<uint32_t>(VarintDataSize(field, zigzag)), target);
+        for (T value : field) {
+          target = stream->EnsureSpace(target);
+          target = io::CodedOutputStream::WriteVarint64ToArray(
+              EncodeVarint(value, zigzag), target);
+        }
+        return target;
+      });
+
+    case fl::kFkFixed:
+      if ((type_card & fl::kRepMask) == fl::kRep64Bits) {
+        if (repeated) {
+          for (uint64_t value :
+               FieldAt<RepeatedField<uint64_t>>(base, entry.offset)) {
+            target = stream->EnsureSpace(target);
+            target = WireFormatLite::WriteFixed64ToArray(field_number, value,
+                                                         target);
+          }
+          return target;
+        }
+        uint64_t value = FieldAt<uint64_t>(base, entry.offset);
+        if (HasImplicitPresence(entry) && value == 0) return target;
+        target = stream->EnsureSpace(target);
+        return WireFormatLite::WriteFixed64ToArray(field_number, value, target);
+      } else {
+        if (repeated) {
+          for (uint32_t value :
+               FieldAt<RepeatedField<uint32_t>>(base, entry.offset)) {
+            target = stream->EnsureSpace(target);
+            target = WireFormatLite::WriteFixed32ToArray(field_number, value,
+                                                         target);
+          }
+          return target;
+        }
+        uint32_t value = FieldAt<uint32_t>(base, entry.offset);
+        if (HasImplicitPresence(entry) && value == 0) return target;
+        target = stream->EnsureSpace(target);
+        return WireFormatLite::WriteFixed32ToArray(field_number, value, target);
+      }
+
+    case fl::kFkPackedFixed:
+      if ((type_card & fl::kRepMask) == fl::kRep64Bits) {
+        const auto& field =
+            FieldAt<RepeatedField<uint64_t>>(base, entry.offset);
+        if (field.empty()) return target;
+        return stream->WriteFixedPacked(field_number, field, target);
+      } else {
+        const auto& field =
+            FieldAt<RepeatedField<uint32_t>>(base, entry.offset);
+        if (field.empty()) return target;
+        return stream->WriteFixedPacked(field_number, field, target);
+      }
+
+    case fl::kFkString:
+      if (repeated) {
+        if ((type_card & fl::kRepMask) == fl::kRepSBuffer) {
+          for (absl::string_view value :
+               FieldAt<RepeatedStringBuffer>(base, entry.offset)) {
+            VerifyUtf8(msg, field_number, type_card, value);
+            target = stream->WriteString(field_number, value, target);
+          }
+          return target;
+        }
+        for (const std::string& value :
+             FieldAt<RepeatedPtrField<std::string>>(base, entry.offset)) {
+          VerifyUtf8(msg, field_number, type_card, value);
+          target = stream->WriteString(field_number, value, target);
+        }
+        return target;
+      } else {
+        const std::string& value = GetString(base, entry);
+        if (HasImplicitPresence(entry) && value.empty()) return target;
+        if ((entry.type_card & fl::kRepMask) != fl::kRepAString ||
+            !FieldAt<ArenaStringPtr>(base, entry.offset).IsUtf8Validated()) {
+          VerifyUtf8(msg, field_number, type_card, value);
+        }
+        return stream->WriteStringMaybeAliased(field_number, value, target);
+      }
+
+    case fl::kFkMessage:
+      if (repeated) {
+        for (const MessageLite& value :
+             FieldAt<RepeatedPtrField<MessageLite>>(base, entry.offset)) {
+          target = WriteMessage(field_number, type_card, value, target, stream);
+        }
+        return target;
+      } else {
+        const MessageLite* value =
+            FieldAt<const MessageLite*>(base, entry.offset);
+        if (value == nullptr) return target;
+        return WriteMessage(field_number, type_card, *value, target, stream);
+      }
+
+    default:
+      PROTOBUF_ASSUME(false);
+  }
+  return target;
+}
+
+size_t FieldByteSize(const Message& msg, const TcParseTableBase* table,
+                     uint32_t field_number, const FieldEntry& entry) {
+  const uint16_t type_card = entry.type_card;
+  if (NeedsReflection(type_card)) {
+    const FieldDescriptor* field = FindPresentField(msg, field_number);
+    if (field == nullptr) return 0;
+    return WireFormat::FieldByteSize(field, msg);
+  }
+  const bool repeated = IsRepeated(entry);
+  if (!repeated && !MaybePresent(msg, field_number, entry)) return 0;
+  const void* base = FieldBase(msg, table, entry);
+  const size_t tag_size = TagSize(field_number);
+
+  switch (type_card & fl::kFkMask) {
+    case fl::kFkVarint:
+      return VisitVarintType(type_card, [&](auto* type) -> size_t {
+        using T = std::remove_pointer_t<decltype(type)>;
+        const bool zigzag = IsZigZag(type_card);
+        if (repeated) {
+          const auto& field = FieldAt<RepeatedField<T>>(base, entry.offset);
+          return tag_size * field.size() + VarintDataSize(field, zigzag);
+        }
+        T value = FieldAt<T>(base, entry.offset);
+        if (HasImplicitPresence(entry) && value == 0) return 0;
+        return tag_size +
+               io::CodedOutputStream::VarintSize64(EncodeVarint(value, zigzag));
+      });
+
+    case fl::kFkPackedVarint:
+      return VisitVarintType(type_card, [&](auto* type) -> size_t {
+        using T = std::remove_pointer_t<decltype(type)>;
+        const auto& field = FieldAt<RepeatedField<T>>(base, entry.offset);
+        if (field.empty()) return 0;
+        return tag_size + WireFormatLite::LengthDelimitedSize(VarintDataSize(
+                              field, IsZigZag(type_card)));
+      });
+
+    case fl::kFkFixed:
+    case fl::kFkPackedFixed: {
+      const bool is_64 = (type_card & fl::kRepMask) == fl::kRep64Bits;
+      const size_t element_size = is_64 ? 8 : 4;
+      if (!repeated) {
+        if (HasImplicitPresence(entry) &&
+            (is_64 ? FieldAt<uint64_t>(base, entry.offset) == 0
+                   : FieldAt<uint32_t>(base, entry.offset) == 0)) {
+          return 0;
+        }
+        return tag_size + element_size;
+      }
+      size_t count =
+          is_64 ? FieldAt<RepeatedField<uint64_t>>(base, entry.offset).size()
+                : FieldAt<RepeatedField<uint32_t>>(base, entry.offset).size();
+      if ((type_card & fl::kFkMask) == fl::kFkFixed) {
+        return count * (tag_size + element_size);
+      }
+      if (count == 0) return 0;
+      return tag_size +
+             WireFormatLite::LengthDelimitedSize(count * element_size);
+    }
+
+    case fl::kFkString:
+      if (repeated) {
+        if ((type_card & fl::kRepMask) == fl::kRepSBuffer) {
+          const auto& field = FieldAt<RepeatedStringBuffer>(base, entry.offset);
+          size_t size = tag_size * field.size();
+          for (absl::string_view value : field) {
+            size += WireFormatLite::LengthDelimitedSize(value.size());
+          }
+          return size;
+        }
+        const auto& field =
+            FieldAt<RepeatedPtrField<std::string>>(base, entry.offset);
+        size_t size = tag_size * field.size();
+        for (const std::string& value : field) {
+          size += WireFormatLite::StringSize(value);
+        }
+        return size;
+      } else {
+        const std::string& value = GetString(base, entry);
+        if (HasImplicitPresence(entry) && value.empty()) return 0;
+        return tag_size + WireFormatLite::StringSize(value);
+      }
+
+    case fl::kFkMessage:
+      if (repeated) {
+        size_t size = 0;
+        for (const MessageLite& value :
+             FieldAt<RepeatedPtrField<MessageLite>>(base, entry.offset)) {
+          size += MessageByteSize(field_number, type_card, value);
+        }
+        return size;
+      } else {
+        const MessageLite* value =
+            FieldAt<const MessageLite*>(base, entry.offset);
+        if (value == nullptr) return 0;
+        return MessageByteSize(field_number, type_card, *value);
+      }
+
+    default:
+      PROTOBUF_ASSUME(false);
+  }
+  return 0;
+}
+
+}  // namespace
+
+uint8_t* TcParser::SerializeWithTable(const Message& msg,
+                                      const TcParseTableBase* table,
+                                      uint8_t* target,
+                                      io::EpsCopyOutputStream* stream) {
+  // Extension ranges are interleaved with the fields in number order, the
+  // same way the generated serializers emit them.
+  const Descriptor* descriptor =
+      table->extension_offset != 0 ? msg.GetDescriptor() : nullptr;
+  int next_range = 0;
+  auto serialize_extensions_before = [&](uint32_t field_number) {
+    if (descriptor == nullptr) return;
+    while (next_range < descriptor->extension_range_count() &&
+           static_cast<uint32_t>(
+               descriptor->extension_range(next_range)->start_number()) <
+               field_number) {
+      const Descriptor::ExtensionRange* range =
+          descriptor->extension_range(next_range++);
+      target = FieldAt<ExtensionSet>(&msg, table->extension_offset)
+                   ._InternalSerialize(table->default_instance,
+                                       range->start_number(),
+                                       range->end_number(), target, stream);
+    }
+  };
+
+  ForEachFieldEntry(table, [&](uint32_t field_number, const FieldEntry& entry) {
+    serialize_extensions_before(field_number);
+    target = SerializeField(msg, table, field_number, entry, target, stream);
+  });
+  serialize_extensions_before(std::numeric_limits<uint32_t>::max());
+
+  const auto& metadata =
+      static_cast<const MessageLite&>(msg)._internal_metadata_;
+  if (PROTOBUF_PREDICT_FALSE(metadata.have_unknown_fields())) {
+    target = WireFormat::InternalSerializeUnknownFieldsToArray(
+        metadata.unknown_fields<UnknownFieldSet>(
+            UnknownFieldSet::default_instance),
+        target, stream);
+  }
+  return target;
+}
+
+size_t TcParser::ByteSizeWithTable(const Message& msg,
+                                   const TcParseTableBase* table) {
+  size_t total_size = 0;
+  ForEachFieldEntry(table, [&](uint32_t field_number, const FieldEntry& entry) {
+    total_size += FieldByteSize(msg, table, field_number, entry);
+  });
+  if (table->extension_offset != 0) {
+    total_size +=
+        FieldAt<ExtensionSet>(&msg, table->extension_offset).ByteSize();
+  }
+
+  const auto& metadata =
+      static_cast<const MessageLite&>(msg)._internal_metadata_;
+  if (PROTOBUF_PREDICT_FALSE(metadata.have_unknown_fields())) {
+    total_size += WireFormat::ComputeUnknownFieldsSize(
+        metadata.unknown_fields<UnknownFieldSet>(
+            UnknownFieldSet::default_instance));
+  }
+  msg.AccessCachedSize()->Set(ToCachedSize(total_size));
+  return total_size;
+}
+
 }  // namespace internal
 }  // namespace protobuf
 }  // namespace google
@@ -256,9 +256,11 @@ bool IsFieldEligibleForFastParsing(
   const auto* field = entry.field;
   const auto options = option_provider.GetForField(field);
   ABSL_CHECK(!field->options().weak());
-  // Map, oneof, weak, and split fields are not handled on the fast path.
+  // Map, oneof, weak, split and string buffer fields are not handled on the
+  // fast path.
   if (field->is_map() || field->real_containing_oneof() ||
-      options.is_implicitly_weak || options.should_split) {
+      options.is_implicitly_weak || options.should_split ||
+      options.is_repeated_string_buffer) {
     return false;
   }
 
@@ -297,18 +299,6 @@ bool IsFieldEligibleForFastParsing(
       }
       break;
 
-    case FieldDescriptor::TYPE_ENUM: {
-      uint8_t rmax_value;
-      if (!message_options.uses_codegen &&
-          GetEnumRangeInfo(field, rmax_value) == EnumRangeInfo::kNone) {
-        // We can't use fast parsing for these entries because we can't specify
-        // the validator.
-        // TODO(b/239592582): Implement a fast parser for these enums.
-        return false;
-      }
-      break;
-    }
-
     default:
       break;
   }
@@ -710,7 +700,11 @@ uint16_t MakeTypeCardForField(
         if (HasLazyRep(field, options)) {
           ABSL_CHECK(options.lazy_opt == field_layout::kTvEager ||
                      options.lazy_opt == field_layout::kTvLazy);
-          type_card |= +fl::kRepLazy | options.lazy_opt;
+          // Implicitly weak lazy fields are not verified, and need the weak
+          // default instance.
+          type_card |= +fl::kRepLazy | (options.is_implicitly_weak
+                                            ? fl::kTvWeakPtr
+                                            : options.lazy_opt);
         } else {
           if (options.is_implicitly_weak) {
             type_card |= fl::kTvWeakPtr;
@@ -733,7 +727,10 @@ uint16_t MakeTypeCardForField(
         type_card |= fl::kRepCord;
         break;
       case FieldOptions::STRING:
-        if (field->is_repeated()) {
+        if (options.is_repeated_string_buffer) {
+          ABSL_CHECK(field->is_repeated());
+          type_card |= fl::kRepSBuffer;
+        } else if (field->is_repeated()) {
           // A repeated string field uses RepeatedPtrField<std::string>
           // (unless it has a ctype option; see above).
           type_card |= fl::kRepSString;
@@ -811,7 +808,10 @@ TailCallTableInfo::TailCallTableInfo(
           }
         }
       } else if (HasLazyRep(field, options)) {
-        if (message_options.uses_codegen) {
+        if (message_options.uses_codegen && options.is_implicitly_weak) {
+          field_entries.back().aux_idx = aux_entries.size();
+          aux_entries.push_back({kSubMessageWeak, {field}});
+        } else if (message_options.uses_codegen) {
           field_entries.back().aux_idx = aux_entries.size();
           aux_entries.push_back({kSubMessage, {field}});
           if (options.lazy_opt == field_layout::kTvEager) {
@@ -873,6 +873,29 @@ TailCallTableInfo::TailCallTableInfo(
     }
   }
 
+  // ParseLoop can only check the required fields if their has-bits share a
+  // word.
+  required_has_bits_word = 0;
+  required_has_bits = 0;
+  bool has_required = false;
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    const FieldDescriptor* field = descriptor->field(i);
+    if (!field->is_required()) continue;
+    const int idx = has_bit_indices.empty()
+                        ? -1
+                        : has_bit_indices[static_cast<size_t>(field->index())];
+    const int word = idx / 32;
+    if (idx < 0 || word >= TcParseTableBase::kRequiredFieldsUnknown ||
+        (has_required && word != required_has_bits_word)) {
+      required_has_bits_word = TcParseTableBase::kRequiredFieldsUnknown;
+      required_has_bits = 0;
+      break;
+    }
+    has_required = true;
+    required_has_bits_word = static_cast<uint8_t>(word);
+    required_has_bits |= uint32_t{1} << (idx % 32);
+  }
+
   table_size_log2 = 0;  // fallback value
   int num_fast_fields = -1;
   auto end_group_tag = GetEndGroupTag(descriptor);
@@ -70,6 +70,8 @@ struct PROTOBUF_EXPORT TailCallTableInfo {
     bool is_implicitly_weak;
     bool use_direct_tcparser_table;
     bool should_split;
+    // Repeated string or bytes field stored in a RepeatedStringBuffer.
+    bool is_repeated_string_buffer;
   };
   class OptionProvider {
    public:
@@ -176,6 +178,10 @@ struct PROTOBUF_EXPORT TailCallTableInfo {
 
   // Table size.
   int table_size_log2;
+
+  // See TcParseTableBase::required_has_bits_word.
+  uint8_t required_has_bits_word;
+  uint32_t required_has_bits;
 };
 
 }  // namespace internal
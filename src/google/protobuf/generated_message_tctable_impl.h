@@ -37,6 +37,9 @@
 #include <type_traits>
 #include <utility>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
 #include "google/protobuf/extension_set.h"
 #include "google/protobuf/generated_message_tctable_decl.h"
 #include "google/protobuf/map.h"
@@ -152,6 +155,7 @@ enum FieldRep : uint16_t {
   kRepCord     = 2 << kRepShift,  // absl::Cord
   kRepSPiece   = 3 << kRepShift,  // StringPieceField
   kRepSString  = 4 << kRepShift,  // std::string*
+  kRepSBuffer  = 5 << kRepShift,  // RepeatedStringBuffer
   // Message types (WT=2 unless otherwise noted):
   kRepMessage  = 0,               // MessageLite*
   kRepGroup    = 1 << kRepShift,  // MessageLite* (WT=3,4)
@@ -178,7 +182,7 @@ enum TransformValidation : uint16_t {
   kTvTable     = 2 << kTvShift,  // Aux has TcParseTableBase*
   kTvWeakPtr   = 3 << kTvShift,  // Aux has default_instance** (for weak)
 
-  // Lazy message fields:
+  // Lazy message fields (kTvWeakPtr as above, for implicitly weak ones):
   kTvEager     = 1 << kTvShift,
   kTvLazy      = 2 << kTvShift,
 };
@@ -382,6 +386,45 @@ inline void AlignFail(std::integral_constant<size_t, 1>,
 enum class TcParseFunction { kNone, PROTOBUF_TC_PARSE_FUNCTION_LIST };
 #undef PROTOBUF_TC_PARSE_FUNCTION_X
 
+// Receives samples of the fields that the table driven parser sees on the
+// wire. See SetTcParseSampler().
+class PROTOBUF_EXPORT TcParseSampler {
+ public:
+  virtual ~TcParseSampler() = default;
+
+  // Called for each field at the top level of a sampled message, in wire
+  // order. `default_instance` identifies the type of the message.
+  virtual void RecordField(const MessageLite& default_instance,
+                           int field_number) = 0;
+};
+
+// Installs `sampler` so that one in every `period` messages parsed by
+// TcParser::ParseLoop reports its field numbers before it is parsed. Only the
+// part of a message that is already buffered is sampled. Passing nullptr
+// disables sampling; the sampler must outlive any parse that may observe it.
+PROTOBUF_EXPORT void SetTcParseSampler(TcParseSampler* sampler, int period);
+
+// A TcParseSampler that counts the fields seen per message type.
+//
+// ToString() produces the profile consumed by the C++ code generator's
+// `parse_profile` option, which assigns the fast table slots of each message
+// to the fields that are most frequent on the wire, lays those fields out
+// first and moves rarely seen fields to the message's split struct.
+class PROTOBUF_EXPORT TcParseProfile final : public TcParseSampler {
+ public:
+  void RecordField(const MessageLite& default_instance,
+                   int field_number) override;
+
+  // Returns one `<message full name> <field number> <count>` line per
+  // sampled field, sorted by message name and field number.
+  std::string ToString() const;
+
+ private:
+  mutable absl::Mutex mu_;
+  absl::flat_hash_map<std::pair<const MessageLite*, int>, uint64_t> counts_
+      ABSL_GUARDED_BY(mu_);
+};
+
 // TcParser implements most of the parsing logic for tailcall tables.
 class PROTOBUF_EXPORT TcParser final {
  public:
@@ -420,6 +463,18 @@ class PROTOBUF_EXPORT TcParser final {
                                ParseContext* ctx,
                                const TcParseTableBase* table);
 
+  // Serialization and size computation driven by the same field entries the
+  // parser uses, for classes generated with the `table_driven` option (see
+  // compiler/cpp/generator.cc).  Fields the table does not fully describe
+  // (maps, lazy, cord and weak fields) are handled through reflection.
+  static uint8_t* SerializeWithTable(const Message& msg,
+                                     const TcParseTableBase* table,
+                                     uint8_t* target,
+                                     io::EpsCopyOutputStream* stream);
+  // Also updates the cached size of `msg`.
+  static size_t ByteSizeWithTable(const Message& msg,
+                                  const TcParseTableBase* table);
+
   // Functions referenced by generated fast tables (numeric types):
   //   F: fixed      V: varint     Z: zigzag
   //   8/32/64: storage type width (bits)
@@ -706,6 +761,11 @@ class PROTOBUF_EXPORT TcParser final {
   template <typename TagType>
   static const char* FastEndGroupImpl(PROTOBUF_TC_PARAM_DECL);
 
+  // Reports the buffered fields of the message at `ptr` to the installed
+  // TcParseSampler, if this message is selected for sampling.
+  static void SampleParse(const char* ptr, ParseContext* ctx,
+                          const TcParseTableBase* table);
+
   static inline PROTOBUF_ALWAYS_INLINE void SyncHasbits(
       MessageLite* msg, uint64_t hasbits, const TcParseTableBase* table) {
     const uint32_t has_bits_offset = table->has_bits_offset;
@@ -716,6 +776,25 @@ class PROTOBUF_EXPORT TcParser final {
     }
   }
 
+  // Flags `ctx` unless `msg`, whose parse just ended, has all the required
+  // fields of `table`.
+  static inline PROTOBUF_ALWAYS_INLINE void CheckRequiredFields(
+      const MessageLite* msg, ParseContext* ctx,
+      const TcParseTableBase* table) {
+    const uint32_t mask = table->required_has_bits;
+    if (PROTOBUF_PREDICT_TRUE(mask == 0)) {
+      if (PROTOBUF_PREDICT_FALSE(table->required_has_bits_word ==
+                                 TcParseTableBase::kRequiredFieldsUnknown)) {
+        ctx->RequireInitializationCheck();
+      }
+      return;
+    }
+    const uint32_t has_bits = RefAt<uint32_t>(
+        msg, table->has_bits_offset +
+                 sizeof(uint32_t) * table->required_has_bits_word);
+    if ((has_bits & mask) != mask) ctx->RequireInitializationCheck();
+  }
+
   static const char* TagDispatch(PROTOBUF_TC_PARAM_NO_DATA_DECL);
   static const char* ToTagDispatch(PROTOBUF_TC_PARAM_NO_DATA_DECL);
   static const char* ToParseLoop(PROTOBUF_TC_PARAM_NO_DATA_DECL);
@@ -774,6 +853,8 @@ class PROTOBUF_EXPORT TcParser final {
           .ParseField(tag, ptr,
                       static_cast<const MessageBaseT*>(table->default_instance),
                       &msg->_internal_metadata_, ctx);
+    } else if (ctx->discard_unknown_fields()) {
+      return SkipUnknownField(tag, ptr, ctx);
     } else {
       // Otherwise, we directly put it on the unknown field set.
       return UnknownFieldParse(
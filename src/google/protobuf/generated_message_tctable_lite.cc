@@ -29,28 +29,36 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <limits>
 #include <numeric>
 #include <string>
+#include <tuple>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "absl/base/optimization.h"
 #include "absl/log/absl_check.h"
 #include "absl/log/absl_log.h"
 #include "absl/numeric/bits.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "google/protobuf/generated_message_tctable_decl.h"
 #include "google/protobuf/generated_message_tctable_impl.h"
 #include "google/protobuf/inlined_string_field.h"
 #include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/lazy_field.h"
 #include "google/protobuf/map.h"
 #include "google/protobuf/message_lite.h"
 #include "google/protobuf/parse_context.h"
+#include "google/protobuf/port.h"
 #include "google/protobuf/repeated_field.h"
 #include "google/protobuf/repeated_ptr_field.h"
+#include "google/protobuf/repeated_string_buffer.h"
 #include "google/protobuf/varint_shuffle.h"
 #include "google/protobuf/wire_format_lite.h"
 #include "utf8_validity.h"
@@ -90,6 +98,104 @@ const char* TcParser::GenericFallbackLite(PROTOBUF_TC_PARAM_DECL) {
       PROTOBUF_TC_PARAM_PASS);
 }
 
+//////////////////////////////////////////////////////////////////////////////
+// Parse sampling:
+//////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+std::atomic<TcParseSampler*> tc_parse_sampler{nullptr};
+std::atomic<int> tc_parse_sample_period{1};
+PROTOBUF_THREAD_LOCAL int tc_parse_sample_countdown = 0;
+
+}  // namespace
+
+void SetTcParseSampler(TcParseSampler* sampler, int period) {
+  ABSL_CHECK_GT(period, 0);
+  tc_parse_sample_period.store(period, std::memory_order_relaxed);
+  tc_parse_sampler.store(sampler, std::memory_order_release);
+}
+
+void TcParser::SampleParse(const char* ptr, ParseContext* ctx,
+                           const TcParseTableBase* table) {
+  if (--tc_parse_sample_countdown > 0) return;
+  tc_parse_sample_countdown =
+      tc_parse_sample_period.load(std::memory_order_relaxed);
+  TcParseSampler* sampler = tc_parse_sampler.load(std::memory_order_acquire);
+  if (sampler == nullptr || table->default_instance == nullptr) return;
+
+  // Walk the fields in the current buffer without consuming them. The last
+  // few bytes are copied into a zero-padded tail first, so that reading a tag
+  // or varint cannot run past the end of the data.
+  constexpr int kTailSize = 16;
+  char tail[2 * kTailSize] = {};
+  bool in_tail = false;
+  const char* end = ctx->ReadableEnd(ptr);
+  while (ptr < end) {
+    if (!in_tail && end - ptr < kTailSize) {
+      const size_t size = static_cast<size_t>(end - ptr);
+      std::memcpy(tail, ptr, size);
+      ptr = tail;
+      end = tail + size;
+      in_tail = true;
+    }
+    uint32_t tag;
+    ptr = ReadTag(ptr, &tag);
+    if (ptr == nullptr || tag == 0) return;
+    const auto wire_type = WireFormatLite::GetTagWireType(tag);
+    if (wire_type == WireFormatLite::WIRETYPE_END_GROUP) return;
+    sampler->RecordField(*table->default_instance, tag >> 3);
+    switch (wire_type) {
+      case WireFormatLite::WIRETYPE_VARINT: {
+        uint64_t unused;
+        ptr = VarintParse(ptr, &unused);
+        break;
+      }
+      case WireFormatLite::WIRETYPE_FIXED64:
+        ptr += 8;
+        break;
+      case WireFormatLite::WIRETYPE_FIXED32:
+        ptr += 4;
+        break;
+      case WireFormatLite::WIRETYPE_LENGTH_DELIMITED: {
+        int size = ReadSize(&ptr);
+        if (ptr == nullptr || size > end - ptr) return;
+        ptr += size;
+        break;
+      }
+      default:
+        // Groups would need to be walked recursively; stop sampling here.
+        return;
+    }
+    if (ptr == nullptr || ptr > end) return;
+  }
+}
+
+void TcParseProfile::RecordField(const MessageLite& default_instance,
+                                 int field_number) {
+  absl::MutexLock lock(&mu_);
+  ++counts_[{&default_instance, field_number}];
+}
+
+std::string TcParseProfile::ToString() const {
+  std::vector<std::tuple<std::string, int, uint64_t>> entries;
+  {
+    absl::MutexLock lock(&mu_);
+    entries.reserve(counts_.size());
+    for (const auto& entry : counts_) {
+      entries.emplace_back(entry.first.first->GetTypeName(),
+                           entry.first.second, entry.second);
+    }
+  }
+  std::sort(entries.begin(), entries.end());
+  std::string result;
+  for (const auto& entry : entries) {
+    absl::StrAppend(&result, std::get<0>(entry), " ", std::get<1>(entry), " ",
+                    std::get<2>(entry), "\n");
+  }
+  return result;
+}
+
 //////////////////////////////////////////////////////////////////////////////
 // Core fast parsing implementation:
 //////////////////////////////////////////////////////////////////////////////
@@ -103,6 +209,10 @@ PROTOBUF_NOINLINE const char* TcParser::ParseLoop(
   // need during dispatch.  It turns out that "table + 1" points exactly to
   // fast_entries, so we just increment table by 1 here, to get the register
   // holding the value we want.
+  if (PROTOBUF_PREDICT_FALSE(
+          tc_parse_sampler.load(std::memory_order_relaxed) != nullptr)) {
+    SampleParse(ptr, ctx, table);
+  }
   table += 1;
   while (!ctx->Done(&ptr)) {
 #if defined(__GNUC__)
@@ -116,6 +226,9 @@ PROTOBUF_NOINLINE const char* TcParser::ParseLoop(
     if (ptr == nullptr) break;
     if (ctx->LastTag() != 1) break;  // Ended on terminating tag
   }
+  if (PROTOBUF_PREDICT_TRUE(ptr != nullptr)) {
+    CheckRequiredFields(msg, ctx, table - 1);
+  }
   return ptr;
 }
 
@@ -403,6 +516,16 @@ inline PROTOBUF_ALWAYS_INLINE void InvertPacked(TcFieldData& data) {
 // Message fields
 //////////////////////////////////////////////////////////////////////////////
 
+// Prefetches the header and first fast entries of a sub-message parse table.
+// We issue this as soon as the sub-message tag is decoded, so the loads can
+// overlap with allocating the sub-message. In deep trees of distinct message
+// types every level enters a different table, and these misses add up.
+PROTOBUF_ALWAYS_INLINE void PrefetchParseTable(const TcParseTableBase* table) {
+  const char* p = reinterpret_cast<const char*>(table);
+  PrefetchToLocalCache(p);
+  PrefetchToLocalCache(p + kCacheAlignment);
+}
+
 template <typename TagType, bool group_coding, bool aux_is_table>
 inline PROTOBUF_ALWAYS_INLINE const char* TcParser::SingularParseMessageAuxImpl(
     PROTOBUF_TC_PARAM_DECL) {
@@ -417,6 +540,7 @@ inline PROTOBUF_ALWAYS_INLINE const char* TcParser::SingularParseMessageAuxImpl(
 
   if (aux_is_table) {
     const auto* inner_table = table->field_aux(data.aux_idx())->table;
+    PrefetchParseTable(inner_table);
     if (field == nullptr) {
       field = inner_table->default_instance->New(msg->GetArenaForAllocation());
     }
@@ -501,6 +625,7 @@ inline PROTOBUF_ALWAYS_INLINE const char* TcParser::RepeatedParseMessageAuxImpl(
   const auto expected_tag = UnalignedLoad<TagType>(ptr);
   const auto aux = *table->field_aux(data.aux_idx());
   auto& field = RefAt<RepeatedPtrFieldBase>(msg, data.offset());
+  if (aux_is_table) PrefetchParseTable(aux.table);
   const MessageLite* const default_instance =
       aux_is_table ? aux.table->default_instance : aux.message_default();
   do {
@@ -822,6 +947,69 @@ PROTOBUF_ALWAYS_INLINE bool EnumIsValidAux(int32_t val, uint16_t xform_val,
   }
 }
 
+// Validates the values a packed parse appended to `field` from index `from`
+// on, keeping the valid ones in order and passing the others to
+// `add_unknown`.
+//
+// Values are checked a block at a time against the dense range of the enum
+// (all of it for kTvRange, the sequential part for kTvEnum) with a branch-free
+// loop that compilers vectorize.  Only a block with a value outside that range
+// goes through EnumIsValidAux() value by value, which also covers the bitmap
+// and ordered parts of the enum data.
+template <typename T, typename AddUnknown>
+PROTOBUF_ALWAYS_INLINE void ValidatePackedEnum(RepeatedField<T>& field,
+                                               int from, uint16_t xform_val,
+                                               TcParseTableBase::FieldAux aux,
+                                               AddUnknown add_unknown) {
+  constexpr int kBlock = 16;
+  uint32_t lo;
+  uint32_t length;
+  if (xform_val == field_layout::kTvRange) {
+    lo = static_cast<uint32_t>(int32_t{aux.enum_range.start});
+    length = aux.enum_range.length;
+  } else {
+    lo = static_cast<uint32_t>(
+        int32_t{static_cast<int16_t>(aux.enum_data[0] & 0xFFFF)});
+    length = aux.enum_data[0] >> 16;
+  }
+  T* values = field.mutable_data();
+  const int size = field.size();
+  int out = from;
+  int i = from;
+  for (; size - i >= kBlock; i += kBlock) {
+    // Wrapping subtraction keeps this exact for any int32_t value, as both
+    // the range start and length fit in 16 bits.
+    bool in_range = true;
+    for (int j = 0; j < kBlock; ++j) {
+      in_range &= static_cast<uint32_t>(values[i + j]) - lo < length;
+    }
+    if (PROTOBUF_PREDICT_TRUE(in_range)) {
+      if (out != i) {
+        std::memmove(values + out, values + i, kBlock * sizeof(T));
+      }
+      out += kBlock;
+      continue;
+    }
+    for (int j = 0; j < kBlock; ++j) {
+      const int32_t value = static_cast<int32_t>(values[i + j]);
+      if (EnumIsValidAux(value, xform_val, aux)) {
+        values[out++] = values[i + j];
+      } else {
+        add_unknown(value);
+      }
+    }
+  }
+  for (; i < size; ++i) {
+    const int32_t value = static_cast<int32_t>(values[i]);
+    if (EnumIsValidAux(value, xform_val, aux)) {
+      values[out++] = values[i];
+    } else {
+      add_unknown(value);
+    }
+  }
+  if (out != size) field.Truncate(out);
+}
+
 }  // namespace
 
 template <typename FieldType, typename TagType, bool zigzag>
@@ -1057,19 +1245,7 @@ const char* TcParser::PackedVarint(PROTOBUF_TC_PARAM_DECL) {
   // pending hasbits now:
   SyncHasbits(msg, hasbits, table);
   auto* field = &RefAt<RepeatedField<FieldType>>(msg, data.offset());
-  return ctx->ReadPackedVarint(ptr, [field](uint64_t varint) {
-    FieldType val;
-    if (zigzag) {
-      if (sizeof(FieldType) == 8) {
-        val = WireFormatLite::ZigZagDecode64(varint);
-      } else {
-        val = WireFormatLite::ZigZagDecode32(varint);
-      }
-    } else {
-      val = varint;
-    }
-    field->Add(val);
-  });
+  return ctx->ReadPackedVarintInto<FieldType, zigzag>(ptr, field);
 }
 
 PROTOBUF_NOINLINE const char* TcParser::FastV8P1(PROTOBUF_TC_PARAM_DECL) {
@@ -1266,13 +1442,14 @@ const char* TcParser::PackedEnum(PROTOBUF_TC_PARAM_DECL) {
   auto* field = &RefAt<RepeatedField<int32_t>>(msg, data.offset());
   const TcParseTableBase::FieldAux aux = *table->field_aux(data.aux_idx());
   PrefetchEnumData(xform_val, aux);
-  return ctx->ReadPackedVarint(ptr, [=](int32_t value) {
-    if (!EnumIsValidAux(value, xform_val, aux)) {
-      AddUnknownEnum(msg, table, FastDecodeTag(saved_tag), value);
-    } else {
-      field->Add(value);
-    }
+  // Decode the whole run first and validate it in bulk. This also runs when
+  // the run is malformed, so the field never holds an invalid value.
+  const int from = field->size();
+  ptr = ctx->ReadPackedVarintInto<int32_t>(ptr, field);
+  ValidatePackedEnum(*field, from, xform_val, aux, [=](int32_t value) {
+    AddUnknownEnum(msg, table, FastDecodeTag(saved_tag), value);
   });
+  return ptr;
 }
 
 PROTOBUF_NOINLINE const char* TcParser::FastErR1(PROTOBUF_TC_PARAM_DECL) {
@@ -1508,7 +1685,10 @@ const char* ReadStringNoArena(MessageLite* /*msg*/, const char* ptr,
 }
 
 PROTOBUF_ALWAYS_INLINE inline bool IsValidUTF8(ArenaStringPtr& field) {
-  return utf8_range::IsStructurallyValid(field.Get());
+  if (!utf8_range::IsStructurallyValid(field.Get())) return false;
+  // Lets serialization skip checking the string again while it is unchanged.
+  field.SetUtf8Validated();
+  return true;
 }
 
 
@@ -2134,21 +2314,16 @@ const char* TcParser::MpPackedVarintT(PROTOBUF_TC_PARAM_DECL) {
   if (is_validated_enum) {
     const TcParseTableBase::FieldAux aux = *table->field_aux(entry.aux_idx);
     PrefetchEnumData(xform_val, aux);
-    return ctx->ReadPackedVarint(ptr, [=](int32_t value) {
-      if (!EnumIsValidAux(value, xform_val, aux)) {
-        AddUnknownEnum(msg, table, data.tag(), value);
-      } else {
-        field->Add(value);
-      }
+    const int from = field->size();
+    ptr = ctx->ReadPackedVarintInto<FieldType>(ptr, field);
+    ValidatePackedEnum(*field, from, xform_val, aux, [=](int32_t value) {
+      AddUnknownEnum(msg, table, data.tag(), value);
     });
+    return ptr;
+  } else if (is_zigzag) {
+    return ctx->ReadPackedVarintInto<FieldType, true>(ptr, field);
   } else {
-    return ctx->ReadPackedVarint(ptr, [=](uint64_t value) {
-      field->Add(is_zigzag ? (sizeof(FieldType) == 8
-                                  ? WireFormatLite::ZigZagDecode64(value)
-                                  : WireFormatLite::ZigZagDecode32(
-                                        static_cast<uint32_t>(value)))
-                           : value);
-    });
+    return ctx->ReadPackedVarintInto<FieldType, false>(ptr, field);
   }
 }
 
@@ -2285,6 +2460,9 @@ PROTOBUF_NOINLINE const char* TcParser::MpString(PROTOBUF_TC_PARAM_DECL) {
       }
       if (!ptr) break;
       is_valid = MpVerifyUtf8(field.Get(), table, entry, xform_val);
+      if (xform_val == field_layout::kTvUtf8 && is_valid) {
+        field.SetUtf8Validated();
+      }
       break;
     }
 
@@ -2389,6 +2567,24 @@ PROTOBUF_NOINLINE const char* TcParser::MpRepeatedString(
       break;
     }
 
+    case field_layout::kRepSBuffer: {
+      auto& field = RefAt<RepeatedStringBuffer>(base, entry.offset);
+      const char* ptr2 = ptr;
+      uint32_t next_tag;
+      do {
+        ptr = ptr2;
+        ptr = field.InternalParseElement(ptr, ctx);
+        if (PROTOBUF_PREDICT_FALSE(ptr == nullptr ||
+                                   !MpVerifyUtf8(field[field.size() - 1],
+                                                 table, entry, xform_val))) {
+          PROTOBUF_MUSTTAIL return Error(PROTOBUF_TC_PARAM_NO_DATA_PASS);
+        }
+        if (PROTOBUF_PREDICT_FALSE(!ctx->DataAvailable(ptr))) goto parse_loop;
+        ptr2 = ReadTag(ptr, &next_tag);
+      } while (next_tag == decoded_tag);
+      break;
+    }
+
 #ifndef NDEBUG
     default:
       ABSL_LOG(FATAL) << "Unsupported repeated string rep: " << rep;
@@ -2440,6 +2636,9 @@ PROTOBUF_NOINLINE const char* TcParser::MpMessage(PROTOBUF_TC_PARAM_DECL) {
         goto fallback;
       }
       break;
+    case field_layout::kRepLazy:
+      if (is_split) goto fallback;
+      PROTOBUF_MUSTTAIL return MpLazyMessage(PROTOBUF_TC_PARAM_PASS);
     default: {
     fallback:
       PROTOBUF_MUSTTAIL return table->fallback(PROTOBUF_TC_PARAM_PASS);
@@ -2459,6 +2658,7 @@ PROTOBUF_NOINLINE const char* TcParser::MpMessage(PROTOBUF_TC_PARAM_DECL) {
   MessageLite*& field = RefAt<MessageLite*>(base, entry.offset);
   if ((type_card & field_layout::kTvMask) == field_layout::kTvTable) {
     auto* inner_table = table->field_aux(&entry)->table;
+    PrefetchParseTable(inner_table);
     if (need_init || field == nullptr) {
       field = inner_table->default_instance->New(msg->GetArenaForAllocation());
     }
@@ -2485,6 +2685,36 @@ PROTOBUF_NOINLINE const char* TcParser::MpMessage(PROTOBUF_TC_PARAM_DECL) {
   }
 }
 
+PROTOBUF_NOINLINE const char* TcParser::MpLazyMessage(
+    PROTOBUF_TC_PARAM_DECL) {
+  const auto& entry = RefAt<FieldEntry>(table, data.entry_offset());
+  const uint16_t type_card = entry.type_card;
+  const uint16_t card = type_card & field_layout::kFcMask;
+  if ((data.tag() & 7) != WireFormatLite::WIRETYPE_LENGTH_DELIMITED ||
+      card == field_layout::kFcOneof) {
+    PROTOBUF_MUSTTAIL return table->fallback(PROTOBUF_TC_PARAM_PASS);
+  }
+
+  if (card == field_layout::kFcOptional) SetHas(entry, msg);
+  SyncHasbits(msg, hasbits, table);
+  // Verification is not supported: both kTvEager and kTvLazy fields only
+  // store the bytes, which are parsed when the field is first accessed.
+  const uint16_t xform_val = type_card & field_layout::kTvMask;
+  const MessageLite* prototype =
+      xform_val == field_layout::kTvWeakPtr
+          ? table->field_aux(&entry)->message_default_weak()
+          : table->field_aux(&entry)->message_default();
+  // The bytes are not checked for required fields, so ParseFrom has to run
+  // IsInitialized() if the type has any, unless the field is lazily verified.
+  // A default instance with required fields is never initialized.
+  if (xform_val != field_layout::kTvLazy &&
+      !ctx->needs_initialization_check() && !prototype->IsInitialized()) {
+    ctx->RequireInitializationCheck();
+  }
+  return RefAt<LazyField>(msg, entry.offset)
+      ._InternalParse(*prototype, msg->GetArenaForAllocation(), ptr, ctx);
+}
+
 template <bool is_split, bool is_group>
 const char* TcParser::MpRepeatedMessageOrGroup(PROTOBUF_TC_PARAM_DECL) {
   const auto& entry = RefAt<FieldEntry>(table, data.entry_offset());
@@ -2516,6 +2746,7 @@ const char* TcParser::MpRepeatedMessageOrGroup(PROTOBUF_TC_PARAM_DECL) {
   const auto aux = *table->field_aux(&entry);
   if ((type_card & field_layout::kTvMask) == field_layout::kTvTable) {
     auto* inner_table = aux.table;
+    PrefetchParseTable(inner_table);
     const MessageLite* default_instance = inner_table->default_instance;
     const char* ptr2 = ptr;
     uint32_t next_tag;
@@ -2701,6 +2932,7 @@ const char* TcParser::ParseOneMapEntry(
   const uint8_t key_tag = WFL::MakeTag(1, map_info.key_type_card.wiretype());
   const uint8_t value_tag =
       WFL::MakeTag(2, map_info.value_type_card.wiretype());
+  bool parsed_message_value = false;
 
   while (!ctx->Done(&ptr)) {
     uint32_t inner_tag = ptr[0];
@@ -2790,12 +3022,18 @@ const char* TcParser::ParseOneMapEntry(
           ABSL_DCHECK_EQ(inner_tag, value_tag);
           ptr = ctx->ParseMessage(reinterpret_cast<MessageLite*>(obj), ptr);
           if (PROTOBUF_PREDICT_FALSE(ptr == nullptr)) return nullptr;
+          parsed_message_value = true;
           continue;
         }
       default:
         PROTOBUF_ASSUME(false);
     }
   }
+  // A message value that is not on the wire is never checked by ParseLoop.
+  if (map_info.value_type_card.cpp_type() == MapTypeCard::kMessage &&
+      !parsed_message_value) {
+    ctx->RequireInitializationCheck();
+  }
   return ptr;
 }
 
@@ -2812,6 +3050,8 @@ PROTOBUF_NOINLINE const char* TcParser::MpMap(PROTOBUF_TC_PARAM_DECL) {
   if (PROTOBUF_PREDICT_FALSE(!map_info.is_supported ||
                              (data.tag() & 7) !=
                                  WireFormatLite::WIRETYPE_LENGTH_DELIMITED)) {
+    // The fallback may parse entries without checking their required fields.
+    ctx->RequireInitializationCheck();
     PROTOBUF_MUSTTAIL return MpFallback(PROTOBUF_TC_PARAM_PASS);
   }
 
@@ -2827,8 +3067,40 @@ PROTOBUF_NOINLINE const char* TcParser::MpMap(PROTOBUF_TC_PARAM_DECL) {
 
   const uint32_t saved_tag = data.tag();
 
+  // If the entries of this field that are already in the buffer would not fit
+  // the table, size it for all of them now instead of growing it step by step
+  // as they are inserted. Until they are in, the inserts must not shrink the
+  // table back.
+  int reserved = 0;
+  const int run = ctx->CountLengthDelimitedRun(ptr, saved_tag);
+  if (run > 1) {
+    const size_t new_size = map.size() + run;
+    bool did_reserve = false;
+    switch (map_info.key_type_card.cpp_type()) {
+      case MapTypeCard::kBool:
+        did_reserve = static_cast<KeyMapBase<bool>&>(map).Reserve(new_size);
+        break;
+      case MapTypeCard::k32:
+        did_reserve =
+            static_cast<KeyMapBase<uint32_t>&>(map).Reserve(new_size);
+        break;
+      case MapTypeCard::k64:
+        did_reserve =
+            static_cast<KeyMapBase<uint64_t>&>(map).Reserve(new_size);
+        break;
+      case MapTypeCard::kString:
+        did_reserve =
+            static_cast<KeyMapBase<std::string>&>(map).Reserve(new_size);
+        break;
+      default:
+        PROTOBUF_ASSUME(false);
+    }
+    if (did_reserve) reserved = run;
+  }
+
   while (true) {
     NodeBase* node = map.AllocNode(map_info.node_size_info);
+    const bool may_shrink = reserved-- <= 0;
 
     InitializeMapNodeEntry(node->GetVoidKey(), map_info.key_type_card, map, aux,
                            true);
@@ -2852,20 +3124,21 @@ PROTOBUF_NOINLINE const char* TcParser::MpMap(PROTOBUF_TC_PARAM_DECL) {
         switch (map_info.key_type_card.cpp_type()) {
           case MapTypeCard::kBool:
             node = static_cast<KeyMapBase<bool>&>(map).InsertOrReplaceNode(
-                static_cast<KeyMapBase<bool>::KeyNode*>(node));
+                static_cast<KeyMapBase<bool>::KeyNode*>(node), may_shrink);
             break;
           case MapTypeCard::k32:
             node = static_cast<KeyMapBase<uint32_t>&>(map).InsertOrReplaceNode(
-                static_cast<KeyMapBase<uint32_t>::KeyNode*>(node));
+                static_cast<KeyMapBase<uint32_t>::KeyNode*>(node), may_shrink);
             break;
           case MapTypeCard::k64:
             node = static_cast<KeyMapBase<uint64_t>&>(map).InsertOrReplaceNode(
-                static_cast<KeyMapBase<uint64_t>::KeyNode*>(node));
+                static_cast<KeyMapBase<uint64_t>::KeyNode*>(node), may_shrink);
             break;
           case MapTypeCard::kString:
             node =
                 static_cast<KeyMapBase<std::string>&>(map).InsertOrReplaceNode(
-                    static_cast<KeyMapBase<std::string>::KeyNode*>(node));
+                    static_cast<KeyMapBase<std::string>::KeyNode*>(node),
+                    may_shrink);
             break;
           default:
             PROTOBUF_ASSUME(false);
@@ -29,11 +29,13 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <cstddef>
+#include <string>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include "absl/types/optional.h"
 #include "google/protobuf/generated_message_tctable_impl.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include "google/protobuf/unittest.pb.h"
 #include "google/protobuf/wire_format_lite.h"
 
@@ -922,6 +924,179 @@ TEST(GeneratedMessageTctableLiteTest,
   EXPECT_LE(proto.vals().Capacity(), 2048);
 }
 
+// Fills the packed varint fields of `proto` with `n` values of all encoded
+// lengths, interleaving runs of single byte values with longer ones.
+void FillPackedVarints(int n, protobuf_unittest::TestPackedTypes& proto) {
+  for (int i = 0; i < n; i++) {
+    const int64_t value = (i % 3 == 0) ? int64_t{1} << ((i * 7) % 63) : i % 64;
+    proto.add_packed_int32(static_cast<int32_t>(i % 5 == 0 ? -value : value));
+    proto.add_packed_int64(i % 5 == 0 ? -value : value);
+    proto.add_packed_uint32(static_cast<uint32_t>(value));
+    proto.add_packed_uint64(static_cast<uint64_t>(value));
+    proto.add_packed_sint32(static_cast<int32_t>(i % 2 == 0 ? -value : value));
+    proto.add_packed_sint64(i % 2 == 0 ? -value : value);
+    proto.add_packed_bool(value % 3 != 0);
+  }
+}
+
+TEST(GeneratedMessageTctableLiteTest, PackedVarintBulkDecode) {
+  protobuf_unittest::TestPackedTypes proto;
+  FillPackedVarints(1000, proto);
+  const std::string serialized = proto.SerializeAsString();
+
+  protobuf_unittest::TestPackedTypes new_proto;
+  ASSERT_TRUE(new_proto.ParseFromString(serialized));
+  EXPECT_EQ(new_proto.SerializeAsString(), serialized);
+
+  // Each field is grown exactly once, to the number of values on the wire.
+  protobuf_unittest::TestPackedTypes empty_proto;
+  empty_proto.mutable_packed_int64()->Reserve(1000);
+  EXPECT_EQ(new_proto.packed_int64().Capacity(),
+            empty_proto.packed_int64().Capacity());
+}
+
+TEST(GeneratedMessageTctableLiteTest, PackedVarintBulkDecodeAcrossBuffers) {
+  protobuf_unittest::TestPackedTypes proto;
+  FillPackedVarints(1000, proto);
+  const std::string serialized = proto.SerializeAsString();
+
+  // Small, odd sized chunks make varints straddle the buffer boundaries.
+  for (int block_size : {1, 7, 17, 64}) {
+    io::ArrayInputStream input(serialized.data(),
+                               static_cast<int>(serialized.size()), block_size);
+    protobuf_unittest::TestPackedTypes new_proto;
+    ASSERT_TRUE(new_proto.ParseFromZeroCopyStream(&input)) << block_size;
+    EXPECT_EQ(new_proto.SerializeAsString(), serialized) << block_size;
+  }
+}
+
+TEST(GeneratedMessageTctableLiteTest, PackedVarintBulkDecodeMalformed) {
+  protobuf_unittest::TestPackedTypes proto;
+  for (int i = 0; i < 101; i++) proto.add_packed_uint64(~uint64_t{0});
+  std::string serialized = proto.SerializeAsString();
+  // Turn the last varint into an invalid 10 byte varint whose final byte still
+  // has the continuation bit set.
+  ASSERT_EQ(serialized.back(), '\x01');
+  serialized.back() = '\xFF';
+
+  protobuf_unittest::TestPackedTypes new_proto;
+  EXPECT_FALSE(new_proto.ParseFromString(serialized));
+  // The values decoded before the error are kept, and the slot reserved for
+  // the invalid one is dropped rather than left uninitialized.
+  ASSERT_EQ(new_proto.packed_uint64_size(), 100);
+  for (uint64_t value : new_proto.packed_uint64()) {
+    EXPECT_EQ(value, ~uint64_t{0});
+  }
+}
+
+TEST(GeneratedMessageTctableLiteTest, ParseSamplerCountsFields) {
+  protobuf_unittest::TestAllTypes proto;
+  proto.set_optional_int32(1);
+  proto.set_optional_string("foo");
+  proto.mutable_optional_nested_message()->set_bb(2);
+  for (int i = 0; i < 3; i++) proto.add_repeated_int32(i);
+  const std::string serialized = proto.SerializeAsString();
+
+  TcParseProfile profile;
+  SetTcParseSampler(&profile, 1);
+  protobuf_unittest::TestAllTypes new_proto;
+  EXPECT_TRUE(new_proto.ParseFromString(serialized));
+  SetTcParseSampler(nullptr, 1);
+
+  EXPECT_EQ(profile.ToString(),
+            "protobuf_unittest.TestAllTypes 1 1\n"
+            "protobuf_unittest.TestAllTypes 14 1\n"
+            "protobuf_unittest.TestAllTypes 18 1\n"
+            "protobuf_unittest.TestAllTypes 31 3\n"
+            "protobuf_unittest.TestAllTypes.NestedMessage 1 1\n");
+
+  // Parsing without a sampler does not record anything.
+  EXPECT_TRUE(new_proto.ParseFromString(serialized));
+  EXPECT_EQ(profile.ToString(),
+            "protobuf_unittest.TestAllTypes 1 1\n"
+            "protobuf_unittest.TestAllTypes 14 1\n"
+            "protobuf_unittest.TestAllTypes 18 1\n"
+            "protobuf_unittest.TestAllTypes 31 3\n"
+            "protobuf_unittest.TestAllTypes.NestedMessage 1 1\n");
+}
+
+TEST(GeneratedMessageTctableLiteTest, ParseSamplerPeriod) {
+  protobuf_unittest::TestAllTypes proto;
+  proto.set_optional_int32(1);
+  const std::string serialized = proto.SerializeAsString();
+
+  TcParseProfile profile;
+  SetTcParseSampler(&profile, 4);
+  for (int i = 0; i < 16; i++) {
+    protobuf_unittest::TestAllTypes new_proto;
+    EXPECT_TRUE(new_proto.ParseFromString(serialized));
+  }
+  SetTcParseSampler(nullptr, 1);
+
+  EXPECT_EQ(profile.ToString(), "protobuf_unittest.TestAllTypes 1 4\n");
+}
+
+// Parses `data` into `msg` and returns whether the parser left the required
+// fields to a separate IsInitialized() check.
+bool ParseNeedsInitializationCheck(MessageLite* msg, const std::string& data) {
+  const char* ptr;
+  ParseContext ctx(io::CodedInputStream::GetDefaultRecursionLimit(), false,
+                   &ptr, data);
+  ptr = msg->_InternalParse(ptr, &ctx);
+  EXPECT_TRUE(ptr != nullptr && ctx.EndedAtLimit());
+  return ctx.needs_initialization_check();
+}
+
+TEST(GeneratedMessageTctableLiteTest, ParseChecksRequiredFields) {
+  protobuf_unittest::TestNestedRequiredForeign proto;
+  proto.set_dummy(1);
+  protobuf_unittest::TestNestedRequiredForeign parsed;
+  EXPECT_FALSE(
+      ParseNeedsInitializationCheck(&parsed, proto.SerializeAsString()));
+
+  proto.mutable_child()->mutable_required_enum()->set_required_enum(
+      protobuf_unittest::FOREIGN_BAR);
+  parsed.Clear();
+  EXPECT_FALSE(
+      ParseNeedsInitializationCheck(&parsed, proto.SerializeAsString()));
+  EXPECT_TRUE(parsed.ParseFromString(proto.SerializeAsString()));
+
+  // The nested message is missing its required field.
+  proto.mutable_required_enum();
+  parsed.Clear();
+  EXPECT_TRUE(
+      ParseNeedsInitializationCheck(&parsed, proto.SerializeAsString()));
+  EXPECT_FALSE(parsed.ParseFromString(proto.SerializeAsString()));
+  EXPECT_TRUE(parsed.ParsePartialFromString(proto.SerializeAsString()));
+}
+
+TEST(GeneratedMessageTctableLiteTest, ParseLeavesSpreadRequiredFields) {
+  // TestRequired has required fields in two has-bits words, which the parser
+  // does not check.
+  protobuf_unittest::TestRequired proto;
+  proto.set_a(1);
+  proto.set_b(2);
+  proto.set_c(3);
+  protobuf_unittest::TestRequired parsed;
+  EXPECT_TRUE(
+      ParseNeedsInitializationCheck(&parsed, proto.SerializeAsString()));
+  EXPECT_TRUE(parsed.ParseFromString(proto.SerializeAsString()));
+
+  proto.clear_c();
+  EXPECT_FALSE(parsed.ParseFromString(proto.SerializeAsString()));
+}
+
+TEST(GeneratedMessageTctableLiteTest, MergeChecksExistingMessages) {
+  // Merging does not revisit what is already in the message, so it still
+  // needs IsInitialized().
+  protobuf_unittest::TestNestedRequiredForeign proto;
+  proto.mutable_required_enum();
+  protobuf_unittest::TestNestedRequiredForeign other;
+  other.set_dummy(1);
+  EXPECT_FALSE(proto.MergeFromString(other.SerializeAsString()));
+  EXPECT_TRUE(proto.ParseFromString(other.SerializeAsString()));
+}
+
 }  // namespace internal
 }  // namespace protobuf
 }  // namespace google
@@ -34,6 +34,7 @@
 
 #include "google/protobuf/generated_message_util.h"
 
+#include <algorithm>
 #include <atomic>
 #include <limits>
 #include <vector>
@@ -45,6 +46,7 @@
 #include "google/protobuf/message_lite.h"
 #include "google/protobuf/metadata_lite.h"
 #include "google/protobuf/repeated_field.h"
+#include "google/protobuf/thread_local_cache.h"
 #include "google/protobuf/wire_format_lite.h"
 
 // Must be included last
@@ -393,6 +395,8 @@ MessageLite* GetOwnedMessageInternal(Arena* message_arena,
                                      Arena* submessage_arena) {
   ABSL_DCHECK(Arena::InternalGetOwningArena(submessage) == submessage_arena);
   ABSL_DCHECK(message_arena != submessage_arena);
+  // A fused arena lives as long as the message's, so adopt the sub-message.
+  if (Arena::IsFused(message_arena, submessage_arena)) return submessage;
   ABSL_DCHECK_EQ(submessage_arena, nullptr);
   if (message_arena != nullptr && submessage_arena == nullptr) {
     message_arena->Own(submessage);
@@ -404,6 +408,79 @@ MessageLite* GetOwnedMessageInternal(Arena* message_arena,
   }
 }
 
+namespace {
+
+// A small per-thread cache of MapSorterCachedOrder, most recently used first.
+// The orders are released on thread exit.
+class MapSorterOrderCache {
+ public:
+  static MapSorterCachedOrder* Take(const void* map) {
+    Orders& orders = ThreadLocalCache<Orders>::Get();
+    for (size_t i = 0; i < orders.count; ++i) {
+      MapSorterCachedOrder* order = orders.orders[i];
+      if (order->map != map) continue;
+      std::copy(orders.orders + i + 1, orders.orders + orders.count,
+                orders.orders + i);
+      --orders.count;
+      return order;
+    }
+    auto* order = new MapSorterCachedOrder;
+    order->map = map;
+    return order;
+  }
+
+  static void Return(MapSorterCachedOrder* order) {
+    Orders* orders = ThreadLocalCache<Orders>::GetForInsert();
+    if (orders == nullptr || order->sorted.size() > kMaxCachedEntries) {
+      delete order;
+      return;
+    }
+    if (orders->count == kMaxOrders) delete orders->orders[--orders->count];
+    std::copy_backward(orders->orders, orders->orders + orders->count,
+                       orders->orders + orders->count + 1);
+    orders->orders[0] = order;
+    ++orders->count;
+  }
+
+ private:
+  static constexpr size_t kMaxOrders = 8;
+  // Larger maps are not kept, to bound the memory held by each thread.
+  static constexpr size_t kMaxCachedEntries = size_t{1} << 20;
+
+  struct Orders {
+    MapSorterCachedOrder* orders[kMaxOrders];
+    size_t count;
+
+    static void Clear(Orders& orders) {
+      while (orders.count > 0) delete orders.orders[--orders.count];
+    }
+  };
+};
+
+}  // namespace
+
+bool SerializedMessageEquals(const MessageLite& a, const MessageLite& b) {
+  auto serialize = [](const MessageLite& msg) {
+    std::string out;
+    {
+      io::StringOutputStream stream(&out);
+      io::CodedOutputStream coded(&stream);
+      coded.SetSerializationDeterministic(true);
+      msg.SerializePartialToCodedStream(&coded);
+    }
+    return out;
+  };
+  return serialize(a) == serialize(b);
+}
+
+MapSorterCachedOrder* TakeMapSorterCachedOrder(const void* map) {
+  return MapSorterOrderCache::Take(map);
+}
+
+void ReturnMapSorterCachedOrder(MapSorterCachedOrder* order) {
+  MapSorterOrderCache::Return(order);
+}
+
 }  // namespace internal
 }  // namespace protobuf
 }  // namespace google
@@ -45,6 +45,7 @@
 #include <climits>
 #include <cstddef>
 #include <memory>
+#include <new>
 #include <string>
 #include <type_traits>
 #include <utility>
@@ -60,6 +61,7 @@
 #include "google/protobuf/message_lite.h"
 #include "google/protobuf/port.h"
 #include "google/protobuf/repeated_field.h"
+#include "google/protobuf/thread_local_cache.h"
 #include "google/protobuf/wire_format_lite.h"
 
 
@@ -203,6 +205,169 @@ inline void OnShutdownDestroyString(const std::string* ptr) {
   OnShutdownRun(DestroyString, ptr);
 }
 
+// Returns `total_size`, the result of SpaceUsedLong() for `message`.  With
+// PROTOBUF_FUZZ_MESSAGE_SPACE_USED_LONG the size is scaled by +/- 50% so that
+// tests cannot depend on exact values.
+inline size_t SpaceUsedLongResult(size_t total_size, const void* message) {
+#ifndef PROTOBUF_FUZZ_MESSAGE_SPACE_USED_LONG
+  (void)message;
+  return total_size;
+#else
+  // Use both `message` and `dummy` to generate the seed so that the scale
+  // factor is both per-object and non-predictable, but consistent across
+  // multiple calls in the same binary.
+  static bool dummy;
+  uintptr_t seed = reinterpret_cast<uintptr_t>(&dummy) ^
+                   reinterpret_cast<uintptr_t>(message);
+  double scale = (static_cast<double>(seed % 10000) / 10000) + 0.5;
+  return total_size * scale;
+#endif
+}
+
+// Helpers for generated Equals() ======================================
+
+// Returns whether the deterministic serializations of `a` and `b` are equal.
+// Used for message types that were generated without Equals().
+PROTOBUF_EXPORT bool SerializedMessageEquals(const MessageLite& a,
+                                             const MessageLite& b);
+
+// Whether an Equals(const T&, const T&) overload is found for T by ADL, which
+// is the case for messages generated with the `equality` option.
+template <typename T, typename = void>
+struct HasGeneratedEquals : std::false_type {};
+template <typename T>
+struct HasGeneratedEquals<T, decltype(static_cast<void>(Equals(
+                                 std::declval<const T&>(),
+                                 std::declval<const T&>())))>
+    : std::true_type {};
+
+template <typename T>
+bool MessageEquals(const T& a, const T& b, std::true_type) {
+  return Equals(a, b);
+}
+template <typename T>
+bool MessageEquals(const T& a, const T& b, std::false_type) {
+  return SerializedMessageEquals(a, b);
+}
+template <typename T>
+bool MessageEquals(const T& a, const T& b) {
+  return MessageEquals(a, b, HasGeneratedEquals<T>{});
+}
+
+template <typename T>
+bool ElementEquals(const T& a, const T& b, std::true_type /*is_message*/) {
+  return MessageEquals(a, b);
+}
+template <typename T>
+bool ElementEquals(const T& a, const T& b, std::false_type /*is_message*/) {
+  return a == b;
+}
+template <typename T>
+bool ElementEquals(const T& a, const T& b) {
+  return ElementEquals(a, b, std::is_base_of<MessageLite, T>{});
+}
+
+// std::equal over the raw arrays lets the standard library use memcmp for
+// integral elements.
+template <typename T>
+bool RepeatedEquals(const RepeatedField<T>& a, const RepeatedField<T>& b) {
+  return a.size() == b.size() &&
+         std::equal(a.data(), a.data() + a.size(), b.data());
+}
+template <typename T>
+bool RepeatedEquals(const RepeatedPtrField<T>& a,
+                    const RepeatedPtrField<T>& b) {
+  if (a.size() != b.size()) return false;
+  for (int i = 0; i < a.size(); ++i) {
+    if (!ElementEquals(a.Get(i), b.Get(i))) return false;
+  }
+  return true;
+}
+
+// Maps compare equal when they have the same keys with equal values,
+// regardless of iteration order.
+template <typename MapT>
+bool MapEquals(const MapT& a, const MapT& b) {
+  if (a.size() != b.size()) return false;
+  for (const auto& entry : a) {
+    auto it = b.find(entry.first);
+    if (it == b.end() || !ElementEquals(entry.second, it->second)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Unknown fields of lite messages are kept in wire format.
+inline bool UnknownFieldsEquals(const std::string& a, const std::string& b) {
+  return a == b;
+}
+
+// A bounded, per-thread LIFO cache of the storage of deleted heap-allocated
+// messages of type T, used by the operator new and delete that the
+// `heap_free_list` option of the C++ generator adds to message classes.
+// Storage freed on one thread may be reused on another, and is released on
+// thread exit. Under ASan nothing is cached, so that use-after-free is still
+// detected.
+template <typename T>
+class MessageFreeList {
+ public:
+  static void* Allocate(size_t size) {
+    if (void* p = TryReuse(size)) return p;
+    return ::operator new(size);
+  }
+
+  // Backs `new (std::nothrow) T`: returns nullptr if allocation fails.
+  static void* Allocate(size_t size, const std::nothrow_t& tag) noexcept {
+    if (void* p = TryReuse(size)) return p;
+    return ::operator new(size, tag);
+  }
+
+  static void Deallocate(void* ptr, size_t size, size_t max_cached) {
+#ifndef PROTOBUF_ASAN
+    if (size == sizeof(T)) {
+      FreeList* list = ThreadLocalCache<FreeList>::GetForInsert();
+      if (list != nullptr && list->count < max_cached) {
+        list->head = new (ptr) Node{list->head};
+        ++list->count;
+        return;
+      }
+    }
+#endif  // !PROTOBUF_ASAN
+    SizedDelete(ptr, size);
+  }
+
+ private:
+  struct Node {
+    Node* next;
+  };
+
+  struct FreeList {
+    Node* head;
+    size_t count;
+
+    static void Clear(FreeList& list) {
+      while (list.head != nullptr) {
+        Node* node = list.head;
+        list.head = node->next;
+        SizedDelete(node, sizeof(T));
+      }
+      list.count = 0;
+    }
+  };
+
+  static void* TryReuse(size_t size) {
+    FreeList& list = ThreadLocalCache<FreeList>::Get();
+    if (PROTOBUF_PREDICT_TRUE(size == sizeof(T) && list.head != nullptr)) {
+      Node* node = list.head;
+      list.head = node->next;
+      --list.count;
+      return node;
+    }
+    return nullptr;
+  }
+};
+
 // Helpers for deterministic serialization =============================
 
 // Iterator base for MapSorterFlat and MapSorterPtr.
@@ -291,8 +456,30 @@ struct MapSorterPtrLessThan {
   }
 };
 
+// The sort order of a map's entries, kept from an earlier deterministic
+// serialization of it. See MapSorterPtr.
+struct MapSorterCachedOrder {
+  const void* map = nullptr;
+  // Pointers to the entries, in iteration order and in key order.
+  std::vector<const void*> iteration_order;
+  std::vector<const void*> sorted;
+};
+
+// Removes the order cached for `map` from this thread's cache and returns it.
+// If there is none, returns a new, empty order for `map`.
+PROTOBUF_EXPORT MapSorterCachedOrder* TakeMapSorterCachedOrder(const void* map);
+// Puts `order` back into this thread's cache, which takes ownership of it. The
+// cache is small and may release this or another order.
+PROTOBUF_EXPORT void ReturnMapSorterCachedOrder(MapSorterCachedOrder* order);
+
 // MapSorterPtr stores and sorts pointers to map entries. This type is used for
 // maps with keys that are strings.
+//
+// Sorting string keys is comparatively expensive, so for larger maps the sort
+// order is kept in a per-thread cache of recently serialized maps. Serializing
+// one of those again only checks that it still holds the same entries, and
+// that they are still in key order, which is O(n) instead of O(n log n) and
+// does not allocate.
 template <typename MapT>
 class MapSorterPtr {
  public:
@@ -318,25 +505,73 @@ class MapSorterPtr {
     reference operator*() const { return *this->operator->(); }
   };
 
-  explicit MapSorterPtr(const MapT& m)
-      : size_(m.size()), items_(size_ ? new storage_type[size_] : nullptr) {
+  explicit MapSorterPtr(const MapT& m) : size_(m.size()) {
+    static_assert(PROTOBUF_FIELD_OFFSET(typename MapT::value_type, first) == 0,
+                  "Must hold for MapSorterPtrLessThan to work.");
     if (!size_) return;
+    if (size_ >= kMinCachedSize) {
+      cached_ = TakeMapSorterCachedOrder(&m);
+      if (!IsStillSorted(m, *cached_)) Sort(m, *cached_);
+      data_ = cached_->sorted.data();
+      return;
+    }
+    items_.reset(new storage_type[size_]);
     storage_type* it = &items_[0];
     for (const auto& entry : m) {
       *it++ = &entry;
     }
-    static_assert(PROTOBUF_FIELD_OFFSET(typename MapT::value_type, first) == 0,
-                  "Must hold for MapSorterPtrLessThan to work.");
     std::sort(&items_[0], &items_[size_],
               MapSorterPtrLessThan<typename MapT::key_type>{});
+    data_ = items_.get();
+  }
+  ~MapSorterPtr() {
+    if (cached_ != nullptr) ReturnMapSorterCachedOrder(cached_);
   }
+  MapSorterPtr(const MapSorterPtr&) = delete;
+  MapSorterPtr& operator=(const MapSorterPtr&) = delete;
+
   size_t size() const { return size_; }
-  const_iterator begin() const { return {items_.get()}; }
-  const_iterator end() const { return {items_.get() + size_}; }
+  const_iterator begin() const { return {data_}; }
+  const_iterator end() const { return {data_ + size_}; }
 
  private:
+  // Smaller maps are sorted on every call without going through the cache.
+  static constexpr size_t kMinCachedSize = 64;
+
+  // Returns whether `order` is still a valid sort order for `m`. The entries
+  // are compared by address, so nothing is dereferenced unless they are all
+  // still in the map. An entry that was erased may have been replaced by a new
+  // one at the same address and position, hence the keys are checked as well.
+  bool IsStillSorted(const MapT& m, const MapSorterCachedOrder& order) const {
+    if (order.iteration_order.size() != size_) return false;
+    auto it = order.iteration_order.begin();
+    for (const auto& entry : m) {
+      if (*it++ != &entry) return false;
+    }
+    MapSorterPtrLessThan<typename MapT::key_type> less;
+    for (size_t i = 1; i < size_; ++i) {
+      if (!less(order.sorted[i - 1], order.sorted[i])) return false;
+    }
+    return true;
+  }
+
+  void Sort(const MapT& m, MapSorterCachedOrder& order) const {
+    order.iteration_order.clear();
+    order.iteration_order.reserve(size_);
+    for (const auto& entry : m) {
+      order.iteration_order.push_back(&entry);
+    }
+    order.sorted = order.iteration_order;
+    std::sort(order.sorted.begin(), order.sorted.end(),
+              MapSorterPtrLessThan<typename MapT::key_type>{});
+  }
+
   size_t size_;
+  // Owns the storage for maps that are not cached.
   std::unique_ptr<storage_type[]> items_;
+  // Borrowed from the per-thread cache until destruction.
+  MapSorterCachedOrder* cached_ = nullptr;
+  storage_type* data_ = nullptr;
 };
 
 }  // namespace internal
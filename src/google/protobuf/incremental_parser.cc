@@ -0,0 +1,199 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "google/protobuf/incremental_parser.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "absl/strings/string_view.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/message_lite.h"
+#include "google/protobuf/wire_format_lite.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace {
+
+using internal::WireFormatLite;
+
+enum class ScanResult { kComplete, kIncomplete, kMalformed };
+
+ScanResult ScanVarint(const char*& p, const char* end, uint64_t* value) {
+  uint64_t result = 0;
+  for (int i = 0; i < 10; ++i) {
+    if (p == end) return ScanResult::kIncomplete;
+    uint8_t byte = static_cast<uint8_t>(*p++);
+    result |= static_cast<uint64_t>(byte & 0x7f) << (7 * i);
+    if (byte < 0x80) {
+      *value = result;
+      return ScanResult::kComplete;
+    }
+  }
+  return ScanResult::kMalformed;
+}
+
+ScanResult ScanBytes(const char*& p, const char* end, uint64_t size) {
+  if (static_cast<uint64_t>(end - p) < size) return ScanResult::kIncomplete;
+  p += size;
+  return ScanResult::kComplete;
+}
+
+// Finds the end of the field that starts at `p` without parsing it. On
+// success, advances `p` past the field. For length-delimited fields,
+// `field_size` is set to the total size of the field as soon as it is known,
+// even if the field is incomplete.
+ScanResult ScanField(const char*& p, const char* end, int depth,
+                     size_t* field_size) {
+  const char* start = p;
+  uint64_t tag;
+  ScanResult result = ScanVarint(p, end, &tag);
+  if (result != ScanResult::kComplete) return result;
+  if (tag > std::numeric_limits<uint32_t>::max() ||
+      WireFormatLite::GetTagFieldNumber(static_cast<uint32_t>(tag)) == 0) {
+    return ScanResult::kMalformed;
+  }
+  uint64_t value;
+  switch (WireFormatLite::GetTagWireType(static_cast<uint32_t>(tag))) {
+    case WireFormatLite::WIRETYPE_VARINT:
+      return ScanVarint(p, end, &value);
+    case WireFormatLite::WIRETYPE_FIXED64:
+      return ScanBytes(p, end, 8);
+    case WireFormatLite::WIRETYPE_FIXED32:
+      return ScanBytes(p, end, 4);
+    case WireFormatLite::WIRETYPE_LENGTH_DELIMITED:
+      result = ScanVarint(p, end, &value);
+      if (result != ScanResult::kComplete) return result;
+      if (value > static_cast<uint64_t>(std::numeric_limits<int>::max())) {
+        return ScanResult::kMalformed;
+      }
+      *field_size = static_cast<size_t>(p - start) + value;
+      return ScanBytes(p, end, value);
+    case WireFormatLite::WIRETYPE_START_GROUP:
+      if (depth >= io::CodedInputStream::GetDefaultRecursionLimit()) {
+        return ScanResult::kMalformed;
+      }
+      while (true) {
+        const char* next = p;
+        uint64_t inner_tag;
+        result = ScanVarint(next, end, &inner_tag);
+        if (result != ScanResult::kComplete) return result;
+        if ((inner_tag & 7) == WireFormatLite::WIRETYPE_END_GROUP) {
+          if ((inner_tag >> 3) != (tag >> 3)) return ScanResult::kMalformed;
+          p = next;
+          return ScanResult::kComplete;
+        }
+        size_t unused;
+        result = ScanField(p, end, depth + 1, &unused);
+        if (result != ScanResult::kComplete) return result;
+      }
+    default:
+      // Unmatched end group, or an invalid wire type.
+      return ScanResult::kMalformed;
+  }
+}
+
+}  // namespace
+
+ptrdiff_t IncrementalParser::MergeCompleteFields(absl::string_view data) {
+  const char* p = data.data();
+  const char* const end = p + data.size();
+  const char* complete = p;
+  pending_size_ = 0;
+  while (p != end) {
+    size_t field_size = 0;
+    ScanResult result = ScanField(p, end, 0, &field_size);
+    if (result == ScanResult::kMalformed) return -1;
+    if (result == ScanResult::kIncomplete) {
+      pending_size_ = field_size;
+      break;
+    }
+    complete = p;
+  }
+  if (complete == data.data()) return 0;
+  if (!message_->ParseFrom<MessageLite::kMergePartial>(
+          data.substr(0, complete - data.data()))) {
+    return -1;
+  }
+  return complete - data.data();
+}
+
+bool IncrementalParser::Feed(absl::string_view data) {
+  if (failed_) return false;
+  if (!buffer_.empty()) {
+    if (pending_size_ == 0) {
+      // The size of the partial field is not known yet (e.g. its tag or
+      // length was split, or it is a group), so rescan it with the new data.
+      buffer_.append(data.data(), data.size());
+      ptrdiff_t consumed = MergeCompleteFields(buffer_);
+      if (consumed < 0) {
+        failed_ = true;
+        return false;
+      }
+      buffer_.erase(0, static_cast<size_t>(consumed));
+      return true;
+    }
+    // Wait until the partial field is complete, then parse it once.
+    size_t n = std::min(pending_size_ - buffer_.size(), data.size());
+    buffer_.append(data.data(), n);
+    data.remove_prefix(n);
+    if (buffer_.size() < pending_size_) return true;
+    if (MergeCompleteFields(buffer_) !=
+        static_cast<ptrdiff_t>(buffer_.size())) {
+      failed_ = true;
+      return false;
+    }
+    buffer_.clear();
+  }
+  // Parse complete fields directly from `data` and only copy the tail.
+  ptrdiff_t consumed = MergeCompleteFields(data);
+  if (consumed < 0) {
+    failed_ = true;
+    return false;
+  }
+  data.remove_prefix(static_cast<size_t>(consumed));
+  buffer_.assign(data.data(), data.size());
+  return true;
+}
+
+bool IncrementalParser::Finish() {
+  return !failed_ && buffer_.empty() && message_->IsInitialized();
+}
+
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
@@ -0,0 +1,115 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// IncrementalParser parses a message from data that arrives in chunks, e.g.
+// from a non-blocking socket, without blocking for the rest of the input and
+// without a thread per message.
+//
+// Each call to Feed() merges every top-level field that is complete into the
+// message, and keeps only the trailing partial field (if any) buffered. A
+// partial length-delimited field is held until its payload is complete and is
+// then parsed once; only a split tag or length, or a partial group, is scanned
+// again when more data arrives. This relies on the wire format property that
+// parsing a concatenation of fields is the same as merging them one by one.
+//
+// Example:
+//
+//   MyMessage message;
+//   IncrementalParser parser(&message);
+//   while (/* data available */) {
+//     if (!parser.Feed(chunk)) { /* malformed input */ }
+//   }
+//   if (!parser.Finish()) { /* truncated or uninitialized */ }
+
+#ifndef GOOGLE_PROTOBUF_INCREMENTAL_PARSER_H__
+#define GOOGLE_PROTOBUF_INCREMENTAL_PARSER_H__
+
+#include <cstddef>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "google/protobuf/message_lite.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+#ifdef SWIG
+#error "You cannot SWIG proto headers"
+#endif
+
+namespace google {
+namespace protobuf {
+
+class PROTOBUF_EXPORT IncrementalParser {
+ public:
+  // `message` must outlive the parser. Fields are merged into it, so it is
+  // not cleared first.
+  explicit IncrementalParser(MessageLite* message) : message_(message) {}
+
+  IncrementalParser(const IncrementalParser&) = delete;
+  IncrementalParser& operator=(const IncrementalParser&) = delete;
+
+  // Consumes the next chunk of input. Returns false if the input is
+  // malformed, after which the parser must not be used anymore. The message
+  // may then hold the fields that were parsed before the error.
+  bool Feed(absl::string_view data);
+
+  // Signals the end of the input. Returns true if the input ended on a field
+  // boundary and the message has all its required fields.
+  bool Finish();
+
+  // Returns true if a partially received field is buffered, i.e. the input
+  // does not currently end on a field boundary.
+  bool NeedsMoreData() const { return !buffer_.empty(); }
+
+  // Number of bytes of the partial field held by the parser.
+  size_t buffered_bytes() const { return buffer_.size(); }
+
+ private:
+  // Merges the complete fields at the start of `data` into the message and
+  // returns how many bytes they span, or -1 on error. If the trailing partial
+  // field reveals its full size, it is stored in `pending_size_`.
+  ptrdiff_t MergeCompleteFields(absl::string_view data);
+
+  MessageLite* message_;
+  // The trailing partial field.
+  std::string buffer_;
+  // The total size of the field in `buffer_` if it is known, or 0.
+  size_t pending_size_ = 0;
+  bool failed_ = false;
+};
+
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_INCREMENTAL_PARSER_H__
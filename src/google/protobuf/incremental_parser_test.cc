@@ -0,0 +1,139 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "google/protobuf/incremental_parser.h"
+
+#include <string>
+
+#include <gtest/gtest.h>
+#include "absl/strings/string_view.h"
+#include "google/protobuf/test_util.h"
+#include "google/protobuf/unittest.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace {
+
+using ::protobuf_unittest::TestAllTypes;
+using ::protobuf_unittest::TestRequired;
+
+void FeedInChunks(IncrementalParser& parser, absl::string_view data,
+                  size_t chunk_size) {
+  while (!data.empty()) {
+    absl::string_view chunk = data.substr(0, chunk_size);
+    ASSERT_TRUE(parser.Feed(chunk));
+    data.remove_prefix(chunk.size());
+  }
+}
+
+class IncrementalParserChunkTest : public ::testing::TestWithParam<size_t> {};
+
+TEST_P(IncrementalParserChunkTest, ParsesAllFields) {
+  TestAllTypes source;
+  TestUtil::SetAllFields(&source);
+  const std::string data = source.SerializeAsString();
+
+  TestAllTypes message;
+  IncrementalParser parser(&message);
+  FeedInChunks(parser, data, GetParam());
+  EXPECT_FALSE(parser.NeedsMoreData());
+  EXPECT_TRUE(parser.Finish());
+  TestUtil::ExpectAllFieldsSet(message);
+}
+
+INSTANTIATE_TEST_SUITE_P(ChunkSizes, IncrementalParserChunkTest,
+                         ::testing::Values(1, 2, 7, 64, 1 << 20));
+
+TEST(IncrementalParserTest, BuffersOnlyPartialField) {
+  TestAllTypes source;
+  source.set_optional_int32(1);
+  source.set_optional_bytes(std::string(100, 'x'));
+  const std::string data = source.SerializeAsString();
+
+  TestAllTypes message;
+  IncrementalParser parser(&message);
+  // The int32 field and the header of the bytes field.
+  ASSERT_TRUE(parser.Feed(absl::string_view(data).substr(0, 10)));
+  EXPECT_EQ(message.optional_int32(), 1);
+  EXPECT_FALSE(message.has_optional_bytes());
+  EXPECT_TRUE(parser.NeedsMoreData());
+  EXPECT_EQ(parser.buffered_bytes(), 8);
+
+  ASSERT_TRUE(parser.Feed(absl::string_view(data).substr(10)));
+  EXPECT_FALSE(parser.NeedsMoreData());
+  EXPECT_EQ(message.optional_bytes(), source.optional_bytes());
+  EXPECT_TRUE(parser.Finish());
+}
+
+TEST(IncrementalParserTest, TruncatedInput) {
+  TestAllTypes source;
+  TestUtil::SetAllFields(&source);
+  const std::string data = source.SerializeAsString();
+
+  TestAllTypes message;
+  IncrementalParser parser(&message);
+  ASSERT_TRUE(parser.Feed(absl::string_view(data).substr(0, data.size() - 1)));
+  EXPECT_TRUE(parser.NeedsMoreData());
+  EXPECT_FALSE(parser.Finish());
+}
+
+TEST(IncrementalParserTest, MalformedInput) {
+  TestAllTypes message;
+  IncrementalParser parser(&message);
+  // Field 1 with invalid wire type 7.
+  EXPECT_FALSE(parser.Feed("\x0f"));
+  EXPECT_FALSE(parser.Feed("\x08\x01"));
+  EXPECT_FALSE(parser.Finish());
+}
+
+TEST(IncrementalParserTest, InvalidFieldContents) {
+  TestAllTypes message;
+  IncrementalParser parser(&message);
+  // optional_nested_message whose payload is an invalid tag.
+  ASSERT_TRUE(parser.Feed("\x92\x01"));
+  EXPECT_FALSE(parser.Feed(absl::string_view("\x01\x00", 2)));
+}
+
+TEST(IncrementalParserTest, MissingRequiredFields) {
+  TestRequired source;
+  source.set_a(1);
+  const std::string data = source.SerializePartialAsString();
+
+  TestRequired message;
+  IncrementalParser parser(&message);
+  ASSERT_TRUE(parser.Feed(data));
+  EXPECT_FALSE(parser.Finish());
+  EXPECT_EQ(message.a(), 1);
+}
+
+}  // namespace
+}  // namespace protobuf
+}  // namespace google
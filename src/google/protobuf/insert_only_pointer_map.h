@@ -0,0 +1,154 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// This header defines an insert-only map from pointers to pointers whose
+// lookups never take a lock. It backs the fast path of the message factories'
+// GetPrototype(), which is called on hot paths from many threads at once but
+// only inserts the first time each type is seen.
+
+#ifndef GOOGLE_PROTOBUF_INSERT_ONLY_POINTER_MAP_H__
+#define GOOGLE_PROTOBUF_INSERT_ONLY_POINTER_MAP_H__
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#include "absl/hash/hash.h"
+#include "absl/log/absl_check.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+
+// Maps `const K*` to `V*`. Find() is wait-free and may run concurrently with
+// other Find() calls and with Insert(). Insert() calls must be serialized by
+// the caller, typically with the mutex that guards the slow path that creates
+// the values. Entries are never removed.
+//
+// The table is open-addressed with linear probing and is kept at most half
+// full. Growing publishes a new table; the old ones are kept alive until the
+// map is destroyed because a concurrent Find() may still be probing them.
+// Since the capacity doubles each time, they never add up to more than the
+// current table.
+template <typename K, typename V>
+class InsertOnlyPointerMap {
+ public:
+  InsertOnlyPointerMap() = default;
+  InsertOnlyPointerMap(const InsertOnlyPointerMap&) = delete;
+  InsertOnlyPointerMap& operator=(const InsertOnlyPointerMap&) = delete;
+  ~InsertOnlyPointerMap() { delete table_.load(std::memory_order_relaxed); }
+
+  // Returns the value inserted for `key`, or nullptr if there is none yet.
+  V* Find(const K* key) const {
+    const Table* table = table_.load(std::memory_order_acquire);
+    if (table == nullptr) return nullptr;
+    for (size_t i = Hash(key) & table->mask;; i = (i + 1) & table->mask) {
+      const Slot& slot = table->slots[i];
+      const K* k = slot.key.load(std::memory_order_acquire);
+      // `value` was written before `key` was released, so it is visible.
+      if (k == key) return slot.value;
+      if (k == nullptr) return nullptr;
+    }
+  }
+
+  // Inserts `key`, which must not be present yet. Neither pointer may be null.
+  void Insert(const K* key, V* value) {
+    ABSL_DCHECK(key != nullptr);
+    ABSL_DCHECK(value != nullptr);
+    Table* table = table_.load(std::memory_order_relaxed);
+    if (table == nullptr || (size_ + 1) * 2 > table->mask + 1) {
+      table = Grow(table);
+    }
+    InsertInto(*table, key, value);
+    ++size_;
+  }
+
+  size_t size() const { return size_; }
+
+ private:
+  struct Slot {
+    std::atomic<const K*> key{nullptr};
+    V* value = nullptr;
+  };
+  struct Table {
+    explicit Table(size_t capacity)
+        : mask(capacity - 1), slots(new Slot[capacity]) {}
+
+    size_t mask;
+    std::unique_ptr<Slot[]> slots;
+    std::unique_ptr<Table> previous;
+  };
+
+  static constexpr size_t kMinCapacity = 16;
+
+  static size_t Hash(const K* key) { return absl::HashOf(key); }
+
+  static void InsertInto(Table& table, const K* key, V* value) {
+    for (size_t i = Hash(key) & table.mask;; i = (i + 1) & table.mask) {
+      Slot& slot = table.slots[i];
+      const K* k = slot.key.load(std::memory_order_relaxed);
+      ABSL_DCHECK(k != key);
+      if (k == nullptr) {
+        slot.value = value;
+        slot.key.store(key, std::memory_order_release);
+        return;
+      }
+    }
+  }
+
+  Table* Grow(Table* old) {
+    auto* table =
+        new Table(old == nullptr ? kMinCapacity : (old->mask + 1) * 2);
+    if (old != nullptr) {
+      for (size_t i = 0; i <= old->mask; ++i) {
+        const Slot& slot = old->slots[i];
+        const K* key = slot.key.load(std::memory_order_relaxed);
+        if (key != nullptr) InsertInto(*table, key, slot.value);
+      }
+      table->previous.reset(old);
+    }
+    table_.store(table, std::memory_order_release);
+    return table;
+  }
+
+  std::atomic<Table*> table_{nullptr};
+  size_t size_ = 0;
+};
+
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_INSERT_ONLY_POINTER_MAP_H__
@@ -0,0 +1,175 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file defines ChunkedInputStream, a ZeroCopyInputStream over a concrete
+// chunk source whose chunk iteration is inlined, and which coalesces small
+// chunks so that the parser does not pay a buffer switch for each of them.
+
+#ifndef GOOGLE_PROTOBUF_IO_CHUNKED_INPUT_STREAM_H__
+#define GOOGLE_PROTOBUF_IO_CHUNKED_INPUT_STREAM_H__
+
+#include <cstdint>
+#include <cstring>
+
+#include "absl/log/absl_check.h"
+#include "google/protobuf/io/zero_copy_stream.h"
+#include "google/protobuf/port.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace io {
+
+// A ZeroCopyInputStream that reads the chunks of a `Source`.
+//
+// `Source` is any type with a non-virtual (or `final`) member
+//
+//   bool Next(const void** data, int* size);
+//
+// with the semantics of ZeroCopyInputStream::Next(): it returns false at the
+// end of the input, and the returned chunk stays valid until the next call.
+// Network ring buffers, arrays of iovecs and fragmented cords (through
+// io::CordInputStream) all fit this shape. Because `Source` is a template
+// parameter, its Next() is called directly and can be inlined.
+//
+// The parser copies the last 16 bytes of every chunk it reads into a patch
+// buffer and switches buffers in between, which dominates for tiny chunks.
+// Consecutive chunks shorter than kMinChunkSize bytes are therefore copied
+// together into an internal buffer of kBufferSize bytes and handed out as one
+// chunk; larger chunks are handed out as they are, without copying.
+//
+// MessageLite::ParseFromChunks() parses a message from such a source.
+template <typename Source>
+class ChunkedInputStream final : public ZeroCopyInputStream {
+ public:
+  static constexpr int kMinChunkSize = 64;
+  static constexpr int kBufferSize = 1024;
+
+  // `source` must outlive this stream.
+  explicit ChunkedInputStream(Source* source) : source_(source) {}
+  ChunkedInputStream(const ChunkedInputStream&) = delete;
+  ChunkedInputStream& operator=(const ChunkedInputStream&) = delete;
+
+  // implements ZeroCopyInputStream ----------------------------------
+  bool Next(const void** data, int* size) override {
+    if (backed_up_ > 0) {
+      return Return(last_ + last_size_ - backed_up_, backed_up_, data, size);
+    }
+    const char* chunk;
+    int chunk_size;
+    if (!NextChunk(&chunk, &chunk_size)) return false;
+    if (chunk_size >= kMinChunkSize) {
+      return Return(chunk, chunk_size, data, size);
+    }
+    int buffered = 0;
+    for (;;) {
+      std::memcpy(buffer_ + buffered, chunk, chunk_size);
+      buffered += chunk_size;
+      if (!NextChunk(&chunk, &chunk_size)) break;
+      if (chunk_size >= kMinChunkSize || buffered + chunk_size > kBufferSize) {
+        // Hand it out on the next call; `source_` keeps it valid until then.
+        pending_ = chunk;
+        pending_size_ = chunk_size;
+        break;
+      }
+    }
+    return Return(buffer_, buffered, data, size);
+  }
+
+  void BackUp(int count) override {
+    ABSL_DCHECK_EQ(backed_up_, 0) << "BackUp() called twice";
+    ABSL_DCHECK_LE(count, last_size_);
+    backed_up_ = count;
+    byte_count_ -= count;
+  }
+
+  bool Skip(int count) override {
+    const void* data;
+    int size;
+    while (count > 0) {
+      if (!Next(&data, &size)) return false;
+      if (size > count) {
+        BackUp(size - count);
+        return true;
+      }
+      count -= size;
+    }
+    return true;
+  }
+
+  int64_t ByteCount() const override { return byte_count_; }
+
+ private:
+  bool NextChunk(const char** chunk, int* size) {
+    if (pending_ != nullptr) {
+      *chunk = pending_;
+      *size = pending_size_;
+      pending_ = nullptr;
+      return true;
+    }
+    const void* data;
+    if (!source_->Next(&data, size)) return false;
+    *chunk = static_cast<const char*>(data);
+    return true;
+  }
+
+  bool Return(const char* chunk, int chunk_size, const void** data,
+              int* size) {
+    last_ = chunk;
+    last_size_ = chunk_size;
+    backed_up_ = 0;
+    byte_count_ += chunk_size;
+    *data = chunk;
+    *size = chunk_size;
+    return true;
+  }
+
+  Source* const source_;
+  // A chunk read from `source_` but not handed out yet.
+  const char* pending_ = nullptr;
+  int pending_size_ = 0;
+  // The chunk handed out last, of which the last `backed_up_` bytes were
+  // returned by BackUp().
+  const char* last_ = nullptr;
+  int last_size_ = 0;
+  int backed_up_ = 0;
+  int64_t byte_count_ = 0;
+  char buffer_[kBufferSize];
+};
+
+}  // namespace io
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_IO_CHUNKED_INPUT_STREAM_H__
@@ -120,6 +120,10 @@
 #include <type_traits>
 #include <utility>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #if defined(_MSC_VER) && _MSC_VER >= 1300 && !defined(__INTEL_COMPILER)
 // If MSVC has "/RTCc" set, it will complain about truncating casts at
 // runtime.  This file contains some intentional truncating casts.
@@ -766,7 +770,8 @@ class PROTOBUF_EXPORT EpsCopyOutputStream {
   template <typename T>
   PROTOBUF_ALWAYS_INLINE uint8_t* WriteSInt32Packed(int num, const T& r,
                                                     int size, uint8_t* ptr) {
-    return WriteVarintPacked(num, r, size, ptr, ZigZagEncode32);
+    return WriteVarintPacked</*kZigZag=*/true>(num, r, size, ptr,
+                                               ZigZagEncode32);
   }
   template <typename T>
   PROTOBUF_ALWAYS_INLINE uint8_t* WriteInt64Packed(int num, const T& r,
@@ -781,7 +786,8 @@ class PROTOBUF_EXPORT EpsCopyOutputStream {
   template <typename T>
   PROTOBUF_ALWAYS_INLINE uint8_t* WriteSInt64Packed(int num, const T& r,
                                                     int size, uint8_t* ptr) {
-    return WriteVarintPacked(num, r, size, ptr, ZigZagEncode64);
+    return WriteVarintPacked</*kZigZag=*/true>(num, r, size, ptr,
+                                               ZigZagEncode64);
   }
   template <typename T>
   PROTOBUF_ALWAYS_INLINE uint8_t* WriteEnumPacked(int num, const T& r, int size,
@@ -885,7 +891,7 @@ class PROTOBUF_EXPORT EpsCopyOutputStream {
   uint8_t* WriteStringOutline(uint32_t num, absl::string_view s, uint8_t* ptr);
   uint8_t* WriteCordOutline(const absl::Cord& c, uint8_t* ptr);
 
-  template <typename T, typename E>
+  template <bool kZigZag = false, typename T, typename E>
   PROTOBUF_ALWAYS_INLINE uint8_t* WriteVarintPacked(int num, const T& r,
                                                     int size, uint8_t* ptr,
                                                     const E& encode) {
@@ -893,6 +899,19 @@ class PROTOBUF_EXPORT EpsCopyOutputStream {
     ptr = WriteLengthDelim(num, size, ptr);
     auto it = r.data();
     auto end = it + r.size();
+    if (size == r.size()) {
+      // Every varint is at least one byte, so every element encodes to
+      // exactly one byte. This is common for small enums and counters.
+      for (; end - it >= kSlopBytes; it += kSlopBytes) {
+        ptr = EnsureSpace(ptr);
+        ptr = UnsafeWriteOneByteVarints<kZigZag>(it, ptr, encode);
+      }
+      for (; it < end; ++it) {
+        ptr = EnsureSpace(ptr);
+        *ptr++ = static_cast<uint8_t>(encode(*it));
+      }
+      return ptr;
+    }
     do {
       ptr = EnsureSpace(ptr);
       ptr = UnsafeVarint(encode(*it++), ptr);
@@ -900,6 +919,49 @@ class PROTOBUF_EXPORT EpsCopyOutputStream {
     return ptr;
   }
 
+  // Writes the kSlopBytes elements at `it`, each of which must encode to a
+  // single byte varint.
+  template <bool kZigZag, typename V, typename E>
+  PROTOBUF_ALWAYS_INLINE static uint8_t* UnsafeWriteOneByteVarints(
+      const V* it, uint8_t* ptr, const E& encode) {
+    static_assert(sizeof(V) == 4 || sizeof(V) == 8, "");
+#if defined(__SSE2__)
+    (void)encode;
+    // Narrow each element to its low byte. The inputs are masked first so
+    // the saturating packs act as truncation.
+    auto load = [it](int i) {
+      return _mm_loadu_si128(reinterpret_cast<const __m128i*>(it) + i);
+    };
+    __m128i words[4];
+    if (sizeof(V) == 8) {
+      const __m128i mask = _mm_set1_epi64x(0xFF);
+      for (int i = 0; i < 4; ++i) {
+        words[i] = _mm_packs_epi32(_mm_and_si128(load(2 * i), mask),
+                                   _mm_and_si128(load(2 * i + 1), mask));
+      }
+    } else {
+      const __m128i mask = _mm_set1_epi32(0xFF);
+      for (int i = 0; i < 4; ++i) {
+        words[i] = _mm_and_si128(load(i), mask);
+      }
+    }
+    __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(words[0], words[1]),
+                                     _mm_packs_epi32(words[2], words[3]));
+    if (kZigZag) {
+      // A value whose zigzag encoding fits in 7 bits fits in an int8_t, so
+      // the encoding can be done on the truncated bytes.
+      bytes = _mm_xor_si128(_mm_add_epi8(bytes, bytes),
+                            _mm_cmpgt_epi8(_mm_setzero_si128(), bytes));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(ptr), bytes);
+#else
+    for (int i = 0; i < kSlopBytes; ++i) {
+      ptr[i] = static_cast<uint8_t>(encode(it[i]));
+    }
+#endif
+    return ptr + kSlopBytes;
+  }
+
   static uint32_t Encode32(uint32_t v) { return v; }
   static uint64_t Encode64(uint64_t v) { return v; }
   static uint32_t ZigZagEncode32(int32_t v) {
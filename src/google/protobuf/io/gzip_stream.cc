@@ -37,6 +37,12 @@
 #if HAVE_ZLIB
 #include "google/protobuf/io/gzip_stream.h"
 
+#include <string.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+
 #include "google/protobuf/stubs/common.h"
 #include "absl/log/absl_check.h"
 #include "absl/log/absl_log.h"
@@ -328,6 +334,425 @@ bool GzipOutputStream::Close() {
   return ok;
 }
 
+// ===================================================================
+
+namespace {
+
+constexpr int kDefaultParallelBlockSize = 256 << 10;
+constexpr int kDefaultMaxPendingBlocks = 8;
+
+// Each member written by ParallelGzipOutputStream starts with this fixed
+// header: a gzip header with FEXTRA set and one 'PB' subfield holding the
+// little-endian size of the whole member, header and trailer included.
+constexpr int kMemberHeaderSize = 20;
+constexpr int kMemberSizeOffset = 16;
+constexpr unsigned char kMemberHeader[kMemberSizeOffset] = {
+    0x1f, 0x8b,        // ID1, ID2
+    8,                 // CM = deflate
+    4,                 // FLG = FEXTRA
+    0,    0,    0, 0,  // MTIME
+    0,                 // XFL
+    0xff,              // OS = unknown
+    8,    0,           // XLEN
+    'P',  'B',         // SI1, SI2
+    4,    0,           // LEN
+};
+// CRC32 and ISIZE.
+constexpr int kMemberTrailerSize = 8;
+
+void PutLittleEndian32(uint32_t value, char* out) {
+  for (int i = 0; i < 4; ++i) {
+    out[i] = static_cast<char>(value >> (8 * i));
+  }
+}
+
+uint32_t GetLittleEndian32(const char* in) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; ++i) {
+    value |= static_cast<uint32_t>(static_cast<unsigned char>(in[i]))
+             << (8 * i);
+  }
+  return value;
+}
+
+ParallelGzipOutputStream::Options NormalizeOptions(
+    ParallelGzipOutputStream::Options options) {
+  if (options.block_size <= 0) options.block_size = kDefaultParallelBlockSize;
+  if (options.max_pending_blocks <= 0) options.max_pending_blocks = 1;
+  return options;
+}
+
+}  // namespace
+
+ParallelGzipOutputStream::Options::Options()
+    : compression_level(Z_DEFAULT_COMPRESSION),
+      compression_strategy(Z_DEFAULT_STRATEGY),
+      block_size(kDefaultParallelBlockSize),
+      max_pending_blocks(kDefaultMaxPendingBlocks),
+      executor(nullptr) {}
+
+ParallelGzipOutputStream::ParallelGzipOutputStream(
+    ZeroCopyOutputStream* sub_stream, const Options& options)
+    : sub_stream_(sub_stream),
+      options_(NormalizeOptions(options)),
+      zerror_(Z_OK),
+      error_message_(nullptr),
+      closed_(false),
+      current_(0),
+      byte_count_(0),
+      wrote_member_(false) {
+  blocks_.resize(options_.max_pending_blocks);
+  for (Block& block : blocks_) {
+    block.options = &options_;
+    block.input.reset(new char[options_.block_size]);
+  }
+}
+
+ParallelGzipOutputStream::~ParallelGzipOutputStream() {
+  Close();
+  // Close() stops at the first error; don't free blocks still compressing.
+  for (Block& block : blocks_) {
+    if (block.done != nullptr) block.done->WaitForNotification();
+  }
+}
+
+void ParallelGzipOutputStream::CompressBlock(void* arg) {
+  Block* block = static_cast<Block*>(arg);
+  const Options& options = *block->options;
+
+  z_stream zcontext;
+  zcontext.zalloc = Z_NULL;
+  zcontext.zfree = Z_NULL;
+  zcontext.opaque = Z_NULL;
+  zcontext.msg = NULL;
+  // Negative windowBits produces raw deflate data; the gzip framing is
+  // written here so that it can carry the member size.
+  int zerror = deflateInit2(&zcontext, options.compression_level, Z_DEFLATED,
+                            /* windowBits */ -15,
+                            /* memLevel (default) */ 8,
+                            options.compression_strategy);
+  if (zerror == Z_OK) {
+    const uLong bound = deflateBound(&zcontext, block->input_size);
+    block->output.resize(kMemberHeaderSize + bound + kMemberTrailerSize);
+    char* out = &block->output[0];
+    zcontext.next_in = reinterpret_cast<Bytef*>(block->input.get());
+    zcontext.avail_in = block->input_size;
+    zcontext.next_out = reinterpret_cast<Bytef*>(out + kMemberHeaderSize);
+    zcontext.avail_out = bound;
+    zerror = deflate(&zcontext, Z_FINISH);
+    if (zerror == Z_STREAM_END) {
+      const size_t member_size =
+          kMemberHeaderSize + zcontext.total_out + kMemberTrailerSize;
+      memcpy(out, kMemberHeader, kMemberSizeOffset);
+      PutLittleEndian32(member_size, out + kMemberSizeOffset);
+      char* trailer = out + kMemberHeaderSize + zcontext.total_out;
+      PutLittleEndian32(
+          crc32(0, reinterpret_cast<const Bytef*>(block->input.get()),
+                block->input_size),
+          trailer);
+      PutLittleEndian32(block->input_size, trailer + 4);
+      block->output.resize(member_size);
+      zerror = Z_OK;
+    } else if (zerror == Z_OK) {
+      // deflateBound() is supposed to make this impossible.
+      zerror = Z_BUF_ERROR;
+    }
+    block->error_message = zcontext.msg;
+    deflateEnd(&zcontext);
+  } else {
+    block->error_message = zcontext.msg;
+  }
+  block->zerror = zerror;
+  block->done->Notify();
+}
+
+bool ParallelGzipOutputStream::SubmitCurrent() {
+  Block* block = &blocks_[current_];
+  block->done.reset(new absl::Notification);
+  if (options_.executor != nullptr) {
+    options_.executor(&CompressBlock, block);
+  } else {
+    CompressBlock(block);
+  }
+
+  // The next block in the ring is the oldest one still pending.
+  current_ = (current_ + 1) % blocks_.size();
+  Block* next = &blocks_[current_];
+  return next->done == nullptr || WriteBlock(next);
+}
+
+bool ParallelGzipOutputStream::WriteBlock(Block* block) {
+  block->done->WaitForNotification();
+  block->done.reset();
+  block->input_size = 0;
+  if (block->zerror != Z_OK) {
+    zerror_ = block->zerror;
+    error_message_ = block->error_message;
+    return false;
+  }
+
+  const char* data = block->output.data();
+  size_t remaining = block->output.size();
+  while (remaining > 0) {
+    void* out;
+    int out_size;
+    if (!sub_stream_->Next(&out, &out_size)) {
+      zerror_ = Z_BUF_ERROR;
+      error_message_ = "failed to write to the underlying stream";
+      return false;
+    }
+    const size_t n = std::min(remaining, static_cast<size_t>(out_size));
+    memcpy(out, data, n);
+    data += n;
+    remaining -= n;
+    if (remaining == 0) sub_stream_->BackUp(out_size - static_cast<int>(n));
+  }
+  wrote_member_ = true;
+  return true;
+}
+
+bool ParallelGzipOutputStream::Next(void** data, int* size) {
+  if (closed_ || zerror_ != Z_OK) return false;
+  Block* block = &blocks_[current_];
+  if (block->input_size == options_.block_size) {
+    if (!SubmitCurrent()) return false;
+    block = &blocks_[current_];
+  }
+  *data = block->input.get() + block->input_size;
+  *size = options_.block_size - block->input_size;
+  block->input_size = options_.block_size;
+  byte_count_ += *size;
+  return true;
+}
+
+void ParallelGzipOutputStream::BackUp(int count) {
+  Block* block = &blocks_[current_];
+  ABSL_CHECK_GE(block->input_size, count)
+      << " BackUp() can not exceed the size of the last Next() call.";
+  block->input_size -= count;
+  byte_count_ -= count;
+}
+
+int64_t ParallelGzipOutputStream::ByteCount() const { return byte_count_; }
+
+bool ParallelGzipOutputStream::Flush() {
+  if (closed_ || zerror_ != Z_OK) return false;
+  if (blocks_[current_].input_size > 0 && !SubmitCurrent()) return false;
+  // Write out everything still pending, oldest first.
+  for (size_t i = 0; i < blocks_.size(); ++i) {
+    Block* block = &blocks_[(current_ + i) % blocks_.size()];
+    if (block->done != nullptr && !WriteBlock(block)) return false;
+  }
+  return true;
+}
+
+bool ParallelGzipOutputStream::Close() {
+  if (closed_) return zerror_ == Z_OK;
+  bool ok = Flush();
+  if (ok && !wrote_member_) {
+    // Even empty output needs one member to be a valid gzip file.
+    ok = SubmitCurrent() && Flush();
+  }
+  closed_ = true;
+  return ok;
+}
+
+// ===================================================================
+
+ParallelGzipInputStream::ParallelGzipInputStream(
+    ZeroCopyInputStream* sub_stream, internal::Executor executor,
+    int max_pending_blocks)
+    : sub_stream_(sub_stream),
+      executor_(executor),
+      zerror_(Z_OK),
+      error_message_(nullptr),
+      stop_reading_(false),
+      head_(0),
+      current_(nullptr),
+      backup_bytes_(0),
+      byte_count_(0) {
+  // Without an executor, members are decompressed one at a time from Next().
+  blocks_.resize(executor_ != nullptr ? std::max(max_pending_blocks, 1) : 1);
+  if (executor_ != nullptr) {
+    for (Block& block : blocks_) {
+      if (!Submit(&block)) break;
+    }
+  }
+}
+
+ParallelGzipInputStream::~ParallelGzipInputStream() {
+  for (Block& block : blocks_) {
+    if (block.done != nullptr) block.done->WaitForNotification();
+  }
+}
+
+bool ParallelGzipInputStream::Fail(int zerror, const char* message) {
+  zerror_ = zerror;
+  error_message_ = message;
+  stop_reading_ = true;
+  return false;
+}
+
+bool ParallelGzipInputStream::ReadFully(char* out, int size) {
+  while (size > 0) {
+    const void* data;
+    int data_size;
+    if (!sub_stream_->Next(&data, &data_size)) return false;
+    const int n = std::min(size, data_size);
+    memcpy(out, data, n);
+    out += n;
+    size -= n;
+    if (size == 0) sub_stream_->BackUp(data_size - n);
+  }
+  return true;
+}
+
+bool ParallelGzipInputStream::Submit(Block* block) {
+  if (stop_reading_) return false;
+
+  // Distinguish the end of the input from a truncated member.
+  const void* data;
+  int size;
+  do {
+    if (!sub_stream_->Next(&data, &size)) {
+      stop_reading_ = true;
+      return false;
+    }
+  } while (size == 0);
+  sub_stream_->BackUp(size);
+
+  char header[kMemberHeaderSize];
+  if (!ReadFully(header, kMemberHeaderSize)) {
+    return Fail(Z_DATA_ERROR, "truncated gzip member header");
+  }
+  if (memcmp(header, kMemberHeader, kMemberSizeOffset) != 0) {
+    return Fail(Z_DATA_ERROR,
+                "gzip member was not written by ParallelGzipOutputStream");
+  }
+  const uint32_t member_size = GetLittleEndian32(header + kMemberSizeOffset);
+  if (member_size < kMemberHeaderSize + kMemberTrailerSize ||
+      member_size > static_cast<uint32_t>(INT_MAX)) {
+    return Fail(Z_DATA_ERROR, "invalid gzip member size");
+  }
+
+  block->input.resize(member_size - kMemberHeaderSize);
+  if (!ReadFully(&block->input[0], static_cast<int>(block->input.size()))) {
+    return Fail(Z_DATA_ERROR, "truncated gzip member");
+  }
+
+  block->done.reset(new absl::Notification);
+  if (executor_ != nullptr) {
+    executor_(&DecompressBlock, block);
+  } else {
+    DecompressBlock(block);
+  }
+  return true;
+}
+
+void ParallelGzipInputStream::DecompressBlock(void* arg) {
+  Block* block = static_cast<Block*>(arg);
+  const std::string& input = block->input;
+  const size_t deflate_size = input.size() - kMemberTrailerSize;
+  const uint32_t crc = GetLittleEndian32(input.data() + deflate_size);
+  const uint32_t uncompressed_size =
+      GetLittleEndian32(input.data() + deflate_size + 4);
+  block->output.resize(uncompressed_size);
+
+  z_stream zcontext;
+  zcontext.zalloc = Z_NULL;
+  zcontext.zfree = Z_NULL;
+  zcontext.opaque = Z_NULL;
+  zcontext.msg = NULL;
+  zcontext.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+  zcontext.avail_in = deflate_size;
+  int zerror = inflateInit2(&zcontext, /* windowBits */ -15);
+  const char* message = zcontext.msg;
+  if (zerror == Z_OK) {
+    zcontext.next_out = reinterpret_cast<Bytef*>(&block->output[0]);
+    zcontext.avail_out = uncompressed_size;
+    zerror = inflate(&zcontext, Z_FINISH);
+    message = zcontext.msg;
+    if (zerror == Z_STREAM_END) {
+      if (zcontext.total_out != uncompressed_size ||
+          crc32(0, reinterpret_cast<const Bytef*>(block->output.data()),
+                uncompressed_size) != crc) {
+        zerror = Z_DATA_ERROR;
+        message = "gzip member checksum mismatch";
+      } else {
+        zerror = Z_OK;
+      }
+    } else {
+      if (zerror == Z_OK || zerror == Z_BUF_ERROR) zerror = Z_DATA_ERROR;
+      if (message == nullptr) message = "corrupt gzip member";
+    }
+    inflateEnd(&zcontext);
+  }
+  block->zerror = zerror;
+  block->error_message = message;
+  block->done->Notify();
+}
+
+bool ParallelGzipInputStream::Next(const void** data, int* size) {
+  if (backup_bytes_ > 0) {
+    *data = current_->output.data() + current_->output.size() - backup_bytes_;
+    *size = backup_bytes_;
+    byte_count_ += backup_bytes_;
+    backup_bytes_ = 0;
+    return true;
+  }
+
+  while (true) {
+    if (current_ != nullptr) {
+      // The reader is done with this member; reuse the block for the next.
+      current_->done.reset();
+      if (executor_ != nullptr) Submit(current_);
+      head_ = (head_ + 1) % blocks_.size();
+      current_ = nullptr;
+    }
+
+    Block* block = &blocks_[head_];
+    if (block->done == nullptr && !Submit(block)) return false;
+    block->done->WaitForNotification();
+    if (block->zerror != Z_OK) {
+      return Fail(block->zerror, block->error_message);
+    }
+    current_ = block;
+    // Skip over empty members.
+    if (!block->output.empty()) break;
+  }
+
+  *data = current_->output.data();
+  *size = static_cast<int>(current_->output.size());
+  byte_count_ += *size;
+  return true;
+}
+
+void ParallelGzipInputStream::BackUp(int count) {
+  ABSL_CHECK(current_ != nullptr && backup_bytes_ == 0)
+      << " BackUp() can only be called after Next().";
+  ABSL_CHECK_LE(count, static_cast<int>(current_->output.size()))
+      << " Can't back up over more bytes than were returned by the last call"
+         " to Next().";
+  backup_bytes_ = count;
+  byte_count_ -= count;
+}
+
+bool ParallelGzipInputStream::Skip(int count) {
+  const void* data;
+  int size;
+  while (count > 0) {
+    if (!Next(&data, &size)) return false;
+    if (size > count) {
+      BackUp(size - count);
+      return true;
+    }
+    count -= size;
+  }
+  return true;
+}
+
+int64_t ParallelGzipInputStream::ByteCount() const { return byte_count_; }
+
 }  // namespace io
 }  // namespace protobuf
 }  // namespace google
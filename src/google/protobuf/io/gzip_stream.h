@@ -43,7 +43,12 @@
 #ifndef GOOGLE_PROTOBUF_IO_GZIP_STREAM_H__
 #define GOOGLE_PROTOBUF_IO_GZIP_STREAM_H__
 
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "google/protobuf/stubs/common.h"
+#include "absl/synchronization/notification.h"
 #include "google/protobuf/io/zero_copy_stream.h"
 #include "google/protobuf/port.h"
 #include "zlib.h"
@@ -193,6 +198,172 @@ class PROTOBUF_EXPORT GzipOutputStream final : public ZeroCopyOutputStream {
   int Deflate(int flush);
 };
 
+// A ZeroCopyOutputStream that compresses blocks of its input in parallel.
+//
+// The input is split into fixed-size blocks which are compressed
+// independently on `executor` and written in order, each as its own gzip
+// member (pigz/BGZF-style).  Any gzip reader, including GzipInputStream,
+// decompresses the result.  Each member records its compressed size in a
+// gzip extra field so that ParallelGzipInputStream can find the member
+// boundaries and decompress them in parallel too.
+//
+// Blocks compress without the history of previous blocks, so the output is
+// slightly larger than GzipOutputStream's for the same input.
+class PROTOBUF_EXPORT ParallelGzipOutputStream final
+    : public ZeroCopyOutputStream {
+ public:
+  struct PROTOBUF_EXPORT Options {
+    // A number between 0 and 9, where 0 is no compression and 9 is best
+    // compression.  Defaults to Z_DEFAULT_COMPRESSION (see zlib.h).
+    int compression_level;
+
+    // Defaults to Z_DEFAULT_STRATEGY.  See GzipOutputStream::Options.
+    int compression_strategy;
+
+    // Uncompressed size of each block.  Defaults to 256kB.
+    int block_size;
+
+    // Number of blocks that may be compressing at once.  Defaults to 8.
+    int max_pending_blocks;
+
+    // Runs the compression tasks, which may run concurrently with each other
+    // and with the stream's caller.  If null, blocks are compressed on the
+    // calling thread.  Defaults to null.
+    internal::Executor executor;
+
+    Options();  // Initializes with default values.
+  };
+
+  // Create a ParallelGzipOutputStream with the given options.
+  explicit ParallelGzipOutputStream(ZeroCopyOutputStream* sub_stream,
+                                    const Options& options = Options());
+  ParallelGzipOutputStream(const ParallelGzipOutputStream&) = delete;
+  ParallelGzipOutputStream& operator=(const ParallelGzipOutputStream&) =
+      delete;
+
+  ~ParallelGzipOutputStream() override;
+
+  // Return last error message or NULL if no error.
+  inline const char* ZlibErrorMessage() const { return error_message_; }
+  inline int ZlibErrorCode() const { return zerror_; }
+
+  // Compresses the data written so far and writes it to the underlying
+  // stream, ending the current member.  Returns true if no error.
+  bool Flush();
+
+  // Writes out all data.  It is the caller's responsibility to close the
+  // underlying stream if necessary.  Returns true if no error.
+  bool Close();
+
+  // implements ZeroCopyOutputStream ---------------------------------
+  bool Next(void** data, int* size) override;
+  void BackUp(int count) override;
+  int64_t ByteCount() const override;
+
+ private:
+  struct Block {
+    const Options* options;
+    std::unique_ptr<char[]> input;
+    int input_size;
+    // Results, valid once `done` has been notified.
+    std::string output;
+    int zerror;
+    const char* error_message;
+    // Set while compression is outstanding or its output unwritten.
+    std::unique_ptr<absl::Notification> done;
+  };
+
+  // Starts compressing the current block and moves on to the next one,
+  // writing out that block's previous output first.
+  bool SubmitCurrent();
+  // Waits for `block` and copies its output to the underlying stream.
+  bool WriteBlock(Block* block);
+  // Compresses a block into a gzip member; runs on the executor.
+  static void CompressBlock(void* block);
+
+  ZeroCopyOutputStream* sub_stream_;
+  const Options options_;
+  int zerror_;
+  const char* error_message_;
+  bool closed_;
+
+  // Ring of blocks; `current_` is the one being filled.
+  std::vector<Block> blocks_;
+  size_t current_;
+  int64_t byte_count_;
+  // Whether any member has been written.
+  bool wrote_member_;
+};
+
+// A ZeroCopyInputStream that decompresses the output of
+// ParallelGzipOutputStream, several members at a time.
+//
+// Members are read from the underlying stream on the calling thread and
+// decompressed on `executor`.  Input that was not written by
+// ParallelGzipOutputStream (members without the compressed-size extra
+// field) is rejected with an error; use GzipInputStream for such input.
+class PROTOBUF_EXPORT ParallelGzipInputStream final
+    : public ZeroCopyInputStream {
+ public:
+  // Decompresses up to `max_pending_blocks` members ahead of the reader on
+  // `executor`, concurrently with the reader, or on the calling thread if
+  // `executor` is null.
+  explicit ParallelGzipInputStream(ZeroCopyInputStream* sub_stream,
+                                   internal::Executor executor = nullptr,
+                                   int max_pending_blocks = 8);
+  ParallelGzipInputStream(const ParallelGzipInputStream&) = delete;
+  ParallelGzipInputStream& operator=(const ParallelGzipInputStream&) = delete;
+
+  // Waits for outstanding decompression tasks.
+  ~ParallelGzipInputStream() override;
+
+  // Return last error message or NULL if no error.
+  inline const char* ZlibErrorMessage() const { return error_message_; }
+  inline int ZlibErrorCode() const { return zerror_; }
+
+  // implements ZeroCopyInputStream ----------------------------------
+  bool Next(const void** data, int* size) override;
+  void BackUp(int count) override;
+  bool Skip(int count) override;
+  int64_t ByteCount() const override;
+
+ private:
+  struct Block {
+    std::string input;
+    // Results, valid once `done` has been notified.
+    std::string output;
+    int zerror;
+    const char* error_message;
+    // Set while decompression is outstanding or its output unconsumed.
+    std::unique_ptr<absl::Notification> done;
+  };
+
+  // Reads the next member into `block` and starts decompressing it.
+  // Returns false at the end of the input or on error.
+  bool Submit(Block* block);
+  // Copies `size` bytes from the underlying stream to `out`.
+  bool ReadFully(char* out, int size);
+  // Decompresses a gzip member; runs on the executor.
+  static void DecompressBlock(void* block);
+  // Records an error; all later reads fail.
+  bool Fail(int zerror, const char* message);
+
+  ZeroCopyInputStream* sub_stream_;
+  const internal::Executor executor_;
+  int zerror_;
+  const char* error_message_;
+  // Set once the underlying stream is exhausted or an error occurred.
+  bool stop_reading_;
+
+  // Ring of blocks.  `head_` is the block returned by the last Next(), or the
+  // next one to be returned if `current_` is null.
+  std::vector<Block> blocks_;
+  size_t head_;
+  Block* current_;
+  int backup_bytes_;
+  int64_t byte_count_;
+};
+
 }  // namespace io
 }  // namespace protobuf
 }  // namespace google
@@ -38,6 +38,7 @@
 
 #include <cstddef>
 #include <functional>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -96,6 +97,17 @@ struct Printer::Format {
 
   // Whether this is a multiline raw string, according to internal heuristics.
   bool is_raw_string = false;
+
+  // Whether every check made while tokenizing passed. Only valid formats are
+  // cached, so that diagnostics are reported on every call.
+  bool is_valid = true;
+};
+
+// A tokenized format string together with the text its chunks point into.
+struct Printer::CachedFormat {
+  std::string text;
+  bool strip_raw_string_indentation = false;
+  Format format;
 };
 
 Printer::Format Printer::TokenizeFormat(absl::string_view format_string,
@@ -229,14 +241,16 @@ Printer::Format Printer::TokenizeFormat(absl::string_view format_string,
     // To ensure there are no unclosed $...$, we check that the computed length
     // above equals the actual length of the string. If it's off, that means
     // that there are missing or extra $ characters.
-    Validate(total_len == line_text.size(), options, [&line] {
-      if (line.chunks.empty()) {
-        return std::string("wrong number of variable delimiters");
-      }
+    if (!Validate(total_len == line_text.size(), options, [&line] {
+          if (line.chunks.empty()) {
+            return std::string("wrong number of variable delimiters");
+          }
 
-      return absl::StrFormat("unclosed variable name: `%s`",
-                             absl::CHexEscape(line.chunks.back().text));
-    });
+          return absl::StrFormat("unclosed variable name: `%s`",
+                                 absl::CHexEscape(line.chunks.back().text));
+        })) {
+      format.is_valid = false;
+    }
 
     // Trim any empty, non-variable chunks.
     while (!line.chunks.empty()) {
@@ -274,6 +288,41 @@ Printer::Format Printer::TokenizeFormat(absl::string_view format_string,
   return format;
 }
 
+std::shared_ptr<const Printer::CachedFormat> Printer::TokenizeFormatCached(
+    absl::string_view format_string, const PrintOptions& options) {
+  // Bounds the cache for callers that build a fresh format string for every
+  // call, where nearly every lookup misses.
+  constexpr size_t kMaxCachedFormats = 4096;
+
+  auto key = std::make_pair(format_string.data(), format_string.size());
+  auto it = format_cache_.find(key);
+  if (it != format_cache_.end() && it->second->text == format_string &&
+      it->second->strip_raw_string_indentation ==
+          options.strip_raw_string_indentation) {
+    return it->second;
+  }
+
+  auto entry = std::make_shared<CachedFormat>();
+  entry->text = std::string(format_string);
+  entry->strip_raw_string_indentation = options.strip_raw_string_indentation;
+  entry->format = TokenizeFormat(entry->text, options);
+  if (!entry->format.is_valid) {
+    return entry;
+  }
+
+  if (it != format_cache_.end()) {
+    it->second = entry;
+  } else {
+    if (format_cache_.size() >= kMaxCachedFormats) {
+      // Entries still in use by an enclosing PrintImpl() call are kept alive
+      // by that call's reference.
+      format_cache_.clear();
+    }
+    format_cache_.emplace(key, entry);
+  }
+  return entry;
+}
+
 constexpr absl::string_view Printer::kProtocCodegenTrace;
 
 Printer::Printer(ZeroCopyOutputStream* output) : Printer(output, Options{}) {}
@@ -516,11 +565,21 @@ void Printer::PrintImpl(absl::string_view format,
 
   line_start_variables_.clear();
 
-  if (opts.use_substitution_map) {
+  // Substitution ranges and same-name annotations only feed the annotation
+  // collector, so skip recording them when there is none.
+  const bool collect_annotations = options_.annotation_collector != nullptr;
+  const bool use_substitution_map =
+      opts.use_substitution_map && collect_annotations;
+
+  if (use_substitution_map) {
     substitutions_.clear();
   }
 
-  auto fmt = TokenizeFormat(format, opts);
+  // Holding a reference keeps the tokenized format alive even if a nested
+  // call evicts it from the cache.
+  std::shared_ptr<const CachedFormat> cached =
+      TokenizeFormatCached(format, opts);
+  const Format& fmt = cached->format;
   PrintCodegenTrace(opts.loc);
 
   size_t arg_index = 0;
@@ -699,7 +758,7 @@ void Printer::PrintImpl(absl::string_view format,
       } else {
         sub = LookupInFrameStack(var, absl::MakeSpan(var_lookups_));
 
-        if (opts.use_annotation_frames) {
+        if (opts.use_annotation_frames && collect_annotations) {
           same_name_record =
               LookupInFrameStack(var, absl::MakeSpan(annotation_lookups_));
         }
@@ -719,7 +778,7 @@ void Printer::PrintImpl(absl::string_view format,
       size_t range_end = sink_.bytes_written();
 
       if (const absl::string_view* str = sub->AsString()) {
-        if (at_start_of_line_ && str->empty()) {
+        if (collect_annotations && at_start_of_line_ && str->empty()) {
           line_start_variables_.emplace_back(var);
         }
 
@@ -792,7 +851,7 @@ void Printer::PrintImpl(absl::string_view format,
             same_name_record->path, same_name_record->semantic);
       }
 
-      if (opts.use_substitution_map) {
+      if (use_substitution_map) {
         auto insertion =
             substitutions_.emplace(var, std::make_pair(range_start, range_end));
 
@@ -40,6 +40,7 @@
 #include <cstddef>
 #include <functional>
 #include <initializer_list>
+#include <memory>
 #include <string>
 #include <type_traits>
 #include <utility>
@@ -680,6 +681,7 @@ class PROTOBUF_EXPORT Printer {
  private:
   struct PrintOptions;
   struct Format;
+  struct CachedFormat;
 
   // Helper type for wrapping a variable substitution expansion result.
   template <bool owned>
@@ -714,6 +716,12 @@ class PROTOBUF_EXPORT Printer {
   Format TokenizeFormat(absl::string_view format_string,
                         const PrintOptions& options);
 
+  // Like TokenizeFormat(), but reuses the result of an earlier call made with
+  // the same format string. Generators pass the same string literals to
+  // Emit() over and over, so this skips re-splitting them on every call.
+  std::shared_ptr<const CachedFormat> TokenizeFormatCached(
+      absl::string_view format_string, const PrintOptions& options);
+
   // Emit an annotation for the range defined by the given substitution
   // variables, as set by the most recent call to PrintImpl() that set
   // `use_substitution_map` to true.
@@ -783,6 +791,14 @@ class PROTOBUF_EXPORT Printer {
   // indents are inserted. These are keys that refer to the beginning of the
   // current line.
   std::vector<std::string> line_start_variables_;
+
+  // Tokenized format strings, keyed by the address and size of the string
+  // passed to PrintImpl(). Each entry owns a copy of the text it was built
+  // from, which is compared on lookup, so storage that has been reused for a
+  // different string is simply tokenized again.
+  absl::flat_hash_map<std::pair<const char*, size_t>,
+                      std::shared_ptr<const CachedFormat>>
+      format_cache_;
 };
 
 // Options for PrintImpl().
@@ -558,6 +558,21 @@ TEST_F(PrinterTest, Emit) {
             "}\n");
 }
 
+TEST_F(PrinterTest, EmitReusedFormatBuffer) {
+  {
+    Printer printer(output());
+    std::string format = "a $x$\n";
+    printer.Emit({{"x", "1"}}, format);
+    printer.Emit({{"x", "2"}}, format);
+
+    // Same address and size, different contents.
+    format[0] = 'b';
+    printer.Emit({{"x", "3"}}, format);
+  }
+
+  EXPECT_EQ(written(), "a 1\na 2\nb 3\n");
+}
+
 TEST_F(PrinterTest, EmitWithSubs) {
   {
     Printer printer(output());
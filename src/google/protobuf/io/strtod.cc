@@ -136,15 +136,14 @@ double NoLocaleStrtod(const char *str, char **endptr) {
 //    and it is embedded in a larger library.  If speed turns out to be
 //    an issue, we could re-implement this in terms of their
 //    implementation.
+//
+//    Rather than retrying at the precise precision right away, we step up
+//    one digit at a time and stop at the first precision that matches, so
+//    we do not print digits the value does not need.  This costs at most a
+//    few more snprintf() calls.
 // ----------------------------------------------------------------------
 
 namespace {
-// In practice, doubles should never need more than 24 bytes and floats
-// should never need more than 14 (including null terminators), but we
-// overestimate to be safe.
-constexpr int kDoubleToBufferSize = 32;
-constexpr int kFloatToBufferSize = 24;
-
 inline bool IsValidFloatChar(char c) {
   return ('0' <= c && c <= '9') || c == 'e' || c == 'E' || c == '+' || c == '-';
 }
@@ -178,12 +177,31 @@ void DelocalizeRadix(char *buffer) {
   }
 }
 
-bool safe_strtof(const char *str, float *value) {
-  char *endptr;
-  errno = 0;  // errno only gets set on errors
-  *value = strtof(str, &endptr);
-  return *str != 0 && *endptr == 0 && errno == 0;
+// Writes `value` with "%.*g" at the smallest precision in
+// [`precision`, `max_precision`] that round-trips, or at `max_precision`.
+//
+// `value` must be finite.
+template <typename T>
+char *ShortestToBuffer(T value, int precision, int max_precision,
+                       char *buffer, int buffer_size) {
+  for (;; ++precision) {
+    int snprintf_result =
+        absl::SNPrintF(buffer, buffer_size, "%.*g", precision, value);
+
+    // The snprintf should never overflow because the buffer is significantly
+    // larger than the precision we asked for.
+    ABSL_DCHECK(snprintf_result > 0 && snprintf_result < buffer_size);
+
+    DelocalizeRadix(buffer);
+    if (precision >= max_precision) break;
+    T parsed_value;
+    auto result =
+        absl::from_chars(buffer, buffer + strlen(buffer), parsed_value);
+    if (result.ec == std::errc() && parsed_value == value) break;
+  }
+  return buffer;
 }
+}  // namespace
 
 char *FloatToBuffer(float value, char *buffer) {
   // FLT_DIG is 6 for IEEE-754 floats, which are used on almost all
@@ -203,24 +221,8 @@ char *FloatToBuffer(float value, char *buffer) {
     return buffer;
   }
 
-  int snprintf_result =
-      absl::SNPrintF(buffer, kFloatToBufferSize, "%.*g", FLT_DIG, value);
-
-  // The snprintf should never overflow because the buffer is significantly
-  // larger than the precision we asked for.
-  ABSL_DCHECK(snprintf_result > 0 && snprintf_result < kFloatToBufferSize);
-
-  float parsed_value;
-  if (!safe_strtof(buffer, &parsed_value) || parsed_value != value) {
-    snprintf_result =
-        absl::SNPrintF(buffer, kFloatToBufferSize, "%.*g", FLT_DIG + 3, value);
-
-    // Should never overflow; see above.
-    ABSL_DCHECK(snprintf_result > 0 && snprintf_result < kFloatToBufferSize);
-  }
-
-  DelocalizeRadix(buffer);
-  return buffer;
+  return ShortestToBuffer(value, FLT_DIG, FLT_DIG + 3, buffer,
+                          kFloatToBufferSize);
 }
 
 char *DoubleToBuffer(double value, char *buffer) {
@@ -241,32 +243,9 @@ char *DoubleToBuffer(double value, char *buffer) {
     return buffer;
   }
 
-  int snprintf_result =
-      absl::SNPrintF(buffer, kDoubleToBufferSize, "%.*g", DBL_DIG, value);
-
-  // The snprintf should never overflow because the buffer is significantly
-  // larger than the precision we asked for.
-  ABSL_DCHECK(snprintf_result > 0 && snprintf_result < kDoubleToBufferSize);
-
-  // We need to make parsed_value volatile in order to force the compiler to
-  // write it out to the stack.  Otherwise, it may keep the value in a
-  // register, and if it does that, it may keep it as a long double instead
-  // of a double.  This long double may have extra bits that make it compare
-  // unequal to "value" even though it would be exactly equal if it were
-  // truncated to a double.
-  volatile double parsed_value = NoLocaleStrtod(buffer, nullptr);
-  if (parsed_value != value) {
-    snprintf_result =
-        absl::SNPrintF(buffer, kDoubleToBufferSize, "%.*g", DBL_DIG + 2, value);
-
-    // Should never overflow; see above.
-    ABSL_DCHECK(snprintf_result > 0 && snprintf_result < kDoubleToBufferSize);
-  }
-
-  DelocalizeRadix(buffer);
-  return buffer;
+  return ShortestToBuffer(value, DBL_DIG, DBL_DIG + 2, buffer,
+                          kDoubleToBufferSize);
 }
-}  // namespace
 
 std::string SimpleDtoa(double value) {
   char buffer[kDoubleToBufferSize];
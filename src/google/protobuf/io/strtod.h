@@ -58,6 +58,23 @@ namespace io {
 PROTOBUF_EXPORT std::string SimpleDtoa(double value);
 PROTOBUF_EXPORT std::string SimpleFtoa(float value);
 
+// ----------------------------------------------------------------------
+// DoubleToBuffer()
+// FloatToBuffer()
+//    Like SimpleDtoa() and SimpleFtoa(), but write the NUL-terminated result
+//    into `buffer`, which must be at least kDoubleToBufferSize or
+//    kFloatToBufferSize bytes long, and return `buffer`.  Use these to avoid
+//    allocating a string per value.
+// ----------------------------------------------------------------------
+// In practice, doubles should never need more than 24 bytes and floats
+// should never need more than 14 (including null terminators), but we
+// overestimate to be safe.
+constexpr int kDoubleToBufferSize = 32;
+constexpr int kFloatToBufferSize = 24;
+
+PROTOBUF_EXPORT char* DoubleToBuffer(double value, char* buffer);
+PROTOBUF_EXPORT char* FloatToBuffer(float value, char* buffer);
+
 // A locale-independent version of the standard strtod(), which always
 // uses a dot as the decimal separator.
 PROTOBUF_EXPORT double NoLocaleStrtod(const char* str, char** endptr);
@@ -444,6 +444,14 @@ class PROTOBUF_EXPORT Tokenizer {
   // e.g. ConsumeOneOrMore<Digit>("Expected digits.");
   template <typename CharacterClass>
   inline void ConsumeOneOrMore(const char* error);
+
+  // Consumes, in one step, the run of characters at the current position
+  // that span(p, n) measures within the n characters left in the current
+  // buffer.  The run must not contain '\n' or '\t', which still go through
+  // NextChar() to keep line and column numbers right.  Returns false if
+  // nothing was consumed.
+  template <typename Span>
+  inline bool ConsumeBufferedRun(Span span);
 };
 
 // inline methods ====================================================
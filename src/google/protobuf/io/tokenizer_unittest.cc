@@ -317,6 +317,44 @@ TEST_1D(TokenizerTest, FloatSuffix, kBlockSizes) {
   EXPECT_TRUE(error_collector.text_.empty());
 }
 
+TEST_1D(TokenizerTest, LongTokenPositions, kBlockSizes) {
+  // Long runs are consumed a buffer at a time; make sure the text and
+  // positions still come out right, including around tabs and newlines.
+  const char* text =
+      "long_identifier_name \"a string\twith a tab\" 1234567890\n  \tnext";
+  TestInputStream input(text, strlen(text), kBlockSizes_case);
+  TestErrorCollector error_collector;
+  Tokenizer tokenizer(&input, &error_collector);
+
+  ASSERT_TRUE(tokenizer.Next());
+  EXPECT_EQ(tokenizer.current().text, "long_identifier_name");
+  EXPECT_EQ(tokenizer.current().type, Tokenizer::TYPE_IDENTIFIER);
+  EXPECT_EQ(tokenizer.current().column, 0);
+  EXPECT_EQ(tokenizer.current().end_column, 20);
+
+  ASSERT_TRUE(tokenizer.Next());
+  EXPECT_EQ(tokenizer.current().text, "\"a string\twith a tab\"");
+  EXPECT_EQ(tokenizer.current().type, Tokenizer::TYPE_STRING);
+  EXPECT_EQ(tokenizer.current().column, 21);
+  EXPECT_EQ(tokenizer.current().end_column, 43);
+
+  ASSERT_TRUE(tokenizer.Next());
+  EXPECT_EQ(tokenizer.current().text, "1234567890");
+  EXPECT_EQ(tokenizer.current().type, Tokenizer::TYPE_INTEGER);
+  EXPECT_EQ(tokenizer.current().column, 44);
+  EXPECT_EQ(tokenizer.current().end_column, 54);
+
+  ASSERT_TRUE(tokenizer.Next());
+  EXPECT_EQ(tokenizer.current().text, "next");
+  EXPECT_EQ(tokenizer.current().line, 1);
+  EXPECT_EQ(tokenizer.current().column, 8);
+  EXPECT_EQ(tokenizer.current().end_column, 12);
+  EXPECT_EQ(tokenizer.previous().text, "1234567890");
+
+  EXPECT_FALSE(tokenizer.Next());
+  EXPECT_TRUE(error_collector.text_.empty());
+}
+
 SimpleTokenCase kWhitespaceTokenCases[] = {
     {" ", Tokenizer::TYPE_WHITESPACE},
     {"    ", Tokenizer::TYPE_WHITESPACE},
@@ -462,6 +500,18 @@ MultiTokenCase kMultiTokenCases[] = {
          {Tokenizer::TYPE_IDENTIFIER, "bar", 1, 11, 14},
          {Tokenizer::TYPE_END, "", 1, 14, 14},
      }},
+
+    // Test that runs longer than 16 bytes, including tabs past the first 16
+    // bytes of a string or comment, keep column numbers correct.
+    {"abcdefghijklmnopqrstuvwxyz_0123456789 \"0123456789abcdef\tx\" "
+     "/* 0123456789abcdef\t*/ z",
+     {
+         {Tokenizer::TYPE_IDENTIFIER, "abcdefghijklmnopqrstuvwxyz_0123456789",
+          0, 0, 37},
+         {Tokenizer::TYPE_STRING, "\"0123456789abcdef\tx\"", 0, 38, 58},
+         {Tokenizer::TYPE_IDENTIFIER, "z", 0, 83, 84},
+         {Tokenizer::TYPE_END, "", 0, 84, 84},
+     }},
 };
 
 TEST_2D(TokenizerTest, MultipleTokens, kMultiTokenCases, kBlockSizes) {
@@ -38,7 +38,12 @@
 #include <sys/types.h>
 #include <unistd.h>
 #endif
+#ifndef _WIN32
+#include <sys/uio.h>
+#endif
 #include <errno.h>
+#include <limits.h>
+#include <string.h>
 
 #include <algorithm>
 #include <iostream>
@@ -78,6 +83,27 @@ int close_no_eintr(int fd) {
   return result;
 }
 
+// Default size of the reads issued by PrefetchingFileInputStream.
+constexpr int kDefaultPrefetchBlockSize = 64 << 10;
+
+// Default size of the buffers returned by VectoredFileOutputStream::Next().
+constexpr int kDefaultVectoredBlockSize = 8192;
+
+// Maximum number of slices handed to a single writev() call.
+#if defined(IOV_MAX) && IOV_MAX < 1024
+constexpr size_t kMaxIovecs = IOV_MAX;
+#else
+constexpr size_t kMaxIovecs = 1024;
+#endif
+
+// Owned buffers allowed to accumulate before VectoredFileOutputStream
+// flushes.
+constexpr size_t kMaxPendingBlocks = 16;
+
+// Aliased data and Cord chunks smaller than this are copied: an iovec per
+// tiny chunk costs more than the copy.
+constexpr size_t kMinAliasedSize = 512;
+
 }  // namespace
 
 // ===================================================================
@@ -170,6 +196,206 @@ int FileInputStream::CopyingFileInputStream::Skip(int count) {
 
 // ===================================================================
 
+PrefetchingFileInputStream::PrefetchingFileInputStream(
+    int file_descriptor, internal::Executor executor, int prefetch_depth,
+    int block_size)
+    : file_(file_descriptor),
+      close_on_delete_(false),
+      is_closed_(false),
+      errno_(0),
+      executor_(executor),
+      block_size_(block_size > 0 ? block_size : kDefaultPrefetchBlockSize),
+      seekable_(false),
+      start_offset_(0),
+      next_offset_(0),
+      stop_reading_(false),
+      head_(0),
+      current_(nullptr),
+      backup_bytes_(0),
+      position_(0) {
+#ifndef _WIN32
+  int flags = fcntl(file_, F_GETFL);
+  flags &= ~O_NONBLOCK;
+  fcntl(file_, F_SETFL, flags);
+
+  off_t offset = lseek(file_, 0, SEEK_CUR);
+  if (offset != (off_t)-1) {
+    seekable_ = true;
+    start_offset_ = next_offset_ = offset;
+  }
+#endif
+
+  // Without an executor or positional reads, a single block is filled from
+  // Next() whenever the reader needs more data.
+  const bool prefetch = executor_ != nullptr && seekable_;
+  blocks_.resize(prefetch ? std::max(prefetch_depth, 1) : 1);
+  for (Block& block : blocks_) {
+    block.stream = this;
+    block.data.reset(new char[block_size_]);
+  }
+  if (prefetch) {
+    for (Block& block : blocks_) Submit(&block);
+  }
+}
+
+PrefetchingFileInputStream::~PrefetchingFileInputStream() {
+  WaitAll();
+  if (is_closed_) return;
+  if (seekable_) {
+    // Leave the file where a sequential reader would have.
+    lseek(file_, start_offset_ + position_, SEEK_SET);
+  }
+  if (close_on_delete_) {
+    if (!Close()) {
+      ABSL_LOG(ERROR) << "close() failed: " << strerror(errno_);
+    }
+  }
+}
+
+bool PrefetchingFileInputStream::Close() {
+  ABSL_CHECK(!is_closed_);
+  WaitAll();
+
+  is_closed_ = true;
+  if (close_no_eintr(file_) != 0) {
+    errno_ = errno;
+    return false;
+  }
+
+  return true;
+}
+
+void PrefetchingFileInputStream::Submit(Block* block) {
+  block->offset = next_offset_;
+  next_offset_ += block_size_;
+  block->done.reset(new absl::Notification);
+  if (executor_ != nullptr && seekable_) {
+    executor_(&ReadBlock, block);
+  } else {
+    ReadBlock(block);
+  }
+}
+
+void PrefetchingFileInputStream::ReadBlock(void* arg) {
+  Block* block = static_cast<Block*>(arg);
+  const PrefetchingFileInputStream* stream = block->stream;
+  char* buffer = block->data.get();
+  const int block_size = stream->block_size_;
+
+  int total = 0;
+  int error = 0;
+  bool eof = false;
+  while (total < block_size) {
+    int bytes;
+    do {
+#ifndef _WIN32
+      if (stream->seekable_) {
+        bytes = static_cast<int>(pread(stream->file_, buffer + total,
+                                       block_size - total,
+                                       block->offset + total));
+      } else {
+        bytes = static_cast<int>(
+            read(stream->file_, buffer + total, block_size - total));
+      }
+#else
+      bytes = read(stream->file_, buffer + total, block_size - total);
+#endif
+    } while (bytes < 0 && errno == EINTR);
+
+    if (bytes <= 0) {
+      if (bytes < 0) error = errno;
+      eof = true;
+      break;
+    }
+    total += bytes;
+    // Like read(), return what a pipe or socket has rather than waiting to
+    // fill the block.
+    if (!stream->seekable_) break;
+  }
+
+  block->size = total;
+  block->error = error;
+  block->eof = eof;
+  block->done->Notify();
+}
+
+void PrefetchingFileInputStream::WaitAll() {
+  for (Block& block : blocks_) {
+    if (block.done != nullptr) block.done->WaitForNotification();
+  }
+}
+
+bool PrefetchingFileInputStream::Next(const void** data, int* size) {
+  if (backup_bytes_ > 0) {
+    *data = current_->data.get() + current_->size - backup_bytes_;
+    *size = backup_bytes_;
+    position_ += backup_bytes_;
+    backup_bytes_ = 0;
+    return true;
+  }
+
+  if (current_ != nullptr) {
+    // The reader is done with this block; reuse it for the next range.
+    current_->done.reset();
+    if (executor_ != nullptr && seekable_ && !stop_reading_) {
+      Submit(current_);
+    }
+    head_ = (head_ + 1) % blocks_.size();
+    current_ = nullptr;
+  }
+
+  Block* block = &blocks_[head_];
+  if (block->done == nullptr) {
+    if (stop_reading_) return false;
+    Submit(block);
+  }
+  block->done->WaitForNotification();
+  if (block->eof) stop_reading_ = true;
+  if (block->error != 0) {
+    errno_ = block->error;
+    return false;
+  }
+  if (block->size == 0) return false;
+
+  current_ = block;
+  *data = block->data.get();
+  *size = block->size;
+  position_ += block->size;
+  return true;
+}
+
+void PrefetchingFileInputStream::BackUp(int count) {
+  ABSL_CHECK(current_ != nullptr && backup_bytes_ == 0)
+      << " BackUp() can only be called after Next().";
+  ABSL_CHECK_LE(count, current_->size)
+      << " Can't back up over more bytes than were returned by the last call"
+         " to Next().";
+  ABSL_CHECK_GE(count, 0) << " Parameter to BackUp() can't be negative.";
+
+  backup_bytes_ = count;
+  position_ -= count;
+}
+
+bool PrefetchingFileInputStream::Skip(int count) {
+  ABSL_CHECK_GE(count, 0);
+
+  const void* data;
+  int size;
+  while (count > 0) {
+    if (!Next(&data, &size)) return false;
+    if (size > count) {
+      BackUp(size - count);
+      return true;
+    }
+    count -= size;
+  }
+  return true;
+}
+
+int64_t PrefetchingFileInputStream::ByteCount() const { return position_; }
+
+// ===================================================================
+
 FileOutputStream::FileOutputStream(int file_descriptor, int block_size)
     : CopyingOutputStreamAdaptor(&copying_output_, block_size),
       copying_output_(file_descriptor) {}
@@ -248,6 +474,225 @@ bool FileOutputStream::CopyingFileOutputStream::Write(const void* buffer,
 
 // ===================================================================
 
+VectoredFileOutputStream::VectoredFileOutputStream(int file_descriptor,
+                                                   int block_size)
+    : file_(file_descriptor),
+      close_on_delete_(false),
+      is_closed_(false),
+      failed_(false),
+      errno_(0),
+      block_size_(block_size > 0 ? block_size : kDefaultVectoredBlockSize),
+      pending_bytes_(0),
+      flushed_bytes_(0),
+      blocks_used_(0),
+      block_pos_(0) {}
+
+VectoredFileOutputStream::~VectoredFileOutputStream() {
+  Flush();
+  if (close_on_delete_ && !is_closed_) {
+    if (!Close()) {
+      ABSL_LOG(ERROR) << "close() failed: " << strerror(errno_);
+    }
+  }
+}
+
+bool VectoredFileOutputStream::Flush() {
+  if (failed_) return false;
+  if (slices_.empty()) return true;
+  if (!WriteSlices()) {
+    failed_ = true;
+    return false;
+  }
+  flushed_bytes_ += pending_bytes_;
+  pending_bytes_ = 0;
+  slices_.clear();
+  blocks_used_ = 0;
+  block_pos_ = 0;
+  cords_.clear();
+  return true;
+}
+
+bool VectoredFileOutputStream::Close() {
+  bool flush_succeeded = Flush();
+  ABSL_CHECK(!is_closed_);
+
+  is_closed_ = true;
+  if (close_no_eintr(file_) != 0) {
+    errno_ = errno;
+    return false;
+  }
+
+  return flush_succeeded;
+}
+
+bool VectoredFileOutputStream::Next(void** data, int* size) {
+  if (failed_) return false;
+  const bool block_full = blocks_used_ == 0 || block_pos_ == block_size_;
+  if (slices_.size() >= kMaxIovecs ||
+      (block_full && blocks_used_ >= kMaxPendingBlocks)) {
+    if (!Flush()) return false;
+  }
+  if (blocks_used_ == 0 || block_pos_ == block_size_) {
+    if (blocks_used_ == blocks_.size()) {
+      blocks_.emplace_back(new char[block_size_]);
+    }
+    ++blocks_used_;
+    block_pos_ = 0;
+  }
+
+  char* buffer = blocks_[blocks_used_ - 1].get() + block_pos_;
+  *data = buffer;
+  *size = block_size_ - block_pos_;
+  block_pos_ = block_size_;
+  AppendSlice(buffer, *size);
+  return true;
+}
+
+void VectoredFileOutputStream::BackUp(int count) {
+  if (count == 0) return;
+  ABSL_CHECK_GT(blocks_used_, 0u)
+      << " BackUp() can only be called after Next().";
+  ABSL_CHECK_LE(count, block_pos_)
+      << " Can't back up over more bytes than were returned by the last call"
+         " to Next().";
+  ABSL_CHECK_GE(count, 0) << " Parameter to BackUp() can't be negative.";
+
+  Slice& last = slices_.back();
+  ABSL_DCHECK_EQ(last.data + last.size,
+                 blocks_[blocks_used_ - 1].get() + block_pos_);
+  block_pos_ -= count;
+  last.size -= count;
+  pending_bytes_ -= count;
+  if (last.size == 0) slices_.pop_back();
+}
+
+int64_t VectoredFileOutputStream::ByteCount() const {
+  return flushed_bytes_ + static_cast<int64_t>(pending_bytes_);
+}
+
+bool VectoredFileOutputStream::WriteAliasedRaw(const void* data, int size) {
+  if (failed_) return false;
+  const char* bytes = static_cast<const char*>(data);
+  if (static_cast<size_t>(size) < kMinAliasedSize) {
+    return CopyToBuffers(bytes, size);
+  }
+  return AppendAliasedSlice(bytes, size);
+}
+
+bool VectoredFileOutputStream::WriteCord(const absl::Cord& cord) {
+  if (failed_) return false;
+  // The value of `flushed_bytes_` right after a chunk of `cord` was last
+  // referenced, or -1 if none was.  If no flush happened since, `cord` has to
+  // be retained.
+  int64_t referenced_at = -1;
+  for (absl::string_view chunk : cord.Chunks()) {
+    if (chunk.size() < kMinAliasedSize) {
+      if (!CopyToBuffers(chunk.data(), chunk.size())) return false;
+    } else {
+      if (!AppendAliasedSlice(chunk.data(), chunk.size())) return false;
+      referenced_at = flushed_bytes_;
+    }
+  }
+  if (referenced_at == flushed_bytes_) cords_.push_back(cord);
+  return true;
+}
+
+void VectoredFileOutputStream::AppendSlice(const char* data, size_t size) {
+  if (!slices_.empty() &&
+      slices_.back().data + slices_.back().size == data) {
+    slices_.back().size += size;
+  } else {
+    slices_.push_back({data, size});
+  }
+  pending_bytes_ += size;
+}
+
+bool VectoredFileOutputStream::AppendAliasedSlice(const char* data,
+                                                  size_t size) {
+  if (slices_.size() >= kMaxIovecs && !Flush()) return false;
+  AppendSlice(data, size);
+  return true;
+}
+
+bool VectoredFileOutputStream::CopyToBuffers(const char* data, size_t size) {
+  while (size > 0) {
+    void* buffer;
+    int buffer_size;
+    if (!Next(&buffer, &buffer_size)) return false;
+    const size_t n = std::min(size, static_cast<size_t>(buffer_size));
+    memcpy(buffer, data, n);
+    BackUp(buffer_size - static_cast<int>(n));
+    data += n;
+    size -= n;
+  }
+  return true;
+}
+
+bool VectoredFileOutputStream::WriteSlices() {
+  ABSL_CHECK(!is_closed_);
+#ifndef _WIN32
+  std::vector<iovec> iov(slices_.size());
+  for (size_t i = 0; i < slices_.size(); ++i) {
+    iov[i].iov_base = const_cast<char*>(slices_[i].data);
+    iov[i].iov_len = slices_[i].size;
+  }
+
+  iovec* next = iov.data();
+  int count = static_cast<int>(iov.size());
+  while (count > 0) {
+    ssize_t bytes;
+    do {
+      bytes = writev(file_, next, count);
+    } while (bytes < 0 && errno == EINTR);
+
+    if (bytes <= 0) {
+      // As in CopyingFileOutputStream::Write(), a zero-byte write is treated
+      // as an error since retrying could loop forever.
+      if (bytes < 0) {
+        errno_ = errno;
+      }
+      return false;
+    }
+
+    // Skip over the slices that were written completely, then advance into
+    // the one that was written partially, if any.
+    size_t written = static_cast<size_t>(bytes);
+    while (count > 0 && written >= next->iov_len) {
+      written -= next->iov_len;
+      ++next;
+      --count;
+    }
+    if (count > 0) {
+      next->iov_base = static_cast<char*>(next->iov_base) + written;
+      next->iov_len -= written;
+    }
+  }
+#else
+  for (const Slice& slice : slices_) {
+    size_t total_written = 0;
+    while (total_written < slice.size) {
+      int bytes;
+      do {
+        bytes = write(file_, slice.data + total_written,
+                      static_cast<int>(std::min<size_t>(
+                          slice.size - total_written, INT_MAX)));
+      } while (bytes < 0 && errno == EINTR);
+
+      if (bytes <= 0) {
+        if (bytes < 0) {
+          errno_ = errno;
+        }
+        return false;
+      }
+      total_written += bytes;
+    }
+  }
+#endif
+  return true;
+}
+
+// ===================================================================
+
 IstreamInputStream::IstreamInputStream(std::istream* input, int block_size)
     : copying_input_(input), impl_(&copying_input_, block_size) {}
 
@@ -356,6 +801,26 @@ bool ConcatenatingInputStream::Skip(int count) {
   return false;
 }
 
+bool ConcatenatingInputStream::ReadCord(absl::Cord* cord, int count) {
+  while (stream_count_ > 0) {
+    // As in Skip(), use ByteCount() to find out how much was actually read
+    // when ReadCord() fails.
+    int64_t target_byte_count = streams_[0]->ByteCount() + count;
+    if (streams_[0]->ReadCord(cord, count)) return true;
+
+    int64_t final_byte_count = streams_[0]->ByteCount();
+    ABSL_DCHECK_LT(final_byte_count, target_byte_count);
+    count = target_byte_count - final_byte_count;
+
+    // That stream is done.  Advance to the next one.
+    bytes_retired_ += final_byte_count;
+    ++streams_;
+    --stream_count_;
+  }
+
+  return count <= 0;
+}
+
 int64_t ConcatenatingInputStream::ByteCount() const {
   if (stream_count_ == 0) {
     return bytes_retired_;
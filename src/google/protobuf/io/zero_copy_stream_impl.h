@@ -41,11 +41,16 @@
 #define GOOGLE_PROTOBUF_IO_ZERO_COPY_STREAM_IMPL_H__
 
 #include <iosfwd>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "google/protobuf/stubs/common.h"
+#include "absl/strings/cord.h"
+#include "absl/synchronization/notification.h"
 #include "google/protobuf/io/zero_copy_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/port.h"
 
 // Must be included last.
 #include "google/protobuf/port_def.inc"
@@ -133,6 +138,109 @@ class PROTOBUF_EXPORT FileInputStream final : public ZeroCopyInputStream {
 
 // ===================================================================
 
+// A ZeroCopyInputStream which reads from a file descriptor ahead of the
+// reader.
+//
+// The stream keeps up to `prefetch_depth` blocks in flight: each block is
+// filled by a positional read (pread()) run on `executor`, and Next()
+// returns blocks as their reads complete.  Reads may run concurrently with
+// each other and with the stream's caller.  Parsing a large file thus
+// overlaps with disk I/O instead of blocking on every read().
+//
+// File descriptors that cannot seek (pipes, sockets) and streams created
+// without an executor read synchronously from Next(), like FileInputStream.
+//
+// Reads do not move the file offset while the stream is alive.  On
+// destruction the offset is set to just past the last byte consumed.
+class PROTOBUF_EXPORT PrefetchingFileInputStream final
+    : public ZeroCopyInputStream {
+ public:
+  // Creates a stream that reads from the given Unix file descriptor,
+  // starting at its current offset.  If a block_size is given, it specifies
+  // the number of bytes read by each prefetch and returned with each call to
+  // Next().  Otherwise, a reasonable default is used.
+  PrefetchingFileInputStream(int file_descriptor, internal::Executor executor,
+                             int prefetch_depth = 4, int block_size = -1);
+  PrefetchingFileInputStream(const PrefetchingFileInputStream&) = delete;
+  PrefetchingFileInputStream& operator=(const PrefetchingFileInputStream&) =
+      delete;
+
+  // Waits for outstanding reads to finish.
+  ~PrefetchingFileInputStream() override;
+
+  // Waits for outstanding reads and closes the underlying file.  Returns
+  // false if an error occurs; use GetErrno() to examine the error.  Even if
+  // an error occurs, the file descriptor is closed when this returns.
+  bool Close();
+
+  // By default, the file descriptor is not closed when the stream is
+  // destroyed.  Call SetCloseOnDelete(true) to change that.  WARNING:
+  // This leaves no way for the caller to detect if close() fails.  If
+  // detecting close() errors is important to you, you should arrange
+  // to close the descriptor yourself.
+  void SetCloseOnDelete(bool value) { close_on_delete_ = value; }
+
+  // If an I/O error has occurred on this file descriptor, this is the
+  // errno from that error.  Otherwise, this is zero.  Once an error
+  // occurs, the stream is broken and all subsequent operations will
+  // fail.
+  int GetErrno() const { return errno_; }
+
+  // implements ZeroCopyInputStream ----------------------------------
+  bool Next(const void** data, int* size) override;
+  void BackUp(int count) override;
+  bool Skip(int count) override;
+  int64_t ByteCount() const override;
+
+ private:
+  struct Block {
+    PrefetchingFileInputStream* stream;
+    std::unique_ptr<char[]> data;
+    int64_t offset;
+    // Results, valid once `done` has been notified.
+    int size;
+    int error;
+    bool eof;
+    // Set while a read is outstanding or its result unconsumed.
+    std::unique_ptr<absl::Notification> done;
+  };
+
+  // Starts filling `block` with the next range of the file.
+  void Submit(Block* block);
+  // Fills a block; runs on the executor.
+  static void ReadBlock(void* block);
+  // Waits for all outstanding reads.
+  void WaitAll();
+
+  // The file descriptor.
+  const int file_;
+  bool close_on_delete_;
+  bool is_closed_;
+
+  // The errno of the I/O error, if one has occurred.  Otherwise, zero.
+  int errno_;
+
+  const internal::Executor executor_;
+  const int block_size_;
+  // Whether reads can be positional and run ahead of the reader.
+  bool seekable_;
+  // File offset the stream started at and the offset of the next read.
+  int64_t start_offset_;
+  int64_t next_offset_;
+  // Set once a read hit end of file or failed; no more reads are submitted.
+  bool stop_reading_;
+
+  // Ring of blocks.  `head_` is the block returned by the last Next(), or the
+  // next one to be returned if `current_` is null.
+  std::vector<Block> blocks_;
+  size_t head_;
+  Block* current_;
+  int backup_bytes_;
+  int64_t position_;
+};
+
+// ===================================================================
+
 // A ZeroCopyOutputStream which writes to a file descriptor.
 //
 // FileOutputStream is preferred over using an ofstream with
@@ -202,6 +310,110 @@ class PROTOBUF_EXPORT FileOutputStream final
 
 // ===================================================================
 
+// A ZeroCopyOutputStream which writes to a file descriptor using vectored
+// writes.
+//
+// Unlike FileOutputStream, which copies everything into a single buffer,
+// this stream keeps a list of pending buffers and hands them to the kernel
+// with writev(), which works for both files and sockets.  Data written via
+// WriteAliasedRaw() and large Cords written via WriteCord() are not copied:
+// their memory is referenced directly until the next flush.  When
+// serializing through a CodedOutputStream, call EnableAliasing(true) so that
+// large string and bytes fields are written through WriteAliasedRaw().
+//
+// Memory passed to WriteAliasedRaw() must remain valid until Flush() or
+// Close() returns, or until the stream is destroyed.
+class PROTOBUF_EXPORT VectoredFileOutputStream final
+    : public ZeroCopyOutputStream {
+ public:
+  // Creates a stream that writes to the given Unix file descriptor.
+  // If a block_size is given, it specifies the size of the buffers
+  // that should be returned by Next().  Otherwise, a reasonable default
+  // is used.
+  explicit VectoredFileOutputStream(int file_descriptor, int block_size = -1);
+  VectoredFileOutputStream(const VectoredFileOutputStream&) = delete;
+  VectoredFileOutputStream& operator=(const VectoredFileOutputStream&) =
+      delete;
+
+  ~VectoredFileOutputStream() override;
+
+  // Writes all pending buffers to the file descriptor.  Returns false if an
+  // error occurs; use GetErrno() to examine the error.
+  bool Flush();
+
+  // Flushes any buffers and closes the underlying file.  Returns false if
+  // an error occurs during the process; use GetErrno() to examine the error.
+  // Even if an error occurs, the file descriptor is closed when this returns.
+  bool Close();
+
+  // By default, the file descriptor is not closed when the stream is
+  // destroyed.  Call SetCloseOnDelete(true) to change that.  WARNING:
+  // This leaves no way for the caller to detect if close() fails.  If
+  // detecting close() errors is important to you, you should arrange
+  // to close the descriptor yourself.
+  void SetCloseOnDelete(bool value) { close_on_delete_ = value; }
+
+  // If an I/O error has occurred on this file descriptor, this is the
+  // errno from that error.  Otherwise, this is zero.  Once an error
+  // occurs, the stream is broken and all subsequent operations will
+  // fail.
+  int GetErrno() const { return errno_; }
+
+  // implements ZeroCopyOutputStream ---------------------------------
+  bool Next(void** data, int* size) override;
+  void BackUp(int count) override;
+  int64_t ByteCount() const override;
+  bool WriteAliasedRaw(const void* data, int size) override;
+  bool AllowsAliasing() const override { return true; }
+  bool WriteCord(const absl::Cord& cord) override;
+
+ private:
+  struct Slice {
+    const char* data;
+    size_t size;
+  };
+
+  // Appends `size` bytes at `data` to the pending slices without copying.
+  // The caller must have made room for a new slice.
+  void AppendSlice(const char* data, size_t size);
+  // Like AppendSlice(), but flushes first if there is no room for a slice.
+  bool AppendAliasedSlice(const char* data, size_t size);
+  // Copies `size` bytes at `data` into owned buffers.
+  bool CopyToBuffers(const char* data, size_t size);
+  // Writes `slices_` to the file descriptor, retrying on partial writes.
+  bool WriteSlices();
+
+  // The file descriptor.
+  const int file_;
+  bool close_on_delete_;
+  bool is_closed_;
+  bool failed_;
+
+  // The errno of the I/O error, if one has occurred.  Otherwise, zero.
+  int errno_;
+
+  // Size of the owned buffers returned by Next().
+  const int block_size_;
+
+  // Data waiting to be written, in order.
+  std::vector<Slice> slices_;
+  size_t pending_bytes_;
+  // Bytes written to the file descriptor by previous flushes.
+  int64_t flushed_bytes_;
+
+  // Owned buffers.  The first `blocks_used_` of them hold pending data and
+  // the last of those is the buffer that Next() is currently filling, with
+  // `block_pos_` bytes handed out.
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  size_t blocks_used_;
+  int block_pos_;
+
+  // Keeps the chunks referenced by `slices_` alive until the next flush.
+  std::vector<absl::Cord> cords_;
+};
+
+// ===================================================================
+
 // A ZeroCopyInputStream which reads from a C++ istream.
 //
 // Note that for reading files (or anything represented by a file descriptor),
@@ -314,6 +526,10 @@ class PROTOBUF_EXPORT ConcatenatingInputStream final
   bool Skip(int count) override;
   int64_t ByteCount() const override;
 
+  // Forwards to each underlying stream's ReadCord() so that streams which
+  // share their data (e.g. CordInputStream) keep doing so when concatenated.
+  bool ReadCord(absl::Cord* cord, int count) override;
+
 
  private:
   // As streams are retired, streams_ is incremented and count_ is
@@ -42,7 +42,6 @@
 #include "absl/base/casts.h"
 #include "absl/log/absl_check.h"
 #include "absl/strings/cord.h"
-#include "absl/strings/internal/resize_uninitialized.h"
 
 // Must be included last
 #include "google/protobuf/port_def.inc"
@@ -159,7 +158,7 @@ bool StringOutputStream::Next(void** data, int* size) {
   // Avoid integer overflow in returned '*size'.
   new_size = std::min(new_size, old_size + std::numeric_limits<int>::max());
   // Increase the size, also make sure that it is at least kMinimumSize.
-  absl::strings_internal::STLStringResizeUninitialized(
+  internal::STLStringResizeUninitialized(
       target_,
       std::max(new_size,
                kMinimumSize + 0));  // "+ 0" works around GCC4 weirdness.
@@ -183,6 +182,118 @@ int64_t StringOutputStream::ByteCount() const {
 
 // ===================================================================
 
+bool IovecInputStream::Next(const void** data, int* size) {
+  while (pending_size_ == 0) {
+    if (index_ == iovcnt_) {
+      // We're past the last buffer.
+      last_returned_size_ = 0;  // Don't let caller back up.
+      return false;
+    }
+    absl::string_view buffer = buffer_at_(iov_, index_++);
+    pending_ = buffer.data();
+    pending_size_ = buffer.size();
+    // Append the buffers that continue it in memory, skipping empty ones.
+    while (index_ < iovcnt_) {
+      absl::string_view next = buffer_at_(iov_, index_);
+      if (!next.empty() && next.data() != pending_ + pending_size_) break;
+      pending_size_ += next.size();
+      ++index_;
+    }
+  }
+  // Avoid integer overflow in returned '*size'.
+  last_returned_size_ = static_cast<int>(
+      std::min<size_t>(pending_size_, std::numeric_limits<int>::max()));
+  *data = pending_;
+  *size = last_returned_size_;
+  pending_ += last_returned_size_;
+  pending_size_ -= last_returned_size_;
+  byte_count_ += last_returned_size_;
+  return true;
+}
+
+void IovecInputStream::BackUp(int count) {
+  ABSL_CHECK_GT(last_returned_size_, 0)
+      << "BackUp() can only be called after a successful Next().";
+  ABSL_CHECK_LE(count, last_returned_size_);
+  ABSL_CHECK_GE(count, 0);
+  pending_ -= count;
+  pending_size_ += count;
+  byte_count_ -= count;
+  last_returned_size_ = 0;  // Don't let caller back up further.
+}
+
+bool IovecInputStream::Skip(int count) {
+  ABSL_CHECK_GE(count, 0);
+  const void* data;
+  int size;
+  while (count > 0) {
+    if (!Next(&data, &size)) return false;
+    if (size > count) {
+      BackUp(size - count);
+      break;
+    }
+    count -= size;
+  }
+  last_returned_size_ = 0;  // Don't let caller back up.
+  return true;
+}
+
+int64_t IovecInputStream::ByteCount() const { return byte_count_; }
+
+// ===================================================================
+
+ScatterOutputStream::ScatterOutputStream(
+    absl::Span<const absl::Span<char>> buffers)
+    : buffers_(buffers) {}
+
+bool ScatterOutputStream::Next(void** data, int* size) {
+  // Move on once the current buffer is full, skipping empty ones.
+  while (index_ < buffers_.size() && position_ == buffers_[index_].size()) {
+    prior_bytes_ += position_;
+    ++index_;
+    position_ = 0;
+  }
+  if (index_ == buffers_.size()) {
+    // We're past the last buffer.
+    last_returned_size_ = 0;  // Don't let caller back up.
+    return false;
+  }
+  // Avoid integer overflow in returned '*size'.
+  last_returned_size_ = static_cast<int>(
+      std::min<size_t>(buffers_[index_].size() - position_,
+                       std::numeric_limits<int>::max()));
+  *data = buffers_[index_].data() + position_;
+  *size = last_returned_size_;
+  position_ += last_returned_size_;
+  return true;
+}
+
+void ScatterOutputStream::BackUp(int count) {
+  ABSL_CHECK_LE(count, last_returned_size_)
+      << "BackUp() can not exceed the size of the last Next() call.";
+  ABSL_CHECK_GE(count, 0);
+  position_ -= count;
+  last_returned_size_ -= count;
+}
+
+int64_t ScatterOutputStream::ByteCount() const {
+  return prior_bytes_ + static_cast<int64_t>(position_);
+}
+
+int ScatterOutputStream::buffers_used() const {
+  return static_cast<int>(index_) + (position_ > 0 ? 1 : 0);
+}
+
+size_t ScatterOutputStream::fill(int i) const {
+  ABSL_DCHECK_GE(i, 0);
+  ABSL_DCHECK_LT(static_cast<size_t>(i), buffers_.size());
+  size_t index = static_cast<size_t>(i);
+  if (index < index_) return buffers_[index].size();
+  return index == index_ ? position_ : 0;
+}
+
+// ===================================================================
+
 int CopyingInputStream::Skip(int count) {
   char junk[4096];
   int skipped = 0;
@@ -54,6 +54,8 @@
 #include "absl/base/attributes.h"
 #include "absl/strings/cord.h"
 #include "absl/strings/cord_buffer.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "google/protobuf/io/zero_copy_stream.h"
 #include "google/protobuf/port.h"
 
@@ -103,6 +105,64 @@ class PROTOBUF_EXPORT ArrayInputStream final : public ZeroCopyInputStream {
 
 // ===================================================================
 
+// A ZeroCopyInputStream over an array of buffers that together hold the
+// input, such as the iovecs a network layer received a message into.
+//
+// `Iovec` is POSIX `struct iovec`, or any struct with the same `iov_base`
+// and `iov_len` members, e.g. the descriptors of registered receive buffers.
+// Next() returns the buffers themselves, never a copy, so the parser can
+// alias them; see MessageLite::ParseFromZeroCopyStreamAliased(). Empty
+// buffers are skipped and buffers that continue where the previous one ends,
+// such as consecutive slots of a receive ring, are returned as one: the
+// parser copies the boundary of every buffer it is handed into a patch
+// buffer, and buffers of at most 16 bytes entirely.
+//
+//   IovecInputStream input(iov, iovcnt);
+//   if (!message.ParseFromZeroCopyStream(&input)) { /* malformed */ }
+class PROTOBUF_EXPORT IovecInputStream final : public ZeroCopyInputStream {
+ public:
+  // `iov`, the array as well as the memory it points to, remains the
+  // property of the caller and must remain valid until the stream is
+  // destroyed.
+  template <typename Iovec>
+  IovecInputStream(const Iovec* iov, int iovcnt)
+      : iov_(iov), iovcnt_(iovcnt), buffer_at_(&BufferAt<Iovec>) {}
+  ~IovecInputStream() override = default;
+
+  // `IovecInputStream` is neither copiable nor assignable
+  IovecInputStream(const IovecInputStream&) = delete;
+  IovecInputStream& operator=(const IovecInputStream&) = delete;
+
+  // implements ZeroCopyInputStream ----------------------------------
+  bool Next(const void** data, int* size) override;
+  void BackUp(int count) override;
+  bool Skip(int count) override;
+  int64_t ByteCount() const override;
+
+ private:
+  template <typename Iovec>
+  static absl::string_view BufferAt(const void* iov, int i) {
+    const Iovec& buffer = static_cast<const Iovec*>(iov)[i];
+    return absl::string_view(static_cast<const char*>(buffer.iov_base),
+                             buffer.iov_len);
+  }
+
+  const void* const iov_;
+  const int iovcnt_;
+  absl::string_view (*const buffer_at_)(const void* iov, int i);
+
+  int index_ = 0;  // The next buffer to read.
+  // The bytes not yet returned from the buffers read so far, which directly
+  // follow the bytes returned last.
+  const char* pending_ = nullptr;
+  size_t pending_size_ = 0;
+  int64_t byte_count_ = 0;
+  int last_returned_size_ = 0;  // How many bytes we returned last time Next()
+                                // was called (used for error checking only).
+};
+
+// ===================================================================
+
 // A ZeroCopyOutputStream backed by an in-memory array of bytes.
 class PROTOBUF_EXPORT ArrayOutputStream final : public ZeroCopyOutputStream {
  public:
@@ -167,6 +227,59 @@ class PROTOBUF_EXPORT StringOutputStream final : public ZeroCopyOutputStream {
   std::string* target_;
 };
 
+// A ZeroCopyOutputStream that writes into a fixed list of caller-provided
+// buffers, such as memory regions pre-registered with an RDMA NIC, in order.
+// It never allocates: Next() hands out whatever is left of the current buffer
+// and then each following buffer whole, and fails once all of them are full.
+// Serializing through it (e.g. with MessageLite::SerializeToZeroCopyStream)
+// lets EpsCopyOutputStream split writes exactly at the buffer boundaries.
+//
+// Once writing is done (for a CodedOutputStream, after it is destroyed or
+// Trim()'ed), fill(i) reports how many bytes of buffers[i] hold data, so the
+// buffers can be posted as is:
+//
+//   ScatterOutputStream output(buffers);
+//   if (!message.SerializeToZeroCopyStream(&output)) { /* too small */ }
+//   for (int i = 0; i < output.buffers_used(); ++i) {
+//     Post(buffers[i].data(), output.fill(i));
+//   }
+class PROTOBUF_EXPORT ScatterOutputStream final : public ZeroCopyOutputStream {
+ public:
+  // `buffers`, the list itself as well as the memory it points to, remains
+  // the property of the caller and must remain valid until the stream is
+  // destroyed.
+  explicit ScatterOutputStream(absl::Span<const absl::Span<char>> buffers);
+  ~ScatterOutputStream() override = default;
+
+  // `ScatterOutputStream` is neither copiable nor assignable
+  ScatterOutputStream(const ScatterOutputStream&) = delete;
+  ScatterOutputStream& operator=(const ScatterOutputStream&) = delete;
+
+  // implements ZeroCopyOutputStream ---------------------------------
+  bool Next(void** data, int* size) override;
+  void BackUp(int count) override;
+  int64_t ByteCount() const override;
+
+  // The number of leading buffers that hold data; every buffer after these
+  // is untouched.
+  int buffers_used() const;
+
+  // The number of bytes written into buffers[i]. All buffers before the last
+  // used one are completely full.
+  size_t fill(int i) const;
+
+ private:
+  const absl::Span<const absl::Span<char>> buffers_;
+
+  // Index of the buffer being written, and how much of it has been written.
+  size_t index_ = 0;
+  size_t position_ = 0;
+  // Bytes in all the buffers before `index_`.
+  int64_t prior_bytes_ = 0;
+  int last_returned_size_ = 0;  // How many bytes we returned last time Next()
+                                // was called (used for error checking only).
+};
+
 // Note:  There is no StringInputStream.  Instead, just create an
 // ArrayInputStream as follows:
 //   ArrayInputStream input(str.data(), str.size());
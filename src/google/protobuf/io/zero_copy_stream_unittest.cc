@@ -77,6 +77,8 @@
 #include "absl/strings/cord_buffer.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "google/protobuf/io/chunked_input_stream.h"
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/io_win32.h"
 #include "google/protobuf/io/zero_copy_stream_impl.h"
@@ -364,6 +366,15 @@ TEST_F(IoTest, TwoSessionWrite) {
   delete[] buffer;
 }
 
+// Executors for the streams that run work off the calling thread.
+void InlineExecutor(void (*task)(void*), void* arg) { task(arg); }
+
+std::vector<std::thread>* executor_threads = nullptr;
+
+void ThreadExecutor(void (*task)(void*), void* arg) {
+  executor_threads->emplace_back(task, arg);
+}
+
 #if HAVE_ZLIB
 TEST_F(IoTest, GzipIo) {
   const int kBufferSize = 2 * 1024;
@@ -712,6 +723,169 @@ TEST_F(IoTest, GzipInputByteCountAfterClosedConcatenatedStreams) {
     EXPECT_EQ(total_size, gz_input.ByteCount());
   }
 }
+
+TEST_F(IoTest, ParallelGzipIo) {
+  for (int block_size : {7, 1000, -1}) {
+    for (int max_pending_blocks : {1, 4}) {
+      for (internal::Executor executor :
+           {internal::Executor{nullptr}, &InlineExecutor}) {
+        SCOPED_TRACE(absl::StrCat("block_size=", block_size,
+                                  " max_pending_blocks=", max_pending_blocks,
+                                  " executor=", executor != nullptr));
+        std::string compressed;
+        {
+          StringOutputStream output(&compressed);
+          ParallelGzipOutputStream::Options options;
+          options.block_size = block_size;
+          options.max_pending_blocks = max_pending_blocks;
+          options.executor = executor;
+          ParallelGzipOutputStream gzout(&output, options);
+          WriteStuffLarge(&gzout);
+          EXPECT_TRUE(gzout.Close());
+        }
+
+        // Any gzip reader can decompress the concatenated members.
+        {
+          ArrayInputStream input(compressed.data(), compressed.size(), 100);
+          GzipInputStream gzin(&input, GzipInputStream::GZIP);
+          ReadStuffLarge(&gzin);
+        }
+        {
+          ArrayInputStream input(compressed.data(), compressed.size(), 100);
+          ParallelGzipInputStream gzin(&input, executor, max_pending_blocks);
+          ReadStuffLarge(&gzin);
+          EXPECT_EQ(nullptr, gzin.ZlibErrorMessage());
+        }
+      }
+    }
+  }
+}
+
+TEST_F(IoTest, ParallelGzipIoWithThreads) {
+  std::vector<std::thread> threads;
+  executor_threads = &threads;
+
+  std::string compressed;
+  {
+    StringOutputStream output(&compressed);
+    ParallelGzipOutputStream::Options options;
+    options.block_size = 4096;
+    options.executor = &ThreadExecutor;
+    ParallelGzipOutputStream gzout(&output, options);
+    WriteStuffLarge(&gzout);
+    EXPECT_TRUE(gzout.Close());
+  }
+  {
+    ArrayInputStream input(compressed.data(), compressed.size());
+    ParallelGzipInputStream gzin(&input, &ThreadExecutor);
+    ReadStuffLarge(&gzin);
+  }
+
+  for (std::thread& thread : threads) thread.join();
+  executor_threads = nullptr;
+  // One compression and one decompression task per block.
+  EXPECT_GT(threads.size(), 2 * 200055 / 4096);
+}
+
+TEST_F(IoTest, ParallelGzipFlush) {
+  std::string compressed;
+  size_t flushed_size;
+  {
+    StringOutputStream output(&compressed);
+    ParallelGzipOutputStream gzout(&output);
+    WriteString(&gzout, "before flush, ");
+    EXPECT_TRUE(gzout.Flush());
+    // Everything written so far has reached the underlying stream.
+    flushed_size = output.ByteCount();
+    EXPECT_GT(flushed_size, 0);
+    WriteString(&gzout, "after flush");
+    EXPECT_TRUE(gzout.Close());
+    EXPECT_EQ(25, gzout.ByteCount());
+  }
+  EXPECT_GT(compressed.size(), flushed_size);
+
+  {
+    ArrayInputStream input(compressed.data(), flushed_size);
+    ParallelGzipInputStream gzin(&input);
+    ReadString(&gzin, "before flush, ");
+  }
+  {
+    ArrayInputStream input(compressed.data(), compressed.size());
+    ParallelGzipInputStream gzin(&input);
+    ReadString(&gzin, "before flush, after flush");
+    EXPECT_EQ(25, gzin.ByteCount());
+  }
+}
+
+TEST_F(IoTest, ParallelGzipEmpty) {
+  std::string compressed;
+  {
+    StringOutputStream output(&compressed);
+    ParallelGzipOutputStream gzout(&output);
+    EXPECT_TRUE(gzout.Close());
+  }
+  EXPECT_FALSE(compressed.empty());
+
+  uint8_t byte;
+  {
+    ArrayInputStream input(compressed.data(), compressed.size());
+    GzipInputStream gzin(&input);
+    EXPECT_EQ(ReadFromInput(&gzin, &byte, 1), 0);
+    EXPECT_EQ(0, gzin.ByteCount());
+  }
+  {
+    ArrayInputStream input(compressed.data(), compressed.size());
+    ParallelGzipInputStream gzin(&input);
+    EXPECT_EQ(ReadFromInput(&gzin, &byte, 1), 0);
+    EXPECT_EQ(nullptr, gzin.ZlibErrorMessage());
+  }
+}
+
+TEST_F(IoTest, ParallelGzipInputRejectsOtherGzip) {
+  std::string compressed =
+      Compress("abcdefghijklmnopqrstuvwxyz", GzipOutputStream::Options());
+  ArrayInputStream input(compressed.data(), compressed.size());
+  ParallelGzipInputStream gzin(&input);
+  const void* data;
+  int size;
+  EXPECT_FALSE(gzin.Next(&data, &size));
+  EXPECT_EQ(Z_DATA_ERROR, gzin.ZlibErrorCode());
+  EXPECT_NE(nullptr, gzin.ZlibErrorMessage());
+}
+
+TEST_F(IoTest, ParallelGzipInputDetectsCorruption) {
+  std::string compressed;
+  {
+    StringOutputStream output(&compressed);
+    ParallelGzipOutputStream gzout(&output);
+    WriteStuffLarge(&gzout);
+    EXPECT_TRUE(gzout.Close());
+  }
+
+  // Truncated input.
+  {
+    ArrayInputStream input(compressed.data(), compressed.size() - 1);
+    ParallelGzipInputStream gzin(&input, &InlineExecutor);
+    const void* data;
+    int size;
+    while (gzin.Next(&data, &size)) {
+    }
+    EXPECT_EQ(Z_DATA_ERROR, gzin.ZlibErrorCode());
+  }
+
+  // Corrupted trailer checksum.
+  compressed[compressed.size() - 8] ^= 1;
+  {
+    ArrayInputStream input(compressed.data(), compressed.size());
+    ParallelGzipInputStream gzin(&input, &InlineExecutor);
+    const void* data;
+    int size;
+    while (gzin.Next(&data, &size)) {
+    }
+    EXPECT_EQ(Z_DATA_ERROR, gzin.ZlibErrorCode());
+    EXPECT_LT(gzin.ByteCount(), 200055);
+  }
+}
 #endif
 
 // There is no string input, only string output.  Also, it doesn't support
@@ -729,6 +903,161 @@ TEST_F(IoTest, StringIo) {
   }
 }
 
+// Splits `buffer` into consecutive pieces of the given sizes.
+std::vector<absl::Span<char>> SplitBuffer(char* buffer,
+                                          std::vector<size_t> sizes) {
+  std::vector<absl::Span<char>> pieces;
+  for (size_t size : sizes) {
+    pieces.emplace_back(buffer, size);
+    buffer += size;
+  }
+  return pieces;
+}
+
+// Concatenates the filled part of each buffer of `output`.
+std::string Gather(const ScatterOutputStream& output,
+                   const std::vector<absl::Span<char>>& buffers) {
+  std::string result;
+  for (int i = 0; i < output.buffers_used(); ++i) {
+    result.append(buffers[i].data(), output.fill(i));
+  }
+  return result;
+}
+
+TEST_F(IoTest, ScatterIo) {
+  char buffer[256];
+  for (int i = 0; i < kBlockSizeCount; i++) {
+    if (kBlockSizes[i] <= 0) continue;
+    std::vector<absl::Span<char>> buffers = SplitBuffer(
+        buffer, std::vector<size_t>(sizeof(buffer) / kBlockSizes[i],
+                                    kBlockSizes[i]));
+    ScatterOutputStream output(buffers);
+    int size = WriteStuff(&output);
+    std::string written = Gather(output, buffers);
+    EXPECT_EQ(written.size(), size);
+    ArrayInputStream input(written.data(), written.size());
+    ReadStuff(&input);
+  }
+}
+
+TEST_F(IoTest, ScatterIoCodedStreamFillsBuffersExactly) {
+  std::string expected;
+  {
+    StringOutputStream output(&expected);
+    CodedOutputStream coded(&output);
+    coded.WriteVarint32(300);
+    coded.WriteString(std::string(500, 'x'));
+    coded.WriteLittleEndian64(0x0102030405060708);
+    coded.WriteString("tail");
+  }
+
+  // Buffers around and below the coded stream's 16 byte slop, and an empty
+  // one, followed by spare room that must be left untouched.
+  char buffer[1024];
+  memset(buffer, '-', sizeof(buffer));
+  std::vector<absl::Span<char>> buffers =
+      SplitBuffer(buffer, {1, 0, 3, 15, 16, 17, 64, 400, 500});
+  ScatterOutputStream output(buffers);
+  {
+    CodedOutputStream coded(&output);
+    coded.WriteVarint32(300);
+    coded.WriteString(std::string(500, 'x'));
+    coded.WriteLittleEndian64(0x0102030405060708);
+    coded.WriteString("tail");
+    EXPECT_FALSE(coded.HadError());
+  }
+  EXPECT_EQ(output.ByteCount(), expected.size());
+  EXPECT_EQ(Gather(output, buffers), expected);
+
+  ASSERT_EQ(output.buffers_used(), 8);
+  for (int i = 0; i < 7; ++i) {
+    EXPECT_EQ(output.fill(i), buffers[i].size()) << i;
+  }
+  EXPECT_EQ(output.fill(8), 0);
+  size_t used = 0;
+  for (int i = 0; i < 8; ++i) used += output.fill(i);
+  EXPECT_EQ(std::string(buffer + used, sizeof(buffer) - used),
+            std::string(sizeof(buffer) - used, '-'));
+}
+
+TEST_F(IoTest, ScatterIoFailsWhenFull) {
+  char buffer[64];
+  std::vector<absl::Span<char>> buffers = SplitBuffer(buffer, {20, 20});
+  ScatterOutputStream output(buffers);
+  {
+    CodedOutputStream coded(&output);
+    coded.WriteString(std::string(41, 'x'));
+    EXPECT_TRUE(coded.HadError());
+  }
+  EXPECT_EQ(output.buffers_used(), 2);
+  EXPECT_EQ(output.ByteCount(), 40);
+
+  void* data;
+  int size;
+  EXPECT_FALSE(output.Next(&data, &size));
+}
+
+// Laid out like POSIX struct iovec.
+struct TestIovec {
+  void* iov_base;
+  size_t iov_len;
+};
+
+TEST_F(IoTest, IovecIo) {
+  char buffer[256];
+  int size;
+  {
+    ArrayOutputStream output(buffer, sizeof(buffer));
+    size = WriteStuff(&output);
+  }
+  for (int i = 0; i < kBlockSizeCount; i++) {
+    if (kBlockSizes[i] <= 0) continue;
+    // Every block in memory of its own, and all of them in place.
+    std::vector<std::string> blocks;
+    std::vector<TestIovec> copied;
+    std::vector<TestIovec> in_place;
+    for (int offset = 0; offset < size; offset += kBlockSizes[i]) {
+      int block_size = std::min(kBlockSizes[i], size - offset);
+      blocks.emplace_back(buffer + offset, block_size);
+      in_place.push_back({buffer + offset, static_cast<size_t>(block_size)});
+    }
+    for (std::string& block : blocks) {
+      copied.push_back({&block[0], block.size()});
+    }
+    {
+      IovecInputStream input(copied.data(), copied.size());
+      ReadStuff(&input);
+    }
+    {
+      IovecInputStream input(in_place.data(), in_place.size());
+      ReadStuff(&input);
+    }
+  }
+}
+
+TEST_F(IoTest, IovecIoJoinsContiguousBuffers) {
+  char buffer[] = "0123456789";
+  char other[] = "abc";
+  TestIovec iov[] = {{nullptr, 0},    {buffer, 3}, {buffer + 3, 0},
+                     {buffer + 3, 5}, {other, 3},  {buffer + 8, 2}};
+  IovecInputStream input(iov, ABSL_ARRAYSIZE(iov));
+
+  const void* data;
+  int size;
+  ASSERT_TRUE(input.Next(&data, &size));
+  EXPECT_EQ(absl::string_view(static_cast<const char*>(data), size),
+            "01234567");
+  input.BackUp(2);
+  EXPECT_EQ(input.ByteCount(), 6);
+  ASSERT_TRUE(input.Next(&data, &size));
+  EXPECT_EQ(absl::string_view(static_cast<const char*>(data), size), "67");
+  EXPECT_TRUE(input.Skip(4));
+  ASSERT_TRUE(input.Next(&data, &size));
+  EXPECT_EQ(absl::string_view(static_cast<const char*>(data), size), "9");
+  EXPECT_EQ(input.ByteCount(), 13);
+  EXPECT_FALSE(input.Next(&data, &size));
+  EXPECT_FALSE(input.Skip(1));
+}
 
 TEST(DefaultReadCordTest, ReadSmallCord) {
   std::string source = "abcdefghijk";
@@ -1455,6 +1784,205 @@ TEST_F(IoTest, FileIo) {
   }
 }
 
+TEST_F(IoTest, VectoredFileIo) {
+  std::string filename =
+      absl::StrCat(TestTempDir(), "/zero_copy_stream_test_file");
+
+  for (int i = 0; i < kBlockSizeCount; i++) {
+    for (int j = 0; j < kBlockSizeCount; j++) {
+      int file =
+          open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0777);
+      ASSERT_GE(file, 0);
+
+      {
+        VectoredFileOutputStream output(file, kBlockSizes[i]);
+        WriteStuff(&output);
+        EXPECT_EQ(0, output.GetErrno());
+      }
+
+      ASSERT_NE(lseek(file, 0, SEEK_SET), (off_t)-1);
+
+      {
+        FileInputStream input(file, kBlockSizes[j]);
+        ReadStuff(&input);
+        EXPECT_EQ(0, input.GetErrno());
+      }
+
+      close(file);
+    }
+  }
+}
+
+TEST_F(IoTest, VectoredFileIoLarge) {
+  std::string filename =
+      absl::StrCat(TestTempDir(), "/zero_copy_stream_test_file");
+
+  for (int i = 0; i < kBlockSizeCount; i++) {
+    int file =
+        open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0777);
+    ASSERT_GE(file, 0);
+
+    {
+      VectoredFileOutputStream output(file, kBlockSizes[i]);
+      WriteStuffLarge(&output);
+      EXPECT_TRUE(output.Flush());
+    }
+
+    ASSERT_NE(lseek(file, 0, SEEK_SET), (off_t)-1);
+
+    {
+      FileInputStream input(file);
+      ReadStuffLarge(&input);
+    }
+
+    close(file);
+  }
+}
+
+// Aliased data and Cord chunks are referenced, not copied, so they must reach
+// the file in order with the buffered data around them.
+TEST_F(IoTest, VectoredFileAliasedAndCordWrites) {
+  std::string filename =
+      absl::StrCat(TestTempDir(), "/zero_copy_stream_test_file");
+  int file =
+      open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0777);
+  ASSERT_GE(file, 0);
+
+  const std::string large(100000, 'x');
+  std::string small_pieces;
+  for (int i = 0; i < 3000; ++i) {
+    small_pieces.append(600, static_cast<char>('a' + i % 26));
+  }
+  // More chunks than a single writev() can take.
+  absl::Cord fragmented;
+  for (int i = 0; i < 3000; ++i) {
+    fragmented.Append(absl::MakeCordFromExternal(
+        absl::string_view(small_pieces).substr(i * 600, 600),
+        [](absl::string_view) {}));
+  }
+
+  std::string expected;
+  {
+    VectoredFileOutputStream output(file, 64);
+    EXPECT_TRUE(output.AllowsAliasing());
+
+    WriteString(&output, "head");
+    expected += "head";
+    EXPECT_TRUE(output.WriteAliasedRaw(large.data(), large.size()));
+    expected += large;
+    EXPECT_TRUE(output.WriteAliasedRaw("tiny", 4));
+    expected += "tiny";
+    EXPECT_TRUE(output.WriteCord(fragmented));
+    expected += small_pieces;
+    EXPECT_TRUE(output.WriteCord(absl::Cord("short cord")));
+    expected += "short cord";
+    WriteString(&output, "tail");
+    expected += "tail";
+
+    EXPECT_EQ(expected.size(), output.ByteCount());
+    EXPECT_TRUE(output.Close());
+    EXPECT_EQ(0, output.GetErrno());
+  }
+
+  file = open(filename.c_str(), O_RDONLY | O_BINARY);
+  ASSERT_GE(file, 0);
+  {
+    FileInputStream input(file);
+    ReadString(&input, expected);
+    uint8_t byte;
+    EXPECT_EQ(ReadFromInput(&input, &byte, 1), 0);
+  }
+  close(file);
+}
+
+TEST_F(IoTest, PrefetchingFileIo) {
+  std::string filename =
+      absl::StrCat(TestTempDir(), "/zero_copy_stream_test_file");
+
+  for (int i = 0; i < kBlockSizeCount; i++) {
+    for (int j = 0; j < kBlockSizeCount; j++) {
+      int file =
+          open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0777);
+      ASSERT_GE(file, 0);
+
+      {
+        FileOutputStream output(file, kBlockSizes[i]);
+        WriteStuff(&output);
+        EXPECT_EQ(0, output.GetErrno());
+      }
+
+      ASSERT_NE(lseek(file, 0, SEEK_SET), (off_t)-1);
+
+      {
+        PrefetchingFileInputStream input(file, &InlineExecutor, 3,
+                                         kBlockSizes[j]);
+        ReadStuff(&input);
+        EXPECT_EQ(0, input.GetErrno());
+      }
+
+      close(file);
+    }
+  }
+}
+
+TEST_F(IoTest, PrefetchingFileIoLargeWithThreads) {
+  std::string filename =
+      absl::StrCat(TestTempDir(), "/zero_copy_stream_test_file");
+  int file =
+      open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0777);
+  ASSERT_GE(file, 0);
+  {
+    FileOutputStream output(file);
+    WriteStuffLarge(&output);
+  }
+
+  for (int depth : {1, 2, 8}) {
+    ASSERT_NE(lseek(file, 0, SEEK_SET), (off_t)-1);
+    std::vector<std::thread> threads;
+    executor_threads = &threads;
+    {
+      PrefetchingFileInputStream input(file, &ThreadExecutor, depth, 1000);
+      ReadStuffLarge(&input);
+      EXPECT_EQ(0, input.GetErrno());
+    }
+    for (std::thread& thread : threads) thread.join();
+    executor_threads = nullptr;
+    EXPECT_GT(threads.size(), 200000 / 1000);
+
+    // The file offset ends up just past the data that was read.
+    EXPECT_EQ(lseek(file, 0, SEEK_CUR), 200055);
+  }
+
+  close(file);
+}
+
+TEST_F(IoTest, PrefetchingFileRestoresOffset) {
+  std::string filename =
+      absl::StrCat(TestTempDir(), "/zero_copy_stream_test_file");
+  int file =
+      open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0777);
+  ASSERT_GE(file, 0);
+  {
+    FileOutputStream output(file);
+    WriteStuff(&output);
+  }
+  ASSERT_NE(lseek(file, 0, SEEK_SET), (off_t)-1);
+
+  {
+    PrefetchingFileInputStream input(file, &InlineExecutor, 4, 5);
+    ReadString(&input, "Hello world!\n");
+  }
+  EXPECT_EQ(lseek(file, 0, SEEK_CUR), 13);
+
+  // A second stream picks up where the first one left off.
+  {
+    FileInputStream input(file);
+    ReadString(&input, "Some text.  ");
+  }
+
+  close(file);
+}
+
 #ifndef _WIN32
 // This tests the FileInputStream with a non blocking file. It opens a pipe in
 // non blocking mode, then starts reading it. The writing thread starts writing
@@ -1621,6 +2149,25 @@ TEST_F(IoTest, FileWriteError) {
   EXPECT_EQ(EBADF, input.GetErrno());
 }
 
+// Test that VectoredFileOutputStreams report errors correctly.
+TEST_F(IoTest, VectoredFileWriteError) {
+  MsvcDebugDisabler debug_disabler;
+
+  // -1 = invalid file descriptor.
+  VectoredFileOutputStream output(-1);
+
+  void* buffer;
+  int size;
+
+  // Nothing is written until the stream is flushed.
+  EXPECT_TRUE(output.Next(&buffer, &size));
+  EXPECT_FALSE(output.Flush());
+  EXPECT_EQ(EBADF, output.GetErrno());
+
+  // The error is permanent.
+  EXPECT_FALSE(output.Next(&buffer, &size));
+}
+
 // Pipes are not seekable, so File{Input,Output}Stream ends up doing some
 // different things to handle them.  We'll test by writing to a pipe and
 // reading back from it.
@@ -1650,6 +2197,31 @@ TEST_F(IoTest, PipeIo) {
   }
 }
 
+// Pipes can't be read positionally, so PrefetchingFileInputStream reads them
+// synchronously.
+TEST_F(IoTest, PrefetchingPipeIo) {
+  int files[2];
+
+  for (int i = 0; i < kBlockSizeCount; i++) {
+    ASSERT_EQ(pipe(files), 0);
+
+    {
+      FileOutputStream output(files[1]);
+      WriteStuff(&output);
+      EXPECT_EQ(0, output.GetErrno());
+    }
+    close(files[1]);  // Send EOF.
+
+    {
+      PrefetchingFileInputStream input(files[0], &InlineExecutor, 4,
+                                       kBlockSizes[i]);
+      ReadStuff(&input);
+      EXPECT_EQ(0, input.GetErrno());
+    }
+    close(files[0]);
+  }
+}
+
 // Test using C++ iostreams.
 TEST_F(IoTest, IostreamIo) {
   for (int i = 0; i < kBlockSizeCount; i++) {
@@ -1720,6 +2292,39 @@ TEST_F(IoTest, ConcatenatingInputStream) {
   ReadStuff(&input);
 }
 
+TEST_F(IoTest, ConcatenatingInputStreamReadCordSharesData) {
+  const std::string data1(4096, 'a');
+  const std::string data2(4096, 'b');
+  absl::Cord source1 =
+      absl::MakeCordFromExternal(data1, [](absl::string_view) {});
+  absl::Cord source2 =
+      absl::MakeCordFromExternal(data2, [](absl::string_view) {});
+  CordInputStream input1(&source1);
+  CordInputStream input2(&source2);
+  ZeroCopyInputStream* streams[] = {&input1, &input2};
+  ConcatenatingInputStream input(streams, ABSL_ARRAYSIZE(streams));
+
+  EXPECT_TRUE(input.Skip(1));
+  absl::Cord dest;
+  EXPECT_TRUE(input.ReadCord(&dest, 8000));
+  EXPECT_EQ(8001, input.ByteCount());
+  EXPECT_EQ(absl::StrCat(data1.substr(1), data2.substr(0, 8000 - 4095)),
+            dest);
+
+  // Both halves reference the source buffers rather than copies.
+  for (absl::string_view chunk : dest.Chunks()) {
+    EXPECT_TRUE((chunk.data() >= data1.data() &&
+                 chunk.data() < data1.data() + data1.size()) ||
+                (chunk.data() >= data2.data() &&
+                 chunk.data() < data2.data() + data2.size()));
+  }
+
+  absl::Cord rest;
+  EXPECT_FALSE(input.ReadCord(&rest, 1000));
+  EXPECT_EQ(std::string(191, 'b'), rest);
+  EXPECT_EQ(8192, input.ByteCount());
+}
+
 // To test LimitingInputStream, we write our golden text to a buffer, then
 // create an ArrayInputStream that contains the whole buffer (not just the
 // bytes written), then use a LimitingInputStream to limit it just to the
@@ -1759,6 +2364,44 @@ TEST_F(IoTest, LimitingInputStreamByteCount) {
   EXPECT_EQ(kHalfBufferSize - 1, input.ByteCount());
 }
 
+TEST_F(IoTest, ChunkedInputStream) {
+  const int kBufferSize = 256;
+  uint8_t buffer[kBufferSize];
+
+  for (int i = 0; i < kBlockSizeCount; i++) {
+    int size;
+    {
+      ArrayOutputStream output(buffer, kBufferSize);
+      size = WriteStuff(&output);
+    }
+    ArrayInputStream source(buffer, size, kBlockSizes[i]);
+    ChunkedInputStream<ArrayInputStream> input(&source);
+    ReadStuff(&input);
+  }
+}
+
+TEST_F(IoTest, ChunkedInputStreamCoalescesSmallChunks) {
+  using Stream = ChunkedInputStream<ArrayInputStream>;
+  const std::string data(4096, 'x');
+  const void* chunk;
+  int size;
+
+  // Small chunks are copied together, up to the size of the buffer.
+  ArrayInputStream small_source(data.data(), data.size(), 8);
+  Stream small_input(&small_source);
+  ASSERT_TRUE(small_input.Next(&chunk, &size));
+  EXPECT_EQ(size, Stream::kBufferSize);
+  EXPECT_NE(chunk, data.data());
+
+  // Large chunks are handed out as they are.
+  ArrayInputStream large_source(data.data(), data.size(),
+                                Stream::kMinChunkSize);
+  Stream large_input(&large_source);
+  ASSERT_TRUE(large_input.Next(&chunk, &size));
+  EXPECT_EQ(chunk, data.data());
+  EXPECT_EQ(size, Stream::kMinChunkSize);
+}
+
 // Check that a zero-size array doesn't confuse the code.
 TEST(ZeroSizeArray, Input) {
   ArrayInputStream input(NULL, 0);
@@ -37,17 +37,21 @@
 #include <cstdint>
 #include <cstring>
 #include <limits>
+#include <memory>
 #include <string>
 #include <utility>
 
 #include "google/protobuf/type.pb.h"
 #include "absl/algorithm/container.h"
+#include "absl/base/attributes.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/log/absl_log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/optional.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/dynamic_message.h"
@@ -149,6 +153,34 @@ using Field = typename Traits::Field;
 template <typename Traits>
 using Desc = typename Traits::Desc;
 
+// Returns the `T` that `build(desc)` made for `desc`, building it on first use,
+// or nullptr if `desc` is not from the generated pool.
+//
+// Only generated-pool descriptors live as long as the process, so only they
+// can be cached by address.  Each instantiation has its own cache.
+template <typename T, typename Build>
+const T* FindOrBuildForGeneratedPool(const Descriptor& desc, Build build) {
+  if (desc.file()->pool() != DescriptorPool::generated_pool()) {
+    return nullptr;
+  }
+
+  ABSL_CONST_INIT static absl::Mutex mu(absl::kConstInit);
+  static auto* cache =
+      new absl::flat_hash_map<const Descriptor*, std::unique_ptr<T>>();
+  {
+    absl::ReaderMutexLock lock(&mu);
+    auto it = cache->find(&desc);
+    if (it != cache->end()) {
+      return it->second.get();
+    }
+  }
+
+  std::unique_ptr<T> built = build(desc);
+  absl::MutexLock lock(&mu);
+  // If another thread got here first, keep its value.
+  return cache->try_emplace(&desc, std::move(built)).first->second.get();
+}
+
 // Traits for proto2-ish descriptors.
 struct Proto2Descriptor {
   // A descriptor for introspecting the fields of a message type.
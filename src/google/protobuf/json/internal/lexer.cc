@@ -36,6 +36,7 @@
 #include <cfloat>
 #include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <limits>
 #include <ostream>
@@ -53,6 +54,7 @@
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
 #include "google/protobuf/stubs/status_macros.h"
+#include "utf8_validity.h"
 
 // Must be included last.
 #include "google/protobuf/port_def.inc"
@@ -98,6 +100,37 @@ void HardenAgainstHyrumsLaw(absl::string_view to_obfuscate, std::string& out) {
     }
   }
 }
+
+// Returns the length of the prefix of `data` that contains no byte which is
+// significant to the string lexer: `quote`, a backslash, or a control
+// character. Bytes at or above 0x80 are not significant here; the caller
+// validates them as UTF-8 separately.
+//
+// This tests eight bytes at a time with the usual "has zero byte" bit tricks.
+size_t SpanStringChunk(absl::string_view data, char quote) {
+  constexpr uint64_t kOnes = ~uint64_t{0} / 0xff;
+  constexpr uint64_t kHighs = kOnes * 0x80;
+  const uint64_t quotes = kOnes * static_cast<uint8_t>(quote);
+  const uint64_t slashes = kOnes * static_cast<uint8_t>('\\');
+
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= data.size(); i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, data.data() + i, sizeof(word));
+    uint64_t q = word ^ quotes;
+    uint64_t s = word ^ slashes;
+    // Each term has some high bit set iff some byte of `q`/`s` is zero, or
+    // some byte of `word` is below 0x20, respectively.
+    uint64_t special = ((q - kOnes) & ~q) | ((s - kOnes) & ~s) |
+                       ((word - kOnes * 0x20) & ~word);
+    if ((special & kHighs) != 0) break;
+  }
+  for (; i < data.size(); ++i) {
+    uint8_t c = static_cast<uint8_t>(data[i]);
+    if (c == static_cast<uint8_t>(quote) || c == '\\' || c < 0x20) break;
+  }
+  return i;
+}
 }  // namespace
 
 constexpr size_t ParseOptions::kDefaultDepth;
@@ -213,24 +246,39 @@ absl::StatusOr<uint16_t> JsonLexer::ParseU16HexCodepoint() {
 absl::Status JsonLexer::SkipToToken() {
   while (true) {
     RETURN_IF_ERROR(stream_.BufferAtLeast(1).status());
-    switch (stream_.PeekChar()) {
-      case '\n':
-        RETURN_IF_ERROR(Advance(1));
+
+    // Skip all of the whitespace that is already buffered with a single
+    // Advance(), rather than going through the stream once per byte.
+    absl::string_view unread = stream_.Unread();
+    size_t skip = 0;
+    size_t line_start = absl::string_view::npos;
+    for (; skip < unread.size(); ++skip) {
+      char c = unread[skip];
+      if (c == '\n') {
         ++json_loc_.line;
-        json_loc_.col = 0;
-        break;
-      case '\r':
-      case '\t':
-      case ' ':
-        RETURN_IF_ERROR(Advance(1));
+        line_start = skip + 1;
+      } else if (c != '\r' && c != '\t' && c != ' ') {
         break;
-      default:
-        return absl::OkStatus();
+      }
+    }
+
+    RETURN_IF_ERROR(Advance(skip));
+    if (line_start != absl::string_view::npos) {
+      json_loc_.col = skip - line_start;
+    }
+    if (skip < unread.size()) {
+      return absl::OkStatus();
     }
   }
 }
 
 absl::StatusOr<LocationWith<MaybeOwnedString>> JsonLexer::ParseRawNumber() {
+  double ignored;
+  return ParseRawNumber(&ignored);
+}
+
+absl::StatusOr<LocationWith<MaybeOwnedString>> JsonLexer::ParseRawNumber(
+    double* value) {
   RETURN_IF_ERROR(SkipToToken());
 
   enum { kInt, kFraction, kExponent } state = kInt;
@@ -283,8 +331,7 @@ absl::StatusOr<LocationWith<MaybeOwnedString>> JsonLexer::ParseRawNumber() {
     return number->loc.Invalid("number cannot have trailing period");
   }
 
-  double d;
-  if (!absl::SimpleAtod(number_text, &d) || !std::isfinite(d)) {
+  if (!absl::SimpleAtod(number_text, value) || !std::isfinite(*value)) {
     return number->loc.Invalid(
         absl::StrFormat("invalid number: '%s'", number_text));
   }
@@ -308,15 +355,10 @@ absl::StatusOr<LocationWith<MaybeOwnedString>> JsonLexer::ParseRawNumber() {
 }
 
 absl::StatusOr<LocationWith<double>> JsonLexer::ParseNumber() {
-  auto number = ParseRawNumber();
-  RETURN_IF_ERROR(number.status());
-
+  // ParseRawNumber() has to convert the number to validate it anyway.
   double d;
-  if (!absl::SimpleAtod(number->value.AsView(), &d) || !std::isfinite(d)) {
-    return number->loc.Invalid(
-        absl::StrFormat("invalid number: '%s'", number->value.AsView()));
-  }
-
+  auto number = ParseRawNumber(&d);
+  RETURN_IF_ERROR(number.status());
   return LocationWith<double>{d, number->loc};
 }
 
@@ -408,6 +450,7 @@ absl::StatusOr<LocationWith<MaybeOwnedString>> JsonLexer::ParseUtf8() {
 
   JsonLocation loc = json_loc_;
   RETURN_IF_ERROR(Expect(is_single_quote ? "'" : "\""));
+  const char quote = is_single_quote ? '\'' : '"';
 
   // on_heap is empty if we do not need to heap-allocate the string.
   std::string on_heap;
@@ -415,12 +458,27 @@ absl::StatusOr<LocationWith<MaybeOwnedString>> JsonLexer::ParseUtf8() {
   while (true) {
     RETURN_IF_ERROR(stream_.BufferAtLeast(1).status());
 
+    // Consume the run of ordinary characters that is already buffered in one
+    // step, validating any non-ASCII bytes in it in bulk. Whatever this stops
+    // on (a quote, an escape, a control character, or UTF-8 that is invalid or
+    // split across chunks) is handled one character at a time below.
+    absl::string_view unread = stream_.Unread();
+    size_t run = utf8_range::SpanStructurallyValid(
+        unread.substr(0, SpanStringChunk(unread, quote)));
+    if (run > 0) {
+      if (!on_heap.empty()) {
+        on_heap.append(unread.data(), run);
+      }
+      RETURN_IF_ERROR(Advance(run));
+      RETURN_IF_ERROR(stream_.BufferAtLeast(1).status());
+    }
+
     char c = stream_.PeekChar();
     RETURN_IF_ERROR(Advance(1));
     switch (c) {
       case '"':
       case '\'': {
-        if (c != (is_single_quote ? '\'' : '"')) {
+        if (c != quote) {
           goto normal_character;
         }
 
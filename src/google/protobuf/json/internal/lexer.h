@@ -264,6 +264,9 @@ class JsonLexer {
   // `out_utf8`; returns the number of bytes written.
   absl::StatusOr<size_t> ParseUnicodeEscape(char out_utf8[4]);
 
+  // Like the public overload, but also stores the number's value in `value`.
+  absl::StatusOr<LocationWith<MaybeOwnedString>> ParseRawNumber(double* value);
+
   // Parses an alphanumeric "identifier", for use with the non-standard
   // "unquoted keys" extension.
   absl::StatusOr<LocationWith<MaybeOwnedString>> ParseBareWord();
@@ -343,6 +343,23 @@ TEST(LexerTest, Cjk) {
   });
 }
 
+TEST(LexerTest, LongString) {
+  // Long enough that runs of ordinary characters are consumed in bulk, with
+  // escapes and multi-byte characters on either side of word boundaries.
+  absl::string_view json = R"json(
+    "abcdefghijklmnop\nqrstuvwxyz-Pokémon-0123456789\u00e9-施氏食獅史"
+  )json";
+  Do(json, [](io::ZeroCopyInputStream* stream) {
+    EXPECT_THAT(Value::Parse(stream),
+                IsOkAndHolds(ValueIs<std::string>(
+                    "abcdefghijklmnop\nqrstuvwxyz-Pokémon-0123456789\u00e9-"
+                    "施氏食獅史")));
+  });
+  Bad(R"json("abcdefghijklmnopqrstuvwxyz)json");
+  BadInner("\"abcdefghijklmnop\x01qrstuvwxyz\"");
+  Bad("\"abcdefghijklmnop\xe6\x96qrstuvwxyz\"");
+}
+
 TEST(LexerTest, BrokenString) {
   Bad(R"json("broken)json");
   Bad(R"json("broken')json");
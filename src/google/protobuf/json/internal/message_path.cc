@@ -53,11 +53,14 @@ void MessagePath::Describe(std::string& out) const {
       absl::StrAppend(&out, "[", components_[i].repeated_index, "]");
     }
   }
-  absl::string_view kind_name =
-      FieldDescriptor::TypeName(components_.back().type);
-  absl::StrAppend(&out, ": ", kind_name);
+  const Component& last = components_.back();
+  FieldDescriptor::Type type = last.type;
+  absl::string_view type_name = last.type_name;
+  if (last.describer != nullptr) {
+    last.describer(last.field, type, type_name);
+  }
+  absl::StrAppend(&out, ": ", FieldDescriptor::TypeName(type));
 
-  absl::string_view type_name = components_.back().type_name;
   if (!type_name.empty()) {
     absl::StrAppend(&out, " ", type_name);
   }
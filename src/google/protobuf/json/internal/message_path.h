@@ -60,6 +60,22 @@ class MessagePath {
     return absl::MakeCleanup([this] { components_.pop_back(); });
   }
 
+  // Looks up the type and, for messages and enums, the type name of a field
+  // pushed with PushField().
+  using FieldDescriber = void (*)(const void* field,
+                                  FieldDescriptor::Type& type,
+                                  absl::string_view& type_name);
+
+  // Like Push(), but only records `field`, which must outlive the path, and
+  // leaves looking up its type to `describer`. Paths are only described when
+  // an error is reported, so this keeps the lookups off the parsing hot path.
+  auto PushField(absl::string_view field_name, const void* field,
+                 FieldDescriber describer) {
+    components_.push_back(Component{FieldDescriptor::Type{}, "", field_name,
+                                    -1, field, describer});
+    return absl::MakeCleanup([this] { components_.pop_back(); });
+  }
+
   // Increments the index of this field, indicating it is a repeated field.
   //
   // The first time this is called, the field will be marked as repeated and
@@ -74,6 +90,10 @@ class MessagePath {
     FieldDescriptor::Type type;
     absl::string_view type_name, field_name;
     int32_t repeated_index;
+    // Set by PushField(), which leaves `type` and `type_name` to be looked up
+    // by `describer`.
+    const void* field = nullptr;
+    FieldDescriber describer = nullptr;
   };
   std::vector<Component> components_;
 };
@@ -37,10 +37,12 @@
 #include <limits>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <utility>
 
 #include "google/protobuf/type.pb.h"
 #include "absl/base/attributes.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/log/absl_check.h"
 #include "absl/log/absl_log.h"
@@ -64,6 +66,8 @@
 #include "google/protobuf/json/internal/lexer.h"
 #include "google/protobuf/json/internal/parser_traits.h"
 #include "google/protobuf/message.h"
+#include "google/protobuf/rfc3339.h"
+#include "google/protobuf/struct.pb.h"
 #include "google/protobuf/util/type_resolver.h"
 #include "google/protobuf/stubs/status_macros.h"
 
@@ -395,6 +399,20 @@ absl::StatusOr<absl::optional<int32_t>> ParseEnum(JsonLexer& lex,
   return n;
 }
 
+// Pushes `field` onto the path used for error messages. Its type is only
+// looked up if an error is reported.
+template <typename Traits>
+auto PushField(JsonLexer& lex, absl::string_view name, Field<Traits> field) {
+  return lex.path().PushField(
+      name, field,
+      [](const void* f, FieldDescriptor::Type& type,
+         absl::string_view& type_name) {
+        auto field = static_cast<Field<Traits>>(f);
+        type = Traits::FieldType(field);
+        type_name = Traits::FieldTypeName(field);
+      });
+}
+
 // Mutually recursive with functions that follow.
 template <typename Traits>
 absl::Status ParseMessage(JsonLexer& lex, const Desc<Traits>& desc,
@@ -521,7 +539,7 @@ absl::Status ParseSingular(JsonLexer& lex, Field<Traits> field,
     case FieldDescriptor::TYPE_BYTES: {
       auto x = ParseStrOrBytes<Traits>(lex, field);
       RETURN_IF_ERROR(x.status());
-      Traits::SetString(field, msg, *x);
+      Traits::SetString(field, msg, *std::move(x));
       break;
     }
     case FieldDescriptor::TYPE_ENUM: {
@@ -582,7 +600,7 @@ absl::Status EmitNull(JsonLexer& lex, Field<Traits> field, Msg<Traits>& msg) {
       break;
     case FieldDescriptor::TYPE_STRING:
     case FieldDescriptor::TYPE_BYTES:
-      Traits::SetString(field, msg, "");
+      Traits::SetString(field, msg, absl::string_view());
       break;
     case FieldDescriptor::TYPE_ENUM:
       Traits::SetEnum(field, msg, 0);
@@ -805,6 +823,17 @@ absl::Status ParseTimestamp(JsonLexer& lex, const Desc<Traits>& desc,
   RETURN_IF_ERROR(str.status());
 
   absl::string_view data = str->value.AsView();
+  {
+    // Well-formed timestamps take the fixed-format path; the code below only
+    // exists to produce a precise error for everything else.
+    int64_t secs;
+    int32_t nanos;
+    if (internal::ParseRfc3339Timestamp(data, &secs, &nanos)) {
+      Traits::SetInt64(Traits::MustHaveField(desc, 1), msg, secs);
+      Traits::SetInt32(Traits::MustHaveField(desc, 2), msg, nanos);
+      return absl::OkStatus();
+    }
+  }
   if (data.size() < 20) {
     return str->loc.Invalid("timestamp string too short");
   }
@@ -837,17 +866,7 @@ absl::Status ParseTimestamp(JsonLexer& lex, const Desc<Traits>& desc,
       return str->loc.Invalid("bad seconds in timestamp");
     }
 
-    uint32_t m_adj = *mon - 3;  // March-based month.
-    uint32_t carry = m_adj > *mon ? 1 : 0;
-
-    uint32_t year_base = 4800;  // Before min year, multiple of 400.
-    uint32_t y_adj = *year + year_base - carry;
-
-    uint32_t month_days = ((m_adj + carry * 12) * 62719 + 769) / 2048;
-    uint32_t leap_days = y_adj / 4 - y_adj / 100 + y_adj / 400;
-    int32_t epoch_days =
-        y_adj * 365 + leap_days + month_days + (*day - 1) - 2472632;
-
+    int32_t epoch_days = internal::DaysSinceEpoch(*year, *mon, *day);
     secs = int64_t{epoch_days} * 86400 + *hour * 3600 + *min * 60 + *sec;
   }
 
@@ -1052,6 +1071,105 @@ absl::Status ParseAny(JsonLexer& lex, const Desc<Traits>& desc,
   }
 }
 
+// Parsers for generated google.protobuf.Struct trees. They fill in the
+// generated classes directly, so a deeply nested payload does not pay for
+// reflection, per-message seen-field sets or the map field's repeated-entry
+// form at every level. The observable behavior, including error paths, matches
+// ParseValue<ParseProto2Descriptor> and friends below.
+absl::Status ParseGeneratedStruct(JsonLexer& lex, Struct& msg);
+absl::Status ParseGeneratedList(JsonLexer& lex, ListValue& msg);
+
+absl::Status ParseGeneratedValue(JsonLexer& lex, Value& msg) {
+  auto kind = lex.PeekKind();
+  RETURN_IF_ERROR(kind.status());
+  const Descriptor& desc = *Value::descriptor();
+  auto push = [&](int number) {
+    auto field = ParseProto2Descriptor::MustHaveField(desc, number);
+    return PushField<ParseProto2Descriptor>(
+        lex, ParseProto2Descriptor::FieldName(field), field);
+  };
+  switch (*kind) {
+    case JsonLexer::kNull: {
+      auto pop = push(Value::kNullValueFieldNumber);
+      RETURN_IF_ERROR(lex.Expect("null"));
+      msg.set_null_value(NULL_VALUE);
+      break;
+    }
+    case JsonLexer::kNum: {
+      auto pop = push(Value::kNumberValueFieldNumber);
+      auto number = lex.ParseNumber();
+      RETURN_IF_ERROR(number.status());
+      msg.set_number_value(number->value);
+      break;
+    }
+    case JsonLexer::kStr: {
+      auto pop = push(Value::kStringValueFieldNumber);
+      auto str = lex.ParseUtf8();
+      RETURN_IF_ERROR(str.status());
+      msg.set_string_value(std::move(str->value.ToString()));
+      break;
+    }
+    case JsonLexer::kFalse:
+    case JsonLexer::kTrue: {
+      auto pop = push(Value::kBoolValueFieldNumber);
+      bool value = *kind == JsonLexer::kTrue;
+      RETURN_IF_ERROR(lex.Expect(value ? "true" : "false"));
+      msg.set_bool_value(value);
+      break;
+    }
+    case JsonLexer::kObj: {
+      auto pop = push(Value::kStructValueFieldNumber);
+      return ParseGeneratedStruct(lex, *msg.mutable_struct_value());
+    }
+    case JsonLexer::kArr: {
+      auto pop = push(Value::kListValueFieldNumber);
+      return ParseGeneratedList(lex, *msg.mutable_list_value());
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status ParseGeneratedStruct(JsonLexer& lex, Struct& msg) {
+  auto pop = PushField<ParseProto2Descriptor>(
+      lex, "<struct>", Struct::descriptor()->field(0));
+
+  // Structs are always cleared even if set to {}.
+  msg.clear_fields();
+  if (lex.Peek(JsonLexer::kNull)) {
+    return lex.Expect("null");
+  }
+
+  auto& fields = *msg.mutable_fields();
+  return lex.VisitObject(
+      [&](LocationWith<MaybeOwnedString>& key) -> absl::Status {
+        lex.path().NextRepeated();
+        // The map starts out empty, so it doubles as the set of keys seen.
+        auto inserted = fields.try_emplace(std::move(key.value.ToString()));
+        if (!inserted.second) {
+          return key.loc.Invalid(absl::StrFormat(
+              "got unexpectedly-repeated repeated map key: '%s'",
+              inserted.first->first));
+        }
+        return ParseGeneratedValue(lex, inserted.first->second);
+      });
+}
+
+absl::Status ParseGeneratedList(JsonLexer& lex, ListValue& msg) {
+  auto pop = PushField<ParseProto2Descriptor>(
+      lex, "<list>", ListValue::descriptor()->field(0));
+
+  // ListValues are always cleared even if set to [].
+  msg.clear_values();
+  if (lex.Peek(JsonLexer::kNull)) {
+    return lex.Expect("null");
+  }
+
+  return lex.VisitArray([&]() -> absl::Status {
+    lex.path().NextRepeated();
+    return ParseGeneratedValue(lex, *msg.add_values());
+  });
+}
+
 // These are mutually recursive with ParseValue.
 template <typename Traits>
 absl::Status ParseStructValue(JsonLexer& lex, const Desc<Traits>& desc,
@@ -1063,6 +1181,12 @@ absl::Status ParseListValue(JsonLexer& lex, const Desc<Traits>& desc,
 template <typename Traits>
 absl::Status ParseValue(JsonLexer& lex, const Desc<Traits>& desc,
                         Msg<Traits>& msg) {
+  if constexpr (std::is_same<Traits, ParseProto2Descriptor>::value) {
+    if (auto* value = Traits::template AsGenerated<Value>(msg)) {
+      return ParseGeneratedValue(lex, *value);
+    }
+  }
+
   auto kind = lex.PeekKind();
   RETURN_IF_ERROR(kind.status());
   // NOTE: The field numbers 1 through 6 are the numbers of the oneof fields
@@ -1071,9 +1195,7 @@ absl::Status ParseValue(JsonLexer& lex, const Desc<Traits>& desc,
   switch (*kind) {
     case JsonLexer::kNull: {
       auto field = Traits::MustHaveField(desc, 1);
-      auto pop =
-          lex.path().Push(Traits::FieldName(field), Traits::FieldType(field),
-                          Traits::FieldTypeName(field));
+      auto pop = PushField<Traits>(lex, Traits::FieldName(field), field);
 
       RETURN_IF_ERROR(lex.Expect("null"));
       Traits::SetEnum(field, msg, 0);
@@ -1081,9 +1203,7 @@ absl::Status ParseValue(JsonLexer& lex, const Desc<Traits>& desc,
     }
     case JsonLexer::kNum: {
       auto field = Traits::MustHaveField(desc, 2);
-      auto pop =
-          lex.path().Push(Traits::FieldName(field), Traits::FieldType(field),
-                          Traits::FieldTypeName(field));
+      auto pop = PushField<Traits>(lex, Traits::FieldName(field), field);
 
       auto number = lex.ParseNumber();
       RETURN_IF_ERROR(number.status());
@@ -1092,9 +1212,7 @@ absl::Status ParseValue(JsonLexer& lex, const Desc<Traits>& desc,
     }
     case JsonLexer::kStr: {
       auto field = Traits::MustHaveField(desc, 3);
-      auto pop =
-          lex.path().Push(Traits::FieldName(field), Traits::FieldType(field),
-                          Traits::FieldTypeName(field));
+      auto pop = PushField<Traits>(lex, Traits::FieldName(field), field);
 
       auto str = lex.ParseUtf8();
       RETURN_IF_ERROR(str.status());
@@ -1104,9 +1222,7 @@ absl::Status ParseValue(JsonLexer& lex, const Desc<Traits>& desc,
     case JsonLexer::kFalse:
     case JsonLexer::kTrue: {
       auto field = Traits::MustHaveField(desc, 4);
-      auto pop =
-          lex.path().Push(Traits::FieldName(field), Traits::FieldType(field),
-                          Traits::FieldTypeName(field));
+      auto pop = PushField<Traits>(lex, Traits::FieldName(field), field);
 
       // "Quoted" bools, including non-standard Abseil Atob bools, are not
       // supported, because all strings are treated as genuine JSON strings.
@@ -1121,9 +1237,7 @@ absl::Status ParseValue(JsonLexer& lex, const Desc<Traits>& desc,
     }
     case JsonLexer::kObj: {
       auto field = Traits::MustHaveField(desc, 5);
-      auto pop =
-          lex.path().Push(Traits::FieldName(field), Traits::FieldType(field),
-                          Traits::FieldTypeName(field));
+      auto pop = PushField<Traits>(lex, Traits::FieldName(field), field);
 
       return Traits::NewMsg(field, msg, [&](auto& desc, auto& msg) {
         return ParseStructValue<Traits>(lex, desc, msg);
@@ -1131,9 +1245,7 @@ absl::Status ParseValue(JsonLexer& lex, const Desc<Traits>& desc,
     }
     case JsonLexer::kArr: {
       auto field = Traits::MustHaveField(desc, 6);
-      auto pop =
-          lex.path().Push(Traits::FieldName(field), Traits::FieldType(field),
-                          Traits::FieldTypeName(field));
+      auto pop = PushField<Traits>(lex, Traits::FieldName(field), field);
 
       return Traits::NewMsg(field, msg, [&](auto& desc, auto& msg) {
         return ParseListValue<Traits>(lex, desc, msg);
@@ -1147,9 +1259,14 @@ absl::Status ParseValue(JsonLexer& lex, const Desc<Traits>& desc,
 template <typename Traits>
 absl::Status ParseStructValue(JsonLexer& lex, const Desc<Traits>& desc,
                               Msg<Traits>& msg) {
+  if constexpr (std::is_same<Traits, ParseProto2Descriptor>::value) {
+    if (auto* value = Traits::template AsGenerated<Struct>(msg)) {
+      return ParseGeneratedStruct(lex, *value);
+    }
+  }
+
   auto entry_field = Traits::MustHaveField(desc, 1);
-  auto pop = lex.path().Push("<struct>", FieldDescriptor::TYPE_MESSAGE,
-                             Traits::FieldTypeName(entry_field));
+  auto pop = PushField<Traits>(lex, "<struct>", entry_field);
 
   // Structs are always cleared even if set to {}.
   Traits::RecordAsSeen(entry_field, msg);
@@ -1165,9 +1282,14 @@ absl::Status ParseStructValue(JsonLexer& lex, const Desc<Traits>& desc,
 template <typename Traits>
 absl::Status ParseListValue(JsonLexer& lex, const Desc<Traits>& desc,
                             Msg<Traits>& msg) {
+  if constexpr (std::is_same<Traits, ParseProto2Descriptor>::value) {
+    if (auto* value = Traits::template AsGenerated<ListValue>(msg)) {
+      return ParseGeneratedList(lex, *value);
+    }
+  }
+
   auto entry_field = Traits::MustHaveField(desc, 1);
-  auto pop = lex.path().Push("<list>", FieldDescriptor::TYPE_MESSAGE,
-                             Traits::FieldTypeName(entry_field));
+  auto pop = PushField<Traits>(lex, "<list>", entry_field);
 
   // ListValues are always cleared even if set to [].
   Traits::RecordAsSeen(entry_field, msg);
@@ -1207,8 +1329,7 @@ absl::Status ParseField(JsonLexer& lex, const Desc<Traits>& desc,
     return lex.SkipValue();
   }
 
-  auto pop = lex.path().Push(name, Traits::FieldType(*field),
-                             Traits::FieldTypeName(*field));
+  auto pop = PushField<Traits>(lex, name, *field);
 
   if (Traits::HasParsed(
           *field, msg,
@@ -1301,6 +1422,48 @@ absl::Status ParseMessage(JsonLexer& lex, const Desc<Traits>& desc,
 }
 }  // namespace
 
+absl::optional<const FieldDescriptor*> ParseProto2Descriptor::FieldByName(
+    const Descriptor& d, absl::string_view name) {
+  // Descriptors outside of the generated pool may be destroyed, so their
+  // indices cannot be cached by address.
+  if (d.file()->pool() != DescriptorPool::generated_pool()) {
+    return Proto2Descriptor::FieldByName(d, name);
+  }
+
+  using Index = absl::flat_hash_map<absl::string_view, const FieldDescriptor*>;
+  // Objects are parsed one key at a time, so remembering the last index this
+  // thread used keeps the shared lock off the common path.
+  static thread_local const Descriptor* last_desc = nullptr;
+  static thread_local const Index* last_index = nullptr;
+  if (last_desc != &d) {
+    // Entries are added in the order Proto2Descriptor::FieldByName() tries
+    // them, so the first name to claim a key wins, as it would there.
+    auto build = [](const Descriptor& desc) {
+      auto index = std::make_unique<Index>();
+      for (int i = 0; i < desc.field_count(); ++i) {
+        index->try_emplace(desc.field(i)->camelcase_name(), desc.field(i));
+      }
+      for (int i = 0; i < desc.field_count(); ++i) {
+        index->try_emplace(desc.field(i)->name(), desc.field(i));
+      }
+      for (int i = 0; i < desc.field_count(); ++i) {
+        if (desc.field(i)->has_json_name()) {
+          index->try_emplace(desc.field(i)->json_name(), desc.field(i));
+        }
+      }
+      return index;
+    };
+    last_index = FindOrBuildForGeneratedPool<Index>(d, build);
+    last_desc = &d;
+  }
+
+  auto it = last_index->find(name);
+  if (it == last_index->end()) {
+    return absl::nullopt;
+  }
+  return it->second;
+}
+
 absl::Status JsonStringToMessage(absl::string_view input, Message* message,
                                  json_internal::ParseOptions options) {
   MessagePath path(message->GetDescriptor()->full_name());
@@ -1326,6 +1489,56 @@ absl::Status JsonStringToMessage(absl::string_view input, Message* message,
   return s;
 }
 
+absl::StatusOr<bool> JsonMessageReader::Next(Message* message) {
+  ABSL_DCHECK_EQ(message->GetDescriptor(), descriptor_);
+  if (state_ == State::kStart) {
+    if (lex_.AtEof()) {
+      state_ = State::kDone;
+      return false;
+    }
+    state_ = lex_.Peek("[") ? State::kArrayStart : State::kSequence;
+  }
+
+  switch (state_) {
+    case State::kArrayStart:
+    case State::kArray:
+      if (lex_.Peek("]")) {
+        state_ = State::kDone;
+        if (!lex_.AtEof()) {
+          return lex_.Invalid("extraneous characters after end of JSON array");
+        }
+        return false;
+      }
+      if (state_ == State::kArray) {
+        absl::Status s = lex_.Expect(",");
+        if (!s.ok()) {
+          state_ = State::kDone;
+          return s;
+        }
+      }
+      state_ = State::kArray;
+      break;
+    case State::kSequence:
+      if (lex_.AtEof()) {
+        state_ = State::kDone;
+        return false;
+      }
+      break;
+    default:
+      return false;
+  }
+
+  message->Clear();
+  ParseProto2Descriptor::Msg msg(message);
+  absl::Status s = ParseMessage<ParseProto2Descriptor>(lex_, *descriptor_, msg,
+                                                       /*any_reparse=*/false);
+  if (!s.ok()) {
+    state_ = State::kDone;
+    return s;
+  }
+  return true;
+}
+
 absl::Status JsonToBinaryStream(google::protobuf::util::TypeResolver* resolver,
                                 const std::string& type_url,
                                 io::ZeroCopyInputStream* json_input,
@@ -33,8 +33,11 @@
 
 #include <string>
 
+#include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
 #include "google/protobuf/json/internal/lexer.h"
+#include "google/protobuf/json/internal/message_path.h"
 #include "google/protobuf/message.h"
 #include "google/protobuf/util/type_resolver.h"
 
@@ -52,6 +55,39 @@ absl::Status JsonToBinaryStream(google::protobuf::util::TypeResolver* resolver,
                                 io::ZeroCopyInputStream* json_input,
                                 io::ZeroCopyOutputStream* binary_output,
                                 json_internal::ParseOptions options);
+
+// Internal version of google::protobuf::json::JsonMessageReader; see json.h for
+// details.
+class JsonMessageReader {
+ public:
+  JsonMessageReader(io::ZeroCopyInputStream* input,
+                    const Descriptor* descriptor,
+                    json_internal::ParseOptions options)
+      : descriptor_(descriptor),
+        path_(descriptor->full_name()),
+        lex_(input, options, &path_) {}
+
+  // Parses the next message into `message`. Returns false once the input is
+  // exhausted.
+  absl::StatusOr<bool> Next(Message* message);
+
+ private:
+  enum class State {
+    kStart,
+    // Just after the opening `[` of a top-level array.
+    kArrayStart,
+    // After an element of a top-level array.
+    kArray,
+    // Reading whitespace-separated values, e.g. NDJSON.
+    kSequence,
+    kDone,
+  };
+
+  const Descriptor* descriptor_;
+  MessagePath path_;
+  JsonLexer lex_;
+  State state_ = State::kStart;
+};
 }  // namespace json_internal
 }  // namespace protobuf
 }  // namespace google
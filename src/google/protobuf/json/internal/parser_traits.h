@@ -38,6 +38,7 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "google/protobuf/type.pb.h"
 #include "absl/base/attributes.h"
@@ -88,6 +89,20 @@ struct ParseProto2Descriptor : Proto2Descriptor {
     absl::flat_hash_set<int> parsed_fields_;
   };
 
+  // Like Proto2Descriptor::FieldByName(), but for types in the generated pool
+  // the camelCase, proto and custom JSON names of all fields are indexed
+  // together the first time the type is seen, so that each key costs a single
+  // hash lookup.
+  static absl::optional<Field> FieldByName(const Desc& d,
+                                           absl::string_view name);
+
+  // Returns the generated message of type T behind `msg`, or nullptr if `msg`
+  // is of another type or is a DynamicMessage.
+  template <typename T>
+  static T* AsGenerated(Msg& msg) {
+    return DynamicCastToGenerated<T>(msg.msg_);
+  }
+
   static bool HasParsed(Field f, const Msg& msg,
                         bool allow_repeated_non_oneof) {
     if (f->real_containing_oneof()) {
@@ -232,6 +247,15 @@ struct ParseProto2Descriptor : Proto2Descriptor {
     }
   }
 
+  static void SetString(Field f, Msg& msg, std::string&& x) {
+    RecordAsSeen(f, msg);
+    if (f->is_repeated()) {
+      msg.msg_->GetReflection()->AddString(msg.msg_, f, std::move(x));
+    } else {
+      msg.msg_->GetReflection()->SetString(msg.msg_, f, std::move(x));
+    }
+  }
+
   static void SetEnum(Field f, Msg& msg, int32_t x) {
     RecordAsSeen(f, msg);
     if (f->is_repeated()) {
@@ -255,9 +279,34 @@ struct ParseProto3Type : Proto3Type {
 
    private:
     friend ParseProto3Type;
+    // Creates a message nested directly inside of `parent`.
+    Msg(io::ZeroCopyOutputStream* stream, Msg& parent)
+        : stream_(stream),
+          nested_buffers_(parent.nested_buffers_),
+          depth_(parent.depth_ + 1) {}
+
+    // Returns the buffer that a message nested directly inside of this one is
+    // serialized into before it is copied here. It already has capacity from
+    // whatever was last written at this depth.
+    std::string& NestedBuffer() {
+      if (nested_buffers_->size() <= depth_) {
+        nested_buffers_->push_back(std::make_unique<std::string>());
+      }
+      std::string& buf = *(*nested_buffers_)[depth_];
+      buf.clear();
+      return buf;
+    }
+
     io::CodedOutputStream stream_;
     absl::flat_hash_set<int32_t> parsed_oneofs_indices_;
     absl::flat_hash_set<int32_t> parsed_fields_;
+
+    // One scratch buffer per level of nesting, owned by the top-level message
+    // and shared by every message below it.
+    std::vector<std::unique_ptr<std::string>> owned_nested_buffers_;
+    std::vector<std::unique_ptr<std::string>>* nested_buffers_ =
+        &owned_nested_buffers_;
+    size_t depth_ = 0;
   };
 
   static bool HasParsed(Field f, const Msg& msg,
@@ -300,14 +349,17 @@ struct ParseProto3Type : Proto3Type {
             return absl::OkStatus();
           }
 
-          std::string out;
-          io::StringOutputStream stream(&out);
-          Msg new_msg(&stream);
-          RETURN_IF_ERROR(body(desc, new_msg));
+          std::string& out = msg.NestedBuffer();
+          absl::string_view written;
+          {
+            io::StringOutputStream stream(&out);
+            Msg new_msg(&stream, msg);
+            RETURN_IF_ERROR(body(desc, new_msg));
 
-          new_msg.stream_.Trim();  // Should probably be called "Flush()".
-          absl::string_view written(
-              out.data(), static_cast<size_t>(new_msg.stream_.ByteCount()));
+            new_msg.stream_.Trim();  // Should probably be called "Flush()".
+            written = absl::string_view(
+                out.data(), static_cast<size_t>(new_msg.stream_.ByteCount()));
+          }
           SetString(f, msg, written);
           return absl::OkStatus();
         });
@@ -48,17 +48,19 @@
 #include "absl/strings/ascii.h"
 #include "absl/strings/escaping.h"
 #include "absl/strings/str_cat.h"
-#include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/dynamic_message.h"
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/zero_copy_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include "google/protobuf/json/internal/descriptor_traits.h"
 #include "google/protobuf/json/internal/unparser_traits.h"
 #include "google/protobuf/json/internal/writer.h"
 #include "google/protobuf/message.h"
+#include "google/protobuf/rfc3339.h"
+#include "google/protobuf/struct.pb.h"
 #include "google/protobuf/stubs/status_macros.h"
 
 // Must be included last.
@@ -411,9 +413,14 @@ absl::Status WriteMap(JsonWriter& writer, const Msg<Traits>& msg,
   return absl::OkStatus();
 }
 
+// Writes `field` as a key-value pair.
+//
+// If `key` is nonempty, it is written verbatim in place of the quoted field
+// name and the colon that follows it.
 template <typename Traits>
 absl::Status WriteField(JsonWriter& writer, const Msg<Traits>& msg,
-                        Field<Traits> field, bool& first) {
+                        Field<Traits> field, bool& first,
+                        absl::string_view key = {}) {
   if (!Traits::IsRepeated(field)) {  // Repeated case is handled in
                                      // WriteRepeated.
     auto is_empty = IsEmptyValue<Traits>(msg, field);
@@ -427,7 +434,9 @@ absl::Status WriteField(JsonWriter& writer, const Msg<Traits>& msg,
   writer.WriteComma(first);
   writer.NewLine();
 
-  if (Traits::IsExtension(field)) {
+  if (!key.empty()) {
+    writer.Write(key);
+  } else if (Traits::IsExtension(field)) {
     writer.Write(MakeQuoted("[", Traits::FieldFullName(field), "]"), ":");
   } else if (writer.options().preserve_proto_field_names) {
     writer.Write(MakeQuoted(Traits::FieldName(field)), ":");
@@ -471,24 +480,29 @@ absl::Status WriteField(JsonWriter& writer, const Msg<Traits>& msg,
   return WriteSingular<Traits>(writer, field, msg);
 }
 
+// Returns whether `field` should be written out for `msg`.
 template <typename Traits>
-absl::Status WriteFields(JsonWriter& writer, const Msg<Traits>& msg,
-                         const Desc<Traits>& desc, bool& first) {
+bool ShouldWriteField(JsonWriter& writer, const Msg<Traits>& msg,
+                      Field<Traits> field) {
+  bool has = Traits::GetSize(field, msg) > 0;
+  if (writer.options().always_print_primitive_fields) {
+    bool is_singular_message =
+        !Traits::IsRepeated(field) &&
+        Traits::FieldType(field) == FieldDescriptor::TYPE_MESSAGE;
+    has |= !is_singular_message && !Traits::IsOneof(field);
+  }
+  return has;
+}
+
+template <typename Traits>
+absl::Status SortAndWriteFields(JsonWriter& writer, const Msg<Traits>& msg,
+                                const Desc<Traits>& desc, bool& first) {
   std::vector<Field<Traits>> fields;
   size_t total = Traits::FieldCount(desc);
   fields.reserve(total);
   for (size_t i = 0; i < total; ++i) {
     Field<Traits> field = Traits::FieldByIndex(desc, i);
-
-    bool has = Traits::GetSize(field, msg) > 0;
-    if (writer.options().always_print_primitive_fields) {
-      bool is_singular_message =
-          !Traits::IsRepeated(field) &&
-          Traits::FieldType(field) == FieldDescriptor::TYPE_MESSAGE;
-      has |= !is_singular_message && !Traits::IsOneof(field);
-    }
-
-    if (has) {
+    if (ShouldWriteField<Traits>(writer, msg, field)) {
       fields.push_back(field);
     }
   }
@@ -508,6 +522,183 @@ absl::Status WriteFields(JsonWriter& writer, const Msg<Traits>& msg,
   return absl::OkStatus();
 }
 
+template <typename Traits>
+absl::Status WriteFields(JsonWriter& writer, const Msg<Traits>& msg,
+                         const Desc<Traits>& desc, bool& first) {
+  return SortAndWriteFields<Traits>(writer, msg, desc, first);
+}
+
+// The parts of writing a message's fields that only depend on its type: the
+// fields in number order, each with its key already quoted and escaped.
+struct FieldPlan {
+  struct Entry {
+    const FieldDescriptor* field;
+    // `"jsonName":` and `"proto_name":`, respectively.
+    std::string json_key;
+    std::string proto_key;
+  };
+  std::vector<Entry> entries;
+};
+
+std::string QuotedKey(absl::string_view name) {
+  std::string key;
+  {
+    io::StringOutputStream out(&key);
+    JsonWriter writer(&out, {});
+    writer.Write(MakeQuoted(name), ":");
+  }
+  return key;
+}
+
+std::unique_ptr<FieldPlan> BuildFieldPlan(const Descriptor& desc) {
+  auto plan = std::make_unique<FieldPlan>();
+  plan->entries.reserve(static_cast<size_t>(desc.field_count()));
+  for (int i = 0; i < desc.field_count(); ++i) {
+    const FieldDescriptor* field = desc.field(i);
+    plan->entries.push_back(
+        {field, QuotedKey(field->json_name()), QuotedKey(field->name())});
+  }
+  absl::c_sort(plan->entries, [](const auto& a, const auto& b) {
+    return a.field->number() < b.field->number();
+  });
+  return plan;
+}
+
+// Returns the plan for `desc`, or nullptr if it should not have one.
+//
+// Plans are only kept for types in the generated pool, which are what
+// MessageToJsonString() sees in practice.
+const FieldPlan* FindFieldPlan(const Descriptor& desc) {
+  return FindOrBuildForGeneratedPool<FieldPlan>(desc, BuildFieldPlan);
+}
+
+template <>
+absl::Status WriteFields<UnparseProto2Descriptor>(JsonWriter& writer,
+                                                  const Message& msg,
+                                                  const Descriptor& desc,
+                                                  bool& first) {
+  using Traits = UnparseProto2Descriptor;
+
+  // Legacy mode may rewrite keys (see WriteField()), and extensions have to be
+  // merged into the field order, so both take the general path.
+  const FieldPlan* plan = FindFieldPlan(desc);
+  if (plan == nullptr || writer.options().allow_legacy_syntax) {
+    return SortAndWriteFields<Traits>(writer, msg, desc, first);
+  }
+  if (desc.extension_range_count() > 0) {
+    std::vector<const FieldDescriptor*> extensions;
+    Traits::FindAndAppendExtensions(msg, extensions);
+    if (!extensions.empty()) {
+      return SortAndWriteFields<Traits>(writer, msg, desc, first);
+    }
+  }
+
+  bool preserve_names = writer.options().preserve_proto_field_names;
+  for (const FieldPlan::Entry& entry : plan->entries) {
+    if (!ShouldWriteField<Traits>(writer, msg, entry.field)) {
+      continue;
+    }
+    RETURN_IF_ERROR(WriteField<Traits>(
+        writer, msg, entry.field, first,
+        preserve_names ? entry.proto_key : entry.json_key));
+  }
+  return absl::OkStatus();
+}
+
+// Printers for generated google.protobuf.Struct trees. They read the generated
+// classes directly instead of going through reflection, which would otherwise
+// materialize the repeated-entry form of every nested Struct's map. The output
+// matches WriteValue<UnparseProto2Descriptor> and friends below.
+absl::Status WriteGeneratedStruct(JsonWriter& writer, const Struct& msg);
+absl::Status WriteGeneratedList(JsonWriter& writer, const ListValue& msg);
+
+// `msg` must have a kind set; empty Values are dropped by the caller.
+absl::Status WriteGeneratedValue(JsonWriter& writer, const Value& msg) {
+  switch (msg.kind_case()) {
+    case Value::kNullValue:
+      writer.Write("null");
+      break;
+    case Value::kNumberValue: {
+      double x = msg.number_value();
+      if (std::isnan(x)) {
+        return absl::InvalidArgumentError(
+            "google.protobuf.Value cannot encode double values for nan, "
+            "because it would be parsed as a string");
+      }
+      if (std::isinf(x)) {
+        return absl::InvalidArgumentError(
+            "google.protobuf.Value cannot encode double values for "
+            "infinity, because it would be parsed as a string");
+      }
+      writer.Write(x);
+      break;
+    }
+    case Value::kStringValue:
+      writer.Write(MakeQuoted(absl::string_view(msg.string_value())));
+      break;
+    case Value::kBoolValue:
+      writer.Write(msg.bool_value() ? "true" : "false");
+      break;
+    case Value::kStructValue:
+      return WriteGeneratedStruct(writer, msg.struct_value());
+    case Value::kListValue:
+      return WriteGeneratedList(writer, msg.list_value());
+    case Value::KIND_NOT_SET:
+      ABSL_LOG(FATAL) << "empty Value must be handled by the caller";
+  }
+  return absl::OkStatus();
+}
+
+absl::Status WriteGeneratedStruct(JsonWriter& writer, const Struct& msg) {
+  writer.Write("{");
+  writer.Push();
+
+  bool first = true;
+  for (const auto& entry : msg.fields()) {
+    if (entry.second.kind_case() == Value::KIND_NOT_SET) {
+      // Empty google.protobuf.Values are silently discarded.
+      continue;
+    }
+
+    writer.WriteComma(first);
+    writer.NewLine();
+    writer.Write(MakeQuoted(absl::string_view(entry.first)));
+    writer.Write(":");
+    writer.Whitespace(" ");
+    RETURN_IF_ERROR(WriteGeneratedValue(writer, entry.second));
+  }
+
+  writer.Pop();
+  if (!first) {
+    writer.NewLine();
+  }
+  writer.Write("}");
+  return absl::OkStatus();
+}
+
+absl::Status WriteGeneratedList(JsonWriter& writer, const ListValue& msg) {
+  writer.Write("[");
+  writer.Push();
+
+  bool first = true;
+  for (const Value& value : msg.values()) {
+    if (value.kind_case() == Value::KIND_NOT_SET) {
+      // Empty google.protobuf.Values are silently discarded.
+      continue;
+    }
+    writer.WriteComma(first);
+    writer.NewLine();
+    RETURN_IF_ERROR(WriteGeneratedValue(writer, value));
+  }
+
+  writer.Pop();
+  if (!first) {
+    writer.NewLine();
+  }
+  writer.Write("]");
+  return absl::OkStatus();
+}
+
 template <typename Traits>
 absl::Status WriteStructValue(JsonWriter& writer, const Msg<Traits>& msg,
                               const Desc<Traits>& desc);
@@ -518,6 +709,13 @@ absl::Status WriteListValue(JsonWriter& writer, const Msg<Traits>& msg,
 template <typename Traits>
 absl::Status WriteValue(JsonWriter& writer, const Msg<Traits>& msg,
                         const Desc<Traits>& desc, bool is_top_level) {
+  if constexpr (std::is_same<Traits, UnparseProto2Descriptor>::value) {
+    const auto* value = DynamicCastToGenerated<Value>(&msg);
+    if (value != nullptr && value->kind_case() != Value::KIND_NOT_SET) {
+      return WriteGeneratedValue(writer, *value);
+    }
+  }
+
   // NOTE: The field numbers 1 through 6 are the numbers of the oneof fields in
   // google.protobuf.Value. Conformance tests verify the correctness of these
   // numbers.
@@ -589,12 +787,22 @@ absl::Status WriteValue(JsonWriter& writer, const Msg<Traits>& msg,
 template <typename Traits>
 absl::Status WriteStructValue(JsonWriter& writer, const Msg<Traits>& msg,
                               const Desc<Traits>& desc) {
+  if constexpr (std::is_same<Traits, UnparseProto2Descriptor>::value) {
+    if (const auto* value = DynamicCastToGenerated<Struct>(&msg)) {
+      return WriteGeneratedStruct(writer, *value);
+    }
+  }
   return WriteMap<Traits>(writer, msg, Traits::MustHaveField(desc, 1));
 }
 
 template <typename Traits>
 absl::Status WriteListValue(JsonWriter& writer, const Msg<Traits>& msg,
                             const Desc<Traits>& desc) {
+  if constexpr (std::is_same<Traits, UnparseProto2Descriptor>::value) {
+    if (const auto* value = DynamicCastToGenerated<ListValue>(&msg)) {
+      return WriteGeneratedList(writer, *value);
+    }
+  }
   return WriteRepeated<Traits>(writer, msg, Traits::MustHaveField(desc, 1));
 }
 
@@ -615,50 +823,22 @@ absl::Status WriteTimestamp(JsonWriter& writer, const Msg<Traits>& msg,
         "maximum acceptable time value is 9999-12-31T23:59:59Z");
   }
 
-  // Ensure seconds is positive.
-  *secs += 62135596800;
-
   auto nanos_field = Traits::MustHaveField(desc, 2);
   auto nanos = Traits::GetSize(nanos_field, msg) > 0
                    ? Traits::GetInt32(nanos_field, msg)
                    : 0;
   RETURN_IF_ERROR(nanos.status());
 
-  // Julian Day -> Y/M/D, Algorithm from:
-  // Fliegel, H. F., and Van Flandern, T. C., "A Machine Algorithm for
-  //   Processing Calendar Dates," Communications of the Association of
-  //   Computing Machines, vol. 11 (1968), p. 657.
-  int32_t L, N, I, J, K;
-  L = static_cast<int32_t>(*secs / 86400) - 719162 + 68569 + 2440588;
-  N = 4 * L / 146097;
-  L = L - (146097 * N + 3) / 4;
-  I = 4000 * (L + 1) / 1461001;
-  L = L - 1461 * I / 4 + 31;
-  J = 80 * L / 2447;
-  K = L - 2447 * J / 80;
-  L = J / 11;
-  J = J + 2 - 12 * L;
-  I = 100 * (N - 49) + I + L;
-
-  int32_t sec = *secs % 60;
-  int32_t min = (*secs / 60) % 60;
-  int32_t hour = (*secs / 3600) % 24;
-
-  if (*nanos == 0) {
-    writer.Write(absl::StrFormat(R"("%04d-%02d-%02dT%02d:%02d:%02dZ")", I, J, K,
-                                 hour, min, sec));
-    return absl::OkStatus();
+  if (*nanos > 999999999 || *nanos < -999999999) {
+    return absl::InvalidArgumentError("timestamp nanos out of range");
   }
 
-  size_t digits = 9;
-  uint32_t frac_seconds = std::abs(*nanos);
-  while (frac_seconds % 1000 == 0) {
-    frac_seconds /= 1000;
-    digits -= 3;
-  }
-
-  writer.Write(absl::StrFormat(R"("%04d-%02d-%02dT%02d:%02d:%02d.%.*dZ")", I, J,
-                               K, hour, min, sec, digits, frac_seconds));
+  char buf[internal::kRfc3339TimestampBufferSize + 2];
+  buf[0] = '"';
+  size_t len =
+      1 + internal::FormatRfc3339Timestamp(*secs, std::abs(*nanos), buf + 1);
+  buf[len++] = '"';
+  writer.Write(absl::string_view(buf, len));
   return absl::OkStatus();
 }
 
@@ -691,21 +871,11 @@ absl::Status WriteDuration(JsonWriter& writer, const Msg<Traits>& msg,
     return absl::InvalidArgumentError("nanos and seconds signs do not match");
   }
 
-  if (*nanos == 0) {
-    writer.Write(absl::StrFormat(R"("%ds")", *secs));
-    return absl::OkStatus();
-  }
-
-  size_t digits = 9;
-  uint32_t frac_seconds = std::abs(*nanos);
-  while (frac_seconds % 1000 == 0) {
-    frac_seconds /= 1000;
-    digits -= 3;
-  }
-
-  absl::string_view sign = ((*secs < 0) || (*nanos < 0)) ? "-" : "";
-  writer.Write(absl::StrFormat(R"("%s%d.%.*ds")", sign, std::abs(*secs), digits,
-                               frac_seconds));
+  char buf[internal::kDurationBufferSize + 2];
+  buf[0] = '"';
+  size_t len = 1 + internal::FormatDuration(*secs, *nanos, buf + 1);
+  buf[len++] = '"';
+  writer.Write(absl::string_view(buf, len));
   return absl::OkStatus();
 }
 
@@ -30,9 +30,11 @@
 
 #include "google/protobuf/json/json.h"
 
+#include <memory>
 #include <string>
 
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "google/protobuf/io/zero_copy_stream.h"
 #include "google/protobuf/json/internal/parser.h"
@@ -130,6 +132,32 @@ absl::Status JsonStringToMessage(absl::string_view input, Message* message,
 
   return google::protobuf::json_internal::JsonStringToMessage(input, message, opts);
 }
+
+JsonMessageReader::JsonMessageReader(io::ZeroCopyInputStream* input,
+                                     const Descriptor* descriptor,
+                                     const ParseOptions& options) {
+  google::protobuf::json_internal::ParseOptions opts;
+  opts.ignore_unknown_fields = options.ignore_unknown_fields;
+  opts.case_insensitive_enum_parsing = options.case_insensitive_enum_parsing;
+
+  // TODO(b/234868512): Drop this setting.
+  opts.allow_legacy_syntax = true;
+
+  impl_ = std::make_unique<google::protobuf::json_internal::JsonMessageReader>(
+      input, descriptor, opts);
+}
+
+JsonMessageReader::~JsonMessageReader() = default;
+
+bool JsonMessageReader::Next(Message* message) {
+  if (!status_.ok()) return false;
+  absl::StatusOr<bool> next = impl_->Next(message);
+  if (!next.ok()) {
+    status_ = next.status();
+    return false;
+  }
+  return *next;
+}
 }  // namespace json
 }  // namespace protobuf
 }  // namespace google
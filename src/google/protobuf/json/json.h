@@ -33,10 +33,13 @@
 #ifndef GOOGLE_PROTOBUF_JSON_JSON_H__
 #define GOOGLE_PROTOBUF_JSON_JSON_H__
 
+#include <memory>
 #include <string>
 
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/io/zero_copy_stream.h"
 #include "google/protobuf/message.h"
 #include "google/protobuf/util/type_resolver.h"
 
@@ -45,6 +48,10 @@
 
 namespace google {
 namespace protobuf {
+namespace json_internal {
+class JsonMessageReader;
+}  // namespace json_internal
+
 namespace json {
 struct ParseOptions {
   // Whether to ignore unknown JSON fields during parsing
@@ -107,6 +114,45 @@ inline absl::Status JsonStringToMessage(absl::string_view input,
   return JsonStringToMessage(input, message, ParseOptions());
 }
 
+// Reads successive messages of one type from a stream of JSON: either the
+// elements of one top-level JSON array, or values separated only by
+// whitespace, such as newline-delimited JSON (NDJSON).
+//
+// The input is lexed incrementally, so memory use does not grow with the
+// length of the stream, and the lexer and parse options are set up once for
+// all messages rather than once per message.
+//
+// Example:
+//   JsonMessageReader reader(&input, Record::descriptor());
+//   Record record;
+//   while (reader.Next(&record)) {
+//     ...
+//   }
+//   if (!reader.status().ok()) ...
+class PROTOBUF_EXPORT JsonMessageReader {
+ public:
+  // `input` must outlive the reader.
+  JsonMessageReader(io::ZeroCopyInputStream* input,
+                    const Descriptor* descriptor,
+                    const ParseOptions& options = ParseOptions());
+  JsonMessageReader(const JsonMessageReader&) = delete;
+  JsonMessageReader& operator=(const JsonMessageReader&) = delete;
+  ~JsonMessageReader();
+
+  // Clears `message`, whose type must be `descriptor`, and parses the next
+  // message into it. Returns false at the end of the input or on an error,
+  // after which status() tells the two apart and no more messages are read.
+  bool Next(Message* message);
+
+  // Please note that non-OK statuses are not a stable output of this API and
+  // subject to change without notice.
+  const absl::Status& status() const { return status_; }
+
+ private:
+  std::unique_ptr<json_internal::JsonMessageReader> impl_;
+  absl::Status status_;
+};
+
 // Converts protobuf binary data to JSON.
 // The conversion will fail if:
 //   1. TypeResolver fails to resolve a type.
@@ -306,6 +306,33 @@ TEST_P(JsonTest, Camels) {
   EXPECT_THAT(ToJson(m), IsOkAndHolds(R"({"StringField":"sTRINGfIELD"})"));
 }
 
+TEST_P(JsonTest, FieldsInNumberOrder) {
+  // Declared as my_string = 11, my_int = 1, my_float = 101.
+  protobuf_unittest::TestFieldOrderings m;
+  m.set_my_string("foo");
+  m.set_my_int(1);
+  m.set_my_float(1.5);
+
+  EXPECT_THAT(ToJson(m),
+              IsOkAndHolds(R"({"myInt":"1","myString":"foo","myFloat":1.5})"));
+
+  PrintOptions options;
+  options.preserve_proto_field_names = true;
+  EXPECT_THAT(
+      ToJson(m, options),
+      IsOkAndHolds(R"({"my_int":"1","my_string":"foo","my_float":1.5})"));
+
+  if (GetParam() == Codec::kResolver) {
+    // Extensions are not supported by the resolver codec.
+    return;
+  }
+  m.SetExtension(protobuf_unittest::my_extension_int, 5);
+  EXPECT_THAT(ToJson(m),
+              IsOkAndHolds(R"({"myInt":"1",)"
+                           R"("[protobuf_unittest.my_extension_int]":5,)"
+                           R"("myString":"foo","myFloat":1.5})"));
+}
+
 TEST_P(JsonTest, EvilString) {
   auto m = ToProto<TestMessage>(R"json(
     {"string_value": ")json"
@@ -501,7 +528,7 @@ TEST_P(JsonTest, FloatPrecision) {
   v.mutable_list_value()->add_values()->set_number_value(0.8799999952316284);
 
   EXPECT_THAT(ToJson(v),
-              IsOkAndHolds("[0.99000000953674316,0.87999999523162842]"));
+              IsOkAndHolds("[0.9900000095367432,0.8799999952316284]"));
 }
 
 TEST_P(JsonTest, FloatMinMaxValue) {
@@ -1329,6 +1356,19 @@ TEST_P(JsonTest, HtmlEscape) {
           R"("\"\u003cscript\u003ealert('hello!);\u003c/script\u003e":0})"));
 }
 
+TEST_P(JsonTest, ParseAnyKindOfFieldName) {
+  // regular_value has json_name = "regular_name".
+  for (absl::string_view key : {"regular_name", "regular_value"}) {
+    auto m =
+        ToProto<proto3::TestEvilJson>(absl::StrCat("{\"", key, "\":42}"));
+    ASSERT_OK(m);
+    EXPECT_EQ(m->regular_value(), 42) << key;
+  }
+
+  EXPECT_THAT(ToProto<proto3::TestEvilJson>(R"json({"regularName":42})json"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
 TEST_P(JsonTest, FieldOrder) {
   // $ protoscope -s <<< "3: 3 22: 2 1: 1 22: 2"
   std::string out;
@@ -1354,6 +1394,74 @@ TEST_P(JsonTest, ClearPreExistingRepeatedInJsonValues) {
   EXPECT_THAT(s.fields(), IsEmpty());
 }
 
+TEST_P(JsonTest, NestedStructRoundTrip) {
+  auto s = ToProto<google::protobuf::Struct>(R"json({
+    "a": {"b": [1, "two", true, null, {"c": []}]}
+  })json");
+  ASSERT_OK(s);
+  const auto& list = s->fields().at("a").struct_value().fields().at("b");
+  ASSERT_EQ(list.list_value().values_size(), 5);
+  EXPECT_EQ(list.list_value().values(1).string_value(), "two");
+  EXPECT_TRUE(list.list_value().values(3).has_null_value());
+  EXPECT_THAT(ToJson(*s),
+              IsOkAndHolds(R"({"a":{"b":[1,"two",true,null,{"c":[]}]}})"));
+
+  EXPECT_THAT(
+      ToProto<google::protobuf::Struct>(R"json({"a": {"b": 1, "b": 2}})json"),
+      StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+// Reads all messages from `json`, fed through the reader in small chunks.
+absl::StatusOr<std::vector<int32_t>> ReadAll(absl::string_view json) {
+  io::ArrayInputStream in(json.data(), json.size(), /*block_size=*/7);
+  JsonMessageReader reader(&in, TestMessage::descriptor());
+  std::vector<int32_t> values;
+  TestMessage message;
+  while (reader.Next(&message)) {
+    values.push_back(message.int32_value());
+  }
+  RETURN_IF_ERROR(reader.status());
+  return values;
+}
+
+TEST(JsonMessageReaderTest, Ndjson) {
+  EXPECT_THAT(ReadAll("{\"int32Value\": 1}\n"
+                      "{\"int32Value\": 2, \"stringValue\": \"x\"}\n"
+                      "{}\n"
+                      "{\"int32Value\": 4}"),
+              IsOkAndHolds(ElementsAre(1, 2, 0, 4)));
+  EXPECT_THAT(ReadAll(""), IsOkAndHolds(IsEmpty()));
+  EXPECT_THAT(ReadAll("\n\n"), IsOkAndHolds(IsEmpty()));
+}
+
+TEST(JsonMessageReaderTest, Array) {
+  EXPECT_THAT(ReadAll(R"json([{"int32Value": 1}, {}, {"int32Value": 3}])json"),
+              IsOkAndHolds(ElementsAre(1, 0, 3)));
+  EXPECT_THAT(ReadAll(" [ ] "), IsOkAndHolds(IsEmpty()));
+}
+
+TEST(JsonMessageReaderTest, Errors) {
+  EXPECT_THAT(ReadAll(R"json([{"int32Value": 1} {"int32Value": 2}])json"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(ReadAll(R"json([{"int32Value": 1}] {})json"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(ReadAll(R"json({"int32Value": 1} {"unknown": 2})json"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(ReadAll(R"json([{"int32Value": 1},)json"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(JsonMessageReaderTest, StopsAfterError) {
+  absl::string_view json = R"json({"int32Value": 1} {"int32Value": "x"} {})json";
+  io::ArrayInputStream in(json.data(), json.size());
+  JsonMessageReader reader(&in, TestMessage::descriptor());
+  TestMessage message;
+  EXPECT_TRUE(reader.Next(&message));
+  EXPECT_FALSE(reader.Next(&message));
+  EXPECT_FALSE(reader.status().ok());
+  EXPECT_FALSE(reader.Next(&message));
+}
+
 }  // namespace
 }  // namespace json
 }  // namespace protobuf
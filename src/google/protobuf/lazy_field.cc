@@ -0,0 +1,233 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "google/protobuf/lazy_field.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "absl/log/absl_check.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/arena.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/message_lite.h"
+#include "google/protobuf/parse_context.h"
+#include "google/protobuf/port.h"
+#include "google/protobuf/wire_format_lite.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+
+void LazyField::Destroy() {
+  delete message_;
+  delete bytes_;
+  message_ = nullptr;
+  bytes_ = nullptr;
+  state_ = State::kCleared;
+}
+
+std::string* LazyField::MutableBytes(Arena* arena) const {
+  if (bytes_ == nullptr) bytes_ = Arena::Create<std::string>(arena);
+  return bytes_;
+}
+
+void LazyField::EnsureParsed(const MessageLite& prototype,
+                             Arena* arena) const {
+  if (state_ != State::kUnparsed) return;
+  if (message_ == nullptr) {
+    message_ = prototype.New(arena);
+  } else {
+    message_->Clear();
+  }
+  // Malformed bytes leave a partially parsed message.  The bytes are kept, so
+  // such a field still round-trips unchanged if it is never mutated.
+  message_->ParseFrom<MessageLite::kMergePartial>(*bytes_);
+  state_ = State::kParsed;
+}
+
+const MessageLite& LazyField::Get(const MessageLite& prototype,
+                                  Arena* arena) const {
+  if (state_ == State::kCleared) return prototype;
+  EnsureParsed(prototype, arena);
+  return *message_;
+}
+
+MessageLite* LazyField::Mutable(const MessageLite& prototype, Arena* arena) {
+  if (state_ == State::kCleared) {
+    if (message_ == nullptr) message_ = prototype.New(arena);
+  } else {
+    EnsureParsed(prototype, arena);
+  }
+  if (bytes_ != nullptr) bytes_->clear();
+  state_ = State::kMutated;
+  return message_;
+}
+
+void LazyField::RetainEncoding() const {
+  ABSL_DCHECK(state_ == State::kMutated);
+  // The message lives on the owner's arena, which is where the bytes go too.
+  std::string* bytes = MutableBytes(message_->GetArena());
+  const int size = message_->GetCachedSize();
+  STLStringResizeUninitialized(bytes, static_cast<size_t>(size));
+  // The bytes may later be copied into a deterministic serialization, and the
+  // size does not depend on the order, so always encode deterministically.
+  uint8_t* target = reinterpret_cast<uint8_t*>(&(*bytes)[0]);
+  io::EpsCopyOutputStream out(target, size, /*deterministic=*/true);
+  message_->_InternalSerialize(target, &out);
+  state_ = State::kParsed;
+}
+
+void LazyField::UnsafeArenaSetAllocated(MessageLite* message, Arena* arena) {
+  if (arena == nullptr) delete message_;
+  message_ = message;
+  if (bytes_ != nullptr) bytes_->clear();
+  state_ = message == nullptr ? State::kCleared : State::kMutated;
+}
+
+MessageLite* LazyField::UnsafeArenaRelease(const MessageLite& prototype,
+                                           Arena* arena) {
+  if (state_ == State::kCleared) return nullptr;
+  EnsureParsed(prototype, arena);
+  MessageLite* result = message_;
+  message_ = nullptr;
+  if (bytes_ != nullptr) bytes_->clear();
+  state_ = State::kCleared;
+  return result;
+}
+
+void LazyField::Clear() {
+  // Keep both allocations around for reuse.
+  if (message_ != nullptr) message_->Clear();
+  if (bytes_ != nullptr) bytes_->clear();
+  state_ = State::kCleared;
+}
+
+void LazyField::MergeFromBytes(absl::string_view bytes,
+                               const MessageLite& prototype, Arena* arena) {
+  switch (state_) {
+    case State::kCleared:
+      state_ = State::kUnparsed;
+      ABSL_FALLTHROUGH_INTENDED;
+    case State::kUnparsed:
+      MutableBytes(arena)->append(bytes.data(), bytes.size());
+      return;
+    case State::kParsed:
+      // Keep bytes and message in sync so the field stays untouched.
+      bytes_->append(bytes.data(), bytes.size());
+      message_->ParseFrom<MessageLite::kMergePartial>(bytes);
+      return;
+    case State::kMutated:
+      message_->ParseFrom<MessageLite::kMergePartial>(bytes);
+      return;
+  }
+}
+
+void LazyField::MergeFrom(const LazyField& other, const MessageLite& prototype,
+                          Arena* arena) {
+  ABSL_DCHECK_NE(&other, this);
+  switch (other.state_) {
+    case State::kCleared:
+      return;
+    case State::kUnparsed:
+    case State::kParsed:
+      MergeFromBytes(*other.bytes_, prototype, arena);
+      return;
+    case State::kMutated:
+      Mutable(prototype, arena)->CheckTypeAndMergeFrom(*other.message_);
+      return;
+  }
+}
+
+const char* LazyField::_InternalParse(const MessageLite& prototype,
+                                      Arena* arena, const char* ptr,
+                                      ParseContext* ctx) {
+  const int size = ReadSize(&ptr);
+  if (ptr == nullptr) return nullptr;
+  if (state_ == State::kCleared || state_ == State::kUnparsed) {
+    state_ = State::kUnparsed;
+    return ctx->AppendString(ptr, size, MutableBytes(arena));
+  }
+  std::string bytes;
+  ptr = ctx->ReadString(ptr, size, &bytes);
+  if (ptr == nullptr) return nullptr;
+  MergeFromBytes(bytes, prototype, arena);
+  return ptr;
+}
+
+bool LazyField::IsInitialized(const MessageLite& prototype,
+                              Arena* arena) const {
+  if (state_ == State::kCleared) return true;
+  EnsureParsed(prototype, arena);
+  return message_->IsInitialized();
+}
+
+size_t LazyField::ByteSizeLong() const {
+  switch (state_) {
+    case State::kCleared:
+      return 0;
+    case State::kUnparsed:
+    case State::kParsed:
+      return bytes_->size();
+    case State::kMutated:
+      return message_->ByteSizeLong();
+  }
+  return 0;
+}
+
+uint8_t* LazyField::InternalWrite(int number, uint8_t* target,
+                                  io::EpsCopyOutputStream* stream) const {
+  switch (state_) {
+    case State::kCleared:
+      return target;
+    case State::kUnparsed:
+    case State::kParsed:
+      return stream->WriteString(number, *bytes_, target);
+    case State::kMutated:
+      if (retain_encoding_) {
+        RetainEncoding();
+        return stream->WriteString(number, *bytes_, target);
+      }
+      return WireFormatLite::InternalWriteMessage(
+          number, *message_, message_->GetCachedSize(), target, stream);
+  }
+  return target;
+}
+
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
@@ -0,0 +1,183 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// This file is internal to the protocol buffer library.  Do not use it
+// directly.
+
+#ifndef GOOGLE_PROTOBUF_LAZY_FIELD_H__
+#define GOOGLE_PROTOBUF_LAZY_FIELD_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "google/protobuf/arena.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/message_lite.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+
+class ParseContext;
+
+// Storage for a singular sub-message field that is parsed on first access.
+//
+// Until the message is read, LazyField keeps the serialized bytes it was
+// parsed from.  Reading the message parses those bytes but keeps them, so a
+// message that was only read is still serialized by copying the original
+// bytes verbatim.  Mutating the message discards the bytes; from then on the
+// field behaves like an eagerly parsed sub-message.
+//
+// The owning message passes its arena and the field's default instance to
+// every call instead of LazyField storing them, which keeps the field to two
+// pointers and a state word.
+//
+// Get() parses on first use and is therefore not safe to call concurrently
+// on an unparsed field.
+//
+// With set_retain_encoding(true), the field also supports incremental
+// re-serialization: serializing a mutated message keeps the bytes written for
+// it, which returns the field to the state it is in after parsing.  Until the
+// next Mutable() marks it dirty again, ByteSizeLong() stops at the field and
+// InternalWrite() copies the bytes, so re-serializing an owner after a small
+// change re-encodes only the fields on the path to that change.
+class PROTOBUF_EXPORT LazyField {
+ public:
+  constexpr LazyField() {}
+  // Starts in the mode set_retain_encoding() selects.
+  constexpr explicit LazyField(bool retain_encoding)
+      : retain_encoding_(retain_encoding) {}
+  // Copies `other` for an owner on `arena`, keeping unparsed bytes unparsed.
+  // The copy retains encodings if `other` does.
+  LazyField(Arena* arena, const LazyField& other, const MessageLite& prototype)
+      : LazyField(other.retain_encoding_) {
+    MergeFrom(other, prototype, arena);
+  }
+  LazyField(const LazyField&) = delete;
+  LazyField& operator=(const LazyField&) = delete;
+
+  // Frees owned memory.  Must be called by the owner when not on an arena.
+  void Destroy();
+
+  // Returns true if the field holds neither bytes nor a message.
+  bool IsCleared() const { return state_ == State::kCleared; }
+  // Returns true if the field has bytes that have not been parsed yet.
+  bool IsUnparsed() const { return state_ == State::kUnparsed; }
+  // Returns true if the message was mutated since its bytes were last parsed
+  // or retained, so serializing it has to encode the message.
+  bool IsDirty() const { return state_ == State::kMutated; }
+
+  // Makes InternalWrite() keep the bytes it writes for a mutated message
+  // (see above).  Generated messages listed in the retain_lazy_encoding
+  // generator option construct their lazy fields in this mode.  Pointers that
+  // Mutable() returned before the field is serialized must not be used to
+  // modify the message afterwards, since the retained bytes would not reflect
+  // the change.  The retained bytes are always encoded deterministically, so
+  // copying them is valid for deterministic serialization too.  Serializing a
+  // dirty field in this mode is not safe concurrently with other reads of the
+  // field.
+  void set_retain_encoding(bool retain) { retain_encoding_ = retain; }
+
+  // Returns the message, parsing the stored bytes first if necessary.  A
+  // cleared field returns `prototype`.
+  const MessageLite& Get(const MessageLite& prototype, Arena* arena) const;
+  // Like Get(), but allows modification, which discards the stored bytes.
+  MessageLite* Mutable(const MessageLite& prototype, Arena* arena);
+
+  // Takes ownership of `message`, which must be on `arena`.
+  void UnsafeArenaSetAllocated(MessageLite* message, Arena* arena);
+  // Returns the message and leaves the field cleared.  The caller owns the
+  // result if `arena` is null; otherwise it is on `arena`.
+  MessageLite* UnsafeArenaRelease(const MessageLite& prototype, Arena* arena);
+
+  void Clear();
+
+  // Appends serialized bytes.  Concatenating serialized messages merges them,
+  // so this is how repeated occurrences on the wire are combined.
+  void MergeFromBytes(absl::string_view bytes, const MessageLite& prototype,
+                      Arena* arena);
+  void MergeFrom(const LazyField& other, const MessageLite& prototype,
+                 Arena* arena);
+  void Swap(LazyField* other) {
+    std::swap(state_, other->state_);
+    std::swap(message_, other->message_);
+    std::swap(bytes_, other->bytes_);
+  }
+
+  // Parses the length-delimited payload at `ptr`, whose tag has already been
+  // consumed.
+  const char* _InternalParse(const MessageLite& prototype, Arena* arena,
+                             const char* ptr, ParseContext* ctx);
+
+  bool IsInitialized(const MessageLite& prototype, Arena* arena) const;
+
+  // Size of the payload, excluding tag and length.  Caches the message size
+  // when it has to be computed.
+  size_t ByteSizeLong() const;
+  // Writes the field, tag and length included.  Untouched bytes are copied
+  // verbatim.  Relies on the cached sizes set by ByteSizeLong().
+  uint8_t* InternalWrite(int number, uint8_t* target,
+                         io::EpsCopyOutputStream* stream) const;
+
+ private:
+  enum class State : uint8_t {
+    kCleared,
+    // Only `bytes_` is valid.
+    kUnparsed,
+    // `message_` was parsed from `bytes_`, which is still valid.
+    kParsed,
+    // Only `message_` is valid.
+    kMutated,
+  };
+
+  void EnsureParsed(const MessageLite& prototype, Arena* arena) const;
+  std::string* MutableBytes(Arena* arena) const;
+  // Encodes the mutated message into `bytes_` and marks the field parsed.
+  void RetainEncoding() const;
+
+  mutable State state_ = State::kCleared;
+  bool retain_encoding_ = false;
+  mutable MessageLite* message_ = nullptr;
+  mutable std::string* bytes_ = nullptr;
+};
+
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_LAZY_FIELD_H__
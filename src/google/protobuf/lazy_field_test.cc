@@ -0,0 +1,200 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "google/protobuf/lazy_field.h"
+
+#include <memory>
+#include <string>
+
+#include <gtest/gtest.h>
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/arena.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/unittest.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+namespace {
+
+using ::protobuf_unittest::TestAllTypes;
+
+const MessageLite& Prototype() {
+  return TestAllTypes::NestedMessage::default_instance();
+}
+
+int GetBb(const LazyField& field, Arena* arena = nullptr) {
+  return static_cast<const TestAllTypes::NestedMessage&>(
+             field.Get(Prototype(), arena))
+      .bb();
+}
+
+std::string Write(const LazyField& field) {
+  field.ByteSizeLong();
+  std::string out;
+  {
+    io::StringOutputStream stream(&out);
+    uint8_t* ptr;
+    io::EpsCopyOutputStream eps(&stream, false, &ptr);
+    ptr = field.InternalWrite(1, ptr, &eps);
+    eps.Trim(ptr);
+  }
+  return out;
+}
+
+class LazyFieldTest : public ::testing::Test {
+ protected:
+  ~LazyFieldTest() override { field_.Destroy(); }
+
+  LazyField field_;
+};
+
+TEST_F(LazyFieldTest, ParsesOnFirstAccess) {
+  EXPECT_TRUE(field_.IsCleared());
+  EXPECT_EQ(&field_.Get(Prototype(), nullptr), &Prototype());
+
+  field_.MergeFromBytes("\x08\x05", Prototype(), nullptr);
+  EXPECT_FALSE(field_.IsCleared());
+  EXPECT_TRUE(field_.IsUnparsed());
+  EXPECT_EQ(GetBb(field_), 5);
+  EXPECT_FALSE(field_.IsUnparsed());
+}
+
+TEST_F(LazyFieldTest, UntouchedBytesAreWrittenVerbatim) {
+  // Not what serializing the parsed message would produce.
+  const absl::string_view bytes("\x08\x01\x08\x02", 4);
+  field_.MergeFromBytes(bytes, Prototype(), nullptr);
+  EXPECT_EQ(Write(field_), absl::StrCat("\x0a\x04", bytes));
+
+  // Reading the message does not change the output.
+  EXPECT_EQ(GetBb(field_), 2);
+  EXPECT_EQ(Write(field_), absl::StrCat("\x0a\x04", bytes));
+
+  // Mutating it does.
+  static_cast<TestAllTypes::NestedMessage*>(
+      field_.Mutable(Prototype(), nullptr))
+      ->set_bb(3);
+  EXPECT_EQ(Write(field_), "\x0a\x02\x08\x03");
+}
+
+TEST_F(LazyFieldTest, MergeConcatenatesBytes) {
+  field_.MergeFromBytes("\x08\x01", Prototype(), nullptr);
+  field_.MergeFromBytes("\x08\x02", Prototype(), nullptr);
+  EXPECT_TRUE(field_.IsUnparsed());
+  EXPECT_EQ(field_.ByteSizeLong(), 4);
+  EXPECT_EQ(GetBb(field_), 2);
+
+  // Merging into a parsed field keeps it untouched.
+  field_.MergeFromBytes("\x08\x07", Prototype(), nullptr);
+  EXPECT_EQ(GetBb(field_), 7);
+  EXPECT_EQ(Write(field_), "\x0a\x06\x08\x01\x08\x02\x08\x07");
+
+  LazyField other;
+  other.MergeFrom(field_, Prototype(), nullptr);
+  EXPECT_TRUE(other.IsUnparsed());
+  EXPECT_EQ(GetBb(other), 7);
+  other.Destroy();
+}
+
+TEST_F(LazyFieldTest, ClearAndRelease) {
+  field_.MergeFromBytes("\x08\x04", Prototype(), nullptr);
+  field_.Clear();
+  EXPECT_TRUE(field_.IsCleared());
+  EXPECT_EQ(Write(field_), "");
+
+  field_.MergeFromBytes("\x08\x04", Prototype(), nullptr);
+  std::unique_ptr<MessageLite> released(
+      field_.UnsafeArenaRelease(Prototype(), nullptr));
+  EXPECT_TRUE(field_.IsCleared());
+  EXPECT_EQ(static_cast<TestAllTypes::NestedMessage&>(*released).bb(), 4);
+}
+
+TEST_F(LazyFieldTest, RetainsEncodingUntilMutated) {
+  field_.set_retain_encoding(true);
+  auto* message = static_cast<TestAllTypes::NestedMessage*>(
+      field_.Mutable(Prototype(), nullptr));
+  message->set_bb(3);
+  EXPECT_TRUE(field_.IsDirty());
+  EXPECT_EQ(Write(field_), "\x0a\x02\x08\x03");
+  EXPECT_FALSE(field_.IsDirty());
+
+  // The retained bytes are spliced in without looking at the message.
+  message->set_bb(4);
+  EXPECT_EQ(field_.ByteSizeLong(), 2);
+  EXPECT_EQ(Write(field_), "\x0a\x02\x08\x03");
+
+  // Mutable() marks the field dirty again.
+  static_cast<TestAllTypes::NestedMessage*>(
+      field_.Mutable(Prototype(), nullptr))
+      ->set_bb(5);
+  EXPECT_TRUE(field_.IsDirty());
+  EXPECT_EQ(Write(field_), "\x0a\x02\x08\x05");
+  EXPECT_EQ(GetBb(field_), 5);
+}
+
+TEST(LazyFieldArenaTest, AllocatesOnArena) {
+  Arena arena;
+  auto* field = Arena::Create<LazyField>(&arena);
+  field->MergeFromBytes("\x08\x09", Prototype(), &arena);
+  EXPECT_EQ(GetBb(*field, &arena), 9);
+  EXPECT_EQ(field->Get(Prototype(), &arena).GetArena(), &arena);
+  EXPECT_TRUE(field->IsInitialized(Prototype(), &arena));
+}
+
+TEST(LazyFieldArenaTest, RetainsEncodingOnArena) {
+  Arena arena;
+  auto* field = Arena::Create<LazyField>(&arena);
+  field->set_retain_encoding(true);
+  static_cast<TestAllTypes::NestedMessage*>(
+      field->Mutable(Prototype(), &arena))
+      ->set_bb(6);
+  EXPECT_EQ(Write(*field), "\x0a\x02\x08\x06");
+  EXPECT_FALSE(field->IsDirty());
+  EXPECT_EQ(GetBb(*field, &arena), 6);
+}
+
+TEST(LazyFieldArenaTest, CopiesOntoArena) {
+  LazyField from;
+  from.MergeFromBytes("\x08\x04", Prototype(), nullptr);
+  Arena arena;
+  auto* field = Arena::Create<LazyField>(&arena, &arena, from, Prototype());
+  EXPECT_TRUE(field->IsUnparsed());
+  EXPECT_EQ(GetBb(*field, &arena), 4);
+  EXPECT_EQ(field->Get(Prototype(), &arena).GetArena(), &arena);
+  from.Destroy();
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,139 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Tests for messages generated with lite_lazy_implicit_weak_fields, whose
+// singular implicitly weak message fields are stored as LazyField.
+
+#include <string>
+
+#include <gtest/gtest.h>
+#include "google/protobuf/arena.h"
+#include "google/protobuf/unittest_lazy_implicit_weak.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace {
+
+using ::protobuf_unittest::LazyWeakHolder;
+
+std::string MakeHolder() {
+  LazyWeakHolder holder;
+  holder.mutable_leaf()->set_a(5);
+  holder.mutable_leaf()->set_s("hello");
+  holder.set_x(3);
+  holder.add_leaves()->set_a(9);
+  holder.mutable_required_child()->set_r(1);
+  return holder.SerializeAsString();
+}
+
+TEST(LazyImplicitWeakTest, RoundTrip) {
+  const std::string bytes = MakeHolder();
+  LazyWeakHolder holder;
+  ASSERT_TRUE(holder.ParseFromString(bytes));
+  EXPECT_TRUE(holder.has_leaf());
+  // Untouched lazy fields are written back verbatim.
+  EXPECT_EQ(holder.SerializeAsString(), bytes);
+
+  EXPECT_EQ(holder.leaf().a(), 5);
+  EXPECT_EQ(holder.leaf().s(), "hello");
+  EXPECT_EQ(holder.x(), 3);
+  EXPECT_EQ(holder.leaves(0).a(), 9);
+  EXPECT_EQ(holder.required_child().r(), 1);
+  EXPECT_EQ(holder.SerializeAsString(), bytes);
+
+  holder.mutable_leaf()->set_a(6);
+  LazyWeakHolder reparsed;
+  ASSERT_TRUE(reparsed.ParseFromString(holder.SerializeAsString()));
+  EXPECT_EQ(reparsed.leaf().a(), 6);
+  EXPECT_EQ(reparsed.leaf().s(), "hello");
+}
+
+TEST(LazyImplicitWeakTest, RepeatedOccurrencesMerge) {
+  LazyWeakHolder first, second;
+  first.mutable_leaf()->set_a(1);
+  first.mutable_leaf()->set_s("x");
+  second.mutable_leaf()->set_a(2);
+  LazyWeakHolder holder;
+  ASSERT_TRUE(holder.ParseFromString(first.SerializeAsString() +
+                                     second.SerializeAsString()));
+  EXPECT_EQ(holder.leaf().a(), 2);
+  EXPECT_EQ(holder.leaf().s(), "x");
+}
+
+TEST(LazyImplicitWeakTest, MergeFromAndCopy) {
+  LazyWeakHolder parsed;
+  ASSERT_TRUE(parsed.ParseFromString(MakeHolder()));
+
+  LazyWeakHolder merged;
+  merged.mutable_leaf()->set_s("old");
+  merged.MergeFrom(parsed);
+  EXPECT_EQ(merged.leaf().a(), 5);
+  EXPECT_EQ(merged.leaf().s(), "hello");
+
+  LazyWeakHolder copy(parsed);
+  EXPECT_EQ(copy.leaf().a(), 5);
+  EXPECT_EQ(copy.SerializeAsString(), parsed.SerializeAsString());
+
+  copy.clear_leaf();
+  EXPECT_FALSE(copy.has_leaf());
+  EXPECT_EQ(copy.leaf().a(), 0);
+}
+
+TEST(LazyImplicitWeakTest, ArenaReleaseAndSetAllocated) {
+  Arena arena;
+  auto* holder = Arena::CreateMessage<LazyWeakHolder>(&arena);
+  ASSERT_TRUE(holder->ParseFromString(MakeHolder()));
+  protobuf_unittest::LazyWeakLeaf* leaf = holder->release_leaf();
+  EXPECT_FALSE(holder->has_leaf());
+  EXPECT_EQ(leaf->a(), 5);
+  holder->set_allocated_leaf(leaf);
+  EXPECT_TRUE(holder->has_leaf());
+  EXPECT_EQ(holder->leaf().s(), "hello");
+
+  LazyWeakHolder other;
+  holder->Swap(&other);
+  EXPECT_FALSE(holder->has_leaf());
+  EXPECT_EQ(other.leaf().a(), 5);
+}
+
+TEST(LazyImplicitWeakTest, MissingRequiredFieldFailsParse) {
+  LazyWeakHolder holder;
+  holder.mutable_required_child();
+  const std::string bytes = holder.SerializePartialAsString();
+
+  LazyWeakHolder parsed;
+  EXPECT_FALSE(parsed.ParseFromString(bytes));
+  EXPECT_TRUE(parsed.ParsePartialFromString(bytes));
+  EXPECT_FALSE(parsed.IsInitialized());
+}
+
+}  // namespace
+}  // namespace protobuf
+}  // namespace google
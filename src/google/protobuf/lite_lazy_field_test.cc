@@ -0,0 +1,187 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Tests for lite messages generated with lite_lazy_fields, whose singular
+// [lazy = true] message fields are stored as LazyField.
+
+#include <string>
+
+#include <gtest/gtest.h>
+#include "google/protobuf/arena.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/unittest_lite_lazy.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace {
+
+using ::protobuf_unittest::LiteLazyHolder;
+using ::protobuf_unittest::LiteLazyRetainHolder;
+
+std::string MakeHolder() {
+  LiteLazyHolder holder;
+  holder.mutable_leaf()->set_a(5);
+  holder.mutable_leaf()->set_s("hello");
+  holder.set_x(3);
+  holder.mutable_eager_leaf()->set_a(7);
+  holder.mutable_required_child()->set_r(1);
+  holder.mutable_choice()->set_a(9);
+  return holder.SerializeAsString();
+}
+
+TEST(LiteLazyFieldTest, RoundTrip) {
+  const std::string bytes = MakeHolder();
+  LiteLazyHolder holder;
+  ASSERT_TRUE(holder.ParseFromString(bytes));
+  EXPECT_TRUE(holder.has_leaf());
+  // Untouched lazy fields are written back verbatim.
+  EXPECT_EQ(holder.SerializeAsString(), bytes);
+
+  EXPECT_EQ(holder.leaf().a(), 5);
+  EXPECT_EQ(holder.leaf().s(), "hello");
+  EXPECT_EQ(holder.x(), 3);
+  EXPECT_EQ(holder.eager_leaf().a(), 7);
+  EXPECT_EQ(holder.required_child().r(), 1);
+  EXPECT_EQ(holder.choice().a(), 9);
+  EXPECT_EQ(holder.SerializeAsString(), bytes);
+
+  holder.mutable_leaf()->set_a(6);
+  LiteLazyHolder reparsed;
+  ASSERT_TRUE(reparsed.ParseFromString(holder.SerializeAsString()));
+  EXPECT_EQ(reparsed.leaf().a(), 6);
+  EXPECT_EQ(reparsed.leaf().s(), "hello");
+}
+
+TEST(LiteLazyFieldTest, RepeatedOccurrencesMerge) {
+  LiteLazyHolder first, second;
+  first.mutable_leaf()->set_a(1);
+  first.mutable_leaf()->set_s("x");
+  second.mutable_leaf()->set_a(2);
+  LiteLazyHolder holder;
+  ASSERT_TRUE(holder.ParseFromString(first.SerializeAsString() +
+                                     second.SerializeAsString()));
+  EXPECT_EQ(holder.leaf().a(), 2);
+  EXPECT_EQ(holder.leaf().s(), "x");
+}
+
+TEST(LiteLazyFieldTest, MergeFromCopyAndSwap) {
+  LiteLazyHolder parsed;
+  ASSERT_TRUE(parsed.ParseFromString(MakeHolder()));
+
+  LiteLazyHolder merged;
+  merged.mutable_leaf()->set_s("old");
+  merged.MergeFrom(parsed);
+  EXPECT_EQ(merged.leaf().a(), 5);
+  EXPECT_EQ(merged.leaf().s(), "hello");
+
+  LiteLazyHolder copy(parsed);
+  EXPECT_EQ(copy.SerializeAsString(), parsed.SerializeAsString());
+  copy.clear_leaf();
+  EXPECT_FALSE(copy.has_leaf());
+  EXPECT_EQ(copy.leaf().a(), 0);
+
+  LiteLazyHolder other;
+  parsed.Swap(&other);
+  EXPECT_FALSE(parsed.has_leaf());
+  EXPECT_EQ(other.leaf().a(), 5);
+}
+
+TEST(LiteLazyFieldTest, ArenaReleaseAndSetAllocated) {
+  Arena arena;
+  auto* holder = Arena::CreateMessage<LiteLazyHolder>(&arena);
+  ASSERT_TRUE(holder->ParseFromString(MakeHolder()));
+  protobuf_unittest::LiteLazyLeaf* leaf = holder->release_leaf();
+  EXPECT_FALSE(holder->has_leaf());
+  EXPECT_EQ(leaf->a(), 5);
+  holder->set_allocated_leaf(leaf);
+  EXPECT_TRUE(holder->has_leaf());
+  EXPECT_EQ(holder->leaf().s(), "hello");
+}
+
+TEST(LiteLazyFieldTest, RequiredFieldsAreVerifiedOnAccess) {
+  LiteLazyHolder holder;
+  holder.mutable_required_child();
+  const std::string bytes = holder.SerializePartialAsString();
+
+  // Lazily verified fields are not checked while parsing.
+  LiteLazyHolder parsed;
+  EXPECT_TRUE(parsed.ParseFromString(bytes));
+  EXPECT_FALSE(parsed.required_child().IsInitialized());
+}
+
+TEST(LiteLazyFieldTest, RetainEncodingKeepsWrittenBytes) {
+  LiteLazyRetainHolder holder;
+  protobuf_unittest::LiteLazyLeaf* leaf = holder.mutable_leaf();
+  leaf->set_a(1);
+  const std::string first = holder.SerializeAsString();
+
+  // The bytes written for the leaf are reused until mutable_leaf() marks it
+  // dirty again, so a change through the old pointer is not seen.
+  leaf->set_a(2);
+  EXPECT_EQ(holder.SerializeAsString(), first);
+
+  holder.mutable_leaf()->set_s("x");
+  LiteLazyRetainHolder parsed;
+  ASSERT_TRUE(parsed.ParseFromString(holder.SerializeAsString()));
+  EXPECT_EQ(parsed.leaf().a(), 2);
+  EXPECT_EQ(parsed.leaf().s(), "x");
+
+  LiteLazyRetainHolder copy(holder);
+  EXPECT_EQ(copy.SerializeAsString(), holder.SerializeAsString());
+}
+
+std::string SerializeDeterministically(const MessageLite& message) {
+  std::string result;
+  {
+    io::StringOutputStream output(&result);
+    io::CodedOutputStream coded(&output);
+    coded.SetSerializationDeterministic(true);
+    message.SerializeToCodedStream(&coded);
+  }
+  return result;
+}
+
+TEST(LiteLazyFieldTest, RetainedBytesAreDeterministic) {
+  LiteLazyRetainHolder holder;
+  LiteLazyHolder reference;
+  for (int i = 0; i < 100; ++i) {
+    (*holder.mutable_leaf()->mutable_m())[i * 7919 % 1000] = i;
+    (*reference.mutable_leaf()->mutable_m())[i * 7919 % 1000] = i;
+  }
+  // Retains the encoding of the leaf.
+  holder.SerializeAsString();
+  EXPECT_EQ(SerializeDeterministically(holder),
+            SerializeDeterministically(reference));
+}
+
+}  // namespace
+}  // namespace protobuf
+}  // namespace google
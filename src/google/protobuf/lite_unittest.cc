@@ -30,6 +30,7 @@
 
 // Author: kenton@google.com (Kenton Varda)
 
+#include <algorithm>
 #include <climits>
 #include <iostream>
 #include <limits>
@@ -179,6 +180,28 @@ TEST(ParseVarintTest, Varint64) {
   test_value(std::numeric_limits<uint64_t>::max(), 10);
 }
 
+TEST(ParseVarintTest, Varint64Overlong) {
+  // Padded like the parse context's slop region.
+  char buffer[16] = {};
+  // Redundant continuation bytes are accepted, up to ten bytes in total.
+  for (int varint_length = 6; varint_length <= 10; ++varint_length) {
+    std::fill(buffer, buffer + sizeof(buffer), 0);
+    buffer[0] = static_cast<char>(0x81);
+    std::fill(buffer + 1, buffer + varint_length - 1, static_cast<char>(0x80));
+    uint64_t parsed = 0;
+    const char* r = internal::VarintParse(buffer, &parsed);
+    ASSERT_EQ(r - buffer, varint_length);
+    EXPECT_EQ(parsed, 1);
+  }
+
+  // Eleven bytes are malformed.
+  std::fill(buffer, buffer + 10, static_cast<char>(0x80));
+  uint64_t parsed64;
+  EXPECT_EQ(internal::VarintParse(buffer, &parsed64), nullptr);
+  uint32_t parsed32;
+  EXPECT_EQ(internal::VarintParse(buffer, &parsed32), nullptr);
+}
+
 template <typename T>
 class LiteTest : public ::testing::Test {};
 
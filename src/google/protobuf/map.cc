@@ -74,6 +74,8 @@ void UntypedMapBase::EraseFromTree(size_type b,
 }
 
 size_t UntypedMapBase::VariantBucketNumber(VariantKey key) const {
+  // Only maps with integer keys are ever dense.
+  if (is_dense()) return DenseBucketNumber(key.integral);
   return BucketNumberFromHash(key.Hash());
 }
 
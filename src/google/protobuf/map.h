@@ -555,6 +555,13 @@ class PROTOBUF_EXPORT UntypedMapBase {
 
  protected:
   enum { kMinTableSize = 8 };
+  enum { kMaxMapLoadTimes16 = 12 };  // controls RAM vs CPU tradeoff
+  // Integer keyed maps whose keys are all smaller than the number of buckets
+  // use the key itself, xored with the seed, as the bucket number: lookups
+  // skip the hash and every bucket holds at most one node.  The low bit of
+  // `seed_` records whether the map is in that dense mode.  See
+  // KeyMapBase::ChooseLayout() for when a map switches modes.
+  static constexpr size_type kDenseSeedBit = 1;
 
  public:
   Arena* arena() const { return this->alloc_.arena(); }
@@ -678,6 +685,14 @@ class PROTOBUF_EXPORT UntypedMapBase {
 
   size_type VariantBucketNumber(VariantKey key) const;
 
+  bool is_dense() const { return (seed_ & kDenseSeedBit) != 0; }
+  size_type DenseBucketNumber(uint64_t key) const {
+    // Xoring in the seed keeps the iteration order random, and for keys below
+    // `num_buckets_` it is still a one to one mapping to buckets.  The mode bit
+    // is shifted out so that it does not fix the order of adjacent keys.
+    return static_cast<size_type>(key ^ (seed_ >> 1)) & (num_buckets_ - 1);
+  }
+
   size_type BucketNumberFromHash(uint64_t h) const {
     // We xor the hash value against the random seed so that we effectively
     // have a random hash function.
@@ -882,6 +897,20 @@ struct KeyNode : NodeBase {
 // 7. Uses VariantKey when using the Tree representation, which holds all
 //    possible key types as a variant value.
 
+// The value an integer key is looked up by in a dense map.  Other key types
+// never use dense mode.
+template <typename Key, typename = void>
+struct DenseKey {
+  template <typename K>
+  static uint64_t Get(const K&) {
+    return 0;
+  }
+};
+template <typename Key>
+struct DenseKey<Key, std::enable_if_t<std::is_integral<Key>::value>> {
+  static uint64_t Get(Key key) { return key; }
+};
+
 template <typename Key>
 class KeyMapBase : public UntypedMapBase {
   static_assert(!std::is_signed<Key>::value || !std::is_integral<Key>::value,
@@ -889,6 +918,11 @@ class KeyMapBase : public UntypedMapBase {
 
   using TS = TransparentSupport<Key>;
 
+  static constexpr bool kMayBeDense = std::is_integral<Key>::value;
+  // A dense table may have up to this many buckets per element, so that a
+  // small map never grows a table much larger than a hashed one.
+  static constexpr size_type kMaxDenseBucketsPerElement = 4;
+
  public:
   using hasher = typename TS::hash;
 
@@ -954,13 +988,16 @@ class KeyMapBase : public UntypedMapBase {
   // If the key is a duplicate, it inserts the new node and returns the old one.
   // Gives ownership to the caller.
   // If the key is unique, it returns `nullptr`.
-  KeyNode* InsertOrReplaceNode(KeyNode* node) {
+  // Pass `may_shrink = false` while filling a table sized by Reserve(), which
+  // would otherwise look underloaded until most of the elements are in.
+  KeyNode* InsertOrReplaceNode(KeyNode* node, bool may_shrink = true) {
     KeyNode* to_erase = nullptr;
     auto p = this->FindHelper(node->key());
     if (p.node != nullptr) {
       erase_no_destroy(p.bucket, static_cast<KeyNode*>(p.node));
       to_erase = static_cast<KeyNode*>(p.node);
-    } else if (ResizeIfLoadIsOutOfRange(num_elements_ + 1)) {
+    } else if (may_shrink ? ResizeIfLoadIsOutOfRange(num_elements_ + 1)
+                          : ResizeIfLoadIsTooHigh(num_elements_ + 1)) {
       p = FindHelper(node->key());
     }
     const size_type b = p.bucket;  // bucket number
@@ -976,6 +1013,13 @@ class KeyMapBase : public UntypedMapBase {
   void InsertUnique(size_type b, KeyNode* node) {
     ABSL_DCHECK(index_of_first_non_null_ == num_buckets_ ||
                 !TableEntryIsEmpty(index_of_first_non_null_));
+    if (kMayBeDense && is_dense() &&
+        PROTOBUF_PREDICT_FALSE(DenseKey<Key>::Get(node->key()) >=
+                               num_buckets_)) {
+      // The key does not fit the dense table: grow it, or switch to hashing.
+      Resize(num_buckets_, DenseKey<Key>::Get(node->key()));
+      b = BucketNumber(node->key());
+    }
     // In practice, the code that led to this point may have already
     // determined whether we are inserting into an empty list, a short list,
     // or whatever.  But it's probably cheap enough to recompute that here;
@@ -1005,7 +1049,6 @@ class KeyMapBase : public UntypedMapBase {
   // policy that sometimes we resize down as well as up, clients can easily
   // keep O(size()) = O(number of buckets) if they want that.
   bool ResizeIfLoadIsOutOfRange(size_type new_size) {
-    const size_type kMaxMapLoadTimes16 = 12;  // controls RAM vs CPU tradeoff
     const size_type hi_cutoff = num_buckets_ * kMaxMapLoadTimes16 / 16;
     const size_type lo_cutoff = hi_cutoff / 4;
     // We don't care how many elements are in trees.  If a lot are,
@@ -1036,18 +1079,63 @@ class KeyMapBase : public UntypedMapBase {
     return false;
   }
 
-  // Resize to the given number of buckets.
-  void Resize(size_t new_num_buckets) {
+  // Grows the table, if needed, so that `n` elements fit without resizing.
+  // Never shrinks the table. Returns whether it did resize.
+  bool Reserve(size_type n) {
+    if (n == 0) return false;
+    size_type new_num_buckets = kMinTableSize;
+    while (n >= new_num_buckets * kMaxMapLoadTimes16 / 16 &&
+           new_num_buckets <= max_size() / 2) {
+      new_num_buckets *= 2;
+    }
+    if (num_buckets_ == kGlobalEmptyTableSize) {
+      num_buckets_ = index_of_first_non_null_ = new_num_buckets;
+      table_ = CreateEmptyTable(num_buckets_);
+      seed_ = InitialSeed();
+      return true;
+    }
+    if (new_num_buckets > num_buckets_) {
+      Resize(new_num_buckets);
+      return true;
+    }
+    return false;
+  }
+
+  // Like ResizeIfLoadIsOutOfRange, but only ever grows the table.
+  bool ResizeIfLoadIsTooHigh(size_type new_size) {
+    const size_type hi_cutoff = num_buckets_ * kMaxMapLoadTimes16 / 16;
+    if (PROTOBUF_PREDICT_FALSE(new_size >= hi_cutoff) &&
+        num_buckets_ <= max_size() / 2) {
+      Resize(num_buckets_ * 2);
+      return true;
+    }
+    return false;
+  }
+
+  // New maps start out dense if their key type allows it.
+  size_type InitialSeed() const {
+    return kMayBeDense ? Seed() | kDenseSeedBit : Seed() & ~kDenseSeedBit;
+  }
+
+  // Resize to the given number of buckets, or more if that keeps the map
+  // dense.  `extra_key` is the dense key of a node about to be inserted.
+  void Resize(size_t new_num_buckets, uint64_t extra_key = 0) {
     if (num_buckets_ == kGlobalEmptyTableSize) {
       // This is the global empty array.
       // Just overwrite with a new one. No need to transfer or free anything.
       num_buckets_ = index_of_first_non_null_ = kMinTableSize;
       table_ = CreateEmptyTable(num_buckets_);
-      seed_ = Seed();
+      seed_ = InitialSeed();
       return;
     }
 
     ABSL_DCHECK_GE(new_num_buckets, kMinTableSize);
+    if (kMayBeDense) {
+      const size_type old_seed = seed_;
+      new_num_buckets = ChooseLayout(new_num_buckets, extra_key);
+      // Shrinking a dense table may not be possible.
+      if (new_num_buckets == num_buckets_ && seed_ == old_seed) return;
+    }
     const auto old_table = table_;
     const size_type old_table_size = num_buckets_;
     num_buckets_ = new_num_buckets;
@@ -1064,6 +1152,41 @@ class KeyMapBase : public UntypedMapBase {
     DeleteTable(old_table, old_table_size);
   }
 
+  // Sets dense or hashed mode for a table about to be resized, and returns the
+  // number of buckets it should get.  The map is dense if every key, and
+  // `extra_key`, is below a power of two number of buckets that is no more
+  // than the larger of `new_num_buckets` and the dense table limit.  This is
+  // rechecked on every resize, so maps move between the modes as they grow,
+  // shrink and get cleared.
+  PROTOBUF_NOINLINE size_type ChooseLayout(size_type new_num_buckets,
+                                           uint64_t extra_key) {
+    const size_type limit = (std::max)(
+        new_num_buckets, (num_elements_ + 1) * kMaxDenseBucketsPerElement);
+    uint64_t max_key = extra_key;
+    // Sparse keys usually show up right away, so stop at the first key that
+    // is too large.
+    for (size_type b = index_of_first_non_null_;
+         b < num_buckets_ && max_key < limit; ++b) {
+      NodeBase* node = TableEntryIsTree(b)
+                           ? TableEntryToTree(table_[b])->begin()->second
+                           : TableEntryToNode(table_[b]);
+      for (; node != nullptr; node = node->next) {
+        max_key = (std::max)(
+            max_key, DenseKey<Key>::Get(static_cast<KeyNode*>(node)->key()));
+      }
+    }
+    size_type dense_num_buckets = kMinTableSize;
+    while (dense_num_buckets <= max_key && dense_num_buckets <= limit / 2) {
+      dense_num_buckets *= 2;
+    }
+    if (max_key < dense_num_buckets) {
+      seed_ |= kDenseSeedBit;
+      return (std::max)(new_num_buckets, dense_num_buckets);
+    }
+    seed_ &= ~kDenseSeedBit;
+    return new_num_buckets;
+  }
+
   // Transfer all nodes in the list `node` into `this`.
   void TransferList(KeyNode* node) {
     do {
@@ -1074,6 +1197,9 @@ class KeyMapBase : public UntypedMapBase {
   }
 
   size_type BucketNumber(typename TS::ViewType k) const {
+    if (kMayBeDense && is_dense()) {
+      return DenseBucketNumber(DenseKey<Key>::Get(k));
+    }
     ABSL_DCHECK_EQ(BucketNumberFromHash(hash_function()(k)),
                    VariantBucketNumber(RealKeyToVariantKey<Key>{}(k)));
     return BucketNumberFromHash(hash_function()(k));
@@ -1198,7 +1324,7 @@ class Map : private internal::KeyMapBase<internal::KeyForBase<Key>> {
  private:
   Map(Arena* arena, const Map& other) : Base(arena) {
     StaticValidityCheck();
-    insert(other.begin(), other.end());
+    CopyElementsFrom(other);
   }
   static_assert(!std::is_const<mapped_type>::value &&
                     !std::is_const<key_type>::value,
@@ -1506,7 +1632,7 @@ class Map : private internal::KeyMapBase<internal::KeyForBase<Key>> {
   Map& operator=(const Map& other) ABSL_ATTRIBUTE_LIFETIME_BOUND {
     if (this != &other) {
       clear();
-      insert(other.begin(), other.end());
+      CopyElementsFrom(other);
     }
     return *this;
   }
@@ -1597,6 +1723,15 @@ class Map : private internal::KeyMapBase<internal::KeyForBase<Key>> {
       p = this->FindHelper(TS::ToView(k));
     }
     const size_type b = p.bucket;  // bucket number
+    Node* node = CreateNode(std::forward<K>(k), std::forward<Args>(args)...);
+    this->InsertUnique(b, node);
+    ++this->num_elements_;
+    return std::make_pair(iterator(node, this, b), true);
+  }
+
+  // Allocates a node and constructs its key and value from the arguments.
+  template <typename K, typename... Args>
+  Node* CreateNode(K&& k, Args&&... args) {
     // If K is not key_type, make the conversion to key_type explicit.
     using TypeToInit = typename std::conditional<
         std::is_same<typename std::decay<K>::type, key_type>::value, K&&,
@@ -1616,10 +1751,33 @@ class Map : private internal::KeyMapBase<internal::KeyForBase<Key>> {
     // Note: if `T` is arena constructible, `Args` needs to be empty.
     Arena::CreateInArenaStorage(&node->kv.second, this->alloc_.arena(),
                                 std::forward<Args>(args)...);
+    return node;
+  }
+
+  // Copies all the elements of `other` into this map, which must be empty.
+  // The keys of `other` are known to be unique, so the table is sized once up
+  // front and the nodes are linked in without lookups or intermediate
+  // resizes.
+  void CopyElementsFrom(const Map& other) {
+    ABSL_DCHECK(this->empty());
+    this->Reserve(other.size());
+    for (const auto& elem : other) {
+      Node* node =
+          CopyNode(Arena::is_arena_constructable<mapped_type>(), elem);
+      this->InsertUnique(this->BucketNumber(TS::ToView(node->kv.first)), node);
+      ++this->num_elements_;
+    }
+  }
 
-    this->InsertUnique(b, node);
-    ++this->num_elements_;
-    return std::make_pair(iterator(node, this, b), true);
+  // Same dispatch as ArenaAwareTryEmplace below: arena constructible values
+  // are created on the arena and then assigned.
+  Node* CopyNode(std::true_type, const value_type& elem) {
+    Node* node = CreateNode(elem.first);
+    AssignMapped(std::true_type(), node->kv.second, elem.second);
+    return node;
+  }
+  Node* CopyNode(std::false_type, const value_type& elem) {
+    return CreateNode(elem.first, elem.second);
   }
 
   // A helper function to perform an assignment of `mapped_type`.
@@ -1679,6 +1837,11 @@ class Map : private internal::KeyMapBase<internal::KeyForBase<Key>> {
 namespace internal {
 template <typename... T>
 PROTOBUF_NOINLINE void MapMergeFrom(Map<T...>& dest, const Map<T...>& src) {
+  if (dest.empty()) {
+    // Copying lets the destination size its table once.
+    dest = src;
+    return;
+  }
   for (const auto& elem : src) {
     dest[elem.first] = elem.second;
   }
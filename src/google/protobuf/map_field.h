@@ -91,11 +91,7 @@ class PROTOBUF_EXPORT MapKey {
     return *this;
   }
 
-  ~MapKey() {
-    if (type_ == FieldDescriptor::CPPTYPE_STRING) {
-      val_.string_value_.Destruct();
-    }
-  }
+  ~MapKey() { DestroyString(); }
 
   FieldDescriptor::CppType type() const {
     if (type_ == FieldDescriptor::CppType()) {
@@ -153,7 +149,7 @@ class PROTOBUF_EXPORT MapKey {
   }
   const std::string& GetStringValue() const {
     TYPE_CHECK(FieldDescriptor::CPPTYPE_STRING, "MapKey::GetStringValue");
-    return val_.string_value_.get();
+    return string_value();
   }
 
   bool operator<(const MapKey& other) const {
@@ -170,7 +166,7 @@ class PROTOBUF_EXPORT MapKey {
         ABSL_LOG(FATAL) << "Unsupported";
         return false;
       case FieldDescriptor::CPPTYPE_STRING:
-        return val_.string_value_.get() < other.val_.string_value_.get();
+        return string_value() < other.string_value();
       case FieldDescriptor::CPPTYPE_INT64:
         return val_.int64_value_ < other.val_.int64_value_;
       case FieldDescriptor::CPPTYPE_INT32:
@@ -198,7 +194,7 @@ class PROTOBUF_EXPORT MapKey {
         ABSL_LOG(FATAL) << "Unsupported";
         break;
       case FieldDescriptor::CPPTYPE_STRING:
-        return val_.string_value_.get() == other.val_.string_value_.get();
+        return string_value() == other.string_value();
       case FieldDescriptor::CPPTYPE_INT64:
         return val_.int64_value_ == other.val_.int64_value_;
       case FieldDescriptor::CPPTYPE_INT32:
@@ -215,6 +211,7 @@ class PROTOBUF_EXPORT MapKey {
   }
 
   void CopyFrom(const MapKey& other) {
+    if (this == &other) return;
     SetType(other.type());
     switch (type_) {
       case FieldDescriptor::CPPTYPE_DOUBLE:
@@ -224,7 +221,7 @@ class PROTOBUF_EXPORT MapKey {
         ABSL_LOG(FATAL) << "Unsupported";
         break;
       case FieldDescriptor::CPPTYPE_STRING:
-        *val_.string_value_.get_mutable() = other.val_.string_value_.get();
+        *val_.string_value_.get_mutable() = other.string_value();
         break;
       case FieldDescriptor::CPPTYPE_INT64:
         val_.int64_value_ = other.val_.int64_value_;
@@ -254,6 +251,8 @@ class PROTOBUF_EXPORT MapKey {
   union KeyValue {
     KeyValue() {}
     internal::ExplicitlyConstructed<std::string> string_value_;
+    // Used instead of string_value_ when string_is_borrowed_ is set.
+    const std::string* borrowed_string_value_;
     int64_t int64_value_;
     int32_t int32_value_;
     uint64_t uint64_value_;
@@ -262,19 +261,41 @@ class PROTOBUF_EXPORT MapKey {
   } val_;
 
   void SetType(FieldDescriptor::CppType type) {
-    if (type_ == type) return;
-    if (type_ == FieldDescriptor::CPPTYPE_STRING) {
-      val_.string_value_.Destruct();
-    }
+    if (type_ == type && !string_is_borrowed_) return;
+    DestroyString();
     type_ = type;
     if (type_ == FieldDescriptor::CPPTYPE_STRING) {
       val_.string_value_.DefaultConstruct();
     }
   }
 
+  // Makes this a string key that refers to `value` instead of holding a copy,
+  // so that iterating over a map doesn't copy every key.  `value` must
+  // outlive this key, or the next call that sets it.  Copies of this key own
+  // their string as usual.
+  void SetBorrowedStringValue(const std::string& value) {
+    DestroyString();
+    type_ = FieldDescriptor::CPPTYPE_STRING;
+    string_is_borrowed_ = true;
+    val_.borrowed_string_value_ = &value;
+  }
+
+  const std::string& string_value() const {
+    return string_is_borrowed_ ? *val_.borrowed_string_value_
+                               : val_.string_value_.get();
+  }
+
+  void DestroyString() {
+    if (type_ == FieldDescriptor::CPPTYPE_STRING && !string_is_borrowed_) {
+      val_.string_value_.Destruct();
+    }
+    string_is_borrowed_ = false;
+  }
+
   // type_ is 0 or a valid FieldDescriptor::CppType.
   // Use "CppType()" to indicate zero.
   FieldDescriptor::CppType type_;
+  bool string_is_borrowed_ = false;
 };
 
 namespace internal {
@@ -585,6 +606,13 @@ class TypeDefinedMapFieldBase : public MapFieldBase {
   bool DeleteMapValue(const MapKey& map_key) final;
   bool InsertOrLookupMapValueNoSync(const MapKey& map_key,
                                     MapValueRef* val) override;
+
+  // Sets the key of a MapIterator from the map's own key.  String keys are
+  // borrowed rather than copied.
+  template <typename K>
+  static void SetIteratorKey(MapKey* map_key, const K& value);
+  static void SetIteratorKey(MapKey* map_key, const std::string& value);
+  static void SetIteratorKey(MapKey* map_key, const MapKey& value);
 };
 
 // This class provides access to map field using generated api. It is used for
@@ -889,8 +917,11 @@ class PROTOBUF_EXPORT MapIterator {
     map_->IncreaseIterator(this);
     return *this;
   }
-  const MapKey& GetKey() { return key_; }
-  const MapValueRef& GetValueRef() { return value_; }
+  // String keys refer to the map's own storage rather than being copied, so
+  // the returned key is only valid until the iterator moves or the entry is
+  // removed.  Copy the MapKey to keep it longer.
+  const MapKey& GetKey() const { return key_; }
+  const MapValueRef& GetValueRef() const { return value_; }
   MapValueRef* MutableValueRef() {
     map_->SetMapDirty();
     return &value_;
@@ -108,12 +108,35 @@ inline void SetMapKey(MapKey* map_key, const MapKey& value) {
 }
 
 // ------------------------TypeDefinedMapFieldBase---------------
+template <typename Key, typename T>
+template <typename K>
+void TypeDefinedMapFieldBase<Key, T>::SetIteratorKey(MapKey* map_key,
+                                                     const K& value) {
+  SetMapKey(map_key, value);
+}
+
+template <typename Key, typename T>
+void TypeDefinedMapFieldBase<Key, T>::SetIteratorKey(
+    MapKey* map_key, const std::string& value) {
+  map_key->SetBorrowedStringValue(value);
+}
+
+template <typename Key, typename T>
+void TypeDefinedMapFieldBase<Key, T>::SetIteratorKey(MapKey* map_key,
+                                                     const MapKey& value) {
+  if (value.type() == FieldDescriptor::CPPTYPE_STRING) {
+    map_key->SetBorrowedStringValue(value.GetStringValue());
+  } else {
+    map_key->CopyFrom(value);
+  }
+}
+
 template <typename Key, typename T>
 void TypeDefinedMapFieldBase<Key, T>::SetMapIteratorValue(
     MapIterator* map_iter) const {
   if (map_iter->iter_.Equals(UntypedMapBase::EndIterator())) return;
   auto iter = typename Map<Key, T>::const_iterator(map_iter->iter_);
-  SetMapKey(&map_iter->key_, iter->first);
+  SetIteratorKey(&map_iter->key_, iter->first);
   map_iter->value_.SetValueOrCopy(&iter->second);
 }
 
@@ -34,8 +34,11 @@
 
 #include "google/protobuf/message.h"
 
+#include <algorithm>
 #include <iostream>
 #include <stack>
+#include <utility>
+#include <vector>
 
 #include "absl/base/casts.h"
 #include "absl/container/flat_hash_map.h"
@@ -44,12 +47,14 @@
 #include "absl/log/absl_log.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/blocking_counter.h"
 #include "absl/synchronization/mutex.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/descriptor.pb.h"
 #include "google/protobuf/generated_message_reflection.h"
 #include "google/protobuf/generated_message_tctable_impl.h"
 #include "google/protobuf/generated_message_util.h"
+#include "google/protobuf/insert_only_pointer_map.h"
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl.h"
 #include "google/protobuf/map_field.h"
@@ -212,6 +217,440 @@ size_t Message::SpaceUsedLong() const {
   return GetReflection()->SpaceUsedLong(*this);
 }
 
+namespace {
+
+// Every parallel task serializes at least this many bytes; below that the
+// hand-off costs more than it saves.
+constexpr size_t kMinParallelSerializeBytes = 64 << 10;
+// Likewise, the minimum number of elements each parallel size task handles.
+constexpr int kMinParallelByteSizeElements = 4096;
+
+struct SerializeRangeTask {
+  const Message* message;
+  const FieldDescriptor* field;
+  int begin;
+  int end;
+  uint8_t* target;
+  size_t size;
+  absl::BlockingCounter* done;
+
+  static void Run(void* arg) {
+    auto* task = static_cast<SerializeRangeTask*>(arg);
+    const Reflection* reflection = task->message->GetReflection();
+    io::EpsCopyOutputStream out(
+        task->target, static_cast<int>(task->size),
+        io::CodedOutputStream::IsDefaultSerializationDeterministic());
+    uint8_t* ptr = task->target;
+    for (int i = task->begin; i < task->end; ++i) {
+      const Message& element =
+          reflection->GetRepeatedMessage(*task->message, task->field, i);
+      ptr = internal::WireFormatLite::InternalWriteMessage(
+          task->field->number(), element, element.GetCachedSize(), ptr, &out);
+    }
+    ABSL_DCHECK_EQ(ptr, task->target + task->size);
+    task->done->DecrementCount();
+  }
+};
+
+struct ByteSizeRangeTask {
+  const Message* message;
+  const FieldDescriptor* field;
+  int begin;
+  int end;
+  size_t bytes;
+  absl::BlockingCounter* done;
+
+  static void Run(void* arg) {
+    auto* task = static_cast<ByteSizeRangeTask*>(arg);
+    const Reflection* reflection = task->message->GetReflection();
+    size_t bytes = 0;
+    for (int i = task->begin; i < task->end; ++i) {
+      bytes += internal::WireFormatLite::LengthDelimitedSize(
+          reflection->GetRepeatedMessage(*task->message, task->field, i)
+              .ByteSizeLong());
+    }
+    task->bytes = bytes;
+    task->done->DecrementCount();
+  }
+};
+
+// Returns the top-level repeated message field with the most elements, or
+// nullptr if `message` has none that can be split.
+const FieldDescriptor* FindSplitField(
+    const Message& message, const std::vector<const FieldDescriptor*>& fields,
+    int* count) {
+  const Reflection* reflection = message.GetReflection();
+  const FieldDescriptor* split = nullptr;
+  *count = 0;
+  if (message.GetDescriptor()->options().message_set_wire_format()) {
+    return nullptr;
+  }
+  for (const FieldDescriptor* field : fields) {
+    if (!field->is_repeated() || field->is_map() ||
+        field->type() != FieldDescriptor::TYPE_MESSAGE) {
+      continue;
+    }
+    int field_count = reflection->FieldSize(message, field);
+    if (field_count > *count) {
+      split = field;
+      *count = field_count;
+    }
+  }
+  return split;
+}
+
+}  // namespace
+
+size_t Message::ByteSizeLongParallel(internal::Executor executor,
+                                     int max_tasks) const {
+  const Reflection* reflection = GetReflection();
+  internal::CachedSize* cached_size = AccessCachedSize();
+  if (executor == nullptr || max_tasks < 2 || cached_size == nullptr) {
+    return ByteSizeLong();
+  }
+  std::vector<const FieldDescriptor*> fields;
+  reflection->ListFields(*this, &fields);
+  int split_count;
+  const FieldDescriptor* split = FindSplitField(*this, fields, &split_count);
+  const int num_tasks =
+      std::min(max_tasks, split_count / kMinParallelByteSizeElements);
+  if (split == nullptr || num_tasks < 2) return ByteSizeLong();
+
+  std::vector<ByteSizeRangeTask> tasks(num_tasks);
+  absl::BlockingCounter done(num_tasks);
+  for (int i = 0; i < num_tasks; ++i) {
+    tasks[i] = {this,
+                split,
+                static_cast<int>(int64_t{split_count} * i / num_tasks),
+                static_cast<int>(int64_t{split_count} * (i + 1) / num_tasks),
+                0,
+                &done};
+    executor(&ByteSizeRangeTask::Run, &tasks[i]);
+  }
+
+  // The remaining fields are sized on the calling thread while the tasks run.
+  size_t total = split_count * internal::WireFormatLite::TagSize(
+                                   split->number(),
+                                   internal::WireFormatLite::TYPE_MESSAGE);
+  for (const FieldDescriptor* field : fields) {
+    if (field != split) total += WireFormat::FieldByteSize(field, *this);
+  }
+  total += WireFormat::ComputeUnknownFieldsSize(
+      reflection->GetUnknownFields(*this));
+
+  done.Wait();
+  for (const ByteSizeRangeTask& task : tasks) total += task.bytes;
+  cached_size->Set(internal::ToCachedSize(total));
+  return total;
+}
+
+bool Message::SerializeReverseToString(std::string* output) const {
+  ABSL_DCHECK(IsInitialized())
+      << "Can't serialize message of type \"" << GetTypeName()
+      << "\" because it is missing required fields: "
+      << InitializationErrorString();
+  return SerializePartialReverseToString(output);
+}
+
+bool Message::SerializePartialReverseToString(std::string* output) const {
+  internal::WireFormat::SerializeReverse(*this, output);
+  if (output->size() > static_cast<size_t>(INT_MAX)) {
+    ABSL_LOG(ERROR) << GetTypeName()
+                    << " exceeded maximum protobuf size of 2GB: "
+                    << output->size();
+    output->clear();
+    return false;
+  }
+  return true;
+}
+
+bool Message::SerializeToArrayParallel(void* data, int size,
+                                       internal::Executor executor,
+                                       int max_tasks) const {
+  ABSL_DCHECK(IsInitialized())
+      << "Can't serialize message of type \"" << GetTypeName()
+      << "\" because it is missing required fields: "
+      << InitializationErrorString();
+  return SerializePartialToArrayParallel(data, size, executor, max_tasks);
+}
+
+bool Message::SerializePartialToArrayParallel(void* data, int size,
+                                              internal::Executor executor,
+                                              int max_tasks) const {
+  const Reflection* reflection = GetReflection();
+  if (executor == nullptr || max_tasks < 2) {
+    return SerializePartialToArray(data, size);
+  }
+
+  std::vector<const FieldDescriptor*> fields;
+  reflection->ListFields(*this, &fields);
+  int split_count;
+  const FieldDescriptor* split = FindSplitField(*this, fields, &split_count);
+  if (split == nullptr || split_count < 2) {
+    return SerializePartialToArray(data, size);
+  }
+
+  // Caches every sub-message size; from here on only cached sizes are used.
+  const size_t byte_size = ByteSizeLongParallel(executor, max_tasks);
+  if (byte_size > INT_MAX) {
+    ABSL_LOG(ERROR) << GetTypeName()
+                    << " exceeded maximum protobuf size of 2GB: " << byte_size;
+    return false;
+  }
+  if (size < static_cast<int64_t>(byte_size)) return false;
+
+  const size_t tag_size = internal::WireFormatLite::TagSize(
+      split->number(), internal::WireFormatLite::TYPE_MESSAGE);
+  auto element_size = [&](int i) -> size_t {
+    return tag_size + internal::WireFormatLite::LengthDelimitedSize(
+                          reflection->GetRepeatedMessage(*this, split, i)
+                              .GetCachedSize());
+  };
+  size_t split_bytes = 0;
+  for (int i = 0; i < split_count; ++i) split_bytes += element_size(i);
+  const int num_tasks = static_cast<int>(
+      std::min<size_t>({static_cast<size_t>(max_tasks),
+                        static_cast<size_t>(split_count),
+                        split_bytes / kMinParallelSerializeBytes}));
+  if (num_tasks < 2) return SerializePartialToArray(data, size);
+
+  const bool deterministic =
+      io::CodedOutputStream::IsDefaultSerializationDeterministic();
+  uint8_t* const start = static_cast<uint8_t*>(data);
+  uint8_t* ptr = start;
+
+  // Fields numbered below the split field.  ListFields() returns fields and
+  // extensions in field number order, matching the generated serializer.
+  auto split_it = std::find(fields.begin(), fields.end(), split);
+  {
+    io::EpsCopyOutputStream out(start, static_cast<int>(byte_size),
+                                deterministic);
+    for (auto it = fields.begin(); it != split_it; ++it) {
+      ptr = internal::WireFormat::InternalSerializeField(*it, *this, ptr, &out);
+    }
+  }
+
+  // Cut the split field into ranges of roughly equal byte size.
+  std::vector<SerializeRangeTask> tasks;
+  tasks.reserve(num_tasks);
+  absl::BlockingCounter done(num_tasks);
+  const size_t bytes_per_task = split_bytes / num_tasks;
+  int begin = 0;
+  size_t range_bytes = 0;
+  for (int i = 0; i < split_count; ++i) {
+    range_bytes += element_size(i);
+    const bool last = i + 1 == split_count;
+    if (last || (range_bytes >= bytes_per_task &&
+                 static_cast<int>(tasks.size()) + 1 < num_tasks)) {
+      tasks.push_back({this, split, begin, i + 1, ptr, range_bytes, &done});
+      ptr += range_bytes;
+      begin = i + 1;
+      range_bytes = 0;
+    }
+  }
+  // Fewer ranges than planned are possible when elements are very uneven.
+  for (int i = static_cast<int>(tasks.size()); i < num_tasks; ++i) {
+    done.DecrementCount();
+  }
+  for (SerializeRangeTask& task : tasks) {
+    executor(&SerializeRangeTask::Run, &task);
+  }
+
+  // Everything after the split field is serialized while the tasks run.
+  uint8_t* const suffix = ptr;
+  io::EpsCopyOutputStream out(
+      suffix, static_cast<int>(start + byte_size - suffix), deterministic);
+  for (auto it = std::next(split_it); it != fields.end(); ++it) {
+    ptr = internal::WireFormat::InternalSerializeField(*it, *this, ptr, &out);
+  }
+  ptr = internal::WireFormat::InternalSerializeUnknownFieldsToArray(
+      reflection->GetUnknownFields(*this), ptr, &out);
+  ABSL_DCHECK_EQ(ptr, start + byte_size);
+
+  done.Wait();
+  return true;
+}
+
+namespace {
+
+// Every parallel task parses at least this many bytes.
+constexpr int kMinParallelParseBytes = 64 << 10;
+
+// The bounds of one length-delimited record within the input: the record
+// starts with its tag at `start`, and its payload is `size` bytes at `offset`.
+struct RecordRange {
+  int start;
+  int offset;
+  int size;
+};
+
+struct ParseRangeTask {
+  const Message* prototype;
+  Arena* arena;
+  const uint8_t* data;
+  const RecordRange* begin;
+  const RecordRange* end;
+  std::vector<Message*> elements;
+  bool ok;
+  absl::BlockingCounter* done;
+
+  static void Run(void* arg) {
+    auto* task = static_cast<ParseRangeTask*>(arg);
+    task->elements.reserve(task->end - task->begin);
+    for (const RecordRange* r = task->begin; r != task->end; ++r) {
+      Message* element = task->prototype->New(task->arena);
+      task->elements.push_back(element);
+      io::CodedInputStream input(task->data + r->offset, r->size);
+      // The element is one level below the top-level message.
+      input.SetRecursionLimit(io::CodedInputStream::GetDefaultRecursionLimit() -
+                              1);
+      if (!element->MergePartialFromCodedStream(&input) ||
+          !input.ConsumedEntireMessage()) {
+        task->ok = false;
+        break;
+      }
+    }
+    task->done->DecrementCount();
+  }
+};
+
+// Returns whether `field` holds records that ParsePartialFromArrayParallel()
+// can parse in isolation.
+bool IsSplittableParseField(const FieldDescriptor* field) {
+  return field != nullptr && field->is_repeated() && !field->is_map() &&
+         field->type() == FieldDescriptor::TYPE_MESSAGE;
+}
+
+}  // namespace
+
+bool Message::ParseFromArrayParallel(const void* data, int size,
+                                     internal::Executor executor,
+                                     int max_tasks) {
+  return ParsePartialFromArrayParallel(data, size, executor, max_tasks) &&
+         IsInitializedWithErrors();
+}
+
+bool Message::ParsePartialFromArrayParallel(const void* data, int size,
+                                            internal::Executor executor,
+                                            int max_tasks) {
+  const Descriptor* descriptor = GetDescriptor();
+  if (executor == nullptr || max_tasks < 2 ||
+      size < 2 * kMinParallelParseBytes ||
+      descriptor->options().message_set_wire_format()) {
+    return ParsePartialFromArray(data, size);
+  }
+
+  // Scan the top level, recording the payload bounds of every record of each
+  // repeated message field.  Anything unusual falls back to a serial parse so
+  // that errors are reported exactly as ParsePartialFromArray() would.
+  const uint8_t* const bytes = static_cast<const uint8_t*>(data);
+  absl::flat_hash_map<int, std::vector<RecordRange>> records;
+  absl::flat_hash_map<int, int64_t> record_bytes;
+  {
+    io::CodedInputStream input(bytes, size);
+    for (;;) {
+      const int start = input.CurrentPosition();
+      const uint32_t tag = input.ReadTag();
+      if (tag == 0) break;
+      const int number = internal::WireFormatLite::GetTagFieldNumber(tag);
+      if (internal::WireFormatLite::GetTagWireType(tag) ==
+              internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED &&
+          IsSplittableParseField(descriptor->FindFieldByNumber(number))) {
+        uint32_t length;
+        if (!input.ReadVarint32(&length) ||
+            length > static_cast<uint32_t>(size)) {
+          return ParsePartialFromArray(data, size);
+        }
+        const int offset = input.CurrentPosition();
+        if (!input.Skip(static_cast<int>(length))) {
+          return ParsePartialFromArray(data, size);
+        }
+        records[number].push_back({start, offset, static_cast<int>(length)});
+        record_bytes[number] += input.CurrentPosition() - start;
+      } else if (!internal::WireFormatLite::SkipField(&input, tag)) {
+        return ParsePartialFromArray(data, size);
+      }
+    }
+    if (!input.ConsumedEntireMessage() || input.CurrentPosition() != size) {
+      return ParsePartialFromArray(data, size);
+    }
+  }
+
+  int split_number = 0;
+  int64_t split_bytes = 0;
+  for (const auto& entry : record_bytes) {
+    if (entry.second > split_bytes) {
+      split_number = entry.first;
+      split_bytes = entry.second;
+    }
+  }
+  if (split_number == 0) return ParsePartialFromArray(data, size);
+  const std::vector<RecordRange>& split_records = records[split_number];
+  const int num_tasks = static_cast<int>(std::min<int64_t>(
+      {max_tasks, static_cast<int64_t>(split_records.size()),
+       split_bytes / kMinParallelParseBytes}));
+  if (num_tasks < 2) return ParsePartialFromArray(data, size);
+
+  const FieldDescriptor* split = descriptor->FindFieldByNumber(split_number);
+  const Reflection* reflection = GetReflection();
+  Clear();
+
+  // Cut the split field into ranges of roughly equal byte size.
+  std::vector<ParseRangeTask> tasks;
+  tasks.reserve(num_tasks);
+  absl::BlockingCounter done(num_tasks);
+  const Message* prototype =
+      reflection->GetMessageFactory()->GetPrototype(split->message_type());
+  const int64_t bytes_per_task = split_bytes / num_tasks;
+  const RecordRange* begin = split_records.data();
+  int64_t range_bytes = 0;
+  for (const RecordRange& r : split_records) {
+    range_bytes += r.offset + r.size - r.start;
+    const bool last = &r == &split_records.back();
+    if (last || (range_bytes >= bytes_per_task &&
+                 static_cast<int>(tasks.size()) + 1 < num_tasks)) {
+      tasks.push_back(
+          {prototype, GetArena(), bytes, begin, &r + 1, {}, true, &done});
+      begin = &r + 1;
+      range_bytes = 0;
+    }
+  }
+  for (int i = static_cast<int>(tasks.size()); i < num_tasks; ++i) {
+    done.DecrementCount();
+  }
+  for (ParseRangeTask& task : tasks) {
+    executor(&ParseRangeTask::Run, &task);
+  }
+
+  // Parse everything between the split records on the calling thread.
+  // Merging these runs in order is equivalent to parsing them in one go,
+  // since none of them touches the split field.
+  bool ok = true;
+  int run_start = 0;
+  auto merge_run = [&](int run_end) {
+    if (ok && run_end > run_start) {
+      io::CodedInputStream input(bytes + run_start, run_end - run_start);
+      ok = MergePartialFromCodedStream(&input) && input.ConsumedEntireMessage();
+    }
+  };
+  for (const RecordRange& r : split_records) {
+    merge_run(r.start);
+    run_start = r.offset + r.size;
+  }
+  merge_run(size);
+
+  // Stitch the elements into the field in wire order.  They were allocated
+  // on this message's arena, so they are added without copying.
+  done.Wait();
+  for (ParseRangeTask& task : tasks) {
+    ok &= task.ok;
+    for (Message* element : task.elements) {
+      reflection->UnsafeArenaAddAllocatedMessage(this, split, element);
+    }
+  }
+  return ok;
+}
+
 uint64_t Message::GetInvariantPerBuild(uint64_t salt) {
   return salt;
 }
@@ -298,6 +737,11 @@ class GeneratedMessageFactory final : public MessageFactory {
   absl::Mutex mutex_;
   absl::flat_hash_map<const Descriptor*, const Message*> type_map_
       ABSL_GUARDED_BY(mutex_);
+  // Mirror of type_map_ readable without the mutex. Files are published here
+  // only once RegisterFileLevelMetadata() has finished with all their types.
+  internal::InsertOnlyPointerMap<Descriptor, const Message> published_;
+  std::vector<std::pair<const Descriptor*, const Message*>> unpublished_
+      ABSL_GUARDED_BY(mutex_);
 };
 
 GeneratedMessageFactory* GeneratedMessageFactory::singleton() {
@@ -326,16 +770,14 @@ void GeneratedMessageFactory::RegisterType(const Descriptor* descriptor,
   if (!type_map_.try_emplace(descriptor, prototype).second) {
     ABSL_DLOG(FATAL) << "Type is already registered: "
                      << descriptor->full_name();
+    return;
   }
+  unpublished_.emplace_back(descriptor, prototype);
 }
 
 
 const Message* GeneratedMessageFactory::GetPrototype(const Descriptor* type) {
-  {
-    absl::ReaderMutexLock lock(&mutex_);
-    const Message* result = FindInTypeMap(type);
-    if (result != nullptr) return result;
-  }
+  if (const Message* result = published_.Find(type)) return result;
 
   // If the type is not in the generated pool, then we can't possibly handle
   // it.
@@ -358,6 +800,10 @@ const Message* GeneratedMessageFactory::GetPrototype(const Descriptor* type) {
   if (result == nullptr) {
     // Nope.  OK, register everything.
     internal::RegisterFileLevelMetadata(registration_data);
+    for (const auto& entry : unpublished_) {
+      published_.Insert(entry.first, entry.second);
+    }
+    unpublished_.clear();
     // Should be here now.
     result = FindInTypeMap(type);
   }
@@ -412,6 +858,9 @@ const internal::RepeatedFieldAccessor* Reflection::RepeatedFieldAccessor(
     HANDLE_PRIMITIVE_TYPE(ENUM, int32_t)
 #undef HANDLE_PRIMITIVE_TYPE
     case FieldDescriptor::CPPTYPE_STRING:
+      if (schema_.IsRepeatedStringBuffer(field)) {
+        return GetSingleton<internal::RepeatedStringBufferAccessor>();
+      }
       switch (field->options().ctype()) {
         default:
         case FieldOptions::STRING:
@@ -457,8 +906,25 @@ template void InternalMetadata::DoMergeFrom<UnknownFieldSet>(
     const UnknownFieldSet& other);
 template void InternalMetadata::DoSwap<UnknownFieldSet>(UnknownFieldSet* other);
 template void InternalMetadata::DeleteOutOfLineHelper<UnknownFieldSet>();
-template UnknownFieldSet*
-InternalMetadata::mutable_unknown_fields_slow<UnknownFieldSet>();
+
+template <>
+UnknownFieldSet*
+InternalMetadata::mutable_unknown_fields_slow<UnknownFieldSet>() {
+  Arena* my_arena = arena();
+  Container<UnknownFieldSet>* container;
+  if (my_arena == nullptr) {
+    container = new Container<UnknownFieldSet>();
+  } else {
+    // An arena-constructed UnknownFieldSet allocates everything it holds on
+    // the arena, so the container is never destroyed.
+    void* mem = my_arena->AllocateAligned(sizeof(Container<UnknownFieldSet>));
+    container = ::new (mem) Container<UnknownFieldSet>(my_arena);
+  }
+  ptr_ = reinterpret_cast<intptr_t>(container);
+  ptr_ |= kUnknownFieldsTagMask;
+  container->arena = my_arena;
+  return &(container->unknown_fields);
+}
 
 }  // namespace internal
 
@@ -146,6 +146,8 @@ namespace protobuf {
 class Message;
 class Reflection;
 class MessageFactory;
+template <typename T>
+class FieldAccessor;
 
 // Defined in other files.
 class AssignDescriptorsHelper;
@@ -192,6 +194,7 @@ PROTOBUF_EXPORT std::string Utf8Format(
     const Message& message);  // text_format.cc
 namespace util {
 class MessageDifferencer;
+class MessageFingerprinter;  // message_fingerprint.cc
 }
 
 
@@ -234,6 +237,16 @@ const To& GetConstRefAtOffset(const Message& message, uint32_t offset) {
 
 bool CreateUnknownEnumValues(const FieldDescriptor* field);
 
+// Where FieldAccessor finds a singular field, as resolved by Reflection.
+struct FieldAccessorLayout {
+  // False if the field must be accessed through the Reflection methods.
+  bool direct;
+  uint32_t offset;
+  uint32_t has_bits_offset;
+  // -1 if the field has no has-bit.
+  uint32_t has_bit_index;
+};
+
 // Returns true if "message" is a descendant of "root".
 PROTOBUF_EXPORT bool IsDescendant(Message& root, const Message& message);
 }  // namespace internal
@@ -324,6 +337,60 @@ class PROTOBUF_EXPORT Message : public MessageLite {
     return internal::ToIntSize(SpaceUsedLong());
   }
 
+  // Serialization ---------------------------------------------------
+
+  // Like ByteSizeLong(), but sizes the elements of the largest top-level
+  // repeated message field in up to `max_tasks` concurrent ranges, caching
+  // every sub-message size on the way.  Tasks are handed to `executor` and
+  // this call blocks until all of them have run.  Follow it with
+  // SerializeWithCachedSizesToString() to avoid a second size pass.
+  size_t ByteSizeLongParallel(internal::Executor executor,
+                              int max_tasks) const;
+
+  // Like SerializeToArray(), but serializes the largest top-level repeated
+  // message field in up to `max_tasks` concurrent ranges.  Sizes are computed
+  // with ByteSizeLongParallel(), after which the output offset of every
+  // element is known, so each task writes to a disjoint part of `data`.  This
+  // call blocks until all tasks have run.  The output is byte-for-byte
+  // identical to SerializeToArray().  Messages without a large
+  // enough repeated message field are serialized on the calling thread.
+  bool SerializeToArrayParallel(void* data, int size,
+                                internal::Executor executor,
+                                int max_tasks) const;
+  // Like SerializeToArrayParallel(), but allows missing required fields.
+  bool SerializePartialToArrayParallel(void* data, int size,
+                                       internal::Executor executor,
+                                       int max_tasks) const;
+
+  // Like ParseFromArray(), but parses the elements of the top-level repeated
+  // message field with the most bytes in up to `max_tasks` concurrent ranges.
+  // The top level of `data` is scanned first to find every element's bounds;
+  // each task then parses its elements into new messages on this message's
+  // arena (a ThreadSafeArena hands each thread its own block), while the
+  // remaining fields are parsed on the calling thread.  The elements are
+  // appended to the field in wire order once all tasks have run, so the
+  // result is the same as ParseFromArray().  Inputs without a large enough
+  // repeated message field are parsed on the calling thread.
+  bool ParseFromArrayParallel(const void* data, int size,
+                              internal::Executor executor, int max_tasks);
+  // Like ParseFromArrayParallel(), but allows missing required fields.
+  bool ParsePartialFromArrayParallel(const void* data, int size,
+                                     internal::Executor executor,
+                                     int max_tasks);
+
+  // Like SerializeToString(), but without the ByteSizeLong() pass: the message
+  // is encoded back to front in a single walk of the message tree, writing
+  // each length prefix after the contents it measures.  Fields are visited
+  // through reflection, so this pays off for messages that are serialized
+  // through reflection anyway, such as DynamicMessage, where it is about
+  // three times faster; generated classes serialize faster forward.  Cached
+  // sizes are neither used nor updated.  The output is the same as
+  // SerializeToString()'s, except for the order of map entries when
+  // serialization is not deterministic.
+  bool SerializeReverseToString(std::string* output) const;
+  // Like SerializeReverseToString(), but allows missing required fields.
+  bool SerializePartialReverseToString(std::string* output) const;
+
   // Debugging & Testing----------------------------------------------
 
   // Generates a human-readable form of this message for debugging purposes.
@@ -862,6 +929,19 @@ class PROTOBUF_EXPORT Reflection final {
   MutableRepeatedFieldRef<T> GetMutableRepeatedFieldRef(
       Message* message, const FieldDescriptor* field) const;
 
+  // Get a FieldAccessor for the singular field 'field', which must be a field
+  // (or extension) of this Reflection's message type. The type parameter T
+  // must be set according to the field's cpp type as for
+  // GetRepeatedFieldRef(), except that only the numeric and bool cpp types
+  // are supported.
+  //
+  // The checks that the Get*() and Set*() methods repeat on every call are
+  // done once here, so a FieldAccessor resolved up front and used for many
+  // messages reads and writes most fields directly. It can be used as long as
+  // this Reflection is alive, with messages whose GetReflection() is this.
+  template <typename T>
+  FieldAccessor<T> GetFieldAccessor(const FieldDescriptor* field) const;
+
   // DEPRECATED. Please use Get(Mutable)RepeatedFieldRef() for repeated field
   // access. The following repeated field accessors will be removed in the
   // future.
@@ -1000,6 +1080,11 @@ class PROTOBUF_EXPORT Reflection final {
                                   FieldDescriptor::CppType cpptype, int ctype,
                                   const Descriptor* message_type) const;
 
+  // Checks that 'field' is a singular field of type 'cpp_type' of this
+  // message and resolves its storage for GetFieldAccessor().
+  internal::FieldAccessorLayout ResolveFieldAccessor(
+      const FieldDescriptor* field, FieldDescriptor::CppType cpp_type) const;
+
   // The following methods are used to implement (Mutable)RepeatedFieldRef.
   // A Ref object will store a raw pointer to the repeated field data (obtained
   // from RepeatedFieldData()) and a pointer to a Accessor (obtained from
@@ -1086,6 +1171,7 @@ class PROTOBUF_EXPORT Reflection final {
   void PopulateTcParseEntries(internal::TailCallTableInfo& table_info,
                               TcParseTableBase::FieldEntry* entries) const;
   void PopulateTcParseFieldAux(const internal::TailCallTableInfo& table_info,
+                               const uint32_t* const* enum_data,
                                TcParseTableBase::FieldAux* field_aux) const;
 
   template <typename T, typename Enable>
@@ -1100,6 +1186,7 @@ class PROTOBUF_EXPORT Reflection final {
   friend class python::MapReflectionFriend;
   friend class python::MessageReflectionFriend;
   friend class util::MessageDifferencer;
+  friend class util::MessageFingerprinter;
 #define GOOGLE_PROTOBUF_HAS_CEL_MAP_REFLECTION_FRIEND
   friend class expr::CelMapReflectionFriend;
   friend class internal::MapFieldReflectionTest;
@@ -1584,6 +1671,117 @@ MutableRepeatedFieldRef<T> Reflection::GetMutableRepeatedFieldRef(
     Message* message, const FieldDescriptor* field) const {
   return MutableRepeatedFieldRef<T>(message, field);
 }
+
+namespace internal {
+template <typename T>
+struct FieldAccessorTraits;
+
+#define PROTOBUF_DEFINE_FIELD_ACCESSOR_TRAITS(TYPENAME, TYPE, CPPTYPE)     \
+  template <>                                                             \
+  struct FieldAccessorTraits<TYPE> {                                      \
+    static constexpr FieldDescriptor::CppType kCppType =                  \
+        FieldDescriptor::CPPTYPE_##CPPTYPE;                               \
+    static TYPE Get(const Reflection& reflection, const Message& message, \
+                    const FieldDescriptor* field) {                       \
+      return reflection.Get##TYPENAME(message, field);                    \
+    }                                                                     \
+    static void Set(const Reflection& reflection, Message* message,       \
+                    const FieldDescriptor* field, TYPE value) {           \
+      reflection.Set##TYPENAME(message, field, value);                    \
+    }                                                                     \
+  };
+
+PROTOBUF_DEFINE_FIELD_ACCESSOR_TRAITS(Int32, int32_t, INT32)
+PROTOBUF_DEFINE_FIELD_ACCESSOR_TRAITS(Int64, int64_t, INT64)
+PROTOBUF_DEFINE_FIELD_ACCESSOR_TRAITS(UInt32, uint32_t, UINT32)
+PROTOBUF_DEFINE_FIELD_ACCESSOR_TRAITS(UInt64, uint64_t, UINT64)
+PROTOBUF_DEFINE_FIELD_ACCESSOR_TRAITS(Float, float, FLOAT)
+PROTOBUF_DEFINE_FIELD_ACCESSOR_TRAITS(Double, double, DOUBLE)
+PROTOBUF_DEFINE_FIELD_ACCESSOR_TRAITS(Bool, bool, BOOL)
+#undef PROTOBUF_DEFINE_FIELD_ACCESSOR_TRAITS
+}  // namespace internal
+
+// A handle to one singular numeric or bool field of a message type, obtained
+// from Reflection::GetFieldAccessor(). Fields that are not extensions, oneof
+// members or split fields are read and written directly at their offset,
+// together with their has-bit; the rest go through the Reflection methods.
+// Either way the results are the same as the Reflection methods'.
+//
+// A FieldAccessor is cheap to copy and is meant to be resolved once per field
+// and reused for many messages, e.g. by generic reflection-based code.
+template <typename T>
+class FieldAccessor {
+ public:
+  using Traits = internal::FieldAccessorTraits<T>;
+
+  const FieldDescriptor* field() const { return field_; }
+
+  // Like Reflection::Get<TYPENAME>().
+  T Get(const Message& message) const {
+    ABSL_DCHECK_EQ(message.GetReflection(), reflection_);
+    if (PROTOBUF_PREDICT_TRUE(layout_.direct)) {
+      return internal::GetConstRefAtOffset<T>(message, layout_.offset);
+    }
+    return Traits::Get(*reflection_, message, field_);
+  }
+
+  // Like Reflection::Set<TYPENAME>().
+  void Set(Message* message, T value) const {
+    ABSL_DCHECK_EQ(message->GetReflection(), reflection_);
+    if (PROTOBUF_PREDICT_TRUE(layout_.direct)) {
+      *internal::GetPointerAtOffset<T>(message, layout_.offset) = value;
+      if (layout_.has_bit_index != static_cast<uint32_t>(-1)) {
+        HasBitsWord(message) |= 1u << (layout_.has_bit_index % 32);
+      }
+      return;
+    }
+    Traits::Set(*reflection_, message, field_, value);
+  }
+
+  // Like Reflection::HasField().
+  bool Has(const Message& message) const {
+    ABSL_DCHECK_EQ(message.GetReflection(), reflection_);
+    if (PROTOBUF_PREDICT_TRUE(layout_.direct)) {
+      if (layout_.has_bit_index != static_cast<uint32_t>(-1)) {
+        return (HasBitsWord(const_cast<Message*>(&message)) >>
+                (layout_.has_bit_index % 32)) &
+               1;
+      }
+      // Without a has-bit a field is present if it is non-zero. Compare the
+      // bits, so that -0.0 is present, like Reflection::HasField().
+      using Bits = typename std::conditional<
+          sizeof(T) == 8, uint64_t,
+          typename std::conditional<sizeof(T) == 4, uint32_t, T>::type>::type;
+      return internal::GetConstRefAtOffset<Bits>(message, layout_.offset) !=
+             Bits{0};
+    }
+    return reflection_->HasField(message, field_);
+  }
+
+ private:
+  friend class Reflection;
+
+  FieldAccessor(const Reflection* reflection, const FieldDescriptor* field,
+                internal::FieldAccessorLayout layout)
+      : reflection_(reflection), field_(field), layout_(layout) {}
+
+  uint32_t& HasBitsWord(Message* message) const {
+    return internal::GetPointerAtOffset<uint32_t>(
+        message, layout_.has_bits_offset)[layout_.has_bit_index / 32];
+  }
+
+  const Reflection* reflection_;
+  const FieldDescriptor* field_;
+  internal::FieldAccessorLayout layout_;
+};
+
+template <typename T>
+FieldAccessor<T> Reflection::GetFieldAccessor(
+    const FieldDescriptor* field) const {
+  return FieldAccessor<T>(
+      this, field,
+      ResolveFieldAccessor(field, internal::FieldAccessorTraits<T>::kCppType));
+}
 }  // namespace protobuf
 }  // namespace google
 
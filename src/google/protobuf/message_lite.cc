@@ -48,7 +48,6 @@
 #include "absl/log/absl_log.h"
 #include "absl/strings/cord.h"
 #include "absl/strings/cord_buffer.h"
-#include "absl/strings/internal/resize_uninitialized.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
@@ -58,6 +57,7 @@
 #include "google/protobuf/io/zero_copy_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl.h"
 #include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/messagez_sampler.h"
 #include "google/protobuf/parse_context.h"
 
 
@@ -122,13 +122,25 @@ inline absl::string_view as_string_view(const void* data, int size) {
 inline bool CheckFieldPresence(const internal::ParseContext& ctx,
                                const MessageLite& msg,
                                MessageLite::ParseFlags parse_flags) {
-  (void)ctx;  // Parameter is used by Google-internal code.
   if (PROTOBUF_PREDICT_FALSE((parse_flags & MessageLite::kMergePartial) != 0)) {
     return true;
   }
+  // The message was cleared before the parse, so every message in it was
+  // parsed, and the parser already found all of them to have their required
+  // fields.
+  if ((parse_flags & MessageLite::kParse) != 0 &&
+      !ctx.needs_initialization_check()) {
+    return true;
+  }
   return msg.IsInitializedWithErrors();
 }
 
+inline void SetDiscardUnknownFields(internal::ParseContext& ctx,
+                                    MessageLite::ParseFlags parse_flags) {
+  ctx.set_discard_unknown_fields(
+      (parse_flags & MessageLite::kMergeDiscardUnknown) != 0);
+}
+
 }  // namespace
 
 void MessageLite::LogInitializationErrorMessage() const {
@@ -140,12 +152,15 @@ namespace internal {
 template <bool aliasing>
 bool MergeFromImpl(absl::string_view input, MessageLite* msg,
                    MessageLite::ParseFlags parse_flags) {
+  MessagezScope messagez(MessagezOp::kParse);
   const char* ptr;
   internal::ParseContext ctx(io::CodedInputStream::GetDefaultRecursionLimit(),
                              aliasing, &ptr, input);
+  SetDiscardUnknownFields(ctx, parse_flags);
   ptr = msg->_InternalParse(ptr, &ctx);
   // ctx has an explicit limit set (length of string_view).
   if (PROTOBUF_PREDICT_TRUE(ptr && ctx.EndedAtLimit())) {
+    messagez.Record(*msg, input.size());
     return CheckFieldPresence(ctx, *msg, parse_flags);
   }
   return false;
@@ -154,12 +169,17 @@ bool MergeFromImpl(absl::string_view input, MessageLite* msg,
 template <bool aliasing>
 bool MergeFromImpl(io::ZeroCopyInputStream* input, MessageLite* msg,
                    MessageLite::ParseFlags parse_flags) {
+  MessagezScope messagez(MessagezOp::kParse);
+  // Not every stream keeps a cheap position, so only ask when sampled.
+  const int64_t start = messagez.sampled() ? input->ByteCount() : 0;
   const char* ptr;
   internal::ParseContext ctx(io::CodedInputStream::GetDefaultRecursionLimit(),
                              aliasing, &ptr, input);
+  SetDiscardUnknownFields(ctx, parse_flags);
   ptr = msg->_InternalParse(ptr, &ctx);
   // ctx has no explicit limit (hence we end on end of stream)
   if (PROTOBUF_PREDICT_TRUE(ptr && ctx.EndedAtEndOfStream())) {
+    if (messagez.sampled()) messagez.Record(*msg, input->ByteCount() - start);
     return CheckFieldPresence(ctx, *msg, parse_flags);
   }
   return false;
@@ -168,13 +188,16 @@ bool MergeFromImpl(io::ZeroCopyInputStream* input, MessageLite* msg,
 template <bool aliasing>
 bool MergeFromImpl(BoundedZCIS input, MessageLite* msg,
                    MessageLite::ParseFlags parse_flags) {
+  MessagezScope messagez(MessagezOp::kParse);
   const char* ptr;
   internal::ParseContext ctx(io::CodedInputStream::GetDefaultRecursionLimit(),
                              aliasing, &ptr, input.zcis, input.limit);
+  SetDiscardUnknownFields(ctx, parse_flags);
   ptr = msg->_InternalParse(ptr, &ctx);
   if (PROTOBUF_PREDICT_FALSE(!ptr)) return false;
   ctx.BackUp(ptr);
   if (PROTOBUF_PREDICT_TRUE(ctx.EndedAtLimit())) {
+    messagez.Record(*msg, input.limit);
     return CheckFieldPresence(ctx, *msg, parse_flags);
   }
   return false;
@@ -227,6 +250,8 @@ class ZeroCopyCodedInputStream : public io::ZeroCopyInputStream {
 
 bool MessageLite::MergeFromImpl(io::CodedInputStream* input,
                                 MessageLite::ParseFlags parse_flags) {
+  internal::MessagezScope messagez(internal::MessagezOp::kParse);
+  const int start = input->CurrentPosition();
   ZeroCopyCodedInputStream zcis(input);
   const char* ptr;
   internal::ParseContext ctx(input->RecursionBudget(), zcis.aliasing_enabled(),
@@ -237,6 +262,7 @@ bool MessageLite::MergeFromImpl(io::CodedInputStream* input,
   ctx.TrackCorrectEnding();
   ctx.data().pool = input->GetExtensionPool();
   ctx.data().factory = input->GetExtensionFactory();
+  SetDiscardUnknownFields(ctx, parse_flags);
   ptr = _InternalParse(ptr, &ctx);
   if (PROTOBUF_PREDICT_FALSE(!ptr)) return false;
   ctx.BackUp(ptr);
@@ -247,6 +273,7 @@ bool MessageLite::MergeFromImpl(io::CodedInputStream* input,
   } else {
     input->SetConsumed();
   }
+  messagez.Record(*this, input->CurrentPosition() - start);
   return CheckFieldPresence(ctx, *this, parse_flags);
 }
 
@@ -333,6 +360,24 @@ bool MessageLite::ParsePartialFromArray(const void* data, int size) {
   return ParseFrom<kParsePartial>(as_string_view(data, size));
 }
 
+bool MessageLite::ParseFromArrayAliased(const void* data, int size) {
+  return ParseFrom<kParseWithAliasing>(as_string_view(data, size));
+}
+
+bool MessageLite::ParsePartialFromArrayAliased(const void* data, int size) {
+  return ParseFrom<kParsePartialWithAliasing>(as_string_view(data, size));
+}
+
+bool MessageLite::ParseFromZeroCopyStreamAliased(
+    io::ZeroCopyInputStream* input) {
+  return ParseFrom<kParseWithAliasing>(input);
+}
+
+bool MessageLite::ParsePartialFromZeroCopyStreamAliased(
+    io::ZeroCopyInputStream* input) {
+  return ParseFrom<kParsePartialWithAliasing>(input);
+}
+
 bool MessageLite::MergeFromString(absl::string_view data) {
   return ParseFrom<kMerge>(data);
 }
@@ -417,6 +462,7 @@ bool MessageLite::SerializeToCodedStream(io::CodedOutputStream* output) const {
 
 bool MessageLite::SerializePartialToCodedStream(
     io::CodedOutputStream* output) const {
+  internal::MessagezScope messagez(internal::MessagezOp::kSerialize);
   const size_t size = ByteSizeLong();  // Force size to be cached.
   if (size > INT_MAX) {
     ABSL_LOG(ERROR) << GetTypeName()
@@ -436,6 +482,7 @@ bool MessageLite::SerializePartialToCodedStream(
                              final_byte_count - original_byte_count, *this);
   }
 
+  messagez.Record(*this, size);
   return true;
 }
 
@@ -448,6 +495,7 @@ bool MessageLite::SerializeToZeroCopyStream(
 
 bool MessageLite::SerializePartialToZeroCopyStream(
     io::ZeroCopyOutputStream* output) const {
+  internal::MessagezScope messagez(internal::MessagezOp::kSerialize);
   const size_t size = ByteSizeLong();  // Force size to be cached.
   if (size > INT_MAX) {
     ABSL_LOG(ERROR) << GetTypeName()
@@ -462,6 +510,7 @@ bool MessageLite::SerializePartialToZeroCopyStream(
   target = _InternalSerialize(target, &stream);
   stream.Trim(target);
   if (stream.HadError()) return false;
+  messagez.Record(*this, size);
   return true;
 }
 
@@ -495,6 +544,7 @@ bool MessageLite::AppendToString(std::string* output) const {
 }
 
 bool MessageLite::AppendPartialToString(std::string* output) const {
+  internal::MessagezScope messagez(internal::MessagezOp::kSerialize);
   size_t old_size = output->size();
   size_t byte_size = ByteSizeLong();
   if (byte_size > INT_MAX) {
@@ -503,11 +553,22 @@ bool MessageLite::AppendPartialToString(std::string* output) const {
     return false;
   }
 
-  absl::strings_internal::STLStringResizeUninitializedAmortized(
-      output, old_size + byte_size);
+  internal::STLStringResizeUninitializedAmortized(output,
+                                                  old_size + byte_size);
   uint8_t* start =
       reinterpret_cast<uint8_t*>(io::mutable_string_data(output) + old_size);
   SerializeToArrayImpl(*this, start, byte_size);
+  messagez.Record(*this, byte_size);
+  return true;
+}
+
+bool MessageLite::SerializeWithCachedSizesToString(std::string* output) const {
+  output->clear();
+  const int byte_size = GetCachedSize();
+  if (byte_size < 0) return false;
+  internal::STLStringResizeUninitializedAmortized(output, byte_size);
+  uint8_t* start = reinterpret_cast<uint8_t*>(io::mutable_string_data(output));
+  SerializeToArrayImpl(*this, start, byte_size);
   return true;
 }
 
@@ -528,6 +589,7 @@ bool MessageLite::SerializeToArray(void* data, int size) const {
 }
 
 bool MessageLite::SerializePartialToArray(void* data, int size) const {
+  internal::MessagezScope messagez(internal::MessagezOp::kSerialize);
   const size_t byte_size = ByteSizeLong();
   if (byte_size > INT_MAX) {
     ABSL_LOG(ERROR) << GetTypeName()
@@ -537,6 +599,31 @@ bool MessageLite::SerializePartialToArray(void* data, int size) const {
   if (size < static_cast<int64_t>(byte_size)) return false;
   uint8_t* start = reinterpret_cast<uint8_t*>(data);
   SerializeToArrayImpl(*this, start, byte_size);
+  messagez.Record(*this, byte_size);
+  return true;
+}
+
+bool MessageLite::SerializeToArena(Arena* arena,
+                                   absl::string_view* output) const {
+  ABSL_DCHECK(IsInitialized())
+      << InitializationErrorMessage("serialize", *this);
+  return SerializePartialToArena(arena, output);
+}
+
+bool MessageLite::SerializePartialToArena(Arena* arena,
+                                          absl::string_view* output) const {
+  ABSL_DCHECK(arena != nullptr);
+  internal::MessagezScope messagez(internal::MessagezOp::kSerialize);
+  const size_t byte_size = ByteSizeLong();
+  if (byte_size > INT_MAX) {
+    ABSL_LOG(ERROR) << GetTypeName()
+                    << " exceeded maximum protobuf size of 2GB: " << byte_size;
+    return false;
+  }
+  char* buffer = Arena::CreateArray<char>(arena, byte_size);
+  SerializeToArrayImpl(*this, reinterpret_cast<uint8_t*>(buffer), byte_size);
+  *output = absl::string_view(buffer, byte_size);
+  messagez.Record(*this, byte_size);
   return true;
 }
 
@@ -563,6 +650,7 @@ bool MessageLite::AppendToCord(absl::Cord* output) const {
 }
 
 bool MessageLite::AppendPartialToCord(absl::Cord* output) const {
+  internal::MessagezScope messagez(internal::MessagezOp::kSerialize);
   // For efficiency, we'd like to pass a size hint to CordOutputStream with
   // the exact total size expected.
   const size_t size = ByteSizeLong();
@@ -589,6 +677,7 @@ bool MessageLite::AppendPartialToCord(absl::Cord* output) const {
     buffer.IncreaseLengthBy(size);
     output->Append(std::move(buffer));
     ABSL_DCHECK_EQ(output->size(), total_size);
+    messagez.Record(*this, size);
     return true;
   }
 
@@ -605,6 +694,7 @@ bool MessageLite::AppendPartialToCord(absl::Cord* output) const {
   if (out.HadError()) return false;
   *output = output_stream.Consume();
   ABSL_DCHECK_EQ(output->size(), total_size);
+  messagez.Record(*this, size);
   return true;
 }
 
@@ -52,6 +52,7 @@
 #include "google/protobuf/arena.h"
 #include "google/protobuf/explicitly_constructed.h"
 #include "google/protobuf/internal_visibility.h"
+#include "google/protobuf/io/chunked_input_stream.h"
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/metadata_lite.h"
 #include "google/protobuf/port.h"
@@ -356,6 +357,28 @@ class PROTOBUF_EXPORT MessageLite {
   // required fields.
   PROTOBUF_ATTRIBUTE_REINITIALIZES bool ParsePartialFromArray(const void* data,
                                                               int size);
+  // Like ParseFromArray(), but fields that support it may reference `data`
+  // directly instead of copying it. Currently this applies to [ctype=CORD]
+  // fields, whose values larger than a small threshold alias the input. The
+  // caller must keep `data` alive and unmodified for as long as the message,
+  // or any Cord copied from it, may be read.
+  PROTOBUF_ATTRIBUTE_REINITIALIZES bool ParseFromArrayAliased(const void* data,
+                                                              int size);
+  // Like ParseFromArrayAliased(), but accepts messages that are missing
+  // required fields.
+  PROTOBUF_ATTRIBUTE_REINITIALIZES bool ParsePartialFromArrayAliased(
+      const void* data, int size);
+  // Like ParseFromZeroCopyStream(), but fields that support it may reference
+  // the chunks returned by `input` directly, as in ParseFromArrayAliased().
+  // Only use it with streams that return the caller's own memory, such as
+  // io::IovecInputStream or io::ArrayInputStream; all of that memory must
+  // outlive the message. Values split across chunks are still copied.
+  PROTOBUF_ATTRIBUTE_REINITIALIZES bool ParseFromZeroCopyStreamAliased(
+      io::ZeroCopyInputStream* input);
+  // Like ParseFromZeroCopyStreamAliased(), but accepts messages that are
+  // missing required fields.
+  PROTOBUF_ATTRIBUTE_REINITIALIZES bool ParsePartialFromZeroCopyStreamAliased(
+      io::ZeroCopyInputStream* input);
 
 
   // Reads a protocol buffer from the stream and merges it into this
@@ -407,6 +430,13 @@ class PROTOBUF_EXPORT MessageLite {
   bool SerializeToArray(void* data, int size) const;
   // Like SerializeToArray(), but allows missing required fields.
   bool SerializePartialToArray(void* data, int size) const;
+  // Serialize the message into a buffer of exactly ByteSizeLong() bytes
+  // allocated on `arena`, which must not be null, and point `output` at it.
+  // The buffer lives as long as the arena; unlike a std::string it is never
+  // zero-filled before being written.  All required fields must be set.
+  bool SerializeToArena(Arena* arena, absl::string_view* output) const;
+  // Like SerializeToArena(), but allows missing required fields.
+  bool SerializePartialToArena(Arena* arena, absl::string_view* output) const;
 
   // Make a string encoding the message. Is equivalent to calling
   // SerializeToString() on a string and using that.  Returns the empty
@@ -447,6 +477,35 @@ class PROTOBUF_EXPORT MessageLite {
   PROTOBUF_ATTRIBUTE_REINITIALIZES bool ParsePartialFromCord(
       const absl::Cord& cord);
 
+  // Reads a protocol buffer from the chunks of `source` and merges it into
+  // this message. `source` is any type with a non-virtual
+  // `bool Next(const void** data, int* size)`, such as a network buffer ring;
+  // see io::ChunkedInputStream. Unlike ParseFromZeroCopyStream(), the chunk
+  // iteration is inlined and small chunks are coalesced before parsing, which
+  // pays off for inputs that arrive in many chunks of less than 64 bytes.
+  template <typename ChunkSource>
+  bool MergeFromChunks(ChunkSource* source) {
+    return ParseFromChunksImpl<kMerge>(source);
+  }
+  // Like MergeFromChunks(), but accepts messages that are missing required
+  // fields.
+  template <typename ChunkSource>
+  bool MergePartialFromChunks(ChunkSource* source) {
+    return ParseFromChunksImpl<kMergePartial>(source);
+  }
+  // Parse a protocol buffer from the chunks of `source`, see MergeFromChunks().
+  template <typename ChunkSource>
+  PROTOBUF_ATTRIBUTE_REINITIALIZES bool ParseFromChunks(ChunkSource* source) {
+    return ParseFromChunksImpl<kParse>(source);
+  }
+  // Like ParseFromChunks(), but accepts messages that are missing required
+  // fields.
+  template <typename ChunkSource>
+  PROTOBUF_ATTRIBUTE_REINITIALIZES bool ParsePartialFromChunks(
+      ChunkSource* source) {
+    return ParseFromChunksImpl<kParsePartial>(source);
+  }
+
   // Serialize the message and store it in the given Cord.  All required
   // fields must be set.
   bool SerializeToCord(absl::Cord* output) const;
@@ -485,6 +544,11 @@ class PROTOBUF_EXPORT MessageLite {
     output->SetCur(_InternalSerialize(output->Cur(), output->EpsCopy()));
   }
 
+  // Like SerializeToString(), but uses the sizes cached by the last call to
+  // ByteSizeLong() instead of recomputing them.  The same caveats as for
+  // SerializeWithCachedSizes() apply.
+  bool SerializeWithCachedSizesToString(std::string* output) const;
+
   // Functions below here are not part of the public interface.  It isn't
   // enforced, but they should be treated as private, and will be private
   // at some future time.  Unfortunately the implementation of the "friend"
@@ -563,7 +627,13 @@ class PROTOBUF_EXPORT MessageLite {
     kMergeWithAliasing = 4,
     kParseWithAliasing = 5,
     kMergePartialWithAliasing = 6,
-    kParsePartialWithAliasing = 7
+    kParsePartialWithAliasing = 7,
+    // Fields the schema does not know are skipped rather than kept as unknown
+    // fields, without decoding anything inside them.
+    kMergeDiscardUnknown = 8,
+    kParseDiscardUnknown = 9,
+    kMergePartialDiscardUnknown = 10,
+    kParsePartialDiscardUnknown = 11
   };
 
   template <ParseFlags flags, typename T>
@@ -601,6 +671,12 @@ class PROTOBUF_EXPORT MessageLite {
   void LogInitializationErrorMessage() const;
 
   bool MergeFromImpl(io::CodedInputStream* input, ParseFlags parse_flags);
+
+  template <ParseFlags flags, typename ChunkSource>
+  bool ParseFromChunksImpl(ChunkSource* source) {
+    io::ChunkedInputStream<ChunkSource> input(source);
+    return ParseFrom<flags>(static_cast<io::ZeroCopyInputStream*>(&input));
+  }
 };
 
 namespace internal {
@@ -0,0 +1,164 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/messagez_sampler.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
+#include "absl/log/absl_log.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+namespace {
+
+PROTOBUF_CONSTINIT std::atomic<bool> g_messagez_enabled{false};
+PROTOBUF_CONSTINIT std::atomic<int32_t> g_messagez_sample_parameter{1 << 10};
+
+// The stride that ends with the next sample on this thread, which is the
+// weight of that sample.
+PROTOBUF_THREAD_LOCAL int64_t messagez_sample_stride = 0;
+PROTOBUF_THREAD_LOCAL uint64_t messagez_rng_state = 0;
+
+// Returns a stride uniformly distributed in [1, 2 * rate), so that samples
+// are not aligned with periodic call patterns. The mean is `rate`.
+int64_t NextStride(int32_t rate) {
+  uint64_t x = messagez_rng_state;
+  if (x == 0) {
+    x = reinterpret_cast<uintptr_t>(&messagez_rng_state) | 1;
+  }
+  // xorshift64
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  messagez_rng_state = x;
+  return 1 + static_cast<int64_t>(x % (2 * static_cast<uint64_t>(rate) - 1));
+}
+
+int64_t NowNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+struct Registry {
+  absl::Mutex mu;
+  absl::flat_hash_map<std::string, MessagezStats> stats ABSL_GUARDED_BY(mu);
+};
+
+Registry& GlobalRegistry() {
+  static auto* registry = new Registry();
+  return *registry;
+}
+
+}  // namespace
+
+PROTOBUF_THREAD_LOCAL int64_t messagez_next_sample = 0;
+
+int64_t MessagezSampleSlow(int64_t& start_nanos) {
+  const int32_t rate =
+      g_messagez_sample_parameter.load(std::memory_order_relaxed);
+  const int64_t weight = messagez_sample_stride;
+  messagez_sample_stride = NextStride(rate);
+  messagez_next_sample = messagez_sample_stride;
+  // The first call on a thread only starts the first stride. A stride that
+  // started while profiling was disabled is not sampled either, to keep the
+  // fast path free of any other check.
+  if (weight == 0 || !g_messagez_enabled.load(std::memory_order_relaxed)) {
+    return 0;
+  }
+  start_nanos = NowNanos();
+  return weight;
+}
+
+void MessagezRecordSlow(absl::string_view type_name, MessagezOp op,
+                        size_t bytes, int64_t weight, int64_t start_nanos) {
+  const int64_t nanos = NowNanos() - start_nanos;
+  Registry& registry = GlobalRegistry();
+  absl::MutexLock lock(&registry.mu);
+  MessagezStats& stats = registry.stats[type_name];
+  if (stats.type_name.empty()) stats.type_name = std::string(type_name);
+  MessagezOpStats& op_stats =
+      op == MessagezOp::kParse ? stats.parse : stats.serialize;
+  op_stats.calls += weight;
+  op_stats.bytes += static_cast<int64_t>(bytes) * weight;
+  op_stats.sampled_calls += 1;
+  op_stats.sampled_nanos += nanos;
+}
+
+void IterateMessagezStats(absl::FunctionRef<void(const MessagezStats&)> f) {
+  Registry& registry = GlobalRegistry();
+  absl::MutexLock lock(&registry.mu);
+  for (const auto& entry : registry.stats) f(entry.second);
+}
+
+void ResetMessagezStats() {
+  Registry& registry = GlobalRegistry();
+  absl::MutexLock lock(&registry.mu);
+  registry.stats.clear();
+}
+
+void SetMessagezEnabled(bool enabled) {
+  g_messagez_enabled.store(enabled, std::memory_order_release);
+}
+
+bool IsMessagezEnabled() {
+  return g_messagez_enabled.load(std::memory_order_acquire);
+}
+
+void SetMessagezSampleParameter(int32_t rate) {
+  if (rate > 0) {
+    g_messagez_sample_parameter.store(rate, std::memory_order_release);
+  } else {
+    ABSL_LOG(ERROR) << "Invalid messagez sample rate: " << rate;
+  }
+}
+
+int32_t MessagezSampleParameter() {
+  return g_messagez_sample_parameter.load(std::memory_order_acquire);
+}
+
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
@@ -0,0 +1,141 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Sampled, per-message-type profiling of parsing and serialization.
+//
+// When enabled, roughly one in every `MessagezSampleParameter()` calls to the
+// MessageLite parse and serialize entry points (ParseFrom*, MergeFrom*,
+// SerializeTo*, AppendTo*) is timed, and its byte count and latency are added
+// to its message type's totals. Each sample stands for the calls made since
+// the previous one, so the call and byte counts it reports are unbiased
+// estimates of the true totals. Every call made while profiling is disabled
+// costs one thread-local decrement.
+//
+// Nested messages are accounted to the outermost message being parsed or
+// serialized. Only successful calls are recorded.
+
+#ifndef GOOGLE_PROTOBUF_MESSAGEZ_SAMPLER_H__
+#define GOOGLE_PROTOBUF_MESSAGEZ_SAMPLER_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "absl/functional/function_ref.h"
+#include "absl/strings/string_view.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+
+enum class MessagezOp { kParse, kSerialize };
+
+struct MessagezOpStats {
+  // Estimated number of calls, and bytes parsed or serialized by them.
+  int64_t calls = 0;
+  int64_t bytes = 0;
+  // Number of calls that were sampled, and their total latency.
+  int64_t sampled_calls = 0;
+  int64_t sampled_nanos = 0;
+};
+
+// A snapshot of the statistics recorded for one message type.
+struct MessagezStats {
+  std::string type_name;
+  MessagezOpStats parse;
+  MessagezOpStats serialize;
+};
+
+// Calls `f` once for every message type that has recorded samples. The
+// registry is locked for the duration of the call, so `f` must not parse or
+// serialize sampled messages itself.
+PROTOBUF_EXPORT void IterateMessagezStats(
+    absl::FunctionRef<void(const MessagezStats&)> f);
+
+// Discards all recorded statistics.
+PROTOBUF_EXPORT void ResetMessagezStats();
+
+// Profiling is disabled by default.
+PROTOBUF_EXPORT void SetMessagezEnabled(bool enabled);
+PROTOBUF_EXPORT bool IsMessagezEnabled();
+
+// Sets the mean number of calls between two samples.
+PROTOBUF_EXPORT void SetMessagezSampleParameter(int32_t rate);
+PROTOBUF_EXPORT int32_t MessagezSampleParameter();
+
+// The number of calls left on this thread before the next sample is taken.
+extern PROTOBUF_THREAD_LOCAL int64_t messagez_next_sample;
+
+// Returns the weight of the sample to take now (0 for none), and its start
+// time.
+int64_t MessagezSampleSlow(int64_t& start_nanos);
+void MessagezRecordSlow(absl::string_view type_name, MessagezOp op,
+                        size_t bytes, int64_t weight, int64_t start_nanos);
+
+// Times one parse or serialize call if it has been chosen for sampling.
+class MessagezScope {
+ public:
+  explicit MessagezScope(MessagezOp op) : op_(op) {
+    if (PROTOBUF_PREDICT_FALSE(--messagez_next_sample <= 0)) {
+      weight_ = MessagezSampleSlow(start_nanos_);
+    }
+  }
+
+  MessagezScope(const MessagezScope&) = delete;
+  MessagezScope& operator=(const MessagezScope&) = delete;
+
+  // Whether this call is sampled, for callers that need extra work (such as
+  // querying a stream position) to compute the recorded byte count.
+  bool sampled() const { return weight_ != 0; }
+
+  // Records the call as one of `msg`'s type that processed `bytes` bytes. The
+  // type name is only looked up for sampled calls.
+  template <typename Msg>
+  void Record(const Msg& msg, size_t bytes) const {
+    if (PROTOBUF_PREDICT_TRUE(weight_ == 0)) return;
+    MessagezRecordSlow(msg.GetTypeName(), op_, bytes, weight_, start_nanos_);
+  }
+
+ private:
+  MessagezOp op_;
+  int64_t weight_ = 0;
+  int64_t start_nanos_ = 0;
+};
+
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_MESSAGEZ_SAMPLER_H__
@@ -0,0 +1,111 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/messagez_sampler.h"
+
+#include <cstdint>
+#include <string>
+
+#include <gtest/gtest.h>
+#include "google/protobuf/test_util.h"
+#include "google/protobuf/unittest.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+namespace {
+
+using ::protobuf_unittest::TestAllTypes;
+
+class MessagezSamplerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    old_rate_ = MessagezSampleParameter();
+    SetMessagezSampleParameter(1);
+    SetMessagezEnabled(true);
+    // End the current stride, so that every later call is sampled with a
+    // weight of one.
+    messagez_next_sample = 1;
+    TestAllTypes().SerializeAsString();
+    ResetMessagezStats();
+  }
+
+  void TearDown() override {
+    SetMessagezEnabled(false);
+    SetMessagezSampleParameter(old_rate_);
+    ResetMessagezStats();
+  }
+
+  static MessagezStats Find(const std::string& type_name) {
+    MessagezStats found;
+    IterateMessagezStats([&](const MessagezStats& stats) {
+      if (stats.type_name == type_name) found = stats;
+    });
+    return found;
+  }
+
+  int32_t old_rate_;
+};
+
+TEST_F(MessagezSamplerTest, RecordsParseAndSerialize) {
+  TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  std::string data;
+  ASSERT_TRUE(message.SerializeToString(&data));
+  ASSERT_TRUE(message.ParseFromString(data));
+  ASSERT_TRUE(message.ParseFromArray(data.data(), data.size()));
+
+  MessagezStats stats = Find(message.GetTypeName());
+  EXPECT_EQ(stats.serialize.calls, 1);
+  EXPECT_EQ(stats.serialize.bytes, static_cast<int64_t>(data.size()));
+  EXPECT_EQ(stats.serialize.sampled_calls, 1);
+  EXPECT_EQ(stats.parse.calls, 2);
+  EXPECT_EQ(stats.parse.bytes, 2 * static_cast<int64_t>(data.size()));
+  EXPECT_EQ(stats.parse.sampled_calls, 2);
+  EXPECT_GE(stats.parse.sampled_nanos, 0);
+}
+
+TEST_F(MessagezSamplerTest, SkipsFailedParses) {
+  TestAllTypes message;
+  EXPECT_FALSE(message.ParseFromString("\xff"));
+  EXPECT_EQ(Find(message.GetTypeName()).parse.calls, 0);
+}
+
+TEST_F(MessagezSamplerTest, RecordsNothingWhenDisabled) {
+  SetMessagezEnabled(false);
+  TestAllTypes message;
+  for (int i = 0; i < 10; ++i) message.SerializeAsString();
+  EXPECT_EQ(Find(message.GetTypeName()).serialize.calls, 0);
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
@@ -176,6 +176,9 @@ class PROTOBUF_EXPORT InternalMetadata {
 
   template <typename T>
   struct Container : public ContainerBase {
+    Container() = default;
+    explicit Container(Arena* arena) : unknown_fields(arena) {}
+
     T unknown_fields;
   };
 
@@ -240,7 +243,10 @@ extern template PROTOBUF_EXPORT void
 InternalMetadata::DoSwap<UnknownFieldSet>(UnknownFieldSet* other);
 extern template PROTOBUF_EXPORT void
 InternalMetadata::DeleteOutOfLineHelper<UnknownFieldSet>();
-extern template PROTOBUF_EXPORT UnknownFieldSet*
+// Specialized in message.cc to keep an arena's unknown fields entirely on the
+// arena, without a cleanup for the container.
+template <>
+PROTOBUF_EXPORT UnknownFieldSet*
 InternalMetadata::mutable_unknown_fields_slow<UnknownFieldSet>();
 
 // This helper RAII class is needed to efficiently parse unknown fields. We
@@ -33,6 +33,7 @@
 #include <algorithm>
 #include <cstring>
 
+#include "absl/numeric/bits.h"
 #include "absl/strings/cord.h"
 #include "absl/strings/string_view.h"
 #include "google/protobuf/message_lite.h"
@@ -40,6 +41,10 @@
 #include "google/protobuf/wire_format_lite.h"
 #include "utf8_validity.h"
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
 
 // Must be included last.
 #include "google/protobuf/port_def.inc"
@@ -204,6 +209,24 @@ std::pair<const char*, bool> EpsCopyInputStream::DoneFallback(int overrun,
   return {p, false};
 }
 
+int EpsCopyInputStream::CountLengthDelimitedRun(const char* ptr,
+                                                uint32_t tag) const {
+  // A tag and a length take at most 10 bytes, so both can be read from
+  // anywhere before limit_end_ without running past the slop region.
+  int count = 0;
+  while (ptr < limit_end_) {
+    uint32_t size = ReadSize(&ptr);
+    if (ptr == nullptr || size > static_cast<size_t>(limit_end_ - ptr)) break;
+    ptr += size;
+    ++count;
+    if (ptr >= limit_end_) break;
+    uint32_t next_tag;
+    ptr = ReadTag(ptr, &next_tag);
+    if (ptr == nullptr || next_tag != tag) break;
+  }
+  return count;
+}
+
 const char* EpsCopyInputStream::SkipFallback(const char* ptr, int size) {
   return AppendSize(ptr, size, [](const char* /*p*/, int /*s*/) {});
 }
@@ -235,6 +258,12 @@ const char* EpsCopyInputStream::AppendStringFallback(const char* ptr, int size,
 
 const char* EpsCopyInputStream::ReadCordFallback(const char* ptr, int size,
                                                  absl::Cord* cord) {
+  if (const char* aliased = AliasedData(ptr, size)) {
+    // The input outlives the parsed message, so reference it directly.
+    *cord = absl::MakeCordFromExternal(absl::string_view(aliased, size),
+                                       [](absl::string_view) {});
+    return ptr + size;
+  }
   if (zcis_ == nullptr) {
     int bytes_from_buffer = buffer_end_ - ptr + kSlopBytes;
     if (size <= bytes_from_buffer) {
@@ -355,6 +384,97 @@ void WriteLengthDelimited(uint32_t num, absl::string_view val, std::string* s) {
   s->append(val.data(), val.size());
 }
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && \
+    defined(PROTOBUF_LITTLE_ENDIAN)
+#define PROTOBUF_VARINT_PEXT 1
+
+namespace {
+
+// Decodes a varint of at least six bytes without a loop: the terminating byte
+// is found from the continuation bits, and PEXT gathers the 7 payload bits of
+// every byte up to it. Like the aarch64 VarintParse(), this loads 8 bytes
+// unconditionally, which the parse context's slop region makes safe.
+__attribute__((target("bmi2"))) std::pair<const char*, uint64_t>
+VarintParseLongBmi2(const char* p) {
+  constexpr uint64_t kPayloadBits = 0x7f7f7f7f7f7f7f7f;
+  uint64_t first8;
+  std::memcpy(&first8, p, sizeof(first8));
+  const uint64_t last_bytes = ~first8 & 0x8080808080808080;
+  if (last_bytes != 0) {
+    // All bits up to and including the stop bit of the last byte.
+    const uint64_t varint_bits = last_bytes ^ (last_bytes - 1);
+    return {p + absl::countr_zero(last_bytes) / 8 + 1,
+            _pext_u64(first8, varint_bits & kPayloadBits)};
+  }
+  // Nine and ten byte varints, e.g. negative int32 and int64 values.
+  uint64_t res = _pext_u64(first8, kPayloadBits);
+  uint64_t byte = static_cast<uint8_t>(p[8]);
+  res |= (byte & 0x7f) << 56;
+  if (byte < 128) return {p + 9, res};
+  byte = static_cast<uint8_t>(p[9]);
+  res |= byte << 63;
+  if (byte < 128) return {p + 10, res};
+  return {nullptr, 0};
+}
+
+// Whether PEXT is available and fast. AMD CPUs before Zen 3 (family 19h)
+// implement it in microcode, where it is much slower than the portable loop.
+// So do Hygon's Zen-based CPUs (family 18h), which __builtin_cpu_is("amd")
+// does not recognize, so we check the vendor string ourselves.
+bool HasFastPext() {
+  __builtin_cpu_init();
+  if (!__builtin_cpu_supports("bmi2")) return false;
+  unsigned eax, ebx, ecx, edx;
+  if (!__get_cpuid(0, &eax, &ebx, &ecx, &edx)) return false;
+  char vendor[12];
+  memcpy(vendor, &ebx, 4);
+  memcpy(vendor + 4, &edx, 4);
+  memcpy(vendor + 8, &ecx, 4);
+  const absl::string_view vendor_id(vendor, sizeof(vendor));
+  if (vendor_id != "AuthenticAMD" && vendor_id != "HygonGenuine") return true;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+  const unsigned family = ((eax >> 8) & 0xf) + ((eax >> 20) & 0xff);
+  return family >= 0x19;
+}
+
+// Selected on first use rather than by a dynamic initializer, so that parsing
+// works during static initialization too.
+bool UseBmi2() {
+  static const bool use_bmi2 = HasFastPext();
+  return use_bmi2;
+}
+
+}  // namespace
+
+#endif  // x86-64 GCC or Clang
+
+namespace {
+
+std::pair<const char*, uint64_t> VarintParseSlow64Portable(const char* p,
+                                                           uint32_t res32) {
+  uint64_t res = res32;
+  for (std::uint32_t i = 1; i < 10; i++) {
+    uint64_t byte = static_cast<uint8_t>(p[i]);
+    res += (byte - 1) << (7 * i);
+    if (PROTOBUF_PREDICT_TRUE(byte < 128)) {
+      return {p + i + 1, res};
+    }
+  }
+  return {nullptr, 0};
+}
+
+#ifdef PROTOBUF_VARINT_PEXT
+// Varints of six bytes or more are rare, so the dispatch is kept out of line
+// to leave the common path of VarintParseSlow64() untouched.
+PROTOBUF_NOINLINE std::pair<const char*, uint64_t> VarintParseSlow64Long(
+    const char* p, uint32_t res32) {
+  if (UseBmi2()) return VarintParseLongBmi2(p);
+  return VarintParseSlow64Portable(p, res32);
+}
+#endif
+
+}  // namespace
+
 std::pair<const char*, uint32_t> VarintParseSlow32(const char* p,
                                                    uint32_t res) {
   for (std::uint32_t i = 1; i < 5; i++) {
@@ -376,17 +496,21 @@ std::pair<const char*, uint32_t> VarintParseSlow32(const char* p,
 
 std::pair<const char*, uint64_t> VarintParseSlow64(const char* p,
                                                    uint32_t res32) {
-  uint64_t res = res32;
-  for (std::uint32_t i = 1; i < 10; i++) {
-    uint64_t byte = static_cast<uint8_t>(p[i]);
-    res += (byte - 1) << (7 * i);
-    if (PROTOBUF_PREDICT_TRUE(byte < 128)) {
-      return {p + i + 1, res};
-    }
+#ifdef PROTOBUF_VARINT_PEXT
+  // Short varints are decoded fastest by the loop: with predictable lengths
+  // its branches let the parser run ahead, where PEXT would put the length on
+  // the critical path. Only varints longer than five bytes are dispatched.
+  uint64_t first8;
+  std::memcpy(&first8, p, sizeof(first8));
+  if (PROTOBUF_PREDICT_FALSE((~first8 & 0x8080808080) == 0)) {
+    return VarintParseSlow64Long(p, res32);
   }
-  return {nullptr, 0};
+#endif
+  return VarintParseSlow64Portable(p, res32);
 }
 
+#undef PROTOBUF_VARINT_PEXT
+
 std::pair<const char*, uint32_t> ReadTagFallback(const char* p, uint32_t res) {
   for (std::uint32_t i = 2; i < 5; i++) {
     uint32_t byte = static_cast<uint8_t>(p[i]);
@@ -448,19 +572,8 @@ const char* InlineGreedyStringParser(std::string* s, const char* ptr,
 
 template <typename T, bool sign>
 const char* VarintParser(void* object, const char* ptr, ParseContext* ctx) {
-  return ctx->ReadPackedVarint(ptr, [object](uint64_t varint) {
-    T val;
-    if (sign) {
-      if (sizeof(T) == 8) {
-        val = WireFormatLite::ZigZagDecode64(varint);
-      } else {
-        val = WireFormatLite::ZigZagDecode32(varint);
-      }
-    } else {
-      val = varint;
-    }
-    static_cast<RepeatedField<T>*>(object)->Add(val);
-  });
+  return ctx->ReadPackedVarintInto<T, sign>(
+      ptr, static_cast<RepeatedField<T>*>(object));
 }
 
 const char* PackedInt32Parser(void* object, const char* ptr,
@@ -579,6 +692,83 @@ class UnknownFieldLiteParserHelper {
   std::string* unknown_;
 };
 
+namespace {
+
+// Returns the end of the varint at `ptr`, or nullptr if it is longer than ten
+// bytes.
+inline const char* SkipVarint(const char* ptr, const ParseContext* ctx) {
+  if (PROTOBUF_PREDICT_TRUE(ctx->MaximumReadSize(ptr) >= 16)) {
+    // The varint ends at the first byte with a clear continuation bit.
+    uint32_t ends = ~VarintContinuationMask16(ptr) & 0x3FF;
+    if (PROTOBUF_PREDICT_FALSE(ends == 0)) return nullptr;
+    return ptr + absl::countr_zero(ends) + 1;
+  }
+  for (int i = 0; i < 10; ++i) {
+    if (static_cast<uint8_t>(ptr[i]) < 0x80) return ptr + i + 1;
+  }
+  return nullptr;
+}
+
+// Walks over the fields of a group, for ParseContext::ParseGroup.
+class UnknownGroupSkipper {
+ public:
+  const char* _InternalParse(const char* ptr, ParseContext* ctx) {
+    while (!ctx->Done(&ptr)) {
+      uint32_t tag;
+      ptr = ReadTag(ptr, &tag);
+      GOOGLE_PROTOBUF_PARSER_ASSERT(ptr != nullptr);
+      if (tag == 0 || (tag & 7) == WireFormatLite::WIRETYPE_END_GROUP) {
+        ctx->SetLastTag(tag);
+        return ptr;
+      }
+      ptr = SkipUnknownField(tag, ptr, ctx);
+      GOOGLE_PROTOBUF_PARSER_ASSERT(ptr != nullptr);
+    }
+    return ptr;
+  }
+};
+
+}  // namespace
+
+const char* SkipUnknownField(uint32_t tag, const char* ptr,
+                             ParseContext* ctx) {
+  while (true) {
+    switch (tag & 7) {
+      case WireFormatLite::WIRETYPE_VARINT:
+        ptr = SkipVarint(ptr, ctx);
+        break;
+      case WireFormatLite::WIRETYPE_FIXED64:
+        ptr += 8;
+        break;
+      case WireFormatLite::WIRETYPE_LENGTH_DELIMITED: {
+        int size = ReadSize(&ptr);
+        GOOGLE_PROTOBUF_PARSER_ASSERT(ptr != nullptr);
+        ptr = ctx->Skip(ptr, size);
+        break;
+      }
+      case WireFormatLite::WIRETYPE_START_GROUP: {
+        UnknownGroupSkipper skipper;
+        ptr = ctx->ParseGroup(&skipper, ptr, tag);
+        break;
+      }
+      case WireFormatLite::WIRETYPE_FIXED32:
+        ptr += 4;
+        break;
+      default:
+        return nullptr;
+    }
+    GOOGLE_PROTOBUF_PARSER_ASSERT(ptr != nullptr);
+    // Unknown fields tend to come in runs of the same repeated field; stay
+    // here while the next tag matches rather than going back to the caller's
+    // dispatch for each of them.
+    if (ctx->Done(&ptr)) return ptr;
+    uint32_t next_tag;
+    const char* next = ReadTag(ptr, &next_tag);
+    if (next == nullptr || next_tag != tag) return ptr;
+    ptr = next;
+  }
+}
+
 const char* UnknownGroupLiteParse(std::string* unknown, const char* ptr,
                                   ParseContext* ctx) {
   UnknownFieldLiteParserHelper field_parser(unknown);
@@ -40,8 +40,8 @@
 #include "absl/base/config.h"
 #include "absl/log/absl_check.h"
 #include "absl/log/absl_log.h"
+#include "absl/numeric/bits.h"
 #include "absl/strings/cord.h"
-#include "absl/strings/internal/resize_uninitialized.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
 #include "google/protobuf/arena.h"
@@ -54,6 +54,7 @@
 #include "google/protobuf/metadata_lite.h"
 #include "google/protobuf/port.h"
 #include "google/protobuf/repeated_field.h"
+#include "google/protobuf/varint_shuffle.h"
 #include "google/protobuf/wire_format_lite.h"
 
 
@@ -67,6 +68,7 @@ namespace protobuf {
 class UnknownFieldSet;
 class DescriptorPool;
 class MessageFactory;
+class RepeatedStringBuffer;
 
 namespace internal {
 
@@ -206,7 +208,7 @@ class PROTOBUF_EXPORT EpsCopyInputStream {
       // However micro-benchmarks regress on string reading cases. So we copy
       // the same logic from the old CodedInputStream ReadString. Note: as of
       // Apr 2021, this is still a significant win over `assign()`.
-      absl::strings_internal::STLStringResizeUninitialized(s, size);
+      STLStringResizeUninitialized(s, size);
       char* z = &(*s)[0];
       memcpy(z, ptr, size);
       return ptr + size;
@@ -252,6 +254,12 @@ class PROTOBUF_EXPORT EpsCopyInputStream {
   template <typename Add, typename SizeCb>
   PROTOBUF_NODISCARD const char* ReadPackedVarint(const char* ptr, Add add,
                                                   SizeCb size_callback);
+  // Bulk variant of ReadPackedVarint that appends every value of the packed
+  // run to `out`, zigzag decoding them if requested. `out` is grown once per
+  // buffer chunk, to exactly the number of varints in that chunk.
+  template <typename T, bool zigzag = false>
+  PROTOBUF_NODISCARD const char* ReadPackedVarintInto(const char* ptr,
+                                                      RepeatedField<T>* out);
 
   uint32_t LastTag() const { return last_tag_minus_1_ + 1; }
   bool ConsumeEndGroup(uint32_t start_tag) {
@@ -268,6 +276,21 @@ class PROTOBUF_EXPORT EpsCopyInputStream {
            (next_chunk_ == nullptr || ptr - buffer_end_ > limit_);
   }
   bool AliasingEnabled() const { return aliasing_ != kNoAliasing; }
+
+  // Returns the address in the original input of the `size` bytes at `ptr`,
+  // or nullptr if aliasing is disabled or those bytes are not contiguous in
+  // the input (e.g. they were stitched together in the patch buffer).
+  const char* AliasedData(const char* ptr, int size) const {
+    if (aliasing_ < kNoDelta) return nullptr;
+    // The bytes must be in the current buffer and within the current limit.
+    if (size > buffer_end_ + kSlopBytes - ptr ||
+        size > buffer_end_ - ptr + limit_) {
+      return nullptr;
+    }
+    if (aliasing_ == kNoDelta) return ptr;
+    return reinterpret_cast<const char*>(reinterpret_cast<std::uintptr_t>(ptr) +
+                                         aliasing_);
+  }
   int BytesUntilLimit(const char* ptr) const {
     return limit_ + static_cast<int>(buffer_end_ - ptr);
   }
@@ -275,9 +298,21 @@ class PROTOBUF_EXPORT EpsCopyInputStream {
   int MaximumReadSize(const char* ptr) const {
     return static_cast<int>(limit_end_ - ptr) + kSlopBytes;
   }
+  // Returns the end of the data that can be read from `ptr` without fetching
+  // another buffer. Unlike MaximumReadSize() this stops at the current limit
+  // and excludes the slop region when no data follows it.
+  const char* ReadableEnd(const char* ptr) const {
+    if (next_chunk_ == nullptr) return limit_end_;
+    return ptr + std::min(BytesUntilLimit(ptr), MaximumReadSize(ptr));
+  }
   // Returns true if more data is available, if false is returned one has to
   // call Done for further checks.
   bool DataAvailable(const char* ptr) { return ptr < limit_end_; }
+  // Returns how many consecutive length delimited fields with tag `tag` lie
+  // entirely in the current buffer. `ptr` points at the length of the first
+  // one, i.e. just past its tag. Only the tags and lengths are read; this is
+  // used to size containers before parsing a run of entries.
+  int CountLengthDelimitedRun(const char* ptr, uint32_t tag) const;
 
  protected:
   // Returns true is limit (either an explicit limit or end of stream) is
@@ -404,6 +439,13 @@ class PROTOBUF_EXPORT EpsCopyInputStream {
     overall_limit_ += count;
   }
 
+  // Reads `size` bytes of packed varints, handing each contiguous range of
+  // complete varints to `read_array(begin, end)`, which must return the
+  // position after the last varint it consumed or nullptr on error.
+  template <typename ReadArray>
+  const char* ReadPackedVarintChunks(const char* ptr, int size,
+                                     ReadArray read_array);
+
   template <typename A>
   const char* AppendSize(const char* ptr, int size, const A& append) {
     int chunk_size = static_cast<int>(buffer_end_ + kSlopBytes - ptr);
@@ -453,6 +495,7 @@ class PROTOBUF_EXPORT EpsCopyInputStream {
         ptr, [str](const char* p, ptrdiff_t s) { str->append(p, s); });
   }
   friend class ImplicitWeakMessage;
+  friend class ::google::protobuf::RepeatedStringBuffer;
 
   // Needs access to kSlopBytes.
   friend PROTOBUF_EXPORT std::pair<const char*, int32_t> ReadSizeFallback(
@@ -492,6 +535,7 @@ class PROTOBUF_EXPORT ParseContext : public EpsCopyInputStream {
   ParseContext(Spawn, const ParseContext& ctx, const char** start, T&&... args)
       : EpsCopyInputStream(false),
         depth_(ctx.depth_),
+        discard_unknown_fields_(ctx.discard_unknown_fields_),
         data_(ctx.data_)
   {
     *start = InitFrom(std::forward<T>(args)...);
@@ -515,6 +559,26 @@ class PROTOBUF_EXPORT ParseContext : public EpsCopyInputStream {
   Data& data() { return data_; }
   const Data& data() const { return data_; }
 
+  // Called when a parsed message may be missing required fields, or was
+  // parsed by a routine that does not check them.
+  void RequireInitializationCheck() { needs_initialization_check_ = true; }
+  // False if every message parsed so far was found to have all its required
+  // fields when its parse ended.  A parse into a cleared message then needs no
+  // IsInitialized() walk.  Contexts spawned from this one do not report back;
+  // their users must forward the flag.
+  bool needs_initialization_check() const {
+    return needs_initialization_check_;
+  }
+
+  // When set, fields the schema does not know are skipped with
+  // SkipUnknownField() instead of being stored in the message's unknown
+  // fields.  Extensions of messages that declare extension ranges are still
+  // handed to the ExtensionSet.
+  void set_discard_unknown_fields(bool discard) {
+    discard_unknown_fields_ = discard;
+  }
+  bool discard_unknown_fields() const { return discard_unknown_fields_; }
+
   const char* ParseMessage(MessageLite* msg, const char* ptr);
 
   // This overload supports those few cases where ParseMessage is called
@@ -608,6 +672,8 @@ class PROTOBUF_EXPORT ParseContext : public EpsCopyInputStream {
   // Unfortunately necessary for the fringe case of ending on 0 or end-group tag
   // in the last kSlopBytes of a ZeroCopyInputStream chunk.
   int group_depth_ = INT_MIN;
+  bool needs_initialization_check_ = false;
+  bool discard_unknown_fields_ = false;
   Data data_;
 };
 
@@ -1242,16 +1308,66 @@ const char* ReadPackedVarintArray(const char* ptr, const char* end, Add add) {
   return ptr;
 }
 
-template <typename Add, typename SizeCb>
-const char* EpsCopyInputStream::ReadPackedVarint(const char* ptr, Add add,
-                                                 SizeCb size_callback) {
-  int size = ReadSize(&ptr);
-  size_callback(size);
+template <typename T, bool zigzag>
+inline T DecodePackedVarint(uint64_t varint) {
+  if (zigzag) {
+    if (sizeof(T) == 8) {
+      return static_cast<T>(WireFormatLite::ZigZagDecode64(varint));
+    } else {
+      return static_cast<T>(
+          WireFormatLite::ZigZagDecode32(static_cast<uint32_t>(varint)));
+    }
+  }
+  return static_cast<T>(varint);
+}
 
-  GOOGLE_PROTOBUF_PARSER_ASSERT(ptr);
+// Decodes all varints starting in [ptr, end) and appends them to `out`. The
+// varints are counted up front so `out` is resized once and the values are
+// stored directly, with runs of single byte varints widened 16 at a time.
+template <typename T, bool zigzag>
+const char* ReadPackedVarintArrayInto(const char* ptr, const char* end,
+                                      RepeatedField<T>* out) {
+  // Bools and 64 bit values need the full 64 bit decode, the 32 bit decode
+  // is only valid for the low 32 bits of the value.
+  using VarintType =
+      std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>;
+  const int count = CountVarints(ptr, end);
+  if (count == 0) return ptr;
+  const int old_size = out->size();
+  out->Reserve(old_size + count);
+  T* const begin = out->AddNAlreadyReserved(count);
+  T* dst = begin;
+  while (ptr < end) {
+    if (end - ptr >= 16) {
+      uint32_t mask = VarintContinuationMask16(ptr);
+      int run = mask == 0 ? 16 : absl::countr_zero(mask);
+      for (int i = 0; i < run; ++i) {
+        dst[i] = DecodePackedVarint<T, zigzag>(static_cast<uint8_t>(ptr[i]));
+      }
+      dst += run;
+      ptr += run;
+      if (run == 16) continue;
+    }
+    int64_t res;
+    ptr = ShiftMixParseVarint<VarintType>(ptr, res);
+    if (PROTOBUF_PREDICT_FALSE(ptr == nullptr)) {
+      // Drop the slots that were reserved for the remaining values.
+      out->Truncate(old_size + static_cast<int>(dst - begin));
+      return nullptr;
+    }
+    *dst++ = DecodePackedVarint<T, zigzag>(static_cast<uint64_t>(res));
+  }
+  ABSL_DCHECK_EQ(dst - begin, count);
+  return ptr;
+}
+
+template <typename ReadArray>
+const char* EpsCopyInputStream::ReadPackedVarintChunks(const char* ptr,
+                                                       int size,
+                                                       ReadArray read_array) {
   int chunk_size = static_cast<int>(buffer_end_ - ptr);
   while (size > chunk_size) {
-    ptr = ReadPackedVarintArray(ptr, buffer_end_, add);
+    ptr = read_array(ptr, buffer_end_);
     if (ptr == nullptr) return nullptr;
     int overrun = static_cast<int>(ptr - buffer_end_);
     ABSL_DCHECK(overrun >= 0 && overrun <= kSlopBytes);
@@ -1263,7 +1379,7 @@ const char* EpsCopyInputStream::ReadPackedVarint(const char* ptr, Add add,
       std::memcpy(buf, buffer_end_, kSlopBytes);
       ABSL_CHECK_LE(size - chunk_size, kSlopBytes);
       auto end = buf + (size - chunk_size);
-      auto res = ReadPackedVarintArray(buf + overrun, end, add);
+      auto res = read_array(buf + overrun, end);
       if (res == nullptr || res != end) return nullptr;
       return buffer_end_ + (res - buf);
     }
@@ -1277,10 +1393,34 @@ const char* EpsCopyInputStream::ReadPackedVarint(const char* ptr, Add add,
     chunk_size = static_cast<int>(buffer_end_ - ptr);
   }
   auto end = ptr + size;
-  ptr = ReadPackedVarintArray(ptr, end, add);
+  ptr = read_array(ptr, end);
   return end == ptr ? ptr : nullptr;
 }
 
+template <typename Add, typename SizeCb>
+const char* EpsCopyInputStream::ReadPackedVarint(const char* ptr, Add add,
+                                                 SizeCb size_callback) {
+  int size = ReadSize(&ptr);
+  size_callback(size);
+
+  GOOGLE_PROTOBUF_PARSER_ASSERT(ptr);
+  return ReadPackedVarintChunks(
+      ptr, size, [&add](const char* begin, const char* end) {
+        return ReadPackedVarintArray(begin, end, add);
+      });
+}
+
+template <typename T, bool zigzag>
+const char* EpsCopyInputStream::ReadPackedVarintInto(const char* ptr,
+                                                     RepeatedField<T>* out) {
+  int size = ReadSize(&ptr);
+  GOOGLE_PROTOBUF_PARSER_ASSERT(ptr);
+  return ReadPackedVarintChunks(
+      ptr, size, [out](const char* begin, const char* end) {
+        return ReadPackedVarintArrayInto<T, zigzag>(begin, end, out);
+      });
+}
+
 // Helper for verification of utf8
 PROTOBUF_EXPORT
 bool VerifyUTF8(absl::string_view s, const char* field_name);
@@ -1431,6 +1571,14 @@ PROTOBUF_NODISCARD PROTOBUF_EXPORT const char* PackedFloatParser(
 PROTOBUF_NODISCARD PROTOBUF_EXPORT const char* PackedDoubleParser(
     void* object, const char* ptr, ParseContext* ctx);
 
+// Skips the field whose `tag` was just read, and every field directly after it
+// with the same tag, without storing them anywhere.  Length-delimited fields
+// are jumped over whole, groups are walked without building anything, and the
+// end of a varint is found from the continuation bits of a whole 16 byte
+// block.  Returns the position of the first following tag that differs.
+PROTOBUF_NODISCARD PROTOBUF_EXPORT const char* SkipUnknownField(
+    uint32_t tag, const char* ptr, ParseContext* ctx);
+
 // This is the only recursive parser.
 PROTOBUF_NODISCARD PROTOBUF_EXPORT const char* UnknownGroupLiteParse(
     std::string* unknown, const char* ptr, ParseContext* ctx);
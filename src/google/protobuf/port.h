@@ -36,6 +36,7 @@
 #ifndef GOOGLE_PROTOBUF_PORT_H__
 #define GOOGLE_PROTOBUF_PORT_H__
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -46,6 +47,7 @@
 
 
 #include "absl/meta/type_traits.h"
+#include "absl/strings/internal/resize_uninitialized.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
 
@@ -67,6 +69,11 @@ struct SizedPtr {
   size_t n;
 };
 
+// A function that runs `task(arg)` exactly once, possibly later and on another
+// thread. Options that take one let the application decide where work runs,
+// e.g. on its thread pool; the library never starts threads itself.
+using Executor = void (*)(void (*task)(void*), void* arg);
+
 // Debug hook allowing setting up test scenarios for AllocateAtLeast usage.
 using AllocateAtLeastHookFn = SizedPtr (*)(size_t, void*);
 
@@ -215,6 +222,52 @@ enum { kCacheAlignment = alignof(max_align_t) };  // do the best we can
 // The maximum byte alignment we support.
 enum { kMaxMessageAlignment = 8 };
 
+// Hints that `addr` will soon be read (or written, for the *ForWrite variant)
+// and should be brought into the local cache. These never fault, so any
+// address is fine, and compile to nothing where the builtin is unavailable.
+inline PROTOBUF_ALWAYS_INLINE void PrefetchToLocalCache(const void* addr) {
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(addr, /*rw=*/0, /*locality=*/3);
+#else
+  (void)addr;
+#endif
+}
+
+inline PROTOBUF_ALWAYS_INLINE void PrefetchToLocalCacheForWrite(
+    const void* addr) {
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(addr, /*rw=*/1, /*locality=*/3);
+#else
+  (void)addr;
+#endif
+}
+
+// Resizes `s` to `new_size`, leaving any new characters uninitialized, for
+// callers that overwrite them right away. The absl helpers only skip the fill
+// on libc++. Where resize_and_overwrite is available we use it instead, so the
+// new bytes are not memset on other standard libraries either.
+inline void STLStringResizeUninitialized(std::string* s, size_t new_size) {
+#ifdef __cpp_lib_string_resize_and_overwrite
+  s->resize_and_overwrite(new_size, [](char*, size_t n) { return n; });
+#else
+  absl::strings_internal::STLStringResizeUninitialized(s, new_size);
+#endif
+}
+
+// Like STLStringResizeUninitialized(), but grows the capacity geometrically
+// like push_back(), for strings that are appended to repeatedly.
+inline void STLStringResizeUninitializedAmortized(std::string* s,
+                                                  size_t new_size) {
+#ifdef __cpp_lib_string_resize_and_overwrite
+  if (new_size > s->capacity()) {
+    s->reserve(std::max(new_size, 2 * s->capacity()));
+  }
+  s->resize_and_overwrite(new_size, [](char*, size_t n) { return n; });
+#else
+  absl::strings_internal::STLStringResizeUninitializedAmortized(s, new_size);
+#endif
+}
+
 // Returns true if debug string hardening is required
 inline constexpr bool DebugHardenStringValues() {
 #ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
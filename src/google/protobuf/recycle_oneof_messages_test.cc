@@ -0,0 +1,107 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Tests for messages generated with the recycle_oneof_messages option, whose
+// clear_<oneof>() keeps arena sub-messages for reuse.
+
+#include <gtest/gtest.h>
+#include "google/protobuf/arena.h"
+#include "google/protobuf/unittest_recycle_oneof_messages.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace {
+
+using ::protobuf_unittest::RecycleOneofChild;
+using ::protobuf_unittest::RecycleOneofMessage;
+
+TEST(RecycleOneofMessagesTest, ReusesAllocatedSubMessage) {
+  Arena arena;
+  auto* message = Arena::CreateMessage<RecycleOneofMessage>(&arena);
+  RecycleOneofChild* first = message->mutable_first();
+  first->set_a(1);
+  first->set_s("abc");
+
+  message->set_number(5);
+  RecycleOneofChild* reused = message->mutable_first();
+  EXPECT_EQ(reused, first);
+  EXPECT_FALSE(reused->has_a());
+  EXPECT_FALSE(reused->has_s());
+
+  // Each alternative keeps its own sub-message.
+  message->clear_kind();
+  RecycleOneofChild* second = message->mutable_second();
+  EXPECT_NE(second, first);
+  EXPECT_EQ(message->mutable_first(), first);
+}
+
+TEST(RecycleOneofMessagesTest, KeepsCallerOwnedSubMessage) {
+  Arena arena;
+  auto* message = Arena::CreateMessage<RecycleOneofMessage>(&arena);
+  RecycleOneofChild* allocated = message->mutable_first();
+
+  RecycleOneofChild owned;
+  owned.set_a(7);
+  message->unsafe_arena_set_allocated_first(&owned);
+  message->set_number(5);
+  EXPECT_EQ(owned.a(), 7);
+
+  // The caller still owns the sub-message, which is neither cleared nor handed
+  // out again; the one the message allocated is.
+  RecycleOneofChild* first = message->mutable_first();
+  EXPECT_EQ(first, allocated);
+  first->set_a(1);
+  EXPECT_EQ(owned.a(), 7);
+}
+
+TEST(RecycleOneofMessagesTest, KeepsReleasedSubMessage) {
+  Arena arena;
+  auto* message = Arena::CreateMessage<RecycleOneofMessage>(&arena);
+  RecycleOneofChild* first = message->mutable_first();
+  first->set_a(3);
+  EXPECT_EQ(message->unsafe_arena_release_first(), first);
+
+  // A released sub-message handed back stays the caller's.
+  message->unsafe_arena_set_allocated_first(first);
+  message->set_number(5);
+  EXPECT_NE(message->mutable_first(), first);
+  EXPECT_EQ(first->a(), 3);
+}
+
+TEST(RecycleOneofMessagesTest, KeepsNothingWithoutArena) {
+  RecycleOneofMessage message;
+  message.mutable_first()->set_a(1);
+  message.set_number(5);
+  EXPECT_FALSE(message.mutable_first()->has_a());
+}
+
+}  // namespace
+}  // namespace protobuf
+}  // namespace google
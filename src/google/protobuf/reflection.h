@@ -461,17 +461,35 @@ class RepeatedFieldRefIterator {
   RepeatedFieldRefIterator(const RepeatedFieldRefIterator& other)
       : data_(other.data_),
         accessor_(other.accessor_),
-        iterator_(accessor_->CopyIterator(data_, other.iterator_)) {}
+        iterator_(accessor_->CopyIterator(data_, other.iterator_)),
+        scratch_space_(CopyScratchSpace(other)) {}
   RepeatedFieldRefIterator& operator=(const RepeatedFieldRefIterator& other) {
     if (this != &other) {
       accessor_->DeleteIterator(data_, iterator_);
       data_ = other.data_;
       accessor_ = other.accessor_;
       iterator_ = accessor_->CopyIterator(data_, other.iterator_);
+      scratch_space_.reset(CopyScratchSpace(other));
     }
     return *this;
   }
 
+ private:
+  // Accessors that do not store values as AccessorValueType (such as the one
+  // for RepeatedStringBuffer) fill the scratch space when dereferenced, so a
+  // copy needs its own.  Message scratch space cannot be allocated here, and
+  // message accessors never use it.
+  static AccessorValueType* CopyScratchSpace(
+      const RepeatedFieldRefIterator& other) {
+    return other.scratch_space_ == nullptr
+               ? nullptr
+               : NewScratchSpace(std::is_base_of<Message, AccessorValueType>());
+  }
+  static AccessorValueType* NewScratchSpace(std::false_type) {
+    return new AccessorValueType;
+  }
+  static AccessorValueType* NewScratchSpace(std::true_type) { return nullptr; }
+
  protected:
   const void* data_;
   const RepeatedFieldAccessor* accessor_;
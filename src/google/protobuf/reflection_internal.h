@@ -32,9 +32,11 @@
 #define GOOGLE_PROTOBUF_REFLECTION_INTERNAL_H__
 
 #include "absl/strings/cord.h"
+#include "absl/strings/string_view.h"
 #include "google/protobuf/map_field.h"
 #include "google/protobuf/reflection.h"
 #include "google/protobuf/repeated_field.h"
+#include "google/protobuf/repeated_string_buffer.h"
 
 namespace google {
 namespace protobuf {
@@ -341,6 +343,73 @@ class RepeatedPtrFieldStringAccessor final
   }
 };
 
+// Implementation of RepeatedFieldAccessor for string fields stored in a
+// RepeatedStringBuffer.  Its elements are not std::string objects, so Get()
+// copies them into the scratch space.
+class RepeatedStringBufferAccessor final
+    : public RandomAccessRepeatedFieldAccessor {
+  typedef void Field;
+  typedef void Value;
+  using RepeatedFieldAccessor::Add;
+
+ public:
+  RepeatedStringBufferAccessor() {}
+  bool IsEmpty(const Field* data) const override {
+    return GetBuffer(data)->empty();
+  }
+  int Size(const Field* data) const override {
+    return GetBuffer(data)->size();
+  }
+  const Value* Get(const Field* data, int index,
+                   Value* scratch_space) const override {
+    absl::string_view value = GetBuffer(data)->Get(index);
+    auto* scratch = static_cast<std::string*>(scratch_space);
+    scratch->assign(value.data(), value.size());
+    return scratch;
+  }
+  void Clear(Field* data) const override { MutableBuffer(data)->Clear(); }
+  void Set(Field* data, int index, const Value* value) const override {
+    MutableBuffer(data)->Set(index, *static_cast<const std::string*>(value));
+  }
+  void Add(Field* data, const Value* value) const override {
+    MutableBuffer(data)->Add(*static_cast<const std::string*>(value));
+  }
+  void RemoveLast(Field* data) const override {
+    MutableBuffer(data)->RemoveLast();
+  }
+  void Reserve(Field* data, int size) const override {
+    RepeatedStringBuffer* buffer = MutableBuffer(data);
+    buffer->Reserve(size, buffer->bytes_size());
+  }
+  void SwapElements(Field* data, int index1, int index2) const override {
+    MutableBuffer(data)->SwapElements(index1, index2);
+  }
+  void Swap(Field* data, const internal::RepeatedFieldAccessor* other_mutator,
+            Field* other_data) const override {
+    if (this == other_mutator) {
+      MutableBuffer(data)->Swap(MutableBuffer(other_data));
+    } else {
+      RepeatedStringBuffer tmp;
+      tmp.Swap(MutableBuffer(data));
+      int other_size = other_mutator->Size(other_data);
+      for (int i = 0; i < other_size; ++i) {
+        Add<std::string>(data, other_mutator->Get<std::string>(other_data, i));
+      }
+      other_mutator->Clear(other_data);
+      for (absl::string_view value : tmp) {
+        other_mutator->Add<std::string>(other_data, std::string(value));
+      }
+    }
+  }
+
+ private:
+  static const RepeatedStringBuffer* GetBuffer(const Field* data) {
+    return reinterpret_cast<const RepeatedStringBuffer*>(data);
+  }
+  static RepeatedStringBuffer* MutableBuffer(Field* data) {
+    return reinterpret_cast<RepeatedStringBuffer*>(data);
+  }
+};
 
 class RepeatedPtrFieldMessageAccessor final
     : public RepeatedPtrFieldWrapper<Message> {
@@ -984,6 +984,15 @@ PROTOBUF_NOINLINE void RepeatedField<Element>::GrowNoAnnotate(int current_size,
     new_size = static_cast<int>(num_available);
     new_rep = static_cast<Rep*>(res.p);
   } else {
+    // If the array is the last allocation on the arena, just extend it.
+    if (total_size_ > 0 &&
+        arena->TryExtendArrayInPlace(
+            rep(),
+            kRepHeaderSize + sizeof(Element) * static_cast<size_t>(total_size_),
+            bytes)) {
+      total_size_ = new_size;
+      return;
+    }
     new_rep = reinterpret_cast<Rep*>(Arena::CreateArray<char>(arena, bytes));
   }
   new_rep->arena = arena;
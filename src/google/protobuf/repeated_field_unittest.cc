@@ -233,6 +233,26 @@ TEST(RepeatedField, NaturalGrowthOnArenasReuseBlocks) {
   EXPECT_THAT(arena.SpaceUsed(), AllOf(Ge(expected), Le(1.02 * expected)));
 }
 
+TEST(RepeatedField, GrowsInPlaceAtArenaTail) {
+  std::string buf(1 << 16, 0);
+  Arena arena(&buf[0], buf.size());
+  auto* field = Arena::CreateMessage<RepeatedField<int>>(&arena);
+  field->Add(0);
+  const int* data = field->data();
+
+  // Nothing else is allocated, so every growth extends the array in place.
+  for (int i = 1; i < 1000; ++i) field->Add(i);
+  EXPECT_EQ(field->data(), data);
+  EXPECT_GE(field->Capacity(), 1000);
+
+  // Once something else is allocated behind it, the array has to move.
+  Arena::CreateArray<char>(&arena, 8);
+  const int capacity = field->Capacity();
+  for (int i = 1000; i <= capacity; ++i) field->Add(i);
+  EXPECT_NE(field->data(), data);
+  for (int i = 0; i <= capacity; ++i) ASSERT_EQ(field->Get(i), i);
+}
+
 // Test swapping between various types of RepeatedFields.
 TEST(RepeatedField, SwapSmallSmall) {
   RepeatedField<int> field1;
@@ -1449,6 +1469,23 @@ TEST(RepeatedPtrField, NaturalGrowthOnArenasReuseBlocks) {
   EXPECT_THAT(arena.SpaceUsed(), AllOf(Ge(expected), Le(1.02 * expected)));
 }
 
+TEST(RepeatedPtrField, GrowsInPlaceAtArenaTail) {
+  std::string buf(1 << 16, 0);
+  Arena arena(&buf[0], buf.size());
+  std::vector<std::string*> strings;
+  for (int i = 0; i < 1000; ++i) {
+    strings.push_back(Arena::Create<std::string>(&arena, absl::StrCat(i)));
+  }
+
+  auto* field = Arena::CreateMessage<RepeatedPtrField<std::string>>(&arena);
+  field->UnsafeArenaAddAllocated(strings[0]);
+  field->UnsafeArenaAddAllocated(strings[1]);
+  const std::string* const* data = field->data();
+  for (int i = 2; i < 1000; ++i) field->UnsafeArenaAddAllocated(strings[i]);
+  EXPECT_EQ(field->data(), data);
+  for (int i = 0; i < 1000; ++i) ASSERT_EQ(field->Get(i), absl::StrCat(i));
+}
+
 TEST(RepeatedPtrField, AddAndAssignRanges) {
   RepeatedPtrField<std::string> field;
 
@@ -1887,6 +1924,47 @@ TEST(RepeatedPtrField, SmallOptimization) {
                std::less_equal<void*>{}(&*array->pointer_begin(), array + 1));
 }
 
+template <typename T>
+bool UsesInlineStorage(const RepeatedPtrField<T>& field) {
+  const void* begin = &*field.pointer_begin();
+  return std::less_equal<const void*>{}(&field, begin) &&
+         std::less<const void*>{}(begin, &field + 1);
+}
+
+TEST(RepeatedPtrField, SmallOptimizationAcrossParseMergeAndSwap) {
+  TestAllTypes source;
+  source.add_repeated_string("a string that does not fit in the object");
+  source.add_repeated_nested_message()->set_bb(1);
+  const std::string data = source.SerializeAsString();
+
+  for (Arena* arena : {static_cast<Arena*>(nullptr), new Arena}) {
+    auto* parsed = Arena::CreateMessage<TestAllTypes>(arena);
+    ASSERT_TRUE(parsed->ParseFromString(data));
+    EXPECT_TRUE(UsesInlineStorage(parsed->repeated_string()));
+    EXPECT_TRUE(UsesInlineStorage(parsed->repeated_nested_message()));
+
+    auto* merged = Arena::CreateMessage<TestAllTypes>(arena);
+    merged->MergeFrom(*parsed);
+    EXPECT_TRUE(UsesInlineStorage(merged->repeated_string()));
+    EXPECT_TRUE(UsesInlineStorage(merged->repeated_nested_message()));
+
+    // Swapping within and across arenas keeps the single element inline.
+    TestAllTypes heap;
+    merged->Swap(parsed);
+    heap.Swap(parsed);
+    EXPECT_TRUE(UsesInlineStorage(heap.repeated_string()));
+    EXPECT_TRUE(UsesInlineStorage(heap.repeated_nested_message()));
+    EXPECT_EQ(heap.repeated_string(0), source.repeated_string(0));
+    EXPECT_EQ(heap.repeated_nested_message(0).bb(), 1);
+
+    if (arena == nullptr) {
+      delete parsed;
+      delete merged;
+    }
+    delete arena;
+  }
+}
+
 TEST(RepeatedPtrField, CopyAssign) {
   RepeatedPtrField<std::string> source, destination;
   source.Add()->assign("4");
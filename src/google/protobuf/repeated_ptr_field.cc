@@ -71,6 +71,13 @@ void** RepeatedPtrFieldBase::InternalExtend(int extend_amount) {
   size_t bytes = kRepHeaderSize + ptr_size * new_size;
   Rep* new_rep;
   void* old_tagged_ptr = tagged_rep_or_elem_;
+  // If the array is the last allocation on the arena, just extend it.
+  if (arena != nullptr && !using_sso() &&
+      arena->TryExtendArrayInPlace(
+          rep(), total_size_ * ptr_size + kRepHeaderSize, bytes)) {
+    total_size_ = new_size;
+    return elements() + current_size_;
+  }
   if (arena == nullptr) {
     internal::SizedPtr res = internal::AllocateAtLeast(bytes);
     new_size = static_cast<int>((res.n - kRepHeaderSize) / ptr_size);
@@ -584,12 +584,13 @@ class PROTOBUF_EXPORT RepeatedPtrFieldBase {
       // Pass value_arena and my_arena to avoid duplicate virtual call (value)
       // or load (mine).
       Value<TypeHandler>* value, Arena* value_arena, Arena* my_arena) {
-    // Ensure that either the value is in the same arena, or if not, we do the
-    // appropriate thing: Own() it (if it's on heap and we're in an arena) or
-    // copy it to our arena/heap (otherwise).
+    // Ensure that either the value is in the same (or a fused) arena, or if
+    // not, we do the appropriate thing: Own() it (if it's on heap and we're in
+    // an arena) or copy it to our arena/heap (otherwise).
     if (my_arena != nullptr && value_arena == nullptr) {
       my_arena->Own(value);
-    } else if (my_arena != value_arena) {
+    } else if (my_arena != value_arena &&
+               !Arena::IsFused(my_arena, value_arena)) {
       auto* new_value = TypeHandler::NewFromPrototype(value, my_arena);
       TypeHandler::Merge(*value, new_value);
       TypeHandler::Delete(value, value_arena);
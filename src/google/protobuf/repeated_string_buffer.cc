@@ -0,0 +1,196 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/repeated_string_buffer.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+
+#include "absl/log/absl_check.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/arena.h"
+#include "google/protobuf/parse_context.h"
+#include "google/protobuf/repeated_ptr_field.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+
+constexpr size_t RepeatedStringBuffer::kMaxBytes;
+
+RepeatedStringBuffer::~RepeatedStringBuffer() {
+  if (arena_ == nullptr) {
+    ::operator delete[](bytes_);
+    ::operator delete[](ends_);
+  }
+}
+
+void RepeatedStringBuffer::GrowBytes(size_t min_capacity) {
+  ABSL_DCHECK_LE(min_capacity, kMaxBytes);
+  const size_t new_capacity = std::min(
+      std::max<size_t>({min_capacity, size_t{2} * bytes_capacity_, 16}),
+      kMaxBytes);
+  char* new_bytes = Arena::CreateArray<char>(arena_, new_capacity);
+  if (bytes_size_ != 0) memcpy(new_bytes, bytes_, bytes_size_);
+  if (arena_ == nullptr) ::operator delete[](bytes_);
+  bytes_ = new_bytes;
+  bytes_capacity_ = static_cast<uint32_t>(new_capacity);
+}
+
+void RepeatedStringBuffer::GrowEnds(int min_capacity) {
+  const int new_capacity = std::max({min_capacity, 2 * capacity_, 4});
+  uint32_t* new_ends = Arena::CreateArray<uint32_t>(arena_, new_capacity);
+  if (size_ != 0) memcpy(new_ends, ends_, size_ * sizeof(uint32_t));
+  if (arena_ == nullptr) ::operator delete[](ends_);
+  ends_ = new_ends;
+  capacity_ = new_capacity;
+}
+
+void RepeatedStringBuffer::Reserve(int new_size, size_t new_bytes_size) {
+  ABSL_CHECK_LE(new_bytes_size, kMaxBytes);
+  if (new_bytes_size > bytes_capacity_) GrowBytes(new_bytes_size);
+  if (new_size > capacity_) GrowEnds(new_size);
+}
+
+void RepeatedStringBuffer::Set(int index, absl::string_view value) {
+  ABSL_DCHECK_GE(index, 0);
+  ABSL_DCHECK_LT(index, size_);
+  // The bytes move underneath a value that points into them.
+  if (std::greater_equal<const char*>()(value.data(), bytes_) &&
+      std::less<const char*>()(value.data(), bytes_ + bytes_capacity_)) {
+    Set(index, std::string(value));
+    return;
+  }
+  const uint32_t begin = index == 0 ? 0 : ends_[index - 1];
+  const uint32_t old_end = ends_[index];
+  const size_t old_size = old_end - begin;
+  if (value.size() > old_size) {
+    ABSL_CHECK_LE(value.size() - old_size, kMaxBytes - bytes_size_);
+  }
+  const size_t tail = bytes_size_ - old_end;
+  const size_t new_bytes_size = bytes_size_ - old_size + value.size();
+  if (new_bytes_size > bytes_capacity_) GrowBytes(new_bytes_size);
+  if (tail != 0) {
+    memmove(bytes_ + begin + value.size(), bytes_ + old_end, tail);
+  }
+  if (!value.empty()) memcpy(bytes_ + begin, value.data(), value.size());
+  // Unsigned arithmetic wraps, which also moves the ends back when the new
+  // value is shorter.
+  const uint32_t delta =
+      static_cast<uint32_t>(value.size()) - static_cast<uint32_t>(old_size);
+  for (int i = index; i < size_; ++i) ends_[i] += delta;
+  bytes_size_ = static_cast<uint32_t>(new_bytes_size);
+}
+
+void RepeatedStringBuffer::SwapElements(int index1, int index2) {
+  if (index1 == index2) return;
+  std::string value1(Get(index1));
+  std::string value2(Get(index2));
+  Set(index1, value2);
+  Set(index2, value1);
+}
+
+void RepeatedStringBuffer::Swap(RepeatedStringBuffer* other) {
+  if (this == other) return;
+  if (arena_ == other->arena_) {
+    InternalSwap(other);
+    return;
+  }
+  RepeatedStringBuffer temp(other->arena_);
+  temp.MergeFrom(*this);
+  CopyFrom(*other);
+  other->InternalSwap(&temp);
+}
+
+void RepeatedStringBuffer::MergeFrom(const RepeatedStringBuffer& other) {
+  if (other.empty()) return;
+  ABSL_CHECK_LE(other.bytes_size_, kMaxBytes - bytes_size_);
+  // Read the sizes first: when `other` is `*this`, Reserve() moves both.
+  const int n = other.size_;
+  const uint32_t other_bytes_size = other.bytes_size_;
+  const uint32_t base = bytes_size_;
+  Reserve(size_ + n, bytes_size_ + other_bytes_size);
+  if (other_bytes_size != 0) {
+    memcpy(bytes_ + base, other.bytes_, other_bytes_size);
+  }
+  bytes_size_ += other_bytes_size;
+  for (int i = 0; i < n; ++i) ends_[size_ + i] = base + other.ends_[i];
+  size_ += n;
+}
+
+void RepeatedStringBuffer::MergeFrom(
+    const RepeatedPtrField<std::string>& other) {
+  size_t total = bytes_size_;
+  for (const std::string& s : other) {
+    ABSL_CHECK_LE(s.size(), kMaxBytes - total);
+    total += s.size();
+  }
+  Reserve(size_ + other.size(), total);
+  for (const std::string& s : other) Add(s);
+}
+
+void RepeatedStringBuffer::AppendTo(RepeatedPtrField<std::string>* out) const {
+  out->Reserve(out->size() + size());
+  for (absl::string_view s : *this) out->Add()->assign(s.data(), s.size());
+}
+
+const char* RepeatedStringBuffer::InternalParseElement(
+    const char* ptr, internal::ParseContext* ctx) {
+  const int size = internal::ReadSize(&ptr);
+  if (ptr == nullptr) return nullptr;
+  if (static_cast<size_t>(size) > kMaxBytes - bytes_size_) return nullptr;
+  if (size <= ctx->buffer_end_ + ctx->kSlopBytes - ptr) {
+    AppendBytes(ptr, size);
+    ptr += size;
+  } else {
+    // The payload spans buffers. Growing as the chunks arrive, rather than
+    // reserving `size` up front, keeps a bogus length from allocating memory
+    // the input does not back.
+    ptr = ctx->AppendSize(
+        ptr, size, [this](const char* p, int s) { AppendBytes(p, s); });
+    if (ptr == nullptr) {
+      bytes_size_ = size_ == 0 ? 0 : ends_[size_ - 1];
+      return nullptr;
+    }
+  }
+  EndElement();
+  return ptr;
+}
+
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
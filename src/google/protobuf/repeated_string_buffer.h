@@ -0,0 +1,301 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// RepeatedStringBuffer is a compact container for many short strings.
+//
+// RepeatedPtrField<std::string> keeps one separately allocated std::string
+// per element behind an array of pointers, so reading an element goes through
+// two indirections and costs at least sizeof(std::string) plus a pointer even
+// when the string itself is a few bytes.  RepeatedStringBuffer instead stores
+// all elements back to back in a single byte buffer and records where each
+// one ends, exposing them as absl::string_view.  Appending, parsing and
+// serializing are memcpy over that buffer.
+//
+// The C++ code generator stores `repeated string` and `repeated bytes` fields
+// listed in its repeated_string_buffer option in this container.
+//
+// Elements cannot be modified in place and views are invalidated by any
+// non-const call, like iterators into a std::vector.
+
+#ifndef GOOGLE_PROTOBUF_REPEATED_STRING_BUFFER_H__
+#define GOOGLE_PROTOBUF_REPEATED_STRING_BUFFER_H__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <utility>
+
+#include "absl/log/absl_check.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/arena.h"
+#include "google/protobuf/internal_visibility.h"
+#include "google/protobuf/repeated_ptr_field.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+class ParseContext;
+class TcParser;
+}  // namespace internal
+
+class PROTOBUF_EXPORT RepeatedStringBuffer final {
+ public:
+  class const_iterator;
+  using value_type = absl::string_view;
+  using size_type = int;
+
+  constexpr RepeatedStringBuffer() = default;
+  explicit RepeatedStringBuffer(Arena* arena) : arena_(arena) {}
+  RepeatedStringBuffer(const RepeatedStringBuffer& other)
+      : RepeatedStringBuffer() {
+    MergeFrom(other);
+  }
+
+  // Arena enabled constructors: for internal use only.
+  RepeatedStringBuffer(internal::InternalVisibility, Arena* arena)
+      : RepeatedStringBuffer(arena) {}
+  RepeatedStringBuffer(internal::InternalVisibility, Arena* arena,
+                       const RepeatedStringBuffer& from)
+      : RepeatedStringBuffer(arena) {
+    MergeFrom(from);
+  }
+
+  RepeatedStringBuffer& operator=(const RepeatedStringBuffer& other) {
+    if (this != &other) CopyFrom(other);
+    return *this;
+  }
+  RepeatedStringBuffer(RepeatedStringBuffer&& other) noexcept
+      : RepeatedStringBuffer() {
+    // A heap buffer cannot take over the memory of an arena one.
+    if (other.arena_ != nullptr) {
+      CopyFrom(other);
+    } else {
+      InternalSwap(&other);
+    }
+  }
+  RepeatedStringBuffer& operator=(RepeatedStringBuffer&& other) noexcept {
+    if (this != &other) {
+      if (arena_ != other.arena_) {
+        CopyFrom(other);
+      } else {
+        InternalSwap(&other);
+      }
+    }
+    return *this;
+  }
+
+  ~RepeatedStringBuffer();
+
+  bool empty() const { return size_ == 0; }
+  int size() const { return size_; }
+  // Total length of all elements.
+  size_t bytes_size() const { return bytes_size_; }
+
+  absl::string_view Get(int index) const {
+    ABSL_DCHECK_GE(index, 0);
+    ABSL_DCHECK_LT(index, size_);
+    const uint32_t begin = index == 0 ? 0 : ends_[index - 1];
+    return absl::string_view(bytes_ + begin, ends_[index] - begin);
+  }
+  absl::string_view operator[](int index) const { return Get(index); }
+
+  const_iterator begin() const;
+  const_iterator end() const;
+
+  void Add(absl::string_view value) {
+    ABSL_CHECK_LE(value.size(), kMaxBytes - bytes_size_);
+    AppendBytes(value.data(), value.size());
+    EndElement();
+  }
+  // Replaces element `index`.  This moves every later element, so it is
+  // linear in bytes_size().
+  void Set(int index, absl::string_view value);
+  void RemoveLast() {
+    ABSL_DCHECK(!empty());
+    --size_;
+    bytes_size_ = size_ == 0 ? 0 : ends_[size_ - 1];
+  }
+  // Keeps the allocated memory.
+  void Clear() {
+    bytes_size_ = 0;
+    size_ = 0;
+  }
+  // Reserves room for `new_size` elements totalling `new_bytes_size` bytes.
+  void Reserve(int new_size, size_t new_bytes_size);
+  // Linear in bytes_size(), like Set().
+  void SwapElements(int index1, int index2);
+
+  // Swaps the contents, copying them if the buffers are on different arenas.
+  void Swap(RepeatedStringBuffer* other);
+  // Swaps the contents of two buffers on the same arena.
+  void InternalSwap(RepeatedStringBuffer* other) {
+    ABSL_DCHECK(this == other || arena_ == other->arena_);
+    std::swap(bytes_, other->bytes_);
+    std::swap(ends_, other->ends_);
+    std::swap(bytes_size_, other->bytes_size_);
+    std::swap(bytes_capacity_, other->bytes_capacity_);
+    std::swap(size_, other->size_);
+    std::swap(capacity_, other->capacity_);
+  }
+
+  void MergeFrom(const RepeatedStringBuffer& other);
+  void MergeFrom(const RepeatedPtrField<std::string>& other);
+  void CopyFrom(const RepeatedStringBuffer& other) {
+    if (this == &other) return;
+    Clear();
+    MergeFrom(other);
+  }
+  // Appends every element to `out`.
+  void AppendTo(RepeatedPtrField<std::string>* out) const;
+
+  Arena* GetArena() const { return arena_; }
+
+  size_t SpaceUsedExcludingSelfLong() const {
+    return bytes_capacity_ + static_cast<size_t>(capacity_) * sizeof(uint32_t);
+  }
+
+  // Equal ends mean equal element sizes, so this compares both arrays as a
+  // whole.
+  friend bool operator==(const RepeatedStringBuffer& a,
+                         const RepeatedStringBuffer& b) {
+    return a.size_ == b.size_ &&
+           std::equal(a.ends_, a.ends_ + a.size_, b.ends_) &&
+           absl::string_view(a.bytes_, a.bytes_size_) ==
+               absl::string_view(b.bytes_, b.bytes_size_);
+  }
+  friend bool operator!=(const RepeatedStringBuffer& a,
+                         const RepeatedStringBuffer& b) {
+    return !(a == b);
+  }
+
+ private:
+  using InternalArenaConstructable_ = void;
+  using DestructorSkippable_ = void;
+
+  friend class Arena;
+  friend class internal::TcParser;
+
+  // Element offsets are 32 bits, which bounds the total size like the 2GB
+  // limit on serialized messages does.
+  static constexpr size_t kMaxBytes = std::numeric_limits<int32_t>::max();
+
+  // Appends to the bytes of the element being built.  The caller checks
+  // kMaxBytes.
+  void AppendBytes(const char* data, size_t size) {
+    if (size == 0) return;
+    if (PROTOBUF_PREDICT_FALSE(size > bytes_capacity_ - bytes_size_)) {
+      GrowBytes(bytes_size_ + size);
+    }
+    memcpy(bytes_ + bytes_size_, data, size);
+    bytes_size_ += static_cast<uint32_t>(size);
+  }
+  // Ends the element being built at the current end of the bytes.
+  void EndElement() {
+    if (PROTOBUF_PREDICT_FALSE(size_ == capacity_)) GrowEnds(size_ + 1);
+    ends_[size_++] = bytes_size_;
+  }
+  void GrowBytes(size_t min_capacity);
+  void GrowEnds(int min_capacity);
+
+  // Parses one length-delimited payload at `ptr`, the tag already consumed,
+  // and appends it.  Returns nullptr on error, leaving the buffer as it was.
+  const char* InternalParseElement(const char* ptr,
+                                   internal::ParseContext* ctx);
+
+  char* bytes_ = nullptr;
+  // ends_[i] is the offset one past the last byte of element i.
+  uint32_t* ends_ = nullptr;
+  uint32_t bytes_size_ = 0;
+  uint32_t bytes_capacity_ = 0;
+  int size_ = 0;
+  int capacity_ = 0;
+  Arena* arena_ = nullptr;
+};
+
+class RepeatedStringBuffer::const_iterator {
+ public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = absl::string_view;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const absl::string_view*;
+  using reference = absl::string_view;
+
+  const_iterator() = default;
+
+  absl::string_view operator*() const {
+    return absl::string_view(data_ + begin_, *end_ - begin_);
+  }
+  const_iterator& operator++() {
+    begin_ = *end_++;
+    return *this;
+  }
+  const_iterator operator++(int) {
+    const_iterator it = *this;
+    ++*this;
+    return it;
+  }
+  friend bool operator==(const const_iterator& a, const const_iterator& b) {
+    return a.end_ == b.end_;
+  }
+  friend bool operator!=(const const_iterator& a, const const_iterator& b) {
+    return a.end_ != b.end_;
+  }
+
+ private:
+  friend class RepeatedStringBuffer;
+  const_iterator(const char* data, const uint32_t* end, uint32_t begin)
+      : data_(data), end_(end), begin_(begin) {}
+
+  const char* data_ = nullptr;
+  const uint32_t* end_ = nullptr;
+  uint32_t begin_ = 0;
+};
+
+inline RepeatedStringBuffer::const_iterator RepeatedStringBuffer::begin()
+    const {
+  return const_iterator(bytes_, ends_, 0);
+}
+inline RepeatedStringBuffer::const_iterator RepeatedStringBuffer::end() const {
+  return const_iterator(bytes_, ends_ + size_, bytes_size_);
+}
+
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_REPEATED_STRING_BUFFER_H__
@@ -0,0 +1,283 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/repeated_string_buffer.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/arena.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/message.h"
+#include "google/protobuf/repeated_ptr_field.h"
+#include "google/protobuf/text_format.h"
+#include "google/protobuf/unittest_repeated_string_buffer.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace {
+
+using ::protobuf_unittest::RepeatedStringBufferMessage;
+using ::protobuf_unittest::RepeatedStringBufferPlain;
+using ::testing::ElementsAre;
+
+std::vector<std::string> Elements(const RepeatedStringBuffer& field) {
+  return std::vector<std::string>(field.begin(), field.end());
+}
+
+TEST(RepeatedStringBufferTest, AddAndGet) {
+  RepeatedStringBuffer field;
+  EXPECT_TRUE(field.empty());
+  EXPECT_THAT(Elements(field), ElementsAre());
+
+  field.Add("foo");
+  field.Add("");
+  field.Add(absl::string_view("b\0r", 3));
+  EXPECT_EQ(field.size(), 3);
+  EXPECT_EQ(field.bytes_size(), 6);
+  EXPECT_EQ(field.Get(0), "foo");
+  EXPECT_EQ(field[1], "");
+  EXPECT_EQ(field[2], absl::string_view("b\0r", 3));
+  EXPECT_THAT(Elements(field),
+              ElementsAre("foo", "", std::string("b\0r", 3)));
+
+  field.RemoveLast();
+  EXPECT_THAT(Elements(field), ElementsAre("foo", ""));
+  EXPECT_EQ(field.bytes_size(), 3);
+  field.Clear();
+  EXPECT_TRUE(field.empty());
+  EXPECT_EQ(field.bytes_size(), 0);
+}
+
+TEST(RepeatedStringBufferTest, SetAndSwapElements) {
+  RepeatedStringBuffer field;
+  field.Add("a");
+  field.Add("bb");
+  field.Add("ccc");
+
+  field.Set(1, "longer than before");
+  EXPECT_THAT(Elements(field), ElementsAre("a", "longer than before", "ccc"));
+  field.Set(1, "");
+  EXPECT_THAT(Elements(field), ElementsAre("a", "", "ccc"));
+  // The value aliases the buffer.
+  field.Set(1, field[2]);
+  EXPECT_THAT(Elements(field), ElementsAre("a", "ccc", "ccc"));
+  EXPECT_EQ(field.bytes_size(), 7);
+
+  field.SwapElements(0, 2);
+  EXPECT_THAT(Elements(field), ElementsAre("ccc", "ccc", "a"));
+}
+
+TEST(RepeatedStringBufferTest, MergeAndSwap) {
+  RepeatedStringBuffer a;
+  a.Add("x");
+  a.Add("yz");
+  a.MergeFrom(a);
+  EXPECT_THAT(Elements(a), ElementsAre("x", "yz", "x", "yz"));
+
+  RepeatedPtrField<std::string> strings;
+  strings.Add("long enough to not fit in any small string buffer");
+  strings.Add("");
+  RepeatedStringBuffer b;
+  b.MergeFrom(strings);
+  b.AppendTo(&strings);
+  EXPECT_THAT(strings, ElementsAre(strings[0], "", strings[0], ""));
+
+  a.Swap(&b);
+  EXPECT_EQ(a.size(), 2);
+  EXPECT_THAT(Elements(b), ElementsAre("x", "yz", "x", "yz"));
+  EXPECT_TRUE(a != b);
+
+  RepeatedStringBuffer c(std::move(b));
+  EXPECT_TRUE(b.empty());  // NOLINT: use after move is defined.
+  EXPECT_EQ(c.size(), 4);
+  RepeatedStringBuffer d = c;
+  EXPECT_TRUE(c == d);
+}
+
+TEST(RepeatedStringBufferTest, Arena) {
+  Arena arena;
+  RepeatedStringBuffer* on_arena =
+      Arena::CreateMessage<RepeatedStringBuffer>(&arena);
+  for (int i = 0; i < 100; ++i) on_arena->Add(absl::StrCat("element", i));
+  EXPECT_EQ(on_arena->GetArena(), &arena);
+
+  RepeatedStringBuffer heap;
+  heap.Add("heap");
+  heap.Swap(on_arena);
+  EXPECT_THAT(Elements(*on_arena), ElementsAre("heap"));
+  EXPECT_EQ(heap.size(), 100);
+  EXPECT_EQ(heap[99], "element99");
+
+  // Moving out of an arena copies.
+  RepeatedStringBuffer moved(std::move(*on_arena));
+  EXPECT_THAT(Elements(moved), ElementsAre("heap"));
+}
+
+void SetFields(RepeatedStringBufferMessage* message) {
+  message->set_id(7);
+  for (int i = 0; i < 1000; ++i) {
+    message->add_names(absl::StrCat("token", i));
+  }
+  message->add_names(std::string(300, 'x'));
+  message->add_blobs("");
+  message->add_blobs(std::string("\0\xff", 2));
+  message->add_blobs(std::string(70000, 'y'));
+  message->add_plain("plain");
+  message->mutable_child()->add_names("child");
+}
+
+TEST(RepeatedStringBufferMessageTest, Accessors) {
+  RepeatedStringBufferMessage message;
+  message.add_names("one");
+  message.add_names("two");
+  message.set_names(0, "uno");
+  EXPECT_EQ(message.names_size(), 2);
+  EXPECT_EQ(message.names(0), "uno");
+  EXPECT_THAT(Elements(message.names()), ElementsAre("uno", "two"));
+  message.mutable_names()->RemoveLast();
+  EXPECT_THAT(Elements(message.names()), ElementsAre("uno"));
+  message.clear_names();
+  EXPECT_EQ(message.names_size(), 0);
+}
+
+TEST(RepeatedStringBufferMessageTest, WireFormatMatchesRepeatedPtrField) {
+  RepeatedStringBufferMessage message;
+  SetFields(&message);
+  const std::string data = message.SerializeAsString();
+  EXPECT_EQ(data.size(), message.ByteSizeLong());
+
+  RepeatedStringBufferPlain plain;
+  ASSERT_TRUE(plain.ParseFromString(data));
+  EXPECT_EQ(plain.SerializeAsString(), data);
+  ASSERT_EQ(plain.names_size(), message.names_size());
+  EXPECT_EQ(plain.names(1000), message.names(1000));
+  EXPECT_EQ(plain.blobs(2), message.blobs(2));
+
+  // Small chunks split payloads across buffers.
+  for (int chunk_size : {1, 7, 64, 1 << 20}) {
+    SCOPED_TRACE(chunk_size);
+    io::ArrayInputStream input(data.data(), static_cast<int>(data.size()),
+                               chunk_size);
+    RepeatedStringBufferMessage parsed;
+    ASSERT_TRUE(parsed.ParseFromZeroCopyStream(&input));
+    EXPECT_EQ(parsed.names(), message.names());
+    EXPECT_EQ(parsed.blobs(), message.blobs());
+    EXPECT_EQ(parsed.SerializeAsString(), data);
+  }
+}
+
+TEST(RepeatedStringBufferMessageTest, RejectsInvalidUtf8) {
+  RepeatedStringBufferPlain plain;
+  plain.add_blobs("\xff");
+  std::string data = plain.SerializeAsString();
+  // Field 3 (bytes) becomes field 2 (string).
+  data[0] = 2 << 3 | 2;
+  RepeatedStringBufferMessage message;
+  EXPECT_FALSE(message.ParseFromString(data));
+}
+
+TEST(RepeatedStringBufferMessageTest, CopyAndArenas) {
+  RepeatedStringBufferMessage message;
+  SetFields(&message);
+
+  Arena arena;
+  auto* on_arena = Arena::CreateMessage<RepeatedStringBufferMessage>(&arena);
+  on_arena->CopyFrom(message);
+  EXPECT_EQ(on_arena->SerializeAsString(), message.SerializeAsString());
+
+  RepeatedStringBufferMessage copy(*on_arena);
+  EXPECT_EQ(copy.names(), message.names());
+  copy.Swap(on_arena);
+  EXPECT_EQ(on_arena->blobs(), message.blobs());
+
+  on_arena->MergeFrom(message);
+  EXPECT_EQ(on_arena->names_size(), 2 * message.names_size());
+  EXPECT_GT(message.SpaceUsedLong(), message.names().bytes_size());
+}
+
+TEST(RepeatedStringBufferMessageTest, Reflection) {
+  RepeatedStringBufferMessage message;
+  const Reflection* reflection = message.GetReflection();
+  const FieldDescriptor* names =
+      message.GetDescriptor()->FindFieldByName("names");
+
+  reflection->AddString(&message, names, "a");
+  reflection->AddString(&message, names, "bb");
+  reflection->AddString(&message, names, "ccc");
+  EXPECT_EQ(reflection->FieldSize(message, names), 3);
+  EXPECT_EQ(reflection->GetRepeatedString(message, names, 1), "bb");
+  std::string scratch;
+  EXPECT_EQ(reflection->GetRepeatedStringReference(message, names, 2, &scratch),
+            "ccc");
+
+  reflection->SetRepeatedString(&message, names, 0, "first");
+  reflection->SwapElements(&message, names, 1, 2);
+  reflection->RemoveLast(&message, names);
+  EXPECT_THAT(Elements(message.names()), ElementsAre("first", "ccc"));
+
+  RepeatedFieldRef<std::string> ref =
+      reflection->GetRepeatedFieldRef<std::string>(message, names);
+  EXPECT_THAT(std::vector<std::string>(ref.begin(), ref.end()),
+              ElementsAre("first", "ccc"));
+  MutableRepeatedFieldRef<std::string> mutable_ref =
+      reflection->GetMutableRepeatedFieldRef<std::string>(&message, names);
+  mutable_ref.Add("added");
+  mutable_ref.Set(0, "set");
+  EXPECT_THAT(Elements(message.names()), ElementsAre("set", "ccc", "added"));
+
+  reflection->ClearField(&message, names);
+  EXPECT_EQ(message.names_size(), 0);
+}
+
+TEST(RepeatedStringBufferMessageTest, TextFormat) {
+  RepeatedStringBufferMessage message;
+  message.add_names("a");
+  message.add_names("b");
+  message.add_blobs(std::string("\0", 1));
+
+  std::string text;
+  ASSERT_TRUE(TextFormat::PrintToString(message, &text));
+  EXPECT_EQ(text, "names: \"a\"\nnames: \"b\"\nblobs: \"\\000\"\n");
+  RepeatedStringBufferMessage parsed;
+  ASSERT_TRUE(TextFormat::ParseFromString(text, &parsed));
+  EXPECT_EQ(parsed.names(), message.names());
+  EXPECT_EQ(parsed.blobs(), message.blobs());
+}
+
+}  // namespace
+}  // namespace protobuf
+}  // namespace google
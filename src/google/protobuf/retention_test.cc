@@ -244,6 +244,80 @@ TEST(RetentionTest, StripSourceRetentionOptionsWithSourceCodeInfo) {
   EXPECT_EQ(stripped_file.source_code_info().location_size(), 63);
 }
 
+TEST(RetentionTest, DiscardSourceOnlyData) {
+  // A pool that discards source-only data strips source-retention options
+  // while building, including custom options defined in the pool itself.
+  std::string proto_file =
+      absl::Substitute(R"(
+      syntax = "proto2";
+
+      package google.protobuf.internal;
+
+      import "$0";
+
+      option (source_retention_option) = 123;
+      option (options) = {
+        i1: 123
+        i2: 456
+        c { s: "abc" }
+        rc { s: "abc" }
+      };
+
+      message Options {
+        optional int32 i1 = 1 [retention = RETENTION_SOURCE];
+        optional int32 i2 = 2;
+        message ChildMessage {
+          optional string s = 1 [retention = RETENTION_SOURCE];
+        }
+        optional ChildMessage c = 3;
+        repeated ChildMessage rc = 4;
+      }
+
+      message Extendee {
+        extensions 1 to max [declaration = {
+          number: 1,
+          full_name: ".my.ext",
+          type: ".my.Message",
+        }];
+      }
+
+      extend google.protobuf.FileOptions {
+        optional int32 source_retention_option = 50000 [retention = RETENTION_SOURCE];
+        optional Options options = 50001;
+      })",
+                       FileDescriptorSet::descriptor()->file()->name());
+  io::ArrayInputStream input_stream(proto_file.data(),
+                                    static_cast<int>(proto_file.size()));
+  io::ErrorCollector error_collector;
+  io::Tokenizer tokenizer(&input_stream, &error_collector);
+  compiler::Parser parser;
+  FileDescriptorProto file_descriptor;
+  ASSERT_TRUE(parser.Parse(&tokenizer, &file_descriptor));
+  file_descriptor.set_name("retention.proto");
+  ASSERT_GT(file_descriptor.source_code_info().location_size(), 0);
+
+  DescriptorPool pool;
+  pool.DiscardSourceOnlyData(true);
+  FileDescriptorProto descriptor_proto_descriptor;
+  FileDescriptorSet::descriptor()->file()->CopyTo(&descriptor_proto_descriptor);
+  pool.BuildFile(descriptor_proto_descriptor);
+  const FileDescriptor* file = pool.BuildFile(file_descriptor);
+  ASSERT_TRUE(file != nullptr);
+
+  FileDescriptorProto built;
+  file->CopySourceCodeInfoTo(&built);
+  EXPECT_FALSE(built.has_source_code_info());
+
+  // Stripping while building matches stripping the full file afterwards.
+  DescriptorPool full_pool;
+  full_pool.BuildFile(descriptor_proto_descriptor);
+  FileDescriptorProto expected = compiler::StripSourceRetentionOptions(
+      *full_pool.BuildFile(file_descriptor));
+  file->CopyTo(&built);
+  EXPECT_TRUE(util::MessageDifferencer::Equals(expected, built));
+  EXPECT_FALSE(built.message_type(1).extension_range(0).has_options());
+}
+
 TEST(RetentionTest, RemoveEmptyOptions) {
   // If an options message is completely empty after stripping, that message
   // should be removed.
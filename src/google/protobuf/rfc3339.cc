@@ -0,0 +1,227 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "google/protobuf/rfc3339.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/log/absl_check.h"
+#include "absl/strings/string_view.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+namespace {
+
+constexpr int32_t kNanosPerSecond = 1000000000;
+constexpr int32_t kNanosPerMillisecond = 1000000;
+constexpr int32_t kNanosPerMicrosecond = 1000;
+
+// Writes `value` as exactly `width` decimal digits, zero padded.
+inline char* WriteDigits(uint32_t value, int width, char* out) {
+  for (int i = width - 1; i >= 0; --i) {
+    out[i] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  }
+  return out + width;
+}
+
+// Writes ".fff", ".ffffff" or ".fffffffff" for a non-zero `nanos`, and nothing
+// for zero.
+inline char* WriteNanos(uint32_t nanos, char* out) {
+  if (nanos == 0) return out;
+  *out++ = '.';
+  if (nanos % kNanosPerMillisecond == 0) {
+    return WriteDigits(nanos / kNanosPerMillisecond, 3, out);
+  }
+  if (nanos % kNanosPerMicrosecond == 0) {
+    return WriteDigits(nanos / kNanosPerMicrosecond, 6, out);
+  }
+  return WriteDigits(nanos, 9, out);
+}
+
+// Reads exactly `width` decimal digits starting at `p`.
+inline bool ReadDigits(const char* p, int width, uint32_t* value) {
+  uint32_t result = 0;
+  for (int i = 0; i < width; ++i) {
+    uint32_t digit = static_cast<uint32_t>(p[i] - '0');
+    if (digit >= 10) return false;
+    result = result * 10 + digit;
+  }
+  *value = result;
+  return true;
+}
+
+inline uint32_t DaysInMonth(uint32_t year, uint32_t month) {
+  static constexpr uint8_t kDays[] = {31, 28, 31, 30, 31, 30,
+                                      31, 31, 30, 31, 30, 31};
+  if (month == 2 && year % 4 == 0 && (year % 100 != 0 || year % 400 == 0)) {
+    return 29;
+  }
+  return kDays[month - 1];
+}
+
+}  // namespace
+
+size_t FormatRfc3339Timestamp(int64_t seconds, int32_t nanos, char* buf) {
+  ABSL_DCHECK(seconds >= kRfc3339MinSeconds && seconds <= kRfc3339MaxSeconds);
+  ABSL_DCHECK(nanos >= 0 && nanos < kNanosPerSecond);
+
+  // Ensure seconds is positive.
+  seconds -= kRfc3339MinSeconds;
+
+  // Julian Day -> Y/M/D, Algorithm from:
+  // Fliegel, H. F., and Van Flandern, T. C., "A Machine Algorithm for
+  //   Processing Calendar Dates," Communications of the Association of
+  //   Computing Machines, vol. 11 (1968), p. 657.
+  int32_t L, N, I, J, K;
+  L = static_cast<int32_t>(seconds / 86400) - 719162 + 68569 + 2440588;
+  N = 4 * L / 146097;
+  L = L - (146097 * N + 3) / 4;
+  I = 4000 * (L + 1) / 1461001;
+  L = L - 1461 * I / 4 + 31;
+  J = 80 * L / 2447;
+  K = L - 2447 * J / 80;
+  L = J / 11;
+  J = J + 2 - 12 * L;
+  I = 100 * (N - 49) + I + L;
+
+  uint32_t day_seconds = static_cast<uint32_t>(seconds % 86400);
+
+  char* p = buf;
+  p = WriteDigits(static_cast<uint32_t>(I), 4, p);
+  *p++ = '-';
+  p = WriteDigits(static_cast<uint32_t>(J), 2, p);
+  *p++ = '-';
+  p = WriteDigits(static_cast<uint32_t>(K), 2, p);
+  *p++ = 'T';
+  p = WriteDigits(day_seconds / 3600, 2, p);
+  *p++ = ':';
+  p = WriteDigits(day_seconds / 60 % 60, 2, p);
+  *p++ = ':';
+  p = WriteDigits(day_seconds % 60, 2, p);
+  p = WriteNanos(static_cast<uint32_t>(nanos), p);
+  *p++ = 'Z';
+  return static_cast<size_t>(p - buf);
+}
+
+size_t FormatDuration(int64_t seconds, int32_t nanos, char* buf) {
+  // Negate in unsigned arithmetic so that the minimum int64 is well defined.
+  uint64_t abs_seconds = seconds < 0 ? 0 - static_cast<uint64_t>(seconds)
+                                     : static_cast<uint64_t>(seconds);
+  uint32_t abs_nanos = nanos < 0 ? 0 - static_cast<uint32_t>(nanos)
+                                 : static_cast<uint32_t>(nanos);
+  ABSL_DCHECK_LT(abs_nanos, static_cast<uint32_t>(kNanosPerSecond));
+
+  char* p = buf;
+  if (seconds < 0 || nanos < 0) *p++ = '-';
+
+  char digits[20];
+  int n = 0;
+  do {
+    digits[n++] = static_cast<char>('0' + abs_seconds % 10);
+    abs_seconds /= 10;
+  } while (abs_seconds != 0);
+  while (n > 0) *p++ = digits[--n];
+
+  p = WriteNanos(abs_nanos, p);
+  *p++ = 's';
+  return static_cast<size_t>(p - buf);
+}
+
+bool ParseRfc3339Timestamp(absl::string_view str, int64_t* seconds,
+                           int32_t* nanos) {
+  // YYYY-MM-DDThh:mm:ss followed by at least a "Z".
+  if (str.size() < 20) return false;
+  const char* p = str.data();
+  uint32_t year, month, day, hour, minute, second;
+  if (!ReadDigits(p, 4, &year) || p[4] != '-' ||
+      !ReadDigits(p + 5, 2, &month) || p[7] != '-' ||
+      !ReadDigits(p + 8, 2, &day) || p[10] != 'T' ||
+      !ReadDigits(p + 11, 2, &hour) || p[13] != ':' ||
+      !ReadDigits(p + 14, 2, &minute) || p[16] != ':' ||
+      !ReadDigits(p + 17, 2, &second)) {
+    return false;
+  }
+  if (year == 0 || month == 0 || month > 12 || day == 0 ||
+      day > DaysInMonth(year, month) || hour > 23 || minute > 59 ||
+      second > 59) {
+    return false;
+  }
+  str.remove_prefix(19);
+
+  uint32_t frac = 0;
+  if (str[0] == '.') {
+    // Scan one digit past the maximum so that overlong fractions are caught.
+    size_t end = 1;
+    while (end < str.size() && end <= 10 &&
+           static_cast<uint32_t>(str[end] - '0') < 10) {
+      ++end;
+    }
+    int digits = static_cast<int>(end - 1);
+    if (digits == 0 || digits > 9) return false;
+    ReadDigits(str.data() + 1, digits, &frac);
+    for (int i = digits; i < 9; ++i) frac *= 10;
+    str.remove_prefix(end);
+  }
+
+  int64_t offset = 0;
+  if (str.size() == 1 && str[0] == 'Z') {
+    // UTC.
+  } else if (str.size() == 6 && (str[0] == '+' || str[0] == '-') &&
+             str[3] == ':') {
+    uint32_t offset_hour, offset_minute;
+    if (!ReadDigits(str.data() + 1, 2, &offset_hour) ||
+        !ReadDigits(str.data() + 4, 2, &offset_minute) || offset_hour > 23 ||
+        offset_minute > 59) {
+      return false;
+    }
+    offset = (offset_hour * 60 + offset_minute) * 60;
+    if (str[0] == '-') offset = -offset;
+  } else {
+    return false;
+  }
+
+  *seconds = int64_t{DaysSinceEpoch(year, month, day)} * 86400 +
+             hour * 3600 + minute * 60 + second - offset;
+  *nanos = static_cast<int32_t>(frac);
+  return true;
+}
+
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
@@ -0,0 +1,104 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Fixed-format RFC 3339 timestamp and JSON duration encoding shared by
+// util::TimeUtil and the JSON parser and printer.  The routines write into a
+// caller-provided buffer and never allocate.
+
+#ifndef GOOGLE_PROTOBUF_RFC3339_H__
+#define GOOGLE_PROTOBUF_RFC3339_H__
+
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/strings/string_view.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+
+// Range of seconds representable as a four-digit-year timestamp, i.e.
+// 0001-01-01T00:00:00Z to 9999-12-31T23:59:59Z.
+constexpr int64_t kRfc3339MinSeconds = -62135596800;
+constexpr int64_t kRfc3339MaxSeconds = 253402300799;
+
+// Buffer sizes that are large enough for any output of the Format* functions
+// below, e.g. "9999-12-31T23:59:59.999999999Z".
+constexpr size_t kRfc3339TimestampBufferSize = 30;
+constexpr size_t kDurationBufferSize = 32;
+
+// Returns the number of days from 1970-01-01 to the given proleptic Gregorian
+// date.  Only meaningful for years in [1, 9999].
+inline int32_t DaysSinceEpoch(uint32_t year, uint32_t month, uint32_t day) {
+  uint32_t m_adj = month - 3;  // March-based month.
+  uint32_t carry = m_adj > month ? 1 : 0;
+
+  uint32_t year_base = 4800;  // Before min year, multiple of 400.
+  uint32_t y_adj = year + year_base - carry;
+
+  uint32_t month_days = ((m_adj + carry * 12) * 62719 + 769) / 2048;
+  uint32_t leap_days = y_adj / 4 - y_adj / 100 + y_adj / 400;
+  return static_cast<int32_t>(y_adj * 365 + leap_days + month_days +
+                              (day - 1) - 2472632);
+}
+
+// Writes `seconds`/`nanos` as "YYYY-MM-DDThh:mm:ss[.fff]Z" into `buf`, which
+// must hold at least kRfc3339TimestampBufferSize bytes.  The fraction is
+// omitted when `nanos` is zero and otherwise has 3, 6 or 9 digits, whichever
+// is the shortest exact form.  `seconds` must be within
+// [kRfc3339MinSeconds, kRfc3339MaxSeconds] and `nanos` within [0, 999999999].
+// Returns the number of bytes written; no terminating NUL is added.
+PROTOBUF_EXPORT size_t FormatRfc3339Timestamp(int64_t seconds, int32_t nanos,
+                                              char* buf);
+
+// Writes a duration as "[-]S[.fff]s", e.g. "-1.500s", into `buf`, which must
+// hold at least kDurationBufferSize bytes.  The duration is negative if either
+// `seconds` or `nanos` is; the magnitude of `nanos` must be below 10^9.
+// Returns the number of bytes written.
+PROTOBUF_EXPORT size_t FormatDuration(int64_t seconds, int32_t nanos,
+                                      char* buf);
+
+// Parses "YYYY-MM-DDThh:mm:ss[.f]Z" or "...[+-]hh:mm", with one to nine
+// fractional digits.  Calendar fields are range-checked (including the length
+// of the month), leap seconds and years outside [1, 9999] are rejected.  On
+// success stores the UTC time in `seconds`/`nanos` and returns true.
+PROTOBUF_EXPORT bool ParseRfc3339Timestamp(absl::string_view str,
+                                           int64_t* seconds, int32_t* nanos);
+
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_RFC3339_H__
@@ -0,0 +1,131 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "google/protobuf/rfc3339.h"
+
+#include <cstdint>
+#include <string>
+
+#include <gtest/gtest.h>
+#include "absl/strings/string_view.h"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+namespace {
+
+std::string Timestamp(int64_t seconds, int32_t nanos) {
+  char buf[kRfc3339TimestampBufferSize];
+  return std::string(buf, FormatRfc3339Timestamp(seconds, nanos, buf));
+}
+
+std::string Duration(int64_t seconds, int32_t nanos) {
+  char buf[kDurationBufferSize];
+  return std::string(buf, FormatDuration(seconds, nanos, buf));
+}
+
+TEST(Rfc3339Test, FormatTimestamp) {
+  EXPECT_EQ("1970-01-01T00:00:00Z", Timestamp(0, 0));
+  EXPECT_EQ("0001-01-01T00:00:00Z", Timestamp(kRfc3339MinSeconds, 0));
+  EXPECT_EQ("9999-12-31T23:59:59.999999999Z",
+            Timestamp(kRfc3339MaxSeconds, 999999999));
+  EXPECT_EQ("1969-12-31T23:59:59.100Z", Timestamp(-1, 100000000));
+  EXPECT_EQ("2000-02-29T12:34:56.000010Z", Timestamp(951827696, 10000));
+  EXPECT_EQ("2000-02-29T12:34:56.000000010Z", Timestamp(951827696, 10));
+}
+
+TEST(Rfc3339Test, FormatDuration) {
+  EXPECT_EQ("0s", Duration(0, 0));
+  EXPECT_EQ("-1.500s", Duration(-1, -500000000));
+  EXPECT_EQ("-0.000001s", Duration(0, -1000));
+  EXPECT_EQ("315576000000.000000001s", Duration(315576000000, 1));
+  EXPECT_EQ("-9223372036854775808s", Duration(INT64_MIN, 0));
+}
+
+TEST(Rfc3339Test, ParseTimestamp) {
+  int64_t seconds;
+  int32_t nanos;
+  ASSERT_TRUE(ParseRfc3339Timestamp("1970-01-01T00:00:00Z", &seconds, &nanos));
+  EXPECT_EQ(0, seconds);
+  EXPECT_EQ(0, nanos);
+  ASSERT_TRUE(ParseRfc3339Timestamp("0001-01-01T00:00:00Z", &seconds, &nanos));
+  EXPECT_EQ(kRfc3339MinSeconds, seconds);
+  ASSERT_TRUE(ParseRfc3339Timestamp("9999-12-31T23:59:59.999999999Z",
+                                    &seconds, &nanos));
+  EXPECT_EQ(kRfc3339MaxSeconds, seconds);
+  EXPECT_EQ(999999999, nanos);
+  ASSERT_TRUE(ParseRfc3339Timestamp("1972-01-01T01:00:00.5-01:30", &seconds,
+                                    &nanos));
+  EXPECT_EQ(63081000, seconds);
+  EXPECT_EQ(500000000, nanos);
+  ASSERT_TRUE(
+      ParseRfc3339Timestamp("2000-02-29T00:00:00+08:00", &seconds, &nanos));
+  EXPECT_EQ(951753600, seconds);
+}
+
+TEST(Rfc3339Test, ParseRejectsNonCanonical) {
+  int64_t seconds;
+  int32_t nanos;
+  for (absl::string_view bad : {
+           "2001-02-29T00:00:00Z",
+           "2000-13-01T00:00:00Z",
+           "0000-01-01T00:00:00Z",
+           "2000-01-01t00:00:00Z",
+           "2000-01-01T24:00:00Z",
+           "2000-01-01T00:00:60Z",
+           "2000-01-01T00:00:00z",
+           "2000-01-01T00:00:00",
+           "2000-01-01T00:00:00.Z",
+           "2000-01-01T00:00:00.1234567891Z",
+           "2000-01-01T00:00:00+0800",
+           "2000-1-01T00:00:00Z",
+       }) {
+    EXPECT_FALSE(ParseRfc3339Timestamp(bad, &seconds, &nanos)) << bad;
+  }
+}
+
+TEST(Rfc3339Test, RoundTrip) {
+  for (int64_t seconds = kRfc3339MinSeconds; seconds < kRfc3339MaxSeconds;
+       seconds += 86400 * 37 + 3607) {
+    std::string str = Timestamp(seconds, 123000000);
+    int64_t parsed_seconds;
+    int32_t parsed_nanos;
+    ASSERT_TRUE(ParseRfc3339Timestamp(str, &parsed_seconds, &parsed_nanos))
+        << str;
+    EXPECT_EQ(seconds, parsed_seconds) << str;
+    EXPECT_EQ(123000000, parsed_nanos) << str;
+  }
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
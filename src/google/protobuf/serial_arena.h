@@ -121,6 +121,8 @@ class PROTOBUF_EXPORT SerialArena {
     return space_allocated_.load(std::memory_order_relaxed);
   }
   uint64_t SpaceUsed() const;
+  // Returns the number of bytes taken by strings allocated from string blocks.
+  size_t StringBlockBytesUsed() const;
 
   bool HasSpace(size_t n) const {
     return n <= static_cast<size_t>(limit_ - ptr());
@@ -143,6 +145,13 @@ class PROTOBUF_EXPORT SerialArena {
     return ret;
   }
 
+  // Whether TryAllocateFromCachedBlock(size) would succeed.
+  bool HasCachedBlock(size_t size) const {
+    if (size < 16) return false;
+    const size_t index = absl::bit_width(size - 1) - 4;
+    return index < cached_block_length_ && cached_blocks_[index] != nullptr;
+  }
+
   // In kArray mode we look through cached blocks.
   // We do not do this by default because most non-array allocations will not
   // have the right size and will fail to find an appropriate cached block.
@@ -187,10 +196,54 @@ class PROTOBUF_EXPORT SerialArena {
   void* AllocateFromExisting(size_t n) {
     PROTOBUF_UNPOISON_MEMORY_REGION(ptr(), n);
     void* ret = ptr();
-    set_ptr(static_cast<char*>(ret) + n);
+    char* next = static_cast<char*>(ret) + n;
+    set_ptr(next);
+    MaybePrefetchForwards(next);
     return ret;
   }
 
+  // Grows the allocation [p, p + old_size) to `new_size` bytes without moving
+  // it, if it is the most recent allocation of the head block and the block
+  // has room for the extra bytes. Returns whether it did. Both sizes must be
+  // aligned to ArenaAlignDefault.
+  //
+  // A cached block that can hold `new_size` bytes is preferred over growing
+  // in place, so that returned arrays keep getting reused.
+  bool TryExtendInPlace(void* p, size_t old_size, size_t new_size) {
+    ABSL_DCHECK(internal::ArenaAlignDefault::IsAligned(old_size));
+    ABSL_DCHECK(internal::ArenaAlignDefault::IsAligned(new_size));
+    ABSL_DCHECK_GE(new_size, old_size);
+    if (static_cast<char*>(p) + old_size != ptr()) return false;
+    if (HasCachedBlock(new_size)) return false;
+    if (PROTOBUF_PREDICT_FALSE(!HasSpace(new_size - old_size))) return false;
+    AllocateFromExisting(new_size - old_size);
+    return true;
+  }
+
+  // Bytes of the head block we keep write-prefetched ahead of `ptr_`.
+  static constexpr ptrdiff_t kPrefetchForwardsDegree = 1024;
+
+  // Parsing allocates messages back to back and writes to them right away, so
+  // once `next` gets within kPrefetchForwardsDegree bytes of `prefetch_ptr_`
+  // we prefetch the following kPrefetchForwardsDegree bytes for write. This
+  // issues a burst of prefetches once per kPrefetchForwardsDegree bytes
+  // allocated rather than one per allocation.
+  PROTOBUF_ALWAYS_INLINE void MaybePrefetchForwards(const char* next) {
+    if (PROTOBUF_PREDICT_TRUE(prefetch_ptr_ - next > kPrefetchForwardsDegree)) {
+      return;
+    }
+    if (PROTOBUF_PREDICT_TRUE(prefetch_ptr_ < limit_)) {
+      const char* prefetch_ptr = std::max(next, prefetch_ptr_);
+      // Count in offsets so no pointer is formed past the end of the block.
+      const ptrdiff_t n =
+          std::min<ptrdiff_t>(limit_ - prefetch_ptr, kPrefetchForwardsDegree);
+      for (ptrdiff_t i = 0; i < n; i += kCacheAlignment) {
+        PrefetchToLocalCacheForWrite(prefetch_ptr + i);
+      }
+      prefetch_ptr_ = prefetch_ptr + n;
+    }
+  }
+
   // See comments on `cached_blocks_` member for details.
   void ReturnArrayMemory(void* p, size_t size) {
     // We only need to check for 32-bit platforms.
@@ -319,6 +372,14 @@ class PROTOBUF_EXPORT SerialArena {
   // Free SerialArena returning the memory passed in to New
   template <typename Deallocator>
   SizedPtr Free(Deallocator deallocator);
+  // Releases `b` and all the blocks after it except the last one, which it
+  // returns.
+  template <typename Deallocator>
+  static SizedPtr FreeBlocks(ArenaBlock* b, Deallocator deallocator);
+
+  // Runs the cleanup nodes of `b` and all the blocks after it. The cleanup
+  // nodes of `b` must have been synced to `b->cleanup_nodes`.
+  static void CleanupBlocks(ArenaBlock* b);
 
   static size_t FreeStringBlocks(StringBlock* string_block, size_t unused);
 
@@ -344,6 +405,10 @@ class PROTOBUF_EXPORT SerialArena {
   std::atomic<char*> ptr_{nullptr};
   // Limiting address up to which memory can be allocated from the head block.
   char* limit_ = nullptr;
+  // Address up to which the head block has been prefetched. Reset to the
+  // start of the free space whenever the head block changes, so it always
+  // points into the same block as `ptr_` when we allocate from it.
+  const char* prefetch_ptr_ = nullptr;
 
   // The active string block.
   std::atomic<StringBlock*> string_block_{nullptr};
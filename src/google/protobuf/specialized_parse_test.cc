@@ -0,0 +1,192 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Tests for messages generated with the specialized_parse option, whose
+// _InternalParse() parses fields in field number order inline before handing
+// over to the table-driven parser.
+
+#include <string>
+
+#include <gtest/gtest.h>
+#include "absl/strings/str_cat.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/unittest_specialized_parse.pb.h"
+#include "google/protobuf/util/message_differencer.h"
+
+namespace google {
+namespace protobuf {
+namespace {
+
+using ::protobuf_unittest::SpecializedParseMessage;
+
+// Sets the fields parsed inline.
+void SetInlineFields(SpecializedParseMessage* message) {
+  message->set_optional_int32(-1);
+  message->set_optional_int64(-2);
+  message->set_optional_uint32(3);
+  message->set_optional_uint64(uint64_t{1} << 63);
+  message->set_optional_sint32(-5);
+  message->set_optional_sint64(-6);
+  message->set_optional_fixed32(7);
+  message->set_optional_fixed64(8);
+  message->set_optional_sfixed32(-9);
+  message->set_optional_sfixed64(-10);
+  message->set_optional_float(11.5f);
+  message->set_optional_double(12.25);
+  message->set_optional_bool(true);
+  message->set_optional_string("fourteen");
+  message->set_optional_bytes(std::string("\0\xff", 2));
+  message->mutable_optional_child()->set_a(16);
+  message->mutable_optional_child()->set_s("child");
+  message->add_repeated_int32(17);
+  message->add_repeated_int32(-17);
+  message->add_repeated_string("a");
+  message->add_repeated_string(std::string(200, 'b'));
+  message->add_repeated_child()->set_a(19);
+  message->add_repeated_child()->set_s("nineteen");
+  message->add_packed_sint64(-20);
+  message->add_packed_sint64(20);
+}
+
+// Sets the fields left to the table-driven parser.
+void SetTableFields(SpecializedParseMessage* message) {
+  message->set_closed_enum(protobuf_unittest::SPECIALIZED_PARSE_ONE);
+  message->set_oneof_string("oneof");
+  (*message->mutable_map_int32_string())[24] = "map";
+  message->set_large_number(5000);
+}
+
+void ExpectEqual(const SpecializedParseMessage& expected,
+                 const SpecializedParseMessage& actual) {
+  EXPECT_TRUE(util::MessageDifferencer::Equals(expected, actual))
+      << "expected: " << expected.DebugString()
+      << "actual: " << actual.DebugString();
+}
+
+TEST(SpecializedParseTest, RoundTrip) {
+  SpecializedParseMessage message;
+  SetInlineFields(&message);
+  SetTableFields(&message);
+
+  SpecializedParseMessage parsed;
+  ASSERT_TRUE(parsed.ParseFromString(message.SerializeAsString()));
+  ExpectEqual(message, parsed);
+  EXPECT_EQ(message.SerializeAsString(), parsed.SerializeAsString());
+}
+
+TEST(SpecializedParseTest, EmptyAndDefaultValues) {
+  SpecializedParseMessage parsed;
+  ASSERT_TRUE(parsed.ParseFromString(""));
+  EXPECT_EQ(parsed.ByteSizeLong(), 0);
+
+  SpecializedParseMessage message;
+  message.set_optional_int32(0);
+  message.set_optional_string("");
+  message.mutable_optional_child();
+  ASSERT_TRUE(parsed.ParseFromString(message.SerializeAsString()));
+  ExpectEqual(message, parsed);
+  EXPECT_TRUE(parsed.has_optional_int32());
+  EXPECT_TRUE(parsed.has_optional_string());
+  EXPECT_TRUE(parsed.has_optional_child());
+}
+
+TEST(SpecializedParseTest, OutOfOrderFieldsFallBackToTable) {
+  SpecializedParseMessage late;
+  SetInlineFields(&late);
+  SpecializedParseMessage early;
+  early.set_optional_int32(100);
+  early.add_repeated_int32(101);
+  SetTableFields(&early);
+
+  // Table fields, then every inline field again: the first tag is out of
+  // order, so the whole message goes through the table.
+  SpecializedParseMessage expected = early;
+  expected.MergeFrom(late);
+  SpecializedParseMessage parsed;
+  ASSERT_TRUE(parsed.ParseFromString(
+      absl::StrCat(early.SerializeAsString(), late.SerializeAsString())));
+  ExpectEqual(expected, parsed);
+
+  // Reversed field order.
+  std::string reversed;
+  for (int number : {20, 18, 16, 14, 12, 3, 1}) {
+    SpecializedParseMessage single;
+    SetInlineFields(&single);
+    const Descriptor* descriptor = single.GetDescriptor();
+    for (int i = 0; i < descriptor->field_count(); ++i) {
+      if (descriptor->field(i)->number() != number) {
+        single.GetReflection()->ClearField(&single, descriptor->field(i));
+      }
+    }
+    absl::StrAppend(&reversed, single.SerializeAsString());
+  }
+  ASSERT_TRUE(parsed.ParseFromString(reversed));
+  EXPECT_EQ(parsed.packed_sint64_size(), 2);
+  EXPECT_EQ(parsed.repeated_string(1), std::string(200, 'b'));
+  EXPECT_EQ(parsed.optional_child().s(), "child");
+  EXPECT_EQ(parsed.optional_string(), "fourteen");
+  EXPECT_EQ(parsed.optional_double(), 12.25);
+  EXPECT_EQ(parsed.optional_uint32(), 3);
+  EXPECT_EQ(parsed.optional_int32(), -1);
+}
+
+TEST(SpecializedParseTest, MergesRepeatedAndUnknownFields) {
+  SpecializedParseMessage message;
+  SetInlineFields(&message);
+  // Field 25 is unknown to SpecializedParseMessage.
+  std::string data = message.SerializeAsString();
+  absl::StrAppend(&data, "\xca\x01", std::string(1, 2), "\x08\x01");
+
+  SpecializedParseMessage parsed;
+  ASSERT_TRUE(parsed.ParseFromString(absl::StrCat(data, data)));
+  EXPECT_EQ(parsed.repeated_int32_size(), 4);
+  EXPECT_EQ(parsed.repeated_child_size(), 4);
+  EXPECT_EQ(parsed.packed_sint64_size(), 4);
+  EXPECT_EQ(parsed.optional_child().a(), 16);
+  EXPECT_EQ(parsed.GetReflection()->GetUnknownFields(parsed).field_count(), 2);
+}
+
+TEST(SpecializedParseTest, RejectsMalformedInput) {
+  SpecializedParseMessage message;
+  SetInlineFields(&message);
+  const std::string data = message.SerializeAsString();
+  SpecializedParseMessage parsed;
+  for (size_t size : {data.size() - 1, size_t{2}, size_t{1}}) {
+    EXPECT_FALSE(parsed.ParseFromString(data.substr(0, size))) << size;
+  }
+  // A string whose length runs past the end of the input.
+  EXPECT_FALSE(parsed.ParseFromString("\x72\x05" "abc"));
+  // A sub-message whose content is truncated.
+  EXPECT_FALSE(parsed.ParseFromString("\x82\x01\x02\x08"));
+}
+
+}  // namespace
+}  // namespace protobuf
+}  // namespace google
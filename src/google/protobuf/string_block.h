@@ -55,7 +55,9 @@ namespace internal {
 // the `New` function, and must be freed using the `Delete` function.
 // StringBlocks are automatically sized from 256B to 8KB depending on the
 // `next` instance provided in the `New` function to keep the average maximum
-// unused space limited to 25%, or up to 4KB.
+// unused space limited to 25%, or up to 4KB. The first block of a chain may be
+// given a larger initial size when the number of strings is known or expected
+// up front, in which case blocks grow from that size instead.
 class alignas(std::string) StringBlock {
  public:
   StringBlock() = delete;
@@ -64,15 +66,22 @@ class alignas(std::string) StringBlock {
 
   // Returns the size of the next string block based on the size information
   // stored in `block`. `block` may be null in which case the size of the
-  // initial string block is returned.
-  static size_t NextSize(StringBlock* block);
+  // initial string block is returned, which is `initial_size` clamped to the
+  // [256B, 8KB] range.
+  static size_t NextSize(StringBlock* block,
+                         size_t initial_size = min_size());
+
+  // Returns an initial block size with room for `count` strings, suitable as
+  // the `initial_size` argument of `NextSize` and `New`.
+  static size_t SizeForStrings(size_t count);
 
   // Allocates a new StringBlock pointing to `next`, which can be null.
-  // The size of the returned block depends on the allocated size of `next`.
-  static StringBlock* New(StringBlock* next);
+  // The size of the returned block depends on the allocated size of `next`,
+  // or on `initial_size` if `next` is null.
+  static StringBlock* New(StringBlock* next, size_t initial_size = min_size());
 
   // Allocates a new string block `in place`. `n` must be the value returned
-  // from a previous call to `StringBlock::NextSize(next)`
+  // from a previous call to `StringBlock::NextSize(next, ...)`
   static StringBlock* Emplace(void* p, size_t n, StringBlock* next);
 
   // Deletes `block` if `block` is heap allocated. `block` must not be null.
@@ -120,6 +129,9 @@ class alignas(std::string) StringBlock {
   static constexpr uint32_t min_size() { return size_t{256}; }
   static constexpr uint32_t max_size() { return size_t{8192}; }
 
+  // Returns `size` clamped to [min_size(), max_size()].
+  static constexpr uint32_t ClampedSize(size_t size);
+
   // Returns `size` rounded down such that we can fit a perfect number
   // of std::string instances inside a StringBlock of that size.
   static constexpr uint32_t RoundedSize(uint32_t size);
@@ -137,24 +149,37 @@ constexpr uint32_t StringBlock::RoundedSize(uint32_t size) {
   return size - (size - sizeof(StringBlock)) % sizeof(std::string);
 }
 
-inline size_t StringBlock::NextSize(StringBlock* block) {
-  return block ? block->next_size() : min_size();
+constexpr uint32_t StringBlock::ClampedSize(size_t size) {
+  return size < min_size()   ? min_size()
+         : size > max_size() ? max_size()
+                             : static_cast<uint32_t>(size);
+}
+
+inline size_t StringBlock::NextSize(StringBlock* block, size_t initial_size) {
+  return block ? block->next_size() : ClampedSize(initial_size);
+}
+
+inline size_t StringBlock::SizeForStrings(size_t count) {
+  count = std::min<size_t>(count, max_size() / sizeof(std::string));
+  return ClampedSize(sizeof(StringBlock) + count * sizeof(std::string));
 }
 
 inline StringBlock* StringBlock::Emplace(void* p, size_t n, StringBlock* next) {
   const auto count = static_cast<uint32_t>(n);
-  ABSL_DCHECK_EQ(count, NextSize(next));
+  ABSL_DCHECK(next == nullptr || count == NextSize(next));
+  ABSL_DCHECK_EQ(count, ClampedSize(count));
+  // The first block is followed by a block of the same size, as for `New`.
   uint32_t doubled = count * 2;
-  uint32_t next_size = next ? std::min(doubled, max_size()) : min_size();
+  uint32_t next_size = next ? std::min(doubled, max_size()) : count;
   return new (p) StringBlock(next, false, RoundedSize(count), next_size);
 }
 
-inline StringBlock* StringBlock::New(StringBlock* next) {
+inline StringBlock* StringBlock::New(StringBlock* next, size_t initial_size) {
   // Compute required size, rounding down to a multiple of sizeof(std:string)
   // so that we can optimize the allocation path. I.e., we incur a (constant
   // size) MOD() operation cost here to avoid any MUL() later on.
-  uint32_t size = min_size();
-  uint32_t next_size = min_size();
+  uint32_t size = ClampedSize(initial_size);
+  uint32_t next_size = size;
   if (next) {
     size = next->next_size_;
     next_size = std::min(size * 2, max_size());
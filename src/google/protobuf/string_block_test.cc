@@ -169,6 +169,34 @@ TEST(StringBlockTest, EmplaceMultipleBlocks) {
   }
 }
 
+TEST(StringBlockTest, InitialSize) {
+  EXPECT_THAT(StringBlock::NextSize(nullptr, 0), Eq(256));
+  EXPECT_THAT(StringBlock::NextSize(nullptr, 1000), Eq(1000));
+  EXPECT_THAT(StringBlock::NextSize(nullptr, 100000), Eq(8192));
+  EXPECT_THAT(StringBlock::SizeForStrings(0), Eq(256));
+  EXPECT_THAT(StringBlock::SizeForStrings(100),
+              Eq(sizeof(StringBlock) + 100 * sizeof(std::string)));
+  EXPECT_THAT(StringBlock::SizeForStrings(size_t{1} << 40), Eq(8192));
+
+  // The first block takes the initial size, and blocks grow from there.
+  StringBlock* first = StringBlock::New(nullptr, 1024);
+  EXPECT_THAT(first->allocated_size(), Eq(AllocatedSizeFor(1024)));
+  EXPECT_THAT(StringBlock::NextSize(first), Eq(1024));
+  StringBlock* second = StringBlock::New(first, 1024);
+  EXPECT_THAT(second->allocated_size(), Eq(AllocatedSizeFor(1024)));
+  EXPECT_THAT(StringBlock::NextSize(second), Eq(2048));
+
+  size_t size = StringBlock::NextSize(nullptr, 1024);
+  auto buffer = std::make_unique<char[]>(size);
+  StringBlock* emplaced = StringBlock::Emplace(buffer.get(), size, nullptr);
+  EXPECT_THAT(emplaced->allocated_size(), Eq(AllocatedSizeFor(1024)));
+  EXPECT_THAT(StringBlock::NextSize(emplaced), Eq(1024));
+
+  EXPECT_THAT(StringBlock::Delete(emplaced), Eq(0));
+  EXPECT_THAT(StringBlock::Delete(second), Eq(AllocatedSizeFor(1024)));
+  EXPECT_THAT(StringBlock::Delete(first), Eq(AllocatedSizeFor(1024)));
+}
+
 }  // namespace
 }  // namespace internal
 }  // namespace protobuf
@@ -0,0 +1,83 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+
+// StringInterner is an immutable dictionary of string values that recur across
+// messages, such as host names or country codes.  An arena created with
+// `ArenaOptions::string_interner` set to a dictionary lets singular string
+// fields that are parsed into its messages refer to the dictionary's copy of
+// their value instead of allocating their own.
+
+#ifndef GOOGLE_PROTOBUF_STRING_INTERNER_H__
+#define GOOGLE_PROTOBUF_STRING_INTERNER_H__
+
+#include <cstddef>
+#include <string>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+
+class PROTOBUF_EXPORT StringInterner {
+ public:
+  // Builds a dictionary of `values`.  Duplicates are ignored.
+  explicit StringInterner(absl::Span<const absl::string_view> values);
+  StringInterner(const StringInterner&) = delete;
+  StringInterner& operator=(const StringInterner&) = delete;
+  ~StringInterner() = default;
+
+  // Returns the dictionary's copy of `value`, or nullptr if it has none.  The
+  // returned string is valid for the lifetime of the dictionary.  Thread-safe.
+  const std::string* Find(absl::string_view value) const {
+    if (value.size() > max_length_) return nullptr;
+    auto it = values_.find(value);
+    return it == values_.end() ? nullptr : &*it;
+  }
+
+  // Returns the number of distinct values in the dictionary.
+  size_t size() const { return values_.size(); }
+
+ private:
+  // Never modified after construction, so the addresses of its elements are
+  // stable.
+  absl::flat_hash_set<std::string> values_;
+  // Longer values cannot be in the dictionary and are not looked up.
+  size_t max_length_ = 0;
+};
+
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_STRING_INTERNER_H__
@@ -42,6 +42,7 @@
 #include <climits>
 #include <cmath>
 #include <limits>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -54,6 +55,8 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+#include "absl/synchronization/blocking_counter.h"
 #include "google/protobuf/any.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/descriptor.pb.h"
@@ -1084,7 +1087,7 @@ class TextFormat::Parser::ParserImpl {
   }
 
   // Returns true if the current token's text is equal to that specified.
-  bool LookingAt(const std::string& text) {
+  bool LookingAt(absl::string_view text) {
     return tokenizer_.current().text == text;
   }
 
@@ -1353,7 +1356,7 @@ class TextFormat::Parser::ParserImpl {
   // Consumes a token and confirms that it matches that specified in the
   // value parameter. Returns false if the token found does not match that
   // which was specified.
-  bool Consume(const std::string& value) {
+  bool Consume(absl::string_view value) {
     const std::string& current_value = tokenizer_.current().text;
 
     if (current_value != value) {
@@ -1369,7 +1372,7 @@ class TextFormat::Parser::ParserImpl {
 
   // Similar to `Consume`, but the following token may be tokenized as
   // TYPE_WHITESPACE.
-  bool ConsumeBeforeWhitespace(const std::string& value) {
+  bool ConsumeBeforeWhitespace(absl::string_view value) {
     // Report whitespace after this token, but only once.
     tokenizer_.set_report_whitespace(true);
     bool result = Consume(value);
@@ -1379,7 +1382,7 @@ class TextFormat::Parser::ParserImpl {
 
   // Attempts to consume the supplied value. Returns false if a the
   // token found does not match the value specified.
-  bool TryConsume(const std::string& value) {
+  bool TryConsume(absl::string_view value) {
     if (tokenizer_.current().text == value) {
       tokenizer_.Next();
       return true;
@@ -1390,7 +1393,7 @@ class TextFormat::Parser::ParserImpl {
 
   // Similar to `TryConsume`, but the following token may be tokenized as
   // TYPE_WHITESPACE.
-  bool TryConsumeBeforeWhitespace(const std::string& value) {
+  bool TryConsumeBeforeWhitespace(absl::string_view value) {
     // Report whitespace after this token, but only once.
     tokenizer_.set_report_whitespace(true);
     bool result = TryConsume(value);
@@ -1401,8 +1404,9 @@ class TextFormat::Parser::ParserImpl {
   bool TryConsumeWhitespace() {
     had_silent_marker_ = false;
     if (LookingAtType(io::Tokenizer::TYPE_WHITESPACE)) {
-      if (tokenizer_.current().text ==
-          absl::StrCat(" ", internal::kDebugStringSilentMarkerForDetection)) {
+      absl::string_view text = tokenizer_.current().text;
+      if (absl::ConsumePrefix(&text, " ") &&
+          text == internal::kDebugStringSilentMarkerForDetection) {
         had_silent_marker_ = true;
       }
       tokenizer_.Next();
@@ -1473,8 +1477,11 @@ class TextFormat::Printer::TextGenerator
         indent_level_(initial_indent_level),
         initial_indent_level_(initial_indent_level) {}
 
+  // If `elided_elements` is non-null, running out of space in `output` is
+  // not an error but the end of a bounded print: see Printer::PrintToBuffer.
   explicit TextGenerator(io::ZeroCopyOutputStream* output,
-                         bool insert_silent_marker, int initial_indent_level)
+                         bool insert_silent_marker, int initial_indent_level,
+                         size_t* elided_elements = nullptr)
       : output_(output),
         buffer_(nullptr),
         buffer_size_(0),
@@ -1482,7 +1489,8 @@ class TextFormat::Printer::TextGenerator
         failed_(false),
         insert_silent_marker_(insert_silent_marker),
         indent_level_(initial_indent_level),
-        initial_indent_level_(initial_indent_level) {}
+        initial_indent_level_(initial_indent_level),
+        elided_elements_(elided_elements) {}
 
   TextGenerator(const TextGenerator&) = delete;
   TextGenerator& operator=(const TextGenerator&) = delete;
@@ -1545,6 +1553,12 @@ class TextFormat::Printer::TextGenerator
   // error.)
   bool failed() const { return failed_; }
 
+  bool Exhausted() const override {
+    return elided_elements_ != nullptr && failed_;
+  }
+
+  size_t* elided_elements() override { return elided_elements_; }
+
   void PrintMaybeWithMarker(MarkerToken, absl::string_view text) override {
     Print(text.data(), text.size());
     if (ConsumeInsertSilentMarker()) {
@@ -1641,8 +1655,60 @@ class TextFormat::Printer::TextGenerator
 
   int indent_level_;
   int initial_indent_level_;
+  // Non-null if printing is bounded by the size of `output_`.
+  size_t* const elided_elements_ = nullptr;
 };
 
+namespace {
+
+// Prints `val` escaped the way absl::CEscape() (or absl::Utf8SafeCEscape(),
+// if `utf8_safe`) would, but hands unescaped runs straight to `generator`
+// instead of building the escaped copy first.
+void PrintEscapedString(absl::string_view val, bool utf8_safe,
+                        TextFormat::BaseTextGenerator* generator) {
+  char octal[4] = {'\\', 0, 0, 0};
+  size_t run_start = 0;
+  for (size_t i = 0; i < val.size(); ++i) {
+    const unsigned char c = static_cast<unsigned char>(val[i]);
+    absl::string_view escaped;
+    switch (c) {
+      case '\n':
+        escaped = "\\n";
+        break;
+      case '\r':
+        escaped = "\\r";
+        break;
+      case '\t':
+        escaped = "\\t";
+        break;
+      case '\"':
+        escaped = "\\\"";
+        break;
+      case '\'':
+        escaped = "\\'";
+        break;
+      case '\\':
+        escaped = "\\\\";
+        break;
+      default:
+        if (absl::ascii_isprint(c) || (utf8_safe && c >= 0x80)) continue;
+        octal[1] = '0' + (c >> 6);
+        octal[2] = '0' + ((c >> 3) & 7);
+        octal[3] = '0' + (c & 7);
+        escaped = absl::string_view(octal, sizeof(octal));
+        break;
+    }
+    if (i > run_start) generator->Print(val.data() + run_start, i - run_start);
+    generator->PrintString(escaped);
+    run_start = i + 1;
+  }
+  if (val.size() > run_start) {
+    generator->Print(val.data() + run_start, val.size() - run_start);
+  }
+}
+
+}  // namespace
+
 // ===========================================================================
 //  An internal field value printer that may insert a silent marker in
 //  DebugStrings.
@@ -1668,7 +1734,7 @@ class TextFormat::Printer::FastFieldValuePrinterUtf8Escaping
   void PrintString(const std::string& val,
                    TextFormat::BaseTextGenerator* generator) const override {
     generator->PrintLiteral("\"");
-    generator->PrintString(absl::Utf8SafeCEscape(val));
+    PrintEscapedString(val, /*utf8_safe=*/true, generator);
     generator->PrintLiteral("\"");
   }
   void PrintBytes(const std::string& val,
@@ -1938,27 +2004,31 @@ void TextFormat::FastFieldValuePrinter::PrintBool(
 }
 void TextFormat::FastFieldValuePrinter::PrintInt32(
     int32_t val, BaseTextGenerator* generator) const {
-  generator->PrintString(absl::StrCat(val));
+  generator->PrintString(absl::AlphaNum(val).Piece());
 }
 void TextFormat::FastFieldValuePrinter::PrintUInt32(
     uint32_t val, BaseTextGenerator* generator) const {
-  generator->PrintString(absl::StrCat(val));
+  generator->PrintString(absl::AlphaNum(val).Piece());
 }
 void TextFormat::FastFieldValuePrinter::PrintInt64(
     int64_t val, BaseTextGenerator* generator) const {
-  generator->PrintString(absl::StrCat(val));
+  generator->PrintString(absl::AlphaNum(val).Piece());
 }
 void TextFormat::FastFieldValuePrinter::PrintUInt64(
     uint64_t val, BaseTextGenerator* generator) const {
-  generator->PrintString(absl::StrCat(val));
+  generator->PrintString(absl::AlphaNum(val).Piece());
 }
 void TextFormat::FastFieldValuePrinter::PrintFloat(
     float val, BaseTextGenerator* generator) const {
-  generator->PrintString(!std::isnan(val) ? io::SimpleFtoa(val) : "nan");
+  char buffer[io::kFloatToBufferSize];
+  generator->PrintString(!std::isnan(val) ? io::FloatToBuffer(val, buffer)
+                                          : "nan");
 }
 void TextFormat::FastFieldValuePrinter::PrintDouble(
     double val, BaseTextGenerator* generator) const {
-  generator->PrintString(!std::isnan(val) ? io::SimpleDtoa(val) : "nan");
+  char buffer[io::kDoubleToBufferSize];
+  generator->PrintString(!std::isnan(val) ? io::DoubleToBuffer(val, buffer)
+                                          : "nan");
 }
 void TextFormat::FastFieldValuePrinter::PrintEnum(
     int32_t /*val*/, const std::string& name,
@@ -1969,7 +2039,7 @@ void TextFormat::FastFieldValuePrinter::PrintEnum(
 void TextFormat::FastFieldValuePrinter::PrintString(
     const std::string& val, BaseTextGenerator* generator) const {
   generator->PrintLiteral("\"");
-  generator->PrintString(absl::CEscape(val));
+  PrintEscapedString(val, /*utf8_safe=*/false, generator);
   generator->PrintLiteral("\"");
 }
 void TextFormat::FastFieldValuePrinter::PrintBytes(
@@ -2120,6 +2190,8 @@ TextFormat::Printer::Printer()
       print_message_fields_in_index_order_(false),
       expand_any_(false),
       truncate_string_field_longer_than_(0LL),
+      parallel_executor_(nullptr),
+      parallel_max_tasks_(0),
       finder_(nullptr) {
   SetUseUtf8StringEscaping(false);
 }
@@ -2195,6 +2267,38 @@ bool TextFormat::Printer::PrintToString(const Message& message,
                internal::FieldReporterLevel::kMemberPrintToString);
 }
 
+bool TextFormat::Printer::PrintToBuffer(const Message& message, char* buffer,
+                                        size_t size, size_t* length) const {
+  ABSL_DCHECK(length) << "length specified is nullptr";
+
+  io::ArrayOutputStream output_stream(
+      buffer, static_cast<int>(std::min<size_t>(
+                  size, std::numeric_limits<int>::max())));
+  size_t elided_elements = 0;
+  bool truncated;
+  {
+    TextGenerator generator(&output_stream, insert_silent_marker_,
+                            initial_indent_level_, &elided_elements);
+    Print(message, &generator);
+    truncated = generator.failed();
+  }
+  *length = static_cast<size_t>(output_stream.ByteCount());
+  if (!truncated) return true;
+
+  // The buffer is full: overwrite its end with the note.
+  char note[64];
+  int note_size =
+      elided_elements == 0
+          ? snprintf(note, sizeof(note), "...")
+          : snprintf(note, sizeof(note), "...(%zu more elements)",
+                     elided_elements);
+  size_t copied = std::min(static_cast<size_t>(note_size), *length);
+  // An empty buffer may be null, which memcpy() does not accept even with a
+  // zero size.
+  if (copied > 0) memcpy(buffer + *length - copied, note, copied);
+  return false;
+}
+
 bool TextFormat::Printer::PrintUnknownFieldsToString(
     const UnknownFieldSet& unknown_fields, std::string* output) const {
   ABSL_DCHECK(output) << "output specified is nullptr";
@@ -2237,6 +2341,13 @@ bool TextFormat::Printer::PrintUnknownFields(
 }
 
 namespace {
+// Every parallel print task handles at least this many elements; below that
+// the hand-off costs more than it saves.
+constexpr int kMinParallelPrintElements = 1024;
+
+// Set while a PrintRangeTask runs on this thread.
+thread_local bool in_parallel_print_task = false;
+
 // Comparison functor for sorting FieldDescriptors by field index.
 // Normal fields have higher precedence than extensions.
 struct FieldIndexSorter {
@@ -2287,7 +2398,9 @@ bool TextFormat::Printer::PrintAny(const Message& message,
   DynamicMessageFactory factory;
   std::unique_ptr<Message> value_message(
       factory.GetPrototype(value_descriptor)->New());
-  std::string serialized_value = reflection->GetString(message, value_field);
+  std::string scratch;
+  const std::string& serialized_value =
+      reflection->GetStringReference(message, value_field, &scratch);
   if (!value_message->ParseFromString(serialized_value)) {
     ABSL_LOG(WARNING) << type_url << ": failed to parse contents";
     return false;
@@ -2350,10 +2463,20 @@ void TextFormat::Printer::PrintMessage(const Message& message,
   if (print_message_fields_in_index_order_) {
     std::sort(fields.begin(), fields.end(), FieldIndexSorter());
   }
-  for (const FieldDescriptor* field : fields) {
-    PrintField(message, reflection, field, generator);
+  for (size_t i = 0; i < fields.size(); ++i) {
+    if (generator->Exhausted()) {
+      // Out of space: count the repeated elements that are never reached.
+      for (; i < fields.size(); ++i) {
+        if (fields[i]->is_repeated()) {
+          *generator->elided_elements() +=
+              reflection->FieldSize(message, fields[i]);
+        }
+      }
+      return;
+    }
+    PrintField(message, reflection, fields[i], generator);
   }
-  if (!hide_unknown_fields_) {
+  if (!hide_unknown_fields_ && !generator->Exhausted()) {
     PrintUnknownFields(reflection->GetUnknownFields(message), generator,
                        kUnknownFieldRecursionLimit);
   }
@@ -2425,21 +2548,30 @@ class MapFieldPrinterHelper {
  public:
   // DynamicMapSorter::Sort cannot be used because it enforces syncing with
   // repeated field.
+  // If the field's repeated entries are up to date, fills sorted_map_field
+  // with them and returns true.  Otherwise fills sorted_map_iterators with
+  // iterators over the map instead, so that no entry messages are built up
+  // front, and returns false.
   static bool SortMap(const Message& message, const Reflection* reflection,
                       const FieldDescriptor* field,
-                      std::vector<const Message*>* sorted_map_field);
+                      std::vector<const Message*>* sorted_map_field,
+                      std::vector<MapIterator>* sorted_map_iterators);
+  // Makes `entry` hold the key and value at `iter`.  Message values are not
+  // copied: `entry` borrows them until ReleaseEntry() is called, which must
+  // happen before `entry` is reused or destroyed.
+  static const Message& FillEntry(const MapIterator& iter, Message* entry);
+  static void ReleaseEntry(Message* entry);
   static void CopyKey(const MapKey& key, Message* message,
                       const FieldDescriptor* field_desc);
   static void CopyValue(const MapValueRef& value, Message* message,
                         const FieldDescriptor* field_desc);
 };
 
-// Returns true if elements contained in sorted_map_field need to be released.
 bool MapFieldPrinterHelper::SortMap(
     const Message& message, const Reflection* reflection,
     const FieldDescriptor* field,
-    std::vector<const Message*>* sorted_map_field) {
-  bool need_release = false;
+    std::vector<const Message*>* sorted_map_field,
+    std::vector<MapIterator>* sorted_map_iterators) {
   const MapFieldBase& base = *reflection->GetMapData(message, field);
 
   if (base.IsRepeatedFieldValid()) {
@@ -2449,29 +2581,47 @@ bool MapFieldPrinterHelper::SortMap(
       sorted_map_field->push_back(
           const_cast<RepeatedPtrField<Message>*>(&map_field)->Mutable(i));
     }
+    MapEntryMessageComparator comparator(field->message_type());
+    std::stable_sort(sorted_map_field->begin(), sorted_map_field->end(),
+                     comparator);
+    return true;
+  }
+
+  Message* mutable_message = const_cast<Message*>(&message);
+  sorted_map_iterators->reserve(reflection->MapSize(message, field));
+  for (MapIterator iter = reflection->MapBegin(mutable_message, field),
+                   end = reflection->MapEnd(mutable_message, field);
+       iter != end; ++iter) {
+    sorted_map_iterators->push_back(iter);
+  }
+  // Map keys are unique, so there is no need for a stable sort.
+  std::sort(sorted_map_iterators->begin(), sorted_map_iterators->end(),
+            [](const MapIterator& a, const MapIterator& b) {
+              return a.GetKey() < b.GetKey();
+            });
+  return false;
+}
+
+const Message& MapFieldPrinterHelper::FillEntry(const MapIterator& iter,
+                                                Message* entry) {
+  const Descriptor* map_entry_desc = entry->GetDescriptor();
+  const FieldDescriptor* value_desc = map_entry_desc->field(1);
+  CopyKey(iter.GetKey(), entry, map_entry_desc->field(0));
+  if (value_desc->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+    entry->GetReflection()->UnsafeArenaSetAllocatedMessage(
+        entry, const_cast<Message*>(&iter.GetValueRef().GetMessageValue()),
+        value_desc);
   } else {
-    // TODO(teboring): For performance, instead of creating map entry message
-    // for each element, just store map keys and sort them.
-    const Descriptor* map_entry_desc = field->message_type();
-    const Message* prototype =
-        reflection->GetMessageFactory()->GetPrototype(map_entry_desc);
-    for (MapIterator iter =
-             reflection->MapBegin(const_cast<Message*>(&message), field);
-         iter != reflection->MapEnd(const_cast<Message*>(&message), field);
-         ++iter) {
-      Message* map_entry_message = prototype->New();
-      CopyKey(iter.GetKey(), map_entry_message, map_entry_desc->field(0));
-      CopyValue(iter.GetValueRef(), map_entry_message,
-                map_entry_desc->field(1));
-      sorted_map_field->push_back(map_entry_message);
-    }
-    need_release = true;
-  }
-
-  MapEntryMessageComparator comparator(field->message_type());
-  std::stable_sort(sorted_map_field->begin(), sorted_map_field->end(),
-                   comparator);
-  return need_release;
+    CopyValue(iter.GetValueRef(), entry, value_desc);
+  }
+  return *entry;
+}
+
+void MapFieldPrinterHelper::ReleaseEntry(Message* entry) {
+  const FieldDescriptor* value_desc = entry->GetDescriptor()->field(1);
+  if (value_desc->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+    entry->GetReflection()->UnsafeArenaReleaseMessage(entry, value_desc);
+  }
 }
 
 void MapFieldPrinterHelper::CopyKey(const MapKey& key, Message* message,
@@ -2567,15 +2717,37 @@ void TextFormat::Printer::PrintField(const Message& message,
     count = 1;
   }
 
+  if (parallel_executor_ != nullptr && parallel_max_tasks_ >= 2 &&
+      !in_parallel_print_task && !insert_silent_marker_ &&
+      count >= 2 * kMinParallelPrintElements && field->is_repeated() &&
+      !field->is_map() &&
+      field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE &&
+      !(redact_debug_string_ && internal::ShouldRedactField(field)) &&
+      generator->elided_elements() == nullptr) {
+    PrintRepeatedMessageParallel(message, reflection, field, count, generator);
+    return;
+  }
+
   std::vector<const Message*> sorted_map_field;
-  bool need_release = false;
+  std::vector<MapIterator> sorted_map_iterators;
+  // When printing from the map itself, each entry is printed through this one
+  // reused entry message.
+  std::unique_ptr<Message> map_entry;
   bool is_map = field->is_map();
-  if (is_map) {
-    need_release = internal::MapFieldPrinterHelper::SortMap(
-        message, reflection, field, &sorted_map_field);
+  if (is_map &&
+      !internal::MapFieldPrinterHelper::SortMap(message, reflection, field,
+                                                &sorted_map_field,
+                                                &sorted_map_iterators)) {
+    map_entry.reset(reflection->GetMessageFactory()
+                        ->GetPrototype(field->message_type())
+                        ->New());
   }
 
   for (int j = 0; j < count; ++j) {
+    if (generator->Exhausted()) {
+      if (field->is_repeated()) *generator->elided_elements() += count - j;
+      break;
+    }
     const int field_index = field->is_repeated() ? j : -1;
 
     PrintFieldName(message, field_index, count, reflection, field, generator);
@@ -2585,22 +2757,21 @@ void TextFormat::Printer::PrintField(const Message& message,
                               /*insert_value_separator=*/true)) {
         break;
       }
-      const FastFieldValuePrinter* printer = GetFieldPrinter(field);
+      if (map_entry != nullptr) {
+        map_entry->Clear();
+        PrintMessageFieldValue(internal::MapFieldPrinterHelper::FillEntry(
+                                   sorted_map_iterators[j], map_entry.get()),
+                               field, field_index, count, generator);
+        internal::MapFieldPrinterHelper::ReleaseEntry(map_entry.get());
+        continue;
+      }
       const Message& sub_message =
           field->is_repeated()
               ? (is_map ? *sorted_map_field[j]
                         : reflection->GetRepeatedMessage(message, field, j))
               : reflection->GetMessage(message, field);
-      printer->PrintMessageStart(sub_message, field_index, count,
-                                 single_line_mode_, generator);
-      generator->Indent();
-      if (!printer->PrintMessageContent(sub_message, field_index, count,
-                                        single_line_mode_, generator)) {
-        Print(sub_message, generator);
-      }
-      generator->Outdent();
-      printer->PrintMessageEnd(sub_message, field_index, count,
-                               single_line_mode_, generator);
+      PrintMessageFieldValue(sub_message, field, field_index, count,
+                             generator);
     } else {
       generator->PrintMaybeWithMarker(MarkerToken(), ": ");
       // Write the field value.
@@ -2612,11 +2783,88 @@ void TextFormat::Printer::PrintField(const Message& message,
       }
     }
   }
+}
+
+void TextFormat::Printer::PrintMessageFieldValue(
+    const Message& sub_message, const FieldDescriptor* field, int field_index,
+    int field_count, BaseTextGenerator* generator) const {
+  const FastFieldValuePrinter* printer = GetFieldPrinter(field);
+  printer->PrintMessageStart(sub_message, field_index, field_count,
+                             single_line_mode_, generator);
+  generator->Indent();
+  if (!printer->PrintMessageContent(sub_message, field_index, field_count,
+                                    single_line_mode_, generator)) {
+    Print(sub_message, generator);
+  }
+  generator->Outdent();
+  printer->PrintMessageEnd(sub_message, field_index, field_count,
+                           single_line_mode_, generator);
+}
+
+struct TextFormat::Printer::PrintRangeTask {
+  const Printer* printer;
+  const Message* message;
+  const FieldDescriptor* field;
+  int begin;
+  int end;
+  int count;
+  std::string output;
+  absl::BlockingCounter* done;
+
+  // Prints elements [begin, end) with no indentation of their own; the
+  // receiving generator indents every line when `output` is written to it.
+  void PrintTo(BaseTextGenerator* generator) const {
+    const Reflection* reflection = message->GetReflection();
+    for (int i = begin; i < end; ++i) {
+      printer->PrintFieldName(*message, i, count, reflection, field,
+                              generator);
+      printer->PrintMessageFieldValue(
+          reflection->GetRepeatedMessage(*message, field, i), field, i, count,
+          generator);
+    }
+  }
 
-  if (need_release) {
-    for (const Message* message_to_delete : sorted_map_field) {
-      delete message_to_delete;
+  static void Run(void* arg) {
+    auto* task = static_cast<PrintRangeTask*>(arg);
+    {
+      // Large repeated fields nested in this range are printed serially, so
+      // that tasks never block waiting on other tasks.
+      const bool was_in_task = in_parallel_print_task;
+      in_parallel_print_task = true;
+      io::StringOutputStream stream(&task->output);
+      TextGenerator generator(&stream, /*initial_indent_level=*/0);
+      task->PrintTo(&generator);
+      in_parallel_print_task = was_in_task;
     }
+    task->done->DecrementCount();
+  }
+};
+
+void TextFormat::Printer::PrintRepeatedMessageParallel(
+    const Message& message, const Reflection* reflection,
+    const FieldDescriptor* field, int count,
+    BaseTextGenerator* generator) const {
+  const int num_tasks =
+      std::min(parallel_max_tasks_, count / kMinParallelPrintElements);
+  // The calling thread prints the first range straight into `generator`
+  // while the executor handles the rest.
+  std::vector<PrintRangeTask> tasks(num_tasks);
+  absl::BlockingCounter done(num_tasks - 1);
+  for (int i = 0; i < num_tasks; ++i) {
+    tasks[i] = {this,
+                &message,
+                field,
+                static_cast<int>(int64_t{count} * i / num_tasks),
+                static_cast<int>(int64_t{count} * (i + 1) / num_tasks),
+                count,
+                std::string(),
+                &done};
+    if (i > 0) parallel_executor_(&PrintRangeTask::Run, &tasks[i]);
+  }
+  tasks[0].PrintTo(generator);
+  done.Wait();
+  for (int i = 1; i < num_tasks; ++i) {
+    generator->Print(tasks[i].output.data(), tasks[i].output.size());
   }
 }
 
@@ -2629,6 +2877,10 @@ void TextFormat::Printer::PrintShortRepeatedField(
                  field, generator);
   generator->PrintMaybeWithMarker(MarkerToken(), ": ", "[");
   for (int i = 0; i < size; i++) {
+    if (generator->Exhausted()) {
+      *generator->elided_elements() += size - i;
+      return;
+    }
     if (i > 0) generator->PrintLiteral(", ");
     PrintFieldValue(message, reflection, field, i, generator);
   }
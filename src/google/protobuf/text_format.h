@@ -190,6 +190,15 @@ class PROTOBUF_EXPORT TextFormat {
       Print(text_tail.data(), text_tail.size());
     }
 
+   private:
+    // Only generators with a byte budget ever become exhausted.  The printer
+    // stops walking the message once this returns true.
+    virtual bool Exhausted() const { return false; }
+
+    // Non-null for generators with a byte budget: the number of repeated
+    // elements the printer skipped because the budget ran out.
+    virtual size_t* elided_elements() { return nullptr; }
+
     friend class Printer;
   };
 
@@ -331,6 +340,18 @@ class PROTOBUF_EXPORT TextFormat {
                             io::ZeroCopyOutputStream* output) const;
     // Like TextFormat::PrintToString
     bool PrintToString(const Message& message, std::string* output) const;
+    // Prints at most `size` bytes of the message into `buffer`, without
+    // allocating any output storage, and sets `*length` to the number of
+    // bytes written.  No terminating NUL is written.  Meant for logging on
+    // hot paths; keep the Printer around rather than building one per call.
+    //
+    // If the text does not fit, printing stops as soon as the buffer is full
+    // rather than walking the rest of the message, the end of the buffer is
+    // overwritten with a "...(N more elements)" note counting the repeated
+    // elements that were never reached, and false is returned.  Repeated
+    // fields are never printed in parallel by this method.
+    bool PrintToBuffer(const Message& message, char* buffer, size_t size,
+                       size_t* length) const;
     // Like TextFormat::PrintUnknownFieldsToString
     bool PrintUnknownFieldsToString(const UnknownFieldSet& unknown_fields,
                                     std::string* output) const;
@@ -424,6 +445,18 @@ class PROTOBUF_EXPORT TextFormat {
       truncate_string_field_longer_than_ = truncate_string_field_longer_than;
     }
 
+    // If `executor` is non-null and `max_tasks` is at least 2, repeated
+    // message fields with many elements are printed in up to `max_tasks`
+    // concurrent ranges, each into its own buffer, which are then written
+    // out in order.  The output is identical to printing on the calling
+    // thread, and Print() blocks until all tasks have run.  Registered
+    // FastFieldValuePrinters, MessagePrinters and the Finder must be safe to
+    // call concurrently.
+    void SetParallelExecutor(internal::Executor executor, int max_tasks) {
+      parallel_executor_ = executor;
+      parallel_max_tasks_ = max_tasks;
+    }
+
     // Sets whether sensitive fields found in the message will be reported or
     // not.
     void SetReportSensitiveFields(internal::FieldReporterLevel reporter) {
@@ -491,6 +524,10 @@ class PROTOBUF_EXPORT TextFormat {
     // strings (see text_format.cc for implementation).
     class FastFieldValuePrinterUtf8Escaping;
 
+    // Forward declaration of an internal task used to print a range of a
+    // repeated message field concurrently (see text_format.cc).
+    struct PrintRangeTask;
+
     // Internal Print method, used for writing to the OutputStream via
     // the TextGenerator class.
     void Print(const Message& message, BaseTextGenerator* generator) const;
@@ -500,6 +537,20 @@ class PROTOBUF_EXPORT TextFormat {
                     const FieldDescriptor* field,
                     BaseTextGenerator* generator) const;
 
+    // Print elements of a large repeated message field using
+    // parallel_executor_.
+    void PrintRepeatedMessageParallel(const Message& message,
+                                      const Reflection* reflection,
+                                      const FieldDescriptor* field, int count,
+                                      BaseTextGenerator* generator) const;
+
+    // Print the value of a message field, from the opening brace to the
+    // closing one.
+    void PrintMessageFieldValue(const Message& sub_message,
+                                const FieldDescriptor* field, int field_index,
+                                int field_count,
+                                BaseTextGenerator* generator) const;
+
     // Print a repeated primitive field in short form.
     void PrintShortRepeatedField(const Message& message,
                                  const Reflection* reflection,
@@ -554,6 +605,8 @@ class PROTOBUF_EXPORT TextFormat {
     bool print_message_fields_in_index_order_;
     bool expand_any_;
     int64_t truncate_string_field_longer_than_;
+    internal::Executor parallel_executor_;
+    int parallel_max_tasks_;
 
     std::unique_ptr<const FastFieldValuePrinter> default_field_value_printer_;
     absl::flat_hash_map<const FieldDescriptor*,
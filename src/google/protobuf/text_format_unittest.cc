@@ -41,6 +41,8 @@
 #include <limits>
 #include <memory>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "google/protobuf/testing/file.h"
 #include "google/protobuf/testing/file.h"
@@ -53,6 +55,7 @@
 #include "absl/log/scoped_mock_log.h"
 #include "absl/strings/cord.h"
 #include "absl/strings/escaping.h"
+#include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_replace.h"
@@ -348,6 +351,67 @@ TEST_F(TextFormatTest, ShortPrimitiveRepeateds) {
       text);
 }
 
+TEST_F(TextFormatTest, PrintToBuffer) {
+  proto_.set_optional_int32(123);
+  proto_.add_repeated_nested_message()->set_bb(2);
+
+  TextFormat::Printer printer;
+  printer.SetSingleLineMode(true);
+  std::string expected;
+  ASSERT_TRUE(printer.PrintToString(proto_, &expected));
+
+  char buffer[64];
+  size_t length;
+  EXPECT_TRUE(printer.PrintToBuffer(proto_, buffer, sizeof(buffer), &length));
+  EXPECT_EQ(expected, absl::string_view(buffer, length));
+
+  // Exactly enough room.
+  EXPECT_TRUE(
+      printer.PrintToBuffer(proto_, buffer, expected.size(), &length));
+  EXPECT_EQ(expected, absl::string_view(buffer, length));
+
+  EXPECT_FALSE(
+      printer.PrintToBuffer(proto_, buffer, expected.size() - 1, &length));
+  EXPECT_EQ(absl::StrCat(expected.substr(0, expected.size() - 4), "..."),
+            absl::string_view(buffer, length));
+
+  // No room at all, not even for the note.
+  EXPECT_FALSE(printer.PrintToBuffer(proto_, nullptr, 0, &length));
+  EXPECT_EQ(0u, length);
+}
+
+TEST_F(TextFormatTest, PrintToBufferCountsElidedElements) {
+  for (int i = 0; i < 100; ++i) proto_.add_repeated_int32(i);
+  proto_.add_repeated_nested_message()->set_bb(1);
+  proto_.add_repeated_nested_message()->set_bb(2);
+
+  TextFormat::Printer printer;
+  printer.SetSingleLineMode(true);
+  std::string full;
+  ASSERT_TRUE(printer.PrintToString(proto_, &full));
+
+  // "repeated_int32: N " is 18 bytes for N < 10, so the budget runs out in
+  // the middle of element 3: elements 4 to 99 and both messages are elided.
+  char buffer[64];
+  size_t length;
+  EXPECT_FALSE(printer.PrintToBuffer(proto_, buffer, sizeof(buffer), &length));
+  absl::string_view note = "...(98 more elements)";
+  EXPECT_EQ(absl::StrCat(full.substr(0, sizeof(buffer) - note.size()), note),
+            absl::string_view(buffer, length));
+
+  printer.SetUseShortRepeatedPrimitives(true);
+  EXPECT_FALSE(printer.PrintToBuffer(proto_, buffer, sizeof(buffer), &length));
+  EXPECT_EQ(sizeof(buffer), length);
+  // "repeated_int32: [" takes 17 bytes, then "N, " 3 bytes each.
+  EXPECT_TRUE(absl::EndsWith(absl::string_view(buffer, length),
+                             "...(87 more elements)"))
+      << absl::string_view(buffer, length);
+
+  // A budget too small for the note still only writes `size` bytes.
+  EXPECT_FALSE(printer.PrintToBuffer(proto_, buffer, 2, &length));
+  EXPECT_EQ("..", absl::string_view(buffer, length));
+}
+
 
 TEST_F(TextFormatTest, StringEscape) {
   // Set the string value to test.
@@ -397,6 +461,60 @@ TEST_F(TextFormatTest, Utf8DebugString) {
   EXPECT_EQ(correct_string, debug_string);
 }
 
+TEST_F(TextFormatTest, EscapesEveryByteLikeCEscape) {
+  std::string all_bytes;
+  for (int i = 0; i < 256; ++i) {
+    absl::StrAppend(&all_bytes, "ab", std::string(1, static_cast<char>(i)));
+  }
+  proto_.set_optional_string(all_bytes);
+
+  TextFormat::Printer printer;
+  printer.SetSingleLineMode(true);
+  std::string text;
+  ASSERT_TRUE(printer.PrintToString(proto_, &text));
+  EXPECT_EQ(absl::StrCat("optional_string: \"", absl::CEscape(all_bytes),
+                         "\" "),
+            text);
+
+  printer.SetUseUtf8StringEscaping(true);
+  ASSERT_TRUE(printer.PrintToString(proto_, &text));
+  EXPECT_EQ(absl::StrCat("optional_string: \"",
+                         absl::Utf8SafeCEscape(all_bytes), "\" "),
+            text);
+}
+
+std::vector<std::thread>* print_threads = nullptr;
+
+void ThreadExecutor(void (*task)(void*), void* arg) {
+  print_threads->emplace_back(task, arg);
+}
+
+TEST_F(TextFormatTest, ParallelPrintMatchesSerialPrint) {
+  unittest::NestedTestAllTypes message;
+  message.mutable_payload()->set_optional_int32(1);
+  for (int i = 0; i < 5000; ++i) {
+    message.mutable_payload()->add_repeated_nested_message()->set_bb(i);
+  }
+  message.mutable_payload()->add_repeated_string("after");
+
+  for (bool single_line : {false, true}) {
+    TextFormat::Printer printer;
+    printer.SetSingleLineMode(single_line);
+    std::string expected;
+    ASSERT_TRUE(printer.PrintToString(message, &expected));
+
+    std::vector<std::thread> threads;
+    print_threads = &threads;
+    printer.SetParallelExecutor(&ThreadExecutor, 4);
+    std::string text;
+    ASSERT_TRUE(printer.PrintToString(message, &text));
+    print_threads = nullptr;
+    EXPECT_EQ(threads.size(), 3);
+    for (auto& thread : threads) thread.join();
+    EXPECT_EQ(expected, text);
+  }
+}
+
 TEST_F(TextFormatTest, PrintUnknownFields) {
   // Test printing of unknown fields in a message.
 
@@ -0,0 +1,103 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// This header defines ThreadLocalCache, the per-thread storage behind the
+// caches of freed objects kept by arenas, ArenaPool, heap_free_list messages
+// and deterministic map serialization.
+
+#ifndef GOOGLE_PROTOBUF_THREAD_LOCAL_CACHE_H__
+#define GOOGLE_PROTOBUF_THREAD_LOCAL_CACHE_H__
+
+#include <type_traits>
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+
+// One `Cache` per thread. `Cache` is a zero-initialized aggregate with a
+// `static void Clear(Cache&)` that releases everything it holds.
+//
+// The storage is trivially destructible so that it can be accessed from other
+// thread-local destructors. A separate `thread_local` reaper, registered on
+// the first insertion, clears the cache on thread exit and disables it
+// afterwards: Get() then returns an empty cache and GetForInsert() nullptr.
+template <typename Cache>
+class ThreadLocalCache {
+  static_assert(std::is_trivially_destructible<Cache>::value, "");
+
+ public:
+  // This thread's cache, for lookups and removals.
+  static Cache& Get() { return GetSlot().cache; }
+
+  // This thread's cache, for insertions. Returns nullptr once the thread is
+  // exiting, in which case the caller releases what it meant to cache.
+  static Cache* GetForInsert() {
+    Slot& slot = GetSlot();
+    if (slot.disabled) return nullptr;
+    if (PROTOBUF_PREDICT_FALSE(!slot.registered)) {
+      slot.registered = true;
+      // Constructing the reaper registers its destructor for this thread.
+      static thread_local Reaper reaper;
+      (void)reaper;
+    }
+    return &slot.cache;
+  }
+
+ private:
+  struct Slot {
+    Cache cache;
+    bool registered;
+    bool disabled;
+  };
+
+  struct Reaper {
+    ~Reaper() {
+      Slot& slot = GetSlot();
+      slot.disabled = true;
+      Cache::Clear(slot.cache);
+    }
+  };
+
+  static Slot& GetSlot() {
+    static PROTOBUF_THREAD_LOCAL Slot slot;
+    return slot;
+  }
+};
+
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_THREAD_LOCAL_CACHE_H__
@@ -38,7 +38,9 @@
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
+#include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
 #include "google/protobuf/arena_align.h"
 #include "google/protobuf/arena_allocation_policy.h"
@@ -84,6 +86,11 @@ class PROTOBUF_EXPORT ThreadSafeArena {
 
   uint64_t Reset();
 
+  // Like Reset(), but keeps the largest block of the owning thread's
+  // SerialArena that is no bigger than `max_retained_bytes` and reuses it for
+  // subsequent allocations.
+  uint64_t ResetRetainingBlock(size_t max_retained_bytes);
+
   uint64_t SpaceAllocated() const;
   uint64_t SpaceUsed() const;
 
@@ -104,6 +111,14 @@ class PROTOBUF_EXPORT ThreadSafeArena {
     }
   }
 
+  // Grows the array at `p` in place if it is the last allocation of this
+  // thread's SerialArena; see SerialArena::TryExtendInPlace().
+  bool TryExtendArrayInPlace(void* p, size_t old_size, size_t new_size) {
+    SerialArena* arena;
+    return GetSerialArenaFast(&arena) &&
+           arena->TryExtendInPlace(p, old_size, new_size);
+  }
+
   // This function allocates n bytes if the common happy case is true and
   // returns true. Otherwise does nothing and returns false. This strange
   // semantics is necessary to allow callers to program functions that only
@@ -125,8 +140,33 @@ class PROTOBUF_EXPORT ThreadSafeArena {
 
   void* AllocateFromStringBlock();
 
+  // Returns the StringInterner from the arena's options, if any.
+  const StringInterner* string_interner() const {
+    const AllocationPolicy* policy = AllocPolicy();
+    return policy != nullptr ? policy->string_interner : nullptr;
+  }
+
+  // Attributes a message of type `type_name` created on this arena in the
+  // arenaz profile, if the arena is sampled.
+  void RecordMessageAllocation(absl::string_view type_name, size_t size) {
+    ThreadSafeArenaStats::RecordMessageStats(arena_stats_.MutableStats(),
+                                             type_name, size);
+  }
+
   std::vector<void*> PeekCleanupListForTesting();
 
+  // Joins the lifetimes of `a` and `b` and of the arenas they are already
+  // fused with; see Arena::Fuse(). Returns false if either arena has a
+  // user-owned initial block.
+  static bool Fuse(ThreadSafeArena* a, ThreadSafeArena* b);
+
+  // Returns true if `other` is this arena or is fused with it.
+  bool IsFusedWith(const ThreadSafeArena& other) const {
+    if (this == &other) return true;
+    uint64_t id = fuse_id_.load(std::memory_order_acquire);
+    return id != 0 && id == other.fuse_id_.load(std::memory_order_acquire);
+  }
+
  private:
   friend class ArenaBenchmark;
   friend class TcParser;
@@ -149,8 +189,9 @@ class PROTOBUF_EXPORT ThreadSafeArena {
   ArenaBlock* FirstBlock(void* buf, size_t size,
                          const AllocationPolicy& policy);
 
-  // Adds SerialArena to the chunked list. May create a new chunk.
-  void AddSerialArena(void* id, SerialArena* serial);
+  // Adds SerialArena to the chunked list. May create a new chunk, in which
+  // case it returns true.
+  bool AddSerialArena(void* id, SerialArena* serial);
 
   // Members are declared here to track sizeof(ThreadSafeArena) and hotness
   // centrally.
@@ -167,14 +208,26 @@ class PROTOBUF_EXPORT ThreadSafeArena {
   std::atomic<SerialArenaChunk*> head_{nullptr};
 
   void* first_owner_;
+  // Initial string block size for the first arena, learned from its string
+  // usage before the last Reset(). Zero if unknown.
+  uint32_t string_block_size_hint_ = 0;
   // Must be declared after alloc_policy_; otherwise, it may lose info on
   // user-provided initial block.
   SerialArena first_arena_;
 
+  // The fuse group this arena belongs to, or nullptr. Guarded by a global
+  // mutex in arena.cc. `fuse_id_` is the group's unique id (0 if unfused) and
+  // can be read without that mutex.
+  struct FuseGroup;
+  FuseGroup* fuse_group_ = nullptr;
+  std::atomic<uint64_t> fuse_id_{0};
+
   static_assert(std::is_trivially_destructible<SerialArena>{},
                 "SerialArena needs to be trivially destructible.");
 
   const AllocationPolicy* AllocPolicy() const { return alloc_policy_.get(); }
+  // Returns the size of the first string block of `serial`.
+  size_t StringBlockInitialSize(const SerialArena* serial) const;
   void InitializeWithPolicy(const AllocationPolicy& policy);
   void* AllocateAlignedWithCleanupFallback(size_t n, size_t align,
                                            void (*destructor)(void*));
@@ -190,6 +243,12 @@ class PROTOBUF_EXPORT ThreadSafeArena {
   }
 
   PROTOBUF_NDEBUG_INLINE bool GetSerialArenaFast(SerialArena** arena) {
+    // A single-threaded arena only has its first SerialArena; skip the
+    // thread-local lookup.
+    if (PROTOBUF_PREDICT_FALSE(alloc_policy_.is_single_threaded())) {
+      *arena = &first_arena_;
+      return true;
+    }
     // If this thread already owns a block in this arena then try to use that.
     // This fast path optimizes the case where multiple threads allocate from
     // the same arena.
@@ -215,9 +274,32 @@ class PROTOBUF_EXPORT ThreadSafeArena {
   template <typename Functor>
   void WalkConstSerialArenaChunk(Functor fn) const;
 
-  // Executes callback function over SerialArenaChunk.
+  // Executes callback function over SerialArenaChunk, starting at `chunk`.
   template <typename Functor>
-  void WalkSerialArenaChunk(Functor fn);
+  static void WalkSerialArenaChunk(SerialArenaChunk* chunk, Functor fn);
+
+  // Runs the cleanup list of every SerialArena in the chunked list.
+  static void CleanupSerialArenas(SerialArenaChunk* chunk);
+
+  // Releases all memory of every SerialArena in the chunked list, and the
+  // chunks themselves.
+  template <typename Deallocator>
+  static void FreeSerialArenas(SerialArenaChunk* chunk, Deallocator deallocator,
+                               size_t* space_allocated);
+
+  // Cleanup work handed to AllocationPolicy::cleanup_executor on destruction,
+  // or kept by the fuse group until its last arena is destroyed.
+  struct DeferredCleanup;
+  DeferredCleanup* NewDeferredCleanup();
+  static void RunDeferredCleanup(void* cleanup);
+  static void RunDeferredDestructors(DeferredCleanup* cleanup);
+  static void FreeDeferred(DeferredCleanup* cleanup);
+
+  // Removes this arena from its fuse group on destruction. Returns true if
+  // other arenas of the group are still alive, in which case this arena's
+  // contents were handed to the group. Otherwise fills `retired` with the
+  // contents of the group's already destroyed arenas.
+  bool LeaveFuseGroup(std::vector<DeferredCleanup*>* retired);
 
   // Executes callback function over SerialArena in chunked list in reverse
   // chronological order. Passes const SerialArena*.
@@ -226,8 +308,13 @@ class PROTOBUF_EXPORT ThreadSafeArena {
 
   // Releases all memory except the first block which it returns. The first
   // block might be owned by the user and thus need some extra checks before
-  // deleting.
-  SizedPtr Free(size_t* space_allocated);
+  // deleting. If `retained` is not null, that block of the first SerialArena
+  // is kept too, and its size is still accounted in `space_allocated`.
+  SizedPtr Free(size_t* space_allocated, const ArenaBlock* retained = nullptr);
+
+  // Returns the largest block of the first SerialArena, other than its first
+  // block, whose size is at most `max_bytes`; or nullptr if there is none.
+  ArenaBlock* FindRetainableBlock(size_t max_bytes);
 
 #ifdef _MSC_VER
 #pragma warning(disable : 4324)
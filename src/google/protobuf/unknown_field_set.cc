@@ -34,9 +34,11 @@
 
 #include "google/protobuf/unknown_field_set.h"
 
+#include <atomic>
+#include <string>
+
 #include "absl/log/absl_check.h"
 #include "absl/strings/cord.h"
-#include "absl/strings/internal/resize_uninitialized.h"
 #include "google/protobuf/extension_set.h"
 #include "google/protobuf/generated_message_tctable_decl.h"
 #include "google/protobuf/generated_message_tctable_impl.h"
@@ -62,46 +64,144 @@ const UnknownFieldSet& UnknownFieldSet::default_instance() {
 
 void UnknownFieldSet::ClearFallback() {
   ABSL_DCHECK(!fields_.empty());
-  int n = fields_.size();
-  do {
-    (fields_)[--n].Delete();
-  } while (n > 0);
+  // Strings and groups of an arena-allocated set are owned by the arena.
+  if (arena() == nullptr) {
+    int n = fields_.size();
+    do {
+      (fields_)[--n].Delete();
+    } while (n > 0);
+  }
   fields_.clear();
 }
 
+void UnknownFieldSet::SwapFallback(UnknownFieldSet* x) {
+  // The sets own their contents through different arenas, so the contents
+  // must be copied rather than exchanged.
+  UnknownFieldSet tmp;
+  tmp.MergeFromAndDestroy(this);
+  MergeFrom(*x);
+  x->Clear();
+  x->MergeFromAndDestroy(&tmp);
+}
+
+UnknownFieldSet* UnknownFieldSet::NewGroup(Arena* arena) {
+  if (arena == nullptr) return new UnknownFieldSet;
+  // All of the group's storage is also on the arena, so it never needs to be
+  // destroyed.
+  return ::new (arena->AllocateAligned(sizeof(UnknownFieldSet)))
+      UnknownFieldSet(arena);
+}
+
+std::string* UnknownFieldSet::mutable_raw() {
+  if (raw_ == nullptr) raw_ = Arena::Create<std::string>(arena());
+  ResetDecodedRaw();
+  return raw_;
+}
+
 void UnknownFieldSet::InternalMergeFrom(const UnknownFieldSet& other) {
-  int other_field_count = other.field_count();
+  int other_field_count = static_cast<int>(other.fields_.size());
   if (other_field_count > 0) {
     fields_.reserve(fields_.size() + other_field_count);
     for (int i = 0; i < other_field_count; i++) {
       fields_.push_back((other.fields_)[i]);
-      fields_.back().DeepCopy((other.fields_)[i]);
+      fields_.back().DeepCopy((other.fields_)[i], arena());
     }
   }
+  if (other.raw_ != nullptr && !other.raw_->empty()) {
+    mutable_raw()->assign(*other.raw_);
+  }
 }
 
 void UnknownFieldSet::MergeFrom(const UnknownFieldSet& other) {
-  int other_field_count = other.field_count();
+  // Raw bytes always follow the decoded fields, so other's raw bytes can be
+  // appended as-is unless other also has decoded fields, which must then come
+  // after everything this set holds.
+  int other_field_count = static_cast<int>(other.fields_.size());
   if (other_field_count > 0) {
+    MaybeDecodeRaw();
     fields_.reserve(fields_.size() + other_field_count);
     for (int i = 0; i < other_field_count; i++) {
       fields_.push_back((other.fields_)[i]);
-      fields_.back().DeepCopy((other.fields_)[i]);
+      fields_.back().DeepCopy((other.fields_)[i], arena());
     }
   }
+  if (other.raw_ != nullptr && !other.raw_->empty()) {
+    mutable_raw()->append(*other.raw_);
+  }
 }
 
 // A specialized MergeFrom for performance when we are merging from an UFS that
 // is temporary and can be destroyed in the process.
 void UnknownFieldSet::MergeFromAndDestroy(UnknownFieldSet* other) {
-  if (fields_.empty()) {
-    fields_ = std::move(other->fields_);
-  } else {
-    fields_.insert(fields_.end(),
-                   std::make_move_iterator(other->fields_.begin()),
-                   std::make_move_iterator(other->fields_.end()));
+  if (arena() != other->arena()) {
+    // Fields can only be moved between sets that share an owner.
+    MergeFrom(*other);
+    other->Clear();
+    return;
+  }
+  if (!other->fields_.empty()) {
+    MaybeDecodeRaw();
+    if (fields_.empty()) {
+      fields_ = std::move(other->fields_);
+    } else {
+      fields_.insert(fields_.end(),
+                     std::make_move_iterator(other->fields_.begin()),
+                     std::make_move_iterator(other->fields_.end()));
+    }
+    other->fields_.clear();
+  }
+  if (other->has_raw()) {
+    if (!has_raw()) {
+      ResetDecodedRaw();
+      std::swap(raw_, other->raw_);
+      decoded_raw_.store(other->decoded_raw_.load(std::memory_order_relaxed),
+                         std::memory_order_relaxed);
+      other->decoded_raw_.store(nullptr, std::memory_order_relaxed);
+    } else {
+      mutable_raw()->append(*other->raw_);
+    }
+    if (other->raw_ != nullptr) other->raw_->clear();
+    other->ResetDecodedRaw();
   }
-  other->fields_.clear();
+}
+
+void UnknownFieldSet::DecodeRaw() {
+  ABSL_DCHECK(has_raw());
+  // decoded_raw() shares this set's arena, so its fields can be moved.
+  UnknownFieldSet* decoded = decoded_raw();
+  fields_.insert(fields_.end(),
+                 std::make_move_iterator(decoded->fields_.begin()),
+                 std::make_move_iterator(decoded->fields_.end()));
+  decoded->fields_.clear();
+  raw_->clear();
+  ResetDecodedRaw();
+}
+
+UnknownFieldSet* UnknownFieldSet::DecodeRawOnce() const {
+  ABSL_DCHECK(has_raw());
+  UnknownFieldSet* decoded = NewGroup(arena());
+  io::CodedInputStream input(reinterpret_cast<const uint8_t*>(raw_->data()),
+                             static_cast<int>(raw_->size()));
+  // raw_ was validated when it was parsed, so this cannot fail.
+  bool ok = internal::WireFormat::SkipMessage(&input, decoded) &&
+            input.ConsumedEntireMessage();
+  ABSL_DCHECK(ok);
+  (void)ok;
+  UnknownFieldSet* expected = nullptr;
+  if (decoded_raw_.compare_exchange_strong(expected, decoded,
+                                           std::memory_order_acq_rel,
+                                           std::memory_order_acquire)) {
+    return decoded;
+  }
+  // Another reader published its copy first.  Ours is garbage on an arena.
+  if (arena() == nullptr) delete decoded;
+  return expected;
+}
+
+void UnknownFieldSet::ResetDecodedRawFallback() {
+  UnknownFieldSet* decoded = decoded_raw_.load(std::memory_order_relaxed);
+  decoded_raw_.store(nullptr, std::memory_order_relaxed);
+  if (arena() == nullptr) delete decoded;
 }
 
 void UnknownFieldSet::MergeToInternalMetadata(
@@ -110,9 +210,18 @@ void UnknownFieldSet::MergeToInternalMetadata(
 }
 
 size_t UnknownFieldSet::SpaceUsedExcludingSelfLong() const {
-  if (fields_.empty()) return 0;
+  size_t total_size = 0;
+  if (raw_ != nullptr) {
+    total_size +=
+        sizeof(*raw_) + internal::StringSpaceUsedExcludingSelfLong(*raw_);
+  }
+  if (const UnknownFieldSet* decoded =
+          decoded_raw_.load(std::memory_order_acquire)) {
+    total_size += decoded->SpaceUsedLong();
+  }
+  if (fields_.empty()) return total_size;
 
-  size_t total_size = sizeof(UnknownField) * fields_.capacity();
+  total_size += sizeof(UnknownField) * fields_.capacity();
 
   for (const UnknownField& field : fields_) {
     switch (field.type()) {
@@ -136,6 +245,7 @@ size_t UnknownFieldSet::SpaceUsedLong() const {
 }
 
 void UnknownFieldSet::AddVarint(int number, uint64_t value) {
+  MaybeDecodeRaw();
   fields_.emplace_back();
   auto& field = fields_.back();
   field.number_ = number;
@@ -144,6 +254,7 @@ void UnknownFieldSet::AddVarint(int number, uint64_t value) {
 }
 
 void UnknownFieldSet::AddFixed32(int number, uint32_t value) {
+  MaybeDecodeRaw();
   fields_.emplace_back();
   auto& field = fields_.back();
   field.number_ = number;
@@ -152,6 +263,7 @@ void UnknownFieldSet::AddFixed32(int number, uint32_t value) {
 }
 
 void UnknownFieldSet::AddFixed64(int number, uint64_t value) {
+  MaybeDecodeRaw();
   fields_.emplace_back();
   auto& field = fields_.back();
   field.number_ = number;
@@ -160,33 +272,40 @@ void UnknownFieldSet::AddFixed64(int number, uint64_t value) {
 }
 
 std::string* UnknownFieldSet::AddLengthDelimited(int number) {
+  MaybeDecodeRaw();
   fields_.emplace_back();
   auto& field = fields_.back();
   field.number_ = number;
   field.SetType(UnknownField::TYPE_LENGTH_DELIMITED);
-  field.data_.length_delimited_.string_value = new std::string;
+  field.data_.length_delimited_.string_value =
+      Arena::Create<std::string>(arena());
   return field.data_.length_delimited_.string_value;
 }
 
 
 UnknownFieldSet* UnknownFieldSet::AddGroup(int number) {
+  MaybeDecodeRaw();
   fields_.emplace_back();
   auto& field = fields_.back();
   field.number_ = number;
   field.SetType(UnknownField::TYPE_GROUP);
-  field.data_.group_ = new UnknownFieldSet;
+  field.data_.group_ = NewGroup(arena());
   return field.data_.group_;
 }
 
 void UnknownFieldSet::AddField(const UnknownField& field) {
+  MaybeDecodeRaw();
   fields_.push_back(field);
-  fields_.back().DeepCopy(field);
+  fields_.back().DeepCopy(field, arena());
 }
 
 void UnknownFieldSet::DeleteSubrange(int start, int num) {
+  MaybeDecodeRaw();
   // Delete the specified fields.
-  for (int i = 0; i < num; ++i) {
-    (fields_)[i + start].Delete();
+  if (arena() == nullptr) {
+    for (int i = 0; i < num; ++i) {
+      (fields_)[i + start].Delete();
+    }
   }
   // Slide down the remaining fields.
   for (size_t i = start + num; i < fields_.size(); ++i) {
@@ -199,11 +318,12 @@ void UnknownFieldSet::DeleteSubrange(int start, int num) {
 }
 
 void UnknownFieldSet::DeleteByNumber(int number) {
+  MaybeDecodeRaw();
   size_t left = 0;  // The number of fields left after deletion.
   for (size_t i = 0; i < fields_.size(); ++i) {
     UnknownField* field = &(fields_)[i];
     if (field->number() == number) {
-      field->Delete();
+      if (arena() == nullptr) field->Delete();
     } else {
       if (i != left) {
         (fields_)[left] = (fields_)[i];
@@ -215,7 +335,7 @@ void UnknownFieldSet::DeleteByNumber(int number) {
 }
 
 bool UnknownFieldSet::MergeFromCodedStream(io::CodedInputStream* input) {
-  UnknownFieldSet other;
+  UnknownFieldSet other(arena());
   if (internal::WireFormat::SkipMessage(input, &other) &&
       input->ConsumedEntireMessage()) {
     MergeFromAndDestroy(&other);
@@ -244,7 +364,7 @@ bool UnknownFieldSet::ParseFromArray(const void* data, int size) {
 bool UnknownFieldSet::SerializeToString(std::string* output) const {
   const size_t size =
       google::protobuf::internal::WireFormat::ComputeUnknownFieldsSize(*this);
-  absl::strings_internal::STLStringResizeUninitializedAmortized(output, size);
+  internal::STLStringResizeUninitializedAmortized(output, size);
   google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
       *this, reinterpret_cast<uint8_t*>(const_cast<char*>(output->data())));
   return true;
@@ -281,15 +401,15 @@ void UnknownField::Delete() {
   }
 }
 
-void UnknownField::DeepCopy(const UnknownField& other) {
+void UnknownField::DeepCopy(const UnknownField& other, Arena* arena) {
   (void)other;  // Parameter is used by Google-internal code.
   switch (type()) {
     case UnknownField::TYPE_LENGTH_DELIMITED:
-      data_.length_delimited_.string_value =
-          new std::string(*data_.length_delimited_.string_value);
+      data_.length_delimited_.string_value = Arena::Create<std::string>(
+          arena, *data_.length_delimited_.string_value);
       break;
     case UnknownField::TYPE_GROUP: {
-      UnknownFieldSet* group = new UnknownFieldSet();
+      UnknownFieldSet* group = UnknownFieldSet::NewGroup(arena);
       group->InternalMergeFrom(*data_.group_);
       data_.group_ = group;
       break;
@@ -311,11 +431,26 @@ uint8_t* UnknownField::InternalSerializeLengthDelimitedNoTag(
 
 namespace internal {
 
+namespace {
+std::atomic<bool> lazy_unknown_field_parsing{false};
+}  // namespace
+
+void SetLazyUnknownFieldParsing(bool enabled) {
+  lazy_unknown_field_parsing.store(enabled, std::memory_order_relaxed);
+}
+
 class UnknownFieldParserHelper {
  public:
   explicit UnknownFieldParserHelper(UnknownFieldSet* unknown)
       : unknown_(unknown) {}
 
+  // Appends the field to unknown->raw_ without decoding it.
+  static const char* ParseRaw(uint64_t tag, UnknownFieldSet* unknown,
+                              const char* ptr, ParseContext* ctx) {
+    return UnknownFieldParse(static_cast<uint32_t>(tag), unknown->mutable_raw(),
+                             ptr, ctx);
+  }
+
   void AddVarint(uint32_t num, uint64_t value) {
     unknown_->AddVarint(num, value);
   }
@@ -353,6 +488,9 @@ const char* UnknownGroupParse(UnknownFieldSet* unknown, const char* ptr,
 
 const char* UnknownFieldParse(uint64_t tag, UnknownFieldSet* unknown,
                               const char* ptr, ParseContext* ctx) {
+  if (lazy_unknown_field_parsing.load(std::memory_order_relaxed)) {
+    return UnknownFieldParserHelper::ParseRaw(tag, unknown, ptr, ctx);
+  }
   UnknownFieldParserHelper field_parser(unknown);
   return FieldParser(tag, field_parser, ptr, ctx);
 }
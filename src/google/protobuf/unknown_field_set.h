@@ -40,13 +40,17 @@
 
 #include <assert.h>
 
+#include <atomic>
+
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "google/protobuf/stubs/common.h"
 #include "absl/log/absl_check.h"
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/map.h"
 #include "google/protobuf/message_lite.h"
 #include "google/protobuf/parse_context.h"
 #include "google/protobuf/port.h"
@@ -65,10 +69,75 @@ class InternalMetadata;           // metadata_lite.h
 class WireFormat;                 // wire_format.h
 class MessageSetFieldSkipperUsingCord;
 // extension_set_heavy.cc
+class UnknownFieldParserHelper;   // unknown_field_set.cc
 }  // namespace internal
 
-class Message;       // message.h
-class UnknownField;  // below
+class Message;          // message.h
+class UnknownFieldSet;  // below
+
+// Represents one field in an UnknownFieldSet.
+class PROTOBUF_EXPORT UnknownField {
+ public:
+  enum Type {
+    TYPE_VARINT,
+    TYPE_FIXED32,
+    TYPE_FIXED64,
+    TYPE_LENGTH_DELIMITED,
+    TYPE_GROUP
+  };
+
+  // The field's field number, as seen on the wire.
+  inline int number() const;
+
+  // The field type.
+  inline Type type() const;
+
+  // Accessors -------------------------------------------------------
+  // Each method works only for UnknownFields of the corresponding type.
+
+  inline uint64_t varint() const;
+  inline uint32_t fixed32() const;
+  inline uint64_t fixed64() const;
+  inline const std::string& length_delimited() const;
+  inline const UnknownFieldSet& group() const;
+
+  inline void set_varint(uint64_t value);
+  inline void set_fixed32(uint32_t value);
+  inline void set_fixed64(uint64_t value);
+  inline void set_length_delimited(const std::string& value);
+  inline std::string* mutable_length_delimited();
+  inline UnknownFieldSet* mutable_group();
+
+  inline size_t GetLengthDelimitedSize() const;
+  uint8_t* InternalSerializeLengthDelimitedNoTag(
+      uint8_t* target, io::EpsCopyOutputStream* stream) const;
+
+
+  // If this UnknownField contains a pointer, delete it.
+  void Delete();
+
+  // Make a deep copy of any pointers in this UnknownField.  The copies are
+  // allocated on `arena` if it is non-null.
+  void DeepCopy(const UnknownField& other, Arena* arena = nullptr);
+
+  // Set the wire type of this UnknownField. Should only be used when this
+  // UnknownField is being created.
+  inline void SetType(Type type);
+
+  union LengthDelimited {
+    std::string* string_value;
+  };
+
+  uint32_t number_;
+  uint32_t type_;
+  union {
+    uint64_t varint_;
+    uint32_t fixed32_;
+    uint64_t fixed64_;
+    mutable union LengthDelimited length_delimited_;
+    UnknownFieldSet* group_;
+  } data_;
+};
 
 // An UnknownFieldSet contains fields that were encountered while parsing a
 // message but were not defined by its type.  Keeping track of these can be
@@ -85,6 +154,10 @@ class UnknownField;  // below
 class PROTOBUF_EXPORT UnknownFieldSet {
  public:
   UnknownFieldSet();
+  // Constructs a set whose fields, strings and groups are all allocated on
+  // `arena`.  Such a set never needs to be destroyed when it is itself
+  // allocated on the arena.
+  explicit UnknownFieldSet(Arena* arena);
   UnknownFieldSet(const UnknownFieldSet&) = delete;
   UnknownFieldSet& operator=(const UnknownFieldSet&) = delete;
   ~UnknownFieldSet();
@@ -128,6 +201,11 @@ class PROTOBUF_EXPORT UnknownFieldSet {
   int SpaceUsed() const { return internal::ToIntSize(SpaceUsedLong()); }
 
   // Returns the number of fields present in the UnknownFieldSet.
+  //
+  // If the set still holds undecoded wire bytes (see
+  // internal::SetLazyUnknownFieldParsing()), the first call to this or field()
+  // decodes them into a separate copy, published atomically, so concurrent
+  // const accessors stay safe.  Mutators fold that copy into the set.
   inline int field_count() const;
   // Get a field in the set, where 0 <= index < field_count().  The fields
   // appear in the order in which they were added.
@@ -184,10 +262,32 @@ class PROTOBUF_EXPORT UnknownFieldSet {
  private:
   // For InternalMergeFrom
   friend class UnknownField;
+  // For raw_
+  friend class internal::UnknownFieldParserHelper;
+  friend class internal::WireFormat;
   // Merges from other UnknownFieldSet. This method assumes, that this object
   // is newly created and has no fields.
   void InternalMergeFrom(const UnknownFieldSet& other);
   void ClearFallback();
+  void SwapFallback(UnknownFieldSet* x);
+
+  Arena* arena() const { return fields_.get_allocator().arena(); }
+  // Allocates a group on `arena`, if non-null, without registering a cleanup.
+  static UnknownFieldSet* NewGroup(Arena* arena);
+  // Returns raw_ for appending, dropping the decoded copy of its old contents.
+  std::string* mutable_raw();
+  bool has_raw() const { return raw_ != nullptr && !raw_->empty(); }
+
+  // Moves the fields held in raw_ into fields_, for mutators.
+  inline void MaybeDecodeRaw();
+  void DecodeRaw();
+  // Returns the fields held in raw_, decoding them on first use.  Safe to call
+  // concurrently: racing decoders publish through decoded_raw_ and all but
+  // one of them discard their copy.
+  inline UnknownFieldSet* decoded_raw() const;
+  UnknownFieldSet* DecodeRawOnce() const;
+  inline void ResetDecodedRaw();
+  void ResetDecodedRawFallback();
 
   template <typename MessageType,
             typename std::enable_if<
@@ -210,7 +310,17 @@ class PROTOBUF_EXPORT UnknownFieldSet {
     return MergeFromCodedStream(&coded_stream);
   }
 
-  std::vector<UnknownField> fields_;
+  // The set's contents are fields_ followed by raw_, which holds fields that
+  // were parsed in lazy mode and are still in wire form.  Const accessors
+  // never modify either of them; the structured view of raw_ is built in
+  // decoded_raw_ instead.
+  //
+  // Every string and group referenced from fields_, and raw_ itself, is owned
+  // by arena() when it is non-null and is otherwise owned by this set.  So is
+  // decoded_raw_, which is null or holds exactly the fields in raw_.
+  std::vector<UnknownField, internal::MapAllocator<UnknownField>> fields_;
+  std::string* raw_ = nullptr;
+  mutable std::atomic<UnknownFieldSet*> decoded_raw_{nullptr};
 };
 
 namespace internal {
@@ -230,77 +340,28 @@ PROTOBUF_EXPORT
 const char* UnknownFieldParse(uint64_t tag, UnknownFieldSet* unknown,
                               const char* ptr, ParseContext* ctx);
 
-}  // namespace internal
+// When enabled, unknown fields met while parsing full-runtime messages are
+// appended to their UnknownFieldSet as raw wire bytes instead of being decoded
+// into UnknownField objects.  Messages whose unknown fields are only ever
+// re-serialized (proxies, forwarders) then pay a single copy per field.  The
+// structured view is built on the first call to field_count(), field(), or
+// any mutator.  Disabled by default.
+PROTOBUF_EXPORT void SetLazyUnknownFieldParsing(bool enabled);
 
-// Represents one field in an UnknownFieldSet.
-class PROTOBUF_EXPORT UnknownField {
- public:
-  enum Type {
-    TYPE_VARINT,
-    TYPE_FIXED32,
-    TYPE_FIXED64,
-    TYPE_LENGTH_DELIMITED,
-    TYPE_GROUP
-  };
-
-  // The field's field number, as seen on the wire.
-  inline int number() const;
-
-  // The field type.
-  inline Type type() const;
-
-  // Accessors -------------------------------------------------------
-  // Each method works only for UnknownFields of the corresponding type.
-
-  inline uint64_t varint() const;
-  inline uint32_t fixed32() const;
-  inline uint64_t fixed64() const;
-  inline const std::string& length_delimited() const;
-  inline const UnknownFieldSet& group() const;
-
-  inline void set_varint(uint64_t value);
-  inline void set_fixed32(uint32_t value);
-  inline void set_fixed64(uint64_t value);
-  inline void set_length_delimited(const std::string& value);
-  inline std::string* mutable_length_delimited();
-  inline UnknownFieldSet* mutable_group();
-
-  inline size_t GetLengthDelimitedSize() const;
-  uint8_t* InternalSerializeLengthDelimitedNoTag(
-      uint8_t* target, io::EpsCopyOutputStream* stream) const;
-
-
-  // If this UnknownField contains a pointer, delete it.
-  void Delete();
-
-  // Make a deep copy of any pointers in this UnknownField.
-  void DeepCopy(const UnknownField& other);
-
-  // Set the wire type of this UnknownField. Should only be used when this
-  // UnknownField is being created.
-  inline void SetType(Type type);
-
-  union LengthDelimited {
-    std::string* string_value;
-  };
-
-  uint32_t number_;
-  uint32_t type_;
-  union {
-    uint64_t varint_;
-    uint32_t fixed32_;
-    uint64_t fixed64_;
-    mutable union LengthDelimited length_delimited_;
-    UnknownFieldSet* group_;
-  } data_;
-};
+}  // namespace internal
 
 // ===================================================================
 // inline implementations
 
 inline UnknownFieldSet::UnknownFieldSet() {}
 
-inline UnknownFieldSet::~UnknownFieldSet() { Clear(); }
+inline UnknownFieldSet::UnknownFieldSet(Arena* arena)
+    : fields_(internal::MapAllocator<UnknownField>(arena)) {}
+
+inline UnknownFieldSet::~UnknownFieldSet() {
+  Clear();
+  if (arena() == nullptr) delete raw_;
+}
 
 inline void UnknownFieldSet::ClearAndFreeMemory() { Clear(); }
 
@@ -308,21 +369,55 @@ inline void UnknownFieldSet::Clear() {
   if (!fields_.empty()) {
     ClearFallback();
   }
+  if (raw_ != nullptr) raw_->clear();
+  ResetDecodedRaw();
 }
 
-inline bool UnknownFieldSet::empty() const { return fields_.empty(); }
+inline bool UnknownFieldSet::empty() const {
+  return fields_.empty() && (raw_ == nullptr || raw_->empty());
+}
 
 inline void UnknownFieldSet::Swap(UnknownFieldSet* x) {
-  fields_.swap(x->fields_);
+  if (PROTOBUF_PREDICT_TRUE(arena() == x->arena())) {
+    fields_.swap(x->fields_);
+    std::swap(raw_, x->raw_);
+    UnknownFieldSet* decoded = decoded_raw_.load(std::memory_order_relaxed);
+    decoded_raw_.store(x->decoded_raw_.load(std::memory_order_relaxed),
+                       std::memory_order_relaxed);
+    x->decoded_raw_.store(decoded, std::memory_order_relaxed);
+  } else {
+    SwapFallback(x);
+  }
+}
+
+inline void UnknownFieldSet::MaybeDecodeRaw() {
+  if (PROTOBUF_PREDICT_FALSE(has_raw())) DecodeRaw();
+}
+
+inline UnknownFieldSet* UnknownFieldSet::decoded_raw() const {
+  UnknownFieldSet* decoded = decoded_raw_.load(std::memory_order_acquire);
+  if (PROTOBUF_PREDICT_TRUE(decoded != nullptr)) return decoded;
+  return DecodeRawOnce();
+}
+
+inline void UnknownFieldSet::ResetDecodedRaw() {
+  if (decoded_raw_.load(std::memory_order_relaxed) != nullptr) {
+    ResetDecodedRawFallback();
+  }
 }
 
 inline int UnknownFieldSet::field_count() const {
-  return static_cast<int>(fields_.size());
+  int count = static_cast<int>(fields_.size());
+  if (PROTOBUF_PREDICT_FALSE(has_raw())) count += decoded_raw()->field_count();
+  return count;
 }
 inline const UnknownField& UnknownFieldSet::field(int index) const {
-  return (fields_)[static_cast<size_t>(index)];
+  size_t i = static_cast<size_t>(index);
+  if (PROTOBUF_PREDICT_TRUE(i < fields_.size())) return (fields_)[i];
+  return decoded_raw()->field(static_cast<int>(i - fields_.size()));
 }
 inline UnknownField* UnknownFieldSet::mutable_field(int index) {
+  MaybeDecodeRaw();
   return &(fields_)[static_cast<size_t>(index)];
 }
 
@@ -38,6 +38,7 @@
 #include "google/protobuf/unknown_field_set.h"
 
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "google/protobuf/stubs/callback.h"
@@ -48,6 +49,7 @@
 #include "absl/container/flat_hash_set.h"
 #include "absl/functional/bind_front.h"
 #include "absl/strings/cord.h"
+#include "absl/strings/str_cat.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
@@ -754,6 +756,119 @@ TEST_F(UnknownFieldSetTest, SerializeToCord_TestPackedTypes) {
   EXPECT_THAT(message.packed_uint64(), ElementsAre(5, 6, 7));
 }
 
+TEST_F(UnknownFieldSetTest, LazyParsing) {
+  internal::SetLazyUnknownFieldParsing(true);
+  unittest::TestEmptyMessage lazy_message;
+  bool parsed = lazy_message.ParseFromString(all_fields_data_);
+  internal::SetLazyUnknownFieldParsing(false);
+  ASSERT_TRUE(parsed);
+
+  // Re-serializing writes the raw bytes back without decoding them.
+  EXPECT_FALSE(lazy_message.unknown_fields().empty());
+  EXPECT_EQ(all_fields_data_, lazy_message.SerializeAsString());
+  EXPECT_EQ(all_fields_data_.size(), lazy_message.ByteSizeLong());
+
+  // Merging appends raw bytes to raw bytes.
+  unittest::TestEmptyMessage merged;
+  merged.MergeFrom(lazy_message);
+  merged.MergeFrom(lazy_message);
+  EXPECT_EQ(absl::StrCat(all_fields_data_, all_fields_data_),
+            merged.SerializeAsString());
+
+  // The structured view matches an eagerly parsed set.
+  ASSERT_EQ(unknown_fields_->field_count(),
+            lazy_message.unknown_fields().field_count());
+  for (int i = 0; i < unknown_fields_->field_count(); i++) {
+    EXPECT_EQ(unknown_fields_->field(i).number(),
+              lazy_message.unknown_fields().field(i).number());
+    EXPECT_EQ(unknown_fields_->field(i).type(),
+              lazy_message.unknown_fields().field(i).type());
+  }
+  EXPECT_EQ(all_fields_data_, lazy_message.SerializeAsString());
+}
+
+TEST_F(UnknownFieldSetTest, LazyParsingKeepsFieldOrder) {
+  UnknownFieldSet decoded;
+  decoded.AddVarint(1, 1);
+
+  internal::SetLazyUnknownFieldParsing(true);
+  unittest::TestEmptyMessage lazy_message;
+  bool parsed = lazy_message.ParseFromString(all_fields_data_);
+  internal::SetLazyUnknownFieldParsing(false);
+  ASSERT_TRUE(parsed);
+
+  // Raw bytes merged into a decoded set come after its fields.
+  decoded.MergeFrom(lazy_message.unknown_fields());
+  ASSERT_EQ(unknown_fields_->field_count() + 1, decoded.field_count());
+  EXPECT_EQ(1, decoded.field(0).number());
+  EXPECT_EQ(unknown_fields_->field(0).number(), decoded.field(1).number());
+
+  // Fields added after lazily parsed ones come after them.
+  UnknownFieldSet* lazy = lazy_message.mutable_unknown_fields();
+  lazy->AddVarint(2, 2);
+  ASSERT_EQ(unknown_fields_->field_count() + 1, lazy->field_count());
+  EXPECT_EQ(2, lazy->field(lazy->field_count() - 1).number());
+}
+
+TEST_F(UnknownFieldSetTest, LazyParsingConcurrentReads) {
+  Arena arena;
+  internal::SetLazyUnknownFieldParsing(true);
+  unittest::TestEmptyMessage heap_message;
+  auto* arena_message =
+      Arena::CreateMessage<unittest::TestEmptyMessage>(&arena);
+  bool parsed = heap_message.ParseFromString(all_fields_data_) &&
+                arena_message->ParseFromString(all_fields_data_);
+  internal::SetLazyUnknownFieldParsing(false);
+  ASSERT_TRUE(parsed);
+
+  // The first structured reads of a const set may run concurrently with each
+  // other and with serialization.
+  for (const auto* message : {&heap_message, arena_message}) {
+    const UnknownFieldSet& fields = message->unknown_fields();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+      threads.emplace_back([&] {
+        ASSERT_EQ(unknown_fields_->field_count(), fields.field_count());
+        for (int i = 0; i < fields.field_count(); i++) {
+          EXPECT_EQ(unknown_fields_->field(i).number(),
+                    fields.field(i).number());
+        }
+        EXPECT_EQ(all_fields_data_, message->SerializeAsString());
+      });
+    }
+    for (auto& thread : threads) thread.join();
+  }
+}
+
+TEST_F(UnknownFieldSetTest, ArenaMessage) {
+  Arena arena;
+  auto* message = Arena::CreateMessage<unittest::TestEmptyMessage>(&arena);
+  ASSERT_TRUE(message->ParseFromString(all_fields_data_));
+  EXPECT_EQ(all_fields_data_, message->SerializeAsString());
+
+  UnknownFieldSet* fields = message->mutable_unknown_fields();
+  ASSERT_EQ(unknown_fields_->field_count(), fields->field_count());
+  fields->AddLengthDelimited(1000, "a string longer than the inline buffer");
+  fields->AddGroup(1001)->AddLengthDelimited(1002, "nested");
+  fields->DeleteByNumber(1);
+  EXPECT_EQ(unknown_fields_->field_count() + 1, fields->field_count());
+
+  // Swapping with a heap set copies the contents across owners.
+  UnknownFieldSet heap;
+  heap.AddVarint(7, 7);
+  heap.Swap(fields);
+  ASSERT_EQ(1, fields->field_count());
+  EXPECT_EQ(7, fields->field(0).number());
+  ASSERT_EQ(unknown_fields_->field_count() + 1, heap.field_count());
+  EXPECT_EQ(1001, heap.field(heap.field_count() - 1).number());
+  const UnknownFieldSet& group = heap.field(heap.field_count() - 1).group();
+  EXPECT_EQ("nested", group.field(0).length_delimited());
+
+  unittest::TestEmptyMessage copy;
+  copy.CopyFrom(*message);
+  EXPECT_EQ(message->SerializeAsString(), copy.SerializeAsString());
+}
+
 }  // namespace
 
 }  // namespace protobuf
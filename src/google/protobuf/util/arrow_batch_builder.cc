@@ -0,0 +1,484 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "google/protobuf/util/arrow_batch_builder.h"
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#include "absl/log/absl_check.h"
+#include "absl/log/absl_log.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "absl/types/variant.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+namespace {
+
+constexpr int64_t kMaxDataSize = std::numeric_limits<int32_t>::max();
+
+ArrowType ArrowTypeForField(const FieldDescriptor* field) {
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+    case FieldDescriptor::CPPTYPE_ENUM:
+      return ArrowType::kInt32;
+    case FieldDescriptor::CPPTYPE_INT64:
+      return ArrowType::kInt64;
+    case FieldDescriptor::CPPTYPE_UINT32:
+      return ArrowType::kUInt32;
+    case FieldDescriptor::CPPTYPE_UINT64:
+      return ArrowType::kUInt64;
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      return ArrowType::kFloat;
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      return ArrowType::kDouble;
+    case FieldDescriptor::CPPTYPE_BOOL:
+      return ArrowType::kBool;
+    case FieldDescriptor::CPPTYPE_STRING:
+      return field->type() == FieldDescriptor::TYPE_STRING ? ArrowType::kUtf8
+                                                           : ArrowType::kBinary;
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      break;
+  }
+  ABSL_LOG(FATAL) << "Unsupported column type: " << field->full_name();
+  return ArrowType::kBinary;
+}
+
+// Bytes per value for fixed-width types other than bool, 0 otherwise.
+size_t ValueWidth(ArrowType type) {
+  switch (type) {
+    case ArrowType::kInt32:
+    case ArrowType::kUInt32:
+    case ArrowType::kFloat:
+      return 4;
+    case ArrowType::kInt64:
+    case ArrowType::kUInt64:
+    case ArrowType::kDouble:
+      return 8;
+    case ArrowType::kBool:
+    case ArrowType::kUtf8:
+    case ArrowType::kBinary:
+      return 0;
+  }
+  return 0;
+}
+
+void AppendBit(std::vector<uint8_t>* bitmap, int64_t index, bool value) {
+  if (index % 8 == 0) bitmap->push_back(0);
+  if (value) bitmap->back() |= static_cast<uint8_t>(1u << (index % 8));
+}
+
+bool GetBit(const std::vector<uint8_t>& bitmap, int64_t index) {
+  return (bitmap[index / 8] >> (index % 8)) & 1;
+}
+
+void TruncateBitmap(std::vector<uint8_t>* bitmap, int64_t length) {
+  bitmap->resize((length + 7) / 8);
+  if (length % 8 != 0) {
+    bitmap->back() &= static_cast<uint8_t>((1u << (length % 8)) - 1);
+  }
+}
+
+}  // namespace
+
+absl::string_view ArrowTypeName(ArrowType type) {
+  switch (type) {
+    case ArrowType::kBool:
+      return "bool";
+    case ArrowType::kInt32:
+      return "int32";
+    case ArrowType::kInt64:
+      return "int64";
+    case ArrowType::kUInt32:
+      return "uint32";
+    case ArrowType::kUInt64:
+      return "uint64";
+    case ArrowType::kFloat:
+      return "float";
+    case ArrowType::kDouble:
+      return "double";
+    case ArrowType::kUtf8:
+      return "utf8";
+    case ArrowType::kBinary:
+      return "binary";
+  }
+  return "";
+}
+
+ArrowColumn::ArrowColumn(ArrowType type, bool nullable)
+    : type_(type), nullable_(nullable) {
+  if (is_binary()) offsets_.push_back(0);
+}
+
+void ArrowColumn::AppendValidity(bool valid) {
+  if (nullable_) {
+    AppendBit(&validity_, length_, valid);
+    if (!valid) ++null_count_;
+  }
+  ++length_;
+}
+
+template <typename T>
+void ArrowColumn::AppendValue(T value) {
+  ABSL_DCHECK_EQ(sizeof(T), ValueWidth(type_));
+  uint8_t bytes[sizeof(T)];
+  memcpy(bytes, &value, sizeof(T));
+  values_.insert(values_.end(), bytes, bytes + sizeof(T));
+}
+
+void ArrowColumn::AppendBool(bool value) {
+  AppendBit(&values_, length_ - 1, value);
+}
+
+bool ArrowColumn::AppendString(absl::string_view value) {
+  if (static_cast<int64_t>(value.size()) >
+      kMaxDataSize - static_cast<int64_t>(data_.size())) {
+    return false;
+  }
+  data_.append(value.data(), value.size());
+  offsets_.push_back(static_cast<int32_t>(data_.size()));
+  return true;
+}
+
+void ArrowColumn::TruncateTo(int64_t length) {
+  if (length >= length_) return;
+  if (nullable_) {
+    for (int64_t i = length; i < length_; ++i) {
+      if (!GetBit(validity_, i)) --null_count_;
+    }
+    TruncateBitmap(&validity_, length);
+  }
+  if (type_ == ArrowType::kBool) {
+    TruncateBitmap(&values_, length);
+  } else if (is_binary()) {
+    offsets_.resize(length + 1);
+    data_.resize(offsets_.back());
+  } else {
+    values_.resize(length * ValueWidth(type_));
+  }
+  length_ = length;
+}
+
+void ArrowColumn::Clear() {
+  length_ = 0;
+  null_count_ = 0;
+  validity_.clear();
+  values_.clear();
+  offsets_.clear();
+  data_.clear();
+  if (is_binary()) offsets_.push_back(0);
+}
+
+ArrowBatchBuilder::ArrowBatchBuilder(const Descriptor* descriptor)
+    : descriptor_(descriptor), decoder_(descriptor) {}
+
+bool ArrowBatchBuilder::AddColumn(const FieldDescriptor* field) {
+  if (num_rows_ != 0 || !decoder_.AddColumn(field)) return false;
+  const ArrowType type = ArrowTypeForField(field);
+  fields_.push_back(field);
+  schema_.push_back({field->name(), type, field->has_presence()});
+  columns_.push_back(ArrowColumn(type, field->has_presence()));
+  // Accessors are resolved again, for all columns, by the next Append().
+  reflection_ = nullptr;
+  return true;
+}
+
+void ArrowBatchBuilder::AddAllColumns() {
+  for (int i = 0; i < descriptor_->field_count(); ++i) {
+    AddColumn(descriptor_->field(i));
+  }
+}
+
+void ArrowBatchBuilder::Compile(const Reflection* reflection) {
+  reflection_ = reflection;
+  accessors_.clear();
+  accessors_.reserve(fields_.size());
+  for (const FieldDescriptor* field : fields_) {
+    switch (field->cpp_type()) {
+      case FieldDescriptor::CPPTYPE_INT32:
+        accessors_.emplace_back(reflection->GetFieldAccessor<int32_t>(field));
+        break;
+      case FieldDescriptor::CPPTYPE_INT64:
+        accessors_.emplace_back(reflection->GetFieldAccessor<int64_t>(field));
+        break;
+      case FieldDescriptor::CPPTYPE_UINT32:
+        accessors_.emplace_back(reflection->GetFieldAccessor<uint32_t>(field));
+        break;
+      case FieldDescriptor::CPPTYPE_UINT64:
+        accessors_.emplace_back(reflection->GetFieldAccessor<uint64_t>(field));
+        break;
+      case FieldDescriptor::CPPTYPE_FLOAT:
+        accessors_.emplace_back(reflection->GetFieldAccessor<float>(field));
+        break;
+      case FieldDescriptor::CPPTYPE_DOUBLE:
+        accessors_.emplace_back(reflection->GetFieldAccessor<double>(field));
+        break;
+      case FieldDescriptor::CPPTYPE_BOOL:
+        accessors_.emplace_back(reflection->GetFieldAccessor<bool>(field));
+        break;
+      case FieldDescriptor::CPPTYPE_ENUM:
+      case FieldDescriptor::CPPTYPE_STRING:
+      case FieldDescriptor::CPPTYPE_MESSAGE:
+        accessors_.emplace_back(absl::monostate());
+        break;
+    }
+  }
+}
+
+bool ArrowBatchBuilder::Append(const Message& message) {
+  ABSL_DCHECK_EQ(message.GetDescriptor(), descriptor_);
+  if (reflection_ == nullptr) Compile(message.GetReflection());
+  const bool ok = message.GetReflection() == reflection_
+                      ? AppendRow(message)
+                      : AppendRowWithReflection(message);
+  if (!ok) {
+    AbandonRow();
+    return false;
+  }
+  ++num_rows_;
+  return true;
+}
+
+bool ArrowBatchBuilder::AppendBatch(absl::Span<const Message* const> messages) {
+  const int64_t start = num_rows_;
+  for (const Message* message : messages) {
+    if (!Append(*message)) {
+      num_rows_ = start;
+      AbandonRow();
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ArrowBatchBuilder::AppendRow(const Message& message) {
+  std::string scratch;
+  for (size_t i = 0; i < columns_.size(); ++i) {
+    ArrowColumn& column = columns_[i];
+    const auto append_fixed = [&](const auto& accessor) {
+      column.AppendValidity(!column.nullable_ || accessor.Has(message));
+      column.AppendValue(accessor.Get(message));
+    };
+    switch (column.type_) {
+      case ArrowType::kInt32:
+        if (fields_[i]->cpp_type() == FieldDescriptor::CPPTYPE_ENUM) {
+          column.AppendValidity(!column.nullable_ ||
+                                reflection_->HasField(message, fields_[i]));
+          column.AppendValue<int32_t>(
+              reflection_->GetEnumValue(message, fields_[i]));
+        } else {
+          append_fixed(absl::get<FieldAccessor<int32_t>>(accessors_[i]));
+        }
+        break;
+      case ArrowType::kInt64:
+        append_fixed(absl::get<FieldAccessor<int64_t>>(accessors_[i]));
+        break;
+      case ArrowType::kUInt32:
+        append_fixed(absl::get<FieldAccessor<uint32_t>>(accessors_[i]));
+        break;
+      case ArrowType::kUInt64:
+        append_fixed(absl::get<FieldAccessor<uint64_t>>(accessors_[i]));
+        break;
+      case ArrowType::kFloat:
+        append_fixed(absl::get<FieldAccessor<float>>(accessors_[i]));
+        break;
+      case ArrowType::kDouble:
+        append_fixed(absl::get<FieldAccessor<double>>(accessors_[i]));
+        break;
+      case ArrowType::kBool: {
+        const auto& accessor = absl::get<FieldAccessor<bool>>(accessors_[i]);
+        column.AppendValidity(!column.nullable_ || accessor.Has(message));
+        column.AppendBool(accessor.Get(message));
+        break;
+      }
+      case ArrowType::kUtf8:
+      case ArrowType::kBinary: {
+        const bool valid = !column.nullable_ ||
+                           reflection_->HasField(message, fields_[i]);
+        column.AppendValidity(valid);
+        if (!column.AppendString(valid ? reflection_->GetStringReference(
+                                             message, fields_[i], &scratch)
+                                       : absl::string_view())) {
+          return false;
+        }
+        break;
+      }
+    }
+  }
+  return true;
+}
+
+bool ArrowBatchBuilder::AppendRowWithReflection(const Message& message) {
+  const Reflection* reflection = message.GetReflection();
+  std::string scratch;
+  for (size_t i = 0; i < columns_.size(); ++i) {
+    ArrowColumn& column = columns_[i];
+    const FieldDescriptor* field = fields_[i];
+    const bool valid =
+        !column.nullable_ || reflection->HasField(message, field);
+    column.AppendValidity(valid);
+    switch (field->cpp_type()) {
+      case FieldDescriptor::CPPTYPE_INT32:
+        column.AppendValue(reflection->GetInt32(message, field));
+        break;
+      case FieldDescriptor::CPPTYPE_ENUM:
+        column.AppendValue<int32_t>(reflection->GetEnumValue(message, field));
+        break;
+      case FieldDescriptor::CPPTYPE_INT64:
+        column.AppendValue(reflection->GetInt64(message, field));
+        break;
+      case FieldDescriptor::CPPTYPE_UINT32:
+        column.AppendValue(reflection->GetUInt32(message, field));
+        break;
+      case FieldDescriptor::CPPTYPE_UINT64:
+        column.AppendValue(reflection->GetUInt64(message, field));
+        break;
+      case FieldDescriptor::CPPTYPE_FLOAT:
+        column.AppendValue(reflection->GetFloat(message, field));
+        break;
+      case FieldDescriptor::CPPTYPE_DOUBLE:
+        column.AppendValue(reflection->GetDouble(message, field));
+        break;
+      case FieldDescriptor::CPPTYPE_BOOL:
+        column.AppendBool(reflection->GetBool(message, field));
+        break;
+      case FieldDescriptor::CPPTYPE_STRING:
+        if (!column.AppendString(
+                valid ? reflection->GetStringReference(message, field, &scratch)
+                      : absl::string_view())) {
+          return false;
+        }
+        break;
+      case FieldDescriptor::CPPTYPE_MESSAGE:
+        ABSL_LOG(FATAL) << "Unsupported column type: " << field->full_name();
+    }
+  }
+  return true;
+}
+
+void ArrowBatchBuilder::AbandonRow() {
+  for (ArrowColumn& column : columns_) column.TruncateTo(num_rows_);
+}
+
+bool ArrowBatchBuilder::AppendSerialized(
+    absl::Span<const absl::string_view> records) {
+  decoder_.Clear();
+  for (absl::string_view record : records) {
+    if (!decoder_.ParseRecord(record)) {
+      decoder_.Clear();
+      return false;
+    }
+  }
+  const int rows = decoder_.num_rows();
+
+  // Check that every binary column still fits its 32-bit offsets before
+  // appending anything, so that a failure leaves the batch unchanged.
+  for (int i = 0; i < num_columns(); ++i) {
+    const ArrowColumn& column = columns_[i];
+    if (!column.is_binary()) continue;
+    const ColumnarColumn& source = decoder_.column(i);
+    int64_t size = 0;
+    if (column.nullable_) {
+      for (int row = 0; row < rows; ++row) {
+        if (source.has_value(row)) size += source.string_value(row).size();
+      }
+    } else {
+      size = source.string_data().size();
+    }
+    if (size > kMaxDataSize - static_cast<int64_t>(column.data_.size())) {
+      decoder_.Clear();
+      return false;
+    }
+  }
+
+  for (int i = 0; i < num_columns(); ++i) {
+    ArrowColumn& column = columns_[i];
+    const ColumnarColumn& source = decoder_.column(i);
+    const int64_t start = column.length_;
+    for (int row = 0; row < rows; ++row) {
+      column.AppendValidity(!column.nullable_ || source.has_value(row));
+    }
+    if (column.type_ == ArrowType::kBool) {
+      // Absent rows hold the default value, like Reflection::GetBool().
+      absl::Span<const bool> values = source.values<bool>();
+      for (int row = 0; row < rows; ++row) {
+        AppendBit(&column.values_, start + row, values[row]);
+      }
+    } else if (column.is_binary() && column.nullable_) {
+      // Null rows are left empty, as Append() does.
+      for (int row = 0; row < rows; ++row) {
+        if (source.has_value(row)) {
+          column.data_.append(source.string_value(row).data(),
+                              source.string_value(row).size());
+        }
+        column.offsets_.push_back(static_cast<int32_t>(column.data_.size()));
+      }
+    } else if (column.is_binary()) {
+      const int32_t base = column.offsets_.back();
+      absl::Span<const uint32_t> offsets = source.offsets();
+      for (int row = 1; row <= rows; ++row) {
+        column.offsets_.push_back(base + static_cast<int32_t>(offsets[row]));
+      }
+      column.data_.append(source.string_data().data(),
+                          source.string_data().size());
+    } else {
+      // The decoder keeps fixed-width values in the same representation, in
+      // the buffer string_data() exposes: copy the whole column.
+      absl::string_view values = source.string_data();
+      column.values_.insert(column.values_.end(), values.begin(),
+                            values.end());
+    }
+  }
+  num_rows_ += rows;
+  decoder_.Clear();
+  return true;
+}
+
+void ArrowBatchBuilder::Clear() {
+  for (ArrowColumn& column : columns_) column.Clear();
+  num_rows_ = 0;
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
@@ -0,0 +1,224 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// Converts records of one message type into columns laid out as Apache Arrow
+// arrays, so that analytics code can hand them to Arrow without a per-value
+// conversion.
+//
+// The column set, the Arrow schema and how each field is read are worked out
+// once.  Appending a message then reads every column through a
+// Reflection::GetFieldAccessor() handle, i.e. directly at the field's offset,
+// with no descriptor lookups and no per-value virtual calls.  Serialized
+// records can be appended without building messages at all: they are decoded
+// by a ColumnarDecoder and copied over a column at a time.
+//
+// Example:
+//   ArrowBatchBuilder builder(Record::descriptor());
+//   builder.AddAllColumns();
+//   for (const Record& record : records) builder.Append(record);
+//   for (int i = 0; i < builder.num_columns(); ++i) {
+//     const ArrowColumn& column = builder.column(i);
+//     // Wrap column.validity(), column.values(), column.offsets() and
+//     // column.data() as the buffers of an Arrow array of
+//     // builder.schema()[i].type with builder.num_rows() elements.
+//   }
+//
+// This library does not depend on Arrow; the buffers follow the Arrow
+// columnar format and can be wrapped (or copied) into arrow::ArrayData.
+
+#ifndef GOOGLE_PROTOBUF_UTIL_ARROW_BATCH_BUILDER_H__
+#define GOOGLE_PROTOBUF_UTIL_ARROW_BATCH_BUILDER_H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "absl/types/variant.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+#include "google/protobuf/util/columnar_decoder.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+// The Arrow data type of a column.  Enums become int32 columns holding the
+// enum numbers.
+enum class ArrowType {
+  kBool,
+  kInt32,
+  kInt64,
+  kUInt32,
+  kUInt64,
+  kFloat,
+  kDouble,
+  kUtf8,
+  kBinary,
+};
+
+// The name Arrow uses for `type`, e.g. "int32" or "utf8".
+PROTOBUF_EXPORT absl::string_view ArrowTypeName(ArrowType type);
+
+// One field of the Arrow schema.  Fields with presence are nullable and are
+// null in rows that did not set them; other fields are never null.
+struct ArrowField {
+  std::string name;
+  ArrowType type;
+  bool nullable;
+};
+
+// The buffers of one Arrow array.
+class PROTOBUF_EXPORT ArrowColumn {
+ public:
+  int64_t length() const { return length_; }
+  int64_t null_count() const { return null_count_; }
+
+  // The validity bitmap: bit `i` (least significant bit first) is set if row
+  // `i` is not null.  Empty for columns that are not nullable, which Arrow
+  // accepts in place of an all-valid bitmap.
+  absl::Span<const uint8_t> validity() const { return validity_; }
+
+  // Fixed-width values, one per row (bit-packed like validity() for bool
+  // columns).  Empty for utf8 and binary columns.
+  absl::Span<const uint8_t> values() const { return values_; }
+
+  // Utf8 and binary columns keep all values back to back in data(); row `i`
+  // spans [offsets()[i], offsets()[i + 1]).  Empty for other columns.
+  absl::Span<const int32_t> offsets() const { return offsets_; }
+  absl::string_view data() const { return data_; }
+
+ private:
+  friend class ArrowBatchBuilder;
+
+  ArrowColumn(ArrowType type, bool nullable);
+
+  bool is_binary() const {
+    return type_ == ArrowType::kUtf8 || type_ == ArrowType::kBinary;
+  }
+  // Each row is added by AppendValidity() followed by exactly one Append*()
+  // call.  AppendString() returns false, without adding the value, if it
+  // would overflow the 32-bit offsets.
+  void AppendValidity(bool valid);
+  template <typename T>
+  void AppendValue(T value);
+  void AppendBool(bool value);
+  bool AppendString(absl::string_view value);
+  void TruncateTo(int64_t length);
+  void Clear();
+
+  ArrowType type_;
+  bool nullable_;
+  int64_t length_ = 0;
+  int64_t null_count_ = 0;
+  std::vector<uint8_t> validity_;
+  std::vector<uint8_t> values_;
+  std::vector<int32_t> offsets_;
+  std::string data_;
+};
+
+// Appends records of one message type to a batch of ArrowColumns, one per
+// selected singular scalar, enum, string or bytes field.
+class PROTOBUF_EXPORT ArrowBatchBuilder {
+ public:
+  explicit ArrowBatchBuilder(const Descriptor* descriptor);
+  ArrowBatchBuilder(const ArrowBatchBuilder&) = delete;
+  ArrowBatchBuilder& operator=(const ArrowBatchBuilder&) = delete;
+
+  // Adds a column for `field`, which must belong to the converted message
+  // type.  Returns false for repeated, message and group fields, and for
+  // fields that already have a column.  Columns must be added before any
+  // record is appended.
+  bool AddColumn(const FieldDescriptor* field);
+
+  // Adds a column for every supported field, in declaration order.
+  void AddAllColumns();
+
+  // Appends `message`, which must be of the converted type, as a new row.
+  // Returns false, without adding a row, if a utf8 or binary column would
+  // exceed the 2 GiB that Arrow's 32-bit offsets can address.
+  bool Append(const Message& message);
+  // Appends each of `messages`.  On failure no row is added.
+  bool AppendBatch(absl::Span<const Message* const> messages);
+
+  // Decodes serialized records with a ColumnarDecoder and appends them as new
+  // rows, without parsing them into messages.  On failure no row is added.
+  bool AppendSerialized(absl::Span<const absl::string_view> records);
+
+  const Descriptor* descriptor() const { return descriptor_; }
+  const std::vector<ArrowField>& schema() const { return schema_; }
+  int64_t num_rows() const { return num_rows_; }
+  int num_columns() const { return static_cast<int>(columns_.size()); }
+  const ArrowColumn& column(int index) const { return columns_[index]; }
+
+  // Removes all rows, keeping the columns and their allocated capacity.
+  void Clear();
+
+ private:
+  // How a column reads its field from a message.  Numeric and bool fields
+  // use a FieldAccessor; enums, strings and bytes use the Reflection getters.
+  using Accessor =
+      absl::variant<absl::monostate, FieldAccessor<int32_t>,
+                    FieldAccessor<int64_t>, FieldAccessor<uint32_t>,
+                    FieldAccessor<uint64_t>, FieldAccessor<float>,
+                    FieldAccessor<double>, FieldAccessor<bool>>;
+
+  // Resolves an accessor per column for messages with `reflection`.
+  void Compile(const Reflection* reflection);
+  bool AppendRow(const Message& message);
+  // Like AppendRow(), for messages whose Reflection differs from the one the
+  // accessors were resolved for.
+  bool AppendRowWithReflection(const Message& message);
+  // Drops the cells appended for a row that could not be completed.
+  void AbandonRow();
+
+  const Descriptor* descriptor_;
+  std::vector<const FieldDescriptor*> fields_;
+  std::vector<ArrowField> schema_;
+  std::vector<ArrowColumn> columns_;
+  // Resolved for the Reflection of the first appended message.
+  const Reflection* reflection_ = nullptr;
+  std::vector<Accessor> accessors_;
+  ColumnarDecoder decoder_;
+  int64_t num_rows_ = 0;
+};
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_ARROW_BATCH_BUILDER_H__
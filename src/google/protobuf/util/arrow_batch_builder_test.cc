@@ -0,0 +1,272 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "google/protobuf/util/arrow_batch_builder.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "absl/strings/string_view.h"
+#include "google/protobuf/dynamic_message.h"
+#include "google/protobuf/test_util.h"
+#include "google/protobuf/unittest.pb.h"
+#include "google/protobuf/unittest_proto3.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+using ::protobuf_unittest::TestAllTypes;
+
+const FieldDescriptor* Field(absl::string_view name) {
+  return TestAllTypes::descriptor()->FindFieldByName(name);
+}
+
+template <typename T>
+T ValueAt(const ArrowColumn& column, int64_t row) {
+  T value;
+  memcpy(&value, column.values().data() + row * sizeof(T), sizeof(T));
+  return value;
+}
+
+bool BitAt(absl::Span<const uint8_t> bitmap, int64_t row) {
+  return (bitmap[row / 8] >> (row % 8)) & 1;
+}
+
+absl::string_view StringAt(const ArrowColumn& column, int64_t row) {
+  return column.data().substr(
+      column.offsets()[row], column.offsets()[row + 1] - column.offsets()[row]);
+}
+
+class ArrowBatchBuilderTest : public ::testing::Test {
+ protected:
+  ArrowBatchBuilderTest() : builder_(TestAllTypes::descriptor()) {
+    EXPECT_TRUE(builder_.AddColumn(Field("optional_int64")));
+    EXPECT_TRUE(builder_.AddColumn(Field("optional_string")));
+    EXPECT_TRUE(builder_.AddColumn(Field("optional_bool")));
+    EXPECT_TRUE(builder_.AddColumn(Field("optional_nested_enum")));
+    EXPECT_TRUE(builder_.AddColumn(Field("default_double")));
+    EXPECT_TRUE(builder_.AddColumn(Field("optional_bytes")));
+  }
+
+  static TestAllTypes Record(int i) {
+    TestAllTypes record;
+    if (i % 3 != 0) record.set_optional_int64(i * 1000);
+    if (i % 4 != 0) {
+      record.set_optional_string(std::string(i % 5, 'a' + i % 26));
+    }
+    if (i % 2 == 0) record.set_optional_bool(i % 6 == 0);
+    record.set_optional_nested_enum(i % 3 == 0 ? TestAllTypes::BAZ
+                                               : TestAllTypes::FOO);
+    if (i % 5 == 0) record.set_default_double(i / 2.0);
+    return record;
+  }
+
+  void ExpectRows(int count) {
+    ASSERT_EQ(builder_.num_rows(), count);
+    const ArrowColumn& ids = builder_.column(0);
+    const ArrowColumn& strings = builder_.column(1);
+    const ArrowColumn& bools = builder_.column(2);
+    const ArrowColumn& enums = builder_.column(3);
+    const ArrowColumn& doubles = builder_.column(4);
+    const ArrowColumn& bytes = builder_.column(5);
+    ASSERT_EQ(strings.offsets().size(), count + 1);
+    for (int i = 0; i < count; ++i) {
+      SCOPED_TRACE(i);
+      EXPECT_EQ(BitAt(ids.validity(), i), i % 3 != 0);
+      if (i % 3 != 0) EXPECT_EQ(ValueAt<int64_t>(ids, i), i * 1000);
+      EXPECT_EQ(BitAt(strings.validity(), i), i % 4 != 0);
+      EXPECT_EQ(StringAt(strings, i),
+                i % 4 != 0 ? std::string(i % 5, 'a' + i % 26) : "");
+      EXPECT_EQ(BitAt(bools.validity(), i), i % 2 == 0);
+      if (i % 2 == 0) EXPECT_EQ(BitAt(bools.values(), i), i % 6 == 0);
+      EXPECT_EQ(ValueAt<int32_t>(enums, i),
+                i % 3 == 0 ? TestAllTypes::BAZ : TestAllTypes::FOO);
+      EXPECT_EQ(BitAt(doubles.validity(), i), i % 5 == 0);
+      EXPECT_EQ(ValueAt<double>(doubles, i), i % 5 == 0 ? i / 2.0 : 52e3);
+      EXPECT_FALSE(BitAt(bytes.validity(), i));
+      EXPECT_EQ(StringAt(bytes, i), "");
+    }
+    EXPECT_EQ(ids.null_count(), (count + 2) / 3);
+    EXPECT_EQ(strings.null_count(), (count + 3) / 4);
+    EXPECT_EQ(bytes.null_count(), count);
+    EXPECT_EQ(enums.null_count(), 0);
+  }
+
+  ArrowBatchBuilder builder_;
+};
+
+TEST_F(ArrowBatchBuilderTest, Schema) {
+  EXPECT_FALSE(builder_.AddColumn(Field("optional_int64")));
+  EXPECT_FALSE(builder_.AddColumn(Field("repeated_int32")));
+  EXPECT_FALSE(builder_.AddColumn(Field("optional_nested_message")));
+  ASSERT_EQ(builder_.schema().size(), 6);
+  EXPECT_EQ(builder_.schema()[0].name, "optional_int64");
+  EXPECT_EQ(ArrowTypeName(builder_.schema()[0].type), "int64");
+  EXPECT_EQ(ArrowTypeName(builder_.schema()[1].type), "utf8");
+  EXPECT_EQ(ArrowTypeName(builder_.schema()[2].type), "bool");
+  EXPECT_EQ(ArrowTypeName(builder_.schema()[3].type), "int32");
+  EXPECT_EQ(ArrowTypeName(builder_.schema()[4].type), "double");
+  EXPECT_EQ(ArrowTypeName(builder_.schema()[5].type), "binary");
+  for (const ArrowField& field : builder_.schema()) {
+    EXPECT_TRUE(field.nullable);
+  }
+}
+
+TEST_F(ArrowBatchBuilderTest, AddAllColumns) {
+  ArrowBatchBuilder builder(TestAllTypes::descriptor());
+  builder.AddAllColumns();
+  // Every singular field that is not a message.
+  int expected = 0;
+  for (int i = 0; i < TestAllTypes::descriptor()->field_count(); ++i) {
+    const FieldDescriptor* field = TestAllTypes::descriptor()->field(i);
+    if (!field->is_repeated() &&
+        field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) {
+      ++expected;
+    }
+  }
+  EXPECT_EQ(builder.num_columns(), expected);
+
+  TestAllTypes record;
+  TestUtil::SetAllFields(&record);
+  ASSERT_TRUE(builder.Append(record));
+  for (int i = 0; i < builder.num_columns(); ++i) {
+    // Only the last oneof member set by SetAllFields() is present.
+    const bool present =
+        Field(builder.schema()[i].name)->containing_oneof() == nullptr ||
+        builder.schema()[i].name == "oneof_bytes";
+    EXPECT_EQ(builder.column(i).null_count(), present ? 0 : 1)
+        << builder.schema()[i].name;
+  }
+}
+
+TEST_F(ArrowBatchBuilderTest, AppendMessages) {
+  std::vector<TestAllTypes> records;
+  for (int i = 0; i < 100; ++i) records.push_back(Record(i));
+  std::vector<const Message*> batch;
+  for (const TestAllTypes& record : records) batch.push_back(&record);
+  ASSERT_TRUE(builder_.AppendBatch(batch));
+  ExpectRows(100);
+}
+
+TEST_F(ArrowBatchBuilderTest, AppendSerialized) {
+  std::vector<std::string> data;
+  for (int i = 0; i < 100; ++i) data.push_back(Record(i).SerializeAsString());
+  std::vector<absl::string_view> records(data.begin(), data.end());
+  ASSERT_TRUE(builder_.AppendSerialized(
+      absl::MakeConstSpan(records).subspan(0, 37)));
+  ASSERT_TRUE(
+      builder_.AppendSerialized(absl::MakeConstSpan(records).subspan(37)));
+  ExpectRows(100);
+
+  records.push_back("\xff");
+  EXPECT_FALSE(builder_.AppendSerialized(records));
+  ExpectRows(100);
+}
+
+TEST_F(ArrowBatchBuilderTest, MixesMessagesAndSerializedRecords) {
+  for (int i = 0; i < 50; ++i) {
+    if (i % 2 == 0) {
+      ASSERT_TRUE(builder_.Append(Record(i)));
+    } else {
+      std::string data = Record(i).SerializeAsString();
+      ASSERT_TRUE(builder_.AppendSerialized({data}));
+    }
+  }
+  ExpectRows(50);
+}
+
+TEST_F(ArrowBatchBuilderTest, AppendDynamicMessages) {
+  DynamicMessageFactory factory;
+  const Message* prototype = factory.GetPrototype(TestAllTypes::descriptor());
+  for (int i = 0; i < 30; ++i) {
+    // Alternate between reflection implementations to exercise both the
+    // resolved accessors and the fallback.
+    if (i % 2 == 0) {
+      std::unique_ptr<Message> record(prototype->New());
+      ASSERT_TRUE(record->ParseFromString(Record(i).SerializeAsString()));
+      ASSERT_TRUE(builder_.Append(*record));
+    } else {
+      ASSERT_TRUE(builder_.Append(Record(i)));
+    }
+  }
+  ExpectRows(30);
+}
+
+TEST_F(ArrowBatchBuilderTest, ClearKeepsColumns) {
+  ASSERT_TRUE(builder_.Append(Record(1)));
+  EXPECT_FALSE(builder_.AddColumn(Field("optional_int32")));
+  builder_.Clear();
+  EXPECT_EQ(builder_.num_rows(), 0);
+  EXPECT_EQ(builder_.column(0).length(), 0);
+  EXPECT_TRUE(builder_.AddColumn(Field("optional_int32")));
+  for (int i = 0; i < 20; ++i) ASSERT_TRUE(builder_.Append(Record(i)));
+  ExpectRows(20);
+  EXPECT_EQ(builder_.column(6).null_count(), 20);
+}
+
+TEST(ArrowBatchBuilder, FieldsWithoutPresenceAreNotNullable) {
+  const Descriptor* descriptor = proto3_unittest::TestAllTypes::descriptor();
+  ArrowBatchBuilder builder(descriptor);
+  builder.AddAllColumns();
+  ASSERT_GT(builder.num_columns(), 0);
+  for (const ArrowField& field : builder.schema()) {
+    EXPECT_EQ(field.nullable,
+              descriptor->FindFieldByName(field.name)->has_presence())
+        << field.name;
+  }
+  EXPECT_FALSE(builder.schema()[0].nullable);
+
+  proto3_unittest::TestAllTypes record;
+  record.set_oneof_uint32(7);
+  ASSERT_TRUE(builder.Append(record));
+  ASSERT_TRUE(builder.AppendSerialized({record.SerializeAsString()}));
+  for (int i = 0; i < builder.num_columns(); ++i) {
+    const ArrowColumn& column = builder.column(i);
+    if (builder.schema()[i].nullable) {
+      EXPECT_EQ(column.null_count(),
+                builder.schema()[i].name == "oneof_uint32" ? 0 : 2);
+    } else {
+      EXPECT_EQ(column.null_count(), 0);
+      EXPECT_TRUE(column.validity().empty());
+    }
+  }
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,292 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "google/protobuf/util/columnar_decoder.h"
+
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "absl/log/absl_check.h"
+#include "absl/log/absl_log.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/wire_format_lite.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+using internal::WireFormatLite;
+
+namespace {
+
+size_t ValueSize(const FieldDescriptor* field) {
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+    case FieldDescriptor::CPPTYPE_UINT32:
+    case FieldDescriptor::CPPTYPE_FLOAT:
+    case FieldDescriptor::CPPTYPE_ENUM:
+      return 4;
+    case FieldDescriptor::CPPTYPE_INT64:
+    case FieldDescriptor::CPPTYPE_UINT64:
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      return 8;
+    case FieldDescriptor::CPPTYPE_BOOL:
+      return 1;
+    case FieldDescriptor::CPPTYPE_STRING:
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      return 0;
+  }
+  return 0;
+}
+
+template <typename T>
+void AppendValue(std::string* data, T value) {
+  char bytes[sizeof(T)];
+  memcpy(bytes, &value, sizeof(T));
+  data->append(bytes, sizeof(T));
+}
+
+}  // namespace
+
+ColumnarColumn::ColumnarColumn(const FieldDescriptor* field)
+    : field_(field),
+      value_size_(ValueSize(field)),
+      wire_type_(WireFormatLite::WireTypeForFieldType(
+          static_cast<WireFormatLite::FieldType>(field->type()))),
+      offsets_{0} {}
+
+void ColumnarColumn::StartRow() {
+  present_.push_back(false);
+  if (is_string()) return;
+  switch (field_->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      return AppendValue(&data_, field_->default_value_int32());
+    case FieldDescriptor::CPPTYPE_UINT32:
+      return AppendValue(&data_, field_->default_value_uint32());
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      return AppendValue(&data_, field_->default_value_float());
+    case FieldDescriptor::CPPTYPE_ENUM:
+      return AppendValue(&data_, static_cast<int32_t>(
+                                     field_->default_value_enum()->number()));
+    case FieldDescriptor::CPPTYPE_INT64:
+      return AppendValue(&data_, field_->default_value_int64());
+    case FieldDescriptor::CPPTYPE_UINT64:
+      return AppendValue(&data_, field_->default_value_uint64());
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      return AppendValue(&data_, field_->default_value_double());
+    case FieldDescriptor::CPPTYPE_BOOL:
+      return AppendValue(&data_, field_->default_value_bool());
+    case FieldDescriptor::CPPTYPE_STRING:
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      break;
+  }
+  ABSL_LOG(FATAL) << "Unsupported column type: " << field_->full_name();
+}
+
+void ColumnarColumn::FinishRow() {
+  if (!is_string()) return;
+  if (!present_.back()) data_.append(field_->default_value_string());
+  offsets_.push_back(static_cast<uint32_t>(data_.size()));
+}
+
+void ColumnarColumn::AbandonRow() {
+  present_.pop_back();
+  if (is_string()) {
+    data_.resize(offsets_.back());
+  } else {
+    data_.resize(data_.size() - value_size_);
+  }
+}
+
+template <typename T, int kFieldType>
+bool ColumnarColumn::ReadFixedWidth(io::CodedInputStream* input) {
+  T value;
+  if (!WireFormatLite::ReadPrimitive<
+          T, static_cast<WireFormatLite::FieldType>(kFieldType)>(input,
+                                                                 &value)) {
+    return false;
+  }
+  memcpy(&data_[data_.size() - sizeof(T)], &value, sizeof(T));
+  return true;
+}
+
+bool ColumnarColumn::Read(io::CodedInputStream* input) {
+  present_.back() = true;
+  switch (field_->type()) {
+    case FieldDescriptor::TYPE_INT32:
+      return ReadFixedWidth<int32_t, WireFormatLite::TYPE_INT32>(input);
+    case FieldDescriptor::TYPE_SINT32:
+      return ReadFixedWidth<int32_t, WireFormatLite::TYPE_SINT32>(input);
+    case FieldDescriptor::TYPE_SFIXED32:
+      return ReadFixedWidth<int32_t, WireFormatLite::TYPE_SFIXED32>(input);
+    case FieldDescriptor::TYPE_ENUM:
+      return ReadFixedWidth<int, WireFormatLite::TYPE_ENUM>(input);
+    case FieldDescriptor::TYPE_UINT32:
+      return ReadFixedWidth<uint32_t, WireFormatLite::TYPE_UINT32>(input);
+    case FieldDescriptor::TYPE_FIXED32:
+      return ReadFixedWidth<uint32_t, WireFormatLite::TYPE_FIXED32>(input);
+    case FieldDescriptor::TYPE_INT64:
+      return ReadFixedWidth<int64_t, WireFormatLite::TYPE_INT64>(input);
+    case FieldDescriptor::TYPE_SINT64:
+      return ReadFixedWidth<int64_t, WireFormatLite::TYPE_SINT64>(input);
+    case FieldDescriptor::TYPE_SFIXED64:
+      return ReadFixedWidth<int64_t, WireFormatLite::TYPE_SFIXED64>(input);
+    case FieldDescriptor::TYPE_UINT64:
+      return ReadFixedWidth<uint64_t, WireFormatLite::TYPE_UINT64>(input);
+    case FieldDescriptor::TYPE_FIXED64:
+      return ReadFixedWidth<uint64_t, WireFormatLite::TYPE_FIXED64>(input);
+    case FieldDescriptor::TYPE_FLOAT:
+      return ReadFixedWidth<float, WireFormatLite::TYPE_FLOAT>(input);
+    case FieldDescriptor::TYPE_DOUBLE:
+      return ReadFixedWidth<double, WireFormatLite::TYPE_DOUBLE>(input);
+    case FieldDescriptor::TYPE_BOOL:
+      return ReadFixedWidth<bool, WireFormatLite::TYPE_BOOL>(input);
+    case FieldDescriptor::TYPE_STRING:
+    case FieldDescriptor::TYPE_BYTES: {
+      // The last occurrence wins, so drop what this row already holds.
+      data_.resize(offsets_.back());
+      uint32_t length;
+      if (!input->ReadVarint32(&length)) return false;
+      if (static_cast<int64_t>(length) > input->BytesUntilLimit()) {
+        return false;
+      }
+      const size_t start = data_.size();
+      data_.resize(start + length);
+      return input->ReadRaw(&data_[start], static_cast<int>(length));
+    }
+    case FieldDescriptor::TYPE_MESSAGE:
+    case FieldDescriptor::TYPE_GROUP:
+      break;
+  }
+  return false;
+}
+
+void ColumnarColumn::Clear() {
+  data_.clear();
+  offsets_.resize(1);
+  present_.clear();
+}
+
+ColumnarDecoder::ColumnarDecoder(const Descriptor* descriptor)
+    : descriptor_(descriptor) {}
+
+bool ColumnarDecoder::AddColumn(const FieldDescriptor* field) {
+  if (num_rows_ != 0 || field->containing_type() != descriptor_ ||
+      field->is_repeated() ||
+      field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+    return false;
+  }
+  if (!column_by_number_.emplace(field->number(), num_columns()).second) {
+    return false;
+  }
+  columns_.emplace_back(field);
+  return true;
+}
+
+bool ColumnarDecoder::ParseFields(io::CodedInputStream* input) {
+  while (true) {
+    const uint32_t tag = input->ReadTag();
+    if (tag == 0) return input->ConsumedEntireMessage();
+    auto it = column_by_number_.find(WireFormatLite::GetTagFieldNumber(tag));
+    if (it != column_by_number_.end()) {
+      ColumnarColumn& column = columns_[it->second];
+      if (WireFormatLite::GetTagWireType(tag) == column.wire_type_) {
+        if (!column.Read(input)) return false;
+        continue;
+      }
+    }
+    if (!WireFormatLite::SkipField(input, tag)) return false;
+  }
+}
+
+bool ColumnarDecoder::ParseRow(io::CodedInputStream* input) {
+  for (ColumnarColumn& column : columns_) column.StartRow();
+  if (!ParseFields(input)) {
+    for (ColumnarColumn& column : columns_) column.AbandonRow();
+    return false;
+  }
+  for (ColumnarColumn& column : columns_) column.FinishRow();
+  ++num_rows_;
+  return true;
+}
+
+bool ColumnarDecoder::ParseRecord(absl::string_view data) {
+  if (data.size() > INT_MAX) return false;
+  io::CodedInputStream input(reinterpret_cast<const uint8_t*>(data.data()),
+                             static_cast<int>(data.size()));
+  return ParseRow(&input);
+}
+
+bool ColumnarDecoder::ParseDelimitedFromZeroCopyStream(
+    io::ZeroCopyInputStream* input, bool* clean_eof) {
+  io::CodedInputStream coded_input(input);
+  return ParseDelimitedFromCodedStream(&coded_input, clean_eof);
+}
+
+bool ColumnarDecoder::ParseDelimitedFromCodedStream(io::CodedInputStream* input,
+                                                    bool* clean_eof) {
+  if (clean_eof != nullptr) *clean_eof = false;
+  int start = input->CurrentPosition();
+
+  uint32_t size;
+  if (!input->ReadVarint32(&size)) {
+    if (clean_eof != nullptr) *clean_eof = input->CurrentPosition() == start;
+    return false;
+  }
+  int position_after_size = input->CurrentPosition();
+
+  io::CodedInputStream::Limit limit = input->PushLimit(static_cast<int>(size));
+  if (!ParseRow(input)) return false;
+  if (input->CurrentPosition() - position_after_size !=
+      static_cast<int>(size)) {
+    return false;
+  }
+  input->PopLimit(limit);
+  return true;
+}
+
+void ColumnarDecoder::Clear() {
+  for (ColumnarColumn& column : columns_) column.Clear();
+  num_rows_ = 0;
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
@@ -0,0 +1,171 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// Decodes streams of same-type records straight into per-field columns,
+// without building a message object for each record.
+//
+// Example:
+//   ColumnarDecoder decoder(Record::descriptor());
+//   decoder.AddColumn(Record::descriptor()->FindFieldByName("id"));
+//   decoder.AddColumn(Record::descriptor()->FindFieldByName("name"));
+//   bool clean_eof;
+//   while (decoder.ParseDelimitedFromZeroCopyStream(&input, &clean_eof)) {}
+//   absl::Span<const int64_t> ids = decoder.column(0).values<int64_t>();
+//   absl::string_view name = decoder.column(1).string_value(row);
+
+#ifndef GOOGLE_PROTOBUF_UTIL_COLUMNAR_DECODER_H__
+#define GOOGLE_PROTOBUF_UTIL_COLUMNAR_DECODER_H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/log/absl_check.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+// The values of one field across all decoded records.  Row `i` holds the
+// value of the field in the `i`th record, or the field's default value if the
+// record did not set it.
+class PROTOBUF_EXPORT ColumnarColumn {
+ public:
+  explicit ColumnarColumn(const FieldDescriptor* field);
+
+  const FieldDescriptor* field() const { return field_; }
+
+  // Whether row `row` had the field set on the wire.
+  bool has_value(int row) const { return present_[row]; }
+
+  // Fixed-width values, one per row.  `T` must match the field's C++ type
+  // (int32_t for enums).  Not available for string and bytes fields.
+  template <typename T>
+  absl::Span<const T> values() const {
+    ABSL_DCHECK_EQ(sizeof(T), value_size_);
+    return absl::MakeConstSpan(reinterpret_cast<const T*>(data_.data()),
+                               data_.size() / sizeof(T));
+  }
+
+  // String and bytes fields keep all values back to back in `string_data()`;
+  // row `i` spans [offsets()[i], offsets()[i + 1]).
+  absl::string_view string_data() const { return data_; }
+  absl::Span<const uint32_t> offsets() const { return offsets_; }
+  absl::string_view string_value(int row) const {
+    return absl::string_view(data_).substr(
+        offsets_[row], offsets_[row + 1] - offsets_[row]);
+  }
+
+ private:
+  friend class ColumnarDecoder;
+
+  bool is_string() const { return value_size_ == 0; }
+  void StartRow();
+  void FinishRow();
+  void AbandonRow();
+  // Reads one value of the field, whose tag has already been consumed.
+  bool Read(io::CodedInputStream* input);
+  template <typename T, int kFieldType>
+  bool ReadFixedWidth(io::CodedInputStream* input);
+  void Clear();
+
+  const FieldDescriptor* field_;
+  size_t value_size_;  // 0 for string and bytes fields.
+  int wire_type_;
+  std::string data_;
+  std::vector<uint32_t> offsets_;
+  std::vector<bool> present_;
+};
+
+// Decodes records of one message type into columns for a selected set of
+// singular scalar, enum, string and bytes fields.  All other fields, and
+// unknown fields, are skipped without being decoded.
+//
+// As with regular parsing, the last occurrence of a field in a record wins.
+class PROTOBUF_EXPORT ColumnarDecoder {
+ public:
+  explicit ColumnarDecoder(const Descriptor* descriptor);
+  ColumnarDecoder(const ColumnarDecoder&) = delete;
+  ColumnarDecoder& operator=(const ColumnarDecoder&) = delete;
+
+  // Adds a column for `field`, which must belong to the decoded message
+  // type.  Returns false for repeated, message and group fields, and for
+  // fields that already have a column.  Columns must be added before any
+  // record is decoded.
+  bool AddColumn(const FieldDescriptor* field);
+
+  // Decodes one serialized record and appends it as a new row.  On failure
+  // no row is added.
+  bool ParseRecord(absl::string_view data);
+
+  // Like util::ParseDelimitedFromZeroCopyStream(), but appends the record as
+  // a new row instead of merging it into a message.
+  bool ParseDelimitedFromZeroCopyStream(io::ZeroCopyInputStream* input,
+                                        bool* clean_eof);
+  bool ParseDelimitedFromCodedStream(io::CodedInputStream* input,
+                                     bool* clean_eof);
+
+  const Descriptor* descriptor() const { return descriptor_; }
+  int num_rows() const { return num_rows_; }
+  int num_columns() const { return static_cast<int>(columns_.size()); }
+  const ColumnarColumn& column(int index) const { return columns_[index]; }
+
+  // Removes all rows, keeping the columns and their allocated capacity.
+  void Clear();
+
+ private:
+  // Reads one record from `input` up to its limit or end of stream and
+  // appends it as a row.
+  bool ParseRow(io::CodedInputStream* input);
+  bool ParseFields(io::CodedInputStream* input);
+
+  const Descriptor* descriptor_;
+  std::vector<ColumnarColumn> columns_;
+  absl::flat_hash_map<int, int> column_by_number_;
+  int num_rows_ = 0;
+};
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_COLUMNAR_DECODER_H__
@@ -0,0 +1,153 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "google/protobuf/util/columnar_decoder.h"
+
+#include <cstdint>
+#include <string>
+
+#include <gtest/gtest.h>
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/test_util.h"
+#include "google/protobuf/unittest.pb.h"
+#include "google/protobuf/util/delimited_message_util.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+using ::protobuf_unittest::TestAllTypes;
+
+const FieldDescriptor* Field(absl::string_view name) {
+  return TestAllTypes::descriptor()->FindFieldByName(name);
+}
+
+class ColumnarDecoderTest : public ::testing::Test {
+ protected:
+  ColumnarDecoderTest() : decoder_(TestAllTypes::descriptor()) {
+    EXPECT_TRUE(decoder_.AddColumn(Field("optional_int64")));
+    EXPECT_TRUE(decoder_.AddColumn(Field("optional_string")));
+    EXPECT_TRUE(decoder_.AddColumn(Field("default_int32")));
+    EXPECT_TRUE(decoder_.AddColumn(Field("optional_nested_enum")));
+    EXPECT_TRUE(decoder_.AddColumn(Field("optional_double")));
+  }
+
+  ColumnarDecoder decoder_;
+};
+
+TEST_F(ColumnarDecoderTest, RejectsUnsupportedFields) {
+  EXPECT_FALSE(decoder_.AddColumn(Field("optional_int64")));
+  EXPECT_FALSE(decoder_.AddColumn(Field("repeated_int32")));
+  EXPECT_FALSE(decoder_.AddColumn(Field("optional_nested_message")));
+  EXPECT_FALSE(decoder_.AddColumn(
+      protobuf_unittest::TestRequired::descriptor()->FindFieldByName("a")));
+  EXPECT_EQ(decoder_.num_columns(), 5);
+}
+
+TEST_F(ColumnarDecoderTest, DecodesDelimitedStream) {
+  std::string data;
+  {
+    io::StringOutputStream output(&data);
+    for (int i = 0; i < 100; ++i) {
+      TestAllTypes record;
+      TestUtil::SetAllFields(&record);
+      record.set_optional_int64(i);
+      record.set_optional_string(std::string(i % 7, 'a' + i % 26));
+      if (i % 2 == 0) record.clear_default_int32();
+      record.set_optional_nested_enum(i % 3 == 0 ? TestAllTypes::BAZ
+                                                 : TestAllTypes::FOO);
+      EXPECT_TRUE(SerializeDelimitedToZeroCopyStream(record, &output));
+    }
+  }
+
+  io::ArrayInputStream input(data.data(), data.size(), /*block_size=*/13);
+  bool clean_eof;
+  while (decoder_.ParseDelimitedFromZeroCopyStream(&input, &clean_eof)) {
+  }
+  EXPECT_TRUE(clean_eof);
+  ASSERT_EQ(decoder_.num_rows(), 100);
+
+  auto ids = decoder_.column(0).values<int64_t>();
+  auto defaults = decoder_.column(2).values<int32_t>();
+  auto enums = decoder_.column(3).values<int32_t>();
+  auto doubles = decoder_.column(4).values<double>();
+  const ColumnarColumn& strings = decoder_.column(1);
+  ASSERT_EQ(ids.size(), 100);
+  ASSERT_EQ(strings.offsets().size(), 101);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(ids[i], i);
+    EXPECT_EQ(strings.string_value(i), std::string(i % 7, 'a' + i % 26));
+    EXPECT_EQ(decoder_.column(2).has_value(i), i % 2 != 0);
+    EXPECT_EQ(defaults[i], i % 2 == 0 ? 41 : 401);
+    EXPECT_EQ(enums[i], i % 3 == 0 ? TestAllTypes::BAZ : TestAllTypes::FOO);
+    EXPECT_EQ(doubles[i], 112);
+  }
+}
+
+TEST_F(ColumnarDecoderTest, LastValueWins) {
+  TestAllTypes first;
+  first.set_optional_int64(1);
+  first.set_optional_string("first");
+  TestAllTypes second;
+  second.set_optional_int64(2);
+  second.set_optional_string("second");
+  ASSERT_TRUE(decoder_.ParseRecord(first.SerializeAsString() +
+                                   second.SerializeAsString()));
+  ASSERT_TRUE(decoder_.ParseRecord(first.SerializeAsString()));
+
+  EXPECT_EQ(decoder_.column(0).values<int64_t>()[0], 2);
+  EXPECT_EQ(decoder_.column(1).string_value(0), "second");
+  EXPECT_EQ(decoder_.column(1).string_value(1), "first");
+  EXPECT_EQ(decoder_.column(1).string_data(), "secondfirst");
+}
+
+TEST_F(ColumnarDecoderTest, MalformedRecordAddsNoRow) {
+  TestAllTypes record;
+  record.set_optional_int64(7);
+  record.set_optional_string("value");
+  ASSERT_TRUE(decoder_.ParseRecord(record.SerializeAsString()));
+
+  std::string data = record.SerializeAsString();
+  EXPECT_FALSE(decoder_.ParseRecord(data.substr(0, data.size() - 1)));
+  EXPECT_EQ(decoder_.num_rows(), 1);
+  EXPECT_EQ(decoder_.column(0).values<int64_t>().size(), 1);
+  EXPECT_EQ(decoder_.column(1).string_data(), "value");
+
+  decoder_.Clear();
+  EXPECT_EQ(decoder_.num_rows(), 0);
+  EXPECT_TRUE(decoder_.column(1).string_data().empty());
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
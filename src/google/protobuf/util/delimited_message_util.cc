@@ -33,11 +33,80 @@
 
 #include "google/protobuf/util/delimited_message_util.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/crc/crc32c.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/types/span.h"
 #include "google/protobuf/io/coded_stream.h"
 
 namespace google {
 namespace protobuf {
 namespace util {
+namespace {
+
+// A varint32 is at most 5 bytes.
+constexpr int kMaxVarint32Size = 5;
+
+// Returns the checksum stored in a frame: the CRC32C of the size varint
+// followed by the payload.
+uint32_t FrameChecksum(uint32_t size, absl::string_view payload) {
+  uint8_t header[kMaxVarint32Size];
+  uint8_t* header_end =
+      io::CodedOutputStream::WriteVarint32ToArray(size, header);
+  absl::crc32c_t crc = absl::ComputeCrc32c(absl::string_view(
+      reinterpret_cast<const char*>(header), header_end - header));
+  return static_cast<uint32_t>(absl::ExtendCrc32c(crc, payload));
+}
+
+// The number of messages whose sizes are computed by one executor task.
+constexpr size_t kMessagesPerSizeTask = 1024;
+
+// Computes and caches the sizes of a slice of a batch.
+struct SizeTask {
+  absl::Span<const MessageLite* const> messages;
+  absl::BlockingCounter* done;
+  bool too_large = false;
+};
+
+bool ComputeSizes(absl::Span<const MessageLite* const> messages) {
+  for (const MessageLite* message : messages) {
+    if (message->ByteSizeLong() > INT_MAX) return false;
+  }
+  return true;
+}
+
+void RunSizeTask(void* arg) {
+  SizeTask* task = static_cast<SizeTask*>(arg);
+  task->too_large = !ComputeSizes(task->messages);
+  task->done->DecrementCount();
+}
+
+bool ComputeSizes(absl::Span<const MessageLite* const> messages,
+                  internal::Executor executor) {
+  if (executor == nullptr || messages.size() <= kMessagesPerSizeTask) {
+    return ComputeSizes(messages);
+  }
+  const size_t task_count =
+      (messages.size() + kMessagesPerSizeTask - 1) / kMessagesPerSizeTask;
+  absl::BlockingCounter done(static_cast<int>(task_count));
+  std::vector<SizeTask> tasks(task_count);
+  for (size_t i = 0; i < task_count; ++i) {
+    tasks[i].messages = messages.subspan(i * kMessagesPerSizeTask,
+                                         kMessagesPerSizeTask);
+    tasks[i].done = &done;
+    executor(&RunSizeTask, &tasks[i]);
+  }
+  done.Wait();
+  return std::none_of(tasks.begin(), tasks.end(),
+                      [](const SizeTask& task) { return task.too_large; });
+}
+
+}  // namespace
 
 bool SerializeDelimitedToFileDescriptor(const MessageLite& message,
                                         int file_descriptor) {
@@ -124,6 +193,113 @@ bool SerializeDelimitedToCodedStream(const MessageLite& message,
   return true;
 }
 
+bool SerializeDelimitedToZeroCopyStream(
+    absl::Span<const MessageLite* const> messages,
+    io::ZeroCopyOutputStream* output, internal::Executor executor) {
+  io::CodedOutputStream coded_output(output);
+  return SerializeDelimitedToCodedStream(messages, &coded_output, executor);
+}
+
+bool SerializeDelimitedToCodedStream(
+    absl::Span<const MessageLite* const> messages,
+    io::CodedOutputStream* output, internal::Executor executor) {
+  if (!ComputeSizes(messages, executor)) return false;
+
+  // All sizes are cached now, so each message is written straight into the
+  // stream's buffer, which flushes itself as it fills up.
+  io::EpsCopyOutputStream* stream = output->EpsCopy();
+  uint8_t* ptr = output->Cur();
+  for (const MessageLite* message : messages) {
+    ptr = stream->EnsureSpace(ptr);
+    ptr = io::CodedOutputStream::WriteVarint32ToArray(
+        static_cast<uint32_t>(message->GetCachedSize()), ptr);
+    ptr = message->_InternalSerialize(ptr, stream);
+  }
+  output->SetCur(ptr);
+  return !output->HadError();
+}
+
+bool SerializeFramedToZeroCopyStream(const MessageLite& message,
+                                     io::ZeroCopyOutputStream* output) {
+  io::CodedOutputStream coded_output(output);
+  return SerializeFramedToCodedStream(message, &coded_output);
+}
+
+bool SerializeFramedToCodedStream(const MessageLite& message,
+                                  io::CodedOutputStream* output) {
+  size_t size = message.ByteSizeLong();
+  if (size > INT_MAX - kMaxVarint32Size - 4) return false;
+  uint32_t size32 = static_cast<uint32_t>(size);
+  int frame_size =
+      static_cast<int>(io::CodedOutputStream::VarintSize32(size32)) + 4 +
+      static_cast<int>(size);
+
+  uint8_t* buffer = output->GetDirectBufferForNBytesAndAdvance(frame_size);
+  if (buffer != nullptr) {
+    // The whole frame fits in one buffer: serialize the payload in place
+    // behind the header, then checksum it while it is still hot.
+    uint8_t* checksum = io::CodedOutputStream::WriteVarint32ToArray(
+        size32, buffer);
+    uint8_t* payload = checksum + 4;
+    message.SerializeWithCachedSizesToArray(payload);
+    io::CodedOutputStream::WriteLittleEndian32ToArray(
+        FrameChecksum(size32, absl::string_view(
+                                  reinterpret_cast<const char*>(payload),
+                                  size)),
+        checksum);
+    return true;
+  }
+
+  // The checksum precedes the payload, so a frame spanning buffers has to be
+  // serialized to a flat buffer first.
+  std::string payload;
+  if (!message.SerializeWithCachedSizesToString(&payload)) return false;
+  output->WriteVarint32(size32);
+  output->WriteLittleEndian32(FrameChecksum(size32, payload));
+  output->WriteRaw(payload.data(), static_cast<int>(payload.size()));
+  return !output->HadError();
+}
+
+bool ParseFramedFromZeroCopyStream(MessageLite* message,
+                                   io::ZeroCopyInputStream* input,
+                                   bool* clean_eof) {
+  io::CodedInputStream coded_input(input);
+  return ParseFramedFromCodedStream(message, &coded_input, clean_eof);
+}
+
+bool ParseFramedFromCodedStream(MessageLite* message,
+                                io::CodedInputStream* input,
+                                bool* clean_eof) {
+  if (clean_eof != nullptr) *clean_eof = false;
+  int start = input->CurrentPosition();
+
+  uint32_t size;
+  if (!input->ReadVarint32(&size)) {
+    if (clean_eof != nullptr) *clean_eof = input->CurrentPosition() == start;
+    return false;
+  }
+  if (size > static_cast<uint32_t>(INT_MAX)) return false;
+  uint32_t expected;
+  if (!input->ReadLittleEndian32(&expected)) return false;
+
+  // Fast path: the payload is contiguous in the stream's buffer, so checksum
+  // and parse it there without copying.
+  const void* data;
+  int available;
+  if (input->GetDirectBufferPointer(&data, &available) &&
+      available >= static_cast<int>(size)) {
+    absl::string_view payload(static_cast<const char*>(data), size);
+    if (FrameChecksum(size, payload) != expected) return false;
+    if (!message->MergeFromString(payload)) return false;
+    return input->Skip(static_cast<int>(size));
+  }
+
+  std::string payload;
+  if (!input->ReadString(&payload, static_cast<int>(size))) return false;
+  if (FrameChecksum(size, payload) != expected) return false;
+  return message->MergeFromString(payload);
+}
+
 }  // namespace util
 }  // namespace protobuf
 }  // namespace google
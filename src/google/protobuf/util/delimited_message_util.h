@@ -36,9 +36,11 @@
 
 #include <ostream>
 
+#include "absl/types/span.h"
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl.h"
 #include "google/protobuf/message_lite.h"
+#include "google/protobuf/port.h"
 
 // Must be included last.
 #include "google/protobuf/port_def.inc"
@@ -99,6 +101,52 @@ bool PROTOBUF_EXPORT SerializeDelimitedToZeroCopyStream(
 bool PROTOBUF_EXPORT SerializeDelimitedToCodedStream(
     const MessageLite& message, io::CodedOutputStream* output);
 
+// Write each of |messages| as a size-delimited message, in order.  The output
+// is the same as calling SerializeDelimitedToZeroCopyStream() for each
+// message, but cheaper for many small messages: the sizes of all messages are
+// computed in one pass up front, and the messages are then serialized back to
+// back through a single CodedOutputStream, without setting up a stream or
+// checking for a direct buffer per message.
+//
+// If |executor| is not null, large batches have their sizes computed in
+// parallel on it, concurrently with the caller; the messages must then be
+// distinct objects.  Returns false
+// if a message is larger than 2GB or writing fails.
+bool PROTOBUF_EXPORT SerializeDelimitedToZeroCopyStream(
+    absl::Span<const MessageLite* const> messages,
+    io::ZeroCopyOutputStream* output,
+    internal::Executor executor = nullptr);
+
+bool PROTOBUF_EXPORT SerializeDelimitedToCodedStream(
+    absl::Span<const MessageLite* const> messages,
+    io::CodedOutputStream* output, internal::Executor executor = nullptr);
+
+// Framed variants of the functions above, for streams that need to detect
+// corruption. A framed message is a varint encoding the message size, a
+// little-endian fixed32 holding the CRC32C of the size varint and the message
+// bytes, and then the message itself.
+//
+// The checksum is computed with the CPU's CRC instructions where available.
+// When serializing, it is computed over the serialized bytes while they are
+// still in cache; when parsing, the message bytes are checksummed in place in
+// the stream's buffer and only merged into |message| if the checksum matches,
+// so a corrupted frame never modifies |message|. Frames that span buffer
+// boundaries are copied once into a temporary buffer first.
+//
+// |clean_eof| has the same meaning as for ParseDelimitedFromZeroCopyStream().
+bool PROTOBUF_EXPORT SerializeFramedToZeroCopyStream(
+    const MessageLite& message, io::ZeroCopyOutputStream* output);
+
+bool PROTOBUF_EXPORT SerializeFramedToCodedStream(
+    const MessageLite& message, io::CodedOutputStream* output);
+
+bool PROTOBUF_EXPORT ParseFramedFromZeroCopyStream(
+    MessageLite* message, io::ZeroCopyInputStream* input, bool* clean_eof);
+
+bool PROTOBUF_EXPORT ParseFramedFromCodedStream(MessageLite* message,
+                                                io::CodedInputStream* input,
+                                                bool* clean_eof);
+
 }  // namespace util
 }  // namespace protobuf
 }  // namespace google
@@ -34,9 +34,13 @@
 #include "google/protobuf/util/delimited_message_util.h"
 
 #include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "google/protobuf/testing/googletest.h"
 #include <gtest/gtest.h>
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include "google/protobuf/test_util.h"
 #include "google/protobuf/unittest.pb.h"
 
@@ -111,6 +115,142 @@ TEST(DelimitedMessageUtilTest, FailsAtEndOfStream) {
   }
 }
 
+TEST(DelimitedMessageUtilTest, DelimitedMessageBatch) {
+  std::vector<protobuf_unittest::TestAllTypes> messages(3000);
+  for (size_t i = 0; i < messages.size(); ++i) {
+    messages[i].set_optional_int32(static_cast<int32_t>(i));
+    if (i % 100 == 0) TestUtil::SetAllFields(&messages[i]);
+  }
+  std::vector<const MessageLite*> pointers;
+  std::string expected;
+  {
+    io::StringOutputStream zstream(&expected);
+    for (const auto& message : messages) {
+      pointers.push_back(&message);
+      EXPECT_TRUE(SerializeDelimitedToZeroCopyStream(message, &zstream));
+    }
+  }
+
+  auto run_inline = [](void (*task)(void*), void* arg) { task(arg); };
+  auto run_on_thread = [](void (*task)(void*), void* arg) {
+    std::thread(task, arg).detach();
+  };
+  for (internal::Executor executor :
+       {internal::Executor{nullptr}, internal::Executor{run_inline},
+        internal::Executor{run_on_thread}}) {
+    for (auto& message : messages) message.Clear();
+    for (size_t i = 0; i < messages.size(); ++i) {
+      messages[i].set_optional_int32(static_cast<int32_t>(i));
+      if (i % 100 == 0) TestUtil::SetAllFields(&messages[i]);
+    }
+    std::string data;
+    {
+      io::StringOutputStream zstream(&data);
+      io::CodedOutputStream coded(&zstream);
+      EXPECT_TRUE(SerializeDelimitedToCodedStream(pointers, &coded, executor));
+    }
+    EXPECT_EQ(data, expected);
+  }
+
+  std::string data;
+  io::StringOutputStream zstream(&data);
+  EXPECT_TRUE(SerializeDelimitedToZeroCopyStream({}, &zstream));
+  EXPECT_TRUE(data.empty());
+}
+
+TEST(DelimitedMessageUtilTest, FramedMessages) {
+  std::string data;
+
+  {
+    io::StringOutputStream zstream(&data);
+    protobuf_unittest::TestAllTypes message1;
+    TestUtil::SetAllFields(&message1);
+    EXPECT_TRUE(SerializeFramedToZeroCopyStream(message1, &zstream));
+
+    protobuf_unittest::TestPackedTypes message2;
+    TestUtil::SetPackedFields(&message2);
+    EXPECT_TRUE(SerializeFramedToZeroCopyStream(message2, &zstream));
+  }
+
+  // Read the frames back once from a single buffer and once from buffers
+  // small enough that every frame spans several of them.
+  for (int block_size : {-1, 7}) {
+    SCOPED_TRACE(block_size);
+    bool clean_eof;
+    io::ArrayInputStream zstream(data.data(), static_cast<int>(data.size()),
+                                 block_size);
+
+    protobuf_unittest::TestAllTypes message1;
+    clean_eof = true;
+    EXPECT_TRUE(ParseFramedFromZeroCopyStream(&message1, &zstream, &clean_eof));
+    EXPECT_FALSE(clean_eof);
+    TestUtil::ExpectAllFieldsSet(message1);
+
+    protobuf_unittest::TestPackedTypes message2;
+    clean_eof = true;
+    EXPECT_TRUE(ParseFramedFromZeroCopyStream(&message2, &zstream, &clean_eof));
+    EXPECT_FALSE(clean_eof);
+    TestUtil::ExpectPackedFieldsSet(message2);
+
+    clean_eof = false;
+    EXPECT_FALSE(
+        ParseFramedFromZeroCopyStream(&message2, &zstream, &clean_eof));
+    EXPECT_TRUE(clean_eof);
+  }
+}
+
+TEST(DelimitedMessageUtilTest, FramedMessageSpanningOutputBuffers) {
+  protobuf_unittest::TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+
+  std::string data(message.ByteSizeLong() + 16, '\0');
+  int written;
+  {
+    io::ArrayOutputStream zstream(&data[0], static_cast<int>(data.size()), 5);
+    EXPECT_TRUE(SerializeFramedToZeroCopyStream(message, &zstream));
+    written = static_cast<int>(zstream.ByteCount());
+  }
+
+  io::ArrayInputStream zstream(data.data(), written);
+  protobuf_unittest::TestAllTypes parsed;
+  EXPECT_TRUE(ParseFramedFromZeroCopyStream(&parsed, &zstream, nullptr));
+  TestUtil::ExpectAllFieldsSet(parsed);
+}
+
+TEST(DelimitedMessageUtilTest, FramedMessageDetectsCorruption) {
+  protobuf_unittest::ForeignMessage message;
+  message.set_c(42);
+  message.set_d(24);
+
+  std::string data;
+  {
+    io::StringOutputStream zstream(&data);
+    EXPECT_TRUE(SerializeFramedToZeroCopyStream(message, &zstream));
+  }
+  // Size, checksum, then the four payload bytes.
+  ASSERT_EQ(data.size(), size_t{9});
+  ASSERT_EQ(data[0], 4);
+
+  for (size_t i = 0; i < data.size(); ++i) {
+    SCOPED_TRACE(i);
+    std::string corrupted = data;
+    corrupted[i] ^= 0x01;
+    for (int block_size : {-1, 1}) {
+      io::ArrayInputStream zstream(corrupted.data(),
+                                   static_cast<int>(corrupted.size()),
+                                   block_size);
+      protobuf_unittest::ForeignMessage parsed;
+      bool clean_eof = true;
+      EXPECT_FALSE(ParseFramedFromZeroCopyStream(&parsed, &zstream,
+                                                 &clean_eof));
+      EXPECT_FALSE(clean_eof);
+      // A frame that fails verification is never merged.
+      EXPECT_FALSE(parsed.has_c());
+      EXPECT_FALSE(parsed.has_d());
+    }
+  }
+}
+
 }  // namespace util
 }  // namespace protobuf
 }  // namespace google
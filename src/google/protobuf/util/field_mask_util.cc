@@ -30,9 +30,11 @@
 
 #include "google/protobuf/util/field_mask_util.h"
 
+#include <climits>
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/container/btree_map.h"
@@ -44,7 +46,11 @@
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/strip.h"
+#include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/message.h"
+#include "google/protobuf/unknown_field_set.h"
+#include "google/protobuf/wire_format.h"
+#include "google/protobuf/wire_format_lite.h"
 
 // Must be included last.
 #include "google/protobuf/port_def.inc"
@@ -181,6 +187,19 @@ void FieldMaskUtil::GetFieldMaskForAllFields(const Descriptor* descriptor,
   }
 }
 
+namespace field_mask_internal {
+// A node of a CompiledFieldMask.
+struct CompiledNode {
+  // True if the node's whole field is in the mask. For the root, true if the
+  // mask is empty.
+  bool leaf = true;
+  // The sub-trees of the fields of the node's message type, indexed by
+  // FieldDescriptor::index() and null for fields not in the mask. Empty for
+  // leaves.
+  std::vector<std::unique_ptr<CompiledNode>> children;
+};
+}  // namespace field_mask_internal
+
 namespace {
 // A FieldMaskTree represents a FieldMask in a tree structure. For example,
 // given a FieldMask "foo.bar,foo.baz,bar.baz", the FieldMaskTree will be:
@@ -233,26 +252,13 @@ class FieldMaskTree {
     MergeMessage(&root_, source, options, destination);
   }
 
-  // Add required field path of the message to this tree based on current tree
-  // structure. If a message is present in the tree, add the path of its
-  // required field to the tree. This is to make sure that after trimming a
-  // message with required fields are set, check IsInitialized() will not fail.
-  void AddRequiredFieldPath(const Descriptor* descriptor) {
-    // Do nothing if the tree is empty.
-    if (root_.children.empty()) {
-      return;
-    }
-    AddRequiredFieldPath(&root_, descriptor);
-  }
-
-  // Trims all fields not specified by this tree from the given message.
-  // Returns true if the message is modified.
-  bool TrimMessage(Message* message) {
-    // Do nothing if the tree is empty.
-    if (root_.children.empty()) {
-      return false;
-    }
-    return TrimMessage(&root_, message);
+  // Resolves this tree against `descriptor` into `out`. With `strict`, fails
+  // if a path names an unknown field, or has sub-paths below a field that is
+  // not a message or is a map. Otherwise such paths are ignored, or cover
+  // their whole field, respectively.
+  bool Compile(const Descriptor* descriptor, bool strict,
+               field_mask_internal::CompiledNode* out) const {
+    return Compile(&root_, descriptor, strict, out);
   }
 
  private:
@@ -284,15 +290,8 @@ class FieldMaskTree {
                     const FieldMaskUtil::MergeOptions& options,
                     Message* destination);
 
-  // Add required field path of the message to this tree based on current tree
-  // structure. If a message is present in the tree, add the path of its
-  // required field to the tree. This is to make sure that after trimming a
-  // message with required fields are set, check IsInitialized() will not fail.
-  void AddRequiredFieldPath(Node* node, const Descriptor* descriptor);
-
-  // Trims all fields not specified by this sub-tree from the given message.
-  // Returns true if the message is actually modified
-  bool TrimMessage(const Node* node, Message* message);
+  static bool Compile(const Node* node, const Descriptor* descriptor,
+                      bool strict, field_mask_internal::CompiledNode* out);
 
   Node root_;
 };
@@ -447,6 +446,83 @@ void FieldMaskTree::MergeLeafNodesToTree(absl::string_view prefix,
   }
 }
 
+// Merges `field` of `source` into `destination` as a whole.
+void MergeField(const Message& source, const FieldDescriptor* field,
+                const FieldMaskUtil::MergeOptions& options,
+                Message* destination) {
+  const Reflection* source_reflection = source.GetReflection();
+  const Reflection* destination_reflection = destination->GetReflection();
+  if (!field->is_repeated()) {
+    switch (field->cpp_type()) {
+#define COPY_VALUE(TYPE, Name)                                              \
+  case FieldDescriptor::CPPTYPE_##TYPE: {                                   \
+    if (source_reflection->HasField(source, field)) {                       \
+      destination_reflection->Set##Name(                                    \
+          destination, field, source_reflection->Get##Name(source, field)); \
+    } else {                                                                \
+      destination_reflection->ClearField(destination, field);               \
+    }                                                                       \
+    break;                                                                  \
+  }
+      COPY_VALUE(BOOL, Bool)
+      COPY_VALUE(INT32, Int32)
+      COPY_VALUE(INT64, Int64)
+      COPY_VALUE(UINT32, UInt32)
+      COPY_VALUE(UINT64, UInt64)
+      COPY_VALUE(FLOAT, Float)
+      COPY_VALUE(DOUBLE, Double)
+      COPY_VALUE(ENUM, Enum)
+      COPY_VALUE(STRING, String)
+#undef COPY_VALUE
+      case FieldDescriptor::CPPTYPE_MESSAGE: {
+        if (options.replace_message_fields()) {
+          destination_reflection->ClearField(destination, field);
+        }
+        if (source_reflection->HasField(source, field)) {
+          destination_reflection->MutableMessage(destination, field)
+              ->MergeFrom(source_reflection->GetMessage(source, field));
+        }
+        break;
+      }
+    }
+  } else {
+    if (options.replace_repeated_fields()) {
+      destination_reflection->ClearField(destination, field);
+    }
+    switch (field->cpp_type()) {
+#define COPY_REPEATED_VALUE(TYPE, Name)                            \
+  case FieldDescriptor::CPPTYPE_##TYPE: {                          \
+    int size = source_reflection->FieldSize(source, field);        \
+    for (int i = 0; i < size; ++i) {                               \
+      destination_reflection->Add##Name(                           \
+          destination, field,                                      \
+          source_reflection->GetRepeated##Name(source, field, i)); \
+    }                                                              \
+    break;                                                         \
+  }
+      COPY_REPEATED_VALUE(BOOL, Bool)
+      COPY_REPEATED_VALUE(INT32, Int32)
+      COPY_REPEATED_VALUE(INT64, Int64)
+      COPY_REPEATED_VALUE(UINT32, UInt32)
+      COPY_REPEATED_VALUE(UINT64, UInt64)
+      COPY_REPEATED_VALUE(FLOAT, Float)
+      COPY_REPEATED_VALUE(DOUBLE, Double)
+      COPY_REPEATED_VALUE(ENUM, Enum)
+      COPY_REPEATED_VALUE(STRING, String)
+#undef COPY_REPEATED_VALUE
+      case FieldDescriptor::CPPTYPE_MESSAGE: {
+        int size = source_reflection->FieldSize(source, field);
+        for (int i = 0; i < size; ++i) {
+          destination_reflection->AddMessage(destination, field)
+              ->MergeFrom(
+                  source_reflection->GetRepeatedMessage(source, field, i));
+        }
+        break;
+      }
+    }
+  }
+}
+
 void FieldMaskTree::MergeMessage(const Node* node, const Message& source,
                                  const FieldMaskUtil::MergeOptions& options,
                                  Message* destination) {
@@ -477,144 +553,391 @@ void FieldMaskTree::MergeMessage(const Node* node, const Message& source,
                    destination_reflection->MutableMessage(destination, field));
       continue;
     }
-    if (!field->is_repeated()) {
-      switch (field->cpp_type()) {
-#define COPY_VALUE(TYPE, Name)                                              \
-  case FieldDescriptor::CPPTYPE_##TYPE: {                                   \
-    if (source_reflection->HasField(source, field)) {                       \
-      destination_reflection->Set##Name(                                    \
-          destination, field, source_reflection->Get##Name(source, field)); \
-    } else {                                                                \
-      destination_reflection->ClearField(destination, field);               \
-    }                                                                       \
-    break;                                                                  \
+    MergeField(source, field, options, destination);
   }
-        COPY_VALUE(BOOL, Bool)
-        COPY_VALUE(INT32, Int32)
-        COPY_VALUE(INT64, Int64)
-        COPY_VALUE(UINT32, UInt32)
-        COPY_VALUE(UINT64, UInt64)
-        COPY_VALUE(FLOAT, Float)
-        COPY_VALUE(DOUBLE, Double)
-        COPY_VALUE(ENUM, Enum)
-        COPY_VALUE(STRING, String)
-#undef COPY_VALUE
-        case FieldDescriptor::CPPTYPE_MESSAGE: {
-          if (options.replace_message_fields()) {
-            destination_reflection->ClearField(destination, field);
-          }
-          if (source_reflection->HasField(source, field)) {
-            destination_reflection->MutableMessage(destination, field)
-                ->MergeFrom(source_reflection->GetMessage(source, field));
-          }
-          break;
+}
+
+bool FieldMaskTree::Compile(const Node* node, const Descriptor* descriptor,
+                            bool strict,
+                            field_mask_internal::CompiledNode* out) {
+  out->leaf = node->children.empty();
+  if (out->leaf) {
+    return true;
+  }
+  out->children.resize(descriptor->field_count());
+  for (const auto& kv : node->children) {
+    const FieldDescriptor* field = descriptor->FindFieldByName(kv.first);
+    if (field == nullptr) {
+      if (strict) return false;
+      continue;
+    }
+    auto child = absl::make_unique<field_mask_internal::CompiledNode>();
+    if (!kv.second->children.empty()) {
+      if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE &&
+          !field->is_map()) {
+        if (!Compile(kv.second.get(), field->message_type(), strict,
+                     child.get())) {
+          return false;
         }
+      } else if (strict) {
+        return false;
       }
+    }
+    out->children[field->index()] = std::move(child);
+  }
+  return true;
+}
+
+using field_mask_internal::CompiledNode;
+
+// Compiles `mask` for `descriptor`, ignoring paths that do not resolve, the
+// way the FieldMaskUtil functions taking a FieldMask have always done.
+CompiledNode CompileLenient(const Descriptor* descriptor,
+                            const FieldMask& mask) {
+  FieldMaskTree tree;
+  tree.MergeFromFieldMask(mask);
+  CompiledNode root;
+  tree.Compile(descriptor, /*strict=*/false, &root);
+  return root;
+}
+
+// Returns the sub-tree of `node` for `field`, or nullptr if the field is not
+// in the mask.
+const CompiledNode* FindChild(const CompiledNode& node,
+                              const FieldDescriptor* field) {
+  if (field->is_extension()) return nullptr;
+  return node.children[field->index()].get();
+}
+
+// Merges the fields specified by a non-leaf node from one message to another.
+void MergeMessage(const CompiledNode& node, const Message& source,
+                  const FieldMaskUtil::MergeOptions& options,
+                  Message* destination) {
+  ABSL_DCHECK(!node.leaf);
+  const Reflection* source_reflection = source.GetReflection();
+  const Reflection* destination_reflection = destination->GetReflection();
+  const Descriptor* descriptor = source.GetDescriptor();
+  for (int i = 0; i < static_cast<int>(node.children.size()); ++i) {
+    const CompiledNode* child = node.children[i].get();
+    if (child == nullptr) continue;
+    const FieldDescriptor* field = descriptor->field(i);
+    if (child->leaf) {
+      MergeField(source, field, options, destination);
+    } else if (!field->is_repeated()) {
+      MergeMessage(*child, source_reflection->GetMessage(source, field),
+                   options,
+                   destination_reflection->MutableMessage(destination, field));
     } else {
       if (options.replace_repeated_fields()) {
         destination_reflection->ClearField(destination, field);
       }
-      switch (field->cpp_type()) {
-#define COPY_REPEATED_VALUE(TYPE, Name)                            \
-  case FieldDescriptor::CPPTYPE_##TYPE: {                          \
-    int size = source_reflection->FieldSize(source, field);        \
-    for (int i = 0; i < size; ++i) {                               \
-      destination_reflection->Add##Name(                           \
-          destination, field,                                      \
-          source_reflection->GetRepeated##Name(source, field, i)); \
-    }                                                              \
-    break;                                                         \
-  }
-        COPY_REPEATED_VALUE(BOOL, Bool)
-        COPY_REPEATED_VALUE(INT32, Int32)
-        COPY_REPEATED_VALUE(INT64, Int64)
-        COPY_REPEATED_VALUE(UINT32, UInt32)
-        COPY_REPEATED_VALUE(UINT64, UInt64)
-        COPY_REPEATED_VALUE(FLOAT, Float)
-        COPY_REPEATED_VALUE(DOUBLE, Double)
-        COPY_REPEATED_VALUE(ENUM, Enum)
-        COPY_REPEATED_VALUE(STRING, String)
-#undef COPY_REPEATED_VALUE
-        case FieldDescriptor::CPPTYPE_MESSAGE: {
-          int size = source_reflection->FieldSize(source, field);
-          for (int i = 0; i < size; ++i) {
-            destination_reflection->AddMessage(destination, field)
-                ->MergeFrom(
-                    source_reflection->GetRepeatedMessage(source, field, i));
-          }
-          break;
-        }
+      const int size = source_reflection->FieldSize(source, field);
+      for (int j = 0; j < size; ++j) {
+        MergeMessage(*child,
+                     source_reflection->GetRepeatedMessage(source, field, j),
+                     options,
+                     destination_reflection->AddMessage(destination, field));
       }
     }
   }
 }
 
-void FieldMaskTree::AddRequiredFieldPath(Node* node,
-                                         const Descriptor* descriptor) {
-  const int32_t field_count = descriptor->field_count();
-  for (int index = 0; index < field_count; ++index) {
-    const FieldDescriptor* field = descriptor->field(index);
-    if (field->is_required()) {
-      absl::string_view node_name = field->name();
-      std::unique_ptr<Node>& child = node->children[node_name];
-      if (child == nullptr) {
-        // Add required field path to the tree
-        child = absl::make_unique<Node>();
-      } else if (child->children.empty()) {
-        // If the required field is in the tree and does not have any children,
-        // do nothing.
-        continue;
-      }
-      // Add required field in the children to the tree if the field is message.
-      if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
-        AddRequiredFieldPath(child.get(), field->message_type());
-      }
-    } else if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
-      auto it = node->children.find(field->name());
-      if (it != node->children.end()) {
-        // Add required fields in the children to the
-        // tree if the field is a message and present in the tree.
-        Node* child = it->second.get();
-        if (!child->children.empty()) {
-          AddRequiredFieldPath(child, field->message_type());
-        }
-      }
+// Clears `field` of `message`. Returns true if it was set.
+bool ClearField(const Reflection* reflection, const FieldDescriptor* field,
+                Message* message) {
+  const bool present = field->is_repeated()
+                           ? reflection->FieldSize(*message, field) != 0
+                           : reflection->HasField(*message, field);
+  reflection->ClearField(message, field);
+  return present;
+}
+
+// Clears all but the required fields of `message`, and trims its required
+// message fields the same way. Messages without required fields are kept
+// whole. This is what TrimOptions::keep_required_fields() keeps of a message
+// that is not in the mask itself. Returns true if the message is modified.
+bool TrimToRequiredFields(Message* message) {
+  const Descriptor* descriptor = message->GetDescriptor();
+  bool has_required = false;
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    has_required |= descriptor->field(i)->is_required();
+  }
+  if (!has_required) {
+    return false;
+  }
+  const Reflection* reflection = message->GetReflection();
+  bool modified = false;
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    const FieldDescriptor* field = descriptor->field(i);
+    if (!field->is_required()) {
+      modified = ClearField(reflection, field, message) || modified;
+    } else if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE &&
+               reflection->HasField(*message, field)) {
+      modified =
+          TrimToRequiredFields(reflection->MutableMessage(message, field)) ||
+          modified;
     }
   }
+  return modified;
 }
 
-bool FieldMaskTree::TrimMessage(const Node* node, Message* message) {
-  ABSL_DCHECK(!node->children.empty());
+// Trims all fields not specified by a non-leaf node from the given message.
+// Returns true if the message is actually modified.
+bool TrimFields(const CompiledNode& node, bool keep_required,
+                Message* message) {
+  ABSL_DCHECK(!node.leaf);
   const Reflection* reflection = message->GetReflection();
   const Descriptor* descriptor = message->GetDescriptor();
-  const int32_t field_count = descriptor->field_count();
   bool modified = false;
-  for (int index = 0; index < field_count; ++index) {
-    const FieldDescriptor* field = descriptor->field(index);
-    auto it = node->children.find(field->name());
-    if (it == node->children.end()) {
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    const FieldDescriptor* field = descriptor->field(i);
+    const CompiledNode* child = node.children[i].get();
+    if (child == nullptr) {
+      if (!keep_required || !field->is_required()) {
+        modified = ClearField(reflection, field, message) || modified;
+      } else if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE &&
+                 reflection->HasField(*message, field)) {
+        modified =
+            TrimToRequiredFields(reflection->MutableMessage(message, field)) ||
+            modified;
+      }
+    } else if (!child->leaf) {
       if (field->is_repeated()) {
-        if (reflection->FieldSize(*message, field) != 0) {
-          modified = true;
-        }
-      } else {
-        if (reflection->HasField(*message, field)) {
-          modified = true;
+        const int size = reflection->FieldSize(*message, field);
+        for (int j = 0; j < size; ++j) {
+          modified = TrimFields(*child, keep_required,
+                                reflection->MutableRepeatedMessage(
+                                    message, field, j)) ||
+                     modified;
         }
+      } else if (reflection->HasField(*message, field)) {
+        modified = TrimFields(*child, keep_required,
+                              reflection->MutableMessage(message, field)) ||
+                   modified;
+      }
+    }
+  }
+  return modified;
+}
+
+size_t MaskedSubMessageSize(const CompiledNode& node,
+                            const FieldDescriptor* field,
+                            const Message& message,
+                            std::vector<size_t>* sizes);
+
+// Returns the serialized size of the fields of `message` specified by a
+// non-leaf node. The sizes of masked sub-messages are appended to `sizes` in
+// the order MaskedSerialize() visits them.
+size_t MaskedByteSize(const CompiledNode& node, const Message& message,
+                      std::vector<size_t>* sizes) {
+  ABSL_DCHECK(!node.leaf);
+  const Reflection* reflection = message.GetReflection();
+  std::vector<const FieldDescriptor*> fields;
+  reflection->ListFields(message, &fields);
+  size_t size = 0;
+  for (const FieldDescriptor* field : fields) {
+    const CompiledNode* child = FindChild(node, field);
+    if (child == nullptr) continue;
+    if (child->leaf) {
+      size += internal::WireFormat::FieldByteSize(field, message);
+      continue;
+    }
+    if (field->is_repeated()) {
+      const int count = reflection->FieldSize(message, field);
+      for (int i = 0; i < count; ++i) {
+        size += MaskedSubMessageSize(
+            *child, field, reflection->GetRepeatedMessage(message, field, i),
+            sizes);
       }
-      reflection->ClearField(message, field);
     } else {
-      if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
-        Node* child = it->second.get();
-        if (!child->children.empty() && reflection->HasField(*message, field)) {
-          bool nestedMessageChanged =
-              TrimMessage(child, reflection->MutableMessage(message, field));
-          modified = nestedMessageChanged || modified;
-        }
+      size += MaskedSubMessageSize(
+          *child, field, reflection->GetMessage(message, field), sizes);
+    }
+  }
+  return size;
+}
+
+size_t MaskedSubMessageSize(const CompiledNode& node,
+                            const FieldDescriptor* field,
+                            const Message& message,
+                            std::vector<size_t>* sizes) {
+  // Reserve the slot before recursing so that sizes are in visiting order.
+  const size_t slot = sizes->size();
+  sizes->push_back(0);
+  const size_t size = MaskedByteSize(node, message, sizes);
+  (*sizes)[slot] = size;
+  const size_t tag_size = internal::WireFormat::TagSize(
+      field->number(), field->type());
+  if (field->type() == FieldDescriptor::TYPE_GROUP) {
+    // TagSize() already accounts for the end tag of a group.
+    return tag_size + size;
+  }
+  return tag_size + internal::WireFormatLite::LengthDelimitedSize(size);
+}
+
+uint8_t* MaskedSerializeSubMessage(const CompiledNode& node,
+                                   const FieldDescriptor* field,
+                                   const Message& message,
+                                   const std::vector<size_t>& sizes,
+                                   size_t* next_size, uint8_t* target,
+                                   io::EpsCopyOutputStream* stream);
+
+// Writes the fields of `message` specified by a non-leaf node, using the
+// sizes computed by MaskedByteSize() starting at `sizes[*next_size]`.
+uint8_t* MaskedSerialize(const CompiledNode& node, const Message& message,
+                         const std::vector<size_t>& sizes, size_t* next_size,
+                         uint8_t* target, io::EpsCopyOutputStream* stream) {
+  const Reflection* reflection = message.GetReflection();
+  std::vector<const FieldDescriptor*> fields;
+  reflection->ListFields(message, &fields);
+  for (const FieldDescriptor* field : fields) {
+    const CompiledNode* child = FindChild(node, field);
+    if (child == nullptr) continue;
+    if (child->leaf) {
+      target = internal::WireFormat::InternalSerializeField(field, message,
+                                                             target, stream);
+      continue;
+    }
+    if (field->is_repeated()) {
+      const int count = reflection->FieldSize(message, field);
+      for (int i = 0; i < count; ++i) {
+        target = MaskedSerializeSubMessage(
+            *child, field, reflection->GetRepeatedMessage(message, field, i),
+            sizes, next_size, target, stream);
       }
+    } else {
+      target = MaskedSerializeSubMessage(*child, field,
+                                         reflection->GetMessage(message, field),
+                                         sizes, next_size, target, stream);
     }
   }
-  return modified;
+  return target;
+}
+
+uint8_t* MaskedSerializeSubMessage(const CompiledNode& node,
+                                   const FieldDescriptor* field,
+                                   const Message& message,
+                                   const std::vector<size_t>& sizes,
+                                   size_t* next_size, uint8_t* target,
+                                   io::EpsCopyOutputStream* stream) {
+  using internal::WireFormatLite;
+  const size_t size = sizes[(*next_size)++];
+  target = stream->EnsureSpace(target);
+  if (field->type() == FieldDescriptor::TYPE_GROUP) {
+    target = WireFormatLite::WriteTagToArray(
+        field->number(), WireFormatLite::WIRETYPE_START_GROUP, target);
+    target = MaskedSerialize(node, message, sizes, next_size, target, stream);
+    target = stream->EnsureSpace(target);
+    return WireFormatLite::WriteTagToArray(
+        field->number(), WireFormatLite::WIRETYPE_END_GROUP, target);
+  }
+  target = WireFormatLite::WriteTagToArray(
+      field->number(), WireFormatLite::WIRETYPE_LENGTH_DELIMITED, target);
+  target = io::CodedOutputStream::WriteVarint32ToArray(
+      static_cast<uint32_t>(size), target);
+  return MaskedSerialize(node, message, sizes, next_size, target, stream);
+}
+
+// Appends the fields of `message` specified by `root` to `output`. Returns
+// false, leaving `output` unchanged, if they would not fit in 2GB.
+bool SerializeMessage(const CompiledNode& root, const Message& message,
+                      std::string* output) {
+  // An empty mask keeps every field.
+  if (root.leaf) {
+    return message.AppendPartialToString(output);
+  }
+  std::vector<size_t> sizes;
+  const size_t size = MaskedByteSize(root, message, &sizes);
+  if (size > INT_MAX) return false;
+  const size_t old_size = output->size();
+  output->resize(old_size + size);
+  uint8_t* target = reinterpret_cast<uint8_t*>(&(*output)[old_size]);
+  io::EpsCopyOutputStream stream(
+      target, static_cast<int>(size),
+      io::CodedOutputStream::IsDefaultSerializationDeterministic());
+  size_t next_size = 0;
+  uint8_t* end =
+      MaskedSerialize(root, message, sizes, &next_size, target, &stream);
+  ABSL_DCHECK_EQ(end, target + size);
+  return true;
+}
+
+// Merges the fields specified by a node from the serialized `data` into
+// `message`. Other fields are skipped without being parsed.
+bool ParseMessage(const CompiledNode& node, absl::string_view data,
+                  const FieldMaskUtil::ParseOptions& options,
+                  Message* message) {
+  // An empty mask keeps every field.
+  if (node.leaf) {
+    return message->ParseFrom<MessageLite::kMergePartial>(data);
+  }
+  if (data.size() > INT_MAX) return false;
+  const Reflection* reflection = message->GetReflection();
+  const Descriptor* descriptor = message->GetDescriptor();
+
+  // Consecutive fields that are kept, or skipped, form contiguous runs of the
+  // input and are handed over in one piece.
+  enum class Run { kNone, kKeep, kSkip };
+  Run run = Run::kNone;
+  int run_start = 0;
+  auto flush = [&](int end) {
+    absl::string_view bytes = data.substr(run_start, end - run_start);
+    run_start = end;
+    switch (std::exchange(run, Run::kNone)) {
+      case Run::kNone:
+        return true;
+      case Run::kKeep:
+        return message->ParseFrom<MessageLite::kMergePartial>(bytes);
+      case Run::kSkip: {
+        if (!options.keep_skipped_as_unknown_fields()) return true;
+        io::CodedInputStream input(
+            reinterpret_cast<const uint8_t*>(bytes.data()),
+            static_cast<int>(bytes.size()));
+        return reflection->MutableUnknownFields(message)->MergeFromCodedStream(
+            &input);
+      }
+    }
+    return false;
+  };
+
+  io::CodedInputStream input(reinterpret_cast<const uint8_t*>(data.data()),
+                             static_cast<int>(data.size()));
+  while (true) {
+    const int start = input.CurrentPosition();
+    const uint32_t tag = input.ReadTag();
+    if (tag == 0) {
+      return input.ConsumedEntireMessage() && flush(start);
+    }
+    const FieldDescriptor* field = descriptor->FindFieldByNumber(
+        internal::WireFormatLite::GetTagFieldNumber(tag));
+    const CompiledNode* child =
+        field != nullptr ? FindChild(node, field) : nullptr;
+
+    if (child != nullptr && !child->leaf &&
+        field->type() == FieldDescriptor::TYPE_MESSAGE &&
+        internal::WireFormatLite::GetTagWireType(tag) ==
+            internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+      // Only some fields of this sub-message are wanted: descend into it.
+      uint32_t length;
+      if (!flush(start) || !input.ReadVarint32(&length)) return false;
+      const int payload = input.CurrentPosition();
+      if (!input.Skip(static_cast<int>(length))) return false;
+      Message* sub_message = field->is_repeated()
+                                 ? reflection->AddMessage(message, field)
+                                 : reflection->MutableMessage(message, field);
+      if (!ParseMessage(*child, data.substr(payload, length), options,
+                        sub_message)) {
+        return false;
+      }
+      run_start = input.CurrentPosition();
+      continue;
+    }
+
+    const Run kind = child != nullptr ? Run::kKeep : Run::kSkip;
+    if (kind != run && !flush(start)) return false;
+    run = kind;
+    if (!internal::WireFormatLite::SkipField(&input, tag)) return false;
+  }
 }
 
 }  // namespace
@@ -692,25 +1015,138 @@ void FieldMaskUtil::MergeMessageTo(const Message& source, const FieldMask& mask,
 }
 
 bool FieldMaskUtil::TrimMessage(const FieldMask& mask, Message* message) {
-  // Build a FieldMaskTree and walk through the tree to merge all specified
-  // fields.
-  FieldMaskTree tree;
-  tree.MergeFromFieldMask(mask);
-  return tree.TrimMessage(ABSL_DIE_IF_NULL(message));
+  CompiledNode root =
+      CompileLenient(ABSL_DIE_IF_NULL(message)->GetDescriptor(), mask);
+  // Do nothing if the mask is empty.
+  if (root.leaf) {
+    return false;
+  }
+  return TrimFields(root, /*keep_required=*/false, message);
 }
 
 bool FieldMaskUtil::TrimMessage(const FieldMask& mask, Message* message,
                                 const TrimOptions& options) {
-  // Build a FieldMaskTree and walk through the tree to merge all specified
-  // fields.
+  CompiledNode root =
+      CompileLenient(ABSL_DIE_IF_NULL(message)->GetDescriptor(), mask);
+  // Do nothing if the mask is empty.
+  if (root.leaf) {
+    return false;
+  }
+  // If keep_required_fields is true, required fields of a message present in
+  // the mask are kept even if the mask does not name them.
+  return TrimFields(root, options.keep_required_fields(), message);
+}
+
+bool FieldMaskUtil::SerializeWithFieldMask(const Message& message,
+                                           const FieldMask& mask,
+                                           std::string* output) {
+  CompiledNode root = CompileLenient(message.GetDescriptor(), mask);
+  output->clear();
+  return SerializeMessage(root, message, output);
+}
+
+bool FieldMaskUtil::ParseFromStringWithMask(absl::string_view data,
+                                            const FieldMask& mask,
+                                            Message* message) {
+  return ParseFromStringWithMask(data, mask, ParseOptions(), message);
+}
+
+bool FieldMaskUtil::ParseFromStringWithMask(absl::string_view data,
+                                            const FieldMask& mask,
+                                            const ParseOptions& options,
+                                            Message* message) {
+  CompiledNode root =
+      CompileLenient(ABSL_DIE_IF_NULL(message)->GetDescriptor(), mask);
+  message->Clear();
+  return ParseMessage(root, data, options, message);
+}
+
+CompiledFieldMask::CompiledFieldMask(const Descriptor* descriptor,
+                                     std::unique_ptr<CompiledNode> root)
+    : descriptor_(descriptor), root_(std::move(root)) {}
+
+CompiledFieldMask::~CompiledFieldMask() {}
+
+std::unique_ptr<CompiledFieldMask> CompiledFieldMask::Compile(
+    const Descriptor* descriptor, const FieldMask& mask) {
   FieldMaskTree tree;
   tree.MergeFromFieldMask(mask);
-  // If keep_required_fields is true, implicitly add required fields of
-  // a message present in the tree to prevent from trimming.
-  if (options.keep_required_fields()) {
-    tree.AddRequiredFieldPath(ABSL_DIE_IF_NULL(message->GetDescriptor()));
+  auto root = absl::make_unique<CompiledNode>();
+  if (!tree.Compile(ABSL_DIE_IF_NULL(descriptor), /*strict=*/true,
+                    root.get())) {
+    return nullptr;
+  }
+  return absl::WrapUnique(new CompiledFieldMask(descriptor, std::move(root)));
+}
+
+bool CompiledFieldMask::IsPathInFieldMask(absl::string_view path) const {
+  const Descriptor* descriptor = descriptor_;
+  const CompiledNode* node = root_.get();
+  if (node->leaf) {
+    return false;
+  }
+  for (absl::string_view field_name : absl::StrSplit(path, '.')) {
+    if (node->leaf) {
+      // A prefix of the path is in the mask.
+      return true;
+    }
+    const FieldDescriptor* field = descriptor->FindFieldByName(field_name);
+    if (field == nullptr) {
+      return false;
+    }
+    node = node->children[field->index()].get();
+    if (node == nullptr) {
+      return false;
+    }
+    descriptor = field->message_type();
+  }
+  return node->leaf;
+}
+
+void CompiledFieldMask::MergeMessageTo(
+    const Message& source, const FieldMaskUtil::MergeOptions& options,
+    Message* destination) const {
+  ABSL_CHECK(source.GetDescriptor() == descriptor_);
+  ABSL_CHECK(destination->GetDescriptor() == descriptor_);
+  // Do nothing if the mask is empty.
+  if (root_->leaf) {
+    return;
   }
-  return tree.TrimMessage(ABSL_DIE_IF_NULL(message));
+  MergeMessage(*root_, source, options, destination);
+}
+
+bool CompiledFieldMask::TrimMessage(Message* message) const {
+  return TrimMessage(message, FieldMaskUtil::TrimOptions());
+}
+
+bool CompiledFieldMask::TrimMessage(
+    Message* message, const FieldMaskUtil::TrimOptions& options) const {
+  ABSL_CHECK(ABSL_DIE_IF_NULL(message)->GetDescriptor() == descriptor_);
+  // Do nothing if the mask is empty.
+  if (root_->leaf) {
+    return false;
+  }
+  return TrimFields(*root_, options.keep_required_fields(), message);
+}
+
+bool CompiledFieldMask::SerializeWithFieldMask(const Message& message,
+                                               std::string* output) const {
+  ABSL_CHECK(message.GetDescriptor() == descriptor_);
+  output->clear();
+  return SerializeMessage(*root_, message, output);
+}
+
+bool CompiledFieldMask::ParseFromStringWithMask(absl::string_view data,
+                                                Message* message) const {
+  return ParseFromStringWithMask(data, FieldMaskUtil::ParseOptions(), message);
+}
+
+bool CompiledFieldMask::ParseFromStringWithMask(
+    absl::string_view data, const FieldMaskUtil::ParseOptions& options,
+    Message* message) const {
+  ABSL_CHECK(ABSL_DIE_IF_NULL(message)->GetDescriptor() == descriptor_);
+  message->Clear();
+  return ParseMessage(*root_, data, options, message);
 }
 
 }  // namespace util
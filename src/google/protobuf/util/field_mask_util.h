@@ -34,6 +34,7 @@
 #define GOOGLE_PROTOBUF_UTIL_FIELD_MASK_UTIL_H__
 
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -48,6 +49,9 @@
 namespace google {
 namespace protobuf {
 namespace util {
+namespace field_mask_internal {
+struct CompiledNode;
+}  // namespace field_mask_internal
 
 class PROTOBUF_EXPORT FieldMaskUtil {
   typedef google::protobuf::FieldMask FieldMask;
@@ -163,6 +167,9 @@ class PROTOBUF_EXPORT FieldMaskUtil {
   // "foo.bar" does NOT cover "foo", even if "bar" is the only child.
   static bool IsPathInFieldMask(absl::string_view path, const FieldMask& mask);
 
+  // The functions below build a tree of the mask's paths on every call. To
+  // apply the same mask many times, compile it once with CompiledFieldMask.
+
   class MergeOptions;
   // Merges fields specified in a FieldMask into another message.
   static void MergeMessageTo(const Message& source, const FieldMask& mask,
@@ -176,11 +183,34 @@ class PROTOBUF_EXPORT FieldMaskUtil {
 
   // Removes from 'message' any field that is not represented in the given
   // FieldMask with customized TrimOptions.
-  // If the FieldMask is empty, does nothing.
+  // If the FieldMask is empty, does nothing, even with keep_required_fields():
+  // an empty mask keeps every field rather than only the required ones.
   // Returns true if the message is modified.
   static bool TrimMessage(const FieldMask& mask, Message* message,
                           const TrimOptions& options);
 
+  // Serializes only the fields of `message` covered by `mask`, producing the
+  // same bytes as serializing a copy trimmed with TrimMessage(), but without
+  // making the copy. Unlike TrimMessage(), paths may also go through repeated
+  // messages. Unknown fields and extensions are not written unless the mask
+  // is empty, in which case the whole message is serialized. Returns false if
+  // the output would exceed 2GB.
+  static bool SerializeWithFieldMask(const Message& message,
+                                     const FieldMask& mask,
+                                     std::string* output);
+
+  class ParseOptions;
+  // Parses `data` into `message`, keeping only the fields covered by `mask`.
+  // Other fields are skipped by length without being parsed, so they cost no
+  // allocation.  An empty mask keeps every field.  Required fields are not
+  // checked, since the mask may exclude them.
+  static bool ParseFromStringWithMask(absl::string_view data,
+                                      const FieldMask& mask, Message* message);
+  static bool ParseFromStringWithMask(absl::string_view data,
+                                      const FieldMask& mask,
+                                      const ParseOptions& options,
+                                      Message* message);
+
  private:
   friend class SnakeCaseCamelCaseTest;
   // Converts a field name from snake_case to camelCase:
@@ -256,6 +286,89 @@ class PROTOBUF_EXPORT FieldMaskUtil::TrimOptions {
   bool keep_required_fields_;
 };
 
+class PROTOBUF_EXPORT FieldMaskUtil::ParseOptions {
+ public:
+  ParseOptions() : keep_skipped_as_unknown_fields_(false) {}
+  // By default fields outside the mask are dropped. If you instead want
+  // them kept as unknown fields, so that serializing the message reproduces
+  // them, set this flag to true.
+  void set_keep_skipped_as_unknown_fields(bool value) {
+    keep_skipped_as_unknown_fields_ = value;
+  }
+  bool keep_skipped_as_unknown_fields() const {
+    return keep_skipped_as_unknown_fields_;
+  }
+
+ private:
+  bool keep_skipped_as_unknown_fields_;
+};
+
+// A FieldMask compiled for one message type, with the fields of its paths
+// already looked up. It applies the mask without the per-call parsing of the
+// paths that the corresponding FieldMaskUtil functions do.
+//
+// A CompiledFieldMask is immutable, and may be shared by several threads.
+// The messages passed to it must be of the type it was compiled for.
+//
+// Example:
+//   static const CompiledFieldMask* const kMask =
+//       CompiledFieldMask::Compile<Foo>(mask).release();
+//   kMask->TrimMessage(&foo);
+class PROTOBUF_EXPORT CompiledFieldMask {
+  typedef google::protobuf::FieldMask FieldMask;
+
+ public:
+  // Compiles `mask` for messages of type `descriptor`. Returns nullptr if a
+  // path names a field that does not exist, or has sub-paths below a field
+  // that is not a message or is a map.
+  static std::unique_ptr<CompiledFieldMask> Compile(
+      const Descriptor* descriptor, const FieldMask& mask);
+  template <typename T>
+  static std::unique_ptr<CompiledFieldMask> Compile(const FieldMask& mask) {
+    return Compile(T::descriptor(), mask);
+  }
+
+  CompiledFieldMask(const CompiledFieldMask&) = delete;
+  CompiledFieldMask& operator=(const CompiledFieldMask&) = delete;
+  ~CompiledFieldMask();
+
+  const Descriptor* descriptor() const { return descriptor_; }
+
+  // Same as FieldMaskUtil::IsPathInFieldMask(), except that a path that does
+  // not name fields of the message type is never in the mask.
+  bool IsPathInFieldMask(absl::string_view path) const;
+
+  // Same as FieldMaskUtil::MergeMessageTo(). Unlike it, paths may go through
+  // repeated messages: each element of the source is merged, masked, into a
+  // new element of the destination.
+  void MergeMessageTo(const Message& source,
+                      const FieldMaskUtil::MergeOptions& options,
+                      Message* destination) const;
+
+  // Same as FieldMaskUtil::TrimMessage(). Unlike it, paths may go through
+  // repeated messages, which trims each of their elements.
+  bool TrimMessage(Message* message) const;
+  bool TrimMessage(Message* message,
+                   const FieldMaskUtil::TrimOptions& options) const;
+
+  // Same as FieldMaskUtil::SerializeWithFieldMask().
+  bool SerializeWithFieldMask(const Message& message,
+                              std::string* output) const;
+
+  // Same as FieldMaskUtil::ParseFromStringWithMask().
+  bool ParseFromStringWithMask(absl::string_view data, Message* message) const;
+  bool ParseFromStringWithMask(absl::string_view data,
+                               const FieldMaskUtil::ParseOptions& options,
+                               Message* message) const;
+
+ private:
+  CompiledFieldMask(const Descriptor* descriptor,
+                    std::unique_ptr<field_mask_internal::CompiledNode> root);
+
+  const Descriptor* const descriptor_;
+  const std::unique_ptr<const field_mask_internal::CompiledNode> root_;
+};
+
 }  // namespace util
 }  // namespace protobuf
 }  // namespace google
@@ -32,6 +32,8 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "google/protobuf/field_mask.pb.h"
@@ -827,6 +829,269 @@ TEST(FieldMaskUtilTest, TrimMessageReturnValue) {
   // supported.
 }
 
+TEST(FieldMaskUtilTest, SerializeWithFieldMask) {
+  NestedTestAllTypes source;
+  TestUtil::SetAllFields(source.mutable_payload());
+  TestUtil::SetAllFields(source.mutable_child()->mutable_payload());
+  source.mutable_child()->mutable_child()->mutable_payload()->set_optional_int32(
+      7);
+  TestUtil::SetAllFields(source.add_repeated_child()->mutable_payload());
+  TestUtil::SetAllFields(source.add_repeated_child()->mutable_payload());
+
+  FieldMask mask;
+  FieldMaskUtil::FromString(
+      "payload.optional_int32,payload.repeated_string,payload.optionalgroup,"
+      "child.payload.optional_nested_message,child.child",
+      &mask);
+  std::string data;
+  ASSERT_TRUE(FieldMaskUtil::SerializeWithFieldMask(source, mask, &data));
+  NestedTestAllTypes expected(source);
+  expected.clear_repeated_child();
+  FieldMaskUtil::TrimMessage(mask, &expected);
+  EXPECT_EQ(data, expected.SerializeAsString());
+
+  // Paths may go through repeated messages and groups.
+  FieldMaskUtil::FromString(
+      "repeated_child.payload.optional_string,"
+      "repeated_child.payload.repeatedgroup.a",
+      &mask);
+  ASSERT_TRUE(FieldMaskUtil::SerializeWithFieldMask(source, mask, &data));
+  NestedTestAllTypes projected;
+  for (const NestedTestAllTypes& child : source.repeated_child()) {
+    TestAllTypes* payload = projected.add_repeated_child()->mutable_payload();
+    payload->set_optional_string(child.payload().optional_string());
+    *payload->mutable_repeatedgroup() = child.payload().repeatedgroup();
+  }
+  EXPECT_EQ(data, projected.SerializeAsString());
+
+  // An empty mask serializes everything.
+  ASSERT_TRUE(
+      FieldMaskUtil::SerializeWithFieldMask(source, FieldMask(), &data));
+  EXPECT_EQ(data, source.SerializeAsString());
+}
+
+TEST(FieldMaskUtilTest, ParseFromStringWithMask) {
+  NestedTestAllTypes source;
+  TestUtil::SetAllFields(source.mutable_payload());
+  TestUtil::SetAllFields(source.mutable_child()->mutable_payload());
+  source.mutable_child()->mutable_child()->mutable_payload()->set_optional_int32(
+      7);
+  TestUtil::SetAllFields(source.add_repeated_child()->mutable_payload());
+  const std::string data = source.SerializeAsString();
+
+  FieldMask mask;
+  FieldMaskUtil::FromString(
+      "payload.optional_int32,payload.repeated_string,"
+      "child.payload.optional_nested_message,child.child",
+      &mask);
+  NestedTestAllTypes parsed;
+  ASSERT_TRUE(FieldMaskUtil::ParseFromStringWithMask(data, mask, &parsed));
+  NestedTestAllTypes expected(source);
+  FieldMaskUtil::TrimMessage(mask, &expected);
+  EXPECT_EQ(parsed.DebugString(), expected.DebugString());
+  EXPECT_EQ(parsed.payload().GetReflection()->GetUnknownFields(
+                parsed.payload()).field_count(),
+            0);
+
+  // Paths may go through repeated messages.
+  FieldMaskUtil::FromString("repeated_child.payload.optional_string", &mask);
+  ASSERT_TRUE(FieldMaskUtil::ParseFromStringWithMask(data, mask, &parsed));
+  ASSERT_EQ(parsed.repeated_child_size(), 1);
+  TestAllTypes payload;
+  payload.set_optional_string(
+      source.repeated_child(0).payload().optional_string());
+  EXPECT_EQ(parsed.repeated_child(0).payload().DebugString(),
+            payload.DebugString());
+  EXPECT_FALSE(parsed.has_payload());
+
+  // An empty mask keeps everything.
+  ASSERT_TRUE(
+      FieldMaskUtil::ParseFromStringWithMask(data, FieldMask(), &parsed));
+  EXPECT_EQ(parsed.SerializeAsString(), data);
+
+  EXPECT_FALSE(FieldMaskUtil::ParseFromStringWithMask(
+      data.substr(0, data.size() - 1), mask, &parsed));
+}
+
+TEST(FieldMaskUtilTest, ParseFromStringWithMaskKeepsSkippedAsUnknown) {
+  TestAllTypes source;
+  TestUtil::SetAllFields(&source);
+  const std::string data = source.SerializeAsString();
+
+  FieldMask mask;
+  FieldMaskUtil::FromString("optional_int32,optional_nested_message.bb",
+                            &mask);
+  FieldMaskUtil::ParseOptions options;
+  options.set_keep_skipped_as_unknown_fields(true);
+  TestAllTypes parsed;
+  ASSERT_TRUE(
+      FieldMaskUtil::ParseFromStringWithMask(data, mask, options, &parsed));
+  EXPECT_EQ(parsed.optional_int32(), source.optional_int32());
+  EXPECT_EQ(parsed.optional_nested_message().bb(),
+            source.optional_nested_message().bb());
+  EXPECT_FALSE(parsed.has_optional_string());
+  EXPECT_GT(parsed.GetReflection()->GetUnknownFields(parsed).field_count(), 0);
+
+  // The skipped bytes round-trip.
+  TestAllTypes reparsed;
+  ASSERT_TRUE(reparsed.ParseFromString(parsed.SerializeAsString()));
+  EXPECT_EQ(reparsed.DebugString(), source.DebugString());
+}
+
+TEST(CompiledFieldMaskTest, Compile) {
+  FieldMask mask;
+  FieldMaskUtil::FromString("payload.optional_int32,child.child", &mask);
+  std::unique_ptr<CompiledFieldMask> compiled =
+      CompiledFieldMask::Compile<NestedTestAllTypes>(mask);
+  ASSERT_TRUE(compiled != nullptr);
+  EXPECT_EQ(compiled->descriptor(), NestedTestAllTypes::descriptor());
+
+  for (const char* invalid :
+       {"payload.no_such_field", "payload.optional_int32.foo",
+        "payload.map_int32_int32.key", ""}) {
+    FieldMaskUtil::FromString(invalid, &mask);
+    if (mask.paths().empty()) mask.add_paths(invalid);
+    EXPECT_TRUE(CompiledFieldMask::Compile<NestedTestAllTypes>(mask) ==
+                nullptr)
+        << invalid;
+  }
+}
+
+TEST(CompiledFieldMaskTest, IsPathInFieldMask) {
+  FieldMask mask;
+  FieldMaskUtil::FromString("payload.optional_nested_message,child", &mask);
+  std::unique_ptr<CompiledFieldMask> compiled =
+      CompiledFieldMask::Compile<NestedTestAllTypes>(mask);
+  ASSERT_TRUE(compiled != nullptr);
+  for (const char* path :
+       {"payload.optional_nested_message", "payload.optional_nested_message.bb",
+        "child", "child.payload.optional_int32", "payload", "payload.bogus",
+        "repeated_child", "child.bogus", ""}) {
+    EXPECT_EQ(compiled->IsPathInFieldMask(path),
+              FieldMaskUtil::IsPathInFieldMask(path, mask))
+        << path;
+  }
+  EXPECT_FALSE(CompiledFieldMask::Compile<NestedTestAllTypes>(FieldMask())
+                   ->IsPathInFieldMask("child"));
+}
+
+TEST(CompiledFieldMaskTest, MatchesFieldMaskUtil) {
+  NestedTestAllTypes source;
+  TestUtil::SetAllFields(source.mutable_payload());
+  TestUtil::SetAllFields(source.mutable_child()->mutable_payload());
+  source.mutable_child()->mutable_child()->mutable_payload()->set_optional_int32(
+      7);
+  const std::string data = source.SerializeAsString();
+
+  for (const char* paths :
+       {"", "payload", "payload.optional_int32,payload.repeated_string",
+        "child.payload.optional_nested_message,child.child",
+        "payload.optional_nested_message.bb,child.payload.optional_foreign_enum"}) {
+    SCOPED_TRACE(paths);
+    FieldMask mask;
+    FieldMaskUtil::FromString(paths, &mask);
+    std::unique_ptr<CompiledFieldMask> compiled =
+        CompiledFieldMask::Compile<NestedTestAllTypes>(mask);
+    ASSERT_TRUE(compiled != nullptr);
+
+    NestedTestAllTypes expected(source), trimmed(source);
+    EXPECT_EQ(compiled->TrimMessage(&trimmed),
+              FieldMaskUtil::TrimMessage(mask, &expected));
+    EXPECT_EQ(trimmed.DebugString(), expected.DebugString());
+
+    FieldMaskUtil::MergeOptions options;
+    options.set_replace_repeated_fields(true);
+    NestedTestAllTypes merged, expected_merged;
+    compiled->MergeMessageTo(source, options, &merged);
+    FieldMaskUtil::MergeMessageTo(source, mask, options, &expected_merged);
+    EXPECT_EQ(merged.DebugString(), expected_merged.DebugString());
+
+    std::string serialized, expected_serialized;
+    ASSERT_TRUE(compiled->SerializeWithFieldMask(source, &serialized));
+    ASSERT_TRUE(FieldMaskUtil::SerializeWithFieldMask(source, mask,
+                                                      &expected_serialized));
+    EXPECT_EQ(serialized, expected_serialized);
+
+    NestedTestAllTypes parsed, expected_parsed;
+    ASSERT_TRUE(compiled->ParseFromStringWithMask(data, &parsed));
+    ASSERT_TRUE(
+        FieldMaskUtil::ParseFromStringWithMask(data, mask, &expected_parsed));
+    EXPECT_EQ(parsed.DebugString(), expected_parsed.DebugString());
+  }
+}
+
+TEST(CompiledFieldMaskTest, TrimKeepsRequiredFields) {
+  TestRequiredMessage message;
+  message.mutable_optional_message()->set_a(1234);
+  message.mutable_optional_message()->set_dummy2(7890);
+  message.mutable_required_message()->set_a(1234);
+  message.mutable_required_message()->set_dummy2(7890);
+  message.add_repeated_message()->set_a(1234);
+
+  FieldMask mask;
+  FieldMaskUtil::FromString("optional_message.dummy2", &mask);
+  std::unique_ptr<CompiledFieldMask> compiled =
+      CompiledFieldMask::Compile<TestRequiredMessage>(mask);
+  ASSERT_TRUE(compiled != nullptr);
+  FieldMaskUtil::TrimOptions options;
+  options.set_keep_required_fields(true);
+  TestRequiredMessage trimmed(message), expected(message);
+  EXPECT_TRUE(compiled->TrimMessage(&trimmed, options));
+  FieldMaskUtil::TrimMessage(mask, &expected, options);
+  EXPECT_EQ(trimmed.DebugString(), expected.DebugString());
+  EXPECT_EQ(trimmed.required_message().a(), 1234);
+  EXPECT_FALSE(trimmed.required_message().has_dummy2());
+}
+
+TEST(FieldMaskUtilTest, TrimMessageEmptyMaskKeepsAllFields) {
+  // An empty mask keeps the whole message, also when only the required
+  // fields would be kept of a message that is not in a non-empty mask.
+  TestRequiredMessage message;
+  message.mutable_optional_message()->set_a(1234);
+  message.mutable_required_message()->set_a(1234);
+  message.mutable_required_message()->set_dummy2(7890);
+  message.add_repeated_message()->set_a(1234);
+
+  FieldMask empty_mask;
+  FieldMaskUtil::TrimOptions options;
+  options.set_keep_required_fields(true);
+  TestRequiredMessage trimmed(message);
+  EXPECT_FALSE(FieldMaskUtil::TrimMessage(empty_mask, &trimmed, options));
+  EXPECT_EQ(trimmed.DebugString(), message.DebugString());
+
+  std::unique_ptr<CompiledFieldMask> compiled =
+      CompiledFieldMask::Compile<TestRequiredMessage>(empty_mask);
+  ASSERT_TRUE(compiled != nullptr);
+  EXPECT_FALSE(compiled->TrimMessage(&trimmed, options));
+  EXPECT_EQ(trimmed.DebugString(), message.DebugString());
+}
+
+TEST(CompiledFieldMaskTest, RepeatedMessages) {
+  NestedTestAllTypes source;
+  for (int i = 0; i < 3; ++i) {
+    TestUtil::SetAllFields(source.add_repeated_child()->mutable_payload());
+  }
+  FieldMask mask;
+  FieldMaskUtil::FromString("repeated_child.payload.optional_string", &mask);
+  std::unique_ptr<CompiledFieldMask> compiled =
+      CompiledFieldMask::Compile<NestedTestAllTypes>(mask);
+  ASSERT_TRUE(compiled != nullptr);
+
+  NestedTestAllTypes expected;
+  for (int i = 0; i < 3; ++i) {
+    expected.add_repeated_child()->mutable_payload()->set_optional_string(
+        source.repeated_child(i).payload().optional_string());
+  }
+
+  NestedTestAllTypes trimmed(source);
+  EXPECT_TRUE(compiled->TrimMessage(&trimmed));
+  EXPECT_EQ(trimmed.DebugString(), expected.DebugString());
+
+  NestedTestAllTypes merged;
+  compiled->MergeMessageTo(source, FieldMaskUtil::MergeOptions(), &merged);
+  EXPECT_EQ(merged.DebugString(), expected.DebugString());
+}
+
 
 }  // namespace
 }  // namespace util
@@ -0,0 +1,740 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/util/message_delta.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/casts.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/log/absl_check.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/message.h"
+#include "google/protobuf/unknown_field_set.h"
+#include "google/protobuf/wire_format_lite.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+using ::google::protobuf::internal::WireFormatLite;
+
+// Field numbers of the patch messages described in message_delta.h.
+constexpr int kMessageDeltaField = 1;
+constexpr int kFieldNumber = 1;
+constexpr int kFieldClear = 2;
+constexpr int kFieldSet = 3;
+constexpr int kFieldPatch = 4;
+constexpr int kFieldSplice = 5;
+constexpr int kFieldMap = 6;
+constexpr int kSpliceStart = 1;
+constexpr int kSpliceRemove = 2;
+constexpr int kSpliceInsert = 3;
+constexpr int kMapPut = 1;
+constexpr int kMapErase = 2;
+
+// Number standing for the unknown fields in a FieldDelta.
+constexpr int kUnknownFields = 0;
+
+// Appends to a string, which is complete once the Writer is destroyed.
+// Messages are serialized deterministically, so equal messages encode alike.
+class Writer {
+ public:
+  explicit Writer(std::string* output) : stream_(output), coded_(&stream_) {
+    coded_.SetSerializationDeterministic(true);
+  }
+
+  io::CodedOutputStream* coded() { return &coded_; }
+
+ private:
+  io::StringOutputStream stream_;
+  io::CodedOutputStream coded_;
+};
+
+void WriteLengthDelimited(int number, absl::string_view data,
+                          io::CodedOutputStream* out) {
+  WireFormatLite::WriteTag(number, WireFormatLite::WIRETYPE_LENGTH_DELIMITED,
+                           out);
+  out->WriteVarint32(static_cast<uint32_t>(data.size()));
+  out->WriteRaw(data.data(), static_cast<int>(data.size()));
+}
+
+std::string Serialize(const Message& message) {
+  message.ByteSizeLong();
+  std::string output;
+  {
+    Writer writer(&output);
+    message.SerializeWithCachedSizes(writer.coded());
+  }
+  return output;
+}
+
+// Reads element `index` of a repeated field, or the value of a singular field
+// if `index` is -1.
+#define GET_VALUE(METHOD, message, field, index)                        \
+  ((index) < 0 ? (message).GetReflection()->Get##METHOD(message, field) \
+               : (message).GetReflection()->GetRepeated##METHOD(        \
+                     message, field, index))
+
+const std::string& GetString(const Message& message,
+                             const FieldDescriptor* field, int index,
+                             std::string* scratch) {
+  const Reflection* reflection = message.GetReflection();
+  return index < 0 ? reflection->GetStringReference(message, field, scratch)
+                   : reflection->GetRepeatedStringReference(message, field,
+                                                            index, scratch);
+}
+
+const Message& GetMessage(const Message& message, const FieldDescriptor* field,
+                          int index) {
+  return GET_VALUE(Message, message, field, index);
+}
+
+// Writes a value as the field serializes it; without its tag if it is an
+// element of a packed field.
+void WriteValue(const Message& message, const FieldDescriptor* field,
+                int index, bool packed, io::CodedOutputStream* out) {
+  const int number = field->number();
+  switch (field->type()) {
+#define HANDLE_TYPE(TYPE, NAME, METHOD)                            \
+  case FieldDescriptor::TYPE_##TYPE: {                             \
+    const auto value = GET_VALUE(METHOD, message, field, index);   \
+    if (packed) {                                                  \
+      WireFormatLite::Write##NAME##NoTag(value, out);              \
+    } else {                                                       \
+      WireFormatLite::Write##NAME(number, value, out);             \
+    }                                                              \
+    return;                                                        \
+  }
+
+    HANDLE_TYPE(INT32, Int32, Int32)
+    HANDLE_TYPE(INT64, Int64, Int64)
+    HANDLE_TYPE(UINT32, UInt32, UInt32)
+    HANDLE_TYPE(UINT64, UInt64, UInt64)
+    HANDLE_TYPE(SINT32, SInt32, Int32)
+    HANDLE_TYPE(SINT64, SInt64, Int64)
+    HANDLE_TYPE(FIXED32, Fixed32, UInt32)
+    HANDLE_TYPE(FIXED64, Fixed64, UInt64)
+    HANDLE_TYPE(SFIXED32, SFixed32, Int32)
+    HANDLE_TYPE(SFIXED64, SFixed64, Int64)
+    HANDLE_TYPE(FLOAT, Float, Float)
+    HANDLE_TYPE(DOUBLE, Double, Double)
+    HANDLE_TYPE(BOOL, Bool, Bool)
+    HANDLE_TYPE(ENUM, Enum, EnumValue)
+#undef HANDLE_TYPE
+
+    case FieldDescriptor::TYPE_STRING:
+    case FieldDescriptor::TYPE_BYTES: {
+      std::string scratch;
+      WireFormatLite::WriteBytes(
+          number, GetString(message, field, index, &scratch), out);
+      return;
+    }
+    case FieldDescriptor::TYPE_GROUP: {
+      const Message& value = GetMessage(message, field, index);
+      value.ByteSizeLong();
+      WireFormatLite::WriteGroup(number, value, out);
+      return;
+    }
+    case FieldDescriptor::TYPE_MESSAGE: {
+      const Message& value = GetMessage(message, field, index);
+      value.ByteSizeLong();
+      WireFormatLite::WriteMessage(number, value, out);
+      return;
+    }
+  }
+}
+
+// Writes elements [begin, end) of a repeated field as the field serializes
+// them.
+void WriteElements(const Message& message, const FieldDescriptor* field,
+                   int begin, int end, io::CodedOutputStream* out) {
+  if (!field->is_packed()) {
+    for (int i = begin; i < end; ++i) {
+      WriteValue(message, field, i, /*packed=*/false, out);
+    }
+    return;
+  }
+  if (begin == end) return;
+  std::string data;
+  {
+    Writer writer(&data);
+    for (int i = begin; i < end; ++i) {
+      WriteValue(message, field, i, /*packed=*/true, writer.coded());
+    }
+  }
+  WriteLengthDelimited(field->number(), data, out);
+}
+
+std::string SerializeField(const Message& message,
+                           const FieldDescriptor* field) {
+  std::string output;
+  {
+    Writer writer(&output);
+    if (field->is_repeated()) {
+      WriteElements(message, field, 0,
+                    message.GetReflection()->FieldSize(message, field),
+                    writer.coded());
+    } else {
+      WriteValue(message, field, -1, /*packed=*/false, writer.coded());
+    }
+  }
+  return output;
+}
+
+// Compares two values exactly: floating point values by their bits, and
+// messages by their deterministic serialization.
+bool ValuesEqual(const Message& a, int index_a, const Message& b, int index_b,
+                 const FieldDescriptor* field) {
+  switch (field->cpp_type()) {
+#define HANDLE_TYPE(CPPTYPE, METHOD)                \
+  case FieldDescriptor::CPPTYPE_##CPPTYPE:          \
+    return GET_VALUE(METHOD, a, field, index_a) ==  \
+           GET_VALUE(METHOD, b, field, index_b);
+
+    HANDLE_TYPE(INT32, Int32)
+    HANDLE_TYPE(INT64, Int64)
+    HANDLE_TYPE(UINT32, UInt32)
+    HANDLE_TYPE(UINT64, UInt64)
+    HANDLE_TYPE(BOOL, Bool)
+    HANDLE_TYPE(ENUM, EnumValue)
+#undef HANDLE_TYPE
+
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      return absl::bit_cast<uint32_t>(GET_VALUE(Float, a, field, index_a)) ==
+             absl::bit_cast<uint32_t>(GET_VALUE(Float, b, field, index_b));
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      return absl::bit_cast<uint64_t>(GET_VALUE(Double, a, field, index_a)) ==
+             absl::bit_cast<uint64_t>(GET_VALUE(Double, b, field, index_b));
+    case FieldDescriptor::CPPTYPE_STRING: {
+      std::string scratch_a, scratch_b;
+      return GetString(a, field, index_a, &scratch_a) ==
+             GetString(b, field, index_b, &scratch_b);
+    }
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      return Serialize(GetMessage(a, field, index_a)) ==
+             Serialize(GetMessage(b, field, index_b));
+  }
+  return false;
+}
+
+#undef GET_VALUE
+
+bool IsSet(const Message& message, const FieldDescriptor* field) {
+  const Reflection* reflection = message.GetReflection();
+  return field->is_repeated() ? reflection->FieldSize(message, field) > 0
+                              : reflection->HasField(message, field);
+}
+
+// The serialized key field of a map entry, which identifies the entry.
+std::string MapKeyOf(const Message& entry) {
+  std::string key;
+  {
+    Writer writer(&key);
+    WriteValue(entry, entry.GetDescriptor()->map_key(), -1, /*packed=*/false,
+               writer.coded());
+  }
+  return key;
+}
+
+void WriteFieldDelta(int number, int op, absl::string_view payload,
+                     io::CodedOutputStream* out) {
+  const size_t size = 2 + io::CodedOutputStream::VarintSize32(number) +
+                      WireFormatLite::LengthDelimitedSize(payload.size());
+  WireFormatLite::WriteTag(kMessageDeltaField,
+                           WireFormatLite::WIRETYPE_LENGTH_DELIMITED, out);
+  out->WriteVarint32(static_cast<uint32_t>(size));
+  WireFormatLite::WriteUInt32(kFieldNumber, number, out);
+  WriteLengthDelimited(op, payload, out);
+}
+
+void WriteClear(int number, io::CodedOutputStream* out) {
+  WireFormatLite::WriteTag(kMessageDeltaField,
+                           WireFormatLite::WIRETYPE_LENGTH_DELIMITED, out);
+  out->WriteVarint32(3 + io::CodedOutputStream::VarintSize32(number));
+  WireFormatLite::WriteUInt32(kFieldNumber, number, out);
+  WireFormatLite::WriteBool(kFieldClear, true, out);
+}
+
+void AppendDelta(const Message& from, const Message& to,
+                 io::CodedOutputStream* out);
+
+// The elements that differ between the common prefix and the common suffix
+// are replaced.  This covers appends, truncation and in-place edits with a
+// single splice.
+void AppendSplice(const Message& from, const Message& to,
+                  const FieldDescriptor* field, io::CodedOutputStream* out) {
+  const int from_size = from.GetReflection()->FieldSize(from, field);
+  const int to_size = to.GetReflection()->FieldSize(to, field);
+  const int common = std::min(from_size, to_size);
+  int prefix = 0;
+  while (prefix < common && ValuesEqual(from, prefix, to, prefix, field)) {
+    ++prefix;
+  }
+  if (prefix == from_size && prefix == to_size) return;
+  int suffix = 0;
+  while (suffix < common - prefix &&
+         ValuesEqual(from, from_size - 1 - suffix, to, to_size - 1 - suffix,
+                     field)) {
+    ++suffix;
+  }
+
+  std::string splice;
+  {
+    Writer writer(&splice);
+    if (prefix != 0) {
+      WireFormatLite::WriteUInt32(kSpliceStart, prefix, writer.coded());
+    }
+    const int remove = from_size - prefix - suffix;
+    if (remove != 0) {
+      WireFormatLite::WriteUInt32(kSpliceRemove, remove, writer.coded());
+    }
+    if (to_size - suffix > prefix) {
+      std::string insert;
+      {
+        Writer insert_writer(&insert);
+        WriteElements(to, field, prefix, to_size - suffix,
+                      insert_writer.coded());
+      }
+      WriteLengthDelimited(kSpliceInsert, insert, writer.coded());
+    }
+  }
+  WriteFieldDelta(field->number(), kFieldSplice, splice, out);
+}
+
+void AppendMapDelta(const Message& from, const Message& to,
+                    const FieldDescriptor* field, io::CodedOutputStream* out) {
+  const Reflection* from_reflection = from.GetReflection();
+  const Reflection* to_reflection = to.GetReflection();
+  absl::flat_hash_map<std::string, std::string> from_entries;
+  for (int i = 0; i < from_reflection->FieldSize(from, field); ++i) {
+    const Message& entry = from_reflection->GetRepeatedMessage(from, field, i);
+    from_entries[MapKeyOf(entry)] = Serialize(entry);
+  }
+
+  std::string put;
+  {
+    Writer writer(&put);
+    for (int i = 0; i < to_reflection->FieldSize(to, field); ++i) {
+      const Message& entry = to_reflection->GetRepeatedMessage(to, field, i);
+      std::string serialized = Serialize(entry);
+      auto it = from_entries.find(MapKeyOf(entry));
+      if (it != from_entries.end()) {
+        const bool unchanged = it->second == serialized;
+        from_entries.erase(it);
+        if (unchanged) continue;
+      }
+      WriteLengthDelimited(field->number(), serialized, writer.coded());
+    }
+  }
+  // What is left of `from_entries` is not in `to`.
+  std::string erase;
+  {
+    Writer writer(&erase);
+    for (const auto& entry : from_entries) {
+      WriteLengthDelimited(field->number(), entry.first, writer.coded());
+    }
+  }
+  if (put.empty() && erase.empty()) return;
+
+  std::string map_delta;
+  {
+    Writer writer(&map_delta);
+    if (!put.empty()) WriteLengthDelimited(kMapPut, put, writer.coded());
+    if (!erase.empty()) WriteLengthDelimited(kMapErase, erase, writer.coded());
+  }
+  WriteFieldDelta(field->number(), kFieldMap, map_delta, out);
+}
+
+void AppendDelta(const Message& from, const Message& to,
+                 io::CodedOutputStream* out) {
+  const Reflection* from_reflection = from.GetReflection();
+  const Reflection* to_reflection = to.GetReflection();
+
+  // ListFields() sorts by number, so a field set on both sides appears once.
+  std::vector<const FieldDescriptor*> from_fields;
+  std::vector<const FieldDescriptor*> to_fields;
+  from_reflection->ListFields(from, &from_fields);
+  to_reflection->ListFields(to, &to_fields);
+  std::vector<const FieldDescriptor*> fields;
+  std::set_union(from_fields.begin(), from_fields.end(), to_fields.begin(),
+                 to_fields.end(), std::back_inserter(fields),
+                 [](const FieldDescriptor* a, const FieldDescriptor* b) {
+                   return a->number() < b->number();
+                 });
+
+  for (const FieldDescriptor* field : fields) {
+    const int number = field->number();
+    if (!IsSet(to, field)) {
+      WriteClear(number, out);
+    } else if (!IsSet(from, field)) {
+      WriteFieldDelta(number, kFieldSet, SerializeField(to, field), out);
+    } else if (field->is_map()) {
+      AppendMapDelta(from, to, field, out);
+    } else if (field->is_repeated()) {
+      AppendSplice(from, to, field, out);
+    } else if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+      std::string patch;
+      {
+        Writer writer(&patch);
+        AppendDelta(from_reflection->GetMessage(from, field),
+                    to_reflection->GetMessage(to, field), writer.coded());
+      }
+      if (!patch.empty()) WriteFieldDelta(number, kFieldPatch, patch, out);
+    } else if (!ValuesEqual(from, -1, to, -1, field)) {
+      WriteFieldDelta(number, kFieldSet, SerializeField(to, field), out);
+    }
+  }
+
+  const UnknownFieldSet& from_unknown = from_reflection->GetUnknownFields(from);
+  const UnknownFieldSet& to_unknown = to_reflection->GetUnknownFields(to);
+  if (from_unknown.empty() && to_unknown.empty()) return;
+  std::string from_bytes;
+  std::string to_bytes;
+  from_unknown.SerializeToString(&from_bytes);
+  to_unknown.SerializeToString(&to_bytes);
+  if (from_bytes == to_bytes) return;
+  if (to_bytes.empty()) {
+    WriteClear(kUnknownFields, out);
+  } else {
+    WriteFieldDelta(kUnknownFields, kFieldSet, to_bytes, out);
+  }
+}
+
+// Applying a patch.
+
+absl::Status Malformed(const Message& message) {
+  return absl::InvalidArgumentError(
+      absl::StrCat("Malformed delta for ", message.GetTypeName(), "."));
+}
+
+// Reads a length-delimited field whose tag has been consumed and limits
+// `input` to its contents.
+bool PushLength(io::CodedInputStream* input,
+                io::CodedInputStream::Limit* limit) {
+  uint32_t length;
+  if (!input->ReadVarint32(&length) ||
+      length > static_cast<uint32_t>(input->BytesUntilLimit())) {
+    return false;
+  }
+  *limit = input->PushLimit(static_cast<int>(length));
+  return true;
+}
+
+// Parses the rest of the current limit into `message`, merging it.
+bool MergeRest(io::CodedInputStream* input, Message* message) {
+  return message->MergePartialFromCodedStream(input) &&
+         input->BytesUntilLimit() == 0;
+}
+
+void Reverse(Message* message, const FieldDescriptor* field, int begin,
+             int end) {
+  const Reflection* reflection = message->GetReflection();
+  for (--end; begin < end; ++begin, --end) {
+    reflection->SwapElements(message, field, begin, end);
+  }
+}
+
+// Moves elements [middle, end) in front of [begin, middle).
+void Rotate(Message* message, const FieldDescriptor* field, int begin,
+            int middle, int end) {
+  Reverse(message, field, begin, middle);
+  Reverse(message, field, middle, end);
+  Reverse(message, field, begin, end);
+}
+
+// Moves the elements of `field` in `from` to the end of `field` in `to`.
+void AppendElements(Message* from, const FieldDescriptor* field,
+                    Message* to) {
+  const Reflection* from_reflection = from->GetReflection();
+  const Reflection* to_reflection = to->GetReflection();
+  const int size = from_reflection->FieldSize(*from, field);
+  switch (field->cpp_type()) {
+#define HANDLE_TYPE(CPPTYPE, METHOD)                                    \
+  case FieldDescriptor::CPPTYPE_##CPPTYPE:                              \
+    for (int i = 0; i < size; ++i) {                                    \
+      to_reflection->Add##METHOD(                                       \
+          to, field, from_reflection->GetRepeated##METHOD(*from, field, \
+                                                          i));          \
+    }                                                                   \
+    return;
+
+    HANDLE_TYPE(INT32, Int32)
+    HANDLE_TYPE(INT64, Int64)
+    HANDLE_TYPE(UINT32, UInt32)
+    HANDLE_TYPE(UINT64, UInt64)
+    HANDLE_TYPE(FLOAT, Float)
+    HANDLE_TYPE(DOUBLE, Double)
+    HANDLE_TYPE(BOOL, Bool)
+    HANDLE_TYPE(ENUM, EnumValue)
+    HANDLE_TYPE(STRING, String)
+#undef HANDLE_TYPE
+
+    case FieldDescriptor::CPPTYPE_MESSAGE: {
+      std::vector<Message*> elements(size);
+      for (int i = size - 1; i >= 0; --i) {
+        elements[i] = from_reflection->ReleaseLast(from, field);
+      }
+      for (Message* element : elements) {
+        to_reflection->AddAllocatedMessage(to, field, element);
+      }
+      return;
+    }
+  }
+}
+
+absl::Status ApplySplice(io::CodedInputStream* input,
+                         const FieldDescriptor* field, Message* message) {
+  uint32_t start = 0;
+  uint32_t remove = 0;
+  std::unique_ptr<Message> inserted(message->New());
+  while (input->BytesUntilLimit() > 0) {
+    const uint32_t tag = input->ReadTag();
+    if (tag == WireFormatLite::MakeTag(kSpliceStart,
+                                       WireFormatLite::WIRETYPE_VARINT)) {
+      if (!input->ReadVarint32(&start)) return Malformed(*message);
+    } else if (tag == WireFormatLite::MakeTag(
+                          kSpliceRemove, WireFormatLite::WIRETYPE_VARINT)) {
+      if (!input->ReadVarint32(&remove)) return Malformed(*message);
+    } else if (tag == WireFormatLite::MakeTag(
+                          kSpliceInsert,
+                          WireFormatLite::WIRETYPE_LENGTH_DELIMITED)) {
+      io::CodedInputStream::Limit limit;
+      if (!PushLength(input, &limit) || !MergeRest(input, inserted.get())) {
+        return Malformed(*message);
+      }
+      input->PopLimit(limit);
+    } else {
+      return Malformed(*message);
+    }
+  }
+
+  const Reflection* reflection = message->GetReflection();
+  const uint32_t size =
+      static_cast<uint32_t>(reflection->FieldSize(*message, field));
+  if (start > size || remove > size - start) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Delta splices elements [", start, ", ", start + remove, ") of ",
+        field->full_name(), ", which has ", size, " elements."));
+  }
+  // Append the inserted elements, move them to `start`, move the removed
+  // elements behind them to the end, and drop those.
+  const int count = inserted->GetReflection()->FieldSize(*inserted, field);
+  AppendElements(inserted.get(), field, message);
+  const int begin = static_cast<int>(start);
+  const int end = static_cast<int>(size) + count;
+  Rotate(message, field, begin, static_cast<int>(size), end);
+  Rotate(message, field, begin + count, begin + count + remove, end);
+  for (uint32_t i = 0; i < remove; ++i) reflection->RemoveLast(message, field);
+  return absl::OkStatus();
+}
+
+absl::Status ApplyMapDelta(io::CodedInputStream* input,
+                           const FieldDescriptor* field, Message* message) {
+  const uint32_t put_tag = WireFormatLite::MakeTag(
+      kMapPut, WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+  const uint32_t erase_tag = WireFormatLite::MakeTag(
+      kMapErase, WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+  const uint32_t entry_tag = WireFormatLite::MakeTag(
+      field->number(), WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+  while (input->BytesUntilLimit() > 0) {
+    const uint32_t tag = input->ReadTag();
+    io::CodedInputStream::Limit limit;
+    if ((tag != put_tag && tag != erase_tag) || !PushLength(input, &limit)) {
+      return Malformed(*message);
+    }
+    if (tag == put_tag) {
+      // Parsing an entry replaces the value of an existing key.
+      if (!MergeRest(input, message)) return Malformed(*message);
+    } else {
+      absl::flat_hash_set<std::string> keys;
+      while (input->BytesUntilLimit() > 0) {
+        std::string key;
+        uint32_t length;
+        if (input->ReadTag() != entry_tag || !input->ReadVarint32(&length) ||
+            !input->ReadString(&key, static_cast<int>(length))) {
+          return Malformed(*message);
+        }
+        keys.insert(std::move(key));
+      }
+      // Map reflection is not public, so entries are erased through the
+      // repeated field view of the map, whose order does not matter.
+      const Reflection* reflection = message->GetReflection();
+      for (int i = reflection->FieldSize(*message, field) - 1; i >= 0; --i) {
+        if (!keys.contains(MapKeyOf(
+                reflection->GetRepeatedMessage(*message, field, i)))) {
+          continue;
+        }
+        const int last = reflection->FieldSize(*message, field) - 1;
+        if (i != last) reflection->SwapElements(message, field, i, last);
+        reflection->RemoveLast(message, field);
+      }
+    }
+    input->PopLimit(limit);
+  }
+  return absl::OkStatus();
+}
+
+absl::Status ApplyDelta(io::CodedInputStream* input, Message* message);
+
+absl::Status ApplyFieldDelta(io::CodedInputStream* input, Message* message) {
+  const Reflection* reflection = message->GetReflection();
+  uint32_t number;
+  if (input->ReadTag() != WireFormatLite::MakeTag(
+                              kFieldNumber, WireFormatLite::WIRETYPE_VARINT) ||
+      !input->ReadVarint32(&number)) {
+    return Malformed(*message);
+  }
+  const FieldDescriptor* field = nullptr;
+  if (number != kUnknownFields) {
+    field = message->GetDescriptor()->FindFieldByNumber(
+        static_cast<int>(number));
+    if (field == nullptr) {
+      field = reflection->FindKnownExtensionByNumber(static_cast<int>(number));
+    }
+    if (field == nullptr) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Delta refers to unknown field ", number, " of ",
+          message->GetTypeName(), "."));
+    }
+  }
+
+  const uint32_t tag = input->ReadTag();
+  if (tag == WireFormatLite::MakeTag(kFieldClear,
+                                     WireFormatLite::WIRETYPE_VARINT)) {
+    uint32_t value;
+    if (!input->ReadVarint32(&value)) return Malformed(*message);
+    if (field == nullptr) {
+      reflection->MutableUnknownFields(message)->Clear();
+    } else {
+      reflection->ClearField(message, field);
+    }
+    return absl::OkStatus();
+  }
+  if (WireFormatLite::GetTagWireType(tag) !=
+      WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+    return Malformed(*message);
+  }
+  const int op = WireFormatLite::GetTagFieldNumber(tag);
+  const bool op_fits_field =
+      field == nullptr
+          ? op == kFieldSet
+          : op == kFieldSet ||
+                (op == kFieldPatch && !field->is_repeated() &&
+                 field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) ||
+                (op == kFieldSplice && field->is_repeated() &&
+                 !field->is_map()) ||
+                (op == kFieldMap && field->is_map());
+  io::CodedInputStream::Limit limit;
+  if (!op_fits_field || !PushLength(input, &limit)) return Malformed(*message);
+
+  absl::Status status;
+  switch (op) {
+    case kFieldSet:
+      if (field == nullptr) {
+        UnknownFieldSet* unknown = reflection->MutableUnknownFields(message);
+        unknown->Clear();
+        if (!unknown->MergeFromCodedStream(input)) status = Malformed(*message);
+      } else {
+        reflection->ClearField(message, field);
+        if (!MergeRest(input, message)) status = Malformed(*message);
+      }
+      break;
+    case kFieldPatch:
+      if (!input->IncrementRecursionDepth()) return Malformed(*message);
+      status = ApplyDelta(input, reflection->MutableMessage(message, field));
+      input->DecrementRecursionDepth();
+      break;
+    case kFieldSplice:
+      status = ApplySplice(input, field, message);
+      break;
+    case kFieldMap:
+      status = ApplyMapDelta(input, field, message);
+      break;
+  }
+  input->PopLimit(limit);
+  return status;
+}
+
+absl::Status ApplyDelta(io::CodedInputStream* input, Message* message) {
+  const uint32_t delta_tag = WireFormatLite::MakeTag(
+      kMessageDeltaField, WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+  while (input->BytesUntilLimit() > 0) {
+    io::CodedInputStream::Limit limit;
+    if (input->ReadTag() != delta_tag || !PushLength(input, &limit)) {
+      return Malformed(*message);
+    }
+    absl::Status status = ApplyFieldDelta(input, message);
+    if (!status.ok()) return status;
+    if (input->BytesUntilLimit() != 0) return Malformed(*message);
+    input->PopLimit(limit);
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+std::string ComputeMessageDelta(const Message& from, const Message& to) {
+  ABSL_CHECK_EQ(from.GetDescriptor(), to.GetDescriptor())
+      << "Deltas are computed between messages of the same type.";
+  std::string delta;
+  {
+    Writer writer(&delta);
+    AppendDelta(from, to, writer.coded());
+  }
+  return delta;
+}
+
+absl::Status ApplyMessageDelta(absl::string_view delta, Message* message) {
+  io::CodedInputStream input(reinterpret_cast<const uint8_t*>(delta.data()),
+                             static_cast<int>(delta.size()));
+  return ApplyDelta(&input, message);
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
@@ -0,0 +1,118 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Compact binary patches between two versions of a message.
+//
+// ComputeMessageDelta() compares two messages of the same type field by field
+// and returns a patch that ApplyMessageDelta() turns the older message into
+// the newer one with.  A patch only carries the fields that differ: a field
+// that was set or cleared, a splice of the elements that changed in the middle
+// of a repeated field, the entries added to or erased from a map, and, for a
+// sub-message present in both versions, a nested patch.  Replicating a large
+// message after a small change therefore costs about as much as the change,
+// not the message, and applying the patch mutates the message in place.
+//
+// The patch is itself encoded in the protocol buffer wire format:
+//
+//   message MessageDelta {
+//     repeated FieldDelta field = 1;
+//   }
+//   message FieldDelta {
+//     uint32 number = 1;  // 0 stands for the unknown fields.
+//     oneof op {
+//       bool clear = 2;
+//       // The field as serialized, which replaces the old value.
+//       bytes set = 3;
+//       // For a singular message field present in both versions.
+//       MessageDelta patch = 4;
+//       Splice splice = 5;
+//       MapDelta map = 6;
+//     }
+//   }
+//   // Replaces `remove` elements, starting at index `start`, by the elements
+//   // serialized in `insert`.
+//   message Splice {
+//     uint32 start = 1;
+//     uint32 remove = 2;
+//     bytes insert = 3;
+//   }
+//   // `put` holds map entries to add or replace, serialized as the map field,
+//   // and `erase` holds the keys to erase, serialized as entries.
+//   message MapDelta {
+//     bytes put = 1;
+//     bytes erase = 2;
+//   }
+//
+// Field values are compared exactly: floating point fields by their bits, and
+// messages in repeated fields and map values by their deterministic
+// serialization.  A patch only applies to a message equal to the `from`
+// message it was computed against.
+//
+// Example:
+//   // Leader:
+//   std::string delta = util::ComputeMessageDelta(last_sent, state);
+//   // Follower:
+//   absl::Status status = util::ApplyMessageDelta(delta, &state);
+
+#ifndef GOOGLE_PROTOBUF_UTIL_MESSAGE_DELTA_H__
+#define GOOGLE_PROTOBUF_UTIL_MESSAGE_DELTA_H__
+
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/message.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+// Returns a patch that turns `from` into `to`, which must have the same
+// descriptor.  The patch is empty if the messages are equal.
+PROTOBUF_EXPORT std::string ComputeMessageDelta(const Message& from,
+                                                const Message& to);
+
+// Applies a patch computed by ComputeMessageDelta() to `message`.  Returns an
+// InvalidArgument error if the patch is malformed or does not fit the type or
+// the contents of `message`, in which case `message` may have been partially
+// modified.
+PROTOBUF_EXPORT absl::Status ApplyMessageDelta(absl::string_view delta,
+                                               Message* message);
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_MESSAGE_DELTA_H__
@@ -0,0 +1,224 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/util/message_delta.h"
+
+#include <memory>
+#include <string>
+
+#include <gtest/gtest.h>
+#include "absl/status/status.h"
+#include "google/protobuf/map_test_util.h"
+#include "google/protobuf/map_unittest.pb.h"
+#include "google/protobuf/test_util.h"
+#include "google/protobuf/unittest.pb.h"
+#include "google/protobuf/util/message_differencer.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+using ::protobuf_unittest::TestAllExtensions;
+using ::protobuf_unittest::TestAllTypes;
+using ::protobuf_unittest::TestMap;
+using ::protobuf_unittest::TestPackedTypes;
+
+// Checks that the delta from `from` to `to` turns a copy of `from` into `to`,
+// and returns its size.
+size_t ExpectDeltaApplies(const Message& from, const Message& to) {
+  std::string delta = ComputeMessageDelta(from, to);
+  std::unique_ptr<Message> patched(from.New());
+  patched->CopyFrom(from);
+  EXPECT_TRUE(ApplyMessageDelta(delta, patched.get()).ok());
+  EXPECT_TRUE(MessageDifferencer::Equals(*patched, to))
+      << "Expected: " << to.DebugString()
+      << "\nPatched: " << patched->DebugString();
+  return delta.size();
+}
+
+TEST(MessageDeltaTest, EqualMessagesHaveEmptyDelta) {
+  TestAllTypes a;
+  TestAllTypes b;
+  EXPECT_EQ(ComputeMessageDelta(a, b), "");
+  TestUtil::SetAllFields(&a);
+  TestUtil::SetAllFields(&b);
+  EXPECT_EQ(ComputeMessageDelta(a, b), "");
+}
+
+TEST(MessageDeltaTest, SetsAndClearsAllFields) {
+  TestAllTypes empty;
+  TestAllTypes full;
+  TestUtil::SetAllFields(&full);
+  ExpectDeltaApplies(empty, full);
+  ExpectDeltaApplies(full, empty);
+
+  TestAllTypes modified = full;
+  TestUtil::ModifyRepeatedFields(&modified);
+  modified.set_optional_int32(-5);
+  modified.set_optional_double(-0.0);
+  modified.set_optional_string("changed");
+  modified.mutable_optional_nested_message()->set_bb(7);
+  modified.clear_optional_foreign_message();
+  ExpectDeltaApplies(full, modified);
+  ExpectDeltaApplies(modified, full);
+}
+
+TEST(MessageDeltaTest, Extensions) {
+  TestAllExtensions empty;
+  TestAllExtensions full;
+  TestUtil::SetAllExtensions(&full);
+  ExpectDeltaApplies(empty, full);
+  ExpectDeltaApplies(full, empty);
+
+  TestAllExtensions modified = full;
+  TestUtil::ModifyRepeatedExtensions(&modified);
+  ExpectDeltaApplies(full, modified);
+}
+
+TEST(MessageDeltaTest, PackedFields) {
+  TestPackedTypes from;
+  TestUtil::SetPackedFields(&from);
+  TestPackedTypes to = from;
+  to.add_packed_int32(1);
+  to.set_packed_double(0, 3.5);
+  ExpectDeltaApplies(from, to);
+}
+
+TEST(MessageDeltaTest, SmallChangeToLargeMessage) {
+  TestAllTypes from;
+  for (int i = 0; i < 1000; ++i) {
+    from.add_repeated_nested_message()->set_bb(i);
+    from.add_repeated_string(std::string(20, 'a' + i % 26));
+  }
+  from.mutable_optional_nested_message()->set_bb(1);
+  TestAllTypes to = from;
+  to.mutable_repeated_nested_message(500)->set_bb(5000);
+  to.mutable_optional_nested_message()->set_bb(2);
+  EXPECT_LT(ExpectDeltaApplies(from, to), 40);
+  EXPECT_GT(from.ByteSizeLong(), 20000);
+}
+
+TEST(MessageDeltaTest, SplicesRepeatedFields) {
+  TestAllTypes from;
+  for (int i = 0; i < 10; ++i) {
+    from.add_repeated_int32(i);
+    from.add_repeated_string(std::to_string(i));
+    from.add_repeated_nested_message()->set_bb(i);
+  }
+
+  TestAllTypes appended = from;
+  appended.add_repeated_int32(10);
+  appended.add_repeated_string("10");
+  appended.add_repeated_nested_message()->set_bb(10);
+  ExpectDeltaApplies(from, appended);
+  // Truncation.
+  ExpectDeltaApplies(appended, from);
+
+  TestAllTypes inserted = from;
+  inserted.mutable_repeated_int32()->Add(0);
+  inserted.mutable_repeated_string()->Add("x");
+  inserted.add_repeated_nested_message()->set_bb(-1);
+  for (int i = inserted.repeated_int32_size() - 1; i > 3; --i) {
+    inserted.mutable_repeated_int32()->SwapElements(i, i - 1);
+    inserted.mutable_repeated_string()->SwapElements(i, i - 1);
+    inserted.mutable_repeated_nested_message()->SwapElements(i, i - 1);
+  }
+  ExpectDeltaApplies(from, inserted);
+  // Removal.
+  ExpectDeltaApplies(inserted, from);
+
+  TestAllTypes replaced = from;
+  replaced.mutable_repeated_int32()->Truncate(2);
+  replaced.add_repeated_int32(100);
+  replaced.mutable_repeated_nested_message()->DeleteSubrange(4, 3);
+  ExpectDeltaApplies(from, replaced);
+  ExpectDeltaApplies(replaced, from);
+}
+
+TEST(MessageDeltaTest, Maps) {
+  TestMap from;
+  MapTestUtil::SetMapFields(&from);
+  TestMap to = from;
+  MapTestUtil::ModifyMapFields(&to);
+  (*to.mutable_map_int32_int32())[100] = 1;
+  to.mutable_map_int32_double()->erase(0);
+  (*to.mutable_map_int32_foreign_message())[0].set_c(5);
+  ExpectDeltaApplies(from, to);
+  ExpectDeltaApplies(to, from);
+  ExpectDeltaApplies(TestMap(), to);
+  ExpectDeltaApplies(to, TestMap());
+}
+
+TEST(MessageDeltaTest, Oneofs) {
+  TestAllTypes from;
+  from.mutable_oneof_nested_message()->set_bb(1);
+  TestAllTypes to;
+  to.set_oneof_uint32(2);
+  ExpectDeltaApplies(from, to);
+  ExpectDeltaApplies(to, from);
+}
+
+TEST(MessageDeltaTest, UnknownFields) {
+  TestAllTypes from;
+  from.mutable_unknown_fields()->AddVarint(1000, 1);
+  TestAllTypes to;
+  to.mutable_unknown_fields()->AddVarint(1000, 2);
+  to.mutable_unknown_fields()->AddLengthDelimited(1001, "x");
+  ExpectDeltaApplies(from, to);
+  ExpectDeltaApplies(to, from);
+  ExpectDeltaApplies(to, TestAllTypes());
+}
+
+TEST(MessageDeltaTest, RejectsMalformedDeltas) {
+  TestAllTypes message;
+  EXPECT_EQ(ApplyMessageDelta("garbage", &message).code(),
+            absl::StatusCode::kInvalidArgument);
+
+  // A splice past the end of the field it applies to.
+  TestAllTypes from;
+  from.add_repeated_int32(1);
+  from.add_repeated_int32(2);
+  TestAllTypes to;
+  to.add_repeated_int32(1);
+  std::string delta = ComputeMessageDelta(from, to);
+  EXPECT_EQ(ApplyMessageDelta(delta, &message).code(),
+            absl::StatusCode::kInvalidArgument);
+
+  // A truncated delta.
+  std::string truncated = delta.substr(0, delta.size() - 1);
+  EXPECT_EQ(ApplyMessageDelta(truncated, &from).code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
@@ -35,9 +35,11 @@
 #include "google/protobuf/util/message_differencer.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <iterator>
 #include <limits>
 #include <memory>
 #include <utility>
@@ -45,15 +47,18 @@
 #include "google/protobuf/descriptor.pb.h"
 #include "absl/container/fixed_array.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/hash/hash.h"
 #include "absl/log/absl_check.h"
 #include "absl/log/absl_log.h"
 #include "absl/strings/escaping.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/synchronization/blocking_counter.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/dynamic_message.h"
 #include "google/protobuf/generated_enum_reflection.h"
+#include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/printer.h"
 #include "google/protobuf/io/zero_copy_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl.h"
@@ -88,6 +93,60 @@ std::string PrintShortTextFormat(const google::protobuf::Message& message) {
   return debug_string;
 }
 
+// Hashes the value of `field` in `message` (element `index` if the field is
+// repeated) so that values that serialize the same hash the same.
+size_t HashFieldValue(const Message& message, const FieldDescriptor* field,
+                      int index) {
+  const Reflection* reflection = message.GetReflection();
+  const bool repeated = field->is_repeated();
+  switch (field->cpp_type()) {
+#define HASH_FIELD_VALUE(CPPTYPE, METHOD)                             \
+  case FieldDescriptor::CPPTYPE_##CPPTYPE:                            \
+    return absl::HashOf(                                              \
+        repeated ? reflection->GetRepeated##METHOD(message, field, index) \
+                 : reflection->Get##METHOD(message, field));
+    HASH_FIELD_VALUE(INT32, Int32)
+    HASH_FIELD_VALUE(INT64, Int64)
+    HASH_FIELD_VALUE(UINT32, UInt32)
+    HASH_FIELD_VALUE(UINT64, UInt64)
+    HASH_FIELD_VALUE(BOOL, Bool)
+    HASH_FIELD_VALUE(ENUM, EnumValue)
+#undef HASH_FIELD_VALUE
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      // Adding zero folds -0.0 into 0.0, which compare equal.
+      return absl::HashOf(
+          (repeated ? reflection->GetRepeatedFloat(message, field, index)
+                    : reflection->GetFloat(message, field)) +
+          0.0f);
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      return absl::HashOf(
+          (repeated ? reflection->GetRepeatedDouble(message, field, index)
+                    : reflection->GetDouble(message, field)) +
+          0.0);
+    case FieldDescriptor::CPPTYPE_STRING: {
+      std::string scratch;
+      return absl::HashOf(
+          repeated ? reflection->GetRepeatedStringReference(message, field,
+                                                            index, &scratch)
+                   : reflection->GetStringReference(message, field, &scratch));
+    }
+    case FieldDescriptor::CPPTYPE_MESSAGE: {
+      const Message& value =
+          repeated ? reflection->GetRepeatedMessage(message, field, index)
+                   : reflection->GetMessage(message, field);
+      std::string serialized;
+      {
+        io::StringOutputStream output(&serialized);
+        io::CodedOutputStream coded(&output);
+        coded.SetSerializationDeterministic(true);
+        value.SerializePartialToCodedStream(&coded);
+      }
+      return absl::HashOf(serialized);
+    }
+  }
+  return 0;
+}
+
 }  // namespace
 
 // A reporter to report the total number of diffs.
@@ -172,6 +231,30 @@ class MessageDifferencer::MultipleFieldsMapKeyComparator
     return true;
   }
 
+  // Hashes the key fields of `message` such that elements with equal keys
+  // hash the same.  Repeated key fields do not contribute.
+  size_t HashKey(const Message& message) const {
+    size_t hash = 0;
+    for (const auto& path : key_field_paths_) {
+      const Message* current = &message;
+      for (const FieldDescriptor* field : path) {
+        if (field->is_repeated()) break;
+        if (field != path.back()) {
+          if (!current->GetReflection()->HasField(*current, field)) break;
+          current = &current->GetReflection()->GetMessage(*current, field);
+          continue;
+        }
+        hash = absl::HashOf(hash, HashFieldValue(*current, field, -1));
+      }
+    }
+    return hash;
+  }
+
+  const std::vector<std::vector<const FieldDescriptor*> >& key_field_paths()
+      const {
+    return key_field_paths_;
+  }
+
  private:
   bool IsMatchInternal(
       const Message& message1, const Message& message2, int unpacked_any,
@@ -556,6 +639,17 @@ bool MessageDifferencer::Compare(const Message& message1,
   force_compare_no_presence_fields_.clear();
   force_compare_failure_triggering_fields_.clear();
 
+  absl::flat_hash_set<const FieldDescriptor*> parallel_equal_fields;
+  if (CanCompareInParallel(message1, message2)) {
+    if (!CompareFieldsInParallel(message1, message2, &parallel_equal_fields) &&
+        reporter_ == nullptr && output_string_ == nullptr) {
+      return false;
+    }
+    parallel_equal_fields_ = &parallel_equal_fields;
+    parallel_message1_ = &message1;
+    parallel_message2_ = &message2;
+  }
+
   bool result = false;
   // Setup the internal reporter if need be.
   if (output_string_) {
@@ -568,6 +662,9 @@ bool MessageDifferencer::Compare(const Message& message1,
   } else {
     result = Compare(message1, message2, false, &parent_fields);
   }
+  parallel_equal_fields_ = nullptr;
+  parallel_message1_ = nullptr;
+  parallel_message2_ = nullptr;
   return result;
 }
 
@@ -961,6 +1058,15 @@ bool MessageDifferencer::CompareWithFieldsInternal(
       continue;
     }
 
+    // Already compared equal on another thread; nothing to report.
+    if (parallel_equal_fields_ != nullptr && &message1 == parallel_message1_ &&
+        &message2 == parallel_message2_ &&
+        parallel_equal_fields_->contains(field1)) {
+      ++field_index1;
+      ++field_index2;
+      continue;
+    }
+
     bool fieldDifferent = false;
     assert(field1 != NULL);
     if (field1->is_map()) {
@@ -1414,6 +1520,211 @@ bool MessageDifferencer::CompareFieldValueUsingParentFields(
   }
 }
 
+namespace {
+
+// Repeated fields compared as lists are split into ranges of at least this
+// many elements when compared with set_parallel_executor().
+constexpr int kMinParallelCompareElements = 1024;
+
+}  // namespace
+
+struct MessageDifferencer::ParallelCompareTask {
+  // A field set in both messages, or elements [begin, end) of a repeated
+  // field compared as a list.  `begin` is -1 for a whole field.
+  struct Item {
+    const FieldDescriptor* field;
+    int begin;
+    int end;
+    bool equal;
+  };
+
+  MessageDifferencer* parent;
+  const Message* message1;
+  const Message* message2;
+  std::vector<Item>* items;
+  std::atomic<size_t>* next_item;
+  // Non-null if the remaining items can be skipped once one differs.
+  std::atomic<bool>* difference_found;
+  absl::BlockingCounter* done;
+
+  void CompareItems() const {
+    MessageDifferencer differencer;
+    differencer.InheritSettingsFrom(parent);
+    std::vector<SpecificField> parent_fields;
+    for (size_t i = next_item->fetch_add(1); i < items->size();
+         i = next_item->fetch_add(1)) {
+      if (difference_found != nullptr &&
+          difference_found->load(std::memory_order_relaxed)) {
+        return;
+      }
+      Item& item = (*items)[i];
+      if (item.begin >= 0) {
+        item.equal = true;
+        for (int j = item.begin; j < item.end && item.equal; ++j) {
+          item.equal = differencer.CompareFieldValueUsingParentFields(
+              *message1, *message2, 0, item.field, j, j, &parent_fields);
+        }
+      } else if (item.field->is_map()) {
+        item.equal = differencer.CompareMapField(*message1, *message2, 0,
+                                                 item.field, &parent_fields);
+      } else if (item.field->is_repeated()) {
+        item.equal = differencer.CompareRepeatedField(
+            *message1, *message2, 0, item.field, &parent_fields);
+      } else {
+        item.equal = differencer.CompareFieldValueUsingParentFields(
+            *message1, *message2, 0, item.field, -1, -1, &parent_fields);
+      }
+      if (!item.equal && difference_found != nullptr) {
+        difference_found->store(true, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  static void Run(void* arg) {
+    auto* task = static_cast<ParallelCompareTask*>(arg);
+    task->CompareItems();
+    task->done->DecrementCount();
+  }
+};
+
+bool MessageDifferencer::CanCompareInParallel(const Message& message1,
+                                              const Message& message2) {
+  if (parallel_executor_ == nullptr || parallel_max_tasks_ < 2 ||
+      parallel_equal_fields_ != nullptr) {
+    return false;
+  }
+  const Descriptor* descriptor = message1.GetDescriptor();
+  if (descriptor != message2.GetDescriptor() ||
+      descriptor->full_name() == internal::kAnyFullTypeName) {
+    return false;
+  }
+  // Everything the tasks call into must be owned by this differencer, so that
+  // it can be recreated or safely shared across threads.
+  if (field_comparator_kind_ != kFCDefault || !ignore_criteria_.empty() ||
+      force_compare_no_presence_) {
+    return false;
+  }
+  for (const auto& entry : map_field_key_comparator_) {
+    if (std::find(owned_key_comparators_.begin(), owned_key_comparators_.end(),
+                  entry.second) == owned_key_comparators_.end()) {
+      return false;
+    }
+  }
+  if (reporter_ != nullptr || output_string_ != nullptr) {
+    // Skipping equal fields must not drop any report.  Moves are only
+    // reported for pairs matched as a set or by key, never for proto maps.
+    const bool may_report_moves =
+        report_moves_ &&
+        (repeated_field_comparison_ != AS_LIST ||
+         !repeated_field_comparisons_.empty() ||
+         !map_field_key_comparator_.empty());
+    if (report_matches_ || may_report_moves ||
+        (report_ignores_ && !ignored_fields_.empty())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool MessageDifferencer::CompareFieldsInParallel(
+    const Message& message1, const Message& message2,
+    absl::flat_hash_set<const FieldDescriptor*>* equal_fields) {
+  const Reflection* reflection1 = message1.GetReflection();
+  const Reflection* reflection2 = message2.GetReflection();
+  std::vector<const FieldDescriptor*> fields1;
+  std::vector<const FieldDescriptor*> fields2;
+  reflection1->ListFields(message1, &fields1);
+  reflection2->ListFields(message2, &fields2);
+  std::vector<const FieldDescriptor*> common_fields;
+  std::set_intersection(fields1.begin(), fields1.end(), fields2.begin(),
+                        fields2.end(), std::back_inserter(common_fields),
+                        FieldBefore);
+
+  bool all_equal = true;
+  std::vector<ParallelCompareTask::Item> items;
+  const std::vector<SpecificField> no_parent_fields;
+  for (const FieldDescriptor* field : common_fields) {
+    if (IsIgnored(message1, message2, field, no_parent_fields)) continue;
+    const bool simple_list = field->is_repeated() && !field->is_map() &&
+                             GetMapKeyComparator(field) == nullptr &&
+                             !IsTreatedAsSet(field) &&
+                             !IsTreatedAsSmartSet(field) &&
+                             !IsTreatedAsSmartList(field);
+    if (!simple_list) {
+      items.push_back({field, -1, -1, false});
+      continue;
+    }
+    const int count = reflection1->FieldSize(message1, field);
+    if (count != reflection2->FieldSize(message2, field)) {
+      all_equal = false;
+      continue;
+    }
+    const int num_ranges = std::max(1, count / kMinParallelCompareElements);
+    for (int i = 0; i < num_ranges; ++i) {
+      items.push_back(
+          {field, static_cast<int>(int64_t{count} * i / num_ranges),
+           static_cast<int>(int64_t{count} * (i + 1) / num_ranges), false});
+    }
+  }
+  if (items.empty()) return all_equal;
+
+  const bool stop_at_difference =
+      reporter_ == nullptr && output_string_ == nullptr;
+  if (!all_equal && stop_at_difference) return false;
+
+  // The calling thread compares items too while the executor runs the other
+  // tasks.
+  const int num_tasks = static_cast<int>(
+      std::min<size_t>(parallel_max_tasks_, items.size()));
+  std::atomic<size_t> next_item{0};
+  std::atomic<bool> difference_found{false};
+  absl::BlockingCounter done(num_tasks - 1);
+  std::vector<ParallelCompareTask> tasks(
+      num_tasks,
+      {this, &message1, &message2, &items, &next_item,
+       stop_at_difference ? &difference_found : nullptr, &done});
+  for (int i = 1; i < num_tasks; ++i) {
+    parallel_executor_(&ParallelCompareTask::Run, &tasks[i]);
+  }
+  tasks[0].CompareItems();
+  done.Wait();
+
+  // Items of the same field are adjacent.
+  for (size_t i = 0; i < items.size();) {
+    const FieldDescriptor* field = items[i].field;
+    bool field_equal = true;
+    for (; i < items.size() && items[i].field == field; ++i) {
+      field_equal &= items[i].equal;
+    }
+    if (field_equal) {
+      equal_fields->insert(field);
+    } else {
+      all_equal = false;
+    }
+  }
+  return all_equal;
+}
+
+void MessageDifferencer::InheritSettingsFrom(MessageDifferencer* parent) {
+  message_field_comparison_ = parent->message_field_comparison_;
+  scope_ = parent->scope_;
+  repeated_field_comparison_ = parent->repeated_field_comparison_;
+  // Key comparators refer back to their differencer, so make new ones.
+  for (const auto& entry : parent->map_field_key_comparator_) {
+    TreatAsMapWithMultipleFieldPathsAsKey(
+        entry.first,
+        static_cast<const MultipleFieldsMapKeyComparator*>(entry.second)
+            ->key_field_paths());
+  }
+  repeated_field_comparisons_ = parent->repeated_field_comparisons_;
+  ignored_fields_ = parent->ignored_fields_;
+  // DefaultFieldComparator::Compare() does not modify the comparator.
+  set_field_comparator(parent->field_comparator_.default_impl);
+  match_repeated_fields_by_hash_ = parent->match_repeated_fields_by_hash_;
+  match_indices_for_smart_list_callback_ =
+      parent->match_indices_for_smart_list_callback_;
+}
+
 bool MessageDifferencer::CheckPathChanged(
     const std::vector<SpecificField>& field_path) {
   for (const SpecificField& specific_field : field_path) {
@@ -1526,15 +1837,23 @@ bool MessageDifferencer::UnpackAnyField::UnpackAny(
   if (!internal::GetAnyFieldDescriptors(any, &type_url_field, &value_field)) {
     return false;
   }
-  const std::string& type_url = reflection->GetString(any, type_url_field);
-  std::string full_type_name;
-  if (!internal::ParseAnyTypeUrl(type_url, &full_type_name)) {
-    return false;
+  std::string scratch;
+  const std::string& type_url =
+      reflection->GetStringReference(any, type_url_field, &scratch);
+  const DescriptorPool* pool = any.GetDescriptor()->file()->pool();
+  auto& pool_cache = descriptor_cache_[pool];
+  const Descriptor* desc;
+  auto it = pool_cache.find(type_url);
+  if (it != pool_cache.end()) {
+    desc = it->second;
+  } else {
+    absl::string_view full_type_name;
+    if (!internal::SplitAnyTypeUrl(type_url, nullptr, &full_type_name)) {
+      return false;
+    }
+    desc = pool->FindMessageTypeByName(full_type_name);
+    pool_cache.emplace(type_url, desc);
   }
-
-  const Descriptor* desc =
-      any.GetDescriptor()->file()->pool()->FindMessageTypeByName(
-          full_type_name);
   if (desc == NULL) {
     return false;
   }
@@ -1543,9 +1862,10 @@ bool MessageDifferencer::UnpackAnyField::UnpackAny(
     dynamic_message_factory_.reset(new DynamicMessageFactory());
   }
   data->reset(dynamic_message_factory_->GetPrototype(desc)->New());
-  std::string serialized_value = reflection->GetString(any, value_field);
+  const std::string& serialized_value =
+      reflection->GetStringReference(any, value_field, &scratch);
   if (!(*data)->ParsePartialFromString(serialized_value)) {
-    ABSL_DLOG(ERROR) << "Failed to parse value for " << full_type_name;
+    ABSL_DLOG(ERROR) << "Failed to parse value for " << desc->full_name();
     return false;
   }
   return true;
@@ -1946,7 +2266,17 @@ bool MessageDifferencer::MatchRepeatedFieldIndices(
         }
       }
     }
+    if (match_repeated_fields_by_hash_ && !is_treated_as_smart_set &&
+        !IsTreatedAsSmartList(repeated_field)) {
+      MatchRepeatedFieldIndicesByHash(message1, message2, unpacked_any,
+                                      repeated_field, key_comparator,
+                                      parent_fields, start_offset, match_list1,
+                                      match_list2);
+    }
     for (int i = start_offset; i < count1; ++i) {
+      // Elements already paired up by hash.
+      if (match_list1->at(i) != -1) continue;
+
       // Indicates any matched elements for this repeated field.
       bool match = false;
       int matched_j = -1;
@@ -2020,6 +2350,69 @@ bool MessageDifferencer::MatchRepeatedFieldIndices(
   return success;
 }
 
+void MessageDifferencer::MatchRepeatedFieldIndicesByHash(
+    const Message& message1, const Message& message2, int unpacked_any,
+    const FieldDescriptor* repeated_field,
+    const MapKeyComparator* key_comparator,
+    const std::vector<SpecificField>& parent_fields, int start_offset,
+    std::vector<int>* match_list1, std::vector<int>* match_list2) {
+  const MultipleFieldsMapKeyComparator* fields_key_comparator = nullptr;
+  if (key_comparator != nullptr &&
+      key_comparator != &map_entry_key_comparator_) {
+    // Only the comparators built by TreatAsMap() and friends know their keys.
+    if (std::find(owned_key_comparators_.begin(), owned_key_comparators_.end(),
+                  key_comparator) == owned_key_comparators_.end()) {
+      return;
+    }
+    fields_key_comparator =
+        static_cast<const MultipleFieldsMapKeyComparator*>(key_comparator);
+  }
+  auto element_hash = [&](const Message& message, int index) -> size_t {
+    if (key_comparator == nullptr) {
+      return HashFieldValue(message, repeated_field, index);
+    }
+    const Message& element =
+        message.GetReflection()->GetRepeatedMessage(message, repeated_field,
+                                                    index);
+    if (fields_key_comparator != nullptr) {
+      return fields_key_comparator->HashKey(element);
+    }
+    return HashFieldValue(element, element.GetDescriptor()->map_key(), -1);
+  };
+
+  // Elements of message2 by hash, in index order.  `first_unmatched` skips
+  // the matched prefix so runs of equal elements are paired in linear time.
+  struct Bucket {
+    std::vector<int> indices;
+    size_t first_unmatched = 0;
+  };
+  const int count1 = static_cast<int>(match_list1->size());
+  const int count2 = static_cast<int>(match_list2->size());
+  absl::flat_hash_map<size_t, Bucket> buckets;
+  for (int j = start_offset; j < count2; ++j) {
+    buckets[element_hash(message2, j)].indices.push_back(j);
+  }
+  for (int i = start_offset; i < count1; ++i) {
+    auto it = buckets.find(element_hash(message1, i));
+    if (it == buckets.end()) continue;
+    Bucket& bucket = it->second;
+    while (bucket.first_unmatched < bucket.indices.size() &&
+           match_list2->at(bucket.indices[bucket.first_unmatched]) != -1) {
+      ++bucket.first_unmatched;
+    }
+    for (size_t k = bucket.first_unmatched; k < bucket.indices.size(); ++k) {
+      const int j = bucket.indices[k];
+      if (match_list2->at(j) != -1) continue;
+      if (IsMatch(repeated_field, key_comparator, &message1, &message2,
+                  unpacked_any, parent_fields, nullptr, i, j)) {
+        match_list1->at(i) = j;
+        match_list2->at(j) = i;
+        break;
+      }
+    }
+  }
+}
+
 FieldComparator::ComparisonResult MessageDifferencer::GetFieldComparisonResult(
     const Message& message1, const Message& message2,
     const FieldDescriptor* field, int index1, int index2,
@@ -55,6 +55,7 @@
 #include "absl/log/absl_check.h"
 #include "google/protobuf/descriptor.h"  // FieldDescriptor
 #include "google/protobuf/message.h"     // Message
+#include "google/protobuf/port.h"
 #include "google/protobuf/unknown_field_set.h"
 #include "google/protobuf/util/field_comparator.h"
 
@@ -604,6 +605,39 @@ class PROTOBUF_EXPORT MessageDifferencer {
   // in the comparison.
   void set_force_compare_no_presence(bool value);
 
+  // When set, elements of repeated fields compared as sets (TreatAsSet()) or
+  // as maps (TreatAsMap() and friends) are first bucketed by a hash of their
+  // value, or of their key fields, and each element of message1 is compared
+  // with the elements in its own bucket before any others.  When most
+  // elements have an exact counterpart this makes matching near-linear
+  // instead of quadratic, at the cost of hashing every element.  Elements
+  // that find no match in their bucket fall back to the pairwise search, so
+  // no match is lost; with inexact comparisons (float margins, ignored
+  // fields, ...) a different but equally valid pairing may be chosen.  Has no
+  // effect in PARTIAL scope, on smart sets and smart lists, or with custom
+  // MapKeyComparators.  The default is false.
+  void set_match_repeated_fields_by_hash(bool value) {
+    match_repeated_fields_by_hash_ = value;
+  }
+
+  // If `executor` is non-null and `max_tasks` is at least 2, Compare() first
+  // compares the fields set in both top-level messages, splitting large
+  // repeated fields compared as lists into ranges, in up to `max_tasks`
+  // concurrent tasks.  The usual serial comparison then skips the fields found
+  // equal, so the result and the calls made on the Reporter are exactly those
+  // of a serial comparison, in the same order.  Compare() blocks until all
+  // tasks have run.
+  //
+  // The comparison stays serial when a FieldComparator other than a
+  // DefaultFieldComparator, an IgnoreCriteria or a MapKeyComparator from
+  // TreatAsMapUsingKeyComparator() is set, with
+  // set_force_compare_no_presence(), and when a Reporter would be told about
+  // fields that compare equal (matches, moves or ignored fields).
+  void set_parallel_executor(internal::Executor executor, int max_tasks) {
+    parallel_executor_ = executor;
+    parallel_max_tasks_ = max_tasks;
+  }
+
   // DEPRECATED. Pass a DefaultFieldComparator instance instead.
   // Sets the type of comparison (as defined in the FloatComparison enumeration
   // above) that is used by this differencer when comparing float (and double)
@@ -662,6 +696,12 @@ class PROTOBUF_EXPORT MessageDifferencer {
   class UnpackAnyField {
    private:
     std::unique_ptr<DynamicMessageFactory> dynamic_message_factory_;
+    // Pool -> type URL -> payload descriptor, so that repeated unpacking of
+    // the same type skips URL parsing and the pool lookup.  The same URL can
+    // name different descriptors in Any messages from different pools.
+    absl::flat_hash_map<const DescriptorPool*,
+                        absl::flat_hash_map<std::string, const Descriptor*>>
+        descriptor_cache_;
 
    public:
     UnpackAnyField() = default;
@@ -933,6 +973,33 @@ class PROTOBUF_EXPORT MessageDifferencer {
       const std::vector<SpecificField>& parent_fields,
       std::vector<int>* match_list1, std::vector<int>* match_list2);
 
+  // Helper for MatchRepeatedFieldIndices() when
+  // set_match_repeated_fields_by_hash() is on: pairs up elements from
+  // `start_offset` onwards that match an element with an equal hash.
+  void MatchRepeatedFieldIndicesByHash(
+      const Message& message1, const Message& message2, int unpacked_any,
+      const FieldDescriptor* repeated_field,
+      const MapKeyComparator* key_comparator,
+      const std::vector<SpecificField>& parent_fields, int start_offset,
+      std::vector<int>* match_list1, std::vector<int>* match_list2);
+
+  // A unit of work for set_parallel_executor(); defined in the .cc file.
+  struct ParallelCompareTask;
+
+  // Returns true if Compare(message1, message2) may use parallel_executor_.
+  bool CanCompareInParallel(const Message& message1, const Message& message2);
+
+  // Compares the fields set in both messages using parallel_executor_ and
+  // adds those found equal to `equal_fields`.  Returns false if any of them
+  // differ.
+  bool CompareFieldsInParallel(
+      const Message& message1, const Message& message2,
+      absl::flat_hash_set<const FieldDescriptor*>* equal_fields);
+
+  // Copies the comparison settings of `parent` into this freshly constructed
+  // differencer, for use on another thread.
+  void InheritSettingsFrom(MessageDifferencer* parent);
+
   // Checks if index is equal to new_index in all the specific fields.
   static bool CheckPathChanged(const std::vector<SpecificField>& parent_fields);
 
@@ -978,6 +1045,16 @@ class PROTOBUF_EXPORT MessageDifferencer {
   bool report_moves_;
   bool report_ignores_;
   bool force_compare_no_presence_ = false;
+  bool match_repeated_fields_by_hash_ = false;
+
+  internal::Executor parallel_executor_ = nullptr;
+  int parallel_max_tasks_ = 0;
+  // Set during a Compare() that used parallel_executor_: the fields of
+  // parallel_message1_ and parallel_message2_ already known to be equal.
+  const absl::flat_hash_set<const FieldDescriptor*>* parallel_equal_fields_ =
+      nullptr;
+  const Message* parallel_message1_ = nullptr;
+  const Message* parallel_message2_ = nullptr;
 
   std::string* output_string_;
 
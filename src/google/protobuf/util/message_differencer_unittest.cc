@@ -39,6 +39,7 @@
 #include <algorithm>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
 #include <vector>
 
 #include "google/protobuf/stubs/common.h"
@@ -51,7 +52,10 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
+#include "google/protobuf/any.pb.h"
 #include "google/protobuf/any_test.pb.h"
+#include "google/protobuf/descriptor.pb.h"
+#include "google/protobuf/dynamic_message.h"
 #include "google/protobuf/map_test_util.h"
 #include "google/protobuf/map_unittest.pb.h"
 #include "google/protobuf/test_util.h"
@@ -1766,6 +1770,154 @@ TEST(MessageDifferencerTest, RepeatedFieldSetTest_Duplicates) {
   EXPECT_FALSE(differencer1.Compare(c, a));
 }
 
+TEST(MessageDifferencerTest, RepeatedFieldSetTest_MatchByHash) {
+  protobuf_unittest::TestDiffMessage msg1;
+  protobuf_unittest::TestDiffMessage msg2;
+  for (int i = 0; i < 500; ++i) {
+    msg1.add_item()->set_a(i % 100);
+    msg2.add_item()->set_a(99 - i % 100);
+    msg1.add_rv(i);
+    msg2.add_rv(499 - i);
+  }
+  // Nested sets in a different order serialize differently, so these only
+  // match through the pairwise fallback.
+  protobuf_unittest::TestDiffMessage::Item* item = msg1.add_item();
+  item->add_ra(1);
+  item->add_ra(2);
+  item = msg2.add_item();
+  item->add_ra(2);
+  item->add_ra(1);
+
+  util::MessageDifferencer differencer;
+  differencer.set_repeated_field_comparison(util::MessageDifferencer::AS_SET);
+  differencer.set_match_repeated_fields_by_hash(true);
+  EXPECT_TRUE(differencer.Compare(msg1, msg2));
+
+  msg2.mutable_item(7)->set_a(-1);
+  msg2.set_rv(3, -1);
+  std::string expected;
+  std::string diff;
+  util::MessageDifferencer reference;
+  reference.set_repeated_field_comparison(util::MessageDifferencer::AS_SET);
+  reference.ReportDifferencesToString(&expected);
+  EXPECT_FALSE(reference.Compare(msg1, msg2));
+  differencer.ReportDifferencesToString(&diff);
+  EXPECT_FALSE(differencer.Compare(msg1, msg2));
+  EXPECT_EQ(expected, diff);
+}
+
+TEST(MessageDifferencerTest, RepeatedFieldMapTest_MatchByHash) {
+  protobuf_unittest::TestDiffMessage msg1;
+  protobuf_unittest::TestDiffMessage msg2;
+  for (int i = 0; i < 500; ++i) {
+    protobuf_unittest::TestDiffMessage::Item* item = msg1.add_item();
+    item->set_a(i);
+    item->set_b(absl::StrCat(i));
+    item = msg2.add_item();
+    item->set_a(499 - i);
+    item->set_b(absl::StrCat(499 - i));
+  }
+  msg2.mutable_item(10)->set_b("changed");
+
+  std::string expected;
+  std::string diff;
+  util::MessageDifferencer reference;
+  reference.TreatAsMap(GetFieldDescriptor(msg1, "item"),
+                       GetFieldDescriptor(msg1, "item.a"));
+  reference.ReportDifferencesToString(&expected);
+  EXPECT_FALSE(reference.Compare(msg1, msg2));
+
+  util::MessageDifferencer differencer;
+  differencer.TreatAsMap(GetFieldDescriptor(msg1, "item"),
+                         GetFieldDescriptor(msg1, "item.a"));
+  differencer.set_match_repeated_fields_by_hash(true);
+  differencer.ReportDifferencesToString(&diff);
+  EXPECT_FALSE(differencer.Compare(msg1, msg2));
+  EXPECT_EQ(expected, diff);
+  EXPECT_THAT(diff, testing::HasSubstr(
+                        "modified: item[489].b -> item[10].b: \"489\" -> "
+                        "\"changed\"\n"));
+}
+
+std::vector<std::thread>* compare_threads = nullptr;
+
+void ThreadExecutor(void (*task)(void*), void* arg) {
+  compare_threads->emplace_back(task, arg);
+}
+
+TEST(MessageDifferencerTest, ParallelCompareMatchesSerialCompare) {
+  unittest::TestAllTypes msg1;
+  TestUtil::SetAllFields(&msg1);
+  for (int i = 0; i < 5000; ++i) {
+    msg1.add_repeated_nested_message()->set_bb(i);
+    msg1.add_repeated_int64(i);
+  }
+  unittest::TestAllTypes msg2 = msg1;
+
+  for (bool report : {false, true}) {
+    SCOPED_TRACE(report);
+    util::MessageDifferencer serial;
+    std::string expected;
+    if (report) serial.ReportDifferencesToString(&expected);
+    const bool expected_result = serial.Compare(msg1, msg2);
+
+    std::vector<std::thread> threads;
+    compare_threads = &threads;
+    util::MessageDifferencer differencer;
+    differencer.set_parallel_executor(&ThreadExecutor, 4);
+    std::string diff;
+    if (report) differencer.ReportDifferencesToString(&diff);
+    const bool result = differencer.Compare(msg1, msg2);
+    compare_threads = nullptr;
+    EXPECT_EQ(threads.size(), 3);
+    for (auto& thread : threads) thread.join();
+    EXPECT_EQ(expected_result, result);
+    EXPECT_EQ(expected, diff);
+
+    // Differences in a singular field, in one range of a large repeated
+    // field, in a field set on one side only and in unknown fields.
+    msg2.set_optional_int32(-1);
+    msg2.mutable_repeated_nested_message(4321)->set_bb(-1);
+    msg2.clear_optional_string();
+    msg2.mutable_unknown_fields()->AddVarint(123456, 1);
+  }
+}
+
+TEST(MessageDifferencerTest, ParallelCompareWithTreatAsMap) {
+  protobuf_unittest::TestDiffMessage msg1;
+  for (int i = 0; i < 100; ++i) {
+    protobuf_unittest::TestDiffMessage::Item* item = msg1.add_item();
+    item->set_a(i);
+    item->set_b(absl::StrCat(i));
+  }
+  msg1.set_w("w");
+  protobuf_unittest::TestDiffMessage msg2 = msg1;
+  msg2.mutable_item(7)->set_b("changed");
+
+  std::string expected;
+  util::MessageDifferencer serial;
+  serial.TreatAsMap(GetFieldDescriptor(msg1, "item"),
+                    GetFieldDescriptor(msg1, "item.a"));
+  serial.set_report_moves(false);
+  serial.ReportDifferencesToString(&expected);
+  EXPECT_FALSE(serial.Compare(msg1, msg2));
+
+  std::vector<std::thread> threads;
+  compare_threads = &threads;
+  std::string diff;
+  util::MessageDifferencer differencer;
+  differencer.TreatAsMap(GetFieldDescriptor(msg1, "item"),
+                         GetFieldDescriptor(msg1, "item.a"));
+  differencer.set_report_moves(false);
+  differencer.set_parallel_executor(&ThreadExecutor, 4);
+  differencer.ReportDifferencesToString(&diff);
+  EXPECT_FALSE(differencer.Compare(msg1, msg2));
+  compare_threads = nullptr;
+  EXPECT_EQ(threads.size(), 1);
+  for (auto& thread : threads) thread.join();
+  EXPECT_EQ(expected, diff);
+}
+
 TEST(MessageDifferencerTest, RepeatedFieldSetTest_PartialSimple) {
   protobuf_unittest::TestDiffMessage a, b, c;
   // message a: {
@@ -4039,6 +4191,64 @@ TEST(Anytest, TreatAsSet_DifferentType) {
   EXPECT_TRUE(message_differencer.Compare(m1, m2));
 }
 
+TEST(AnyTest, SameTypeUrlInDifferentPools) {
+  // Both pools define foo.Payload, with differently named fields.
+  DescriptorPool pool1, pool2;
+  FileDescriptorProto any_file;
+  Any::descriptor()->file()->CopyTo(&any_file);
+  FileDescriptorProto file1, file2;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      R"pb(
+        name: "payload.proto"
+        package: "foo"
+        dependency: "google/protobuf/any.proto"
+        message_type {
+          name: "Payload"
+          field { name: "a" number: 1 label: LABEL_OPTIONAL type: TYPE_INT32 }
+        }
+        message_type {
+          name: "Holder"
+          field {
+            name: "any"
+            number: 1
+            label: LABEL_OPTIONAL
+            type: TYPE_MESSAGE
+            type_name: ".google.protobuf.Any"
+          }
+        }
+      )pb",
+      &file1));
+  file2 = file1;
+  file2.mutable_message_type(0)->mutable_field(0)->set_name("b");
+  ASSERT_NE(pool1.BuildFile(any_file), nullptr);
+  ASSERT_NE(pool1.BuildFile(file1), nullptr);
+  ASSERT_NE(pool2.BuildFile(any_file), nullptr);
+  ASSERT_NE(pool2.BuildFile(file2), nullptr);
+
+  DynamicMessageFactory factory;
+  auto make = [&](const DescriptorPool& pool, absl::string_view text) {
+    std::unique_ptr<Message> m(
+        factory.GetPrototype(pool.FindMessageTypeByName("foo.Holder"))->New());
+    ABSL_CHECK(TextFormat::ParseFromString(text, m.get()));
+    return m;
+  };
+  auto m1 = make(pool1, "any { [type.googleapis.com/foo.Payload] { a: 1 } }");
+  auto m2 = make(pool1, "any { [type.googleapis.com/foo.Payload] { a: 2 } }");
+  auto m3 = make(pool2, "any { [type.googleapis.com/foo.Payload] { b: 1 } }");
+  auto m4 = make(pool2, "any { [type.googleapis.com/foo.Payload] { b: 2 } }");
+
+  // One differencer, so the second comparison must not reuse the payload
+  // descriptor unpacked for the first.
+  util::MessageDifferencer message_differencer;
+  std::string difference_string;
+  message_differencer.ReportDifferencesToString(&difference_string);
+  EXPECT_FALSE(message_differencer.Compare(*m1, *m2));
+  EXPECT_EQ("modified: any.a: 1 -> 2\n", difference_string);
+  difference_string.clear();
+  EXPECT_FALSE(message_differencer.Compare(*m3, *m4));
+  EXPECT_EQ("modified: any.b: 1 -> 2\n", difference_string);
+}
+
 
 }  // namespace
 }  // namespace protobuf
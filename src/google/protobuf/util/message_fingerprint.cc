@@ -0,0 +1,373 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/util/message_fingerprint.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "absl/base/casts.h"
+#include "absl/numeric/int128.h"
+#include "absl/strings/string_view.h"
+#include "absl/log/absl_log.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/map_field.h"
+#include "google/protobuf/message.h"
+#include "google/protobuf/unknown_field_set.h"
+#include "google/protobuf/util/field_comparator.h"
+#include "google/protobuf/util/message_differencer.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+// The constants only need to be fixed forever; changing any of them changes
+// every stored fingerprint.
+constexpr uint64_t kSeedLow = 0x243f6a8885a308d3;
+constexpr uint64_t kSeedHigh = 0x13198a2e03707344;
+constexpr uint64_t kMul = 0x9ddfea08eb382d69;
+
+// The 64-bit finalizer of MurmurHash3: a bijection in which every input bit
+// affects every output bit.
+inline uint64_t Mix(uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccd;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53;
+  x ^= x >> 33;
+  return x;
+}
+
+inline uint64_t Load64(const char* p) {
+  uint64_t value;
+  memcpy(&value, p, sizeof(value));
+#ifndef PROTOBUF_LITTLE_ENDIAN
+  value = bswap_64(value);
+#endif
+  return value;
+}
+
+}  // namespace
+
+// Accumulates values into two independent 64-bit lanes.  Sub-messages and
+// map entries are fingerprinted separately and added as a single value, so
+// the encoding of a message is unambiguous without any length prefixes for
+// the message itself.  A friend of Reflection, for its map API.
+class MessageFingerprinter {
+ public:
+  void AddMessage(const Message& message);
+
+  absl::uint128 Finish() const {
+    return absl::MakeUint128(Mix(high_ + low_ * kMul), Mix(low_ ^ high_));
+  }
+
+ private:
+  void Add(uint64_t value) {
+    low_ = Mix(low_ ^ value);
+    high_ = Mix(high_ + value * kMul);
+  }
+
+  void Add(absl::uint128 value) {
+    Add(absl::Uint128Low64(value));
+    Add(absl::Uint128High64(value));
+  }
+
+  void AddSigned(int64_t value) { Add(static_cast<uint64_t>(value)); }
+
+  void AddDouble(double value) {
+    if (value == 0) {
+      value = 0;  // -0.0 == 0.0
+    } else if (std::isnan(value)) {
+      // Every NaN is the same value, as in MessageEquals.
+      value = std::numeric_limits<double>::quiet_NaN();
+    }
+    Add(absl::bit_cast<uint64_t>(value));
+  }
+
+  void AddBytes(absl::string_view bytes) {
+    Add(bytes.size());
+    const char* p = bytes.data();
+    size_t size = bytes.size();
+    for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t)) {
+      Add(Load64(p));
+      p += sizeof(uint64_t);
+    }
+    if (size > 0) {
+      char tail[sizeof(uint64_t)] = {};
+      memcpy(tail, p, size);
+      Add(Load64(tail));
+    }
+  }
+
+  void AddField(const Message& message, const FieldDescriptor* field);
+  void AddMap(const Message& message, const FieldDescriptor* field);
+  void AddValue(const Message& message, const FieldDescriptor* field,
+                int index);
+  void AddMapKey(const MapKey& key);
+  void AddMapValue(const FieldDescriptor* field,
+                   const MapValueConstRef& value);
+  void AddUnknownFields(const UnknownFieldSet& unknown_fields);
+
+  uint64_t low_ = kSeedLow;
+  uint64_t high_ = kSeedHigh;
+};
+
+namespace {
+
+absl::uint128 Fingerprint(const Message& message) {
+  MessageFingerprinter fingerprinter;
+  fingerprinter.AddMessage(message);
+  return fingerprinter.Finish();
+}
+
+}  // namespace
+
+void MessageFingerprinter::AddMessage(const Message& message) {
+  const Reflection* reflection = message.GetReflection();
+  std::vector<const FieldDescriptor*> fields;
+  // Sorted by field number, extensions included.
+  reflection->ListFields(message, &fields);
+  for (const FieldDescriptor* field : fields) {
+    Add(static_cast<uint64_t>(field->number()));
+    AddField(message, field);
+  }
+  Add(fields.size());
+  AddUnknownFields(reflection->GetUnknownFields(message));
+}
+
+void MessageFingerprinter::AddField(const Message& message,
+                                    const FieldDescriptor* field) {
+  const Reflection* reflection = message.GetReflection();
+  if (!field->is_repeated()) {
+    AddValue(message, field, -1);
+    return;
+  }
+  if (field->is_map()) {
+    AddMap(message, field);
+    return;
+  }
+  const int size = reflection->FieldSize(message, field);
+  Add(static_cast<uint64_t>(size));
+  for (int i = 0; i < size; ++i) {
+    AddValue(message, field, i);
+  }
+}
+
+// Reads the map itself rather than its entry messages, so that an entry's
+// fingerprint does not depend on whether its key or value was explicitly set,
+// and a key that occurs several times in the wire form counts once.
+void MessageFingerprinter::AddMap(const Message& message,
+                                  const FieldDescriptor* field) {
+  const Reflection* reflection = message.GetReflection();
+  Message* mutable_message = const_cast<Message*>(&message);
+  Add(static_cast<uint64_t>(reflection->MapSize(message, field)));
+  // Entries are summed so that their order does not matter.
+  absl::uint128 sum = 0;
+  for (MapIterator it = reflection->MapBegin(mutable_message, field);
+       it != reflection->MapEnd(mutable_message, field); ++it) {
+    MessageFingerprinter entry;
+    entry.AddMapKey(it.GetKey());
+    entry.AddMapValue(field->message_type()->map_value(), it.GetValueRef());
+    sum += entry.Finish();
+  }
+  Add(sum);
+}
+
+void MessageFingerprinter::AddMapKey(const MapKey& key) {
+  switch (key.type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      AddSigned(key.GetInt32Value());
+      break;
+    case FieldDescriptor::CPPTYPE_INT64:
+      AddSigned(key.GetInt64Value());
+      break;
+    case FieldDescriptor::CPPTYPE_UINT32:
+      Add(key.GetUInt32Value());
+      break;
+    case FieldDescriptor::CPPTYPE_UINT64:
+      Add(key.GetUInt64Value());
+      break;
+    case FieldDescriptor::CPPTYPE_BOOL:
+      Add(key.GetBoolValue());
+      break;
+    case FieldDescriptor::CPPTYPE_STRING:
+      AddBytes(key.GetStringValue());
+      break;
+    default:
+      ABSL_DLOG(FATAL) << "Invalid key for map field.";
+      break;
+  }
+}
+
+void MessageFingerprinter::AddMapValue(const FieldDescriptor* field,
+                                       const MapValueConstRef& value) {
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      AddSigned(value.GetInt32Value());
+      break;
+    case FieldDescriptor::CPPTYPE_INT64:
+      AddSigned(value.GetInt64Value());
+      break;
+    case FieldDescriptor::CPPTYPE_UINT32:
+      Add(value.GetUInt32Value());
+      break;
+    case FieldDescriptor::CPPTYPE_UINT64:
+      Add(value.GetUInt64Value());
+      break;
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      AddDouble(value.GetDoubleValue());
+      break;
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      AddDouble(value.GetFloatValue());
+      break;
+    case FieldDescriptor::CPPTYPE_BOOL:
+      Add(value.GetBoolValue());
+      break;
+    case FieldDescriptor::CPPTYPE_ENUM:
+      AddSigned(value.GetEnumValue());
+      break;
+    case FieldDescriptor::CPPTYPE_STRING:
+      AddBytes(value.GetStringValue());
+      break;
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      Add(Fingerprint(value.GetMessageValue()));
+      break;
+  }
+}
+
+void MessageFingerprinter::AddValue(const Message& message,
+                             const FieldDescriptor* field, int index) {
+  const Reflection* reflection = message.GetReflection();
+  const bool repeated = index >= 0;
+  switch (field->cpp_type()) {
+#define HANDLE_TYPE(CPPTYPE, METHOD, ADD)                                  \
+  case FieldDescriptor::CPPTYPE_##CPPTYPE:                                 \
+    ADD(repeated ? reflection->GetRepeated##METHOD(message, field, index)  \
+                 : reflection->Get##METHOD(message, field));               \
+    break;
+
+    HANDLE_TYPE(INT32, Int32, AddSigned)
+    HANDLE_TYPE(INT64, Int64, AddSigned)
+    HANDLE_TYPE(UINT32, UInt32, Add)
+    HANDLE_TYPE(UINT64, UInt64, Add)
+    HANDLE_TYPE(DOUBLE, Double, AddDouble)
+    HANDLE_TYPE(FLOAT, Float, AddDouble)
+    HANDLE_TYPE(BOOL, Bool, Add)
+    HANDLE_TYPE(ENUM, EnumValue, AddSigned)
+#undef HANDLE_TYPE
+
+    case FieldDescriptor::CPPTYPE_STRING: {
+      std::string scratch;
+      AddBytes(repeated ? reflection->GetRepeatedStringReference(
+                              message, field, index, &scratch)
+                        : reflection->GetStringReference(message, field,
+                                                         &scratch));
+      break;
+    }
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      Add(Fingerprint(
+          repeated ? reflection->GetRepeatedMessage(message, field, index)
+                   : reflection->GetMessage(message, field)));
+      break;
+  }
+}
+
+void MessageFingerprinter::AddUnknownFields(
+    const UnknownFieldSet& unknown_fields) {
+  // Like MessageDifferencer, ignore the order of unknown fields with
+  // different numbers but keep that of repeated occurrences of a number.
+  std::vector<const UnknownField*> fields;
+  fields.reserve(unknown_fields.field_count());
+  for (int i = 0; i < unknown_fields.field_count(); ++i) {
+    fields.push_back(&unknown_fields.field(i));
+  }
+  std::stable_sort(fields.begin(), fields.end(),
+                   [](const UnknownField* a, const UnknownField* b) {
+                     return a->number() < b->number();
+                   });
+  for (const UnknownField* field : fields) {
+    Add(static_cast<uint64_t>(field->number()));
+    Add(static_cast<uint64_t>(field->type()));
+    switch (field->type()) {
+      case UnknownField::TYPE_VARINT:
+        Add(field->varint());
+        break;
+      case UnknownField::TYPE_FIXED32:
+        Add(field->fixed32());
+        break;
+      case UnknownField::TYPE_FIXED64:
+        Add(field->fixed64());
+        break;
+      case UnknownField::TYPE_LENGTH_DELIMITED:
+        AddBytes(field->length_delimited());
+        break;
+      case UnknownField::TYPE_GROUP: {
+        MessageFingerprinter group;
+        group.AddUnknownFields(field->group());
+        Add(group.Finish());
+        break;
+      }
+    }
+  }
+  Add(fields.size());
+}
+
+uint64_t MessageFingerprint64(const Message& message) {
+  return absl::Uint128Low64(Fingerprint(message));
+}
+
+absl::uint128 MessageFingerprint128(const Message& message) {
+  return Fingerprint(message);
+}
+
+bool MessageEquals::operator()(const Message& a, const Message& b) const {
+  // A message holding a NaN must equal itself, or a container could never
+  // find it again.
+  DefaultFieldComparator comparator;
+  comparator.set_treat_nan_as_equal(true);
+  MessageDifferencer differencer;
+  differencer.set_field_comparator(&comparator);
+  return differencer.Compare(a, b);
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
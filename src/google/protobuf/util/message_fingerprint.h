@@ -0,0 +1,92 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Stable fingerprints of messages, computed from their fields rather than
+// from their serialized form.
+//
+// Deduplicating messages by hashing the output of deterministic serialization
+// costs a full serialization and a string allocation per message.  The
+// functions below read the fields through reflection instead and never build
+// a buffer.  Fields are visited in field number order, map entries are
+// combined independently of their order, and -0.0 and 0.0 hash alike, so
+// messages that MessageDifferencer::Equals() considers equal have the same
+// fingerprint.
+//
+// All NaNs hash alike.  MessageDifferencer::Equals() never considers a NaN
+// equal to anything, so MessageEquals instead treats NaNs as equal to each
+// other; otherwise a message holding one could not be found in a container.
+//
+// Fingerprints depend only on field numbers, types and values, not on names,
+// the process or the build, so they can be stored and compared across
+// binaries.  They are not cryptographic.
+//
+// Example:
+//   absl::flat_hash_set<Request, util::MessageHash, util::MessageEquals> seen;
+//   if (!seen.insert(request).second) return;  // Duplicate.
+
+#ifndef GOOGLE_PROTOBUF_UTIL_MESSAGE_FINGERPRINT_H__
+#define GOOGLE_PROTOBUF_UTIL_MESSAGE_FINGERPRINT_H__
+
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/numeric/int128.h"
+#include "google/protobuf/message.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+PROTOBUF_EXPORT uint64_t MessageFingerprint64(const Message& message);
+PROTOBUF_EXPORT absl::uint128 MessageFingerprint128(const Message& message);
+
+// Hash functor for hash containers keyed by messages.
+struct MessageHash {
+  size_t operator()(const Message& message) const {
+    return static_cast<size_t>(MessageFingerprint64(message));
+  }
+};
+
+// Equality functor consistent with MessageHash: MessageDifferencer::Equals(),
+// except that NaNs are equal to each other.
+struct PROTOBUF_EXPORT MessageEquals {
+  bool operator()(const Message& a, const Message& b) const;
+};
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_MESSAGE_FINGERPRINT_H__
@@ -0,0 +1,211 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "google/protobuf/util/message_fingerprint.h"
+
+#include <cstdint>
+#include <limits>
+
+#include <gtest/gtest.h>
+#include "absl/container/flat_hash_set.h"
+#include "google/protobuf/map_test_util.h"
+#include "google/protobuf/map_unittest.pb.h"
+#include "google/protobuf/test_util.h"
+#include "google/protobuf/unittest.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+using ::protobuf_unittest::TestAllExtensions;
+using ::protobuf_unittest::TestAllTypes;
+using ::protobuf_unittest::TestMap;
+
+TEST(MessageFingerprintTest, EqualMessagesHaveEqualFingerprints) {
+  TestAllTypes a;
+  TestAllTypes b;
+  EXPECT_EQ(MessageFingerprint128(a), MessageFingerprint128(b));
+
+  TestUtil::SetAllFields(&a);
+  EXPECT_NE(MessageFingerprint128(a), MessageFingerprint128(b));
+  ASSERT_TRUE(b.ParseFromString(a.SerializeAsString()));
+  EXPECT_EQ(MessageFingerprint128(a), MessageFingerprint128(b));
+  EXPECT_EQ(MessageFingerprint64(a), MessageFingerprint64(b));
+
+  TestAllExtensions extensions;
+  TestUtil::SetAllExtensions(&extensions);
+  TestAllExtensions parsed;
+  ASSERT_TRUE(parsed.ParseFromString(extensions.SerializeAsString()));
+  EXPECT_EQ(MessageFingerprint128(extensions), MessageFingerprint128(parsed));
+}
+
+TEST(MessageFingerprintTest, SetOrderDoesNotMatter) {
+  TestAllTypes a;
+  a.set_optional_int32(1);
+  a.set_optional_string("x");
+  TestAllTypes b;
+  b.set_optional_string("x");
+  b.set_optional_int32(1);
+  EXPECT_EQ(MessageFingerprint128(a), MessageFingerprint128(b));
+}
+
+TEST(MessageFingerprintTest, DistinguishesValues) {
+  TestAllTypes a;
+  TestAllTypes b;
+  a.set_optional_int32(1);
+  b.set_optional_int64(1);
+  EXPECT_NE(MessageFingerprint128(a), MessageFingerprint128(b));
+
+  // Values are not concatenated ambiguously.
+  a.Clear();
+  b.Clear();
+  a.add_repeated_string("ab");
+  a.add_repeated_string("c");
+  b.add_repeated_string("a");
+  b.add_repeated_string("bc");
+  EXPECT_NE(MessageFingerprint128(a), MessageFingerprint128(b));
+
+  a.Clear();
+  b.Clear();
+  a.mutable_optional_nested_message()->set_bb(1);
+  b.mutable_optional_foreign_message()->set_c(1);
+  EXPECT_NE(MessageFingerprint128(a), MessageFingerprint128(b));
+}
+
+TEST(MessageFingerprintTest, NegativeZeroEqualsZero) {
+  TestAllTypes a;
+  TestAllTypes b;
+  a.set_optional_double(0.0);
+  b.set_optional_double(-0.0);
+  EXPECT_EQ(MessageFingerprint128(a), MessageFingerprint128(b));
+}
+
+TEST(MessageFingerprintTest, MapOrderDoesNotMatter) {
+  // Entries added through reflection keep their order in the repeated
+  // representation that reflection iterates.
+  const FieldDescriptor* field =
+      TestMap::descriptor()->FindFieldByName("map_int32_int32");
+  auto add_entry = [field](TestMap& map, int32_t key, int32_t value) {
+    Message* entry = map.GetReflection()->AddMessage(&map, field);
+    const Descriptor* descriptor = entry->GetDescriptor();
+    entry->GetReflection()->SetInt32(entry, descriptor->map_key(), key);
+    entry->GetReflection()->SetInt32(entry, descriptor->map_value(), value);
+  };
+  TestMap a;
+  add_entry(a, 1, 10);
+  add_entry(a, 2, 20);
+  TestMap b;
+  add_entry(b, 2, 20);
+  add_entry(b, 1, 10);
+  EXPECT_EQ(MessageFingerprint128(a), MessageFingerprint128(b));
+
+  TestMap c;
+  add_entry(c, 1, 20);
+  add_entry(c, 2, 10);
+  EXPECT_NE(MessageFingerprint128(a), MessageFingerprint128(c));
+
+  TestMap full;
+  MapTestUtil::SetMapFields(&full);
+  TestMap parsed;
+  ASSERT_TRUE(parsed.ParseFromString(full.SerializeAsString()));
+  EXPECT_EQ(MessageFingerprint128(full), MessageFingerprint128(parsed));
+}
+
+TEST(MessageFingerprintTest, MapEntriesAreReadThroughTheMap) {
+  const FieldDescriptor* field =
+      TestMap::descriptor()->FindFieldByName("map_int32_int32");
+  const Descriptor* entry_descriptor = field->message_type();
+  auto add_entry = [&](TestMap& map, int32_t key, bool set_value) {
+    Message* entry = map.GetReflection()->AddMessage(&map, field);
+    entry->GetReflection()->SetInt32(entry, entry_descriptor->map_key(), key);
+    if (set_value) {
+      entry->GetReflection()->SetInt32(entry, entry_descriptor->map_value(),
+                                       0);
+    }
+  };
+  // An entry with the default value is the same whether or not the value was
+  // set explicitly.
+  TestMap a;
+  add_entry(a, 1, false);
+  TestMap b;
+  add_entry(b, 1, true);
+  EXPECT_EQ(MessageFingerprint128(a), MessageFingerprint128(b));
+
+  // A repeated key counts once, like in the map.
+  add_entry(b, 1, true);
+  EXPECT_EQ(MessageFingerprint128(a), MessageFingerprint128(b));
+}
+
+TEST(MessageFingerprintTest, NaNsAreEqual) {
+  TestAllTypes a;
+  a.set_optional_double(std::numeric_limits<double>::quiet_NaN());
+  TestAllTypes b;
+  b.set_optional_double(-std::numeric_limits<double>::quiet_NaN());
+  EXPECT_EQ(MessageFingerprint128(a), MessageFingerprint128(b));
+  EXPECT_TRUE(MessageEquals()(a, a));
+  EXPECT_TRUE(MessageEquals()(a, b));
+
+  absl::flat_hash_set<TestAllTypes, MessageHash, MessageEquals> set;
+  EXPECT_TRUE(set.insert(a).second);
+  EXPECT_FALSE(set.insert(b).second);
+  EXPECT_TRUE(set.contains(a));
+
+  TestMap map;
+  (*map.mutable_map_int32_double())[1] =
+      std::numeric_limits<double>::quiet_NaN();
+  EXPECT_TRUE(MessageEquals()(map, map));
+}
+
+TEST(MessageFingerprintTest, UnknownFieldsCount) {
+  TestAllTypes a;
+  TestAllTypes b;
+  a.mutable_unknown_fields()->AddVarint(1000, 1);
+  EXPECT_NE(MessageFingerprint128(a), MessageFingerprint128(b));
+  b.mutable_unknown_fields()->AddVarint(1000, 1);
+  EXPECT_EQ(MessageFingerprint128(a), MessageFingerprint128(b));
+}
+
+TEST(MessageFingerprintTest, HashContainer) {
+  TestAllTypes a;
+  a.set_optional_int32(1);
+  TestAllTypes b = a;
+  absl::flat_hash_set<TestAllTypes, MessageHash, MessageEquals> set;
+  EXPECT_TRUE(set.insert(a).second);
+  EXPECT_FALSE(set.insert(b).second);
+  b.set_optional_int32(2);
+  EXPECT_TRUE(set.insert(b).second);
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,340 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "google/protobuf/util/message_view.h"
+
+#include <climits>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/log/absl_check.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/wire_format_lite.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+using internal::WireFormatLite;
+
+namespace {
+
+WireFormatLite::WireType ExpectedWireType(const FieldDescriptor* field) {
+  return WireFormatLite::WireTypeForFieldType(
+      static_cast<WireFormatLite::FieldType>(field->type()));
+}
+
+bool WireTypeMatches(const FieldDescriptor* field, int wire_type) {
+  return wire_type == ExpectedWireType(field) ||
+         (field->is_packable() &&
+          wire_type == WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+}
+
+// Reads one scalar of `wire_type` from `input`.
+bool ReadRaw(io::CodedInputStream* input, int wire_type, uint64_t* raw) {
+  switch (wire_type) {
+    case WireFormatLite::WIRETYPE_VARINT:
+      return input->ReadVarint64(raw);
+    case WireFormatLite::WIRETYPE_FIXED64:
+      return input->ReadLittleEndian64(raw);
+    case WireFormatLite::WIRETYPE_FIXED32: {
+      uint32_t value;
+      if (!input->ReadLittleEndian32(&value)) return false;
+      *raw = value;
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+io::CodedInputStream InputFor(absl::string_view data) {
+  return io::CodedInputStream(reinterpret_cast<const uint8_t*>(data.data()),
+                              static_cast<int>(data.size()));
+}
+
+template <typename T>
+T FromRaw(const FieldDescriptor* field, uint64_t raw) {
+  switch (field->type()) {
+    case FieldDescriptor::TYPE_SINT32:
+      return static_cast<T>(
+          WireFormatLite::ZigZagDecode32(static_cast<uint32_t>(raw)));
+    case FieldDescriptor::TYPE_SINT64:
+      return static_cast<T>(WireFormatLite::ZigZagDecode64(raw));
+    case FieldDescriptor::TYPE_FLOAT:
+      return static_cast<T>(
+          WireFormatLite::DecodeFloat(static_cast<uint32_t>(raw)));
+    case FieldDescriptor::TYPE_DOUBLE:
+      return static_cast<T>(WireFormatLite::DecodeDouble(raw));
+    case FieldDescriptor::TYPE_BOOL:
+      return static_cast<T>(raw != 0);
+    case FieldDescriptor::TYPE_INT32:
+    case FieldDescriptor::TYPE_SFIXED32:
+    case FieldDescriptor::TYPE_ENUM:
+      return static_cast<T>(static_cast<int32_t>(raw));
+    case FieldDescriptor::TYPE_UINT32:
+    case FieldDescriptor::TYPE_FIXED32:
+      return static_cast<T>(static_cast<uint32_t>(raw));
+    default:
+      return static_cast<T>(raw);
+  }
+}
+
+}  // namespace
+
+MessageView::MessageView(const Descriptor* descriptor, absl::string_view data)
+    : MessageView(descriptor, data, nullptr) {}
+
+MessageView::MessageView(const Descriptor* descriptor, absl::string_view data,
+                         std::shared_ptr<const std::string> owned)
+    : descriptor_(descriptor), data_(data), owned_(std::move(owned)) {}
+
+bool MessageView::ok() const {
+  EnsureIndexed();
+  return ok_;
+}
+
+void MessageView::EnsureIndexed() const {
+  if (indexed_) return;
+  indexed_ = true;
+  if (data_.size() > INT_MAX) {
+    ok_ = false;
+    return;
+  }
+
+  io::CodedInputStream input = InputFor(data_);
+  while (true) {
+    const int position = input.CurrentPosition();
+    const uint32_t tag = input.ReadTag();
+    if (tag == 0) {
+      ok_ = input.ConsumedEntireMessage();
+      break;
+    }
+    const int number = WireFormatLite::GetTagFieldNumber(tag);
+    const int wire_type = WireFormatLite::GetTagWireType(tag);
+    int start = input.CurrentPosition();
+    int size;
+    switch (wire_type) {
+      case WireFormatLite::WIRETYPE_VARINT:
+      case WireFormatLite::WIRETYPE_FIXED64:
+      case WireFormatLite::WIRETYPE_FIXED32: {
+        uint64_t unused;
+        ok_ = ReadRaw(&input, wire_type, &unused);
+        size = input.CurrentPosition() - start;
+        break;
+      }
+      case WireFormatLite::WIRETYPE_LENGTH_DELIMITED: {
+        uint32_t length;
+        ok_ = input.ReadVarint32(&length) &&
+              input.Skip(static_cast<int>(length));
+        start = input.CurrentPosition() - static_cast<int>(length);
+        size = static_cast<int>(length);
+        break;
+      }
+      case WireFormatLite::WIRETYPE_START_GROUP:
+        // The payload is everything up to, but excluding, the end tag.
+        ok_ = WireFormatLite::SkipField(&input, tag);
+        size = input.CurrentPosition() - start -
+               io::CodedOutputStream::VarintSize32(WireFormatLite::MakeTag(
+                   number, WireFormatLite::WIRETYPE_END_GROUP));
+        break;
+      default:
+        ok_ = false;
+        break;
+    }
+    if (!ok_) break;
+
+    // Occurrences whose wire type does not match the field are unknown
+    // fields as far as parsing is concerned.
+    const FieldDescriptor* field = descriptor_->FindFieldByNumber(number);
+    if (field != nullptr && !WireTypeMatches(field, wire_type)) continue;
+    FieldIndex& entry = index_[number];
+    entry.occurrences.push_back({wire_type, data_.substr(start, size)});
+    entry.last_position = position;
+  }
+  if (!ok_) index_.clear();
+}
+
+const MessageView::FieldIndex* MessageView::Find(
+    const FieldDescriptor* field) const {
+  ABSL_DCHECK(field->containing_type() == descriptor_)
+      << field->full_name() << " is not a field of "
+      << descriptor_->full_name();
+  EnsureIndexed();
+  auto it = index_.find(field->number());
+  return it == index_.end() ? nullptr : &it->second;
+}
+
+bool MessageView::Has(const FieldDescriptor* field) const {
+  ABSL_DCHECK(!field->is_repeated());
+  const FieldIndex* entry = Find(field);
+  if (entry == nullptr) return false;
+  if (const OneofDescriptor* oneof = field->real_containing_oneof()) {
+    for (int i = 0; i < oneof->field_count(); ++i) {
+      const FieldIndex* other = Find(oneof->field(i));
+      if (other != nullptr && other->last_position > entry->last_position) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool MessageView::GetRaw(const FieldDescriptor* field, uint64_t* raw) const {
+  if (!Has(field)) return false;
+  const Occurrence& last = Find(field)->occurrences.back();
+  io::CodedInputStream input = InputFor(last.value);
+  return ReadRaw(&input, last.wire_type, raw);
+}
+
+uint64_t MessageView::GetRepeatedRaw(const FieldDescriptor* field,
+                                     int index) const {
+  ABSL_DCHECK_GE(index, 0);
+  ABSL_DCHECK_LT(index, FieldSize(field));
+  return Find(field)->values[index];
+}
+
+const std::vector<MessageView::Occurrence>& MessageView::LengthDelimited(
+    const FieldDescriptor* field) const {
+  static const auto* const kEmpty = new std::vector<Occurrence>();
+  const FieldIndex* entry = Find(field);
+  return entry == nullptr ? *kEmpty : entry->occurrences;
+}
+
+int MessageView::FieldSize(const FieldDescriptor* field) const {
+  ABSL_DCHECK(field->is_repeated());
+  const FieldIndex* entry = Find(field);
+  if (entry == nullptr) return 0;
+  if (!field->is_packable()) {
+    return static_cast<int>(entry->occurrences.size());
+  }
+  if (!entry->decoded) {
+    auto* mutable_entry = const_cast<FieldIndex*>(entry);
+    mutable_entry->decoded = true;
+    const int wire_type = ExpectedWireType(field);
+    for (const Occurrence& occurrence : entry->occurrences) {
+      io::CodedInputStream input = InputFor(occurrence.value);
+      // An unpacked occurrence holds exactly one value.
+      const bool packed =
+          occurrence.wire_type == WireFormatLite::WIRETYPE_LENGTH_DELIMITED;
+      for (int n = 0; packed ? input.BytesUntilLimit() > 0 : n < 1; ++n) {
+        uint64_t raw;
+        if (!ReadRaw(&input, wire_type, &raw)) {
+          ok_ = false;
+          break;
+        }
+        mutable_entry->values.push_back(raw);
+      }
+    }
+  }
+  return static_cast<int>(entry->values.size());
+}
+
+#define PROTOBUF_DEFINE_VIEW_ACCESSORS(NAME, TYPE, DEFAULT)                 \
+  TYPE MessageView::Get##NAME(const FieldDescriptor* field) const {         \
+    uint64_t raw;                                                           \
+    if (!GetRaw(field, &raw)) return field->DEFAULT();                      \
+    return FromRaw<TYPE>(field, raw);                                       \
+  }                                                                         \
+  TYPE MessageView::GetRepeated##NAME(const FieldDescriptor* field,         \
+                                      int index) const {                    \
+    return FromRaw<TYPE>(field, GetRepeatedRaw(field, index));              \
+  }
+
+PROTOBUF_DEFINE_VIEW_ACCESSORS(Int32, int32_t, default_value_int32)
+PROTOBUF_DEFINE_VIEW_ACCESSORS(Int64, int64_t, default_value_int64)
+PROTOBUF_DEFINE_VIEW_ACCESSORS(UInt32, uint32_t, default_value_uint32)
+PROTOBUF_DEFINE_VIEW_ACCESSORS(UInt64, uint64_t, default_value_uint64)
+PROTOBUF_DEFINE_VIEW_ACCESSORS(Float, float, default_value_float)
+PROTOBUF_DEFINE_VIEW_ACCESSORS(Double, double, default_value_double)
+PROTOBUF_DEFINE_VIEW_ACCESSORS(Bool, bool, default_value_bool)
+
+#undef PROTOBUF_DEFINE_VIEW_ACCESSORS
+
+int MessageView::GetEnumValue(const FieldDescriptor* field) const {
+  uint64_t raw;
+  if (!GetRaw(field, &raw)) return field->default_value_enum()->number();
+  return FromRaw<int>(field, raw);
+}
+
+int MessageView::GetRepeatedEnumValue(const FieldDescriptor* field,
+                                      int index) const {
+  return FromRaw<int>(field, GetRepeatedRaw(field, index));
+}
+
+absl::string_view MessageView::GetString(const FieldDescriptor* field) const {
+  if (!Has(field)) return field->default_value_string();
+  return Find(field)->occurrences.back().value;
+}
+
+absl::string_view MessageView::GetRepeatedString(const FieldDescriptor* field,
+                                                 int index) const {
+  ABSL_DCHECK_LT(index, FieldSize(field));
+  return LengthDelimited(field)[index].value;
+}
+
+MessageView MessageView::GetMessage(const FieldDescriptor* field) const {
+  const Descriptor* type = field->message_type();
+  if (!Has(field)) return MessageView(type, absl::string_view(), owned_);
+  auto* entry = const_cast<FieldIndex*>(Find(field));
+  if (entry->occurrences.size() == 1) {
+    return MessageView(type, entry->occurrences[0].value, owned_);
+  }
+  if (entry->merged == nullptr) {
+    auto merged = std::make_shared<std::string>();
+    for (const Occurrence& occurrence : entry->occurrences) {
+      merged->append(occurrence.value.data(), occurrence.value.size());
+    }
+    entry->merged = std::move(merged);
+  }
+  return MessageView(type, *entry->merged, entry->merged);
+}
+
+MessageView MessageView::GetRepeatedMessage(const FieldDescriptor* field,
+                                            int index) const {
+  ABSL_DCHECK_LT(index, FieldSize(field));
+  return MessageView(field->message_type(), LengthDelimited(field)[index].value,
+                     owned_);
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
@@ -0,0 +1,172 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// A read-only view over a serialized message that decodes fields on demand.
+//
+// Parsing a large message builds every sub-object before a single field can
+// be read.  A MessageView instead keeps the serialized bytes (for example a
+// memory-mapped file) and, on first access, records where each top-level
+// field occurs.  Length-delimited fields, including sub-messages, are skipped
+// in constant time during that scan, and values are only decoded when an
+// accessor asks for them, so the cost is roughly proportional to the number
+// of fields touched rather than the size of the data.
+//
+// Example:
+//   MessageView view(Config::descriptor(), mapped_bytes);
+//   const Descriptor* d = view.descriptor();
+//   MessageView model = view.GetMessage(d->FindFieldByName("model"));
+//   absl::string_view name = model.GetString(
+//       model.descriptor()->FindFieldByName("name"));
+//
+// Strings, bytes and sub-message views alias the underlying data, which must
+// outlive the view.  A view caches what it has decoded and is not safe to use
+// from several threads at once.
+
+#ifndef GOOGLE_PROTOBUF_UTIL_MESSAGE_VIEW_H__
+#define GOOGLE_PROTOBUF_UTIL_MESSAGE_VIEW_H__
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+class PROTOBUF_EXPORT MessageView {
+ public:
+  // `data` must hold a serialized message of type `descriptor`.  Nothing is
+  // read until the first accessor is called.
+  MessageView(const Descriptor* descriptor, absl::string_view data);
+
+  const Descriptor* descriptor() const { return descriptor_; }
+  absl::string_view data() const { return data_; }
+
+  // Returns false if the top level of the data is malformed.  Accessors on a
+  // malformed view return default values.  Sub-messages are checked when a
+  // view of them is used.
+  bool ok() const;
+
+  // Singular fields ---------------------------------------------------
+  // As with parsing, the last occurrence of a scalar field wins, and only the
+  // last field set in a oneof is present.  Unset fields return their default.
+
+  bool Has(const FieldDescriptor* field) const;
+
+  int32_t GetInt32(const FieldDescriptor* field) const;
+  int64_t GetInt64(const FieldDescriptor* field) const;
+  uint32_t GetUInt32(const FieldDescriptor* field) const;
+  uint64_t GetUInt64(const FieldDescriptor* field) const;
+  float GetFloat(const FieldDescriptor* field) const;
+  double GetDouble(const FieldDescriptor* field) const;
+  bool GetBool(const FieldDescriptor* field) const;
+  int GetEnumValue(const FieldDescriptor* field) const;
+  absl::string_view GetString(const FieldDescriptor* field) const;
+  MessageView GetMessage(const FieldDescriptor* field) const;
+
+  // Repeated fields ---------------------------------------------------
+  // Packed and unpacked encodings are both accepted.  The first access to a
+  // repeated scalar field decodes all of its elements.
+
+  int FieldSize(const FieldDescriptor* field) const;
+
+  int32_t GetRepeatedInt32(const FieldDescriptor* field, int index) const;
+  int64_t GetRepeatedInt64(const FieldDescriptor* field, int index) const;
+  uint32_t GetRepeatedUInt32(const FieldDescriptor* field, int index) const;
+  uint64_t GetRepeatedUInt64(const FieldDescriptor* field, int index) const;
+  float GetRepeatedFloat(const FieldDescriptor* field, int index) const;
+  double GetRepeatedDouble(const FieldDescriptor* field, int index) const;
+  bool GetRepeatedBool(const FieldDescriptor* field, int index) const;
+  int GetRepeatedEnumValue(const FieldDescriptor* field, int index) const;
+  absl::string_view GetRepeatedString(const FieldDescriptor* field,
+                                      int index) const;
+  MessageView GetRepeatedMessage(const FieldDescriptor* field,
+                                 int index) const;
+
+ private:
+  // One occurrence of a field on the wire.  For length-delimited values
+  // `value` is the payload; otherwise it is the encoded varint or fixed-width
+  // value.
+  struct Occurrence {
+    int wire_type;
+    absl::string_view value;
+  };
+  struct FieldIndex {
+    std::vector<Occurrence> occurrences;
+    // Position of the last occurrence in the data, used to resolve oneofs.
+    int last_position = -1;
+    // Raw wire values of a repeated scalar field, decoded on first access.
+    bool decoded = false;
+    std::vector<uint64_t> values;
+    // Payloads of a singular sub-message that occurs several times,
+    // concatenated, which is how the wire format merges them.
+    std::shared_ptr<const std::string> merged;
+  };
+
+  MessageView(const Descriptor* descriptor, absl::string_view data,
+              std::shared_ptr<const std::string> owned);
+
+  // Scans the top level of the data once and records every occurrence.
+  void EnsureIndexed() const;
+  const FieldIndex* Find(const FieldDescriptor* field) const;
+
+  // Returns the raw wire value of a singular scalar field, or false if the
+  // field is not present.
+  bool GetRaw(const FieldDescriptor* field, uint64_t* raw) const;
+  uint64_t GetRepeatedRaw(const FieldDescriptor* field, int index) const;
+  const std::vector<Occurrence>& LengthDelimited(
+      const FieldDescriptor* field) const;
+
+  const Descriptor* descriptor_;
+  absl::string_view data_;
+
+  mutable bool indexed_ = false;
+  mutable bool ok_ = true;
+  mutable absl::flat_hash_map<int, FieldIndex> index_;
+  // Keeps merged sub-message data that `data_` points into alive.
+  std::shared_ptr<const std::string> owned_;
+};
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_MESSAGE_VIEW_H__
@@ -0,0 +1,219 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "google/protobuf/util/message_view.h"
+
+#include <string>
+
+#include <gtest/gtest.h>
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+#include "google/protobuf/test_util.h"
+#include "google/protobuf/unittest.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+using ::protobuf_unittest::TestAllTypes;
+
+// Checks every non-message field of `view` against `message` via reflection.
+void ExpectMatches(const Message& message, const MessageView& view) {
+  const Reflection* reflection = message.GetReflection();
+  const Descriptor* descriptor = message.GetDescriptor();
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    const FieldDescriptor* field = descriptor->field(i);
+    SCOPED_TRACE(field->full_name());
+    if (field->is_repeated()) {
+      const int size = reflection->FieldSize(message, field);
+      ASSERT_EQ(view.FieldSize(field), size);
+      for (int j = 0; j < size; ++j) {
+        switch (field->cpp_type()) {
+          case FieldDescriptor::CPPTYPE_INT32:
+            EXPECT_EQ(view.GetRepeatedInt32(field, j),
+                      reflection->GetRepeatedInt32(message, field, j));
+            break;
+          case FieldDescriptor::CPPTYPE_INT64:
+            EXPECT_EQ(view.GetRepeatedInt64(field, j),
+                      reflection->GetRepeatedInt64(message, field, j));
+            break;
+          case FieldDescriptor::CPPTYPE_UINT32:
+            EXPECT_EQ(view.GetRepeatedUInt32(field, j),
+                      reflection->GetRepeatedUInt32(message, field, j));
+            break;
+          case FieldDescriptor::CPPTYPE_UINT64:
+            EXPECT_EQ(view.GetRepeatedUInt64(field, j),
+                      reflection->GetRepeatedUInt64(message, field, j));
+            break;
+          case FieldDescriptor::CPPTYPE_FLOAT:
+            EXPECT_EQ(view.GetRepeatedFloat(field, j),
+                      reflection->GetRepeatedFloat(message, field, j));
+            break;
+          case FieldDescriptor::CPPTYPE_DOUBLE:
+            EXPECT_EQ(view.GetRepeatedDouble(field, j),
+                      reflection->GetRepeatedDouble(message, field, j));
+            break;
+          case FieldDescriptor::CPPTYPE_BOOL:
+            EXPECT_EQ(view.GetRepeatedBool(field, j),
+                      reflection->GetRepeatedBool(message, field, j));
+            break;
+          case FieldDescriptor::CPPTYPE_ENUM:
+            EXPECT_EQ(view.GetRepeatedEnumValue(field, j),
+                      reflection->GetRepeatedEnumValue(message, field, j));
+            break;
+          case FieldDescriptor::CPPTYPE_STRING:
+            EXPECT_EQ(view.GetRepeatedString(field, j),
+                      reflection->GetRepeatedString(message, field, j));
+            break;
+          case FieldDescriptor::CPPTYPE_MESSAGE:
+            ExpectMatches(reflection->GetRepeatedMessage(message, field, j),
+                          view.GetRepeatedMessage(field, j));
+            break;
+        }
+      }
+      continue;
+    }
+    EXPECT_EQ(view.Has(field), reflection->HasField(message, field));
+    switch (field->cpp_type()) {
+      case FieldDescriptor::CPPTYPE_INT32:
+        EXPECT_EQ(view.GetInt32(field), reflection->GetInt32(message, field));
+        break;
+      case FieldDescriptor::CPPTYPE_INT64:
+        EXPECT_EQ(view.GetInt64(field), reflection->GetInt64(message, field));
+        break;
+      case FieldDescriptor::CPPTYPE_UINT32:
+        EXPECT_EQ(view.GetUInt32(field),
+                  reflection->GetUInt32(message, field));
+        break;
+      case FieldDescriptor::CPPTYPE_UINT64:
+        EXPECT_EQ(view.GetUInt64(field),
+                  reflection->GetUInt64(message, field));
+        break;
+      case FieldDescriptor::CPPTYPE_FLOAT:
+        EXPECT_EQ(view.GetFloat(field), reflection->GetFloat(message, field));
+        break;
+      case FieldDescriptor::CPPTYPE_DOUBLE:
+        EXPECT_EQ(view.GetDouble(field),
+                  reflection->GetDouble(message, field));
+        break;
+      case FieldDescriptor::CPPTYPE_BOOL:
+        EXPECT_EQ(view.GetBool(field), reflection->GetBool(message, field));
+        break;
+      case FieldDescriptor::CPPTYPE_ENUM:
+        EXPECT_EQ(view.GetEnumValue(field),
+                  reflection->GetEnumValue(message, field));
+        break;
+      case FieldDescriptor::CPPTYPE_STRING:
+        EXPECT_EQ(view.GetString(field),
+                  reflection->GetString(message, field));
+        break;
+      case FieldDescriptor::CPPTYPE_MESSAGE:
+        ExpectMatches(reflection->GetMessage(message, field),
+                      view.GetMessage(field));
+        break;
+    }
+  }
+}
+
+TEST(MessageViewTest, MatchesParsedMessage) {
+  TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  const std::string data = message.SerializeAsString();
+  MessageView view(TestAllTypes::descriptor(), data);
+  EXPECT_TRUE(view.ok());
+  ExpectMatches(message, view);
+}
+
+TEST(MessageViewTest, UnsetFieldsReturnDefaults) {
+  TestAllTypes message;
+  message.set_optional_int32(-5);
+  const std::string data = message.SerializeAsString();
+  MessageView view(TestAllTypes::descriptor(), data);
+  ExpectMatches(message, view);
+}
+
+TEST(MessageViewTest, PackedFields) {
+  protobuf_unittest::TestPackedTypes message;
+  TestUtil::SetPackedFields(&message);
+  const std::string data = message.SerializeAsString();
+  MessageView view(message.GetDescriptor(), data);
+  ExpectMatches(message, view);
+
+  // Unpacked data for packed fields is accepted as well.
+  protobuf_unittest::TestUnpackedTypes unpacked;
+  TestUtil::SetUnpackedFields(&unpacked);
+  const std::string unpacked_data = unpacked.SerializeAsString();
+  MessageView mixed(message.GetDescriptor(), data + unpacked_data);
+  message.MergeFromString(unpacked_data);
+  ExpectMatches(message, mixed);
+}
+
+TEST(MessageViewTest, LastOccurrenceWinsAndMessagesMerge) {
+  TestAllTypes first;
+  first.set_optional_int32(1);
+  first.set_oneof_uint32(7);
+  first.mutable_optional_nested_message()->set_bb(10);
+  TestAllTypes second;
+  second.set_optional_int32(2);
+  second.set_oneof_string("oneof");
+  second.mutable_optional_foreign_message()->set_c(3);
+  TestAllTypes third;
+  third.mutable_optional_nested_message();
+  const std::string data = first.SerializeAsString() +
+                           second.SerializeAsString() +
+                           third.SerializeAsString();
+
+  TestAllTypes message;
+  ASSERT_TRUE(message.ParseFromString(data));
+  MessageView view(TestAllTypes::descriptor(), data);
+  ExpectMatches(message, view);
+}
+
+TEST(MessageViewTest, MalformedData) {
+  TestAllTypes message;
+  message.set_optional_int32(1);
+  message.set_optional_string("value");
+  std::string data = message.SerializeAsString();
+  data.pop_back();
+
+  const Descriptor* descriptor = TestAllTypes::descriptor();
+  MessageView view(descriptor, data);
+  EXPECT_FALSE(view.ok());
+  EXPECT_FALSE(view.Has(descriptor->FindFieldByName("optional_int32")));
+  EXPECT_EQ(view.GetString(descriptor->FindFieldByName("optional_string")),
+            "");
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,346 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/util/record_file.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/log/absl_check.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+
+#if HAVE_ZLIB
+#include "google/protobuf/io/gzip_stream.h"
+#endif  // HAVE_ZLIB
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+// "PBRF" when stored little-endian.
+constexpr uint32_t kRecordFileMagic = 0x46524250;
+// The fixed64 index offset followed by the fixed32 magic number.
+constexpr size_t kTrailerSize = 12;
+// A varint32 is at most 5 bytes.
+constexpr int kMaxVarint32Size = 5;
+
+bool WriteToStream(io::ZeroCopyOutputStream* output, const void* data,
+                   size_t size) {
+  const char* p = static_cast<const char*>(data);
+  while (size > 0) {
+    void* buffer;
+    int buffer_size;
+    if (!output->Next(&buffer, &buffer_size)) return false;
+    size_t n = std::min(size, static_cast<size_t>(buffer_size));
+    std::memcpy(buffer, p, n);
+    p += n;
+    size -= n;
+    if (n < static_cast<size_t>(buffer_size)) {
+      output->BackUp(buffer_size - static_cast<int>(n));
+    }
+  }
+  return true;
+}
+
+void WriteString(absl::string_view value, io::CodedOutputStream* output) {
+  output->WriteVarint32(static_cast<uint32_t>(value.size()));
+  output->WriteRaw(value.data(), static_cast<int>(value.size()));
+}
+
+bool ReadString(io::CodedInputStream* input, std::string* value) {
+  uint32_t size;
+  return input->ReadVarint32(&size) &&
+         input->ReadString(value, static_cast<int>(size));
+}
+
+}  // namespace
+
+RecordFileWriter::RecordFileWriter(io::ZeroCopyOutputStream* output,
+                                   const RecordFileOptions& options)
+    : output_(output), options_(options), start_(output->ByteCount()) {
+#if !HAVE_ZLIB
+  if (options_.compression == RecordFileOptions::kGzip) ok_ = false;
+#endif  // !HAVE_ZLIB
+}
+
+bool RecordFileWriter::Write(const MessageLite& message) {
+  return AddRecord(message);
+}
+
+bool RecordFileWriter::Write(const MessageLite& message,
+                             absl::string_view key) {
+  if (!block_.has_keys) {
+    block_.has_keys = true;
+    block_.min_key = std::string(key);
+    block_.max_key = std::string(key);
+  } else if (key < block_.min_key) {
+    block_.min_key = std::string(key);
+  } else if (key > block_.max_key) {
+    block_.max_key = std::string(key);
+  }
+  return AddRecord(message);
+}
+
+bool RecordFileWriter::AddRecord(const MessageLite& message) {
+  ABSL_DCHECK(!closed_) << "Write() called after Close()";
+  if (!ok_) return false;
+  size_t size = message.ByteSizeLong();
+  if (size > INT_MAX) return ok_ = false;
+
+  uint8_t header[kMaxVarint32Size];
+  uint8_t* header_end = io::CodedOutputStream::WriteVarint32ToArray(
+      static_cast<uint32_t>(size), header);
+  block_data_.append(reinterpret_cast<const char*>(header),
+                     header_end - header);
+  size_t pos = block_data_.size();
+  block_data_.resize(pos + size);
+  message.SerializeWithCachedSizesToArray(
+      reinterpret_cast<uint8_t*>(&block_data_[pos]));
+
+  ++block_.record_count;
+  ++record_count_;
+  if (block_data_.size() >= options_.block_size) return FinishBlock();
+  return true;
+}
+
+bool RecordFileWriter::FinishBlock() {
+  if (block_.record_count == 0) return true;
+  block_.offset = output_->ByteCount() - start_;
+  block_.first_record = record_count_ - block_.record_count;
+  switch (options_.compression) {
+    case RecordFileOptions::kNone:
+      ok_ = WriteToStream(output_, block_data_.data(), block_data_.size());
+      break;
+    case RecordFileOptions::kGzip: {
+#if HAVE_ZLIB
+      io::GzipOutputStream::Options gzip_options;
+      gzip_options.format = io::GzipOutputStream::ZLIB;
+      io::GzipOutputStream gzip(output_, gzip_options);
+      ok_ = WriteToStream(&gzip, block_data_.data(), block_data_.size());
+      ok_ = gzip.Close() && ok_;
+#else
+      ok_ = false;
+#endif  // HAVE_ZLIB
+      break;
+    }
+  }
+  if (!ok_) return false;
+  block_.size = output_->ByteCount() - start_ - block_.offset;
+  blocks_.push_back(std::move(block_));
+  block_ = RecordFileBlock();
+  block_data_.clear();
+  return true;
+}
+
+bool RecordFileWriter::Close() {
+  ABSL_DCHECK(!closed_) << "Close() called twice";
+  closed_ = true;
+  if (!ok_ || !FinishBlock()) return false;
+  const uint64_t index_offset = output_->ByteCount() - start_;
+
+  std::string index;
+  {
+    io::StringOutputStream index_stream(&index);
+    io::CodedOutputStream index_output(&index_stream);
+    index_output.WriteVarint32(options_.compression);
+    index_output.WriteVarint64(blocks_.size());
+    for (const RecordFileBlock& block : blocks_) {
+      index_output.WriteVarint64(block.size);
+      index_output.WriteVarint64(block.record_count);
+      index_output.WriteVarint32(block.has_keys);
+      if (block.has_keys) {
+        WriteString(block.min_key, &index_output);
+        WriteString(block.max_key, &index_output);
+      }
+    }
+  }
+  uint8_t trailer[kTrailerSize];
+  io::CodedOutputStream::WriteLittleEndian32ToArray(
+      kRecordFileMagic,
+      io::CodedOutputStream::WriteLittleEndian64ToArray(index_offset, trailer));
+  return ok_ = WriteToStream(output_, index.data(), index.size()) &&
+               WriteToStream(output_, trailer, sizeof(trailer));
+}
+
+bool RecordFileReader::Open(absl::string_view data) {
+  blocks_.clear();
+  record_count_ = 0;
+  if (data.size() < kTrailerSize) return false;
+
+  const uint8_t* trailer = reinterpret_cast<const uint8_t*>(
+      data.data() + data.size() - kTrailerSize);
+  uint64_t index_offset;
+  uint32_t magic;
+  io::CodedInputStream::ReadLittleEndian32FromArray(
+      io::CodedInputStream::ReadLittleEndian64FromArray(trailer,
+                                                        &index_offset),
+      &magic);
+  if (magic != kRecordFileMagic) return false;
+  if (index_offset > data.size() - kTrailerSize) return false;
+  const size_t index_size = data.size() - kTrailerSize - index_offset;
+  if (index_size > INT_MAX) return false;
+
+  io::CodedInputStream input(
+      reinterpret_cast<const uint8_t*>(data.data() + index_offset),
+      static_cast<int>(index_size));
+  uint32_t compression;
+  uint64_t block_count;
+  if (!input.ReadVarint32(&compression) || !input.ReadVarint64(&block_count)) {
+    return false;
+  }
+  if (compression != RecordFileOptions::kNone &&
+      compression != RecordFileOptions::kGzip) {
+    return false;
+  }
+  // Every block takes at least three bytes of index.
+  if (block_count > index_size / 3) return false;
+
+  std::vector<RecordFileBlock> blocks(block_count);
+  uint64_t offset = 0;
+  int64_t record_count = 0;
+  for (RecordFileBlock& block : blocks) {
+    uint64_t block_records;
+    uint32_t has_keys;
+    if (!input.ReadVarint64(&block.size) ||
+        !input.ReadVarint64(&block_records) ||
+        !input.ReadVarint32(&has_keys)) {
+      return false;
+    }
+    if (block.size > index_offset - offset || block_records == 0 ||
+        block_records > static_cast<uint64_t>(INT64_MAX - record_count)) {
+      return false;
+    }
+    block.offset = offset;
+    block.first_record = record_count;
+    block.record_count = static_cast<int64_t>(block_records);
+    block.has_keys = has_keys != 0;
+    if (block.has_keys && (!ReadString(&input, &block.min_key) ||
+                           !ReadString(&input, &block.max_key))) {
+      return false;
+    }
+    offset += block.size;
+    record_count += block.record_count;
+  }
+  if (offset != index_offset || !input.ExpectAtEnd()) return false;
+
+  data_ = data;
+  compression_ = static_cast<RecordFileOptions::Compression>(compression);
+  blocks_ = std::move(blocks);
+  record_count_ = record_count;
+  return true;
+}
+
+int RecordFileReader::FindBlock(int64_t record) const {
+  ABSL_DCHECK_GE(record, 0);
+  ABSL_DCHECK_LT(record, record_count_);
+  auto it = std::upper_bound(blocks_.begin(), blocks_.end(), record,
+                             [](int64_t record, const RecordFileBlock& block) {
+                               return record < block.first_record;
+                             });
+  return static_cast<int>(it - blocks_.begin()) - 1;
+}
+
+std::vector<int> RecordFileReader::FindBlocksForKey(
+    absl::string_view key) const {
+  std::vector<int> result;
+  for (size_t i = 0; i < blocks_.size(); ++i) {
+    const RecordFileBlock& block = blocks_[i];
+    if (block.has_keys && block.min_key <= key && key <= block.max_key) {
+      result.push_back(static_cast<int>(i));
+    }
+  }
+  return result;
+}
+
+bool RecordFileReader::ReadRecord(int64_t record, MessageLite* message) const {
+  if (record < 0 || record >= record_count_) return false;
+  const int block = FindBlock(record);
+  int64_t skip = record - blocks_[block].first_record;
+  bool parsed = false;
+  bool ok = ForEachRecord(block, [&](absl::string_view data) {
+    if (skip-- > 0) return true;
+    parsed =
+        message->ParseFromArray(data.data(), static_cast<int>(data.size()));
+    return false;
+  });
+  return ok && parsed;
+}
+
+bool RecordFileReader::ForEachRecord(
+    int block, absl::FunctionRef<bool(absl::string_view)> callback) const {
+  ABSL_DCHECK_GE(block, 0);
+  ABSL_DCHECK_LT(block, static_cast<int>(blocks_.size()));
+  const RecordFileBlock& info = blocks_[block];
+  if (info.size > INT_MAX) return false;
+  absl::string_view records = data_.substr(info.offset, info.size);
+
+  std::string decompressed;
+  if (compression_ == RecordFileOptions::kGzip) {
+#if HAVE_ZLIB
+    io::ArrayInputStream compressed(records.data(),
+                                    static_cast<int>(records.size()));
+    io::GzipInputStream gzip(&compressed, io::GzipInputStream::ZLIB);
+    const void* chunk;
+    int chunk_size;
+    while (gzip.Next(&chunk, &chunk_size)) {
+      decompressed.append(static_cast<const char*>(chunk), chunk_size);
+    }
+    if (gzip.ZlibErrorCode() != Z_STREAM_END) return false;
+    records = decompressed;
+#else
+    return false;
+#endif  // HAVE_ZLIB
+  }
+  if (records.size() > INT_MAX) return false;
+
+  io::CodedInputStream input(reinterpret_cast<const uint8_t*>(records.data()),
+                             static_cast<int>(records.size()));
+  for (int64_t i = 0; i < info.record_count; ++i) {
+    uint32_t size;
+    if (!input.ReadVarint32(&size)) return false;
+    const size_t pos = input.CurrentPosition();
+    if (size > records.size() - pos) return false;
+    if (!callback(records.substr(pos, size))) return true;
+    input.Skip(static_cast<int>(size));
+  }
+  return input.ExpectAtEnd();
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,189 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// A record file stores a sequence of size-delimited messages, as written by
+// util::SerializeDelimitedToZeroCopyStream(), grouped into blocks and
+// followed by an index of the blocks.  The index lets a reader find record N
+// without scanning the records before it, and lets the blocks be decoded
+// independently, e.g. by several threads.
+//
+// Example:
+//   RecordFileWriter writer(&output);
+//   for (const Record& record : records) writer.Write(record);
+//   writer.Close();
+//
+//   RecordFileReader reader;
+//   reader.Open(mapped_file);  // e.g. from mmap()
+//   Record record;
+//   reader.ReadRecord(1234567, &record);
+//
+// The file consists of the blocks, the index, and a 12 byte trailer holding
+// the offset of the index as a little-endian fixed64 and a fixed32 magic
+// number.  Each block is the concatenation of its delimited records, deflated
+// as one zlib stream if the file is compressed.  The index holds the
+// compression and, for each block, its offset and size in the file, its
+// number of records, and the smallest and largest key of its records if keys
+// were given to the writer.
+
+#ifndef GOOGLE_PROTOBUF_UTIL_RECORD_FILE_H__
+#define GOOGLE_PROTOBUF_UTIL_RECORD_FILE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/functional/function_ref.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/io/zero_copy_stream.h"
+#include "google/protobuf/message_lite.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+struct RecordFileOptions {
+  enum Compression {
+    kNone = 0,
+    // Requires zlib; without it, the writer fails.
+    kGzip = 1,
+  };
+  Compression compression = kNone;
+
+  // A block is finished once its records add up to at least this many bytes,
+  // before compression.  Smaller blocks make reading a single record cheaper,
+  // larger blocks compress better and make the index smaller.
+  size_t block_size = 64 * 1024;
+};
+
+// One block of a record file, as described by the index.
+struct RecordFileBlock {
+  // Position and size of the block in the file.
+  uint64_t offset = 0;
+  uint64_t size = 0;
+  // Index of the first record of the block, and number of records in it.
+  int64_t first_record = 0;
+  int64_t record_count = 0;
+  // The smallest and largest key of the block's records, if the writer was
+  // given keys.
+  bool has_keys = false;
+  std::string min_key;
+  std::string max_key;
+};
+
+// Writes a record file to a ZeroCopyOutputStream.  Offsets in the index are
+// relative to the position of the stream when the writer was created.
+class PROTOBUF_EXPORT RecordFileWriter {
+ public:
+  explicit RecordFileWriter(io::ZeroCopyOutputStream* output,
+                            const RecordFileOptions& options = {});
+  RecordFileWriter(const RecordFileWriter&) = delete;
+  RecordFileWriter& operator=(const RecordFileWriter&) = delete;
+
+  // Appends a record.  With a key, the record contributes to the key range of
+  // its block; keys are compared bytewise and need not be sorted, but blocks
+  // only narrow down key lookups if they are.  Returns false once writing to
+  // the stream has failed.
+  bool Write(const MessageLite& message);
+  bool Write(const MessageLite& message, absl::string_view key);
+
+  // Finishes the last block and writes the index and trailer.  Nothing may be
+  // written afterwards.  The file is incomplete, and unreadable, until this
+  // has returned true.
+  bool Close();
+
+  int64_t record_count() const { return record_count_; }
+
+ private:
+  bool AddRecord(const MessageLite& message);
+  bool FinishBlock();
+
+  io::ZeroCopyOutputStream* const output_;
+  const RecordFileOptions options_;
+  const int64_t start_;
+  // The delimited records of the current block.
+  std::string block_data_;
+  RecordFileBlock block_;
+  std::vector<RecordFileBlock> blocks_;
+  int64_t record_count_ = 0;
+  bool ok_ = true;
+  bool closed_ = false;
+};
+
+// Reads a record file held entirely in memory, typically through mmap().
+// After Open(), all methods are const and may be called from several threads
+// at once, e.g. to decode different blocks in parallel.
+class PROTOBUF_EXPORT RecordFileReader {
+ public:
+  RecordFileReader() = default;
+  RecordFileReader(const RecordFileReader&) = delete;
+  RecordFileReader& operator=(const RecordFileReader&) = delete;
+
+  // Reads the index of the file `data`, which must outlive the reader.
+  // Returns false if `data` is not a complete record file.
+  bool Open(absl::string_view data);
+
+  int64_t record_count() const { return record_count_; }
+  const std::vector<RecordFileBlock>& blocks() const { return blocks_; }
+
+  // Returns the block holding record `record`, which must be in
+  // [0, record_count()).
+  int FindBlock(int64_t record) const;
+
+  // Returns the blocks whose key range contains `key`, in file order.
+  // Blocks written without keys are never returned.
+  std::vector<int> FindBlocksForKey(absl::string_view key) const;
+
+  // Parses record `record` into `message`, decoding only its block.
+  bool ReadRecord(int64_t record, MessageLite* message) const;
+
+  // Calls `callback` with the serialized bytes of each record of block
+  // `block`, in order, until it returns false.  Returns false if the block is
+  // corrupt.
+  bool ForEachRecord(
+      int block, absl::FunctionRef<bool(absl::string_view)> callback) const;
+
+ private:
+  absl::string_view data_;
+  RecordFileOptions::Compression compression_ = RecordFileOptions::kNone;
+  std::vector<RecordFileBlock> blocks_;
+  int64_t record_count_ = 0;
+};
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_RECORD_FILE_H__
@@ -0,0 +1,170 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/util/record_file.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/unittest.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+using ::protobuf_unittest::TestAllTypes;
+
+constexpr int kRecordCount = 1000;
+
+TestAllTypes MakeRecord(int i) {
+  TestAllTypes message;
+  message.set_optional_int32(i);
+  message.set_optional_string(absl::StrCat("record ", i));
+  return message;
+}
+
+std::string WriteFile(const RecordFileOptions& options) {
+  std::string data;
+  io::StringOutputStream output(&data);
+  RecordFileWriter writer(&output, options);
+  for (int i = 0; i < kRecordCount; ++i) {
+    EXPECT_TRUE(writer.Write(MakeRecord(i), absl::StrCat("key", 1000 + i)));
+  }
+  EXPECT_TRUE(writer.Close());
+  return data;
+}
+
+void ExpectReadable(absl::string_view data) {
+  RecordFileReader reader;
+  ASSERT_TRUE(reader.Open(data));
+  EXPECT_EQ(reader.record_count(), kRecordCount);
+  EXPECT_GT(reader.blocks().size(), 1);
+
+  // Random access, in any order.
+  for (int i : {999, 0, 517, 1, 998, 500}) {
+    TestAllTypes message;
+    ASSERT_TRUE(reader.ReadRecord(i, &message));
+    EXPECT_EQ(message.optional_int32(), i);
+    EXPECT_EQ(message.optional_string(), absl::StrCat("record ", i));
+  }
+  TestAllTypes message;
+  EXPECT_FALSE(reader.ReadRecord(kRecordCount, &message));
+
+  // Every block decodes on its own, and together they hold all records.
+  int next = 0;
+  for (size_t block = 0; block < reader.blocks().size(); ++block) {
+    EXPECT_EQ(reader.blocks()[block].first_record, next);
+    EXPECT_TRUE(reader.ForEachRecord(block, [&](absl::string_view record) {
+      TestAllTypes message;
+      EXPECT_TRUE(message.ParseFromArray(record.data(), record.size()));
+      EXPECT_EQ(message.optional_int32(), next++);
+      return true;
+    }));
+  }
+  EXPECT_EQ(next, kRecordCount);
+}
+
+TEST(RecordFileTest, Uncompressed) {
+  RecordFileOptions options;
+  options.block_size = 1024;
+  ExpectReadable(WriteFile(options));
+}
+
+#if HAVE_ZLIB
+TEST(RecordFileTest, Gzip) {
+  RecordFileOptions options;
+  options.block_size = 1024;
+  std::string uncompressed = WriteFile(options);
+  options.compression = RecordFileOptions::kGzip;
+  std::string compressed = WriteFile(options);
+  EXPECT_LT(compressed.size(), uncompressed.size());
+  ExpectReadable(compressed);
+}
+#endif  // HAVE_ZLIB
+
+TEST(RecordFileTest, FindBlock) {
+  RecordFileOptions options;
+  options.block_size = 1024;
+  RecordFileReader reader;
+  std::string data = WriteFile(options);
+  ASSERT_TRUE(reader.Open(data));
+  for (int64_t i = 0; i < kRecordCount; ++i) {
+    const RecordFileBlock& block = reader.blocks()[reader.FindBlock(i)];
+    EXPECT_LE(block.first_record, i);
+    EXPECT_LT(i, block.first_record + block.record_count);
+  }
+}
+
+TEST(RecordFileTest, FindBlocksForKey) {
+  RecordFileOptions options;
+  options.block_size = 1024;
+  RecordFileReader reader;
+  std::string data = WriteFile(options);
+  ASSERT_TRUE(reader.Open(data));
+
+  std::vector<int> blocks = reader.FindBlocksForKey("key1517");
+  ASSERT_EQ(blocks.size(), 1);
+  EXPECT_EQ(blocks[0], reader.FindBlock(517));
+  EXPECT_TRUE(reader.FindBlocksForKey("key0999").empty());
+  EXPECT_TRUE(reader.FindBlocksForKey("key2000").empty());
+}
+
+TEST(RecordFileTest, Empty) {
+  std::string data;
+  {
+    io::StringOutputStream output(&data);
+    RecordFileWriter writer(&output);
+    EXPECT_TRUE(writer.Close());
+  }
+  RecordFileReader reader;
+  ASSERT_TRUE(reader.Open(data));
+  EXPECT_EQ(reader.record_count(), 0);
+  EXPECT_TRUE(reader.blocks().empty());
+}
+
+TEST(RecordFileTest, RejectsIncompleteFiles) {
+  std::string data = WriteFile(RecordFileOptions());
+  RecordFileReader reader;
+  EXPECT_FALSE(reader.Open(""));
+  EXPECT_FALSE(reader.Open(absl::string_view(data).substr(0, data.size() - 1)));
+  EXPECT_FALSE(reader.Open(absl::string_view(data).substr(1)));
+  EXPECT_TRUE(reader.Open(data));
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
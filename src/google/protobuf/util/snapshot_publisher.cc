@@ -0,0 +1,123 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/util/snapshot_publisher.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+
+#include "absl/log/absl_check.h"
+#include "absl/synchronization/mutex.h"
+#include "google/protobuf/arena.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+
+SnapshotPublisherBase::~SnapshotPublisherBase() {
+  absl::MutexLock lock(&mu_);
+  for (const auto& slot : slots_) {
+    ABSL_DCHECK(!slot->in_use) << "Readers must not outlive their publisher.";
+  }
+  delete current_.load(std::memory_order_relaxed);
+}
+
+SnapshotPublisherBase::Slot* SnapshotPublisherBase::AcquireSlot() {
+  absl::MutexLock lock(&mu_);
+  for (const auto& slot : slots_) {
+    if (!slot->in_use) {
+      slot->in_use = true;
+      return slot.get();
+    }
+  }
+  slots_.push_back(std::make_unique<Slot>());
+  slots_.back()->in_use = true;
+  return slots_.back().get();
+}
+
+void SnapshotPublisherBase::ReleaseSlot(Slot* slot) {
+  ABSL_DCHECK_EQ(slot->epoch.load(std::memory_order_relaxed), 0)
+      << "A Reader must not outlive its ReadGuard.";
+  absl::MutexLock lock(&mu_);
+  slot->in_use = false;
+}
+
+void SnapshotPublisherBase::PublishImpl(const void* value,
+                                        std::unique_ptr<Arena> arena,
+                                        void (*deleter)(const void*)) {
+  auto* snapshot = new Snapshot{value, std::move(arena), deleter};
+  absl::MutexLock lock(&mu_);
+  const Snapshot* old = current_.exchange(snapshot, std::memory_order_seq_cst);
+  if (old != nullptr) {
+    // Readers that still see `old` started their read in an earlier epoch.
+    retired_.push_back(Retired{std::unique_ptr<const Snapshot>(old),
+                               epoch_.fetch_add(1) + 1});
+  }
+  ReclaimLocked();
+}
+
+size_t SnapshotPublisherBase::Reclaim() {
+  absl::MutexLock lock(&mu_);
+  return ReclaimLocked();
+}
+
+size_t SnapshotPublisherBase::ReclaimLocked() {
+  if (retired_.empty()) return 0;
+  // A reader announces the epoch it read before loading the snapshot, while
+  // PublishImpl() swaps the snapshot before advancing the epoch.  So a reader
+  // that still sees a snapshot retired in epoch `r` announced an epoch below
+  // `r`, and snapshots retired no later than the oldest announced epoch (all
+  // of them if no read is in progress) are unreachable.  A reader that has
+  // not announced its epoch by the time we scan will load a newer snapshot.
+  uint64_t oldest = std::numeric_limits<uint64_t>::max();
+  for (const auto& slot : slots_) {
+    uint64_t announced = slot->epoch.load(std::memory_order_seq_cst);
+    if (announced != 0) oldest = std::min(oldest, announced - 1);
+  }
+  retired_.erase(std::remove_if(retired_.begin(), retired_.end(),
+                                [&](const Retired& retired) {
+                                  return retired.epoch <= oldest;
+                                }),
+                 retired_.end());
+  return retired_.size();
+}
+
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
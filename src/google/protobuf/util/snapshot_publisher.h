@@ -0,0 +1,236 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Publishes immutable snapshots of a value, typically a large message that is
+// read by many threads and occasionally rebuilt by a writer.
+//
+// Readers get the current snapshot without locks, retries, or reference
+// counts: each reader thread owns a Reader, whose slot on a cache line of its
+// own records the epoch the thread is reading in.  A reader only writes its
+// own slot, so reads never bounce a shared cache line between threads.  A
+// replaced snapshot, together with the arena holding it, is destroyed once
+// every reader that might still see it has finished; Publish() and Reclaim()
+// destroy such snapshots.
+//
+// Example:
+//   SnapshotPublisher<Config> publisher;
+//
+//   // Writer:
+//   auto arena = std::make_unique<Arena>();
+//   Config* config = Arena::CreateMessage<Config>(arena.get());
+//   ...
+//   publisher.Publish(std::move(arena), config);
+//
+//   // Each reader thread:
+//   SnapshotPublisher<Config>::Reader reader(&publisher);
+//   while (...) {
+//     auto config = reader.Read();
+//     if (config) Use(config->flag());
+//   }
+//
+// A snapshot must not be used after the ReadGuard it came from is destroyed,
+// and each Reader may hold one ReadGuard at a time.  Readers must be destroyed
+// before their publisher.  Publish() and Reclaim() may be called from several
+// threads; they serialize on a mutex.
+
+#ifndef GOOGLE_PROTOBUF_UTIL_SNAPSHOT_PUBLISHER_H__
+#define GOOGLE_PROTOBUF_UTIL_SNAPSHOT_PUBLISHER_H__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/log/absl_check.h"
+#include "absl/synchronization/mutex.h"
+#include "google/protobuf/arena.h"
+#include "google/protobuf/port.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+
+// The type-erased implementation of SnapshotPublisher.
+class PROTOBUF_EXPORT SnapshotPublisherBase {
+ public:
+  SnapshotPublisherBase(const SnapshotPublisherBase&) = delete;
+  SnapshotPublisherBase& operator=(const SnapshotPublisherBase&) = delete;
+
+  // Destroys every snapshot that has been replaced and that no reader can
+  // still see.  Returns the number of replaced snapshots still alive.
+  size_t Reclaim() ABSL_LOCKS_EXCLUDED(mu_);
+
+ protected:
+  // The state of one Reader, alone on its cache line.
+  struct alignas(kCacheAlignment) Slot {
+    // One more than the epoch in which the reader started its current read,
+    // or 0 while it is not reading.
+    std::atomic<uint64_t> epoch{0};
+    bool in_use = false;  // Guarded by mu_.
+  };
+
+  SnapshotPublisherBase() = default;
+  ~SnapshotPublisherBase();
+
+  Slot* AcquireSlot() ABSL_LOCKS_EXCLUDED(mu_);
+  void ReleaseSlot(Slot* slot) ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Publishes `value`, owned by `arena` if not null and otherwise destroyed
+  // with `deleter`.
+  void PublishImpl(const void* value, std::unique_ptr<Arena> arena,
+                   void (*deleter)(const void*)) ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Starts a read on `slot` and returns the current value.  The value stays
+  // alive until EndRead().
+  const void* BeginRead(Slot* slot) const {
+    ABSL_DCHECK_EQ(slot->epoch.load(std::memory_order_relaxed), 0)
+        << "A Reader may hold only one ReadGuard at a time.";
+    // Announcing the epoch must be ordered before loading the snapshot, and
+    // Publish() replaces the snapshot before advancing the epoch; see
+    // Reclaim().
+    slot->epoch.store(epoch_.load(std::memory_order_seq_cst) + 1,
+                      std::memory_order_seq_cst);
+    const Snapshot* snapshot = current_.load(std::memory_order_seq_cst);
+    return snapshot == nullptr ? nullptr : snapshot->value;
+  }
+
+  static void EndRead(Slot* slot) {
+    slot->epoch.store(0, std::memory_order_release);
+  }
+
+ private:
+  struct Snapshot {
+    const void* value;
+    std::unique_ptr<Arena> arena;
+    void (*deleter)(const void*);
+
+    ~Snapshot() {
+      if (deleter != nullptr) deleter(value);
+    }
+  };
+  struct Retired {
+    std::unique_ptr<const Snapshot> snapshot;
+    // The epoch in which the snapshot was replaced.
+    uint64_t epoch;
+  };
+
+  size_t ReclaimLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  std::atomic<const Snapshot*> current_{nullptr};
+  std::atomic<uint64_t> epoch_{1};
+
+  absl::Mutex mu_;
+  std::vector<std::unique_ptr<Slot>> slots_ ABSL_GUARDED_BY(mu_);
+  std::vector<Retired> retired_ ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace internal
+
+namespace util {
+
+template <typename T>
+class SnapshotPublisher : public internal::SnapshotPublisherBase {
+ public:
+  class Reader;
+
+  // Gives access to one snapshot for as long as it is alive.
+  class ReadGuard {
+   public:
+    ReadGuard(ReadGuard&& other) noexcept
+        : slot_(std::exchange(other.slot_, nullptr)), value_(other.value_) {}
+    ReadGuard& operator=(ReadGuard&&) = delete;
+    ~ReadGuard() {
+      if (slot_ != nullptr) EndRead(slot_);
+    }
+
+    // The snapshot, or null if nothing has been published yet.
+    const T* get() const { return value_; }
+    const T& operator*() const { return *value_; }
+    const T* operator->() const { return value_; }
+    explicit operator bool() const { return value_ != nullptr; }
+
+   private:
+    friend class Reader;
+    ReadGuard(Slot* slot, const T* value) : slot_(slot), value_(value) {}
+
+    Slot* slot_;
+    const T* value_;
+  };
+
+  // A reader thread's handle on the publisher.  Not thread-safe: each thread
+  // needs its own.
+  class Reader {
+   public:
+    explicit Reader(SnapshotPublisher* publisher)
+        : publisher_(publisher), slot_(publisher->AcquireSlot()) {}
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+    ~Reader() { publisher_->ReleaseSlot(slot_); }
+
+    // Returns the current snapshot.  Wait-free.
+    ReadGuard Read() {
+      return ReadGuard(
+          slot_, static_cast<const T*>(publisher_->BeginRead(slot_)));
+    }
+
+   private:
+    SnapshotPublisher* publisher_;
+    Slot* slot_;
+  };
+
+  SnapshotPublisher() = default;
+
+  // Publishes `value`, which must be allocated on `arena`.  The arena is
+  // destroyed once the snapshot has been replaced and no reader sees it.
+  void Publish(std::unique_ptr<Arena> arena, const T* value) {
+    ABSL_DCHECK(arena != nullptr);
+    PublishImpl(value, std::move(arena), nullptr);
+  }
+
+  // Publishes a heap-allocated `value`.
+  void Publish(std::unique_ptr<const T> value) {
+    PublishImpl(value.release(), nullptr, [](const void* p) {
+      delete static_cast<const T*>(p);
+    });
+  }
+};
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_SNAPSHOT_PUBLISHER_H__
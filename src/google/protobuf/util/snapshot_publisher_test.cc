@@ -0,0 +1,156 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/util/snapshot_publisher.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "google/protobuf/arena.h"
+#include "google/protobuf/unittest.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+using ::protobuf_unittest::TestAllTypes;
+
+// Counts live instances, to observe when snapshots are destroyed.
+struct Tracked {
+  explicit Tracked(int value) : value(value) { ++live; }
+  ~Tracked() { --live; }
+  int value;
+  static std::atomic<int> live;
+};
+std::atomic<int> Tracked::live{0};
+
+TEST(SnapshotPublisherTest, ReadsNullBeforeFirstPublish) {
+  SnapshotPublisher<Tracked> publisher;
+  SnapshotPublisher<Tracked>::Reader reader(&publisher);
+  EXPECT_FALSE(reader.Read());
+}
+
+TEST(SnapshotPublisherTest, KeepsSnapshotAliveWhileRead) {
+  {
+    SnapshotPublisher<Tracked> publisher;
+    SnapshotPublisher<Tracked>::Reader reader(&publisher);
+    publisher.Publish(std::make_unique<Tracked>(1));
+    {
+      auto guard = reader.Read();
+      ASSERT_TRUE(guard);
+      EXPECT_EQ(guard->value, 1);
+
+      publisher.Publish(std::make_unique<Tracked>(2));
+      // The reader still sees the old snapshot.
+      EXPECT_EQ(Tracked::live, 2);
+      EXPECT_EQ(guard->value, 1);
+      EXPECT_EQ(publisher.Reclaim(), 1);
+    }
+    EXPECT_EQ(reader.Read()->value, 2);
+    EXPECT_EQ(publisher.Reclaim(), 0);
+    EXPECT_EQ(Tracked::live, 1);
+
+    // An ongoing read holds back every snapshot replaced since it started.
+    auto guard = reader.Read();
+    publisher.Publish(std::make_unique<Tracked>(3));
+    EXPECT_EQ(Tracked::live, 2);
+    publisher.Publish(std::make_unique<Tracked>(4));
+    EXPECT_EQ(Tracked::live, 3);
+    EXPECT_EQ(guard->value, 2);
+  }
+  EXPECT_EQ(Tracked::live, 0);
+}
+
+TEST(SnapshotPublisherTest, ReusesReaderSlots) {
+  SnapshotPublisher<Tracked> publisher;
+  publisher.Publish(std::make_unique<Tracked>(1));
+  for (int i = 0; i < 3; ++i) {
+    SnapshotPublisher<Tracked>::Reader reader(&publisher);
+    EXPECT_EQ(reader.Read()->value, 1);
+  }
+  publisher.Publish(std::make_unique<Tracked>(2));
+  EXPECT_EQ(publisher.Reclaim(), 0);
+}
+
+TEST(SnapshotPublisherTest, ArenaMessages) {
+  SnapshotPublisher<TestAllTypes> publisher;
+  SnapshotPublisher<TestAllTypes>::Reader reader(&publisher);
+  for (int i = 0; i < 4; ++i) {
+    auto arena = std::make_unique<Arena>();
+    auto* message = Arena::CreateMessage<TestAllTypes>(arena.get());
+    message->set_optional_int32(i);
+    message->add_repeated_string("x");
+    publisher.Publish(std::move(arena), message);
+    EXPECT_EQ(reader.Read()->optional_int32(), i);
+  }
+  EXPECT_EQ(publisher.Reclaim(), 0);
+}
+
+TEST(SnapshotPublisherTest, ConcurrentReadersSeeConsistentSnapshots) {
+  constexpr int kReaders = 4;
+  constexpr int kPublishes = 2000;
+  {
+    SnapshotPublisher<Tracked> publisher;
+    publisher.Publish(std::make_unique<Tracked>(0));
+    std::atomic<bool> done{false};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < kReaders; ++i) {
+      readers.emplace_back([&] {
+        SnapshotPublisher<Tracked>::Reader reader(&publisher);
+        int last = 0;
+        while (!done.load(std::memory_order_relaxed)) {
+          auto guard = reader.Read();
+          // Snapshots only move forward, and are intact while read.
+          int value = guard->value;
+          EXPECT_GE(value, last);
+          last = value;
+          EXPECT_EQ(guard->value, value);
+        }
+      });
+    }
+    for (int i = 1; i <= kPublishes; ++i) {
+      publisher.Publish(std::make_unique<Tracked>(i));
+    }
+    done = true;
+    for (auto& reader : readers) reader.join();
+    EXPECT_EQ(publisher.Reclaim(), 0);
+    EXPECT_EQ(Tracked::live, 1);
+  }
+  EXPECT_EQ(Tracked::live, 0);
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
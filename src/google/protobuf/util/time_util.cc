@@ -34,6 +34,7 @@
 #include <cstdlib>
 
 #include "google/protobuf/duration.pb.h"
+#include "google/protobuf/rfc3339.h"
 #include "google/protobuf/timestamp.pb.h"
 #include "absl/log/absl_check.h"
 #include "absl/numeric/int128.h"
@@ -138,6 +139,15 @@ std::string FormatNanos(int32_t nanos) {
 }
 
 std::string FormatTime(int64_t seconds, int32_t nanos) {
+  if (seconds >= internal::kRfc3339MinSeconds &&
+      seconds <= internal::kRfc3339MaxSeconds && nanos >= 0 &&
+      nanos < kNanosPerSecond) {
+    char buf[internal::kRfc3339TimestampBufferSize];
+    return std::string(buf,
+                       internal::FormatRfc3339Timestamp(seconds, nanos, buf));
+  }
+
+  // Out-of-range values are still formatted the way absl does it.
   static constexpr absl::string_view kTimestampFormat = "%E4Y-%m-%dT%H:%M:%S";
 
   timespec spec;
@@ -157,6 +167,11 @@ std::string FormatTime(int64_t seconds, int32_t nanos) {
 }
 
 bool ParseTime(absl::string_view value, int64_t* seconds, int32_t* nanos) {
+  // The strict fixed-format parser handles the common case; absl additionally
+  // accepts lowercase separators, leap seconds, long fractions, etc.
+  if (internal::ParseRfc3339Timestamp(value, seconds, nanos)) {
+    return true;
+  }
   absl::Time result;
   if (!absl::ParseTime(absl::RFC3339_full, value, &result, nullptr)) {
     return false;
@@ -228,20 +243,9 @@ Timestamp TimeUtil::GetCurrentTime() {
 Timestamp TimeUtil::GetEpoch() { return Timestamp(); }
 
 std::string TimeUtil::ToString(const Duration& duration) {
-  std::string result;
-  int64_t seconds = duration.seconds();
-  int32_t nanos = duration.nanos();
-  if (seconds < 0 || nanos < 0) {
-    result = "-";
-    seconds = -seconds;
-    nanos = -nanos;
-  }
-  absl::StrAppend(&result, seconds);
-  if (nanos != 0) {
-    absl::StrAppend(&result, ".", FormatNanos(nanos));
-  }
-  absl::StrAppend(&result, "s");
-  return result;
+  char buf[internal::kDurationBufferSize];
+  return std::string(
+      buf, internal::FormatDuration(duration.seconds(), duration.nanos(), buf));
 }
 
 static int64_t Pow(int64_t x, int y) {
@@ -30,6 +30,7 @@
 
 #include "google/protobuf/util/type_resolver_util.h"
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -37,12 +38,15 @@
 #include "google/protobuf/type.pb.h"
 #include "google/protobuf/wrappers.pb.h"
 #include "google/protobuf/descriptor.pb.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/log/absl_log.h"
 #include "absl/status/status.h"
 #include "absl/strings/escaping.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/strip.h"
+#include "absl/synchronization/mutex.h"
 #include "google/protobuf/descriptor_legacy.h"
 #include "google/protobuf/io/strtod.h"
 #include "google/protobuf/util/type_resolver.h"
@@ -376,6 +380,62 @@ class DescriptorPoolTypeResolver : public TypeResolver {
   const DescriptorPool* pool_;
 };
 
+class CachingTypeResolver : public TypeResolver {
+ public:
+  explicit CachingTypeResolver(TypeResolver* resolver) : resolver_(resolver) {}
+
+  absl::Status ResolveMessageType(const std::string& type_url,
+                                  Type* type) override {
+    return Resolve(type_url, type, messages_,
+                   [this](const std::string& url, Type* resolved) {
+                     return resolver_->ResolveMessageType(url, resolved);
+                   });
+  }
+
+  absl::Status ResolveEnumType(const std::string& type_url,
+                               Enum* enum_type) override {
+    return Resolve(type_url, enum_type, enums_,
+                   [this](const std::string& url, Enum* resolved) {
+                     return resolver_->ResolveEnumType(url, resolved);
+                   });
+  }
+
+ private:
+  template <typename T>
+  using Cache = absl::flat_hash_map<std::string, std::unique_ptr<const T>>;
+
+  template <typename T, typename ResolveFn>
+  absl::Status Resolve(const std::string& type_url, T* out, Cache<T>& cache,
+                       ResolveFn resolve) {
+    {
+      absl::ReaderMutexLock lock(&mu_);
+      auto it = cache.find(type_url);
+      if (it != cache.end()) {
+        *out = *it->second;
+        return absl::OkStatus();
+      }
+    }
+
+    // Resolve without holding the lock, so the wrapped resolver may be called
+    // from several threads at once.  If several threads miss on the same URL,
+    // the first one to finish populates the cache.
+    auto resolved = std::make_unique<T>();
+    absl::Status status = resolve(type_url, resolved.get());
+    if (!status.ok()) {
+      return status;
+    }
+    *out = *resolved;
+    absl::MutexLock lock(&mu_);
+    cache.try_emplace(type_url, std::move(resolved));
+    return absl::OkStatus();
+  }
+
+  TypeResolver* resolver_;
+  absl::Mutex mu_;
+  Cache<Type> messages_ ABSL_GUARDED_BY(mu_);
+  Cache<Enum> enums_ ABSL_GUARDED_BY(mu_);
+};
+
 }  // namespace
 
 TypeResolver* NewTypeResolverForDescriptorPool(absl::string_view url_prefix,
@@ -383,6 +443,10 @@ TypeResolver* NewTypeResolverForDescriptorPool(absl::string_view url_prefix,
   return new DescriptorPoolTypeResolver(url_prefix, pool);
 }
 
+TypeResolver* NewCachingTypeResolver(TypeResolver* resolver) {
+  return new CachingTypeResolver(resolver);
+}
+
 // Performs a direct conversion from a descriptor to a type proto.
 Type ConvertDescriptorToType(absl::string_view url_prefix,
                              const Descriptor& descriptor) {
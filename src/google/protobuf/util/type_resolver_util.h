@@ -51,6 +51,15 @@ class TypeResolver;
 PROTOBUF_EXPORT TypeResolver* NewTypeResolverForDescriptorPool(
     absl::string_view url_prefix, const DescriptorPool* pool);
 
+// Creates a TypeResolver that resolves each type URL through `resolver` only
+// once, and serves later requests for it from a cache.  Types stay cached for
+// the lifetime of the returned resolver; failed resolutions are not cached.
+// The returned TypeResolver is thread-safe as long as `resolver` is: cache
+// misses call `resolver` concurrently from whichever threads miss, so it
+// must itself be thread-safe.  `resolver` must outlive the returned
+// TypeResolver.  Caller takes ownership of the returned TypeResolver.
+PROTOBUF_EXPORT TypeResolver* NewCachingTypeResolver(TypeResolver* resolver);
+
 // Performs a direct conversion from a descriptor to a type proto.
 PROTOBUF_EXPORT google::protobuf::Type ConvertDescriptorToType(
     absl::string_view url_prefix, const Descriptor& descriptor);
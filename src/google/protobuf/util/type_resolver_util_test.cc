@@ -695,6 +695,71 @@ TEST(ConvertDescriptorToTypeTest, TestCustomEnumOptions) {
       HasInt32Option(value->options(), "protobuf_unittest.enum_value_opt1", 123));
 }
 
+// Counts the requests that reach the wrapped resolver.
+class CountingTypeResolver : public TypeResolver {
+ public:
+  explicit CountingTypeResolver(TypeResolver* resolver)
+      : resolver_(resolver) {}
+
+  absl::Status ResolveMessageType(const std::string& type_url,
+                                  Type* type) override {
+    ++calls_;
+    return resolver_->ResolveMessageType(type_url, type);
+  }
+
+  absl::Status ResolveEnumType(const std::string& type_url,
+                               Enum* enum_type) override {
+    ++calls_;
+    return resolver_->ResolveEnumType(type_url, enum_type);
+  }
+
+  int calls() const { return calls_; }
+
+ private:
+  TypeResolver* resolver_;
+  int calls_ = 0;
+};
+
+TEST(CachingTypeResolverTest, ResolvesEachUrlOnce) {
+  std::unique_ptr<TypeResolver> pool_resolver(NewTypeResolverForDescriptorPool(
+      kUrlPrefix, DescriptorPool::generated_pool()));
+  CountingTypeResolver counting(pool_resolver.get());
+  std::unique_ptr<TypeResolver> resolver(NewCachingTypeResolver(&counting));
+
+  std::string url = GetTypeUrl<protobuf_unittest::TestAllTypes>();
+  Type expected;
+  ASSERT_TRUE(pool_resolver->ResolveMessageType(url, &expected).ok());
+  for (int i = 0; i < 3; ++i) {
+    Type type;
+    ASSERT_TRUE(resolver->ResolveMessageType(url, &type).ok());
+    EXPECT_EQ(type.SerializeAsString(), expected.SerializeAsString());
+  }
+  EXPECT_EQ(counting.calls(), 1);
+
+  std::string enum_url =
+      GetTypeUrl(protobuf_unittest::TestAllTypes::NestedEnum_descriptor()
+                     ->full_name());
+  for (int i = 0; i < 3; ++i) {
+    Enum type;
+    ASSERT_TRUE(resolver->ResolveEnumType(enum_url, &type).ok());
+    EXPECT_TRUE(FindEnumValue(type, "BAZ") != nullptr);
+  }
+  EXPECT_EQ(counting.calls(), 2);
+}
+
+TEST(CachingTypeResolverTest, DoesNotCacheErrors) {
+  std::unique_ptr<TypeResolver> pool_resolver(NewTypeResolverForDescriptorPool(
+      kUrlPrefix, DescriptorPool::generated_pool()));
+  CountingTypeResolver counting(pool_resolver.get());
+  std::unique_ptr<TypeResolver> resolver(NewCachingTypeResolver(&counting));
+
+  Type type;
+  std::string url = GetTypeUrl("protobuf_unittest.NoSuchType");
+  EXPECT_FALSE(resolver->ResolveMessageType(url, &type).ok());
+  EXPECT_FALSE(resolver->ResolveMessageType(url, &type).ok());
+  EXPECT_EQ(counting.calls(), 2);
+}
+
 }  // namespace
 }  // namespace util
 }  // namespace protobuf
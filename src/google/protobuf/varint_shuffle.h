@@ -37,6 +37,14 @@
 #include <type_traits>
 #include <utility>
 
+#include "absl/numeric/bits.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 // Must be included last.
 #include "google/protobuf/port_def.inc"
 
@@ -177,6 +185,50 @@ limit0:
   return p;
 }
 
+// Returns a mask with bit `i` set iff the continuation bit of `p[i]` is set,
+// for the 16 bytes starting at `p`. A run of single byte varints starting at
+// `p` is `absl::countr_zero(mask)` values long.
+inline PROTOBUF_ALWAYS_INLINE uint32_t VarintContinuationMask16(const char* p) {
+#if defined(__SSE2__)
+  return static_cast<uint32_t>(_mm_movemask_epi8(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(p))));
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  // NEON has no movemask; isolate the top bits and weight each lane by its
+  // position in the half register before summing the halves.
+  static constexpr int8_t kShifts[16] = {0, 1, 2, 3, 4, 5, 6, 7,
+                                         0, 1, 2, 3, 4, 5, 6, 7};
+  uint8x16_t bits =
+      vshlq_u8(vshrq_n_u8(vld1q_u8(reinterpret_cast<const uint8_t*>(p)), 7),
+               vld1q_s8(kShifts));
+  return static_cast<uint32_t>(vaddv_u8(vget_low_u8(bits))) |
+         (static_cast<uint32_t>(vaddv_u8(vget_high_u8(bits))) << 8);
+#else
+  uint32_t mask = 0;
+  for (int i = 0; i < 16; ++i) {
+    mask |= static_cast<uint32_t>(static_cast<uint8_t>(p[i]) >> 7) << i;
+  }
+  return mask;
+#endif
+}
+
+// Returns the number of varints that start in [p, end), given that a varint
+// starts at `p`. Every byte with a clear continuation bit ends a varint, so
+// the count is exact even when the last varint continues past `end`.
+inline int CountVarints(const char* p, const char* end) {
+  if (p >= end) return 0;
+  // The last byte of the range can only end a varint, never start one.
+  const char* last = end - 1;
+  int count = 1;
+  while (last - p >= 16) {
+    count += 16 - absl::popcount(VarintContinuationMask16(p));
+    p += 16;
+  }
+  for (; p < last; ++p) {
+    count += static_cast<uint8_t>(*p) < 0x80;
+  }
+  return count;
+}
+
 }  // namespace internal
 }  // namespace protobuf
 }  // namespace google
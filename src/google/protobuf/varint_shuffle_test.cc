@@ -324,6 +324,38 @@ TEST(ShiftMixParseVarint64Test, DroppingOverlongBits) {
   ASSERT_THAT(result, Eq(expected));
 }
 
+TEST(VarintContinuationMask16Test, MatchesContinuationBits) {
+  char data[16];
+  for (int bit = 0; bit < 16; ++bit) {
+    for (int i = 0; i < 16; ++i) data[i] = static_cast<char>(i);
+    data[bit] = '\x80';
+    EXPECT_THAT(VarintContinuationMask16(data), Eq(uint32_t{1} << bit));
+  }
+  for (int i = 0; i < 16; ++i) data[i] = '\xFF';
+  EXPECT_THAT(VarintContinuationMask16(data), Eq(0xFFFFu));
+}
+
+TEST(CountVarintsTest, MixedLengths) {
+  std::vector<char> bytes;
+  int expected = 0;
+  for (uint64_t value = 1; value != 0 && expected < 200; value *= 3) {
+    char buf[10];
+    int len = NaiveSerialize(buf, value);
+    bytes.insert(bytes.end(), buf, buf + len);
+    ++expected;
+  }
+  const char* begin = bytes.data();
+  EXPECT_THAT(CountVarints(begin, begin), Eq(0));
+  EXPECT_THAT(CountVarints(begin, begin + bytes.size()), Eq(expected));
+}
+
+TEST(CountVarintsTest, CountsVarintContinuingPastEnd) {
+  std::vector<char> bytes(40, '\x01');
+  bytes[39] = '\x81';
+  const char* begin = bytes.data();
+  EXPECT_THAT(CountVarints(begin, begin + bytes.size()), Eq(40));
+  EXPECT_THAT(CountVarints(begin, begin + 1), Eq(1));
+}
 
 }  // namespace
 }  // namespace internal
@@ -34,10 +34,13 @@
 
 #include "google/protobuf/wire_format.h"
 
+#include <algorithm>
+#include <cstring>
 #include <stack>
 #include <string>
 #include <vector>
 
+#include "absl/base/casts.h"
 #include "absl/log/absl_check.h"
 #include "absl/log/absl_log.h"
 #include "absl/strings/cord.h"
@@ -52,6 +55,7 @@
 #include "google/protobuf/message.h"
 #include "google/protobuf/message_lite.h"
 #include "google/protobuf/parse_context.h"
+#include "google/protobuf/port.h"
 #include "google/protobuf/unknown_field_set.h"
 
 
@@ -193,9 +197,9 @@ bool WireFormat::ReadPackedEnumPreserveUnknowns(io::CodedInputStream* input,
 uint8_t* WireFormat::InternalSerializeUnknownFieldsToArray(
     const UnknownFieldSet& unknown_fields, uint8_t* target,
     io::EpsCopyOutputStream* stream) {
-  for (int i = 0; i < unknown_fields.field_count(); i++) {
-    const UnknownField& field = unknown_fields.field(i);
-
+  // Fields still in wire form (raw_) follow the decoded ones and are written
+  // back verbatim.
+  for (const UnknownField& field : unknown_fields.fields_) {
     target = stream->EnsureSpace(target);
     switch (field.type()) {
       case UnknownField::TYPE_VARINT:
@@ -225,9 +229,23 @@ uint8_t* WireFormat::InternalSerializeUnknownFieldsToArray(
         break;
     }
   }
+  if (unknown_fields.raw_ != nullptr) {
+    const std::string& raw = *unknown_fields.raw_;
+    target = stream->WriteRaw(raw.data(), static_cast<int>(raw.size()), target);
+  }
   return target;
 }
 
+uint8_t* WireFormat::SerializeUnknownMessageSetItemsToArray(
+    const UnknownFieldSet& unknown_fields, uint8_t* target) {
+  io::EpsCopyOutputStream stream(
+      target,
+      static_cast<int>(ComputeUnknownMessageSetItemsSize(unknown_fields)),
+      io::CodedOutputStream::IsDefaultSerializationDeterministic());
+  return InternalSerializeUnknownMessageSetItemsToArray(unknown_fields, target,
+                                                        &stream);
+}
+
 uint8_t* WireFormat::InternalSerializeUnknownMessageSetItemsToArray(
     const UnknownFieldSet& unknown_fields, uint8_t* target,
     io::EpsCopyOutputStream* stream) {
@@ -266,10 +284,9 @@ uint8_t* WireFormat::InternalSerializeUnknownMessageSetItemsToArray(
 
 size_t WireFormat::ComputeUnknownFieldsSize(
     const UnknownFieldSet& unknown_fields) {
-  size_t size = 0;
-  for (int i = 0; i < unknown_fields.field_count(); i++) {
-    const UnknownField& field = unknown_fields.field(i);
-
+  size_t size =
+      unknown_fields.raw_ != nullptr ? unknown_fields.raw_->size() : 0;
+  for (const UnknownField& field : unknown_fields.fields_) {
     switch (field.type()) {
       case UnknownField::TYPE_VARINT:
         size += io::CodedOutputStream::VarintSize32(WireFormatLite::MakeTag(
@@ -794,6 +811,8 @@ const char* WireFormat::_InternalParse(Message* msg, const char* ptr,
   const Reflection* reflection = msg->GetReflection();
   ABSL_DCHECK(descriptor);
   ABSL_DCHECK(reflection);
+  // Required fields are left to IsInitialized().
+  ctx->RequireInitializationCheck();
   if (descriptor->options().message_set_wire_format()) {
     MessageSetParser message_set{msg, descriptor, reflection};
     return message_set.ParseMessageSet(ptr, ctx);
@@ -1357,6 +1376,45 @@ uint8_t* WireFormat::InternalSerializeField(const FieldDescriptor* field,
     return target;
   }
 
+  // Unpacked repeated primitives: fetch the RepeatedField once and write its
+  // elements directly.
+  if (field->is_repeated()) {
+    switch (field->type()) {
+#define HANDLE_PRIMITIVE_TYPE(TYPE, CPPTYPE, TYPE_METHOD)                      \
+  case FieldDescriptor::TYPE_##TYPE: {                                         \
+    for (CPPTYPE value :                                                       \
+         message_reflection->GetRepeatedFieldInternal<CPPTYPE>(message,        \
+                                                               field)) {       \
+      target = stream->EnsureSpace(target);                                    \
+      target = WireFormatLite::Write##TYPE_METHOD##ToArray(field->number(),    \
+                                                           value, target);     \
+    }                                                                          \
+    return target;                                                             \
+  }
+
+      HANDLE_PRIMITIVE_TYPE(INT32, int32_t, Int32)
+      HANDLE_PRIMITIVE_TYPE(INT64, int64_t, Int64)
+      HANDLE_PRIMITIVE_TYPE(SINT32, int32_t, SInt32)
+      HANDLE_PRIMITIVE_TYPE(SINT64, int64_t, SInt64)
+      HANDLE_PRIMITIVE_TYPE(UINT32, uint32_t, UInt32)
+      HANDLE_PRIMITIVE_TYPE(UINT64, uint64_t, UInt64)
+      HANDLE_PRIMITIVE_TYPE(ENUM, int, Enum)
+
+      HANDLE_PRIMITIVE_TYPE(FIXED32, uint32_t, Fixed32)
+      HANDLE_PRIMITIVE_TYPE(FIXED64, uint64_t, Fixed64)
+      HANDLE_PRIMITIVE_TYPE(SFIXED32, int32_t, SFixed32)
+      HANDLE_PRIMITIVE_TYPE(SFIXED64, int64_t, SFixed64)
+
+      HANDLE_PRIMITIVE_TYPE(FLOAT, float, Float)
+      HANDLE_PRIMITIVE_TYPE(DOUBLE, double, Double)
+
+      HANDLE_PRIMITIVE_TYPE(BOOL, bool, Bool)
+#undef HANDLE_PRIMITIVE_TYPE
+      default:
+        break;
+    }
+  }
+
   auto get_message_from_field = [&message, &map_entries, message_reflection](
                                     const FieldDescriptor* field, int j) {
     if (!field->is_repeated()) {
@@ -1413,12 +1471,14 @@ uint8_t* WireFormat::InternalSerializeField(const FieldDescriptor* field,
       } break;
 
       case FieldDescriptor::TYPE_ENUM: {
-        const EnumValueDescriptor* value =
+        // The number is all that goes on the wire; looking up its
+        // EnumValueDescriptor would be wasted work.
+        const int value =
             field->is_repeated()
-                ? message_reflection->GetRepeatedEnum(message, field, j)
-                : message_reflection->GetEnum(message, field);
-        target = WireFormatLite::WriteEnumToArray(field->number(),
-                                                  value->number(), target);
+                ? message_reflection->GetRepeatedEnumValue(message, field, j)
+                : message_reflection->GetEnumValue(message, field);
+        target = WireFormatLite::WriteEnumToArray(field->number(), value,
+                                                  target);
         break;
       }
 
@@ -1490,6 +1550,497 @@ uint8_t* WireFormat::InternalSerializeMessageSetItem(
   return target;
 }
 
+// ===================================================================
+// Reverse serialization.
+//
+// Everything is written back to front: the contents of a length-delimited
+// field before its length, and the length before its tag.  Fields are
+// visited in descending number order and repeated elements from last to
+// first, so that the result reads front to back in the same order as
+// _InternalSerialize() writes it.
+
+class WireFormat::ReverseEncoder {
+ public:
+  explicit ReverseEncoder(bool deterministic) : deterministic_(deterministic) {}
+
+  void EncodeMessage(const Message& message);
+
+  // Moves the encoding to the front of the buffer and hands it to `output`.
+  void Finish(std::string* output) {
+    const size_t n = size();
+    if (n != 0) memmove(begin_, ptr_, n);
+    buffer_.resize(n);
+    output->swap(buffer_);
+  }
+
+ private:
+  // Number of bytes written so far, which stays valid across Grow().
+  size_t size() const { return static_cast<size_t>(end_ - ptr_); }
+
+  // Returns the `n` bytes right before everything written so far.
+  uint8_t* Reserve(size_t n) {
+    if (PROTOBUF_PREDICT_FALSE(static_cast<size_t>(ptr_ - begin_) < n)) {
+      Grow(n);
+    }
+    ptr_ -= n;
+    return ptr_;
+  }
+  void Grow(size_t n);
+
+  void WriteBytes(const void* data, size_t n) {
+    if (n != 0) memcpy(Reserve(n), data, n);
+  }
+  void WriteVarint(uint64_t value) {
+    uint8_t buf[10];  // The longest varint.
+    WriteBytes(buf,
+               io::CodedOutputStream::WriteVarint64ToArray(value, buf) - buf);
+  }
+  void WriteTag(int number, WireFormatLite::WireType type) {
+    WriteVarint(WireFormatLite::MakeTag(number, type));
+  }
+  // Writes the length and tag of a length-delimited field whose contents are
+  // everything written since size() was `start`.
+  void WriteLengthDelimited(int number, size_t start) {
+    WriteVarint(size() - start);
+    WriteTag(number, WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+  }
+
+  // The value encodings, without tags.
+  void WriteVarintValue(int32_t value) {
+    WriteVarint(static_cast<uint64_t>(static_cast<int64_t>(value)));
+  }
+  void WriteVarintValue(int64_t value) {
+    WriteVarint(static_cast<uint64_t>(value));
+  }
+  void WriteVarintValue(uint32_t value) { WriteVarint(value); }
+  void WriteVarintValue(uint64_t value) { WriteVarint(value); }
+  void WriteVarintValue(bool value) { WriteVarint(value ? 1 : 0); }
+  void WriteZigZag(int32_t value) {
+    WriteVarint(WireFormatLite::ZigZagEncode32(value));
+  }
+  void WriteZigZag(int64_t value) {
+    WriteVarint(WireFormatLite::ZigZagEncode64(value));
+  }
+  void WriteFixed(uint32_t value) {
+    io::CodedOutputStream::WriteLittleEndian32ToArray(value, Reserve(4));
+  }
+  void WriteFixed(uint64_t value) {
+    io::CodedOutputStream::WriteLittleEndian64ToArray(value, Reserve(8));
+  }
+  void WriteFixed(int32_t value) { WriteFixed(static_cast<uint32_t>(value)); }
+  void WriteFixed(int64_t value) { WriteFixed(static_cast<uint64_t>(value)); }
+  void WriteFixed(float value) { WriteFixed(absl::bit_cast<uint32_t>(value)); }
+  void WriteFixed(double value) {
+    WriteFixed(absl::bit_cast<uint64_t>(value));
+  }
+  template <typename T>
+  void WriteFixedArray(const RepeatedField<T>& values) {
+#ifdef PROTOBUF_LITTLE_ENDIAN
+    WriteBytes(values.data(), values.size() * sizeof(T));
+#else
+    for (int i = values.size() - 1; i >= 0; --i) WriteFixed(values.Get(i));
+#endif
+  }
+
+  void EncodeField(const Message& message, const Reflection* reflection,
+                   const FieldDescriptor* field);
+  void EncodePacked(const Message& message, const Reflection* reflection,
+                    const FieldDescriptor* field);
+  // Encodes a string, bytes, group or message field; `index` is -1 for
+  // singular fields.
+  void EncodeNonScalar(const Message& message, const Reflection* reflection,
+                       const FieldDescriptor* field, int index,
+                       const std::vector<const Message*>& map_entries);
+  void EncodeMapEntry(const FieldDescriptor* field, const MapKey& key,
+                      const MapValueConstRef& value);
+  // Encodes the map key or value `field` of type int, bool or string.
+  template <typename T>
+  void EncodeMapScalar(const FieldDescriptor* field, const T& value);
+  void EncodeMessageSetItem(const FieldDescriptor* field,
+                            const Message& message);
+
+  const bool deterministic_;
+  std::string buffer_;
+  uint8_t* begin_ = nullptr;
+  uint8_t* ptr_ = nullptr;
+  uint8_t* end_ = nullptr;
+};
+
+void WireFormat::ReverseEncoder::Grow(size_t n) {
+  const size_t used = size();
+  const size_t capacity =
+      std::max({2 * buffer_.size(), used + n, static_cast<size_t>(256)});
+  std::string grown;
+  STLStringResizeUninitialized(&grown, capacity);
+  uint8_t* grown_end = reinterpret_cast<uint8_t*>(&grown[0]) + capacity;
+  if (used != 0) memcpy(grown_end - used, ptr_, used);
+  buffer_.swap(grown);
+  begin_ = reinterpret_cast<uint8_t*>(&buffer_[0]);
+  end_ = begin_ + capacity;
+  ptr_ = end_ - used;
+}
+
+void WireFormat::ReverseEncoder::EncodeMessage(const Message& message) {
+  const Descriptor* descriptor = message.GetDescriptor();
+  const Reflection* reflection = message.GetReflection();
+
+  // Unknown fields come last, so they are written first.
+  const UnknownFieldSet& unknown_fields = reflection->GetUnknownFields(message);
+  if (!unknown_fields.empty()) {
+    if (descriptor->options().message_set_wire_format()) {
+      SerializeUnknownMessageSetItemsToArray(
+          unknown_fields,
+          Reserve(ComputeUnknownMessageSetItemsSize(unknown_fields)));
+    } else {
+      SerializeUnknownFieldsToArray(
+          unknown_fields, Reserve(ComputeUnknownFieldsSize(unknown_fields)));
+    }
+  }
+
+  std::vector<const FieldDescriptor*> fields;
+  // Fields of map entry should always be serialized.
+  if (descriptor->options().map_entry()) {
+    for (int i = 0; i < descriptor->field_count(); i++) {
+      fields.push_back(descriptor->field(i));
+    }
+  } else {
+    reflection->ListFields(message, &fields);
+  }
+  for (auto it = fields.rbegin(); it != fields.rend(); ++it) {
+    EncodeField(message, reflection, *it);
+  }
+}
+
+void WireFormat::ReverseEncoder::EncodeField(const Message& message,
+                                             const Reflection* reflection,
+                                             const FieldDescriptor* field) {
+  if (field->is_extension() &&
+      field->containing_type()->options().message_set_wire_format() &&
+      field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE &&
+      !field->is_repeated()) {
+    EncodeMessageSetItem(field, message);
+    return;
+  }
+
+  // As in InternalSerializeField(), maps are read through map reflection
+  // while the map is valid, which leaves its representation untouched.
+  if (field->is_map()) {
+    const MapFieldBase* map_field = reflection->GetMapData(message, field);
+    if (map_field->IsMapValid()) {
+      if (deterministic_) {
+        std::vector<MapKey> sorted_keys =
+            MapKeySorter::SortKey(message, reflection, field);
+        for (auto it = sorted_keys.rbegin(); it != sorted_keys.rend(); ++it) {
+          MapValueConstRef value;
+          reflection->LookupMapValue(message, field, *it, &value);
+          EncodeMapEntry(field, *it, value);
+        }
+      } else {
+        for (MapIterator it =
+                 reflection->MapBegin(const_cast<Message*>(&message), field);
+             it != reflection->MapEnd(const_cast<Message*>(&message), field);
+             ++it) {
+          EncodeMapEntry(field, it.GetKey(), it.GetValueRef());
+        }
+      }
+      return;
+    }
+  }
+
+  const int number = field->number();
+  const WireFormatLite::WireType wire_type =
+      WireTypeForFieldType(field->type());
+
+  if (!field->is_repeated()) {
+    switch (field->type()) {
+#define HANDLE_TYPE(TYPE, METHOD, WRITE)              \
+  case FieldDescriptor::TYPE_##TYPE:                  \
+    WRITE(reflection->Get##METHOD(message, field));   \
+    WriteTag(number, wire_type);                      \
+    return;
+
+      HANDLE_TYPE(INT32, Int32, WriteVarintValue)
+      HANDLE_TYPE(INT64, Int64, WriteVarintValue)
+      HANDLE_TYPE(UINT32, UInt32, WriteVarintValue)
+      HANDLE_TYPE(UINT64, UInt64, WriteVarintValue)
+      HANDLE_TYPE(SINT32, Int32, WriteZigZag)
+      HANDLE_TYPE(SINT64, Int64, WriteZigZag)
+      HANDLE_TYPE(ENUM, EnumValue, WriteVarintValue)
+      HANDLE_TYPE(BOOL, Bool, WriteVarintValue)
+      HANDLE_TYPE(FIXED32, UInt32, WriteFixed)
+      HANDLE_TYPE(FIXED64, UInt64, WriteFixed)
+      HANDLE_TYPE(SFIXED32, Int32, WriteFixed)
+      HANDLE_TYPE(SFIXED64, Int64, WriteFixed)
+      HANDLE_TYPE(FLOAT, Float, WriteFixed)
+      HANDLE_TYPE(DOUBLE, Double, WriteFixed)
+#undef HANDLE_TYPE
+      default:
+        EncodeNonScalar(message, reflection, field, -1, {});
+        return;
+    }
+  }
+
+  if (field->is_packed()) {
+    EncodePacked(message, reflection, field);
+    return;
+  }
+
+  switch (field->type()) {
+#define HANDLE_TYPE(TYPE, CPPTYPE, WRITE)                                     \
+  case FieldDescriptor::TYPE_##TYPE: {                                        \
+    const auto& values =                                                      \
+        reflection->GetRepeatedFieldInternal<CPPTYPE>(message, field);        \
+    for (int i = values.size() - 1; i >= 0; --i) {                            \
+      WRITE(values.Get(i));                                                   \
+      WriteTag(number, wire_type);                                            \
+    }                                                                         \
+    return;                                                                   \
+  }
+
+    HANDLE_TYPE(INT32, int32_t, WriteVarintValue)
+    HANDLE_TYPE(INT64, int64_t, WriteVarintValue)
+    HANDLE_TYPE(UINT32, uint32_t, WriteVarintValue)
+    HANDLE_TYPE(UINT64, uint64_t, WriteVarintValue)
+    HANDLE_TYPE(SINT32, int32_t, WriteZigZag)
+    HANDLE_TYPE(SINT64, int64_t, WriteZigZag)
+    HANDLE_TYPE(ENUM, int, WriteVarintValue)
+    HANDLE_TYPE(BOOL, bool, WriteVarintValue)
+    HANDLE_TYPE(FIXED32, uint32_t, WriteFixed)
+    HANDLE_TYPE(FIXED64, uint64_t, WriteFixed)
+    HANDLE_TYPE(SFIXED32, int32_t, WriteFixed)
+    HANDLE_TYPE(SFIXED64, int64_t, WriteFixed)
+    HANDLE_TYPE(FLOAT, float, WriteFixed)
+    HANDLE_TYPE(DOUBLE, double, WriteFixed)
+#undef HANDLE_TYPE
+    default:
+      break;
+  }
+
+  const int count = reflection->FieldSize(message, field);
+  // map_entries is for maps that'll be deterministically serialized.
+  std::vector<const Message*> map_entries;
+  if (count > 1 && field->is_map() && deterministic_) {
+    map_entries = DynamicMapSorter::Sort(message, count, reflection, field);
+  }
+  for (int i = count - 1; i >= 0; --i) {
+    EncodeNonScalar(message, reflection, field, i, map_entries);
+  }
+}
+
+void WireFormat::ReverseEncoder::EncodePacked(const Message& message,
+                                              const Reflection* reflection,
+                                              const FieldDescriptor* field) {
+  if (reflection->FieldSize(message, field) == 0) return;
+  const size_t start = size();
+  switch (field->type()) {
+#define HANDLE_TYPE(TYPE, CPPTYPE, WRITE)                                     \
+  case FieldDescriptor::TYPE_##TYPE: {                                        \
+    const auto& values =                                                      \
+        reflection->GetRepeatedFieldInternal<CPPTYPE>(message, field);        \
+    for (int i = values.size() - 1; i >= 0; --i) WRITE(values.Get(i));        \
+    break;                                                                    \
+  }
+
+    HANDLE_TYPE(INT32, int32_t, WriteVarintValue)
+    HANDLE_TYPE(INT64, int64_t, WriteVarintValue)
+    HANDLE_TYPE(UINT32, uint32_t, WriteVarintValue)
+    HANDLE_TYPE(UINT64, uint64_t, WriteVarintValue)
+    HANDLE_TYPE(SINT32, int32_t, WriteZigZag)
+    HANDLE_TYPE(SINT64, int64_t, WriteZigZag)
+    HANDLE_TYPE(ENUM, int, WriteVarintValue)
+    HANDLE_TYPE(BOOL, bool, WriteVarintValue)
+#undef HANDLE_TYPE
+#define HANDLE_TYPE(TYPE, CPPTYPE)                                             \
+  case FieldDescriptor::TYPE_##TYPE:                                           \
+    WriteFixedArray(                                                           \
+        reflection->GetRepeatedFieldInternal<CPPTYPE>(message, field));        \
+    break;
+
+    HANDLE_TYPE(FIXED32, uint32_t)
+    HANDLE_TYPE(FIXED64, uint64_t)
+    HANDLE_TYPE(SFIXED32, int32_t)
+    HANDLE_TYPE(SFIXED64, int64_t)
+    HANDLE_TYPE(FLOAT, float)
+    HANDLE_TYPE(DOUBLE, double)
+#undef HANDLE_TYPE
+    default:
+      ABSL_LOG(FATAL) << "Invalid descriptor";
+  }
+  WriteLengthDelimited(field->number(), start);
+}
+
+void WireFormat::ReverseEncoder::EncodeNonScalar(
+    const Message& message, const Reflection* reflection,
+    const FieldDescriptor* field, int index,
+    const std::vector<const Message*>& map_entries) {
+  const int number = field->number();
+  auto get_message = [&]() -> const Message& {
+    if (index < 0) return reflection->GetMessage(message, field);
+    if (!map_entries.empty()) return *map_entries[index];
+    return reflection->GetRepeatedMessage(message, field, index);
+  };
+  switch (field->type()) {
+    case FieldDescriptor::TYPE_GROUP:
+      WriteTag(number, WireFormatLite::WIRETYPE_END_GROUP);
+      EncodeMessage(get_message());
+      WriteTag(number, WireFormatLite::WIRETYPE_START_GROUP);
+      break;
+
+    case FieldDescriptor::TYPE_MESSAGE: {
+      const size_t start = size();
+      EncodeMessage(get_message());
+      WriteLengthDelimited(number, start);
+      break;
+    }
+
+    case FieldDescriptor::TYPE_STRING:
+    case FieldDescriptor::TYPE_BYTES: {
+      const size_t start = size();
+      if (index < 0 &&
+          internal::cpp::EffectiveStringCType(field) == FieldOptions::CORD) {
+        absl::Cord value = reflection->GetCord(message, field);
+        uint8_t* target = Reserve(value.size());
+        for (absl::string_view chunk : value.Chunks()) {
+          memcpy(target, chunk.data(), chunk.size());
+          target += chunk.size();
+        }
+        WriteLengthDelimited(number, start);
+        break;
+      }
+      std::string scratch;
+      const std::string& value =
+          index < 0 ? reflection->GetStringReference(message, field, &scratch)
+                    : reflection->GetRepeatedStringReference(message, field,
+                                                             index, &scratch);
+      if (field->type() == FieldDescriptor::TYPE_STRING) {
+        if (field->requires_utf8_validation()) {
+          WireFormatLite::VerifyUtf8String(value.data(), value.length(),
+                                           WireFormatLite::SERIALIZE,
+                                           field->full_name().c_str());
+        } else {
+          VerifyUTF8StringNamedField(value.data(), value.length(), SERIALIZE,
+                                     field->full_name().c_str());
+        }
+      }
+      WriteBytes(value.data(), value.size());
+      WriteLengthDelimited(number, start);
+      break;
+    }
+
+    default:
+      ABSL_LOG(FATAL) << "Invalid descriptor";
+  }
+}
+
+template <typename T>
+void WireFormat::ReverseEncoder::EncodeMapScalar(const FieldDescriptor* field,
+                                                 const T& value) {
+  switch (field->type()) {
+    case FieldDescriptor::TYPE_INT32:
+      WriteVarintValue(value.GetInt32Value());
+      break;
+    case FieldDescriptor::TYPE_INT64:
+      WriteVarintValue(value.GetInt64Value());
+      break;
+    case FieldDescriptor::TYPE_UINT32:
+      WriteVarintValue(value.GetUInt32Value());
+      break;
+    case FieldDescriptor::TYPE_UINT64:
+      WriteVarintValue(value.GetUInt64Value());
+      break;
+    case FieldDescriptor::TYPE_SINT32:
+      WriteZigZag(value.GetInt32Value());
+      break;
+    case FieldDescriptor::TYPE_SINT64:
+      WriteZigZag(value.GetInt64Value());
+      break;
+    case FieldDescriptor::TYPE_BOOL:
+      WriteVarintValue(value.GetBoolValue());
+      break;
+    case FieldDescriptor::TYPE_FIXED32:
+      WriteFixed(value.GetUInt32Value());
+      break;
+    case FieldDescriptor::TYPE_FIXED64:
+      WriteFixed(value.GetUInt64Value());
+      break;
+    case FieldDescriptor::TYPE_SFIXED32:
+      WriteFixed(value.GetInt32Value());
+      break;
+    case FieldDescriptor::TYPE_SFIXED64:
+      WriteFixed(value.GetInt64Value());
+      break;
+    case FieldDescriptor::TYPE_STRING:
+    case FieldDescriptor::TYPE_BYTES: {
+      const std::string& s = value.GetStringValue();
+      WriteBytes(s.data(), s.size());
+      WriteVarint(s.size());
+      break;
+    }
+    default:
+      ABSL_LOG(FATAL) << "Invalid descriptor";
+  }
+  WriteTag(field->number(), WireTypeForFieldType(field->type()));
+}
+
+void WireFormat::ReverseEncoder::EncodeMapEntry(const FieldDescriptor* field,
+                                                const MapKey& key,
+                                                const MapValueConstRef& value) {
+  const FieldDescriptor* key_field = field->message_type()->field(0);
+  const FieldDescriptor* value_field = field->message_type()->field(1);
+  const size_t start = size();
+
+  switch (value_field->type()) {
+    case FieldDescriptor::TYPE_DOUBLE:
+      WriteFixed(value.GetDoubleValue());
+      WriteTag(2, WireFormatLite::WIRETYPE_FIXED64);
+      break;
+    case FieldDescriptor::TYPE_FLOAT:
+      WriteFixed(value.GetFloatValue());
+      WriteTag(2, WireFormatLite::WIRETYPE_FIXED32);
+      break;
+    case FieldDescriptor::TYPE_ENUM:
+      WriteVarintValue(value.GetEnumValue());
+      WriteTag(2, WireFormatLite::WIRETYPE_VARINT);
+      break;
+    case FieldDescriptor::TYPE_MESSAGE: {
+      const size_t value_start = size();
+      EncodeMessage(value.GetMessageValue());
+      WriteLengthDelimited(2, value_start);
+      break;
+    }
+    case FieldDescriptor::TYPE_GROUP:
+      WriteTag(2, WireFormatLite::WIRETYPE_END_GROUP);
+      EncodeMessage(value.GetMessageValue());
+      WriteTag(2, WireFormatLite::WIRETYPE_START_GROUP);
+      break;
+    default:
+      EncodeMapScalar(value_field, value);
+  }
+  EncodeMapScalar(key_field, key);
+  WriteLengthDelimited(field->number(), start);
+}
+
+void WireFormat::ReverseEncoder::EncodeMessageSetItem(
+    const FieldDescriptor* field, const Message& message) {
+  WriteTag(WireFormatLite::kMessageSetItemNumber,
+           WireFormatLite::WIRETYPE_END_GROUP);
+  const size_t start = size();
+  EncodeMessage(message.GetReflection()->GetMessage(message, field));
+  WriteLengthDelimited(WireFormatLite::kMessageSetMessageNumber, start);
+  WriteVarint(field->number());
+  WriteTag(WireFormatLite::kMessageSetTypeIdNumber,
+           WireFormatLite::WIRETYPE_VARINT);
+  WriteTag(WireFormatLite::kMessageSetItemNumber,
+           WireFormatLite::WIRETYPE_START_GROUP);
+}
+
+void WireFormat::SerializeReverse(const Message& message, std::string* output) {
+  ReverseEncoder encoder(
+      io::CodedOutputStream::IsDefaultSerializationDeterministic());
+  encoder.EncodeMessage(message);
+  encoder.Finish(output);
+}
+
 // ===================================================================
 
 size_t WireFormat::ByteSize(const Message& message) {
@@ -1703,17 +2254,34 @@ size_t WireFormat::FieldDataOnlyByteSize(const FieldDescriptor* field,
     }                                                                       \
     break;
 
+// Repeated varints are sized straight from the RepeatedField rather than
+// through one reflection call per element.
+#define HANDLE_VARINT_TYPE(TYPE, TYPE_METHOD, CPPTYPE, CPPTYPE_METHOD)   \
+  case FieldDescriptor::TYPE_##TYPE:                                     \
+    if (field->is_repeated()) {                                          \
+      if (count > 0) {                                                   \
+        data_size += WireFormatLite::TYPE_METHOD##Size(                  \
+            message_reflection->GetRepeatedFieldInternal<CPPTYPE>(       \
+                message, field));                                        \
+      }                                                                  \
+    } else {                                                             \
+      data_size += WireFormatLite::TYPE_METHOD##Size(                    \
+          message_reflection->Get##CPPTYPE_METHOD(message, field));      \
+    }                                                                    \
+    break;
+
 #define HANDLE_FIXED_TYPE(TYPE, TYPE_METHOD)                   \
   case FieldDescriptor::TYPE_##TYPE:                           \
     data_size += count * WireFormatLite::k##TYPE_METHOD##Size; \
     break;
 
-    HANDLE_TYPE(INT32, Int32, Int32)
-    HANDLE_TYPE(INT64, Int64, Int64)
-    HANDLE_TYPE(SINT32, SInt32, Int32)
-    HANDLE_TYPE(SINT64, SInt64, Int64)
-    HANDLE_TYPE(UINT32, UInt32, UInt32)
-    HANDLE_TYPE(UINT64, UInt64, UInt64)
+    HANDLE_VARINT_TYPE(INT32, Int32, int32_t, Int32)
+    HANDLE_VARINT_TYPE(INT64, Int64, int64_t, Int64)
+    HANDLE_VARINT_TYPE(SINT32, SInt32, int32_t, Int32)
+    HANDLE_VARINT_TYPE(SINT64, SInt64, int64_t, Int64)
+    HANDLE_VARINT_TYPE(UINT32, UInt32, uint32_t, UInt32)
+    HANDLE_VARINT_TYPE(UINT64, UInt64, uint64_t, UInt64)
+    HANDLE_VARINT_TYPE(ENUM, Enum, int, EnumValue)
 
     HANDLE_FIXED_TYPE(FIXED32, Fixed32)
     HANDLE_FIXED_TYPE(FIXED64, Fixed64)
@@ -1728,21 +2296,9 @@ size_t WireFormat::FieldDataOnlyByteSize(const FieldDescriptor* field,
     HANDLE_TYPE(GROUP, Group, Message)
     HANDLE_TYPE(MESSAGE, Message, Message)
 #undef HANDLE_TYPE
+#undef HANDLE_VARINT_TYPE
 #undef HANDLE_FIXED_TYPE
 
-    case FieldDescriptor::TYPE_ENUM: {
-      if (field->is_repeated()) {
-        for (size_t j = 0; j < count; j++) {
-          data_size += WireFormatLite::EnumSize(
-              message_reflection->GetRepeatedEnum(message, field, j)->number());
-        }
-      } else {
-        data_size += WireFormatLite::EnumSize(
-            message_reflection->GetEnum(message, field)->number());
-      }
-      break;
-    }
-
     // Handle strings separately so that we can get string references
     // instead of copying.
     case FieldDescriptor::TYPE_STRING:
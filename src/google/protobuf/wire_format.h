@@ -137,6 +137,13 @@ class PROTOBUF_EXPORT WireFormat {
   static uint8_t* _InternalSerialize(const Message& message, uint8_t* target,
                                      io::EpsCopyOutputStream* stream);
 
+  // Serializes `message` into `output`, replacing its contents, in a single
+  // walk of the message tree and without cached sizes.  The encoding is
+  // written from the end of a growing buffer towards its front, as upb's
+  // encoder does, so the length of every submessage is known by the time its
+  // prefix is written.  Implements Message::SerializePartialReverseToString().
+  static void SerializeReverse(const Message& message, std::string* output);
+
   // Implements Message::ByteSize() via reflection.  WARNING:  The result
   // of this method is *not* cached anywhere.  However, all embedded messages
   // will have their ByteSize() methods called, so their sizes will be cached.
@@ -287,6 +294,7 @@ class PROTOBUF_EXPORT WireFormat {
 
  private:
   struct MessageSetParser;
+  class ReverseEncoder;
   friend class TcParser;
   // Skip a MessageSet field.
   static bool SkipMessageSetField(io::CodedInputStream* input,
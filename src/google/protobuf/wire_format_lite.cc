@@ -46,6 +46,9 @@
 #include "absl/strings/str_format.h"
 #include "utf8_validity.h"
 
+#if defined(__SSE2__) && !defined(__clang__)
+#include <emmintrin.h>
+#endif
 
 // Must be included last.
 #include "google/protobuf/port_def.inc"
@@ -708,10 +711,49 @@ static size_t VarintSize64(const T* data, const int n) {
   return sum;
 }
 
-// GCC does not recognize the vectorization opportunity
-// and other platforms are untested, in those cases using the optimized
-// varint size routine for each element is faster.
-// Hence we enable it only for clang
+#if defined(__SSE2__) && !defined(__clang__)
+// GCC does not vectorize VarintSize above, so spell out the sequence clang
+// produces for it: four biased signed compares per 4 ints (SSE2 has no
+// unsigned compare), each subtracting its -1/0 result from the accumulator.
+template <bool ZigZag, bool SignExtended, typename T>
+static size_t VarintSizeSse2(const T* data, const int n) {
+  static_assert(sizeof(T) == 4, "This routine only works for 32 bit integers");
+  const __m128i bias = _mm_set1_epi32(std::numeric_limits<int32_t>::min());
+  const __m128i size1 = _mm_xor_si128(_mm_set1_epi32(0x7F), bias);
+  const __m128i size2 = _mm_xor_si128(_mm_set1_epi32(0x3FFF), bias);
+  const __m128i size3 = _mm_xor_si128(_mm_set1_epi32(0x1FFFFF), bias);
+  const __m128i size4 = _mm_xor_si128(_mm_set1_epi32(0xFFFFFFF), bias);
+  __m128i sum = _mm_setzero_si128();
+  __m128i msb_sum = _mm_setzero_si128();
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    if (ZigZag) {
+      x = _mm_xor_si128(_mm_slli_epi32(x, 1), _mm_srai_epi32(x, 31));
+    } else if (SignExtended) {
+      msb_sum = _mm_add_epi32(msb_sum, _mm_srli_epi32(x, 31));
+    }
+    x = _mm_xor_si128(x, bias);
+    sum = _mm_sub_epi32(sum, _mm_cmpgt_epi32(x, size1));
+    sum = _mm_sub_epi32(sum, _mm_cmpgt_epi32(x, size2));
+    sum = _mm_sub_epi32(sum, _mm_cmpgt_epi32(x, size3));
+    sum = _mm_sub_epi32(sum, _mm_cmpgt_epi32(x, size4));
+  }
+  if (SignExtended) {
+    // msb_sum * 5, without SSE4.1's 32 bit multiply.
+    sum = _mm_add_epi32(sum, _mm_add_epi32(_mm_slli_epi32(msb_sum, 2),
+                                           msb_sum));
+  }
+  alignas(16) uint32_t lanes[4];
+  _mm_store_si128(reinterpret_cast<__m128i*>(lanes), sum);
+  return static_cast<size_t>(i) + lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+         VarintSize<ZigZag, SignExtended>(data + i, n - i);
+}
+#endif
+
+// GCC does not recognize the vectorization opportunity in VarintSize, so it
+// gets the explicit SSE2 kernel above. Other platforms are untested, in those
+// cases using the optimized varint size routine for each element is faster.
 #if (defined(__SSE__) || defined(__aarch64__)) && defined(__clang__)
 size_t WireFormatLite::Int32Size(const RepeatedField<int32_t>& value) {
   return VarintSize<false, true>(value.data(), value.size());
@@ -730,6 +772,25 @@ size_t WireFormatLite::EnumSize(const RepeatedField<int>& value) {
   return VarintSize<false, true>(value.data(), value.size());
 }
 
+#elif defined(__SSE2__)
+
+size_t WireFormatLite::Int32Size(const RepeatedField<int32_t>& value) {
+  return VarintSizeSse2<false, true>(value.data(), value.size());
+}
+
+size_t WireFormatLite::UInt32Size(const RepeatedField<uint32_t>& value) {
+  return VarintSizeSse2<false, false>(value.data(), value.size());
+}
+
+size_t WireFormatLite::SInt32Size(const RepeatedField<int32_t>& value) {
+  return VarintSizeSse2<true, false>(value.data(), value.size());
+}
+
+size_t WireFormatLite::EnumSize(const RepeatedField<int>& value) {
+  // On ILP64, sizeof(int) == 8, which would require a different template.
+  return VarintSizeSse2<false, true>(value.data(), value.size());
+}
+
 #else  // !((defined(__SSE__) || defined(__aarch64__) && defined(__clang__))
 
 size_t WireFormatLite::Int32Size(const RepeatedField<int32_t>& value) {
@@ -29,6 +29,10 @@
 #include <tmmintrin.h>
 #endif
 
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
 namespace utf8_range {
 namespace {
 
@@ -330,6 +334,95 @@ size_t ValidUTF8(const char* data, size_t len) {
   __m128i prev_input = _mm_set1_epi8(0);
   __m128i prev_first_len = _mm_set1_epi8(0);
   __m128i error = _mm_set1_epi8(0);
+#ifdef __AVX2__
+  /* The same algorithm on 32 bytes at once. Byte shifts work within 128 bit
+   * lanes, so the input shifted by N bytes is built from the previous input's
+   * upper lane followed by the current input's lower lane. The 16 byte loop
+   * below picks up from the state of the last 32 bytes, and in the
+   * ReturnPosition case also rechecks the 32 bytes an error was found in to
+   * find its position.
+   */
+  if (end - data >= 32) {
+    const __m256i first_len_table2 =
+        _mm256_broadcastsi128_si256(first_len_table);
+    const __m256i first_range_table2 =
+        _mm256_broadcastsi128_si256(first_range_table);
+    const __m256i range_min_table2 =
+        _mm256_broadcastsi128_si256(range_min_table);
+    const __m256i range_max_table2 =
+        _mm256_broadcastsi128_si256(range_max_table);
+    const __m256i df_ee_table2 = _mm256_broadcastsi128_si256(df_ee_table);
+    const __m256i ef_fe_table2 = _mm256_broadcastsi128_si256(ef_fe_table);
+
+    __m256i prev_input2 = _mm256_set1_epi8(0);
+    __m256i prev_first_len2 = _mm256_set1_epi8(0);
+    __m256i error2 = _mm256_set1_epi8(0);
+    while (end - data >= 32) {
+      const __m256i input =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+
+      const __m256i high_nibbles =
+          _mm256_and_si256(_mm256_srli_epi16(input, 4), _mm256_set1_epi8(0x0F));
+      const __m256i first_len =
+          _mm256_shuffle_epi8(first_len_table2, high_nibbles);
+      __m256i range = _mm256_shuffle_epi8(first_range_table2, high_nibbles);
+
+      /* (first_len, prev_first_len) << N bytes, as in the 16 byte loop */
+      const __m256i first_len_prev =
+          _mm256_permute2x128_si256(prev_first_len2, first_len, 0x21);
+      range = _mm256_or_si256(
+          range, _mm256_alignr_epi8(first_len, first_len_prev, 15));
+
+      __m256i tmp1;
+      __m256i tmp2;
+      tmp1 = _mm256_subs_epu8(first_len, _mm256_set1_epi8(1));
+      tmp2 = _mm256_subs_epu8(first_len_prev, _mm256_set1_epi8(1));
+      range = _mm256_or_si256(range, _mm256_alignr_epi8(tmp1, tmp2, 14));
+
+      tmp1 = _mm256_subs_epu8(first_len, _mm256_set1_epi8(2));
+      tmp2 = _mm256_subs_epu8(first_len_prev, _mm256_set1_epi8(2));
+      range = _mm256_or_si256(range, _mm256_alignr_epi8(tmp1, tmp2, 13));
+
+      /* Adjust Second Byte range for special First Bytes(E0,ED,F0,F4) */
+      const __m256i input_prev =
+          _mm256_permute2x128_si256(prev_input2, input, 0x21);
+      const __m256i shift1 = _mm256_alignr_epi8(input, input_prev, 15);
+      const __m256i pos = _mm256_sub_epi8(shift1, _mm256_set1_epi8(0xEF));
+      tmp1 = _mm256_subs_epu8(pos, _mm256_set1_epi8(-16));
+      __m256i range2 = _mm256_shuffle_epi8(df_ee_table2, tmp1);
+      tmp2 = _mm256_adds_epu8(pos, _mm256_set1_epi8(112));
+      range2 =
+          _mm256_add_epi8(range2, _mm256_shuffle_epi8(ef_fe_table2, tmp2));
+
+      range = _mm256_add_epi8(range, range2);
+
+      const __m256i min_range = _mm256_shuffle_epi8(range_min_table2, range);
+      const __m256i max_range = _mm256_shuffle_epi8(range_max_table2, range);
+
+      /* input < min_range || input > max_range, signed like the SSE code */
+      if (ReturnPosition) {
+        const __m256i chunk_error =
+            _mm256_or_si256(_mm256_cmpgt_epi8(min_range, input),
+                            _mm256_cmpgt_epi8(input, max_range));
+        if (!_mm256_testz_si256(chunk_error, chunk_error)) {
+          break;
+        }
+      } else {
+        error2 = _mm256_or_si256(error2, _mm256_cmpgt_epi8(min_range, input));
+        error2 = _mm256_or_si256(error2, _mm256_cmpgt_epi8(input, max_range));
+      }
+
+      prev_input2 = input;
+      prev_first_len2 = first_len;
+
+      data += 32;
+    }
+    prev_input = _mm256_extracti128_si256(prev_input2, 1);
+    prev_first_len = _mm256_extracti128_si256(prev_first_len2, 1);
+    error = _mm_or_si128(_mm256_castsi256_si128(error2),
+                         _mm256_extracti128_si256(error2, 1));
+  }
+#endif  // __AVX2__
   while (end - data >= 16) {
     const __m128i input =
         _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
@@ -1,5 +1,8 @@
 #include "utf8_validity.h"
 
+#include <cstddef>
+#include <string>
+
 #include "gtest/gtest.h"
 #include "absl/strings/string_view.h"
 
@@ -73,4 +76,30 @@ TEST(Utf8Validity, IsStructurallyValid) {
   EXPECT_FALSE(IsStructurallyValid("\xc7\xc8\xcd\xcb"));
 }
 
+TEST(Utf8Validity, LongStrings) {
+  // Long enough for the SIMD paths, and not ASCII so that skipping ASCII does
+  // not cover it.  Each unit has code points of all lengths.
+  const std::string unit = "a\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80";
+  const size_t boundaries[] = {0, 1, 3, 6};
+  std::string valid;
+  for (int i = 0; i < 12; ++i) valid += unit;
+  EXPECT_TRUE(IsStructurallyValid(valid));
+  EXPECT_EQ(valid.size(), SpanStructurallyValid(valid));
+
+  for (absl::string_view bad :
+       {"\x80", "\xc2", "\xc0\x81", "\xe0\x81\x81", "\xf4\xbf\xbf\xbf",
+        "\xED\xA0\x80", "\xc7\xc8\xcd\xcb"}) {
+    for (size_t start = 0; start < valid.size(); start += unit.size()) {
+      for (size_t offset : boundaries) {
+        const size_t pos = start + offset;
+        std::string s = valid.substr(0, pos);
+        s.append(bad.data(), bad.size());
+        s += valid.substr(pos);
+        EXPECT_FALSE(IsStructurallyValid(s)) << pos;
+        EXPECT_EQ(pos, SpanStructurallyValid(s));
+      }
+    }
+  }
+}
+
 }  // namespace utf8_range
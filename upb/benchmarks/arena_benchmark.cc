@@ -0,0 +1,210 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google LLC.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Benchmarks for allocating from one Arena on many threads at once.
+//
+// Every round creates fresh arenas, has all threads allocate a fixed mix of
+// sizes from them concurrently, and destroys them, like a request arena shared
+// by the threads serving the request.  The first allocation of each thread in
+// each arena goes through ThreadSafeArena's SerialArena lookup, adds a
+// SerialArena and, past the capacity of the current chunk of the SerialArena
+// list, grows the list under the arena's mutex.  Benchmarks are named
+//
+//   BM_Arena<Pattern>/threads:<N>/cleanups:<0|1>
+//
+// where <Pattern> is "Shared" for one arena per round and "Alternating" for
+// two arenas that every thread switches between on each allocation, which
+// misses the thread's cached SerialArena every time.  With cleanups, every
+// fourth allocation is an object with a destructor.
+//
+// When built with PROTOBUF_ARENAZ_SAMPLE, a few extra rounds are run with the
+// arenas sampled, and the counters lookups, created and chunks_grown report
+// the SerialArena lookups per round and how many of them added a SerialArena
+// or a chunk.
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "absl/functional/function_ref.h"
+#include "absl/synchronization/mutex.h"
+#include "google/protobuf/arena.h"
+#include "google/protobuf/arenaz_sampler.h"
+
+namespace {
+
+namespace protobuf = ::google::protobuf;
+
+constexpr size_t kSizes[] = {8, 16, 24, 32, 48, 64, 96, 128, 256, 1024};
+constexpr int kNumSizes = sizeof(kSizes) / sizeof(kSizes[0]);
+constexpr int kAllocationsPerThread = 1024;
+
+// Runs `work` on `n` threads at once, once per call to RunRound().
+class Workers {
+ public:
+  Workers(int n, std::function<void()> work) : work_(std::move(work)) {
+    for (int i = 0; i < n; ++i) {
+      threads_.emplace_back([this] { Loop(); });
+    }
+  }
+  Workers(const Workers&) = delete;
+  Workers& operator=(const Workers&) = delete;
+
+  ~Workers() {
+    {
+      absl::MutexLock lock(&mu_);
+      stop_ = true;
+      start_.SignalAll();
+    }
+    for (std::thread& thread : threads_) thread.join();
+  }
+
+  void RunRound() {
+    absl::MutexLock lock(&mu_);
+    ++round_;
+    pending_ = static_cast<int>(threads_.size());
+    start_.SignalAll();
+    while (pending_ != 0) finish_.Wait(&mu_);
+  }
+
+ private:
+  void Loop() {
+    int64_t done = 0;
+    while (true) {
+      {
+        absl::MutexLock lock(&mu_);
+        while (!stop_ && round_ == done) start_.Wait(&mu_);
+        if (stop_) return;
+        done = round_;
+      }
+      work_();
+      absl::MutexLock lock(&mu_);
+      if (--pending_ == 0) finish_.Signal();
+    }
+  }
+
+  const std::function<void()> work_;
+  std::vector<std::thread> threads_;
+  absl::Mutex mu_;
+  absl::CondVar start_;
+  absl::CondVar finish_;
+  int64_t round_ = 0;
+  int pending_ = 0;
+  bool stop_ = false;
+};
+
+void Allocate(protobuf::Arena* arena, int i, bool cleanups) {
+  if (cleanups && i % 4 == 0) {
+    benchmark::DoNotOptimize(protobuf::Arena::Create<std::string>(arena));
+  } else {
+    benchmark::DoNotOptimize(
+        protobuf::Arena::CreateArray<char>(arena, kSizes[i % kNumSizes]));
+  }
+}
+
+void BM_Arena(benchmark::State& state, int num_arenas) {
+  const int num_threads = static_cast<int>(state.range(0));
+  const bool cleanups = state.range(1) != 0;
+  std::vector<std::unique_ptr<protobuf::Arena>> arenas(num_arenas);
+  Workers workers(num_threads, [&] {
+    for (int i = 0; i < kAllocationsPerThread; ++i) {
+      Allocate(arenas[i % num_arenas].get(), i, cleanups);
+    }
+  });
+
+  // `inspect` is called after the threads are done, while the arenas are
+  // still alive.
+  auto round = [&](absl::FunctionRef<void()> inspect) {
+    for (auto& arena : arenas) {
+      arena = std::make_unique<protobuf::Arena>();
+    }
+    workers.RunRound();
+    inspect();
+    for (auto& arena : arenas) {
+      arena.reset();
+    }
+  };
+
+  for (auto _ : state) {
+    round([] {});
+  }
+  state.SetItemsProcessed(state.iterations() * num_threads *
+                          kAllocationsPerThread);
+
+#if defined(PROTOBUF_ARENAZ_SAMPLE)
+  namespace internal = ::google::protobuf::internal;
+  constexpr int kSampledRounds = 8;
+  const bool was_enabled = internal::IsThreadSafeArenazEnabled();
+  internal::SetThreadSafeArenazEnabled(true);
+  size_t lookups = 0;
+  size_t created = 0;
+  size_t chunks_grown = 0;
+  for (int r = 0; r < kSampledRounds; ++r) {
+    // Samples the next arena created on this thread, i.e. the next round's.
+    internal::SetThreadSafeArenazGlobalNextSample(num_arenas);
+    round([&] {
+      internal::GlobalThreadSafeArenazSampler().Iterate(
+          [&](const internal::ThreadSafeArenaStats& stats) {
+            lookups += stats.serial_arena_lookups.load();
+            created += stats.serial_arenas_created.load();
+            chunks_grown += stats.serial_arena_chunks_grown.load();
+          });
+    });
+  }
+  internal::SetThreadSafeArenazEnabled(was_enabled);
+  state.counters["lookups"] = static_cast<double>(lookups) / kSampledRounds;
+  state.counters["created"] = static_cast<double>(created) / kSampledRounds;
+  state.counters["chunks_grown"] =
+      static_cast<double>(chunks_grown) / kSampledRounds;
+#endif
+}
+
+void BM_ArenaShared(benchmark::State& state) { BM_Arena(state, 1); }
+void BM_ArenaAlternating(benchmark::State& state) { BM_Arena(state, 2); }
+
+BENCHMARK(BM_ArenaShared)
+    ->ArgsProduct({benchmark::CreateRange(1, 128, /*multi=*/2), {0, 1}})
+    ->ArgNames({"threads", "cleanups"})
+    ->UseRealTime();
+BENCHMARK(BM_ArenaAlternating)
+    ->ArgsProduct({benchmark::CreateRange(1, 128, /*multi=*/2), {0, 1}})
+    ->ArgNames({"threads", "cleanups"})
+    ->UseRealTime();
+
+}  // namespace
+
+BENCHMARK_MAIN();
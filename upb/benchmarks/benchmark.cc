@@ -32,12 +32,15 @@
 
 #include <string.h>
 
+#include <string>
 #include <vector>
 
 #include "google/ads/googleads/v13/services/google_ads_service.upbdefs.h"
 #include "google/protobuf/descriptor.pb.h"
 #include "absl/container/flat_hash_set.h"
 #include "google/protobuf/dynamic_message.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/text_format.h"
 #include "benchmarks/descriptor.pb.h"
 #include "benchmarks/descriptor.upb.h"
 #include "benchmarks/descriptor.upbdefs.h"
@@ -45,6 +48,7 @@
 #include "upb/base/internal/log2.h"
 #include "upb/mem/arena.h"
 #include "upb/reflection/def.hpp"
+#include "upb/reflection/def_pool_image.h"
 
 upb_StringView descriptor = benchmarks_descriptor_proto_upbdefinit.descriptor;
 namespace protobuf = ::google::protobuf;
@@ -128,6 +132,24 @@ static void BM_ArenaFuseBalanced(benchmark::State& state) {
 }
 BENCHMARK(BM_ArenaFuseBalanced)->Range(2, 128);
 
+static upb_Arena* contended_root;
+
+// Many threads fusing fresh arenas into the same tree, so that every fuse
+// races with the others on the root's refcount.  The root lives until the end
+// of the run, together with everything fused into it, so the iteration count
+// is fixed to keep memory in check.
+static void BM_ArenaFuseContended(benchmark::State& state) {
+  if (state.thread_index() == 0) contended_root = upb_Arena_New();
+  for (auto _ : state) {
+    upb_Arena* arena = upb_Arena_New();
+    upb_Arena_Fuse(contended_root, arena);
+    upb_Arena_Free(arena);
+  }
+  if (state.thread_index() == 0) upb_Arena_Free(contended_root);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ArenaFuseContended)->ThreadRange(1, 16)->Iterations(1 << 14);
+
 enum LoadDescriptorMode {
   NoLayout,
   WithLayout,
@@ -210,6 +232,33 @@ static void BM_LoadAdsDescriptor_Upb(benchmark::State& state) {
 BENCHMARK_TEMPLATE(BM_LoadAdsDescriptor_Upb, NoLayout);
 BENCHMARK_TEMPLATE(BM_LoadAdsDescriptor_Upb, WithLayout);
 
+static void BM_LoadAdsDescriptor_UpbImage(benchmark::State& state) {
+  std::vector<upb_StringView> serialized_files;
+  absl::flat_hash_set<const _upb_DefPool_Init*> seen_files;
+  CollectFileDescriptors(
+      &google_ads_googleads_v13_services_google_ads_service_proto_upbdefinit,
+      serialized_files, seen_files);
+  upb::Arena arena;
+  upb::Status status;
+  size_t size;
+  char* image =
+      upb_DefPoolImage_Build(serialized_files.data(), serialized_files.size(),
+                             arena.ptr(), &size, status.ptr());
+  if (!image) {
+    printf("Failed to build image: %s\n", status.error_message());
+    exit(1);
+  }
+  for (auto _ : state) {
+    upb::DefPool defpool;
+    if (!upb_DefPool_LoadImage(defpool.ptr(), image, size, status.ptr())) {
+      printf("Failed to load image: %s\n", status.error_message());
+      exit(1);
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_LoadAdsDescriptor_UpbImage);
+
 template <LoadDescriptorMode Mode>
 static void BM_LoadAdsDescriptor_Proto2(benchmark::State& state) {
   extern _upb_DefPool_Init
@@ -364,6 +413,30 @@ static void BM_SerializeDescriptor_Proto2(benchmark::State& state) {
 }
 BENCHMARK(BM_SerializeDescriptor_Proto2);
 
+enum TextOutput { ToString, ToStream };
+
+template <TextOutput kOutput>
+static void BM_PrintTextFormat_Proto2(benchmark::State& state) {
+  upb_benchmark::FileDescriptorProto proto;
+  proto.ParseFromArray(descriptor.data, descriptor.size);
+  std::string text;
+  protobuf::TextFormat::PrintToString(proto, &text);
+  std::vector<char> out(text.size());
+  for (auto _ : state) {
+    if (kOutput == ToString) {
+      std::string str;
+      protobuf::TextFormat::PrintToString(proto, &str);
+      benchmark::DoNotOptimize(str);
+    } else {
+      protobuf::io::ArrayOutputStream stream(out.data(), out.size());
+      protobuf::TextFormat::Print(proto, &stream);
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK_TEMPLATE(BM_PrintTextFormat_Proto2, ToString);
+BENCHMARK_TEMPLATE(BM_PrintTextFormat_Proto2, ToStream);
+
 static void BM_SerializeDescriptor_Upb(benchmark::State& state) {
   int64_t total = 0;
   upb_Arena* arena = upb_Arena_New();
@@ -58,9 +58,9 @@ def GitWorktree(commit):
 def Run(cmd):
   subprocess.check_call(cmd, shell=True)
 
-def Benchmark(outbase, bench_cpu=True, runs=12, fasttable=False):
+def Benchmark(outbase, bench_cpu=True, runs=12, fasttable=False,
+              targets=("benchmark",)):
   tmpfile = "/tmp/bench-output.json"
-  Run("rm -rf {}".format(tmpfile))
   #Run("CC=clang bazel test ...")
   if fasttable:
     extra_args = " --//:fasttable_enabled=true"
@@ -68,22 +68,25 @@ def Benchmark(outbase, bench_cpu=True, runs=12, fasttable=False):
     extra_args = ""
 
   if bench_cpu:
-    Run("CC=clang bazel build -c opt --copt=-march=native benchmarks:benchmark" + extra_args)
-    Run("./bazel-bin/benchmarks/benchmark --benchmark_out_format=json --benchmark_out={} --benchmark_repetitions={} --benchmark_min_time=0.05 --benchmark_enable_random_interleaving=true".format(tmpfile, runs))
-    with open(tmpfile) as f:
-      bench_json = json.load(f)
-
-    # Translate into the format expected by benchstat.
     txt_filename = outbase + ".txt"
-    with open(txt_filename, "w") as f:
-      for run in bench_json["benchmarks"]:
-        if run["run_type"] == "aggregate":
-          continue
-        name = run["name"]
-        name = name.replace(" ", "")
-        name = re.sub(r'^BM_', 'Benchmark', name)
-        values = (name, run["iterations"], run["cpu_time"])
-        print("{} {} {} ns/op".format(*values), file=f)
+    Run("rm -f {}".format(txt_filename))
+    for target in targets:
+      Run("rm -rf {}".format(tmpfile))
+      Run("CC=clang bazel build -c opt --copt=-march=native benchmarks:" + target + extra_args)
+      Run("./bazel-bin/benchmarks/{} --benchmark_out_format=json --benchmark_out={} --benchmark_repetitions={} --benchmark_min_time=0.05 --benchmark_enable_random_interleaving=true".format(target, tmpfile, runs))
+      with open(tmpfile) as f:
+        bench_json = json.load(f)
+
+      # Translate into the format expected by benchstat.
+      with open(txt_filename, "a") as f:
+        for run in bench_json["benchmarks"]:
+          if run["run_type"] == "aggregate":
+            continue
+          name = run["name"]
+          name = name.replace(" ", "")
+          name = re.sub(r'^BM_', 'Benchmark', name)
+          values = (name, run["iterations"], run["cpu_time"])
+          print("{} {} {} ns/op".format(*values), file=f)
     Run("sort {} -o {} ".format(txt_filename, txt_filename))
 
   Run("CC=clang bazel build -c opt --copt=-g --copt=-march=native :conformance_upb"
@@ -94,6 +97,9 @@ def Benchmark(outbase, bench_cpu=True, runs=12, fasttable=False):
 baseline = "main"
 bench_cpu = True
 fasttable = False
+# Benchmark binaries in this package. "cpp_benchmark" and "cpp_benchmark_lite"
+# cover the C++ runtime over a fixed corpus.
+targets = ["benchmark"]
 
 if len(sys.argv) > 1:
   baseline = sys.argv[1]
@@ -102,12 +108,15 @@ if len(sys.argv) > 1:
   with GitWorktree(baseline):
     pass
 
+if len(sys.argv) > 2:
+  targets = sys.argv[2:]
+
 # Benchmark our current directory first, since it's more likely to be broken.
-Benchmark("/tmp/new", bench_cpu, fasttable=fasttable)
+Benchmark("/tmp/new", bench_cpu, fasttable=fasttable, targets=targets)
 
 # Benchmark the baseline.
 with GitWorktree(baseline):
-  Benchmark("/tmp/old", bench_cpu, fasttable=fasttable)
+  Benchmark("/tmp/old", bench_cpu, fasttable=fasttable, targets=targets)
 
 print()
 print()
@@ -0,0 +1,476 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google LLC.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Benchmarks for the C++ runtime over a fixed corpus of messages shaped like
+// common workloads.  Benchmarks are named
+//
+//   BM_Cpp_<Operation>/<Variant>/<Dataset>[/<ArenaMode>]
+//
+// where <Variant> is "Generated" or "Dynamic" (DynamicMessage) in the full
+// build and "Lite" in the LITE_RUNTIME build.  The corpus is generated from a
+// fixed seed, so results are comparable across runs and commits; run with
+// --benchmark_out_format=json or through compare.py.
+
+#include <benchmark/benchmark.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/arena.h"
+#include "google/protobuf/message_lite.h"
+
+#ifdef CPP_BENCHMARK_LITE
+#include "benchmarks/cpp_benchmark_lite.pb.h"
+#else
+#include "google/protobuf/descriptor.pb.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/dynamic_message.h"
+#include "google/protobuf/message.h"
+#include "google/protobuf/text_format.h"
+#include "google/protobuf/util/json_util.h"
+#include "google/protobuf/util/type_resolver.h"
+#include "google/protobuf/util/type_resolver_util.h"
+#include "benchmarks/cpp_benchmark.pb.h"
+#endif
+
+namespace {
+
+namespace protobuf = ::google::protobuf;
+namespace cpp = ::upb_benchmark::cpp;
+
+void Check(bool ok, absl::string_view what) {
+  if (!ok) {
+    fprintf(stderr, "%.*s failed.\n", static_cast<int>(what.size()),
+            what.data());
+    exit(1);
+  }
+}
+
+// Produces the same values on every platform: std::mt19937 is fully specified
+// by the standard, unlike the standard distributions.
+class Generator {
+ public:
+  uint32_t Next() { return rng_(); }
+  uint32_t Uniform(uint32_t n) { return rng_() % n; }
+  uint64_t Next64() {
+    uint64_t hi = Next();
+    return (hi << 32) | Next();
+  }
+  std::string String(size_t min_len, size_t max_len) {
+    static constexpr char kAlphabet[] =
+        "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 -_";
+    std::string s(min_len + Uniform(max_len - min_len + 1), ' ');
+    for (char& c : s) c = kAlphabet[Uniform(sizeof(kAlphabet) - 1)];
+    return s;
+  }
+  std::string Bytes(size_t min_len, size_t max_len) {
+    std::string s(min_len + Uniform(max_len - min_len + 1), '\0');
+    for (char& c : s) c = static_cast<char>(Next());
+    return s;
+  }
+
+ private:
+  std::mt19937 rng_{0x5eed};
+};
+
+void FillRecords(cpp::RecordBatch* batch) {
+  Generator gen;
+  for (int i = 0; i < 256; ++i) {
+    cpp::Record* record = batch->add_records();
+    record->set_timestamp_micros(int64_t{1700000000000000} + i * 1000 +
+                                 gen.Uniform(1000));
+    record->set_severity(static_cast<cpp::Record::Severity>(gen.Uniform(4)));
+    uint32_t host = gen.Uniform(32);
+    record->set_host(absl::StrCat("host-", host, ".example.com"));
+    record->set_message(gen.String(16, 160));
+    record->set_pid(gen.Uniform(1 << 16));
+    record->set_latency_ms(gen.Uniform(100000) / 100.0);
+    record->set_sampled(gen.Uniform(8) == 0);
+    for (uint32_t j = gen.Uniform(5); j > 0; --j) {
+      cpp::Record::Label* label = record->add_labels();
+      label->set_key(gen.String(3, 12));
+      label->set_value(gen.String(1, 24));
+    }
+    record->set_trace_id(gen.Next64());
+  }
+}
+
+void FillMapHeavy(cpp::MapHeavy* msg) {
+  Generator gen;
+  for (int i = 0; i < 512; ++i) {
+    std::string key = gen.String(8, 24);
+    (*msg->mutable_counters())[key] = gen.Next64();
+  }
+  for (int i = 0; i < 256; ++i) {
+    int32_t key = static_cast<int32_t>(gen.Next());
+    cpp::MapHeavy::Value& value = (*msg->mutable_values())[key];
+    value.set_id(i);
+    value.set_name(gen.String(4, 32));
+    value.set_score(gen.Next() / 65536.0);
+  }
+  for (int i = 0; i < 64; ++i) {
+    std::string key = gen.String(4, 16);
+    (*msg->mutable_attributes())[key] = gen.String(8, 64);
+  }
+}
+
+void FillPackedHeavy(cpp::PackedHeavy* msg) {
+  Generator gen;
+  for (int i = 0; i < 4096; ++i) {
+    // Mostly small values with occasional large ones, as with real ids.
+    msg->add_int32s(static_cast<int32_t>(gen.Next() >> gen.Uniform(32)));
+    msg->add_sint64s(static_cast<int64_t>(gen.Next64()) >> gen.Uniform(64));
+    msg->add_fixed32s(gen.Next());
+    msg->add_doubles(gen.Next() / 1024.0);
+    msg->add_bools(gen.Uniform(2) == 0);
+  }
+}
+
+void FillStringHeavy(cpp::StringHeavy* msg) {
+  Generator gen;
+  msg->set_name(gen.String(16, 16));
+  for (int i = 0; i < 256; ++i) msg->add_strings(gen.String(8, 256));
+  for (int i = 0; i < 64; ++i) msg->add_blobs(gen.Bytes(256, 4096));
+}
+
+void FillNested(cpp::Nested* msg) {
+  Generator gen;
+  // Deep, but well below the default recursion limit of the parsers.
+  for (int depth = 0; depth < 64; ++depth) {
+    msg->set_depth(depth);
+    msg->set_payload(gen.String(8, 32));
+    for (int i = 0; i < 4; ++i) msg->add_values(gen.Next64());
+    msg = msg->mutable_child();
+  }
+}
+
+void FillTreeLevel(cpp::TreeA* msg, int depth, Generator& gen) {
+  msg->set_id(depth);
+  msg->set_label(gen.String(4, 16));
+  // Each level nests three messages; stay below the default recursion limit
+  // of 100, and branch every few levels so the tree is wide as well as deep.
+  if (depth >= 30) return;
+  int fanout = depth % 6 == 0 ? 2 : 1;
+  for (int i = 0; i < fanout; ++i) {
+    cpp::TreeB* b = msg->add_children();
+    b->set_weight(gen.Next64());
+    for (int j = 0; j < 3; ++j) b->add_tags(gen.Next());
+    cpp::TreeC* c = b->mutable_child();
+    c->set_score(gen.Next() / 1024.0);
+    FillTreeLevel(c->mutable_child(), depth + 1, gen);
+  }
+}
+
+void FillTree(cpp::TreeA* msg) {
+  Generator gen;
+  FillTreeLevel(msg, 0, gen);
+}
+
+#ifndef CPP_BENCHMARK_LITE
+// The descriptors of the messages above and of descriptor.proto itself, a
+// typical metadata-heavy payload.
+void FillFileDescriptorSet(protobuf::FileDescriptorSet* set) {
+  protobuf::FileDescriptorProto::descriptor()->file()->CopyTo(set->add_file());
+  cpp::RecordBatch::descriptor()->file()->CopyTo(set->add_file());
+}
+#endif
+
+struct Dataset {
+  std::string name;
+  // A message populated with the dataset, and its wire format.
+  std::unique_ptr<protobuf::MessageLite> message;
+  std::string payload;
+};
+
+struct Variant {
+  std::string name;
+  std::vector<Dataset> datasets;
+};
+
+template <typename T>
+Dataset MakeDataset(absl::string_view name, void (*fill)(T*)) {
+  auto message = std::make_unique<T>();
+  fill(message.get());
+  std::string payload = message->SerializeAsString();
+  return Dataset{std::string(name), std::move(message), std::move(payload)};
+}
+
+Variant GeneratedVariant() {
+#ifdef CPP_BENCHMARK_LITE
+  Variant variant{"Lite", {}};
+#else
+  Variant variant{"Generated", {}};
+#endif
+  variant.datasets.push_back(MakeDataset("Records", &FillRecords));
+  variant.datasets.push_back(MakeDataset("MapHeavy", &FillMapHeavy));
+  variant.datasets.push_back(MakeDataset("PackedHeavy", &FillPackedHeavy));
+  variant.datasets.push_back(MakeDataset("StringHeavy", &FillStringHeavy));
+  variant.datasets.push_back(MakeDataset("Nested", &FillNested));
+  variant.datasets.push_back(MakeDataset("Tree", &FillTree));
+#ifndef CPP_BENCHMARK_LITE
+  variant.datasets.push_back(
+      MakeDataset("FileDescriptorSet", &FillFileDescriptorSet));
+#endif
+  return variant;
+}
+
+#ifndef CPP_BENCHMARK_LITE
+// The same datasets as `generated`, parsed into DynamicMessages.
+Variant DynamicVariant(const Variant& generated) {
+  static auto* factory = new protobuf::DynamicMessageFactory();
+  Variant variant{"Dynamic", {}};
+  for (const Dataset& dataset : generated.datasets) {
+    const auto& message =
+        static_cast<const protobuf::Message&>(*dataset.message);
+    std::unique_ptr<protobuf::Message> dynamic(
+        factory->GetPrototype(message.GetDescriptor())->New());
+    Check(dynamic->ParseFromString(dataset.payload), "Parsing dynamic message");
+    variant.datasets.push_back(
+        Dataset{dataset.name, std::move(dynamic), dataset.payload});
+  }
+  return variant;
+}
+
+const protobuf::Message& AsMessage(const Dataset& dataset) {
+  return static_cast<const protobuf::Message&>(*dataset.message);
+}
+#endif
+
+enum ArenaMode { kNoArena, kArena };
+
+const char* ArenaModeName(ArenaMode mode) {
+  return mode == kArena ? "Arena" : "NoArena";
+}
+
+// Creates an empty message of the dataset's type, on `arena` if it is set.
+// The caller owns the result if `arena` is null.
+protobuf::MessageLite* NewMessage(const Dataset& dataset,
+                                  protobuf::Arena* arena) {
+  return dataset.message->New(arena);
+}
+
+void BM_Parse(benchmark::State& state, const Dataset& dataset,
+              ArenaMode mode) {
+  for (auto _ : state) {
+    if (mode == kArena) {
+      protobuf::Arena arena;
+      protobuf::MessageLite* msg = NewMessage(dataset, &arena);
+      Check(msg->ParseFromString(dataset.payload), "Parse");
+    } else {
+      std::unique_ptr<protobuf::MessageLite> msg(NewMessage(dataset, nullptr));
+      Check(msg->ParseFromString(dataset.payload), "Parse");
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * dataset.payload.size());
+}
+
+void BM_Serialize(benchmark::State& state, const Dataset& dataset) {
+  std::string out;
+  for (auto _ : state) {
+    Check(dataset.message->SerializeToString(&out), "Serialize");
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetBytesProcessed(state.iterations() * dataset.payload.size());
+}
+
+void BM_ByteSize(benchmark::State& state, const Dataset& dataset) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(dataset.message->ByteSizeLong());
+  }
+  state.SetBytesProcessed(state.iterations() * dataset.payload.size());
+}
+
+// Copies the dataset into a fresh message.
+void BM_Copy(benchmark::State& state, const Dataset& dataset, ArenaMode mode) {
+  for (auto _ : state) {
+    if (mode == kArena) {
+      protobuf::Arena arena;
+      NewMessage(dataset, &arena)->CheckTypeAndMergeFrom(*dataset.message);
+    } else {
+      std::unique_ptr<protobuf::MessageLite> msg(NewMessage(dataset, nullptr));
+      msg->CheckTypeAndMergeFrom(*dataset.message);
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * dataset.payload.size());
+}
+
+// Merges the dataset into a cleared message, reusing the allocations that
+// Clear() retains.
+void BM_Merge(benchmark::State& state, const Dataset& dataset) {
+  std::unique_ptr<protobuf::MessageLite> msg(NewMessage(dataset, nullptr));
+  msg->CheckTypeAndMergeFrom(*dataset.message);
+  for (auto _ : state) {
+    msg->Clear();
+    msg->CheckTypeAndMergeFrom(*dataset.message);
+  }
+  state.SetBytesProcessed(state.iterations() * dataset.payload.size());
+}
+
+#ifndef CPP_BENCHMARK_LITE
+void BM_JsonPrint(benchmark::State& state, const Dataset& dataset) {
+  std::string json;
+  for (auto _ : state) {
+    json.clear();
+    Check(protobuf::util::MessageToJsonString(AsMessage(dataset), &json).ok(),
+          "JSON print");
+  }
+  state.SetBytesProcessed(state.iterations() * json.size());
+}
+
+void BM_JsonParse(benchmark::State& state, const Dataset& dataset) {
+  std::string json;
+  Check(protobuf::util::MessageToJsonString(AsMessage(dataset), &json).ok(),
+        "JSON print");
+  for (auto _ : state) {
+    std::unique_ptr<protobuf::MessageLite> msg(NewMessage(dataset, nullptr));
+    Check(protobuf::util::JsonStringToMessage(
+              json, static_cast<protobuf::Message*>(msg.get()))
+              .ok(),
+          "JSON parse");
+  }
+  state.SetBytesProcessed(state.iterations() * json.size());
+}
+
+// Converts JSON to the wire format through a TypeResolver, which looks types
+// up by URL rather than through the message's descriptor.
+void BM_JsonToBinary(benchmark::State& state, const Dataset& dataset) {
+  const protobuf::Descriptor* descriptor = AsMessage(dataset).GetDescriptor();
+  std::unique_ptr<protobuf::util::TypeResolver> resolver(
+      protobuf::util::NewTypeResolverForDescriptorPool(
+          "type.googleapis.com", descriptor->file()->pool()));
+  std::string type_url =
+      absl::StrCat("type.googleapis.com/", descriptor->full_name());
+  std::string json;
+  Check(protobuf::util::MessageToJsonString(AsMessage(dataset), &json).ok(),
+        "JSON print");
+  std::string binary;
+  for (auto _ : state) {
+    binary.clear();
+    Check(protobuf::util::JsonToBinaryString(resolver.get(), type_url, json,
+                                             &binary)
+              .ok(),
+          "JSON to binary");
+  }
+  state.SetBytesProcessed(state.iterations() * json.size());
+}
+
+void BM_TextPrint(benchmark::State& state, const Dataset& dataset) {
+  std::string text;
+  for (auto _ : state) {
+    Check(protobuf::TextFormat::PrintToString(AsMessage(dataset), &text),
+          "Text print");
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+void BM_TextParse(benchmark::State& state, const Dataset& dataset) {
+  std::string text;
+  Check(protobuf::TextFormat::PrintToString(AsMessage(dataset), &text),
+        "Text print");
+  for (auto _ : state) {
+    std::unique_ptr<protobuf::MessageLite> msg(NewMessage(dataset, nullptr));
+    Check(protobuf::TextFormat::ParseFromString(
+              text, static_cast<protobuf::Message*>(msg.get())),
+          "Text parse");
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+#endif
+
+template <typename F>
+void Register(absl::string_view op, const Variant& variant,
+              const Dataset& dataset, F f) {
+  std::string name = absl::StrCat("BM_Cpp_", op, "/", variant.name, "/",
+                                  dataset.name);
+  benchmark::RegisterBenchmark(name.c_str(), [&dataset, f](
+                                                 benchmark::State& state) {
+    f(state, dataset);
+  });
+}
+
+template <typename F>
+void RegisterWithArenaModes(absl::string_view op, const Variant& variant,
+                            const Dataset& dataset, F f) {
+  for (ArenaMode mode : {kNoArena, kArena}) {
+    std::string name = absl::StrCat("BM_Cpp_", op, "/", variant.name, "/",
+                                    dataset.name, "/", ArenaModeName(mode));
+    benchmark::RegisterBenchmark(
+        name.c_str(), [&dataset, f, mode](benchmark::State& state) {
+          f(state, dataset, mode);
+        });
+  }
+}
+
+void RegisterVariant(const Variant& variant) {
+  for (const Dataset& dataset : variant.datasets) {
+    RegisterWithArenaModes("Parse", variant, dataset, BM_Parse);
+    Register("Serialize", variant, dataset, BM_Serialize);
+    Register("ByteSize", variant, dataset, BM_ByteSize);
+    RegisterWithArenaModes("Copy", variant, dataset, BM_Copy);
+    Register("Merge", variant, dataset, BM_Merge);
+#ifndef CPP_BENCHMARK_LITE
+    Register("JsonPrint", variant, dataset, BM_JsonPrint);
+    Register("JsonParse", variant, dataset, BM_JsonParse);
+    Register("JsonToBinary", variant, dataset, BM_JsonToBinary);
+    Register("TextPrint", variant, dataset, BM_TextPrint);
+    Register("TextParse", variant, dataset, BM_TextParse);
+#endif
+  }
+}
+
+void RegisterBenchmarks() {
+  // The datasets are referenced by the registered benchmarks, so they live
+  // for the rest of the program.
+  static auto* generated = new Variant(GeneratedVariant());
+  RegisterVariant(*generated);
+#ifndef CPP_BENCHMARK_LITE
+  static auto* dynamic = new Variant(DynamicVariant(*generated));
+  RegisterVariant(*dynamic);
+#endif
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  RegisterBenchmarks();
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
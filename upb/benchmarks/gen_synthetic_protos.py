@@ -34,6 +34,8 @@ import sys
 import random
 
 base = sys.argv[1]
+# Number of startup_<i>.proto files to write for the startup benchmark.
+num_startup_files = int(sys.argv[2]) if len(sys.argv) > 2 else 0
 
 field_freqs = [
     (('bool', 'optional'), 8.321),
@@ -121,3 +123,47 @@ with open(base + "/200_fields.proto", "w") as f:
     f.write('  {label} {field_type} field{i} = {i};\n'.format(i=i, label=label,field_type=field_type))
     i += 1
   f.write('}\n')
+
+# Files for the startup benchmark: startup_0.proto .. startup_<n-1>.proto form
+# a balanced import tree with startup_0.proto as its deepest leaf, and
+# startup.proto imports and refers to all of them.  Each file has a few
+# messages with fields referring to messages of the same file and of the file
+# it imports.
+msgs_per_startup_file = 10
+fields_per_startup_msg = 20
+random.seed(a=0, version=2)
+for i in range(num_startup_files):
+  rev = num_startup_files - 1 - i
+  parent = num_startup_files - 1 - (rev - 1) // 2 if rev > 0 else None
+  with open(base + "/startup_{i}.proto".format(i=i), "w") as f:
+    f.write('syntax = "proto2";\n')
+    f.write('package upb_benchmark.startup;\n')
+    if parent is not None:
+      f.write('import "benchmarks/startup_{p}.proto";\n'.format(p=parent))
+    f.write('enum Enum{i} {{ ZERO{i} = 0; ONE{i} = 1; }}\n'.format(i=i))
+    for j in range(msgs_per_startup_file):
+      f.write('message Message{i}_{j} {{\n'.format(i=i, j=j))
+      n = 1
+      for field_type, label in choices(fields_per_startup_msg):
+        if field_type == 'Enum':
+          field_type = 'Enum{i}'.format(i=i)
+        elif field_type == 'Message':
+          if parent is not None and n % 2 == 0:
+            field_type = 'Message{p}_{j}'.format(p=parent, j=j)
+          else:
+            field_type = 'Message{i}_{j}'.format(i=i, j=random.randrange(j + 1))
+        f.write('  {label} {field_type} field{n} = {n};\n'.format(
+            label=label, field_type=field_type, n=n))
+        n += 1
+      f.write('}\n')
+
+if num_startup_files:
+  with open(base + "/startup.proto", "w") as f:
+    f.write('syntax = "proto2";\n')
+    f.write('package upb_benchmark.startup;\n')
+    for i in range(num_startup_files):
+      f.write('import "benchmarks/startup_{i}.proto";\n'.format(i=i))
+    f.write('message Startup {\n')
+    for i in range(num_startup_files):
+      f.write('  optional Message{i}_0 file{i} = {n};\n'.format(i=i, n=i + 1))
+    f.write('}\n')
@@ -0,0 +1,358 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google LLC.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Measures how much memory parsed messages take, for the same payloads in
+// each in-memory representation.  Benchmarks are named
+//
+//   BM_Memory/<Representation>/<Dataset>
+//
+// where <Representation> is "Heap" and "Arena" for generated C++ messages,
+// "Dynamic" for DynamicMessage and "Upb" for upb messages.  Each benchmark
+// parses kCopies copies of the dataset, keeps them all alive, and reports per
+// message:
+//
+//   wire_bytes       The size of the payload, for reference.
+//   space_used       Message::SpaceUsedLong(), in C++.
+//   arena_allocated  The space allocated by the message's arena, with each
+//                    message on its own arena: Arena::SpaceAllocated() or
+//                    upb_Arena_SpaceAllocated().  In C++ this leaves out
+//                    the heap buffers of std::string objects living on the
+//                    arena, e.g. of long strings and unknown fields.
+//   rss              The growth of the resident set size of the process,
+//                    where it can be read (Linux).  Includes allocator
+//                    overhead, but memory freed by the benchmarks that ran
+//                    before is reused, so filter down to one benchmark with
+//                    --benchmark_filter for a meaningful number.
+//
+// The time is that of parsing the kCopies messages once.
+
+#include <benchmark/benchmark.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/arena.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/dynamic_message.h"
+#include "google/protobuf/message.h"
+#include "benchmarks/cpp_benchmark.pb.h"
+#include "benchmarks/memory_benchmark.pb.h"
+#include "benchmarks/memory_benchmark.upbdefs.h"
+#include "upb/mem/arena.h"
+#include "upb/message/message.h"
+#include "upb/reflection/def.hpp"
+#include "upb/wire/decode.h"
+
+namespace {
+
+namespace protobuf = ::google::protobuf;
+namespace cpp = ::upb_benchmark::cpp;
+namespace memory = ::upb_benchmark::memory;
+
+constexpr int kCopies = 256;
+
+void Check(bool ok, absl::string_view what) {
+  if (!ok) {
+    fprintf(stderr, "%.*s failed.\n", static_cast<int>(what.size()),
+            what.data());
+    exit(1);
+  }
+}
+
+// Returns the resident set size of the process, or 0 if it is unknown.
+size_t ResidentBytes() {
+#ifdef __linux__
+  FILE* f = fopen("/proc/self/statm", "r");
+  if (f == nullptr) return 0;
+  unsigned long size = 0;     // NOLINT(runtime/int)
+  unsigned long resident = 0; // NOLINT(runtime/int)
+  int n = fscanf(f, "%lu %lu", &size, &resident);
+  fclose(f);
+  if (n != 2) return 0;
+  return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+  return 0;
+#endif
+}
+
+// Deterministic contents; std::mt19937 is fully specified by the standard.
+class Generator {
+ public:
+  uint32_t Uniform(uint32_t n) { return rng_() % n; }
+  uint64_t Next64() { return (uint64_t{rng_()} << 32) | rng_(); }
+  std::string String(size_t min_len, size_t max_len) {
+    std::string s(min_len + Uniform(max_len - min_len + 1), ' ');
+    for (char& c : s) c = static_cast<char>('a' + Uniform(26));
+    return s;
+  }
+
+ private:
+  std::mt19937 rng_{0x5eed};
+};
+
+void FillRecord(cpp::Record* record, Generator& gen) {
+  record->set_timestamp_micros(int64_t{1700000000000000} + gen.Uniform(1000));
+  record->set_severity(static_cast<cpp::Record::Severity>(gen.Uniform(4)));
+  record->set_host(absl::StrCat("host-", gen.Uniform(32), ".example.com"));
+  record->set_message(gen.String(16, 160));
+  record->set_pid(gen.Uniform(1 << 16));
+  record->set_latency_ms(gen.Uniform(100000) / 100.0);
+  for (uint32_t j = gen.Uniform(5); j > 0; --j) {
+    cpp::Record::Label* label = record->add_labels();
+    label->set_key(gen.String(3, 12));
+    label->set_value(gen.String(1, 24));
+  }
+  record->set_trace_id(gen.Next64());
+}
+
+void FillRecords(cpp::RecordBatch* batch) {
+  Generator gen;
+  for (int i = 0; i < 64; ++i) FillRecord(batch->add_records(), gen);
+}
+
+void FillMaps(cpp::MapHeavy* msg) {
+  Generator gen;
+  for (int i = 0; i < 128; ++i) {
+    (*msg->mutable_counters())[gen.String(8, 24)] = gen.Next64();
+  }
+  for (int i = 0; i < 64; ++i) {
+    cpp::MapHeavy::Value& value =
+        (*msg->mutable_values())[static_cast<int32_t>(gen.Next64())];
+    value.set_id(i);
+    value.set_name(gen.String(4, 32));
+  }
+  for (int i = 0; i < 32; ++i) {
+    (*msg->mutable_attributes())[gen.String(4, 16)] = gen.String(8, 64);
+  }
+}
+
+// Many short strings, with repeats, as in tags and enum-like values.
+void FillRepeatedStrings(cpp::StringHeavy* msg) {
+  Generator gen;
+  std::vector<std::string> vocabulary;
+  for (int i = 0; i < 32; ++i) vocabulary.push_back(gen.String(4, 24));
+  msg->set_name(gen.String(16, 16));
+  for (int i = 0; i < 512; ++i) {
+    msg->add_strings(vocabulary[gen.Uniform(vocabulary.size())]);
+  }
+}
+
+void FillExtensions(memory::Extendable* msg) {
+  Generator gen;
+  msg->set_id(1);
+  msg->SetExtension(memory::name, gen.String(8, 32));
+  for (int i = 0; i < 64; ++i) msg->AddExtension(memory::values, gen.Next64());
+  for (int i = 0; i < 32; ++i) {
+    msg->AddExtension(memory::tags, gen.String(4, 16));
+  }
+  FillRecord(msg->MutableExtension(memory::record), gen);
+}
+
+struct Dataset {
+  std::string name;
+  // The generated default instance of the dataset's type.
+  const protobuf::Message* prototype;
+  std::string payload;
+};
+
+template <typename T>
+Dataset MakeDataset(absl::string_view name, void (*fill)(T*)) {
+  T message;
+  fill(&message);
+  return Dataset{std::string(name), &T::default_instance(),
+                 message.SerializeAsString()};
+}
+
+std::vector<Dataset> MakeDatasets() {
+  std::vector<Dataset> datasets;
+  datasets.push_back(MakeDataset("Records", &FillRecords));
+  datasets.push_back(MakeDataset("Maps", &FillMaps));
+  datasets.push_back(MakeDataset("RepeatedStrings", &FillRepeatedStrings));
+  datasets.push_back(MakeDataset("Extensions", &FillExtensions));
+  // The records again, all of them unknown fields.
+  datasets.push_back(Dataset{"UnknownFields",
+                             &memory::Opaque::default_instance(),
+                             datasets[0].payload});
+  return datasets;
+}
+
+// Accumulates the measurements of the kCopies messages.
+class Footprint {
+ public:
+  explicit Footprint(const Dataset& dataset)
+      : wire_bytes_(dataset.payload.size()), rss_before_(ResidentBytes()) {}
+
+  void AddSpaceUsed(size_t bytes) { space_used_ += bytes; }
+  void AddArenaAllocated(size_t bytes) { arena_allocated_ += bytes; }
+
+  void Report(benchmark::State& state) const {
+    size_t rss_after = ResidentBytes();
+    state.counters["wire_bytes"] = static_cast<double>(wire_bytes_);
+    if (space_used_ > 0) {
+      state.counters["space_used"] = PerMessage(space_used_);
+    }
+    if (arena_allocated_ > 0) {
+      state.counters["arena_allocated"] = PerMessage(arena_allocated_);
+    }
+    if (rss_before_ > 0 && rss_after > rss_before_) {
+      state.counters["rss"] = PerMessage(rss_after - rss_before_);
+    }
+  }
+
+ private:
+  static double PerMessage(size_t bytes) {
+    return static_cast<double>(bytes) / kCopies;
+  }
+
+  const size_t wire_bytes_;
+  const size_t rss_before_;
+  size_t space_used_ = 0;
+  size_t arena_allocated_ = 0;
+};
+
+// Generated messages on the heap, or on an arena each.
+void BM_Generated(benchmark::State& state, const Dataset& dataset,
+                  bool use_arena) {
+  for (auto _ : state) {
+    Footprint footprint(dataset);
+    std::vector<std::unique_ptr<protobuf::Arena>> arenas;
+    std::vector<std::unique_ptr<protobuf::Message>> heap_messages;
+    for (int i = 0; i < kCopies; ++i) {
+      protobuf::Message* msg;
+      if (use_arena) {
+        arenas.push_back(std::make_unique<protobuf::Arena>());
+        msg = dataset.prototype->New(arenas.back().get());
+      } else {
+        heap_messages.emplace_back(dataset.prototype->New());
+        msg = heap_messages.back().get();
+      }
+      Check(msg->ParseFromString(dataset.payload), "Parse");
+      footprint.AddSpaceUsed(msg->SpaceUsedLong());
+      if (use_arena) {
+        footprint.AddArenaAllocated(arenas.back()->SpaceAllocated());
+      }
+    }
+    footprint.Report(state);
+  }
+}
+
+void BM_Dynamic(benchmark::State& state, const Dataset& dataset) {
+  static auto* factory = new protobuf::DynamicMessageFactory();
+  const protobuf::Message* prototype =
+      factory->GetPrototype(dataset.prototype->GetDescriptor());
+  for (auto _ : state) {
+    Footprint footprint(dataset);
+    std::vector<std::unique_ptr<protobuf::Message>> messages;
+    for (int i = 0; i < kCopies; ++i) {
+      messages.emplace_back(prototype->New());
+      // Extensions are looked up in the generated pool, which the dynamic
+      // types do not belong to; they are kept as unknown fields.
+      Check(messages.back()->ParseFromString(dataset.payload), "Parse");
+      footprint.AddSpaceUsed(messages.back()->SpaceUsedLong());
+    }
+    footprint.Report(state);
+  }
+}
+
+void BM_Upb(benchmark::State& state, const Dataset& dataset) {
+  static auto* pool = [] {
+    auto* pool = new upb::DefPool();
+    // Loads memory_benchmark.proto and the files it imports.
+    upb_benchmark_memory_Extendable_getmsgdef(pool->ptr());
+    return pool;
+  }();
+  const upb_MessageDef* m = upb_DefPool_FindMessageByName(
+      pool->ptr(), dataset.prototype->GetDescriptor()->full_name().c_str());
+  Check(m != nullptr, "Finding the upb message");
+  const upb_MiniTable* mini_table = upb_MessageDef_MiniTable(m);
+  for (auto _ : state) {
+    Footprint footprint(dataset);
+    std::vector<upb_Arena*> arenas;
+    for (int i = 0; i < kCopies; ++i) {
+      upb_Arena* arena = upb_Arena_New();
+      arenas.push_back(arena);
+      upb_Message* msg = upb_Message_New(mini_table, arena);
+      Check(upb_Decode(dataset.payload.data(), dataset.payload.size(), msg,
+                       mini_table, upb_DefPool_ExtensionRegistry(pool->ptr()),
+                       0, arena) == kUpb_DecodeStatus_Ok,
+            "upb_Decode");
+      footprint.AddArenaAllocated(upb_Arena_SpaceAllocated(arena));
+    }
+    footprint.Report(state);
+    for (upb_Arena* arena : arenas) upb_Arena_Free(arena);
+  }
+}
+
+template <typename F>
+void Register(absl::string_view representation, const Dataset& dataset, F f) {
+  std::string name =
+      absl::StrCat("BM_Memory/", representation, "/", dataset.name);
+  benchmark::RegisterBenchmark(name.c_str(), [&dataset, f](
+                                                 benchmark::State& state) {
+    f(state, dataset);
+  })->Iterations(1);
+}
+
+void RegisterBenchmarks() {
+  // The datasets are referenced by the registered benchmarks, so they live
+  // for the rest of the program.
+  static auto* datasets = new std::vector<Dataset>(MakeDatasets());
+  for (const Dataset& dataset : *datasets) {
+    Register("Heap", dataset, [](benchmark::State& state, const Dataset& d) {
+      BM_Generated(state, d, /*use_arena=*/false);
+    });
+    Register("Arena", dataset, [](benchmark::State& state, const Dataset& d) {
+      BM_Generated(state, d, /*use_arena=*/true);
+    });
+    Register("Dynamic", dataset, BM_Dynamic);
+    Register("Upb", dataset, BM_Upb);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  RegisterBenchmarks();
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
@@ -0,0 +1,159 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google LLC.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Measures the one-time costs a process pays for the generated code of many
+// .proto files: the synthetic startup_<i>.proto files written by
+// gen_synthetic_protos.py, linked in through startup.proto.  These costs are
+// only paid once per process, so unlike the other benchmarks this binary
+// measures a single startup and prints the results, in microseconds:
+//
+//   before_main   CPU time spent before main(), e.g. in static initializers
+//                 registering the generated files.
+//   first_lookup  Finding a message of startup_0.proto, the deepest file of
+//                 the import tree, which builds the file.  upb loads the
+//                 files it imports along with it, while the C++ generated
+//                 pool builds imports lazily, when they are first used.
+//   full_pool     Building the descriptors of all the other files.
+//   dynamic       Creating the first message of startup_0.proto from its
+//                 descriptor alone: the first DynamicMessageFactory prototype
+//                 in C++; in upb, which has no generated pool to build
+//                 lazily, loading the files into a new pool while building
+//                 their MiniTables at runtime, and creating a message.
+//
+// Built once against the C++ runtime and once, with STARTUP_BENCHMARK_UPB,
+// against upb.  Run it repeatedly, e.g. with `perf stat -r`, to average out
+// noise.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <ctime>
+
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+#ifdef STARTUP_BENCHMARK_UPB
+#include "benchmarks/startup.upbdefs.h"
+#include "benchmarks/startup_0.upbdefs.h"
+#include "upb/mem/arena.hpp"
+#include "upb/message/message.h"
+#include "upb/reflection/def.hpp"
+#include "upb/reflection/internal/def_pool.h"
+#else
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/dynamic_message.h"
+#include "benchmarks/startup.pb.h"
+#endif
+
+namespace {
+
+constexpr char kLeafMessage[] = "upb_benchmark.startup.Message0_0";
+
+// Runs `f` and returns how long it took, in microseconds.
+template <typename F>
+double Time(F f) {
+  absl::Time start = absl::Now();
+  f();
+  return absl::ToDoubleMicroseconds(absl::Now() - start);
+}
+
+void Check(bool ok, const char* what) {
+  if (!ok) {
+    fprintf(stderr, "Failed to %s.\n", what);
+    exit(1);
+  }
+}
+
+}  // namespace
+
+int main() {
+  const double before_main = 1e6 * std::clock() / CLOCKS_PER_SEC;
+  double first_lookup;
+  double full_pool;
+  double dynamic;
+
+#ifdef STARTUP_BENCHMARK_UPB
+  upb::DefPool pool;
+  first_lookup = Time([&] {
+    Check(upb_benchmark_startup_Message0_0_getmsgdef(pool.ptr()) != nullptr,
+          "find the leaf message");
+  });
+  full_pool = Time([&] {
+    Check(upb_benchmark_startup_Startup_getmsgdef(pool.ptr()) != nullptr,
+          "load all files");
+  });
+
+  upb::DefPool dynamic_pool;
+  upb::Arena arena;
+  dynamic = Time([&] {
+    Check(_upb_DefPool_LoadDefInitEx(dynamic_pool.ptr(),
+                                     &benchmarks_startup_0_proto_upbdefinit,
+                                     /*rebuild_minitable=*/true),
+          "load the leaf file");
+    const upb_MessageDef* m =
+        upb_DefPool_FindMessageByName(dynamic_pool.ptr(), kLeafMessage);
+    Check(m != nullptr && upb_Message_New(upb_MessageDef_MiniTable(m),
+                                          arena.ptr()) != nullptr,
+          "create the leaf message");
+  });
+#else
+  // Links in the generated code of every file, which startup.pb.cc refers to.
+  const void* volatile linked =
+      &upb_benchmark::startup::Startup::default_instance();
+  (void)linked;
+
+  const google::protobuf::DescriptorPool* pool =
+      google::protobuf::DescriptorPool::generated_pool();
+  const google::protobuf::Descriptor* leaf;
+  first_lookup = Time([&] {
+    leaf = pool->FindMessageTypeByName(kLeafMessage);
+    Check(leaf != nullptr, "find the leaf message");
+  });
+  full_pool = Time([&] {
+    const google::protobuf::FileDescriptor* file =
+        pool->FindFileByName("benchmarks/startup.proto");
+    Check(file != nullptr, "build startup.proto");
+    for (int i = 0; i < file->dependency_count(); ++i) {
+      Check(file->dependency(i) != nullptr, "build all files");
+    }
+  });
+
+  google::protobuf::DynamicMessageFactory factory;
+  dynamic = Time([&] {
+    Check(factory.GetPrototype(leaf) != nullptr, "create the leaf prototype");
+  });
+#endif
+
+  printf("before_main: %.1f us\n", before_main);
+  printf("first_lookup: %.1f us\n", first_lookup);
+  printf("full_pool: %.1f us\n", full_pool);
+  printf("dynamic: %.1f us\n", dynamic);
+  return 0;
+}
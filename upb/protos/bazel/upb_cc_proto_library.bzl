@@ -269,6 +269,7 @@ _upb_cc_proto_library_aspect = aspect(
                 "//protos:generated_protos_support__only_for_generated_code_do_not_use__i_give_permission_to_break_me",
                 "@com_google_absl//absl/strings",
                 "@com_google_absl//absl/status:statusor",
+                "@com_google_absl//absl/types:span",
                 "//protos",
                 "//protos:repeated_field",
             ],
@@ -37,6 +37,7 @@
 
 #include "absl/base/attributes.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "protos/protos.h"
 #include "protos/protos_traits.h"
 #include "protos/repeated_field_iterator.h"
@@ -117,9 +118,8 @@ class RepeatedFieldProxy
 
   // T::CProxy [] operator specialization.
   typename T::CProxy operator[](size_t n) const {
-    upb_MessageValue message_value = upb_Array_Get(this->arr_, n);
     return ::protos::internal::CreateMessage<typename std::remove_const_t<T>>(
-        (upb_Message*)message_value.msg_val, this->arena_);
+        messages()[n], this->arena_);
   }
 
   // TODO(b:/280069986) : Audit/Finalize based on Iterator Design.
@@ -155,6 +155,13 @@ class RepeatedFieldProxy
 
  private:
   friend class ::protos::Ptr<T>;
+
+  // Reads the element pointers straight out of the array storage rather than
+  // going through upb_Array_Get() for each one.
+  upb_Message* const* messages() const {
+    UPB_ASSERT(this->arr_);
+    return static_cast<upb_Message* const*>(upb_Array_DataPtr(this->arr_));
+  }
 };
 
 // RepeatedField proxy for repeated strings.
@@ -232,11 +239,14 @@ class RepeatedFieldScalarProxy
   // Constructor used by ::protos::Ptr.
   RepeatedFieldScalarProxy(const RepeatedFieldScalarProxy&) = default;
 
-  T operator[](size_t n) const {
-    upb_MessageValue message_value = upb_Array_Get(this->arr_, n);
-    typename std::remove_const_t<T> val;
-    memcpy(&val, &message_value, sizeof(T));
-    return val;
+  T operator[](size_t n) const { return unsafe_array()[n]; }
+
+  // Returns a view of the elements in place. The array stores them
+  // contiguously, so loops over the span compile to plain pointer arithmetic
+  // and can be vectorized. Invalidated by anything that resizes the field.
+  absl::Span<T> span() const {
+    return this->arr_ != nullptr ? absl::Span<T>(unsafe_array(), this->size())
+                                 : absl::Span<T>();
   }
 
   template <int&... DeductionBlocker, bool b = !kIsConst,
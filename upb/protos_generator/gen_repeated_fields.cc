@@ -75,6 +75,13 @@ void WriteRepeatedFieldUsingAccessors(const protobuf::FieldDescriptor* field,
           using $0Access::$1_size;
         )cc",
         class_name, resolved_field_name);
+    if (field->cpp_type() != protobuf::FieldDescriptor::CPPTYPE_STRING) {
+      output(
+          R"cc(
+            using $0Access::$1_span;
+          )cc",
+          class_name, resolved_field_name);
+    }
     if (!read_only) {
       output(
           R"cc(
@@ -138,6 +145,7 @@ void WriteRepeatedFieldsInMessageHeader(const protobuf::Descriptor* desc,
           bool add_$1($0 val);
           void set_$1(size_t index, $0 val);
           bool resize_$1(size_t len);
+          absl::Span<const $0> $1_span() const;
         )cc",
         CppConstType(field), resolved_field_name);
   }
@@ -310,6 +318,16 @@ void WriteRepeatedScalarAccessor(const protobuf::Descriptor* message,
       )cc",
       class_name, CppConstType(field), resolved_field_name,
       MessageName(message), upbc_name);
+  output(
+      R"cc(
+        absl::Span<const $1> $0::$2_span() const {
+          size_t len;
+          const $1* ptr = $3_$4(msg_, &len);
+          return absl::Span<const $1>(ptr, len);
+        }
+      )cc",
+      class_name, CppConstType(field), resolved_field_name,
+      MessageName(message), upbc_name);
   output(
       R"cc(
         void $0::set_$2(size_t index, $1 val) {
@@ -144,6 +144,7 @@ void WriteHeader(const protobuf::FileDescriptor* file, Output& output) {
 
 #include "absl/strings/string_view.h"
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
       )cc",
       ToPreproc(file->name()));
 
@@ -38,6 +38,7 @@
 #include "gtest/gtest.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "protos/protos.h"
 #include "protos/repeated_field.h"
 #include "protos/repeated_field_iterator.h"
@@ -438,6 +439,28 @@ TEST(CppGeneratedCode, RepeatedFieldProxyForScalars) {
               ElementsAre(27, 16, 5));
 }
 
+TEST(CppGeneratedCode, RepeatedScalarSpan) {
+  ::protos::Arena arena;
+  auto test_model = ::protos::CreateMessage<TestModel>(arena);
+  EXPECT_TRUE(test_model.value_array_span().empty());
+  EXPECT_TRUE(test_model.value_array().span().empty());
+
+  for (int i = 1; i <= 100; i++) test_model.add_value_array(i);
+
+  absl::Span<const int32_t> values = test_model.value_array_span();
+  ASSERT_EQ(values.size(), 100);
+  EXPECT_EQ(values.data(), test_model.value_array().span().data());
+  int64_t sum = 0;
+  for (int32_t v : values) sum += v;
+  EXPECT_EQ(sum, 5050);
+
+  // Writes through the mutable span land directly in the message.
+  absl::Span<int32_t> mutable_values = test_model.mutable_value_array()->span();
+  for (int32_t& v : mutable_values) v *= 2;
+  EXPECT_EQ(test_model.value_array(0), 2);
+  EXPECT_EQ(test_model.value_array(99), 200);
+}
+
 TEST(CppGeneratedCode, RepeatedScalarIterator) {
   ::protos::Arena arena;
   auto test_model = ::protos::CreateMessage<TestModel>(arena);
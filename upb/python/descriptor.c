@@ -216,7 +216,21 @@ PyObject* PyUpb_Descriptor_Get(const upb_MessageDef* m) {
 
 PyObject* PyUpb_Descriptor_GetClass(const upb_MessageDef* m) {
   PyObject* ret = PyUpb_ObjCache_Get(upb_MessageDef_MiniTable(m));
-  return ret;
+  if (ret) return ret;
+
+  // Generated modules build their message classes on first use, so ask the
+  // builder for this one.
+  PyObject* builder =
+      PyImport_ImportModule(PYUPB_PROTOBUF_INTERNAL_PACKAGE ".builder");
+  if (!builder) return NULL;
+  PyObject* py_descriptor = PyUpb_Descriptor_Get(m);
+  PyObject* built = PyObject_CallMethod(builder, "_BuildLazyMessage", "O",
+                                        py_descriptor);
+  Py_DECREF(py_descriptor);
+  Py_DECREF(builder);
+  if (!built) return NULL;
+  Py_DECREF(built);
+  return PyUpb_ObjCache_Get(upb_MessageDef_MiniTable(m));
 }
 
 // The LookupNested*() functions provide name lookup for entities nested inside
@@ -49,7 +49,8 @@ typedef enum {
 } PyUpb_DescriptorType;
 
 // Given a descriptor object |desc|, returns a Python message class object for
-// the msgdef |m|, which must be from the same pool.
+// the msgdef |m|, which must be from the same pool.  The class of a message
+// from a generated module that has not built it yet is built on the spot.
 PyObject* PyUpb_Descriptor_GetClass(const upb_MessageDef* m);
 
 // Returns a Python wrapper object for the given def. This will return an
@@ -36,6 +36,7 @@
 #include "python/message.h"
 #include "python/protobuf.h"
 #include "upb/reflection/def.h"
+#include "upb/util/compare.h"
 #include "upb/util/def_to_proto.h"
 
 // -----------------------------------------------------------------------------
@@ -46,6 +47,7 @@ typedef struct {
   PyObject_HEAD;
   upb_DefPool* symtab;
   PyObject* db;  // The DescriptorDatabase underlying this pool.  May be NULL.
+  PyUpb_ReadLock lock;  // Held by parsers that run without the GIL.
 } PyUpb_DescriptorPool;
 
 PyObject* PyUpb_DescriptorPool_GetDefaultPool(void) {
@@ -81,6 +83,10 @@ upb_DefPool* PyUpb_DescriptorPool_GetSymtab(PyObject* pool) {
   return ((PyUpb_DescriptorPool*)pool)->symtab;
 }
 
+PyUpb_ReadLock* PyUpb_DescriptorPool_GetReadLock(PyObject* pool) {
+  return &((PyUpb_DescriptorPool*)pool)->lock;
+}
+
 static int PyUpb_DescriptorPool_Traverse(PyUpb_DescriptorPool* self,
                                          visitproc visit, void* arg) {
   Py_VISIT(self->db);
@@ -100,6 +106,7 @@ PyObject* PyUpb_DescriptorPool_Get(const upb_DefPool* symtab) {
 
 static void PyUpb_DescriptorPool_Dealloc(PyUpb_DescriptorPool* self) {
   PyUpb_DescriptorPool_Clear(self);
+  PyUpb_ReadLock_Free(&self->lock);
   upb_DefPool_Free(self->symtab);
   PyUpb_ObjCache_Delete(self->symtab);
   PyUpb_Dealloc(self);
@@ -220,7 +227,8 @@ static PyObject* PyUpb_DescriptorPool_DoAddSerializedFile(
       goto done;
     }
     const upb_MessageDef* m = PyUpb_DescriptorPool_GetFileProtoDef();
-    if (upb_Message_IsEqual(proto, existing, m)) {
+    if (upb_Message_IsEqual(proto, existing, upb_MessageDef_MiniTable(m),
+                            kUpb_CompareOption_IncludeUnknownFields)) {
       result = PyUpb_FileDescriptor_Get(file);
       goto done;
     }
@@ -233,6 +241,9 @@ static PyObject* PyUpb_DescriptorPool_DoAddSerializedFile(
   upb_Status status;
   upb_Status_Clear(&status);
 
+  // Adding a file can grow the extension registry, which parsers may be
+  // reading with the GIL released.
+  PyUpb_ReadLock_WaitForReaders(&self->lock);
   const upb_FileDef* filedef =
       upb_DefPool_AddFile(self->symtab, proto, &status);
   if (!filedef) {
@@ -42,6 +42,10 @@ PyObject* PyUpb_DescriptorPool_Get(const upb_DefPool* symtab);
 // Given a Python DescriptorPool, returns the underlying symtab.
 upb_DefPool* PyUpb_DescriptorPool_GetSymtab(PyObject* pool);
 
+// Returns the lock that parsers take to read the pool's extension registry
+// with the GIL released. Files are only added once it has no readers.
+PyUpb_ReadLock* PyUpb_DescriptorPool_GetReadLock(PyObject* pool);
+
 // Returns the default DescriptorPool (a global singleton).
 PyObject* PyUpb_DescriptorPool_GetDefaultPool(void);
 
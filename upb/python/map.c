@@ -136,6 +136,7 @@ void PyUpb_MapContainer_Invalidate(PyObject* obj) {
 
 upb_Map* PyUpb_MapContainer_EnsureReified(PyObject* _self) {
   PyUpb_MapContainer* self = (PyUpb_MapContainer*)_self;
+  PyUpb_Arena_WaitForReaders(self->arena);
   self->version++;
   upb_Map* map = PyUpb_MapContainer_GetIfReified(self);
   if (map) return map;  // Already writable.
@@ -183,8 +184,10 @@ int PyUpb_MapContainer_AssignSubscript(PyObject* _self, PyObject* key,
 
   if (val) {
     if (!PyUpb_PyToUpb(val, val_f, &u_val, arena)) return -1;
+    PyUpb_Arena_WaitForReaders(self->arena);
     if (!PyUpb_MapContainer_Set(self, map, u_key, u_val, arena)) return -1;
   } else {
+    PyUpb_Arena_WaitForReaders(self->arena);
     if (!upb_Map_Delete(map, u_key, NULL)) {
       PyErr_Format(PyExc_KeyError, "Key not present in map");
       return -1;
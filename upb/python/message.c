@@ -32,6 +32,7 @@
 
 #include "python/convert.h"
 #include "python/descriptor.h"
+#include "python/descriptor_pool.h"
 #include "python/extension_dict.h"
 #include "python/map.h"
 #include "python/repeated.h"
@@ -39,6 +40,7 @@
 #include "upb/reflection/def.h"
 #include "upb/reflection/message.h"
 #include "upb/text/encode.h"
+#include "upb/util/compare.h"
 #include "upb/util/required_fields.h"
 
 static const upb_MessageDef* PyUpb_MessageMeta_GetMsgdef(PyObject* cls);
@@ -471,14 +473,15 @@ static bool PyUpb_Message_InitMessageAttribute(PyObject* _self, PyObject* name,
   return ok;
 }
 
-static bool PyUpb_Message_InitScalarAttribute(upb_Message* msg,
+static bool PyUpb_Message_InitScalarAttribute(PyUpb_Message* self,
                                               const upb_FieldDef* f,
-                                              PyObject* value,
-                                              upb_Arena* arena) {
+                                              PyObject* value) {
+  upb_Arena* arena = PyUpb_Arena_Get(self->arena);
   upb_MessageValue msgval;
   assert(!PyErr_Occurred());
   if (!PyUpb_PyToUpb(value, f, &msgval, arena)) return false;
-  upb_Message_SetFieldByDef(msg, f, msgval, arena);
+  PyUpb_Arena_WaitForReaders(self->arena);
+  upb_Message_SetFieldByDef(PyUpb_Message_GetMsg(self), f, msgval, arena);
   return true;
 }
 
@@ -498,8 +501,6 @@ int PyUpb_Message_InitAttributes(PyObject* _self, PyObject* args,
   PyObject* name;
   PyObject* value;
   PyUpb_Message_EnsureReified(self);
-  upb_Message* msg = PyUpb_Message_GetMsg(self);
-  upb_Arena* arena = PyUpb_Arena_Get(self->arena);
 
   while (PyDict_Next(kwargs, &pos, &name, &value)) {
     assert(!PyErr_Occurred());
@@ -520,7 +521,7 @@ int PyUpb_Message_InitAttributes(PyObject* _self, PyObject* args,
     } else if (upb_FieldDef_IsSubMessage(f)) {
       if (!PyUpb_Message_InitMessageAttribute(_self, name, value)) return -1;
     } else {
-      if (!PyUpb_Message_InitScalarAttribute(msg, f, value, arena)) return -1;
+      if (!PyUpb_Message_InitScalarAttribute(self, f, value)) return -1;
     }
     if (PyErr_Occurred()) return -1;
   }
@@ -543,6 +544,7 @@ static PyObject* PyUpb_Message_NewStub(PyObject* parent, const upb_FieldDef* f,
                                        PyObject* arena) {
   const upb_MessageDef* sub_m = upb_FieldDef_MessageSubDef(f);
   PyObject* cls = PyUpb_Descriptor_GetClass(sub_m);
+  if (!cls) return NULL;
 
   PyUpb_Message* msg = (void*)PyType_GenericAlloc((PyTypeObject*)cls, 0);
   msg->def = (uintptr_t)f | 1;
@@ -592,7 +594,9 @@ static bool PyUpb_Message_IsEqual(PyUpb_Message* m1, PyObject* _m2) {
   const bool e2 = PyUpb_Message_IsEmpty(m2_msg, m1_msgdef, symtab);
   if (e1 || e2) return e1 && e2;
 
-  return upb_Message_IsEqual(m1_msg, m2_msg, m1_msgdef);
+  const upb_MiniTable* layout = upb_MessageDef_MiniTable(m1_msgdef);
+  return upb_Message_IsEqual(m1_msg, m2_msg, layout,
+                             kUpb_CompareOption_IncludeUnknownFields);
 }
 
 static const upb_FieldDef* PyUpb_Message_InitAsMsg(PyUpb_Message* m,
@@ -633,6 +637,7 @@ static void PyUpb_Message_SetField(PyUpb_Message* parent, const upb_FieldDef* f,
  *   PyUpb_Message_IsStub(self) is false
  */
 void PyUpb_Message_EnsureReified(PyUpb_Message* self) {
+  PyUpb_Arena_WaitForReaders(self->arena);
   if (!PyUpb_Message_IsStub(self)) return;
   upb_Arena* arena = PyUpb_Arena_Get(self->arena);
 
@@ -831,6 +836,7 @@ PyObject* PyUpb_Message_Get(upb_Message* u_msg, const upb_MessageDef* m,
   if (ret) return ret;
 
   PyObject* cls = PyUpb_Descriptor_GetClass(m);
+  if (!cls) return NULL;
   // It is not safe to use PyObject_{,GC}_New() due to:
   //    https://bugs.python.org/issue35810
   PyUpb_Message* py_msg = (void*)PyType_GenericAlloc((PyTypeObject*)cls, 0);
@@ -885,6 +891,7 @@ PyObject* PyUpb_Message_GetStub(PyUpb_Message* self,
   } else {
     subobj = PyUpb_Message_NewStub(&self->ob_base, field, self->arena);
   }
+  if (!subobj) return NULL;
   PyUpb_WeakMap_Add(self->unset_subobj_map, field, subobj);
 
   assert(!PyErr_Occurred());
@@ -894,6 +901,7 @@ PyObject* PyUpb_Message_GetStub(PyUpb_Message* self,
 PyObject* PyUpb_Message_GetPresentWrapper(PyUpb_Message* self,
                                           const upb_FieldDef* field) {
   assert(!PyUpb_Message_IsStub(self));
+  PyUpb_Arena_WaitForReaders(self->arena);
   upb_MutableMessageValue mutval =
       upb_Message_Mutable(self->ptr.msg, field, PyUpb_Arena_Get(self->arena));
   if (upb_FieldDef_IsMap(field)) {
@@ -966,6 +974,7 @@ int PyUpb_Message_SetFieldValue(PyObject* _self, const upb_FieldDef* field,
     return -1;
   }
 
+  PyUpb_Arena_WaitForReaders(self->arena);
   upb_Message_SetFieldByDef(self->ptr.msg, field, val, arena);
   return 0;
 }
@@ -1208,6 +1217,7 @@ static PyObject* PyUpb_Message_MergeInternal(PyObject* self, PyObject* arg,
   if (!serialized) return NULL;
   PyObject* ret = PyUpb_Message_MergeFromString(self, serialized);
   Py_DECREF(serialized);
+  if (!ret) return NULL;
   Py_DECREF(ret);
   Py_RETURN_NONE;
 }
@@ -1235,6 +1245,7 @@ static PyObject* PyUpb_Message_CopyFrom(PyObject* _self, PyObject* arg) {
   }
   PyUpb_Message* self = (void*)_self;
   PyUpb_Message* other = (void*)arg;
+  if (!PyUpb_Arena_CheckNotExported(self->arena)) return NULL;
   PyUpb_Message_EnsureReified(self);
 
   const upb_Message* other_msg = PyUpb_Message_GetIfReified((PyObject*)other);
@@ -1264,6 +1275,60 @@ static PyObject* PyUpb_Message_UnknownFields(PyObject* _self, PyObject* arg) {
   return NULL;
 }
 
+// Parsing or serializing at least this many bytes is done with the GIL
+// released so that other threads can run meanwhile. For smaller messages the
+// cost of dropping and re-taking the GIL outweighs the work.
+#define PYUPB_NOGIL_THRESHOLD (64 * 1024)
+
+// Parses `buf` into a private message on a private arena with the GIL
+// released, then copies the result into `self`, which must be empty. The copy
+// shares string data with the parsed message, so it is cheap compared to the
+// parse. Returns false if no result was produced, in which case the caller
+// should parse with the GIL held as usual.
+static bool PyUpb_Message_TryDecodeWithoutGil(
+    PyUpb_Message* self, const char* buf, Py_ssize_t size,
+    const upb_MessageDef* msgdef, const upb_ExtensionRegistry* extreg,
+    int options, upb_DecodeStatus* status) {
+  const upb_DefPool* symtab = upb_FileDef_Pool(upb_MessageDef_File(msgdef));
+  if (size < PYUPB_NOGIL_THRESHOLD ||
+      !PyUpb_Message_IsEmpty(self->ptr.msg, msgdef, symtab)) {
+    return false;
+  }
+
+  // The extension registry must not change while we read it without the GIL.
+  PyObject* pool = PyUpb_DescriptorPool_Get(symtab);
+  PyUpb_ReadLock* lock = PyUpb_DescriptorPool_GetReadLock(pool);
+  bool ok = false;
+  if (!PyUpb_ReadLock_TryBeginRead(lock)) goto done;
+
+  const upb_MiniTable* layout = upb_MessageDef_MiniTable(msgdef);
+  upb_Arena* arena = upb_Arena_New();
+  upb_Message* msg = upb_Message_New(layout, arena);
+  if (msg) {
+    Py_BEGIN_ALLOW_THREADS
+    *status = upb_Decode(buf, size, msg, layout, extreg, options, arena);
+    Py_END_ALLOW_THREADS
+  }
+  PyUpb_ReadLock_EndRead(lock);
+
+  // Another thread may have used `self` while we did not hold the GIL. If it
+  // is no longer empty, fall back to merging into it the slow way.
+  PyUpb_Arena_WaitForReaders(self->arena);
+  if (msg && PyUpb_Message_IsEmpty(self->ptr.msg, msgdef, symtab)) {
+    if (*status == kUpb_DecodeStatus_Ok &&
+        !upb_Message_ShareCopy(self->ptr.msg, msg, layout, arena,
+                               PyUpb_Arena_Get(self->arena))) {
+      *status = kUpb_DecodeStatus_OutOfMemory;
+    }
+    ok = true;
+  }
+  upb_Arena_Free(arena);
+
+done:
+  Py_DECREF(pool);
+  return ok;
+}
+
 PyObject* PyUpb_Message_MergeFromString(PyObject* _self, PyObject* arg) {
   PyUpb_Message* self = (void*)_self;
   char* buf;
@@ -1280,6 +1345,10 @@ PyObject* PyUpb_Message_MergeFromString(PyObject* _self, PyObject* arg) {
     return NULL;
   }
 
+  if (!PyUpb_Arena_CheckNotExported(self->arena)) {
+    Py_XDECREF(bytes);
+    return NULL;
+  }
   PyUpb_Message_EnsureReified(self);
   const upb_MessageDef* msgdef = _PyUpb_Message_GetMsgdef(self);
   const upb_FileDef* file = upb_MessageDef_File(msgdef);
@@ -1291,8 +1360,13 @@ PyObject* PyUpb_Message_MergeFromString(PyObject* _self, PyObject* arg) {
   int options = upb_DecodeOptions_MaxDepth(
       state->allow_oversize_protos ? UINT16_MAX
                                    : kUpb_WireFormat_DefaultDepthLimit);
-  upb_DecodeStatus status =
-      upb_Decode(buf, size, self->ptr.msg, layout, extreg, options, arena);
+  upb_DecodeStatus status;
+  if (!PyUpb_Message_TryDecodeWithoutGil(self, buf, size, msgdef, extreg,
+                                         options, &status)) {
+    PyUpb_Arena_WaitForReaders(self->arena);
+    status =
+        upb_Decode(buf, size, self->ptr.msg, layout, extreg, options, arena);
+  }
   Py_XDECREF(bytes);
   if (status != kUpb_DecodeStatus_Ok) {
     PyErr_Format(state->decode_error_class, "Error parsing message");
@@ -1304,6 +1378,7 @@ PyObject* PyUpb_Message_MergeFromString(PyObject* _self, PyObject* arg) {
 
 static PyObject* PyUpb_Message_ParseFromString(PyObject* self, PyObject* arg) {
   PyObject* tmp = PyUpb_Message_Clear((PyUpb_Message*)self);
+  if (!tmp) return NULL;
   Py_DECREF(tmp);
   return PyUpb_Message_MergeFromString(self, arg);
 }
@@ -1322,6 +1397,7 @@ static PyObject* PyUpb_Message_ByteSize(PyObject* self, PyObject* args) {
 }
 
 static PyObject* PyUpb_Message_Clear(PyUpb_Message* self) {
+  if (!PyUpb_Arena_CheckNotExported(self->arena)) return NULL;
   PyUpb_Message_EnsureReified(self);
   const upb_MessageDef* msgdef = _PyUpb_Message_GetMsgdef(self);
   PyUpb_WeakMap* subobj_map = self->unset_subobj_map;
@@ -1355,8 +1431,9 @@ static PyObject* PyUpb_Message_Clear(PyUpb_Message* self) {
   Py_RETURN_NONE;
 }
 
-void PyUpb_Message_DoClearField(PyObject* _self, const upb_FieldDef* f) {
+bool PyUpb_Message_DoClearField(PyObject* _self, const upb_FieldDef* f) {
   PyUpb_Message* self = (void*)_self;
+  if (!PyUpb_Arena_CheckNotExported(self->arena)) return false;
   PyUpb_Message_EnsureReified((PyUpb_Message*)self);
 
   // We must ensure that any stub object is reified so its parent no longer
@@ -1385,6 +1462,7 @@ void PyUpb_Message_DoClearField(PyObject* _self, const upb_FieldDef* f) {
 
   Py_XDECREF(sub);
   upb_Message_ClearFieldByDef(self->ptr.msg, f);
+  return true;
 }
 
 static PyObject* PyUpb_Message_ClearExtension(PyObject* _self, PyObject* arg) {
@@ -1392,7 +1470,7 @@ static PyObject* PyUpb_Message_ClearExtension(PyObject* _self, PyObject* arg) {
   PyUpb_Message_EnsureReified(self);
   const upb_FieldDef* f = PyUpb_Message_GetExtensionDef(_self, arg);
   if (!f) return NULL;
-  PyUpb_Message_DoClearField(_self, f);
+  if (!PyUpb_Message_DoClearField(_self, f)) return NULL;
   Py_RETURN_NONE;
 }
 
@@ -1413,7 +1491,7 @@ static PyObject* PyUpb_Message_ClearField(PyObject* _self, PyObject* arg) {
   }
 
   if (o) f = upb_Message_WhichOneof(self->ptr.msg, o);
-  if (f) PyUpb_Message_DoClearField(_self, f);
+  if (f && !PyUpb_Message_DoClearField(_self, f)) return NULL;
   Py_RETURN_NONE;
 }
 
@@ -1529,6 +1607,29 @@ done:
   Py_DECREF(errors);
 }
 
+// Serializes `self` with the GIL released if it is large enough to be worth
+// it. Mutators of the message tree wait on the arena's read lock until we are
+// done. Returns false if the caller should serialize with the GIL held.
+static bool PyUpb_Message_TryEncodeWithoutGil(PyUpb_Message* self,
+                                              const upb_MiniTable* layout,
+                                              int options, upb_Arena* arena,
+                                              char** buf, size_t* size,
+                                              upb_EncodeStatus* status) {
+  // The size of the tree's arena is a cheap proxy for the encoded size.
+  if (upb_Arena_SpaceAllocated(PyUpb_Arena_Get(self->arena)) <
+      PYUPB_NOGIL_THRESHOLD) {
+    return false;
+  }
+  PyUpb_ReadLock* lock = PyUpb_Arena_GetReadLock(self->arena);
+  if (!PyUpb_ReadLock_TryBeginRead(lock)) return false;
+  upb_Message* msg = self->ptr.msg;
+  Py_BEGIN_ALLOW_THREADS
+  *status = upb_Encode(msg, layout, options, arena, buf, size);
+  Py_END_ALLOW_THREADS
+  PyUpb_ReadLock_EndRead(lock);
+  return true;
+}
+
 PyObject* PyUpb_Message_SerializeInternal(PyObject* _self, PyObject* args,
                                           PyObject* kwargs,
                                           bool check_required) {
@@ -1565,8 +1666,11 @@ PyObject* PyUpb_Message_SerializeInternal(PyObject* _self, PyObject* args,
   if (check_required) options |= kUpb_EncodeOption_CheckRequired;
   if (deterministic) options |= kUpb_EncodeOption_Deterministic;
   char* pb;
-  upb_EncodeStatus status =
-      upb_Encode(self->ptr.msg, layout, options, arena, &pb, &size);
+  upb_EncodeStatus status;
+  if (!PyUpb_Message_TryEncodeWithoutGil(self, layout, options, arena, &pb,
+                                         &size, &status)) {
+    status = upb_Encode(self->ptr.msg, layout, options, arena, &pb, &size);
+  }
   PyObject* ret = NULL;
 
   if (status != kUpb_EncodeStatus_Ok) {
@@ -222,6 +222,8 @@ PyObject* PyUpb_ObjCache_Get(const void* key) {
 typedef struct {
   PyObject_HEAD;
   upb_Arena* arena;
+  PyUpb_ReadLock lock;
+  Py_ssize_t exports;  // Buffers exported by repeated fields in this tree.
 } PyUpb_Arena;
 
 PyObject* PyUpb_Arena_New(void) {
@@ -232,6 +234,7 @@ PyObject* PyUpb_Arena_New(void) {
 }
 
 static void PyUpb_Arena_Dealloc(PyObject* self) {
+  PyUpb_ReadLock_Free(PyUpb_Arena_GetReadLock(self));
   upb_Arena_Free(PyUpb_Arena_Get(self));
   PyUpb_Dealloc(self);
 }
@@ -240,6 +243,76 @@ upb_Arena* PyUpb_Arena_Get(PyObject* arena) {
   return ((PyUpb_Arena*)arena)->arena;
 }
 
+PyUpb_ReadLock* PyUpb_Arena_GetReadLock(PyObject* arena) {
+  return &((PyUpb_Arena*)arena)->lock;
+}
+
+void PyUpb_Arena_WaitForReaders(PyObject* arena) {
+  PyUpb_ReadLock* lock = PyUpb_Arena_GetReadLock(arena);
+  if (lock->readers == 0) return;
+  PyUpb_ReadLock_WaitForReaders(lock);
+}
+
+void PyUpb_Arena_AddExport(PyObject* arena) {
+  ((PyUpb_Arena*)arena)->exports++;
+}
+
+void PyUpb_Arena_RemoveExport(PyObject* arena) {
+  assert(((PyUpb_Arena*)arena)->exports > 0);
+  ((PyUpb_Arena*)arena)->exports--;
+}
+
+bool PyUpb_Arena_CheckNotExported(PyObject* arena) {
+  if (((PyUpb_Arena*)arena)->exports == 0) return true;
+  PyErr_SetString(PyExc_BufferError,
+                  "cannot modify a message while a buffer into one of its "
+                  "repeated fields is exported");
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+// ReadLock
+// -----------------------------------------------------------------------------
+
+// The counters are only touched with the GIL held, so they need no atomics.
+// `idle` is the only thing waited on without the GIL: the first reader takes
+// it and the last reader releases it, so a mutator can sleep until it is free.
+// While a mutator is waiting, new readers are turned away so it cannot starve.
+
+bool PyUpb_ReadLock_TryBeginRead(PyUpb_ReadLock* lock) {
+  if (lock->waiting_writers) return false;
+  if (!lock->idle) {
+    lock->idle = PyThread_allocate_lock();
+    if (!lock->idle) return false;
+  }
+  // Nobody else can hold `idle` while there are no readers, so this never
+  // blocks.
+  if (lock->readers++ == 0) PyThread_acquire_lock(lock->idle, WAIT_LOCK);
+  return true;
+}
+
+void PyUpb_ReadLock_EndRead(PyUpb_ReadLock* lock) {
+  assert(lock->readers > 0);
+  if (--lock->readers == 0) PyThread_release_lock(lock->idle);
+}
+
+void PyUpb_ReadLock_WaitForReaders(PyUpb_ReadLock* lock) {
+  lock->waiting_writers++;
+  while (lock->readers > 0) {
+    Py_BEGIN_ALLOW_THREADS
+    PyThread_acquire_lock(lock->idle, WAIT_LOCK);
+    PyThread_release_lock(lock->idle);
+    Py_END_ALLOW_THREADS
+  }
+  lock->waiting_writers--;
+}
+
+void PyUpb_ReadLock_Free(PyUpb_ReadLock* lock) {
+  assert(lock->readers == 0);
+  if (lock->idle) PyThread_free_lock(lock->idle);
+  lock->idle = NULL;
+}
+
 static PyType_Slot PyUpb_Arena_Slots[] = {
     {Py_tp_dealloc, PyUpb_Arena_Dealloc},
     {0, NULL},
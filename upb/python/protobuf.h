@@ -190,6 +190,56 @@ PyUpb_WeakMap* PyUpb_ObjCache_Instance(void);
 PyObject* PyUpb_Arena_New(void);
 upb_Arena* PyUpb_Arena_Get(PyObject* arena);
 
+// Every message, repeated field and map in a tree shares the tree's arena
+// object, so the arena's read lock guards the whole tree. Code that mutates a
+// tree must call this first; it blocks until any thread that is reading the
+// tree with the GIL released has finished.
+//
+// Any Python code (conversions, __index__, iteration, even an allocation that
+// triggers the GC) may release the GIL and let a new reader start, so the call
+// must come after the last such callback and immediately before the upb
+// mutation it protects.
+void PyUpb_Arena_WaitForReaders(PyObject* arena);
+
+// Repeated scalar fields can export their storage through the buffer protocol.
+// Each exported buffer is counted against the tree's arena for as long as it
+// is held. Operations that can move or detach repeated field storage anywhere
+// in the tree (Clear(), CopyFrom(), MergeFrom() and the like) must call
+// PyUpb_Arena_CheckNotExported() first: it raises BufferError and returns false
+// while any buffer is exported.
+void PyUpb_Arena_AddExport(PyObject* arena);
+void PyUpb_Arena_RemoveExport(PyObject* arena);
+bool PyUpb_Arena_CheckNotExported(PyObject* arena);
+
+// -----------------------------------------------------------------------------
+// ReadLock
+// -----------------------------------------------------------------------------
+
+// Lets threads read an object with the GIL released while keeping mutators,
+// which always hold the GIL, out until they are done. All functions must be
+// called with the GIL held. A zero-initialized PyUpb_ReadLock is unlocked.
+
+typedef struct {
+  PyThread_type_lock idle;  // Held while readers > 0.
+  int readers;
+  int waiting_writers;
+} PyUpb_ReadLock;
+
+// Registers a reader that is about to release the GIL. Returns false if a
+// mutator is waiting (or the lock could not be allocated), in which case the
+// caller must keep holding the GIL for its read.
+bool PyUpb_ReadLock_TryBeginRead(PyUpb_ReadLock* lock);
+
+// Unregisters a reader. Must be called after re-acquiring the GIL.
+void PyUpb_ReadLock_EndRead(PyUpb_ReadLock* lock);
+
+// Blocks, with the GIL released, until there are no registered readers.
+void PyUpb_ReadLock_WaitForReaders(PyUpb_ReadLock* lock);
+
+void PyUpb_ReadLock_Free(PyUpb_ReadLock* lock);
+
+PyUpb_ReadLock* PyUpb_Arena_GetReadLock(PyObject* arena);
+
 // -----------------------------------------------------------------------------
 // Utilities
 // -----------------------------------------------------------------------------
@@ -61,4 +61,12 @@ PyAPI_FUNC(const char*)
     PyUnicode_AsUTF8AndSize(PyObject* unicode, Py_ssize_t* size);
 #endif
 
+// The buffer protocol (Py_buffer, PyObject_GetBuffer() and the Py_bf_* type
+// slots) only joined the limited API in Python 3.11, and unlike
+// PyUnicode_AsUTF8AndSize() it involves a struct layout, so we do not try to
+// use it under older limited API builds.
+#if !defined(Py_LIMITED_API) || Py_LIMITED_API >= 0x030B0000
+#define PYUPB_HAS_BUFFER_PROTOCOL
+#endif
+
 #endif  // PYUPB_PYTHON_H__
@@ -52,6 +52,7 @@ typedef struct {
     PyObject* parent;  // stub: owning pointer to parent message.
     upb_Array* arr;    // reified: the data for this array.
   } ptr;
+  Py_ssize_t exports;  // Number of buffers currently exported (see below).
 } PyUpb_RepeatedContainer;
 
 static bool PyUpb_RepeatedContainer_IsStub(PyUpb_RepeatedContainer* self) {
@@ -91,8 +92,20 @@ void PyUpb_RepeatedContainer_Reify(PyObject* _self, upb_Array* arr) {
   assert(!PyUpb_RepeatedContainer_IsStub(self));
 }
 
+// Operations that resize the array may move its elements to new storage, and
+// reifying a stub replaces the empty storage it exported, so both must fail
+// while a buffer is exported rather than leave the buffer silently detached.
+static bool PyUpb_RepeatedContainer_CheckNotExported(
+    PyUpb_RepeatedContainer* self) {
+  if (self->exports == 0) return true;
+  PyErr_SetString(PyExc_BufferError,
+                  "cannot resize a repeated field while a buffer is exported");
+  return false;
+}
+
 upb_Array* PyUpb_RepeatedContainer_EnsureReified(PyObject* _self) {
   PyUpb_RepeatedContainer* self = (PyUpb_RepeatedContainer*)_self;
+  PyUpb_Arena_WaitForReaders(self->arena);
   upb_Array* arr = PyUpb_RepeatedContainer_GetIfReified(self);
   if (arr) return arr;  // Already writable.
 
@@ -188,18 +201,164 @@ PyObject* PyUpb_RepeatedContainer_DeepCopy(PyObject* _self, PyObject* value) {
   return (PyObject*)clone;
 }
 
+#ifdef PYUPB_HAS_BUFFER_PROTOCOL
+
+// How the elements of a repeated scalar field are stored in its upb_Array.
+typedef struct {
+  char kind;           // NumPy type kind: 'i', 'u', 'f' or 'b' (bool).
+  const char* format;  // Buffer protocol (struct module) format.
+  int size;
+  bool readonly;
+} PyUpb_ScalarLayout;
+
+// Returns false for string and bytes fields, whose elements are
+// upb_StringViews rather than plain values.
+static bool PyUpb_ScalarLayout_Get(const upb_FieldDef* f,
+                                   PyUpb_ScalarLayout* layout) {
+  switch (upb_FieldDef_CType(f)) {
+    case kUpb_CType_Int32:
+      *layout = (PyUpb_ScalarLayout){'i', "i", 4, false};
+      return true;
+    case kUpb_CType_Enum:
+      // Writes could store values that a closed enum does not accept.
+      *layout = (PyUpb_ScalarLayout){'i', "i", 4, true};
+      return true;
+    case kUpb_CType_UInt32:
+      *layout = (PyUpb_ScalarLayout){'u', "I", 4, false};
+      return true;
+    case kUpb_CType_Int64:
+      *layout = (PyUpb_ScalarLayout){'i', "q", 8, false};
+      return true;
+    case kUpb_CType_UInt64:
+      *layout = (PyUpb_ScalarLayout){'u', "Q", 8, false};
+      return true;
+    case kUpb_CType_Float:
+      *layout = (PyUpb_ScalarLayout){'f', "f", 4, false};
+      return true;
+    case kUpb_CType_Double:
+      *layout = (PyUpb_ScalarLayout){'f', "d", 8, false};
+      return true;
+    case kUpb_CType_Bool:
+      // Writes could store bytes other than 0 and 1.
+      *layout = (PyUpb_ScalarLayout){'b', "?", 1, true};
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns true if a buffer with struct-module format |format| holds values of
+// the given NumPy kind in native byte order. The caller checks the item size.
+static bool PyUpb_ScalarLayout_FormatMatches(const PyUpb_ScalarLayout* layout,
+                                             const char* format) {
+  if (!format) format = "B";
+  switch (*format) {
+    case '@':
+    case '=':
+      format++;
+      break;
+    case '<':
+      if (!PY_LITTLE_ENDIAN) return false;
+      format++;
+      break;
+    case '>':
+    case '!':
+      if (PY_LITTLE_ENDIAN) return false;
+      format++;
+      break;
+  }
+  if (format[0] == '\0' || format[1] != '\0') return false;
+  switch (format[0]) {
+    case 'b':
+    case 'h':
+    case 'i':
+    case 'l':
+    case 'q':
+    case 'n':
+      return layout->kind == 'i';
+    case 'B':
+    case 'H':
+    case 'I':
+    case 'L':
+    case 'Q':
+    case 'N':
+      return layout->kind == 'u';
+    case 'f':
+    case 'd':
+      return layout->kind == 'f';
+    case '?':
+      return layout->kind == 'b';
+    default:
+      return false;
+  }
+}
+
+// Appends the contents of |value| with a single memcpy() if it exports a
+// contiguous one-dimensional buffer of the field's element type, eg. a NumPy
+// array of the right dtype.  Returns 1 if the elements were appended, 0 if
+// |value| should be iterated instead, and -1 on error.
+static int PyUpb_RepeatedScalarContainer_ExtendFromBuffer(
+    PyUpb_RepeatedContainer* self, upb_Array* arr, PyObject* value) {
+  const upb_FieldDef* f = PyUpb_RepeatedContainer_GetField(self);
+  PyUpb_ScalarLayout layout;
+  // Enum values must be checked one by one.
+  if (!PyUpb_ScalarLayout_Get(f, &layout) ||
+      upb_FieldDef_CType(f) == kUpb_CType_Enum ||
+      !PyObject_CheckBuffer(value)) {
+    return 0;
+  }
+
+  Py_buffer view;
+  if (PyObject_GetBuffer(value, &view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0) {
+    PyErr_Clear();
+    return 0;
+  }
+
+  int ret = 0;
+  if (view.ndim == 1 && view.itemsize == layout.size &&
+      PyUpb_ScalarLayout_FormatMatches(&layout, view.format)) {
+    size_t start = upb_Array_Size(arr);
+    size_t n = view.len / view.itemsize;
+    PyUpb_Arena_WaitForReaders(self->arena);
+    if (!upb_Array_Resize(arr, start + n, PyUpb_Arena_Get(self->arena))) {
+      PyErr_NoMemory();
+      ret = -1;
+    } else {
+      if (n) {
+        char* data = upb_Array_MutableDataPtr(arr);
+        memcpy(data + start * layout.size, view.buf, view.len);
+      }
+      ret = 1;
+    }
+  }
+  PyBuffer_Release(&view);
+  return ret;
+}
+
+#endif  // PYUPB_HAS_BUFFER_PROTOCOL
+
 PyObject* PyUpb_RepeatedContainer_Extend(PyObject* _self, PyObject* value) {
   PyUpb_RepeatedContainer* self = (PyUpb_RepeatedContainer*)_self;
+  if (!PyUpb_RepeatedContainer_CheckNotExported(self)) return NULL;
   upb_Array* arr = PyUpb_RepeatedContainer_EnsureReified(_self);
   size_t start_size = upb_Array_Size(arr);
+  const upb_FieldDef* f = PyUpb_RepeatedContainer_GetField(self);
+  bool submsg = upb_FieldDef_IsSubMessage(f);
+
+#ifdef PYUPB_HAS_BUFFER_PROTOCOL
+  if (!submsg) {
+    int ok = PyUpb_RepeatedScalarContainer_ExtendFromBuffer(self, arr, value);
+    if (ok < 0) return NULL;
+    if (ok) Py_RETURN_NONE;
+  }
+#endif
+
   PyObject* it = PyObject_GetIter(value);
   if (!it) {
     PyErr_SetString(PyExc_TypeError, "Value must be iterable");
     return NULL;
   }
 
-  const upb_FieldDef* f = PyUpb_RepeatedContainer_GetField(self);
-  bool submsg = upb_FieldDef_IsSubMessage(f);
   PyObject* e;
 
   while ((e = PyIter_Next(it))) {
@@ -216,6 +375,7 @@ PyObject* PyUpb_RepeatedContainer_Extend(PyObject* _self, PyObject* value) {
   Py_DECREF(it);
 
   if (PyErr_Occurred()) {
+    PyUpb_Arena_WaitForReaders(self->arena);
     upb_Array_Resize(arr, start_size, NULL);
     return NULL;
   }
@@ -321,6 +481,7 @@ static int PyUpb_RepeatedContainer_SetSubscript(
     // Set single value.
     upb_MessageValue msgval;
     if (!PyUpb_PyToUpb(value, f, &msgval, arena)) return -1;
+    PyUpb_Arena_WaitForReaders(self->arena);
     upb_Array_Set(arr, idx, msgval);
     return 0;
   }
@@ -334,8 +495,10 @@ static int PyUpb_RepeatedContainer_SetSubscript(
   Py_ssize_t seq_size = PySequence_Size(seq);
   if (seq_size != count) {
     if (step == 1) {
+      if (!PyUpb_RepeatedContainer_CheckNotExported(self)) goto err;
       // We must shift the tail elements (either right or left).
       size_t tail = upb_Array_Size(arr) - (idx + count);
+      PyUpb_Arena_WaitForReaders(self->arena);
       upb_Array_Resize(arr, idx + seq_size + tail, arena);
       upb_Array_Move(arr, idx + seq_size, idx + count, tail);
       count = seq_size;
@@ -355,6 +518,7 @@ static int PyUpb_RepeatedContainer_SetSubscript(
     if (!PyUpb_PyToUpb(item, f, &msgval, arena)) goto err;
     Py_DECREF(item);
     item = NULL;
+    PyUpb_Arena_WaitForReaders(self->arena);
     upb_Array_Set(arr, idx, msgval);
   }
   ret = 0;
@@ -409,6 +573,10 @@ static int PyUpb_RepeatedContainer_AssignSubscript(PyObject* _self,
                                                    PyObject* value) {
   PyUpb_RepeatedContainer* self = (PyUpb_RepeatedContainer*)_self;
   const upb_FieldDef* f = PyUpb_RepeatedContainer_GetField(self);
+  if ((!value || PyUpb_RepeatedContainer_IsStub(self)) &&
+      !PyUpb_RepeatedContainer_CheckNotExported(self)) {
+    return -1;
+  }
   upb_Array* arr = PyUpb_RepeatedContainer_EnsureReified(_self);
   Py_ssize_t size = arr ? upb_Array_Size(arr) : 0;
   Py_ssize_t idx, count, step;
@@ -417,6 +585,7 @@ static int PyUpb_RepeatedContainer_AssignSubscript(PyObject* _self,
     return PyUpb_RepeatedContainer_SetSubscript(self, arr, f, idx, count, step,
                                                 value);
   } else {
+    PyUpb_Arena_WaitForReaders(self->arena);
     return PyUpb_RepeatedContainer_DeleteSubscript(arr, idx, count, step);
   }
 }
@@ -425,18 +594,22 @@ static PyObject* PyUpb_RepeatedContainer_Pop(PyObject* _self, PyObject* args) {
   PyUpb_RepeatedContainer* self = (PyUpb_RepeatedContainer*)_self;
   Py_ssize_t index = -1;
   if (!PyArg_ParseTuple(args, "|n", &index)) return NULL;
+  if (!PyUpb_RepeatedContainer_CheckNotExported(self)) return NULL;
   upb_Array* arr = PyUpb_RepeatedContainer_EnsureReified(_self);
   size_t size = upb_Array_Size(arr);
   if (index < 0) index += size;
   if (index >= size) index = size - 1;
   PyObject* ret = PyUpb_RepeatedContainer_Item(_self, index);
   if (!ret) return NULL;
+  PyUpb_Arena_WaitForReaders(self->arena);
   upb_Array_Delete(self->ptr.arr, index, 1);
   return ret;
 }
 
 static PyObject* PyUpb_RepeatedContainer_Remove(PyObject* _self,
                                                 PyObject* value) {
+  PyUpb_RepeatedContainer* self = (PyUpb_RepeatedContainer*)_self;
+  if (!PyUpb_RepeatedContainer_CheckNotExported(self)) return NULL;
   upb_Array* arr = PyUpb_RepeatedContainer_EnsureReified(_self);
   Py_ssize_t match_index = -1;
   Py_ssize_t n = PyUpb_RepeatedContainer_Length(_self);
@@ -454,6 +627,7 @@ static PyObject* PyUpb_RepeatedContainer_Remove(PyObject* _self,
     PyErr_SetString(PyExc_ValueError, "remove(x): x not in container");
     return NULL;
   }
+  PyUpb_Arena_WaitForReaders(self->arena);
   if (PyUpb_RepeatedContainer_DeleteSubscript(arr, match_index, 1, 1) < 0) {
     return NULL;
   }
@@ -477,6 +651,7 @@ static bool PyUpb_RepeatedContainer_Assign(PyObject* _self, PyObject* list) {
     } else {
       if (!PyUpb_PyToUpb(obj, f, &msgval, arena)) return false;
     }
+    PyUpb_Arena_WaitForReaders(self->arena);
     upb_Array_Set(arr, i, msgval);
   }
   return true;
@@ -561,6 +736,7 @@ PyObject* PyUpb_RepeatedCompositeContainer_Add(PyObject* _self, PyObject* args,
   if (!py_msg) return NULL;
   if (PyUpb_Message_InitAttributes(py_msg, args, kwargs) < 0) {
     Py_DECREF(py_msg);
+    PyUpb_Arena_WaitForReaders(self->arena);
     upb_Array_Delete(self->ptr.arr, upb_Array_Size(self->ptr.arr) - 1, 1);
     return NULL;
   }
@@ -587,6 +763,7 @@ static PyObject* PyUpb_RepeatedContainer_Insert(PyObject* _self,
   Py_ssize_t index;
   PyObject* value;
   if (!PyArg_ParseTuple(args, "nO", &index, &value)) return NULL;
+  if (!PyUpb_RepeatedContainer_CheckNotExported(self)) return NULL;
   upb_Array* arr = PyUpb_RepeatedContainer_EnsureReified(_self);
   if (!arr) return NULL;
 
@@ -614,12 +791,72 @@ static PyObject* PyUpb_RepeatedContainer_Insert(PyObject* _self,
     if (!PyUpb_PyToUpb(value, f, &msgval, arena)) return NULL;
   }
 
+  PyUpb_Arena_WaitForReaders(self->arena);
   upb_Array_Insert(arr, index, 1, arena);
   upb_Array_Set(arr, index, msgval);
 
   Py_RETURN_NONE;
 }
 
+// Builds one list per requested field directly from the upb messages, so
+// that no Python wrapper has to be created for each element.
+static PyObject* PyUpb_RepeatedCompositeContainer_ExtractColumns(
+    PyObject* _self, PyObject* names) {
+  PyUpb_RepeatedContainer* self = (PyUpb_RepeatedContainer*)_self;
+  const upb_MessageDef* m =
+      upb_FieldDef_MessageSubDef(PyUpb_RepeatedContainer_GetField(self));
+  upb_Array* arr = PyUpb_RepeatedContainer_GetIfReified(self);
+  size_t size = arr ? upb_Array_Size(arr) : 0;
+  PyObject* columns = PyDict_New();
+  PyObject* it = PyObject_GetIter(names);
+  PyObject* name = NULL;
+  if (!columns || !it) goto err;
+
+  while ((name = PyIter_Next(it))) {
+    Py_ssize_t len;
+    const char* str = PyUnicode_AsUTF8AndSize(name, &len);
+    if (!str) goto err;
+    const upb_FieldDef* f = upb_MessageDef_FindFieldByNameWithSize(m, str, len);
+    if (!f) {
+      PyErr_Format(PyExc_ValueError, "Protocol message %s has no \"%s\" field.",
+                   upb_MessageDef_Name(m), str);
+      goto err;
+    }
+    if (upb_FieldDef_IsRepeated(f) || upb_FieldDef_IsSubMessage(f)) {
+      PyErr_Format(PyExc_TypeError,
+                   "Cannot extract a column for field \"%s\"; only singular, "
+                   "non-message fields are supported.",
+                   str);
+      goto err;
+    }
+    PyObject* column = PyList_New(size);
+    if (!column) goto err;
+    for (size_t i = 0; i < size; i++) {
+      const upb_Message* msg = upb_Array_Get(arr, i).msg_val;
+      PyObject* val =
+          PyUpb_UpbToPy(upb_Message_GetFieldByDef(msg, f), f, self->arena);
+      if (!val) {
+        Py_DECREF(column);
+        goto err;
+      }
+      PyList_SetItem(column, i, val);  // Steals the reference.
+    }
+    int err = PyDict_SetItem(columns, name, column);
+    Py_DECREF(column);
+    if (err < 0) goto err;
+    Py_DECREF(name);
+  }
+  if (PyErr_Occurred()) goto err;
+  Py_DECREF(it);
+  return columns;
+
+err:
+  Py_XDECREF(name);
+  Py_XDECREF(it);
+  Py_XDECREF(columns);
+  return NULL;
+}
+
 static PyMethodDef PyUpb_RepeatedCompositeContainer_Methods[] = {
     {"__deepcopy__", PyUpb_RepeatedContainer_DeepCopy, METH_VARARGS,
      "Makes a deep copy of the class."},
@@ -631,6 +868,8 @@ static PyMethodDef PyUpb_RepeatedCompositeContainer_Methods[] = {
      "Inserts a message before the specified index."},
     {"extend", PyUpb_RepeatedContainer_Extend, METH_O,
      "Adds objects to the repeated container."},
+    {"extract_columns", PyUpb_RepeatedCompositeContainer_ExtractColumns,
+     METH_O, "Returns a dict mapping field names to lists of values."},
     {"pop", PyUpb_RepeatedContainer_Pop, METH_VARARGS,
      "Removes an object from the repeated container and returns it."},
     {"remove", PyUpb_RepeatedContainer_Remove, METH_O,
@@ -672,6 +911,7 @@ static PyType_Spec PyUpb_RepeatedCompositeContainer_Spec = {
 static PyObject* PyUpb_RepeatedScalarContainer_Append(PyObject* _self,
                                                       PyObject* value) {
   PyUpb_RepeatedContainer* self = (PyUpb_RepeatedContainer*)_self;
+  if (!PyUpb_RepeatedContainer_CheckNotExported(self)) return NULL;
   upb_Array* arr = PyUpb_RepeatedContainer_EnsureReified(_self);
   upb_Arena* arena = PyUpb_Arena_Get(self->arena);
   const upb_FieldDef* f = PyUpb_RepeatedContainer_GetField(self);
@@ -679,6 +919,7 @@ static PyObject* PyUpb_RepeatedScalarContainer_Append(PyObject* _self,
   if (!PyUpb_PyToUpb(value, f, &msgval, arena)) {
     return NULL;
   }
+  PyUpb_Arena_WaitForReaders(self->arena);
   upb_Array_Append(arr, msgval, arena);
   Py_RETURN_NONE;
 }
@@ -699,6 +940,7 @@ static int PyUpb_RepeatedScalarContainer_AssignItem(PyObject* _self,
   if (!PyUpb_PyToUpb(item, f, &msgval, arena)) {
     return -1;
   }
+  PyUpb_Arena_WaitForReaders(self->arena);
   upb_Array_Set(self->ptr.arr, index, msgval);
   return 0;
 }
@@ -716,6 +958,71 @@ static PyObject* PyUpb_RepeatedScalarContainer_Reduce(PyObject* unused_self,
   return NULL;
 }
 
+#ifdef PYUPB_HAS_BUFFER_PROTOCOL
+
+// Repeated scalar fields expose their storage to NumPy and other consumers
+// through the buffer protocol, without a copy.  The storage lives in the
+// message's arena, so an exported buffer stays valid for as long as it holds a
+// reference to the container.  Operations that could move the elements to new
+// storage raise BufferError until every exported buffer has been released:
+// resizing this field, or clearing or merging into any message of its tree.
+
+static void* PyUpb_RepeatedScalarContainer_Data(PyUpb_RepeatedContainer* self,
+                                               Py_ssize_t* size) {
+  // Empty fields export a zero-length view of this rather than NULL.
+  static uint64_t empty;
+  upb_Array* arr = PyUpb_RepeatedContainer_GetIfReified(self);
+  *size = arr ? upb_Array_Size(arr) : 0;
+  return *size ? upb_Array_MutableDataPtr(arr) : &empty;
+}
+
+static int PyUpb_RepeatedScalarContainer_GetBuffer(PyObject* _self,
+                                                   Py_buffer* view, int flags) {
+  PyUpb_RepeatedContainer* self = (PyUpb_RepeatedContainer*)_self;
+  PyUpb_ScalarLayout layout;
+  if (!PyUpb_ScalarLayout_Get(PyUpb_RepeatedContainer_GetField(self),
+                              &layout)) {
+    PyErr_SetString(PyExc_BufferError,
+                    "repeated string and bytes fields cannot export a buffer");
+    view->obj = NULL;
+    return -1;
+  }
+
+  Py_ssize_t size;
+  void* data = PyUpb_RepeatedScalarContainer_Data(self, &size);
+  if (PyBuffer_FillInfo(view, _self, data, size * layout.size, layout.readonly,
+                        flags) < 0) {
+    return -1;
+  }
+  view->itemsize = layout.size;
+  view->format = (flags & PyBUF_FORMAT) ? (char*)layout.format : NULL;
+  if ((flags & PyBUF_ND) == PyBUF_ND) {
+    Py_ssize_t* shape = PyMem_Malloc(sizeof(*shape));
+    if (!shape) {
+      Py_CLEAR(view->obj);
+      PyErr_NoMemory();
+      return -1;
+    }
+    *shape = size;
+    view->shape = shape;
+    view->internal = shape;
+  }
+  self->exports++;
+  PyUpb_Arena_AddExport(self->arena);
+  return 0;
+}
+
+static void PyUpb_RepeatedScalarContainer_ReleaseBuffer(PyObject* _self,
+                                                        Py_buffer* view) {
+  PyUpb_RepeatedContainer* self = (PyUpb_RepeatedContainer*)_self;
+  assert(self->exports > 0);
+  self->exports--;
+  PyUpb_Arena_RemoveExport(self->arena);
+  PyMem_Free(view->internal);
+}
+
+#endif  // PYUPB_HAS_BUFFER_PROTOCOL
+
 static PyMethodDef PyUpb_RepeatedScalarContainer_Methods[] = {
     {"__deepcopy__", PyUpb_RepeatedContainer_DeepCopy, METH_VARARGS,
      "Makes a deep copy of the class."},
@@ -742,6 +1049,10 @@ static PyMethodDef PyUpb_RepeatedScalarContainer_Methods[] = {
 static PyType_Slot PyUpb_RepeatedScalarContainer_Slots[] = {
     {Py_tp_dealloc, PyUpb_RepeatedContainer_Dealloc},
     {Py_tp_methods, PyUpb_RepeatedScalarContainer_Methods},
+#ifdef PYUPB_HAS_BUFFER_PROTOCOL
+    {Py_bf_getbuffer, PyUpb_RepeatedScalarContainer_GetBuffer},
+    {Py_bf_releasebuffer, PyUpb_RepeatedScalarContainer_ReleaseBuffer},
+#endif
     {Py_tp_new, PyUpb_Forbidden_New},
     {Py_tp_repr, PyUpb_RepeatedContainer_Repr},
     {Py_sq_length, PyUpb_RepeatedContainer_Length},
@@ -116,61 +116,223 @@ typedef bool eqlfunc_t(upb_tabkey k1, lookupkey_t k2);
 
 /* Base table (shared code) ***************************************************/
 
-static uint32_t upb_inthash(uintptr_t key) { return (uint32_t)key; }
+/* The hash part is an open-addressing table in the style of Abseil's
+ * SwissTable. Alongside the entries there is one control byte per entry:
+ *
+ *   kUpb_Ctrl_Empty     the entry has never been used since the last rehash
+ *   kUpb_Ctrl_Deleted   the entry held a key that was removed (a tombstone)
+ *   kUpb_Ctrl_Sentinel  padding past the end of a table smaller than a group
+ *   0b0xxxxxxx          the entry is full; xxxxxxx are the low 7 bits (H2) of
+ *                       the key's hash
+ *
+ * Entries are probed a group (16 or 8 control bytes) at a time: the remaining
+ * bits of the hash (H1) pick the first group and later groups are visited in
+ * triangular order. Within a group, the control bytes whose H2 matches are
+ * found with one SIMD comparison, so keys are only compared on a likely hit.
+ * Groups are aligned, which lets a removal tell from its own group whether a
+ * probe could ever have passed through it: if the group still has an empty
+ * entry no probe did, and the entry can become empty instead of a tombstone.
+ */
+
+enum {
+  kUpb_Ctrl_Empty = 0x80,
+  kUpb_Ctrl_Deleted = 0xfe,
+  kUpb_Ctrl_Sentinel = 0xff,
+};
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+static int upb_ctz64(uint64_t v) {
+  UPB_ASSERT(v != 0);
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(v);
+#elif defined(_MSC_VER) && defined(_M_X64)
+  unsigned long idx;
+  _BitScanForward64(&idx, v);
+  return (int)idx;
+#else
+  int ret = 0;
+  while (!(v & 1)) {
+    v >>= 1;
+    ret++;
+  }
+  return ret;
+#endif
+}
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+
+#include <emmintrin.h>
+
+#define UPB_TABLE_GROUP_WIDTH 16
+
+/* One bit per control byte. */
+typedef uint32_t upb_groupmask;
+
+static upb_groupmask upb_group_match(const uint8_t* ctrl, uint8_t h2) {
+  __m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), group));
+}
+
+static upb_groupmask upb_group_matchempty(const uint8_t* ctrl) {
+  return upb_group_match(ctrl, kUpb_Ctrl_Empty);
+}
+
+static upb_groupmask upb_group_matchfree(const uint8_t* ctrl) {
+  // Empty and deleted are the only bytes less than sentinel as signed chars.
+  __m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+  return _mm_movemask_epi8(
+      _mm_cmpgt_epi8(_mm_set1_epi8((char)kUpb_Ctrl_Sentinel), group));
+}
+
+static int upb_groupmask_first(upb_groupmask mask) {
+  return upb_ctz64(mask);
+}
+
+#else
+
+#define UPB_TABLE_GROUP_WIDTH 8
+
+/* The high bit of each byte corresponds to one control byte. */
+typedef uint64_t upb_groupmask;
+
+#define kUpb_Group_Lsbs 0x0101010101010101ULL
+#define kUpb_Group_Msbs 0x8080808080808080ULL
 
-static const upb_tabent* upb_getentry(const upb_table* t, uint32_t hash) {
-  return t->entries + (hash & t->mask);
+static uint64_t upb_group_load(const uint8_t* ctrl) {
+  uint64_t ret = 0;
+  for (int i = 0; i < 8; i++) ret |= (uint64_t)ctrl[i] << (i * 8);
+  return ret;
+}
+
+static upb_groupmask upb_group_match(const uint8_t* ctrl, uint8_t h2) {
+  // May report a false positive for a byte above a real match; callers
+  // compare keys anyway.
+  uint64_t x = upb_group_load(ctrl) ^ (kUpb_Group_Lsbs * h2);
+  return (x - kUpb_Group_Lsbs) & ~x & kUpb_Group_Msbs;
+}
+
+static upb_groupmask upb_group_matchempty(const uint8_t* ctrl) {
+  // High bit set and bit 1 clear: only kUpb_Ctrl_Empty.
+  uint64_t g = upb_group_load(ctrl);
+  return g & ~(g << 6) & kUpb_Group_Msbs;
+}
+
+static upb_groupmask upb_group_matchfree(const uint8_t* ctrl) {
+  // High bit set and bit 0 clear: kUpb_Ctrl_Empty or kUpb_Ctrl_Deleted.
+  uint64_t g = upb_group_load(ctrl);
+  return g & ~(g << 7) & kUpb_Group_Msbs;
+}
+
+static int upb_groupmask_first(upb_groupmask mask) {
+  return upb_ctz64(mask) >> 3;
+}
+
+#endif
+
+static uint8_t upb_h2(uint32_t hash) { return hash & 0x7f; }
+
+static size_t upb_groupcount(const upb_table* t) {
+  size_t size = upb_table_size(t);
+  return size > UPB_TABLE_GROUP_WIDTH ? size / UPB_TABLE_GROUP_WIDTH : 1;
+}
+
+/* Probe sequence over aligned groups. With a power-of-two group count,
+ * triangular steps visit every group exactly once. */
+typedef struct {
+  size_t group;
+  size_t mask;
+  size_t step;
+} upb_probeseq;
+
+static upb_probeseq upb_probeseq_start(const upb_table* t, uint32_t hash) {
+  upb_probeseq seq;
+  seq.mask = t->mask / UPB_TABLE_GROUP_WIDTH;  // Zero for a single group.
+  seq.group = (hash >> 7) & seq.mask;
+  seq.step = 0;
+  return seq;
+}
+
+static void upb_probeseq_next(upb_probeseq* seq) {
+  seq->step++;
+  seq->group = (seq->group + seq->step) & seq->mask;
+}
+
+static const uint8_t* upb_groupctrl(const upb_table* t, size_t group) {
+  return t->ctrl + group * UPB_TABLE_GROUP_WIDTH;
+}
+
+static uint32_t upb_inthash(uintptr_t key) {
+  // Keys are often small integers or aligned pointers, which would cluster
+  // badly if used directly; take the high half of a multiplicative hash.
+  return (uint32_t)(((uint64_t)key * 0x9E3779B97F4A7C15ULL) >> 32);
 }
 
 static bool upb_arrhas(upb_tabval key) { return key.val != (uint64_t)-1; }
 
-static bool isfull(upb_table* t) { return t->count == t->max_count; }
+static bool isfull(upb_table* t) {
+  return t->count + t->deleted >= t->max_count;
+}
+
+/* The size to rehash to once `t` is full: if half or more of the used entries
+ * are tombstones, rehashing in place reclaims enough room. */
+static uint8_t growsize_lg2(const upb_table* t) {
+  return t->size_lg2 && t->deleted >= t->count ? t->size_lg2
+                                               : t->size_lg2 + 1;
+}
+
+static void init_ctrl(upb_table* t) {
+  size_t size = upb_table_size(t);
+  size_t ctrl_size = upb_groupcount(t) * UPB_TABLE_GROUP_WIDTH;
+  memset(t->ctrl, kUpb_Ctrl_Empty, size);
+  memset(t->ctrl + size, kUpb_Ctrl_Sentinel, ctrl_size - size);
+}
 
 static bool init(upb_table* t, uint8_t size_lg2, upb_Arena* a) {
   size_t bytes;
 
   t->count = 0;
+  t->deleted = 0;
   t->size_lg2 = size_lg2;
   t->mask = upb_table_size(t) ? upb_table_size(t) - 1 : 0;
   t->max_count = upb_table_size(t) * MAX_LOAD;
   bytes = upb_table_size(t) * sizeof(upb_tabent);
   if (bytes > 0) {
-    t->entries = upb_Arena_Malloc(a, bytes);
+    size_t ctrl_size = upb_groupcount(t) * UPB_TABLE_GROUP_WIDTH;
+    t->entries = upb_Arena_Malloc(a, bytes + ctrl_size);
     if (!t->entries) return false;
     memset(t->entries, 0, bytes);
+    t->ctrl = (uint8_t*)(t->entries + upb_table_size(t));
+    init_ctrl(t);
   } else {
     t->entries = NULL;
+    t->ctrl = NULL;
   }
   return true;
 }
 
-static upb_tabent* emptyent(upb_table* t, upb_tabent* e) {
-  upb_tabent* begin = t->entries;
-  upb_tabent* end = begin + upb_table_size(t);
-  for (e = e + 1; e < end; e++) {
-    if (upb_tabent_isempty(e)) return e;
-  }
-  for (e = begin; e < end; e++) {
-    if (upb_tabent_isempty(e)) return e;
-  }
-  UPB_ASSERT(false);
-  return NULL;
-}
-
-static upb_tabent* getentry_mutable(upb_table* t, uint32_t hash) {
-  return (upb_tabent*)upb_getentry(t, hash);
-}
-
 static const upb_tabent* findentry(const upb_table* t, lookupkey_t key,
                                    uint32_t hash, eqlfunc_t* eql) {
-  const upb_tabent* e;
+  upb_probeseq seq;
+  uint8_t h2 = upb_h2(hash);
 
   if (t->size_lg2 == 0) return NULL;
-  e = upb_getentry(t, hash);
-  if (upb_tabent_isempty(e)) return NULL;
+  seq = upb_probeseq_start(t, hash);
   while (1) {
-    if (eql(e->key, key)) return e;
-    if ((e = e->next) == NULL) return NULL;
+    const uint8_t* ctrl = upb_groupctrl(t, seq.group);
+    upb_groupmask match = upb_group_match(ctrl, h2);
+    while (match) {
+      const upb_tabent* e =
+          &t->entries[seq.group * UPB_TABLE_GROUP_WIDTH +
+                      upb_groupmask_first(match)];
+      if (eql(e->key, key)) return e;
+      match &= match - 1;
+    }
+    if (upb_group_matchempty(ctrl)) return NULL;
+    upb_probeseq_next(&seq);
   }
 }
 
@@ -192,90 +354,76 @@ static bool lookup(const upb_table* t, lookupkey_t key, upb_value* v,
   }
 }
 
+/* Inserts without checking for duplicates or load; the table must have a free
+ * entry. */
+static void insert_unique(upb_table* t, upb_tabkey tabkey, upb_value val,
+                          uint32_t hash) {
+  upb_probeseq seq = upb_probeseq_start(t, hash);
+  while (1) {
+    upb_groupmask free = upb_group_matchfree(upb_groupctrl(t, seq.group));
+    if (free) {
+      size_t i = seq.group * UPB_TABLE_GROUP_WIDTH + upb_groupmask_first(free);
+      if (t->ctrl[i] == kUpb_Ctrl_Deleted) t->deleted--;
+      t->ctrl[i] = upb_h2(hash);
+      t->entries[i].key = tabkey;
+      t->entries[i].val.val = val.val;
+      t->count++;
+      return;
+    }
+    upb_probeseq_next(&seq);
+  }
+}
+
 /* The given key must not already exist in the table. */
 static void insert(upb_table* t, lookupkey_t key, upb_tabkey tabkey,
-                   upb_value val, uint32_t hash, hashfunc_t* hashfunc,
-                   eqlfunc_t* eql) {
-  upb_tabent* mainpos_e;
-  upb_tabent* our_e;
-
+                   upb_value val, uint32_t hash, eqlfunc_t* eql) {
   UPB_ASSERT(findentry(t, key, hash, eql) == NULL);
+  UPB_ASSERT(!isfull(t));
+  insert_unique(t, tabkey, val, hash);
+  UPB_ASSERT(findentry(t, key, hash, eql)->key == tabkey);
+}
+
+/* Rebuilds `t` with 2^size_lg2 entries, moving the existing keys over without
+ * copying them. */
+static bool rehash(upb_table* t, uint8_t size_lg2, hashfunc_t* hashfunc,
+                   upb_Arena* a) {
+  upb_table new_table;
+  size_t i;
+
+  if (!init(&new_table, size_lg2, a)) return false;
+  for (i = 0; i < upb_table_size(t); i++) {
+    const upb_tabent* e = &t->entries[i];
+    upb_value v;
+    if (upb_tabent_isempty(e)) continue;
+    _upb_value_setval(&v, e->val.val);
+    insert_unique(&new_table, e->key, v, hashfunc(e->key));
+  }
+  UPB_ASSERT(t->count == new_table.count);
+  *t = new_table;
+  return true;
+}
 
-  t->count++;
-  mainpos_e = getentry_mutable(t, hash);
-  our_e = mainpos_e;
-
-  if (upb_tabent_isempty(mainpos_e)) {
-    /* Our main position is empty; use it. */
-    our_e->next = NULL;
+/* Empties the entry at index i, which must be full. */
+static void rm_entry(upb_table* t, size_t i) {
+  const uint8_t* ctrl = upb_groupctrl(t, i / UPB_TABLE_GROUP_WIDTH);
+  t->count--;
+  t->entries[i].key = 0;
+  if (upb_group_matchempty(ctrl)) {
+    t->ctrl[i] = kUpb_Ctrl_Empty;
   } else {
-    /* Collision. */
-    upb_tabent* new_e = emptyent(t, mainpos_e);
-    /* Head of collider's chain. */
-    upb_tabent* chain = getentry_mutable(t, hashfunc(mainpos_e->key));
-    if (chain == mainpos_e) {
-      /* Existing ent is in its main position (it has the same hash as us, and
-       * is the head of our chain).  Insert to new ent and append to this chain.
-       */
-      new_e->next = mainpos_e->next;
-      mainpos_e->next = new_e;
-      our_e = new_e;
-    } else {
-      /* Existing ent is not in its main position (it is a node in some other
-       * chain).  This implies that no existing ent in the table has our hash.
-       * Evict it (updating its chain) and use its ent for head of our chain. */
-      *new_e = *mainpos_e; /* copies next. */
-      while (chain->next != mainpos_e) {
-        chain = (upb_tabent*)chain->next;
-        UPB_ASSERT(chain);
-      }
-      chain->next = new_e;
-      our_e = mainpos_e;
-      our_e->next = NULL;
-    }
+    t->ctrl[i] = kUpb_Ctrl_Deleted;
+    t->deleted++;
   }
-  our_e->key = tabkey;
-  our_e->val.val = val.val;
-  UPB_ASSERT(findentry(t, key, hash, eql) == our_e);
 }
 
 static bool rm(upb_table* t, lookupkey_t key, upb_value* val,
                upb_tabkey* removed, uint32_t hash, eqlfunc_t* eql) {
-  upb_tabent* chain = getentry_mutable(t, hash);
-  if (upb_tabent_isempty(chain)) return false;
-  if (eql(chain->key, key)) {
-    /* Element to remove is at the head of its chain. */
-    t->count--;
-    if (val) _upb_value_setval(val, chain->val.val);
-    if (removed) *removed = chain->key;
-    if (chain->next) {
-      upb_tabent* move = (upb_tabent*)chain->next;
-      *chain = *move;
-      move->key = 0; /* Make the slot empty. */
-    } else {
-      chain->key = 0; /* Make the slot empty. */
-    }
-    return true;
-  } else {
-    /* Element to remove is either in a non-head position or not in the
-     * table. */
-    while (chain->next && !eql(chain->next->key, key)) {
-      chain = (upb_tabent*)chain->next;
-    }
-    if (chain->next) {
-      /* Found element to remove. */
-      upb_tabent* rm = (upb_tabent*)chain->next;
-      t->count--;
-      if (val) _upb_value_setval(val, chain->next->val.val);
-      if (removed) *removed = rm->key;
-      rm->key = 0; /* Make the slot empty. */
-      chain->next = rm->next;
-      return true;
-    } else {
-      /* Element to remove is not in the table. */
-      return false;
-    }
-  }
+  upb_tabent* e = findentry_mutable(t, key, hash, eql);
+  if (!e) return false;
+  if (val) _upb_value_setval(val, e->val.val);
+  if (removed) *removed = e->key;
+  rm_entry(t, e - t->entries);
+  return true;
 }
 
 static size_t next(const upb_table* t, size_t i) {
@@ -470,21 +618,13 @@ bool upb_strtable_init(upb_strtable* t, size_t expected_size, upb_Arena* a) {
 void upb_strtable_clear(upb_strtable* t) {
   size_t bytes = upb_table_size(&t->t) * sizeof(upb_tabent);
   t->t.count = 0;
+  t->t.deleted = 0;
   memset((char*)t->t.entries, 0, bytes);
+  if (t->t.ctrl) init_ctrl(&t->t);
 }
 
 bool upb_strtable_resize(upb_strtable* t, size_t size_lg2, upb_Arena* a) {
-  upb_strtable new_table;
-  if (!init(&new_table.t, size_lg2, a)) return false;
-
-  intptr_t iter = UPB_STRTABLE_BEGIN;
-  upb_StringView key;
-  upb_value val;
-  while (upb_strtable_next2(t, &key, &val, &iter)) {
-    upb_strtable_insert(&new_table, key.data, key.size, val, a);
-  }
-  *t = new_table;
-  return true;
+  return rehash(&t->t, size_lg2, &strhash, a);
 }
 
 bool upb_strtable_insert(upb_strtable* t, const char* k, size_t len,
@@ -494,8 +634,9 @@ bool upb_strtable_insert(upb_strtable* t, const char* k, size_t len,
   uint32_t hash;
 
   if (isfull(&t->t)) {
-    /* Need to resize.  New table of double the size, add old elements to it. */
-    if (!upb_strtable_resize(t, t->t.size_lg2 + 1, a)) {
+    /* Need to resize.  Rehash the existing keys into a larger table (or one of
+     * the same size, if that clears enough tombstones). */
+    if (!upb_strtable_resize(t, growsize_lg2(&t->t), a)) {
       return false;
     }
   }
@@ -505,7 +646,7 @@ bool upb_strtable_insert(upb_strtable* t, const char* k, size_t len,
   if (tabkey == 0) return false;
 
   hash = _upb_Hash_NoSeed(key.str.str, key.str.len);
-  insert(&t->t, key, tabkey, v, hash, &strhash, &streql);
+  insert(&t->t, key, tabkey, v, hash, &streql);
   return true;
 }
 
@@ -650,28 +791,11 @@ bool upb_inttable_insert(upb_inttable* t, uintptr_t key, upb_value val,
   } else {
     if (isfull(&t->t)) {
       /* Need to resize the hash part, but we re-use the array part. */
-      size_t i;
-      upb_table new_table;
-
-      if (!init(&new_table, t->t.size_lg2 + 1, a)) {
+      if (!rehash(&t->t, growsize_lg2(&t->t), &inthash, a)) {
         return false;
       }
-
-      for (i = begin(&t->t); i < upb_table_size(&t->t); i = next(&t->t, i)) {
-        const upb_tabent* e = &t->t.entries[i];
-        uint32_t hash;
-        upb_value v;
-
-        _upb_value_setval(&v, e->val.val);
-        hash = upb_inthash(e->key);
-        insert(&new_table, intkey(e->key), e->key, v, hash, &inthash, &inteql);
-      }
-
-      UPB_ASSERT(t->t.count == new_table.count);
-
-      t->t = new_table;
     }
-    insert(&t->t, intkey(key), key, val, upb_inthash(key), &inthash, &inteql);
+    insert(&t->t, intkey(key), key, val, upb_inthash(key), &inteql);
   }
   check(t);
   return true;
@@ -809,25 +933,7 @@ void upb_inttable_removeiter(upb_inttable* t, intptr_t* iter) {
     t->array_count--;
     mutable_array(t)[i].val = -1;
   } else {
-    upb_tabent* ent = &t->t.entries[i - t->array_size];
-    upb_tabent* prev = NULL;
-
-    // Linear search, not great.
-    upb_tabent* end = &t->t.entries[upb_table_size(&t->t)];
-    for (upb_tabent* e = t->t.entries; e != end; e++) {
-      if (e->next == ent) {
-        prev = e;
-        break;
-      }
-    }
-
-    if (prev) {
-      prev->next = ent->next;
-    }
-
-    t->t.count--;
-    ent->key = 0;
-    ent->next = NULL;
+    rm_entry(&t->t, i - t->array_size);
   }
 }
 
@@ -848,26 +954,7 @@ bool upb_strtable_next2(const upb_strtable* t, upb_StringView* key,
 }
 
 void upb_strtable_removeiter(upb_strtable* t, intptr_t* iter) {
-  intptr_t i = *iter;
-  upb_tabent* ent = &t->t.entries[i];
-  upb_tabent* prev = NULL;
-
-  // Linear search, not great.
-  upb_tabent* end = &t->t.entries[upb_table_size(&t->t)];
-  for (upb_tabent* e = t->t.entries; e != end; e++) {
-    if (e->next == ent) {
-      prev = e;
-      break;
-    }
-  }
-
-  if (prev) {
-    prev->next = ent->next;
-  }
-
-  t->t.count--;
-  ent->key = 0;
-  ent->next = NULL;
+  rm_entry(&t->t, *iter);
 }
 
 void upb_strtable_setentryvalue(upb_strtable* t, intptr_t iter, upb_value v) {
@@ -35,9 +35,9 @@
  * This file defines very fast int->upb_value (inttable) and string->upb_value
  * (strtable) hash tables.
  *
- * The table uses chained scatter with Brent's variation (inspired by the Lua
- * implementation of hash tables).  The hash function for strings is Austin
- * Appleby's "MurmurHash."
+ * The table uses open addressing with one metadata byte per entry that is
+ * probed a group at a time with SIMD (in the style of Abseil's SwissTable).
+ * The hash function for strings is wyhash.
  *
  * The inttable uses uintptr_t as its key, which guarantees it can be used to
  * store pointers or integers of at least 32 bits (upb isn't really useful on
@@ -168,19 +168,15 @@ typedef struct upb_tabval {
 typedef struct _upb_tabent {
   upb_tabkey key;
   upb_tabval val;
-
-  /* Internal chaining.  This is const so we can create static initializers for
-   * tables.  We cast away const sometimes, but *only* when the containing
-   * upb_table is known to be non-const.  This requires a bit of care, but
-   * the subtlety is confined to table.c. */
-  const struct _upb_tabent* next;
 } upb_tabent;
 
 typedef struct {
   size_t count;       /* Number of entries in the hash part. */
   uint32_t mask;      /* Mask to turn hash value -> bucket. */
-  uint32_t max_count; /* Max count before we hit our load limit. */
+  uint32_t max_count; /* Max count + deleted before we hit our load limit. */
+  uint32_t deleted;   /* Number of tombstones in the hash part. */
   uint8_t size_lg2;   /* Size of the hashtable part is 2^size_lg2 entries. */
+  uint8_t* ctrl;      /* Per-entry metadata bytes, see common.c. */
   upb_tabent* entries;
 } upb_table;
 
@@ -252,6 +252,73 @@ TEST(Table, Delete) {
   }
 }
 
+// Repeated inserts and removals leave tombstones behind; make sure lookups
+// stay correct and the table reclaims them instead of growing forever.
+TEST(Table, StringTableChurn) {
+  upb::Arena arena;
+  upb_strtable t;
+  upb_strtable_init(&t, 0, arena.ptr());
+  absl::flat_hash_map<std::string, uint64_t> m;
+  for (int i = 0; i < 20000; i++) {
+    std::string key = std::to_string(i);
+    ASSERT_TRUE(upb_strtable_insert(&t, key.data(), key.size(),
+                                    upb_value_uint64(i), arena.ptr()));
+    m[key] = i;
+    if (i >= 100) {
+      std::string old = std::to_string(i - 100);
+      upb_value val;
+      ASSERT_TRUE(upb_strtable_remove2(&t, old.data(), old.size(), &val));
+      EXPECT_EQ(val.val, i - 100);
+      m.erase(old);
+    }
+  }
+  EXPECT_EQ(upb_strtable_count(&t), m.size());
+  EXPECT_LE(t.t.size_lg2, 8);
+  for (int i = 0; i < 20000; i++) {
+    std::string key = std::to_string(i);
+    upb_value val;
+    bool found = upb_strtable_lookup2(&t, key.data(), key.size(), &val);
+    ASSERT_EQ(found, m.contains(key)) << key;
+    if (found) EXPECT_EQ(val.val, i);
+  }
+
+  // Remove everything through the iterator.
+  intptr_t iter = UPB_STRTABLE_BEGIN;
+  upb_StringView key;
+  upb_value val;
+  while (upb_strtable_next2(&t, &key, &val, &iter)) {
+    EXPECT_EQ(m.erase(std::string(key.data, key.size)), 1);
+    upb_strtable_removeiter(&t, &iter);
+  }
+  EXPECT_TRUE(m.empty());
+  EXPECT_EQ(upb_strtable_count(&t), 0);
+  EXPECT_FALSE(upb_strtable_lookup(&t, "19999", nullptr));
+}
+
+TEST(Table, IntTableChurn) {
+  upb::Arena arena;
+  upb_inttable t;
+  upb_inttable_init(&t, arena.ptr());
+  absl::flat_hash_map<uintptr_t, uint64_t> m;
+  for (uintptr_t i = 0; i < 20000; i++) {
+    // Pointer-like keys: large and aligned.
+    uintptr_t key = (i + 1) * 64;
+    ASSERT_TRUE(upb_inttable_insert(&t, key, upb_value_uint64(i), arena.ptr()));
+    m[key] = i;
+    if (i % 3 == 0) {
+      uintptr_t old = (i / 2 + 1) * 64;
+      if (m.erase(old)) EXPECT_TRUE(upb_inttable_remove(&t, old, nullptr));
+    }
+  }
+  EXPECT_EQ(upb_inttable_count(&t), m.size());
+  for (const auto& [key, value] : m) {
+    upb_value val;
+    ASSERT_TRUE(upb_inttable_lookup(&t, key, &val)) << key;
+    EXPECT_EQ(val.val, value);
+  }
+  EXPECT_FALSE(upb_inttable_lookup(&t, 64 * 100000, nullptr));
+}
+
 TEST(Table, Init) {
   for (int i = 0; i < 2048; i++) {
     /* Tests that the size calculations in init() (lg2 size for target load)
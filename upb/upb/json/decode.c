@@ -410,6 +410,37 @@ static void jsondec_resize(jsondec* d, char** buf, char** end, char** buf_end) {
   *buf_end = *buf + size;
 }
 
+// Returns a pointer to the first byte in [ptr, end) that ends a plain run of
+// JSON string data (a quote, a backslash or a control character), or `end`.
+// Scans a word at a time, since most strings contain no escapes.
+static const char* jsondec_skipplain(const char* ptr, const char* end) {
+  const uint64_t ones = 0x0101010101010101ULL;
+  const uint64_t highs = 0x8080808080808080ULL;
+
+  while (end - ptr >= 8) {
+    uint64_t w;
+    memcpy(&w, ptr, 8);
+    // `(x - ones * n) & ~x & highs` is nonzero iff some byte of `x` is less
+    // than `n` (for n <= 0x80); with n == 1 that finds zero bytes, which the
+    // XORs turn into matches for '"' and '\\'.
+    uint64_t quote = w ^ (ones * '"');
+    uint64_t backslash = w ^ (ones * '\\');
+    uint64_t special = ((quote - ones) & ~quote) |
+                       ((backslash - ones) & ~backslash) |
+                       ((w - ones * 0x20) & ~w);
+    if (special & highs) break;
+    ptr += 8;
+  }
+
+  while (ptr < end) {
+    uint8_t ch = *ptr;
+    if (ch == '"' || ch == '\\' || ch < 0x20) break;
+    ptr++;
+  }
+
+  return ptr;
+}
+
 static upb_StringView jsondec_string(jsondec* d) {
   char* buf = NULL;
   char* end = NULL;
@@ -422,11 +453,19 @@ static upb_StringView jsondec_string(jsondec* d) {
   }
 
   while (d->ptr < d->end) {
-    char ch = *d->ptr++;
+    const char* plain = jsondec_skipplain(d->ptr, d->end);
+    size_t n = plain - d->ptr;
 
-    if (end == buf_end) {
+    // Always leaves room for at least one more byte.
+    while (end == buf_end || (size_t)(buf_end - end) <= n) {
       jsondec_resize(d, &buf, &end, &buf_end);
     }
+    if (n) memcpy(end, d->ptr, n);
+    end += n;
+    d->ptr = plain;
+    if (d->ptr == d->end) break;
+
+    char ch = *d->ptr++;
 
     switch (ch) {
       case '"': {
@@ -450,11 +489,7 @@ static upb_StringView jsondec_string(jsondec* d) {
         }
         break;
       default:
-        if ((unsigned char)*d->ptr < 0x20) {
-          jsondec_err(d, "Invalid char in JSON string");
-        }
-        *end++ = ch;
-        break;
+        jsondec_err(d, "Invalid char in JSON string");
     }
   }
 
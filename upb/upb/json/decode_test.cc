@@ -92,3 +92,23 @@ TEST(JsonTest, DecodeFloats) {
     EXPECT_EQ(box, nullptr);
   }
 }
+
+// Decode strings that mix long plain runs with escapes.
+TEST(JsonTest, DecodeStrings) {
+  upb::Arena a;
+
+  upb_test_Box* box = JsonDecode(
+      R"({"name": "a plain run longer than a word \"quoted\" back\\slash\n)"
+      R"(é tail"})",
+      a.ptr());
+  ASSERT_NE(box, nullptr);
+  upb_StringView name = upb_test_Box_name(box);
+  EXPECT_EQ(
+      "a plain run longer than a word \"quoted\" back\\slash\n\xc3\xa9 tail",
+      std::string(name.data, name.size));
+
+  // Raw control characters are not allowed anywhere in a string.
+  EXPECT_EQ(JsonDecode("{\"name\": \"\x01\"}", a.ptr()), nullptr);
+  EXPECT_EQ(JsonDecode("{\"name\": \"abc\\n\x1f\"}", a.ptr()), nullptr);
+  EXPECT_EQ(JsonDecode("{\"name\": \"abcdefghijkl\x0a\"}", a.ptr()), nullptr);
+}
@@ -126,6 +126,19 @@ static void jsonenc_printf(jsonenc* e, const char* fmt, ...) {
   }
 }
 
+/* Writes `val` as exactly `width` zero-padded decimal digits. */
+static void jsonenc_putdigits(jsonenc* e, uint32_t val, int width) {
+  char buf[10];
+  int i;
+
+  UPB_ASSERT(width <= (int)sizeof(buf));
+  for (i = width - 1; i >= 0; i--) {
+    buf[i] = '0' + (val % 10);
+    val /= 10;
+  }
+  jsonenc_putbytes(e, buf, width);
+}
+
 static void jsonenc_nanos(jsonenc* e, int32_t nanos) {
   int digits = 9;
 
@@ -139,7 +152,8 @@ static void jsonenc_nanos(jsonenc* e, int32_t nanos) {
     digits -= 3;
   }
 
-  jsonenc_printf(e, ".%.*" PRId32, digits, nanos);
+  jsonenc_putbytes(e, ".", 1);
+  jsonenc_putdigits(e, nanos, digits);
 }
 
 static void jsonenc_timestamp(jsonenc* e, const upb_Message* msg,
@@ -180,7 +194,18 @@ static void jsonenc_timestamp(jsonenc* e, const upb_Message* msg,
   min = (seconds / 60) % 60;
   hour = (seconds / 3600) % 24;
 
-  jsonenc_printf(e, "\"%04d-%02d-%02dT%02d:%02d:%02d", I, J, K, hour, min, sec);
+  jsonenc_putbytes(e, "\"", 1);
+  jsonenc_putdigits(e, I, 4);
+  jsonenc_putbytes(e, "-", 1);
+  jsonenc_putdigits(e, J, 2);
+  jsonenc_putbytes(e, "-", 1);
+  jsonenc_putdigits(e, K, 2);
+  jsonenc_putbytes(e, "T", 1);
+  jsonenc_putdigits(e, hour, 2);
+  jsonenc_putbytes(e, ":", 1);
+  jsonenc_putdigits(e, min, 2);
+  jsonenc_putbytes(e, ":", 1);
+  jsonenc_putdigits(e, sec, 2);
   jsonenc_nanos(e, nanos);
   jsonenc_putstr(e, "Z\"");
 }
@@ -274,11 +299,47 @@ static void jsonenc_bytes(jsonenc* e, upb_StringView str) {
   jsonenc_putstr(e, "\"");
 }
 
+// Returns a pointer to the first byte in [ptr, end) that must be escaped in a
+// JSON string (a quote, a backslash or a control character), or `end`.
+// Scans a word at a time, since most strings need no escaping at all.
+static const char* jsonenc_skipplain(const char* ptr, const char* end) {
+  const uint64_t ones = 0x0101010101010101ULL;
+  const uint64_t highs = 0x8080808080808080ULL;
+
+  while (end - ptr >= 8) {
+    uint64_t w;
+    memcpy(&w, ptr, 8);
+    // `(x - ones * n) & ~x & highs` is nonzero iff some byte of `x` is less
+    // than `n` (for n <= 0x80); with n == 1 that finds zero bytes, which the
+    // XORs turn into matches for '"' and '\\'.
+    uint64_t quote = w ^ (ones * '"');
+    uint64_t backslash = w ^ (ones * '\\');
+    uint64_t special = ((quote - ones) & ~quote) |
+                       ((backslash - ones) & ~backslash) |
+                       ((w - ones * 0x20) & ~w);
+    if (special & highs) break;
+    ptr += 8;
+  }
+
+  while (ptr < end) {
+    uint8_t ch = *ptr;
+    if (ch == '"' || ch == '\\' || ch < 0x20) break;
+    ptr++;
+  }
+
+  return ptr;
+}
+
 static void jsonenc_stringbody(jsonenc* e, upb_StringView str) {
   const char* ptr = str.data;
   const char* end = UPB_PTRADD(ptr, str.size);
 
   while (ptr < end) {
+    const char* plain = jsonenc_skipplain(ptr, end);
+    if (plain != ptr) jsonenc_putbytes(e, ptr, plain - ptr);
+    ptr = plain;
+    if (ptr == end) break;
+
     switch (*ptr) {
       case '\n':
         jsonenc_putstr(e, "\\n");
@@ -302,13 +363,7 @@ static void jsonenc_stringbody(jsonenc* e, upb_StringView str) {
         jsonenc_putstr(e, "\\\\");
         break;
       default:
-        if ((uint8_t)*ptr < 0x20) {
-          jsonenc_printf(e, "\\u%04x", (int)(uint8_t)*ptr);
-        } else {
-          /* This could be a non-ASCII byte.  We rely on the string being valid
-           * UTF-8. */
-          jsonenc_putbytes(e, ptr, 1);
-        }
+        jsonenc_printf(e, "\\u%04x", (int)(uint8_t)*ptr);
         break;
     }
     ptr++;
@@ -724,7 +779,9 @@ static void jsonenc_fieldval(jsonenc* e, const upb_FieldDef* f,
     } else {
       name = upb_FieldDef_JsonName(f);
     }
-    jsonenc_printf(e, "\"%s\":", name);
+    jsonenc_putstr(e, "\"");
+    jsonenc_stringbody(e, upb_StringView_FromString(name));
+    jsonenc_putstr(e, "\":");
   }
 
   if (upb_FieldDef_IsMap(f)) {
@@ -103,3 +103,18 @@ TEST(JsonTest, EncodeNullEnum) {
   EXPECT_EQ(R"({"val":null})",
             JsonEncode(foo, upb_JsonEncode_FormatEnumsAsIntegers));
 }
+
+// Encode strings that mix long plain runs with characters that need escaping.
+TEST(JsonTest, EncodeStringEscapes) {
+  upb::Arena a;
+
+  upb_test_Box* foo = upb_test_Box_new(a.ptr());
+  const char name[] = "a plain run longer than a word \"quoted\" back\\slash\n"
+                      "\x01\x1f tail \xc3\xa9";
+  upb_test_Box_set_name(foo, upb_StringView_FromString(name));
+
+  EXPECT_EQ(R"({"name":"a plain run longer than a word \"quoted\" back\\slash)"
+            R"(\n\u0001\u001f tail )"
+            "\xc3\xa9\"}",
+            JsonEncode(foo, 0));
+}
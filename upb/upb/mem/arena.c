@@ -30,6 +30,8 @@
 
 #include "upb/mem/internal/arena.h"
 
+#include <string.h>
+
 #include "upb/port/atomic.h"
 
 // Must be last.
@@ -45,6 +47,44 @@ struct _upb_MemBlock {
 static const size_t memblock_reserve =
     UPB_ALIGN_UP(sizeof(_upb_MemBlock), UPB_MALLOC_ALIGN);
 
+#define kUpb_Arena_DefaultInitialBlockSize 256
+#define kUpb_Arena_DefaultGrowthFactor 2
+
+static upb_ArenaOptions _upb_Arena_DefaultOptions = {
+    kUpb_Arena_DefaultInitialBlockSize,
+    0,
+    kUpb_Arena_DefaultGrowthFactor,
+};
+
+// Fills in the zero fields of |options| (which may be NULL) from the
+// process-wide defaults.
+static upb_ArenaOptions _upb_Arena_ResolveOptions(
+    const upb_ArenaOptions* options) {
+  upb_ArenaOptions ret = _upb_Arena_DefaultOptions;
+  if (options) {
+    if (options->initial_block_size) {
+      ret.initial_block_size = options->initial_block_size;
+    }
+    if (options->max_block_size) ret.max_block_size = options->max_block_size;
+    if (options->growth_factor) ret.growth_factor = options->growth_factor;
+  }
+  return ret;
+}
+
+void upb_Arena_SetDefaultOptions(const upb_ArenaOptions* options) {
+  _upb_Arena_DefaultOptions.initial_block_size =
+      options->initial_block_size ? options->initial_block_size
+                                  : kUpb_Arena_DefaultInitialBlockSize;
+  _upb_Arena_DefaultOptions.max_block_size = options->max_block_size;
+  _upb_Arena_DefaultOptions.growth_factor =
+      options->growth_factor ? options->growth_factor
+                             : kUpb_Arena_DefaultGrowthFactor;
+}
+
+void upb_Arena_GetDefaultOptions(upb_ArenaOptions* options) {
+  *options = _upb_Arena_DefaultOptions;
+}
+
 typedef struct _upb_ArenaRoot {
   upb_Arena* root;
   uintptr_t tagged_count;
@@ -87,21 +127,27 @@ static _upb_ArenaRoot _upb_Arena_FindRoot(upb_Arena* a) {
   return (_upb_ArenaRoot){.root = a, .tagged_count = poc};
 }
 
-size_t upb_Arena_SpaceAllocated(upb_Arena* arena) {
+void upb_Arena_GetStats(upb_Arena* arena, upb_ArenaStats* stats) {
   arena = _upb_Arena_FindRoot(arena).root;
-  size_t memsize = 0;
+  memset(stats, 0, sizeof(*stats));
 
   while (arena != NULL) {
     _upb_MemBlock* block =
         upb_Atomic_Load(&arena->blocks, memory_order_relaxed);
     while (block != NULL) {
-      memsize += sizeof(_upb_MemBlock) + block->size;
+      stats->space_allocated += sizeof(_upb_MemBlock) + block->size;
+      stats->block_count++;
+      stats->largest_block = UPB_MAX(stats->largest_block, block->size);
       block = upb_Atomic_Load(&block->next, memory_order_relaxed);
     }
     arena = upb_Atomic_Load(&arena->next, memory_order_relaxed);
   }
+}
 
-  return memsize;
+size_t upb_Arena_SpaceAllocated(upb_Arena* arena) {
+  upb_ArenaStats stats;
+  upb_Arena_GetStats(arena, &stats);
+  return stats.space_allocated;
 }
 
 uint32_t upb_Arena_DebugRefCount(upb_Arena* a) {
@@ -130,10 +176,13 @@ static void upb_Arena_AddBlock(upb_Arena* a, void* ptr, size_t size) {
 }
 
 static bool upb_Arena_AllocBlock(upb_Arena* a, size_t size) {
-  if (!a->block_alloc) return false;
+  if (!upb_Arena_BlockAlloc(a)) return false;
   _upb_MemBlock* last_block = upb_Atomic_Load(&a->blocks, memory_order_acquire);
   size_t last_size = last_block != NULL ? last_block->size : 128;
-  size_t block_size = UPB_MAX(size, last_size * 2) + memblock_reserve;
+  uint64_t next_size = (uint64_t)last_size * a->growth_factor;
+  size_t block_size =
+      UPB_MAX(size, (size_t)UPB_MIN(next_size, a->max_block_size)) +
+      memblock_reserve;
   _upb_MemBlock* block = upb_malloc(upb_Arena_BlockAlloc(a), block_size);
 
   if (!block) return false;
@@ -142,20 +191,33 @@ static bool upb_Arena_AllocBlock(upb_Arena* a, size_t size) {
 }
 
 void* _upb_Arena_SlowMalloc(upb_Arena* a, size_t size) {
-  if (!upb_Arena_AllocBlock(a, size)) return NULL; /* Out of memory. */
-  UPB_ASSERT(_upb_ArenaHas(a) >= size);
+  // Leave room for the guard upb_Arena_Malloc() checks for, otherwise a
+  // block capped at exactly |size| would send us straight back here.
+  size_t span = size + UPB_ASAN_GUARD_SIZE;
+  if (!upb_Arena_AllocBlock(a, span)) return NULL; /* Out of memory. */
+  UPB_ASSERT(_upb_ArenaHas(a) >= span);
   return upb_Arena_Malloc(a, size);
 }
 
 /* Public Arena API ***********************************************************/
 
-static upb_Arena* upb_Arena_InitSlow(upb_alloc* alloc) {
+static void upb_Arena_SetGrowthPolicy(upb_Arena* a,
+                                      const upb_ArenaOptions* options) {
+  a->max_block_size = options->max_block_size
+                          ? (uint32_t)UPB_MIN(options->max_block_size,
+                                              UINT32_MAX - memblock_reserve)
+                          : UINT32_MAX - memblock_reserve;
+  a->growth_factor = options->growth_factor;
+}
+
+static upb_Arena* upb_Arena_InitSlow(upb_alloc* alloc,
+                                     const upb_ArenaOptions* options) {
   const size_t first_block_overhead = sizeof(upb_Arena) + memblock_reserve;
   upb_Arena* a;
 
   /* We need to malloc the initial block. */
   char* mem;
-  size_t n = first_block_overhead + 256;
+  size_t n = first_block_overhead + options->initial_block_size;
   if (!alloc || !(mem = upb_malloc(alloc, n))) {
     return NULL;
   }
@@ -168,6 +230,7 @@ static upb_Arena* upb_Arena_InitSlow(upb_alloc* alloc) {
   upb_Atomic_Init(&a->next, NULL);
   upb_Atomic_Init(&a->tail, a);
   upb_Atomic_Init(&a->blocks, NULL);
+  upb_Arena_SetGrowthPolicy(a, options);
 
   upb_Arena_AddBlock(a, mem, n);
 
@@ -175,6 +238,12 @@ static upb_Arena* upb_Arena_InitSlow(upb_alloc* alloc) {
 }
 
 upb_Arena* upb_Arena_Init(void* mem, size_t n, upb_alloc* alloc) {
+  return upb_Arena_InitWithOptions(mem, n, alloc, NULL);
+}
+
+upb_Arena* upb_Arena_InitWithOptions(void* mem, size_t n, upb_alloc* alloc,
+                                     const upb_ArenaOptions* options) {
+  upb_ArenaOptions resolved = _upb_Arena_ResolveOptions(options);
   upb_Arena* a;
 
   if (n) {
@@ -190,7 +259,7 @@ upb_Arena* upb_Arena_Init(void* mem, size_t n, upb_alloc* alloc) {
   n = UPB_ALIGN_DOWN(n, UPB_ALIGN_OF(upb_Arena));
 
   if (UPB_UNLIKELY(n < sizeof(upb_Arena))) {
-    return upb_Arena_InitSlow(alloc);
+    return upb_Arena_InitSlow(alloc, &resolved);
   }
 
   a = UPB_PTR_AT(mem, n - sizeof(*a), upb_Arena);
@@ -200,6 +269,7 @@ upb_Arena* upb_Arena_Init(void* mem, size_t n, upb_alloc* alloc) {
   upb_Atomic_Init(&a->tail, a);
   upb_Atomic_Init(&a->blocks, NULL);
   a->block_alloc = upb_Arena_MakeBlockAlloc(alloc, 1);
+  upb_Arena_SetGrowthPolicy(a, &resolved);
   a->head.ptr = mem;
   a->head.end = UPB_PTR_AT(mem, n - sizeof(*a), char);
 
@@ -255,29 +325,55 @@ retry:
   goto retry;
 }
 
+bool upb_Arena_IncRefFor(upb_Arena* a, const void* owner) {
+  UPB_UNUSED(owner);
+  if (upb_Arena_HasInitialBlock(a)) return false;
+
+  _upb_ArenaRoot r;
+retry:
+  r = _upb_Arena_FindRoot(a);
+  if (upb_Atomic_CompareExchangeWeak(
+          &r.root->parent_or_count, &r.tagged_count,
+          _upb_Arena_TaggedFromRefcount(
+              _upb_Arena_RefCountFromTagged(r.tagged_count) + 1),
+          memory_order_release, memory_order_acquire)) {
+    return true;
+  }
+
+  // Either the count changed or the root was fused away; look again.
+  goto retry;
+}
+
+void upb_Arena_DecRefFor(upb_Arena* a, const void* owner) {
+  UPB_UNUSED(owner);
+  upb_Arena_Free(a);
+}
+
 static void _upb_Arena_DoFuseArenaLists(upb_Arena* const parent,
                                         upb_Arena* child) {
-  upb_Arena* parent_tail = upb_Atomic_Load(&parent->tail, memory_order_relaxed);
+  // The list links are how other threads reach arenas they did not create, so
+  // they are published with release and read with acquire ordering.
+  upb_Arena* parent_tail = upb_Atomic_Load(&parent->tail, memory_order_acquire);
   do {
     // Our tail might be stale, but it will always converge to the true tail.
     upb_Arena* parent_tail_next =
-        upb_Atomic_Load(&parent_tail->next, memory_order_relaxed);
+        upb_Atomic_Load(&parent_tail->next, memory_order_acquire);
     while (parent_tail_next != NULL) {
       parent_tail = parent_tail_next;
       parent_tail_next =
-          upb_Atomic_Load(&parent_tail->next, memory_order_relaxed);
+          upb_Atomic_Load(&parent_tail->next, memory_order_acquire);
     }
 
     upb_Arena* displaced =
-        upb_Atomic_Exchange(&parent_tail->next, child, memory_order_relaxed);
-    parent_tail = upb_Atomic_Load(&child->tail, memory_order_relaxed);
+        upb_Atomic_Exchange(&parent_tail->next, child, memory_order_acq_rel);
+    parent_tail = upb_Atomic_Load(&child->tail, memory_order_acquire);
 
     // If we displaced something that got installed racily, we can simply
     // reinstall it on our new tail.
     child = displaced;
   } while (child != NULL);
 
-  upb_Atomic_Store(&parent->tail, parent_tail, memory_order_relaxed);
+  upb_Atomic_Store(&parent->tail, parent_tail, memory_order_release);
 }
 
 static upb_Arena* _upb_Arena_DoFuse(upb_Arena* a1, upb_Arena* a2,
@@ -306,32 +402,49 @@ static upb_Arena* _upb_Arena_DoFuse(upb_Arena* a1, upb_Arena* a2,
   // increments to that refcount and their frees!).  We need to add `r2`'s refs
   // now, so that `r1` can withstand any unrefs that come from r2.
   //
-  // Note that while it is possible for `r2`'s refcount to increase
-  // asynchronously, we will not actually do the reparenting operation below
-  // unless `r2`'s refcount is unchanged from when we read it.
+  // Under contention either CAS below can fail merely because another thread
+  // changed a refcount while the arena stayed a root.  Re-walking both trees
+  // for that is wasteful, so we only start over when `r1` or `r2` stops being
+  // a root; otherwise we retry in place with the freshly loaded value.
   //
-  // Note that we may have done this previously, either to this node or a
-  // different node, during a previous and failed DoFuse() attempt. But we will
-  // not lose track of these refs because we always add them to our overall
-  // delta.
+  // `added` is how many of `r2`'s refs (untagged, so still shifted left by one)
+  // we have moved to `r1` so far.  It can exceed `r2`'s final count if `r2` was
+  // unreffed concurrently; any excess, and any refs added during a failed
+  // attempt, go into the overall `ref_delta` and are removed from the final
+  // root in a single fixup.
+  uintptr_t added = 0;
   uintptr_t r2_untagged_count = r2.tagged_count & ~1;
-  uintptr_t with_r2_refs = r1.tagged_count + r2_untagged_count;
-  if (!upb_Atomic_CompareExchangeStrong(
-          &r1.root->parent_or_count, &r1.tagged_count, with_r2_refs,
-          memory_order_release, memory_order_acquire)) {
-    return NULL;
-  }
+  while (true) {
+    while (added < r2_untagged_count) {
+      uintptr_t with_r2_refs = r1.tagged_count + (r2_untagged_count - added);
+      if (upb_Atomic_CompareExchangeWeak(
+              &r1.root->parent_or_count, &r1.tagged_count, with_r2_refs,
+              memory_order_release, memory_order_acquire)) {
+        r1.tagged_count = with_r2_refs;
+        added = r2_untagged_count;
+      } else if (_upb_Arena_IsTaggedPointer(r1.tagged_count)) {
+        // `r1` was fused under another root, start over from the top.
+        *ref_delta += added;
+        return NULL;
+      }
+    }
 
-  // Perform the actual fuse by removing the refs from `r2` and swapping in the
-  // parent pointer.
-  if (!upb_Atomic_CompareExchangeStrong(
-          &r2.root->parent_or_count, &r2.tagged_count,
-          _upb_Arena_TaggedFromPointer(r1.root), memory_order_release,
-          memory_order_acquire)) {
-    // We'll need to remove the excess refs we added to r1 previously.
-    *ref_delta += r2_untagged_count;
-    return NULL;
+    // Perform the actual fuse by removing the refs from `r2` and swapping in
+    // the parent pointer.
+    if (upb_Atomic_CompareExchangeWeak(
+            &r2.root->parent_or_count, &r2.tagged_count,
+            _upb_Arena_TaggedFromPointer(r1.root), memory_order_release,
+            memory_order_acquire)) {
+      break;
+    }
+    if (_upb_Arena_IsTaggedPointer(r2.tagged_count)) {
+      // We'll need to remove the excess refs we added to r1 previously.
+      *ref_delta += added;
+      return NULL;
+    }
+    r2_untagged_count = r2.tagged_count & ~1;
   }
+  *ref_delta += added - r2_untagged_count;
 
   // Now that the fuse has been performed (and can no longer fail) we need to
   // append `r2` to `r1`'s linked list.
@@ -343,12 +456,16 @@ static bool _upb_Arena_FixupRefs(upb_Arena* new_root, uintptr_t ref_delta) {
   if (ref_delta == 0) return true;  // No fixup required.
   uintptr_t poc =
       upb_Atomic_Load(&new_root->parent_or_count, memory_order_relaxed);
-  if (_upb_Arena_IsTaggedPointer(poc)) return false;
-  uintptr_t with_refs = poc - ref_delta;
-  UPB_ASSERT(!_upb_Arena_IsTaggedPointer(with_refs));
-  return upb_Atomic_CompareExchangeStrong(&new_root->parent_or_count, &poc,
-                                          with_refs, memory_order_relaxed,
-                                          memory_order_relaxed);
+  // Racing refcount changes on the root only require another try; we have to
+  // find the new root only if `new_root` itself was fused away.
+  do {
+    if (_upb_Arena_IsTaggedPointer(poc)) return false;
+    UPB_ASSERT(!_upb_Arena_IsTaggedPointer(poc - ref_delta));
+  } while (!upb_Atomic_CompareExchangeWeak(&new_root->parent_or_count, &poc,
+                                           poc - ref_delta,
+                                           memory_order_relaxed,
+                                           memory_order_relaxed));
+  return true;
 }
 
 bool upb_Arena_Fuse(upb_Arena* a1, upb_Arena* a2) {
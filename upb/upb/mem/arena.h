@@ -58,6 +58,28 @@ typedef struct {
   char *ptr, *end;
 } _upb_ArenaHead;
 
+// Controls how an arena sizes the blocks it allocates. Zero fields select the
+// built-in defaults.
+typedef struct {
+  // Usable size of the first block allocated by an arena that was not given an
+  // initial block. Default: 256.
+  size_t initial_block_size;
+
+  // Blocks stop growing once they reach this size. An allocation that is larger
+  // still gets a block of its own. Default: unlimited.
+  size_t max_block_size;
+
+  // Each block is this many times larger than the previous one. Default: 2.
+  uint32_t growth_factor;
+} upb_ArenaOptions;
+
+// Statistics for an arena and every arena fused with it.
+typedef struct {
+  size_t space_allocated;  // Same as upb_Arena_SpaceAllocated().
+  size_t block_count;
+  size_t largest_block;
+} upb_ArenaStats;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -67,11 +89,33 @@ extern "C" {
 // is a fixed-size arena and cannot grow.
 UPB_API upb_Arena* upb_Arena_Init(void* mem, size_t n, upb_alloc* alloc);
 
+// Like upb_Arena_Init(), but blocks are sized according to |options| instead
+// of the process-wide defaults. |options| may be NULL.
+UPB_API upb_Arena* upb_Arena_InitWithOptions(void* mem, size_t n,
+                                             upb_alloc* alloc,
+                                             const upb_ArenaOptions* options);
+
+// Replaces the process-wide defaults used by upb_Arena_Init() and
+// upb_Arena_New(). Zero fields restore the built-in default for that field.
+// This is not synchronized with arena creation, so it should be called during
+// startup before other threads create arenas.
+UPB_API void upb_Arena_SetDefaultOptions(const upb_ArenaOptions* options);
+UPB_API void upb_Arena_GetDefaultOptions(upb_ArenaOptions* options);
+
 UPB_API void upb_Arena_Free(upb_Arena* a);
 UPB_API bool upb_Arena_Fuse(upb_Arena* a, upb_Arena* b);
 
+// Adds a reference to `a` on behalf of `owner`, who must later drop it with
+// upb_Arena_DecRefFor(). The arena (and everything fused with it) is freed
+// once every reference is gone, including the one upb_Arena_Free() drops.
+// Returns false, without adding a reference, for arenas with an initial
+// block, whose lifetime cannot be extended.
+UPB_API bool upb_Arena_IncRefFor(upb_Arena* a, const void* owner);
+UPB_API void upb_Arena_DecRefFor(upb_Arena* a, const void* owner);
+
 void* _upb_Arena_SlowMalloc(upb_Arena* a, size_t size);
 size_t upb_Arena_SpaceAllocated(upb_Arena* arena);
+UPB_API void upb_Arena_GetStats(upb_Arena* arena, upb_ArenaStats* stats);
 uint32_t upb_Arena_DebugRefCount(upb_Arena* arena);
 
 UPB_INLINE size_t _upb_ArenaHas(upb_Arena* a) {
@@ -143,6 +187,11 @@ UPB_API_INLINE upb_Arena* upb_Arena_New(void) {
   return upb_Arena_Init(NULL, 0, &upb_alloc_global);
 }
 
+UPB_API_INLINE upb_Arena* upb_Arena_NewWithOptions(
+    const upb_ArenaOptions* options) {
+  return upb_Arena_InitWithOptions(NULL, 0, &upb_alloc_global, options);
+}
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
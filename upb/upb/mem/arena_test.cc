@@ -32,6 +32,7 @@
 
 #include <array>
 #include <atomic>
+#include <cstring>
 #include <thread>
 #include <vector>
 
@@ -83,6 +84,46 @@ TEST(ArenaTest, FuseWithInitialBlock) {
   for (int i = 0; i < size; ++i) upb_Arena_Free(arenas[i]);
 }
 
+TEST(ArenaTest, IncRefFor) {
+  upb_Arena* arena = upb_Arena_New();
+  int owner;
+  EXPECT_TRUE(upb_Arena_IncRefFor(arena, &owner));
+  EXPECT_EQ(upb_Arena_DebugRefCount(arena), 2);
+
+  // The arena outlives its creator's reference.
+  char* mem = static_cast<char*>(upb_Arena_Malloc(arena, 16));
+  upb_Arena_Free(arena);
+  memset(mem, 0, 16);
+  EXPECT_EQ(upb_Arena_DebugRefCount(arena), 1);
+  upb_Arena_DecRefFor(arena, &owner);
+
+  char buf[1024];
+  upb_Arena* fixed = upb_Arena_Init(buf, sizeof(buf), &upb_alloc_global);
+  EXPECT_FALSE(upb_Arena_IncRefFor(fixed, &owner));
+  upb_Arena_Free(fixed);
+}
+
+TEST(ArenaTest, IncRefForFusedArena) {
+  upb_Arena* arena1 = upb_Arena_New();
+  upb_Arena* arena2 = upb_Arena_New();
+  int owner;
+  EXPECT_TRUE(upb_Arena_Fuse(arena1, arena2));
+  EXPECT_TRUE(upb_Arena_IncRefFor(arena2, &owner));
+  EXPECT_EQ(upb_Arena_DebugRefCount(arena1), 3);
+  upb_Arena_Free(arena1);
+  upb_Arena_Free(arena2);
+  EXPECT_NE(upb_Arena_Malloc(arena2, 16), nullptr);
+  upb_Arena_DecRefFor(arena2, &owner);
+}
+
+TEST(ArenaTest, FixedArenaWithoutAllocator) {
+  char buf[1024];
+  upb_Arena* arena = upb_Arena_Init(buf, sizeof(buf), nullptr);
+  EXPECT_NE(upb_Arena_Malloc(arena, 16), nullptr);
+  EXPECT_EQ(upb_Arena_Malloc(arena, 2048), nullptr);
+  upb_Arena_Free(arena);
+}
+
 class Environment {
  public:
   ~Environment() {
@@ -143,6 +184,69 @@ TEST(ArenaTest, FuzzSingleThreaded) {
   }
 }
 
+TEST(ArenaTest, StatsCountFusedBlocks) {
+  upb_Arena* arena1 = upb_Arena_New();
+  upb_Arena* arena2 = upb_Arena_New();
+  upb_Arena_Malloc(arena1, 4096);
+  EXPECT_TRUE(upb_Arena_Fuse(arena1, arena2));
+
+  upb_ArenaStats stats;
+  upb_Arena_GetStats(arena2, &stats);
+  EXPECT_EQ(stats.space_allocated, upb_Arena_SpaceAllocated(arena1));
+  EXPECT_EQ(stats.block_count, 3);
+  EXPECT_GE(stats.largest_block, 4096);
+
+  upb_Arena_Free(arena1);
+  upb_Arena_Free(arena2);
+}
+
+TEST(ArenaTest, OptionsLimitBlockGrowth) {
+  upb_ArenaOptions options = {};
+  options.initial_block_size = 1024;
+  options.max_block_size = 4096;
+  options.growth_factor = 4;
+  upb_Arena* arena = upb_Arena_NewWithOptions(&options);
+
+  for (int i = 0; i < 100; ++i) upb_Arena_Malloc(arena, 512);
+  upb_ArenaStats stats;
+  upb_Arena_GetStats(arena, &stats);
+  EXPECT_GT(stats.block_count, 10);
+  EXPECT_LT(stats.largest_block, 4096 + 128);
+
+  // Allocations larger than the cap still succeed in a block of their own.
+  EXPECT_NE(upb_Arena_Malloc(arena, 100000), nullptr);
+  upb_Arena_GetStats(arena, &stats);
+  EXPECT_GE(stats.largest_block, 100000);
+
+  upb_Arena_Free(arena);
+}
+
+TEST(ArenaTest, DefaultOptions) {
+  upb_ArenaOptions saved;
+  upb_Arena_GetDefaultOptions(&saved);
+  EXPECT_EQ(saved.initial_block_size, 256);
+  EXPECT_EQ(saved.max_block_size, 0);
+  EXPECT_EQ(saved.growth_factor, 2);
+
+  upb_ArenaOptions options = {};
+  options.initial_block_size = 8192;
+  upb_Arena_SetDefaultOptions(&options);
+  upb_Arena* arena = upb_Arena_New();
+  upb_Arena_Malloc(arena, 4096);
+  upb_ArenaStats stats;
+  upb_Arena_GetStats(arena, &stats);
+  EXPECT_EQ(stats.block_count, 1);
+  EXPECT_GE(stats.space_allocated, 8192);
+  upb_Arena_Free(arena);
+
+  upb_ArenaOptions current;
+  upb_Arena_GetDefaultOptions(&current);
+  EXPECT_EQ(current.initial_block_size, 8192);
+  EXPECT_EQ(current.growth_factor, 2);
+
+  upb_Arena_SetDefaultOptions(&saved);
+}
+
 #ifdef UPB_USE_C11_ATOMICS
 
 TEST(ArenaTest, FuzzFuseFreeRace) {
@@ -191,6 +295,34 @@ TEST(ArenaTest, FuzzFuseFuseRace) {
   for (auto& t : threads) t.join();
 }
 
+TEST(ArenaTest, ConcurrentFuseIntoSameRoot) {
+  constexpr int kThreads = 10;
+  constexpr int kArenasPerThread = 1000;
+  upb_Arena* root = upb_Arena_New();
+
+  // Keep every arena alive until the end so that the final refcount tells us
+  // whether any refs were lost or duplicated by racing fuses.
+  std::vector<std::vector<upb_Arena*>> arenas(kThreads);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.emplace_back([&, i]() {
+      for (int j = 0; j < kArenasPerThread; ++j) {
+        upb_Arena* a = upb_Arena_New();
+        EXPECT_TRUE(upb_Arena_Fuse(root, a));
+        arenas[i].push_back(a);
+      }
+    });
+  }
+  for (auto& t : threads) t.join();
+
+  EXPECT_EQ(upb_Arena_DebugRefCount(root), 1 + kThreads * kArenasPerThread);
+  for (auto& v : arenas) {
+    for (upb_Arena* a : v) upb_Arena_Free(a);
+  }
+  EXPECT_EQ(upb_Arena_DebugRefCount(root), 1);
+  upb_Arena_Free(root);
+}
+
 #endif
 
 }  // namespace
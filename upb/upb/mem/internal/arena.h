@@ -65,6 +65,10 @@ struct upb_Arena {
   // Linked list of blocks to free/cleanup.  Atomic only for the benefit of
   // upb_Arena_SpaceAllocated().
   UPB_ATOMIC(_upb_MemBlock*) blocks;
+
+  // Block growth policy, resolved from upb_ArenaOptions at creation.
+  uint32_t max_block_size;
+  uint32_t growth_factor;
 };
 
 UPB_INLINE bool _upb_Arena_IsTaggedRefcount(uintptr_t parent_or_count) {
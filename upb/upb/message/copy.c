@@ -50,10 +50,11 @@ static bool upb_MessageField_IsMap(const upb_MiniTableField* field) {
 }
 
 static upb_StringView upb_Clone_StringView(upb_StringView str,
-                                           upb_Arena* arena) {
+                                           upb_Arena* arena, bool alias) {
   if (str.size == 0) {
     return upb_StringView_FromDataAndSize(NULL, 0);
   }
+  if (alias) return str;
   void* cloned_data = upb_Arena_Malloc(arena, str.size);
   upb_StringView cloned_str =
       upb_StringView_FromDataAndSize(cloned_data, str.size);
@@ -61,8 +62,13 @@ static upb_StringView upb_Clone_StringView(upb_StringView str,
   return cloned_str;
 }
 
+static upb_Message* _upb_Message_Clone(const upb_Message* message,
+                                       const upb_MiniTable* mini_table,
+                                       upb_Arena* arena, bool alias);
+
 static bool upb_Clone_MessageValue(void* value, upb_CType value_type,
-                                   const upb_MiniTable* sub, upb_Arena* arena) {
+                                   const upb_MiniTable* sub, upb_Arena* arena,
+                                   bool alias) {
   switch (value_type) {
     case kUpb_CType_Bool:
     case kUpb_CType_Float:
@@ -77,6 +83,7 @@ static bool upb_Clone_MessageValue(void* value, upb_CType value_type,
     case kUpb_CType_Bytes: {
       upb_StringView source = *(upb_StringView*)value;
       int size = source.size;
+      if (alias) return true;
       void* cloned_data = upb_Arena_Malloc(arena, size);
       if (cloned_data == NULL) {
         return false;
@@ -91,8 +98,8 @@ static bool upb_Clone_MessageValue(void* value, upb_CType value_type,
       bool is_empty = upb_TaggedMessagePtr_IsEmpty(source);
       if (is_empty) sub = &_kUpb_MiniTable_Empty;
       UPB_ASSERT(source);
-      upb_Message* clone = upb_Message_DeepClone(
-          _upb_TaggedMessagePtr_GetMessage(source), sub, arena);
+      upb_Message* clone = _upb_Message_Clone(
+          _upb_TaggedMessagePtr_GetMessage(source), sub, arena, alias);
       *(upb_TaggedMessagePtr*)value =
           _upb_TaggedMessagePtr_Pack(clone, is_empty);
       return clone != NULL;
@@ -101,10 +108,9 @@ static bool upb_Clone_MessageValue(void* value, upb_CType value_type,
   UPB_UNREACHABLE();
 }
 
-upb_Map* upb_Map_DeepClone(const upb_Map* map, upb_CType key_type,
-                           upb_CType value_type,
-                           const upb_MiniTable* map_entry_table,
-                           upb_Arena* arena) {
+static upb_Map* _upb_Map_Clone(const upb_Map* map,
+                               const upb_MiniTable* map_entry_table,
+                               upb_Arena* arena, bool alias) {
   upb_Map* cloned_map = _upb_Map_New(arena, map->key_size, map->val_size);
   if (cloned_map == NULL) {
     return NULL;
@@ -118,7 +124,8 @@ upb_Map* upb_Map_DeepClone(const upb_Map* map, upb_CType key_type,
             ? upb_MiniTable_GetSubMessageTable(map_entry_table, value_field)
             : NULL;
     upb_CType value_field_type = upb_MiniTableField_CType(value_field);
-    if (!upb_Clone_MessageValue(&val, value_field_type, value_sub, arena)) {
+    if (!upb_Clone_MessageValue(&val, value_field_type, value_sub, arena,
+                                alias)) {
       return NULL;
     }
     if (upb_Map_Insert(cloned_map, key, val, arena) ==
@@ -129,21 +136,23 @@ upb_Map* upb_Map_DeepClone(const upb_Map* map, upb_CType key_type,
   return cloned_map;
 }
 
+upb_Map* upb_Map_DeepClone(const upb_Map* map, upb_CType key_type,
+                           upb_CType value_type,
+                           const upb_MiniTable* map_entry_table,
+                           upb_Arena* arena) {
+  return _upb_Map_Clone(map, map_entry_table, arena, false);
+}
+
 static upb_Map* upb_Message_Map_DeepClone(const upb_Map* map,
                                           const upb_MiniTable* mini_table,
                                           const upb_MiniTableField* field,
                                           upb_Message* clone,
-                                          upb_Arena* arena) {
+                                          upb_Arena* arena, bool alias) {
   const upb_MiniTable* map_entry_table =
       mini_table->subs[field->UPB_PRIVATE(submsg_index)].submsg;
   UPB_ASSERT(map_entry_table);
 
-  const upb_MiniTableField* key_field = &map_entry_table->fields[0];
-  const upb_MiniTableField* value_field = &map_entry_table->fields[1];
-
-  upb_Map* cloned_map = upb_Map_DeepClone(
-      map, upb_MiniTableField_CType(key_field),
-      upb_MiniTableField_CType(value_field), map_entry_table, arena);
+  upb_Map* cloned_map = _upb_Map_Clone(map, map_entry_table, arena, alias);
   if (!cloned_map) {
     return NULL;
   }
@@ -151,8 +160,10 @@ static upb_Map* upb_Message_Map_DeepClone(const upb_Map* map,
   return cloned_map;
 }
 
-upb_Array* upb_Array_DeepClone(const upb_Array* array, upb_CType value_type,
-                               const upb_MiniTable* sub, upb_Arena* arena) {
+static upb_Array* _upb_Array_Clone(const upb_Array* array,
+                                   upb_CType value_type,
+                                   const upb_MiniTable* sub, upb_Arena* arena,
+                                   bool alias) {
   size_t size = array->size;
   upb_Array* cloned_array =
       _upb_Array_New(arena, size, _upb_Array_CTypeSizeLg2(value_type));
@@ -164,7 +175,7 @@ upb_Array* upb_Array_DeepClone(const upb_Array* array, upb_CType value_type,
   }
   for (size_t i = 0; i < size; ++i) {
     upb_MessageValue val = upb_Array_Get(array, i);
-    if (!upb_Clone_MessageValue(&val, value_type, sub, arena)) {
+    if (!upb_Clone_MessageValue(&val, value_type, sub, arena, alias)) {
       return false;
     }
     upb_Array_Set(cloned_array, i, val);
@@ -172,18 +183,24 @@ upb_Array* upb_Array_DeepClone(const upb_Array* array, upb_CType value_type,
   return cloned_array;
 }
 
+upb_Array* upb_Array_DeepClone(const upb_Array* array, upb_CType value_type,
+                               const upb_MiniTable* sub, upb_Arena* arena) {
+  return _upb_Array_Clone(array, value_type, sub, arena, false);
+}
+
 static bool upb_Message_Array_DeepClone(const upb_Array* array,
                                         const upb_MiniTable* mini_table,
                                         const upb_MiniTableField* field,
-                                        upb_Message* clone, upb_Arena* arena) {
+                                        upb_Message* clone, upb_Arena* arena,
+                                        bool alias) {
   _upb_MiniTableField_CheckIsArray(field);
-  upb_Array* cloned_array = upb_Array_DeepClone(
+  upb_Array* cloned_array = _upb_Array_Clone(
       array, upb_MiniTableField_CType(field),
       upb_MiniTableField_CType(field) == kUpb_CType_Message &&
               field->UPB_PRIVATE(submsg_index) != kUpb_NoSub
           ? upb_MiniTable_GetSubMessageTable(mini_table, field)
           : NULL,
-      arena);
+      arena, alias);
 
   // Clear out upb_Array* due to parent memcpy.
   _upb_Message_SetNonExtensionField(clone, field, &cloned_array);
@@ -193,16 +210,17 @@ static bool upb_Message_Array_DeepClone(const upb_Array* array,
 static bool upb_Clone_ExtensionValue(
     const upb_MiniTableExtension* mini_table_ext,
     const upb_Message_Extension* source, upb_Message_Extension* dest,
-    upb_Arena* arena) {
+    upb_Arena* arena, bool alias) {
   dest->data = source->data;
   return upb_Clone_MessageValue(
       &dest->data, upb_MiniTableField_CType(&mini_table_ext->field),
-      mini_table_ext->sub.submsg, arena);
+      mini_table_ext->sub.submsg, arena, alias);
 }
 
-upb_Message* _upb_Message_Copy(upb_Message* dst, const upb_Message* src,
-                               const upb_MiniTable* mini_table,
-                               upb_Arena* arena) {
+static upb_Message* _upb_Message_CopyInternal(upb_Message* dst,
+                                              const upb_Message* src,
+                                              const upb_MiniTable* mini_table,
+                                              upb_Arena* arena, bool alias) {
   upb_StringView empty_string = upb_StringView_FromDataAndSize(NULL, 0);
   // Only copy message area skipping upb_Message_Internal.
   memcpy(dst, src, mini_table->size);
@@ -223,8 +241,8 @@ upb_Message* _upb_Message_Copy(upb_Message* dst, const upb_Message* src,
             const upb_MiniTable* sub_message_table =
                 is_empty ? &_kUpb_MiniTable_Empty
                          : upb_MiniTable_GetSubMessageTable(mini_table, field);
-            upb_Message* dst_sub_message =
-                upb_Message_DeepClone(sub_message, sub_message_table, arena);
+            upb_Message* dst_sub_message = _upb_Message_Clone(
+                sub_message, sub_message_table, arena, alias);
             if (dst_sub_message == NULL) {
               return NULL;
             }
@@ -238,7 +256,8 @@ upb_Message* _upb_Message_Copy(upb_Message* dst, const upb_Message* src,
           upb_StringView str = upb_Message_GetString(src, field, empty_string);
           if (str.size != 0) {
             if (!upb_Message_SetString(
-                    dst, field, upb_Clone_StringView(str, arena), arena)) {
+                    dst, field, upb_Clone_StringView(str, arena, alias),
+                    arena)) {
               return NULL;
             }
           }
@@ -251,7 +270,8 @@ upb_Message* _upb_Message_Copy(upb_Message* dst, const upb_Message* src,
       if (upb_MessageField_IsMap(field)) {
         const upb_Map* map = upb_Message_GetMap(src, field);
         if (map != NULL) {
-          if (!upb_Message_Map_DeepClone(map, mini_table, field, dst, arena)) {
+          if (!upb_Message_Map_DeepClone(map, mini_table, field, dst, arena,
+                                         alias)) {
             return NULL;
           }
         }
@@ -259,7 +279,7 @@ upb_Message* _upb_Message_Copy(upb_Message* dst, const upb_Message* src,
         const upb_Array* array = upb_Message_GetArray(src, field);
         if (array != NULL) {
           if (!upb_Message_Array_DeepClone(array, mini_table, field, dst,
-                                           arena)) {
+                                           arena, alias)) {
             return NULL;
           }
         }
@@ -276,15 +296,16 @@ upb_Message* _upb_Message_Copy(upb_Message* dst, const upb_Message* src,
         _upb_Message_GetOrCreateExtension(dst, msg_ext->ext, arena);
     if (!dst_ext) return NULL;
     if (!upb_IsRepeatedOrMap(field)) {
-      if (!upb_Clone_ExtensionValue(msg_ext->ext, msg_ext, dst_ext, arena)) {
+      if (!upb_Clone_ExtensionValue(msg_ext->ext, msg_ext, dst_ext, arena,
+                                    alias)) {
         return NULL;
       }
     } else {
       upb_Array* msg_array = (upb_Array*)msg_ext->data.ptr;
       UPB_ASSERT(msg_array);
       upb_Array* cloned_array =
-          upb_Array_DeepClone(msg_array, upb_MiniTableField_CType(field),
-                              msg_ext->ext->sub.submsg, arena);
+          _upb_Array_Clone(msg_array, upb_MiniTableField_CType(field),
+                           msg_ext->ext->sub.submsg, arena, alias);
       if (!cloned_array) {
         return NULL;
       }
@@ -305,6 +326,20 @@ upb_Message* _upb_Message_Copy(upb_Message* dst, const upb_Message* src,
   return dst;
 }
 
+static upb_Message* _upb_Message_Clone(const upb_Message* message,
+                                       const upb_MiniTable* mini_table,
+                                       upb_Arena* arena, bool alias) {
+  upb_Message* clone = upb_Message_New(mini_table, arena);
+  if (!clone) return NULL;
+  return _upb_Message_CopyInternal(clone, message, mini_table, arena, alias);
+}
+
+upb_Message* _upb_Message_Copy(upb_Message* dst, const upb_Message* src,
+                               const upb_MiniTable* mini_table,
+                               upb_Arena* arena) {
+  return _upb_Message_CopyInternal(dst, src, mini_table, arena, false);
+}
+
 bool upb_Message_DeepCopy(upb_Message* dst, const upb_Message* src,
                           const upb_MiniTable* mini_table, upb_Arena* arena) {
   upb_Message_Clear(dst, mini_table);
@@ -317,6 +352,24 @@ bool upb_Message_DeepCopy(upb_Message* dst, const upb_Message* src,
 upb_Message* upb_Message_DeepClone(const upb_Message* message,
                                    const upb_MiniTable* mini_table,
                                    upb_Arena* arena) {
-  upb_Message* clone = upb_Message_New(mini_table, arena);
-  return _upb_Message_Copy(clone, message, mini_table, arena);
+  return _upb_Message_Clone(message, mini_table, arena, false);
+}
+
+// String data is never modified in place, only replaced, so once the arenas
+// are fused the clone can simply point at the source's bytes. Arenas with an
+// initial block cannot be fused; fall back to a full copy for those.
+bool upb_Message_ShareCopy(upb_Message* dst, const upb_Message* src,
+                           const upb_MiniTable* mini_table,
+                           upb_Arena* src_arena, upb_Arena* arena) {
+  bool alias = upb_Arena_Fuse(src_arena, arena);
+  upb_Message_Clear(dst, mini_table);
+  return _upb_Message_CopyInternal(dst, src, mini_table, arena, alias) != NULL;
+}
+
+upb_Message* upb_Message_ShareClone(const upb_Message* message,
+                                    const upb_MiniTable* mini_table,
+                                    upb_Arena* message_arena,
+                                    upb_Arena* arena) {
+  bool alias = upb_Arena_Fuse(message_arena, arena);
+  return _upb_Message_Clone(message, mini_table, arena, alias);
 }
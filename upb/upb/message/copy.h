@@ -60,6 +60,22 @@ upb_Map* upb_Map_DeepClone(const upb_Map* map, upb_CType key_type,
 bool upb_Message_DeepCopy(upb_Message* dst, const upb_Message* src,
                           const upb_MiniTable* mini_table, upb_Arena* arena);
 
+// Like upb_Message_DeepCopy(), but string and bytes fields of dst share their
+// data with src instead of copying it. src_arena (the arena that owns src) is
+// fused with arena so that the shared data lives as long as dst; this also
+// means src_arena's memory is not released until both arenas are freed.
+// Messages, arrays and maps are still copied, so either message may be
+// mutated afterwards without affecting the other.
+bool upb_Message_ShareCopy(upb_Message* dst, const upb_Message* src,
+                           const upb_MiniTable* mini_table,
+                           upb_Arena* src_arena, upb_Arena* arena);
+
+// Like upb_Message_DeepClone(), with the sharing of upb_Message_ShareCopy().
+upb_Message* upb_Message_ShareClone(const upb_Message* message,
+                                    const upb_MiniTable* mini_table,
+                                    upb_Arena* message_arena,
+                                    upb_Arena* arena);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -341,4 +341,97 @@ TEST(GeneratedCode, DeepCloneMessageWithUnknowns) {
   upb_Arena_Free(clone_arena);
 }
 
+TEST(GeneratedCode, ShareCloneSharesStringsButNotMessages) {
+  upb_Arena* source_arena = upb_Arena_New();
+  protobuf_test_messages_proto2_TestAllTypesProto2* msg =
+      protobuf_test_messages_proto2_TestAllTypesProto2_new(source_arena);
+  const upb_MiniTableField* optional_string_field =
+      find_proto2_field(kFieldOptionalString);
+  char* string_in_arena =
+      (char*)upb_Arena_Malloc(source_arena, sizeof(kTestStr1));
+  memcpy(string_in_arena, kTestStr1, sizeof(kTestStr1));
+  upb_Message_SetString(
+      msg, optional_string_field,
+      upb_StringView_FromDataAndSize(string_in_arena, sizeof(kTestStr1) - 1),
+      source_arena);
+  ASSERT_TRUE(
+      protobuf_test_messages_proto2_TestAllTypesProto2_add_repeated_string(
+          msg, upb_StringView_FromString(kTestStr2), source_arena));
+  protobuf_test_messages_proto2_TestAllTypesProto2_NestedMessage* nested =
+      protobuf_test_messages_proto2_TestAllTypesProto2_mutable_optional_nested_message(
+          msg, source_arena);
+  protobuf_test_messages_proto2_TestAllTypesProto2_NestedMessage_set_a(
+      nested, kTestNestedInt32);
+
+  upb_Arena* arena = upb_Arena_New();
+  protobuf_test_messages_proto2_TestAllTypesProto2* clone =
+      (protobuf_test_messages_proto2_TestAllTypesProto2*)upb_Message_ShareClone(
+          msg, &protobuf_test_messages_proto2_TestAllTypesProto2_msg_init,
+          source_arena, arena);
+  ASSERT_NE(clone, nullptr);
+
+  // String data is shared...
+  EXPECT_EQ(upb_Message_GetString(clone, optional_string_field,
+                                  upb_StringView_FromDataAndSize(nullptr, 0))
+                .data,
+            string_in_arena);
+  size_t size;
+  const upb_StringView* repeated =
+      protobuf_test_messages_proto2_TestAllTypesProto2_repeated_string(clone,
+                                                                       &size);
+  ASSERT_EQ(size, 1);
+  EXPECT_EQ(repeated[0].data, kTestStr2);
+
+  // ...but sub-messages are not.
+  protobuf_test_messages_proto2_TestAllTypesProto2_NestedMessage_set_a(nested,
+                                                                       0);
+  EXPECT_EQ(protobuf_test_messages_proto2_TestAllTypesProto2_NestedMessage_a(
+                protobuf_test_messages_proto2_TestAllTypesProto2_optional_nested_message(
+                    clone)),
+            kTestNestedInt32);
+
+  // The arenas are fused, so the shared data outlives source_arena.
+  upb_Arena_Free(source_arena);
+  EXPECT_TRUE(upb_StringView_IsEqual(
+      upb_Message_GetString(clone, optional_string_field,
+                            upb_StringView_FromDataAndSize(nullptr, 0)),
+      upb_StringView_FromString(kTestStr1)));
+  upb_Arena_Free(arena);
+}
+
+TEST(GeneratedCode, ShareCopyFallsBackToCopyWhenArenasCannotFuse) {
+  char initial_block[512];
+  upb_Arena* source_arena =
+      upb_Arena_Init(initial_block, sizeof(initial_block), &upb_alloc_global);
+  protobuf_test_messages_proto2_TestAllTypesProto2* msg =
+      protobuf_test_messages_proto2_TestAllTypesProto2_new(source_arena);
+  const upb_MiniTableField* optional_string_field =
+      find_proto2_field(kFieldOptionalString);
+  char* string_in_arena =
+      (char*)upb_Arena_Malloc(source_arena, sizeof(kTestStr1));
+  memcpy(string_in_arena, kTestStr1, sizeof(kTestStr1));
+  upb_Message_SetString(
+      msg, optional_string_field,
+      upb_StringView_FromDataAndSize(string_in_arena, sizeof(kTestStr1) - 1),
+      source_arena);
+
+  upb_Arena* arena = upb_Arena_New();
+  upb_Message* copy = upb_Message_New(
+      &protobuf_test_messages_proto2_TestAllTypesProto2_msg_init, arena);
+  ASSERT_TRUE(upb_Message_ShareCopy(
+      copy, msg, &protobuf_test_messages_proto2_TestAllTypesProto2_msg_init,
+      source_arena, arena));
+  EXPECT_NE(upb_Message_GetString(copy, optional_string_field,
+                                  upb_StringView_FromDataAndSize(nullptr, 0))
+                .data,
+            string_in_arena);
+  memset(string_in_arena, 0, sizeof(kTestStr1));
+  upb_Arena_Free(source_arena);
+  EXPECT_TRUE(upb_StringView_IsEqual(
+      upb_Message_GetString(copy, optional_string_field,
+                            upb_StringView_FromDataAndSize(nullptr, 0)),
+      upb_StringView_FromString(kTestStr1)));
+  upb_Arena_Free(arena);
+}
+
 }  // namespace
@@ -97,6 +97,17 @@ UPB_INLINE void _upb_sethas_field(const upb_Message* msg,
   _upb_sethas(msg, _upb_Message_Hasidx(f));
 }
 
+// Returns true if any required field of |msg| is unset.  Required fields have
+// the lowest hasbits, so this is a single compare of the leading hasbit bytes.
+UPB_INLINE bool _upb_Message_MissingRequired(const upb_Message* msg,
+                                             const upb_MiniTable* l) {
+  if (!l->required_count) return false;
+  const unsigned char* head = (const unsigned char*)msg;
+  uint64_t hasbits = 0;
+  for (int i = 0; i < 8; i++) hasbits |= (uint64_t)head[i] << (8 * i);
+  return (upb_MiniTable_requiredmask(l) & ~hasbits) != 0;
+}
+
 // Oneof case access ///////////////////////////////////////////////////////////
 
 UPB_INLINE size_t _upb_oneofcase_ofs(const upb_MiniTableField* f) {
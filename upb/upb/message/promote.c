@@ -35,6 +35,7 @@
 #include "upb/collections/map.h"
 #include "upb/message/accessors.h"
 #include "upb/message/message.h"
+#include "upb/mini_descriptor/link.h"
 #include "upb/mini_table/field.h"
 #include "upb/wire/decode.h"
 #include "upb/wire/encode.h"
@@ -231,6 +232,73 @@ upb_DecodeStatus upb_Map_PromoteMessages(upb_Map* map,
   return kUpb_DecodeStatus_Ok;
 }
 
+static upb_DecodeStatus upb_UnknownToMessage_DecodeStatus(
+    upb_UnknownToMessage_Status status) {
+  switch (status) {
+    case kUpb_UnknownToMessage_Ok:
+    case kUpb_UnknownToMessage_NotFound:
+      return kUpb_DecodeStatus_Ok;
+    case kUpb_UnknownToMessage_OutOfMemory:
+      return kUpb_DecodeStatus_OutOfMemory;
+    case kUpb_UnknownToMessage_ParseError:
+    default:
+      return kUpb_DecodeStatus_Malformed;
+  }
+}
+
+upb_DecodeStatus upb_Message_LinkAndPromoteField(
+    upb_Message* msg, upb_MiniTable* mini_table, upb_MiniTableField* field,
+    upb_MiniTable_SubMessageResolver* resolver, void* resolver_ctx,
+    int decode_options, upb_Arena* arena) {
+  UPB_ASSERT(upb_MiniTableField_CType(field) == kUpb_CType_Message);
+  const upb_MiniTable* sub =
+      upb_MiniTable_GetSubMessageTable(mini_table, field);
+  if (!sub) {
+    sub = resolver(resolver_ctx, mini_table, field);
+    if (!sub) return kUpb_DecodeStatus_UnlinkedSubMessage;
+    // A map field parsed while unlinked holds an array of empty messages,
+    // which cannot be reinterpreted once the field is linked as a map.
+    UPB_ASSERT(!(sub->ext & kUpb_ExtMode_IsMapEntry) ||
+               !upb_Message_GetArray(msg, field));
+    if (!upb_MiniTable_SetSubMessage(mini_table, field, sub)) {
+      return kUpb_DecodeStatus_UnlinkedSubMessage;
+    }
+  }
+
+  switch (upb_FieldMode_Get(field)) {
+    case kUpb_FieldMode_Map:
+      return upb_UnknownToMessage_DecodeStatus(
+          upb_MiniTable_PromoteUnknownToMap(msg, mini_table, field,
+                                            decode_options, arena));
+    case kUpb_FieldMode_Array: {
+      upb_Array* arr = upb_Message_GetMutableArray(msg, field);
+      if (arr) {
+        upb_DecodeStatus status =
+            upb_Array_PromoteMessages(arr, sub, decode_options, arena);
+        if (status != kUpb_DecodeStatus_Ok) return status;
+      }
+      return upb_UnknownToMessage_DecodeStatus(
+          upb_MiniTable_PromoteUnknownToMessageArray(msg, field, sub,
+                                                     decode_options, arena));
+    }
+    case kUpb_FieldMode_Scalar: {
+      upb_TaggedMessagePtr tagged =
+          upb_Message_GetTaggedMessagePtr(msg, field, NULL);
+      if (upb_TaggedMessagePtr_IsEmpty(tagged)) {
+        upb_Message* promoted;
+        return upb_Message_PromoteMessage(msg, mini_table, field,
+                                          decode_options, arena, &promoted);
+      }
+      if (tagged) return kUpb_DecodeStatus_Ok;
+      return upb_UnknownToMessage_DecodeStatus(
+          upb_MiniTable_PromoteUnknownToMessage(msg, mini_table, field, sub,
+                                                decode_options, arena)
+              .status);
+    }
+  }
+  UPB_UNREACHABLE();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // OLD promotion functions, will be removed!
 ////////////////////////////////////////////////////////////////////////////////
@@ -33,6 +33,8 @@
 
 #include "upb/collections/array.h"
 #include "upb/message/internal/extension.h"
+#include "upb/mini_table/field.h"
+#include "upb/mini_table/message.h"
 #include "upb/wire/decode.h"
 
 // Must be last.
@@ -139,6 +141,41 @@ upb_DecodeStatus upb_Map_PromoteMessages(upb_Map* map,
                                          const upb_MiniTable* mini_table,
                                          int decode_options, upb_Arena* arena);
 
+// Returns the MiniTable for the sub-message of `field`, which was left
+// unlinked (passed as NULL to upb_MiniTable_Link()). Typically this builds the
+// sub-message's MiniTable from its MiniDescriptor on first use. Returns NULL
+// on failure.
+typedef const upb_MiniTable* upb_MiniTable_SubMessageResolver(
+    void* ctx, const upb_MiniTable* mini_table,
+    const upb_MiniTableField* field);
+
+// Lazily links a sub-message field and promotes its value in `msg`.
+//
+// This lets a schema be loaded with only the MiniTables that are actually
+// used: sub-messages can be left unlinked up front and are then linked the
+// first time they are accessed. While `field` is unlinked the parser stores
+// its data either as unknown fields or, with
+// kUpb_DecodeOption_ExperimentalAllowUnlinked, as "empty" messages.
+//
+// If `field` is still unlinked, `resolver` is called to obtain the sub-message
+// MiniTable, which is then linked with upb_MiniTable_SetSubMessage(). After
+// that, whatever the parser stored for `field` in `msg` is promoted so that
+// the regular accessors can be used. Calling this again on a linked field only
+// promotes, so it must be called once for every message that was parsed
+// while `field` was unlinked.
+//
+// Linking mutates `mini_table` without synchronization, as described for
+// upb_MiniTable_SetSubMessage(). Map fields must have been parsed without
+// kUpb_DecodeOption_ExperimentalAllowUnlinked, because linking them changes
+// how the field is stored.
+//
+// Returns kUpb_DecodeStatus_UnlinkedSubMessage if the field could not be
+// linked, or the status of parsing the promoted data.
+upb_DecodeStatus upb_Message_LinkAndPromoteField(
+    upb_Message* msg, upb_MiniTable* mini_table, upb_MiniTableField* field,
+    upb_MiniTable_SubMessageResolver* resolver, void* resolver_ctx,
+    int decode_options, upb_Arena* arena);
+
 ////////////////////////////////////////////////////////////////////////////////
 // OLD promotion interfaces, will be removed!
 ////////////////////////////////////////////////////////////////////////////////
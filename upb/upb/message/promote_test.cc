@@ -705,6 +705,105 @@ upb_MiniTable* CreateMapEntryMiniTableOld(upb_Arena* arena) {
   return table;
 }
 
+const upb_MiniTable* ResolveModelWithExtensions(
+    void* ctx, const upb_MiniTable* mini_table,
+    const upb_MiniTableField* field) {
+  ++*static_cast<int*>(ctx);
+  return &upb_test_ModelWithExtensions_msg_init;
+}
+
+TEST(GeneratedCode, LinkAndPromoteLazily) {
+  upb::Arena arena;
+  upb_test_ModelWithSubMessages* input_msg =
+      upb_test_ModelWithSubMessages_new(arena.ptr());
+  upb_test_ModelWithSubMessages_set_id(input_msg, 11);
+  upb_test_ModelWithExtensions* sub_message =
+      upb_test_ModelWithExtensions_new(arena.ptr());
+  upb_test_ModelWithExtensions_set_random_int32(sub_message, 12);
+  upb_test_ModelWithSubMessages_set_optional_child(input_msg, sub_message);
+  upb_test_ModelWithExtensions* item =
+      upb_test_ModelWithSubMessages_add_items(input_msg, arena.ptr());
+  upb_test_ModelWithExtensions_set_random_int32(item, 5);
+  item = upb_test_ModelWithSubMessages_add_items(input_msg, arena.ptr());
+  upb_test_ModelWithExtensions_set_random_int32(item, 6);
+  size_t serialized_size;
+  char* serialized = upb_test_ModelWithSubMessages_serialize(
+      input_msg, arena.ptr(), &serialized_size);
+
+  upb_MiniTable* mini_table = CreateMiniTableWithEmptySubTables(arena.ptr());
+
+  // One message keeps the unlinked data as "empty" messages, the other as
+  // unknown fields.
+  upb_Message* empty_msg = _upb_Message_New(mini_table, arena.ptr());
+  EXPECT_EQ(upb_Decode(serialized, serialized_size, empty_msg, mini_table,
+                       nullptr, kUpb_DecodeOption_ExperimentalAllowUnlinked,
+                       arena.ptr()),
+            kUpb_DecodeStatus_Ok);
+  upb_Message* unknown_msg = _upb_Message_New(mini_table, arena.ptr());
+  EXPECT_EQ(upb_Decode(serialized, serialized_size, unknown_msg, mini_table,
+                       nullptr, 0, arena.ptr()),
+            kUpb_DecodeStatus_Ok);
+
+  const int decode_options =
+      upb_DecodeOptions_MaxDepth(kUpb_WireFormat_DefaultDepthLimit);
+  upb_MiniTableField* child_field = const_cast<upb_MiniTableField*>(
+      upb_MiniTable_FindFieldByNumber(mini_table, 5));
+  upb_MiniTableField* items_field = const_cast<upb_MiniTableField*>(
+      upb_MiniTable_FindFieldByNumber(mini_table, 6));
+  int resolved = 0;
+  for (upb_MiniTableField* field : {child_field, items_field}) {
+    for (upb_Message* msg : {empty_msg, unknown_msg}) {
+      EXPECT_EQ(upb_Message_LinkAndPromoteField(
+                    msg, mini_table, field, ResolveModelWithExtensions,
+                    &resolved, decode_options, arena.ptr()),
+                kUpb_DecodeStatus_Ok);
+    }
+  }
+  // Each field is only resolved the first time it is accessed.
+  EXPECT_EQ(resolved, 2);
+
+  for (upb_Message* msg : {empty_msg, unknown_msg}) {
+    const upb_Message* child =
+        upb_Message_GetMessage(msg, child_field, nullptr);
+    ASSERT_NE(child, nullptr);
+    EXPECT_EQ(upb_test_ModelWithExtensions_random_int32(
+                  (const upb_test_ModelWithExtensions*)child),
+              12);
+    const upb_Array* items = upb_Message_GetArray(msg, items_field);
+    ASSERT_NE(items, nullptr);
+    ASSERT_EQ(upb_Array_Size(items), 2);
+    EXPECT_EQ(upb_test_ModelWithExtensions_random_int32(
+                  (const upb_test_ModelWithExtensions*)upb_Array_Get(items, 0)
+                      .msg_val),
+              5);
+    EXPECT_EQ(upb_test_ModelWithExtensions_random_int32(
+                  (const upb_test_ModelWithExtensions*)upb_Array_Get(items, 1)
+                      .msg_val),
+              6);
+    size_t unknown_size;
+    upb_Message_GetUnknown(msg, &unknown_size);
+    EXPECT_EQ(unknown_size, 0);
+  }
+}
+
+const upb_MiniTable* ResolveNothing(void* ctx, const upb_MiniTable* mini_table,
+                                    const upb_MiniTableField* field) {
+  return nullptr;
+}
+
+TEST(GeneratedCode, LinkAndPromoteResolverFailure) {
+  upb::Arena arena;
+  upb_MiniTable* mini_table = CreateMiniTableWithEmptySubTables(arena.ptr());
+  upb_Message* msg = _upb_Message_New(mini_table, arena.ptr());
+  upb_MiniTableField* field = const_cast<upb_MiniTableField*>(
+      upb_MiniTable_FindFieldByNumber(mini_table, 5));
+  EXPECT_EQ(upb_Message_LinkAndPromoteField(msg, mini_table, field,
+                                            ResolveNothing, nullptr, 0,
+                                            arena.ptr()),
+            kUpb_DecodeStatus_UnlinkedSubMessage);
+  EXPECT_FALSE(upb_MiniTable_MessageFieldIsLinked(mini_table, field));
+}
+
 TEST(GeneratedCode, PromoteUnknownMessageOld) {
   upb_Arena* arena = upb_Arena_New();
   upb_test_ModelWithSubMessages* input_msg =
@@ -0,0 +1,575 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google LLC.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "upb/reflection/def_pool_image.h"
+
+#include <setjmp.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "upb/hash/int_table.h"
+#include "upb/mini_table/internal/enum.h"
+#include "upb/mini_table/internal/extension.h"
+#include "upb/mini_table/internal/field.h"
+#include "upb/mini_table/internal/file.h"
+#include "upb/mini_table/internal/message.h"
+#include "upb/reflection/def.h"
+#include "upb/reflection/internal/def_pool.h"
+#include "upb/reflection/internal/enum_def.h"
+#include "upb/reflection/internal/file_def.h"
+
+// Must be last.
+#include "upb/port/def.inc"
+
+// An image is laid out as follows, with all integers stored as native
+// uint32_t:
+//
+//   upb_DefPoolImage_Header
+//   upb_DefPoolImage_File[file_count]
+//   uint32_t relocs[reloc_count]
+//   (padding to 8 bytes)
+//   blob: the MiniTables, with each pointer stored as an offset into the blob
+//   the serialized FileDescriptorProtos
+//
+// Each reloc is the blob offset of a pointer slot. If its low bit is set the
+// slot points to the shared empty MiniTable, otherwise the slot holds the blob
+// offset of its target. NULL slots hold zero and have no reloc.
+
+#define kUpb_DefPoolImage_Magic 0x49627075  // "upbI" read as little-endian.
+#define kUpb_DefPoolImage_Version 1
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t ptr_size;
+  uint32_t file_count;
+  uint32_t reloc_count;
+  uint32_t blob_offset;
+  uint32_t blob_size;
+} upb_DefPoolImage_Header;
+
+typedef struct {
+  uint32_t layout;  // Blob offset of the file's upb_MiniTableFile.
+  uint32_t descriptor_offset;
+  uint32_t descriptor_size;
+} upb_DefPoolImage_File;
+
+/* Writer *********************************************************************/
+
+typedef struct {
+  const void* target;
+  uint32_t slot;
+} upb_ImagePatch;
+
+typedef struct {
+  upb_Arena* arena;  // Scratch memory, freed when the image is done.
+  char* blob;
+  size_t blob_size, blob_cap;
+  uint32_t* relocs;
+  size_t reloc_count, reloc_cap;
+  upb_ImagePatch* patches;  // Pointers to objects that may not be written yet.
+  size_t patch_count, patch_cap;
+  upb_inttable objs;  // Object address -> blob offset.
+  upb_Status* status;
+  jmp_buf err;
+} upb_ImageWriter;
+
+UPB_NORETURN static void upb_ImageWriter_Err(upb_ImageWriter* w,
+                                             const char* msg) {
+  upb_Status_SetErrorMessage(w->status, msg);
+  UPB_LONGJMP(w->err, 1);
+}
+
+// Grows the array `ptr` of `*cap` elements of `elem_size` bytes so that it can
+// hold at least `need` elements.
+static void* upb_ImageWriter_Reserve(upb_ImageWriter* w, void* ptr,
+                                     size_t* cap, size_t need,
+                                     size_t elem_size) {
+  if (need <= *cap) return ptr;
+  size_t new_cap = UPB_MAX(*cap * 2, 64);
+  while (new_cap < need) new_cap *= 2;
+  ptr = upb_Arena_Realloc(w->arena, ptr, *cap * elem_size,
+                          new_cap * elem_size);
+  if (!ptr) upb_ImageWriter_Err(w, "out of memory");
+  *cap = new_cap;
+  return ptr;
+}
+
+// Appends `size` bytes to the blob, copied from `data` or zeroed if `data` is
+// NULL, and returns their offset. Every object is 8-byte aligned.
+static uint32_t upb_ImageWriter_Put(upb_ImageWriter* w, const void* data,
+                                    size_t size) {
+  const size_t ofs = w->blob_size;
+  const size_t padded = UPB_ALIGN_UP(size, 8);
+  if (ofs + padded > UINT32_MAX) upb_ImageWriter_Err(w, "image too large");
+  w->blob = upb_ImageWriter_Reserve(w, w->blob, &w->blob_cap, ofs + padded, 1);
+  memset(w->blob + ofs, 0, padded);
+  if (data) memcpy(w->blob + ofs, data, size);
+  w->blob_size = ofs + padded;
+  return ofs;
+}
+
+static void upb_ImageWriter_AddReloc(upb_ImageWriter* w, uint32_t reloc) {
+  w->relocs = upb_ImageWriter_Reserve(w, w->relocs, &w->reloc_cap,
+                                      w->reloc_count + 1, sizeof(*w->relocs));
+  w->relocs[w->reloc_count++] = reloc;
+}
+
+// Points the pointer slot at blob offset `slot` to blob offset `target`.
+static void upb_ImageWriter_SetPtr(upb_ImageWriter* w, uint32_t slot,
+                                   uint32_t target) {
+  const uintptr_t val = target;
+  memcpy(w->blob + slot, &val, sizeof(val));
+  upb_ImageWriter_AddReloc(w, slot);
+}
+
+// Points the pointer slot at blob offset `slot` to the object at `ptr`, which
+// is looked up once every object has been written.
+static void upb_ImageWriter_PatchPtr(upb_ImageWriter* w, uint32_t slot,
+                                     const void* ptr) {
+  if (!ptr) return;
+  if (ptr == &_kUpb_MiniTable_Empty) {
+    upb_ImageWriter_AddReloc(w, slot | 1);
+    return;
+  }
+  w->patches = upb_ImageWriter_Reserve(w, w->patches, &w->patch_cap,
+                                       w->patch_count + 1, sizeof(*w->patches));
+  w->patches[w->patch_count].target = ptr;
+  w->patches[w->patch_count].slot = slot;
+  w->patch_count++;
+}
+
+static void upb_ImageWriter_AddObject(upb_ImageWriter* w, const void* ptr,
+                                      uint32_t ofs) {
+  if (!upb_inttable_insert(&w->objs, (uintptr_t)ptr, upb_value_uint32(ofs),
+                           w->arena)) {
+    upb_ImageWriter_Err(w, "out of memory");
+  }
+}
+
+static void upb_ImageWriter_PutMessage(upb_ImageWriter* w,
+                                       const upb_MiniTable* m) {
+  upb_MiniTable copy;
+  memcpy(&copy, m, sizeof(copy));
+  copy.subs = NULL;
+  copy.fields = NULL;
+  // The fast table holds function pointers, so it cannot be stored. Without it
+  // the decoder takes the MiniTable path for this message.
+  copy.table_mask = (uint8_t)-1;
+  const uint32_t ofs = upb_ImageWriter_Put(w, &copy, sizeof(copy));
+  upb_ImageWriter_AddObject(w, m, ofs);
+
+  int sub_count = 0;
+  for (int i = 0; i < m->field_count; i++) {
+    const uint16_t index = m->fields[i].UPB_PRIVATE(submsg_index);
+    if (index != kUpb_NoSub && index >= sub_count) sub_count = index + 1;
+  }
+
+  if (m->field_count) {
+    const uint32_t fields =
+        upb_ImageWriter_Put(w, m->fields, m->field_count * sizeof(*m->fields));
+    upb_ImageWriter_SetPtr(w, ofs + offsetof(upb_MiniTable, fields), fields);
+  }
+
+  if (sub_count) {
+    const uint32_t subs =
+        upb_ImageWriter_Put(w, NULL, sub_count * sizeof(*m->subs));
+    upb_ImageWriter_SetPtr(w, ofs + offsetof(upb_MiniTable, subs), subs);
+    for (int i = 0; i < sub_count; i++) {
+      upb_ImageWriter_PatchPtr(w, subs + i * sizeof(*m->subs),
+                               m->subs[i].submsg);
+    }
+  }
+}
+
+static void upb_ImageWriter_PutEnum(upb_ImageWriter* w,
+                                    const upb_MiniTableEnum* e) {
+  const size_t size =
+      sizeof(*e) + (e->mask_limit / 32 + e->value_count) * sizeof(e->data[0]);
+  upb_ImageWriter_AddObject(w, e, upb_ImageWriter_Put(w, e, size));
+}
+
+static void upb_ImageWriter_PutExtension(upb_ImageWriter* w,
+                                         const upb_MiniTableExtension* ext) {
+  upb_MiniTableExtension copy = *ext;
+  copy.extendee = NULL;
+  copy.sub.submsg = NULL;
+  const uint32_t ofs = upb_ImageWriter_Put(w, &copy, sizeof(copy));
+  upb_ImageWriter_AddObject(w, ext, ofs);
+  upb_ImageWriter_PatchPtr(
+      w, ofs + offsetof(upb_MiniTableExtension, extendee), ext->extendee);
+  upb_ImageWriter_PatchPtr(w, ofs + offsetof(upb_MiniTableExtension, sub),
+                           ext->sub.submsg);
+}
+
+// The def builder consumes the MiniTables of a file in the order it creates
+// the defs: messages in pre-order, and closed enums in the order they appear
+// (top-level enums first, then each message's enums before its nested
+// messages'). Extensions are indexed the same way by the file itself.
+typedef struct {
+  uint32_t msgs;   // Blob offset of the upb_MiniTableFile.msgs array.
+  uint32_t enums;  // Blob offset of the upb_MiniTableFile.enums array.
+  int msg_count;
+  int enum_count;
+  int ext_count;
+} upb_ImageFileCursor;
+
+static void upb_ImageWriter_PutEnumDef(upb_ImageWriter* w,
+                                       upb_ImageFileCursor* c,
+                                       const upb_EnumDef* e, bool count_only) {
+  const upb_MiniTableEnum* mt = _upb_EnumDef_MiniTable(e);
+  if (!mt) return;  // Open enums have no MiniTable.
+  if (!count_only) {
+    upb_ImageWriter_PatchPtr(w, c->enums + c->enum_count * sizeof(void*), mt);
+    upb_ImageWriter_PutEnum(w, mt);
+  }
+  c->enum_count++;
+}
+
+static void upb_ImageWriter_PutMessageDef(upb_ImageWriter* w,
+                                          upb_ImageFileCursor* c,
+                                          const upb_MessageDef* m,
+                                          bool count_only) {
+  if (!count_only) {
+    const upb_MiniTable* mt = upb_MessageDef_MiniTable(m);
+    upb_ImageWriter_PatchPtr(w, c->msgs + c->msg_count * sizeof(void*), mt);
+    upb_ImageWriter_PutMessage(w, mt);
+  }
+  c->msg_count++;
+  c->ext_count += upb_MessageDef_NestedExtensionCount(m);
+
+  for (int i = 0; i < upb_MessageDef_NestedEnumCount(m); i++) {
+    upb_ImageWriter_PutEnumDef(w, c, upb_MessageDef_NestedEnum(m, i),
+                               count_only);
+  }
+  for (int i = 0; i < upb_MessageDef_NestedMessageCount(m); i++) {
+    upb_ImageWriter_PutMessageDef(w, c, upb_MessageDef_NestedMessage(m, i),
+                                  count_only);
+  }
+}
+
+static void upb_ImageWriter_WalkFile(upb_ImageWriter* w,
+                                     upb_ImageFileCursor* c,
+                                     const upb_FileDef* f, bool count_only) {
+  c->msg_count = 0;
+  c->enum_count = 0;
+  c->ext_count = upb_FileDef_TopLevelExtensionCount(f);
+  for (int i = 0; i < upb_FileDef_TopLevelEnumCount(f); i++) {
+    upb_ImageWriter_PutEnumDef(w, c, upb_FileDef_TopLevelEnum(f, i),
+                               count_only);
+  }
+  for (int i = 0; i < upb_FileDef_TopLevelMessageCount(f); i++) {
+    upb_ImageWriter_PutMessageDef(w, c, upb_FileDef_TopLevelMessage(f, i),
+                                  count_only);
+  }
+}
+
+// Writes the MiniTables of `f` and returns the blob offset of its
+// upb_MiniTableFile.
+static uint32_t upb_ImageWriter_PutFile(upb_ImageWriter* w,
+                                        const upb_FileDef* f) {
+  upb_ImageFileCursor c;
+  upb_ImageWriter_WalkFile(w, &c, f, true);
+
+  upb_MiniTableFile file = {
+      .msgs = NULL,
+      .enums = NULL,
+      .exts = NULL,
+      .msg_count = c.msg_count,
+      .enum_count = c.enum_count,
+      .ext_count = c.ext_count,
+  };
+  const uint32_t ofs = upb_ImageWriter_Put(w, &file, sizeof(file));
+  const uint32_t msgs = upb_ImageWriter_Put(w, NULL, c.msg_count * sizeof(void*));
+  const uint32_t enums =
+      upb_ImageWriter_Put(w, NULL, c.enum_count * sizeof(void*));
+  const uint32_t exts = upb_ImageWriter_Put(w, NULL, c.ext_count * sizeof(void*));
+  if (c.msg_count) {
+    upb_ImageWriter_SetPtr(w, ofs + offsetof(upb_MiniTableFile, msgs), msgs);
+  }
+  if (c.enum_count) {
+    upb_ImageWriter_SetPtr(w, ofs + offsetof(upb_MiniTableFile, enums), enums);
+  }
+  if (c.ext_count) {
+    upb_ImageWriter_SetPtr(w, ofs + offsetof(upb_MiniTableFile, exts), exts);
+  }
+
+  c.msgs = msgs;
+  c.enums = enums;
+  upb_ImageWriter_WalkFile(w, &c, f, false);
+
+  for (int i = 0; i < c.ext_count; i++) {
+    const upb_MiniTableExtension* ext = _upb_FileDef_ExtensionMiniTable(f, i);
+    upb_ImageWriter_PatchPtr(w, exts + i * sizeof(void*), ext);
+    upb_ImageWriter_PutExtension(w, ext);
+  }
+
+  return ofs;
+}
+
+static void upb_ImageWriter_ResolvePatches(upb_ImageWriter* w) {
+  for (size_t i = 0; i < w->patch_count; i++) {
+    upb_value v;
+    if (!upb_inttable_lookup(&w->objs, (uintptr_t)w->patches[i].target, &v)) {
+      upb_ImageWriter_Err(w, "MiniTable refers to a type outside the image");
+    }
+    upb_ImageWriter_SetPtr(w, w->patches[i].slot, upb_value_getuint32(v));
+  }
+}
+
+static bool upb_ImageWriter_Write(upb_ImageWriter* w, upb_DefPool* pool,
+                                  const upb_StringView* files,
+                                  size_t file_count, uint32_t* layouts) {
+  if (UPB_SETJMP(w->err)) return false;
+
+  for (size_t i = 0; i < file_count; i++) {
+    const UPB_DESC(FileDescriptorProto)* proto =
+        UPB_DESC(FileDescriptorProto_parse_ex)(files[i].data, files[i].size,
+                                               NULL,
+                                               kUpb_DecodeOption_AliasString,
+                                               w->arena);
+    if (!proto) upb_ImageWriter_Err(w, "failed to parse file descriptor");
+
+    const upb_FileDef* f = upb_DefPool_AddFile(pool, proto, w->status);
+    if (!f) UPB_LONGJMP(w->err, 1);
+    layouts[i] = upb_ImageWriter_PutFile(w, f);
+  }
+
+  upb_ImageWriter_ResolvePatches(w);
+  return true;
+}
+
+// Lays out the finished image in a single allocation from `arena`.
+static char* upb_ImageWriter_Finish(upb_ImageWriter* w,
+                                    const upb_StringView* files,
+                                    size_t file_count, const uint32_t* layouts,
+                                    upb_Arena* arena, size_t* size) {
+  const size_t files_ofs = sizeof(upb_DefPoolImage_Header);
+  const size_t relocs_ofs = files_ofs + file_count * sizeof(upb_DefPoolImage_File);
+  const size_t blob_ofs =
+      UPB_ALIGN_UP(relocs_ofs + w->reloc_count * sizeof(uint32_t), 8);
+  size_t total = blob_ofs + w->blob_size;
+  for (size_t i = 0; i < file_count; i++) total += files[i].size;
+  if (total > UINT32_MAX) {
+    upb_Status_SetErrorMessage(w->status, "image too large");
+    return NULL;
+  }
+
+  char* ret = upb_Arena_Malloc(arena, total);
+  if (!ret) {
+    upb_Status_SetErrorMessage(w->status, "out of memory");
+    return NULL;
+  }
+  memset(ret, 0, blob_ofs);
+
+  const upb_DefPoolImage_Header header = {
+      .magic = kUpb_DefPoolImage_Magic,
+      .version = kUpb_DefPoolImage_Version,
+      .ptr_size = sizeof(void*),
+      .file_count = file_count,
+      .reloc_count = w->reloc_count,
+      .blob_offset = blob_ofs,
+      .blob_size = w->blob_size,
+  };
+  memcpy(ret, &header, sizeof(header));
+  if (w->reloc_count) {
+    memcpy(ret + relocs_ofs, w->relocs, w->reloc_count * sizeof(uint32_t));
+  }
+  if (w->blob_size) memcpy(ret + blob_ofs, w->blob, w->blob_size);
+
+  size_t desc_ofs = blob_ofs + w->blob_size;
+  for (size_t i = 0; i < file_count; i++) {
+    const upb_DefPoolImage_File file = {
+        .layout = layouts[i],
+        .descriptor_offset = desc_ofs,
+        .descriptor_size = files[i].size,
+    };
+    memcpy(ret + files_ofs + i * sizeof(file), &file, sizeof(file));
+    if (files[i].size) memcpy(ret + desc_ofs, files[i].data, files[i].size);
+    desc_ofs += files[i].size;
+  }
+
+  *size = total;
+  return ret;
+}
+
+char* upb_DefPoolImage_Build(const upb_StringView* files, size_t file_count,
+                             upb_Arena* arena, size_t* size,
+                             upb_Status* status) {
+  upb_ImageWriter w;
+  memset(&w, 0, sizeof(w));
+  w.status = status;
+  w.arena = upb_Arena_New();
+  upb_DefPool* pool = upb_DefPool_New();
+  uint32_t* layouts =
+      w.arena ? upb_Arena_Malloc(w.arena, UPB_MAX(file_count, 1) *
+                                              sizeof(*layouts))
+              : NULL;
+  char* ret = NULL;
+
+  if (!pool || !layouts || !upb_inttable_init(&w.objs, w.arena)) {
+    upb_Status_SetErrorMessage(status, "out of memory");
+  } else if (upb_ImageWriter_Write(&w, pool, files, file_count, layouts)) {
+    ret = upb_ImageWriter_Finish(&w, files, file_count, layouts, arena, size);
+  }
+
+  if (pool) upb_DefPool_Free(pool);
+  if (w.arena) upb_Arena_Free(w.arena);
+  return ret;
+}
+
+/* Loader *********************************************************************/
+
+static bool upb_DefPoolImage_Malformed(upb_Status* status) {
+  upb_Status_SetErrorMessage(status, "malformed def pool image");
+  return false;
+}
+
+// Patches the pointers in `blob`, a copy of the blob of an image. Returns
+// false if a reloc is out of bounds.
+static bool upb_DefPoolImage_Relocate(char* blob, uint32_t blob_size,
+                                      const char* relocs,
+                                      uint32_t reloc_count) {
+  for (uint32_t i = 0; i < reloc_count; i++) {
+    uint32_t reloc;
+    memcpy(&reloc, relocs + i * sizeof(reloc), sizeof(reloc));
+    const uint32_t slot = reloc & ~(uint32_t)1;
+    if (slot % sizeof(void*) != 0 ||
+        (uint64_t)slot + sizeof(void*) > blob_size) {
+      return false;
+    }
+
+    const void* ptr;
+    if (reloc & 1) {
+      ptr = &_kUpb_MiniTable_Empty;
+    } else {
+      uintptr_t target;
+      memcpy(&target, blob + slot, sizeof(target));
+      if (target >= blob_size) return false;
+      ptr = blob + target;
+    }
+    memcpy(blob + slot, &ptr, sizeof(ptr));
+  }
+  return true;
+}
+
+bool upb_DefPool_LoadImage(upb_DefPool* s, const char* image, size_t size,
+                           upb_Status* status) {
+  upb_DefPoolImage_Header h;
+  if (size < sizeof(h)) return upb_DefPoolImage_Malformed(status);
+  memcpy(&h, image, sizeof(h));
+
+  if (h.magic != kUpb_DefPoolImage_Magic ||
+      h.version != kUpb_DefPoolImage_Version || h.ptr_size != sizeof(void*)) {
+    upb_Status_SetErrorMessage(status,
+                               "def pool image was built for a different "
+                               "platform or version of upb");
+    return false;
+  }
+
+  const uint64_t files_ofs = sizeof(h);
+  const uint64_t relocs_ofs =
+      files_ofs + (uint64_t)h.file_count * sizeof(upb_DefPoolImage_File);
+  const uint64_t relocs_end =
+      relocs_ofs + (uint64_t)h.reloc_count * sizeof(uint32_t);
+  if (relocs_end > h.blob_offset ||
+      (uint64_t)h.blob_offset + h.blob_size > size) {
+    return upb_DefPoolImage_Malformed(status);
+  }
+
+  upb_Arena* tmp = upb_Arena_New();
+  UPB_DESC(FileDescriptorProto)** protos =
+      tmp ? upb_Arena_Malloc(tmp, UPB_MAX(h.file_count, 1) * sizeof(*protos))
+          : NULL;
+  upb_DefPoolImage_File* files =
+      tmp ? upb_Arena_Malloc(tmp, UPB_MAX(h.file_count, 1) * sizeof(*files))
+          : NULL;
+  char* blob = NULL;
+  bool ok = false;
+
+  if (!protos || !files) {
+    upb_Status_SetErrorMessage(status, "out of memory");
+    goto done;
+  }
+
+  // Parse and check every file up front so that a bad image leaves the pool
+  // untouched.
+  for (uint32_t i = 0; i < h.file_count; i++) {
+    upb_DefPoolImage_File* file = &files[i];
+    memcpy(file, image + files_ofs + i * sizeof(*file), sizeof(*file));
+    if ((uint64_t)file->descriptor_offset + file->descriptor_size > size ||
+        file->layout % sizeof(void*) != 0 ||
+        (uint64_t)file->layout + sizeof(upb_MiniTableFile) > h.blob_size) {
+      upb_DefPoolImage_Malformed(status);
+      goto done;
+    }
+
+    protos[i] = UPB_DESC(FileDescriptorProto_parse_ex)(
+        image + file->descriptor_offset, file->descriptor_size, NULL,
+        kUpb_DecodeOption_AliasString, tmp);
+    if (!protos[i]) {
+      upb_DefPoolImage_Malformed(status);
+      goto done;
+    }
+
+    const upb_StringView name = UPB_DESC(FileDescriptorProto_name)(protos[i]);
+    if (upb_DefPool_FindFileByNameWithSize(s, name.data, name.size)) {
+      upb_Status_SetErrorFormat(status,
+                                "file " UPB_STRINGVIEW_FORMAT
+                                " is already in the pool",
+                                UPB_STRINGVIEW_ARGS(name));
+      goto done;
+    }
+  }
+
+  // The blob is copied so that the image may be read-only and short-lived.
+  blob = upb_Arena_Malloc(_upb_DefPool_Arena(s), UPB_MAX(h.blob_size, 1));
+  if (!blob) {
+    upb_Status_SetErrorMessage(status, "out of memory");
+    goto done;
+  }
+  memcpy(blob, image + h.blob_offset, h.blob_size);
+  if (!upb_DefPoolImage_Relocate(blob, h.blob_size, image + relocs_ofs,
+                                 h.reloc_count)) {
+    upb_DefPoolImage_Malformed(status);
+    goto done;
+  }
+
+  for (uint32_t i = 0; i < h.file_count; i++) {
+    const upb_MiniTableFile* layout =
+        (const upb_MiniTableFile*)(blob + files[i].layout);
+    if (!_upb_DefPool_AddFile(s, protos[i], layout, status)) goto done;
+  }
+  ok = true;
+
+done:
+  if (tmp) upb_Arena_Free(tmp);
+  return ok;
+}
@@ -0,0 +1,80 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google LLC.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// A def pool image is a flat, relocatable snapshot of the MiniTables of a
+// set of files together with their serialized FileDescriptorProtos. Loading
+// an image into a upb_DefPool copies the MiniTables into the pool's arena and
+// patches their pointers, so it skips building MiniTables from mini
+// descriptors (upb/mini_descriptor/decode.c) and linking them. The image does
+// not need to outlive the call that loads it, so it can be mmap()ed read-only
+// straight from a file.
+//
+// Images contain native structs and are only portable between builds of upb
+// with the same pointer size, byte order and MiniTable layout. A loader that
+// does not recognize an image rejects it.
+
+#ifndef UPB_REFLECTION_DEF_POOL_IMAGE_H_
+#define UPB_REFLECTION_DEF_POOL_IMAGE_H_
+
+#include <stddef.h>
+
+#include "upb/base/status.h"
+#include "upb/base/string_view.h"
+#include "upb/mem/arena.h"
+#include "upb/reflection/def_pool.h"
+
+// Must be last.
+#include "upb/port/def.inc"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Builds the serialized FileDescriptorProtos `files` into a fresh pool and
+// returns an image of it, allocated from `arena`. `files` must be in
+// dependency order and must include every dependency. Returns NULL and sets
+// `status` on failure.
+UPB_API char* upb_DefPoolImage_Build(const upb_StringView* files,
+                                     size_t file_count, upb_Arena* arena,
+                                     size_t* size, upb_Status* status);
+
+// Adds every file in `image` to `s`. None of the files may already be in `s`.
+// Returns false and sets `status` if the image is malformed or a file fails
+// to load; files that were loaded before the failure stay in the pool.
+UPB_API bool upb_DefPool_LoadImage(upb_DefPool* s, const char* image,
+                                   size_t size, upb_Status* status);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#include "upb/port/undef.inc"
+
+#endif /* UPB_REFLECTION_DEF_POOL_IMAGE_H_ */
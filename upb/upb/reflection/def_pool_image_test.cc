@@ -0,0 +1,379 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google LLC.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "upb/reflection/def_pool_image.h"
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "google/protobuf/descriptor.upb.h"
+#include "upb/base/status.hpp"
+#include "upb/mem/arena.hpp"
+#include "upb/mini_table/enum.h"
+#include "upb/mini_table/internal/field.h"
+#include "upb/mini_table/internal/message.h"
+#include "upb/mini_table/message.h"
+#include "upb/reflection/def.hpp"
+#include "upb/wire/decode.h"
+#include "upb/wire/encode.h"
+
+namespace {
+
+upb_StringView ToView(const char* str) {
+  return upb_StringView_FromString(str);
+}
+
+google_protobuf_FieldDescriptorProto* AddField(
+    google_protobuf_DescriptorProto* msg, const char* name, int number,
+    int label, int type, const char* type_name, upb_Arena* arena) {
+  google_protobuf_FieldDescriptorProto* f =
+      google_protobuf_DescriptorProto_add_field(msg, arena);
+  google_protobuf_FieldDescriptorProto_set_name(f, ToView(name));
+  google_protobuf_FieldDescriptorProto_set_number(f, number);
+  google_protobuf_FieldDescriptorProto_set_label(f, label);
+  google_protobuf_FieldDescriptorProto_set_type(f, type);
+  if (type_name) {
+    google_protobuf_FieldDescriptorProto_set_type_name(f, ToView(type_name));
+  }
+  return f;
+}
+
+void AddEnum(google_protobuf_EnumDescriptorProto* e, const char* name,
+             const char* v0, const char* v1, int v1_number, upb_Arena* arena) {
+  google_protobuf_EnumDescriptorProto_set_name(e, ToView(name));
+  google_protobuf_EnumValueDescriptorProto* v =
+      google_protobuf_EnumDescriptorProto_add_value(e, arena);
+  google_protobuf_EnumValueDescriptorProto_set_name(v, ToView(v0));
+  google_protobuf_EnumValueDescriptorProto_set_number(v, 0);
+  v = google_protobuf_EnumDescriptorProto_add_value(e, arena);
+  google_protobuf_EnumValueDescriptorProto_set_name(v, ToView(v1));
+  google_protobuf_EnumValueDescriptorProto_set_number(v, v1_number);
+}
+
+std::string Serialize(const google_protobuf_FileDescriptorProto* file,
+                      upb_Arena* arena) {
+  size_t size;
+  char* data =
+      google_protobuf_FileDescriptorProto_serialize(file, arena, &size);
+  return std::string(data, size);
+}
+
+constexpr int kOptional = google_protobuf_FieldDescriptorProto_LABEL_OPTIONAL;
+constexpr int kRepeated = google_protobuf_FieldDescriptorProto_LABEL_REPEATED;
+constexpr int kInt32 = google_protobuf_FieldDescriptorProto_TYPE_INT32;
+constexpr int kString = google_protobuf_FieldDescriptorProto_TYPE_STRING;
+constexpr int kMessage = google_protobuf_FieldDescriptorProto_TYPE_MESSAGE;
+constexpr int kEnum = google_protobuf_FieldDescriptorProto_TYPE_ENUM;
+
+// Two proto2 files, equivalent to:
+//
+//   // a.proto
+//   package image_test;
+//   message Sub { optional int32 x = 1; }
+//   enum Color { RED = 0; BLUE = 5; }
+//
+//   // b.proto
+//   import "a.proto";
+//   package image_test;
+//   message Top {
+//     optional Sub sub = 1;
+//     optional Color color = 2;
+//     repeated string names = 3;
+//     message Nested {
+//       enum Kind { K0 = 0; K1 = 1; }
+//       optional Top top = 1;
+//       optional Kind kind = 2;
+//       extend Top { optional int32 nested_ext = 101; }
+//     }
+//     optional Nested nested = 4;
+//     map<string, Sub> entries = 5;
+//     extensions 100 to 199;
+//   }
+//   extend Top { optional Sub ext = 100; }
+std::vector<std::string> TestFiles() {
+  upb::Arena arena;
+  upb_Arena* a = arena.ptr();
+  std::vector<std::string> ret;
+
+  google_protobuf_FileDescriptorProto* file_a =
+      google_protobuf_FileDescriptorProto_new(a);
+  google_protobuf_FileDescriptorProto_set_name(file_a, ToView("a.proto"));
+  google_protobuf_FileDescriptorProto_set_package(file_a, ToView("image_test"));
+  google_protobuf_DescriptorProto* sub =
+      google_protobuf_FileDescriptorProto_add_message_type(file_a, a);
+  google_protobuf_DescriptorProto_set_name(sub, ToView("Sub"));
+  AddField(sub, "x", 1, kOptional, kInt32, nullptr, a);
+  AddEnum(google_protobuf_FileDescriptorProto_add_enum_type(file_a, a),
+          "Color", "RED", "BLUE", 5, a);
+  ret.push_back(Serialize(file_a, a));
+
+  google_protobuf_FileDescriptorProto* file_b =
+      google_protobuf_FileDescriptorProto_new(a);
+  google_protobuf_FileDescriptorProto_set_name(file_b, ToView("b.proto"));
+  google_protobuf_FileDescriptorProto_set_package(file_b, ToView("image_test"));
+  google_protobuf_FileDescriptorProto_add_dependency(file_b, ToView("a.proto"),
+                                                     a);
+  google_protobuf_DescriptorProto* top =
+      google_protobuf_FileDescriptorProto_add_message_type(file_b, a);
+  google_protobuf_DescriptorProto_set_name(top, ToView("Top"));
+  AddField(top, "sub", 1, kOptional, kMessage, ".image_test.Sub", a);
+  AddField(top, "color", 2, kOptional, kEnum, ".image_test.Color", a);
+  AddField(top, "names", 3, kRepeated, kString, nullptr, a);
+  AddField(top, "nested", 4, kOptional, kMessage, ".image_test.Top.Nested", a);
+  AddField(top, "entries", 5, kRepeated, kMessage,
+           ".image_test.Top.EntriesEntry", a);
+  google_protobuf_DescriptorProto_ExtensionRange* range =
+      google_protobuf_DescriptorProto_add_extension_range(top, a);
+  google_protobuf_DescriptorProto_ExtensionRange_set_start(range, 100);
+  google_protobuf_DescriptorProto_ExtensionRange_set_end(range, 200);
+
+  google_protobuf_DescriptorProto* nested =
+      google_protobuf_DescriptorProto_add_nested_type(top, a);
+  google_protobuf_DescriptorProto_set_name(nested, ToView("Nested"));
+  AddField(nested, "top", 1, kOptional, kMessage, ".image_test.Top", a);
+  AddField(nested, "kind", 2, kOptional, kEnum, ".image_test.Top.Nested.Kind",
+           a);
+  AddEnum(google_protobuf_DescriptorProto_add_enum_type(nested, a), "Kind",
+          "K0", "K1", 1, a);
+  google_protobuf_FieldDescriptorProto* nested_ext =
+      google_protobuf_DescriptorProto_add_extension(nested, a);
+  google_protobuf_FieldDescriptorProto_set_name(nested_ext,
+                                                ToView("nested_ext"));
+  google_protobuf_FieldDescriptorProto_set_number(nested_ext, 101);
+  google_protobuf_FieldDescriptorProto_set_label(nested_ext, kOptional);
+  google_protobuf_FieldDescriptorProto_set_type(nested_ext, kInt32);
+  google_protobuf_FieldDescriptorProto_set_extendee(nested_ext,
+                                                    ToView(".image_test.Top"));
+
+  google_protobuf_DescriptorProto* entry =
+      google_protobuf_DescriptorProto_add_nested_type(top, a);
+  google_protobuf_DescriptorProto_set_name(entry, ToView("EntriesEntry"));
+  google_protobuf_MessageOptions_set_map_entry(
+      google_protobuf_DescriptorProto_mutable_options(entry, a), true);
+  AddField(entry, "key", 1, kOptional, kString, nullptr, a);
+  AddField(entry, "value", 2, kOptional, kMessage, ".image_test.Sub", a);
+
+  google_protobuf_FieldDescriptorProto* ext =
+      google_protobuf_FileDescriptorProto_add_extension(file_b, a);
+  google_protobuf_FieldDescriptorProto_set_name(ext, ToView("ext"));
+  google_protobuf_FieldDescriptorProto_set_number(ext, 100);
+  google_protobuf_FieldDescriptorProto_set_label(ext, kOptional);
+  google_protobuf_FieldDescriptorProto_set_type(ext, kMessage);
+  google_protobuf_FieldDescriptorProto_set_type_name(ext,
+                                                     ToView(".image_test.Sub"));
+  google_protobuf_FieldDescriptorProto_set_extendee(ext,
+                                                    ToView(".image_test.Top"));
+  ret.push_back(Serialize(file_b, a));
+
+  return ret;
+}
+
+std::string BuildImage(const std::vector<std::string>& files,
+                       upb::Status* status) {
+  std::vector<upb_StringView> views;
+  for (const auto& file : files) {
+    views.push_back(upb_StringView_FromDataAndSize(file.data(), file.size()));
+  }
+  upb::Arena arena;
+  size_t size;
+  char* image = upb_DefPoolImage_Build(views.data(), views.size(), arena.ptr(),
+                                       &size, status->ptr());
+  return image ? std::string(image, size) : std::string();
+}
+
+void LoadFiles(upb::DefPool* pool, const std::vector<std::string>& files) {
+  upb::Arena arena;
+  for (const auto& file : files) {
+    google_protobuf_FileDescriptorProto* proto =
+        google_protobuf_FileDescriptorProto_parse(file.data(), file.size(),
+                                                  arena.ptr());
+    ASSERT_NE(proto, nullptr);
+    upb::Status status;
+    ASSERT_TRUE(pool->AddFile(proto, &status)) << status.error_message();
+  }
+}
+
+// Parses `payload` as image_test.Top with the MiniTables of `pool` and
+// serializes it again.
+std::string RoundTrip(upb::DefPool* pool, const std::string& payload) {
+  upb::Arena arena;
+  upb::MessageDefPtr m = pool->FindMessageByName("image_test.Top");
+  EXPECT_TRUE(m);
+  const upb_MiniTable* mt = m.mini_table();
+  upb_Message* msg = upb_Message_New(mt, arena.ptr());
+  upb_DecodeStatus decoded =
+      upb_Decode(payload.data(), payload.size(), msg, mt,
+                 upb_DefPool_ExtensionRegistry(pool->ptr()), 0, arena.ptr());
+  EXPECT_EQ(decoded, kUpb_DecodeStatus_Ok);
+  char* data;
+  size_t size;
+  upb_EncodeStatus encoded =
+      upb_Encode(msg, mt, kUpb_EncodeOption_Deterministic, arena.ptr(), &data,
+                 &size);
+  EXPECT_EQ(encoded, kUpb_EncodeStatus_Ok);
+  return std::string(data, size);
+}
+
+TEST(DefPoolImageTest, LoadMatchesBuiltPool) {
+  std::vector<std::string> files = TestFiles();
+  upb::Status status;
+  std::string image = BuildImage(files, &status);
+  ASSERT_FALSE(image.empty()) << status.error_message();
+
+  upb::DefPool built;
+  LoadFiles(&built, files);
+
+  upb::DefPool loaded;
+  EXPECT_TRUE(upb_DefPool_LoadImage(loaded.ptr(), image.data(), image.size(),
+                                    status.ptr()))
+      << status.error_message();
+  // The image only has to live for the duration of the load.
+  image.assign(image.size(), '\0');
+
+  for (const char* name : {"image_test.Sub", "image_test.Top",
+                           "image_test.Top.Nested",
+                           "image_test.Top.EntriesEntry"}) {
+    const upb_MiniTable* want =
+        built.FindMessageByName(name).mini_table();
+    upb::MessageDefPtr m = loaded.FindMessageByName(name);
+    ASSERT_TRUE(m) << name;
+    const upb_MiniTable* got = m.mini_table();
+    EXPECT_EQ(got->field_count, want->field_count);
+    for (int i = 0; i < got->field_count; i++) {
+      const upb_MiniTableField* f = upb_MiniTable_GetFieldByIndex(got, i);
+      EXPECT_EQ(memcmp(f, upb_MiniTable_GetFieldByIndex(want, i), sizeof(*f)),
+                0)
+          << name << " field " << i;
+
+      // Sub-tables must point at the loaded pool's own MiniTables.
+      upb::FieldDefPtr field = m.FindFieldByNumber(f->number);
+      if (field.message_type()) {
+        EXPECT_EQ(upb_MiniTable_GetSubMessageTable(got, f),
+                  field.message_type().mini_table());
+      }
+    }
+  }
+
+  const upb_MiniTable* top =
+      loaded.FindMessageByName("image_test.Top").mini_table();
+  const upb_MiniTableEnum* color = upb_MiniTable_GetSubEnumTable(
+      top, upb_MiniTable_FindFieldByNumber(top, 2));
+  ASSERT_NE(color, nullptr);
+  EXPECT_TRUE(upb_MiniTableEnum_CheckValue(color, 5));
+  EXPECT_FALSE(upb_MiniTableEnum_CheckValue(color, 3));
+
+  upb::FieldDefPtr ext = loaded.FindExtensionByName("image_test.ext");
+  ASSERT_TRUE(ext);
+  EXPECT_EQ(ext.message_type(), loaded.FindMessageByName("image_test.Sub"));
+  EXPECT_TRUE(loaded.FindExtensionByName("image_test.Top.Nested.nested_ext"));
+}
+
+TEST(DefPoolImageTest, ParsesLikeBuiltPool) {
+  std::vector<std::string> files = TestFiles();
+  upb::Status status;
+  std::string image = BuildImage(files, &status);
+  ASSERT_FALSE(image.empty()) << status.error_message();
+
+  upb::DefPool built;
+  LoadFiles(&built, files);
+  upb::DefPool loaded;
+  ASSERT_TRUE(upb_DefPool_LoadImage(loaded.ptr(), image.data(), image.size(),
+                                    status.ptr()))
+      << status.error_message();
+
+  // sub {x: 7} color: BLUE names: "a" nested {top {names: "b"} kind: K1}
+  // entries {key: "k" value {x: 1}} [ext] {x: 9} [nested_ext]: 3
+  // and an unknown (closed) enum value for color.
+  const std::string payload(
+      "\x0a\x02\x08\x07"
+      "\x10\x05"
+      "\x1a\x01"
+      "a"
+      "\x22\x07\x0a\x03\x1a\x01"
+      "b"
+      "\x10\x01"
+      "\x2a\x07\x0a\x01"
+      "k"
+      "\x12\x02\x08\x01"
+      "\xa2\x06\x02\x08\x09"
+      "\xa8\x06\x03"
+      "\x10\x03",
+      37);
+  std::string want = RoundTrip(&built, payload);
+  EXPECT_EQ(RoundTrip(&loaded, payload), want);
+  EXPECT_NE(want.find("\xa2\x06\x02\x08\x09"), std::string::npos);
+}
+
+TEST(DefPoolImageTest, RejectsFilesAlreadyInPool) {
+  std::vector<std::string> files = TestFiles();
+  upb::Status status;
+  std::string image = BuildImage(files, &status);
+  ASSERT_FALSE(image.empty()) << status.error_message();
+
+  upb::DefPool pool;
+  LoadFiles(&pool, {files[0]});
+  EXPECT_FALSE(upb_DefPool_LoadImage(pool.ptr(), image.data(), image.size(),
+                                     status.ptr()));
+  EXPECT_NE(std::string(status.error_message()).find("already"),
+            std::string::npos);
+  EXPECT_FALSE(pool.FindMessageByName("image_test.Top"));
+}
+
+TEST(DefPoolImageTest, RejectsMalformedImages) {
+  upb::Status status;
+  std::string image = BuildImage(TestFiles(), &status);
+  ASSERT_FALSE(image.empty()) << status.error_message();
+
+  for (size_t size : {size_t{0}, size_t{12}, image.size() / 2}) {
+    upb::DefPool pool;
+    EXPECT_FALSE(
+        upb_DefPool_LoadImage(pool.ptr(), image.data(), size, status.ptr()));
+  }
+
+  std::string bad_magic = image;
+  bad_magic[0] ^= 1;
+  upb::DefPool pool;
+  EXPECT_FALSE(upb_DefPool_LoadImage(pool.ptr(), bad_magic.data(),
+                                     bad_magic.size(), status.ptr()));
+  EXPECT_FALSE(pool.FindMessageByName("image_test.Sub"));
+}
+
+TEST(DefPoolImageTest, BuildReportsUnresolvedDependencies) {
+  std::vector<std::string> files = TestFiles();
+  upb::Status status;
+  EXPECT_TRUE(BuildImage({files[1]}, &status).empty());
+  EXPECT_NE(std::string(status.error_message()).find("a.proto"),
+            std::string::npos);
+}
+
+}  // namespace
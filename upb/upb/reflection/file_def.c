@@ -351,6 +351,17 @@ void _upb_FileDef_Create(upb_DefBuilder* ctx,
     _upb_FieldDef_Resolve(ctx, file->package, f);
   }
 
+  // Messages of this file may refer to each other in cycles, so iterate to a
+  // fixed point.  Messages from dependencies are already final.
+  bool changed;
+  do {
+    changed = false;
+    for (int i = 0; i < file->top_lvl_msg_count; i++) {
+      upb_MessageDef* m = (upb_MessageDef*)upb_FileDef_TopLevelMessage(file, i);
+      changed |= _upb_MessageDef_PropagateRequired(m);
+    }
+  } while (changed);
+
   for (int i = 0; i < file->top_lvl_msg_count; i++) {
     upb_MessageDef* m = (upb_MessageDef*)upb_FileDef_TopLevelMessage(file, i);
     _upb_MessageDef_CreateMiniTable(ctx, (upb_MessageDef*)m);
@@ -42,6 +42,15 @@ extern "C" {
 
 upb_MessageDef* _upb_MessageDef_At(const upb_MessageDef* m, int i);
 bool _upb_MessageDef_InMessageSet(const upb_MessageDef* m);
+
+// Whether a message of this type can be missing a required field: one of its
+// own, or one of a sub-message or extension at any depth.  False means that
+// required field checks can skip the message entirely.
+bool _upb_MessageDef_ReachesRequired(const upb_MessageDef* m);
+
+// Whether any sub-message or extension of this type can be missing a required
+// field, i.e. whether required field checks need to look past this message.
+bool _upb_MessageDef_SubMessagesReachRequired(const upb_MessageDef* m);
 bool _upb_MessageDef_Insert(upb_MessageDef* m, const char* name, size_t size,
                             upb_value v, upb_Arena* a);
 void _upb_MessageDef_InsertField(upb_DefBuilder* ctx, upb_MessageDef* m,
@@ -52,6 +61,12 @@ void _upb_MessageDef_LinkMiniTable(upb_DefBuilder* ctx,
                                    const upb_MessageDef* m);
 void _upb_MessageDef_Resolve(upb_DefBuilder* ctx, upb_MessageDef* m);
 
+// Marks |m| and its nested messages as reaching required fields through
+// their sub-messages, based on what is known so far.  Returns true if
+// anything changed, in which case it should be called again for all messages
+// of the file until it returns false.
+bool _upb_MessageDef_PropagateRequired(upb_MessageDef* m);
+
 // Allocate and initialize an array of |n| message defs.
 upb_MessageDef* _upb_MessageDefs_New(
     upb_DefBuilder* ctx, int n, const UPB_DESC(DescriptorProto) * const* protos,
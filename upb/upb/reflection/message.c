@@ -32,9 +32,11 @@
 
 #include <string.h>
 
+#include "upb/collections/array.h"
 #include "upb/collections/map.h"
 #include "upb/hash/common.h"
 #include "upb/message/accessors.h"
+#include "upb/message/internal/accessors.h"
 #include "upb/message/message.h"
 #include "upb/mini_table/field.h"
 #include "upb/reflection/def.h"
@@ -127,57 +129,73 @@ void upb_Message_ClearByDef(upb_Message* msg, const upb_MessageDef* m) {
   upb_Message_Clear(msg, upb_MessageDef_MiniTable(m));
 }
 
-bool upb_Message_Next(const upb_Message* msg, const upb_MessageDef* m,
-                      const upb_DefPool* ext_pool, const upb_FieldDef** out_f,
-                      upb_MessageValue* out_val, size_t* iter) {
+// Returns true if a non-extension field is set, deciding from the hasbit, the
+// oneof case or the field's own storage.  An unset field therefore costs a
+// single load and its default value is never materialized.
+static bool _upb_Message_NonExtensionFieldIsSet(
+    const upb_Message* msg, const upb_MiniTableField* field) {
+  if (field->presence > 0) return _upb_hasbit_field(msg, field);
+  if (field->presence < 0) {
+    return _upb_getoneofcase_field(msg, field) == field->number;
+  }
+  const void* ptr = _upb_MiniTableField_GetConstPtr(msg, field);
+  switch (upb_FieldMode_Get(field)) {
+    case kUpb_FieldMode_Map: {
+      const upb_Map* map = *(const upb_Map* const*)ptr;
+      return map && upb_Map_Size(map) != 0;
+    }
+    case kUpb_FieldMode_Array: {
+      const upb_Array* arr = *(const upb_Array* const*)ptr;
+      return arr && upb_Array_Size(arr) != 0;
+    }
+    case kUpb_FieldMode_Scalar:
+      return _upb_MiniTable_ValueIsNonZero(ptr, field);
+  }
+  UPB_UNREACHABLE();
+}
+
+size_t upb_Message_NextBatch(const upb_Message* msg, const upb_MessageDef* m,
+                             const upb_DefPool* ext_pool,
+                             const upb_FieldDef** out_f,
+                             upb_MessageValue* out_val, size_t max,
+                             size_t* iter) {
   size_t i = *iter;
   size_t n = upb_MessageDef_FieldCount(m);
-  UPB_UNUSED(ext_pool);
+  size_t found = 0;
 
-  // Iterate over normal fields, returning the first one that is set.
-  while (++i < n) {
+  // Iterate over normal fields, returning the ones that are set.
+  while (found < max && ++i < n) {
     const upb_FieldDef* f = upb_MessageDef_Field(m, i);
     const upb_MiniTableField* field = upb_FieldDef_MiniTable(f);
-    upb_MessageValue val = upb_Message_GetFieldByDef(msg, f);
+    if (!_upb_Message_NonExtensionFieldIsSet(msg, field)) continue;
 
-    // Skip field if unset or empty.
-    if (upb_MiniTableField_HasPresence(field)) {
-      if (!upb_Message_HasFieldByDef(msg, f)) continue;
-    } else {
-      switch (upb_FieldMode_Get(field)) {
-        case kUpb_FieldMode_Map:
-          if (!val.map_val || upb_Map_Size(val.map_val) == 0) continue;
-          break;
-        case kUpb_FieldMode_Array:
-          if (!val.array_val || upb_Array_Size(val.array_val) == 0) continue;
-          break;
-        case kUpb_FieldMode_Scalar:
-          if (!_upb_MiniTable_ValueIsNonZero(&val, field)) continue;
-          break;
-      }
-    }
-
-    *out_val = val;
-    *out_f = f;
-    *iter = i;
-    return true;
+    // The field is set, so its storage holds the value.
+    memset(&out_val[found], 0, sizeof(out_val[found]));
+    _upb_MiniTable_CopyFieldData(
+        &out_val[found], _upb_MiniTableField_GetConstPtr(msg, field), field);
+    out_f[found++] = f;
   }
 
-  if (ext_pool) {
+  if (ext_pool && i >= n) {
     // Return any extensions that are set.
     size_t count;
     const upb_Message_Extension* ext = _upb_Message_Getexts(msg, &count);
-    if (i - n < count) {
-      ext += count - 1 - (i - n);
-      memcpy(out_val, &ext->data, sizeof(*out_val));
-      *out_f = upb_DefPool_FindExtensionByMiniTable(ext_pool, ext->ext);
-      *iter = i;
-      return true;
+    while (found < max && i - n < count) {
+      const upb_Message_Extension* e = ext + count - 1 - (i - n);
+      memcpy(&out_val[found], &e->data, sizeof(out_val[found]));
+      out_f[found++] = upb_DefPool_FindExtensionByMiniTable(ext_pool, e->ext);
+      if (found < max) i++;
     }
   }
 
   *iter = i;
-  return false;
+  return found;
+}
+
+bool upb_Message_Next(const upb_Message* msg, const upb_MessageDef* m,
+                      const upb_DefPool* ext_pool, const upb_FieldDef** out_f,
+                      upb_MessageValue* out_val, size_t* iter) {
+  return upb_Message_NextBatch(msg, m, ext_pool, out_f, out_val, 1, iter) == 1;
 }
 
 bool _upb_Message_DiscardUnknown(upb_Message* msg, const upb_MessageDef* m,
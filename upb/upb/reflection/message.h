@@ -94,6 +94,23 @@ bool upb_Message_Next(const upb_Message* msg, const upb_MessageDef* m,
                       const upb_DefPool* ext_pool, const upb_FieldDef** f,
                       upb_MessageValue* val, size_t* iter);
 
+// Like upb_Message_Next(), but fills up to |max| present fields into |f| and
+// |val| per call and returns how many it wrote.  A return value less than
+// |max| means the iteration is complete.
+//
+// size_t iter = kUpb_Message_Begin;
+// const upb_FieldDef *f[16];
+// upb_MessageValue val[16];
+// size_t n;
+// do {
+//   n = upb_Message_NextBatch(msg, m, ext_pool, f, val, 16, &iter);
+//   for (size_t i = 0; i < n; i++) process_field(f[i], val[i]);
+// } while (n == 16);
+size_t upb_Message_NextBatch(const upb_Message* msg, const upb_MessageDef* m,
+                             const upb_DefPool* ext_pool,
+                             const upb_FieldDef** f, upb_MessageValue* val,
+                             size_t max, size_t* iter);
+
 // Clears all unknown field data from this message and all submessages.
 UPB_API bool upb_Message_DiscardUnknown(upb_Message* msg,
                                         const upb_MessageDef* m, int maxdepth);
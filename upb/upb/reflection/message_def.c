@@ -83,6 +83,8 @@ struct upb_MessageDef {
   int nested_ext_count;
   bool in_message_set;
   bool is_sorted;
+  bool has_required;
+  bool subs_reach_required;
   upb_WellKnown well_known_type;
 #if UINTPTR_MAX == 0xffffffff
   uint32_t padding;  // Increase size to a multiple of 8.
@@ -333,6 +335,14 @@ bool _upb_MessageDef_InMessageSet(const upb_MessageDef* m) {
   return m->in_message_set;
 }
 
+bool _upb_MessageDef_ReachesRequired(const upb_MessageDef* m) {
+  return m->has_required || m->subs_reach_required;
+}
+
+bool _upb_MessageDef_SubMessagesReachRequired(const upb_MessageDef* m) {
+  return m->subs_reach_required;
+}
+
 const upb_FieldDef* upb_MessageDef_FindFieldByName(const upb_MessageDef* m,
                                                    const char* name) {
   return upb_MessageDef_FindFieldByNameWithSize(m, name, strlen(name));
@@ -370,11 +380,18 @@ static upb_MiniTable* _upb_MessageDef_MakeMiniTable(upb_DefBuilder* ctx,
 }
 
 void _upb_MessageDef_Resolve(upb_DefBuilder* ctx, upb_MessageDef* m) {
+  m->has_required = false;
   for (int i = 0; i < m->field_count; i++) {
     upb_FieldDef* f = (upb_FieldDef*)upb_MessageDef_Field(m, i);
     _upb_FieldDef_Resolve(ctx, m->full_name, f);
+    if (upb_FieldDef_Label(f) == kUpb_Label_Required) m->has_required = true;
   }
 
+  // Any extension may carry required fields, so extendable messages always
+  // count as reaching them.  The rest is filled in by
+  // _upb_MessageDef_PropagateRequired() once the whole file is resolved.
+  m->subs_reach_required = m->ext_range_count > 0;
+
   m->in_message_set = false;
   for (int i = 0; i < upb_MessageDef_NestedExtensionCount(m); i++) {
     upb_FieldDef* ext = (upb_FieldDef*)upb_MessageDef_NestedExtension(m, i);
@@ -394,6 +411,24 @@ void _upb_MessageDef_Resolve(upb_DefBuilder* ctx, upb_MessageDef* m) {
   }
 }
 
+bool _upb_MessageDef_PropagateRequired(upb_MessageDef* m) {
+  bool changed = false;
+  for (int i = 0; !m->subs_reach_required && i < m->field_count; i++) {
+    const upb_MessageDef* sub =
+        upb_FieldDef_MessageSubDef(upb_MessageDef_Field(m, i));
+    if (sub && _upb_MessageDef_ReachesRequired(sub)) {
+      m->subs_reach_required = true;
+      changed = true;
+    }
+  }
+
+  for (int i = 0; i < upb_MessageDef_NestedMessageCount(m); i++) {
+    upb_MessageDef* n = (upb_MessageDef*)upb_MessageDef_NestedMessage(m, i);
+    changed |= _upb_MessageDef_PropagateRequired(n);
+  }
+  return changed;
+}
+
 void _upb_MessageDef_InsertField(upb_DefBuilder* ctx, upb_MessageDef* m,
                                  const upb_FieldDef* f) {
   const int32_t field_number = upb_FieldDef_Number(f);
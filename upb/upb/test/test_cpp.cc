@@ -36,14 +36,17 @@
 #include <iostream>
 #include <set>
 #include <sstream>
+#include <vector>
 
 #include "google/protobuf/timestamp.upb.h"
 #include "google/protobuf/timestamp.upbdefs.h"
 #include "gtest/gtest.h"
+#include "upb/collections/array.h"
 #include "upb/json/decode.h"
 #include "upb/json/encode.h"
 #include "upb/reflection/def.h"
 #include "upb/reflection/def.hpp"
+#include "upb/reflection/message.h"
 #include "upb/test/test_cpp.upb.h"
 #include "upb/test/test_cpp.upbdefs.h"
 
@@ -70,6 +73,59 @@ TEST(Cpp, Iteration) {
   EXPECT_EQ(oneof_count, md.oneof_count());
 }
 
+TEST(Cpp, MessageNext) {
+  upb::DefPool defpool;
+  upb::Arena arena;
+  upb::MessageDefPtr md(upb_test_TestMessage_getmsgdef(defpool.ptr()));
+  upb_test_TestMessage* msg = upb_test_TestMessage_new(arena.ptr());
+
+  // Set to zero, but explicitly present.
+  upb_test_TestMessage_set_i32(msg, 0);
+  // Allocated but empty, so not present.
+  upb_test_TestMessage_resize_r_i32(msg, 0, arena.ptr());
+  upb_test_TestMessage_add_r_str(msg, upb_StringView_FromString("x"),
+                                 arena.ptr());
+  upb_test_TestMessage* sub =
+      upb_test_TestMessage_mutable_msg(msg, arena.ptr());
+  upb_test_TestMessage_set_i32(sub, 7);
+
+  const upb_Message* m = (const upb_Message*)msg;
+  size_t iter = kUpb_Message_Begin;
+  const upb_FieldDef* f;
+  upb_MessageValue val;
+  std::vector<int> numbers;
+  while (upb_Message_Next(m, md.ptr(), defpool.ptr(), &f, &val, &iter)) {
+    numbers.push_back(upb_FieldDef_Number(f));
+    switch (upb_FieldDef_Number(f)) {
+      case 1:
+        EXPECT_EQ(0, val.int32_val);
+        break;
+      case 4:
+        EXPECT_EQ(1, upb_Array_Size(val.array_val));
+        break;
+      case 5:
+        EXPECT_EQ(7, upb_test_TestMessage_i32(
+                         (const upb_test_TestMessage*)val.msg_val));
+        break;
+    }
+  }
+  EXPECT_EQ(numbers, std::vector<int>({1, 4, 5}));
+
+  // The batch variant visits the same fields, however they are split up.
+  std::vector<int> batched;
+  const upb_FieldDef* fs[2];
+  upb_MessageValue vals[2];
+  size_t n;
+  iter = kUpb_Message_Begin;
+  do {
+    n = upb_Message_NextBatch(m, md.ptr(), defpool.ptr(), fs, vals, 2, &iter);
+    for (size_t i = 0; i < n; i++) {
+      batched.push_back(upb_FieldDef_Number(fs[i]));
+    }
+  } while (n == 2);
+  EXPECT_EQ(batched, numbers);
+}
+
 TEST(Cpp, InlinedArena2) {
   upb::InlinedArena<64> arena;
   upb_Arena_Malloc(arena.ptr(), sizeof(int));
@@ -35,6 +35,8 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <string>
 
 #include "gtest/gtest.h"
 #include "google/protobuf/test_messages_proto2.upb.h"
@@ -44,6 +46,7 @@
 #include "upb/collections/array.h"
 #include "upb/mem/arena.hpp"
 #include "upb/test/test.upb.h"
+#include "upb/wire/decode.h"
 
 // Must be last.
 #include "upb/port/def.inc"
@@ -828,6 +831,142 @@ TEST(GeneratedCode, TestRepeated) {
   upb_Arena_Free(arena);
 }
 
+TEST(GeneratedCode, RepeatedSubMessageRoundTrip) {
+  upb::Arena arena;
+  protobuf_test_messages_proto3_TestAllTypesProto3* msg =
+      protobuf_test_messages_proto3_TestAllTypesProto3_new(arena.ptr());
+  for (int i = 0; i < 100; i++) {
+    protobuf_test_messages_proto3_TestAllTypesProto3_NestedMessage* nested =
+        protobuf_test_messages_proto3_TestAllTypesProto3_add_repeated_nested_message(
+            msg, arena.ptr());
+    protobuf_test_messages_proto3_TestAllTypesProto3_NestedMessage_set_a(nested,
+                                                                         i);
+    protobuf_test_messages_proto3_TestAllTypesProto3* child =
+        protobuf_test_messages_proto3_TestAllTypesProto3_NestedMessage_mutable_corecursive(
+            nested, arena.ptr());
+    for (int j = 0; j < i % 3; j++) {
+      protobuf_test_messages_proto3_TestAllTypesProto3_NestedMessage_set_a(
+          protobuf_test_messages_proto3_TestAllTypesProto3_add_repeated_nested_message(
+              child, arena.ptr()),
+          j);
+    }
+  }
+
+  size_t size;
+  char* serialized = protobuf_test_messages_proto3_TestAllTypesProto3_serialize(
+      msg, arena.ptr(), &size);
+  ASSERT_NE(serialized, nullptr);
+
+  // Parsing the data twice merges it, appending to the same repeated field.
+  protobuf_test_messages_proto3_TestAllTypesProto3* parsed =
+      protobuf_test_messages_proto3_TestAllTypesProto3_parse(serialized, size,
+                                                             arena.ptr());
+  ASSERT_NE(parsed, nullptr);
+  ASSERT_EQ(
+      upb_Decode(serialized, size, parsed,
+                 &protobuf_test_messages_proto3_TestAllTypesProto3_msg_init,
+                 nullptr, 0, arena.ptr()),
+      kUpb_DecodeStatus_Ok);
+
+  size_t count;
+  protobuf_test_messages_proto3_TestAllTypesProto3_NestedMessage* const*
+      elems =
+          protobuf_test_messages_proto3_TestAllTypesProto3_mutable_repeated_nested_message(
+              parsed, &count);
+  ASSERT_EQ(count, 200);
+  for (size_t i = 0; i < count; i++) {
+    EXPECT_EQ(
+        protobuf_test_messages_proto3_TestAllTypesProto3_NestedMessage_a(
+            elems[i]),
+        static_cast<int32_t>(i % 100));
+    const protobuf_test_messages_proto3_TestAllTypesProto3* child =
+        protobuf_test_messages_proto3_TestAllTypesProto3_NestedMessage_corecursive(
+            elems[i]);
+    size_t child_count;
+    protobuf_test_messages_proto3_TestAllTypesProto3_repeated_nested_message(
+        child, &child_count);
+    EXPECT_EQ(child_count, (i % 100) % 3);
+  }
+
+  // Elements that were decoded together must still be independent messages.
+  protobuf_test_messages_proto3_TestAllTypesProto3_NestedMessage_set_a(elems[0],
+                                                                       -1);
+  protobuf_test_messages_proto3_TestAllTypesProto3_NestedMessage_clear_corecursive(
+      elems[0]);
+  EXPECT_EQ(
+      protobuf_test_messages_proto3_TestAllTypesProto3_NestedMessage_a(elems[1]),
+      1);
+  EXPECT_TRUE(
+      protobuf_test_messages_proto3_TestAllTypesProto3_NestedMessage_has_corecursive(
+          elems[1]));
+}
+
+static void AppendVarint(std::string* out, uint64_t val) {
+  do {
+    char byte = val & 0x7f;
+    val >>= 7;
+    if (val) byte |= 0x80;
+    out->push_back(byte);
+  } while (val);
+}
+
+static void AppendDouble(std::string* out, double val) {
+  uint64_t bits;
+  memcpy(&bits, &val, sizeof(bits));
+  for (int i = 0; i < 8; i++) out->push_back((bits >> (8 * i)) & 0xff);
+}
+
+TEST(GeneratedCode, RepeatedMixedPackedAndUnpacked) {
+  // repeated_int32 (31) and repeated_double (42) encoded as a packed run, then
+  // unpacked elements, then another packed run.  The decoder sizes arrays from
+  // the first run it sees; later runs must append rather than overwrite.
+  std::string packed_varints, packed_doubles;
+  for (int i = 0; i < 50; i++) {
+    AppendVarint(&packed_varints, i * 1000);
+    AppendDouble(&packed_doubles, i * 1000);
+  }
+  std::string data;
+  for (int run = 0; run < 3; run++) {
+    if (run == 1) {
+      for (int i = 0; i < 50; i++) {
+        AppendVarint(&data, (31 << 3) | 0);
+        AppendVarint(&data, i * 1000);
+        AppendVarint(&data, (42 << 3) | 1);
+        AppendDouble(&data, i * 1000);
+      }
+      continue;
+    }
+    AppendVarint(&data, (31 << 3) | 2);
+    AppendVarint(&data, packed_varints.size());
+    data.append(packed_varints);
+    AppendVarint(&data, (42 << 3) | 2);
+    AppendVarint(&data, packed_doubles.size());
+    data.append(packed_doubles);
+  }
+
+  upb::Arena arena;
+  protobuf_test_messages_proto3_TestAllTypesProto3* msg =
+      protobuf_test_messages_proto3_TestAllTypesProto3_parse(
+          data.data(), data.size(), arena.ptr());
+  ASSERT_NE(msg, nullptr);
+
+  size_t size;
+  const int32_t* varints =
+      protobuf_test_messages_proto3_TestAllTypesProto3_repeated_int32(msg,
+                                                                      &size);
+  ASSERT_EQ(size, 150);
+  for (size_t i = 0; i < size; i++) {
+    EXPECT_EQ(varints[i], static_cast<int32_t>((i % 50) * 1000));
+  }
+  const double* doubles =
+      protobuf_test_messages_proto3_TestAllTypesProto3_repeated_double(msg,
+                                                                       &size);
+  ASSERT_EQ(size, 150);
+  for (size_t i = 0; i < size; i++) {
+    EXPECT_EQ(doubles[i], static_cast<double>((i % 50) * 1000));
+  }
+}
+
 TEST(GeneratedCode, Issue9440) {
   upb::Arena arena;
   upb_test_HelloRequest* msg = upb_test_HelloRequest_new(arena.ptr());
@@ -0,0 +1,701 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google LLC.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "upb/text/decode.h"
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "upb/collections/array.h"
+#include "upb/collections/map.h"
+#include "upb/io/string.h"
+#include "upb/io/tokenizer.h"
+#include "upb/io/zero_copy_input_stream.h"
+#include "upb/reflection/message.h"
+#include "upb/wire/encode.h"
+
+// Must be last.
+#include "upb/port/def.inc"
+
+typedef struct {
+  upb_Tokenizer* t;
+  upb_Arena* arena;  // For the message data.
+  upb_Arena* tmp;    // For the tokenizer and scratch strings.
+  const upb_DefPool* ext_pool;
+  upb_Status* status;
+  int options;
+  int depth;
+  jmp_buf err;
+} txtdec;
+
+// A NULL message def means the fields are being skipped.
+static void txtdec_fields(txtdec* d, upb_Message* msg, const upb_MessageDef* m,
+                          char close);
+
+/* Input stream ***************************************************************/
+
+// The tokenizer reads the flat buffer first and then asks its stream for more,
+// so we hand it a stream that is always at EOF.
+
+static const void* txtdec_EmptyStream_Next(upb_ZeroCopyInputStream* z,
+                                           size_t* count, upb_Status* status) {
+  UPB_UNUSED(z);
+  UPB_UNUSED(status);
+  *count = 0;
+  return NULL;
+}
+
+static void txtdec_EmptyStream_BackUp(upb_ZeroCopyInputStream* z,
+                                      size_t count) {
+  UPB_UNUSED(z);
+  UPB_UNUSED(count);
+}
+
+static bool txtdec_EmptyStream_Skip(upb_ZeroCopyInputStream* z,
+                                    size_t count) {
+  UPB_UNUSED(z);
+  return count == 0;
+}
+
+static size_t txtdec_EmptyStream_ByteCount(const upb_ZeroCopyInputStream* z) {
+  UPB_UNUSED(z);
+  return 0;
+}
+
+static const _upb_ZeroCopyInputStream_VTable txtdec_EmptyStream_vtable = {
+    txtdec_EmptyStream_Next,
+    txtdec_EmptyStream_BackUp,
+    txtdec_EmptyStream_Skip,
+    txtdec_EmptyStream_ByteCount,
+};
+
+/* Errors and tokens **********************************************************/
+
+UPB_NORETURN static void txtdec_err(txtdec* d, const char* msg) {
+  upb_Status_SetErrorFormat(d->status, "Error parsing text format @%d:%d: %s",
+                            upb_Tokenizer_Line(d->t) + 1,
+                            upb_Tokenizer_Column(d->t) + 1, msg);
+  UPB_LONGJMP(d->err, 1);
+}
+
+UPB_PRINTF(2, 3)
+UPB_NORETURN static void txtdec_errf(txtdec* d, const char* fmt, ...) {
+  va_list argp;
+  upb_Status_SetErrorFormat(d->status, "Error parsing text format @%d:%d: ",
+                            upb_Tokenizer_Line(d->t) + 1,
+                            upb_Tokenizer_Column(d->t) + 1);
+  va_start(argp, fmt);
+  upb_Status_VAppendErrorFormat(d->status, fmt, argp);
+  va_end(argp);
+  UPB_LONGJMP(d->err, 1);
+}
+
+static void txtdec_oom(txtdec* d, bool ok) {
+  if (!ok) txtdec_err(d, "Out of memory");
+}
+
+static void txtdec_next(txtdec* d) {
+  upb_Status status;
+  upb_Status_Clear(&status);
+  if (!upb_Tokenizer_Next(d->t, &status) && !upb_Status_IsOk(&status)) {
+    // The tokenizer's message already carries its (0-based) position.
+    upb_Status_SetErrorFormat(d->status, "Error parsing text format: %s",
+                              upb_Status_ErrorMessage(&status));
+    UPB_LONGJMP(d->err, 1);
+  }
+}
+
+static upb_TokenType txtdec_type(txtdec* d) { return upb_Tokenizer_Type(d->t); }
+
+static const char* txtdec_text(txtdec* d) { return upb_Tokenizer_TextData(d->t); }
+
+static bool txtdec_issym(txtdec* d, char ch) {
+  return txtdec_type(d) == kUpb_TokenType_Symbol && txtdec_text(d)[0] == ch;
+}
+
+static bool txtdec_trysym(txtdec* d, char ch) {
+  if (!txtdec_issym(d, ch)) return false;
+  txtdec_next(d);
+  return true;
+}
+
+static void txtdec_sym(txtdec* d, char ch) {
+  if (!txtdec_trysym(d, ch)) {
+    txtdec_errf(d, "Expected \"%c\", found \"%s\".", ch, txtdec_text(d));
+  }
+}
+
+static bool txtdec_isident(txtdec* d, const char* lit) {
+  return txtdec_type(d) == kUpb_TokenType_Identifier &&
+         strcmp(txtdec_text(d), lit) == 0;
+}
+
+// Case-insensitive comparison of the current identifier against a lower-case
+// literal, for "inf"/"nan" and friends.
+static bool txtdec_isident_nocase(txtdec* d, const char* lit) {
+  if (txtdec_type(d) != kUpb_TokenType_Identifier) return false;
+  const char* text = txtdec_text(d);
+  for (; *lit; text++, lit++) {
+    char ch = *text;
+    if (ch >= 'A' && ch <= 'Z') ch += 'a' - 'A';
+    if (ch != *lit) return false;
+  }
+  return *text == '\0';
+}
+
+static upb_StringView txtdec_copy(txtdec* d, upb_StringView str,
+                                  upb_Arena* arena) {
+  char* data = upb_Arena_Malloc(arena, str.size + 1);
+  txtdec_oom(d, data != NULL);
+  if (str.size) memcpy(data, str.data, str.size);
+  data[str.size] = '\0';
+  return upb_StringView_FromDataAndSize(data, str.size);
+}
+
+/* Scalars ********************************************************************/
+
+static uint64_t txtdec_uint(txtdec* d, uint64_t max) {
+  uint64_t val;
+  if (txtdec_type(d) != kUpb_TokenType_Integer) {
+    txtdec_errf(d, "Expected integer, got: %s", txtdec_text(d));
+  }
+  if (!upb_Parse_Integer(txtdec_text(d), max, &val)) {
+    txtdec_errf(d, "Integer out of range (%s)", txtdec_text(d));
+  }
+  txtdec_next(d);
+  return val;
+}
+
+// Parses an optionally negated integer in [-max - 1, max].
+static int64_t txtdec_int(txtdec* d, int64_t max) {
+  bool neg = txtdec_trysym(d, '-');
+  uint64_t val = txtdec_uint(d, neg ? (uint64_t)max + 1 : (uint64_t)max);
+  if (!neg) return (int64_t)val;
+  return val == 0 ? 0 : -(int64_t)(val - 1) - 1;
+}
+
+static double txtdec_double(txtdec* d) {
+  bool neg = txtdec_trysym(d, '-');
+  double val;
+  uint64_t u;
+
+  switch (txtdec_type(d)) {
+    case kUpb_TokenType_Integer:
+      if (upb_Parse_Integer(txtdec_text(d), UINT64_MAX, &u)) {
+        val = (double)u;
+      } else {
+        val = upb_Parse_Float(txtdec_text(d));
+      }
+      break;
+    case kUpb_TokenType_Float:
+      val = upb_Parse_Float(txtdec_text(d));
+      break;
+    case kUpb_TokenType_Identifier:
+      if (txtdec_isident_nocase(d, "inf") ||
+          txtdec_isident_nocase(d, "infinity")) {
+        val = INFINITY;
+      } else if (txtdec_isident_nocase(d, "nan")) {
+        val = NAN;
+      } else {
+        txtdec_errf(d, "Expected double, got: %s", txtdec_text(d));
+      }
+      break;
+    default:
+      txtdec_errf(d, "Expected double, got: %s", txtdec_text(d));
+  }
+
+  txtdec_next(d);
+  return neg ? -val : val;
+}
+
+static bool txtdec_bool(txtdec* d) {
+  if (txtdec_type(d) == kUpb_TokenType_Integer) {
+    return txtdec_uint(d, 1) != 0;
+  }
+
+  bool val;
+  if (txtdec_isident(d, "true") || txtdec_isident(d, "True") ||
+      txtdec_isident(d, "t")) {
+    val = true;
+  } else if (txtdec_isident(d, "false") || txtdec_isident(d, "False") ||
+             txtdec_isident(d, "f")) {
+    val = false;
+  } else {
+    txtdec_errf(d, "Invalid value for boolean field: %s", txtdec_text(d));
+  }
+  txtdec_next(d);
+  return val;
+}
+
+static int32_t txtdec_enum(txtdec* d, const upb_FieldDef* f) {
+  const upb_EnumDef* e = upb_FieldDef_EnumSubDef(f);
+
+  if (txtdec_type(d) == kUpb_TokenType_Identifier) {
+    const upb_EnumValueDef* ev = upb_EnumDef_FindValueByNameWithSize(
+        e, txtdec_text(d), upb_Tokenizer_TextSize(d->t));
+    if (!ev) {
+      txtdec_errf(d, "Unknown enumeration value of \"%s\" for field \"%s\".",
+                  txtdec_text(d), upb_FieldDef_Name(f));
+    }
+    txtdec_next(d);
+    return upb_EnumValueDef_Number(ev);
+  }
+
+  int32_t val = (int32_t)txtdec_int(d, INT32_MAX);
+  if (upb_EnumDef_IsClosed(e) && !upb_EnumDef_CheckNumber(e, val)) {
+    txtdec_errf(d, "Unknown enumeration value of \"%" PRId32
+                   "\" for field \"%s\".",
+                val, upb_FieldDef_Name(f));
+  }
+  return val;
+}
+
+// Adjacent string literals are concatenated, as in C.
+static upb_StringView txtdec_string(txtdec* d) {
+  if (txtdec_type(d) != kUpb_TokenType_String) {
+    txtdec_errf(d, "Expected string, got: %s", txtdec_text(d));
+  }
+
+  upb_StringView ret = upb_Parse_String(txtdec_text(d), d->arena);
+  txtdec_next(d);
+  if (txtdec_type(d) != kUpb_TokenType_String) return ret;
+
+  upb_String buf;
+  txtdec_oom(d, upb_String_Init(&buf, d->tmp) &&
+                    upb_String_Append(&buf, ret.data, ret.size));
+  do {
+    upb_StringView more = upb_Parse_String(txtdec_text(d), d->tmp);
+    txtdec_oom(d, upb_String_Append(&buf, more.data, more.size));
+    txtdec_next(d);
+  } while (txtdec_type(d) == kUpb_TokenType_String);
+
+  return txtdec_copy(d,
+                     upb_StringView_FromDataAndSize(upb_String_Data(&buf),
+                                                    upb_String_Size(&buf)),
+                     d->arena);
+}
+
+static upb_MessageValue txtdec_scalar(txtdec* d, const upb_FieldDef* f) {
+  upb_MessageValue val;
+
+  switch (upb_FieldDef_CType(f)) {
+    case kUpb_CType_Bool:
+      val.bool_val = txtdec_bool(d);
+      break;
+    case kUpb_CType_Float:
+      val.float_val = (float)txtdec_double(d);
+      break;
+    case kUpb_CType_Double:
+      val.double_val = txtdec_double(d);
+      break;
+    case kUpb_CType_Int32:
+      val.int32_val = (int32_t)txtdec_int(d, INT32_MAX);
+      break;
+    case kUpb_CType_Int64:
+      val.int64_val = txtdec_int(d, INT64_MAX);
+      break;
+    case kUpb_CType_UInt32:
+      val.uint32_val = (uint32_t)txtdec_uint(d, UINT32_MAX);
+      break;
+    case kUpb_CType_UInt64:
+      val.uint64_val = txtdec_uint(d, UINT64_MAX);
+      break;
+    case kUpb_CType_Enum:
+      val.int32_val = txtdec_enum(d, f);
+      break;
+    case kUpb_CType_String:
+    case kUpb_CType_Bytes:
+      val.str_val = txtdec_string(d);
+      break;
+    default:
+      UPB_UNREACHABLE();
+  }
+
+  return val;
+}
+
+/* Field names ****************************************************************/
+
+// Reads the contents of "[...]" after the opening bracket: an extension name,
+// or a type URL for an expanded Any. The result lives in the tmp arena.
+static upb_StringView txtdec_bracketname(txtdec* d) {
+  upb_String name;
+  txtdec_oom(d, upb_String_Init(&name, d->tmp));
+
+  while (!txtdec_trysym(d, ']')) {
+    if (txtdec_type(d) != kUpb_TokenType_Identifier && !txtdec_issym(d, '.') &&
+        !txtdec_issym(d, '/') && !txtdec_issym(d, '-')) {
+      txtdec_errf(d, "Expected identifier, got: %s", txtdec_text(d));
+    }
+    txtdec_oom(d, upb_String_Append(&name, txtdec_text(d),
+                                    upb_Tokenizer_TextSize(d->t)));
+    txtdec_next(d);
+  }
+
+  return upb_StringView_FromDataAndSize(upb_String_Data(&name),
+                                        upb_String_Size(&name));
+}
+
+static const upb_FieldDef* txtdec_findfield(const upb_MessageDef* m,
+                                            const char* name, size_t size) {
+  const upb_FieldDef* f = upb_MessageDef_FindFieldByNameWithSize(m, name, size);
+  if (f) return f;
+
+  // Groups are also written using the name of their message type, which only
+  // differs from the field name in capitalization.
+  int n = upb_MessageDef_FieldCount(m);
+  for (int i = 0; i < n; i++) {
+    f = upb_MessageDef_Field(m, i);
+    if (upb_FieldDef_Type(f) != kUpb_FieldType_Group) continue;
+    const char* type_name = upb_MessageDef_Name(upb_FieldDef_MessageSubDef(f));
+    if (strlen(type_name) == size && memcmp(type_name, name, size) == 0) {
+      return f;
+    }
+  }
+  return NULL;
+}
+
+/* Values *********************************************************************/
+
+// Parses "{ fields }" or "< fields >".
+static void txtdec_msg(txtdec* d, upb_Message* msg, const upb_MessageDef* m) {
+  char close;
+  if (txtdec_trysym(d, '{')) {
+    close = '}';
+  } else if (txtdec_trysym(d, '<')) {
+    close = '>';
+  } else {
+    txtdec_errf(d, "Expected \"{\", found \"%s\".", txtdec_text(d));
+  }
+
+  if (--d->depth < 0) txtdec_err(d, "Message nesting too deep");
+  txtdec_fields(d, msg, m, close);
+  d->depth++;
+  txtdec_sym(d, close);
+}
+
+static upb_Message* txtdec_newmsg(txtdec* d, const upb_MessageDef* m) {
+  upb_Message* msg = upb_Message_New(upb_MessageDef_MiniTable(m), d->arena);
+  txtdec_oom(d, msg != NULL);
+  return msg;
+}
+
+static void txtdec_mapentry(txtdec* d, upb_Message* msg,
+                            const upb_FieldDef* f) {
+  const upb_MessageDef* entry_m = upb_FieldDef_MessageSubDef(f);
+  const upb_FieldDef* key_f = upb_MessageDef_FindFieldByNumber(entry_m, 1);
+  const upb_FieldDef* val_f = upb_MessageDef_FindFieldByNumber(entry_m, 2);
+  upb_Message* entry = txtdec_newmsg(d, entry_m);
+
+  txtdec_msg(d, entry, entry_m);
+
+  upb_MessageValue key = upb_Message_GetFieldByDef(entry, key_f);
+  upb_MessageValue val = upb_Message_GetFieldByDef(entry, val_f);
+  if (upb_FieldDef_IsSubMessage(val_f) && !val.msg_val) {
+    val.msg_val = txtdec_newmsg(d, upb_FieldDef_MessageSubDef(val_f));
+  }
+
+  upb_Map* map = upb_Message_Mutable(msg, f, d->arena).map;
+  txtdec_oom(d, map && upb_Map_Set(map, key, val, d->arena));
+}
+
+static void txtdec_element(txtdec* d, upb_Message* msg,
+                           const upb_FieldDef* f) {
+  if (upb_FieldDef_IsMap(f)) {
+    txtdec_mapentry(d, msg, f);
+    return;
+  }
+
+  upb_MessageValue val;
+  if (upb_FieldDef_IsSubMessage(f)) {
+    const upb_MessageDef* subm = upb_FieldDef_MessageSubDef(f);
+    val.msg_val = txtdec_newmsg(d, subm);
+    txtdec_msg(d, (upb_Message*)val.msg_val, subm);
+  } else {
+    val = txtdec_scalar(d, f);
+  }
+
+  upb_Array* arr = upb_Message_Mutable(msg, f, d->arena).array;
+  txtdec_oom(d, arr && upb_Array_Append(arr, val, d->arena));
+}
+
+static void txtdec_checksingular(txtdec* d, const upb_Message* msg,
+                                 const upb_FieldDef* f) {
+  const upb_OneofDef* o = upb_FieldDef_RealContainingOneof(f);
+  if (o) {
+    const upb_FieldDef* other = upb_Message_WhichOneof(msg, o);
+    if (other && other != f) {
+      txtdec_errf(d,
+                  "Field \"%s\" is specified along with field \"%s\", another "
+                  "member of oneof \"%s\".",
+                  upb_FieldDef_Name(f), upb_FieldDef_Name(other),
+                  upb_OneofDef_Name(o));
+    }
+  }
+  if (upb_FieldDef_HasPresence(f) && upb_Message_HasFieldByDef(msg, f)) {
+    txtdec_errf(d, "Non-repeated field \"%s\" is specified multiple times.",
+                upb_FieldDef_Name(f));
+  }
+}
+
+static void txtdec_fieldval(txtdec* d, upb_Message* msg,
+                            const upb_FieldDef* f) {
+  // The colon is optional before a message value.
+  if (upb_FieldDef_IsSubMessage(f)) {
+    txtdec_trysym(d, ':');
+  } else {
+    txtdec_sym(d, ':');
+  }
+
+  if (upb_FieldDef_IsRepeated(f)) {
+    // Either a single element or a list: "[a, b, c]".
+    if (!txtdec_trysym(d, '[')) {
+      txtdec_element(d, msg, f);
+    } else if (!txtdec_trysym(d, ']')) {
+      do {
+        txtdec_element(d, msg, f);
+      } while (txtdec_trysym(d, ','));
+      txtdec_sym(d, ']');
+    }
+    return;
+  }
+
+  txtdec_checksingular(d, msg, f);
+
+  if (upb_FieldDef_IsSubMessage(f)) {
+    upb_Message* submsg = upb_Message_Mutable(msg, f, d->arena).msg;
+    txtdec_oom(d, submsg != NULL);
+    txtdec_msg(d, submsg, upb_FieldDef_MessageSubDef(f));
+  } else {
+    upb_MessageValue val = txtdec_scalar(d, f);
+    txtdec_oom(d, upb_Message_SetFieldByDef(msg, f, val, d->arena));
+  }
+}
+
+// Parses the body of "[type.googleapis.com/pkg.Msg] { ... }" into the Any
+// `msg`, storing the serialized value.
+static void txtdec_anyval(txtdec* d, upb_Message* msg, const upb_MessageDef* m,
+                          upb_StringView url) {
+  const upb_FieldDef* type_url_f = upb_MessageDef_FindFieldByNumber(m, 1);
+  const upb_FieldDef* value_f = upb_MessageDef_FindFieldByNumber(m, 2);
+  const char* name = url.data + url.size;
+  while (name > url.data && name[-1] != '/') name--;
+  size_t name_size = url.data + url.size - name;
+
+  const upb_MessageDef* value_m =
+      d->ext_pool ? upb_DefPool_FindMessageByNameWithSize(d->ext_pool, name,
+                                                          name_size)
+                  : NULL;
+  if (!value_m && (d->options & UPB_TXTDEC_IGNOREUNKNOWN)) {
+    txtdec_trysym(d, ':');
+    txtdec_msg(d, NULL, NULL);
+    return;
+  }
+  if (!value_m) {
+    txtdec_errf(d, "Could not find type \"" UPB_STRINGVIEW_FORMAT
+                   "\" stored in google.protobuf.Any.",
+                UPB_STRINGVIEW_ARGS(url));
+  }
+  txtdec_checksingular(d, msg, type_url_f);
+
+  txtdec_trysym(d, ':');
+  upb_Message* value = txtdec_newmsg(d, value_m);
+  txtdec_msg(d, value, value_m);
+
+  upb_MessageValue val;
+  char* buf;
+  size_t size;
+  if (upb_Encode(value, upb_MessageDef_MiniTable(value_m),
+                 kUpb_EncodeOption_Deterministic, d->arena, &buf,
+                 &size) != kUpb_EncodeStatus_Ok) {
+    txtdec_err(d, "Error serializing google.protobuf.Any value");
+  }
+  val.str_val = txtdec_copy(d, url, d->arena);
+  txtdec_oom(d, upb_Message_SetFieldByDef(msg, type_url_f, val, d->arena));
+  val.str_val = upb_StringView_FromDataAndSize(buf, size);
+  txtdec_oom(d, upb_Message_SetFieldByDef(msg, value_f, val, d->arena));
+}
+
+/* Skipping *******************************************************************/
+
+static void txtdec_skipscalar(txtdec* d) {
+  txtdec_trysym(d, '-');
+  switch (txtdec_type(d)) {
+    case kUpb_TokenType_String:
+      while (txtdec_type(d) == kUpb_TokenType_String) txtdec_next(d);
+      break;
+    case kUpb_TokenType_Identifier:
+    case kUpb_TokenType_Integer:
+    case kUpb_TokenType_Float:
+      txtdec_next(d);
+      break;
+    default:
+      txtdec_errf(d, "Expected value, got: %s", txtdec_text(d));
+  }
+}
+
+static void txtdec_skipelement(txtdec* d) {
+  if (txtdec_issym(d, '{') || txtdec_issym(d, '<')) {
+    txtdec_msg(d, NULL, NULL);
+  } else {
+    txtdec_skipscalar(d);
+  }
+}
+
+// Skips the value of an unknown field, whose type we do not know.
+static void txtdec_skipfieldval(txtdec* d) {
+  bool colon = txtdec_trysym(d, ':');
+  if (txtdec_trysym(d, '[')) {
+    if (!txtdec_trysym(d, ']')) {
+      do {
+        txtdec_skipelement(d);
+      } while (txtdec_trysym(d, ','));
+      txtdec_sym(d, ']');
+    }
+  } else if (colon) {
+    txtdec_skipelement(d);
+  } else {
+    // Only message values may omit the colon.
+    txtdec_msg(d, NULL, NULL);
+  }
+}
+
+/* Messages *******************************************************************/
+
+static void txtdec_field(txtdec* d, upb_Message* msg, const upb_MessageDef* m) {
+  const upb_FieldDef* f = NULL;
+
+  if (txtdec_trysym(d, '[')) {
+    upb_StringView name = txtdec_bracketname(d);
+    if (memchr(name.data, '/', name.size)) {
+      if (m && upb_MessageDef_WellKnownType(m) == kUpb_WellKnown_Any) {
+        txtdec_anyval(d, msg, m, name);
+        goto done;
+      }
+      if (m) {
+        txtdec_errf(d, "Type URL \"" UPB_STRINGVIEW_FORMAT
+                       "\" is only allowed in google.protobuf.Any.",
+                    UPB_STRINGVIEW_ARGS(name));
+      }
+    } else if (m && d->ext_pool) {
+      f = upb_DefPool_FindExtensionByNameWithSize(d->ext_pool, name.data,
+                                                  name.size);
+      if (f && upb_FieldDef_ContainingType(f) != m) {
+        txtdec_errf(
+            d, "Extension \"%s\" extends message %s, but was seen in message %s.",
+            upb_FieldDef_FullName(f),
+            upb_MessageDef_FullName(upb_FieldDef_ContainingType(f)),
+            upb_MessageDef_FullName(m));
+      }
+    }
+    if (!f && m && !(d->options & UPB_TXTDEC_IGNOREUNKNOWN)) {
+      txtdec_errf(d, "Extension \"" UPB_STRINGVIEW_FORMAT
+                     "\" is not defined or is not an extension of \"%s\".",
+                  UPB_STRINGVIEW_ARGS(name), upb_MessageDef_FullName(m));
+    }
+  } else {
+    if (txtdec_type(d) != kUpb_TokenType_Identifier) {
+      txtdec_errf(d, "Expected identifier, got: %s", txtdec_text(d));
+    }
+    if (m) {
+      f = txtdec_findfield(m, txtdec_text(d), upb_Tokenizer_TextSize(d->t));
+      if (!f && !(d->options & UPB_TXTDEC_IGNOREUNKNOWN)) {
+        txtdec_errf(d, "Message type \"%s\" has no field named \"%s\".",
+                    upb_MessageDef_FullName(m), txtdec_text(d));
+      }
+    }
+    txtdec_next(d);
+  }
+
+  if (f) {
+    txtdec_fieldval(d, msg, f);
+  } else {
+    txtdec_skipfieldval(d);
+  }
+
+done:
+  // Fields may be separated by an optional ';' or ','.
+  if (!txtdec_trysym(d, ';')) txtdec_trysym(d, ',');
+}
+
+// Parses fields until the `close` symbol, or to the end of input if `close`
+// is '\0'. Does not consume `close`.
+static void txtdec_fields(txtdec* d, upb_Message* msg, const upb_MessageDef* m,
+                          char close) {
+  while (close ? !txtdec_issym(d, close)
+               : txtdec_type(d) != kUpb_TokenType_End) {
+    if (txtdec_type(d) == kUpb_TokenType_End) {
+      txtdec_errf(d, "Expected \"%c\" before end of input.", close);
+    }
+    txtdec_field(d, msg, m);
+  }
+}
+
+static bool upb_TextDecoder_Decode(txtdec* const d, upb_Message* const msg,
+                                   const upb_MessageDef* const m) {
+  if (UPB_SETJMP(d->err)) return false;
+
+  txtdec_next(d);
+  txtdec_fields(d, msg, m, '\0');
+  return true;
+}
+
+bool upb_TextDecode(const char* buf, size_t size, upb_Message* msg,
+                    const upb_MessageDef* m, const upb_DefPool* ext_pool,
+                    int options, upb_Arena* arena, upb_Status* status) {
+  upb_ZeroCopyInputStream empty = {&txtdec_EmptyStream_vtable};
+  txtdec d;
+
+  d.tmp = upb_Arena_New();
+  if (!d.tmp) {
+    upb_Status_SetErrorMessage(status, "Out of memory");
+    return false;
+  }
+  d.t = upb_Tokenizer_New(buf, size, &empty,
+                          kUpb_TokenizerOption_CommentStyleShell |
+                              kUpb_TokenizerOption_AllowFAfterFloat,
+                          d.tmp);
+  if (!d.t) {
+    upb_Arena_Free(d.tmp);
+    upb_Status_SetErrorMessage(status, "Out of memory");
+    return false;
+  }
+  d.arena = arena;
+  d.ext_pool = ext_pool;
+  d.status = status;
+  d.options = options;
+  d.depth = 64;
+
+  bool ok = upb_TextDecoder_Decode(&d, msg, m);
+  upb_Arena_Free(d.tmp);
+  return ok;
+}
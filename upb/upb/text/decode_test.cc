@@ -0,0 +1,198 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google LLC.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "upb/text/decode.h"
+
+#include <string.h>
+
+#include <cmath>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "upb/base/status.hpp"
+#include "upb/mem/arena.hpp"
+#include "upb/reflection/def.hpp"
+#include "upb/reflection/message.h"
+#include "upb/text/encode.h"
+#include "upb/text/test.upbdefs.h"
+
+namespace {
+
+class TextDecodeTest : public testing::Test {
+ protected:
+  TextDecodeTest() : m_(upb_text_test_TestMessage_getmsgdef(pool_.ptr())) {}
+
+  upb_Message* Decode(const char* text, int options = 0) {
+    upb_Message* msg =
+        upb_Message_New(upb_MessageDef_MiniTable(m_), arena_.ptr());
+    bool ok = upb_TextDecode(text, strlen(text), msg, m_, pool_.ptr(), options,
+                             arena_.ptr(), status_.ptr());
+    return ok ? msg : nullptr;
+  }
+
+  // Parses `text` and returns the result re-encoded on a single line, or
+  // "error" if the parse failed.
+  std::string Parse(const char* text, int options = 0) {
+    upb_Message* msg = Decode(text, options);
+    if (!msg) return "error";
+    char buf[1024];
+    size_t size = upb_TextEncode(msg, m_, pool_.ptr(), UPB_TXTENC_SINGLELINE,
+                                 buf, sizeof(buf));
+    EXPECT_LT(size, sizeof(buf));
+    // Single-line output puts a space after every field.
+    if (size > 0 && buf[size - 1] == ' ') size--;
+    return std::string(buf, size);
+  }
+
+  upb::DefPool pool_;
+  upb::Arena arena_;
+  upb::Status status_;
+  const upb_MessageDef* m_;
+};
+
+TEST_F(TextDecodeTest, Empty) {
+  EXPECT_EQ("", Parse(""));
+  EXPECT_EQ("", Parse("  # Only a comment.\n"));
+}
+
+TEST_F(TextDecodeTest, Scalars) {
+  EXPECT_EQ(
+      "i32: -2147483648 i64: -9223372036854775808 u32: 4294967295 "
+      "u64: 18446744073709551615",
+      Parse("i32: -2147483648 i64: -9223372036854775808 u32: 4294967295 "
+            "u64: 18446744073709551615"));
+  EXPECT_EQ("i32: 16 i64: 8", Parse("i32: 0x10; i64: 010,"));
+  EXPECT_EQ("f: 1.5 d: -0.25", Parse("f: 1.5f d: -.25"));
+  EXPECT_EQ("f: inf d: -inf", Parse("f: Infinity d: -inf"));
+  EXPECT_EQ("d: 3", Parse("d: 3"));
+  EXPECT_EQ("b: true", Parse("b: t"));
+  EXPECT_EQ("b: false", Parse("b: 0"));
+  EXPECT_EQ("e: NEG", Parse("e: NEG"));
+  EXPECT_EQ("e: ONE", Parse("e: 1"));
+}
+
+TEST_F(TextDecodeTest, NaN) {
+  upb_Message* msg = Decode("d: NaN f: -nan");
+  ASSERT_NE(msg, nullptr);
+  EXPECT_TRUE(std::isnan(upb_Message_GetFieldByDef(
+                             msg, upb_MessageDef_FindFieldByName(m_, "d"))
+                             .double_val));
+  EXPECT_TRUE(std::isnan(upb_Message_GetFieldByDef(
+                             msg, upb_MessageDef_FindFieldByName(m_, "f"))
+                             .float_val));
+}
+
+TEST_F(TextDecodeTest, ScalarErrors) {
+  EXPECT_EQ("error", Parse("i32: 2147483648"));
+  EXPECT_EQ("error", Parse("i32: -2147483649"));
+  EXPECT_EQ("error", Parse("u32: -1"));
+  EXPECT_EQ("error", Parse("i32: 1.5"));
+  EXPECT_EQ("error", Parse("b: 2"));
+  EXPECT_EQ("error", Parse("b: yes"));
+  EXPECT_EQ("error", Parse("e: TWO"));
+  // Enum is closed, so unknown numbers are rejected.
+  EXPECT_EQ("error", Parse("e: 5"));
+  EXPECT_EQ("error", Parse("i32 1"));
+  EXPECT_EQ("error", Parse("i32: 1 i32: 2"));
+  EXPECT_EQ("error", Parse("s: 'unterminated"));
+}
+
+TEST_F(TextDecodeTest, Strings) {
+  EXPECT_EQ(R"(s: "abc")", Parse(R"(s: "a" 'b' "c")"));
+  EXPECT_EQ(R"(s: "\"q\"\n")", Parse(R"(s: '"q"\n')"));
+  EXPECT_EQ(R"(by: "\001\377")", Parse(R"(by: "\001\xff")"));
+}
+
+TEST_F(TextDecodeTest, Submessages) {
+  EXPECT_EQ("child { i32: 1 child { s: \"x\" } }",
+            Parse("child { i32: 1 child: < s: \"x\" > }"));
+  // Groups may be named by their type or their field.
+  EXPECT_EQ("optionalgroup { a: 5 }", Parse("OptionalGroup { a: 5 }"));
+  EXPECT_EQ("optionalgroup { a: 5 }", Parse("optionalgroup { a: 5 }"));
+  EXPECT_EQ("error", Parse("child { i32: 1"));
+  EXPECT_EQ("error", Parse("child { i32: 1 >"));
+}
+
+TEST_F(TextDecodeTest, Repeated) {
+  EXPECT_EQ("r_i32: 1 r_i32: 2 r_i32: 3 r_i32: 4",
+            Parse("r_i32: 1 r_i32: [2, 3] r_i32: [] r_i32: 4"));
+  EXPECT_EQ(R"(r_s: "a" r_s: "b")", Parse(R"(r_s: ["a", "b"])"));
+  EXPECT_EQ("r_child { i32: 1 } r_child { i32: 2 }",
+            Parse("r_child [{ i32: 1 }, { i32: 2 }]"));
+}
+
+TEST_F(TextDecodeTest, Maps) {
+  constexpr char kMaps[] =
+      R"(map_si { key: "a" value: 1 } map_im { key: 2 value { i32: 3 } })";
+  EXPECT_EQ(kMaps, Parse(kMaps));
+  // A missing message value is an empty message.
+  EXPECT_EQ("map_im { key: 2 value { } }", Parse("map_im { key: 2 }"));
+}
+
+TEST_F(TextDecodeTest, Oneof) {
+  EXPECT_EQ("o_i32: 1", Parse("o_i32: 1"));
+  EXPECT_EQ("error", Parse("o_i32: 1 o_s: \"x\""));
+}
+
+TEST_F(TextDecodeTest, Extensions) {
+  EXPECT_EQ("[upb_text_test.ext_i32]: 7", Parse("[upb_text_test.ext_i32]: 7"));
+  EXPECT_EQ("error", Parse("[upb_text_test.no_such_ext]: 7"));
+  EXPECT_EQ("", Parse("[upb_text_test.no_such_ext]: 7",
+                      UPB_TXTDEC_IGNOREUNKNOWN));
+}
+
+TEST_F(TextDecodeTest, Any) {
+  // The encoder prints Any values in their serialized form.
+  EXPECT_EQ(
+      R"(any { type_url: "type.googleapis.com/upb_text_test.TestMessage" )"
+      R"(value: "\010\001" })",
+      Parse("any { [type.googleapis.com/upb_text_test.TestMessage] { i32: 1 } "
+            "}"));
+  EXPECT_EQ("error",
+            Parse("any { [type.googleapis.com/upb_text_test.Nope] { i32: 1 } }"));
+  EXPECT_EQ("error",
+            Parse("[type.googleapis.com/upb_text_test.TestMessage] { }"));
+}
+
+TEST_F(TextDecodeTest, UnknownFields) {
+  const char* text =
+      "i32: 1 nope: 2 nope: -inf nope: \"a\" 'b' nope { x: [1, 2] y < z: 3 > } "
+      "nope: [{ a: 1 }, { b: 2 }] nope [] i64: 2";
+  EXPECT_EQ("error", Parse(text));
+  EXPECT_EQ("i32: 1 i64: 2", Parse(text, UPB_TXTDEC_IGNOREUNKNOWN));
+}
+
+TEST_F(TextDecodeTest, ErrorMessage) {
+  EXPECT_EQ("error", Parse("i32: 1\nchild { i32: x }"));
+  EXPECT_STREQ("Error parsing text format @2:14: Expected integer, got: x",
+               status_.error_message());
+}
+
+}  // namespace
@@ -33,6 +33,13 @@
 #include <stdlib.h>
 
 #include "upb/base/string_view.h"
+#include "upb/collections/internal/array.h"
+#include "upb/collections/map.h"
+#include "upb/message/internal/accessors.h"
+#include "upb/message/internal/extension.h"
+#include "upb/message/message.h"
+#include "upb/message/tagged_ptr.h"
+#include "upb/mini_table/field.h"
 #include "upb/wire/eps_copy_input_stream.h"
 #include "upb/wire/reader.h"
 #include "upb/wire/types.h"
@@ -295,7 +302,9 @@ upb_UnknownCompareResult upb_Message_UnknownFieldsAreEqual(const char* buf1,
                                                            int max_depth) {
   if (size1 == 0 && size2 == 0) return kUpb_UnknownCompareResult_Equal;
   if (size1 == 0 || size2 == 0) return kUpb_UnknownCompareResult_NotEqual;
-  if (memcmp(buf1, buf2, size1) == 0) return kUpb_UnknownCompareResult_Equal;
+  if (size1 == size2 && memcmp(buf1, buf2, size1) == 0) {
+    return kUpb_UnknownCompareResult_Equal;
+  }
 
   upb_UnknownField_Context ctx = {
       .arena = upb_Arena_New(),
@@ -309,3 +318,203 @@ upb_UnknownCompareResult upb_Message_UnknownFieldsAreEqual(const char* buf1,
 
   return upb_UnknownField_Compare(&ctx, buf1, size1, buf2, size2);
 }
+
+// Message comparison //////////////////////////////////////////////////////////
+
+static bool upb_Value_IsEqual(const void* p1, const void* p2, upb_CType ctype,
+                              const upb_MiniTable* sub, int options);
+
+static bool upb_Message_UnknownIsEqual(const upb_Message* msg1,
+                                       const upb_Message* msg2) {
+  size_t size1, size2;
+  const char* buf1 = upb_Message_GetUnknown(msg1, &size1);
+  const char* buf2 = upb_Message_GetUnknown(msg2, &size2);
+  // 100 is arbitrary, we're trying to prevent stack overflow but it's not
+  // obvious how deep we should allow here.
+  return upb_Message_UnknownFieldsAreEqual(buf1, size1, buf2, size2, 100) ==
+         kUpb_UnknownCompareResult_Equal;
+}
+
+static bool upb_TaggedMessagePtr_IsEqual(upb_TaggedMessagePtr ptr1,
+                                         upb_TaggedMessagePtr ptr2,
+                                         const upb_MiniTable* m, int options) {
+  const upb_Message* msg1 = _upb_TaggedMessagePtr_GetMessage(ptr1);
+  const upb_Message* msg2 = _upb_TaggedMessagePtr_GetMessage(ptr2);
+  if (msg1 == msg2) return true;
+
+  // An unlinked sub-message holds its entire payload as unknown fields, so it
+  // can only match another unlinked sub-message with the same payload.
+  const bool empty1 = upb_TaggedMessagePtr_IsEmpty(ptr1);
+  const bool empty2 = upb_TaggedMessagePtr_IsEmpty(ptr2);
+  if (empty1 || empty2) {
+    return empty1 && empty2 && upb_Message_UnknownIsEqual(msg1, msg2);
+  }
+
+  UPB_ASSERT(m);
+  return upb_Message_IsEqual(msg1, msg2, m, options);
+}
+
+static bool upb_Array_IsEqualImpl(const upb_Array* arr1, const upb_Array* arr2,
+                                  upb_CType ctype, const upb_MiniTable* sub,
+                                  int options) {
+  const size_t size1 = arr1 ? arr1->size : 0;
+  const size_t size2 = arr2 ? arr2->size : 0;
+  if (size1 != size2) return false;
+  if (size1 == 0) return true;
+
+  const char* data1 = _upb_array_constptr(arr1);
+  const char* data2 = _upb_array_constptr(arr2);
+  const size_t lg2 = _upb_Array_ElementSizeLg2(arr1);
+  UPB_ASSERT(lg2 == _upb_Array_ElementSizeLg2(arr2));
+
+  switch (ctype) {
+    case kUpb_CType_Bool:
+    case kUpb_CType_Int32:
+    case kUpb_CType_UInt32:
+    case kUpb_CType_Enum:
+    case kUpb_CType_Int64:
+    case kUpb_CType_UInt64:
+      // Integer elements are equal exactly when their bytes are.
+      return memcmp(data1, data2, size1 << lg2) == 0;
+    default:
+      for (size_t i = 0; i < size1; i++) {
+        const size_t ofs = i << lg2;
+        if (!upb_Value_IsEqual(data1 + ofs, data2 + ofs, ctype, sub, options)) {
+          return false;
+        }
+      }
+      return true;
+  }
+}
+
+static bool upb_Map_IsEqualImpl(const upb_Map* map1, const upb_Map* map2,
+                                const upb_MiniTable* entry, int options) {
+  const size_t size1 = map1 ? upb_Map_Size(map1) : 0;
+  const size_t size2 = map2 ? upb_Map_Size(map2) : 0;
+  if (size1 != size2) return false;
+  if (size1 == 0) return true;
+
+  const upb_MiniTableField* val_f = &entry->fields[1];
+  const upb_CType ctype = upb_MiniTableField_CType(val_f);
+  const upb_MiniTable* val_sub =
+      ctype == kUpb_CType_Message
+          ? upb_MiniTable_GetSubMessageTable(entry, val_f)
+          : NULL;
+
+  upb_MessageValue key, val1, val2;
+  size_t iter = kUpb_Map_Begin;
+  while (upb_Map_Next(map1, &key, &val1, &iter)) {
+    if (!upb_Map_Get(map2, key, &val2)) return false;
+    if (!upb_Value_IsEqual(&val1, &val2, ctype, val_sub, options)) return false;
+  }
+  return true;
+}
+
+static bool upb_Value_IsEqual(const void* p1, const void* p2, upb_CType ctype,
+                              const upb_MiniTable* sub, int options) {
+  switch (ctype) {
+    case kUpb_CType_Bool:
+      return *(const bool*)p1 == *(const bool*)p2;
+    case kUpb_CType_Float:
+      return *(const float*)p1 == *(const float*)p2;
+    case kUpb_CType_Int32:
+    case kUpb_CType_UInt32:
+    case kUpb_CType_Enum:
+      return *(const uint32_t*)p1 == *(const uint32_t*)p2;
+    case kUpb_CType_Double:
+      return *(const double*)p1 == *(const double*)p2;
+    case kUpb_CType_Int64:
+    case kUpb_CType_UInt64:
+      return *(const uint64_t*)p1 == *(const uint64_t*)p2;
+    case kUpb_CType_String:
+    case kUpb_CType_Bytes:
+      return upb_StringView_IsEqual(*(const upb_StringView*)p1,
+                                    *(const upb_StringView*)p2);
+    case kUpb_CType_Message:
+      return upb_TaggedMessagePtr_IsEqual(*(const upb_TaggedMessagePtr*)p1,
+                                          *(const upb_TaggedMessagePtr*)p2,
+                                          sub, options);
+  }
+  UPB_UNREACHABLE();
+}
+
+// Compares the data of field `f`, already known to be present in both
+// messages.  For message and map fields `sub` is the sub-message or map entry
+// MiniTable.
+static bool upb_FieldData_IsEqual(const void* p1, const void* p2,
+                                  const upb_MiniTableField* f,
+                                  const upb_MiniTable* sub, int options) {
+  switch (upb_FieldMode_Get(f)) {
+    case kUpb_FieldMode_Map:
+      return upb_Map_IsEqualImpl(*(const upb_Map* const*)p1,
+                                 *(const upb_Map* const*)p2, sub, options);
+    case kUpb_FieldMode_Array:
+      return upb_Array_IsEqualImpl(*(const upb_Array* const*)p1,
+                                   *(const upb_Array* const*)p2,
+                                   upb_MiniTableField_CType(f), sub, options);
+    case kUpb_FieldMode_Scalar:
+      return upb_Value_IsEqual(p1, p2, upb_MiniTableField_CType(f), sub,
+                               options);
+  }
+  UPB_UNREACHABLE();
+}
+
+static bool upb_Message_ExtensionsAreEqual(const upb_Message* msg1,
+                                           const upb_Message* msg2,
+                                           int options) {
+  size_t count1, count2;
+  const upb_Message_Extension* exts1 = _upb_Message_Getexts(msg1, &count1);
+  _upb_Message_Getexts(msg2, &count2);
+  if (count1 != count2) return false;
+
+  // Extensions are stored in the order they were set, so look up each of
+  // msg1's extensions in msg2.  Equal counts mean nothing in msg2 is missed.
+  for (size_t i = 0; i < count1; i++) {
+    const upb_MiniTableExtension* e = exts1[i].ext;
+    const upb_Message_Extension* ext2 = _upb_Message_Getext(msg2, e);
+    if (!ext2) return false;
+
+    const upb_MiniTableField* f = &e->field;
+    const upb_MiniTable* sub =
+        upb_MiniTableField_CType(f) == kUpb_CType_Message ? e->sub.submsg
+                                                          : NULL;
+    if (!upb_FieldData_IsEqual(&exts1[i].data, &ext2->data, f, sub, options)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool upb_Message_IsEqual(const upb_Message* msg1, const upb_Message* msg2,
+                         const upb_MiniTable* m, int options) {
+  if (msg1 == msg2) return true;
+
+  for (int i = 0; i < m->field_count; i++) {
+    const upb_MiniTableField* f = &m->fields[i];
+    if (upb_MiniTableField_HasPresence(f)) {
+      const bool has1 = _upb_Message_HasNonExtensionField(msg1, f);
+      if (has1 != _upb_Message_HasNonExtensionField(msg2, f)) return false;
+      if (!has1) continue;
+    }
+
+    const upb_MiniTable* sub =
+        upb_MiniTableField_CType(f) == kUpb_CType_Message
+            ? upb_MiniTable_GetSubMessageTable(m, f)
+            : NULL;
+    if (!upb_FieldData_IsEqual(_upb_MiniTableField_GetConstPtr(msg1, f),
+                               _upb_MiniTableField_GetConstPtr(msg2, f), f,
+                               sub, options)) {
+      return false;
+    }
+  }
+
+  if (m->ext != kUpb_ExtMode_NonExtendable &&
+      !upb_Message_ExtensionsAreEqual(msg1, msg2, options)) {
+    return false;
+  }
+
+  if (options & kUpb_CompareOption_IncludeUnknownFields) {
+    return upb_Message_UnknownIsEqual(msg1, msg2);
+  }
+  return true;
+}
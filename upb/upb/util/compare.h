@@ -33,6 +33,9 @@
 
 #include <stddef.h>
 
+#include "upb/message/types.h"
+#include "upb/mini_table/message.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -62,6 +65,20 @@ upb_UnknownCompareResult upb_Message_UnknownFieldsAreEqual(const char* buf1,
                                                            size_t size2,
                                                            int max_depth);
 
+typedef enum {
+  // Also compare unknown fields, using upb_Message_UnknownFieldsAreEqual() when
+  // the raw bytes differ.
+  kUpb_CompareOption_IncludeUnknownFields = (1 << 0),
+} upb_CompareOption;
+
+// Returns true if the two messages of type `m` have the same fields set to the
+// same values, including extensions.  Fields are compared directly through the
+// MiniTable, without serializing either message.  Floating-point values compare
+// with ==, so a NaN is never equal to itself.  `options` is a bitwise OR of
+// upb_CompareOption values.
+bool upb_Message_IsEqual(const upb_Message* msg1, const upb_Message* msg2,
+                         const upb_MiniTable* m, int options);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
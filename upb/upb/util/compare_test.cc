@@ -38,6 +38,8 @@
 #include <vector>
 
 #include "gtest/gtest.h"
+#include "google/protobuf/test_messages_proto2.upb.h"
+#include "upb/mem/arena.hpp"
 #include "upb/wire/internal/swap.h"
 #include "upb/wire/types.h"
 
@@ -195,3 +197,83 @@ TEST(CompareTest, MaxDepth) {
           {{1, Group({{2, Group({{4, Fixed64(123)}, {3, Fixed32(456)}})}})}},
           2));
 }
+
+bool MessagesAreEqual(const UnknownFields& fields1,
+                      const UnknownFields& fields2, int options = 0) {
+  upb::Arena arena;
+  std::string buf1 = ToBinaryPayload(fields1);
+  std::string buf2 = ToBinaryPayload(fields2);
+  protobuf_test_messages_proto2_TestAllTypesProto2* msg1 =
+      protobuf_test_messages_proto2_TestAllTypesProto2_parse(
+          buf1.data(), buf1.size(), arena.ptr());
+  protobuf_test_messages_proto2_TestAllTypesProto2* msg2 =
+      protobuf_test_messages_proto2_TestAllTypesProto2_parse(
+          buf2.data(), buf2.size(), arena.ptr());
+  EXPECT_NE(nullptr, msg1);
+  EXPECT_NE(nullptr, msg2);
+  return upb_Message_IsEqual(
+      msg1, msg2, &protobuf_test_messages_proto2_TestAllTypesProto2_msg_init,
+      options);
+}
+
+std::string MapEntry(uint64_t key, uint64_t value) {
+  return ToBinaryPayload({{1, Varint(key)}, {2, Varint(value)}});
+}
+
+TEST(CompareTest, MessageScalarFields) {
+  EXPECT_TRUE(MessagesAreEqual({}, {}));
+  EXPECT_TRUE(MessagesAreEqual({{1, Varint(5)}}, {{1, Varint(5)}}));
+  EXPECT_FALSE(MessagesAreEqual({{1, Varint(5)}}, {{1, Varint(6)}}));
+  // Presence matters even when the value is the default.
+  EXPECT_FALSE(MessagesAreEqual({{1, Varint(0)}}, {}));
+  // Oneof members compare by case as well as by value.
+  EXPECT_TRUE(MessagesAreEqual({{111, Varint(0)}}, {{111, Varint(0)}}));
+  EXPECT_FALSE(MessagesAreEqual({{111, Varint(0)}}, {}));
+}
+
+TEST(CompareTest, MessageRepeatedFields) {
+  EXPECT_TRUE(MessagesAreEqual({{31, Varint(1)}, {31, Varint(2)}},
+                               {{31, Varint(1)}, {31, Varint(2)}}));
+  EXPECT_FALSE(MessagesAreEqual({{31, Varint(1)}, {31, Varint(2)}},
+                                {{31, Varint(2)}, {31, Varint(1)}}));
+  EXPECT_FALSE(MessagesAreEqual({{31, Varint(1)}}, {}));
+  EXPECT_TRUE(MessagesAreEqual({{44, Delimited("a")}, {44, Delimited("b")}},
+                               {{44, Delimited("a")}, {44, Delimited("b")}}));
+  EXPECT_FALSE(MessagesAreEqual({{44, Delimited("a")}}, {{44, Delimited("")}}));
+
+  // Doubles compare by value, not by representation.
+  const uint64_t kNaN = 0x7ff8000000000000;
+  const uint64_t kNegativeZero = 0x8000000000000000;
+  EXPECT_TRUE(
+      MessagesAreEqual({{42, Fixed64(0)}}, {{42, Fixed64(kNegativeZero)}}));
+  EXPECT_FALSE(MessagesAreEqual({{42, Fixed64(kNaN)}}, {{42, Fixed64(kNaN)}}));
+}
+
+TEST(CompareTest, MessageSubMessagesAndMaps) {
+  const std::string nested = ToBinaryPayload({{1, Varint(3)}});
+  EXPECT_TRUE(
+      MessagesAreEqual({{18, Delimited(nested)}}, {{18, Delimited(nested)}}));
+  EXPECT_FALSE(
+      MessagesAreEqual({{18, Delimited(nested)}}, {{18, Delimited("")}}));
+
+  // Map order does not matter.
+  EXPECT_TRUE(MessagesAreEqual({{56, Delimited(MapEntry(1, 2))},
+                                {56, Delimited(MapEntry(3, 4))}},
+                               {{56, Delimited(MapEntry(3, 4))},
+                                {56, Delimited(MapEntry(1, 2))}}));
+  EXPECT_FALSE(MessagesAreEqual({{56, Delimited(MapEntry(1, 2))}},
+                                {{56, Delimited(MapEntry(1, 3))}}));
+  EXPECT_FALSE(MessagesAreEqual({{56, Delimited(MapEntry(1, 2))}},
+                                {{56, Delimited(MapEntry(2, 2))}}));
+}
+
+TEST(CompareTest, MessageUnknownFields) {
+  const int kUnknown = kUpb_CompareOption_IncludeUnknownFields;
+  EXPECT_TRUE(MessagesAreEqual({{5000, Varint(1)}}, {}));
+  EXPECT_FALSE(MessagesAreEqual({{5000, Varint(1)}}, {}, kUnknown));
+  EXPECT_TRUE(MessagesAreEqual({{5000, Varint(1)}, {5001, Fixed32(2)}},
+                               {{5001, Fixed32(2)}, {5000, Varint(1)}},
+                               kUnknown));
+  EXPECT_FALSE(MessagesAreEqual({{5000, Varint(1)}}, {{5000, Varint(2)}},
+                                kUnknown));
+}
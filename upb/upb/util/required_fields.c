@@ -34,7 +34,9 @@
 #include <stdarg.h>
 
 #include "upb/collections/map.h"
+#include "upb/message/internal/accessors.h"
 #include "upb/port/vsnprintf_compat.h"
+#include "upb/reflection/internal/message_def.h"
 #include "upb/reflection/message.h"
 
 // Must be last.
@@ -206,6 +208,12 @@ static void upb_FindContext_Pop(upb_FindContext* ctx) {
 static void upb_util_FindUnsetInMessage(upb_FindContext* ctx,
                                         const upb_Message* msg,
                                         const upb_MessageDef* m) {
+  // Most messages are complete; only look for the missing fields by name if
+  // the hasbits say that there are some.
+  const upb_MiniTable* l = upb_MessageDef_MiniTable(m);
+  if (!l->required_count) return;
+  if (msg && !_upb_Message_MissingRequired(msg, l)) return;
+
   // Iterate over all fields to see if any required fields are missing.
   for (int i = 0, n = upb_MessageDef_FieldCount(m); i < n; i++) {
     const upb_FieldDef* f = upb_MessageDef_Field(m, i);
@@ -236,12 +244,11 @@ static void upb_util_FindUnsetInMessage(upb_FindContext* ctx,
 static void upb_util_FindUnsetRequiredInternal(upb_FindContext* ctx,
                                                const upb_Message* msg,
                                                const upb_MessageDef* m) {
-  // OPT: add markers in the schema for where we can avoid iterating:
-  // 1. messages with no required fields.
-  // 2. messages that cannot possibly reach any required fields.
+  if (!_upb_MessageDef_ReachesRequired(m)) return;
 
   upb_util_FindUnsetInMessage(ctx, msg, m);
-  if (!msg) return;
+  if (!msg || !_upb_MessageDef_SubMessagesReachRequired(m)) return;
+  if (ctx->has_unset_required && !ctx->save_paths) return;
 
   // Iterate over all present fields to find sub-messages that might be missing
   // required fields.  This may revisit some of the fields already inspected
@@ -255,11 +262,13 @@ static void upb_util_FindUnsetRequiredInternal(upb_FindContext* ctx,
   const upb_FieldDef* f;
   upb_MessageValue val;
   while (upb_Message_Next(msg, m, ctx->ext_pool, &f, &val, &iter)) {
-    // Skip non-submessage fields.
+    // Skip non-submessage fields, and sub-messages that can never be missing
+    // required fields.
     if (!upb_FieldDef_IsSubMessage(f)) continue;
+    const upb_MessageDef* sub_m = upb_FieldDef_MessageSubDef(f);
+    if (!_upb_MessageDef_ReachesRequired(sub_m)) continue;
 
     upb_FindContext_Push(ctx, (upb_FieldPathEntry){.field = f});
-    const upb_MessageDef* sub_m = upb_FieldDef_MessageSubDef(f);
 
     if (upb_FieldDef_IsMap(f)) {
       // Map field.
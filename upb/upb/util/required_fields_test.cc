@@ -31,6 +31,7 @@
 #include "upb/util/required_fields.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -39,6 +40,7 @@
 #include "upb/json/decode.h"
 #include "upb/mem/arena.hpp"
 #include "upb/reflection/def.hpp"
+#include "upb/reflection/internal/message_def.h"
 #include "upb/util/required_fields_test.upb.h"
 #include "upb/util/required_fields_test.upbdefs.h"
 
@@ -208,3 +210,37 @@ TEST(RequiredFieldsTest, TestRequired) {
       )json",
       {R"(map_string_message["d\"ef"].required_int32)"});
 }
+
+TEST(RequiredFieldsTest, ReachesRequired) {
+  upb::DefPool defpool;
+  const upb_MessageDef* no_required =
+      upb_util_test_NoRequiredFields_getmsgdef(defpool.ptr());
+  const upb_MessageDef* has_required =
+      upb_util_test_HasRequiredField_getmsgdef(defpool.ptr());
+  const upb_MessageDef* test_required =
+      upb_util_test_TestRequiredFields_getmsgdef(defpool.ptr());
+  const upb_MessageDef* cycle_a =
+      upb_util_test_CycleA_getmsgdef(defpool.ptr());
+  const upb_MessageDef* cycle_b =
+      upb_util_test_CycleB_getmsgdef(defpool.ptr());
+
+  EXPECT_FALSE(_upb_MessageDef_ReachesRequired(no_required));
+  EXPECT_TRUE(_upb_MessageDef_ReachesRequired(has_required));
+  EXPECT_FALSE(_upb_MessageDef_SubMessagesReachRequired(has_required));
+  EXPECT_TRUE(_upb_MessageDef_SubMessagesReachRequired(test_required));
+  EXPECT_TRUE(_upb_MessageDef_ReachesRequired(cycle_a));
+  EXPECT_TRUE(_upb_MessageDef_ReachesRequired(cycle_b));
+
+  upb::Arena arena;
+  upb::Status status;
+  const char json[] = R"json({"b": {"a": {"b": {"required": {}}}}})json";
+  upb_util_test_CycleA* msg = upb_util_test_CycleA_new(arena.ptr());
+  EXPECT_TRUE(upb_JsonDecode(json, strlen(json), msg, cycle_a, defpool.ptr(),
+                             0, arena.ptr(), status.ptr()))
+      << status.error_message();
+  upb_FieldPathEntry* entries = nullptr;
+  EXPECT_TRUE(upb_util_HasUnsetRequired(msg, cycle_a, defpool.ptr(), &entries));
+  EXPECT_EQ(std::vector<std::string>{"b.a.b.required.required_int32"},
+            PathsToText(entries));
+  free(entries);
+}
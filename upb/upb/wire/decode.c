@@ -77,6 +77,11 @@ enum {
   kUpb_DecodeOp_PackedEnum = 13,
 };
 
+// Upper bound on how many elements of a repeated field are counted ahead of
+// the decoder, and so on how many sub-messages are allocated together; see
+// _upb_Decoder_CountRepeated().
+#define kUpb_Decoder_MaxLookahead 32
+
 // For packed fields it is helpful to be able to recover the lg2 of the data
 // size from the op.
 #define OP_FIXPCK_LG2(n) (n + 5) /* n in [2, 3] => op in [7, 8] */
@@ -444,6 +449,8 @@ static const char* _upb_Decoder_DecodeVarintPacked(
     const upb_MiniTableField* field, int lg2) {
   int scale = 1 << lg2;
   int saved_limit = upb_EpsCopyInputStream_PushLimit(&d->input, ptr, val->size);
+  _upb_Decoder_Reserve(
+      d, arr, _upb_Decoder_CountVarints(ptr, d->input.limit_ptr));
   char* out = UPB_PTR_AT(_upb_array_ptr(arr), arr->size << lg2, void);
   while (!_upb_Decoder_IsDone(d, &ptr)) {
     wireval elem;
@@ -467,6 +474,9 @@ static const char* _upb_Decoder_DecodeEnumPacked(
     wireval* val) {
   const upb_MiniTableEnum* e = subs[field->UPB_PRIVATE(submsg_index)].subenum;
   int saved_limit = upb_EpsCopyInputStream_PushLimit(&d->input, ptr, val->size);
+  // Unknown values are dropped, so this may reserve a few too many.
+  _upb_Decoder_Reserve(
+      d, arr, _upb_Decoder_CountVarints(ptr, d->input.limit_ptr));
   char* out = UPB_PTR_AT(_upb_array_ptr(arr), arr->size * 4, void);
   while (!_upb_Decoder_IsDone(d, &ptr)) {
     wireval elem;
@@ -487,7 +497,8 @@ static const char* _upb_Decoder_DecodeEnumPacked(
 }
 
 upb_Array* _upb_Decoder_CreateArray(upb_Decoder* d,
-                                    const upb_MiniTableField* field) {
+                                    const upb_MiniTableField* field,
+                                    size_t capacity) {
   /* Maps descriptor type -> elem_size_lg2.  */
   static const uint8_t kElemSizeLg2[] = {
       [0] = -1,  // invalid descriptor type
@@ -512,11 +523,132 @@ upb_Array* _upb_Decoder_CreateArray(upb_Decoder* d,
   };
 
   size_t lg2 = kElemSizeLg2[field->UPB_PRIVATE(descriptortype)];
-  upb_Array* ret = _upb_Array_New(&d->arena, 4, lg2);
+  upb_Array* ret = _upb_Array_New(&d->arena, capacity, lg2);
   if (!ret) _upb_Decoder_ErrorJmp(d, kUpb_DecodeStatus_OutOfMemory);
   return ret;
 }
 
+// Returns the wire type of one unpacked element of |field|.
+static int _upb_Decoder_ElementWireType(const upb_MiniTableField* field) {
+  switch (field->UPB_PRIVATE(descriptortype)) {
+    case kUpb_FieldType_Float:
+    case kUpb_FieldType_Fixed32:
+    case kUpb_FieldType_SFixed32:
+      return kUpb_WireType_32Bit;
+    case kUpb_FieldType_Double:
+    case kUpb_FieldType_Fixed64:
+    case kUpb_FieldType_SFixed64:
+      return kUpb_WireType_64Bit;
+    case kUpb_FieldType_String:
+    case kUpb_FieldType_Bytes:
+    case kUpb_FieldType_Message:
+      return kUpb_WireType_Delimited;
+    default:
+      return kUpb_WireType_Varint;
+  }
+}
+
+// Counts the unpacked elements of |field| that directly follow |ptr|,
+// including the one that ends at |ptr|, without reading past the current
+// buffer or limit.  At most kUpb_Decoder_MaxLookahead are counted.
+static int _upb_Decoder_CountRepeated(upb_Decoder* d, const char* ptr,
+                                      const upb_MiniTableField* field) {
+  const char* limit = d->input.limit_ptr;
+  const int wire_type = _upb_Decoder_ElementWireType(field);
+  char tag[5];
+  uint32_t tag_val = ((uint32_t)field->number << 3) | wire_type;
+  size_t tag_size = upb_Decoder_EncodeVarint32(tag_val, tag) - tag;
+  int count = 1;
+
+  // Everything we read here is within the slop bytes past |limit|.
+  while (count < kUpb_Decoder_MaxLookahead && ptr < limit) {
+    if (memcmp(ptr, tag, tag_size) != 0) break;
+    ptr += tag_size;
+    switch (wire_type) {
+      case kUpb_WireType_Varint:
+        while (ptr < limit && (*ptr & 0x80)) ptr++;
+        ptr++;
+        break;
+      case kUpb_WireType_32Bit:
+        ptr += 4;
+        break;
+      case kUpb_WireType_64Bit:
+        ptr += 8;
+        break;
+      case kUpb_WireType_Delimited: {
+        uint64_t size = (uint8_t)*ptr;
+        if (UPB_LIKELY((size & 0x80) == 0)) {
+          ptr++;
+        } else {
+          _upb_DecodeLongVarintReturn res =
+              _upb_Decoder_DecodeLongVarint(ptr, size);
+          if (!res.ptr) return count;
+          ptr = res.ptr;
+          size = res.val;
+        }
+        if (ptr > limit || size > (uint64_t)(limit - ptr)) return count;
+        ptr += size;
+        break;
+      }
+    }
+    if (ptr > limit) break;
+    count++;
+  }
+
+  return count;
+}
+
+// Appends the next element of a repeated sub-message field and decodes it.
+// Long runs of the same field are common, so rather than allocating each
+// element separately we count the run that is already in the buffer and carve
+// its messages out of a single zeroed allocation.
+static const char* _upb_Decoder_DecodeRepeatedSubMessage(
+    upb_Decoder* d, const char* ptr, upb_Array* arr,
+    const upb_MiniTableSub* subs, const upb_MiniTableField* field, int size) {
+  const upb_MiniTable* subl = subs[field->UPB_PRIVATE(submsg_index)].submsg;
+  UPB_ASSERT(subl);
+  size_t msg_size = UPB_ALIGN_MALLOC(upb_msg_sizeof(subl));
+  upb_Message* submsg = NULL;
+  int count;
+
+  if (d->msg_slab != d->msg_slab_end && d->msg_slab_type == subl) {
+    submsg = UPB_PTR_AT(d->msg_slab, sizeof(upb_Message_Internal), upb_Message);
+    d->msg_slab += msg_size;
+  } else if (subl != &_kUpb_MiniTable_Empty &&
+             (count = _upb_Decoder_CountRepeated(d, ptr + size, field)) > 1) {
+    _upb_Decoder_Reserve(d, arr, count);
+    char* mem = upb_Arena_Malloc(&d->arena, msg_size * count);
+    if (!mem) _upb_Decoder_ErrorJmp(d, kUpb_DecodeStatus_OutOfMemory);
+    memset(mem, 0, msg_size * count);
+    d->msg_slab = mem + msg_size;
+    d->msg_slab_end = mem + msg_size * count;
+    d->msg_slab_type = subl;
+    submsg = UPB_PTR_AT(mem, sizeof(upb_Message_Internal), upb_Message);
+  }
+
+  upb_TaggedMessagePtr* target =
+      (upb_TaggedMessagePtr*)_upb_array_ptr(arr) + arr->size;
+  if (submsg) {
+    upb_TaggedMessagePtr tagged = _upb_TaggedMessagePtr_Pack(submsg, false);
+    memcpy(target, &tagged, sizeof(tagged));
+  } else {
+    submsg = _upb_Decoder_NewSubMessage(d, subs, field, target);
+  }
+  arr->size++;
+
+  // The sub-message may batch its own repeated fields, so give it an empty
+  // slab and restore ours (whose remaining entries follow this one) after.
+  char* slab = d->msg_slab;
+  char* slab_end = d->msg_slab_end;
+  const upb_MiniTable* slab_type = d->msg_slab_type;
+  d->msg_slab = d->msg_slab_end = NULL;
+  ptr = _upb_Decoder_DecodeSubMessage(d, ptr, submsg, subs, field, size);
+  d->msg_slab = slab;
+  d->msg_slab_end = slab_end;
+  d->msg_slab_type = slab_type;
+  return ptr;
+}
+
 static const char* _upb_Decoder_DecodeToArray(upb_Decoder* d, const char* ptr,
                                               upb_Message* msg,
                                               const upb_MiniTableSub* subs,
@@ -529,7 +661,26 @@ static const char* _upb_Decoder_DecodeToArray(upb_Decoder* d, const char* ptr,
   if (arr) {
     _upb_Decoder_Reserve(d, arr, 1);
   } else {
-    arr = _upb_Decoder_CreateArray(d, field);
+    // Size a new array for the run of elements already in the buffer.  Packed
+    // payloads reserve their own space once their length is known.
+    size_t capacity = 4;
+    switch (op) {
+      case kUpb_DecodeOp_Scalar1Byte:
+      case kUpb_DecodeOp_Scalar4Byte:
+      case kUpb_DecodeOp_Scalar8Byte:
+      case kUpb_DecodeOp_Enum:
+        capacity = UPB_MAX(capacity, _upb_Decoder_CountRepeated(d, ptr, field));
+        break;
+      case kUpb_DecodeOp_String:
+      case kUpb_DecodeOp_Bytes:
+        if (upb_EpsCopyInputStream_CheckDataSizeAvailable(&d->input, ptr,
+                                                          val->size)) {
+          capacity = UPB_MAX(capacity, _upb_Decoder_CountRepeated(
+                                           d, ptr + val->size, field));
+        }
+        break;
+    }
+    arr = _upb_Decoder_CreateArray(d, field, capacity);
     *arrp = arr;
   }
 
@@ -552,18 +703,17 @@ static const char* _upb_Decoder_DecodeToArray(upb_Decoder* d, const char* ptr,
       return _upb_Decoder_ReadString(d, ptr, val->size, str);
     }
     case kUpb_DecodeOp_SubMessage: {
-      /* Append submessage / group. */
+      if (UPB_LIKELY(field->UPB_PRIVATE(descriptortype) !=
+                     kUpb_FieldType_Group)) {
+        return _upb_Decoder_DecodeRepeatedSubMessage(d, ptr, arr, subs, field,
+                                                     val->size);
+      }
+      /* Append group. */
       upb_TaggedMessagePtr* target = UPB_PTR_AT(
           _upb_array_ptr(arr), arr->size * sizeof(void*), upb_TaggedMessagePtr);
       upb_Message* submsg = _upb_Decoder_NewSubMessage(d, subs, field, target);
       arr->size++;
-      if (UPB_UNLIKELY(field->UPB_PRIVATE(descriptortype) ==
-                       kUpb_FieldType_Group)) {
-        return _upb_Decoder_DecodeKnownGroup(d, ptr, submsg, subs, field);
-      } else {
-        return _upb_Decoder_DecodeSubMessage(d, ptr, submsg, subs, field,
-                                             val->size);
-      }
+      return _upb_Decoder_DecodeKnownGroup(d, ptr, submsg, subs, field);
     }
     case OP_FIXPCK_LG2(2):
     case OP_FIXPCK_LG2(3):
@@ -752,10 +902,7 @@ const char* _upb_Decoder_CheckRequired(upb_Decoder* d, const char* ptr,
   if (UPB_LIKELY((d->options & kUpb_DecodeOption_CheckRequired) == 0)) {
     return ptr;
   }
-  uint64_t msg_head;
-  memcpy(&msg_head, msg, 8);
-  msg_head = _upb_BigEndian_Swap64(msg_head);
-  if (upb_MiniTable_requiredmask(l) & ~msg_head) {
+  if (_upb_Message_MissingRequired(msg, l)) {
     d->missing_required = true;
   }
   return ptr;
@@ -1365,6 +1512,9 @@ upb_DecodeStatus upb_Decode(const char* buf, size_t size, void* msg,
   decoder.options = (uint16_t)options;
   decoder.missing_required = false;
   decoder.status = kUpb_DecodeStatus_Ok;
+  decoder.msg_slab = NULL;
+  decoder.msg_slab_end = NULL;
+  decoder.msg_slab_type = NULL;
 
   // Violating the encapsulation of the arena for performance reasons.
   // This is a temporary arena that we swap into and swap out of when we are
@@ -1374,6 +1524,8 @@ upb_DecodeStatus upb_Decode(const char* buf, size_t size, void* msg,
   _upb_MemBlock* blocks = upb_Atomic_Load(&arena->blocks, memory_order_relaxed);
   decoder.arena.head = arena->head;
   decoder.arena.block_alloc = arena->block_alloc;
+  decoder.arena.max_block_size = arena->max_block_size;
+  decoder.arena.growth_factor = arena->growth_factor;
   upb_Atomic_Init(&decoder.arena.blocks, blocks);
 
   return upb_Decoder_Decode(&decoder, buf, msg, l, arena);
@@ -0,0 +1,102 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google LLC.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "upb/wire/decode_delimited.h"
+
+#include <string.h>
+
+#include "upb/wire/eps_copy_input_stream.h"
+#include "upb/wire/reader.h"
+
+// Must be last.
+#include "upb/port/def.inc"
+
+upb_DecodeStatus upb_DelimitedRecords_Split(const char* buf, size_t size,
+                                            upb_Arena* arena,
+                                            upb_StringView** records,
+                                            size_t* count) {
+  upb_StringView* out = NULL;
+  size_t n = 0;
+  size_t capacity = 0;
+  upb_EpsCopyInputStream stream;
+  const char* ptr = buf;
+
+  // Aliasing lets us map positions in the stream's patch buffer back to the
+  // caller's buffer; nothing is copied.
+  upb_EpsCopyInputStream_Init(&stream, &ptr, size, true);
+
+  while (!upb_EpsCopyInputStream_IsDone(&stream, &ptr)) {
+    int len;
+    ptr = upb_WireReader_ReadSize(ptr, &len);
+    if (!ptr ||
+        !upb_EpsCopyInputStream_CheckDataSizeAvailable(&stream, ptr, len)) {
+      return kUpb_DecodeStatus_Malformed;
+    }
+    if (n == capacity) {
+      size_t new_capacity = UPB_MAX(capacity * 2, 8);
+      out = upb_Arena_Realloc(arena, out, capacity * sizeof(*out),
+                              new_capacity * sizeof(*out));
+      if (!out) return kUpb_DecodeStatus_OutOfMemory;
+      capacity = new_capacity;
+    }
+    out[n].data = upb_EpsCopyInputStream_GetAliasedPtr(&stream, ptr);
+    out[n].size = len;
+    n++;
+    ptr += len;
+  }
+
+  // A record that extends past the end of the buffer is only detected by the
+  // IsDone() that follows it.
+  if (upb_EpsCopyInputStream_IsError(&stream)) {
+    return kUpb_DecodeStatus_Malformed;
+  }
+
+  *records = out;
+  *count = n;
+  return kUpb_DecodeStatus_Ok;
+}
+
+upb_DecodeStatus upb_DecodeRecords(const upb_StringView* records, size_t count,
+                                   const upb_MiniTable* mt,
+                                   const upb_ExtensionRegistry* extreg,
+                                   int options, upb_Arena* arena,
+                                   upb_Message** msgs, size_t* decoded) {
+  for (size_t i = 0; i < count; i++) {
+    *decoded = i;
+    upb_Message* msg = upb_Message_New(mt, arena);
+    if (!msg) return kUpb_DecodeStatus_OutOfMemory;
+    msgs[i] = msg;
+    upb_DecodeStatus status = upb_Decode(records[i].data, records[i].size, msg,
+                                         mt, extreg, options, arena);
+    if (status != kUpb_DecodeStatus_Ok) return status;
+  }
+  *decoded = count;
+  return kUpb_DecodeStatus_Ok;
+}
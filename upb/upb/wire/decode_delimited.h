@@ -0,0 +1,114 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google LLC.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Batch decoding of length-delimited record streams.
+//
+// A delimited stream is a sequence of records, each a varint length followed
+// by that many bytes of serialized message, as written by the C++
+// SerializeDelimitedToZeroCopyStream() and Java writeDelimitedTo().
+//
+// Decoding is split into two steps so that the expensive one can be spread
+// across threads. upb_DelimitedRecords_Split() makes one cheap pass over the
+// framing and returns the payload of every record. upb_DecodeRecords() then
+// decodes any contiguous slice of those payloads. It touches nothing but the
+// (read-only) input, the MiniTable and its own arena, so disjoint slices may
+// be decoded concurrently, each thread using its own upb_Arena:
+//
+//   upb_StringView* records;
+//   size_t n;
+//   upb_DelimitedRecords_Split(buf, size, arena, &records, &n);
+//   // On thread t of T, with arenas[t]:
+//   size_t begin = n * t / T, end = n * (t + 1) / T;
+//   upb_DecodeRecords(records + begin, end - begin, mt, NULL, 0, arenas[t],
+//                     msgs + begin, &decoded);
+//   // Once joined:
+//   upb_Arena_Fuse(arena, arenas[t]);
+//
+// Fusing gives all of the messages the lifetime of `arena`. No locks are
+// needed, and since the threads do not share an arena their allocations do
+// not contend.
+//
+// Neither function blocks or calls back into the caller, so language bindings
+// can run them with their interpreter lock released.
+
+#ifndef UPB_WIRE_DECODE_DELIMITED_H_
+#define UPB_WIRE_DECODE_DELIMITED_H_
+
+#include <stddef.h>
+
+#include "upb/base/string_view.h"
+#include "upb/mem/arena.h"
+#include "upb/message/message.h"
+#include "upb/mini_table/extension_registry.h"
+#include "upb/mini_table/message.h"
+#include "upb/wire/decode.h"
+
+// Must be last.
+#include "upb/port/def.inc"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Splits the delimited stream [buf, buf + size) into its records. On success
+// `*records` is set to an array of `*count` views that alias `buf`, allocated
+// from `arena`. An empty input yields zero records.
+//
+// Returns kUpb_DecodeStatus_Malformed if a length prefix is corrupt or a record
+// runs past the end of the buffer.
+UPB_API upb_DecodeStatus upb_DelimitedRecords_Split(const char* buf,
+                                                    size_t size,
+                                                    upb_Arena* arena,
+                                                    upb_StringView** records,
+                                                    size_t* count);
+
+// Decodes each of records[0, count) into a new message of type `mt` allocated
+// from `arena`, storing it in msgs[i]. `extreg` and `options` are the same as
+// for upb_Decode(). With kUpb_DecodeOption_AliasString the messages alias the
+// buffer the records point into, which must then outlive them.
+//
+// `*decoded` is set to the number of records that were decoded successfully.
+// Decoding stops at the first record that fails, and its status is returned;
+// msgs[*decoded] then holds the partially decoded message.
+UPB_API upb_DecodeStatus upb_DecodeRecords(const upb_StringView* records,
+                                           size_t count,
+                                           const upb_MiniTable* mt,
+                                           const upb_ExtensionRegistry* extreg,
+                                           int options, upb_Arena* arena,
+                                           upb_Message** msgs,
+                                           size_t* decoded);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#include "upb/port/undef.inc"
+
+#endif /* UPB_WIRE_DECODE_DELIMITED_H_ */
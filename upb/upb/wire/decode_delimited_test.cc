@@ -0,0 +1,259 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google LLC.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "upb/wire/decode_delimited.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "upb/base/status.h"
+#include "upb/base/string_view.h"
+#include "upb/mem/arena.h"
+#include "upb/message/accessors.h"
+#include "upb/message/message.h"
+#include "upb/mini_descriptor/decode.h"
+#include "upb/mini_descriptor/internal/encode.hpp"
+#include "upb/mini_table/message.h"
+#include "upb/wire/decode.h"
+#include "upb/wire/encode.h"
+
+namespace {
+
+// message M {
+//   int32 i32 = 1;
+//   string str = 2;
+// }
+upb_MiniTable* BuildMiniTable(upb_Arena* arena) {
+  upb::MtDataEncoder e;
+  e.StartMessage(0);
+  e.PutField(kUpb_FieldType_Int32, 1, 0);
+  e.PutField(kUpb_FieldType_String, 2, 0);
+  upb_Status status;
+  upb_Status_Clear(&status);
+  upb_MiniTable* table =
+      upb_MiniTable_Build(e.data().data(), e.data().size(), arena, &status);
+  EXPECT_TRUE(upb_Status_IsOk(&status));
+  return table;
+}
+
+std::string Varint(uint64_t val) {
+  std::string ret;
+  do {
+    char byte = val & 0x7f;
+    val >>= 7;
+    if (val) byte |= 0x80;
+    ret.push_back(byte);
+  } while (val);
+  return ret;
+}
+
+std::string Delimited(const std::string& data) {
+  return Varint(data.size()) + data;
+}
+
+// Builds a stream of `n` delimited records where record i has i32 = i and a
+// string whose length varies with i, so record boundaries land at assorted
+// offsets relative to the end of the buffer.
+std::string BuildStream(const upb_MiniTable* mt, int n, upb_Arena* arena) {
+  std::string stream;
+  for (int i = 0; i < n; i++) {
+    upb_Message* msg = upb_Message_New(mt, arena);
+    upb_Message_SetInt32(msg, upb_MiniTable_FindFieldByNumber(mt, 1), i,
+                         nullptr);
+    std::string str(i % 37, 'a' + i % 26);
+    upb_Message_SetString(
+        msg, upb_MiniTable_FindFieldByNumber(mt, 2),
+        upb_StringView_FromDataAndSize(str.data(), str.size()), nullptr);
+    char* buf;
+    size_t size;
+    EXPECT_EQ(kUpb_EncodeStatus_Ok, upb_Encode(msg, mt, 0, arena, &buf, &size));
+    stream += Delimited(std::string(buf, size));
+  }
+  return stream;
+}
+
+void CheckRecord(const upb_MiniTable* mt, const upb_Message* msg, int i) {
+  EXPECT_EQ(i, upb_Message_GetInt32(msg, upb_MiniTable_FindFieldByNumber(mt, 1),
+                                    -1));
+  upb_StringView str = upb_Message_GetString(
+      msg, upb_MiniTable_FindFieldByNumber(mt, 2), upb_StringView());
+  EXPECT_EQ(std::string(i % 37, 'a' + i % 26), std::string(str.data, str.size));
+}
+
+TEST(DecodeDelimitedTest, SplitAndDecode) {
+  upb_Arena* arena = upb_Arena_New();
+  const upb_MiniTable* mt = BuildMiniTable(arena);
+
+  for (int n : {0, 1, 2, 3, 100}) {
+    std::string stream = BuildStream(mt, n, arena);
+    upb_StringView* records;
+    size_t count;
+    ASSERT_EQ(kUpb_DecodeStatus_Ok,
+              upb_DelimitedRecords_Split(stream.data(), stream.size(), arena,
+                                         &records, &count));
+    ASSERT_EQ(static_cast<size_t>(n), count);
+    for (size_t i = 0; i < count; i++) {
+      // Records alias the input buffer.
+      EXPECT_GE(records[i].data, stream.data());
+      EXPECT_LE(records[i].data + records[i].size,
+                stream.data() + stream.size());
+    }
+
+    std::vector<upb_Message*> msgs(count);
+    size_t decoded;
+    ASSERT_EQ(kUpb_DecodeStatus_Ok,
+              upb_DecodeRecords(records, count, mt, nullptr, 0, arena,
+                                msgs.data(), &decoded));
+    EXPECT_EQ(count, decoded);
+    for (int i = 0; i < n; i++) CheckRecord(mt, msgs[i], i);
+  }
+
+  upb_Arena_Free(arena);
+}
+
+TEST(DecodeDelimitedTest, EmptyRecords) {
+  upb_Arena* arena = upb_Arena_New();
+  std::string stream(3, '\0');
+  upb_StringView* records;
+  size_t count;
+  ASSERT_EQ(kUpb_DecodeStatus_Ok,
+            upb_DelimitedRecords_Split(stream.data(), stream.size(), arena,
+                                       &records, &count));
+  ASSERT_EQ(3u, count);
+  for (size_t i = 0; i < count; i++) EXPECT_EQ(0u, records[i].size);
+  upb_Arena_Free(arena);
+}
+
+TEST(DecodeDelimitedTest, Malformed) {
+  upb_Arena* arena = upb_Arena_New();
+  const upb_MiniTable* mt = BuildMiniTable(arena);
+  std::string stream = BuildStream(mt, 10, arena);
+
+  upb_StringView* records;
+  size_t count;
+  // Every proper prefix that does not end on a record boundary is truncated.
+  std::vector<size_t> boundaries;
+  ASSERT_EQ(kUpb_DecodeStatus_Ok,
+            upb_DelimitedRecords_Split(stream.data(), stream.size(), arena,
+                                       &records, &count));
+  for (size_t i = 0; i < count; i++) {
+    boundaries.push_back(records[i].data + records[i].size - stream.data());
+  }
+  for (size_t len = 1; len < stream.size(); len++) {
+    std::string prefix = stream.substr(0, len);
+    bool boundary = std::find(boundaries.begin(), boundaries.end(), len) !=
+                    boundaries.end();
+    EXPECT_EQ(boundary ? kUpb_DecodeStatus_Ok : kUpb_DecodeStatus_Malformed,
+              upb_DelimitedRecords_Split(prefix.data(), prefix.size(), arena,
+                                         &records, &count))
+        << len;
+  }
+
+  // Overlong length prefix.
+  std::string bad(11, '\xff');
+  EXPECT_EQ(kUpb_DecodeStatus_Malformed,
+            upb_DelimitedRecords_Split(bad.data(), bad.size(), arena, &records,
+                                       &count));
+
+  upb_Arena_Free(arena);
+}
+
+TEST(DecodeDelimitedTest, StopsAtFirstBadRecord) {
+  upb_Arena* arena = upb_Arena_New();
+  const upb_MiniTable* mt = BuildMiniTable(arena);
+  std::string stream = BuildStream(mt, 2, arena);
+  // A record holding a truncated varint field.
+  stream += Delimited("\x08\x80");
+  stream += BuildStream(mt, 1, arena);
+
+  upb_StringView* records;
+  size_t count;
+  ASSERT_EQ(kUpb_DecodeStatus_Ok,
+            upb_DelimitedRecords_Split(stream.data(), stream.size(), arena,
+                                       &records, &count));
+  ASSERT_EQ(4u, count);
+  std::vector<upb_Message*> msgs(count);
+  size_t decoded;
+  EXPECT_EQ(kUpb_DecodeStatus_Malformed,
+            upb_DecodeRecords(records, count, mt, nullptr, 0, arena,
+                              msgs.data(), &decoded));
+  EXPECT_EQ(2u, decoded);
+  upb_Arena_Free(arena);
+}
+
+TEST(DecodeDelimitedTest, ParallelDecodeIntoFusedArenas) {
+  upb_Arena* arena = upb_Arena_New();
+  const upb_MiniTable* mt = BuildMiniTable(arena);
+  const size_t kRecords = 1000;
+  const int kThreads = 4;
+  std::string stream = BuildStream(mt, kRecords, arena);
+
+  upb_StringView* records;
+  size_t count;
+  ASSERT_EQ(kUpb_DecodeStatus_Ok,
+            upb_DelimitedRecords_Split(stream.data(), stream.size(), arena,
+                                       &records, &count));
+  ASSERT_EQ(kRecords, count);
+
+  std::vector<upb_Message*> msgs(count);
+  std::vector<upb_Arena*> arenas(kThreads);
+  std::vector<upb_DecodeStatus> statuses(kThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    arenas[t] = upb_Arena_New();
+    threads.emplace_back([&, t] {
+      size_t begin = count * t / kThreads;
+      size_t end = count * (t + 1) / kThreads;
+      size_t decoded;
+      statuses[t] =
+          upb_DecodeRecords(records + begin, end - begin, mt, nullptr, 0,
+                            arenas[t], msgs.data() + begin, &decoded);
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  for (int t = 0; t < kThreads; t++) {
+    EXPECT_EQ(kUpb_DecodeStatus_Ok, statuses[t]);
+    ASSERT_TRUE(upb_Arena_Fuse(arena, arenas[t]));
+    upb_Arena_Free(arenas[t]);
+  }
+
+  // The messages now live as long as `arena`.
+  for (size_t i = 0; i < kRecords; i++) CheckRecord(mt, msgs[i], i);
+  upb_Arena_Free(arena);
+}
+
+}  // namespace
@@ -40,6 +40,7 @@
 
 #include "upb/wire/decode_fast.h"
 
+#include "upb/base/internal/log2.h"
 #include "upb/collections/internal/array.h"
 #include "upb/wire/internal/decode.h"
 
@@ -182,21 +183,29 @@ typedef struct {
   uint32_t tag;
 } fastdecode_nextret;
 
+// Grows the array so that at least |count| more elements fit after |dst|.
+UPB_NOINLINE
+static void* fastdecode_growarr(upb_Decoder* d, void* dst, fastdecode_arr* farr,
+                                int valbytes, size_t count) {
+  char* old_ptr = _upb_array_ptr(farr->arr);
+  size_t old_size = farr->arr->capacity;
+  size_t used = ((char*)dst - old_ptr) / valbytes;
+  size_t new_size = UPB_MAX(old_size * 2, used + count);
+  char* new_ptr = upb_Arena_Realloc(&d->arena, old_ptr, old_size * valbytes,
+                                    new_size * valbytes);
+  if (!new_ptr) _upb_FastDecoder_ErrorJmp(d, kUpb_DecodeStatus_OutOfMemory);
+  uint8_t elem_size_lg2 = upb_Log2Ceiling(valbytes);
+  farr->arr->capacity = new_size;
+  farr->arr->data = _upb_array_tagptr(new_ptr, elem_size_lg2);
+  farr->end = (void*)(new_ptr + (new_size * valbytes));
+  return (void*)(new_ptr + (used * valbytes));
+}
+
 UPB_FORCEINLINE
 static void* fastdecode_resizearr(upb_Decoder* d, void* dst,
                                   fastdecode_arr* farr, int valbytes) {
   if (UPB_UNLIKELY(dst == farr->end)) {
-    size_t old_size = farr->arr->capacity;
-    size_t old_bytes = old_size * valbytes;
-    size_t new_size = old_size * 2;
-    size_t new_bytes = new_size * valbytes;
-    char* old_ptr = _upb_array_ptr(farr->arr);
-    char* new_ptr = upb_Arena_Realloc(&d->arena, old_ptr, old_bytes, new_bytes);
-    uint8_t elem_size_lg2 = __builtin_ctz(valbytes);
-    farr->arr->capacity = new_size;
-    farr->arr->data = _upb_array_tagptr(new_ptr, elem_size_lg2);
-    dst = (void*)(new_ptr + (old_size * valbytes));
-    farr->end = (void*)(new_ptr + (new_size * valbytes));
+    dst = fastdecode_growarr(d, dst, farr, valbytes, 1);
   }
   return dst;
 }
@@ -270,7 +279,7 @@ static void* fastdecode_getfield(upb_Decoder* d, const char* ptr,
     }
     case CARD_r: {
       // Get pointer to upb_Array and allocate/expand if necessary.
-      uint8_t elem_size_lg2 = __builtin_ctz(valbytes);
+      uint8_t elem_size_lg2 = upb_Log2Ceiling(valbytes);
       upb_Array** arr_p = fastdecode_fieldmem(msg, *data);
       char* begin;
       *(uint32_t*)msg |= *hasbits;
@@ -406,6 +415,13 @@ static const char* fastdecode_topackedvarint(upb_EpsCopyInputStream* e,
   void* dst = data->dst;
   uint64_t val;
 
+  // Make room for every varint that is already in the buffer at once.
+  size_t count = _upb_Decoder_CountVarints(ptr, e->limit_ptr);
+  size_t avail = ((char*)data->farr.end - (char*)dst) / data->valbytes;
+  if (count > avail) {
+    dst = fastdecode_growarr(d, dst, &data->farr, data->valbytes, count);
+  }
+
   while (!_upb_Decoder_IsDone(d, &ptr)) {
     dst = fastdecode_resizearr(d, dst, &data->farr, data->valbytes);
     ptr = fastdecode_varint64(ptr, &val);
@@ -557,21 +573,26 @@ TAGBYTES(p)
                                                                             \
   upb_Array** arr_p = fastdecode_fieldmem(msg, data);                       \
   upb_Array* arr = *arr_p;                                                  \
-  uint8_t elem_size_lg2 = __builtin_ctz(valbytes);                          \
+  uint8_t elem_size_lg2 = upb_Log2Ceiling(valbytes);                        \
   int elems = size / valbytes;                                              \
                                                                             \
+  size_t old_elems = 0;                                                      \
   if (UPB_LIKELY(!arr)) {                                                   \
     *arr_p = arr = _upb_Array_New(&d->arena, elems, elem_size_lg2);         \
     if (!arr) {                                                             \
-      _upb_FastDecoder_ErrorJmp(d, kUpb_DecodeStatus_Malformed);            \
+      _upb_FastDecoder_ErrorJmp(d, kUpb_DecodeStatus_OutOfMemory);          \
     }                                                                       \
   } else {                                                                  \
-    _upb_Array_ResizeUninitialized(arr, elems, &d->arena);                  \
+    old_elems = arr->size;                                                  \
+    if (!_upb_Array_ResizeUninitialized(arr, old_elems + elems,             \
+                                        &d->arena)) {                       \
+      _upb_FastDecoder_ErrorJmp(d, kUpb_DecodeStatus_OutOfMemory);          \
+    }                                                                       \
   }                                                                         \
                                                                             \
-  char* dst = _upb_array_ptr(arr);                                          \
+  char* dst = (char*)_upb_array_ptr(arr) + old_elems * valbytes;            \
   memcpy(dst, ptr, size);                                                   \
-  arr->size = elems;                                                        \
+  arr->size = old_elems + elems;                                            \
                                                                             \
   ptr += size;                                                              \
   UPB_MUSTTAIL return fastdecode_dispatch(UPB_PARSE_ARGS);
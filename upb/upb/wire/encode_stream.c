@@ -0,0 +1,672 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google LLC.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Two-pass forward encoder. The first pass walks the message exactly like the
+// second one but only counts bytes, recording the length of each delimited
+// region (submessage, map entry, packed field) in the order its header will be
+// written. The second pass replays the same walk, consuming those lengths and
+// copying bytes into the output stream's buffers.
+
+#include "upb/wire/encode_stream.h"
+
+#include <string.h>
+
+#include "upb/collections/internal/array.h"
+#include "upb/collections/internal/map_sorter.h"
+#include "upb/message/internal/accessors.h"
+#include "upb/message/internal/extension.h"
+#include "upb/mini_table/sub.h"
+#include "upb/wire/internal/common.h"
+#include "upb/wire/internal/swap.h"
+
+// Must be last.
+#include "upb/port/def.inc"
+
+#define UPB_PB_VARINT_MAX_LEN 10
+
+static size_t encode_varint64(uint64_t val, char* buf) {
+  size_t i = 0;
+  do {
+    uint8_t byte = val & 0x7fU;
+    val >>= 7;
+    if (val) byte |= 0x80U;
+    buf[i++] = byte;
+  } while (val);
+  return i;
+}
+
+static size_t encode_varint64_size(uint64_t val) {
+  size_t i = 1;
+  while (val >= 0x80U) {
+    val >>= 7;
+    i++;
+  }
+  return i;
+}
+
+static uint32_t encode_zz32(int32_t n) {
+  return ((uint32_t)n << 1) ^ (n >> 31);
+}
+static uint64_t encode_zz64(int64_t n) {
+  return ((uint64_t)n << 1) ^ (n >> 63);
+}
+
+typedef struct {
+  upb_EncodeStatus status;
+  jmp_buf err;
+  upb_Arena* arena;
+  upb_ZeroCopyOutputStream* output;
+  upb_Status* output_status;
+  char *ptr, *limit;  // Current output buffer, write pass only.
+  size_t* lens;       // Delimited lengths, in the order they are written.
+  size_t lens_size, lens_cap;
+  size_t lens_pos;  // Next entry of lens to be written.
+  size_t bytes;     // Bytes counted so far, size pass only.
+  bool sizing;
+  int options;
+  int depth;
+  _upb_mapsorter sorter;
+} upb_encstream;
+
+UPB_NORETURN static void encode_err(upb_encstream* e, upb_EncodeStatus s) {
+  UPB_ASSERT(s != kUpb_EncodeStatus_Ok);
+  e->status = s;
+  UPB_LONGJMP(e->err, 1);
+}
+
+UPB_NOINLINE
+static void encode_nextbuf(upb_encstream* e) {
+  size_t count;
+  void* buf = upb_ZeroCopyOutputStream_Next(e->output, &count, e->output_status);
+  if (!buf) {
+    if (upb_Status_IsOk(e->output_status)) {
+      upb_Status_SetErrorMessage(e->output_status, "output stream hit EOF");
+    }
+    encode_err(e, kUpb_EncodeStatus_OutputError);
+  }
+  e->ptr = buf;
+  e->limit = e->ptr + count;
+}
+
+/* Writes the given bytes to the stream, spanning as many buffers as needed. */
+static void encode_bytes(upb_encstream* e, const void* data, size_t len) {
+  const char* src = data;
+  if (e->sizing) {
+    e->bytes += len;
+    return;
+  }
+  while (len) {
+    size_t n;
+    if (e->ptr == e->limit) encode_nextbuf(e);
+    n = UPB_MIN(len, (size_t)(e->limit - e->ptr));
+    memcpy(e->ptr, src, n);
+    e->ptr += n;
+    src += n;
+    len -= n;
+  }
+}
+
+static void encode_fixed64(upb_encstream* e, uint64_t val) {
+  val = _upb_BigEndian_Swap64(val);
+  encode_bytes(e, &val, sizeof(uint64_t));
+}
+
+static void encode_fixed32(upb_encstream* e, uint32_t val) {
+  val = _upb_BigEndian_Swap32(val);
+  encode_bytes(e, &val, sizeof(uint32_t));
+}
+
+UPB_FORCEINLINE
+static void encode_varint(upb_encstream* e, uint64_t val) {
+  char buf[UPB_PB_VARINT_MAX_LEN];
+  if (e->sizing) {
+    e->bytes += encode_varint64_size(val);
+  } else if ((size_t)(e->limit - e->ptr) >= UPB_PB_VARINT_MAX_LEN) {
+    e->ptr += encode_varint64(val, e->ptr);
+  } else {
+    encode_bytes(e, buf, encode_varint64(val, buf));
+  }
+}
+
+static void encode_double(upb_encstream* e, double d) {
+  uint64_t u64;
+  UPB_ASSERT(sizeof(double) == sizeof(uint64_t));
+  memcpy(&u64, &d, sizeof(uint64_t));
+  encode_fixed64(e, u64);
+}
+
+static void encode_float(upb_encstream* e, float d) {
+  uint32_t u32;
+  UPB_ASSERT(sizeof(float) == sizeof(uint32_t));
+  memcpy(&u32, &d, sizeof(uint32_t));
+  encode_fixed32(e, u32);
+}
+
+static void encode_tag(upb_encstream* e, uint32_t field_number,
+                       uint8_t wire_type) {
+  encode_varint(e, (field_number << 3) | wire_type);
+}
+
+UPB_NOINLINE
+static void encode_growlens(upb_encstream* e) {
+  size_t old_cap = e->lens_cap;
+  size_t new_cap = old_cap ? old_cap * 2 : 64;
+  size_t* lens = upb_Arena_Realloc(e->arena, e->lens, old_cap * sizeof(size_t),
+                                   new_cap * sizeof(size_t));
+  if (!lens) encode_err(e, kUpb_EncodeStatus_OutOfMemory);
+  e->lens = lens;
+  e->lens_cap = new_cap;
+}
+
+/* Starts a length-delimited region. The size pass reserves a slot for the
+ * length and returns it; the write pass emits the length the slot recorded. */
+static size_t encode_startdelim(upb_encstream* e) {
+  if (!e->sizing) {
+    UPB_ASSERT(e->lens_pos < e->lens_size);
+    encode_varint(e, e->lens[e->lens_pos++]);
+    return 0;
+  }
+  if (e->lens_size == e->lens_cap) encode_growlens(e);
+  e->lens[e->lens_size] = e->bytes;
+  return e->lens_size++;
+}
+
+static void encode_enddelim(upb_encstream* e, size_t slot) {
+  size_t len;
+  if (!e->sizing) return;
+  len = e->bytes - e->lens[slot];
+  e->lens[slot] = len;
+  e->bytes += encode_varint64_size(len);
+}
+
+static void encode_fixedarray(upb_encstream* e, const upb_Array* arr,
+                              size_t elem_size, uint32_t tag) {
+  size_t bytes = arr->size * elem_size;
+  const char* data = _upb_array_constptr(arr);
+  const char* end = data + bytes;
+
+  if (tag || !_upb_IsLittleEndian()) {
+    const char* ptr;
+    for (ptr = data; ptr != end; ptr += elem_size) {
+      if (tag) encode_varint(e, tag);
+      if (elem_size == 4) {
+        uint32_t val;
+        memcpy(&val, ptr, sizeof(val));
+        encode_fixed32(e, val);
+      } else {
+        uint64_t val;
+        UPB_ASSERT(elem_size == 8);
+        memcpy(&val, ptr, sizeof(val));
+        encode_fixed64(e, val);
+      }
+    }
+  } else {
+    encode_bytes(e, data, bytes);
+  }
+}
+
+static void encode_message(upb_encstream* e, const upb_Message* msg,
+                           const upb_MiniTable* m);
+
+static void encode_TaggedMessagePtr(upb_encstream* e,
+                                    upb_TaggedMessagePtr tagged,
+                                    const upb_MiniTable* m) {
+  if (upb_TaggedMessagePtr_IsEmpty(tagged)) {
+    m = &_kUpb_MiniTable_Empty;
+  }
+  encode_message(e, _upb_TaggedMessagePtr_GetMessage(tagged), m);
+}
+
+static void encode_scalar(upb_encstream* e, const void* _field_mem,
+                          const upb_MiniTableSub* subs,
+                          const upb_MiniTableField* f) {
+  const char* field_mem = _field_mem;
+
+#define CASE(ctype, type, wtype, encodeval) \
+  {                                         \
+    ctype val = *(ctype*)field_mem;         \
+    encode_tag(e, f->number, wtype);        \
+    encode_##type(e, encodeval);            \
+    return;                                 \
+  }
+
+  switch (f->UPB_PRIVATE(descriptortype)) {
+    case kUpb_FieldType_Double:
+      CASE(double, double, kUpb_WireType_64Bit, val);
+    case kUpb_FieldType_Float:
+      CASE(float, float, kUpb_WireType_32Bit, val);
+    case kUpb_FieldType_Int64:
+    case kUpb_FieldType_UInt64:
+      CASE(uint64_t, varint, kUpb_WireType_Varint, val);
+    case kUpb_FieldType_UInt32:
+      CASE(uint32_t, varint, kUpb_WireType_Varint, val);
+    case kUpb_FieldType_Int32:
+    case kUpb_FieldType_Enum:
+      CASE(int32_t, varint, kUpb_WireType_Varint, (int64_t)val);
+    case kUpb_FieldType_SFixed64:
+    case kUpb_FieldType_Fixed64:
+      CASE(uint64_t, fixed64, kUpb_WireType_64Bit, val);
+    case kUpb_FieldType_Fixed32:
+    case kUpb_FieldType_SFixed32:
+      CASE(uint32_t, fixed32, kUpb_WireType_32Bit, val);
+    case kUpb_FieldType_Bool:
+      CASE(bool, varint, kUpb_WireType_Varint, val);
+    case kUpb_FieldType_SInt32:
+      CASE(int32_t, varint, kUpb_WireType_Varint, encode_zz32(val));
+    case kUpb_FieldType_SInt64:
+      CASE(int64_t, varint, kUpb_WireType_Varint, encode_zz64(val));
+    case kUpb_FieldType_String:
+    case kUpb_FieldType_Bytes: {
+      upb_StringView view = *(upb_StringView*)field_mem;
+      encode_tag(e, f->number, kUpb_WireType_Delimited);
+      encode_varint(e, view.size);
+      encode_bytes(e, view.data, view.size);
+      return;
+    }
+    case kUpb_FieldType_Group: {
+      upb_TaggedMessagePtr submsg = *(upb_TaggedMessagePtr*)field_mem;
+      const upb_MiniTable* subm = subs[f->UPB_PRIVATE(submsg_index)].submsg;
+      if (submsg == 0) {
+        return;
+      }
+      if (--e->depth == 0) encode_err(e, kUpb_EncodeStatus_MaxDepthExceeded);
+      encode_tag(e, f->number, kUpb_WireType_StartGroup);
+      encode_TaggedMessagePtr(e, submsg, subm);
+      encode_tag(e, f->number, kUpb_WireType_EndGroup);
+      e->depth++;
+      return;
+    }
+    case kUpb_FieldType_Message: {
+      size_t slot;
+      upb_TaggedMessagePtr submsg = *(upb_TaggedMessagePtr*)field_mem;
+      const upb_MiniTable* subm = subs[f->UPB_PRIVATE(submsg_index)].submsg;
+      if (submsg == 0) {
+        return;
+      }
+      if (--e->depth == 0) encode_err(e, kUpb_EncodeStatus_MaxDepthExceeded);
+      encode_tag(e, f->number, kUpb_WireType_Delimited);
+      slot = encode_startdelim(e);
+      encode_TaggedMessagePtr(e, submsg, subm);
+      encode_enddelim(e, slot);
+      e->depth++;
+      return;
+    }
+    default:
+      UPB_UNREACHABLE();
+  }
+#undef CASE
+}
+
+static void encode_array(upb_encstream* e, const upb_Message* msg,
+                         const upb_MiniTableSub* subs,
+                         const upb_MiniTableField* f) {
+  const upb_Array* arr = *UPB_PTR_AT(msg, f->offset, upb_Array*);
+  bool packed = f->mode & kUpb_LabelFlags_IsPacked;
+  size_t slot = 0;
+
+  if (arr == NULL || arr->size == 0) {
+    return;
+  }
+
+  if (packed) {
+    encode_tag(e, f->number, kUpb_WireType_Delimited);
+    slot = encode_startdelim(e);
+  }
+
+#define VARINT_CASE(ctype, encode)                                       \
+  {                                                                      \
+    const ctype* ptr = _upb_array_constptr(arr);                         \
+    const ctype* end = ptr + arr->size;                                  \
+    uint32_t tag = packed ? 0 : (f->number << 3) | kUpb_WireType_Varint; \
+    for (; ptr != end; ptr++) {                                          \
+      if (tag) encode_varint(e, tag);                                    \
+      encode_varint(e, encode);                                          \
+    }                                                                    \
+  }                                                                      \
+  break;
+
+#define TAG(wire_type) (packed ? 0 : (f->number << 3 | wire_type))
+
+  switch (f->UPB_PRIVATE(descriptortype)) {
+    case kUpb_FieldType_Double:
+      encode_fixedarray(e, arr, sizeof(double), TAG(kUpb_WireType_64Bit));
+      break;
+    case kUpb_FieldType_Float:
+      encode_fixedarray(e, arr, sizeof(float), TAG(kUpb_WireType_32Bit));
+      break;
+    case kUpb_FieldType_SFixed64:
+    case kUpb_FieldType_Fixed64:
+      encode_fixedarray(e, arr, sizeof(uint64_t), TAG(kUpb_WireType_64Bit));
+      break;
+    case kUpb_FieldType_Fixed32:
+    case kUpb_FieldType_SFixed32:
+      encode_fixedarray(e, arr, sizeof(uint32_t), TAG(kUpb_WireType_32Bit));
+      break;
+    case kUpb_FieldType_Int64:
+    case kUpb_FieldType_UInt64:
+      VARINT_CASE(uint64_t, *ptr);
+    case kUpb_FieldType_UInt32:
+      VARINT_CASE(uint32_t, *ptr);
+    case kUpb_FieldType_Int32:
+    case kUpb_FieldType_Enum:
+      VARINT_CASE(int32_t, (int64_t)*ptr);
+    case kUpb_FieldType_Bool:
+      VARINT_CASE(bool, *ptr);
+    case kUpb_FieldType_SInt32:
+      VARINT_CASE(int32_t, encode_zz32(*ptr));
+    case kUpb_FieldType_SInt64:
+      VARINT_CASE(int64_t, encode_zz64(*ptr));
+    case kUpb_FieldType_String:
+    case kUpb_FieldType_Bytes: {
+      const upb_StringView* ptr = _upb_array_constptr(arr);
+      const upb_StringView* end = ptr + arr->size;
+      for (; ptr != end; ptr++) {
+        encode_tag(e, f->number, kUpb_WireType_Delimited);
+        encode_varint(e, ptr->size);
+        encode_bytes(e, ptr->data, ptr->size);
+      }
+      return;
+    }
+    case kUpb_FieldType_Group: {
+      const upb_TaggedMessagePtr* ptr = _upb_array_constptr(arr);
+      const upb_TaggedMessagePtr* end = ptr + arr->size;
+      const upb_MiniTable* subm = subs[f->UPB_PRIVATE(submsg_index)].submsg;
+      if (--e->depth == 0) encode_err(e, kUpb_EncodeStatus_MaxDepthExceeded);
+      for (; ptr != end; ptr++) {
+        encode_tag(e, f->number, kUpb_WireType_StartGroup);
+        encode_TaggedMessagePtr(e, *ptr, subm);
+        encode_tag(e, f->number, kUpb_WireType_EndGroup);
+      }
+      e->depth++;
+      return;
+    }
+    case kUpb_FieldType_Message: {
+      const upb_TaggedMessagePtr* ptr = _upb_array_constptr(arr);
+      const upb_TaggedMessagePtr* end = ptr + arr->size;
+      const upb_MiniTable* subm = subs[f->UPB_PRIVATE(submsg_index)].submsg;
+      if (--e->depth == 0) encode_err(e, kUpb_EncodeStatus_MaxDepthExceeded);
+      for (; ptr != end; ptr++) {
+        size_t msg_slot;
+        encode_tag(e, f->number, kUpb_WireType_Delimited);
+        msg_slot = encode_startdelim(e);
+        encode_TaggedMessagePtr(e, *ptr, subm);
+        encode_enddelim(e, msg_slot);
+      }
+      e->depth++;
+      return;
+    }
+  }
+#undef VARINT_CASE
+#undef TAG
+
+  if (packed) encode_enddelim(e, slot);
+}
+
+static void encode_mapentry(upb_encstream* e, uint32_t number,
+                            const upb_MiniTable* layout,
+                            const upb_MapEntry* ent) {
+  const upb_MiniTableField* key_field = &layout->fields[0];
+  const upb_MiniTableField* val_field = &layout->fields[1];
+  size_t slot;
+  encode_tag(e, number, kUpb_WireType_Delimited);
+  slot = encode_startdelim(e);
+  encode_scalar(e, &ent->data.k, layout->subs, key_field);
+  encode_scalar(e, &ent->data.v, layout->subs, val_field);
+  encode_enddelim(e, slot);
+}
+
+static void encode_map(upb_encstream* e, const upb_Message* msg,
+                       const upb_MiniTableSub* subs,
+                       const upb_MiniTableField* f) {
+  const upb_Map* map = *UPB_PTR_AT(msg, f->offset, const upb_Map*);
+  const upb_MiniTable* layout = subs[f->UPB_PRIVATE(submsg_index)].submsg;
+  UPB_ASSERT(layout->field_count == 2);
+
+  if (map == NULL) return;
+
+  if (e->options & kUpb_EncodeOption_Deterministic) {
+    // upb_Encode() writes sorted entries back to front, so visit them in
+    // reverse to produce the same bytes.
+    _upb_sortedmap sorted;
+    int i;
+    if (!_upb_mapsorter_pushmap(&e->sorter,
+                                layout->fields[0].UPB_PRIVATE(descriptortype),
+                                map, &sorted)) {
+      encode_err(e, kUpb_EncodeStatus_OutOfMemory);
+    }
+    for (i = sorted.end; i > sorted.start; i--) {
+      upb_MapEntry ent;
+      sorted.pos = i - 1;
+      _upb_sortedmap_next(&e->sorter, map, &sorted, &ent);
+      encode_mapentry(e, f->number, layout, &ent);
+    }
+    _upb_mapsorter_popmap(&e->sorter, &sorted);
+  } else {
+    intptr_t iter = UPB_STRTABLE_BEGIN;
+    upb_StringView key;
+    upb_value val;
+    while (upb_strtable_next2(&map->table, &key, &val, &iter)) {
+      upb_MapEntry ent;
+      _upb_map_fromkey(key, &ent.data.k, map->key_size);
+      _upb_map_fromvalue(val, &ent.data.v, map->val_size);
+      encode_mapentry(e, f->number, layout, &ent);
+    }
+  }
+}
+
+static bool encode_shouldencode(const upb_Message* msg,
+                                const upb_MiniTableField* f) {
+  if (f->presence == 0) {
+    /* Proto3 presence or map/array. */
+    const void* mem = UPB_PTR_AT(msg, f->offset, void);
+    switch (_upb_MiniTableField_GetRep(f)) {
+      case kUpb_FieldRep_1Byte: {
+        char ch;
+        memcpy(&ch, mem, 1);
+        return ch != 0;
+      }
+      case kUpb_FieldRep_4Byte: {
+        uint32_t u32;
+        memcpy(&u32, mem, 4);
+        return u32 != 0;
+      }
+      case kUpb_FieldRep_8Byte: {
+        uint64_t u64;
+        memcpy(&u64, mem, 8);
+        return u64 != 0;
+      }
+      case kUpb_FieldRep_StringView: {
+        const upb_StringView* str = (const upb_StringView*)mem;
+        return str->size != 0;
+      }
+      default:
+        UPB_UNREACHABLE();
+    }
+  } else if (f->presence > 0) {
+    /* Proto2 presence: hasbit. */
+    return _upb_hasbit_field(msg, f);
+  } else {
+    /* Field is in a oneof. */
+    return _upb_getoneofcase_field(msg, f) == f->number;
+  }
+}
+
+static void encode_field(upb_encstream* e, const upb_Message* msg,
+                         const upb_MiniTableSub* subs,
+                         const upb_MiniTableField* field) {
+  switch (upb_FieldMode_Get(field)) {
+    case kUpb_FieldMode_Array:
+      encode_array(e, msg, subs, field);
+      break;
+    case kUpb_FieldMode_Map:
+      encode_map(e, msg, subs, field);
+      break;
+    case kUpb_FieldMode_Scalar:
+      encode_scalar(e, UPB_PTR_AT(msg, field->offset, void), subs, field);
+      break;
+    default:
+      UPB_UNREACHABLE();
+  }
+}
+
+static void encode_msgset_item(upb_encstream* e,
+                               const upb_Message_Extension* ext) {
+  size_t slot;
+  encode_tag(e, kUpb_MsgSet_Item, kUpb_WireType_StartGroup);
+  encode_tag(e, kUpb_MsgSet_TypeId, kUpb_WireType_Varint);
+  encode_varint(e, ext->ext->field.number);
+  encode_tag(e, kUpb_MsgSet_Message, kUpb_WireType_Delimited);
+  slot = encode_startdelim(e);
+  encode_message(e, ext->data.ptr, ext->ext->sub.submsg);
+  encode_enddelim(e, slot);
+  encode_tag(e, kUpb_MsgSet_Item, kUpb_WireType_EndGroup);
+}
+
+static void encode_ext(upb_encstream* e, const upb_Message_Extension* ext,
+                       bool is_message_set) {
+  if (UPB_UNLIKELY(is_message_set)) {
+    encode_msgset_item(e, ext);
+  } else {
+    encode_field(e, &ext->data, &ext->ext->sub, &ext->ext->field);
+  }
+}
+
+static void encode_message(upb_encstream* e, const upb_Message* msg,
+                           const upb_MiniTable* m) {
+  if ((e->options & kUpb_EncodeOption_CheckRequired) && m->required_count) {
+    uint64_t msg_head;
+    memcpy(&msg_head, msg, 8);
+    msg_head = _upb_BigEndian_Swap64(msg_head);
+    if (upb_MiniTable_requiredmask(m) & ~msg_head) {
+      encode_err(e, kUpb_EncodeStatus_MissingRequired);
+    }
+  }
+
+  if (m->field_count) {
+    const upb_MiniTableField* f = &m->fields[0];
+    const upb_MiniTableField* end = &m->fields[m->field_count];
+    for (; f != end; f++) {
+      if (encode_shouldencode(msg, f)) {
+        encode_field(e, msg, m->subs, f);
+      }
+    }
+  }
+
+  if (m->ext != kUpb_ExtMode_NonExtendable) {
+    /* As in upb_Encode(), extensions come after all regular fields and are
+     * visited in reverse so that both encoders agree byte for byte. */
+    size_t ext_count;
+    const upb_Message_Extension* ext = _upb_Message_Getexts(msg, &ext_count);
+    if (ext_count) {
+      if (e->options & kUpb_EncodeOption_Deterministic) {
+        _upb_sortedmap sorted;
+        int i;
+        if (!_upb_mapsorter_pushexts(&e->sorter, ext, ext_count, &sorted)) {
+          encode_err(e, kUpb_EncodeStatus_OutOfMemory);
+        }
+        for (i = sorted.end; i > sorted.start; i--) {
+          sorted.pos = i - 1;
+          _upb_sortedmap_nextext(&e->sorter, &sorted, &ext);
+          encode_ext(e, ext, m->ext == kUpb_ExtMode_IsMessageSet);
+        }
+        _upb_mapsorter_popmap(&e->sorter, &sorted);
+      } else {
+        const upb_Message_Extension* start = ext;
+        for (ext += ext_count; ext != start;) {
+          ext--;
+          encode_ext(e, ext, m->ext == kUpb_ExtMode_IsMessageSet);
+        }
+      }
+    }
+  }
+
+  if ((e->options & kUpb_EncodeOption_SkipUnknown) == 0) {
+    size_t unknown_size;
+    const char* unknown = upb_Message_GetUnknown(msg, &unknown_size);
+
+    if (unknown) {
+      encode_bytes(e, unknown, unknown_size);
+    }
+  }
+}
+
+static upb_EncodeStatus upb_StreamEncoder_Encode(upb_encstream* const encoder,
+                                                 const void* const msg,
+                                                 const upb_MiniTable* const l) {
+  if (UPB_SETJMP(encoder->err) == 0) {
+    encode_message(encoder, msg, l);
+
+    encoder->sizing = false;
+    encode_message(encoder, msg, l);
+    UPB_ASSERT(encoder->lens_pos == encoder->lens_size);
+
+    // Hand back whatever is left of the last buffer; this also marks a flush
+    // point for the stream.
+    if (encoder->ptr) {
+      upb_ZeroCopyOutputStream_BackUp(encoder->output,
+                                      encoder->limit - encoder->ptr);
+    }
+  } else {
+    UPB_ASSERT(encoder->status != kUpb_EncodeStatus_Ok);
+  }
+
+  _upb_mapsorter_destroy(&encoder->sorter);
+  return encoder->status;
+}
+
+upb_EncodeStatus upb_EncodeToStream(const void* msg, const upb_MiniTable* l,
+                                    int options,
+                                    upb_ZeroCopyOutputStream* output,
+                                    upb_Arena* arena, upb_Status* status) {
+  upb_encstream e;
+  upb_Status dummy_status;
+  unsigned depth = (unsigned)options >> 16;
+
+  if (!status) status = &dummy_status;
+  upb_Status_Clear(status);
+
+  e.status = kUpb_EncodeStatus_Ok;
+  e.arena = arena;
+  e.output = output;
+  e.output_status = status;
+  e.ptr = NULL;
+  e.limit = NULL;
+  e.lens = NULL;
+  e.lens_size = 0;
+  e.lens_cap = 0;
+  e.lens_pos = 0;
+  e.bytes = 0;
+  e.sizing = true;
+  e.depth = depth ? depth : kUpb_WireFormat_DefaultDepthLimit;
+  e.options = options;
+  _upb_mapsorter_init(&e.sorter);
+
+  return upb_StreamEncoder_Encode(&e, msg, l);
+}
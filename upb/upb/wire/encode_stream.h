@@ -0,0 +1,80 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google LLC.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// upb_EncodeToStream: forward, chunked encoding of a upb_Message.
+//
+// upb_Encode() serializes backwards into a single contiguous buffer, which is
+// fast but requires the whole output to be resident (and briefly ~2x that
+// while the buffer grows). upb_EncodeToStream() instead makes two passes: the
+// first computes the length of every delimited region, the second writes the
+// bytes front-to-back into the buffers handed out by a
+// upb_ZeroCopyOutputStream. Aside from the output stream's own buffers, memory
+// use is proportional to the number of submessages, map entries and packed
+// fields rather than to the encoded size.
+//
+// With kUpb_EncodeOption_Deterministic the output is byte-for-byte identical
+// to upb_Encode().
+
+#ifndef UPB_WIRE_ENCODE_STREAM_H_
+#define UPB_WIRE_ENCODE_STREAM_H_
+
+#include "upb/base/status.h"
+#include "upb/io/zero_copy_output_stream.h"
+#include "upb/mem/arena.h"
+#include "upb/mini_table/message.h"
+#include "upb/wire/encode.h"
+
+// Must be last.
+#include "upb/port/def.inc"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Encodes `msg` into `output`. `options` are the same as for upb_Encode().
+// `arena` is only used for the length table built by the first pass.
+//
+// Returns kUpb_EncodeStatus_OutputError if `output` fails or runs out of room,
+// in which case `status` carries the reason. On any error a prefix of the
+// message may already have been written to `output`.
+UPB_API upb_EncodeStatus upb_EncodeToStream(const void* msg,
+                                            const upb_MiniTable* l,
+                                            int options,
+                                            upb_ZeroCopyOutputStream* output,
+                                            upb_Arena* arena,
+                                            upb_Status* status);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#include "upb/port/undef.inc"
+
+#endif /* UPB_WIRE_ENCODE_STREAM_H_ */
@@ -0,0 +1,257 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google LLC.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "upb/wire/encode_stream.h"
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "upb/base/status.h"
+#include "upb/io/chunked_output_stream.h"
+#include "upb/mem/arena.hpp"
+#include "upb/message/message.h"
+#include "upb/mini_descriptor/decode.h"
+#include "upb/mini_descriptor/internal/encode.hpp"
+#include "upb/mini_descriptor/internal/modifiers.h"
+#include "upb/mini_descriptor/link.h"
+#include "upb/mini_table/message.h"
+#include "upb/wire/decode.h"
+#include "upb/wire/encode.h"
+
+namespace {
+
+// message M {
+//   int32 i32 = 1;
+//   string str = 2;
+//   M child = 3;
+//   repeated int32 packed_i32 = 4 [packed = true];
+//   repeated string rep_str = 5;
+//   repeated M rep_child = 6;
+//   map<int32, M> map_child = 7;
+//   double dbl = 8;
+//   repeated fixed64 packed_f64 = 9 [packed = true];
+//   repeated sint64 unpacked_s64 = 10;
+// }
+upb_MiniTable* BuildMiniTable(upb_Arena* arena) {
+  upb::MtDataEncoder e;
+  e.StartMessage(0);
+  e.PutField(kUpb_FieldType_Int32, 1, 0);
+  e.PutField(kUpb_FieldType_String, 2, 0);
+  e.PutField(kUpb_FieldType_Message, 3, 0);
+  e.PutField(kUpb_FieldType_Int32, 4,
+             kUpb_FieldModifier_IsRepeated | kUpb_FieldModifier_IsPacked);
+  e.PutField(kUpb_FieldType_String, 5, kUpb_FieldModifier_IsRepeated);
+  e.PutField(kUpb_FieldType_Message, 6, kUpb_FieldModifier_IsRepeated);
+  e.PutField(kUpb_FieldType_Message, 7, kUpb_FieldModifier_IsRepeated);
+  e.PutField(kUpb_FieldType_Double, 8, 0);
+  e.PutField(kUpb_FieldType_Fixed64, 9,
+             kUpb_FieldModifier_IsRepeated | kUpb_FieldModifier_IsPacked);
+  e.PutField(kUpb_FieldType_SInt64, 10, kUpb_FieldModifier_IsRepeated);
+  upb_Status status;
+  upb_Status_Clear(&status);
+  upb_MiniTable* table =
+      upb_MiniTable_Build(e.data().data(), e.data().size(), arena, &status);
+  EXPECT_TRUE(upb_Status_IsOk(&status));
+
+  upb::MtDataEncoder map_e;
+  map_e.EncodeMap(kUpb_FieldType_Int32, kUpb_FieldType_Message, 0, 0);
+  upb_MiniTable* entry = upb_MiniTable_Build(
+      map_e.data().data(), map_e.data().size(), arena, &status);
+  EXPECT_TRUE(upb_Status_IsOk(&status));
+
+  auto field = [table](uint32_t number) {
+    return const_cast<upb_MiniTableField*>(
+        upb_MiniTable_FindFieldByNumber(table, number));
+  };
+  EXPECT_TRUE(upb_MiniTable_SetSubMessage(table, field(3), table));
+  EXPECT_TRUE(upb_MiniTable_SetSubMessage(table, field(6), table));
+  EXPECT_TRUE(upb_MiniTable_SetSubMessage(table, field(7), entry));
+  EXPECT_TRUE(upb_MiniTable_SetSubMessage(
+      entry, const_cast<upb_MiniTableField*>(&entry->fields[1]), table));
+  return table;
+}
+
+std::string Varint(uint64_t val) {
+  std::string ret;
+  do {
+    char byte = val & 0x7f;
+    val >>= 7;
+    if (val) byte |= 0x80;
+    ret.push_back(byte);
+  } while (val);
+  return ret;
+}
+
+std::string Tag(uint32_t number, int wire_type) {
+  return Varint((number << 3) | wire_type);
+}
+
+std::string Delimited(uint32_t number, const std::string& data) {
+  return Tag(number, kUpb_WireType_Delimited) + Varint(data.size()) + data;
+}
+
+// Builds a tree of messages `depth` levels deep with strings and repeated
+// fields large enough to span many output buffers.
+std::string Payload(int depth) {
+  std::string ret;
+  ret += Tag(1, kUpb_WireType_Varint) + Varint(depth * 1000);
+  ret += Delimited(2, std::string(300 + depth, 'a' + depth));
+  if (depth > 0) ret += Delimited(3, Payload(depth - 1));
+  std::string packed;
+  for (int i = 0; i < 200; i++) packed += Varint(i * 131);
+  ret += Delimited(4, packed);
+  ret += Delimited(5, "x");
+  ret += Delimited(5, "");
+  ret += Delimited(5, std::string(1000, 'z'));
+  if (depth > 0) {
+    ret += Delimited(6, Payload(depth - 1));
+    ret += Delimited(6, "");
+    for (int key : {5, -3, 17}) {
+      ret += Delimited(7, Tag(1, kUpb_WireType_Varint) + Varint(key) +
+                              Delimited(2, Payload(depth - 1)));
+    }
+  }
+  ret += Tag(8, kUpb_WireType_64Bit) +
+         std::string("\x00\x00\x00\x00\x00\x00\xf0\x3f", 8);
+  ret += Delimited(9, std::string(64, '\x5a'));
+  for (int i = 0; i < 20; i++) {
+    ret += Tag(10, kUpb_WireType_Varint) + Varint(i * 7);
+  }
+  // Unknown field.
+  ret += Tag(99, kUpb_WireType_Varint) + Varint(12345);
+  return ret;
+}
+
+upb_Message* Parse(const std::string& payload, const upb_MiniTable* table,
+                   upb_Arena* arena) {
+  upb_Message* msg = upb_Message_New(table, arena);
+  EXPECT_EQ(kUpb_DecodeStatus_Ok, upb_Decode(payload.data(), payload.size(),
+                                             msg, table, nullptr, 0, arena));
+  return msg;
+}
+
+std::string EncodeFlat(const upb_Message* msg, const upb_MiniTable* table,
+                       int options, upb_Arena* arena) {
+  char* buf;
+  size_t size;
+  EXPECT_EQ(kUpb_EncodeStatus_Ok,
+            upb_Encode(msg, table, options, arena, &buf, &size));
+  return std::string(buf, size);
+}
+
+TEST(EncodeStreamTest, MatchesFlatEncoder) {
+  upb::Arena arena;
+  upb_MiniTable* table = BuildMiniTable(arena.ptr());
+  upb_Message* msg = Parse(Payload(3), table, arena.ptr());
+  std::string expected = EncodeFlat(msg, table, kUpb_EncodeOption_Deterministic,
+                                    arena.ptr());
+  ASSERT_GT(expected.size(), 10000);
+
+  for (size_t chunk : {1, 2, 3, 7, 64, 4096, 1 << 20}) {
+    SCOPED_TRACE(chunk);
+    std::vector<char> buf(expected.size());
+    upb_ZeroCopyOutputStream* output = upb_ChunkedOutputStream_New(
+        buf.data(), buf.size(), chunk, arena.ptr());
+    upb_Status status;
+    EXPECT_EQ(kUpb_EncodeStatus_Ok,
+              upb_EncodeToStream(msg, table, kUpb_EncodeOption_Deterministic,
+                                 output, arena.ptr(), &status));
+    EXPECT_TRUE(upb_Status_IsOk(&status));
+    EXPECT_EQ(expected.size(), upb_ZeroCopyOutputStream_ByteCount(output));
+    EXPECT_EQ(expected, std::string(buf.data(), buf.size()));
+  }
+}
+
+TEST(EncodeStreamTest, RoundTripsNonDeterministic) {
+  upb::Arena arena;
+  upb_MiniTable* table = BuildMiniTable(arena.ptr());
+  upb_Message* msg = Parse(Payload(2), table, arena.ptr());
+  std::string expected = EncodeFlat(msg, table, kUpb_EncodeOption_Deterministic,
+                                    arena.ptr());
+
+  std::vector<char> buf(expected.size());
+  upb_ZeroCopyOutputStream* output =
+      upb_ChunkedOutputStream_New(buf.data(), buf.size(), 5, arena.ptr());
+  EXPECT_EQ(kUpb_EncodeStatus_Ok,
+            upb_EncodeToStream(msg, table, 0, output, arena.ptr(), nullptr));
+  ASSERT_EQ(expected.size(), upb_ZeroCopyOutputStream_ByteCount(output));
+
+  // Map order is unspecified, so compare after a deterministic re-encode.
+  upb_Message* reparsed =
+      Parse(std::string(buf.data(), buf.size()), table, arena.ptr());
+  EXPECT_EQ(expected, EncodeFlat(reparsed, table,
+                                 kUpb_EncodeOption_Deterministic, arena.ptr()));
+}
+
+TEST(EncodeStreamTest, EmptyMessage) {
+  upb::Arena arena;
+  upb_MiniTable* table = BuildMiniTable(arena.ptr());
+  upb_Message* msg = upb_Message_New(table, arena.ptr());
+  char buf[1];
+  upb_ZeroCopyOutputStream* output =
+      upb_ChunkedOutputStream_New(buf, 0, 1, arena.ptr());
+  EXPECT_EQ(kUpb_EncodeStatus_Ok,
+            upb_EncodeToStream(msg, table, 0, output, arena.ptr(), nullptr));
+  EXPECT_EQ(0, upb_ZeroCopyOutputStream_ByteCount(output));
+}
+
+TEST(EncodeStreamTest, OutputTooSmall) {
+  upb::Arena arena;
+  upb_MiniTable* table = BuildMiniTable(arena.ptr());
+  upb_Message* msg = Parse(Payload(1), table, arena.ptr());
+  std::string expected = EncodeFlat(msg, table, 0, arena.ptr());
+
+  std::vector<char> buf(expected.size() - 1);
+  upb_ZeroCopyOutputStream* output =
+      upb_ChunkedOutputStream_New(buf.data(), buf.size(), 16, arena.ptr());
+  upb_Status status;
+  EXPECT_EQ(kUpb_EncodeStatus_OutputError,
+            upb_EncodeToStream(msg, table, 0, output, arena.ptr(), &status));
+  EXPECT_FALSE(upb_Status_IsOk(&status));
+}
+
+TEST(EncodeStreamTest, MaxDepthExceededWritesNothing) {
+  upb::Arena arena;
+  upb_MiniTable* table = BuildMiniTable(arena.ptr());
+  upb_Message* msg = Parse(Payload(3), table, arena.ptr());
+
+  std::vector<char> buf(1 << 20);
+  upb_ZeroCopyOutputStream* output =
+      upb_ChunkedOutputStream_New(buf.data(), buf.size(), 64, arena.ptr());
+  EXPECT_EQ(kUpb_EncodeStatus_MaxDepthExceeded,
+            upb_EncodeToStream(msg, table, upb_EncodeOptions_MaxDepth(2),
+                               output, arena.ptr(), nullptr));
+  EXPECT_EQ(0, upb_ZeroCopyOutputStream_ByteCount(output));
+}
+
+}  // namespace
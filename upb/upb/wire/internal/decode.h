@@ -58,6 +58,13 @@ typedef struct upb_Decoder {
   bool missing_required;
   upb_Arena arena;
   upb_DecodeStatus status;
+
+  // Pre-zeroed messages for the run of repeated sub-messages being decoded at
+  // the current depth. Each message occupies msg_slab_type's aligned size.
+  char* msg_slab;
+  char* msg_slab_end;
+  const upb_MiniTable* msg_slab_type;
+
   jmp_buf err;
 
 #ifndef NDEBUG
@@ -101,6 +108,16 @@ non_ascii:
   return utf8_range2((const unsigned char*)ptr, end - ptr) == 0;
 }
 
+// Returns how many varints end in [ptr, end): every byte without a
+// continuation bit ends one.  This sizes arrays for packed varint fields before
+// they are decoded; it is not a bound, since a malformed payload can still
+// decode one more element.
+UPB_INLINE size_t _upb_Decoder_CountVarints(const char* ptr, const char* end) {
+  size_t count = 0;
+  for (; ptr < end; ptr++) count += (uint8_t)*ptr < 0x80;
+  return count;
+}
+
 const char* _upb_Decoder_CheckRequired(upb_Decoder* d, const char* ptr,
                                        const upb_Message* msg,
                                        const upb_MiniTable* l);